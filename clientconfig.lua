@@ -2,12 +2,28 @@ Debug = {
 	SendServerState = false,
 	ShowConnectionData = "ping", -- ping|download|upload|usage
 	ShowServerGhosts = false,
-	ShowVersion = true
+	ShowVersion = true,
+	SimulatedJitter = 0, -- ms, local server only
+	SimulatedLatency = 0, -- ms, one way (applied on both directions), local server only
+	SimulatedPacketDuplication = 0.0, -- 0..1
+	SimulatedPacketLoss = 0.0, -- 0..1
+	SimulatedPacketReordering = 0.0, -- 0..1
+	SimulationSeed = 0
+}
+Demo = {
+	KeyframeInterval = 5.0, -- seconds between full match states, demos seek to the nearest one before the target
+	PlaybackFile = "", -- demo to play when the client starts (Space pauses, Left/Right seek, Home restarts)
+	RecordDirectory = "" -- matches played are recorded there when set
 }
 Resources = {
 	AssetDirectory = "assets",
+	BytecodeCacheDirectory = ".bytecodeCache", -- compiled scripts kept between runs (empty to keep them in memory only)
+	ContentStoreMaxSize = 4096, -- MiB, downloaded files shared between servers (0 to disable)
+	JobThreadCount = 0, -- threads running background jobs such as asset hashing (0 = one per core, minus the main thread)
+	MaxConcurrentDownloads = 4, -- simultaneous fast download (HTTP) transfers
 	ModDirectory = "mods",
-	ScriptDirectory  = "scripts"
+	ScriptDirectory  = "scripts",
+	ScriptJobInstructionBudget = 100000000 -- Lua instructions a background job may run before being aborted (0 = unlimited)
 }
 ServerSettings = {
 	FastDownloadURLs = [[
@@ -0,0 +1,97 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_ANIMATIONMANAGER_HPP
+#define BURGWAR_CLIENTLIB_ANIMATIONMANAGER_HPP
+
+#include <CoreLib/Utility/InplaceFunction.hpp>
+#include <ClientLib/Export.hpp>
+#include <Nazara/Core/Color.hpp>
+#include <Nazara/Graphics/Sprite.hpp>
+#include <Nazara/Math/Angle.hpp>
+#include <Nazara/Math/Vector4.hpp>
+#include <NDK/Entity.hpp>
+#include <vector>
+
+namespace bw
+{
+	// Animations are stored contiguously and reuse their storage, common tweens are native curves which don't need any callback
+	class BURGWAR_CLIENTLIB_API AnimationManager
+	{
+		public:
+			using FinishCallback = InplaceFunction<void()>;
+			using UpdateCallback = InplaceFunction<bool(float ratio)>;
+
+			enum class Easing
+			{
+				Linear,
+				QuadraticIn,
+				QuadraticOut
+			};
+
+			AnimationManager() = default;
+			AnimationManager(const AnimationManager&) = delete;
+			AnimationManager(AnimationManager&&) = default;
+			~AnimationManager() = default;
+
+			void PushAnimation(float duration, UpdateCallback update, FinishCallback finish = {});
+			void PushColorAnimation(Nz::SpriteRef sprite, const Nz::Color& from, const Nz::Color& to, float duration, Easing easing = Easing::Linear, FinishCallback finish = {});
+			void PushOffsetAnimation(Ndk::EntityHandle entity, const Nz::Vector2f& from, const Nz::Vector2f& to, float duration, Easing easing = Easing::Linear, FinishCallback finish = {}); //< initial position of the entity node
+			void PushPositionAnimation(Ndk::EntityHandle entity, const Nz::Vector2f& from, const Nz::Vector2f& to, float duration, Easing easing = Easing::Linear, FinishCallback finish = {});
+			void PushRotationAnimation(Ndk::EntityHandle entity, const Nz::DegreeAnglef& from, const Nz::DegreeAnglef& to, float duration, Easing easing = Easing::Linear, FinishCallback finish = {});
+			void PushScaleAnimation(Ndk::EntityHandle entity, const Nz::Vector2f& from, const Nz::Vector2f& to, float duration, Easing easing = Easing::Linear, FinishCallback finish = {});
+
+			void Update(float elapsedTime);
+
+			AnimationManager& operator=(const AnimationManager&) = delete;
+			AnimationManager& operator=(AnimationManager&&) = default;
+
+		private:
+			enum class CurveType
+			{
+				Color,
+				Offset,
+				Position,
+				Rotation,
+				Scale
+			};
+
+			struct Animation
+			{
+				FinishCallback finishCallback;
+				UpdateCallback updateCallback;
+				float duration;
+				float elapsedTime;
+			};
+
+			struct Curve
+			{
+				FinishCallback finishCallback;
+				Ndk::EntityHandle entity;
+				Nz::SpriteRef sprite;
+				Nz::Vector4f from;
+				Nz::Vector4f to;
+				CurveType type;
+				Easing easing;
+				float duration;
+				float elapsedTime;
+			};
+
+			void PushCurve(Curve&& curve);
+
+			static bool ApplyCurve(Curve& curve, float ratio);
+			static inline float ApplyEasing(Easing easing, float ratio);
+
+			std::vector<Animation> m_animations;
+			std::vector<Animation> m_newAnimations; //< pushed while updating, started by the next update
+			std::vector<Curve> m_curves;
+			std::vector<Curve> m_newCurves;
+	};
+}
+
+#include <ClientLib/AnimationManager.inl>
+
+#endif
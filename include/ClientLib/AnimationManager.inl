@@ -0,0 +1,25 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/AnimationManager.hpp>
+
+namespace bw
+{
+	inline float AnimationManager::ApplyEasing(Easing easing, float ratio)
+	{
+		switch (easing)
+		{
+			case Easing::Linear:
+				return ratio;
+
+			case Easing::QuadraticIn:
+				return ratio * ratio;
+
+			case Easing::QuadraticOut:
+				return ratio * (2.f - ratio);
+		}
+
+		return ratio;
+	}
+}
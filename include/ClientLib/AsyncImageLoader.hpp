@@ -0,0 +1,69 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_ASYNCIMAGELOADER_HPP
+#define BURGWAR_CLIENTLIB_ASYNCIMAGELOADER_HPP
+
+#include <ClientLib/Export.hpp>
+#include <CoreLib/Utility/VirtualDirectory.hpp>
+#include <Nazara/Utility/Image.hpp>
+#include <tsl/hopscotch_map.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace bw
+{
+	// Decodes images on a background thread, GPU resources are left to be created by the main thread
+	class BURGWAR_CLIENTLIB_API AsyncImageLoader
+	{
+		public:
+			AsyncImageLoader() = default;
+			AsyncImageLoader(const AsyncImageLoader&) = delete;
+			AsyncImageLoader(AsyncImageLoader&&) = delete;
+			~AsyncImageLoader();
+
+			void Clear();
+
+			bool HasResult(const std::string& imagePath) const;
+
+			bool IsPending(const std::string& imagePath) const;
+
+			void Push(std::string imagePath, VirtualDirectory::Entry entry, Nz::ImageParams params = Nz::ImageParams{});
+
+			bool Take(const std::string& imagePath, Nz::ImageRef* image);
+
+			AsyncImageLoader& operator=(const AsyncImageLoader&) = delete;
+			AsyncImageLoader& operator=(AsyncImageLoader&&) = delete;
+
+			static bool IsSupported(const std::string& imagePath); //< based on extension
+
+		private:
+			struct Job
+			{
+				std::string imagePath;
+				Nz::ImageParams params;
+				VirtualDirectory::Entry entry;
+			};
+
+			void WorkerMain();
+
+			mutable std::mutex m_mutex;
+			std::condition_variable m_jobCondition;
+			std::condition_variable m_resultCondition;
+			std::deque<Job> m_jobs;
+			std::string m_currentJob;
+			std::thread m_worker;
+			tsl::hopscotch_map<std::string, Nz::ImageRef> m_results; //< null refs for images which failed to load
+			bool m_isStopping = false;
+	};
+}
+
+#include <ClientLib/AsyncImageLoader.inl>
+
+#endif
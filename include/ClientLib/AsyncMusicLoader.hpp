@@ -0,0 +1,76 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_ASYNCMUSICLOADER_HPP
+#define BURGWAR_CLIENTLIB_ASYNCMUSICLOADER_HPP
+
+#include <ClientLib/Export.hpp>
+#include <CoreLib/Utility/VirtualDirectory.hpp>
+#include <Nazara/Audio/Music.hpp>
+#include <tsl/hopscotch_map.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+namespace bw
+{
+	// Opens musics (decoder setup, headers parsing) on a background thread, so switching tracks doesn't stall the main thread
+	class BURGWAR_CLIENTLIB_API AsyncMusicLoader
+	{
+		public:
+			struct Result;
+
+			AsyncMusicLoader() = default;
+			AsyncMusicLoader(const AsyncMusicLoader&) = delete;
+			AsyncMusicLoader(AsyncMusicLoader&&) = delete;
+			~AsyncMusicLoader();
+
+			void Clear();
+
+			bool IsPending(const std::string& musicPath) const;
+
+			void Push(std::string musicPath, VirtualDirectory::Entry entry);
+
+			std::optional<Result> Take(const std::string& musicPath);
+
+			AsyncMusicLoader& operator=(const AsyncMusicLoader&) = delete;
+			AsyncMusicLoader& operator=(AsyncMusicLoader&&) = delete;
+
+			struct Result
+			{
+				Nz::Music music;
+				VirtualDirectory::Entry source; //< musics stream from it, in-memory files must outlive them
+				bool isOpen;
+			};
+
+			static Result Open(VirtualDirectory::Entry entry);
+
+		private:
+			struct Job
+			{
+				std::string musicPath;
+				VirtualDirectory::Entry entry;
+			};
+
+			void WorkerMain();
+
+			mutable std::mutex m_mutex;
+			std::condition_variable m_jobCondition;
+			std::condition_variable m_resultCondition;
+			std::deque<Job> m_jobs;
+			std::string m_currentJob;
+			std::thread m_worker;
+			tsl::hopscotch_map<std::string, Result> m_results;
+			bool m_isStopping = false;
+	};
+}
+
+#include <ClientLib/AsyncMusicLoader.inl>
+
+#endif
@@ -7,6 +7,7 @@
 #ifndef BURGWAR_CLIENTLIB_CHATBOX_HPP
 #define BURGWAR_CLIENTLIB_CHATBOX_HPP
 
+#include <CoreLib/Utility/CircularBuffer.hpp>
 #include <ClientLib/Export.hpp>
 #include <Nazara/Core/Signal.hpp>
 #include <Nazara/Renderer/RenderTarget.hpp>
@@ -17,6 +18,7 @@
 #include <NDK/Widgets/ScrollAreaWidget.hpp>
 #include <NDK/Widgets/TextAreaWidget.hpp>
 #include <variant>
+#include <vector>
 
 namespace bw
 {
@@ -60,12 +62,15 @@ namespace bw
 			NazaraSignal(OnChatMessage, const std::string& /*message*/);
 
 		private:
+			void AppendLine(const std::vector<Item>& lineItems);
 			void OnRenderTargetSizeChange(const Nz::RenderTarget* renderTarget);
 			void Refresh();
+			void UpdateLayout();
 
 			NazaraSlot(Nz::RenderTarget, OnRenderTargetSizeChange, m_onTargetChangeSizeSlot);
 
-			std::vector<std::vector<Item>> m_chatLines;
+			std::size_t m_displayedLineCount;
+			CircularBuffer<std::vector<Item>> m_chatLines;
 			Ndk::ScrollAreaWidget* m_chatboxScrollArea;
 			Ndk::RichTextAreaWidget* m_chatBox;
 			Ndk::TextAreaWidget* m_chatEnteringBox;
@@ -8,29 +8,61 @@
 #define BURGWAR_CLIENTLIB_CLIENTASSETSTORE_HPP
 
 #include <CoreLib/AssetStore.hpp>
+#include <ClientLib/AsyncImageLoader.hpp>
+#include <ClientLib/AsyncMusicLoader.hpp>
 #include <ClientLib/Export.hpp>
+#include <ClientLib/TextureAtlas.hpp>
 #include <Nazara/Audio/SoundBuffer.hpp>
 #include <Nazara/Graphics/Model.hpp>
 #include <Nazara/Renderer/Texture.hpp>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
 
 namespace bw
 {
 	class BURGWAR_CLIENTLIB_API ClientAssetStore : public AssetStore
 	{
 		public:
+			using TextureCallback = std::function<void(const Nz::TextureRef& texture)>;
+
 			using AssetStore::AssetStore;
 			~ClientAssetStore() = default;
 
+			void AdoptImageLoader(std::shared_ptr<AsyncImageLoader> imageLoader);
+
 			void Clear() override;
 
 			const Nz::ModelRef& GetModel(const std::string& modelPath) const;
 			const Nz::SoundBufferRef& GetSoundBuffer(const std::string& soundPath) const;
+			const TextureAtlas::Region* GetSpriteRegion(const std::string& texturePath, bool repeatTexture = false) const;
 			const Nz::TextureRef& GetTexture(const std::string& texturePath) const;
 
+			void ImportAssets(const ClientAssetStore& assetStore);
+
+			void LoadTextureAsync(const std::string& texturePath, TextureCallback callback) const;
+
+			std::optional<AsyncMusicLoader::Result> OpenMusic(const std::string& musicPath) const;
+
+			void PrefetchMusic(const std::string& musicPath) const;
+			void PreloadAssets(const std::vector<std::string>& assetPaths);
+
+			void Update();
+
 		private:
+			Nz::ImageRef LoadImage(const std::string& imagePath) const;
+			bool QueueImage(const std::string& imagePath) const;
+
+			mutable std::shared_ptr<AsyncImageLoader> m_imageLoader = std::make_shared<AsyncImageLoader>();
+			mutable AsyncMusicLoader m_musicLoader;
 			mutable tsl::hopscotch_map<std::string, Nz::ModelRef> m_models;
 			mutable tsl::hopscotch_map<std::string, Nz::SoundBufferRef> m_soundBuffers;
+			mutable tsl::hopscotch_map<std::string, TextureAtlas::Region> m_repeatedSpriteRegions;
+			mutable tsl::hopscotch_map<std::string, TextureAtlas::Region> m_spriteRegions;
 			mutable tsl::hopscotch_map<std::string, Nz::TextureRef> m_textures;
+			mutable tsl::hopscotch_map<std::string, std::vector<TextureCallback>> m_textureCallbacks;
+			mutable TextureAtlas m_spriteAtlas;
 	};
 }
 
@@ -25,6 +25,8 @@ namespace bw
 			ClientConsole(ClientConsole&&) = delete;
 			~ClientConsole() = default;
 
+			inline ScriptingEnvironment& GetEnvironment();
+
 			ClientConsole& operator=(const ClientConsole&) = delete;
 			ClientConsole& operator=(ClientConsole&&) = delete;
 
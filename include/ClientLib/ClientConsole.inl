@@ -6,4 +6,8 @@
 
 namespace bw
 {
+	inline ScriptingEnvironment& ClientConsole::GetEnvironment()
+	{
+		return m_environment;
+	}
 }
@@ -10,6 +10,7 @@
 #include <Nazara/Core/Bitset.hpp>
 #include <Nazara/Core/Signal.hpp>
 #include <CoreLib/Protocol/Packets.hpp>
+#include <CoreLib/Utility/EntityRegistry.hpp>
 #include <ClientLib/Export.hpp>
 #include <ClientLib/ClientEditorLayer.hpp>
 #include <ClientLib/ClientLayerEntity.hpp>
@@ -18,6 +19,8 @@
 #include <functional>
 #include <memory>
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace bw
 {
@@ -37,6 +40,7 @@ namespace bw
 			void Enable(bool enable = true);
 			inline void EnablePrediction(bool enable = true);
 
+			inline Packets::Helper::EntityData* FindPendingEntity(Nz::UInt32 serverId);
 			template<typename F> void ForEachLayerEntity(F&& func);
 			template<typename F> void ForEachLayerSound(F&& func);
 			void ForEachVisualEntity(const std::function<void(LayerVisualEntity& visualEntity)>& func) override;
@@ -47,7 +51,12 @@ namespace bw
 			inline EntityId GetUniqueIdByServerId(Nz::UInt32 serverId);
 			ClientMatch& GetClientMatch();
 
+			inline bool HasPendingEntities() const;
+
+			void InstantiatePendingEntities(const Nz::Vector2f& viewPosition, Nz::UInt64 deadline);
+
 			bool IsEnabled() const override;
+			inline bool IsLoading() const;
 			inline bool IsPredictionEnabled() const;
 
 			void PostFrameUpdate(float elapsedTime) override;
@@ -56,6 +65,7 @@ namespace bw
 			ClientLayerSound& RegisterSound(ClientLayerSound layerEntity);
 
 			void SyncVisuals();
+			void SyncVisuals(const Nz::Rectf& viewRect);
 
 			ClientLayer& operator=(const ClientLayer&) = delete;
 			ClientLayer& operator=(ClientLayer&&) = delete;
@@ -67,6 +77,7 @@ namespace bw
 
 		private:
 			void CreateEntity(Nz::UInt32 entityId, const Packets::Helper::EntityData& entityData);
+			void DiscardEntity(EntityId uniqueId);
 			void HandleEntityDestruction(EntityId uniqueId);
 			void HandlePacket(const Packets::CreateEntities::Entity* entities, std::size_t entityCount);
 			void HandlePacket(const Packets::DeleteEntities::Entity* entities, std::size_t entityCount);
@@ -74,11 +85,16 @@ namespace bw
 			void HandlePacket(const Packets::EntitiesAnimation::Entity* entities, std::size_t entityCount);
 			void HandlePacket(const Packets::EntitiesDeath::Entity* entities, std::size_t entityCount);
 			void HandlePacket(const Packets::EntitiesInputs::Entity* entities, std::size_t entityCount);
+			void HandlePacket(const Packets::EntitiesPhysics::Entity* entities, std::size_t entityCount);
 			void HandlePacket(const Packets::EntitiesScale::Entity* entities, std::size_t entityCount);
-			void HandlePacket(const Packets::EntityPhysics& packet);
-			void HandlePacket(const Packets::EntityWeapon& packet);
+			void HandlePacket(const Packets::EntitiesWeapon::Entity* entities, std::size_t entityCount);
 			void HandlePacket(const Packets::HealthUpdate::Entity* entities, std::size_t entityCount);
 			void HandlePacket(const Packets::MapReset::Entity* entities, std::size_t entityCount);
+			void HandlePacket(const Packets::RecycleEntities::Entity* entities, std::size_t entityCount);
+			void HandlePacket(const Packets::RespawnEntities::Entity* entities, std::size_t entityCount);
+			EntityId InstantiatePendingEntity(Nz::UInt32 serverId);
+			void RecycleEntity(EntityId uniqueId);
+			inline void SetRemainingEntityCount(std::size_t remainingEntityCount);
 
 			struct EntityData
 			{
@@ -106,11 +122,15 @@ namespace bw
 				ClientLayerSound sound;
 			};
 
-			tsl::hopscotch_map<EntityId /*uniqueId*/, EntityData> m_entities;
-			tsl::hopscotch_map<Nz::UInt32 /*serverEntityId*/, EntityId> m_serverEntityIds;
+			EntityRegistry<EntityData> m_entities;
+			EntityRegistry<EntityId> m_serverEntityIds; //< indexed by server entity id
+			tsl::hopscotch_map<Nz::UInt32 /*serverId*/, Packets::Helper::EntityData> m_pendingEntities; //< received with the layer but not instantiated yet (see InstantiatePendingEntities)
+			tsl::hopscotch_map<Nz::UInt32 /*serverId*/, std::unique_ptr<ClientLayerEntity>> m_recycledEntities;
+			std::vector<std::pair<float /*squaredDistance*/, Nz::UInt32 /*serverId*/>> m_pendingEntityOrder;
 			std::vector<std::optional<SoundData>> m_sounds;
 			Nz::Bitset<Nz::UInt64> m_freeSoundIds;
 			Nz::Color m_backgroundColor;
+			std::size_t m_remainingEntityCount; //< entities the server has yet to send before the layer is fully loaded
 			bool m_isEnabled;
 			bool m_isPredictionEnabled;
 	};
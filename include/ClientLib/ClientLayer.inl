@@ -16,13 +16,24 @@ namespace bw
 		m_isPredictionEnabled = enable;
 	}
 
+	inline Packets::Helper::EntityData* ClientLayer::FindPendingEntity(Nz::UInt32 serverId)
+	{
+		auto it = m_pendingEntities.find(serverId);
+		if (it == m_pendingEntities.end())
+			return nullptr;
+
+		return &it.value();
+	}
+
 	template<typename F>
 	void ClientLayer::ForEachLayerEntity(F&& func)
 	{
 		assert(m_isEnabled);
 
-		for (auto it = m_entities.begin(); it != m_entities.end(); ++it)
-			func(it.value().layerEntity);
+		m_entities.ForEach([&](EntityId /*uniqueId*/, EntityData& entity)
+		{
+			func(entity.layerEntity);
+		});
 	}
 
 	template<typename F>
@@ -47,11 +58,11 @@ namespace bw
 	{
 		assert(m_isEnabled);
 
-		auto it = m_entities.find(uniqueId);
-		if (it == m_entities.end())
+		EntityData* entity = m_entities.Find(uniqueId);
+		if (!entity)
 			return std::nullopt;
 
-		return it.value().layerEntity;
+		return entity->layerEntity;
 	}
 
 	inline std::optional<std::reference_wrapper<ClientLayerEntity>> ClientLayer::GetEntityByServerId(Nz::UInt32 serverId)
@@ -60,7 +71,12 @@ namespace bw
 
 		EntityId uniqueId = GetUniqueIdByServerId(serverId);
 		if (uniqueId == InvalidEntityId)
-			return std::nullopt;
+		{
+			// Something needs this entity right now, don't wait for its turn
+			uniqueId = InstantiatePendingEntity(serverId);
+			if (uniqueId == InvalidEntityId)
+				return std::nullopt;
+		}
 
 		auto entityOpt = GetEntity(uniqueId);
 		assert(entityOpt);
@@ -72,15 +88,30 @@ namespace bw
 	{
 		assert(m_isEnabled);
 
-		auto it = m_serverEntityIds.find(serverId);
-		if (it == m_serverEntityIds.end())
+		const EntityId* uniqueId = m_serverEntityIds.Find(serverId);
+		if (!uniqueId)
 			return InvalidEntityId;
 
-		return it->second;
+		return *uniqueId;
+	}
+
+	inline bool ClientLayer::HasPendingEntities() const
+	{
+		return !m_pendingEntities.empty();
+	}
+
+	inline bool ClientLayer::IsLoading() const
+	{
+		return m_remainingEntityCount > 0 || !m_pendingEntities.empty();
 	}
 
 	inline bool ClientLayer::IsPredictionEnabled() const
 	{
 		return m_isPredictionEnabled;
 	}
+
+	inline void ClientLayer::SetRemainingEntityCount(std::size_t remainingEntityCount)
+	{
+		m_remainingEntityCount = remainingEntityCount;
+	}
 }
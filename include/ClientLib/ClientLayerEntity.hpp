@@ -59,6 +59,7 @@ namespace bw
 			void UpdateHealth(Nz::UInt16 newHealth);
 			void UpdateInputs(const PlayerInputData& inputData);
 			void UpdateParent(const ClientLayerEntity* newParent);
+			void UpdateUniqueId(EntityId uniqueId);
 			void UpdateWeaponEntity(const ClientLayerEntityHandle& entity);
 
 			ClientLayerEntity& operator=(const ClientLayerEntity&) = delete;
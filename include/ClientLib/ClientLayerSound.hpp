@@ -41,7 +41,7 @@ namespace bw
 			LayerIndex GetLayerIndex() const;
 			inline Nz::Vector2f GetPosition() const;
 
-			std::size_t PlaySound(const Nz::SoundBufferRef& soundBuffer, bool isLooping, bool isSpatialized);
+			std::size_t PlaySound(const Nz::SoundBufferRef& soundBuffer, bool isLooping, bool isSpatialized, float priority = 1.f);
 			void StopSound(std::size_t soundIndex);
 
 			bool Update(float elapsedTime);
@@ -63,6 +63,7 @@ namespace bw
 				Nz::SoundBufferRef soundBuffer;
 				float currentOffset = 0.f;
 				float duration = 0.f;
+				float priority = 1.f;
 				bool isLooping;
 				bool isSpatialized;
 			};
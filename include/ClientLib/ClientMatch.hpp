@@ -7,21 +7,25 @@
 #ifndef BURGWAR_CLIENTLIB_CLIENTMATCH_HPP
 #define BURGWAR_CLIENTLIB_CLIENTMATCH_HPP
 
-#include <CoreLib/AnimationManager.hpp>
 #include <CoreLib/PropertyValues.hpp>
 #include <CoreLib/SharedMatch.hpp>
 #include <CoreLib/SharedLayer.hpp>
 #include <CoreLib/Protocol/Packets.hpp>
+#include <CoreLib/Protocol/StateQuantizer.hpp>
 #include <CoreLib/Scripting/ScriptingContext.hpp>
 #include <CoreLib/Utility/AverageValues.hpp>
+#include <CoreLib/Utility/TickRingBuffer.hpp>
+#include <ClientLib/AnimationManager.hpp>
 #include <ClientLib/Camera.hpp>
 #include <ClientLib/Chatbox.hpp>
 #include <ClientLib/ClientAssetStore.hpp>
+#include <ClientLib/ClockSynchronizer.hpp>
 #include <ClientLib/EscapeMenu.hpp>
 #include <ClientLib/Export.hpp>
 #include <ClientLib/ClientConsole.hpp>
 #include <ClientLib/ClientLayer.hpp>
 #include <ClientLib/ClientPlayer.hpp>
+#include <ClientLib/PerformanceOverlay.hpp>
 #include <ClientLib/VisualEntity.hpp>
 #include <ClientLib/Scripting/ClientEntityStore.hpp>
 #include <ClientLib/Scripting/ClientWeaponStore.hpp>
@@ -34,8 +38,10 @@
 #include <NDK/EntityOwner.hpp>
 #include <tsl/hopscotch_map.h>
 #include <tsl/hopscotch_set.h>
+#include <deque>
 #include <memory>
 #include <optional>
+#include <tuple>
 #include <variant>
 #include <vector>
 
@@ -45,6 +51,7 @@ namespace bw
 	class Camera;
 	class ClientGamemode;
 	class ClientSession;
+	class DemoRecorder;
 	class InputPoller;
 	class Scoreboard;
 	class VirtualDirectory;
@@ -59,14 +66,19 @@ namespace bw
 			ClientMatch(ClientMatch&&) = delete;
 			~ClientMatch();
 
-			template<typename T> T AdjustServerTick(T tick);
+			template<typename T> T AdjustServerTick(T tick) const;
 
 			inline EntityId AllocateClientUniqueId();
 
 			Nz::UInt64 EstimateServerTick() const;
 
+			bool DumpFrameCapture(const std::string& filePath, float duration);
+
+			inline void EnableLateTicks(bool enable = true);
+
 			void ForEachEntity(std::function<void(const Ndk::EntityHandle& entity)> func) override;
 			template<typename F> void ForEachPlayer(F&& func);
+			std::string FormatReconciliationStatistics() const;
 
 			inline Nz::UInt16 GetActiveLayer();
 			inline AnimationManager& GetAnimationManager();
@@ -75,6 +87,9 @@ namespace bw
 			inline Camera& GetCamera();
 			inline const Camera& GetCamera() const;
 			inline ClientSession& GetClientSession();
+			inline const TickProfiler& GetFrameProfiler() const;
+			inline float GetInputLatency() const;
+			inline Nz::UInt16 GetJitterBufferDepth() const;
 			ClientEntityStore& GetEntityStore() override;
 			const ClientEntityStore& GetEntityStore() const override;
 			ClientLayer& GetLayer(LayerIndex layerIndex) override;
@@ -95,16 +110,21 @@ namespace bw
 
 			void InitDebugGhosts();
 
+			bool IsLocalPlayerWeapon(const Ndk::EntityHandle& weapon) const;
+
 			void LoadAssets(std::shared_ptr<VirtualDirectory> assetDir);
 			void LoadScripts(const std::shared_ptr<VirtualDirectory>& scriptDir);
 
 			inline void Quit();
 
 			void RegisterEntity(EntityId uniqueId, ClientLayerEntityHandle entity);
+			void RegisterPredictedEntity(const ClientLayerEntity& layerEntity);
 			
 			const Ndk::EntityHandle& RetrieveEntityByUniqueId(EntityId uniqueId) const override;
 			EntityId RetrieveUniqueIdByEntity(const Ndk::EntityHandle& entity) const override;
 
+			void StartDemoRecording(std::unique_ptr<DemoRecorder> demoRecorder);
+
 			void UnregisterEntity(EntityId uniqueId);
 
 			bool Update(float elapsedTime);
@@ -129,19 +149,31 @@ namespace bw
 				Packets::EntitiesAnimation,
 				Packets::EntitiesDeath,
 				Packets::EntitiesInputs,
+				Packets::EntitiesPhysics,
 				Packets::EntitiesScale,
-				Packets::EntityPhysics,
-				Packets::EntityWeapon,
+				Packets::EntitiesWeapon,
 				Packets::HealthUpdate,
 				Packets::MapReset,
 				Packets::MatchState,
 				Packets::PlayerLayer,
-				Packets::PlayerWeapons
+				Packets::PlayerWeapons,
+				Packets::RecycleEntities,
+				Packets::RespawnEntities
 			>;
 
+			template<typename> struct TickPacketPool;
+
+			template<typename... T>
+			struct TickPacketPool<std::variant<T...>>
+			{
+				using Type = std::tuple<std::vector<T>...>;
+			};
+
+			template<typename T> TickPacketContent AcquireTickPacket(const T& packet);
 			void BindEscapeMenu();
 			void BindPackets();
 			void BindSignals(ClientEditorApp& burgApp, Nz::RenderWindow* window, Ndk::Canvas* canvas);
+			void DecodeMatchState(Packets::MatchState& packet);
 			void HandleChatMessage(const Packets::ChatMessage& packet);
 			void HandleConsoleAnswer(const Packets::ConsoleAnswer& packet);
 			void HandleEntityCreated(ClientLayer* layer, ClientLayerEntity& entity);
@@ -162,20 +194,31 @@ namespace bw
 			void HandleTickPacket(Packets::EntitiesAnimation&& packet);
 			void HandleTickPacket(Packets::EntitiesDeath&& packet);
 			void HandleTickPacket(Packets::EntitiesInputs&& packet);
+			void HandleTickPacket(Packets::EntitiesPhysics&& packet);
 			void HandleTickPacket(Packets::EntitiesScale&& packet);
-			void HandleTickPacket(Packets::EntityPhysics&& packet);
-			void HandleTickPacket(Packets::EntityWeapon&& packet);
+			void HandleTickPacket(Packets::EntitiesWeapon&& packet);
 			void HandleTickPacket(Packets::HealthUpdate&& packet);
 			void HandleTickPacket(Packets::MapReset&& packet);
 			void HandleTickPacket(Packets::MatchState&& packet);
 			void HandleTickPacket(Packets::PlayerLayer&& packet);
 			void HandleTickPacket(Packets::PlayerWeapons&& packet);
+			void HandleTickPacket(Packets::RecycleEntities&& packet);
+			void HandleTickPacket(Packets::RespawnEntities&& packet);
 			void HandleTickError(Nz::UInt16 serverTick, Nz::Int32 tickError);
 			void InitializeRemoteConsole();
 			void InitializeScoreboard();
 			void OnTick(bool lastTick) override;
-			void PushTickPacket(Nz::UInt16 tick, const TickPacketContent& packet);
+			void PushTickPacket(Nz::UInt16 tick, TickPacketContent&& packet);
+			void ReconcilePredictedEntity(ClientLayer& layer, Nz::UInt32 serverId, Nz::UInt16 ownerPlayerIndex);
+			void ReleaseTickPacket(TickPacketContent&& packet);
 			bool SendInputs(Nz::UInt16 serverTick, bool force);
+			void UpdateJitterBufferDepth();
+
+			static constexpr std::size_t FrameCaptureSampleCount = 60 * 60; //< one minute at 60 FPS
+			static constexpr std::size_t JitterBufferSize = 256;
+			static constexpr Nz::UInt16 MaxJitterBufferDepth = 64;
+			static constexpr Nz::UInt16 MinJitterBufferDepth = 1;
+			static constexpr Nz::UInt16 PredictedEntityGraceTicks = 10; //< creation packets and match states may not arrive in order
 
 			struct LocalPlayerData
 			{
@@ -200,6 +243,12 @@ namespace bw
 				PlayerInputData lastInputData;
 			};
 
+			struct SentInputs
+			{
+				std::vector<PlayerInputData> inputs;
+				Nz::UInt16 inputTick;
+			};
+
 			struct PredictedInput
 			{
 				struct MovementData
@@ -229,7 +278,7 @@ namespace bw
 				struct LayerData
 				{
 					LayerIndex layerIndex;
-					tsl::hopscotch_map<EntityId, EntityData> entities;
+					tsl::hopscotch_map<EntityId, EntityData> entities; //< cleared and refilled when the history entry is reused, keeping its buckets
 				};
 
 				struct PlayerData
@@ -237,6 +286,7 @@ namespace bw
 					PlayerInputData input;
 					PlayerInputData previousInput;
 					std::optional<MovementData> movement;
+					std::vector<EntityId> touchedEntities;
 					std::vector<WeaponData> weapons;
 				};
 
@@ -245,8 +295,65 @@ namespace bw
 				std::vector<LayerData> layers;
 			};
 
+			struct PredictedEntity
+			{
+				std::string entityClass;
+				EntityId uniqueId;
+				LayerIndex layerIndex;
+				Nz::UInt16 inputTick;
+				Nz::UInt16 playerIndex;
+			};
+
+			struct FrozenEntity
+			{
+				EntityId uniqueId;
+				LayerIndex layerIndex;
+				Nz::RadianAnglef angularVelocity;
+				Nz::RadianAnglef rotation;
+				Nz::Vector2f linearVelocity;
+				Nz::Vector2f position;
+			};
+
+			struct FrameProfilerSections
+			{
+				std::size_t audio;
+				std::size_t frameScripts;
+				std::size_t frameTime;
+				std::size_t postFrameScripts;
+				std::size_t render;
+				std::size_t tick;
+				std::size_t update;
+				std::size_t visualSync;
+			};
+
+			struct ReconciliationStatistics
+			{
+				Nz::UInt64 islandEntityCount = 0;
+				Nz::UInt64 maxDuration = 0; //< microseconds
+				Nz::UInt64 reconciliationCount = 0;
+				Nz::UInt64 replayedTickCount = 0;
+				Nz::UInt64 stateCount = 0;
+				Nz::UInt64 totalDuration = 0; //< microseconds
+			};
+
+			struct ReceivedMatchState
+			{
+				struct EntityState
+				{
+					Nz::RadianAnglef angularVelocity;
+					Nz::RadianAnglef rotation;
+					Nz::Vector2f linearVelocity;
+					Nz::Vector2f position;
+				};
+
+				bool isValid = false;
+				Nz::UInt16 stateTick;
+				tsl::hopscotch_map<Nz::UInt64 /*layerIndex|entityId*/, EntityState> entities;
+			};
+
 			struct TickPrediction
 			{
+				Nz::UInt64 sendTime; //< microseconds, to measure input timing round-trip
 				Nz::UInt16 serverTick;
 				Nz::Int32 tickError;
 			};
@@ -257,6 +364,12 @@ namespace bw
 				TickPacketContent content;
 			};
 
+			struct TickPacketBucket
+			{
+				Nz::UInt16 serverTick;
+				std::vector<TickPacketContent> packets;
+			};
+
 			NazaraSlot(Nz::RenderTarget, OnRenderTargetSizeChange, m_onRenderTargetSizeChange);
 			NazaraSlot(Nz::EventHandler, OnGainedFocus, m_onGainedFocus);
 			NazaraSlot(Nz::EventHandler, OnLostFocus, m_onLostFocus);
@@ -273,17 +386,23 @@ namespace bw
 			std::optional<Camera> m_camera;
 			std::optional<Console> m_remoteConsole;
 			std::optional<Debug> m_debug;
+			std::optional<Packets::TickRateUpdate> m_pendingTickRateUpdate;
 			std::optional<ClientConsole> m_localConsole;
 			std::optional<ParticleRegistry> m_particleRegistry;
+			std::optional<StateQuantizer> m_stateQuantizer;
 			std::shared_ptr<ClientGamemode> m_gamemode;
 			std::shared_ptr<ScriptingContext> m_scriptingContext;
+			std::unique_ptr<DemoRecorder> m_demoRecorder;
 			std::string m_gamemodeName;
+			std::vector<FrozenEntity> m_frozenEntities;
 			std::vector<std::unique_ptr<ClientLayer>> m_layers;
 			std::vector<LocalPlayerData> m_localPlayers;
 			std::vector<std::optional<ClientPlayer>> m_matchPlayers;
-			std::vector<PredictedInput> m_predictedInputs;
-			std::vector<TickPacket> m_tickedPackets;
-			std::vector<TickPrediction> m_tickPredictions;
+			std::vector<PredictedEntity> m_predictedEntities; //< clientside entities spawned by local weapons, until the server creates them (oldest first)
+			std::vector<ReceivedMatchState> m_receivedMatchStates; //< indexed by stateTick, used as baselines for delta-encoded entities
+			std::vector<TickPacket> m_lateTickPackets; //< sorted by serverTick, handled on next tick
+			std::vector<TickPacketBucket> m_tickPacketBuckets; //< indexed by serverTick % JitterBufferSize
+			TickPacketPool<TickPacketContent>::Type m_tickPacketPool; //< handled packets, kept for the capacity of their vectors
 			Ndk::Canvas* m_canvas;
 			Ndk::EntityHandle m_currentLayer;
 			Ndk::World m_renderWorld;
@@ -292,21 +411,38 @@ namespace bw
 			Nz::RenderTarget* m_renderTarget;
 			Nz::RenderWindow* m_window;
 			Nz::UInt16 m_activeLayerIndex;
+			Nz::UInt16 m_jitterBufferDepth;
+			Nz::UInt16 m_lastArrivedTick;
+			Nz::UInt16 m_lastHandledTick;
 			tsl::hopscotch_map<EntityId, ClientLayerEntityHandle> m_entitiesByUniqueId;
 			tsl::hopscotch_map<EntityId, std::size_t> m_playerEntitiesByUniqueId;
 			tsl::hopscotch_set<EntityId> m_inactiveEntities;
+			tsl::hopscotch_set<EntityId> m_reconciliationIsland;
+			TickRingBuffer<PredictedInput> m_predictedInputs; //< indexed by inputTick
+			TickRingBuffer<TickPrediction> m_tickPredictions; //< indexed by serverTick
 			AnimationManager m_animationManager;
-			AverageValues<Nz::Int32> m_averageTickError;
+			AverageValues<float> m_inputLatency; //< seconds between a tick being due and the inputs of that tick being sampled and sent
+			AverageValues<float> m_tickArrivalDelay;
+			AverageValues<float> m_tickArrivalDelaySquared;
 			Chatbox m_chatBox;
 			ClientEditorApp& m_application;
+			ClockSynchronizer m_clockSync;
 			ClientSession& m_session;
 			EscapeMenu m_escapeMenu;
+			FrameProfilerSections m_frameProfilerSections;
+			PerformanceOverlay m_performanceOverlay;
 			PropertyValueMap m_gamemodeProperties;
+			ReconciliationStatistics m_reconciliationStats;
 			Scoreboard* m_scoreboard;
 			Packets::PlayersInput m_inputPacket;
+			TickProfiler m_frameProfiler;
+			std::deque<SentInputs> m_sentInputs; //< most recent first
+			bool m_areLateTicksEnabled;
 			bool m_hasFocus;
 			bool m_isLeavingMatch;
 			float m_errorCorrectionTimer;
+			float m_jitterBufferTimer;
+			float m_lateTickTime; //< part of the frame time already given to ticks at the end of the previous frame
 			float m_playerEntitiesTimer;
 			float m_playerInputTimer;
 			float m_timeSinceLastInputSending;
@@ -7,9 +7,24 @@
 namespace bw
 {
 	template<typename T>
-	T ClientMatch::AdjustServerTick(T tick)
+	T ClientMatch::AdjustServerTick(T tick) const
 	{
-		return tick - 3;
+		return tick - static_cast<T>(m_jitterBufferDepth);
+	}
+
+	template<typename T>
+	auto ClientMatch::AcquireTickPacket(const T& packet) -> TickPacketContent
+	{
+		std::vector<T>& pool = std::get<std::vector<T>>(m_tickPacketPool);
+		if (pool.empty())
+			return packet;
+
+		// Copy assignment reuses the storage of the pooled packet
+		T pooledPacket = std::move(pool.back());
+		pool.pop_back();
+
+		pooledPacket = packet;
+		return TickPacketContent(std::in_place_type<T>, std::move(pooledPacket));
 	}
 
 	template<typename F>
@@ -29,6 +44,11 @@ namespace bw
 		return m_freeClientId--;
 	}
 
+	inline void ClientMatch::EnableLateTicks(bool enable)
+	{
+		m_areLateTicksEnabled = enable;
+	}
+
 	inline Nz::UInt16 ClientMatch::GetActiveLayer()
 	{
 		return m_activeLayerIndex;
@@ -65,6 +85,21 @@ namespace bw
 		return m_session;
 	}
 
+	inline const TickProfiler& ClientMatch::GetFrameProfiler() const
+	{
+		return m_frameProfiler;
+	}
+
+	inline float ClientMatch::GetInputLatency() const
+	{
+		return m_inputLatency.GetAverageValue();
+	}
+
+	inline Nz::UInt16 ClientMatch::GetJitterBufferDepth() const
+	{
+		return m_jitterBufferDepth;
+	}
+
 	inline ClientPlayer* ClientMatch::GetLocalPlayerClientPlayer(std::size_t localPlayerIndex)
 	{
 		assert(localPlayerIndex < m_localPlayers.size());
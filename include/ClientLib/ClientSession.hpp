@@ -35,7 +35,9 @@ namespace bw
 
 			inline BurgApp& GetApp();
 			inline const BurgApp& GetApp() const;
+			inline Nz::UInt32 GetDisconnectionData() const;
 			inline const NetworkStringStore& GetNetworkStringStore() const;
+			inline ProtocolFeatureFlags GetProtocolFeatures() const;
 
 			inline bool IsConnected() const;
 
@@ -68,9 +70,9 @@ namespace bw
 			NazaraSignal(OnEntitiesAnimation,            ClientSession* /*session*/, const Packets::EntitiesAnimation&            /*data*/);
 			NazaraSignal(OnEntitiesDeath,                ClientSession* /*session*/, const Packets::EntitiesDeath&                /*data*/);
 			NazaraSignal(OnEntitiesInputs,               ClientSession* /*session*/, const Packets::EntitiesInputs&               /*data*/);
+			NazaraSignal(OnEntitiesPhysics,              ClientSession* /*session*/, const Packets::EntitiesPhysics&              /*data*/);
 			NazaraSignal(OnEntitiesScale,                ClientSession* /*session*/, const Packets::EntitiesScale&                /*data*/);
-			NazaraSignal(OnEntityPhysics,                ClientSession* /*session*/, const Packets::EntityPhysics&                /*data*/);
-			NazaraSignal(OnEntityWeapon,                 ClientSession* /*session*/, const Packets::EntityWeapon&                 /*data*/);
+			NazaraSignal(OnEntitiesWeapon,               ClientSession* /*session*/, const Packets::EntitiesWeapon&               /*data*/);
 			NazaraSignal(OnHealthUpdate,                 ClientSession* /*session*/, const Packets::HealthUpdate&                 /*data*/);
 			NazaraSignal(OnInputTimingCorrection,        ClientSession* /*session*/, const Packets::InputTimingCorrection&        /*data*/);
 			NazaraSignal(OnMapReset,                     ClientSession* /*session*/, const Packets::MapReset&                     /*data*/);
@@ -84,7 +86,10 @@ namespace bw
 			NazaraSignal(OnPlayerNameUpdate,             ClientSession* /*session*/, const Packets::PlayerNameUpdate&             /*data*/);
 			NazaraSignal(OnPlayerPingUpdate,             ClientSession* /*session*/, const Packets::PlayerPingUpdate&             /*data*/);
 			NazaraSignal(OnPlayerWeapons,                ClientSession* /*session*/, const Packets::PlayerWeapons&                /*data*/);
+			NazaraSignal(OnRecycleEntities,              ClientSession* /*session*/, const Packets::RecycleEntities&              /*data*/);
+			NazaraSignal(OnRespawnEntities,              ClientSession* /*session*/, const Packets::RespawnEntities&              /*data*/);
 			NazaraSignal(OnScriptPacket,                 ClientSession* /*session*/, const Packets::ScriptPacket&                 /*data*/);
+			NazaraSignal(OnTickRateUpdate,               ClientSession* /*session*/, const Packets::TickRateUpdate&               /*data*/);
 
 		private:
 			void OnSessionConnected();
@@ -93,11 +98,14 @@ namespace bw
 			NazaraSlot(SessionBridge, OnConnected, m_onConnectedSlot);
 			NazaraSlot(SessionBridge, OnDisconnected, m_onDisconnectedSlot);
 			NazaraSlot(SessionBridge, OnIncomingPacket, m_onIncomingPacketSlot);
+			NazaraSlot(SessionBridge, OnIncomingTypedPacket, m_onIncomingTypedPacketSlot);
 
 			std::shared_ptr<SessionBridge> m_bridge;
 			BurgApp& m_application;
 			ClientCommandStore m_commandStore;
 			NetworkStringStore m_stringStore;
+			ProtocolFeatureFlags m_protocolFeatures;
+			Nz::UInt32 m_disconnectionData;
 	};
 }
 
@@ -10,7 +10,9 @@ namespace bw
 {
 	inline ClientSession::ClientSession(BurgApp& application) :
 	m_application(application),
-	m_commandStore(m_application.GetLogger())
+	m_commandStore(m_application.GetLogger()),
+	m_protocolFeatures(LegacyProtocolFeatures & SupportedProtocolFeatures),
+	m_disconnectionData(0)
 	{
 	}
 
@@ -24,11 +26,21 @@ namespace bw
 		return m_application;
 	}
 
+	inline Nz::UInt32 ClientSession::GetDisconnectionData() const
+	{
+		return m_disconnectionData;
+	}
+
 	inline const NetworkStringStore& ClientSession::GetNetworkStringStore() const
 	{
 		return m_stringStore;
 	}
 
+	inline ProtocolFeatureFlags ClientSession::GetProtocolFeatures() const
+	{
+		return m_protocolFeatures;
+	}
+
 	inline bool ClientSession::IsConnected() const
 	{
 		return m_bridge && m_bridge->IsConnected();
@@ -48,10 +60,17 @@ namespace bw
 		if (!IsConnected())
 			return;
 
-		Nz::NetPacket data;
-		m_commandStore.SerializePacket(data, packet);
+		if (m_bridge->SupportsTypedPackets())
+		{
+			m_bridge->SendTypedPacket(BuildTypedPacket(packet));
+			return;
+		}
 
 		const auto& command = m_commandStore.GetOutgoingCommand<T>();
+
+		Nz::NetPacket data;
+		m_commandStore.SerializePacket(data, packet, command.compress && m_protocolFeatures.Test(ProtocolFeature::Compression));
+
 		m_bridge->SendPacket(command.channelId, command.flags, std::move(data));
 	}
 }
@@ -0,0 +1,66 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_CLOCKSYNCHRONIZER_HPP
+#define BURGWAR_CLIENTLIB_CLOCKSYNCHRONIZER_HPP
+
+#include <ClientLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <vector>
+
+namespace bw
+{
+	// Estimates the tick offset between client and server (serverTick = clientTick - offset) from input timing corrections, NTP-style:
+	// samples with an unusual round-trip time are rejected, offset drift is estimated and applied, and the offset is slewed instead of stepped
+	class BURGWAR_CLIENTLIB_API ClockSynchronizer
+	{
+		public:
+			ClockSynchronizer(float tickDuration, float initialOffset);
+			ClockSynchronizer(const ClockSynchronizer&) = delete;
+			ClockSynchronizer(ClockSynchronizer&&) = delete;
+			~ClockSynchronizer() = default;
+
+			inline float GetDrift() const;
+			inline float GetOffset() const;
+			inline Nz::Int32 GetRoundedOffset() const;
+			inline float GetTargetOffset() const;
+
+			void InsertSample(float offset, Nz::UInt64 roundTripTime, Nz::UInt64 now);
+
+			void SetTickDuration(float tickDuration);
+
+			void Update(float elapsedTime);
+
+			ClockSynchronizer& operator=(const ClockSynchronizer&) = delete;
+			ClockSynchronizer& operator=(ClockSynchronizer&&) = delete;
+
+			static constexpr std::size_t MaxSampleCount = 32;
+			static constexpr float MaxDrift = 1.f; //< ticks per second
+			static constexpr float MaxSlewPerTick = 0.1f; //< ticks the offset may move per tick when slewing
+			static constexpr float StepThreshold = 10.f; //< ticks of error above which the offset is stepped
+
+		private:
+			struct Sample
+			{
+				Nz::UInt64 roundTripTime; //< microseconds
+				Nz::UInt64 time; //< microseconds
+				float offset;
+			};
+
+			std::vector<Sample> m_samples; //< ring buffer
+			std::vector<float> m_sortBuffer;
+			std::vector<const Sample*> m_validSamples;
+			std::size_t m_nextSample;
+			float m_drift;
+			float m_offset;
+			float m_targetOffset;
+			float m_tickDuration;
+	};
+}
+
+#include <ClientLib/ClockSynchronizer.inl>
+
+#endif
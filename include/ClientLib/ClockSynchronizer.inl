@@ -0,0 +1,29 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/ClockSynchronizer.hpp>
+#include <cmath>
+
+namespace bw
+{
+	inline float ClockSynchronizer::GetDrift() const
+	{
+		return m_drift;
+	}
+
+	inline float ClockSynchronizer::GetOffset() const
+	{
+		return m_offset;
+	}
+
+	inline Nz::Int32 ClockSynchronizer::GetRoundedOffset() const
+	{
+		return static_cast<Nz::Int32>(std::lround(m_offset));
+	}
+
+	inline float ClockSynchronizer::GetTargetOffset() const
+	{
+		return m_targetOffset;
+	}
+}
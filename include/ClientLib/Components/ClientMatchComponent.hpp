@@ -29,6 +29,8 @@ namespace bw
 			inline ClientMatch& GetClientMatch() const;
 			inline EntityId GetUniqueId() const;
 
+			inline void UpdateUniqueId(EntityId uniqueId);
+
 			static Ndk::ComponentIndex componentIndex;
 
 		private:
@@ -0,0 +1,40 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_COMPONENTS_FRAMECALLBACKRATECOMPONENT_HPP
+#define BURGWAR_CLIENTLIB_COMPONENTS_FRAMECALLBACKRATECOMPONENT_HPP
+
+#include <CoreLib/Scripting/ElementEvents.hpp>
+#include <ClientLib/Export.hpp>
+#include <NDK/Component.hpp>
+
+namespace bw
+{
+	// Rate at which the scripted Frame/PostFrame callbacks of an entity should run (entities without it run them every frame)
+	class BURGWAR_CLIENTLIB_API FrameCallbackRateComponent : public Ndk::Component<FrameCallbackRateComponent>
+	{
+		public:
+			inline FrameCallbackRateComponent();
+			~FrameCallbackRateComponent() = default;
+
+			inline float GetRate(ElementEvent event) const;
+
+			inline void UpdateRate(ElementEvent event, float rate);
+
+			static Ndk::ComponentIndex componentIndex;
+
+			static constexpr float EveryFrame = 0.f;
+			static constexpr float IdleOnly = -1.f; //< only runs when the frame budget isn't exhausted
+
+		private:
+			float m_frameRate;
+			float m_postFrameRate;
+	};
+}
+
+#include <ClientLib/Components/FrameCallbackRateComponent.inl>
+
+#endif
@@ -0,0 +1,30 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/Components/FrameCallbackRateComponent.hpp>
+#include <cassert>
+
+namespace bw
+{
+	inline FrameCallbackRateComponent::FrameCallbackRateComponent() :
+	m_frameRate(EveryFrame),
+	m_postFrameRate(EveryFrame)
+	{
+	}
+
+	inline float FrameCallbackRateComponent::GetRate(ElementEvent event) const
+	{
+		assert(event == ElementEvent::Frame || event == ElementEvent::PostFrame);
+		return (event == ElementEvent::Frame) ? m_frameRate : m_postFrameRate;
+	}
+
+	inline void FrameCallbackRateComponent::UpdateRate(ElementEvent event, float rate)
+	{
+		assert(event == ElementEvent::Frame || event == ElementEvent::PostFrame);
+		if (event == ElementEvent::Frame)
+			m_frameRate = rate;
+		else
+			m_postFrameRate = rate;
+	}
+}
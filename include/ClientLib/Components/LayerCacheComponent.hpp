@@ -0,0 +1,59 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_COMPONENTS_LAYERCACHECOMPONENT_HPP
+#define BURGWAR_CLIENTLIB_COMPONENTS_LAYERCACHECOMPONENT_HPP
+
+#include <ClientLib/Export.hpp>
+#include <Nazara/Graphics/Sprite.hpp>
+#include <Nazara/Renderer/RenderTexture.hpp>
+#include <Nazara/Renderer/Texture.hpp>
+#include <Nazara/Utility/Node.hpp>
+#include <NDK/Component.hpp>
+#include <NDK/EntityOwner.hpp>
+#include <NDK/World.hpp>
+#include <memory>
+
+namespace bw
+{
+	// Renders visual entities of a static layer once into an offscreen texture, displayed by its entity as a single sprite
+	class BURGWAR_CLIENTLIB_API LayerCacheComponent : public Ndk::Component<LayerCacheComponent>
+	{
+		friend class LayerCacheSystem;
+
+		public:
+			LayerCacheComponent(int renderOrder);
+			inline LayerCacheComponent(const LayerCacheComponent& layerCache);
+			~LayerCacheComponent() = default;
+
+			inline Ndk::World& GetCacheWorld();
+			inline const Nz::Node& GetRootNode() const;
+
+			inline void Invalidate();
+			inline bool IsInvalidated() const;
+
+			static Ndk::ComponentIndex componentIndex;
+
+			static constexpr unsigned int MaxCacheSize = 4096; //< larger layers are cached at a lower resolution
+
+		private:
+			void OnAttached() override;
+			void Refresh();
+
+			std::unique_ptr<Ndk::World> m_cacheWorld;
+			Ndk::EntityOwner m_cameraEntity;
+			Nz::Node m_rootNode;
+			Nz::RenderTexture m_renderTexture;
+			Nz::SpriteRef m_sprite;
+			Nz::TextureRef m_texture;
+			int m_renderOrder;
+			bool m_isInvalidated;
+	};
+}
+
+#include <ClientLib/Components/LayerCacheComponent.inl>
+
+#endif
@@ -0,0 +1,34 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/Components/LayerCacheComponent.hpp>
+
+namespace bw
+{
+	inline LayerCacheComponent::LayerCacheComponent(const LayerCacheComponent& layerCache) :
+	// Do not copy the cached content
+	LayerCacheComponent(layerCache.m_renderOrder)
+	{
+	}
+
+	inline Ndk::World& LayerCacheComponent::GetCacheWorld()
+	{
+		return *m_cacheWorld;
+	}
+
+	inline const Nz::Node& LayerCacheComponent::GetRootNode() const
+	{
+		return m_rootNode;
+	}
+
+	inline void LayerCacheComponent::Invalidate()
+	{
+		m_isInvalidated = true;
+	}
+
+	inline bool LayerCacheComponent::IsInvalidated() const
+	{
+		return m_isInvalidated;
+	}
+}
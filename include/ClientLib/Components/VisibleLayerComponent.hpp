@@ -15,6 +15,7 @@
 #include <ClientLib/VisualLayer.hpp>
 #include <Nazara/Utility/Node.hpp>
 #include <NDK/Component.hpp>
+#include <NDK/EntityOwner.hpp>
 #include <memory>
 
 namespace bw
@@ -29,7 +30,7 @@ namespace bw
 
 			void Clear();
 
-			void RegisterLocalLayer(ClientLayer& localLayer, int renderOrder, const Nz::Vector2f& scale, const Nz::Vector2f& parallaxFactor);
+			void RegisterLocalLayer(ClientLayer& localLayer, int renderOrder, const Nz::Vector2f& scale, const Nz::Vector2f& parallaxFactor, bool isStatic = false);
 			void RegisterVisibleLayer(Camera& camera, VisualLayer& visualLayer, int renderOrder, const Nz::Vector2f& scale, const Nz::Vector2f& parallaxFactor);
 
 			static Ndk::ComponentIndex componentIndex;
@@ -43,13 +44,14 @@ namespace bw
 			void DeleteSound(VisibleLayer* layer, std::size_t soundIndex, ClientLayerSound& layerSound);
 			void DeleteVisual(VisibleLayer* layer, Nz::Int64 uniqueId);
 
-			void RegisterLayer(std::shared_ptr<VisibleLayer> visibleLayer, Camera& camera, VisualLayer& visualLayer, int renderOrder, const Nz::Vector2f& scale, const Nz::Vector2f& parallaxFactor);
+			void RegisterLayer(std::shared_ptr<VisibleLayer> visibleLayer, Camera& camera, VisualLayer& visualLayer, int renderOrder, const Nz::Vector2f& scale, const Nz::Vector2f& parallaxFactor, bool isStatic);
 
 			struct VisibleLayer
 			{
 				Nz::Node baseNode;
 				int baseRenderOrder;
 
+				Ndk::EntityOwner cacheEntity; //< static layers only, must outlive visual entities rendered in its world
 				tsl::hopscotch_map<std::size_t /*sound*/, SoundEntity> soundEntities;
 				tsl::hopscotch_map<Nz::Int64 /*uniqueId*/, VisualEntity> visualEntities;
 
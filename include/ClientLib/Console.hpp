@@ -7,6 +7,7 @@
 #ifndef BURGWAR_CLIENTLIB_CONSOLE_HPP
 #define BURGWAR_CLIENTLIB_CONSOLE_HPP
 
+#include <CoreLib/Utility/CircularBuffer.hpp>
 #include <ClientLib/Export.hpp>
 #include <Nazara/Core/Signal.hpp>
 #include <Nazara/Renderer/RenderTarget.hpp>
@@ -14,6 +15,7 @@
 #include <NDK/Console.hpp>
 #include <functional>
 #include <memory>
+#include <string>
 
 namespace bw
 {
@@ -41,11 +43,22 @@ namespace bw
 			Console& operator=(const Console&) = delete;
 			Console& operator=(Console&&) = delete;
 
+			static constexpr std::size_t MaxHistoryLines = 500;
+			static constexpr std::size_t TrimThreshold = 100; //< extra lines the widget can hold before being rebuilt from history
+
 		private:
 			void OnRenderTargetSizeChange(const Nz::RenderTarget* renderTarget);
 
+			struct Line
+			{
+				std::string text;
+				Nz::Color color;
+			};
+
 			NazaraSlot(Nz::RenderTarget, OnRenderTargetSizeChange, m_onTargetChangeSizeSlot);
 
+			std::size_t m_displayedLineCount;
+			CircularBuffer<Line> m_historyLines;
 			ExecuteCallback m_callback;
 			Ndk::Console* m_widget;
 	};
@@ -0,0 +1,69 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_CONTENTSTORE_HPP
+#define BURGWAR_CLIENTLIB_CONTENTSTORE_HPP
+
+#include <ClientLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <tsl/hopscotch_map.h>
+#include <array>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	class Logger;
+
+	// Files indexed by their SHA1 checksum, shared by every server and evicted by least recent use
+	class BURGWAR_CLIENTLIB_API ContentStore
+	{
+		public:
+			using Checksum = std::array<Nz::UInt8, 20>;
+
+			ContentStore(const Logger& logger, std::filesystem::path storeDirectory, Nz::UInt64 maxSize);
+			ContentStore(const ContentStore&) = delete;
+			ContentStore(ContentStore&&) = delete;
+			~ContentStore() = default;
+
+			bool Fetch(const Checksum& checksum, Nz::UInt64 expectedSize, const std::filesystem::path& outputPath);
+			bool Fetch(const Checksum& checksum, Nz::UInt64 expectedSize, std::vector<Nz::UInt8>& content);
+
+			inline Nz::UInt64 GetTotalSize() const;
+
+			void Store(const Checksum& checksum, const std::filesystem::path& filePath);
+
+			ContentStore& operator=(const ContentStore&) = delete;
+			ContentStore& operator=(ContentStore&&) = delete;
+
+		private:
+			struct Entry;
+
+			void Evict();
+			Entry* FindEntry(const Checksum& checksum, Nz::UInt64 expectedSize, std::string* hexChecksum = nullptr);
+			std::filesystem::path GetObjectPath(const std::string& hexChecksum) const;
+			void Touch(const std::string& hexChecksum, Entry& entry);
+
+			static bool LinkOrCopy(const std::filesystem::path& from, const std::filesystem::path& to);
+
+			struct Entry
+			{
+				std::filesystem::file_time_type lastUse;
+				Nz::UInt64 size;
+			};
+
+			std::filesystem::path m_storeDirectory;
+			tsl::hopscotch_map<std::string, Entry> m_entries;
+			const Logger& m_logger;
+			Nz::UInt64 m_maxSize;
+			Nz::UInt64 m_totalSize;
+	};
+}
+
+#include <ClientLib/ContentStore.inl>
+
+#endif
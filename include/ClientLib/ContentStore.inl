@@ -0,0 +1,13 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/ContentStore.hpp>
+
+namespace bw
+{
+	inline Nz::UInt64 ContentStore::GetTotalSize() const
+	{
+		return m_totalSize;
+	}
+}
@@ -0,0 +1,55 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_DEMOCOMMANDSTORE_HPP
+#define BURGWAR_CLIENTLIB_DEMOCOMMANDSTORE_HPP
+
+#include <CoreLib/CommandStore.hpp>
+#include <CoreLib/Protocol/Packets.hpp>
+#include <ClientLib/Export.hpp>
+#include <variant>
+
+namespace bw
+{
+	using DemoPacket = std::variant<std::monostate,
+		Packets::ChatMessage,
+		Packets::CreateEntities,
+		Packets::DeleteEntities,
+		Packets::DisableLayer,
+		Packets::EnableLayer,
+		Packets::EntitiesAnimation,
+		Packets::EntitiesDeath,
+		Packets::EntitiesInputs,
+		Packets::EntitiesPhysics,
+		Packets::EntitiesScale,
+		Packets::EntitiesWeapon,
+		Packets::HealthUpdate,
+		Packets::MapReset,
+		Packets::MatchData,
+		Packets::MatchState,
+		Packets::NetworkStrings,
+		Packets::PlayerControlEntity,
+		Packets::PlayerJoined,
+		Packets::PlayerLeaving,
+		Packets::PlayerNameUpdate,
+		Packets::PlayerPingUpdate,
+		Packets::RecycleEntities,
+		Packets::RespawnEntities,
+		Packets::ScriptPacket
+	>;
+
+	// Unserializes packets stored in demos (see DemoRecorder) into the packet they hold
+	class BURGWAR_CLIENTLIB_API DemoCommandStore : public CommandStore<DemoPacket>
+	{
+		public:
+			DemoCommandStore(const Logger& logger);
+			~DemoCommandStore() = default;
+	};
+}
+
+#include <ClientLib/DemoCommandStore.inl>
+
+#endif
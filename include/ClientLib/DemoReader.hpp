@@ -0,0 +1,80 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_DEMOREADER_HPP
+#define BURGWAR_CLIENTLIB_DEMOREADER_HPP
+
+#include <ClientLib/Export.hpp>
+#include <ClientLib/DemoCommandStore.hpp>
+#include <ClientLib/DemoRecorder.hpp>
+#include <Nazara/Core/ByteStream.hpp>
+#include <Nazara/Core/MemoryView.hpp>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace bw
+{
+	// Reads back a file written by DemoRecorder, events are read in order from the beginning or from a keyframe
+	class BURGWAR_CLIENTLIB_API DemoReader
+	{
+		public:
+			using EventType = DemoRecorder::EventType;
+			using IndexEntry = DemoRecorder::IndexEntry;
+
+			struct Event
+			{
+				Nz::UInt64 demoTick;
+				EventType type;
+			};
+
+			DemoReader(const std::filesystem::path& filePath, const Logger& logger);
+			DemoReader(const DemoReader&) = delete;
+			DemoReader(DemoReader&&) = delete;
+			~DemoReader() = default;
+
+			const IndexEntry* FindKeyframe(Nz::UInt64 demoTick) const;
+
+			inline const std::vector<IndexEntry>& GetIndex() const;
+			inline Nz::UInt64 GetLastTick() const;
+			inline const Packets::MatchData& GetMatchData() const;
+			inline float GetTickDuration() const;
+
+			std::optional<Event> PeekEvent();
+
+			void ReadKeyframe(std::vector<DemoPacket>& packets);
+			DemoPacket ReadPacket();
+
+			void Rewind();
+
+			void SeekToKeyframe(const IndexEntry& keyframe);
+			void SkipEvent();
+
+			DemoReader& operator=(const DemoReader&) = delete;
+			DemoReader& operator=(DemoReader&&) = delete;
+
+		private:
+			void BuildIndex();
+			Event ReadEventHeader();
+			DemoPacket ReadPacketData();
+			Nz::UInt32 ReadSize();
+
+			std::optional<Packets::MatchData> m_matchData;
+			std::optional<Nz::MemoryView> m_contentView;
+			std::vector<IndexEntry> m_index;
+			std::vector<Nz::UInt8> m_content;
+			DemoCommandStore m_commandStore;
+			Nz::ByteStream m_stream;
+			Nz::UInt64 m_eventBegin;
+			Nz::UInt64 m_eventEnd;
+			Nz::UInt64 m_lastTick;
+			float m_tickDuration;
+	};
+}
+
+#include <ClientLib/DemoReader.inl>
+
+#endif
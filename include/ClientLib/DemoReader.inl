@@ -0,0 +1,30 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/DemoReader.hpp>
+#include <cassert>
+
+namespace bw
+{
+	inline auto DemoReader::GetIndex() const -> const std::vector<IndexEntry>&
+	{
+		return m_index;
+	}
+
+	inline Nz::UInt64 DemoReader::GetLastTick() const
+	{
+		return m_lastTick;
+	}
+
+	inline const Packets::MatchData& DemoReader::GetMatchData() const
+	{
+		assert(m_matchData);
+		return *m_matchData;
+	}
+
+	inline float DemoReader::GetTickDuration() const
+	{
+		return m_tickDuration;
+	}
+}
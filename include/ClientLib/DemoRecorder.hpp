@@ -0,0 +1,80 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_DEMORECORDER_HPP
+#define BURGWAR_CLIENTLIB_DEMORECORDER_HPP
+
+#include <CoreLib/MatchStateMirror.hpp>
+#include <CoreLib/Protocol/Packets.hpp>
+#include <ClientLib/Export.hpp>
+#include <Nazara/Core/ByteArray.hpp>
+#include <Nazara/Core/ByteStream.hpp>
+#include <Nazara/Core/File.hpp>
+#include <Nazara/Network/NetPacket.hpp>
+#include <filesystem>
+#include <vector>
+
+namespace bw
+{
+	class Logger;
+
+	// Writes the packets a client match receives (as they are after decoding) along with periodic keyframes holding the full match state, so demos can be played back and seeked quickly (see DemoReader)
+	class BURGWAR_CLIENTLIB_API DemoRecorder
+	{
+		public:
+			enum class EventType : Nz::UInt8
+			{
+				Keyframe,
+				Packet
+			};
+
+			struct IndexEntry
+			{
+				Nz::UInt64 demoTick;
+				Nz::UInt64 fileOffset;
+			};
+
+			DemoRecorder(const std::filesystem::path& filePath, const Logger& logger, const Packets::MatchData& matchData, const Packets::NetworkStrings& networkStrings, Nz::UInt64 keyframeInterval);
+			DemoRecorder(const DemoRecorder&) = delete;
+			DemoRecorder(DemoRecorder&&) = delete;
+			~DemoRecorder();
+
+			void Flush();
+
+			template<typename T> void RecordPacket(const T& packet);
+			template<typename T> void RecordTickPacket(Nz::UInt16 tick, const T& packet);
+
+			DemoRecorder& operator=(const DemoRecorder&) = delete;
+			DemoRecorder& operator=(DemoRecorder&&) = delete;
+
+			static constexpr Nz::UInt16 FileVersion = 2;
+			static constexpr std::size_t FlushThreshold = 64 * 1024; //< bytes buffered before being written to the file
+			static constexpr Nz::UInt64 IndexOffsetPosition = 8 + sizeof(Nz::UInt16) + sizeof(float); //< signature, version and tick duration precede it
+
+		private:
+			inline Nz::UInt64 GetFileOffset() const;
+			Nz::UInt64 ToDemoTick(Nz::UInt16 tick);
+			void WriteKeyframe(Nz::UInt64 demoTick);
+			template<typename T> void WritePacket(Nz::UInt64 demoTick, const T& packet);
+
+			static void WritePacketData(Nz::ByteStream& stream, const Nz::NetPacket& packet);
+
+			std::vector<IndexEntry> m_index;
+			MatchStateMirror m_mirror;
+			Nz::ByteArray m_buffer;
+			Nz::ByteStream m_stream;
+			Nz::File m_file;
+			Nz::UInt16 m_referenceTick;
+			Nz::UInt64 m_flushedSize;
+			Nz::UInt64 m_keyframeInterval;
+			Nz::UInt64 m_lastDemoTick;
+			Nz::UInt64 m_nextKeyframeTick;
+	};
+}
+
+#include <ClientLib/DemoRecorder.inl>
+
+#endif
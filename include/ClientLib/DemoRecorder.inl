@@ -0,0 +1,70 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/DemoRecorder.hpp>
+#include <CoreLib/PlayerCommandStore.hpp>
+#include <CoreLib/Protocol/CompressedInteger.hpp>
+#include <type_traits>
+
+namespace bw
+{
+	template<typename T>
+	void DemoRecorder::RecordPacket(const T& packet)
+	{
+		// Packets which aren't bound to a tick are played back along the last tick received
+		if constexpr (std::is_same_v<T, Packets::PlayerJoined>)
+		{
+			// Local players of the recording are regular players during playback
+			Packets::PlayerJoined playerJoined = packet;
+			playerJoined.localIndex.reset();
+
+			WritePacket(m_lastDemoTick, playerJoined);
+		}
+		else
+			WritePacket(m_lastDemoTick, packet);
+	}
+
+	template<typename T>
+	void DemoRecorder::RecordTickPacket(Nz::UInt16 tick, const T& packet)
+	{
+		// Demos are watched as a spectator, packets targeting the local players are meaningless there
+		if constexpr (std::is_same_v<T, Packets::ControlEntity> || std::is_same_v<T, Packets::PlayerLayer> || std::is_same_v<T, Packets::PlayerWeapons>)
+			return;
+		else if constexpr (std::is_same_v<T, Packets::MatchState>)
+		{
+			// States are recorded decoded (see ClientMatch::DecodeMatchState), playback doesn't have their baselines
+			Packets::MatchState decodedState = packet;
+			decodedState.isQuantized = false;
+
+			WritePacket(ToDemoTick(tick), decodedState);
+		}
+		else
+			WritePacket(ToDemoTick(tick), packet);
+	}
+
+	inline Nz::UInt64 DemoRecorder::GetFileOffset() const
+	{
+		return m_flushedSize + m_buffer.GetSize();
+	}
+
+	template<typename T>
+	void DemoRecorder::WritePacket(Nz::UInt64 demoTick, const T& packet)
+	{
+		if (demoTick >= m_nextKeyframeTick)
+			WriteKeyframe(demoTick);
+
+		Nz::NetPacket data;
+		PlayerCommandStore::SerializePacket(data, packet);
+
+		m_stream << static_cast<Nz::UInt8>(EventType::Packet);
+		m_stream << CompressedUnsigned<Nz::UInt64>(demoTick);
+		WritePacketData(m_stream, data);
+
+		if constexpr (std::is_constructible_v<MatchStateMirror::Packet, const T&>)
+			m_mirror.HandlePacket(packet, 0);
+
+		if (m_buffer.GetSize() >= FlushThreshold)
+			Flush();
+	}
+}
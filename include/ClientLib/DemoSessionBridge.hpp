@@ -0,0 +1,76 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_DEMOSESSIONBRIDGE_HPP
+#define BURGWAR_CLIENTLIB_DEMOSESSIONBRIDGE_HPP
+
+#include <CoreLib/MatchStateMirror.hpp>
+#include <CoreLib/SessionBridge.hpp>
+#include <ClientLib/Export.hpp>
+#include <ClientLib/DemoReader.hpp>
+#include <filesystem>
+#include <optional>
+
+namespace bw
+{
+	class Logger;
+
+	// Plays a demo back to a client session as if it were a server with a spectator, ticks sent are remapped so seeking never makes them go back
+	class BURGWAR_CLIENTLIB_API DemoSessionBridge : public SessionBridge
+	{
+		public:
+			DemoSessionBridge(const std::filesystem::path& filePath, const Logger& logger);
+			~DemoSessionBridge() = default;
+
+			void Disconnect() override;
+
+			inline Nz::UInt64 GetCurrentTick() const;
+			inline Nz::UInt64 GetLastTick() const;
+			inline float GetTickDuration() const;
+
+			bool IsLocal() const override;
+			inline bool IsPaused() const;
+
+			void QueryInfo(std::function<void(const SessionInfo& info)> callback) const override;
+
+			void Seek(Nz::UInt64 demoTick);
+
+			void SendPacket(Nz::UInt8 channelId, Nz::ENetPacketFlags flags, Nz::NetPacket&& packet) override;
+			void SendTypedPacket(TypedPacket&& packet) override;
+
+			inline void SetPaused(bool paused);
+
+			bool SupportsTypedPackets() const override;
+
+			void Update(float elapsedTime);
+
+		private:
+			void HandleClientPacket(const Packets::Auth& packet);
+			void HandleClientPacket(const Packets::DownloadClientFileRequest& packet);
+			void HandleClientPacket(const Packets::PlayersInput& packet);
+			void HandleClientPacket(const Packets::Ready& packet);
+			void ReleaseEvents(Nz::UInt64 lastTick, Nz::UInt64 firstTick = 0);
+			void SendKeyframe(std::vector<DemoPacket>&& keyframePackets);
+			void SendToClient(DemoPacket&& packet, Nz::UInt16 wireTick);
+			template<typename T> void SendToClient(T&& packet);
+			inline Nz::UInt16 ToWireTick(Nz::UInt64 demoTick) const;
+
+			std::optional<MatchStateMirror> m_mirror;
+			DemoReader m_reader;
+			const Logger& m_logger;
+			Nz::UInt16 m_wireTick;
+			Nz::UInt32 m_sentStringCount;
+			Nz::UInt64 m_demoTick;
+			float m_tickAccumulator;
+			bool m_isAuthenticated;
+			bool m_isPaused;
+			bool m_isStreaming;
+	};
+}
+
+#include <ClientLib/DemoSessionBridge.inl>
+
+#endif
@@ -0,0 +1,45 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/DemoSessionBridge.hpp>
+
+namespace bw
+{
+	inline Nz::UInt64 DemoSessionBridge::GetCurrentTick() const
+	{
+		return m_demoTick;
+	}
+
+	inline Nz::UInt64 DemoSessionBridge::GetLastTick() const
+	{
+		return m_reader.GetLastTick();
+	}
+
+	inline float DemoSessionBridge::GetTickDuration() const
+	{
+		return m_reader.GetTickDuration();
+	}
+
+	inline bool DemoSessionBridge::IsPaused() const
+	{
+		return m_isPaused;
+	}
+
+	inline void DemoSessionBridge::SetPaused(bool paused)
+	{
+		m_isPaused = paused;
+	}
+
+	template<typename T>
+	void DemoSessionBridge::SendToClient(T&& packet)
+	{
+		TypedPacket typedPacket = BuildTypedPacket(std::forward<T>(packet));
+		HandleIncomingTypedPacket(typedPacket);
+	}
+
+	inline Nz::UInt16 DemoSessionBridge::ToWireTick(Nz::UInt64 demoTick) const
+	{
+		return static_cast<Nz::UInt16>(m_wireTick - static_cast<Nz::UInt16>(m_demoTick - demoTick));
+	}
+}
@@ -12,11 +12,14 @@
 #include <Nazara/Core/Signal.hpp>
 #include <array>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace bw
 {
+	class ContentStore;
+
 	class BURGWAR_CLIENTLIB_API DownloadManager
 	{
 		public:
@@ -40,6 +43,8 @@ namespace bw
 
 			virtual void RegisterFile(std::string downloadPath, const Checksum& checksum, Nz::UInt64 expectedSize, std::filesystem::path outputPath, bool keepInMemory) = 0;
 
+			inline void SetContentStore(std::shared_ptr<ContentStore> contentStore);
+
 			virtual void Update() = 0;
 
 			struct FileEntry
@@ -57,6 +62,13 @@ namespace bw
 			NazaraSignal(OnDownloadProgress, DownloadManager* /*downloadManager*/, std::size_t /*fileIndex*/, Nz::UInt64 /*downloadedSize*/);
 			NazaraSignal(OnDownloadStarted, DownloadManager* /*downloadManager*/, std::size_t /*fileIndex*/, const std::string& /*downloadPath*/);
 			NazaraSignal(OnFinished, DownloadManager* /*downloadManager*/);
+
+		protected:
+			void AddToContentStore(std::size_t fileIndex);
+			bool FetchFromContentStore(std::size_t fileIndex);
+
+		private:
+			std::shared_ptr<ContentStore> m_contentStore;
 	};
 }
 
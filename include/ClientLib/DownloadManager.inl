@@ -6,4 +6,8 @@
 
 namespace bw
 {
+	inline void DownloadManager::SetContentStore(std::shared_ptr<ContentStore> contentStore)
+	{
+		m_contentStore = std::move(contentStore);
+	}
 }
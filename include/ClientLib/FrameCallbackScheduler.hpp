@@ -0,0 +1,61 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_FRAMECALLBACKSCHEDULER_HPP
+#define BURGWAR_CLIENTLIB_FRAMECALLBACKSCHEDULER_HPP
+
+#include <CoreLib/Scripting/ElementEvents.hpp>
+#include <NDK/Entity.hpp>
+#include <tsl/hopscotch_map.h>
+#include <utility>
+#include <vector>
+
+namespace bw
+{
+	// Runs an event callback of entities according to their FrameCallbackRateComponent
+	// Every-frame callbacks always run, rate-limited callbacks run (most late first) and idle callbacks run (round-robin) as long as the frame budget allows
+	template<ElementEvent Event>
+	class FrameCallbackScheduler
+	{
+		public:
+			FrameCallbackScheduler(Nz::UInt64 frameBudget = DefaultFrameBudget);
+			FrameCallbackScheduler(const FrameCallbackScheduler&) = delete;
+			FrameCallbackScheduler(FrameCallbackScheduler&&) = delete;
+			~FrameCallbackScheduler() = default;
+
+			void Insert(Ndk::Entity* entity);
+
+			void Remove(Ndk::Entity* entity);
+
+			void Update(float elapsedTime);
+
+			FrameCallbackScheduler& operator=(const FrameCallbackScheduler&) = delete;
+			FrameCallbackScheduler& operator=(FrameCallbackScheduler&&) = delete;
+
+			static constexpr Nz::UInt64 DefaultFrameBudget = 1000; //< microseconds
+
+		private:
+			float GetRate(const Ndk::EntityHandle& entity) const;
+			void Execute(const Ndk::EntityHandle& entity);
+
+			struct Entry
+			{
+				Ndk::EntityHandle entity;
+				Ndk::EntityId entityId;
+				float timer = 0.f;
+			};
+
+			std::size_t m_idleCursor;
+			std::vector<std::pair<float /*timer*/, std::size_t /*entryIndex*/>> m_dueEntries;
+			std::vector<Entry> m_entries;
+			tsl::hopscotch_map<Ndk::EntityId, std::size_t /*entryIndex*/> m_entryIndices;
+			Nz::UInt64 m_frameBudget;
+	};
+}
+
+#include <ClientLib/FrameCallbackScheduler.inl>
+
+#endif
@@ -0,0 +1,129 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/FrameCallbackScheduler.hpp>
+#include <CoreLib/Components/ScriptComponent.hpp>
+#include <ClientLib/Components/FrameCallbackRateComponent.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <algorithm>
+
+namespace bw
+{
+	template<ElementEvent Event>
+	FrameCallbackScheduler<Event>::FrameCallbackScheduler(Nz::UInt64 frameBudget) :
+	m_idleCursor(0),
+	m_frameBudget(frameBudget)
+	{
+	}
+
+	template<ElementEvent Event>
+	void FrameCallbackScheduler<Event>::Insert(Ndk::Entity* entity)
+	{
+		if (m_entryIndices.find(entity->GetId()) != m_entryIndices.end())
+			return;
+
+		m_entryIndices.emplace(entity->GetId(), m_entries.size());
+
+		auto& entry = m_entries.emplace_back();
+		entry.entity = entity->CreateHandle();
+		entry.entityId = entity->GetId();
+	}
+
+	template<ElementEvent Event>
+	void FrameCallbackScheduler<Event>::Remove(Ndk::Entity* entity)
+	{
+		auto it = m_entryIndices.find(entity->GetId());
+		if (it == m_entryIndices.end())
+			return;
+
+		std::size_t entryIndex = it->second;
+		m_entryIndices.erase(it);
+
+		if (entryIndex != m_entries.size() - 1)
+		{
+			m_entries[entryIndex] = std::move(m_entries.back());
+			m_entryIndices[m_entries[entryIndex].entityId] = entryIndex;
+		}
+
+		m_entries.pop_back();
+	}
+
+	template<ElementEvent Event>
+	void FrameCallbackScheduler<Event>::Update(float elapsedTime)
+	{
+		Nz::UInt64 startTime = Nz::GetElapsedMicroseconds();
+		auto IsOverBudget = [&]
+		{
+			return Nz::GetElapsedMicroseconds() - startTime >= m_frameBudget;
+		};
+
+		m_dueEntries.clear();
+
+		bool hasIdleEntries = false;
+		for (std::size_t i = 0; i < m_entries.size(); ++i)
+		{
+			Entry& entry = m_entries[i];
+			if (!entry.entity)
+				continue;
+
+			float rate = GetRate(entry.entity);
+			if (rate > 0.f)
+			{
+				entry.timer -= elapsedTime;
+				if (entry.timer <= 0.f)
+					m_dueEntries.emplace_back(entry.timer, i);
+			}
+			else if (rate < 0.f)
+				hasIdleEntries = true;
+			else
+				Execute(entry.entity);
+		}
+
+		// Run the most late rate-limited callbacks first, those which don't fit in the budget will be even more late next frame
+		std::sort(m_dueEntries.begin(), m_dueEntries.end());
+
+		bool executedOne = false;
+		for (auto&& [timer, entryIndex] : m_dueEntries)
+		{
+			if (executedOne && IsOverBudget())
+				break;
+
+			Entry& entry = m_entries[entryIndex];
+			Execute(entry.entity);
+			executedOne = true;
+
+			// Don't accumulate a backlog when we can't keep up with the rate
+			entry.timer = std::max(entry.timer + 1.f / GetRate(entry.entity), 0.f);
+		}
+
+		if (!hasIdleEntries || m_entries.empty())
+			return;
+
+		// Idle callbacks share the remaining time, starting from where we stopped last frame
+		for (std::size_t i = 0; i < m_entries.size() && !IsOverBudget(); ++i)
+		{
+			m_idleCursor = (m_idleCursor + 1) % m_entries.size();
+
+			Entry& entry = m_entries[m_idleCursor];
+			if (entry.entity && GetRate(entry.entity) < 0.f)
+				Execute(entry.entity);
+		}
+	}
+
+	template<ElementEvent Event>
+	float FrameCallbackScheduler<Event>::GetRate(const Ndk::EntityHandle& entity) const
+	{
+		if (!entity->HasComponent<FrameCallbackRateComponent>())
+			return FrameCallbackRateComponent::EveryFrame;
+
+		return entity->GetComponent<FrameCallbackRateComponent>().GetRate(Event);
+	}
+
+	template<ElementEvent Event>
+	void FrameCallbackScheduler<Event>::Execute(const Ndk::EntityHandle& entity)
+	{
+		auto& scriptComponent = entity->GetComponent<ScriptComponent>();
+		scriptComponent.ExecuteCallback<Event>();
+	}
+}
@@ -11,9 +11,11 @@
 #include <CoreLib/Protocol/Packets.hpp>
 #include <ClientLib/DownloadManager.hpp>
 #include <ClientLib/Export.hpp>
+#include <Nazara/Core/AbstractHash.hpp>
 #include <Nazara/Core/File.hpp>
 #include <Nazara/Core/MovablePtr.hpp>
-#include <functional>
+#include <deque>
+#include <memory>
 #include <vector>
 
 namespace bw
@@ -40,26 +42,49 @@ namespace bw
 			HttpDownloadManager& operator=(HttpDownloadManager&&) = delete;
 
 		private:
+			struct Request;
+
+			void FinishFile(std::size_t fileIndex, Nz::UInt64 downloadSpeed);
+			void HandleChunkData(Request& request, const void* data, std::size_t size);
+			void HandleChunkResult(Request& request, WebRequestResult&& result);
+			void PrepareFile(std::size_t fileIndex);
 			void RequestNextFiles();
+			void StartChunk(Request& request);
+
+			struct Chunk
+			{
+				std::size_t failedAttemptCount = 0;
+				std::size_t fileIndex;
+				std::size_t mirrorIndex;
+				Nz::UInt64 endOffset; //< exclusive
+				Nz::UInt64 offset; //< moves forward as data gets written, allowing to resume from another mirror
+			};
 
 			struct PendingFile : FileEntry
 			{
-				std::size_t downloadUrlIndex = 0;
+				std::size_t remainingChunkCount = 0;
+				std::unique_ptr<Nz::AbstractHash> hash;
+				std::unique_ptr<Nz::File> file;
+				std::vector<Nz::UInt8> fileContent;
+				Error error = Error::FileNotFound;
 				Nz::UInt64 downloadedSize = 0;
+				Nz::UInt64 hashedSize = 0; //< data is hashed as it comes when received in order, the rest is hashed once the file is complete
+				bool hasFailed = false;
 			};
 
 			struct Request
 			{
-				Nz::File file;
-				std::function<void(const void* /*data*/, std::size_t /*size*/)> dataCallback;
-				std::size_t fileIndex;
-				std::unique_ptr<Nz::AbstractHash> hash;
-				std::vector<Nz::UInt8> fileContent;
-				bool keepInMemory;
+				Chunk chunk;
+				WebRequest* webRequest;
+				Nz::UInt64 bodyOffset; //< file offset of the next received byte
+				bool hasCheckedResponse;
+				bool ignoresRange;
 				bool isActive = false;
+				bool isChunkComplete;
 			};
 
 			std::filesystem::path m_targetFolder;
+			std::deque<Chunk> m_pendingChunks;
 			std::size_t m_nextFileIndex;
 			std::vector<std::string> m_baseDownloadUrls;
 			std::vector<PendingFile> m_downloadList;
@@ -15,6 +15,7 @@
 #include <Nazara/Core/ObjectHandle.hpp>
 #include <Nazara/Graphics/Sprite.hpp>
 #include <Nazara/Graphics/TextSprite.hpp>
+#include <Nazara/Math/Rect.hpp>
 #include <NDK/EntityOwner.hpp>
 #include <memory>
 #include <optional>
@@ -57,6 +58,7 @@ namespace bw
 			bool IsPhysical() const;
 
 			void SyncVisuals();
+			void SyncVisuals(const Nz::Rectf& viewRect);
 
 			void UpdateHoveringRenderableHoveringHeight(const Nz::InstancedRenderableRef& renderable, float newHoveringHeight);
 			void UpdateHoveringRenderableMatrix(const Nz::InstancedRenderableRef& renderable, const Nz::Matrix4f& offsetMatrix);
@@ -68,6 +70,9 @@ namespace bw
 			LayerVisualEntity& operator=(const LayerVisualEntity&) = delete;
 			LayerVisualEntity& operator=(LayerVisualEntity&&) = delete;
 
+		protected:
+			inline void UpdateUniqueId(EntityId uniqueId);
+
 		private:
 			void NotifyVisualEntityMoved(VisualEntity* oldPointer, VisualEntity* newPointer);
 			void RegisterVisualEntity(VisualEntity* visualEntity);
@@ -47,4 +47,9 @@ namespace bw
 	{
 		return m_entity->IsEnabled();
 	}
+
+	inline void LayerVisualEntity::UpdateUniqueId(EntityId uniqueId)
+	{
+		m_uniqueId = uniqueId;
+	}
 }
@@ -9,6 +9,7 @@
 
 #include <CoreLib/SessionBridge.hpp>
 #include <ClientLib/Export.hpp>
+#include <atomic>
 
 namespace bw
 {
@@ -22,13 +23,19 @@ namespace bw
 
 			void Disconnect() override;
 
+			inline void EnableTypedPackets(bool enable);
+
 			void HandleIncomingPacket(Nz::NetPacket& packet) override;
+			void HandleIncomingTypedPacket(TypedPacket& packet) override;
 			inline bool IsServer() const;
 			bool IsLocal() const override;
 
 			void QueryInfo(std::function<void(const SessionInfo& info)> callback) const override;
 
 			void SendPacket(Nz::UInt8 channelId, Nz::ENetPacketFlags flags, Nz::NetPacket&& packet) override;
+			void SendTypedPacket(TypedPacket&& packet) override;
+
+			bool SupportsTypedPackets() const override;
 
 		private:
 			std::size_t m_peerId;
@@ -36,6 +43,7 @@ namespace bw
 			mutable SessionInfo m_sessionInfo;
 			LocalSessionManager& m_sessionManager;
 			bool m_isServer;
+			std::atomic_bool m_typedPackets; //< enabled by the match thread once its session is created
 	};
 }
 
@@ -6,6 +6,11 @@
 
 namespace bw
 {
+	inline void LocalSessionBridge::EnableTypedPackets(bool enable)
+	{
+		m_typedPackets = enable;
+	}
+
 	inline bool LocalSessionBridge::IsServer() const
 	{
 		return m_isServer;
@@ -8,9 +8,13 @@
 #define BURGWAR_CLIENTLIB_LOCALSESSIONMANAGER_HPP
 
 #include <CoreLib/SessionManager.hpp>
+#include <CoreLib/TypedPacket.hpp>
 #include <ClientLib/Export.hpp>
 #include <Nazara/Core/MemoryPool.hpp>
+#include <Nazara/Network/NetPacket.hpp>
+#include <mutex>
 #include <optional>
+#include <variant>
 #include <vector>
 
 namespace bw
@@ -19,12 +23,13 @@ namespace bw
 	class MatchClientSession;
 	class MatchSessions;
 
+	// Connects client sessions to a match of the same process, the match may run on another thread than its clients (see separateClientThread)
 	class BURGWAR_CLIENTLIB_API LocalSessionManager : public SessionManager
 	{
 		friend LocalSessionBridge;
 
 		public:
-			using SessionManager::SessionManager;
+			LocalSessionManager(MatchSessions* owner, bool separateClientThread = false);
 			LocalSessionManager(const LocalSessionManager&) = delete;
 			LocalSessionManager(LocalSessionManager&&) = delete;
 			~LocalSessionManager();
@@ -32,6 +37,7 @@ namespace bw
 			std::shared_ptr<LocalSessionBridge> CreateSession();
 
 			void Poll() override;
+			void PollClients();
 
 			LocalSessionManager& operator=(const LocalSessionManager&) = delete;
 			LocalSessionManager& operator=(LocalSessionManager&&) = delete;
@@ -39,18 +45,24 @@ namespace bw
 		private:
 			void DisconnectPeer(std::size_t peerId);
 			void SendPacket(std::size_t peerId, Nz::NetPacket&& packet, bool isServer);
+			void SendPacket(std::size_t peerId, TypedPacket&& packet, bool isServer);
+
+			using PendingPacket = std::variant<Nz::NetPacket, TypedPacket>;
 
 			struct Peer
 			{
 				std::shared_ptr<LocalSessionBridge> clientBridge;
 				std::shared_ptr<LocalSessionBridge> serverBridge;
-				std::vector<Nz::NetPacket> clientPackets;
-				std::vector<Nz::NetPacket> serverPackets;
-				MatchClientSession* session;
+				std::vector<PendingPacket> clientPackets;
+				std::vector<PendingPacket> serverPackets;
+				MatchClientSession* session = nullptr; //< created by the match thread on its next poll
 				bool disconnectionRequested = false;
+				bool isServerDisconnected = false; //< the client side has yet to handle the disconnection
 			};
 
+			std::mutex m_peerMutex; //< packets are queued and delivered from both the match and the client threads, handlers run outside of it
 			std::vector<std::optional<Peer>> m_peers;
+			bool m_separateClientThread;
 	};
 }
 
@@ -8,6 +8,7 @@
 #define BURGWAR_CLIENTLIB_NETWORKREACTORMANAGER_HPP
 
 #include <CoreLib/NetworkReactor.hpp>
+#include <ClientLib/ClientCommandStore.hpp>
 #include <ClientLib/Export.hpp>
 #include <memory>
 #include <vector>
@@ -30,6 +31,7 @@ namespace bw
 
 			std::shared_ptr<NetworkSessionBridge> ConnectToServer(const Nz::IpAddress& serverAddress, Nz::UInt32 data);
 
+			NetworkReactor::PacketDecoder GetPacketDecoder() const; //< for reactors added to this manager
 			inline const std::unique_ptr<NetworkReactor>& GetReactor(std::size_t reactorId);
 			inline std::size_t GetReactorCount() const;
 
@@ -42,7 +44,9 @@ namespace bw
 			void HandlePeerConnection(bool outgoing, std::size_t peerId, Nz::UInt32 data);
 			void HandlePeerDisconnection(std::size_t peerId, Nz::UInt32 data);
 			void HandlePeerPacket(std::size_t peerId, Nz::NetPacket& packet);
+			void HandlePeerTypedPacket(std::size_t peerId, TypedPacket& packet);
 
+			std::shared_ptr<const ClientCommandStore> m_packetDecoderStore; //< shared with reactors threads, only used to decode packets
 			std::vector<std::unique_ptr<NetworkReactor>> m_reactors;
 			std::vector<std::shared_ptr<NetworkSessionBridge>> m_connections;
 			const Logger& m_logger;
@@ -8,6 +8,7 @@
 namespace bw
 {
 	inline NetworkReactorManager::NetworkReactorManager(const Logger& logger) :
+	m_packetDecoderStore(std::make_shared<ClientCommandStore>(logger)),
 	m_logger(logger)
 	{
 	}
@@ -40,6 +40,8 @@ namespace bw
 			struct PendingFile : FileEntry
 			{
 				Nz::Bitset<Nz::UInt64> receivedFragment;
+				Nz::UInt32 receivedFragmentCount;
+				Nz::UInt64 downloadedSize;
 				Nz::UInt64 fragmentSize;
 			};
 
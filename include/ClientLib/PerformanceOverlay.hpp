@@ -0,0 +1,65 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_PERFORMANCEOVERLAY_HPP
+#define BURGWAR_CLIENTLIB_PERFORMANCEOVERLAY_HPP
+
+#include <CoreLib/SessionBridge.hpp>
+#include <ClientLib/Export.hpp>
+#include <NDK/Canvas.hpp>
+#include <NDK/Widgets/LabelWidget.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace bw
+{
+	class ClientSession;
+	class TickProfiler;
+
+	// HUD displaying client frame timings and network statistics, to help diagnosing lag
+	class BURGWAR_CLIENTLIB_API PerformanceOverlay
+	{
+		public:
+			PerformanceOverlay(Ndk::Canvas* canvas, ClientSession& session);
+			PerformanceOverlay(const PerformanceOverlay&) = delete;
+			PerformanceOverlay(PerformanceOverlay&&) = delete;
+			~PerformanceOverlay();
+
+			inline void Hide();
+
+			inline bool IsVisible() const;
+
+			void Show(bool shouldShow = true);
+
+			void Update(float elapsedTime, const TickProfiler& frameProfiler, const std::string& matchStatistics);
+
+			PerformanceOverlay& operator=(const PerformanceOverlay&) = delete;
+			PerformanceOverlay& operator=(PerformanceOverlay&&) = delete;
+
+			static constexpr float RefreshInterval = 0.5f;
+
+		private:
+			struct NetworkStatistics
+			{
+				std::optional<SessionBridge::SessionInfo> lastSessionInfo;
+				Nz::UInt64 lastQueryTime = 0;
+				double downloadSpeed = 0.0; //< bytes per second
+				double uploadSpeed = 0.0; //< bytes per second
+			};
+
+			void QueryNetworkStatistics();
+
+			std::shared_ptr<NetworkStatistics> m_networkStatistics; //< shared with pending session queries
+			ClientSession& m_session;
+			Ndk::LabelWidget* m_label;
+			float m_refreshTimer;
+	};
+}
+
+#include <ClientLib/PerformanceOverlay.inl>
+
+#endif
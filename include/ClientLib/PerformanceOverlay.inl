@@ -0,0 +1,18 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/PerformanceOverlay.hpp>
+
+namespace bw
+{
+	inline void PerformanceOverlay::Hide()
+	{
+		return Show(false);
+	}
+
+	inline bool PerformanceOverlay::IsVisible() const
+	{
+		return m_label->IsVisible();
+	}
+}
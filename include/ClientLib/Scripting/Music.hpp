@@ -8,6 +8,7 @@
 #define BURGWAR_CLIENTLIB_SCRIPTING_MUSIC_HPP
 
 #include <ClientLib/Export.hpp>
+#include <CoreLib/Utility/VirtualDirectory.hpp>
 #include <Nazara/Audio/Music.hpp>
 #include <Nazara/Core/Signal.hpp>
 
@@ -18,7 +19,7 @@ namespace bw
 	class BURGWAR_CLIENTLIB_API Music
 	{
 		public:
-			Music(ClientEditorApp& app, Nz::Music music);
+			Music(ClientEditorApp& app, Nz::Music music, VirtualDirectory::Entry source);
 			Music(const Music&) = delete;
 			Music(Music&&) noexcept = default;
 			~Music() = default;
@@ -46,6 +47,7 @@ namespace bw
 		private:
 			typename Nz::Signal<long long>::ConnectionGuard m_musicVolumeUpdateSlot;
 
+			VirtualDirectory::Entry m_source; //< in-memory files are streamed from, must outlive m_music
 			Nz::Music m_music;
 	};
 }
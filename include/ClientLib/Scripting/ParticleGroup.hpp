@@ -8,6 +8,7 @@
 #define BURGWAR_CLIENTLIB_SCRIPTING_PARTICLEGROUP_HPP
 
 #include <ClientLib/Export.hpp>
+#include <Nazara/Math/Vector2.hpp>
 #include <sol/forward.hpp>
 #include <NDK/EntityOwner.hpp>
 
@@ -27,6 +28,7 @@ namespace bw
 			void AddGenerator(const std::string& generatorName, const sol::table& parameters);
 
 			void GenerateParticles(unsigned int count);
+			void GenerateParticles(unsigned int count, const Nz::Vector2f& position);
 
 			std::size_t GetParticleCount() const;
 
@@ -43,7 +43,14 @@ namespace bw
 			Text& operator=(const Text&) = delete;
 			Text& operator=(Text&&) = default;
 
+			static Nz::TextSpriteRef BuildTextSprite(const Nz::SimpleTextDrawer& drawer);
+			static void ClearLayoutCache();
+
+			static constexpr std::size_t MaxCachedLayouts = 256;
+
 		private:
+			static const Nz::TextSprite& GetCachedLayout(const Nz::SimpleTextDrawer& drawer);
+
 			void UpdateTextSprite();
 			void UpdateTransformMatrix();
 
@@ -63,6 +63,10 @@ namespace bw
 		if (!m_visualEntity)
 			throw std::runtime_error("Invalid text");
 
+		// Scripts often set the same text every frame (counters, names), don't layout it again
+		if (m_drawer.GetText() == text.c_str())
+			return;
+
 		m_drawer.SetText(text);
 
 		UpdateTextSprite();
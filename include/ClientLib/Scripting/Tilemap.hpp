@@ -14,17 +14,21 @@
 #include <Nazara/Graphics/TileMap.hpp>
 #include <NDK/Entity.hpp>
 #include <sol/forward.hpp>
+#include <vector>
 
 namespace bw
 {
+	// Large tilemaps are split in chunks, each one being a renderable with its own bounds (culled separately, rebuilt separately)
 	class BURGWAR_CLIENTLIB_API Tilemap
 	{
 		public:
-			inline Tilemap(LayerVisualEntityHandle visualEntity, Nz::TileMapRef tilemap, const Nz::Matrix4f& transformMatrix, int renderOrder);
+			inline Tilemap(LayerVisualEntityHandle visualEntity, const Nz::Vector2ui& mapSize, const Nz::Vector2f& tileSize, const Nz::Vector2ui& chunkSize, std::vector<Nz::TileMapRef> chunks, const Nz::Matrix4f& transformMatrix, int renderOrder);
 			Tilemap(const Tilemap&) = delete;
 			Tilemap(Tilemap&&) noexcept = default;
 			~Tilemap() = default;
 
+			inline std::size_t GetChunkCount() const;
+			inline const Nz::Vector2ui& GetChunkSize() const;
 			inline const Nz::Vector2ui& GetMapSize() const;
 			inline Nz::Vector2f GetSize() const;
 			inline const Nz::Vector2f& GetTileSize() const;
@@ -42,12 +46,19 @@ namespace bw
 			Tilemap& operator=(const Tilemap&) = delete;
 			Tilemap& operator=(Tilemap&&) noexcept = default;
 
+			static constexpr unsigned int DefaultChunkSize = 32;
+
 		private:
+			Nz::Matrix4f GetChunkMatrix(std::size_t chunkIndex) const;
 			void UpdateTransformMatrix();
 
 			LayerVisualEntityHandle m_visualEntity;
 			Nz::Matrix4f m_transformMatrix;
-			Nz::TileMapRef m_tilemap;
+			Nz::Vector2f m_tileSize;
+			Nz::Vector2ui m_chunkCount;
+			Nz::Vector2ui m_chunkSize;
+			Nz::Vector2ui m_mapSize;
+			std::vector<Nz::TileMapRef> m_chunks; //< row-major, empty chunks are null
 			int m_renderOrder;
 			bool m_isVisible;
 	};
@@ -3,31 +3,47 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <ClientLib/Scripting/Tilemap.hpp>
+#include <cassert>
 
 namespace bw
 {
-	inline Tilemap::Tilemap(LayerVisualEntityHandle visualEntity, Nz::TileMapRef tilemap, const Nz::Matrix4f& transformMatrix, int renderOrder) :
+	inline Tilemap::Tilemap(LayerVisualEntityHandle visualEntity, const Nz::Vector2ui& mapSize, const Nz::Vector2f& tileSize, const Nz::Vector2ui& chunkSize, std::vector<Nz::TileMapRef> chunks, const Nz::Matrix4f& transformMatrix, int renderOrder) :
 	m_visualEntity(std::move(visualEntity)),
 	m_transformMatrix(transformMatrix),
-	m_tilemap(std::move(tilemap)),
+	m_tileSize(tileSize),
+	m_chunkCount((mapSize.x + chunkSize.x - 1) / chunkSize.x, (mapSize.y + chunkSize.y - 1) / chunkSize.y),
+	m_chunkSize(chunkSize),
+	m_mapSize(mapSize),
+	m_chunks(std::move(chunks)),
 	m_renderOrder(renderOrder),
 	m_isVisible(false)
 	{
+		assert(m_chunks.size() == std::size_t(m_chunkCount.x) * m_chunkCount.y);
+	}
+
+	inline std::size_t Tilemap::GetChunkCount() const
+	{
+		return m_chunks.size();
+	}
+
+	inline const Nz::Vector2ui& Tilemap::GetChunkSize() const
+	{
+		return m_chunkSize;
 	}
 
 	inline const Nz::Vector2ui& Tilemap::GetMapSize() const
 	{
-		return m_tilemap->GetMapSize();
+		return m_mapSize;
 	}
 
 	inline Nz::Vector2f Tilemap::GetSize() const
 	{
-		return m_tilemap->GetSize();
+		return Nz::Vector2f(m_mapSize) * m_tileSize;
 	}
 
 	inline const Nz::Vector2f& Tilemap::GetTileSize() const
 	{
-		return m_tilemap->GetTileSize();
+		return m_tileSize;
 	}
 
 	inline void Tilemap::Hide()
@@ -31,7 +31,7 @@ namespace bw
 
 			inline const Ndk::EntityHandle& GetEntity() const;
 
-			void PlaySound(std::size_t soundIndex, const Nz::SoundBufferRef& soundBuffer, bool isLooping, bool isSpatialized);
+			void PlaySound(std::size_t soundIndex, const Nz::SoundBufferRef& soundBuffer, bool isLooping, bool isSpatialized, float priority);
 
 			void StopSound(std::size_t soundIndex);
 
@@ -8,7 +8,7 @@
 #define BURGWAR_CLIENTLIB_SYSTEMS_FRAMECALLBACKSYSTEM_HPP
 
 #include <ClientLib/Export.hpp>
-#include <NDK/EntityList.hpp>
+#include <ClientLib/FrameCallbackScheduler.hpp>
 #include <NDK/System.hpp>
 #include <vector>
 
@@ -29,7 +29,7 @@ namespace bw
 			void OnEntityValidation(Ndk::Entity* entity, bool justAdded) override;
 			void OnUpdate(float elapsedTime) override;
 
-			Ndk::EntityList m_frameUpdateEntities;
+			FrameCallbackScheduler<ElementEvent::Frame> m_scheduler;
 	};
 }
 
@@ -0,0 +1,31 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_SYSTEMS_LAYERCACHESYSTEM_HPP
+#define BURGWAR_CLIENTLIB_SYSTEMS_LAYERCACHESYSTEM_HPP
+
+#include <ClientLib/Export.hpp>
+#include <NDK/System.hpp>
+
+namespace bw
+{
+	// Redraws invalidated layer caches before the render world is rendered
+	class BURGWAR_CLIENTLIB_API LayerCacheSystem : public Ndk::System<LayerCacheSystem>
+	{
+		public:
+			LayerCacheSystem();
+			~LayerCacheSystem() = default;
+
+			static Ndk::SystemIndex systemIndex;
+
+		private:
+			void OnUpdate(float elapsedTime) override;
+	};
+}
+
+#include <ClientLib/Systems/LayerCacheSystem.inl>
+
+#endif
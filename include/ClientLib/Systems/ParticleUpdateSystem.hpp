@@ -0,0 +1,54 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_SYSTEMS_PARTICLEUPDATESYSTEM_HPP
+#define BURGWAR_CLIENTLIB_SYSTEMS_PARTICLEUPDATESYSTEM_HPP
+
+#include <ClientLib/Export.hpp>
+#include <CoreLib/Utility/WorkerPool.hpp>
+#include <Nazara/Core/Signal.hpp>
+#include <Nazara/Math/Rect.hpp>
+#include <Nazara/Math/Vector2.hpp>
+#include <NDK/System.hpp>
+#include <memory>
+
+namespace bw
+{
+	class ConfigFile;
+
+	// Replaces Ndk::ParticleSystem: updates particle groups in parallel and limits how many particles are generated each frame
+	class BURGWAR_CLIENTLIB_API ParticleUpdateSystem : public Ndk::System<ParticleUpdateSystem>
+	{
+		public:
+			ParticleUpdateSystem(ConfigFile& playerSettings);
+			~ParticleUpdateSystem() = default;
+
+			unsigned int AcquireParticles(unsigned int particleCount);
+			unsigned int AcquireParticles(unsigned int particleCount, const Nz::Vector2f& position);
+
+			inline unsigned int GetRemainingBudget() const;
+
+			inline void UpdateViewRect(const Nz::Rectf& viewRect);
+
+			static Ndk::SystemIndex systemIndex;
+
+			static constexpr float LodFadeDistance = 1000.f; //< distance beyond view at which out-of-view emissions stop
+
+		private:
+			void OnUpdate(float elapsedTime) override;
+
+			std::unique_ptr<WorkerPool> m_workerPool;
+			typename Nz::Signal<long long>::ConnectionGuard m_particleBudgetUpdateSlot;
+			Nz::Rectf m_viewRect;
+			unsigned int m_particleBudget;
+			unsigned int m_remainingBudget;
+			bool m_hasViewRect;
+	};
+}
+
+#include <ClientLib/Systems/ParticleUpdateSystem.inl>
+
+#endif
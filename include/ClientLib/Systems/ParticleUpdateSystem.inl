@@ -0,0 +1,19 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/Systems/ParticleUpdateSystem.hpp>
+
+namespace bw
+{
+	inline unsigned int ParticleUpdateSystem::GetRemainingBudget() const
+	{
+		return m_remainingBudget;
+	}
+
+	inline void ParticleUpdateSystem::UpdateViewRect(const Nz::Rectf& viewRect)
+	{
+		m_hasViewRect = true;
+		m_viewRect = viewRect;
+	}
+}
@@ -8,7 +8,7 @@
 #define BURGWAR_CLIENTLIB_SYSTEMS_POSTFRAMECALLBACKSYSTEM_HPP
 
 #include <ClientLib/Export.hpp>
-#include <NDK/EntityList.hpp>
+#include <ClientLib/FrameCallbackScheduler.hpp>
 #include <NDK/System.hpp>
 #include <vector>
 
@@ -27,7 +27,7 @@ namespace bw
 			void OnEntityValidation(Ndk::Entity* entity, bool justAdded) override;
 			void OnUpdate(float elapsedTime) override;
 
-			Ndk::EntityList m_frameUpdateEntities;
+			FrameCallbackScheduler<ElementEvent::PostFrame> m_scheduler;
 	};
 }
 
@@ -12,6 +12,8 @@
 #include <Nazara/Core/Signal.hpp>
 #include <NDK/System.hpp>
 #include <tsl/hopscotch_map.h>
+#include <limits>
+#include <utility>
 #include <vector>
 
 namespace bw
@@ -26,33 +28,59 @@ namespace bw
 			SoundSystem(ConfigFile& playerSettings);
 			~SoundSystem() = default;
 
+			inline Nz::UInt64 GetLastUpdateDuration() const;
+
 			static Ndk::SystemIndex systemIndex;
 
 			static constexpr Nz::UInt32 InvalidSoundId = 0;
+			static constexpr float MaxAudibleDistance = 3000.f;
+			static constexpr std::size_t MaxIdenticalSoundsPerFrame = 4;
+			static constexpr float SoundMinDistance = 200.f;
 
 		private:
-			Nz::UInt32 PlaySound(const Nz::SoundBufferRef& soundBuffer, const Nz::Vector3f& soundPosition, bool attachedToEntity, bool isLooping, bool isSpatialized);
+			Nz::UInt32 PlaySound(const Nz::SoundBufferRef& soundBuffer, const Nz::Vector3f& soundPosition, bool attachedToEntity, bool isLooping, bool isSpatialized, float priority);
 			void StopSound(Nz::UInt32 soundId);
+			void UpdateVoices();
 			void UpdateVolume(float newVolume);
 
 			void OnEntityRemoved(Ndk::Entity* entity) override;
 			void OnEntityValidation(Ndk::Entity* entity, bool justAdded) override;
 			void OnUpdate(float elapsedTime) override;
 
+			static constexpr std::size_t NoVoice = std::numeric_limits<std::size_t>::max();
+
+			// Logical sound, only the most audible ones get a voice (a real playing Nz::Sound)
 			struct SoundData
 			{
-				Nz::Sound sound;
-				Nz::UInt32 playingSoundId;
+				Nz::SoundBufferRef buffer;
+				Nz::UInt32 duration;
+				Nz::Vector3f position;
+				Nz::Vector3f velocity;
+				float playingOffset; //< in milliseconds, advanced even when the sound has no voice
+				float priority;
+				std::size_t voiceIndex;
 				bool attachedToEntity;
+				bool isLooping;
+				bool isSpatialized;
+				bool justStarted;
+			};
+
+			struct Voice
+			{
+				Nz::Sound sound;
+				Nz::UInt32 soundId;
 			};
 
-			std::size_t m_maxSoundInPool;
-			std::vector<SoundData> m_soundPool;
-			tsl::hopscotch_map<Nz::UInt32 /*soundId*/, std::size_t /*soundIndex*/> m_playingSounds;
+			std::size_t m_maxVoiceCount;
+			std::vector<std::pair<float /*score*/, Nz::UInt32 /*soundId*/>> m_voiceCandidates;
+			std::vector<Voice> m_voices;
+			tsl::hopscotch_map<Nz::UInt32 /*soundId*/, SoundData> m_sounds;
+			tsl::hopscotch_map<const Nz::SoundBuffer*, std::size_t /*count*/> m_frameStartedSounds;
 			typename Nz::Signal<long long>::ConnectionGuard m_effectVolumeUpdateSlot;
 			Nz::Vector3f m_soundOffset;
 			Nz::UInt32 m_nextSoundId;
 			Ndk::EntityList m_movableEntities;
+			Nz::UInt64 m_lastUpdateDuration;
 			float m_volume;
 	};
 }
@@ -6,4 +6,8 @@
 
 namespace bw
 {
+	inline Nz::UInt64 SoundSystem::GetLastUpdateDuration() const
+	{
+		return m_lastUpdateDuration;
+	}
 }
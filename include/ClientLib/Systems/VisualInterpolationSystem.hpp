@@ -9,6 +9,7 @@
 
 #include <ClientLib/Export.hpp>
 #include <NDK/System.hpp>
+#include <vector>
 
 namespace bw
 {
@@ -23,6 +24,14 @@ namespace bw
 		private:
 			void OnEntityAdded(Ndk::Entity* entity) override;
 			void OnUpdate(float elapsedTime) override;
+
+			// Interpolation runs on these contiguous arrays (indexed like GetEntities()) so the compiler can vectorize it
+			std::vector<float> m_positionsX;
+			std::vector<float> m_positionsY;
+			std::vector<float> m_rotations;
+			std::vector<float> m_targetPositionsX;
+			std::vector<float> m_targetPositionsY;
+			std::vector<float> m_targetRotations;
 	};
 }
 
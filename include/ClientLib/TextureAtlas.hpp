@@ -0,0 +1,76 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CLIENTLIB_TEXTUREATLAS_HPP
+#define BURGWAR_CLIENTLIB_TEXTUREATLAS_HPP
+
+#include <ClientLib/Export.hpp>
+#include <Nazara/Graphics/Material.hpp>
+#include <Nazara/Math/Rect.hpp>
+#include <Nazara/Math/Vector2.hpp>
+#include <Nazara/Renderer/Texture.hpp>
+#include <Nazara/Utility/Image.hpp>
+#include <optional>
+#include <vector>
+
+namespace bw
+{
+	// Packs small images into shared texture pages, so sprites using them share a material (and are batched together)
+	class BURGWAR_CLIENTLIB_API TextureAtlas
+	{
+		public:
+			struct Region;
+
+			inline TextureAtlas(unsigned int pageSize = 1024, unsigned int maxImageSize = 128);
+			TextureAtlas(const TextureAtlas&) = delete;
+			TextureAtlas(TextureAtlas&&) noexcept = default;
+			~TextureAtlas() = default;
+
+			inline bool CanInsert(const Nz::Image& image) const;
+			void Clear();
+
+			inline std::size_t GetPageCount() const;
+
+			std::optional<Region> Insert(const Nz::Image& image);
+
+			TextureAtlas& operator=(const TextureAtlas&) = delete;
+			TextureAtlas& operator=(TextureAtlas&&) noexcept = default;
+
+			struct Region
+			{
+				Nz::MaterialRef material;
+				Nz::Rectf textureCoords; //< normalized coordinates of the image in the material diffuse map
+				Nz::Vector2f size;       //< image size in pixels
+			};
+
+		private:
+			struct Shelf
+			{
+				unsigned int height;
+				unsigned int nextX;
+				unsigned int y;
+			};
+
+			struct Page
+			{
+				std::vector<Shelf> shelves;
+				Nz::MaterialRef material;
+				Nz::TextureRef texture;
+				unsigned int nextShelfY = 0;
+			};
+
+			bool AllocateRect(Page& page, unsigned int width, unsigned int height, Nz::Vector2ui* position) const;
+			Page& CreatePage();
+
+			std::vector<Page> m_pages;
+			unsigned int m_maxImageSize;
+			unsigned int m_pageSize;
+	};
+}
+
+#include <ClientLib/TextureAtlas.inl>
+
+#endif
@@ -0,0 +1,24 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/TextureAtlas.hpp>
+
+namespace bw
+{
+	inline TextureAtlas::TextureAtlas(unsigned int pageSize, unsigned int maxImageSize) :
+	m_maxImageSize(maxImageSize),
+	m_pageSize(pageSize)
+	{
+	}
+
+	inline bool TextureAtlas::CanInsert(const Nz::Image& image) const
+	{
+		return image.GetType() == Nz::ImageType_2D && image.GetWidth() <= m_maxImageSize && image.GetHeight() <= m_maxImageSize;
+	}
+
+	inline std::size_t TextureAtlas::GetPageCount() const
+	{
+		return m_pages.size();
+	}
+}
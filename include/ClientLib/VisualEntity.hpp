@@ -10,6 +10,7 @@
 #include <ClientLib/Export.hpp>
 #include <Nazara/Core/ObjectHandle.hpp>
 #include <Nazara/Graphics/InstancedRenderable.hpp>
+#include <Nazara/Math/Rect.hpp>
 #include <Nazara/Utility/Node.hpp>
 #include <NDK/EntityOwner.hpp>
 #include <vector>
@@ -34,6 +35,7 @@ namespace bw
 			inline const Ndk::EntityHandle& GetEntity() const;
 
 			void Update(const Nz::Vector2f& position, const Nz::Quaternionf& rotation, const Nz::Vector2f& scale);
+			void Update(const Nz::Vector2f& position, const Nz::Quaternionf& rotation, const Nz::Vector2f& scale, const Nz::Rectf& viewRect);
 
 			VisualEntity& operator=(const VisualEntity&) = delete;
 			VisualEntity& operator=(VisualEntity&& entity) = delete;
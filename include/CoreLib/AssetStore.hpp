@@ -12,6 +12,8 @@
 #include <Nazara/Core/ObjectRef.hpp>
 #include <Nazara/Utility/Image.hpp>
 #include <tsl/hopscotch_map.h>
+#include <array>
+#include <string>
 
 namespace bw
 {
@@ -28,16 +30,27 @@ namespace bw
 			inline const std::shared_ptr<VirtualDirectory>& GetAssetDirectory() const;
 			const Nz::ImageRef& GetImage(const std::string& imagePath) const;
 
+			// Reuses resources already loaded by another store, for assets both stores resolve to the same file
+			void ImportAssets(const AssetStore& assetStore);
+
+			// Assets registered with the same checksum share their resources, which are loaded from the first registered path
+			void RegisterAssetChecksum(const std::string& assetPath, const std::array<Nz::UInt8, 20>& sha1Checksum);
+
 			inline void UpdateAssetDirectory(std::shared_ptr<VirtualDirectory> assetDirectory);
 
 		protected:
+			inline const std::string& GetSourcePath(const std::string& assetPath) const;
 			template<typename ResourceType, typename ParameterType> const Nz::ObjectRef<ResourceType>& GetResource(const std::string& resourcePath, tsl::hopscotch_map<std::string, Nz::ObjectRef<ResourceType>>& cache, const ParameterType& params) const;
+			template<typename ResourceType> std::size_t ImportResources(const AssetStore& assetStore, const tsl::hopscotch_map<std::string, Nz::ObjectRef<ResourceType>>& sourceCache, tsl::hopscotch_map<std::string, Nz::ObjectRef<ResourceType>>& cache) const;
+			bool IsSameAsset(const AssetStore& assetStore, const std::string& assetPath) const;
 
 			const Logger& m_logger;
 
 		private:
 			mutable tsl::hopscotch_map<std::string, Nz::ImageRef> m_images;
 			mutable std::shared_ptr<VirtualDirectory> m_assetDirectory;
+			tsl::hopscotch_map<std::string, std::string> m_checksumPaths; //< raw checksum => first path registered with it
+			tsl::hopscotch_map<std::string, std::string> m_sourcePaths; //< only for assets whose content was registered under another path
 	};
 }
 
@@ -19,6 +19,14 @@ namespace bw
 		return m_assetDirectory;
 	}
 
+	inline const std::string& AssetStore::GetSourcePath(const std::string& assetPath) const
+	{
+		if (auto it = m_sourcePaths.find(assetPath); it != m_sourcePaths.end())
+			return it->second;
+
+		return assetPath;
+	}
+
 	inline void AssetStore::UpdateAssetDirectory(std::shared_ptr<VirtualDirectory> assetDirectory)
 	{
 		m_assetDirectory = std::move(assetDirectory);
@@ -32,6 +40,15 @@ namespace bw
 		if (auto it = cache.find(resourcePath); it != cache.end())
 			return it->second;
 
+		if (const std::string& sourcePath = GetSourcePath(resourcePath); sourcePath != resourcePath)
+		{
+			Nz::ObjectRef<ResourceType> resource = GetResource(sourcePath, cache, params);
+			if (!resource)
+				return InvalidResource;
+
+			return cache.emplace(resourcePath, std::move(resource)).first->second;
+		}
+
 		VirtualDirectory::Entry entry;
 		if (!m_assetDirectory->GetEntry(resourcePath, &entry))
 			return InvalidResource;
@@ -39,7 +56,12 @@ namespace bw
 		auto resource = std::visit([&](auto&& arg) -> Nz::ObjectRef<ResourceType>
 		{
 			using T = std::decay_t<decltype(arg)>;
-			if constexpr (std::is_same_v<T, VirtualDirectory::FileContentEntry>)
+			if constexpr (std::is_same_v<T, VirtualDirectory::DataPointerEntry>)
+			{
+				bwLog(m_logger, LogLevel::Info, "Loading asset from memory");
+				return ResourceType::LoadFromMemory(arg.data, arg.size, params);
+			}
+			else if constexpr (std::is_same_v<T, VirtualDirectory::FileContentEntry>)
 			{
 				bwLog(m_logger, LogLevel::Info, "Loading asset from memory");
 				return ResourceType::LoadFromMemory(arg.data(), arg.size(), params);
@@ -62,4 +84,23 @@ namespace bw
 
 		return cache.emplace(resourcePath, std::move(resource)).first->second;
 	}
+
+	template<typename ResourceType>
+	std::size_t AssetStore::ImportResources(const AssetStore& assetStore, const tsl::hopscotch_map<std::string, Nz::ObjectRef<ResourceType>>& sourceCache, tsl::hopscotch_map<std::string, Nz::ObjectRef<ResourceType>>& cache) const
+	{
+		std::size_t importedCount = 0;
+		for (auto&& [resourcePath, resource] : sourceCache)
+		{
+			if (!resource || cache.find(resourcePath) != cache.end())
+				continue;
+
+			if (!IsSameAsset(assetStore, resourcePath))
+				continue;
+
+			cache.emplace(resourcePath, resource);
+			importedCount++;
+		}
+
+		return importedCount;
+	}
 }
@@ -0,0 +1,112 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_BINARYMAPREADER_HPP
+#define BURGWAR_CORELIB_BINARYMAPREADER_HPP
+
+#include <CoreLib/Export.hpp>
+#include <CoreLib/LayerIndex.hpp>
+#include <CoreLib/Map.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	// Parses a binary map header and section table, layers, scripts and assets are then loaded on demand
+	class BURGWAR_CORELIB_API BinaryMapReader
+	{
+		public:
+			enum class Compression : Nz::UInt8;
+			struct LayerSection;
+			struct ScriptSection;
+			struct Section;
+
+			static constexpr std::size_t MaxUncompressedSectionSize = 256 * 1024 * 1024;
+
+			BinaryMapReader(const std::filesystem::path& mapFile);
+			BinaryMapReader(const BinaryMapReader&) = delete;
+			BinaryMapReader(BinaryMapReader&&) noexcept = default;
+			~BinaryMapReader() = default;
+
+			inline const Nz::UInt8* GetData() const;
+			inline std::size_t GetContentOffset() const;
+			inline Nz::UInt16 GetFileVersion() const;
+			inline Nz::UInt32 GetGameVersion() const;
+			inline std::size_t GetLayerCount() const;
+			inline const LayerSection& GetLayerSection(LayerIndex layerIndex) const;
+			inline const MapInfo& GetMapInfo() const;
+			inline const std::shared_ptr<const MemoryMappedFile>& GetMapping() const;
+			inline std::size_t GetScriptCount() const;
+			inline const ScriptSection& GetScriptSection(std::size_t scriptIndex) const;
+			inline std::size_t GetSize() const;
+
+			inline bool HasSectionTable() const;
+
+			std::vector<Map::Asset> LoadAssets() const;
+			Map::Layer LoadLayer(LayerIndex layerIndex) const;
+			Map::Script LoadScript(std::size_t scriptIndex) const;
+
+			BinaryMapReader& operator=(const BinaryMapReader&) = delete;
+			BinaryMapReader& operator=(BinaryMapReader&&) noexcept = default;
+
+			enum class Compression : Nz::UInt8
+			{
+				None = 0,
+				LZ4 = 1
+			};
+
+			struct Section
+			{
+				static constexpr std::size_t ChecksumSize = 4; //< CRC32
+
+				std::optional<std::array<Nz::UInt8, ChecksumSize>> checksum; //< of stored bytes, maps before CompressedSectionFileVersion have none
+				Compression compression = Compression::None;
+				Nz::UInt64 offset = 0; //< from the end of the section table
+				Nz::UInt64 size = 0; //< stored size
+				Nz::UInt64 uncompressedSize = 0;
+			};
+
+			struct LayerSection
+			{
+				std::string name;
+				Section data;
+				Nz::UInt16 entityCount;
+			};
+
+			struct ScriptSection
+			{
+				std::string filepath;
+				Section bytecode;
+				Section content;
+			};
+
+			static std::array<Nz::UInt8, Section::ChecksumSize> ComputeChecksum(const Nz::UInt8* data, std::size_t size);
+
+		private:
+			const Nz::UInt8* ReadSection(const Section& section, std::vector<Nz::UInt8>& buffer, const std::string& sectionName) const;
+
+			std::shared_ptr<const MemoryMappedFile> m_mapping;
+			std::vector<LayerSection> m_layers;
+			std::vector<ScriptSection> m_scripts;
+			std::vector<Nz::UInt8> m_content; //< whole file content, when it couldn't be mapped
+			MapInfo m_mapInfo;
+			Section m_assets;
+			const Nz::UInt8* m_data;
+			std::size_t m_contentOffset; //< end of the section table, or of the header for maps without one
+			std::size_t m_size;
+			Nz::UInt32 m_gameVersion;
+			Nz::UInt16 m_fileVersion;
+	};
+}
+
+#include <CoreLib/BinaryMapReader.inl>
+
+#endif
@@ -0,0 +1,71 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/BinaryMapReader.hpp>
+#include <cassert>
+
+namespace bw
+{
+	inline const Nz::UInt8* BinaryMapReader::GetData() const
+	{
+		return m_data;
+	}
+
+	inline std::size_t BinaryMapReader::GetContentOffset() const
+	{
+		return m_contentOffset;
+	}
+
+	inline Nz::UInt16 BinaryMapReader::GetFileVersion() const
+	{
+		return m_fileVersion;
+	}
+
+	inline Nz::UInt32 BinaryMapReader::GetGameVersion() const
+	{
+		return m_gameVersion;
+	}
+
+	inline std::size_t BinaryMapReader::GetLayerCount() const
+	{
+		return m_layers.size();
+	}
+
+	inline auto BinaryMapReader::GetLayerSection(LayerIndex layerIndex) const -> const LayerSection&
+	{
+		assert(layerIndex < m_layers.size());
+		return m_layers[layerIndex];
+	}
+
+	inline const MapInfo& BinaryMapReader::GetMapInfo() const
+	{
+		return m_mapInfo;
+	}
+
+	inline const std::shared_ptr<const MemoryMappedFile>& BinaryMapReader::GetMapping() const
+	{
+		return m_mapping;
+	}
+
+	inline std::size_t BinaryMapReader::GetScriptCount() const
+	{
+		return m_scripts.size();
+	}
+
+	inline auto BinaryMapReader::GetScriptSection(std::size_t scriptIndex) const -> const ScriptSection&
+	{
+		assert(scriptIndex < m_scripts.size());
+		return m_scripts[scriptIndex];
+	}
+
+	inline std::size_t BinaryMapReader::GetSize() const
+	{
+		return m_size;
+	}
+
+	inline bool BinaryMapReader::HasSectionTable() const
+	{
+		return m_fileVersion >= Map::SectionTableFileVersion;
+	}
+}
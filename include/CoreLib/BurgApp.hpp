@@ -13,13 +13,17 @@
 #include <CoreLib/LogSystem/Logger.hpp>
 #include <Nazara/Prerequisites.hpp>
 #include <tsl/hopscotch_map.h>
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <optional>
 
 namespace bw
 {
 	class ConfigFile;
+	class JobSystem;
 	class Mod;
+	class ScriptBytecodeCache;
 
 	class BURGWAR_CORELIB_API BurgApp
 	{
@@ -28,12 +32,16 @@ namespace bw
 			~BurgApp();
 
 			inline Nz::UInt64 GetAppTime() const;
+			const std::shared_ptr<ScriptBytecodeCache>& GetBytecodeCache();
 			inline const ConfigFile& GetConfig() const;
+			JobSystem& GetJobSystem();
 			inline Logger& GetLogger();
 			inline Nz::UInt64 GetLogTime() const;
 			inline const tsl::hopscotch_map<std::string, std::shared_ptr<Mod>>& GetMods() const;
 			inline WebService& GetWebService();
 
+			bool LoadWebService();
+
 			void Update();
 
 		private:
@@ -51,9 +59,14 @@ namespace bw
 			virtual void Quit() = 0;
 
 			const ConfigFile& m_config;
+			std::once_flag m_bytecodeCacheFlag;
+			std::once_flag m_jobSystemFlag;
+			std::once_flag m_webServiceFlag;
 			std::optional<WebService> m_webService;
+			std::shared_ptr<ScriptBytecodeCache> m_bytecodeCache; //< shared by every match (and editor) of this application
+			std::unique_ptr<JobSystem> m_jobSystem; //< shared by every subsystem needing background work, continuations run in Update
 			tsl::hopscotch_map<std::string, std::shared_ptr<Mod>> m_mods;
-			Nz::UInt64 m_appTime;
+			std::atomic<Nz::UInt64> m_appTime; //< may be read by match threads
 			Nz::UInt64 m_lastTime;
 			Nz::UInt64 m_startTime;
 	};
@@ -0,0 +1,68 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_CHECKSUMCACHE_HPP
+#define BURGWAR_CORELIB_CHECKSUMCACHE_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Core/ByteArray.hpp>
+#include <tsl/hopscotch_map.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	class Logger;
+
+	// Persistent SHA1 checksums of files, invalidated when file size or last write time changes
+	class BURGWAR_CORELIB_API ChecksumCache
+	{
+		public:
+			ChecksumCache(const Logger& logger, std::filesystem::path cacheFile);
+			ChecksumCache(const ChecksumCache&) = delete;
+			ChecksumCache(ChecksumCache&&) = delete;
+			~ChecksumCache() = default;
+
+			Nz::ByteArray ComputeChecksum(const std::filesystem::path& filePath);
+			std::vector<Nz::ByteArray> ComputeChecksums(const std::vector<std::filesystem::path>& filePaths);
+
+			bool Save();
+
+			ChecksumCache& operator=(const ChecksumCache&) = delete;
+			ChecksumCache& operator=(ChecksumCache&&) = delete;
+
+		private:
+			struct FileInfo;
+
+			bool FindChecksum(const std::string& filePath, const FileInfo& fileInfo, Nz::ByteArray* checksum) const;
+			bool Load();
+			void UpdateChecksum(std::string filePath, const FileInfo& fileInfo, const Nz::ByteArray& checksum);
+
+			static bool RetrieveFileInfo(const std::filesystem::path& filePath, FileInfo* fileInfo);
+
+			struct FileInfo
+			{
+				Nz::Int64 lastWriteTime;
+				Nz::UInt64 size;
+			};
+
+			struct Entry
+			{
+				FileInfo fileInfo;
+				Nz::ByteArray checksum;
+			};
+
+			std::filesystem::path m_cacheFile;
+			tsl::hopscotch_map<std::string, Entry> m_entries;
+			const Logger& m_logger;
+			bool m_isDirty;
+	};
+}
+
+#include <CoreLib/ChecksumCache.inl>
+
+#endif
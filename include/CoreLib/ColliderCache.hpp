@@ -0,0 +1,69 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_COLLIDERCACHE_HPP
+#define BURGWAR_CORELIB_COLLIDERCACHE_HPP
+
+#include <CoreLib/Colliders.hpp>
+#include <CoreLib/Export.hpp>
+#include <Nazara/Physics2D/Collider2D.hpp>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace bw
+{
+	// Immutable collider list, shared by every entity using the same colliders
+	class BURGWAR_CORELIB_API ColliderGeometry
+	{
+		public:
+			explicit ColliderGeometry(std::vector<Collider> colliders);
+			ColliderGeometry(const ColliderGeometry&) = delete;
+			ColliderGeometry(ColliderGeometry&&) = delete;
+			~ColliderGeometry() = default;
+
+			Nz::Collider2DRef BuildCollider(float scale = 1.f) const;
+
+			inline const std::vector<Collider>& GetColliders() const;
+
+			ColliderGeometry& operator=(const ColliderGeometry&) = delete;
+			ColliderGeometry& operator=(ColliderGeometry&&) = delete;
+
+			static constexpr std::size_t MaxBuiltScaleCount = 4;
+
+		private:
+			static Nz::Collider2DRef ToCollider(const Collider& collider, float scale);
+
+			std::vector<Collider> m_colliders;
+			mutable std::vector<std::pair<float /*scale*/, Nz::Collider2DRef>> m_builtColliders; //< most recently used last
+	};
+
+	// Deduplicates collider geometries of an element class, used under the scripting lock
+	class BURGWAR_CORELIB_API ColliderCache
+	{
+		public:
+			ColliderCache() = default;
+			ColliderCache(const ColliderCache&) = delete;
+			ColliderCache(ColliderCache&&) noexcept = default;
+			~ColliderCache() = default;
+
+			inline void Clear();
+
+			std::shared_ptr<const ColliderGeometry> GetGeometry(std::vector<Collider> colliders);
+
+			ColliderCache& operator=(const ColliderCache&) = delete;
+			ColliderCache& operator=(ColliderCache&&) noexcept = default;
+
+			static constexpr std::size_t MaxGeometryCount = 32;
+
+		private:
+			std::vector<std::shared_ptr<const ColliderGeometry>> m_geometries;
+	};
+}
+
+#include <CoreLib/ColliderCache.inl>
+
+#endif
@@ -0,0 +1,18 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/ColliderCache.hpp>
+
+namespace bw
+{
+	inline const std::vector<Collider>& ColliderGeometry::GetColliders() const
+	{
+		return m_colliders;
+	}
+
+	inline void ColliderCache::Clear()
+	{
+		m_geometries.clear();
+	}
+}
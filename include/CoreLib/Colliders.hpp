@@ -20,6 +20,9 @@ namespace bw
 		Nz::Vector2f surfaceVelocity = Nz::Vector2f::Zero();
 		bool isTrigger = false;
 		unsigned int colliderId = 0;
+
+		inline bool operator==(const ColliderPhysics& rhs) const;
+		inline bool operator!=(const ColliderPhysics& rhs) const;
 	};
 
 	struct CircleCollider
@@ -27,12 +30,18 @@ namespace bw
 		ColliderPhysics physics;
 		Nz::Vector2f offset;
 		float radius;
+
+		inline bool operator==(const CircleCollider& rhs) const;
+		inline bool operator!=(const CircleCollider& rhs) const;
 	};
 
 	struct RectangleCollider
 	{
 		ColliderPhysics physics;
 		Nz::Rectf data;
+
+		inline bool operator==(const RectangleCollider& rhs) const;
+		inline bool operator!=(const RectangleCollider& rhs) const;
 	};
 
 	struct SegmentCollider
@@ -42,9 +51,14 @@ namespace bw
 		Nz::Vector2f fromNeighbor;
 		Nz::Vector2f to;
 		Nz::Vector2f toNeighbor;
+
+		inline bool operator==(const SegmentCollider& rhs) const;
+		inline bool operator!=(const SegmentCollider& rhs) const;
 	};
 
 	using Collider = std::variant<CircleCollider, RectangleCollider, SegmentCollider>;
 }
 
+#include <CoreLib/Colliders.inl>
+
 #endif
@@ -0,0 +1,56 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Colliders.hpp>
+
+namespace bw
+{
+	inline bool ColliderPhysics::operator==(const ColliderPhysics& rhs) const
+	{
+		return elasticity == rhs.elasticity &&
+		       friction == rhs.friction &&
+		       surfaceVelocity == rhs.surfaceVelocity &&
+		       isTrigger == rhs.isTrigger &&
+		       colliderId == rhs.colliderId;
+	}
+
+	inline bool ColliderPhysics::operator!=(const ColliderPhysics& rhs) const
+	{
+		return !operator==(rhs);
+	}
+
+	inline bool CircleCollider::operator==(const CircleCollider& rhs) const
+	{
+		return physics == rhs.physics && offset == rhs.offset && radius == rhs.radius;
+	}
+
+	inline bool CircleCollider::operator!=(const CircleCollider& rhs) const
+	{
+		return !operator==(rhs);
+	}
+
+	inline bool RectangleCollider::operator==(const RectangleCollider& rhs) const
+	{
+		return physics == rhs.physics && data == rhs.data;
+	}
+
+	inline bool RectangleCollider::operator!=(const RectangleCollider& rhs) const
+	{
+		return !operator==(rhs);
+	}
+
+	inline bool SegmentCollider::operator==(const SegmentCollider& rhs) const
+	{
+		return physics == rhs.physics &&
+		       from == rhs.from &&
+		       fromNeighbor == rhs.fromNeighbor &&
+		       to == rhs.to &&
+		       toNeighbor == rhs.toNeighbor;
+	}
+
+	inline bool SegmentCollider::operator!=(const SegmentCollider& rhs) const
+	{
+		return !operator==(rhs);
+	}
+}
@@ -7,9 +7,9 @@
 #ifndef BURGWAR_CORELIB_COMMANDSTORE_HPP
 #define BURGWAR_CORELIB_COMMANDSTORE_HPP
 
+#include <CoreLib/TypedPacket.hpp>
 #include <Nazara/Network/ENetPacket.hpp>
 #include <Nazara/Network/NetPacket.hpp>
-#include <functional>
 #include <type_traits>
 #include <vector>
 
@@ -17,6 +17,15 @@ namespace bw
 {
 	class Logger;
 
+	struct CommandStatistics
+	{
+		Nz::UInt64 byteCount = 0;
+		Nz::UInt64 packetCount = 0;
+		Nz::UInt64 processingTime = 0; //< time spent (un)serializing, in microseconds
+	};
+
+	using CommandStatisticsList = std::vector<CommandStatistics>; //< indexed by packet type
+
 	template<typename Peer>
 	class CommandStore
 	{
@@ -29,19 +38,38 @@ namespace bw
 			CommandStore(const Logger& logger);
 			~CommandStore() = default;
 
+			bool DecodePacket(Nz::NetPacket& packet, TypedPacket& typedPacket) const; //< only reads registered commands (can be called from any thread once registration is done)
+
 			template<typename T> const IncomingCommand& GetIncomingCommand() const;
+			inline const char* GetIncomingCommandName(std::size_t packetId) const;
+			inline const CommandStatisticsList& GetIncomingStatistics() const;
 			template<typename T> const OutgoingCommand& GetOutgoingCommand() const;
+			inline const char* GetOutgoingCommandName(std::size_t packetId) const;
+			inline const CommandStatisticsList& GetOutgoingStatistics() const;
+
+			bool HandleTypedPacket(PeerRef peer, TypedPacket& packet, CommandStatisticsList* sessionStatistics = nullptr);
+
+			inline void RecordOutgoingPacket(std::size_t packetId, std::size_t byteCount, Nz::UInt64 serializationTime, CommandStatisticsList* sessionStatistics = nullptr);
 
 			template<typename T>
-			void SerializePacket(Nz::NetPacket& packet, const T& data) const;
+			static void SerializePacket(Nz::NetPacket& packet, const T& data, bool compress = false); //< doesn't depend on any store state (can be called from any thread)
+
+			bool UnserializePacket(PeerRef peer, Nz::NetPacket& packet, CommandStatisticsList* sessionStatistics = nullptr);
 
-			bool UnserializePacket(PeerRef peer, Nz::NetPacket& packet) const;
+			template<typename T> using Callback = void(*)(PeerRef peer, T&& packet);
 
-			using UnserializeFunction = std::function<void(PeerRef peer, Nz::NetPacket& packet)>;
+			// Commands are dispatched through plain function pointers, generated for each packet type at registration
+			using GenericCallback = void(*)();
+			using DecodeFunction = bool(*)(const CommandStore& store, Nz::NetPacket& packet, TypedPacket& typedPacket);
+			using HandleFunction = void(*)(GenericCallback callback, PeerRef peer, void* packet);
+			using UnserializeFunction = bool(*)(const CommandStore& store, GenericCallback callback, PeerRef peer, Nz::NetPacket& packet, Nz::UInt64& unserializationTime);
 
 			struct IncomingCommand
 			{
 				bool enabled = false;
+				GenericCallback callback; //< Callback<T> of the packet type
+				DecodeFunction decode;
+				HandleFunction handle; //< for typed packets
 				UnserializeFunction unserialize;
 				const char* name;
 			};
@@ -50,20 +78,33 @@ namespace bw
 			{
 				bool enabled = false;
 				const char* name;
+				bool compress;
 				Nz::ENetPacketFlags flags;
 				Nz::UInt8 channelId;
 			};
 
+			static constexpr Nz::UInt8 CompressedOpcodeFlag = 0x80; //< payload is LZ4-compressed and preceded by its uncompressed size
+
 		protected:
-			template<typename T, typename CB> void RegisterIncomingCommand(const char* name, CB&& callback);
-			template<typename T> void RegisterOutgoingCommand(const char* name, Nz::ENetPacketFlags flags, Nz::UInt8 channelId);
+			template<typename T> void RegisterIncomingCommand(const char* name, Callback<T> callback);
+			template<typename T> void RegisterOutgoingCommand(const char* name, Nz::ENetPacketFlags flags, Nz::UInt8 channelId, bool compress = false);
+			inline void SetMaxUncompressedSize(std::size_t maxUncompressedSize); //< largest payload a peer may claim for a compressed packet
 
 		private:
-			using HandleFunction = std::function<void(Nz::NetPacket& packet)>;
+			template<typename F> bool ReadCommand(Nz::NetPacket& packet, F&& func) const;
+
+			template<typename T> static bool DecodeCommand(const CommandStore& store, Nz::NetPacket& packet, TypedPacket& typedPacket);
+			template<typename T> static void HandleCommand(GenericCallback callback, PeerRef peer, void* packet);
+			template<typename T> static bool UnserializeCommand(const CommandStore& store, GenericCallback callback, PeerRef peer, Nz::NetPacket& packet, Nz::UInt64& unserializationTime);
+
+			static void RecordStatistics(CommandStatisticsList& statistics, std::size_t packetId, std::size_t byteCount, Nz::UInt64 processingTime);
 
 			std::vector<IncomingCommand> m_incomingCommands;
 			std::vector<OutgoingCommand> m_outgoingCommands;
+			CommandStatisticsList m_incomingStatistics;
+			CommandStatisticsList m_outgoingStatistics;
 			const Logger& m_logger;
+			std::size_t m_maxUncompressedSize;
 	};
 }
 
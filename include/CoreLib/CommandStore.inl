@@ -4,17 +4,30 @@
 
 #include <CoreLib/CommandStore.hpp>
 #include <CoreLib/LogSystem/Logger.hpp>
+#include <CoreLib/Protocol/CompressedInteger.hpp>
+#include <CoreLib/Protocol/PacketCompression.hpp>
 #include <CoreLib/Protocol/Packets.hpp>
+#include <Nazara/Core/Clock.hpp>
 #include <cassert>
 
 namespace bw
 {
 	template<typename Peer>
 	inline CommandStore<Peer>::CommandStore(const Logger& logger) :
-	m_logger(logger)
+	m_logger(logger),
+	m_maxUncompressedSize(PacketMaxUncompressedSize)
 	{
 	}
 
+	template<typename Peer>
+	bool CommandStore<Peer>::DecodePacket(Nz::NetPacket& packet, TypedPacket& typedPacket) const
+	{
+		return ReadCommand(packet, [&](Nz::UInt8 /*opcode*/, const IncomingCommand& command, Nz::NetPacket& payload)
+		{
+			return command.decode(*this, payload, typedPacket);
+		});
+	}
+
 	template<typename Peer>
 	template<typename T>
 	auto CommandStore<Peer>::GetIncomingCommand() const -> const IncomingCommand&
@@ -28,6 +41,21 @@ namespace bw
 		return command;
 	}
 
+	template<typename Peer>
+	const char* CommandStore<Peer>::GetIncomingCommandName(std::size_t packetId) const
+	{
+		if (packetId >= m_incomingCommands.size() || !m_incomingCommands[packetId].enabled)
+			return nullptr;
+
+		return m_incomingCommands[packetId].name;
+	}
+
+	template<typename Peer>
+	auto CommandStore<Peer>::GetIncomingStatistics() const -> const CommandStatisticsList&
+	{
+		return m_incomingStatistics;
+	}
+
 	template<typename Peer>
 	template<typename T>
 	auto CommandStore<Peer>::GetOutgoingCommand() const -> const OutgoingCommand&
@@ -42,8 +70,52 @@ namespace bw
 	}
 
 	template<typename Peer>
-	template<typename T, typename CB>
-	void CommandStore<Peer>::RegisterIncomingCommand(const char* name, CB&& callback)
+	const char* CommandStore<Peer>::GetOutgoingCommandName(std::size_t packetId) const
+	{
+		if (packetId >= m_outgoingCommands.size() || !m_outgoingCommands[packetId].enabled)
+			return nullptr;
+
+		return m_outgoingCommands[packetId].name;
+	}
+
+	template<typename Peer>
+	auto CommandStore<Peer>::GetOutgoingStatistics() const -> const CommandStatisticsList&
+	{
+		return m_outgoingStatistics;
+	}
+
+	template<typename Peer>
+	bool CommandStore<Peer>::HandleTypedPacket(PeerRef peer, TypedPacket& packet, CommandStatisticsList* sessionStatistics)
+	{
+		std::size_t packetId = packet.packetId;
+		if (m_incomingCommands.size() <= packetId || !m_incomingCommands[packetId].enabled)
+		{
+			bwLog(m_logger, LogLevel::Error, "Received invalid or disabled typed packet: {}", packetId);
+			return false;
+		}
+
+		const IncomingCommand& command = m_incomingCommands[packetId];
+		command.handle(command.callback, peer, packet.data.get());
+
+		// No bytes went through, only packet count is meaningful
+		RecordStatistics(m_incomingStatistics, packetId, 0, 0);
+		if (sessionStatistics)
+			RecordStatistics(*sessionStatistics, packetId, 0, 0);
+
+		return true;
+	}
+
+	template<typename Peer>
+	void CommandStore<Peer>::RecordOutgoingPacket(std::size_t packetId, std::size_t byteCount, Nz::UInt64 serializationTime, CommandStatisticsList* sessionStatistics)
+	{
+		RecordStatistics(m_outgoingStatistics, packetId, byteCount, serializationTime);
+		if (sessionStatistics)
+			RecordStatistics(*sessionStatistics, packetId, byteCount, serializationTime);
+	}
+
+	template<typename Peer>
+	template<typename T>
+	void CommandStore<Peer>::RegisterIncomingCommand(const char* name, Callback<T> callback)
 	{
 		std::size_t packetId = static_cast<std::size_t>(T::Type);
 
@@ -51,47 +123,42 @@ namespace bw
 			m_incomingCommands.resize(packetId + 1);
 
 		IncomingCommand& newCommand = m_incomingCommands[packetId];
+		newCommand.callback = reinterpret_cast<GenericCallback>(callback);
+		newCommand.decode = &DecodeCommand<T>;
 		newCommand.enabled = true;
-		newCommand.unserialize = [this, cb = std::forward<CB>(callback)](PeerRef peer, Nz::NetPacket& packet)
-		{
-			T data;
-			try
-			{
-				PacketSerializer serializer(packet, false);
-
-				Packets::Serialize(serializer, data);
-			}
-			catch (const std::exception&)
-			{
-				bwLog(m_logger, LogLevel::Error, "Failed to unserialize packet");
-				return false;
-			}
-
-			cb(peer, std::move(data));
-			return true;
-		};
+		newCommand.handle = &HandleCommand<T>;
+		newCommand.unserialize = &UnserializeCommand<T>;
 		newCommand.name = name;
 	}
 
 	template<typename Peer>
 	template<typename T>
-	void CommandStore<Peer>::RegisterOutgoingCommand(const char* name, Nz::ENetPacketFlags flags, Nz::UInt8 channelId)
+	void CommandStore<Peer>::RegisterOutgoingCommand(const char* name, Nz::ENetPacketFlags flags, Nz::UInt8 channelId, bool compress)
 	{
 		std::size_t packetId = static_cast<std::size_t>(T::Type);
+		static_assert(static_cast<std::size_t>(T::Type) < CompressedOpcodeFlag);
 
 		if (m_outgoingCommands.size() <= packetId)
 			m_outgoingCommands.resize(packetId + 1);
 
 		OutgoingCommand& newCommand = m_outgoingCommands[packetId];
 		newCommand.channelId = channelId;
+		newCommand.compress = compress;
 		newCommand.enabled = true;
 		newCommand.flags = flags;
 		newCommand.name = name;
 	}
 
+	template<typename Peer>
+	inline void CommandStore<Peer>::SetMaxUncompressedSize(std::size_t maxUncompressedSize)
+	{
+		assert(maxUncompressedSize <= PacketMaxUncompressedSize);
+		m_maxUncompressedSize = maxUncompressedSize;
+	}
+
 	template<typename Peer>
 	template<typename T>
-	void CommandStore<Peer>::SerializePacket(Nz::NetPacket& packet, const T& data) const
+	void CommandStore<Peer>::SerializePacket(Nz::NetPacket& packet, const T& data, bool compress)
 	{
 		packet << static_cast<Nz::UInt8>(T::Type);
 
@@ -103,10 +170,52 @@ namespace bw
 		Packets::Serialize(serializer, dataRef);
 
 		packet.FlushBits();
+
+		if (compress)
+		{
+			// Compress everything following the opcode, packet is left untouched if it's not worth it
+			const Nz::UInt8* payload = static_cast<const Nz::UInt8*>(packet.GetConstData()) + Nz::NetPacket::HeaderSize + 1;
+			std::size_t payloadSize = packet.GetDataSize() - 1;
+
+			std::vector<Nz::UInt8> compressedPayload;
+			if (CompressPacketPayload(payload, payloadSize, compressedPayload))
+			{
+				packet.Reset(packet.GetNetCode());
+				packet << static_cast<Nz::UInt8>(static_cast<Nz::UInt8>(T::Type) | CompressedOpcodeFlag);
+				packet << CompressedUnsigned<Nz::UInt32>(Nz::UInt32(payloadSize));
+				packet.Write(compressedPayload.data(), compressedPayload.size());
+			}
+		}
+	}
+
+	template<typename Peer>
+	bool CommandStore<Peer>::UnserializePacket(PeerRef peer, Nz::NetPacket& packet, CommandStatisticsList* sessionStatistics)
+	{
+		std::size_t byteCount = packet.GetDataSize();
+		Nz::UInt64 startTime = Nz::GetElapsedMicroseconds();
+
+		return ReadCommand(packet, [&](Nz::UInt8 opcode, const IncomingCommand& command, Nz::NetPacket& payload)
+		{
+			// Account for decompression time as well
+			Nz::UInt64 readTime = Nz::GetElapsedMicroseconds() - startTime;
+
+			Nz::UInt64 unserializationTime = 0;
+			if (!command.unserialize(*this, command.callback, peer, payload, unserializationTime))
+				return false;
+
+			unserializationTime += readTime;
+
+			RecordStatistics(m_incomingStatistics, opcode, byteCount, unserializationTime);
+			if (sessionStatistics)
+				RecordStatistics(*sessionStatistics, opcode, byteCount, unserializationTime);
+
+			return true;
+		});
 	}
 
 	template<typename Peer>
-	bool CommandStore<Peer>::UnserializePacket(PeerRef peer, Nz::NetPacket& packet) const
+	template<typename F>
+	bool CommandStore<Peer>::ReadCommand(Nz::NetPacket& packet, F&& func) const
 	{
 		Nz::UInt8 opcode;
 		try
@@ -119,13 +228,120 @@ namespace bw
 			return false;
 		}
 
+		bool isCompressed = (opcode & CompressedOpcodeFlag) != 0;
+		opcode &= Nz::UInt8(~CompressedOpcodeFlag);
+
 		if (m_incomingCommands.size() <= opcode || !m_incomingCommands[opcode].enabled)
 		{
 			bwLog(m_logger, LogLevel::Error, "Client :derp: sent invalid or disabled opcode: {}", +opcode);
 			return false;
 		}
 
-		m_incomingCommands[opcode].unserialize(peer, packet);
+		const IncomingCommand& command = m_incomingCommands[opcode];
+
+		if (isCompressed)
+		{
+			CompressedUnsigned<Nz::UInt32> uncompressedSize;
+			try
+			{
+				packet >> uncompressedSize;
+			}
+			catch (const std::exception&)
+			{
+				bwLog(m_logger, LogLevel::Error, "Failed to unserialize compressed packet size");
+				return false;
+			}
+
+			// Checked before decompressing as the claimed size is allocated up front
+			if (uncompressedSize > m_maxUncompressedSize)
+			{
+				bwLog(m_logger, LogLevel::Error, "Compressed packet claims a too large payload ({} bytes, opcode: {})", Nz::UInt32(uncompressedSize), +opcode);
+				return false;
+			}
+
+			std::size_t offset = static_cast<std::size_t>(packet.GetStream()->GetCursorPos());
+			std::size_t packetSize = Nz::NetPacket::HeaderSize + packet.GetDataSize();
+
+			const Nz::UInt8* compressedPayload = static_cast<const Nz::UInt8*>(packet.GetConstData()) + offset;
+
+			std::vector<Nz::UInt8> payload;
+			if (offset > packetSize || !DecompressPacketPayload(compressedPayload, packetSize - offset, uncompressedSize, payload))
+			{
+				bwLog(m_logger, LogLevel::Error, "Failed to decompress packet (opcode: {})", +opcode);
+				return false;
+			}
+
+			Nz::NetPacket uncompressedPacket(packet.GetNetCode(), payload.data(), payload.size());
+			return func(opcode, command, uncompressedPacket);
+		}
+		else
+			return func(opcode, command, packet);
+	}
+
+	template<typename Peer>
+	template<typename T>
+	bool CommandStore<Peer>::DecodeCommand(const CommandStore& store, Nz::NetPacket& packet, TypedPacket& typedPacket)
+	{
+		auto data = std::make_shared<T>();
+		try
+		{
+			PacketSerializer serializer(packet, false);
+
+			Packets::Serialize(serializer, *data);
+		}
+		catch (const std::exception&)
+		{
+			bwLog(store.m_logger, LogLevel::Error, "Failed to unserialize packet");
+			return false;
+		}
+
+		typedPacket.data = std::move(data);
+		typedPacket.packetId = static_cast<std::size_t>(T::Type);
+		return true;
+	}
+
+	template<typename Peer>
+	template<typename T>
+	void CommandStore<Peer>::HandleCommand(GenericCallback callback, PeerRef peer, void* packet)
+	{
+		// Packet type is guaranteed by its id
+		reinterpret_cast<Callback<T>>(callback)(peer, std::move(*static_cast<T*>(packet)));
+	}
+
+	template<typename Peer>
+	template<typename T>
+	bool CommandStore<Peer>::UnserializeCommand(const CommandStore& store, GenericCallback callback, PeerRef peer, Nz::NetPacket& packet, Nz::UInt64& unserializationTime)
+	{
+		Nz::UInt64 startTime = Nz::GetElapsedMicroseconds();
+
+		T data;
+		try
+		{
+			PacketSerializer serializer(packet, false);
+
+			Packets::Serialize(serializer, data);
+		}
+		catch (const std::exception&)
+		{
+			bwLog(store.m_logger, LogLevel::Error, "Failed to unserialize packet");
+			return false;
+		}
+
+		unserializationTime = Nz::GetElapsedMicroseconds() - startTime;
+
+		reinterpret_cast<Callback<T>>(callback)(peer, std::move(data));
 		return true;
 	}
+
+	template<typename Peer>
+	void CommandStore<Peer>::RecordStatistics(CommandStatisticsList& statistics, std::size_t packetId, std::size_t byteCount, Nz::UInt64 processingTime)
+	{
+		if (statistics.size() <= packetId)
+			statistics.resize(packetId + 1);
+
+		CommandStatistics& commandStatistics = statistics[packetId];
+		commandStatistics.byteCount += byteCount;
+		commandStatistics.packetCount++;
+		commandStatistics.processingTime += processingTime;
+	}
 }
@@ -7,10 +7,11 @@
 #ifndef BURGWAR_CORELIB_COMPONENTS_COLLISIONDATA_HPP
 #define BURGWAR_CORELIB_COMPONENTS_COLLISIONDATA_HPP
 
-#include <CoreLib/Colliders.hpp>
+#include <CoreLib/ColliderCache.hpp>
 #include <CoreLib/Export.hpp>
 #include <Nazara/Physics2D/Collider2D.hpp>
 #include <NDK/Component.hpp>
+#include <memory>
 #include <vector>
 
 namespace bw
@@ -20,21 +21,18 @@ namespace bw
 		friend class ColliderSystem;
 
 		public:
-			CollisionDataComponent() = default;
+			inline CollisionDataComponent(std::shared_ptr<const ColliderGeometry> geometry);
 			~CollisionDataComponent() = default;
 
-			inline void AddCollider(Collider collider);
-
-			Nz::Collider2DRef BuildCollider(float scale = 1.f) const;
+			inline Nz::Collider2DRef BuildCollider(float scale = 1.f) const;
 
 			inline const std::vector<Collider>& GetColliders() const;
+			inline const std::shared_ptr<const ColliderGeometry>& GetGeometry() const;
 
 			static Ndk::ComponentIndex componentIndex;
 
 		private:
-			static Nz::Collider2DRef ToCollider(const Collider& collider, float scale);
-
-			std::vector<Collider> m_colliders;
+			std::shared_ptr<const ColliderGeometry> m_geometry;
 	};
 }
 
@@ -3,16 +3,28 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/Components/CollisionDataComponent.hpp>
+#include <cassert>
 
 namespace bw
 {
-	inline void CollisionDataComponent::AddCollider(Collider collider)
+	inline CollisionDataComponent::CollisionDataComponent(std::shared_ptr<const ColliderGeometry> geometry) :
+	m_geometry(std::move(geometry))
 	{
-		m_colliders.emplace_back(std::move(collider));
+		assert(m_geometry);
+	}
+
+	inline Nz::Collider2DRef CollisionDataComponent::BuildCollider(float scale) const
+	{
+		return m_geometry->BuildCollider(scale);
 	}
 
 	inline const std::vector<Collider>& CollisionDataComponent::GetColliders() const
 	{
-		return m_colliders;
+		return m_geometry->GetColliders();
+	}
+
+	inline const std::shared_ptr<const ColliderGeometry>& CollisionDataComponent::GetGeometry() const
+	{
+		return m_geometry;
 	}
 }
@@ -27,6 +27,8 @@ namespace bw
 
 			inline void Heal(Nz::UInt16 heal, const Ndk::EntityHandle& healer);
 
+			inline void RestoreHealth(Nz::UInt16 health);
+
 			static Ndk::ComponentIndex componentIndex;
 
 			NazaraSignal(OnDamage, HealthComponent* /*emitter*/, Nz::UInt16& /*damage*/, const Ndk::EntityHandle& /*attacker*/);
@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/Components/HealthComponent.hpp>
+#include <cassert>
 
 namespace bw
 {
@@ -79,4 +80,11 @@ namespace bw
 			m_currentHealth = newHealth;
 		}
 	}
+
+	inline void HealthComponent::RestoreHealth(Nz::UInt16 health)
+	{
+		// Doesn't trigger any signal, used when restoring a previous state
+		assert(health <= m_maxHealth);
+		m_currentHealth = health;
+	}
 }
@@ -32,6 +32,7 @@ namespace bw
 
 			static Ndk::ComponentIndex componentIndex;
 
+			NazaraSignal(OnControllerUpdate, InputComponent* /*input*/);
 			NazaraSignal(OnInputUpdate, InputComponent* /*input*/);
 
 		private:
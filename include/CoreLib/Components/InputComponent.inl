@@ -36,6 +36,8 @@ namespace bw
 	inline void InputComponent::UpdateController(std::shared_ptr<InputController> inputController)
 	{
 		m_inputController = std::move(inputController);
+
+		OnControllerUpdate(this);
 	}
 
 	inline void InputComponent::UpdateInputs(const PlayerInputData& inputData)
@@ -26,6 +26,8 @@ namespace bw
 			inline Match& GetMatch() const;
 			inline EntityId GetUniqueId() const;
 
+			inline void UpdateUniqueId(EntityId uniqueId);
+
 			static Ndk::ComponentIndex componentIndex;
 
 		private:
@@ -27,4 +27,9 @@ namespace bw
 	{
 		return m_uniqueId;
 	}
+
+	inline void MatchComponent::UpdateUniqueId(EntityId uniqueId)
+	{
+		m_uniqueId = uniqueId;
+	}
 }
@@ -8,6 +8,7 @@
 #define BURGWAR_CORELIB_COMPONENTS_NETWORKSYNCCOMPONENT_HPP
 
 #include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
 #include <Nazara/Core/Signal.hpp>
 #include <NDK/Component.hpp>
 #include <vector>
@@ -17,15 +18,27 @@ namespace bw
 	class BURGWAR_CORELIB_API NetworkSyncComponent : public Ndk::Component<NetworkSyncComponent>
 	{
 		public:
+			struct Settings;
+
 			inline NetworkSyncComponent(std::string entityClass, const Ndk::EntityHandle& parent = Ndk::EntityHandle::InvalidHandle);
 			~NetworkSyncComponent() = default;
 
 			inline const std::string& GetEntityClass() const;
 			inline const Ndk::EntityHandle& GetParent() const;
+			inline const Settings& GetSettings() const;
 
 			inline void Invalidate();
 
 			inline void UpdateParent(const Ndk::EntityHandle& parent);
+			inline void UpdateSettings(const Settings& settings);
+
+			// How movement of this entity competes for the space of MatchState packets (see MatchClientVisibility::SendMatchState)
+			struct Settings
+			{
+				Nz::UInt8 priority = 1; //< added to the entity priority each time it has movement to send, entities with the highest priority are sent first
+				float maxUpdateRate = 0.f; //< movement updates per second each client gets at most (0 = no limit)
+				float relevanceDistance = 0.f; //< with an interest area, distance to controlled entities under which the entity is sent (0 = interest area radius)
+			};
 
 			static Ndk::ComponentIndex componentIndex;
 
@@ -34,6 +47,7 @@ namespace bw
 		private:
 			Ndk::EntityHandle m_parent;
 			std::string m_entityClass;
+			Settings m_settings;
 	};
 }
 
@@ -22,6 +22,11 @@ namespace bw
 		return m_parent;
 	}
 
+	inline auto NetworkSyncComponent::GetSettings() const -> const Settings&
+	{
+		return m_settings;
+	}
+
 	inline void NetworkSyncComponent::Invalidate()
 	{
 		OnInvalidated(this);
@@ -32,4 +37,9 @@ namespace bw
 		m_parent = parent;
 		//TODO: network event
 	}
+
+	inline void NetworkSyncComponent::UpdateSettings(const Settings& settings)
+	{
+		m_settings = settings;
+	}
 }
@@ -10,6 +10,7 @@
 #include <CoreLib/Export.hpp>
 #include <Nazara/Math/Vector2.hpp>
 #include <NDK/Component.hpp>
+#include <NDK/Entity.hpp>
 #include <memory>
 #include <vector>
 
@@ -23,6 +24,10 @@ namespace bw
 			PlayerMovementComponent();
 			~PlayerMovementComponent() = default;
 
+			inline void ClearTouchedEntities();
+
+			inline void EnableContactTracking(bool enable);
+
 			inline const std::shared_ptr<PlayerMovementController>& GetController() const;
 			inline float GetGroundFriction() const;
 			inline float GetJumpBoostHeight() const;
@@ -30,10 +35,14 @@ namespace bw
 			inline float GetJumpTime() const;
 			inline float GetMovementSpeed() const;
 			inline const Nz::Vector2f& GetTargetVelocity() const;
+			inline const std::vector<Ndk::EntityHandle>& GetTouchedEntities() const;
 
+			inline bool IsContactTrackingEnabled() const;
 			inline bool IsFacingRight() const;
 			inline bool IsOnGround() const;
 
+			inline void RecordContact(const Ndk::EntityHandle& entity);
+
 			void UpdateController(std::shared_ptr<PlayerMovementController> controller);
 			inline bool UpdateFacingRightState(bool isFacingRight);
 			inline void UpdateGroundFriction(float groundFriction);
@@ -51,7 +60,9 @@ namespace bw
 
 		private:
 			std::shared_ptr<PlayerMovementController> m_controller;
+			std::vector<Ndk::EntityHandle> m_touchedEntities; //< only filled when contact tracking is enabled (by client prediction)
 			Nz::Vector2f m_targetVelocity;
+			bool m_isContactTrackingEnabled;
 			bool m_isFacingRight;
 			bool m_isOnGround;
 			bool m_lastJumpingState;
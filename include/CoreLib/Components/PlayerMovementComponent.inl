@@ -3,11 +3,13 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/Components/PlayerMovementComponent.hpp>
+#include <algorithm>
 
 namespace bw
 {
 	inline PlayerMovementComponent::PlayerMovementComponent() :
 	m_targetVelocity(Nz::Vector2f::Zero()),
+	m_isContactTrackingEnabled(false),
 	m_isFacingRight(true),
 	m_isOnGround(false),
 	m_lastJumpingState(false),
@@ -19,6 +21,18 @@ namespace bw
 	{
 	}
 
+	inline void PlayerMovementComponent::ClearTouchedEntities()
+	{
+		m_touchedEntities.clear();
+	}
+
+	inline void PlayerMovementComponent::EnableContactTracking(bool enable)
+	{
+		m_isContactTrackingEnabled = enable;
+		if (!enable)
+			m_touchedEntities.clear();
+	}
+
 	inline const std::shared_ptr<PlayerMovementController>& PlayerMovementComponent::GetController() const
 	{
 		return m_controller;
@@ -54,6 +68,16 @@ namespace bw
 		return m_targetVelocity;
 	}
 
+	inline const std::vector<Ndk::EntityHandle>& PlayerMovementComponent::GetTouchedEntities() const
+	{
+		return m_touchedEntities;
+	}
+
+	inline bool PlayerMovementComponent::IsContactTrackingEnabled() const
+	{
+		return m_isContactTrackingEnabled;
+	}
+
 	inline bool PlayerMovementComponent::IsFacingRight() const
 	{
 		return m_isFacingRight;
@@ -64,6 +88,15 @@ namespace bw
 		return m_isOnGround;
 	}
 
+	inline void PlayerMovementComponent::RecordContact(const Ndk::EntityHandle& entity)
+	{
+		if (!m_isContactTrackingEnabled)
+			return;
+
+		if (std::find(m_touchedEntities.begin(), m_touchedEntities.end(), entity) == m_touchedEntities.end())
+			m_touchedEntities.push_back(entity);
+	}
+
 	inline void PlayerMovementComponent::UpdateController(std::shared_ptr<PlayerMovementController> controller)
 	{
 		m_controller = std::move(controller);
@@ -0,0 +1,43 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_COMPONENTS_POOLABLE_HPP
+#define BURGWAR_CORELIB_COMPONENTS_POOLABLE_HPP
+
+#include <CoreLib/Export.hpp>
+#include <NDK/Component.hpp>
+
+namespace bw
+{
+	class TerrainLayer;
+
+	class BURGWAR_CORELIB_API PoolableComponent : public Ndk::Component<PoolableComponent>
+	{
+		public:
+			inline PoolableComponent(TerrainLayer& layer, std::size_t elementIndex);
+			~PoolableComponent() = default;
+
+			inline std::size_t GetElementIndex() const;
+			inline TerrainLayer& GetLayer() const;
+
+			inline bool IsRespawned() const; //< was this entity taken back from its layer pool at least once
+
+			inline void MarkAsRespawned();
+
+			static void KillEntity(const Ndk::EntityHandle& entity); //< recycles poolable entities when possible, kills them otherwise
+
+			static Ndk::ComponentIndex componentIndex;
+
+		private:
+			std::size_t m_elementIndex;
+			TerrainLayer& m_layer;
+			bool m_isRespawned;
+	};
+}
+
+#include <CoreLib/Components/PoolableComponent.inl>
+
+#endif
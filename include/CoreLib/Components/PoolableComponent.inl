@@ -0,0 +1,35 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Components/PoolableComponent.hpp>
+
+namespace bw
+{
+	inline PoolableComponent::PoolableComponent(TerrainLayer& layer, std::size_t elementIndex) :
+	m_elementIndex(elementIndex),
+	m_layer(layer),
+	m_isRespawned(false)
+	{
+	}
+
+	inline std::size_t PoolableComponent::GetElementIndex() const
+	{
+		return m_elementIndex;
+	}
+
+	inline TerrainLayer& PoolableComponent::GetLayer() const
+	{
+		return m_layer;
+	}
+
+	inline bool PoolableComponent::IsRespawned() const
+	{
+		return m_isRespawned;
+	}
+
+	inline void PoolableComponent::MarkAsRespawned()
+	{
+		m_isRespawned = true;
+	}
+}
@@ -16,8 +16,10 @@
 #include <NDK/Component.hpp>
 #include <array>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace bw
@@ -27,9 +29,13 @@ namespace bw
 		friend class TickCallbackSystem;
 
 		public:
-			ScriptComponent(const Logger& logger, std::shared_ptr<const ScriptedElement> element, std::shared_ptr<ScriptingContext> context, sol::table entityTable, PropertyValueMap properties);
+			struct State;
+
+			ScriptComponent(const Logger& logger, std::shared_ptr<const ScriptedElement> element, std::shared_ptr<ScriptingContext> context, sol::table entityTable, ScriptedPropertyValues properties);
 			~ScriptComponent();
 
+			std::optional<State> CaptureState() const;
+
 			template<ElementEvent Event, typename... Args>
 			std::enable_if_t<!HasReturnValue(Event), bool> ExecuteCallback(Args... args);
 
@@ -43,36 +49,54 @@ namespace bw
 			inline const std::shared_ptr<const ScriptedElement>& GetElement() const;
 			inline const EntityLogger& GetLogger() const;
 			inline std::optional<std::reference_wrapper<const PropertyValue>> GetProperty(const std::string& keyName) const;
-			inline const PropertyValueMap& GetProperties() const;
+			inline std::optional<std::reference_wrapper<const PropertyValue>> GetProperty(const ScriptedProperty& property) const;
+			inline const ScriptedPropertyValues& GetProperties() const;
 			inline sol::table& GetTable();
+			inline float GetTimeBeforeTick() const;
 
 			inline bool HasCallbacks(ElementEvent event) const;
 
 			inline std::size_t RegisterCallback(ElementEvent event, sol::main_protected_function callback, bool async);
 			inline std::size_t RegisterCallbackCustom(std::size_t eventIndex, sol::main_protected_function callback, bool async);
 
-			inline void SetNextTick(float seconds);
+			void RestoreState(const State& state);
+
+			void SetNextTick(float seconds);
 
 			inline bool UnregisterCallback(ElementEvent event, std::size_t callbackId);
 			inline bool UnregisterCallbackCustom(std::size_t eventIndex, std::size_t callbackId);
 
-			inline void UpdateElement(std::shared_ptr<const ScriptedElement> element);
+			void UpdateElement(std::shared_ptr<const ScriptedElement> element);
 			void UpdateEntity(const Ndk::EntityHandle& entity);
+			void UpdateProperties(PropertyValueMap properties);
 
 			static Ndk::ComponentIndex componentIndex;
 
+			// Script side state of an entity, only plain values are supported (nested tables could be modified in place)
+			struct State
+			{
+				std::shared_ptr<ScriptedElement::CallbackSet> callbacks;
+				std::vector<std::pair<sol::object, sol::object>> tableFields;
+				std::size_t nextCallbackId;
+				float timeBeforeTick;
+			};
+
 		private:
+			template<typename... Args> bool CallDirectly(const sol::main_protected_function& callback, std::string_view eventName, Args&&... args);
 			inline bool CanTriggerTick(float elapsedTime);
+			void CheckCallbackBudget(std::string_view eventName, Nz::UInt64 duration, bool throttleTick);
+			inline ScriptedElement::CallbackSet& EditCallbacks();
 			void OnAttached() override;
+			void RescheduleTick();
 
-			std::array<std::vector<ScriptedElement::Callback>, ElementEventCount> m_eventCallbacks;
-			std::vector<std::vector<ScriptedElement::Callback>> m_customEventCallbacks;
+			std::shared_ptr<ScriptedElement::CallbackSet> m_callbacks; //< shared with the element (and captured states) until modified
 			std::shared_ptr<const ScriptedElement> m_element;
 			std::shared_ptr<ScriptingContext> m_context;
 			std::size_t m_nextCallbackId;
 			sol::table m_entityTable;
 			EntityLogger m_logger;
-			PropertyValueMap m_properties;
+			Nz::UInt64 m_nextBudgetWarning;
+			ScriptedPropertyValues m_properties;
 			float m_timeBeforeTick;
 	};
 }
@@ -4,6 +4,8 @@
 
 #include <CoreLib/Components/ScriptComponent.hpp>
 #include <CoreLib/Utils.hpp>
+#include <CoreLib/Utility/Profiling.hpp>
+#include <algorithm>
 
 namespace bw
 {
@@ -12,28 +14,36 @@ namespace bw
 	{
 		using EventData = ElementEventData<Event>;
 
-		const auto& callbacks = m_eventCallbacks[UnderlyingCast(Event)];
+		const auto& callbacks = m_callbacks->eventCallbacks[UnderlyingCast(Event)];
 		if (callbacks.empty())
 			return true;
 
+		auto profileScope = m_context->GetProfiler().Profile(m_element->fullName, ToString(Event));
+		bwProfileZone("Script callback");
+		bwProfileZoneText(m_element->fullName);
+		bwProfileZoneText(ToString(Event));
+
 		bool ret = false;
 
 		for (const auto& callbackData : callbacks)
 		{
-			sol::protected_function_result callbackResult;
 			if (callbackData.async)
 			{
 				auto co = m_context->CreateCoroutine(callbackData.callback);
-				callbackResult = co(m_entityTable, args...);
-			}
-			else
-				callbackResult = callbackData.callback(m_entityTable, args...);
+				sol::protected_function_result callbackResult = co(m_entityTable, args...);
+				if (!callbackResult.valid())
+				{
+					sol::error err = callbackResult;
+					bwLogRateLimited(m_logger, LogLevel::Error, "{} callback failed: {}", ToString(Event), err.what());
 
-			if (!callbackResult.valid())
-			{
-				sol::error err = callbackResult;
-				bwLog(m_logger, LogLevel::Error, "{} callback failed: {}", ToString(Event), err.what());
+					if constexpr (!EventData::FatalError)
+						continue;
 
+					return false;
+				}
+			}
+			else if (!CallDirectly(callbackData.callback, ToString(Event), args...))
+			{
 				if constexpr (!EventData::FatalError)
 					continue;
 
@@ -43,6 +53,8 @@ namespace bw
 			ret = true;
 		}
 
+		CheckCallbackBudget(ToString(Event), profileScope.Stop(), Event == ElementEvent::Tick);
+
 		return ret;
 	}
 
@@ -54,7 +66,15 @@ namespace bw
 
 		std::optional<ResultType> combinedResult;
 
-		const auto& callbacks = m_eventCallbacks[UnderlyingCast(Event)];
+		const auto& callbacks = m_callbacks->eventCallbacks[UnderlyingCast(Event)];
+		if (callbacks.empty())
+			return combinedResult;
+
+		auto profileScope = m_context->GetProfiler().Profile(m_element->fullName, ToString(Event));
+		bwProfileZone("Script callback");
+		bwProfileZoneText(m_element->fullName);
+		bwProfileZoneText(ToString(Event));
+
 		for (const auto& callbackData : callbacks)
 		{
 			assert(!callbackData.async);
@@ -63,7 +83,7 @@ namespace bw
 			if (!callbackResult.valid())
 			{
 				sol::error err = callbackResult;
-				bwLog(m_logger, LogLevel::Error, "{} callback failed: {}", ToString(Event), err.what());
+				bwLogRateLimited(m_logger, LogLevel::Error, "{} callback failed: {}", ToString(Event), err.what());
 
 				if constexpr (!EventData::FatalError)
 					continue;
@@ -76,21 +96,30 @@ namespace bw
 				combinedResult = EventData::Combinator(combinedResult, *retOpt);
 		}
 
+		CheckCallbackBudget(ToString(Event), profileScope.Stop(), false);
+
 		return combinedResult;
 	}
 
 	template<typename... Args>
 	std::optional<sol::object> ScriptComponent::ExecuteCustomCallback(std::size_t eventIndex, Args... args) //< FIXME: Not const because of a bug in sol
 	{
-		if (eventIndex >= m_customEventCallbacks.size())
+		const auto& customEventCallbacks = m_callbacks->customEventCallbacks;
+		if (eventIndex >= customEventCallbacks.size())
 			return sol::nil;
 
-		const auto& callbacks = m_customEventCallbacks[eventIndex];
+		const auto& callbacks = customEventCallbacks[eventIndex];
 		if (callbacks.empty())
 			return sol::nil;
 
 		assert(eventIndex < m_element->customEvents.size());
 		const auto& eventData = m_element->customEvents[eventIndex];
+
+		auto profileScope = m_context->GetProfiler().Profile(m_element->fullName, eventData.name);
+		bwProfileZone("Script callback");
+		bwProfileZoneText(m_element->fullName);
+		bwProfileZoneText(eventData.name);
+
 		if (eventData.returnType.empty())
 		{
 			// No return
@@ -98,26 +127,26 @@ namespace bw
 
 			for (const auto& callbackData : callbacks)
 			{
-				sol::protected_function_result callbackResult;
 				if (callbackData.async)
 				{
 					auto co = m_context->CreateCoroutine(callbackData.callback);
-					callbackResult = co(m_entityTable, args...);
-				}
-				else
-					callbackResult = callbackData.callback(m_entityTable, args...);
-
-				if (!callbackResult.valid())
-				{
-					sol::error err = callbackResult;
-					bwLog(m_logger, LogLevel::Error, "{} callback failed: {}", eventData.name, err.what());
+					sol::protected_function_result callbackResult = co(m_entityTable, args...);
+					if (!callbackResult.valid())
+					{
+						sol::error err = callbackResult;
+						bwLogRateLimited(m_logger, LogLevel::Error, "{} callback failed: {}", eventData.name, err.what());
 
-					continue;
+						continue;
+					}
 				}
+				else if (!CallDirectly(callbackData.callback, eventData.name, args...))
+					continue;
 
 				ret = true;
 			}
 
+			CheckCallbackBudget(eventData.name, profileScope.Stop(), false);
+
 			if (ret)
 				return sol::nil;
 			else
@@ -135,7 +164,7 @@ namespace bw
 				if (!callbackResult.valid())
 				{
 					sol::error err = callbackResult;
-					bwLog(m_logger, LogLevel::Error, "{} callback failed: {}", eventData.name, err.what());
+					bwLogRateLimited(m_logger, LogLevel::Error, "{} callback failed: {}", eventData.name, err.what());
 
 					continue;
 				}
@@ -143,9 +172,9 @@ namespace bw
 				if (eventData.combinator && combinedResult.has_value())
 				{
 					auto combinatorResult = eventData.combinator(combinedResult, callbackResult);
-					if (!callbackResult.valid())
+					if (!combinatorResult.valid())
 					{
-						sol::error err = callbackResult;
+						sol::error err = combinatorResult;
 						bwLog(m_logger, LogLevel::Error, "{} combinator failed: {}", eventData.name, err.what());
 
 						continue;
@@ -157,6 +186,8 @@ namespace bw
 					combinedResult.emplace(callbackResult);
 			}
 
+			CheckCallbackBudget(eventData.name, profileScope.Stop(), false);
+
 			return combinedResult;
 		}
 	}
@@ -177,20 +208,28 @@ namespace bw
 	}
 
 	inline std::optional<std::reference_wrapper<const PropertyValue>> ScriptComponent::GetProperty(const std::string& keyName) const
+	{
+		if (auto it = m_element->properties.find(keyName); it != m_element->properties.end())
+			return GetProperty(it->second);
+
+		// Not found, return nil for now (should we throw an error?)
+		return std::nullopt;
+	}
+
+	inline std::optional<std::reference_wrapper<const PropertyValue>> ScriptComponent::GetProperty(const ScriptedProperty& property) const
 	{
 		// Check specific value
-		if (auto it = m_properties.find(keyName); it != m_properties.end())
-			return it->second;
+		if (property.index < m_properties.size() && m_properties[property.index])
+			return *m_properties[property.index];
 
 		// Check default value
-		if (auto it = m_element->properties.find(keyName); it != m_element->properties.end())
-			return it->second.defaultValue;
+		if (property.defaultValue)
+			return *property.defaultValue;
 
-		// Not found, return nil for now (should we throw an error?)
 		return std::nullopt;
 	}
 
-	inline const PropertyValueMap& ScriptComponent::GetProperties() const
+	inline const ScriptedPropertyValues& ScriptComponent::GetProperties() const
 	{
 		return m_properties;
 	}
@@ -200,15 +239,20 @@ namespace bw
 		return m_entityTable;
 	}
 
+	inline float ScriptComponent::GetTimeBeforeTick() const
+	{
+		return m_timeBeforeTick;
+	}
+
 	inline bool ScriptComponent::HasCallbacks(ElementEvent event) const
 	{
-		auto& callbacks = m_eventCallbacks[UnderlyingCast(event)];
+		auto& callbacks = m_callbacks->eventCallbacks[UnderlyingCast(event)];
 		return !callbacks.empty();
 	}
 
 	inline std::size_t ScriptComponent::RegisterCallback(ElementEvent event, sol::main_protected_function callback, bool async)
 	{
-		auto& callbacks = m_eventCallbacks[UnderlyingCast(event)];
+		auto& callbacks = EditCallbacks().eventCallbacks[UnderlyingCast(event)];
 		auto& callbackData = callbacks.emplace_back();
 		callbackData.async = async;
 		callbackData.callback = std::move(callback);
@@ -219,10 +263,11 @@ namespace bw
 
 	inline std::size_t ScriptComponent::RegisterCallbackCustom(std::size_t eventIndex, sol::main_protected_function callback, bool async)
 	{
-		if (m_customEventCallbacks.size() <= eventIndex)
-			m_customEventCallbacks.resize(eventIndex + 1);
+		auto& customEventCallbacks = EditCallbacks().customEventCallbacks;
+		if (customEventCallbacks.size() <= eventIndex)
+			customEventCallbacks.resize(eventIndex + 1);
 
-		auto& callbackData = m_customEventCallbacks[eventIndex].emplace_back();
+		auto& callbackData = customEventCallbacks[eventIndex].emplace_back();
 		callbackData.async = async;
 		callbackData.callback = std::move(callback);
 		callbackData.callbackId = m_nextCallbackId++;
@@ -230,49 +275,60 @@ namespace bw
 		return callbackData.callbackId;
 	}
 
-	inline void ScriptComponent::SetNextTick(float seconds)
-	{
-		m_timeBeforeTick = seconds;
-	}
-
 	inline bool ScriptComponent::UnregisterCallback(ElementEvent event, std::size_t callbackId)
 	{
-		auto& callbacks = m_eventCallbacks[UnderlyingCast(event)];
+		const auto& sharedCallbacks = m_callbacks->eventCallbacks[UnderlyingCast(event)];
 
-		for (auto it = callbacks.begin(); it != callbacks.end(); ++it)
-		{
-			if (it->callbackId == callbackId)
-			{
-				callbacks.erase(it);
-				return true;
-			}
-		}
+		auto it = std::find_if(sharedCallbacks.begin(), sharedCallbacks.end(), [&](const ScriptedElement::Callback& callback) { return callback.callbackId == callbackId; });
+		if (it == sharedCallbacks.end())
+			return false;
+
+		std::size_t callbackIndex = std::distance(sharedCallbacks.begin(), it);
 
-		return false;
+		auto& callbacks = EditCallbacks().eventCallbacks[UnderlyingCast(event)];
+		callbacks.erase(callbacks.begin() + callbackIndex);
+
+		return true;
 	}
 
 	inline bool ScriptComponent::UnregisterCallbackCustom(std::size_t eventIndex, std::size_t callbackId)
 	{
-		if (m_customEventCallbacks.size() <= eventIndex)
+		if (m_callbacks->customEventCallbacks.size() <= eventIndex)
 			return false;
 
-		auto& callbacks = m_customEventCallbacks[eventIndex];
+		const auto& sharedCallbacks = m_callbacks->customEventCallbacks[eventIndex];
 
-		for (auto it = callbacks.begin(); it != callbacks.end(); ++it)
-		{
-			if (it->callbackId == callbackId)
-			{
-				callbacks.erase(it);
-				return true;
-			}
-		}
+		auto it = std::find_if(sharedCallbacks.begin(), sharedCallbacks.end(), [&](const ScriptedElement::Callback& callback) { return callback.callbackId == callbackId; });
+		if (it == sharedCallbacks.end())
+			return false;
+
+		std::size_t callbackIndex = std::distance(sharedCallbacks.begin(), it);
+
+		auto& callbacks = EditCallbacks().customEventCallbacks[eventIndex];
+		callbacks.erase(callbacks.begin() + callbackIndex);
 
-		return false;
+		return true;
 	}
 
-	inline void ScriptComponent::UpdateElement(std::shared_ptr<const ScriptedElement> element)
+	template<typename... Args>
+	bool ScriptComponent::CallDirectly(const sol::main_protected_function& callback, std::string_view eventName, Args&&... args)
 	{
-		m_element = std::move(element);
+		// Callbacks without results don't need a sol::protected_function_result (and its stack bookkeeping), call them through the Lua API
+		lua_State* L = callback.lua_state();
+		callback.push(L);
+		int argCount = sol::stack::multi_push(L, m_entityTable, std::forward<Args>(args)...);
+
+		if (lua_pcall(L, argCount, 0, 0) != LUA_OK)
+		{
+			std::size_t length;
+			const char* errorMessage = lua_tolstring(L, -1, &length);
+			bwLogRateLimited(m_logger, LogLevel::Error, "{} callback failed: {}", eventName, (errorMessage) ? std::string_view(errorMessage, length) : std::string_view("<non-string error>"));
+
+			lua_pop(L, 1);
+			return false;
+		}
+
+		return true;
 	}
 
 	inline bool ScriptComponent::CanTriggerTick(float elapsedTime)
@@ -280,4 +336,13 @@ namespace bw
 		m_timeBeforeTick -= elapsedTime;
 		return m_timeBeforeTick < 0.f;
 	}
+
+	inline ScriptedElement::CallbackSet& ScriptComponent::EditCallbacks()
+	{
+		// Callbacks still referenced elsewhere (by the element or a captured state) are never modified in place
+		if (m_callbacks.use_count() > 1)
+			m_callbacks = std::make_shared<ScriptedElement::CallbackSet>(*m_callbacks);
+
+		return *m_callbacks;
+	}
 }
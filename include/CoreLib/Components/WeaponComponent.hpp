@@ -39,6 +39,8 @@ namespace bw
 
 			static Ndk::ComponentIndex componentIndex;
 
+			NazaraSignal(OnActiveUpdate, WeaponComponent* /*weapon*/);
+
 		private:
 			Ndk::EntityHandle m_owner;
 			WeaponAttackMode m_attackMode;
@@ -36,9 +36,14 @@ namespace bw
 
 	inline void WeaponComponent::SetActive(bool isActive)
 	{
+		if (m_isActive == isActive)
+			return;
+
 		m_isActive = isActive;
 		if (!isActive)
 			m_isAttacking = false;
+
+		OnActiveUpdate(this);
 	}
 
 	inline void WeaponComponent::SetAttacking(bool isAttacking)
@@ -7,9 +7,17 @@
 #ifndef BURGWAR_CORELIB_CONFIG_HPP
 #define BURGWAR_CORELIB_CONFIG_HPP
 
+#include <Nazara/Prerequisites.hpp>
+
 namespace bw
 {
-	constexpr std::size_t NetworkChannelCount = 2;
+	constexpr std::size_t NetworkChannelCount = 3; //< 0: general, 1: match events, 2: inputs (unreliable, sequenced)
+
+	// Disconnection data sent to a peer which should reconnect to another port (port offset is stored in the lower bits)
+	constexpr Nz::UInt32 NetworkRedirectFlag = 0x80000000;
+
+	// Connection data of server list latency probes, which are disconnected as soon as they are connected
+	constexpr Nz::UInt32 NetworkProbeData = 0x50524F42; //< "PROB"
 }
 
 #endif
@@ -43,6 +43,7 @@ namespace bw
 			inline Nz::Signal<const std::string&>& GetStringUpdateSignal(const std::string& optionName);
 
 			bool LoadFromFile(const std::filesystem::path& filePath);
+			bool LoadFromFiles(const std::vector<std::filesystem::path>& filePaths);
 			bool SaveToFile(const std::filesystem::path& filePath);
 
 			inline bool SetBoolValue(const std::string& optionName, bool value);
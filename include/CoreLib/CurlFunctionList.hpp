@@ -23,7 +23,11 @@ BURGWAR_CURL_FUNCTION(multi_info_read)
 BURGWAR_CURL_FUNCTION(multi_init)
 BURGWAR_CURL_FUNCTION(multi_perform)
 BURGWAR_CURL_FUNCTION(multi_remove_handle)
+BURGWAR_CURL_FUNCTION(multi_setopt)
 BURGWAR_CURL_FUNCTION(multi_strerror)
+BURGWAR_CURL_FUNCTION(share_cleanup)
+BURGWAR_CURL_FUNCTION(share_init)
+BURGWAR_CURL_FUNCTION(share_setopt)
 BURGWAR_CURL_FUNCTION(slist_append)
 BURGWAR_CURL_FUNCTION(slist_free_all)
 BURGWAR_CURL_FUNCTION_LAST(version_info)
@@ -20,6 +20,8 @@ namespace bw
 
 			std::optional<PlayerInputData> GenerateInputs(const Ndk::EntityHandle& entity) const override;
 
+			bool IsScripted() const override;
+
 		private:
 			sol::main_protected_function m_callback;
 	};
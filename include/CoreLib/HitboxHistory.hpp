@@ -0,0 +1,84 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_HITBOXHISTORY_HPP
+#define BURGWAR_CORELIB_HITBOXHISTORY_HPP
+
+#include <CoreLib/EntityId.hpp>
+#include <CoreLib/Export.hpp>
+#include <Nazara/Math/Rect.hpp>
+#include <Nazara/Math/Vector2.hpp>
+#include <NDK/World.hpp>
+#include <functional>
+#include <vector>
+
+namespace bw
+{
+	class SharedMatch;
+
+	// Keeps the bounding box of physical entities for the last ticks, used to trace against what clients saw (lag compensation)
+	class BURGWAR_CORELIB_API HitboxHistory
+	{
+		public:
+			struct RaycastHit;
+
+			HitboxHistory(std::size_t capacity = 0);
+			HitboxHistory(const HitboxHistory&) = delete;
+			HitboxHistory(HitboxHistory&&) noexcept = default;
+			~HitboxHistory() = default;
+
+			inline void Clear();
+
+			inline std::size_t GetCapacity() const;
+			inline std::size_t GetFrameCount() const;
+
+			void RaycastQuery(const SharedMatch& match, Ndk::World& world, Nz::UInt16 tick, const Nz::Vector2f& startPos, const Nz::Vector2f& endPos, const Ndk::EntityHandle& ignoredEntity, const std::function<void(const RaycastHit& hitInfo)>& callback) const;
+			bool RaycastQueryFirst(const SharedMatch& match, Ndk::World& world, Nz::UInt16 tick, const Nz::Vector2f& startPos, const Nz::Vector2f& endPos, const Ndk::EntityHandle& ignoredEntity, RaycastHit* hitInfo) const;
+
+			void Record(Nz::UInt16 tick, Ndk::World& world);
+
+			void SetCapacity(std::size_t capacity);
+
+			HitboxHistory& operator=(const HitboxHistory&) = delete;
+			HitboxHistory& operator=(HitboxHistory&&) noexcept = default;
+
+			struct RaycastHit
+			{
+				Ndk::EntityHandle entity;
+				Nz::Vector2f hitNormal;
+				Nz::Vector2f hitPos;
+				float fraction;
+				bool isRewound; //< hit was computed against a past bounding box instead of the physics world
+			};
+
+			static constexpr float RewindThreshold = 0.5f; //< bodies which moved less than this since the traced tick are traced in the physics world
+
+		private:
+			struct Hitbox
+			{
+				EntityId uniqueId;
+				Nz::Rectf aabb;
+			};
+
+			struct Frame
+			{
+				std::vector<Hitbox> hitboxes; //< sorted by unique id
+				Nz::UInt16 tick;
+			};
+
+			const Frame* FindFrame(Nz::UInt16 tick) const;
+
+			static bool IntersectRay(const Nz::Rectf& aabb, const Nz::Vector2f& startPos, const Nz::Vector2f& endPos, float* fraction, Nz::Vector2f* hitNormal);
+
+			std::size_t m_frameCount;
+			std::size_t m_nextFrameIndex;
+			std::vector<Frame> m_frames;
+	};
+}
+
+#include <CoreLib/HitboxHistory.inl>
+
+#endif
@@ -0,0 +1,24 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/HitboxHistory.hpp>
+
+namespace bw
+{
+	inline void HitboxHistory::Clear()
+	{
+		m_frameCount = 0;
+		m_nextFrameIndex = 0;
+	}
+
+	inline std::size_t HitboxHistory::GetCapacity() const
+	{
+		return m_frames.size();
+	}
+
+	inline std::size_t HitboxHistory::GetFrameCount() const
+	{
+		return m_frameCount;
+	}
+}
@@ -21,6 +21,8 @@ namespace bw
 			virtual ~InputController();
 
 			virtual std::optional<PlayerInputData> GenerateInputs(const Ndk::EntityHandle& entity) const = 0;
+
+			virtual bool IsScripted() const; //< scripted controllers are updated apart from native ones
 	};
 }
 
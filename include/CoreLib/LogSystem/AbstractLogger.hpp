@@ -26,7 +26,7 @@ namespace bw
 			virtual void Log(const LogContext& context, std::string content) const = 0;
 			virtual void LogRaw(const LogContext& context, std::string_view content) const = 0;
 
-			virtual bool ShouldLog(const LogContext& context) const = 0;
+			virtual bool ShouldLog(LogLevel level) const = 0; //< only depends on the level, so it can be checked before setting up a context
 
 			AbstractLogger& operator=(const AbstractLogger&) = default;
 			AbstractLogger& operator=(AbstractLogger&&) noexcept = default;
@@ -0,0 +1,71 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_LOGSYSTEM_ASYNCSINK_HPP
+#define BURGWAR_CORELIB_LOGSYSTEM_ASYNCSINK_HPP
+
+#include <CoreLib/Export.hpp>
+#include <CoreLib/LogSystem/LogContext.hpp>
+#include <CoreLib/LogSystem/LogSink.hpp>
+#include <CoreLib/Utility/BoundedMpscQueue.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace bw
+{
+	// Forwards records to another sink from a background thread, records are dropped (and counted) when the queue is full
+	class BURGWAR_CORELIB_API AsyncSink : public LogSink
+	{
+		public:
+			AsyncSink(std::shared_ptr<LogSink> sink, std::size_t queueSize = DefaultQueueSize);
+			AsyncSink(const AsyncSink&) = delete;
+			AsyncSink(AsyncSink&&) = delete;
+			~AsyncSink();
+
+			void Flush();
+
+			inline Nz::UInt64 GetDroppedCount() const;
+
+			void Write(const LogContext& context, std::string_view content) override;
+
+			AsyncSink& operator=(const AsyncSink&) = delete;
+			AsyncSink& operator=(AsyncSink&&) = delete;
+
+			static void FlushAll(); //< for crash handlers, writes every pending record of every async sink
+
+			static constexpr std::size_t DefaultQueueSize = 4096;
+
+		private:
+			// Only the base context is kept, derived contexts data is already part of the content at this point
+			struct Record
+			{
+				LogContext context;
+				std::string content;
+			};
+
+			bool Drain();
+			void WorkerMain();
+
+			std::atomic_bool m_isStopping;
+			std::atomic_flag m_isDraining = ATOMIC_FLAG_INIT; //< makes sure a single thread pops at a time
+			std::atomic<Nz::UInt64> m_droppedCount;
+			std::condition_variable m_wakeUpCondition;
+			std::mutex m_wakeUpMutex;
+			std::shared_ptr<LogSink> m_sink;
+			std::thread m_worker;
+			BoundedMpscQueue<Record> m_queue;
+			Nz::UInt64 m_reportedDropCount;
+	};
+}
+
+#include <CoreLib/LogSystem/AsyncSink.inl>
+
+#endif
@@ -0,0 +1,84 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_LOGSYSTEM_BINARYLOGSINK_HPP
+#define BURGWAR_CORELIB_LOGSYSTEM_BINARYLOGSINK_HPP
+
+#include <CoreLib/Export.hpp>
+#include <CoreLib/LogSystem/Enums.hpp>
+#include <CoreLib/LogSystem/LogSink.hpp>
+#include <Nazara/Core/ByteArray.hpp>
+#include <Nazara/Core/ByteStream.hpp>
+#include <Nazara/Core/File.hpp>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace bw
+{
+	// Writes records (with their match and entity context) in a compact binary format to size-rotated files, see ReadFile to decode them
+	class BURGWAR_CORELIB_API BinaryLogSink : public LogSink
+	{
+		public:
+			struct Record;
+
+			BinaryLogSink(std::filesystem::path filePath, Nz::UInt64 maxFileSize = DefaultMaxFileSize, std::size_t maxFileCount = DefaultMaxFileCount);
+			BinaryLogSink(const BinaryLogSink&) = delete;
+			BinaryLogSink(BinaryLogSink&&) = delete;
+			~BinaryLogSink();
+
+			void Flush();
+
+			void Write(const LogContext& context, std::string_view content) override;
+
+			BinaryLogSink& operator=(const BinaryLogSink&) = delete;
+			BinaryLogSink& operator=(BinaryLogSink&&) = delete;
+
+			static bool ReadFile(const std::filesystem::path& filePath, const std::function<void(const Record& record)>& callback);
+
+			static constexpr Nz::UInt16 FileVersion = 1;
+			static constexpr Nz::UInt64 DefaultMaxFileSize = 64 * 1024 * 1024;
+			static constexpr std::size_t DefaultMaxFileCount = 5;
+
+			struct Record
+			{
+				std::optional<Nz::UInt32> entityId;
+				std::optional<std::string> matchName;
+				std::string content;
+				LogLevel level;
+				LogSide side;
+				Nz::UInt64 tick = 0; //< only meaningful with a match name
+				Nz::UInt64 timestamp; //< microseconds since epoch
+				float elapsedTime; //< seconds since application start
+			};
+
+		private:
+			void FlushBuffer();
+			bool OpenFile();
+			void RotateFiles();
+
+			enum RecordFlags : Nz::UInt8
+			{
+				RecordFlag_Match  = 1 << 0,
+				RecordFlag_Entity = 1 << 1
+			};
+
+			std::filesystem::path m_filePath;
+			std::mutex m_mutex; //< loggers of every thread may share the sink
+			std::size_t m_maxFileCount;
+			Nz::ByteArray m_buffer;
+			Nz::ByteStream m_stream;
+			Nz::File m_file;
+			Nz::UInt64 m_fileSize;
+			Nz::UInt64 m_maxFileSize;
+	};
+}
+
+#include <CoreLib/LogSystem/BinaryLogSink.inl>
+
+#endif
@@ -0,0 +1,40 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_LOGSYSTEM_LOGRATELIMITER_HPP
+#define BURGWAR_CORELIB_LOGSYSTEM_LOGRATELIMITER_HPP
+
+#include <Nazara/Prerequisites.hpp>
+#include <atomic>
+
+namespace bw
+{
+	// Lets through at most one message per interval, counting the others (used by bwLogRateLimited for each call site)
+	class LogRateLimiter
+	{
+		public:
+			inline LogRateLimiter(Nz::UInt64 interval = DefaultInterval);
+			LogRateLimiter(const LogRateLimiter&) = delete;
+			LogRateLimiter(LogRateLimiter&&) = delete;
+			~LogRateLimiter() = default;
+
+			inline bool Acquire(Nz::UInt64& suppressedCount);
+
+			LogRateLimiter& operator=(const LogRateLimiter&) = delete;
+			LogRateLimiter& operator=(LogRateLimiter&&) = delete;
+
+			static constexpr Nz::UInt64 DefaultInterval = 1000; //< in milliseconds
+
+		private:
+			std::atomic<Nz::UInt64> m_nextAllowedTime;
+			std::atomic<Nz::UInt64> m_suppressedCount;
+			Nz::UInt64 m_interval;
+	};
+}
+
+#include <CoreLib/LogSystem/LogRateLimiter.inl>
+
+#endif
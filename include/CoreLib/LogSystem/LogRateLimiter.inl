@@ -0,0 +1,36 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/LogSystem/LogRateLimiter.hpp>
+#include <Nazara/Core/Clock.hpp>
+
+namespace bw
+{
+	inline LogRateLimiter::LogRateLimiter(Nz::UInt64 interval) :
+	m_nextAllowedTime(0),
+	m_suppressedCount(0),
+	m_interval(interval)
+	{
+	}
+
+	/*!
+	* \brief Checks if a message may be logged now
+	* \return True if the message should be logged, suppressedCount is then set to the number of messages suppressed since the last one
+	*/
+	inline bool LogRateLimiter::Acquire(Nz::UInt64& suppressedCount)
+	{
+		Nz::UInt64 now = Nz::GetElapsedMilliseconds();
+
+		// Multiple threads may log from the same call site, only one of them wins the slot
+		Nz::UInt64 nextAllowedTime = m_nextAllowedTime.load(std::memory_order_relaxed);
+		if (now < nextAllowedTime || !m_nextAllowedTime.compare_exchange_strong(nextAllowedTime, now + m_interval, std::memory_order_relaxed))
+		{
+			m_suppressedCount.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		suppressedCount = m_suppressedCount.exchange(0, std::memory_order_relaxed);
+		return true;
+	}
+}
@@ -12,23 +12,58 @@
 #include <CoreLib/LogSystem/Enums.hpp>
 #include <CoreLib/LogSystem/LogContext.hpp>
 #include <CoreLib/LogSystem/LogContextPtr.hpp>
+#include <CoreLib/LogSystem/LogRateLimiter.hpp>
 #include <Nazara/Core/MovablePtr.hpp>
-#include <Nazara/Core/MemoryPool.hpp>
 #include <fmt/format.h>
 #include <memory>
 #include <vector>
 
+// Log calls below this level (as an integer) are compiled out, arguments are not even evaluated
+#ifndef BURGWAR_LOG_MINIMUM_LEVEL
+#define BURGWAR_LOG_MINIMUM_LEVEL 0
+#endif
+
+// No context is allocated nor message formatted unless the level is enabled
 #define bwLog(logObject, lvl, ...) do \
 { \
-	auto _bwLogContext = (logObject).PushContext(); \
-	_bwLogContext->level = lvl; \
-	if ((logObject).ShouldLog(*_bwLogContext)) \
-		(logObject).LogFormat(*_bwLogContext, __VA_ARGS__); \
+	if constexpr (bw::IsLogLevelCompiled(lvl)) \
+	{ \
+		if ((logObject).ShouldLog(lvl)) \
+		{ \
+			auto _bwLogContext = (logObject).PushContext(); \
+			_bwLogContext->level = lvl; \
+			(logObject).LogFormat(*_bwLogContext, __VA_ARGS__); \
+		} \
+	} \
+} \
+while (false)
+
+// Same as bwLog but logs at most once per second for this call site (whatever the logger), reporting how many messages were suppressed
+#define bwLogRateLimited(logObject, lvl, ...) do \
+{ \
+	if constexpr (bw::IsLogLevelCompiled(lvl)) \
+	{ \
+		static bw::LogRateLimiter _bwLogRateLimiter; \
+		Nz::UInt64 _bwSuppressedCount; \
+		if ((logObject).ShouldLog(lvl) && _bwLogRateLimiter.Acquire(_bwSuppressedCount)) \
+		{ \
+			auto _bwLogContext = (logObject).PushContext(); \
+			_bwLogContext->level = lvl; \
+			(logObject).LogFormat(*_bwLogContext, __VA_ARGS__); \
+			if (_bwSuppressedCount > 0) \
+				(logObject).LogFormat(*_bwLogContext, "{0} similar message(s) suppressed", _bwSuppressedCount); \
+		} \
+	} \
 } \
 while (false)
 
 namespace bw
 {
+	constexpr bool IsLogLevelCompiled(LogLevel level)
+	{
+		return static_cast<int>(level) >= BURGWAR_LOG_MINIMUM_LEVEL;
+	}
+
 	class BurgApp;
 	class LogSink;
 
@@ -38,8 +73,8 @@ namespace bw
 		friend class LoggerProxy;
 
 		public:
-			inline Logger(BurgApp& app, LogSide logSide, std::size_t contextSize = sizeof(bw::LogContext));
-			inline Logger(BurgApp& app, LogSide logSide, const AbstractLogger& logParent, std::size_t contextSize = sizeof(bw::LogContext));
+			inline Logger(BurgApp& app, LogSide logSide);
+			inline Logger(BurgApp& app, LogSide logSide, const AbstractLogger& logParent);
 			Logger(const Logger&) = delete;
 			Logger(Logger&&) noexcept = default;
 			~Logger() = default;
@@ -55,23 +90,27 @@ namespace bw
 
 			inline void SetMinimumLogLevel(LogLevel level);
 
-			bool ShouldLog(const LogContext& context) const override;
+			bool ShouldLog(LogLevel level) const override;
 
 			Logger& operator=(const Logger& logger) = delete;
 			Logger& operator=(Logger&&) = delete;
 
 		protected:
-			template<typename T> T* AllocateContext(Nz::MemoryPool& pool) const;
+			template<typename T> T* AllocateContext() const;
 			template<typename T> LogContextPtr PushCustomContext() const;
 
 			virtual void InitializeContext(LogContext& context) const;
-			virtual LogContext* NewContext(Nz::MemoryPool& pool) const;
+			virtual LogContext* NewContext() const;
 			virtual void OverrideContent(const LogContext& context, std::string& content) const;
 
 		private:
 			void FreeContext(LogContext* context) const;
 
-			mutable Nz::MemoryPool m_contextPool;
+			static void* AllocateContextMemory();
+			static void FreeContextMemory(void* memory);
+
+			static constexpr std::size_t MaxContextSize = 128; //< contexts are allocated from fixed-size blocks
+
 			BurgApp& m_app;
 			LogLevel m_minimumLogLevel;
 			Nz::MovablePtr<const AbstractLogger> m_logParent;
@@ -31,7 +31,7 @@ namespace bw
 
 			inline LogContextPtr PushContext() const;
 
-			bool ShouldLog(const LogContext& context) const override;
+			bool ShouldLog(LogLevel level) const override;
 
 			LoggerProxy& operator=(const LoggerProxy& logger) = delete;
 			LoggerProxy& operator=(LoggerProxy&&) = delete;
@@ -16,10 +16,20 @@
 #include <Nazara/Math/Vector2.hpp>
 #include <nlohmann/json_fwd.hpp>
 #include <tsl/hopscotch_map.h>
+#include <tsl/hopscotch_set.h>
 #include <array>
 #include <filesystem>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string_view>
 #include <vector>
 
+namespace Nz
+{
+	class ByteStream;
+}
+
 namespace bw
 {
 	struct MapInfo
@@ -29,6 +39,8 @@ namespace bw
 		std::string name;
 	};
 
+	class MemoryMappedFile;
+
 	class BURGWAR_CORELIB_API Map
 	{
 		public:
@@ -39,6 +51,10 @@ namespace bw
 			struct PreserveUniqueId {};
 			struct Script;
 
+			static constexpr Nz::UInt16 BinaryFileVersion = 5;
+			static constexpr Nz::UInt16 CompressedSectionFileVersion = 5; //< first binary version with compressed and checksummed sections
+			static constexpr Nz::UInt16 SectionTableFileVersion = 4; //< first binary version starting with a section table (see BinaryMapReader)
+
 			inline Map();
 			inline Map(MapInfo mapInfo);
 			Map(const Map&) = default;
@@ -49,12 +65,14 @@ namespace bw
 			template<typename... Args> Entity& AddEntity(LayerIndex layerIndex, PreserveUniqueId, Args&&... args);
 			template<typename... Args> Layer& AddLayer(Args&&... args);
 
-			bool Compile(const std::filesystem::path& outputPath);
+			bool Compile(const std::filesystem::path& outputPath, bool compressSections = true);
 
 			inline Entity DropEntity(LayerIndex layerIndex, std::size_t entityIndex);
 			inline Entity DropEntity(EntityId uniqueId);
+			inline std::vector<Entity> DropEntities(LayerIndex layerIndex, std::size_t firstEntityIndex, std::size_t entityCount);
 			inline Layer DropLayer(LayerIndex layerIndex);
 
+			inline void EmplaceEntities(LayerIndex layerIndex, std::size_t firstEntityIndex, std::vector<Entity> entities);
 			template<typename... Args> Entity& EmplaceEntity(LayerIndex layerIndex, std::size_t entityIndex, Args&&... args);
 			template<typename... Args> Layer& EmplaceLayer(LayerIndex layerIndex, Args&&... args);
 
@@ -63,6 +81,7 @@ namespace bw
 			template<PropertyType P, typename F> void ForeachEntityPropertyValue(F&& func);
 
 			inline EntityId GenerateUniqueId();
+			inline EntityId GenerateUniqueIds(std::size_t count); //< returns the first of count consecutive ids
 
 			inline std::vector<Asset>& GetAssets();
 			inline const std::vector<Asset>& GetAssets() const;
@@ -79,6 +98,7 @@ namespace bw
 			inline std::vector<Layer>& GetLayers();
 			inline const std::vector<Layer>& GetLayers() const;
 			inline const MapInfo& GetMapInfo() const;
+			inline const std::shared_ptr<const MemoryMappedFile>& GetMapping() const;
 			inline std::vector<Script>& GetScripts();
 			inline const std::vector<Script>& GetScripts() const;
 
@@ -121,8 +141,16 @@ namespace bw
 				std::size_t entityIndex;
 			};
 
+			struct LayerPhysics
+			{
+				std::optional<float> sleepTime;
+				std::optional<float> spatialHashCellSize;
+				std::optional<Nz::UInt32> iterationCount;
+			};
+
 			struct Layer
 			{
+				LayerPhysics physics; //< unset values are picked by the gamemode or from entity density
 				Nz::Color backgroundColor = Nz::Color::Black;
 				Nz::Vector2f positionAlignment = Nz::Vector2f::Unit();
 				std::string name = "unnamed layer";
@@ -131,29 +159,42 @@ namespace bw
 
 			struct Script
 			{
+				inline std::string_view GetContent() const;
+
 				std::string filepath;
-				std::vector<Nz::UInt8> content;
+				std::vector<Nz::UInt8> content; //< left empty when the map file is memory-mapped
+				std::vector<Nz::UInt8> bytecode; //< precompiled content, only filled from binary maps
+				std::string_view mappedContent; //< content inside the map file mapping (see GetMapping)
 			};
 
 			static inline Map LoadFromBinary(const std::filesystem::path& mapFile);
 			static inline Map LoadFromDirectory(const std::filesystem::path& mapDirectory);
 
+			static void ReadBinaryLayer(Nz::ByteStream& stream, Layer& layer, Nz::UInt16 fileVersion);
+
 			static nlohmann::json Serialize(const Map& map);
 			static nlohmann::json SerializeEntity(const Entity& entity);
 			static Map Unserialize(const nlohmann::json& mapInfo);
 			static Entity UnserializeEntity(const nlohmann::json& entityInfo);
 
+			static void WriteBinaryLayer(Nz::ByteStream& stream, const Layer& layer);
+
 		private:
 			bool CheckEntityIndices() const;
+			bool CheckEntityIndices(LayerIndex layerIndex) const;
 			void LoadFromBinaryInternal(const std::filesystem::path& mapFile);
 			void LoadFromDirectoryInternal(const std::filesystem::path& mapFolder);
 			inline void RegisterEntity(EntityId uniqueId, LayerIndex layerIndex, std::size_t entityIndex);
 			void Sanitize();
 			inline void UnregisterEntity(EntityId uniqueId);
+			inline void UpdateEntityIndex(LayerIndex layerIndex, std::size_t entityIndex);
+			inline void UpdateEntityIndices(LayerIndex layerIndex, std::size_t firstEntityIndex);
+			inline void UpdateLayerIndices(LayerIndex firstLayerIndex);
 
 			std::vector<Asset> m_assets;
 			std::vector<Layer> m_layers;
 			std::vector<Script> m_scripts;
+			std::shared_ptr<const MemoryMappedFile> m_mapping;
 			EntityId m_freeUniqueId;
 			tsl::hopscotch_map<EntityId /*unique id*/, EntityIndices> m_entitiesByUniqueId;
 			MapInfo m_mapInfo;
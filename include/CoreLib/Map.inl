@@ -79,19 +79,9 @@ namespace bw
 		layer.entities.erase(layer.entities.begin() + entityIndex);
 
 		UnregisterEntity(entityData.uniqueId);
+		UpdateEntityIndices(layerIndex, entityIndex);
 
-		for (auto it = m_entitiesByUniqueId.begin(); it != m_entitiesByUniqueId.end(); ++it)
-		{
-			EntityIndices& entityIndices = it.value();
-			if (entityIndices.layerIndex == layerIndex)
-			{
-				assert(entityIndices.entityIndex != entityIndex);
-				if (entityIndices.entityIndex > entityIndex)
-					entityIndices.entityIndex--;
-			}
-		}
-
-		assert(CheckEntityIndices());
+		assert(CheckEntityIndices(layerIndex));
 
 		return entityData;
 	}
@@ -102,28 +92,61 @@ namespace bw
 		return DropEntity(entityIndices.layerIndex, entityIndices.entityIndex);
 	}
 
-	inline auto Map::DropLayer(LayerIndex layerIndex) -> Layer
+	inline auto Map::DropEntities(LayerIndex layerIndex, std::size_t firstEntityIndex, std::size_t entityCount) -> std::vector<Entity>
 	{
-		Layer layer = std::move(GetLayer(layerIndex));
+		Layer& layer = GetLayer(layerIndex);
 
-		std::size_t entityIndex = 0;
-		for (auto& entity : layer.entities)
+		assert(firstEntityIndex + entityCount <= layer.entities.size());
+		auto firstIt = layer.entities.begin() + firstEntityIndex;
+		auto lastIt = firstIt + entityCount;
+
+		std::vector<Entity> entities(std::make_move_iterator(firstIt), std::make_move_iterator(lastIt));
+		layer.entities.erase(firstIt, lastIt);
+
+		// Same as dropping them one by one, but references to them are cleared in a single pass
+		tsl::hopscotch_set<EntityId> droppedEntities;
+		droppedEntities.reserve(entities.size());
+
+		for (const Entity& entity : entities)
 		{
-			UnregisterEntity(entity.uniqueId);
-			entityIndex++;
+			m_entitiesByUniqueId.erase(entity.uniqueId);
+			droppedEntities.insert(entity.uniqueId);
 		}
 
-		for (auto it = m_entitiesByUniqueId.begin(); it != m_entitiesByUniqueId.end(); ++it)
+		UpdateEntityIndices(layerIndex, firstEntityIndex);
+
+		if (!droppedEntities.empty())
 		{
-			EntityIndices& entityIndices = it.value();
-			assert(entityIndices.layerIndex != layerIndex);
-			if (entityIndices.layerIndex > layerIndex)
-				entityIndices.layerIndex--;
+			ForeachEntityPropertyValue<PropertyType::Entity>([&](Map::Entity& /*entity*/, const std::string& /*name*/, EntityId& entityId)
+			{
+				if (droppedEntities.find(entityId) != droppedEntities.end())
+					entityId = 0;
+			});
 		}
 
+		assert(CheckEntityIndices(layerIndex));
+
+		return entities;
+	}
+
+	inline auto Map::DropLayer(LayerIndex layerIndex) -> Layer
+	{
+		Layer layer = std::move(GetLayer(layerIndex));
 		m_layers.erase(m_layers.begin() + layerIndex);
 
-		// Update entities pointing to this layer
+		// Remove every entity of the layer at once, so references to them are cleared in a single pass
+		tsl::hopscotch_set<EntityId> droppedEntities;
+		droppedEntities.reserve(layer.entities.size());
+
+		for (auto& entity : layer.entities)
+		{
+			m_entitiesByUniqueId.erase(entity.uniqueId);
+			droppedEntities.insert(entity.uniqueId);
+		}
+
+		UpdateLayerIndices(layerIndex);
+
+		// Update entities pointing to this layer or its entities
 		ForeachEntityPropertyValue<PropertyType::Layer>([&](Map::Entity& /*entity*/, const std::string& /*name*/, LayerIndex& currentLayerIndex)
 		{
 			assert(currentLayerIndex >= std::numeric_limits<LayerIndex>::min() && currentLayerIndex <= std::numeric_limits<LayerIndex>::max());
@@ -131,7 +154,14 @@ namespace bw
 				currentLayerIndex = NoLayer;
 		});
 
-		assert(CheckEntityIndices());
+		if (!droppedEntities.empty())
+		{
+			ForeachEntityPropertyValue<PropertyType::Entity>([&](Map::Entity& /*entity*/, const std::string& /*name*/, EntityId& entityId)
+			{
+				if (droppedEntities.find(entityId) != droppedEntities.end())
+					entityId = 0;
+			});
+		}
 
 		return layer;
 	}
@@ -148,18 +178,37 @@ namespace bw
 		if (m_entitiesByUniqueId.find(entity.uniqueId) != m_entitiesByUniqueId.end())
 			entity.uniqueId = m_freeUniqueId++;
 
-		for (auto it = m_entitiesByUniqueId.begin(); it != m_entitiesByUniqueId.end(); ++it)
+		UpdateEntityIndices(layerIndex, entityIndex + 1);
+		RegisterEntity(entity.uniqueId, layerIndex, entityIndex);
+
+		assert(CheckEntityIndices(layerIndex));
+
+		return entity;
+	}
+
+	inline void Map::EmplaceEntities(LayerIndex layerIndex, std::size_t firstEntityIndex, std::vector<Entity> entities)
+	{
+		auto& layer = GetLayer(layerIndex);
+
+		assert(firstEntityIndex <= layer.entities.size());
+		layer.entities.insert(layer.entities.begin() + firstEntityIndex, std::make_move_iterator(entities.begin()), std::make_move_iterator(entities.end()));
+
+		// Indices of the following entities are only updated once
+		UpdateEntityIndices(layerIndex, firstEntityIndex + entities.size());
+
+		for (std::size_t i = 0; i < entities.size(); ++i)
 		{
-			EntityIndices& entityIndices = it.value();
-			if (entityIndices.layerIndex == layerIndex && entityIndices.entityIndex >= entityIndex)
-				entityIndices.entityIndex++;
-		}
+			std::size_t entityIndex = firstEntityIndex + i;
+			auto& entity = layer.entities[entityIndex];
 
-		assert(CheckEntityIndices());
+			// If unique id is still in use, set a new one
+			if (m_entitiesByUniqueId.find(entity.uniqueId) != m_entitiesByUniqueId.end())
+				entity.uniqueId = m_freeUniqueId++;
 
-		RegisterEntity(entity.uniqueId, layerIndex, entityIndex);
+			RegisterEntity(entity.uniqueId, layerIndex, entityIndex);
+		}
 
-		return entity;
+		assert(CheckEntityIndices(layerIndex));
 	}
 
 	template<typename... Args> 
@@ -175,14 +224,7 @@ namespace bw
 
 		Layer& layer = *m_layers.emplace(m_layers.begin() + layerIndex, std::forward<Args>(args)...);
 
-		for (auto it = m_entitiesByUniqueId.begin(); it != m_entitiesByUniqueId.end(); ++it)
-		{
-			EntityIndices& entityIndices = it.value();
-			if (entityIndices.layerIndex >= layerIndex)
-				entityIndices.layerIndex++;
-		}
-
-		assert(CheckEntityIndices());
+		UpdateLayerIndices(layerIndex + 1);
 
 		std::size_t entityIndex = 0;
 		for (auto& entity : layer.entities)
@@ -264,6 +306,14 @@ namespace bw
 		return m_freeUniqueId++;
 	}
 
+	inline EntityId Map::GenerateUniqueIds(std::size_t count)
+	{
+		EntityId firstUniqueId = m_freeUniqueId;
+		m_freeUniqueId += static_cast<EntityId>(count);
+
+		return firstUniqueId;
+	}
+
 	inline auto Map::GetAssets() -> std::vector<Asset>&
 	{
 		return m_assets;
@@ -352,6 +402,11 @@ namespace bw
 		return m_mapInfo;
 	}
 
+	inline const std::shared_ptr<const MemoryMappedFile>& Map::GetMapping() const
+	{
+		return m_mapping;
+	}
+
 	inline auto Map::GetScripts() -> std::vector<Script>&
 	{
 		return m_scripts;
@@ -378,30 +433,14 @@ namespace bw
 
 		Entity& sourceEntity = sourceLayer.entities[sourceEntityIndex];
 
-		auto movedIt = m_entitiesByUniqueId.find(sourceEntity.uniqueId);
-		assert(movedIt != m_entitiesByUniqueId.end());
-
 		targetLayer.entities.emplace(targetLayer.entities.begin() + targetEntityIndex, std::move(sourceEntity));
 		sourceLayer.entities.erase(sourceLayer.entities.begin() + sourceEntityIndex);
 
-		for (auto it = m_entitiesByUniqueId.begin(); it != m_entitiesByUniqueId.end(); ++it)
-		{
-			EntityIndices& entityIndices = it.value();
-			if (entityIndices.layerIndex == sourceLayerIndex)
-			{
-				if (entityIndices.entityIndex > sourceEntityIndex)
-					entityIndices.entityIndex--;
-			}
-			else if (entityIndices.layerIndex == targetLayerIndex)
-			{
-				if (entityIndices.entityIndex >= targetEntityIndex)
-					entityIndices.entityIndex++;
-			}
-		}
-
-		movedIt.value() = EntityIndices{ targetLayerIndex, targetEntityIndex };
+		UpdateEntityIndices(sourceLayerIndex, sourceEntityIndex);
+		UpdateEntityIndices(targetLayerIndex, targetEntityIndex);
 
-		assert(CheckEntityIndices());
+		assert(CheckEntityIndices(sourceLayerIndex));
+		assert(CheckEntityIndices(targetLayerIndex));
 
 		return targetLayer.entities[targetEntityIndex];
 	}
@@ -417,19 +456,10 @@ namespace bw
 		std::swap(firstEntity, secondEntity);
 
 		// Fix uniqueId
-		for (auto it = m_entitiesByUniqueId.begin(); it != m_entitiesByUniqueId.end(); ++it)
-		{
-			EntityIndices& entityIndices = it.value();
-			if (entityIndices.layerIndex == layerIndex)
-			{
-				if (entityIndices.entityIndex == firstEntityIndex)
-					entityIndices.entityIndex = secondEntityIndex;
-				else if (entityIndices.entityIndex == secondEntityIndex)
-					entityIndices.entityIndex = firstEntityIndex;
-			}
-		}
+		UpdateEntityIndex(layerIndex, firstEntityIndex);
+		UpdateEntityIndex(layerIndex, secondEntityIndex);
 
-		assert(CheckEntityIndices());
+		assert(CheckEntityIndices(layerIndex));
 	}
 
 	inline void Map::SwapLayers(LayerIndex firstLayerIndex, LayerIndex secondLayerIndex)
@@ -443,16 +473,11 @@ namespace bw
 		std::swap(firstLayer, secondLayer);
 
 		// Fix uniqueId
-		for (auto it = m_entitiesByUniqueId.begin(); it != m_entitiesByUniqueId.end(); ++it)
-		{
-			EntityIndices& entityIndices = it.value();
-			if (entityIndices.layerIndex == firstLayerIndex)
-				entityIndices.layerIndex = secondLayerIndex;
-			else if (entityIndices.layerIndex == secondLayerIndex)
-				entityIndices.layerIndex = firstLayerIndex;
-		}
+		UpdateEntityIndices(firstLayerIndex, 0);
+		UpdateEntityIndices(secondLayerIndex, 0);
 
-		assert(CheckEntityIndices());
+		assert(CheckEntityIndices(firstLayerIndex));
+		assert(CheckEntityIndices(secondLayerIndex));
 
 		// Update entities pointing to this layer
 		ForeachEntityPropertyValue<PropertyType::Layer>([&](Map::Entity& /*entity*/, const std::string& /*name*/, LayerIndex& layerIndex)
@@ -505,4 +530,34 @@ namespace bw
 				entityIndex = 0;
 		});
 	}
+
+	inline void Map::UpdateEntityIndex(LayerIndex layerIndex, std::size_t entityIndex)
+	{
+		auto it = m_entitiesByUniqueId.find(m_layers[layerIndex].entities[entityIndex].uniqueId);
+		assert(it != m_entitiesByUniqueId.end());
+
+		it.value() = EntityIndices{ layerIndex, entityIndex };
+	}
+
+	inline void Map::UpdateEntityIndices(LayerIndex layerIndex, std::size_t firstEntityIndex)
+	{
+		// Only entities after a mutation moved, leave the rest of the map alone
+		std::size_t entityCount = m_layers[layerIndex].entities.size();
+		for (std::size_t entityIndex = firstEntityIndex; entityIndex < entityCount; ++entityIndex)
+			UpdateEntityIndex(layerIndex, entityIndex);
+	}
+
+	inline void Map::UpdateLayerIndices(LayerIndex firstLayerIndex)
+	{
+		for (std::size_t layerIndex = firstLayerIndex; layerIndex < m_layers.size(); ++layerIndex)
+			UpdateEntityIndices(static_cast<LayerIndex>(layerIndex), 0);
+	}
+
+	inline std::string_view Map::Script::GetContent() const
+	{
+		if (mappedContent.data())
+			return mappedContent;
+
+		return std::string_view(reinterpret_cast<const char*>(content.data()), content.size());
+	}
 }
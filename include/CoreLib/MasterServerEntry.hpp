@@ -8,17 +8,18 @@
 #define BURGWAR_CORELIB_MASTERSERVERENTRY_HPP
 
 #include <CoreLib/Export.hpp>
-#include <CoreLib/WebService.hpp>
+#include <concurrentqueue/concurrentqueue.h>
 #include <nlohmann/json_fwd.hpp>
+#include <tsl/hopscotch_map.h>
+#include <memory>
 #include <optional>
 #include <string>
 
 namespace bw
 {
-	class Logger;
 	class Match;
-	class WebRequestResult;
 
+	// Requests are sent and polled by the application main thread (see BurgApp::Update), responses are handled on the match thread so web traffic never delays ticks
 	class BURGWAR_CORELIB_API MasterServerEntry
 	{
 		public:
@@ -33,17 +34,45 @@ namespace bw
 			MasterServerEntry& operator=(MasterServerEntry&&) = delete;
 
 		private:
+			enum class RequestType
+			{
+				Refresh,
+				Register,
+				RegisterIPv4
+			};
+
+			struct Response
+			{
+				std::string body;
+				std::string errorMessage;
+				RequestType requestType;
+				long responseCode = 0;
+				bool hasSucceeded = false; //< a response was received (whatever its code)
+				bool isDelta = false;
+			};
+
+			using ResponseQueue = moodycamel::ConcurrentQueue<Response>;
+
 			nlohmann::json BuildServerInfo() const;
-			void HandleResponse(WebRequestResult&& result, bool refresh);
+			void HandleResponse(Response&& response);
+			bool HasServerInfoChanged(const nlohmann::json& serverInfo) const;
 
-			void Refresh();
+			void Refresh(const nlohmann::json& serverInfo);
 			void Register();
 
+			void SendRequest(std::string url, const nlohmann::json& requestData, RequestType requestType, bool isDelta = false);
+
+			static tsl::hopscotch_map<std::string, std::string> SerializeFields(const nlohmann::json& serverInfo);
+
+			std::shared_ptr<ResponseQueue> m_responses; //< shared with requests in flight, which may outlive the entry
+			tsl::hopscotch_map<std::string, std::string> m_pendingFields; //< serialized fields of the request in flight
+			tsl::hopscotch_map<std::string, std::string> m_sentFields; //< serialized fields known by the master server
 			std::string m_masterServerURL;
-			std::string m_requestBody;
 			std::string m_updateToken;
 			Match& m_match;
-			WebService m_webService;
+			bool m_isDeltaRefreshSupported;
+			bool m_isRequestPending;
+			float m_timeBeforeChangeCheck;
 			float m_timeBeforeRefresh;
 	};
 }
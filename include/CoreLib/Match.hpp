@@ -8,9 +8,11 @@
 #define BURGWAR_CORELIB_MATCH_HPP
 
 #include <CoreLib/AssetStore.hpp>
+#include <CoreLib/ChecksumCache.hpp>
 #include <CoreLib/Export.hpp>
 #include <CoreLib/Map.hpp>
 #include <CoreLib/MasterServerEntry.hpp>
+#include <CoreLib/MatchCheckpoint.hpp>
 #include <CoreLib/MatchSessions.hpp>
 #include <CoreLib/Player.hpp>
 #include <CoreLib/SharedMatch.hpp>
@@ -18,15 +20,23 @@
 #include <CoreLib/LogSystem/MatchLogger.hpp>
 #include <CoreLib/Protocol/Packets.hpp>
 #include <CoreLib/Protocol/NetworkStringStore.hpp>
+#include <CoreLib/Protocol/StateQuantizer.hpp>
 #include <CoreLib/Scripting/ScriptingContext.hpp>
 #include <CoreLib/Scripting/ServerEntityStore.hpp>
 #include <CoreLib/Scripting/ServerWeaponStore.hpp>
+#include <CoreLib/Utility/EntityRegistry.hpp>
+#include <CoreLib/Utility/FileWatcher.hpp>
+#include <CoreLib/Utility/MemoryMappedFile.hpp>
+#include <CoreLib/Utility/WorkerPool.hpp>
 #include <Nazara/Core/Bitset.hpp>
 #include <Nazara/Core/ByteArray.hpp>
 #include <Nazara/Core/ObjectHandle.hpp>
 #include <Nazara/Network/UdpSocket.hpp>
 #include <tsl/hopscotch_map.h>
+#include <atomic>
+#include <filesystem>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
@@ -34,7 +44,9 @@
 namespace bw
 {
 	class BurgApp;
+	class MatchRecorder;
 	class Mod;
+	class ScriptBytecodeCache;
 	class ServerGamemode;
 	class ServerScriptingLibrary;
 	class Terrain;
@@ -49,12 +61,15 @@ namespace bw
 	class BURGWAR_CORELIB_API Match : public SharedMatch
 	{
 		friend class MatchClientSession;
+		friend class Terrain;
 
 		public:
 			struct ClientAsset;
 			struct ClientScript;
 			struct GamemodeSettings;
 			struct MatchSettings;
+			struct MemoryUsage;
+			struct Metrics;
 			struct ModSettings;
 
 			Match(BurgApp& app, MatchSettings matchSettings, GamemodeSettings gamemodeSettings, ModSettings modSettings);
@@ -70,13 +85,19 @@ namespace bw
 
 			void BuildClientAssetListPacket(Packets::MatchData& clientAsset) const;
 			void BuildClientScriptListPacket(Packets::MatchData& clientScript) const;
+			Packets::TickRateUpdate BuildTickRateUpdate() const;
 
 			Player* CreatePlayer(MatchClientSession& session, Nz::UInt8 localIndex, std::string name);
 
+			MemoryUsage EstimateMemoryUsage();
+
+			void FlushNetworkStrings();
+
 			void ForEachEntity(std::function<void(const Ndk::EntityHandle& entity)> func) override;
 			template<typename F> void ForEachPlayer(F&& func, bool onlyReady = true);
 
-			inline BurgApp& GetApp();
+			std::string FormatMemoryUsage();
+
 			inline const std::shared_ptr<VirtualDirectory>& GetAssetDirectory() const;
 			inline AssetStore& GetAssetStore();
 			bool GetClientAsset(const std::string& filePath, const ClientAsset** clientScriptData);
@@ -90,15 +111,21 @@ namespace bw
 			inline sol::state& GetLuaState();
 			inline const Map& GetMap() const;
 			inline const Packets::MatchData& GetMatchData() const;
+			Metrics GetMetrics() const;
+			inline float GetMinTickDuration() const;
 			inline const ModSettings& GetModSettings() const;
 			const NetworkStringStore& GetNetworkStringStore() const override;
 			inline Player* GetPlayerByIndex(Nz::UInt16 playerIndex);
+			inline Nz::UInt32 GetRandomSeed() const;
+			inline MatchRecorder* GetRecorder();
 			inline const std::shared_ptr<VirtualDirectory>& GetScriptDirectory() const;
 			inline const std::shared_ptr<ServerScriptingLibrary>& GetScriptingLibrary() const;
+			inline const ScriptProfiler& GetScriptProfiler() const;
 			inline MatchSessions& GetSessions();
 			inline const MatchSessions& GetSessions() const;
 			inline const MatchSettings& GetSettings() const;
 			std::shared_ptr<const SharedGamemode> GetSharedGamemode() const override;
+			inline const std::optional<StateQuantizer>& GetStateQuantizer() const;
 			inline Terrain& GetTerrain();
 			inline const Terrain& GetTerrain() const;
 			ServerWeaponStore& GetWeaponStore() override;
@@ -110,17 +137,22 @@ namespace bw
 			void RegisterClientScript(std::string scriptPath);
 			void RegisterEntity(EntityId uniqueId, Ndk::EntityHandle entity);
 			void RegisterNetworkString(std::string string);
+			void RegisterRelaySession(MatchClientSession* session);
 
 			void ReloadAssets();
+			void ReloadChangedScripts();
 			void ReloadMods();
 			void ReloadScripts();
 
 			void RemovePlayer(Player* player, DisconnectionReason disconnection);
 			void ResetTerrain();
+			Player* ResumePlayer(MatchClientSession& session, Nz::UInt8 localIndex, const std::string& reconnectToken);
 
 			const Ndk::EntityHandle& RetrieveEntityByUniqueId(EntityId uniqueId) const override;
 			EntityId RetrieveUniqueIdByEntity(const Ndk::EntityHandle& entity) const override;
 
+			void UnregisterEntity(EntityId uniqueId);
+			void UnregisterRelaySession(MatchClientSession* session);
 			bool Update(float elapsedTime);
 
 			inline void Quit();
@@ -133,26 +165,130 @@ namespace bw
 				Nz::ByteArray checksum;
 				Nz::UInt64 size;
 				std::filesystem::path realPath;
+				std::shared_ptr<const MemoryMappedFile> mappedFile; //< shared by all sessions, null if mapping failed
 			};
 
 			struct ClientScript
 			{
 				Nz::ByteArray checksum;
-				std::vector<Nz::UInt8> content;
+				std::shared_ptr<const std::vector<Nz::UInt8>> content; //< shared by all sessions
 			};
 
 			struct MatchSettings
 			{
+				struct AdaptiveTickRateSettings
+				{
+					float evaluationInterval = 5.f; //< seconds between two tick rate evaluations
+					float maxTickRate; //< rate of a full match, as long as ticks take less than half of their duration
+					float minTickRate; //< rate of a match with at most one player
+				};
+
+				struct InterestAreaSettings
+				{
+					float cellSize = 512.f;
+					float radius;
+				};
+
+				struct MovementSyncSettings
+				{
+					float extrapolationPositionError = 0.f; //< bodies aren't sent to a client while extrapolating their last acknowledged state stays this close to the real one (0 = disabled)
+					float extrapolationRotationError = 0.05f; //< radians, with extrapolationPositionError
+					float positionEpsilon = 0.01f;
+					float rotationEpsilon = 0.001f; //< radians
+					float settleDuration = 0.25f; //< bodies are still sent for this long after their last change, so sessions with a lower snapshot rate get their final state
+					std::size_t keyframeInterval = 100; //< ticks between two unconditional updates of each body (0 = never)
+				};
+
+				struct StateQuantizationSettings
+				{
+					Nz::UInt16 healthStep = 1; //< health updates are rounded up to a multiple of this
+					float mapMargin = 4096.f; //< positions are encoded relative to map entities bounds extended by this margin (and clamped)
+					float maxAngularVelocity = 100.f;
+					float maxLinearVelocity = 5000.f;
+				};
+
+				std::optional<AdaptiveTickRateSettings> adaptiveTickRate; //< change the tick rate at runtime with player count and tick load, starting from tickDuration (see Packets::TickRateUpdate)
+				std::optional<InterestAreaSettings> interestArea; //< only send moving entities around controlled entities (instead of whole layers)
+				std::optional<MovementSyncSettings> movementSync; //< only send bodies which moved since last tick (instead of every awake body)
+				std::optional<StateQuantizationSettings> stateQuantization; //< quantize entities state in MatchState packets
+				std::optional<Nz::UInt32> randomSeed; //< seed given to scripts (see match.GetRandomSeed), random if unset
 				std::size_t maxPlayerCount;
+				float checkpointInterval = 30.f; //< seconds between two checkpoints, written in the background (0 = only when the match is destroyed)
+				float checkpointReconnectionDelay = 60.f; //< seconds players of a resumed match have to reconnect before their slot and entity are released
+				float fileWatchDelay = 0.f; //< watch script and asset directories and reload what changed once files stopped changing for this many seconds (0 = disabled, see FileWatcher)
+				std::size_t metricsInterval = 0; //< milliseconds between two metrics snapshots (0 = disabled, see GetMetrics)
+				float layerHibernationDelay = 0.f; //< seconds without any player seeing a layer before its entities are removed until someone sees it again (0 = never, requires lazyLayerActivation)
+				float lagCompensationDuration = 1.f; //< seconds of hitboxes history kept by each layer for rewind traces (0 = disabled, see HitboxHistory)
+				std::size_t networkStatisticsInterval = 0; //< seconds between two network statistics log lines (0 = disabled)
+				std::size_t networkThreadCount = 1; //< each network thread listens on its own port (starting from port)
+				std::size_t peerBandwidth = 0; //< outgoing bytes per second for each session (0 = unlimited)
+				ScriptingContext::GarbageCollectorMode scriptGarbageCollectorMode = ScriptingContext::GarbageCollectorMode::IncrementalStepped; //< IncrementalStepped spends idle tick time collecting Lua garbage instead of pausing at random allocations
+				float scriptGarbageCollectorStepBudget = 1.f; //< milliseconds of garbage collection each tick may spend if it has time left (IncrementalStepped)
+				float scriptCallbackBudget = 0.f; //< milliseconds an entity event callbacks may take before being logged and, for ticks, throttled (0 = unlimited, see ScriptProfiler)
+				float snapshotRate = 0.f; //< visibility updates (MatchState snapshots and entities events) per second for each session (0 = every tick)
+				std::size_t tickProfileInterval = 0; //< seconds between two tick profile log lines (0 = disabled)
+				std::size_t workerThreadCount = 0; //< threads helping the match thread with parallel tick work such as session visibility (0 = none)
 				std::string name;
 				std::string description;
+				std::string checkpointPath; //< save the match state to this file and resume from it if it exists when the match starts (see MatchCheckpoint, empty = disabled)
+				std::string relayPassword; //< lets relays (BurgWarServer --relay) connect as a spectator session seeing every layer, to serve the match to many spectators (empty = disabled)
+				std::string replayRecordPath; //< record sessions traffic to this file so the match can be replayed offline (see MatchRecorder, empty = disabled)
 				Nz::UInt16 port = 0;
 				Map map;
+				bool adaptiveSnapshotRate = false; //< lower sessions snapshot rate when their connection is congested
+				bool deferPacketSerialization = false; //< serialize large per-session packets (MatchState) on network threads
+				bool fastTerrainReset = false; //< restore map entities captured state on reset instead of instantiating them again (see TerrainLayer)
+				bool lazyLayerActivation = false; //< only instantiate map entities of a layer (except the first one) once a player sees it (see Terrain::ActivateLayer)
+				bool loadShedding = true; //< degrade non-critical work when ticks fall behind (see SharedMatch::LoadLevel)
+				bool parallelLayerUpdate = false; //< step layers physics concurrently on worker threads
 				bool sleepWhenEmpty = true;
+				bool tickProfiling = true; //< time tick phases, systems and script callbacks (see GetTickProfiler and ScriptProfiler)
 				bool registerToMasterServer = true;
 				float tickDuration;
 			};
 
+			// Memory used by each subsystem, in bytes unless noted otherwise (containers are estimated from their capacity)
+			struct MemoryUsage
+			{
+				std::size_t clientAssets = 0; //< client assets mapped in memory and client scripts
+				std::size_t entities = 0; //< count, Ndk worlds allocate through Nazara and can't be measured
+				std::size_t entityComponents = 0; //< count
+				std::size_t scripts = 0; //< Lua heap, tracked by the script allocator
+				std::size_t sessions = 0; //< packets buffered by sessions and their pending downloads
+				std::size_t visibility = 0; //< per-session visibility event maps and sent match states
+			};
+
+			struct Metrics
+			{
+				struct PacketMetrics
+				{
+					std::string name;
+					Nz::UInt64 byteCount;
+					Nz::UInt64 packetCount;
+					bool outgoing;
+				};
+
+				struct SessionMetrics
+				{
+					MatchClientSession::InputTimingStatistics inputTiming;
+					SessionBridge::SessionInfo info;
+					std::size_t sessionId;
+				};
+
+				MemoryUsage memoryUsage;
+				ScriptingContext::GarbageCollectorStats scriptGarbageCollector;
+				TickDurationHistogram tickDurations;
+				std::string name;
+				std::vector<std::size_t> layerEntityCounts;
+				std::vector<PacketMetrics> packets; //< totals per packet type since match start
+				std::vector<SessionMetrics> sessions; //< sessions which received peer info from their network reactor
+				Nz::UInt64 discardedTickCount = 0;
+				Nz::UInt64 tickCount = 0;
+				std::size_t pendingDownloadCount = 0; //< client files queued or being sent, over all sessions
+				std::size_t playerCount = 0;
+				std::size_t scriptMemoryUsage = 0; //< bytes
+			};
+
 			struct ModSettings
 			{
 				struct ModEntry
@@ -171,10 +307,30 @@ namespace bw
 
 		private:
 			void BuildMatchData();
+			void BuildScriptDirectory();
+			void CaptureCheckpoint(MatchCheckpoint& checkpoint);
+			Metrics CollectMetrics();
+			void ExpireResumablePlayers();
+			std::shared_ptr<const MemoryMappedFile> MapClientAsset(const std::filesystem::path& realPath, Nz::UInt64 assetSize);
 			void OnPlayerReady(Player* player);
 			void OnTick(bool lastTick) override;
+			void RefreshClientAssets();
 			void RegisterClientAssetInternal(std::string assetPath, Nz::UInt64 assetSize, Nz::ByteArray assetChecksum, std::filesystem::path realPath);
+			void RegisterElementNetworkStrings();
+			void RestoreCheckpoint(const MatchCheckpoint& checkpoint);
 			void SendPingUpdate();
+			void UpdateEntityElements();
+			void UpdateFileWatches();
+			void UpdateTickRate();
+			void WriteCheckpoint(bool inBackground);
+
+			// Shared with the background job writing the last checkpoint, which may outlive the match
+			struct CheckpointWriter
+			{
+				std::atomic_bool isWriting{ false };
+				std::mutex errorMutex;
+				std::string lastError;
+			};
 
 			struct Debug
 			{
@@ -191,35 +347,88 @@ namespace bw
 				NazaraSlot(Ndk::Entity, OnEntityDestruction, onDestruction);
 			};
 
+			struct ResumablePlayer
+			{
+				MatchCheckpoint::Player playerData;
+				Nz::UInt64 expirationTime;
+			};
+
+			struct FileWatch
+			{
+				FileWatch(std::filesystem::path directory) : watcher(std::move(directory)) {}
+
+				FileWatcher watcher;
+				Nz::UInt64 lastChangeTime = 0;
+				bool hasPendingChanges = false;
+			};
+
+			struct TickProfilerSections
+			{
+				std::size_t gamemodeTick;
+				std::size_t playerTick;
+				std::size_t scriptGarbageCollection;
+				std::size_t sessionTick;
+				std::size_t sessionUpdate;
+			};
+
 			std::shared_ptr<ScriptingContext> m_scriptingContext; //< Must be over script based classes
+			std::shared_ptr<ScriptBytecodeCache> m_bytecodeCache;
+			std::shared_ptr<CheckpointWriter> m_checkpointWriter;
 			std::optional<AssetStore> m_assetStore;
 			std::optional<Debug> m_debug;
+			std::optional<FileWatch> m_assetWatch;
+			std::optional<FileWatch> m_scriptWatch;
 			std::optional<ServerEntityStore> m_entityStore;
 			std::optional<ServerWeaponStore> m_weaponStore;
+			std::optional<Packets::TickRateUpdate> m_pendingTickRateUpdate;
+			std::optional<StateQuantizer> m_stateQuantizer;
 			std::size_t m_maxPlayerCount;
 			std::shared_ptr<ServerGamemode> m_gamemode;
 			std::shared_ptr<ServerScriptingLibrary> m_scriptingLibrary;
 			std::shared_ptr<VirtualDirectory> m_assetDirectory;
 			std::shared_ptr<VirtualDirectory> m_scriptDirectory;
 			std::string m_name;
+			std::unique_ptr<MatchRecorder> m_recorder;
 			std::unique_ptr<Terrain> m_terrain;
+			std::unique_ptr<WorkerPool> m_workerPool;
 			std::vector<std::shared_ptr<Mod>> m_enabledMods;
 			std::vector<std::unique_ptr<MasterServerEntry>> m_masterServerEntries;
+			std::vector<MatchClientSession*> m_parallelSessions;
+			std::vector<MatchClientSession*> m_relaySessions;
 			std::vector<std::unique_ptr<Player>> m_players;
+			std::vector<Nz::UInt16> m_sentPings; //< by player index, last ping sent by SendPingUpdate
 			mutable Packets::MatchData m_matchData;
+			mutable std::mutex m_metricsMutex;
 			tsl::hopscotch_map<std::string, ClientAsset> m_clientAssets;
 			tsl::hopscotch_map<std::string, ClientScript> m_clientScripts;
-			tsl::hopscotch_map<EntityId, Entity> m_entitiesByUniqueId;
+			tsl::hopscotch_map<std::string, ResumablePlayer> m_resumablePlayers; //< players of the resumed checkpoint by reconnect token, until they reconnect or expire
+			tsl::hopscotch_map<std::size_t, MatchCheckpoint::Player> m_resumedPlayers; //< by player index, reconnected players waiting for their session to be ready
+			tsl::hopscotch_map<std::string, Nz::ByteArray> m_scriptChecksums; //< script files checksums when they were last loaded (see ReloadChangedScripts)
+			EntityRegistry<Entity> m_entitiesByUniqueId;
 			Nz::Bitset<> m_freePlayerId;
 			EntityId m_nextUniqueId;
+			Nz::UInt64 m_lastCheckpointTime;
+			Nz::UInt64 m_lastMetricsUpdate;
+			Nz::UInt64 m_lastNetworkStatisticsLog;
 			Nz::UInt64 m_lastPingUpdate;
-			BurgApp& m_app;
+			Nz::UInt64 m_pingUpdateCounter; //< full ping updates are sent when this is a multiple of PingFullUpdateInterval
+			Nz::UInt64 m_lastTickProfileLog;
+			Nz::UInt64 m_lastTickRateEvaluation;
+			Nz::UInt64 m_pendingTickRateTick;
+			Nz::UInt64 m_tickRateEvaluationTick; //< tick count and ticks total duration when the tick rate was last evaluated, to average tick load since then
+			Nz::UInt64 m_tickRateEvaluationTickDuration;
+			Nz::UInt32 m_randomSeed;
+			Nz::UInt32 m_sentNetworkStringCount; //< strings before this id were sent to every session, newer ones are sent in a batch by FlushNetworkStrings
+			ChecksumCache m_checksumCache;
 			GamemodeSettings m_gamemodeSettings;
 			Map m_map;
 			MatchSessions m_sessions;
 			MatchSettings m_settings;
+			Metrics m_metrics; //< last snapshot, protected by m_metricsMutex
 			ModSettings m_modSettings;
 			NetworkStringStore m_networkStringStore;
+			TickProfilerSections m_tickProfilerSections;
+			float m_deferredMasterServerTime;
 			bool m_isResetting;
 			bool m_isMatchRunning;
 	};
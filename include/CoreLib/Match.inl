@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/Match.hpp>
+#include <algorithm>
 #include <cassert>
 
 namespace bw
@@ -20,11 +21,39 @@ namespace bw
 	template<typename T>
 	void Match::BroadcastPacket(const T& packet, bool onlyReady, Player* except)
 	{
-		ForEachPlayer([&packet, onlyReady, except](Player* player)
+		// Serialize only once for every player (and once more for those which didn't negotiate compression)
+		SharedPacketRef compressedPacket;
+		SharedPacketRef uncompressedPacket;
+		auto SendToSession = [&](MatchClientSession& session)
+		{
+			// Local sessions don't need serialization at all
+			if (session.GetSessionBridge().SupportsTypedPackets())
+			{
+				session.SendPacket(packet);
+				return;
+			}
+
+			bool allowCompression = session.HasProtocolFeature(ProtocolFeature::Compression);
+
+			SharedPacketRef& sharedPacket = (allowCompression) ? compressedPacket : uncompressedPacket;
+			if (!sharedPacket)
+				sharedPacket = m_sessions.BuildSharedPacket(packet, allowCompression);
+
+			session.SendSharedPacket(sharedPacket);
+		};
+
+		ForEachPlayer([&](Player* player)
 		{
 			if (player != except)
-				player->SendPacket(packet);
+				SendToSession(player->GetSession());
 		}, onlyReady);
+
+		// Relays have no player but follow the whole match
+		for (MatchClientSession* relaySession : m_relaySessions)
+		{
+			if (!onlyReady || relaySession->IsRelayReady())
+				SendToSession(*relaySession);
+		}
 	}
 
 	template<typename F>
@@ -37,11 +66,6 @@ namespace bw
 		}
 	}
 
-	inline BurgApp& Match::GetApp()
-	{
-		return m_app;
-	}
-
 	inline const std::shared_ptr<VirtualDirectory>& Match::GetAssetDirectory() const
 	{
 		return m_assetDirectory;
@@ -74,6 +98,14 @@ namespace bw
 		return m_matchData;
 	}
 
+	inline float Match::GetMinTickDuration() const
+	{
+		if (m_settings.adaptiveTickRate)
+			return std::min(m_settings.tickDuration, 1.f / m_settings.adaptiveTickRate->maxTickRate);
+
+		return m_settings.tickDuration;
+	}
+
 	inline auto Match::GetModSettings() const -> const ModSettings&
 	{
 		return m_modSettings;
@@ -105,6 +137,21 @@ namespace bw
 		return m_settings;
 	}
 
+	inline const std::optional<StateQuantizer>& Match::GetStateQuantizer() const
+	{
+		return m_stateQuantizer;
+	}
+
+	inline Nz::UInt32 Match::GetRandomSeed() const
+	{
+		return m_randomSeed;
+	}
+
+	inline MatchRecorder* Match::GetRecorder()
+	{
+		return m_recorder.get();
+	}
+
 	inline const std::shared_ptr<VirtualDirectory>& Match::GetScriptDirectory() const
 	{
 		return m_scriptDirectory;
@@ -115,6 +162,11 @@ namespace bw
 		return m_scriptingLibrary;
 	}
 
+	inline const ScriptProfiler& Match::GetScriptProfiler() const
+	{
+		return m_scriptingContext->GetProfiler();
+	}
+
 	inline Terrain& Match::GetTerrain()
 	{
 		assert(m_terrain);
@@ -0,0 +1,114 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_MATCHCHECKPOINT_HPP
+#define BURGWAR_CORELIB_MATCHCHECKPOINT_HPP
+
+#include <CoreLib/EntityId.hpp>
+#include <CoreLib/Export.hpp>
+#include <CoreLib/LayerIndex.hpp>
+#include <CoreLib/PropertyValues.hpp>
+#include <CoreLib/Scripting/ScriptMessageValue.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <Nazara/Math/Angle.hpp>
+#include <Nazara/Math/Vector2.hpp>
+#include <Nazara/Math/Vector3.hpp>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	class PacketSerializer;
+
+	// State of a running match (entities, opted-in script state and players) which another process can resume from (see MatchSettings::checkpointPath)
+	class BURGWAR_CORELIB_API MatchCheckpoint
+	{
+		public:
+			struct Entity;
+			struct Layer;
+			struct Physics;
+			struct Player;
+			struct Weapon;
+
+			MatchCheckpoint() = default;
+			MatchCheckpoint(const MatchCheckpoint&) = default;
+			MatchCheckpoint(MatchCheckpoint&&) noexcept = default;
+			~MatchCheckpoint() = default;
+
+			void Serialize(PacketSerializer& serializer);
+
+			MatchCheckpoint& operator=(const MatchCheckpoint&) = default;
+			MatchCheckpoint& operator=(MatchCheckpoint&&) noexcept = default;
+
+			static MatchCheckpoint LoadFromFile(const std::filesystem::path& filePath);
+			static void SaveToFile(const std::filesystem::path& filePath, MatchCheckpoint checkpoint); //< written next to the file then renamed over it, so a crash never leaves a truncated checkpoint
+
+			static constexpr Nz::UInt16 FileVersion = 1;
+
+			struct Physics
+			{
+				Nz::RadianAnglef angularVelocity;
+				Nz::RadianAnglef rotation;
+				Nz::Vector2f linearVelocity;
+				Nz::Vector2f position;
+				float mass;
+				float momentOfInertia;
+				bool isSleeping;
+			};
+
+			struct Weapon
+			{
+				std::string weaponClass;
+				EntityId uniqueId;
+			};
+
+			struct Entity
+			{
+				std::optional<Nz::UInt16> health;
+				std::optional<Physics> physics;
+				std::optional<Nz::UInt32> selectedWeapon;
+				std::optional<ScriptMessageValue> scriptState; //< instance table fields, only for elements with Checkpoint = true
+				std::string entityClass;
+				std::vector<Weapon> weapons;
+				EntityId uniqueId;
+				Nz::RadianAnglef rotation;
+				Nz::Vector2f position;
+				Nz::Vector3f scale;
+				PropertyValueMap properties;
+				float timeBeforeTick;
+			};
+
+			struct Layer
+			{
+				std::vector<Entity> entities;
+				bool isActive;
+			};
+
+			struct Player
+			{
+				std::string name;
+				std::string reconnectToken;
+				EntityId controlledEntityId;
+				LayerIndex layerIndex;
+				Nz::UInt16 playerIndex;
+				bool isAdmin;
+			};
+
+			std::vector<ScriptMessageValue> gamemodeState; //< plain fields of the gamemode table then of its bases, empty if the gamemode has no Checkpoint = true
+			std::string gamemodeName;
+			std::vector<Layer> layers;
+			std::vector<Player> players;
+			EntityId nextUniqueId;
+			Nz::UInt64 currentTick;
+			Nz::UInt32 randomSeed;
+	};
+}
+
+#include <CoreLib/MatchCheckpoint.inl>
+
+#endif
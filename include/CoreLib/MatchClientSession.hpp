@@ -12,10 +12,14 @@
 #include <CoreLib/SessionBridge.hpp>
 #include <CoreLib/Protocol/Packets.hpp>
 #include <CoreLib/Utility/CircularBuffer.hpp>
+#include <Nazara/Core/File.hpp>
 #include <Nazara/Core/HandledObject.hpp>
 #include <Nazara/Core/ObjectHandle.hpp>
 #include <filesystem>
 #include <memory>
+#include <optional>
+#include <string>
+#include <variant>
 #include <vector>
 
 namespace bw
@@ -34,6 +38,8 @@ namespace bw
 		friend PlayerCommandStore;
 
 		public:
+			struct InputTimingStatistics;
+
 			MatchClientSession(Match& match, std::size_t sessionId, PlayerCommandStore& commandStore, std::shared_ptr<SessionBridge> bridge);
 			MatchClientSession(const MatchClientSession&) = delete;
 			MatchClientSession(MatchClientSession&&) = delete;
@@ -41,28 +47,63 @@ namespace bw
 
 			void Disconnect();
 
+			std::size_t EstimateMemoryUsage() const;
+
 			template<typename F> void ForEachPlayer(F&& func);
 
+			inline std::size_t GetAvailableBandwidth() const;
+			inline const CommandStatisticsList& GetIncomingStatistics() const;
+			inline const InputTimingStatistics& GetInputTimingStatistics() const;
+			inline const std::optional<Nz::UInt16>& GetLastInputStateTick() const;
 			inline Nz::UInt16 GetLastInputTick() const;
+			inline const CommandStatisticsList& GetOutgoingStatistics() const;
+			inline std::size_t GetPendingDownloadCount() const;
 			inline Nz::UInt32 GetPing() const;
+			inline ProtocolFeatureFlags GetProtocolFeatures() const;
 			inline const SessionBridge& GetSessionBridge() const;
 			inline std::size_t GetSessionId() const;
+			inline const std::optional<SessionBridge::SessionInfo>& GetSessionInfo() const;
+			float GetSnapshotInterval() const;
+			inline float GetSnapshotRate() const;
 			inline MatchClientVisibility& GetVisibility();
 			inline const MatchClientVisibility& GetVisibility() const;
 
 			void HandleIncomingPacket(Nz::NetPacket& packet);
+			inline bool HasProtocolFeature(ProtocolFeature feature) const;
+
+			inline bool IsRelay() const;
+			inline bool IsRelayReady() const;
 
 			void OnTick(float elapsedTime);
 
+			template<typename T> void SendDeferredPacket(T&& packet, std::size_t expectedSize);
 			template<typename T> void SendPacket(const T& packet);
+			inline void SendSharedPacket(const SharedPacketRef& packet);
+
+			inline void SetSnapshotRate(float snapshotRate);
+
+			inline bool SupportsParallelUpdate() const;
 
+			void FinishUpdate(float elapsedTime);
 			void Update(float elapsedTime);
+			void UpdateVisibility(float elapsedTime, bool bufferPackets = false);
 
 			MatchClientSession& operator=(const MatchClientSession&) = delete;
 			MatchClientSession& operator=(MatchClientSession&&) = delete;
 
+			// How input packets arrived compared to the tick they were meant for, late inputs are dropped and cause mispredictions
+			struct InputTimingStatistics
+			{
+				Nz::UInt64 earlyCount = 0; //< arrived more than InputTimingTolerance ticks before being needed (adding latency)
+				Nz::UInt64 lateCount = 0; //< arrived after their tick was processed
+				Nz::UInt64 onTimeCount = 0;
+			};
+
+			static constexpr Nz::Int32 InputTimingTolerance = 2; //< ticks
+
 		private:
 			void HandleIncomingPacket(const Packets::Auth& packet);
+			void HandleIncomingPacket(const Packets::DownloadClientFileAck& packet);
 			void HandleIncomingPacket(const Packets::DownloadClientFileRequest& packet);
 			void HandleIncomingPacket(Packets::PlayerChat&& packet);
 			void HandleIncomingPacket(const Packets::PlayerConsoleCommand& packet);
@@ -71,23 +112,50 @@ namespace bw
 			void HandleIncomingPacket(const Packets::Ready& packet);
 			void HandleIncomingPacket(const Packets::ScriptPacket& packet);
 			void HandleIncomingPacket(Packets::UpdatePlayerName&& packet);
-			void SendClientFile(const std::filesystem::path& filePath);
-			void SendClientFile(const std::vector<Nz::UInt8>& content);
+			inline void ConsumeBandwidth(std::size_t byteCount);
+			void FlushBufferedPackets();
+			std::size_t GetDownloadWindowSize() const;
+			void SendDownloadFailure();
+			void SendMatchData();
+			void SendPendingDownloads();
+			bool StartDownload(const std::string& path);
+			template<typename T> void SendTypedPacket(T&& packet);
+			void UpdateBandwidth(float elapsedTime);
 			void UpdatePeerInfo(const SessionBridge::SessionInfo& sessionInfo);
 
 			struct Input
 			{
-				std::vector<std::optional<PlayerInputData>> inputs;
+				std::vector<PlayerInputData> inputs;
+				std::optional<Nz::UInt16> lastReceivedStateTick; //< most recent MatchState the client had when sending these inputs
 				Nz::UInt16 inputTick;
 			};
 
-			/*struct PendingAssetRequest
+			static constexpr std::size_t MaxQueuedInputs = Packets::PlayersInput::MaxPreviousInputs + 1;
+
+			struct ActiveDownload
+			{
+				std::optional<Nz::File> file; //< fallback for assets which couldn't be mapped
+				std::shared_ptr<const Nz::UInt8> data; //< mapped asset or script content, shared with the match
+				Nz::UInt32 acknowledgedFragmentCount;
+				Nz::UInt32 fragmentCount;
+				Nz::UInt32 nextFragmentIndex;
+				Nz::UInt64 fileSize;
+			};
+
+			struct PendingDownload
 			{
-				std::size_t fragmentCount;
-				std::size_t currentFragmentIndex;
-				std::filesystem::path filePath;
-				Nz::UInt64 fragmentSize;
-			};*/
+				std::string path;
+			};
+
+			struct BufferedPacket
+			{
+				std::variant<Nz::NetPacket, SessionBridge::SerializationJob, SharedPacketRef> data;
+				std::size_t byteCount;
+				std::size_t packetId;
+				Nz::UInt64 serializationTime;
+				Nz::ENetPacketFlags flags;
+				Nz::UInt8 channelId;
+			};
 
 			CircularBuffer<Input> m_queuedInputs;
 			Match& m_match;
@@ -95,11 +163,31 @@ namespace bw
 			std::size_t m_sessionId;
 			std::shared_ptr<SessionBridge> m_bridge;
 			std::unique_ptr<MatchClientVisibility> m_visibility;
-			//std::vector<PendingAssetRequest> m_pendingAssetRequest;
+			std::optional<ActiveDownload> m_activeDownload;
+			std::vector<BufferedPacket> m_bufferedPackets; //< outgoing packets waiting to be handed to the bridge in order (parallel updates)
+			std::vector<PendingDownload> m_pendingDownloads;
 			std::vector<PlayerHandle> m_players;
+			std::size_t m_maxBandwidth;
+			CommandStatisticsList m_incomingStatistics;
+			CommandStatisticsList m_outgoingStatistics;
+			InputTimingStatistics m_inputTimingStatistics;
+			std::optional<SessionBridge::SessionInfo> m_lastSessionInfo;
+			std::optional<Nz::UInt16> m_lastInputStateTick;
+			std::optional<Nz::UInt16> m_lastReceivedInputTick;
 			Nz::UInt16 m_lastInputTick;
+			Nz::UInt32 m_minPing;
 			Nz::UInt32 m_ping;
+			ProtocolFeatureFlags m_protocolFeatures;
+			float m_bandwidthScale;
+			float m_bandwidthTokens;
 			float m_peerInfoUpdateCounter;
+			float m_snapshotRate;
+			float m_snapshotTimer;
+			bool m_adaptiveSnapshotRate;
+			bool m_bufferOutgoingPackets;
+			bool m_deferPacketSerialization;
+			bool m_isRelay;
+			bool m_isRelayReady;
 	};
 }
 
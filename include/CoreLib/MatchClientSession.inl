@@ -3,7 +3,10 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/MatchClientSession.hpp>
+#include <Nazara/Core/Clock.hpp>
 #include <cassert>
+#include <limits>
+#include <type_traits>
 
 namespace bw
 {
@@ -17,16 +20,54 @@ namespace bw
 		}
 	}
 
+	inline std::size_t MatchClientSession::GetAvailableBandwidth() const
+	{
+		if (m_maxBandwidth == 0)
+			return std::numeric_limits<std::size_t>::max();
+
+		return (m_bandwidthTokens > 0.f) ? static_cast<std::size_t>(m_bandwidthTokens) : 0;
+	}
+
+	inline const CommandStatisticsList& MatchClientSession::GetIncomingStatistics() const
+	{
+		return m_incomingStatistics;
+	}
+
+	inline auto MatchClientSession::GetInputTimingStatistics() const -> const InputTimingStatistics&
+	{
+		return m_inputTimingStatistics;
+	}
+
+	inline const std::optional<Nz::UInt16>& MatchClientSession::GetLastInputStateTick() const
+	{
+		return m_lastInputStateTick;
+	}
+
 	inline Nz::UInt16 MatchClientSession::GetLastInputTick() const
 	{
 		return m_lastInputTick;
 	}
 
+	inline const CommandStatisticsList& MatchClientSession::GetOutgoingStatistics() const
+	{
+		return m_outgoingStatistics;
+	}
+
+	inline std::size_t MatchClientSession::GetPendingDownloadCount() const
+	{
+		return m_pendingDownloads.size() + ((m_activeDownload) ? 1 : 0);
+	}
+
 	inline Nz::UInt32 MatchClientSession::GetPing() const
 	{
 		return m_ping;
 	}
 
+	inline ProtocolFeatureFlags MatchClientSession::GetProtocolFeatures() const
+	{
+		return m_protocolFeatures;
+	}
+
 	inline const SessionBridge& MatchClientSession::GetSessionBridge() const
 	{
 		return *m_bridge;
@@ -37,6 +78,16 @@ namespace bw
 		return m_sessionId;
 	}
 
+	inline const std::optional<SessionBridge::SessionInfo>& MatchClientSession::GetSessionInfo() const
+	{
+		return m_lastSessionInfo;
+	}
+
+	inline float MatchClientSession::GetSnapshotRate() const
+	{
+		return m_snapshotRate;
+	}
+
 	inline MatchClientVisibility& MatchClientSession::GetVisibility()
 	{
 		return *m_visibility;
@@ -47,13 +98,137 @@ namespace bw
 		return *m_visibility;
 	}
 
+	inline bool MatchClientSession::HasProtocolFeature(ProtocolFeature feature) const
+	{
+		return m_protocolFeatures.Test(feature);
+	}
+
+	inline bool MatchClientSession::IsRelay() const
+	{
+		return m_isRelay;
+	}
+
+	inline bool MatchClientSession::IsRelayReady() const
+	{
+		return m_isRelayReady;
+	}
+
+	template<typename T>
+	void MatchClientSession::SendDeferredPacket(T&& packet, std::size_t expectedSize)
+	{
+		using Packet = std::decay_t<T>;
+
+		if (m_bridge->SupportsTypedPackets())
+		{
+			SendTypedPacket(std::forward<T>(packet));
+			return;
+		}
+
+		if (!m_deferPacketSerialization)
+		{
+			SendPacket(packet);
+			return;
+		}
+
+		// Packet is serialized by the bridge (network thread) so it has to be moved/copied
+		ConsumeBandwidth(expectedSize);
+
+		const auto& command = m_commandStore.GetOutgoingCommand<Packet>();
+		SessionBridge::SerializationJob serializationJob = [packet = Packet(std::forward<T>(packet)), compress = command.compress && HasProtocolFeature(ProtocolFeature::Compression)](Nz::NetPacket& data)
+		{
+			PlayerCommandStore::SerializePacket(data, packet, compress);
+		};
+
+		if (m_bufferOutgoingPackets)
+		{
+			m_bufferedPackets.push_back({ std::move(serializationJob), expectedSize, static_cast<std::size_t>(Packet::Type), 0, command.flags, command.channelId });
+			return;
+		}
+
+		// Serialization happens on the network thread, only the expected size can be recorded
+		m_commandStore.RecordOutgoingPacket(static_cast<std::size_t>(Packet::Type), expectedSize, 0, &m_outgoingStatistics);
+
+		m_bridge->SendDeferredPacket(command.channelId, command.flags, std::move(serializationJob));
+	}
+
 	template<typename T>
 	void MatchClientSession::SendPacket(const T& packet)
 	{
-		Nz::NetPacket data;
-		m_commandStore.SerializePacket(data, packet);
+		if (m_bridge->SupportsTypedPackets())
+		{
+			SendTypedPacket(packet);
+			return;
+		}
 
 		const auto& command = m_commandStore.GetOutgoingCommand<T>();
+
+		Nz::UInt64 startTime = Nz::GetElapsedMicroseconds();
+
+		Nz::NetPacket data;
+		m_commandStore.SerializePacket(data, packet, command.compress && HasProtocolFeature(ProtocolFeature::Compression));
+
+		Nz::UInt64 serializationTime = Nz::GetElapsedMicroseconds() - startTime;
+		std::size_t byteCount = data.GetDataSize();
+
+		ConsumeBandwidth(byteCount);
+
+		if (m_bufferOutgoingPackets)
+		{
+			// Command store statistics are shared by all sessions, they will be recorded when flushing
+			m_bufferedPackets.push_back({ std::move(data), byteCount, static_cast<std::size_t>(T::Type), serializationTime, command.flags, command.channelId });
+			return;
+		}
+
+		m_commandStore.RecordOutgoingPacket(static_cast<std::size_t>(T::Type), byteCount, serializationTime, &m_outgoingStatistics);
+
 		m_bridge->SendPacket(command.channelId, command.flags, std::move(data));
 	}
+
+	inline void MatchClientSession::SendSharedPacket(const SharedPacketRef& packet)
+	{
+		ConsumeBandwidth(packet->data.GetDataSize());
+
+		if (m_bufferOutgoingPackets)
+		{
+			m_bufferedPackets.push_back({ packet, packet->data.GetDataSize(), packet->packetId, 0, packet->flags, packet->channelId });
+			return;
+		}
+
+		// Shared packets are serialized once for every session
+		m_commandStore.RecordOutgoingPacket(packet->packetId, packet->data.GetDataSize(), 0, &m_outgoingStatistics);
+
+		m_bridge->SendSharedPacket(packet);
+	}
+
+	inline void MatchClientSession::SetSnapshotRate(float snapshotRate)
+	{
+		assert(snapshotRate >= 0.f);
+		m_snapshotRate = snapshotRate;
+	}
+
+	inline bool MatchClientSession::SupportsParallelUpdate() const
+	{
+		// Typed packets are directly handled by the local client, which cannot be done from another thread
+		return !m_bridge->SupportsTypedPackets();
+	}
+
+	template<typename T>
+	void MatchClientSession::SendTypedPacket(T&& packet)
+	{
+		using Packet = std::decay_t<T>;
+
+		assert(!m_bufferOutgoingPackets);
+
+		// Packet structure is moved to the other side without being serialized, bandwidth isn't an issue there
+		m_commandStore.RecordOutgoingPacket(static_cast<std::size_t>(Packet::Type), 0, 0, &m_outgoingStatistics);
+
+		m_bridge->SendTypedPacket(BuildTypedPacket(std::forward<T>(packet)));
+	}
+
+	inline void MatchClientSession::ConsumeBandwidth(std::size_t byteCount)
+	{
+		// Budget may go negative (reliable packets have to be sent anyway), delaying lower priority traffic
+		if (m_maxBandwidth != 0)
+			m_bandwidthTokens -= float(byteCount);
+	}
 }
@@ -21,6 +21,7 @@
 #include <tsl/hopscotch_map.h>
 #include <tsl/hopscotch_set.h>
 #include <limits>
+#include <tuple>
 #include <vector>
 
 namespace bw
@@ -34,6 +35,8 @@ namespace bw
 		InputUpdate,
 		PlayAnimation,
 		PhysicsUpdate,
+		Recycle,
+		Respawn,
 		ScaleUpdate,
 		WeaponUpdate,
 
@@ -62,9 +65,13 @@ namespace bw
 			MatchClientVisibility(MatchClientVisibility&&) noexcept = default;
 			~MatchClientVisibility() = default;
 
+			void AcknowledgeMatchState(Nz::UInt16 stateTick);
+
 			inline void ClearLayers();
 
-			inline void HideLayer(LayerIndex layerIndex);
+			std::size_t EstimateMemoryUsage() const;
+
+			inline void HideLayer(LayerIndex layerIndex, bool prefetch = false);
 
 			inline bool IsLayerVisible(LayerIndex layerIndex) const;
 
@@ -77,7 +84,7 @@ namespace bw
 			inline void SetEntityControlledStatus(LayerIndex layerIndex, Nz::UInt32 entityId, bool isControlled);
 			inline void ShouldIgnoreEvents(bool ignoreEvents);
 
-			void ShowLayer(LayerIndex layerIndex);
+			void ShowLayer(LayerIndex layerIndex, bool prefetch = false); //< prefetched layers are streamed in the background and get fewer movement updates
 
 			void Update();
 
@@ -85,23 +92,95 @@ namespace bw
 			MatchClientVisibility& operator=(MatchClientVisibility&&) = delete;
 
 		private:
+			struct Layer;
+
+			struct MatchStateLayer
+			{
+				LayerIndex layerIndex;
+				Layer* layer;
+			};
+
 			struct PriorityMovementData
 			{
 				Nz::UInt8 priorityAccumulator;
 				LayerIndex layerIndex;
-				NetworkSyncSystem::EntityMovement movementData;
+				Layer* layer;
+				const NetworkSyncSystem::MovementSnapshot* snapshot; //< nullptr for static entities
+				std::size_t movementIndex; //< in snapshot, or in m_staticMovementData for static entities
+				Ndk::EntityId entityId;
 				bool staticEntity;
 			};
 
-			using EntityPacketSendFunction = std::function<void()>;
+			struct EntityState
+			{
+				Nz::RadianAnglef angularVelocity;
+				Nz::RadianAnglef rotation;
+				Nz::Vector2f linearVelocity;
+				Nz::Vector2f position;
+			};
+
+			struct SentMatchState
+			{
+				struct Entity
+				{
+					LayerIndex layerIndex;
+					Nz::UInt32 entityId;
+					Nz::UInt32 generation;
+					Nz::UInt8 priorityAccumulator; //< priority at the time the state was sent, reinstated on loss
+					EntityState state;
+					std::optional<NetworkSyncSystem::EntityMovement> staticMovement; //< static update to reinstate on loss
+				};
+
+				bool isValid = false;
+				Nz::UInt16 stateTick;
+				std::vector<Entity> entities;
+			};
+
+			template<typename T>
+			struct PendingEntityPacket
+			{
+				Nz::UInt64 entityKey; //< layerId|entityId
+				T packet;
+			};
+
+			template<typename T>
+			struct PendingEntitiesPacket
+			{
+				LayerIndex layerIndex;
+				Nz::Bitset<Nz::UInt64> entitiesId;
+				T packet;
+			};
+
+			// One contiguous queue per packet type which can wait for entities to be visible, supporting another packet type only requires adding it here
+			using PendingEntityPacketQueues = std::tuple<std::vector<PendingEntityPacket<Packets::ControlEntity>>>;
+			using PendingEntitiesPacketQueues = std::tuple<std::vector<PendingEntitiesPacket<Packets::PlayerWeapons>>>;
 			using PendingCreationEventMap = tsl::hopscotch_map<Nz::UInt32 /*entityId*/, std::optional<NetworkSyncSystem::EntityCreation>>;
 
-			void BuildMovementPacket(Packets::MatchState::Entity& packetData, const NetworkSyncSystem::EntityMovement& eventData);
+			struct CreationOrderNode
+			{
+				PendingCreationEventMap::iterator it;
+				std::size_t dependencyIndex; //< next dependency to visit (parent first, then dependent ids)
+			};
+
+			void BuildMovementPacket(Packets::MatchState::Entity& packetData, const NetworkSyncSystem::EntityMovement& eventData, const Layer& layer, Nz::UInt16 stateTick);
+			void BuildMovementPacket(Packets::MatchState::Entity& packetData, const NetworkSyncSystem::MovementSnapshot& snapshot, std::size_t movementIndex, const Layer& layer, Nz::UInt16 stateTick);
+			void EncodeMovementPacket(Packets::MatchState::Entity& packetData, const Layer& layer, Nz::UInt16 stateTick);
 			void FillEntityData(const NetworkSyncSystem::EntityCreation& creationEvent, Packets::Helper::EntityData& entityData);
+			template<typename T> void FlushPendingPackets(std::vector<PendingEntityPacket<T>>& pendingPackets);
+			template<typename T> void FlushPendingPackets(std::vector<PendingEntitiesPacket<T>>& pendingPackets);
+			template<typename F> void ForEachCreationEventOrdered(PendingCreationEventMap& creationEvents, F&& func);
 			void HandleEntityCreation(LayerIndex layerIndex, const NetworkSyncSystem::EntityCreation& eventData);
-			void HandleEntityRemove(LayerIndex layerIndex, Ndk::EntityId entityId, bool deathEvent);
+			void HandleEntityRemove(LayerIndex layerIndex, Ndk::EntityId entityId, bool deathEvent, bool recycled);
+			void HandleLostMatchState(SentMatchState& sentState);
+			void PrepareLayerLoading(LayerIndex layerIndex, Layer& layer);
+			template<typename E> void PushCreationEvents(std::vector<E>& packetEntities, Layer& layer, PendingCreationEventMap& pendingCreationMap);
 			template<typename E> void PushLayerEntities(std::vector<E>& packetEntities, LayerIndex layerIndex, PendingCreationEventMap& pendingCreationMap);
+			void ReleaseLayer(std::unique_ptr<Layer> layer);
+			void SendLayerChunk(LayerIndex layerIndex, Layer& layer, Nz::UInt16 networkTick);
 			void SendMatchState();
+			template<typename T> void SendPendingPacket(T& packet);
+			template<typename T> void SendSharedEventPacket(const T& packet);
+			void UpdateInterestArea();
 
 			struct PendingLayerUpdate
 			{
@@ -109,20 +188,17 @@ namespace bw
 				LayerIndex layerIndex;
 			};
 
-			struct PendingMultipleEntities
-			{
-				LayerIndex layerIndex;
-				Nz::Bitset<Nz::UInt64> entitiesId;
-				EntityPacketSendFunction sendFunction;
-			};
-
 			struct Layer
 			{
 				struct VisibleEntityData
 				{
-					Nz::UInt8 priorityAccumulator = 0;
+					Nz::UInt16 baselineTick;
+					Nz::UInt16 lastSentTick; //< last MatchState tick this entity was sent in
+					Nz::UInt32 generation;
+					std::optional<EntityState> baseline; //< last state acknowledged by the client
 				};
 
+				std::size_t prefetchCounter = 0; //< part of visibilityCounter coming from prefetching, the layer is only prefetched while both are equal
 				std::size_t visibilityCounter = 1;
 
 				PendingCreationEventMap creationEvents;
@@ -131,36 +207,54 @@ namespace bw
 				tsl::hopscotch_map<Nz::UInt32 /*entityId*/, NetworkSyncSystem::EntityMovement> staticMovementUpdateEvents;
 				tsl::hopscotch_map<Nz::UInt32 /*entityId*/, NetworkSyncSystem::EntityPlayAnimation> playAnimationEvents;
 				tsl::hopscotch_map<Nz::UInt32 /*entityId*/, NetworkSyncSystem::EntityPhysics> physicsEvents;
+				tsl::hopscotch_map<Nz::UInt32 /*entityId*/, NetworkSyncSystem::EntityCreation> respawnEvents;
 				tsl::hopscotch_map<Nz::UInt32 /*entityId*/, NetworkSyncSystem::EntityScale> scaleEvents;
 				tsl::hopscotch_map<Nz::UInt32 /*entityId*/, NetworkSyncSystem::EntityWeapon> weaponEvents;
-				tsl::hopscotch_map<Nz::UInt32 /*entityId*/, VisibleEntityData> visibleEntities;
 				tsl::hopscotch_set<Nz::UInt32 /*entityId*/> deathEvents;
 				tsl::hopscotch_set<Nz::UInt32 /*entityId*/> destructionEvents;
+				tsl::hopscotch_set<Nz::UInt32 /*entityId*/> recycleEvents;
+				tsl::hopscotch_set<Nz::UInt32 /*entityId*/> recycledEntities; //< entities kept client-side until they get respawned
+				Nz::Bitset<Nz::UInt64> visibleEntityIds; //< entities the client knows about, intersected with NetworkSyncSystem updates
+				std::vector<Packets::MatchState::Entity> matchStateEntities; //< used to group entities by layer when building MatchState
+				std::vector<Nz::UInt32 /*entityId*/> loadingEntities; //< entities left to send before the layer is fully loaded client-side, nearest last
+				std::vector<Nz::UInt8> priorityAccumulators; //< indexed by entity id (only valid for visible entities), apart from VisibleEntityData to keep the per-tick pass compact
+				std::vector<VisibleEntityData> visibleEntities; //< indexed by entity id, only valid for entities in visibleEntityIds
 
 				NazaraSlot(NetworkSyncSystem, OnEntityCreated,         onEntityCreatedSlot);
 				NazaraSlot(NetworkSyncSystem, OnEntityDeath,           onEntityDeath);
 				NazaraSlot(NetworkSyncSystem, OnEntityDeleted,         onEntityDeletedSlot);
 				NazaraSlot(NetworkSyncSystem, OnEntityInvalidated,     onEntityInvalidated);
-				NazaraSlot(NetworkSyncSystem, OnEntityPlayAnimation,   onEntityPlayAnimation);
 				NazaraSlot(NetworkSyncSystem, OnEntitiesHealthUpdate,  onEntitiesHealthUpdate);
 				NazaraSlot(NetworkSyncSystem, OnEntitiesInputUpdate,   onEntitiesInputUpdate);
 				NazaraSlot(NetworkSyncSystem, OnEntitiesPhysicsUpdate, onEntitiesPhysicsUpdate);
+				NazaraSlot(NetworkSyncSystem, OnEntitiesPlayAnimation, onEntitiesPlayAnimation);
 				NazaraSlot(NetworkSyncSystem, OnEntitiesScaleUpdate,   onEntitiesScaleUpdate);
 				NazaraSlot(NetworkSyncSystem, OnEntitiesWeaponUpdate,  onEntitiesWeaponUpdate);
 			};
 
+			inline bool IsEntityControlled(LayerIndex layerIndex, Nz::UInt32 entityId) const;
+			inline void MarkEntityVisible(Layer& layer, Nz::UInt32 entityId);
+
 			Nz::Bitset<Nz::UInt64> m_newlyHiddenLayers;
 			Nz::Bitset<Nz::UInt64> m_newlyVisibleLayers;
 			Nz::Bitset<Nz::UInt64> m_clientVisibleLayers;
 			Nz::Flags<VisibilityEventType> m_pendingEvents;
 			tsl::hopscotch_map<LayerIndex /*layerId*/, std::unique_ptr<Layer>> m_layers;
-			tsl::hopscotch_map<Nz::UInt64 /*layerId|entityId*/, std::vector<EntityPacketSendFunction>> m_pendingEntitiesEvent;
-			tsl::hopscotch_set<Nz::UInt64 /*layerId|entityId*/> m_controlledEntities;
+			std::vector<std::unique_ptr<Layer>> m_layerPool; //< hidden layers, kept with their event containers to reuse them
+			std::vector<CreationOrderNode> m_creationOrderStack;
+			std::vector<Nz::Bitset<Nz::UInt64>> m_controlledEntities; //< indexed by layer index then entity id
 			std::vector<PendingLayerUpdate> m_pendingLayerUpdates;
-			std::vector<PendingMultipleEntities> m_multiplePendingEntitiesEvent;
+			std::vector<MatchStateLayer> m_matchStateLayers;
 			std::vector<PriorityMovementData> m_priorityMovementData;
+			std::vector<PriorityMovementData> m_sortedMovementData; //< counting sort output, swapped with m_priorityMovementData
+			std::vector<NetworkSyncSystem::EntityMovement> m_staticMovementData; //< copied from layers static updates while building MatchState
+			std::vector<SentMatchState> m_sentMatchStates; //< indexed by stateTick, used to retrieve acknowledged states
+			std::vector<Nz::Vector2i> m_interestCells; //< cells of controlled entities on the current layer, used by UpdateInterestArea
+			std::vector<Nz::UInt64> m_sharedPacketKey; //< content of the entity event packet being built, see MatchSessions::AcquireSharedPacket
 			Match& m_match;
 			MatchClientSession& m_session;
+			PendingEntityPacketQueues m_pendingEntityPackets; //< in push order, sent once their entity is visible
+			PendingEntitiesPacketQueues m_pendingEntitiesPackets; //< in push order, sent once all their entities are visible
 
 			Packets::CreateEntities    m_createEntitiesPacket;
 			Packets::DeleteEntities    m_deleteEntitiesPacket;
@@ -168,8 +262,13 @@ namespace bw
 			Packets::EntitiesAnimation m_entitiesAnimationPacket;
 			Packets::EntitiesDeath     m_entitiesDeathPacket;
 			Packets::EntitiesInputs    m_inputUpdatePacket;
+			Packets::EntitiesPhysics   m_physicsUpdatePacket;
+			Packets::RecycleEntities   m_recycleEntitiesPacket;
+			Packets::RespawnEntities   m_respawnEntitiesPacket;
 			Packets::EntitiesScale     m_scaleUpdatePacket;
+			Packets::EntitiesWeapon    m_weaponUpdatePacket;
 			Packets::MatchState        m_matchStatePacket;
+			Nz::UInt32 m_nextEntityGeneration;
 			bool m_ignoreEvents;
 	};
 }
@@ -27,28 +27,39 @@ namespace bw
 	inline MatchClientVisibility::MatchClientVisibility(Match& match, MatchClientSession& session) :
 	m_match(match),
 	m_session(session),
+	m_nextEntityGeneration(0),
 	m_ignoreEvents(false)
 	{
+		m_sentMatchStates.resize(Packets::MatchState::MaxBaselineAge + 1);
 	}
 
 	inline void MatchClientVisibility::ClearLayers()
 	{
-		for (auto&& [layerIndex, layer] : m_layers)
+		for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
 		{
+			LayerIndex layerIndex = it.key();
 			m_newlyVisibleLayers.UnboundedReset(layerIndex);
 
 			if (m_clientVisibleLayers.UnboundedTest(layerIndex))
 				m_newlyHiddenLayers.UnboundedSet(layerIndex);
+
+			ReleaseLayer(std::move(it.value()));
 		}
 
 		m_layers.clear();
 	}
 
-	inline void MatchClientVisibility::HideLayer(LayerIndex layerIndex)
+	inline void MatchClientVisibility::HideLayer(LayerIndex layerIndex, bool prefetch)
 	{
 		auto it = m_layers.find(layerIndex);
 		assert(it != m_layers.end());
 		auto& layer = *it.value();
+		if (prefetch)
+		{
+			assert(layer.prefetchCounter > 0);
+			layer.prefetchCounter--;
+		}
+
 		if (--layer.visibilityCounter > 0)
 			return;
 
@@ -57,6 +68,7 @@ namespace bw
 		if (m_clientVisibleLayers.UnboundedTest(layerIndex))
 			m_newlyHiddenLayers.UnboundedSet(layerIndex);
 
+		ReleaseLayer(std::move(it.value()));
 		m_layers.erase(it);
 	}
 
@@ -65,6 +77,31 @@ namespace bw
 		return m_layers.find(layerIndex) != m_layers.end();
 	}
 
+	inline bool MatchClientVisibility::IsEntityControlled(LayerIndex layerIndex, Nz::UInt32 entityId) const
+	{
+		return layerIndex < m_controlledEntities.size() && m_controlledEntities[layerIndex].UnboundedTest(entityId);
+	}
+
+	inline void MatchClientVisibility::MarkEntityVisible(Layer& layer, Nz::UInt32 entityId)
+	{
+		if (layer.visibleEntityIds.UnboundedTest(entityId))
+			return;
+
+		if (entityId >= layer.visibleEntities.size())
+		{
+			layer.priorityAccumulators.resize(entityId + 1);
+			layer.visibleEntities.resize(entityId + 1);
+		}
+
+		Layer::VisibleEntityData& visibleData = layer.visibleEntities[entityId];
+		visibleData.baseline.reset();
+		visibleData.generation = m_nextEntityGeneration++;
+		visibleData.lastSentTick = m_match.GetNetworkTick() - 0x8000; //< as long ago as possible, for update rate limits
+
+		layer.priorityAccumulators[entityId] = 0;
+		layer.visibleEntityIds.UnboundedSet(entityId);
+	}
+
 	inline void MatchClientVisibility::PushLayerUpdate(Nz::UInt8 localPlayerIndex, LayerIndex layerIndex)
 	{
 		m_pendingLayerUpdates.emplace_back(PendingLayerUpdate{ localPlayerIndex, layerIndex });
@@ -72,11 +109,15 @@ namespace bw
 
 	inline void MatchClientVisibility::SetEntityControlledStatus(LayerIndex layerIndex, Nz::UInt32 entityId, bool isControlled)
 	{
-		Nz::UInt64 entityKey = Nz::UInt64(layerIndex) << 32 | entityId;
-		if (isControlled)
-			m_controlledEntities.insert(entityKey);
-		else
-			m_controlledEntities.erase(entityKey);
+		if (layerIndex >= m_controlledEntities.size())
+		{
+			if (!isControlled)
+				return;
+
+			m_controlledEntities.resize(layerIndex + 1);
+		}
+
+		m_controlledEntities[layerIndex].UnboundedSet(entityId, isControlled);
 	}
 
 	inline void MatchClientVisibility::ShouldIgnoreEvents(bool ignoreEvents)
@@ -87,56 +128,17 @@ namespace bw
 	template<typename T>
 	void MatchClientVisibility::PushEntityPacket(LayerIndex layerIndex, Nz::UInt32 entityId, T&& packet)
 	{
-		Nz::UInt64 entityKey = Nz::UInt64(layerIndex) << 32 | entityId;
+		using Packet = std::decay_t<T>;
 
-		auto it = m_pendingEntitiesEvent.find(entityKey);
-		if (it == m_pendingEntitiesEvent.end())
-			it = m_pendingEntitiesEvent.emplace(entityKey, std::vector<EntityPacketSendFunction>()).first;
-
-		if constexpr (Detail::HasStateTick<T>::value)
-		{
-			it.value().emplace_back([this, packet = std::forward<T>(packet)]() mutable
-			{
-				packet.stateTick = m_match.GetNetworkTick();
-
-				m_session.SendPacket(packet);
-			});
-		}
-		else
-		{
-			it.value().emplace_back([this, packet = std::forward<T>(packet)]() mutable
-			{
-				m_session.SendPacket(packet);
-			});
-		}
+		Nz::UInt64 entityKey = Nz::UInt64(layerIndex) << 32 | entityId;
+		std::get<std::vector<PendingEntityPacket<Packet>>>(m_pendingEntityPackets).push_back(PendingEntityPacket<Packet>{ entityKey, std::forward<T>(packet) });
 	}
 
 	template<typename T>
 	void MatchClientVisibility::PushEntitiesPacket(LayerIndex layerIndex, Nz::Bitset<Nz::UInt64> entitiesId, T&& packet)
 	{
-		if constexpr (Detail::HasStateTick<T>::value)
-		{
-			m_multiplePendingEntitiesEvent.emplace_back(PendingMultipleEntities{
-				layerIndex,
-				std::move(entitiesId),
-				[this, packet = std::forward<T>(packet)]() mutable
-				{
-					packet.stateTick = m_match.GetNetworkTick();
-
-					m_session.SendPacket(packet);
-				}
-			});
-		}
-		else
-		{
-			m_multiplePendingEntitiesEvent.emplace_back(PendingMultipleEntities{
-				layerIndex,
-				std::move(entitiesId),
-				[this, packet = std::forward<T>(packet)]() mutable
-				{
-					m_session.SendPacket(packet);
-				}
-			});
-		}
+		using Packet = std::decay_t<T>;
+
+		std::get<std::vector<PendingEntitiesPacket<Packet>>>(m_pendingEntitiesPackets).push_back(PendingEntitiesPacket<Packet>{ layerIndex, std::move(entitiesId), std::forward<T>(packet) });
 	}
 }
@@ -0,0 +1,58 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_MATCHRECORDER_HPP
+#define BURGWAR_CORELIB_MATCHRECORDER_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Core/ByteArray.hpp>
+#include <Nazara/Core/ByteStream.hpp>
+#include <Nazara/Core/File.hpp>
+#include <Nazara/Network/NetPacket.hpp>
+#include <filesystem>
+
+namespace bw
+{
+	// Writes everything a match receives from its sessions (connections, packets) along with update timings, so it can be replayed offline (see MatchReplay)
+	class BURGWAR_CORELIB_API MatchRecorder
+	{
+		public:
+			enum class EventType : Nz::UInt8
+			{
+				Connection,
+				Disconnection,
+				IncomingPacket,
+				Update
+			};
+
+			MatchRecorder(const std::filesystem::path& filePath, float tickDuration, Nz::UInt32 randomSeed);
+			MatchRecorder(const MatchRecorder&) = delete;
+			MatchRecorder(MatchRecorder&&) = delete;
+			~MatchRecorder();
+
+			void Flush();
+
+			void RecordConnection(std::size_t sessionId);
+			void RecordDisconnection(std::size_t sessionId);
+			void RecordIncomingPacket(std::size_t sessionId, const Nz::NetPacket& packet);
+			void RecordUpdate(float elapsedTime);
+
+			MatchRecorder& operator=(const MatchRecorder&) = delete;
+			MatchRecorder& operator=(MatchRecorder&&) = delete;
+
+			static constexpr Nz::UInt16 FileVersion = 1;
+			static constexpr std::size_t FlushThreshold = 64 * 1024; //< bytes buffered before being written to the file
+
+		private:
+			Nz::ByteArray m_buffer;
+			Nz::ByteStream m_stream;
+			Nz::File m_file;
+	};
+}
+
+#include <CoreLib/MatchRecorder.inl>
+
+#endif
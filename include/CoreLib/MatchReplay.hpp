@@ -0,0 +1,58 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_MATCHREPLAY_HPP
+#define BURGWAR_CORELIB_MATCHREPLAY_HPP
+
+#include <CoreLib/Export.hpp>
+#include <CoreLib/MatchRecorder.hpp>
+#include <Nazara/Core/ByteStream.hpp>
+#include <Nazara/Core/MemoryView.hpp>
+#include <Nazara/Network/NetPacket.hpp>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace bw
+{
+	// Reads back a file written by MatchRecorder, events have to be read in order
+	class BURGWAR_CORELIB_API MatchReplay
+	{
+		public:
+			using EventType = MatchRecorder::EventType;
+
+			MatchReplay(const std::filesystem::path& filePath);
+			MatchReplay(const MatchReplay&) = delete;
+			MatchReplay(MatchReplay&&) = delete;
+			~MatchReplay() = default;
+
+			inline Nz::UInt32 GetRandomSeed() const;
+			inline float GetTickDuration() const;
+
+			std::optional<EventType> PeekEvent();
+
+			std::size_t ReadConnection();
+			std::size_t ReadDisconnection();
+			Nz::NetPacket ReadIncomingPacket(std::size_t* sessionId);
+			float ReadUpdate();
+
+			MatchReplay& operator=(const MatchReplay&) = delete;
+			MatchReplay& operator=(MatchReplay&&) = delete;
+
+		private:
+			void ReadEventType(EventType expectedType);
+
+			std::vector<Nz::UInt8> m_content;
+			Nz::ByteStream m_stream;
+			std::optional<Nz::MemoryView> m_contentView;
+			Nz::UInt32 m_randomSeed;
+			float m_tickDuration;
+	};
+}
+
+#include <CoreLib/MatchReplay.inl>
+
+#endif
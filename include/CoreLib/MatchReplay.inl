@@ -0,0 +1,18 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/MatchReplay.hpp>
+
+namespace bw
+{
+	inline Nz::UInt32 MatchReplay::GetRandomSeed() const
+	{
+		return m_randomSeed;
+	}
+
+	inline float MatchReplay::GetTickDuration() const
+	{
+		return m_tickDuration;
+	}
+}
@@ -12,8 +12,12 @@
 #include <CoreLib/PlayerCommandStore.hpp>
 #include <CoreLib/SessionBridge.hpp>
 #include <CoreLib/SessionManager.hpp>
+#include <CoreLib/SimulatedSessionBridge.hpp>
 #include <Nazara/Core/MemoryPool.hpp>
 #include <tsl/hopscotch_map.h>
+#include <mutex>
+#include <optional>
+#include <string>
 #include <vector>
 
 namespace bw
@@ -28,6 +32,8 @@ namespace bw
 			MatchSessions(Match& match);
 			~MatchSessions();
 
+			template<typename T> SharedPacketRef AcquireSharedPacket(const T& packet, const std::vector<Nz::UInt64>& contentKey, bool allowCompression = true);
+
 			void Clear();
 
 			MatchClientSession* CreateSession(std::shared_ptr<SessionBridge> bridge);
@@ -36,17 +42,46 @@ namespace bw
 
 			template<typename F> void ForEachSession(F&& cb);
 
+			template<typename T> SharedPacketRef BuildSharedPacket(const T& packet, bool allowCompression = true) const;
+
+			std::string FormatNetworkStatistics() const;
+
+			inline const PlayerCommandStore& GetCommandStore() const;
 			inline Match& GetMatch();
 
+			void LogNetworkStatistics();
+
 			void Poll();
 
+			void ReleaseSharedPackets();
+
 		private:
+			struct SharedPacketKey
+			{
+				std::size_t packetId;
+				std::vector<Nz::UInt64> content; //< built by the caller, equal keys must give the same serialized packet
+				bool compressed;
+
+				inline bool operator==(const SharedPacketKey& key) const;
+			};
+
+			struct SharedPacketKeyHasher
+			{
+				std::size_t operator()(const SharedPacketKey& key) const;
+			};
+
+			std::optional<SimulatedSessionBridge::Conditions> m_simulatedConditions;
 			std::size_t m_nextSessionId;
+			CommandStatisticsList m_lastLoggedIncomingStatistics;
+			CommandStatisticsList m_lastLoggedOutgoingStatistics;
 			std::vector<std::unique_ptr<SessionManager>> m_managers;
 			Match& m_match;
 			PlayerCommandStore m_commandStore;
 			Nz::MemoryPool m_sessionPool;
+			std::mutex m_sharedPacketMutex;
+			tsl::hopscotch_map<SharedPacketKey, SharedPacketRef, SharedPacketKeyHasher> m_sharedPackets; //< built during the current sessions update, sessions may update in parallel
 			tsl::hopscotch_map<std::size_t /*sessionId*/, MatchClientSession* /*session*/> m_sessionIdToSession;
+			tsl::hopscotch_map<std::size_t /*sessionId*/, std::shared_ptr<SimulatedSessionBridge>> m_simulatedBridges;
 	};
 }
 
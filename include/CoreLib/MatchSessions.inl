@@ -6,6 +6,43 @@
 
 namespace bw
 {
+	template<typename T>
+	SharedPacketRef MatchSessions::AcquireSharedPacket(const T& packet, const std::vector<Nz::UInt64>& contentKey, bool allowCompression)
+	{
+		const auto& command = m_commandStore.GetOutgoingCommand<T>();
+
+		SharedPacketKey key;
+		key.compressed = command.compress && allowCompression;
+		key.content = contentKey;
+		key.packetId = static_cast<std::size_t>(T::Type);
+
+		{
+			std::lock_guard<std::mutex> lock(m_sharedPacketMutex);
+			if (auto it = m_sharedPackets.find(key); it != m_sharedPackets.end())
+				return it->second;
+		}
+
+		// Serialize outside of the lock so sessions updating in parallel don't wait on each other, the first packet inserted wins
+		SharedPacketRef sharedPacket = BuildSharedPacket(packet, allowCompression);
+
+		std::lock_guard<std::mutex> lock(m_sharedPacketMutex);
+		return m_sharedPackets.emplace(std::move(key), std::move(sharedPacket)).first->second;
+	}
+
+	template<typename T>
+	SharedPacketRef MatchSessions::BuildSharedPacket(const T& packet, bool allowCompression) const
+	{
+		auto sharedPacket = std::make_shared<SharedPacket>();
+		const auto& command = m_commandStore.GetOutgoingCommand<T>();
+		m_commandStore.SerializePacket(sharedPacket->data, packet, command.compress && allowCompression);
+
+		sharedPacket->channelId = command.channelId;
+		sharedPacket->flags = command.flags;
+		sharedPacket->packetId = static_cast<std::size_t>(T::Type);
+
+		return sharedPacket;
+	}
+
 	template<typename T, typename ...Args>
 	T* MatchSessions::CreateSessionManager(Args&&... args)
 	{
@@ -20,8 +57,18 @@ namespace bw
 			cb(pair.second);
 	}
 
+	inline const PlayerCommandStore& MatchSessions::GetCommandStore() const
+	{
+		return m_commandStore;
+	}
+
 	inline Match& MatchSessions::GetMatch()
 	{
 		return m_match;
 	}
+
+	inline bool MatchSessions::SharedPacketKey::operator==(const SharedPacketKey& key) const
+	{
+		return packetId == key.packetId && compressed == key.compressed && content == key.content;
+	}
 }
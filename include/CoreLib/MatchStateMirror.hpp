@@ -0,0 +1,144 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_MATCHSTATEMIRROR_HPP
+#define BURGWAR_CORELIB_MATCHSTATEMIRROR_HPP
+
+#include <CoreLib/Export.hpp>
+#include <CoreLib/Protocol/Packets.hpp>
+#include <CoreLib/Protocol/StateQuantizer.hpp>
+#include <tsl/hopscotch_map.h>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace bw
+{
+	class Logger;
+
+	// Mirror of the match as seen by a client, built from the packets it receives so a full snapshot can be sent again (relay catch-up, demo keyframes)
+	class BURGWAR_CORELIB_API MatchStateMirror
+	{
+		public:
+			using Packet = std::variant<std::monostate,
+				Packets::CreateEntities,
+				Packets::DeleteEntities,
+				Packets::DisableLayer,
+				Packets::EnableLayer,
+				Packets::EntitiesDeath,
+				Packets::EntitiesInputs,
+				Packets::EntitiesPhysics,
+				Packets::EntitiesScale,
+				Packets::EntitiesWeapon,
+				Packets::HealthUpdate,
+				Packets::MapReset,
+				Packets::MatchData,
+				Packets::MatchState,
+				Packets::NetworkStrings,
+				Packets::PlayerControlEntity,
+				Packets::PlayerJoined,
+				Packets::PlayerLeaving,
+				Packets::PlayerNameUpdate,
+				Packets::RecycleEntities,
+				Packets::RespawnEntities,
+				Packets::TickRateUpdate
+			>;
+
+			struct CatchUpPackets;
+
+			MatchStateMirror(const Logger& logger);
+			MatchStateMirror(const MatchStateMirror&) = delete;
+			MatchStateMirror(MatchStateMirror&&) = delete;
+			~MatchStateMirror() = default;
+
+			void BuildCatchUpPackets(CatchUpPackets& packets) const;
+
+			Nz::UInt16 EstimateCurrentTick(Nz::UInt64 now) const;
+
+			inline const Packets::MatchData& GetMatchData() const;
+			inline const std::vector<std::string>& GetNetworkStrings() const;
+
+			void HandlePacket(Packet&& packet, Nz::UInt64 now);
+
+			inline bool HasMatchData() const;
+
+			MatchStateMirror& operator=(const MatchStateMirror&) = delete;
+			MatchStateMirror& operator=(MatchStateMirror&&) = delete;
+
+			struct CatchUpPackets
+			{
+				std::vector<Packets::EnableLayer> enabledLayers;
+				std::vector<Packets::PlayerControlEntity> playerControlledEntities;
+				std::vector<Packets::PlayerJoined> players;
+				Packets::EntitiesPhysics entitiesPhysics;
+				Packets::EntitiesWeapon entitiesWeapon;
+				Packets::RecycleEntities recycledEntities;
+			};
+
+		private:
+			struct Entity
+			{
+				Packets::Helper::EntityData data;
+				std::optional<Packets::EntitiesPhysics::Entity> physics;
+				std::optional<Nz::UInt32> weaponEntityId;
+				bool isRecycled = false;
+			};
+
+			struct Layer
+			{
+				tsl::hopscotch_map<Nz::UInt32, Entity> entities;
+				Nz::UInt32 remainingEntityCount = 0;
+				bool isEnabled = false;
+			};
+
+			struct Player
+			{
+				std::optional<Nz::UInt64> controlledEntityId;
+				std::string name;
+			};
+
+			template<typename T, typename F> void ForEachLayerEntity(const T& packet, F&& func);
+
+			void Apply(std::monostate);
+			void Apply(const Packets::CreateEntities& packet);
+			void Apply(const Packets::DeleteEntities& packet);
+			void Apply(const Packets::DisableLayer& packet);
+			void Apply(const Packets::EnableLayer& packet);
+			void Apply(const Packets::EntitiesDeath& packet);
+			void Apply(const Packets::EntitiesInputs& packet);
+			void Apply(const Packets::EntitiesPhysics& packet);
+			void Apply(const Packets::EntitiesScale& packet);
+			void Apply(const Packets::EntitiesWeapon& packet);
+			void Apply(const Packets::HealthUpdate& packet);
+			void Apply(const Packets::MapReset& packet);
+			void Apply(const Packets::MatchData& packet);
+			void Apply(const Packets::MatchState& packet);
+			void Apply(const Packets::NetworkStrings& packet);
+			void Apply(const Packets::PlayerControlEntity& packet);
+			void Apply(const Packets::PlayerJoined& packet);
+			void Apply(const Packets::PlayerLeaving& packet);
+			void Apply(const Packets::PlayerNameUpdate& packet);
+			void Apply(const Packets::RecycleEntities& packet);
+			void Apply(const Packets::RespawnEntities& packet);
+			void Apply(const Packets::TickRateUpdate& packet);
+
+			Layer* GetLayer(Nz::UInt16 layerIndex);
+
+			std::optional<Packets::MatchData> m_matchData;
+			std::optional<StateQuantizer> m_stateQuantizer;
+			std::vector<Layer> m_layers;
+			std::vector<std::string> m_networkStrings;
+			tsl::hopscotch_map<Nz::UInt16, Player> m_players;
+			const Logger& m_logger;
+			Nz::UInt16 m_lastStateTick;
+			Nz::UInt64 m_lastStateTime;
+	};
+}
+
+#include <CoreLib/MatchStateMirror.inl>
+
+#endif
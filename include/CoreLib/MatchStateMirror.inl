@@ -0,0 +1,49 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/MatchStateMirror.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <cassert>
+
+namespace bw
+{
+	inline const Packets::MatchData& MatchStateMirror::GetMatchData() const
+	{
+		assert(m_matchData);
+		return *m_matchData;
+	}
+
+	inline const std::vector<std::string>& MatchStateMirror::GetNetworkStrings() const
+	{
+		return m_networkStrings;
+	}
+
+	inline bool MatchStateMirror::HasMatchData() const
+	{
+		return m_matchData.has_value();
+	}
+
+	template<typename T, typename F>
+	void MatchStateMirror::ForEachLayerEntity(const T& packet, F&& func)
+	{
+		std::size_t offset = 0;
+		for (const auto& layerData : packet.layers)
+		{
+			std::size_t entityCount = layerData.entityCount;
+			if (offset + entityCount > packet.entities.size())
+			{
+				bwLog(m_logger, LogLevel::Error, "received packet with more entities than it holds");
+				return;
+			}
+
+			if (Layer* layer = GetLayer(layerData.layerIndex))
+			{
+				for (std::size_t i = 0; i < entityCount; ++i)
+					func(*layer, packet.entities[offset + i]);
+			}
+
+			offset += entityCount;
+		}
+	}
+}
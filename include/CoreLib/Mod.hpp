@@ -9,6 +9,7 @@
 
 #include <CoreLib/Export.hpp>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -22,6 +23,7 @@ namespace bw
 	};
 
 	class Logger;
+	class PackFile;
 
 	class BURGWAR_CORELIB_API Mod
 	{
@@ -39,6 +41,7 @@ namespace bw
 			inline const ModInfo& GetInfo() const;
 			inline const std::filesystem::path& GetPath() const;
 			inline const std::string& GetName() const;
+			inline const std::shared_ptr<const PackFile>& GetScriptPack() const;
 			inline const std::vector<Script>& GetScripts() const;
 
 			Mod& operator=(const Mod&) = default;
@@ -62,6 +65,7 @@ namespace bw
 		private:
 			std::filesystem::path m_modDirectory;
 			std::string m_id;
+			std::shared_ptr<const PackFile> m_scriptPack;
 			std::vector<Asset> m_assets;
 			std::vector<Script> m_scripts;
 			ModInfo m_info;
@@ -32,6 +32,11 @@ namespace bw
 		return m_info.name;
 	}
 	
+	inline const std::shared_ptr<const PackFile>& Mod::GetScriptPack() const
+	{
+		return m_scriptPack;
+	}
+
 	inline auto Mod::GetScripts() const -> const std::vector<Script>&
 	{
 		return m_scripts;
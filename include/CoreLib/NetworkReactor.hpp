@@ -8,9 +8,13 @@
 #define BURGWAR_CORELIB_NETWORK_REACTOR_HPP
 
 #include <CoreLib/Export.hpp>
+#include <CoreLib/SharedPacket.hpp>
+#include <CoreLib/TypedPacket.hpp>
 #include <Nazara/Core/Thread.hpp>
 #include <Nazara/Network/ENetHost.hpp>
+#include <Nazara/Network/ENetPacket.hpp>
 #include <concurrentqueue/concurrentqueue.h>
+#include <tsl/hopscotch_map.h>
 #include <atomic>
 #include <functional>
 #include <variant>
@@ -29,9 +33,11 @@ namespace bw
 	{
 		public:
 			struct PeerInfo;
+			using PacketDecoder = std::function<bool(Nz::NetPacket& packet, TypedPacket& typedPacket)>;
 			using PeerInfoCallback = std::function<void(PeerInfo& peerInfo)>;
+			using SerializationJob = std::function<void(Nz::NetPacket& packet)>;
 
-			NetworkReactor(std::size_t firstId, Nz::NetProtocol protocol, Nz::UInt16 port, std::size_t maxClient);
+			NetworkReactor(std::size_t firstId, Nz::NetProtocol protocol, Nz::UInt16 port, std::size_t maxClient, PacketDecoder packetDecoder = {}); //< packets are decoded on the network thread (and polled as typed packets) if a decoder is given
 			NetworkReactor(const NetworkReactor&) = delete;
 			NetworkReactor(NetworkReactor&&) = delete;
 			~NetworkReactor();
@@ -41,12 +47,16 @@ namespace bw
 
 			template<typename ConnectCB, typename DisconnectCB, typename DataCB>
 			void Poll(ConnectCB&& onConnection, DisconnectCB&& onDisconnection, DataCB&& onData);
+			template<typename ConnectCB, typename DisconnectCB, typename DataCB, typename TypedDataCB>
+			void Poll(ConnectCB&& onConnection, DisconnectCB&& onDisconnection, DataCB&& onData, TypedDataCB&& onTypedData);
 
 			inline Nz::NetProtocol GetProtocol() const;
 
 			void QueryInfo(std::size_t peerId, PeerInfoCallback callback);
 
 			void SendData(std::size_t peerId, Nz::UInt8 channelId, Nz::ENetPacketFlags flags, Nz::NetPacket&& packet);
+			void SendDeferredData(std::size_t peerId, Nz::UInt8 channelId, Nz::ENetPacketFlags flags, SerializationJob serializationJob);
+			void SendSharedData(std::size_t peerId, SharedPacketRef packet);
 
 			NetworkReactor& operator=(const NetworkReactor&) = delete;
 			NetworkReactor& operator=(NetworkReactor&&) = delete;
@@ -62,6 +72,7 @@ namespace bw
 				Nz::UInt64 totalByteSent;
 			};
 
+			static constexpr std::size_t EventBulkSize = 64; //< max number of events dequeued at once
 			static constexpr std::size_t InvalidPeerId = std::numeric_limits<std::size_t>::max();
 	
 		private:
@@ -104,8 +115,13 @@ namespace bw
 					PeerInfoCallback callback;
 				};
 
+				struct TypedPacketEvent
+				{
+					TypedPacket packet;
+				};
+
 				std::size_t peerId = InvalidPeerId;
-				std::variant<ConnectEvent, DisconnectEvent, PacketEvent, PeerInfoResponse> data;
+				std::variant<ConnectEvent, DisconnectEvent, PacketEvent, PeerInfoResponse, TypedPacketEvent> data;
 			};
 
 			struct OutgoingEvent
@@ -116,6 +132,13 @@ namespace bw
 					Nz::UInt32 data;
 				};
 
+				struct DeferredPacketEvent
+				{
+					Nz::ENetPacketFlags flags;
+					Nz::UInt8 channelId;
+					SerializationJob serializationJob;
+				};
+
 				struct PacketEvent
 				{
 					Nz::ENetPacketFlags flags;
@@ -128,16 +151,26 @@ namespace bw
 					PeerInfoCallback callback;
 				};
 
+				struct SharedPacketEvent
+				{
+					SharedPacketRef packet;
+				};
+
 				std::size_t peerId = InvalidPeerId;
-				std::variant<DisconnectEvent, PacketEvent, QueryPeerInfo> data;
+				std::variant<DisconnectEvent, DeferredPacketEvent, PacketEvent, QueryPeerInfo, SharedPacketEvent> data;
 			};
 
 			std::atomic_bool m_running;
 			std::size_t m_firstId;
+			PacketDecoder m_packetDecoder; //< only used by the network thread
 			std::vector<Nz::ENetPeer*> m_clients;
+			std::vector<bool> m_probePeers; //< indexed by peer id, server list probes only wait to be disconnected, only used by the network thread
 			moodycamel::ConcurrentQueue<ConnectionRequest> m_connectionRequests;
 			moodycamel::ConcurrentQueue<IncomingEvent> m_incomingQueue;
 			moodycamel::ConcurrentQueue<OutgoingEvent> m_outgoingQueue;
+			std::vector<IncomingEvent> m_incomingEvents; //< only used by the polling thread
+			std::vector<OutgoingEvent> m_outgoingEvents; //< only used by the network thread
+			tsl::hopscotch_map<const SharedPacket*, std::pair<SharedPacketRef, Nz::ENetPacketRef>> m_sharedPackets; //< only used by the network thread
 			Nz::ENetHost m_host;
 			Nz::NetProtocol m_protocol;
 			Nz::Thread m_thread;
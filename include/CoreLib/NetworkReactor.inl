@@ -4,38 +4,61 @@
 
 #include <CoreLib/NetworkReactor.hpp>
 #include <CoreLib/Utils.hpp>
+#include <cassert>
 
 namespace bw
 {
 	template<typename ConnectCB, typename DisconnectCB, typename DataCB>
 	void NetworkReactor::Poll(ConnectCB&& onConnection, DisconnectCB&& onDisconnection, DataCB&& onData)
 	{
-		IncomingEvent inEvent;
-		while (m_incomingQueue.try_dequeue(inEvent))
+		assert(!m_packetDecoder);
+
+		Poll(std::forward<ConnectCB>(onConnection), std::forward<DisconnectCB>(onDisconnection), std::forward<DataCB>(onData), [](std::size_t /*peerId*/, TypedPacket&& /*packet*/) {});
+	}
+
+	template<typename ConnectCB, typename DisconnectCB, typename DataCB, typename TypedDataCB>
+	void NetworkReactor::Poll(ConnectCB&& onConnection, DisconnectCB&& onDisconnection, DataCB&& onData, TypedDataCB&& onTypedData)
+	{
+		std::size_t eventCount;
+		while ((eventCount = m_incomingQueue.try_dequeue_bulk(m_incomingEvents.begin(), m_incomingEvents.size())) > 0)
 		{
-			std::visit([&](auto&& arg)
+			for (std::size_t i = 0; i < eventCount; ++i)
 			{
-				using T = std::decay_t<decltype(arg)>;
-				if constexpr (std::is_same_v<T, IncomingEvent::ConnectEvent>)
-				{
-					onConnection(arg.outgoingConnection, inEvent.peerId, arg.data);
-				}
-				else if constexpr (std::is_same_v<T, IncomingEvent::DisconnectEvent>)
+				IncomingEvent& inEvent = m_incomingEvents[i];
+				std::visit([&](auto&& arg)
 				{
-					onDisconnection(inEvent.peerId, arg.data);
-				}
-				else if constexpr (std::is_same_v<T, IncomingEvent::PacketEvent>)
-				{
-					onData(inEvent.peerId, std::move(arg.packet));
-				}
-				else if constexpr (std::is_same_v<T, IncomingEvent::PeerInfoResponse>)
-				{
-					arg.callback(arg.peerInfo);
-				}
-				else
-					static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
+					using T = std::decay_t<decltype(arg)>;
+					if constexpr (std::is_same_v<T, IncomingEvent::ConnectEvent>)
+					{
+						onConnection(arg.outgoingConnection, inEvent.peerId, arg.data);
+					}
+					else if constexpr (std::is_same_v<T, IncomingEvent::DisconnectEvent>)
+					{
+						onDisconnection(inEvent.peerId, arg.data);
+					}
+					else if constexpr (std::is_same_v<T, IncomingEvent::PacketEvent>)
+					{
+						onData(inEvent.peerId, std::move(arg.packet));
+					}
+					else if constexpr (std::is_same_v<T, IncomingEvent::PeerInfoResponse>)
+					{
+						arg.callback(arg.peerInfo);
+					}
+					else if constexpr (std::is_same_v<T, IncomingEvent::TypedPacketEvent>)
+					{
+						onTypedData(inEvent.peerId, std::move(arg.packet));
+					}
+					else
+						static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
+
+				}, inEvent.data);
+
+				// Release packet memory and callbacks now instead of keeping them until the next poll
+				inEvent.data = IncomingEvent::DisconnectEvent{};
+			}
 
-			}, inEvent.data);
+			if (eventCount < m_incomingEvents.size())
+				break;
 		}
 	}
 
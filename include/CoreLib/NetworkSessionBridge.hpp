@@ -28,7 +28,9 @@ namespace bw
 
 			void QueryInfo(std::function<void(const SessionInfo& info)> callback) const override;
 
+			void SendDeferredPacket(Nz::UInt8 channelId, Nz::ENetPacketFlags flags, SerializationJob serializationJob) override;
 			void SendPacket(Nz::UInt8 channelId, Nz::ENetPacketFlags flags, Nz::NetPacket&& packet) override;
+			void SendSharedPacket(const SharedPacketRef& packet) override;
 
 		private:
 			std::size_t m_peerId;
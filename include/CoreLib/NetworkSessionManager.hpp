@@ -11,17 +11,19 @@
 #include <CoreLib/NetworkReactor.hpp>
 #include <CoreLib/SessionManager.hpp>
 #include <Nazara/Core/MemoryPool.hpp>
+#include <memory>
 #include <vector>
 
 namespace bw
 {
 	class MatchClientSession;
 	class MatchSessions;
+	class NetworkSessionBridge;
 
 	class BURGWAR_CORELIB_API NetworkSessionManager : public SessionManager
 	{
 		public:
-			NetworkSessionManager(MatchSessions* owner, Nz::UInt16 port, std::size_t maxClient);
+			NetworkSessionManager(MatchSessions* owner, Nz::UInt16 port, std::size_t maxClient, std::size_t reactorCount = 1);
 			~NetworkSessionManager();
 
 			void Poll() override;
@@ -31,8 +33,18 @@ namespace bw
 			void HandlePeerDisconnection(std::size_t peerId, Nz::UInt32 data);
 			void HandlePeerPacket(std::size_t peerId, Nz::NetPacket&& packet);
 
-			std::vector<MatchClientSession*> m_peerIdToSession;
-			NetworkReactor m_reactor;
+			inline std::size_t GetReactorIndex(std::size_t peerId) const;
+
+			struct Peer
+			{
+				std::shared_ptr<NetworkSessionBridge> bridge;
+				MatchClientSession* session = nullptr;
+			};
+
+			std::size_t m_maxClientPerReactor;
+			std::vector<Peer> m_peers;
+			std::vector<std::size_t> m_reactorSessionCount;
+			std::vector<std::unique_ptr<NetworkReactor>> m_reactors;
 	};
 }
 
@@ -3,3 +3,11 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/NetworkSessionManager.hpp>
+
+namespace bw
+{
+	inline std::size_t NetworkSessionManager::GetReactorIndex(std::size_t peerId) const
+	{
+		return peerId / m_maxClientPerReactor;
+	}
+}
@@ -0,0 +1,93 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_PACKFILE_HPP
+#define BURGWAR_CORELIB_PACKFILE_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bw
+{
+	class MemoryMappedFile;
+
+	// Archive of files sharing a single sorted index, contents are aligned and (optionally) compressed to be read straight from a memory mapping
+	class BURGWAR_CORELIB_API PackFile
+	{
+		public:
+			enum class Compression : Nz::UInt8;
+			struct Entry;
+			struct SourceFile;
+
+			static constexpr std::size_t BlobAlignment = 16;
+			static constexpr Nz::UInt16 FileVersion = 1;
+			static constexpr std::size_t MaxUncompressedSize = 256 * 1024 * 1024;
+
+			PackFile(const std::filesystem::path& packFile);
+			PackFile(const PackFile&) = delete;
+			PackFile(PackFile&&) noexcept = default;
+			~PackFile() = default;
+
+			inline const Entry* FindEntry(const std::string_view& path) const;
+			// Calls cb(name, entry) for files and directories (with a null entry) directly inside directoryPrefix, which is empty or ends with a slash
+			template<typename F> void ForeachChild(const std::string_view& directoryPrefix, F&& cb) const;
+
+			inline const Entry& GetEntry(std::size_t entryIndex) const;
+			inline std::size_t GetEntryCount() const;
+			inline const std::shared_ptr<const MemoryMappedFile>& GetMapping() const;
+
+			bool HasDirectory(const std::string_view& directoryPrefix) const;
+
+			const Nz::UInt8* ReadEntry(const Entry& entry, std::vector<Nz::UInt8>& buffer) const;
+
+			PackFile& operator=(const PackFile&) = delete;
+			PackFile& operator=(PackFile&&) noexcept = default;
+
+			static bool Build(const std::filesystem::path& outputPath, std::vector<SourceFile> files, bool compressFiles = true);
+
+			enum class Compression : Nz::UInt8
+			{
+				None = 0,
+				LZ4 = 1
+			};
+
+			struct Entry
+			{
+				std::array<Nz::UInt8, 4> checksum; //< CRC32 of stored bytes
+				std::string path; //< using slashes as separators
+				Compression compression = Compression::None;
+				Nz::UInt64 offset = 0; //< from the (aligned) end of the index
+				Nz::UInt64 size = 0; //< stored size
+				Nz::UInt64 uncompressedSize = 0;
+			};
+
+			struct SourceFile
+			{
+				std::string path;
+				std::filesystem::path physicalPath;
+			};
+
+		private:
+			std::vector<Entry>::const_iterator LowerBound(const std::string_view& path) const;
+
+			std::shared_ptr<const MemoryMappedFile> m_mapping;
+			std::vector<Entry> m_entries; //< sorted by path
+			std::vector<Nz::UInt8> m_content; //< whole file content, when it couldn't be mapped
+			const Nz::UInt8* m_data;
+			std::size_t m_contentOffset;
+			std::size_t m_size;
+	};
+}
+
+#include <CoreLib/PackFile.inl>
+
+#endif
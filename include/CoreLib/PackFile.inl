@@ -0,0 +1,60 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/PackFile.hpp>
+#include <cassert>
+
+namespace bw
+{
+	inline auto PackFile::FindEntry(const std::string_view& path) const -> const Entry*
+	{
+		auto it = LowerBound(path);
+		if (it == m_entries.end() || it->path != path)
+			return nullptr;
+
+		return &*it;
+	}
+
+	template<typename F>
+	void PackFile::ForeachChild(const std::string_view& directoryPrefix, F&& cb) const
+	{
+		std::string_view lastDirectory;
+		for (auto it = LowerBound(directoryPrefix); it != m_entries.end(); ++it)
+		{
+			std::string_view path = it->path;
+			if (path.compare(0, directoryPrefix.size(), directoryPrefix) != 0)
+				break;
+
+			std::string_view name = path.substr(directoryPrefix.size());
+			if (std::size_t separatorPos = name.find('/'); separatorPos != name.npos)
+			{
+				// Files of a directory are contiguous as they share the same prefix
+				name = name.substr(0, separatorPos);
+				if (name == lastDirectory)
+					continue;
+
+				lastDirectory = name;
+				cb(name, static_cast<const Entry*>(nullptr));
+			}
+			else
+				cb(name, &*it);
+		}
+	}
+
+	inline auto PackFile::GetEntry(std::size_t entryIndex) const -> const Entry&
+	{
+		assert(entryIndex < m_entries.size());
+		return m_entries[entryIndex];
+	}
+
+	inline std::size_t PackFile::GetEntryCount() const
+	{
+		return m_entries.size();
+	}
+
+	inline const std::shared_ptr<const MemoryMappedFile>& PackFile::GetMapping() const
+	{
+		return m_mapping;
+	}
+}
@@ -34,7 +34,7 @@ namespace bw
 		friend Match;
 
 		public:
-			Player(Match& match, MatchClientSession& session, std::size_t playerIndex, Nz::UInt8 localIndex, std::string name);
+			Player(Match& match, MatchClientSession& session, std::size_t playerIndex, Nz::UInt8 localIndex, std::string name, std::string reconnectToken);
 			Player(const Player&) = delete;
 			Player(Player&&) noexcept = default;
 			~Player();
@@ -46,6 +46,7 @@ namespace bw
 			inline Match& GetMatch() const;
 			inline const std::string& GetName() const;
 			inline std::size_t GetPlayerIndex() const;
+			inline const std::string& GetReconnectToken() const;
 			inline MatchClientSession& GetSession();
 			inline const MatchClientSession& GetSession() const;
 
@@ -79,6 +80,7 @@ namespace bw
 		private:
 			void OnDeath(const Ndk::EntityHandle& attacker);
 			void SetReady();
+			void UpdatePrefetchedLayers();
 
 			NazaraSlot(Ndk::Entity, OnEntityDestruction, m_onPlayerEntityDestruction);
 			NazaraSlot(HealthComponent, OnDied, m_onPlayerEntityDied);
@@ -89,7 +91,9 @@ namespace bw
 			LayerIndex m_layerIndex;
 			std::size_t m_playerIndex;
 			std::string m_name;
+			std::string m_reconnectToken; //< lets the client take this player back after the match moved to another process (see MatchCheckpoint)
 			Ndk::EntityOwner m_playerEntity;
+			Nz::Bitset<Nz::UInt64> m_prefetchedLayers; //< layers adjacent to the current one (see Terrain::SetAdjacentLayers)
 			Nz::Bitset<Nz::UInt64> m_visibleLayers;
 			Nz::UInt8 m_localIndex;
 			Match& m_match;
@@ -41,6 +41,11 @@ namespace bw
 		return m_playerIndex;
 	}
 
+	inline const std::string& Player::GetReconnectToken() const
+	{
+		return m_reconnectToken;
+	}
+
 	inline MatchClientSession& Player::GetSession()
 	{
 		return m_session;
@@ -7,6 +7,7 @@
 #ifndef BURGWAR_CORELIB_PLAYERINPUTDATA_HPP
 #define BURGWAR_CORELIB_PLAYERINPUTDATA_HPP
 
+#include <Nazara/Prerequisites.hpp>
 #include <Nazara/Math/Vector2.hpp>
 
 namespace bw
@@ -21,8 +22,15 @@ namespace bw
 		bool isMovingLeft = false;
 		bool isMovingRight = false;
 
-		inline bool operator==(const PlayerInputData& rhs);
-		inline bool operator!=(const PlayerInputData& rhs);
+		inline void DecodeAimDirection(Nz::UInt16 aimAngle);
+		inline Nz::UInt16 EncodeAimDirection() const;
+
+		inline void QuantizeAimDirection(); //< rounds aim direction to the precision it is sent with
+
+		inline bool operator==(const PlayerInputData& rhs) const;
+		inline bool operator!=(const PlayerInputData& rhs) const;
+
+		static constexpr std::size_t AimAngleBits = 12; //< aim direction is sent as an angle
 	};
 }
 
@@ -3,10 +3,39 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/PlayerInputData.hpp>
+#include <Nazara/Math/Algorithm.hpp>
+#include <cmath>
 
 namespace bw
 {
-	inline bool PlayerInputData::operator==(const PlayerInputData& rhs)
+	inline void PlayerInputData::DecodeAimDirection(Nz::UInt16 aimAngle)
+	{
+		constexpr float AngleStep = 2.f * float(M_PI) / (1 << AimAngleBits);
+
+		float angle = aimAngle * AngleStep;
+		aimDirection = Nz::Vector2f(std::cos(angle), std::sin(angle));
+	}
+
+	inline Nz::UInt16 PlayerInputData::EncodeAimDirection() const
+	{
+		constexpr std::size_t AngleCount = 1 << AimAngleBits;
+
+		float angle = std::atan2(aimDirection.y, aimDirection.x);
+		if (!std::isfinite(angle))
+			return 0;
+
+		if (angle < 0.f)
+			angle += 2.f * float(M_PI);
+
+		return static_cast<Nz::UInt16>(static_cast<std::size_t>(std::lround(angle * AngleCount / (2.f * float(M_PI)))) % AngleCount);
+	}
+
+	inline void PlayerInputData::QuantizeAimDirection()
+	{
+		DecodeAimDirection(EncodeAimDirection());
+	}
+
+	inline bool PlayerInputData::operator==(const PlayerInputData& rhs) const
 	{
 		return aimDirection == rhs.aimDirection && 
 		       isAttacking == rhs.isAttacking && 
@@ -17,7 +46,7 @@ namespace bw
 		       isMovingRight == rhs.isMovingRight;
 	}
 
-	inline bool PlayerInputData::operator!=(const PlayerInputData& rhs)
+	inline bool PlayerInputData::operator!=(const PlayerInputData& rhs) const
 	{
 		return !operator==(rhs);
 	}
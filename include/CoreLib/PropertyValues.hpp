@@ -10,6 +10,7 @@
 #include <CoreLib/EntityId.hpp>
 #include <CoreLib/Export.hpp>
 #include <CoreLib/LayerIndex.hpp>
+#include <CoreLib/Utils.hpp>
 #include <Nazara/Prerequisites.hpp>
 #include <Nazara/Math/Rect.hpp>
 #include <Nazara/Math/Vector2.hpp>
@@ -53,6 +54,7 @@ namespace bw
 		static constexpr PropertyType Property = P;
 	};
 
+	// Elements are shared between copies until one of them is modified (any non-const access), so big arrays (tilemaps) are cheap to pass around
 	template<PropertyType P>
 	class PropertyArrayValue
 	{
@@ -61,14 +63,18 @@ namespace bw
 			using UnderlyingType = PropertyUnderlyingType_t<Property>;
 
 			explicit PropertyArrayValue(std::size_t elementCount);
-			PropertyArrayValue(const PropertyArrayValue&);
+			PropertyArrayValue(const PropertyArrayValue&) = default;
 			PropertyArrayValue(PropertyArrayValue&&) noexcept = default;
 			~PropertyArrayValue() = default;
 
+			UnderlyingType* GetData();
+			const UnderlyingType* GetData() const;
 			UnderlyingType& GetElement(std::size_t i);
 			const UnderlyingType& GetElement(std::size_t i) const;
 			std::size_t GetSize() const;
 
+			bool IsShared() const;
+
 			UnderlyingType& operator[](std::size_t i);
 			const UnderlyingType& operator[](std::size_t i) const;
 
@@ -79,12 +85,16 @@ namespace bw
 			const UnderlyingType* end() const;
 			std::size_t size() const;
 
-			PropertyArrayValue& operator=(const PropertyArrayValue&);
+			PropertyArrayValue& operator=(const PropertyArrayValue&) = default;
 			PropertyArrayValue& operator=(PropertyArrayValue&&) noexcept = default;
 
+			static constexpr bool IsRawSerializable = IsRawSerializable_v<UnderlyingType>;
+
 		private:
+			void Detach();
+
 			std::size_t m_size;
-			std::unique_ptr<UnderlyingType[]> m_arrayData;
+			std::shared_ptr<UnderlyingType[]> m_arrayData;
 	};
 
 	template<PropertyType P>
@@ -127,6 +137,9 @@ namespace bw
 	BURGWAR_CORELIB_API PropertyValue TranslatePropertyFromLua(SharedMatch* match, const sol::object& value, PropertyType expectedType, bool isArray);
 	BURGWAR_CORELIB_API sol::object TranslatePropertyToLua(SharedMatch* match, sol::state_view& lua, const PropertyValue& property);
 
+	template<PropertyType P> void ReadPropertyArray(Nz::ByteStream& stream, PropertyArrayValue<P>& array);
+	template<PropertyType P> void WritePropertyArray(Nz::ByteStream& stream, const PropertyArrayValue<P>& array);
+
 	template<typename T> Nz::Vector4<T> TranslateRectToVec(const Nz::Rect<T>& value);
 	template<typename T> Nz::Rect<T> TranslateVecToRect(const Nz::Vector4<T>& value);
 }
@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/PropertyValues.hpp>
+#include <algorithm>
 #include <cassert>
 
 namespace bw
@@ -34,22 +35,29 @@ namespace bw
 
 	template<PropertyType P>
 	PropertyArrayValue<P>::PropertyArrayValue(std::size_t elementCount) :
-	m_size(elementCount)
+	m_size(elementCount),
+	m_arrayData(new UnderlyingType[elementCount]())
 	{
-		m_arrayData = std::make_unique<UnderlyingType[]>(m_size);
 	}
 
 	template<PropertyType P>
-	PropertyArrayValue<P>::PropertyArrayValue(const PropertyArrayValue& container)
+	auto PropertyArrayValue<P>::GetData() -> UnderlyingType*
 	{
-		*this = container;
+		Detach();
+		return m_arrayData.get();
+	}
+
+	template<PropertyType P>
+	auto PropertyArrayValue<P>::GetData() const -> const UnderlyingType*
+	{
+		return m_arrayData.get();
 	}
 
 	template<PropertyType P>
 	auto PropertyArrayValue<P>::GetElement(std::size_t i) -> UnderlyingType&
 	{
 		assert(i < m_size);
-		return m_arrayData[i];
+		return GetData()[i];
 	}
 
 	template<PropertyType P>
@@ -65,6 +73,12 @@ namespace bw
 		return m_size;
 	}
 
+	template<PropertyType P>
+	bool PropertyArrayValue<P>::IsShared() const
+	{
+		return m_arrayData.use_count() > 1;
+	}
+
 	template<PropertyType P>
 	auto PropertyArrayValue<P>::operator[](std::size_t i) -> UnderlyingType&
 	{
@@ -80,25 +94,25 @@ namespace bw
 	template<PropertyType P>
 	auto PropertyArrayValue<P>::begin() -> UnderlyingType*
 	{
-		return &m_arrayData[0];
+		return GetData();
 	}
 
 	template<PropertyType P>
 	auto PropertyArrayValue<P>::begin() const -> const UnderlyingType*
 	{
-		return &m_arrayData[0];
+		return GetData();
 	}
 
 	template<PropertyType P>
 	auto PropertyArrayValue<P>::end() -> UnderlyingType*
 	{
-		return &m_arrayData[m_size];
+		return GetData() + m_size;
 	}
 
 	template<PropertyType P>
 	auto PropertyArrayValue<P>::end() const -> const UnderlyingType*
 	{
-		return &m_arrayData[m_size];
+		return GetData() + m_size;
 	}
 
 	template<PropertyType P>
@@ -108,16 +122,15 @@ namespace bw
 	}
 
 	template<PropertyType P>
-	PropertyArrayValue<P>& PropertyArrayValue<P>::operator=(const PropertyArrayValue& container)
+	void PropertyArrayValue<P>::Detach()
 	{
-		if (this == &container)
-			return *this;
+		if (!IsShared())
+			return;
 
-		m_size = container.m_size;
-		m_arrayData = std::make_unique<UnderlyingType[]>(m_size);
-		std::copy(container.m_arrayData.get(), container.m_arrayData.get() + m_size, m_arrayData.get());
+		std::shared_ptr<UnderlyingType[]> arrayData(new UnderlyingType[m_size]);
+		std::copy(m_arrayData.get(), m_arrayData.get() + m_size, arrayData.get());
 
-		return *this;
+		m_arrayData = std::move(arrayData);
 	}
 
 
@@ -152,6 +165,30 @@ namespace bw
 	}
 
 
+	template<PropertyType P>
+	void ReadPropertyArray(Nz::ByteStream& stream, PropertyArrayValue<P>& array)
+	{
+		if constexpr (PropertyArrayValue<P>::IsRawSerializable)
+			ReadRawArray(stream, array.GetData(), array.GetSize());
+		else
+		{
+			for (auto& element : array)
+				stream >> element;
+		}
+	}
+
+	template<PropertyType P>
+	void WritePropertyArray(Nz::ByteStream& stream, const PropertyArrayValue<P>& array)
+	{
+		if constexpr (PropertyArrayValue<P>::IsRawSerializable)
+			WriteRawArray(stream, array.GetData(), array.GetSize());
+		else
+		{
+			for (const auto& element : array)
+				stream << element;
+		}
+	}
+
 	template<typename T>
 	Nz::Vector4<T> TranslateRectToVec(const Nz::Rect<T>& value)
 	{
@@ -7,7 +7,10 @@
 #ifndef BURGWAR_CORELIB_NETWORK_COMPRESSEDINTEGER_HPP
 #define BURGWAR_CORELIB_NETWORK_COMPRESSEDINTEGER_HPP
 
+#include <Nazara/Prerequisites.hpp>
 #include <Nazara/Core/Algorithm.hpp>
+#include <climits>
+#include <cstddef>
 #include <type_traits>
 
 namespace bw
@@ -55,6 +58,10 @@ namespace bw
 		private:
 			T m_value;
 	};
+
+	// Decode a compressed integer from a contiguous buffer, returns the number of bytes consumed or zero if data is truncated or invalid
+	template<typename T> std::size_t DecodeCompressedSigned(const Nz::UInt8* data, std::size_t size, T& value);
+	template<typename T> std::size_t DecodeCompressedUnsigned(const Nz::UInt8* data, std::size_t size, T& value);
 }
 
 namespace Nz
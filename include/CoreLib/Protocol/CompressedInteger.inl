@@ -104,6 +104,58 @@ namespace bw
 		m_value--;
 		return copy;
 	}
+
+	template<typename T>
+	std::size_t DecodeCompressedSigned(const Nz::UInt8* data, std::size_t size, T& value)
+	{
+		static_assert(std::is_signed_v<T>);
+		using UnsignedT = std::make_unsigned_t<T>;
+
+		UnsignedT unsignedValue;
+		std::size_t byteCount = DecodeCompressedUnsigned(data, size, unsignedValue);
+		if (byteCount == 0)
+			return 0;
+
+		// ZigZag decoding (branchless form)
+		unsignedValue = (unsignedValue >> 1) ^ (UnsignedT(0) - (unsignedValue & 1));
+
+		value = reinterpret_cast<T&>(unsignedValue);
+		return byteCount;
+	}
+
+	template<typename T>
+	std::size_t DecodeCompressedUnsigned(const Nz::UInt8* data, std::size_t size, T& value)
+	{
+		static_assert(std::is_unsigned_v<T>);
+
+		constexpr std::size_t MaxByteCount = (CHAR_BIT * sizeof(T) + 6) / 7;
+
+		// Most values (sizes, counts, small ids) fit in a single byte
+		if (size > 0 && (data[0] & 0x80) == 0)
+		{
+			value = data[0];
+			return 1;
+		}
+
+		// Never read more bytes than T can hold, this bounds the loop and rejects overlong encodings
+		std::size_t byteCount = (size < MaxByteCount) ? size : MaxByteCount;
+
+		T integerValue = 0;
+		for (std::size_t i = 0; i < byteCount; ++i)
+		{
+			Nz::UInt8 byteValue = data[i];
+			integerValue |= T(byteValue & 0x7F) << (7 * i);
+
+			if ((byteValue & 0x80) == 0)
+			{
+				value = integerValue;
+				return i + 1;
+			}
+		}
+
+		// Truncated data or too many bytes for T
+		return 0;
+	}
 }
 
 namespace Nz
@@ -0,0 +1,26 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_NETWORK_PACKETCOMPRESSION_HPP
+#define BURGWAR_CORELIB_NETWORK_PACKETCOMPRESSION_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <vector>
+
+namespace bw
+{
+	constexpr std::size_t PacketCompressionThreshold = 512; //< smaller payloads are never compressed
+	constexpr std::size_t PacketMaxUncompressedSize = 32 * 1024 * 1024;
+	constexpr std::size_t PacketMaxServerBoundUncompressedSize = 64 * 1024; //< clients only send small packets (inputs, chat, script packets)
+	constexpr std::size_t PacketMaxCompressionRatio = 255; //< LZ4 can't expand data more than this (plus a few bytes)
+
+	// Returns false if compression failed or wouldn't make the payload smaller (payload should be sent as-is)
+	BURGWAR_CORELIB_API bool CompressPacketPayload(const Nz::UInt8* data, std::size_t size, std::vector<Nz::UInt8>& compressedData);
+	BURGWAR_CORELIB_API bool DecompressPacketPayload(const Nz::UInt8* data, std::size_t size, std::size_t uncompressedSize, std::vector<Nz::UInt8>& uncompressedData);
+}
+
+#endif
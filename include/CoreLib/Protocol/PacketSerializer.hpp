@@ -8,23 +8,38 @@
 #define BURGWAR_CORELIB_NETWORK_PACKETSERIALIZER_HPP
 
 #include <CoreLib/Export.hpp>
+#include <CoreLib/Protocol/CompressedInteger.hpp>
 #include <Nazara/Core/ByteStream.hpp>
+#include <Nazara/Network/NetPacket.hpp>
+#include <type_traits>
 #include <vector>
 
 namespace bw
 {
+	// Booleans (and bit-packed enums) are packed into bit bytes which are interleaved with regular data:
+	// a new bit byte is reserved in the stream when the previous one is full, regardless of what has been serialized since
 	class BURGWAR_CORELIB_API PacketSerializer
 	{
 		public:
 			inline PacketSerializer(Nz::ByteStream& packetBuffer, bool isWriting);
+			inline PacketSerializer(Nz::NetPacket& packet, bool isWriting);
 			~PacketSerializer() = default;
 
 			inline void Read(void* ptr, std::size_t size);
+			template<typename T> void ReadArray(T* data, std::size_t count); //< bulk read of IsRawSerializable types
+			inline Nz::UInt32 ReadBits(std::size_t bitCount);
 
+			inline bool IsAtEnd() const; //< no more data to read, for fields appended to a packet in a later version
 			inline bool IsWriting() const;
 
 			inline void Write(const void* ptr, std::size_t size);
+			template<typename T> void WriteArray(const T* data, std::size_t count); //< bulk write of IsRawSerializable types
+			inline void WriteBits(Nz::UInt32 value, std::size_t bitCount);
 
+			inline void Serialize(bool& value);
+			void Serialize(const bool& value) const = delete; //< bits cannot be packed from a const serializer
+			template<typename T> void Serialize(CompressedSigned<T>& value);
+			template<typename T> void Serialize(CompressedUnsigned<T>& value);
 			template<typename DataType> void Serialize(DataType& data);
 			template<typename DataType> void Serialize(std::vector<DataType>& dataVec);
 			template<typename DataType> void Serialize(const DataType& data) const;
@@ -35,12 +50,20 @@ namespace bw
 			template<typename T> void SerializeArraySize(const T& array);
 
 			template<typename E, typename UT = std::underlying_type_t<E>> void SerializeEnum(E& enumValue);
+			template<typename E> void SerializeEnum(E& enumValue, E maxValue); //< packed using as many bits as maxValue requires
 
 			template<typename DataType> void operator&=(DataType& data);
 			template<typename DataType> void operator&=(const DataType& data) const;
 
 		private:
+			inline void UpdateBitByte();
+
 			Nz::ByteStream& m_buffer;
+			const Nz::UInt8* m_readData; //< packet memory, when available compressed integers are decoded from it directly
+			std::size_t m_readSize;
+			Nz::UInt64 m_bitByteOffset;
+			Nz::UInt8 m_bitByte;
+			std::size_t m_bitPos;
 			bool m_isWriting;
 	};
 }
@@ -3,7 +3,8 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/Protocol/PacketSerializer.hpp>
-#include <CoreLib/Protocol/CompressedInteger.hpp>
+#include <CoreLib/Utils.hpp>
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 
@@ -11,16 +12,71 @@ namespace bw
 {
 	inline PacketSerializer::PacketSerializer(Nz::ByteStream& packetBuffer, bool isWriting) :
 	m_buffer(packetBuffer),
+	m_readData(nullptr),
+	m_readSize(0),
+	m_bitByteOffset(0),
+	m_bitByte(0),
+	m_bitPos(8),
 	m_isWriting(isWriting)
 	{
 	}
 
+	inline PacketSerializer::PacketSerializer(Nz::NetPacket& packet, bool isWriting) :
+	PacketSerializer(static_cast<Nz::ByteStream&>(packet), isWriting)
+	{
+		if (!isWriting)
+		{
+			// Packet cursor is relative to the beginning of the packet memory (header included)
+			m_readData = static_cast<const Nz::UInt8*>(packet.GetConstData());
+			m_readSize = Nz::NetPacket::HeaderSize + packet.GetDataSize();
+		}
+	}
+
 	inline void PacketSerializer::Read(void* ptr, std::size_t size)
 	{
 		if (m_buffer.Read(ptr, size) != size)
 			throw std::runtime_error("failed to read");
 	}
 
+	template<typename T>
+	void PacketSerializer::ReadArray(T* data, std::size_t count)
+	{
+		assert(!IsWriting());
+		ReadRawArray(m_buffer, data, count);
+	}
+
+	inline Nz::UInt32 PacketSerializer::ReadBits(std::size_t bitCount)
+	{
+		assert(!IsWriting());
+		assert(bitCount <= 32);
+
+		Nz::UInt32 value = 0;
+		std::size_t offset = 0;
+		while (offset < bitCount)
+		{
+			if (m_bitPos == 8)
+			{
+				Read(&m_bitByte, 1);
+				m_bitPos = 0;
+			}
+
+			std::size_t count = std::min(bitCount - offset, 8 - m_bitPos);
+			Nz::UInt32 bits = (m_bitByte >> m_bitPos) & ((1U << count) - 1);
+
+			value |= bits << offset;
+			offset += count;
+			m_bitPos += count;
+		}
+
+		return value;
+	}
+
+	inline bool PacketSerializer::IsAtEnd() const
+	{
+		assert(!IsWriting());
+		return m_buffer.EndOfStream();
+	}
+
 	inline bool PacketSerializer::IsWriting() const
 	{
 		return m_isWriting;
@@ -32,6 +88,99 @@ namespace bw
 			throw std::runtime_error("failed to write");
 	}
 
+	template<typename T>
+	void PacketSerializer::WriteArray(const T* data, std::size_t count)
+	{
+		assert(IsWriting());
+		WriteRawArray(m_buffer, data, count);
+	}
+
+	inline void PacketSerializer::WriteBits(Nz::UInt32 value, std::size_t bitCount)
+	{
+		assert(IsWriting());
+		assert(bitCount <= 32);
+
+		while (bitCount > 0)
+		{
+			if (m_bitPos == 8)
+			{
+				// Reserve a new bit byte at the current position, it will be updated in place
+				m_bitByteOffset = m_buffer.GetStream()->GetCursorPos();
+				m_bitByte = 0;
+				m_bitPos = 0;
+
+				Write(&m_bitByte, 1);
+			}
+
+			std::size_t count = std::min(bitCount, 8 - m_bitPos);
+			m_bitByte |= Nz::UInt8((value & ((1U << count) - 1)) << m_bitPos);
+
+			value >>= count;
+			bitCount -= count;
+			m_bitPos += count;
+		}
+
+		UpdateBitByte();
+	}
+
+	inline void PacketSerializer::Serialize(bool& value)
+	{
+		if (IsWriting())
+			WriteBits((value) ? 1 : 0, 1);
+		else
+			value = (ReadBits(1) != 0);
+	}
+
+	template<typename T>
+	void PacketSerializer::Serialize(CompressedSigned<T>& value)
+	{
+		if (IsWriting())
+			m_buffer << value;
+		else if (m_readData)
+		{
+			Nz::Stream* stream = m_buffer.GetStream();
+
+			std::size_t cursorPos = static_cast<std::size_t>(stream->GetCursorPos());
+			if (cursorPos >= m_readSize)
+				throw std::runtime_error("failed to read");
+
+			T decodedValue;
+			std::size_t byteCount = DecodeCompressedSigned(m_readData + cursorPos, m_readSize - cursorPos, decodedValue);
+			if (byteCount == 0)
+				throw std::runtime_error("failed to read");
+
+			stream->SetCursorPos(cursorPos + byteCount);
+			value = decodedValue;
+		}
+		else
+			m_buffer >> value;
+	}
+
+	template<typename T>
+	void PacketSerializer::Serialize(CompressedUnsigned<T>& value)
+	{
+		if (IsWriting())
+			m_buffer << value;
+		else if (m_readData)
+		{
+			Nz::Stream* stream = m_buffer.GetStream();
+
+			std::size_t cursorPos = static_cast<std::size_t>(stream->GetCursorPos());
+			if (cursorPos >= m_readSize)
+				throw std::runtime_error("failed to read");
+
+			T decodedValue;
+			std::size_t byteCount = DecodeCompressedUnsigned(m_readData + cursorPos, m_readSize - cursorPos, decodedValue);
+			if (byteCount == 0)
+				throw std::runtime_error("failed to read");
+
+			stream->SetCursorPos(cursorPos + byteCount);
+			value = decodedValue;
+		}
+		else
+			m_buffer >> value;
+	}
+
 	template<typename DataType>
 	void PacketSerializer::Serialize(DataType& data)
 	{
@@ -115,6 +264,33 @@ namespace bw
 		}
 	}
 
+	template<typename E>
+	void PacketSerializer::SerializeEnum(E& enumValue, E maxValue)
+	{
+		using UT = std::underlying_type_t<E>;
+		static_assert(sizeof(UT) <= sizeof(Nz::UInt32));
+
+		Nz::UInt32 maxInt = static_cast<Nz::UInt32>(maxValue);
+
+		std::size_t bitCount = 0;
+		while (bitCount < 32 && (maxInt >> bitCount) != 0)
+			bitCount++;
+
+		if (IsWriting())
+		{
+			assert(static_cast<Nz::UInt32>(enumValue) <= maxInt);
+			WriteBits(static_cast<Nz::UInt32>(enumValue), bitCount);
+		}
+		else
+		{
+			Nz::UInt32 value = ReadBits(bitCount);
+			if (value > maxInt)
+				throw std::runtime_error("invalid enum value");
+
+			enumValue = static_cast<E>(value);
+		}
+	}
+
 	template<typename DataType>
 	void PacketSerializer::operator&=(DataType& data)
 	{
@@ -126,4 +302,16 @@ namespace bw
 	{
 		return Serialize(data);
 	}
+
+	inline void PacketSerializer::UpdateBitByte()
+	{
+		Nz::Stream* stream = m_buffer.GetStream();
+
+		Nz::UInt64 cursorPos = stream->GetCursorPos();
+		stream->SetCursorPos(m_bitByteOffset);
+		if (stream->Write(&m_bitByte, 1) != 1)
+			throw std::runtime_error("failed to write");
+
+		stream->SetCursorPos(cursorPos);
+	}
 }
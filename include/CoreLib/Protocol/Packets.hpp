@@ -13,6 +13,7 @@
 #include <CoreLib/PropertyValues.hpp>
 #include <CoreLib/Protocol/CompressedInteger.hpp>
 #include <CoreLib/Protocol/PacketSerializer.hpp>
+#include <CoreLib/Protocol/ProtocolFeatures.hpp>
 #include <Nazara/Prerequisites.hpp>
 #include <Nazara/Core/Color.hpp>
 #include <Nazara/Core/String.hpp>
@@ -41,6 +42,7 @@ namespace bw
 		CreateEntities,
 		DeleteEntities,
 		DisableLayer,
+		DownloadClientFileAck,
 		DownloadClientFileFragment,
 		DownloadClientFileRequest,
 		DownloadClientFileResponse,
@@ -48,9 +50,9 @@ namespace bw
 		EntitiesAnimation,
 		EntitiesDeath,
 		EntitiesInputs,
+		EntitiesPhysics,
 		EntitiesScale,
-		EntityPhysics,
-		EntityWeapon,
+		EntitiesWeapon,
 		InputTimingCorrection,
 		HealthUpdate,
 		MapReset,
@@ -69,7 +71,10 @@ namespace bw
 		PlayerSelectWeapon,
 		PlayerWeapons,
 		Ready,
+		RecycleEntities,
+		RespawnEntities,
 		ScriptPacket,
+		TickRateUpdate,
 		UpdatePlayerName
 	};
 
@@ -114,6 +119,14 @@ namespace bw
 				PropertyValue value;
 			};
 
+			struct StateQuantization
+			{
+				Nz::Vector2f positionMin;
+				Nz::Vector2f positionMax;
+				float maxAngularVelocity;
+				float maxLinearVelocity;
+			};
+
 			struct EntityData
 			{
 				CompressedUnsigned<Nz::UInt32> entityClass;
@@ -138,9 +151,12 @@ namespace bw
 			struct Player
 			{
 				std::string nickname;
+				std::string reconnectToken; //< set when reconnecting to a match resumed from a checkpoint, to take the player back
 			};
 
 			std::vector<Player> players;
+			std::string relayPassword; //< only set by relays, which connect without any player (see MatchSettings::relayPassword)
+			ProtocolFeatureFlags protocolFeatures = SupportedProtocolFeatures;
 		};
 
 		DeclarePacket(AuthFailure)
@@ -152,9 +168,11 @@ namespace bw
 			struct Player
 			{
 				Nz::UInt16 playerIndex;
+				std::string reconnectToken;
 			};
 
 			std::vector<Player> players;
+			ProtocolFeatureFlags protocolFeatures = SupportedProtocolFeatures; //< features of the client the server will use
 		};
 
 		DeclarePacket(ChatMessage)
@@ -248,6 +266,11 @@ namespace bw
 			CompressedUnsigned<LayerIndex> layerIndex;
 		};
 
+		DeclarePacket(DownloadClientFileAck)
+		{
+			CompressedUnsigned<Nz::UInt32> receivedFragmentCount; //< fragments are received in order
+		};
+
 		DeclarePacket(DownloadClientFileFragment)
 		{
 			CompressedUnsigned<Nz::UInt32> fragmentIndex;
@@ -292,6 +315,7 @@ namespace bw
 
 			Nz::UInt16 stateTick;
 			CompressedUnsigned<LayerIndex> layerIndex;
+			CompressedUnsigned<Nz::UInt32> remainingEntityCount; //< entities still to be sent in following EnableLayer packets (layers are streamed in chunks)
 			std::vector<Entity> layerEntities;
 		};
 
@@ -370,7 +394,7 @@ namespace bw
 			std::vector<Layer> layers;
 		};
 
-		DeclarePacket(EntityPhysics)
+		DeclarePacket(EntitiesPhysics)
 		{
 			struct PlayerMovement
 			{
@@ -379,19 +403,43 @@ namespace bw
 				float jumpHeightBoost;
 			};
 
+			struct Entity
+			{
+				CompressedUnsigned<Nz::UInt32> id;
+				bool asleep;
+				float mass;
+				float momentOfInertia;
+				std::optional<PlayerMovement> playerMovement;
+			};
+
+			struct Layer
+			{
+				CompressedUnsigned<LayerIndex> layerIndex;
+				CompressedUnsigned<Nz::UInt32> entityCount;
+			};
+
 			Nz::UInt16 stateTick;
-			Helper::EntityId entityId;
-			bool asleep;
-			float mass;
-			float momentOfInertia;
-			std::optional<PlayerMovement> playerMovement;
+			std::vector<Entity> entities;
+			std::vector<Layer> layers;
 		};
 
-		DeclarePacket(EntityWeapon)
+		DeclarePacket(EntitiesWeapon)
 		{
+			struct Entity
+			{
+				CompressedUnsigned<Nz::UInt32> id;
+				CompressedUnsigned<Nz::UInt32> weaponEntityId;
+			};
+
+			struct Layer
+			{
+				CompressedUnsigned<LayerIndex> layerIndex;
+				CompressedUnsigned<Nz::UInt32> entityCount;
+			};
+
 			Nz::UInt16 stateTick;
-			Helper::EntityId entityId;
-			CompressedUnsigned<Nz::UInt32> weaponEntityId;
+			std::vector<Entity> entities;
+			std::vector<Layer> layers;
 
 			static constexpr Nz::UInt32 NoWeapon = 0xFFFFFFFF;
 		};
@@ -410,6 +458,7 @@ namespace bw
 				CompressedUnsigned<Nz::UInt32> entityCount;
 			};
 
+			CompressedUnsigned<Nz::UInt16> healthStep = CompressedUnsigned<Nz::UInt16>(1); //< health is sent as a multiple of this (rounded up so living entities never look dead)
 			Nz::UInt16 stateTick;
 			std::vector<Entity> entities;
 			std::vector<Layer> layers;
@@ -452,6 +501,10 @@ namespace bw
 			struct Layer
 			{
 				Nz::Color backgroundColor;
+				CompressedUnsigned<Nz::UInt32> physicsIterationCount;
+				CompressedUnsigned<Nz::UInt32> physicsSpatialHashEntityCount;
+				float physicsSleepTime;
+				float physicsSpatialHashCellSize;
 			};
 
 			std::string gamemode;
@@ -460,12 +513,22 @@ namespace bw
 			std::vector<Helper::Property> gamemodeProperties;
 			std::vector<ClientFile> assets;
 			std::vector<ClientFile> scripts;
+			std::optional<Helper::StateQuantization> stateQuantization;
 			Nz::UInt16 currentTick;
+			float minTickDuration; //< fastest rate the match may switch to (see TickRateUpdate)
 			float tickDuration;
 		};
 
 		DeclarePacket(MatchState)
 		{
+			struct DeltaData
+			{
+				Nz::UInt8 baselineAge; //< Tick difference between stateTick and the baseline this entity is encoded against
+				bool positionChanged;
+				bool rotationChanged;
+				bool velocityChanged;
+			};
+
 			struct PlayerMovementData
 			{
 				bool isFacingRight;
@@ -475,6 +538,10 @@ namespace bw
 			{
 				Nz::RadianAnglef angularVelocity;
 				Nz::Vector2f linearVelocity;
+
+				// Sent instead of the above when the state is quantized
+				Nz::Int16 quantizedAngularVelocity;
+				Nz::Vector2<Nz::Int16> quantizedLinearVelocity;
 			};
 
 			struct Entity
@@ -482,6 +549,9 @@ namespace bw
 				CompressedUnsigned<Nz::UInt32> id;
 				Nz::RadianAnglef rotation;
 				Nz::Vector2f position;
+				Nz::UInt16 quantizedRotation;             //< sent instead of rotation when the state is quantized
+				Nz::Vector2<Nz::UInt16> quantizedPosition; //< sent instead of position when the state is quantized
+				std::optional<DeltaData> delta; //< when set, unchanged fields are taken from the baseline
 				std::optional<PlayerMovementData> playerMovement;
 				std::optional<PhysicsProperties> physicsProperties;
 			};
@@ -496,6 +566,9 @@ namespace bw
 			Nz::UInt16 stateTick;
 			std::vector<Entity> entities;
 			std::vector<Layer> layers;
+			bool isQuantized = false;
+
+			static constexpr std::size_t MaxBaselineAge = 127;
 		};
 
 		DeclarePacket(NetworkStrings)
@@ -560,9 +633,19 @@ namespace bw
 
 		DeclarePacket(PlayersInput)
 		{
+			struct PreviousInputs
+			{
+				Nz::UInt8 tickOffset; //< Tick difference with the more recent inputs
+				std::vector<std::optional<PlayerInputData>> inputs; //< Unset when identical to the more recent inputs
+			};
+
 			Nz::UInt16 estimatedServerTick;
 			Nz::UInt16 inputTick;
-			std::vector<std::optional<PlayerInputData>> inputs;
+			std::optional<Nz::UInt16> lastReceivedStateTick; //< MatchState acknowledgement
+			std::vector<PlayerInputData> inputs;
+			std::vector<PreviousInputs> previousInputs; //< Most recent first, sent again in case previous packets were lost (packet is unreliable)
+
+			static constexpr std::size_t MaxPreviousInputs = 4;
 		};
 
 		DeclarePacket(PlayerSelectWeapon)
@@ -585,12 +668,62 @@ namespace bw
 		{
 		};
 
+		DeclarePacket(RecycleEntities)
+		{
+			struct Entity
+			{
+				CompressedUnsigned<Nz::UInt32> id;
+			};
+
+			struct Layer
+			{
+				CompressedUnsigned<LayerIndex> layerIndex;
+				CompressedUnsigned<Nz::UInt32> entityCount;
+			};
+
+			Nz::UInt16 stateTick;
+			std::vector<Entity> entities;
+			std::vector<Layer> layers;
+		};
+
+		// Reuses entities the client kept after a RecycleEntities, without sending their class and static data again
+		DeclarePacket(RespawnEntities)
+		{
+			struct Entity
+			{
+				CompressedUnsigned<Nz::UInt32> id;
+				CompressedUnsigned<Nz::UInt64> uniqueId;
+				Nz::RadianAnglef rotation;
+				Nz::Vector2f position;
+				std::optional<Nz::UInt16> currentHealth;
+				std::optional<Nz::UInt16> ownerPlayerIndex;
+				std::optional<Helper::PhysicsProperties> physicsProperties;
+				std::vector<Helper::Property> properties;
+			};
+
+			struct Layer
+			{
+				CompressedUnsigned<LayerIndex> layerIndex;
+				CompressedUnsigned<Nz::UInt32> entityCount;
+			};
+
+			Nz::UInt16 stateTick;
+			std::vector<Entity> entities;
+			std::vector<Layer> layers;
+		};
+
 		DeclarePacket(ScriptPacket)
 		{
 			CompressedUnsigned<Nz::UInt32> nameIndex;
 			std::vector<Nz::UInt8> content;
 		};
 
+		DeclarePacket(TickRateUpdate)
+		{
+			Nz::UInt16 applyTick; //< first tick simulated with the new duration, sent ahead so clients switch at the same tick
+			float tickDuration;
+		};
+
 		DeclarePacket(UpdatePlayerName)
 		{
 			Nz::UInt8 localIndex;
@@ -600,7 +733,10 @@ namespace bw
 #undef DeclarePacket
 
 		// Compute size
+		BURGWAR_CORELIB_API std::size_t EstimateHeaderSize(const MatchState& matchState);
 		BURGWAR_CORELIB_API std::size_t EstimateSize(const MatchState& matchState);
+		BURGWAR_CORELIB_API std::size_t EstimateSize(const MatchState::Entity& entity, bool isQuantized, std::size_t& propertyBitCount);
+		BURGWAR_CORELIB_API std::size_t EstimateSize(const MatchState::Layer& layer);
 
 		// Packets serializer
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, Auth& data);
@@ -614,6 +750,7 @@ namespace bw
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, CreateEntities& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, DeleteEntities& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, DisableLayer& data);
+		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, DownloadClientFileAck& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, DownloadClientFileFragment& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, DownloadClientFileRequest& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, DownloadClientFileResponse& data);
@@ -621,9 +758,9 @@ namespace bw
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, EntitiesAnimation& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, EntitiesDeath& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, EntitiesInputs& data);
+		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, EntitiesPhysics& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, EntitiesScale& data);
-		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, EntityPhysics& data);
-		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, EntityWeapon& data);
+		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, EntitiesWeapon& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, HealthUpdate& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, InputTimingCorrection& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, MatchData& data);
@@ -642,7 +779,10 @@ namespace bw
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, PlayerSelectWeapon& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, PlayerWeapons& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, Ready& data);
+		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, RecycleEntities& data);
+		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, RespawnEntities& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, ScriptPacket& data);
+		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, TickRateUpdate& data);
 		BURGWAR_CORELIB_API void Serialize(PacketSerializer& serializer, UpdatePlayerName& data);
 
 		// Helpers
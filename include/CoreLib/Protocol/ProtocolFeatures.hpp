@@ -0,0 +1,46 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_NETWORK_PROTOCOLFEATURES_HPP
+#define BURGWAR_CORELIB_NETWORK_PROTOCOLFEATURES_HPP
+
+#include <Nazara/Core/Flags.hpp>
+
+namespace bw
+{
+	// Encodings which both sides have to understand, negotiated per session during authentication (see Packets::Auth)
+	// Values are sent over the network: only add new ones at the end
+	enum class ProtocolFeature
+	{
+		Compression,       //< LZ4-compressed payloads (see CompressPacketPayload)
+		DeltaSnapshots,    //< MatchState entities encoded against an acknowledged baseline
+		StateQuantization, //< MatchState entities quantized (see StateQuantizer)
+
+		Max = StateQuantization
+	};
+}
+
+namespace Nz
+{
+	template<>
+	struct EnumAsFlags<bw::ProtocolFeature>
+	{
+		static constexpr bw::ProtocolFeature max = bw::ProtocolFeature::Max;
+	};
+}
+
+namespace bw
+{
+	using ProtocolFeatureFlags = Nz::Flags<ProtocolFeature>;
+
+	// Features of peers which predate negotiation (and don't send their own)
+	constexpr ProtocolFeatureFlags LegacyProtocolFeatures = ProtocolFeature::Compression | ProtocolFeature::DeltaSnapshots | ProtocolFeature::StateQuantization;
+
+	// Features this build understands
+	constexpr ProtocolFeatureFlags SupportedProtocolFeatures = ProtocolFeature::Compression | ProtocolFeature::DeltaSnapshots | ProtocolFeature::StateQuantization;
+}
+
+#endif
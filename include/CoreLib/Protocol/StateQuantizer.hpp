@@ -0,0 +1,48 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_NETWORK_STATEQUANTIZER_HPP
+#define BURGWAR_CORELIB_NETWORK_STATEQUANTIZER_HPP
+
+#include <CoreLib/Protocol/Packets.hpp>
+#include <Nazara/Math/Angle.hpp>
+#include <Nazara/Math/Vector2.hpp>
+
+namespace bw
+{
+	class StateQuantizer
+	{
+		public:
+			inline StateQuantizer(const Packets::Helper::StateQuantization& settings);
+			StateQuantizer(const StateQuantizer&) = default;
+			~StateQuantizer() = default;
+
+			inline Nz::RadianAnglef DequantizeAngle(Nz::UInt16 value) const;
+			inline Nz::RadianAnglef DequantizeAngularVelocity(Nz::Int16 value) const;
+			inline Nz::Vector2f DequantizeLinearVelocity(const Nz::Vector2<Nz::Int16>& value) const;
+			inline Nz::Vector2f DequantizePosition(const Nz::Vector2<Nz::UInt16>& value) const;
+
+			inline const Packets::Helper::StateQuantization& GetSettings() const;
+
+			inline Nz::UInt16 QuantizeAngle(const Nz::RadianAnglef& angle) const;
+			inline Nz::Int16 QuantizeAngularVelocity(const Nz::RadianAnglef& angularVelocity) const;
+			inline Nz::Vector2<Nz::Int16> QuantizeLinearVelocity(const Nz::Vector2f& linearVelocity) const;
+			inline Nz::Vector2<Nz::UInt16> QuantizePosition(const Nz::Vector2f& position) const;
+
+			StateQuantizer& operator=(const StateQuantizer&) = default;
+
+		private:
+			static inline Nz::Int16 QuantizeSigned(float value, float maxValue);
+			static inline Nz::UInt16 QuantizeUnsigned(float value, float range);
+
+			Packets::Helper::StateQuantization m_settings;
+			Nz::Vector2f m_positionRange;
+	};
+}
+
+#include <CoreLib/Protocol/StateQuantizer.inl>
+
+#endif
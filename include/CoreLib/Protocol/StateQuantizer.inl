@@ -0,0 +1,87 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Protocol/StateQuantizer.hpp>
+#include <Nazara/Math/Algorithm.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace bw
+{
+	inline StateQuantizer::StateQuantizer(const Packets::Helper::StateQuantization& settings) :
+	m_settings(settings),
+	m_positionRange(settings.positionMax - settings.positionMin)
+	{
+		m_positionRange.Maximize(Nz::Vector2f(1.f));
+	}
+
+	inline Nz::RadianAnglef StateQuantizer::DequantizeAngle(Nz::UInt16 value) const
+	{
+		// Decode in [-pi, pi[
+		return Nz::RadianAnglef(static_cast<Nz::Int16>(value) * (float(M_PI) / 32768.f));
+	}
+
+	inline Nz::RadianAnglef StateQuantizer::DequantizeAngularVelocity(Nz::Int16 value) const
+	{
+		return Nz::RadianAnglef(value * m_settings.maxAngularVelocity / 32767.f);
+	}
+
+	inline Nz::Vector2f StateQuantizer::DequantizeLinearVelocity(const Nz::Vector2<Nz::Int16>& value) const
+	{
+		return Nz::Vector2f(value) * m_settings.maxLinearVelocity / 32767.f;
+	}
+
+	inline Nz::Vector2f StateQuantizer::DequantizePosition(const Nz::Vector2<Nz::UInt16>& value) const
+	{
+		return m_settings.positionMin + Nz::Vector2f(value) * m_positionRange / 65535.f;
+	}
+
+	inline const Packets::Helper::StateQuantization& StateQuantizer::GetSettings() const
+	{
+		return m_settings;
+	}
+
+	inline Nz::UInt16 StateQuantizer::QuantizeAngle(const Nz::RadianAnglef& angle) const
+	{
+		// Physics rotation is not bounded, wrap it to [-pi, pi] first
+		float wrappedAngle = std::remainder(angle.value, 2.f * float(M_PI));
+		long quantizedAngle = std::lround(wrappedAngle * (32768.f / float(M_PI)));
+
+		return static_cast<Nz::UInt16>(quantizedAngle & 0xFFFF); //< pi and -pi share the same value
+	}
+
+	inline Nz::Int16 StateQuantizer::QuantizeAngularVelocity(const Nz::RadianAnglef& angularVelocity) const
+	{
+		return QuantizeSigned(angularVelocity.value, m_settings.maxAngularVelocity);
+	}
+
+	inline Nz::Vector2<Nz::Int16> StateQuantizer::QuantizeLinearVelocity(const Nz::Vector2f& linearVelocity) const
+	{
+		return Nz::Vector2<Nz::Int16>(QuantizeSigned(linearVelocity.x, m_settings.maxLinearVelocity), QuantizeSigned(linearVelocity.y, m_settings.maxLinearVelocity));
+	}
+
+	inline Nz::Vector2<Nz::UInt16> StateQuantizer::QuantizePosition(const Nz::Vector2f& position) const
+	{
+		Nz::Vector2f relativePosition = position - m_settings.positionMin;
+		return Nz::Vector2<Nz::UInt16>(QuantizeUnsigned(relativePosition.x, m_positionRange.x), QuantizeUnsigned(relativePosition.y, m_positionRange.y));
+	}
+
+	inline Nz::Int16 StateQuantizer::QuantizeSigned(float value, float maxValue)
+	{
+		if (!std::isfinite(value))
+			return 0;
+
+		float ratio = std::clamp(value / maxValue, -1.f, 1.f);
+		return static_cast<Nz::Int16>(std::lround(ratio * 32767.f));
+	}
+
+	inline Nz::UInt16 StateQuantizer::QuantizeUnsigned(float value, float range)
+	{
+		if (!std::isfinite(value))
+			return 0;
+
+		float ratio = std::clamp(value / range, 0.f, 1.f);
+		return static_cast<Nz::UInt16>(std::lround(ratio * 65535.f));
+	}
+}
@@ -0,0 +1,45 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_REPLAYSESSIONMANAGER_HPP
+#define BURGWAR_CORELIB_REPLAYSESSIONMANAGER_HPP
+
+#include <CoreLib/Export.hpp>
+#include <CoreLib/SessionManager.hpp>
+#include <tsl/hopscotch_map.h>
+#include <memory>
+
+namespace bw
+{
+	class MatchClientSession;
+	class MatchReplay;
+	class MatchSessions;
+	class SessionBridge;
+
+	// Feeds recorded sessions events to the match, each poll handles the events recorded during one match update
+	class BURGWAR_CORELIB_API ReplaySessionManager : public SessionManager
+	{
+		public:
+			ReplaySessionManager(MatchSessions* owner, MatchReplay& replay);
+			~ReplaySessionManager();
+
+			void Poll() override;
+
+		private:
+			struct Peer
+			{
+				std::shared_ptr<SessionBridge> bridge;
+				MatchClientSession* session = nullptr;
+			};
+
+			tsl::hopscotch_map<std::size_t /*recordedSessionId*/, Peer> m_peers;
+			MatchReplay& m_replay;
+	};
+}
+
+#include <CoreLib/ReplaySessionManager.inl>
+
+#endif
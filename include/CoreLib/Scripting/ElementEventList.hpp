@@ -20,6 +20,7 @@ BURGWAR_EVENT(Destroyed)
 BURGWAR_EVENT(Died)
 BURGWAR_EVENT(HealthUpdate)
 BURGWAR_EVENT(Init)
+BURGWAR_EVENT(Respawn)
 BURGWAR_EVENT(ScaleUpdate)
 BURGWAR_EVENT(TakeDamage)
 BURGWAR_EVENT(Tick)
@@ -24,6 +24,7 @@ BURGWAR_EVENT(PlayerChat)
 BURGWAR_EVENT(PlayerConnected)
 BURGWAR_EVENT(PlayerDeath)
 BURGWAR_EVENT(PlayerLayerUpdate)
+BURGWAR_EVENT(PlayerResumed)
 //BURGWAR_EVENT(PlayerSpawn)
 
 // Client gamemode events
@@ -0,0 +1,41 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_SCRIPTING_NATIVEELEMENT_HPP
+#define BURGWAR_CORELIB_SCRIPTING_NATIVEELEMENT_HPP
+
+#include <CoreLib/Export.hpp>
+#include <CoreLib/Scripting/ElementEvents.hpp>
+#include <CoreLib/Scripting/ScriptedElement.hpp>
+#include <sol/sol.hpp>
+#include <string>
+
+namespace bw
+{
+	// Element class implemented in C++, registered in a store under its name as if it was loaded from a script (scripts can use it as their Base)
+	class BURGWAR_CORELIB_API NativeElement
+	{
+		public:
+			inline NativeElement(std::string name);
+			virtual ~NativeElement();
+
+			inline const std::string& GetName() const;
+
+			// Fills the table the element is created from, with the same fields as scripts (Base, Properties, IsNetworked, ...)
+			virtual void InitializeTable(sol::state& state, sol::table& initTable) const = 0;
+			virtual void RegisterCallbacks(sol::state& state, ScriptedElement& element) const = 0;
+
+		protected:
+			template<typename F> static void RegisterCallback(sol::state& state, ScriptedElement& element, ElementEvent event, F&& callback);
+
+		private:
+			std::string m_name;
+	};
+}
+
+#include <CoreLib/Scripting/NativeElement.inl>
+
+#endif
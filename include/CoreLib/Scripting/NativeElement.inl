@@ -0,0 +1,33 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Scripting/NativeElement.hpp>
+#include <CoreLib/Scripting/ScriptingUtils.hpp>
+#include <CoreLib/Utils.hpp>
+
+namespace bw
+{
+	inline NativeElement::NativeElement(std::string name) :
+	m_name(std::move(name))
+	{
+	}
+
+	inline const std::string& NativeElement::GetName() const
+	{
+		return m_name;
+	}
+
+	// Callbacks get the same arguments as script callbacks (entity table first), they go through the Lua API but run no Lua code
+	template<typename F>
+	void NativeElement::RegisterCallback(sol::state& state, ScriptedElement& element, ElementEvent event, F&& callback)
+	{
+		sol::object callbackObject = sol::make_object(state, LuaFunction(std::forward<F>(callback)));
+
+		auto& callbackData = element.eventCallbacks[UnderlyingCast(event)].emplace_back();
+		callbackData.callback = callbackObject.as<sol::main_protected_function>();
+		callbackData.callbackId = element.nextCallbackId++;
+
+		element.sharedCallbacks.reset();
+	}
+}
@@ -8,15 +8,39 @@
 #define BURGWAR_CORELIB_SCRIPTING_NETWORKPACKET_HPP
 
 #include <CoreLib/Export.hpp>
+#include <CoreLib/PropertyValues.hpp>
 #include <CoreLib/Protocol/NetworkStringStore.hpp>
 #include <CoreLib/Protocol/Packets.hpp>
 #include <Nazara/Core/ByteArray.hpp>
 #include <Nazara/Core/ByteStream.hpp>
 #include <Nazara/Math/Vector2.hpp>
+#include <sol/sol.hpp>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace bw
 {
+	class SharedMatch;
+
+	// Fields declared ahead of time by scripts, they are serialized in order without any name or type tag
+	struct BURGWAR_CORELIB_API NetworkPacketSchema
+	{
+		static NetworkPacketSchema FromLua(const sol::table& fields);
+
+		struct Field
+		{
+			std::string name;
+			PropertyType type;
+			Nz::UInt32 maxArraySize = DefaultMaxArraySize;
+			bool isArray = false;
+		};
+
+		std::vector<Field> fields;
+
+		static constexpr Nz::UInt32 DefaultMaxArraySize = 1024; //< arrays are read from untrusted peers, scripts can raise it per field (MaxSize)
+	};
+
 	class BURGWAR_CORELIB_API NetworkPacket
 	{
 		public:
@@ -48,6 +72,8 @@ namespace bw
 			inline float ReadSingle();
 			inline std::string ReadString();
 			inline Nz::Vector2f ReadVector2();
+
+			sol::table ReadFields(SharedMatch& match, sol::state_view& lua, const NetworkPacketSchema& schema);
 	};
 
 	class BURGWAR_CORELIB_API OutgoingNetworkPacket : public NetworkPacket
@@ -62,6 +88,7 @@ namespace bw
 			inline void WriteCompressedInteger(Nz::Int64 number);
 			inline void WriteCompressedUnsigned(Nz::UInt64 number);
 			inline void WriteDouble(double number);
+			void WriteFields(SharedMatch& match, const NetworkPacketSchema& schema, const sol::table& values);
 			inline void WriteSingle(float number);
 			inline void WriteString(const std::string& str);
 			inline void WriteVector2(const Nz::Vector2f& vec);
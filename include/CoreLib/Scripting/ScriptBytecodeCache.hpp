@@ -0,0 +1,61 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_SCRIPTING_SCRIPTBYTECODECACHE_HPP
+#define BURGWAR_CORELIB_SCRIPTING_SCRIPTBYTECODECACHE_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <sol/sol.hpp>
+#include <tsl/hopscotch_map.h>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bw
+{
+	class Logger;
+
+	// Compiled Lua chunks indexed by a hash of their name and source, optionally persisted in a folder
+	class BURGWAR_CORELIB_API ScriptBytecodeCache
+	{
+		public:
+			using Bytecode = std::vector<Nz::UInt8>;
+
+			ScriptBytecodeCache(const Logger& logger, std::filesystem::path cacheFolder);
+			ScriptBytecodeCache(const ScriptBytecodeCache&) = delete;
+			ScriptBytecodeCache(ScriptBytecodeCache&&) = delete;
+			~ScriptBytecodeCache() = default;
+
+			std::shared_ptr<const Bytecode> Find(const std::string& key);
+
+			void Register(const std::string& key, Bytecode bytecode); //< keeps it in memory only (for already persisted chunks, such as maps ones)
+
+			void Store(const std::string& key, Bytecode bytecode);
+
+			ScriptBytecodeCache& operator=(const ScriptBytecodeCache&) = delete;
+			ScriptBytecodeCache& operator=(ScriptBytecodeCache&&) = delete;
+
+			static bool Compile(const std::string& chunkName, const std::string_view& content, Bytecode* bytecode, std::string* error = nullptr);
+			static std::string ComputeKey(const std::string& chunkName, const std::string_view& content);
+			static Bytecode Dump(const sol::protected_function& function);
+
+		private:
+			std::filesystem::path GetCachePath(const std::string& key) const;
+
+			std::filesystem::path m_cacheFolder;
+			std::mutex m_mutex; //< client and local server may share the cache
+			tsl::hopscotch_map<std::string /*key*/, std::shared_ptr<const Bytecode>> m_entries;
+			const Logger& m_logger;
+	};
+}
+
+#include <CoreLib/Scripting/ScriptBytecodeCache.inl>
+
+#endif
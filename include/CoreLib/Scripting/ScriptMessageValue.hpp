@@ -0,0 +1,65 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_SCRIPTING_SCRIPTMESSAGEVALUE_HPP
+#define BURGWAR_CORELIB_SCRIPTING_SCRIPTMESSAGEVALUE_HPP
+
+#include <CoreLib/EntityId.hpp>
+#include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <sol/sol.hpp>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace bw
+{
+	class PacketSerializer;
+	class SharedMatch;
+
+	// Copy of a Lua value which doesn't reference any Lua state, used to pass messages between layers (and data to script jobs)
+	class BURGWAR_CORELIB_API ScriptMessageValue
+	{
+		public:
+			ScriptMessageValue() = default;
+			ScriptMessageValue(const ScriptMessageValue&) = default;
+			ScriptMessageValue(ScriptMessageValue&&) noexcept = default;
+			~ScriptMessageValue() = default;
+
+			void Serialize(PacketSerializer& serializer);
+
+			sol::object ToLua(sol::state_view& lua) const;
+			sol::object ToLua(SharedMatch& match, sol::state_view& lua) const;
+
+			ScriptMessageValue& operator=(const ScriptMessageValue&) = default;
+			ScriptMessageValue& operator=(ScriptMessageValue&&) noexcept = default;
+
+			static ScriptMessageValue FromLua(const sol::object& value); //< plain data only, entities can't leave their match
+			static ScriptMessageValue FromLua(SharedMatch& match, const sol::object& value);
+			static ScriptMessageValue FromLuaFields(SharedMatch& match, const sol::table& table); //< only plain fields are copied, functions, userdata and objects (tables with a metatable other than entities) are skipped
+
+			static constexpr std::size_t MaxDepth = 16;
+
+		private:
+			static ScriptMessageValue FromLua(SharedMatch* match, const sol::object& value, std::size_t depth);
+
+			void Serialize(PacketSerializer& serializer, std::size_t depth);
+
+			sol::object ToLua(SharedMatch* match, sol::state_view& lua) const;
+
+			struct EntityReference
+			{
+				EntityId uniqueId;
+			};
+
+			using Table = std::vector<std::pair<ScriptMessageValue, ScriptMessageValue>>;
+
+			std::variant<std::monostate, bool, Nz::Int64, double, std::string, EntityReference, Table> m_value;
+	};
+}
+
+#endif
@@ -0,0 +1,105 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_SCRIPTING_SCRIPTPROFILER_HPP
+#define BURGWAR_CORELIB_SCRIPTING_SCRIPTPROFILER_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <sol/sol.hpp>
+#include <tsl/hopscotch_map.h>
+#include <string>
+#include <string_view>
+
+namespace bw
+{
+	// Accounts time and Lua memory allocations spent in script callbacks, per element and event
+	class BURGWAR_CORELIB_API ScriptProfiler
+	{
+		public:
+			class Scope;
+
+			ScriptProfiler();
+			ScriptProfiler(const ScriptProfiler&) = delete;
+			ScriptProfiler(ScriptProfiler&&) = delete;
+			~ScriptProfiler() = default;
+
+			inline void Enable(bool enable = true);
+
+			void EndTick();
+
+			std::string Format() const;
+			std::string FormatSummary(std::size_t callbackCount) const;
+
+			inline Nz::UInt64 GetCallbackBudget() const;
+			inline std::size_t GetMemoryUsage() const;
+
+			void InstallAllocator(lua_State* L);
+
+			inline bool IsEnabled() const;
+
+			inline Scope Profile(std::string_view elementName, std::string_view eventName);
+
+			void Reset();
+
+			inline void SetCallbackBudget(Nz::UInt64 microseconds);
+
+			ScriptProfiler& operator=(const ScriptProfiler&) = delete;
+			ScriptProfiler& operator=(ScriptProfiler&&) = delete;
+
+			class Scope
+			{
+				public:
+					inline Scope(ScriptProfiler* profiler, std::string_view elementName, std::string_view eventName);
+					Scope(const Scope&) = delete;
+					Scope(Scope&&) = delete;
+					inline ~Scope();
+
+					inline Nz::UInt64 Stop();
+
+					Scope& operator=(const Scope&) = delete;
+					Scope& operator=(Scope&&) = delete;
+
+				private:
+					ScriptProfiler* m_profiler;
+					std::string_view m_elementName;
+					std::string_view m_eventName;
+					Nz::UInt64 m_startAllocatedBytes;
+					Nz::UInt64 m_startTime;
+			};
+
+		private:
+			struct CallbackStats
+			{
+				std::string name;
+				Nz::UInt64 callCount = 0;
+				Nz::UInt64 maxTickAllocatedBytes = 0;
+				Nz::UInt64 maxTickDuration = 0;
+				Nz::UInt64 tickAllocatedBytes = 0;
+				Nz::UInt64 tickDuration = 0;
+				Nz::UInt64 totalAllocatedBytes = 0;
+				Nz::UInt64 totalDuration = 0;
+			};
+
+			void Record(std::string_view elementName, std::string_view eventName, Nz::UInt64 duration, Nz::UInt64 allocatedBytes);
+
+			static void* Allocate(void* userdata, void* ptr, std::size_t oldSize, std::size_t newSize);
+
+			lua_Alloc m_allocator;
+			tsl::hopscotch_map<std::string, CallbackStats> m_callbacks;
+			std::size_t m_memoryUsage;
+			std::string m_keyBuffer;
+			void* m_allocatorUserdata;
+			Nz::UInt64 m_allocatedBytes; //< growing counter of every byte allocated by Lua, scopes compare it at start and stop
+			Nz::UInt64 m_callbackBudget;
+			Nz::UInt64 m_tickCount;
+			bool m_isEnabled;
+	};
+}
+
+#include <CoreLib/Scripting/ScriptProfiler.inl>
+
+#endif
@@ -0,0 +1,67 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Scripting/ScriptProfiler.hpp>
+#include <Nazara/Core/Clock.hpp>
+
+namespace bw
+{
+	inline void ScriptProfiler::Enable(bool enable)
+	{
+		m_isEnabled = enable;
+	}
+
+	inline Nz::UInt64 ScriptProfiler::GetCallbackBudget() const
+	{
+		return m_callbackBudget;
+	}
+
+	inline std::size_t ScriptProfiler::GetMemoryUsage() const
+	{
+		return m_memoryUsage;
+	}
+
+	inline bool ScriptProfiler::IsEnabled() const
+	{
+		return m_isEnabled;
+	}
+
+	inline auto ScriptProfiler::Profile(std::string_view elementName, std::string_view eventName) -> Scope
+	{
+		// Budget checks need the callback duration even when statistics are not collected
+		return Scope((m_isEnabled || m_callbackBudget > 0) ? this : nullptr, elementName, eventName);
+	}
+
+	inline void ScriptProfiler::SetCallbackBudget(Nz::UInt64 microseconds)
+	{
+		m_callbackBudget = microseconds;
+	}
+
+	inline ScriptProfiler::Scope::Scope(ScriptProfiler* profiler, std::string_view elementName, std::string_view eventName) :
+	m_profiler(profiler),
+	m_elementName(elementName),
+	m_eventName(eventName),
+	m_startAllocatedBytes((profiler) ? profiler->m_allocatedBytes : 0),
+	m_startTime((profiler) ? Nz::GetElapsedMicroseconds() : 0)
+	{
+	}
+
+	inline ScriptProfiler::Scope::~Scope()
+	{
+		Stop();
+	}
+
+	inline Nz::UInt64 ScriptProfiler::Scope::Stop()
+	{
+		if (!m_profiler)
+			return 0;
+
+		Nz::UInt64 duration = Nz::GetElapsedMicroseconds() - m_startTime;
+		if (m_profiler->m_isEnabled)
+			m_profiler->Record(m_elementName, m_eventName, duration, m_profiler->m_allocatedBytes - m_startAllocatedBytes);
+
+		m_profiler = nullptr;
+		return duration;
+	}
+}
@@ -0,0 +1,64 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_SCRIPTING_SCRIPTSAMPLER_HPP
+#define BURGWAR_CORELIB_SCRIPTING_SCRIPTSAMPLER_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <sol/sol.hpp>
+#include <tsl/hopscotch_map.h>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	// Samples Lua call stacks every few instructions through a count hook, and dumps them in collapsed format for flamegraph tools
+	class BURGWAR_CORELIB_API ScriptSampler
+	{
+		public:
+			ScriptSampler();
+			ScriptSampler(const ScriptSampler&) = delete;
+			ScriptSampler(ScriptSampler&&) = delete;
+			~ScriptSampler() = default;
+
+			void Attach(lua_State* L);
+			void Detach(lua_State* L);
+
+			std::string FormatCollapsedStacks() const;
+
+			inline Nz::UInt64 GetSampleCount() const;
+			inline unsigned int GetSampleInterval() const;
+
+			inline bool IsRunning() const;
+
+			void Reset();
+
+			void Start(lua_State* L, unsigned int instructionInterval);
+			void Stop(lua_State* L);
+
+			ScriptSampler& operator=(const ScriptSampler&) = delete;
+			ScriptSampler& operator=(ScriptSampler&&) = delete;
+
+			static constexpr std::size_t MaxStackDepth = 64;
+
+		private:
+			void Sample(lua_State* L);
+
+			static void Hook(lua_State* L, lua_Debug* ar);
+
+			tsl::hopscotch_map<std::string, Nz::UInt64> m_stacks;
+			std::string m_stackBuffer;
+			std::vector<std::string> m_frames;
+			Nz::UInt64 m_sampleCount;
+			unsigned int m_sampleInterval;
+			bool m_isRunning;
+	};
+}
+
+#include <CoreLib/Scripting/ScriptSampler.inl>
+
+#endif
@@ -0,0 +1,23 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Scripting/ScriptSampler.hpp>
+
+namespace bw
+{
+	inline Nz::UInt64 ScriptSampler::GetSampleCount() const
+	{
+		return m_sampleCount;
+	}
+
+	inline unsigned int ScriptSampler::GetSampleInterval() const
+	{
+		return m_sampleInterval;
+	}
+
+	inline bool ScriptSampler::IsRunning() const
+	{
+		return m_isRunning;
+	}
+}
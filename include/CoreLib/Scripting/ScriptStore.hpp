@@ -10,6 +10,7 @@
 #include <CoreLib/PropertyValues.hpp>
 #include <CoreLib/LogSystem/Logger.hpp>
 #include <CoreLib/Scripting/AbstractElementLibrary.hpp>
+#include <CoreLib/Scripting/NativeElement.hpp>
 #include <CoreLib/Scripting/ScriptedElement.hpp>
 #include <CoreLib/Scripting/ScriptingContext.hpp>
 #include <NDK/Entity.hpp>
@@ -45,6 +46,8 @@ namespace bw
 			bool LoadElement(bool isDirectory, std::filesystem::path elementPath);
 			void LoadLibrary(std::shared_ptr<AbstractElementLibrary> library);
 
+			void RegisterNativeElement(std::shared_ptr<const NativeElement> nativeElement);
+			void ReloadElements(const std::filesystem::path& directoryPath, const std::vector<std::string>& entryNames);
 			void ReloadLibraries();
 
 			void Resolve();
@@ -70,6 +73,7 @@ namespace bw
 			sol::table CreateElement(lua_State* L, sol::table initTable);
 			sol::table GetElementTable();
 			void RegisterCustomEvents(const std::shared_ptr<Element>& element, Element* baseElement);
+			bool LoadNativeElement(const NativeElement& nativeElement);
 			bool RegisterElement(std::shared_ptr<Element> element);
 			void RegisterProperties(const std::shared_ptr<Element>& element, Element* baseElement);
 
@@ -96,9 +100,11 @@ namespace bw
 			std::string m_elementTypeName;
 			std::string m_elementName;
 			std::vector<std::shared_ptr<AbstractElementLibrary>> m_libraries;
+			std::vector<std::shared_ptr<const NativeElement>> m_nativeElements;
 			std::vector<std::shared_ptr<Element>> m_elements;
 			tsl::hopscotch_map<std::string /*name*/, std::size_t /*elementIndex*/> m_elementsByName;
 			tsl::hopscotch_map<std::string /*dependency*/, std::vector<PendingElementData>> m_pendingElements;
+			tsl::hopscotch_map<std::string /*name*/, std::size_t /*elementIndex*/> m_reloadingElements;
 			CurrentElementData* m_currentElementData;
 			const Logger& m_logger;
 			bool m_isServer;
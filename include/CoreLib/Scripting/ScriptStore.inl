@@ -9,6 +9,7 @@
 #include <CoreLib/Utility/VirtualDirectory.hpp>
 #include <Nazara/Core/CallOnExit.hpp>
 #include <NDK/World.hpp>
+#include <algorithm>
 #include <cassert>
 #include <filesystem>
 #include <sstream>
@@ -90,6 +91,13 @@ namespace bw
 	template<typename Element>
 	void ScriptStore<Element>::LoadDirectory(const std::filesystem::path& directoryPath)
 	{
+		// Native elements come first (and again after ClearElements), so scripts can use them as their base
+		for (const auto& nativeElement : m_nativeElements)
+		{
+			if (m_elementsByName.find(m_elementTypeName + "_" + nativeElement->GetName()) == m_elementsByName.end())
+				LoadNativeElement(*nativeElement);
+		}
+
 		const auto& scriptDir = m_context->GetScriptDirectory();
 
 		VirtualDirectory::Entry entry;
@@ -166,6 +174,88 @@ namespace bw
 		m_libraries.emplace_back(std::move(library));
 	}
 
+	template<typename Element>
+	void ScriptStore<Element>::RegisterNativeElement(std::shared_ptr<const NativeElement> nativeElement)
+	{
+		assert(nativeElement);
+
+		LoadNativeElement(*nativeElement);
+		m_nativeElements.emplace_back(std::move(nativeElement));
+	}
+
+	template<typename Element>
+	void ScriptStore<Element>::ReloadElements(const std::filesystem::path& directoryPath, const std::vector<std::string>& entryNames)
+	{
+		struct ReloadedElement
+		{
+			std::filesystem::path path;
+			std::string fullName;
+			bool isDirectory;
+		};
+
+		std::vector<ReloadedElement> reloadedElements;
+		auto IsReloaded = [&](const std::string& fullName)
+		{
+			return std::find_if(reloadedElements.begin(), reloadedElements.end(), [&](const ReloadedElement& element) { return element.fullName == fullName; }) != reloadedElements.end();
+		};
+
+		const auto& scriptDir = m_context->GetScriptDirectory();
+		for (const std::string& entryName : entryNames)
+		{
+			std::filesystem::path elementPath = directoryPath / entryName;
+
+			VirtualDirectory::Entry entry;
+			if (!scriptDir->GetEntry(elementPath.generic_u8string(), &entry))
+			{
+				bwLog(m_logger, LogLevel::Warning, "{0} has been removed, its {1} is kept until a full reload", elementPath.generic_u8string(), m_elementTypeName);
+				continue;
+			}
+
+			bool isDirectory = std::holds_alternative<VirtualDirectory::VirtualDirectoryEntry>(entry);
+			std::string fullName = m_elementTypeName + "_" + ((isDirectory) ? elementPath.filename() : elementPath.stem()).u8string();
+			if (!IsReloaded(fullName))
+				reloadedElements.push_back({ std::move(elementPath), std::move(fullName), isDirectory });
+		}
+
+		// Derived elements copied callbacks and properties from their base, reload them as well
+		bool addedDerived;
+		do
+		{
+			addedDerived = false;
+			for (const auto& elementPtr : m_elements)
+			{
+				if (!elementPtr->base.empty() && IsReloaded(elementPtr->base) && !IsReloaded(elementPtr->fullName))
+				{
+					reloadedElements.push_back({ elementPtr->path, elementPtr->fullName, elementPtr->isDirectory });
+					addedDerived = true;
+				}
+			}
+		}
+		while (addedDerived);
+
+		for (const ReloadedElement& reloadedElement : reloadedElements)
+		{
+			if (auto it = m_elementsByName.find(reloadedElement.fullName); it != m_elementsByName.end())
+			{
+				m_reloadingElements.emplace(reloadedElement.fullName, it->second);
+				m_elementsByName.erase(it);
+			}
+		}
+
+		for (const ReloadedElement& reloadedElement : reloadedElements)
+			LoadElement(reloadedElement.isDirectory, reloadedElement.path);
+
+		Resolve();
+
+		// Elements which failed to reload keep running their previous version
+		for (auto&& [fullName, elementIndex] : m_reloadingElements)
+		{
+			bwLog(m_logger, LogLevel::Warning, "failed to reload {0}, keeping its previous version", fullName);
+			m_elementsByName[fullName] = elementIndex;
+		}
+		m_reloadingElements.clear();
+	}
+
 	template<typename Element>
 	void ScriptStore<Element>::ReloadLibraries()
 	{
@@ -262,7 +352,7 @@ namespace bw
 	{
 		const Ndk::EntityHandle& entity = world.CreateEntity();
 
-		PropertyValueMap filteredProperties; //< Without potential unused properties (FIXME: Is it really necessary?)
+		ScriptedPropertyValues filteredProperties(element->properties.size()); //< Without potential unused properties
 
 		for (auto&& [propertyName, propertyInfo] : element->properties)
 		{
@@ -294,7 +384,7 @@ namespace bw
 					throw std::runtime_error(std::move(ss).str());
 				}
 
-				filteredProperties.emplace(propertyName, std::move(value));
+				filteredProperties[propertyInfo.index] = std::move(value);
 			}
 			else
 			{
@@ -308,7 +398,8 @@ namespace bw
 
 		sol::state& state = scriptingContext->GetLuaState();
 
-		sol::table entityTable = state.create_table();
+		// Pooling tables isn't possible as scripts may keep the table of a removed entity (and check IsValid), but they're created with room for these fields
+		sol::table entityTable = state.create_table(0, 2);
 		entityTable["Derived"] = entityTable;
 		entityTable["_Entity"] = entity;
 		entityTable[sol::metatable_key] = element->elementTable;
@@ -345,6 +436,8 @@ namespace bw
 		element = CreateElement();
 		element->fullName = std::move(m_currentElementData->fullName);
 		element->name = std::move(m_currentElementData->name);
+		element->isDirectory = m_currentElementData->directory;
+		element->path = m_currentElementData->elementPath;
 
 		element->elementTable = std::move(initTable);
 
@@ -416,6 +509,8 @@ namespace bw
 			}
 
 			RegisterCustomEvents(element, parentElement);
+
+			element->sharedCallbacks.reset();
 		}
 
 		sol::object customEvents = baseElement->elementTable.template raw_get<sol::object>("CustomEvents"); //< raw get as we don't want to fetch from the base
@@ -450,6 +545,47 @@ namespace bw
 		}
 	}
 
+	template<typename Element>
+	bool ScriptStore<Element>::LoadNativeElement(const NativeElement& nativeElement)
+	{
+		CurrentElementData elementData;
+		elementData.name = nativeElement.GetName();
+		elementData.fullName = m_elementTypeName + "_" + elementData.name;
+		elementData.directory = false;
+
+		m_currentElementData = &elementData;
+		Nz::CallOnExit resetOnExit([&] { m_currentElementData = nullptr; });
+
+		bwLog(m_logger, LogLevel::Info, "loading native {0} {1}", m_elementTypeName, elementData.name);
+
+		sol::state& state = GetLuaState();
+
+		try
+		{
+			sol::table initTable = state.create_table();
+			nativeElement.InitializeTable(state, initTable);
+
+			// Elements waiting for their base are resumed from their loading coroutine, which native elements don't have
+			std::string baseElement = initTable.get_or("Base", std::string());
+			if (!baseElement.empty() && m_elementsByName.find(baseElement) == m_elementsByName.end())
+			{
+				bwLog(m_logger, LogLevel::Error, "failed to initialize native {0} {1}: base {2} must be registered first", m_elementTypeName, elementData.name, baseElement);
+				return false;
+			}
+
+			CreateElement(state.lua_state(), std::move(initTable));
+
+			nativeElement.RegisterCallbacks(state, *elementData.element);
+		}
+		catch (const std::exception& e)
+		{
+			bwLog(m_logger, LogLevel::Error, "failed to initialize native {0} {1}: {2}", m_elementTypeName, elementData.name, e.what());
+			return false;
+		}
+
+		return true;
+	}
+
 	template<typename Element>
 	bool ScriptStore<Element>::RegisterElement(std::shared_ptr<Element> element)
 	{
@@ -468,6 +604,13 @@ namespace bw
 		RegisterCustomEvents(element, element.get());
 		RegisterProperties(element, element.get());
 
+		// Custom events are interned here, scripts can trigger them by index (ENTITY.EventHandles.Name) instead of by name
+		sol::table eventHandles = sol::state_view(element->elementTable.lua_state()).create_table(0, int(element->customEvents.size()));
+		for (const ScriptedEvent& event : element->customEvents)
+			eventHandles[event.name] = event.index;
+
+		element->elementTable["EventHandles"] = eventHandles;
+
 		try
 		{
 			InitializeElement(element->elementTable, *element);
@@ -478,8 +621,20 @@ namespace bw
 			return false;
 		}
 
-		m_elementsByName[element->fullName] = m_elements.size();
-		m_elements.emplace_back(std::move(element));
+		// Reloaded elements take their previous slot, for indices to stay valid
+		if (auto it = m_reloadingElements.find(element->fullName); it != m_reloadingElements.end())
+		{
+			std::size_t elementIndex = it->second;
+			m_reloadingElements.erase(it);
+
+			m_elementsByName[element->fullName] = elementIndex;
+			m_elements[elementIndex] = std::move(element);
+		}
+		else
+		{
+			m_elementsByName[element->fullName] = m_elements.size();
+			m_elements.emplace_back(std::move(element));
+		}
 
 		return true;
 	}
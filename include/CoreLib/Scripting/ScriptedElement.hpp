@@ -7,6 +7,7 @@
 #ifndef BURGWAR_CORELIB_SCRIPTING_SCRIPTEDELEMENT_HPP
 #define BURGWAR_CORELIB_SCRIPTING_SCRIPTEDELEMENT_HPP
 
+#include <CoreLib/ColliderCache.hpp>
 #include <CoreLib/PropertyValues.hpp>
 #include <CoreLib/Scripting/ElementEvents.hpp>
 #include <CoreLib/Scripting/ScriptedEvent.hpp>
@@ -15,6 +16,7 @@
 #include <tsl/hopscotch_map.h>
 #include <sol/sol.hpp>
 #include <array>
+#include <filesystem>
 #include <memory>
 #include <optional>
 #include <string>
@@ -30,9 +32,18 @@ namespace bw
 			bool async = false;
 		};
 
+		struct CallbackSet
+		{
+			std::array<std::vector<Callback>, ElementEventCount> eventCallbacks;
+			std::vector<std::vector<Callback>> customEventCallbacks;
+		};
+
 		sol::main_table elementTable;
+		mutable ColliderCache colliderCache; //< collider geometries shared by instances
+		mutable std::shared_ptr<CallbackSet> sharedCallbacks; //< snapshot of the callbacks below shared by instances until they register their own (reset when those change)
 		std::array<std::vector<Callback>, ElementEventCount> eventCallbacks;
 		std::size_t nextCallbackId = 1;
+		std::filesystem::path path; //< file or directory the element was loaded from
 		std::string base;
 		std::string name;
 		std::string fullName;
@@ -40,6 +51,7 @@ namespace bw
 		std::vector<std::vector<Callback>> customEventCallbacks;
 		tsl::hopscotch_map<std::string /*key*/, ScriptedProperty> properties;
 		tsl::hopscotch_map<std::string /*eventName*/, std::size_t> customEventByName;
+		bool isDirectory = false;
 	};
 }
 
@@ -15,7 +15,12 @@ namespace bw
 	struct ScriptedEntity : ScriptedElement
 	{
 		bool isNetworked;
+		std::size_t poolSize; //< how many removed entities can be kept for reuse (0 if pooling is disabled)
 		Nz::UInt16 maxHealth;
+		Nz::UInt8 networkPriority = 1; //< see NetworkSyncComponent::Settings (server only)
+		float networkMaxUpdateRate = 0.f;
+		float networkRelevanceDistance = 0.f;
+		bool checkpoint = false; //< instance table fields are saved in match checkpoints (see MatchCheckpoint, server only)
 	};
 }
 
@@ -8,6 +8,8 @@
 #define BURGWAR_CORELIB_SCRIPTING_SCRIPTEDPROPERTY_HPP
 
 #include <CoreLib/PropertyValues.hpp>
+#include <optional>
+#include <vector>
 
 namespace bw
 {
@@ -20,6 +22,9 @@ namespace bw
 		bool shared = false;
 	};
 
+	// Property values of an entity indexed by ScriptedProperty::index, unset values fall back to the default one
+	using ScriptedPropertyValues = std::vector<std::optional<PropertyValue>>;
+
 	BURGWAR_CORELIB_API ScriptedProperty InitPropertyFromLua(std::size_t index, const sol::table& table);
 }
 
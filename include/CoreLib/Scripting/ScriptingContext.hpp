@@ -9,35 +9,59 @@
 
 #include <CoreLib/Export.hpp>
 #include <CoreLib/Scripting/AbstractScriptingLibrary.hpp>
+#include <CoreLib/Scripting/ScriptProfiler.hpp>
+#include <CoreLib/Scripting/ScriptSampler.hpp>
 #include <CoreLib/Utility/VirtualDirectory.hpp>
 #include <sol/sol.hpp>
 #include <tl/expected.hpp>
+#include <tsl/hopscotch_map.h>
 #include <filesystem>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace bw
 {
+	class JobSystem;
 	class Logger;
+	class ScriptBytecodeCache;
 
 	class BURGWAR_CORELIB_API ScriptingContext
 	{
 		public:
 			struct Async {};
+			struct ContinuationQueue;
 			struct FileLoadCoroutine;
+			struct GarbageCollectorStats;
+
+			enum class GarbageCollectorMode
+			{
+				Generational,       //< Lua generational collector, triggered by allocations
+				Incremental,        //< Lua incremental collector, triggered by allocations
+				IncrementalStepped  //< Incremental collector only driven by StepGarbageCollector
+			};
 			using PrintFunction = std::function<void(const std::string& str, const Nz::Color& color)>;
 
 			ScriptingContext(const Logger& logger, std::shared_ptr<VirtualDirectory> scriptDir);
 			~ScriptingContext();
 
+			inline void ClearPreloadedScripts();
+
 			template<typename... Args> sol::coroutine CreateCoroutine(Args&&... args);
 
 			template<typename... Args> std::optional<sol::object> Exec(FileLoadCoroutine& coroutineData, Args&&... args);
 
+			inline std::weak_ptr<ContinuationQueue> GetContinuationQueue() const;
 			inline const std::filesystem::path& GetCurrentFile() const;
 			inline const std::filesystem::path& GetCurrentFolder() const;
+			inline const GarbageCollectorStats& GetGarbageCollectorStats() const;
 			inline sol::state& GetLuaState();
 			inline const sol::state& GetLuaState() const;
+			inline ScriptProfiler& GetProfiler();
+			inline const ScriptProfiler& GetProfiler() const;
+			inline const ScriptSampler& GetSampler() const;
 			inline const std::shared_ptr<VirtualDirectory>& GetScriptDirectory() const;
 
 			tl::expected<sol::object, std::string> Load(const std::filesystem::path& file, bool logError = true);
@@ -46,15 +70,33 @@ namespace bw
 			bool LoadDirectoryOpt(const std::filesystem::path& folder);
 			void LoadLibrary(std::shared_ptr<AbstractScriptingLibrary> library);
 
+			// Reads, hashes and compiles every script of those folders on the job system, loading them afterwards only has to run them
+			void Preload(JobSystem& jobSystem, const std::vector<std::string>& folders);
 			inline void Print(const std::string& str, const Nz::Color& color = Nz::Color::White);
 
+			void RegisterLazyTable(std::string name, std::function<void(sol::table& table)> initializer); //< global table only created (and filled) the first time it's accessed
 			void ReloadLibraries();
 
+			inline void SetBytecodeCache(std::shared_ptr<ScriptBytecodeCache> bytecodeCache);
+			void SetGarbageCollectorMode(GarbageCollectorMode mode);
 			inline void SetPrintFunction(PrintFunction function);
 
+			void StartSampling(unsigned int instructionInterval);
+			Nz::UInt64 StepGarbageCollector(Nz::UInt64 budget);
+			void StopSampling();
+
 			void Update();
 			inline void UpdateScriptDirectory(std::shared_ptr<VirtualDirectory> scriptDir);
 
+			// Lets other threads (such as script jobs) hand work back to the thread owning the context, it is run by Update
+			struct ContinuationQueue
+			{
+				inline void Push(std::function<void()> continuation);
+
+				std::mutex mutex;
+				std::vector<std::function<void()>> continuations;
+			};
+
 			struct FileLoadCoroutine
 			{
 				sol::thread thread;
@@ -62,9 +104,28 @@ namespace bw
 				std::filesystem::path filePath;
 			};
 
+			struct GarbageCollectorStats
+			{
+				Nz::UInt64 cycleCount = 0; //< completed collection cycles (only counted in IncrementalStepped mode)
+				Nz::UInt64 maxStepDuration = 0; //< microseconds
+				Nz::UInt64 stepCount = 0;
+				Nz::UInt64 totalStepDuration = 0; //< microseconds
+			};
+
 		private:
+			struct PreloadedScript
+			{
+				std::shared_ptr<const std::vector<Nz::UInt8>> bytecode; //< null if the script failed to compile
+				std::string content; //< only for physical files
+			};
+
 			sol::thread& CreateThread();
+			void RecycleThread(sol::thread&& thread);
+
+			tl::expected<sol::protected_function, std::string> LoadChunk(const std::filesystem::path& path, const std::string_view& content);
 
+			tl::expected<sol::object, std::string> LoadFile(std::filesystem::path path, const VirtualDirectory::DataPointerEntry& entry);
+			std::optional<FileLoadCoroutine> LoadFile(std::filesystem::path path, const VirtualDirectory::DataPointerEntry& entry, Async);
 			tl::expected<sol::object, std::string> LoadFile(std::filesystem::path path, const VirtualDirectory::FileContentEntry& entry);
 			std::optional<FileLoadCoroutine> LoadFile(std::filesystem::path path, const VirtualDirectory::FileContentEntry& entry, Async);
 			tl::expected<sol::object, std::string> LoadFile(std::filesystem::path path, const VirtualDirectory::PhysicalFileEntry& entry);
@@ -76,11 +137,21 @@ namespace bw
 
 			std::filesystem::path m_currentFile;
 			std::filesystem::path m_currentFolder;
+			GarbageCollectorMode m_garbageCollectorMode;
+			GarbageCollectorStats m_garbageCollectorStats;
 			PrintFunction m_printFunction;
+			std::shared_ptr<ContinuationQueue> m_continuationQueue;
+			std::shared_ptr<ScriptBytecodeCache> m_bytecodeCache;
 			std::shared_ptr<VirtualDirectory> m_scriptDirectory;
 			std::vector<std::shared_ptr<AbstractScriptingLibrary>> m_libraries;
+			std::vector<std::function<void()>> m_runningContinuations;
 			std::vector<sol::thread> m_availableThreads;
-			std::vector<sol::thread> m_runningThreads;
+			std::vector<sol::thread> m_startedThreads; //< handed out since the last Update, most of them are already done by then
+			std::vector<sol::thread> m_suspendedThreads; //< yielded at least once, resumed from Lua (timers, animations) when they're ready
+			tsl::hopscotch_map<std::string /*name*/, std::function<void(sol::table& table)>> m_lazyTables;
+			tsl::hopscotch_map<std::string /*path*/, PreloadedScript> m_preloadedScripts; //< consumed when the script is loaded
+			ScriptSampler m_sampler;
+			ScriptProfiler m_profiler; //< must outlive m_luaState, which frees its memory through it
 			sol::state m_luaState;
 			const Logger& m_logger;
 	};
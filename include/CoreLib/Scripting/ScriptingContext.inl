@@ -43,6 +43,16 @@ namespace bw
 		return result;
 	}
 
+	inline void ScriptingContext::ClearPreloadedScripts()
+	{
+		m_preloadedScripts.clear();
+	}
+
+	inline auto ScriptingContext::GetContinuationQueue() const -> std::weak_ptr<ContinuationQueue>
+	{
+		return m_continuationQueue;
+	}
+
 	inline const std::filesystem::path& ScriptingContext::GetCurrentFile() const
 	{
 		return m_currentFile;
@@ -53,6 +63,11 @@ namespace bw
 		return m_currentFolder;
 	}
 
+	inline auto ScriptingContext::GetGarbageCollectorStats() const -> const GarbageCollectorStats&
+	{
+		return m_garbageCollectorStats;
+	}
+
 	inline sol::state& ScriptingContext::GetLuaState()
 	{
 		return m_luaState;
@@ -63,6 +78,21 @@ namespace bw
 		return m_luaState;
 	}
 
+	inline ScriptProfiler& ScriptingContext::GetProfiler()
+	{
+		return m_profiler;
+	}
+
+	inline const ScriptProfiler& ScriptingContext::GetProfiler() const
+	{
+		return m_profiler;
+	}
+
+	inline const ScriptSampler& ScriptingContext::GetSampler() const
+	{
+		return m_sampler;
+	}
+
 	inline const std::shared_ptr<VirtualDirectory>& ScriptingContext::GetScriptDirectory() const
 	{
 		return m_scriptDirectory;
@@ -73,6 +103,11 @@ namespace bw
 		m_printFunction(str, color);
 	}
 
+	inline void ScriptingContext::SetBytecodeCache(std::shared_ptr<ScriptBytecodeCache> bytecodeCache)
+	{
+		m_bytecodeCache = std::move(bytecodeCache);
+	}
+
 	inline void ScriptingContext::SetPrintFunction(PrintFunction function)
 	{
 		m_printFunction = std::move(function);
@@ -82,4 +117,10 @@ namespace bw
 	{
 		m_scriptDirectory = std::move(scriptDir);
 	}
+
+	inline void ScriptingContext::ContinuationQueue::Push(std::function<void()> continuation)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		continuations.push_back(std::move(continuation));
+	}
 }
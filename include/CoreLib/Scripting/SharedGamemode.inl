@@ -6,6 +6,7 @@
 #include <CoreLib/SharedMatch.hpp>
 #include <CoreLib/Utils.hpp>
 #include <CoreLib/LogSystem/Logger.hpp>
+#include <CoreLib/Utility/Profiling.hpp>
 #include <cassert>
 
 namespace bw
@@ -19,6 +20,11 @@ namespace bw
 		if (callbacks.empty())
 			return true;
 
+		auto profileScope = m_context->GetProfiler().Profile(m_gamemodeName, ToString(Event));
+		bwProfileZone("Script callback");
+		bwProfileZoneText(m_gamemodeName);
+		bwProfileZoneText(ToString(Event));
+
 		bool ret = false;
 
 		for (const auto& callbackData : callbacks)
@@ -58,6 +64,14 @@ namespace bw
 		std::optional<ResultType> combinedResult;
 
 		const auto& callbacks = m_eventCallbacks[UnderlyingCast(Event)];
+		if (callbacks.empty())
+			return combinedResult;
+
+		auto profileScope = m_context->GetProfiler().Profile(m_gamemodeName, ToString(Event));
+		bwProfileZone("Script callback");
+		bwProfileZoneText(m_gamemodeName);
+		bwProfileZoneText(ToString(Event));
+
 		for (const auto& callbackData : callbacks)
 		{
 			assert(!callbackData.async);
@@ -94,6 +108,12 @@ namespace bw
 
 		assert(eventIndex < m_customEvents.size());
 		const auto& eventData = m_customEvents[eventIndex];
+
+		auto profileScope = m_context->GetProfiler().Profile(m_gamemodeName, eventData.name);
+		bwProfileZone("Script callback");
+		bwProfileZoneText(m_gamemodeName);
+		bwProfileZoneText(eventData.name);
+
 		if (eventData.returnType.empty())
 		{
 			// No return
@@ -146,9 +166,9 @@ namespace bw
 				if (eventData.combinator && combinedResult.has_value())
 				{
 					auto combinatorResult = eventData.combinator(combinedResult, callbackResult);
-					if (!callbackResult.valid())
+					if (!combinatorResult.valid())
 					{
-						sol::error err = callbackResult;
+						sol::error err = combinatorResult;
 						bwLog(m_sharedMatch.GetLogger(), LogLevel::Error, "{} combinator failed: {}", eventData.name, err.what());
 
 						continue;
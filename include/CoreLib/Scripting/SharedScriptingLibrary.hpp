@@ -9,7 +9,11 @@
 
 #include <CoreLib/Export.hpp>
 #include <CoreLib/Scripting/AbstractScriptingLibrary.hpp>
+#include <CoreLib/Scripting/ScriptMessageValue.hpp>
+#include <tsl/hopscotch_map.h>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace bw
 {
@@ -36,6 +40,7 @@ namespace bw
 			// Libraries
 			virtual void RegisterGameLibrary(ScriptingContext& context, sol::table& library);
 			void RegisterGlobalLibrary(ScriptingContext& context) override;
+			virtual void RegisterJobLibrary(ScriptingContext& context, sol::table& library);
 			virtual void RegisterMatchLibrary(ScriptingContext& context, sol::table& library);
 			virtual void RegisterNetworkLibrary(ScriptingContext& context, sol::table& library);
 			virtual void RegisterPhysicsLibrary(ScriptingContext& context, sol::table& library);
@@ -43,7 +48,18 @@ namespace bw
 			virtual void RegisterTimerLibrary(ScriptingContext& context, sol::table& library);
 
 		private:
+			struct JobResult
+			{
+				std::string error;
+				std::vector<ScriptMessageValue> values;
+				bool success;
+			};
+
+			void HandleJobResult(Nz::UInt64 jobId, JobResult& result);
+
+			tsl::hopscotch_map<Nz::UInt64 /*jobId*/, sol::main_protected_function> m_pendingJobs;
 			SharedMatch& m_match;
+			Nz::UInt64 m_nextJobId;
 	};
 }
 
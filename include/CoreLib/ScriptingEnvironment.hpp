@@ -30,6 +30,8 @@ namespace bw
 
 			bool Execute(const std::string& command);
 
+			template<typename F> void RegisterFunction(const std::string& name, F&& func);
+
 			void SetOutputCallback(OutputCallback callback);
 
 			ScriptingEnvironment& operator=(const ScriptingEnvironment&) = delete;
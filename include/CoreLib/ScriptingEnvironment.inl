@@ -3,7 +3,14 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/ScriptingEnvironment.hpp>
+#include <CoreLib/Scripting/ScriptingUtils.hpp>
 
 namespace bw
 {
+	template<typename F>
+	void ScriptingEnvironment::RegisterFunction(const std::string& name, F&& func)
+	{
+		sol::state& luaState = m_scriptingContext->GetLuaState();
+		luaState[name] = LuaFunction(std::forward<F>(func));
+	}
 }
@@ -9,7 +9,10 @@
 
 #include <CoreLib/Export.hpp>
 #include <CoreLib/PlayerCommandStore.hpp>
+#include <CoreLib/SharedPacket.hpp>
+#include <CoreLib/TypedPacket.hpp>
 #include <Nazara/Core/Signal.hpp>
+#include <functional>
 
 namespace bw
 {
@@ -19,6 +22,7 @@ namespace bw
 	{
 		public:
 			struct SessionInfo;
+			using SerializationJob = std::function<void(Nz::NetPacket& packet)>;
 
 			inline SessionBridge(MatchClientSession* session);
 			virtual ~SessionBridge();
@@ -33,14 +37,21 @@ namespace bw
 			virtual void HandleConnection(Nz::UInt32 data);
 			virtual void HandleDisconnection(Nz::UInt32 data);
 			virtual void HandleIncomingPacket(Nz::NetPacket& packet);
+			virtual void HandleIncomingTypedPacket(TypedPacket& packet);
 
 			virtual void QueryInfo(std::function<void(const SessionInfo& info)> callback) const = 0;
 
+			virtual void SendDeferredPacket(Nz::UInt8 channelId, Nz::ENetPacketFlags flags, SerializationJob serializationJob);
 			virtual void SendPacket(Nz::UInt8 channelId, Nz::ENetPacketFlags flags, Nz::NetPacket&& data) = 0;
+			virtual void SendSharedPacket(const SharedPacketRef& packet);
+			virtual void SendTypedPacket(TypedPacket&& packet);
+
+			virtual bool SupportsTypedPackets() const;
 
 			NazaraSignal(OnConnected, Nz::UInt32 /*data*/);
 			NazaraSignal(OnDisconnected, Nz::UInt32 /*data*/);
 			NazaraSignal(OnIncomingPacket, Nz::NetPacket& /*packet*/);
+			NazaraSignal(OnIncomingTypedPacket, TypedPacket& /*packet*/);
 
 			struct SessionInfo
 			{
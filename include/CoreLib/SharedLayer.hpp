@@ -10,6 +10,7 @@
 #include <CoreLib/Export.hpp>
 #include <CoreLib/LayerIndex.hpp>
 #include <NDK/World.hpp>
+#include <vector>
 
 namespace bw
 {
@@ -18,6 +19,8 @@ namespace bw
 	class BURGWAR_CORELIB_API SharedLayer
 	{
 		public:
+			struct PhysicsSettings;
+
 			SharedLayer(SharedMatch& match, LayerIndex layerIndex);
 			SharedLayer(const SharedLayer&) = delete;
 			SharedLayer(SharedLayer&&) noexcept = default;
@@ -27,15 +30,40 @@ namespace bw
 
 			inline LayerIndex GetLayerIndex() const;
 			inline SharedMatch& GetMatch();
+			inline const PhysicsSettings& GetPhysicsSettings() const;
 			Ndk::World& GetWorld();
 			const Ndk::World& GetWorld() const;
 
+			void ConfigurePhysics(const PhysicsSettings& settings);
+
+			void EnablePhysicsUpdate(bool enable);
+
+			void StepPhysics(float elapsedTime);
+
 			virtual void TickUpdate(float elapsedTime);
 
 			SharedLayer& operator=(const SharedLayer&) = delete;
 			SharedLayer& operator=(SharedLayer&&) = delete;
 
+			struct PhysicsSettings
+			{
+				float sleepTime = 0.f; //< 0 disables sleeping
+				float spatialHashCellSize = 0.f; //< 0 keeps the default bounding box tree
+				Nz::UInt32 iterationCount = 10;
+				Nz::UInt32 spatialHashEntityCount = 0;
+			};
+
 		private:
+			void RegisterProfiledSystems();
+
+			struct ProfiledSystem
+			{
+				Ndk::BaseSystem* system;
+				std::size_t sectionIndex;
+			};
+
+			std::vector<ProfiledSystem> m_profiledSystems;
+			PhysicsSettings m_physicsSettings;
 			SharedMatch& m_match;
 			Ndk::World m_world;
 			LayerIndex m_layerIndex;
@@ -23,6 +23,11 @@ namespace bw
 	{
 		return m_match;
 	}
+
+	inline auto SharedLayer::GetPhysicsSettings() const -> const PhysicsSettings&
+	{
+		return m_physicsSettings;
+	}
 	
 	inline Ndk::World& SharedLayer::GetWorld()
 	{
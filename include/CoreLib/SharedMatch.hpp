@@ -9,11 +9,16 @@
 
 #include <CoreLib/Export.hpp>
 #include <CoreLib/SharedLayer.hpp>
+#include <CoreLib/TickProfiler.hpp>
 #include <CoreLib/TimerManager.hpp>
 #include <CoreLib/LogSystem/MatchLogger.hpp>
 #include <CoreLib/Protocol/NetworkStringStore.hpp>
+#include <CoreLib/Scripting/NetworkPacket.hpp>
 #include <CoreLib/Scripting/ScriptHandlerRegistry.hpp>
 #include <NDK/Entity.hpp>
+#include <tsl/hopscotch_map.h>
+#include <array>
+#include <mutex>
 
 namespace bw
 {
@@ -27,33 +32,71 @@ namespace bw
 	class BURGWAR_CORELIB_API SharedMatch
 	{
 		public:
+			// Load shedding levels, each one includes the previous ones
+			enum class LoadLevel
+			{
+				Normal,             //< everything runs at full rate
+				DeferNonCritical,   //< non-critical work (master server, ping updates) is deferred
+				ReduceNetworkRate,  //< match state snapshots are sent every other tick
+				StretchScripts,     //< interval-based script ticks run at a slower rate
+
+				Max = StretchScripts
+			};
+
+			struct TickDurationHistogram
+			{
+				static constexpr std::array<Nz::UInt64, 9> BucketBounds = { 1'000, 2'000, 4'000, 8'000, 16'000, 33'000, 50'000, 100'000, 250'000 }; //< microseconds (inclusive upper bound)
+
+				std::array<Nz::UInt64, BucketBounds.size() + 1> tickCounts = {}; //< per bucket, the last one counts ticks slower than every bound
+				Nz::UInt64 totalDuration = 0; //< microseconds
+			};
+
 			SharedMatch(BurgApp& app, LogSide side, std::string matchName, float tickDuration);
 			SharedMatch(const SharedMatch&) = delete;
 			SharedMatch(SharedMatch&&) = delete;
 			virtual ~SharedMatch();
 
+			void DispatchScriptPacket(const Packets::ScriptPacket& packet);
+
+			inline void EnableLoadShedding(bool enable);
+
 			virtual void ForEachEntity(std::function<void(const Ndk::EntityHandle& entity)> func) = 0;
 
+			std::string FormatLoadStatistics() const;
+
+			inline BurgApp& GetApp();
 			inline Nz::UInt64 GetCurrentTick() const;
 			inline Nz::UInt64 GetCurrentTime() const;
+			inline Nz::UInt64 GetDiscardedTickCount() const;
 			virtual SharedEntityStore& GetEntityStore() = 0;
 			virtual const SharedEntityStore& GetEntityStore() const = 0;
 			inline MatchLogger& GetLogger();
 			virtual SharedLayer& GetLayer(LayerIndex layerIndex) = 0;
 			virtual const SharedLayer& GetLayer(LayerIndex layerIndex) const = 0;
 			virtual LayerIndex GetLayerCount() const = 0;
+			inline LoadLevel GetLoadLevel() const;
 			inline const std::string& GetName() const;
 			virtual const NetworkStringStore& GetNetworkStringStore() const = 0;
 			inline Nz::UInt16 GetNetworkTick() const;
 			inline Nz::UInt16 GetNetworkTick(Nz::UInt64 tick) const;
+			inline std::recursive_mutex& GetScriptMutex();
 			inline ScriptHandlerRegistry& GetScriptPacketHandlerRegistry();
 			inline const ScriptHandlerRegistry& GetScriptPacketHandlerRegistry() const;
+			inline const NetworkPacketSchema* GetScriptPacketSchema(const std::string& packetName) const;
 			virtual std::shared_ptr<const SharedGamemode> GetSharedGamemode() const = 0;
 			inline float GetTickDuration() const;
+			inline const TickDurationHistogram& GetTickDurationHistogram() const;
+			inline TickProfiler& GetTickProfiler();
+			inline const TickProfiler& GetTickProfiler() const;
+			inline float GetTickTimer() const; //< time since the last tick was due, while ticking: since the current tick was due
 			inline TimerManager& GetTimerManager();
 			virtual SharedWeaponStore& GetWeaponStore() = 0;
 			virtual const SharedWeaponStore& GetWeaponStore() const = 0;
 
+			inline bool IsLoadSheddingEnabled() const;
+
+			inline void RegisterScriptPacketSchema(std::string packetName, NetworkPacketSchema schema);
+
 			virtual const Ndk::EntityHandle& RetrieveEntityByUniqueId(EntityId uniqueId) const = 0;
 			virtual EntityId RetrieveUniqueIdByEntity(const Ndk::EntityHandle& entity) const = 0;
 
@@ -65,17 +108,32 @@ namespace bw
 		protected:
 			virtual void OnTick(bool lastTick) = 0;
 
+			void SetTickDuration(float tickDuration);
+
 		private:
+			void UpdateLoadLevel(float elapsedTime);
+
+			std::array<Nz::UInt64, static_cast<std::size_t>(LoadLevel::Max) + 1> m_loadLevelTickCounts;
+			BurgApp& m_app;
 			std::string m_name;
 			MatchLogger m_logger;
 			ScriptHandlerRegistry m_scriptPacketHandler;
+			tsl::hopscotch_map<std::string, NetworkPacketSchema> m_scriptPacketSchemas;
+			std::recursive_mutex m_scriptMutex; //< serializes script calls made while layers are updated in parallel
+			TickDurationHistogram m_tickDurations;
+			TickProfiler m_tickProfiler;
 			TimerManager m_timerManager;
 			Nz::UInt64 m_currentTick;
 			Nz::UInt64 m_currentTime;
+			Nz::UInt64 m_discardedTickCount;
+			LoadLevel m_loadLevel;
+			std::size_t m_tickProfilerSection;
 			float m_floatingTime;
+			float m_loadLevelCooldown;
 			float m_maxTickTimer;
 			float m_tickDuration;
 			float m_tickTimer;
+			bool m_isLoadSheddingEnabled;
 	};
 }
 
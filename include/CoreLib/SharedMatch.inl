@@ -7,6 +7,18 @@
 
 namespace bw
 {
+	inline void SharedMatch::EnableLoadShedding(bool enable)
+	{
+		m_isLoadSheddingEnabled = enable;
+		if (!enable)
+			m_loadLevel = LoadLevel::Normal;
+	}
+
+	inline BurgApp& SharedMatch::GetApp()
+	{
+		return m_app;
+	}
+
 	inline Nz::UInt64 SharedMatch::GetCurrentTick() const
 	{
 		return m_currentTick;
@@ -17,6 +29,16 @@ namespace bw
 		return m_currentTime;
 	}
 
+	inline Nz::UInt64 SharedMatch::GetDiscardedTickCount() const
+	{
+		return m_discardedTickCount;
+	}
+
+	inline auto SharedMatch::GetLoadLevel() const -> LoadLevel
+	{
+		return m_loadLevel;
+	}
+
 	inline auto SharedMatch::GetLogger() -> MatchLogger&
 	{
 		return m_logger;
@@ -37,6 +59,11 @@ namespace bw
 		return static_cast<Nz::UInt16>(tick % (0xFFFFU + 1));
 	}
 
+	inline std::recursive_mutex& SharedMatch::GetScriptMutex()
+	{
+		return m_scriptMutex;
+	}
+
 	inline ScriptHandlerRegistry& SharedMatch::GetScriptPacketHandlerRegistry()
 	{
 		return m_scriptPacketHandler;
@@ -47,13 +74,52 @@ namespace bw
 		return m_scriptPacketHandler;
 	}
 
+	inline const NetworkPacketSchema* SharedMatch::GetScriptPacketSchema(const std::string& packetName) const
+	{
+		auto it = m_scriptPacketSchemas.find(packetName);
+		if (it == m_scriptPacketSchemas.end())
+			return nullptr;
+
+		return &it->second;
+	}
+
 	inline float SharedMatch::GetTickDuration() const
 	{
 		return m_tickDuration;
 	}
 
+	inline auto SharedMatch::GetTickDurationHistogram() const -> const TickDurationHistogram&
+	{
+		return m_tickDurations;
+	}
+
+	inline TickProfiler& SharedMatch::GetTickProfiler()
+	{
+		return m_tickProfiler;
+	}
+
+	inline const TickProfiler& SharedMatch::GetTickProfiler() const
+	{
+		return m_tickProfiler;
+	}
+
+	inline float SharedMatch::GetTickTimer() const
+	{
+		return m_tickTimer;
+	}
+
 	inline TimerManager& SharedMatch::GetTimerManager()
 	{
 		return m_timerManager;
 	}
+
+	inline bool SharedMatch::IsLoadSheddingEnabled() const
+	{
+		return m_isLoadSheddingEnabled;
+	}
+
+	inline void SharedMatch::RegisterScriptPacketSchema(std::string packetName, NetworkPacketSchema schema)
+	{
+		m_scriptPacketSchemas.insert_or_assign(std::move(packetName), std::move(schema));
+	}
 }
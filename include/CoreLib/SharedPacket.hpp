@@ -0,0 +1,28 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_SHAREDPACKET_HPP
+#define BURGWAR_CORELIB_SHAREDPACKET_HPP
+
+#include <Nazara/Network/Enums.hpp>
+#include <Nazara/Network/NetPacket.hpp>
+#include <memory>
+
+namespace bw
+{
+	// Packet serialized once and sent to multiple sessions
+	struct SharedPacket
+	{
+		std::size_t packetId;
+		Nz::ENetPacketFlags flags;
+		Nz::NetPacket data;
+		Nz::UInt8 channelId;
+	};
+
+	using SharedPacketRef = std::shared_ptr<const SharedPacket>;
+}
+
+#endif
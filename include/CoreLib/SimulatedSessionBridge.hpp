@@ -0,0 +1,85 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_SIMULATEDSESSIONBRIDGE_HPP
+#define BURGWAR_CORELIB_SIMULATEDSESSIONBRIDGE_HPP
+
+#include <CoreLib/Export.hpp>
+#include <CoreLib/SessionBridge.hpp>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace bw
+{
+	// Wraps another bridge to simulate bad network conditions (for testing purposes)
+	// Outgoing packets are delayed, lost, duplicated or reordered according to their flags (reliable packets are never lost but delayed by a resend)
+	// Incoming packets flags are unknown, they are only delayed (in order)
+	class BURGWAR_CORELIB_API SimulatedSessionBridge : public SessionBridge
+	{
+		public:
+			struct Conditions;
+
+			SimulatedSessionBridge(std::shared_ptr<SessionBridge> bridge, const Conditions& conditions);
+			~SimulatedSessionBridge() = default;
+
+			void Disconnect() override;
+
+			inline const Conditions& GetConditions() const;
+
+			bool IsLocal() const override;
+
+			void Poll();
+
+			void QueryInfo(std::function<void(const SessionInfo& info)> callback) const override;
+
+			void SendPacket(Nz::UInt8 channelId, Nz::ENetPacketFlags flags, Nz::NetPacket&& packet) override;
+
+			struct Conditions
+			{
+				Nz::UInt32 jitter = 0; //< maximum random delay added to latency (in milliseconds)
+				Nz::UInt32 latency = 0; //< one-way delay (in milliseconds)
+				Nz::UInt32 seed = 0; //< random seed, for reproducible runs
+				float duplicationRate = 0.f;
+				float lossRate = 0.f;
+				float reorderRate = 0.f;
+			};
+
+		private:
+			Nz::UInt64 ComputeDeliveryTime(Nz::UInt64 now);
+			void SchedulePacket(bool outgoing, Nz::UInt8 channelId, Nz::ENetPacketFlags flags, Nz::NetPacket&& packet);
+			bool TestProbability(float probability);
+
+			struct PendingPacket
+			{
+				Nz::NetPacket packet;
+				Nz::UInt64 deliveryTime;
+				Nz::UInt64 sequence;
+				Nz::ENetPacketFlags flags;
+				Nz::UInt8 channelId;
+				bool outgoing;
+			};
+
+			NazaraSlot(SessionBridge, OnConnected, m_onConnectedSlot);
+			NazaraSlot(SessionBridge, OnDisconnected, m_onDisconnectedSlot);
+			NazaraSlot(SessionBridge, OnIncomingPacket, m_onIncomingPacketSlot);
+
+			std::minstd_rand m_randomGenerator;
+			std::shared_ptr<SessionBridge> m_bridge;
+			std::vector<PendingPacket> m_duePackets;
+			std::vector<PendingPacket> m_pendingPackets;
+			std::vector<Nz::UInt64> m_lastSequencedDelivery; //< indexed by channel, unreliable sequenced packets older than this are dropped
+			Conditions m_conditions;
+			Nz::UInt32 m_lostPacketCount;
+			Nz::UInt64 m_lastIncomingDeliveryTime;
+			Nz::UInt64 m_lastReliableDeliveryTime;
+			Nz::UInt64 m_nextSequence;
+	};
+}
+
+#include <CoreLib/SimulatedSessionBridge.inl>
+
+#endif
@@ -8,13 +8,17 @@
 #define BURGWAR_CLIENTLIB_SYSTEMS_ANIMATIONSYSTEM_HPP
 
 #include <CoreLib/Export.hpp>
+#include <CoreLib/Components/AnimationComponent.hpp>
 #include <NDK/System.hpp>
+#include <tsl/hopscotch_map.h>
+#include <limits>
 #include <vector>
 
 namespace bw
 {
 	class SharedMatch;
 
+	// Only playing animations are checked, their end times are kept contiguous
 	class BURGWAR_CORELIB_API AnimationSystem : public Ndk::System<AnimationSystem>
 	{
 		public:
@@ -24,8 +28,30 @@ namespace bw
 			static Ndk::SystemIndex systemIndex;
 
 		private:
+			void AddPlayingAnimation(AnimationComponent& animation);
+			void RemovePlayingAnimation(std::size_t playingIndex);
+
+			void OnEntityAdded(Ndk::Entity* entity) override;
+			void OnEntityRemoved(Ndk::Entity* entity) override;
 			void OnUpdate(float elapsedTime) override;
 
+			struct EntityData
+			{
+				std::size_t playingIndex = InvalidIndex;
+
+				NazaraSlot(AnimationComponent, OnAnimationStart, onAnimationStart);
+			};
+
+			struct PlayingAnimation
+			{
+				Nz::UInt64 endTime;
+				AnimationComponent* animation;
+			};
+
+			static constexpr std::size_t InvalidIndex = std::numeric_limits<std::size_t>::max();
+
+			tsl::hopscotch_map<Ndk::EntityId, EntityData> m_entityData;
+			std::vector<PlayingAnimation> m_playingAnimations;
 			SharedMatch& m_match;
 	};
 }
@@ -0,0 +1,43 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_SYSTEMS_ELEMENTINDEXSYSTEM_HPP
+#define BURGWAR_CORELIB_SYSTEMS_ELEMENTINDEXSYSTEM_HPP
+
+#include <CoreLib/Export.hpp>
+#include <NDK/EntityList.hpp>
+#include <NDK/System.hpp>
+#include <tsl/hopscotch_map.h>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	// Keeps scripted entities of a layer indexed by element class, so scripts can query them without going through every entity
+	class BURGWAR_CORELIB_API ElementIndexSystem : public Ndk::System<ElementIndexSystem>
+	{
+		public:
+			ElementIndexSystem();
+			~ElementIndexSystem() = default;
+
+			inline const Ndk::EntityList* FindEntitiesByClass(const std::string& elementClass) const;
+
+			static Ndk::SystemIndex systemIndex;
+
+		private:
+			void OnEntityRemoved(Ndk::Entity* entity) override;
+			void OnEntityValidation(Ndk::Entity* entity, bool justAdded) override;
+			void OnUpdate(float elapsedTime) override;
+
+			tsl::hopscotch_map<Ndk::EntityId, std::size_t> m_entityClasses;
+			tsl::hopscotch_map<std::string, std::size_t> m_classIndices;
+			std::vector<Ndk::EntityList> m_classEntities;
+	};
+}
+
+#include <CoreLib/Systems/ElementIndexSystem.inl>
+
+#endif
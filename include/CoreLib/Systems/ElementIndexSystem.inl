@@ -0,0 +1,17 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Systems/ElementIndexSystem.hpp>
+
+namespace bw
+{
+	inline const Ndk::EntityList* ElementIndexSystem::FindEntitiesByClass(const std::string& elementClass) const
+	{
+		auto it = m_classIndices.find(elementClass);
+		if (it == m_classIndices.end())
+			return nullptr;
+
+		return &m_classEntities[it->second];
+	}
+}
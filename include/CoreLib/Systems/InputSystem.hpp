@@ -8,11 +8,15 @@
 #define BURGWAR_CORELIB_SYSTEMS_INPUTSYSTEM_HPP
 
 #include <CoreLib/Export.hpp>
+#include <CoreLib/Components/InputComponent.hpp>
+#include <NDK/EntityList.hpp>
 #include <NDK/System.hpp>
+#include <tsl/hopscotch_map.h>
 #include <vector>
 
 namespace bw
 {
+	// Entities with a scripted input controller are kept apart, native ones are updated without ever going through Lua
 	class BURGWAR_CORELIB_API InputSystem : public Ndk::System<InputSystem>
 	{
 		public:
@@ -22,7 +26,21 @@ namespace bw
 			static Ndk::SystemIndex systemIndex;
 
 		private:
+			void OnEntityAdded(Ndk::Entity* entity) override;
+			void OnEntityRemoved(Ndk::Entity* entity) override;
 			void OnUpdate(float elapsedTime) override;
+			void RefreshControllerKind(Ndk::Entity* entity, const InputComponent& inputComponent);
+
+			static void UpdateInputs(const Ndk::EntityList& entities);
+
+			struct EntityData
+			{
+				NazaraSlot(InputComponent, OnControllerUpdate, onControllerUpdate);
+			};
+
+			tsl::hopscotch_map<Ndk::EntityId, EntityData> m_entityData;
+			Ndk::EntityList m_nativeControlledEntities;
+			Ndk::EntityList m_scriptControlledEntities;
 	};
 }
 
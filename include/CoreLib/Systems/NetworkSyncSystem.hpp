@@ -14,12 +14,17 @@
 #include <CoreLib/Components/InputComponent.hpp>
 #include <CoreLib/Components/NetworkSyncComponent.hpp>
 #include <CoreLib/Components/WeaponWielderComponent.hpp>
+#include <CoreLib/Protocol/Packets.hpp>
 #include <CoreLib/Scripting/ScriptedElement.hpp>
 #include <Nazara/Core/Signal.hpp>
 #include <Nazara/Math/Angle.hpp>
 #include <Nazara/Math/Vector2.hpp>
+#include <Nazara/Core/Bitset.hpp>
+#include <Nazara/Core/Flags.hpp>
 #include <NDK/System.hpp>
 #include <tsl/hopscotch_map.h>
+#include <array>
+#include <memory>
 #include <optional>
 #include <string>
 #include <variant>
@@ -27,6 +32,34 @@
 
 namespace bw
 {
+	// Per-entity state which changed during the tick and has to be sent to clients
+	enum class NetworkDirtyFlag
+	{
+		Animation,
+		Health,
+		Inputs,
+		Movement, //< static entities only, physical ones are part of the movement snapshot
+		Physics,
+		Scale,
+		Weapon,
+
+		Max = Weapon
+	};
+}
+
+namespace Nz
+{
+	template<>
+	struct EnumAsFlags<bw::NetworkDirtyFlag>
+	{
+		static constexpr bw::NetworkDirtyFlag max = bw::NetworkDirtyFlag::Max;
+	};
+}
+
+namespace bw
+{
+	using NetworkDirtyFlags = Nz::Flags<NetworkDirtyFlag>;
+
 	class Player;
 	class TerrainLayer;
 
@@ -34,24 +67,30 @@ namespace bw
 	{
 		public:
 			struct EntityCreation;
+			struct EntityCreationPayload;
 			struct EntityDestruction;
 			struct EntityMovement;
+			struct MovementSnapshot;
 
 			NetworkSyncSystem(TerrainLayer& layer);
 			~NetworkSyncSystem() = default;
 
+			inline void BuildCreationEvent(EntityCreation& creationEvent, Ndk::Entity* entity) const;
+
 			void CreateEntities(const std::function<void(const EntityCreation* entityCreation, std::size_t entityCount)>& callback) const;
 			void DeleteEntities(const std::function<void(const EntityDestruction* entityDestruction, std::size_t entityCount)>& callback) const;
 			
 			inline TerrainLayer& GetLayer();
 			inline const TerrainLayer& GetLayer() const;
-			
-			void MoveEntities(const std::function<void(const EntityMovement* entityMovement, std::size_t entityCount)>& callback) const;
+			inline const MovementSnapshot& GetMovementSnapshot() const;
+			inline const Nz::Bitset<Nz::UInt64>& GetUpdatedEntities(NetworkDirtyFlag flag) const; //< entities of the events being signaled, empty outside of signals
 
 			inline void NotifyPhysicsUpdate(const Ndk::EntityHandle& entity);
 			inline void NotifyMovementUpdate(const Ndk::EntityHandle& entity);
 			inline void NotifyScaleUpdate(const Ndk::EntityHandle& entity);
 
+			void UpdateMovementSnapshot();
+
 			static Ndk::SystemIndex systemIndex;
 
 			struct HealthProperties
@@ -95,9 +134,18 @@ namespace bw
 				std::optional<PlayerInputData> inputs;
 				std::optional<PlayerMovementData> playerMovement;
 				std::optional<PhysicsProperties> physicsProperties;
-				std::string entityClass;
-				tsl::hopscotch_map<std::string /*key*/, PropertyValue> properties;
+				std::shared_ptr<const EntityCreationPayload> payload;
 				std::vector<std::pair<LayerIndex, Ndk::EntityId>> dependentIds;
+				Nz::UInt64 eventId; //< non-zero for events signaled to every session, events sharing an id hold the same data
+				bool respawned; //< entity was taken back from a pool, clients which kept it can reuse it
+			};
+
+			// Parts of the creation event which don't change during the entity lifetime, built once and shared by every session
+			struct EntityCreationPayload
+			{
+				Nz::UInt32 entityClass; //< network string index
+				std::vector<EntityId> dependentUniqueIds; //< entities referenced by properties
+				std::vector<Packets::Helper::Property> properties; //< shared properties only, names are network string indices
 			};
 
 			struct EntityDeath
@@ -108,6 +156,7 @@ namespace bw
 			struct EntityDestruction
 			{
 				Ndk::EntityId entityId;
+				bool recycled; //< entity went back to its layer pool and may be respawned later
 			};
 
 			struct EntityHealth
@@ -159,23 +208,47 @@ namespace bw
 				std::optional<PhysicsProperties> physicsProperties;
 			};
 
+			// Moving physical entities state (awake ones, or recently changed ones with MatchSettings::movementSync), stored field by field and built once per tick (see UpdateMovementSnapshot) for every session
+			struct MovementSnapshot
+			{
+				enum Flags : Nz::UInt8
+				{
+					HasPlayerMovement = 1 << 0,
+					IsFacingRight     = 1 << 1
+				};
+
+				inline std::size_t GetEntityCount() const;
+
+				std::vector<Ndk::EntityId> entityIds;
+				std::vector<Nz::Vector2f> positions;
+				std::vector<Nz::RadianAnglef> rotations;
+				std::vector<Nz::Vector2f> linearVelocities;
+				std::vector<Nz::RadianAnglef> angularVelocities;
+				std::vector<Nz::UInt8> flags;
+				std::vector<Nz::UInt8> priorities; //< see NetworkSyncComponent::Settings
+				std::vector<Nz::UInt16> updateIntervals; //< minimum network ticks between two updates sent to a client
+			};
+
 			NazaraSignal(OnEntityCreated, NetworkSyncSystem* /*emitter*/, const EntityCreation& /*event*/);
 			NazaraSignal(OnEntityDeath, NetworkSyncSystem* /*emitter*/, const EntityDeath& /*event*/);
 			NazaraSignal(OnEntityDeleted, NetworkSyncSystem* /*emitter*/, const EntityDestruction& /*event*/);
-			NazaraSignal(OnEntityPlayAnimation, NetworkSyncSystem* /*emitter*/, const EntityPlayAnimation& /*event*/);
 			NazaraSignal(OnEntityInvalidated, NetworkSyncSystem* /*emitter*/, const EntityMovement& /*event*/);
 			NazaraSignal(OnEntitiesInputUpdate, NetworkSyncSystem* /*emitter*/, const EntityInputs* /*events*/, std::size_t /*entityCount*/);
 			NazaraSignal(OnEntitiesHealthUpdate, NetworkSyncSystem* /*emitter*/, const EntityHealth* /*events*/, std::size_t /*entityCount*/);
+			NazaraSignal(OnEntitiesPlayAnimation, NetworkSyncSystem* /*emitter*/, const EntityPlayAnimation* /*events*/, std::size_t /*entityCount*/);
 			NazaraSignal(OnEntitiesPhysicsUpdate, NetworkSyncSystem* /*emitter*/, const EntityPhysics* /*events*/, std::size_t /*entityCount*/);
 			NazaraSignal(OnEntitiesScaleUpdate, NetworkSyncSystem* /*emitter*/, const EntityScale* /*events*/, std::size_t /*entityCount*/);
 			NazaraSignal(OnEntitiesWeaponUpdate, NetworkSyncSystem* /*emitter*/, const EntityWeapon* /*events*/, std::size_t /*entityCount*/);
 
 		private:
+			std::shared_ptr<const EntityCreationPayload> BuildCreationPayload(Ndk::Entity* entity) const;
 			void BuildEvent(EntityCreation& creationEvent, Ndk::Entity* entity) const;
 			void BuildEvent(EntityDeath& deathEvent, Ndk::Entity* entity) const;
 			void BuildEvent(EntityDestruction& deleteEvent, Ndk::Entity* entity) const;
 			void BuildEvent(EntityMovement& movementEvent, Ndk::Entity* entity) const;
 
+			inline void MarkDirty(Ndk::Entity* entity, NetworkDirtyFlag flag);
+
 			void OnEntityAdded(Ndk::Entity* entity) override;
 			void OnEntityRemoved(Ndk::Entity* entity) override;
 			void OnUpdate(float elapsedTime) override;
@@ -190,24 +263,35 @@ namespace bw
 				NazaraSlot(WeaponWielderComponent, OnNewWeaponSelection, onNewWeaponSelection);
 			};
 
+			struct MovementState
+			{
+				Nz::RadianAnglef rotation;
+				Nz::Vector2f position;
+				Nz::UInt64 lastChangeTick;
+				Nz::UInt8 flags;
+				bool isSleeping;
+			};
+
 			tsl::hopscotch_map<Ndk::EntityId, EntitySlots> m_entitySlots;
+			tsl::hopscotch_map<Ndk::EntityId, std::shared_ptr<const EntityCreationPayload>> m_creationPayloads;
+			tsl::hopscotch_map<Ndk::EntityId, MovementState> m_movementStates; //< last significant state of each body (see MatchSettings::movementSync)
+
+			static constexpr std::size_t NetworkDirtyFlagCount = static_cast<std::size_t>(NetworkDirtyFlag::Max) + 1;
 
-			Ndk::EntityList m_inputUpdateEntities;
-			Ndk::EntityList m_healthUpdateEntities;
-			Ndk::EntityList m_movedStaticEntities;
+			std::array<Nz::Bitset<Nz::UInt64>, NetworkDirtyFlagCount> m_updatedEntities;
 			Ndk::EntityList m_physicsEntities;
-			Ndk::EntityList m_physicsUpdateEntities;
-			Ndk::EntityList m_scaleUpdateEntities;
 			Ndk::EntityList m_staticEntities;
-			Ndk::EntityList m_weaponUpdateEntities;
-			mutable std::vector<EntityCreation> m_creationEvents;
-			mutable std::vector<EntityDestruction> m_destructionEvents;
+			Nz::Bitset<Nz::UInt64> m_dirtyEntities; //< entities with at least one dirty flag
 			std::vector<EntityHealth> m_healthEvents;
 			std::vector<EntityInputs> m_inputEvents;
+			std::vector<EntityMovement> m_movementEvents;
 			std::vector<EntityPhysics> m_physicsEvent;
+			std::vector<EntityPlayAnimation> m_playAnimationEvents;
 			std::vector<EntityScale> m_scaleEvent;
 			std::vector<EntityWeapon> m_weaponEvents;
-			mutable std::vector<EntityMovement> m_movementEvents;
+			std::vector<NetworkDirtyFlags> m_entityDirtyFlags; //< indexed by entity id
+			MovementSnapshot m_movementSnapshot;
+			Nz::UInt64 m_lastCreationEventId;
 			TerrainLayer& m_layer;
 	};
 }
@@ -6,6 +6,11 @@
 
 namespace bw
 {
+	inline void NetworkSyncSystem::BuildCreationEvent(EntityCreation& creationEvent, Ndk::Entity* entity) const
+	{
+		BuildEvent(creationEvent, entity);
+	}
+
 	inline TerrainLayer& NetworkSyncSystem::GetLayer()
 	{
 		return m_layer;
@@ -16,21 +21,47 @@ namespace bw
 		return m_layer;
 	}
 
+	inline auto NetworkSyncSystem::GetMovementSnapshot() const -> const MovementSnapshot&
+	{
+		return m_movementSnapshot;
+	}
+
+	inline const Nz::Bitset<Nz::UInt64>& NetworkSyncSystem::GetUpdatedEntities(NetworkDirtyFlag flag) const
+	{
+		return m_updatedEntities[static_cast<std::size_t>(flag)];
+	}
+
+	inline void NetworkSyncSystem::MarkDirty(Ndk::Entity* entity, NetworkDirtyFlag flag)
+	{
+		Ndk::EntityId entityId = entity->GetId();
+		if (entityId >= m_entityDirtyFlags.size())
+			m_entityDirtyFlags.resize(entityId + 1);
+
+		m_entityDirtyFlags[entityId] |= flag;
+		m_dirtyEntities.UnboundedSet(entityId);
+	}
+
 	inline void NetworkSyncSystem::NotifyPhysicsUpdate(const Ndk::EntityHandle& entity)
 	{
 		if (m_physicsEntities.Has(entity))
-			m_physicsUpdateEntities.Insert(entity);
+			MarkDirty(entity, NetworkDirtyFlag::Physics);
 	}
 
 	inline void NetworkSyncSystem::NotifyMovementUpdate(const Ndk::EntityHandle& entity)
 	{
 		// Dynamic entities are sent regulary, only send static for now (TODO: Handle teleportation this way)
 		if (m_staticEntities.Has(entity))
-			m_movedStaticEntities.Insert(entity);
+			MarkDirty(entity, NetworkDirtyFlag::Movement);
 	}
 
 	inline void NetworkSyncSystem::NotifyScaleUpdate(const Ndk::EntityHandle& entity)
 	{
-		m_scaleUpdateEntities.Insert(entity);
+		if (HasEntity(entity))
+			MarkDirty(entity, NetworkDirtyFlag::Scale);
+	}
+
+	inline std::size_t NetworkSyncSystem::MovementSnapshot::GetEntityCount() const
+	{
+		return entityIds.size();
 	}
 }
@@ -9,10 +9,21 @@
 
 #include <CoreLib/Export.hpp>
 #include <NDK/System.hpp>
+#include <tsl/hopscotch_map.h>
 #include <vector>
 
+namespace Ndk
+{
+	class NodeComponent;
+	class PhysicsComponent2D;
+}
+
 namespace bw
 {
+	class InputComponent;
+	class PlayerMovementComponent;
+
+	// Components used every tick are packed contiguously, so lots of AI-controlled entities don't go through entity lookups
 	class BURGWAR_CORELIB_API PlayerMovementSystem : public Ndk::System<PlayerMovementSystem>
 	{
 		public:
@@ -25,6 +36,18 @@ namespace bw
 			void OnEntityAdded(Ndk::Entity* entity) override;
 			void OnEntityRemoved(Ndk::Entity* entity) override;
 			void OnUpdate(float elapsedTime) override;
+
+			struct MovementData
+			{
+				InputComponent* input;
+				PlayerMovementComponent* movement;
+				Ndk::NodeComponent* node;
+				Ndk::PhysicsComponent2D* physics;
+				Ndk::EntityId entityId;
+			};
+
+			tsl::hopscotch_map<Ndk::EntityId, std::size_t> m_movementIndices;
+			std::vector<MovementData> m_movementData;
 	};
 }
 
@@ -10,27 +10,55 @@
 #include <CoreLib/Export.hpp>
 #include <NDK/EntityList.hpp>
 #include <NDK/System.hpp>
+#include <tsl/hopscotch_map.h>
+#include <array>
 #include <vector>
 
 namespace bw
 {
 	class SharedMatch;
 
+	// Schedules entities tick callbacks on a wheel of frames, so only due entities are visited
 	class BURGWAR_CORELIB_API TickCallbackSystem : public Ndk::System<TickCallbackSystem>
 	{
 		public:
 			TickCallbackSystem(SharedMatch& match);
 			~TickCallbackSystem() = default;
 
+			void Reschedule(Ndk::Entity* entity);
+
 			static Ndk::SystemIndex systemIndex;
 
 		private:
 			void OnEntityRemoved(Ndk::Entity* entity) override;
 			void OnEntityValidation(Ndk::Entity* entity, bool justAdded) override;
 			void OnUpdate(float elapsedTime) override;
+			void Schedule(Ndk::EntityId entityId, float timeBeforeTick);
+
+			static constexpr std::size_t WheelSize = 256; //< frames, ticks further away are visited once per lap
+			static constexpr Nz::UInt64 MaxPhaseSpread = 4; //< frames an interval tick may be delayed by to even out buckets
+			static constexpr Nz::UInt64 PhaseSpreadMinInterval = 8; //< frames, shorter intervals are never delayed
+
+			struct EntityTick
+			{
+				double lastUpdateTime; //< script time when the entity tick countdown was last brought up to date
+				Nz::UInt32 serial = 0; //< incremented on each scheduling, older wheel entries are ignored
+			};
+
+			struct ScheduledTick
+			{
+				Ndk::EntityId entityId;
+				Nz::UInt32 serial;
+				Nz::UInt64 dueFrame;
+			};
 
+			std::array<std::vector<ScheduledTick>, WheelSize> m_tickWheel;
+			std::vector<ScheduledTick> m_dueTicks;
+			tsl::hopscotch_map<Ndk::EntityId, EntityTick> m_entityTicks;
 			Ndk::EntityList m_tickableEntities;
 			SharedMatch& m_match;
+			Nz::UInt64 m_currentFrame;
+			double m_scriptTime;
 	};
 }
 
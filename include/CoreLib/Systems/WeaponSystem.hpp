@@ -8,25 +8,42 @@
 #define BURGWAR_CORELIB_SYSTEMS_WEAPONSYSTEM_HPP
 
 #include <CoreLib/Export.hpp>
+#include <CoreLib/Components/WeaponComponent.hpp>
+#include <NDK/Entity.hpp>
 #include <NDK/EntityList.hpp>
 #include <NDK/System.hpp>
+#include <tsl/hopscotch_map.h>
 #include <vector>
 
 namespace bw
 {
 	class SharedMatch;
 
+	// Only active weapons (the ones held in hand) are visited, dropped and holstered weapons cost nothing per tick
+	// Held weapons are polled rather than scheduled on the match timers: cooldowns are only checked when an attack is attempted, and aim follows the owner inputs every tick
 	class BURGWAR_CORELIB_API WeaponSystem : public Ndk::System<WeaponSystem>
 	{
 		public:
 			WeaponSystem(SharedMatch& match);
 			~WeaponSystem() = default;
 
+			inline const Ndk::EntityHandle& GetAttackingWeapon() const; //< weapon whose attack callbacks are running, if any
+
 			static Ndk::SystemIndex systemIndex;
 
 		private:
+			void OnEntityAdded(Ndk::Entity* entity) override;
+			void OnEntityRemoved(Ndk::Entity* entity) override;
 			void OnUpdate(float elapsedTime) override;
 
+			struct EntityData
+			{
+				NazaraSlot(WeaponComponent, OnActiveUpdate, onActiveUpdate);
+			};
+
+			tsl::hopscotch_map<Ndk::EntityId, EntityData> m_entityData;
+			Ndk::EntityHandle m_attackingWeapon;
+			Ndk::EntityList m_activeWeapons;
 			SharedMatch& m_match;
 	};
 }
@@ -6,4 +6,8 @@
 
 namespace bw
 {
+	inline const Ndk::EntityHandle& WeaponSystem::GetAttackingWeapon() const
+	{
+		return m_attackingWeapon;
+	}
 }
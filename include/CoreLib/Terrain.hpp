@@ -10,11 +10,16 @@
 #include <CoreLib/Export.hpp>
 #include <CoreLib/Map.hpp>
 #include <CoreLib/TerrainLayer.hpp>
+#include <CoreLib/Scripting/ScriptHandlerRegistry.hpp>
+#include <CoreLib/Scripting/ScriptMessageValue.hpp>
+#include <mutex>
+#include <string>
 #include <vector>
 
 namespace bw
 {
 	class Match;
+	class WorkerPool;
 
 	class BURGWAR_CORELIB_API Terrain
 	{
@@ -23,22 +28,55 @@ namespace bw
 			Terrain(const Terrain&) = delete;
 			~Terrain() = default;
 
+			void ActivateLayer(LayerIndex layerIndex);
+
+			inline const std::vector<LayerIndex>& GetAdjacentLayers(LayerIndex layerIndex) const;
 			inline TerrainLayer& GetLayer(LayerIndex layerIndex);
 			inline const TerrainLayer& GetLayer(LayerIndex layerIndex) const;
 			inline LayerIndex GetLayerCount() const;
+			inline ScriptHandlerRegistry& GetLayerMessageHandlers(LayerIndex layerIndex);
 			inline const Map& GetMap() const;
 
 			void Initialize();
 
+			inline bool IsLayerActive(LayerIndex layerIndex) const;
+
+			void PostLayerMessage(LayerIndex layerIndex, std::string name, ScriptMessageValue value);
+
 			void Reset();
 
+			inline void SetAdjacentLayers(LayerIndex layerIndex, std::vector<LayerIndex> adjacentLayers);
+			inline void SetWorkerPool(WorkerPool* workerPool);
+
 			void Update(float elapsedTime);
 
 			Terrain& operator=(const Terrain&) = delete;
 
 		private:
+			void DispatchLayerMessages();
+			void HibernateLayer(TerrainLayer& layer);
+			void HibernateUnvisitedLayers();
+			void RecordHitboxes();
+			void UpdateMovementSnapshots();
+
+			struct LayerMessage
+			{
+				std::string name;
+				ScriptMessageValue value;
+				LayerIndex layerIndex;
+			};
+
+			Match& m_match;
 			Map& m_map;
+			std::mutex m_layerMessageMutex;
+			std::vector<LayerMessage> m_dispatchedLayerMessages;
+			std::vector<LayerMessage> m_pendingLayerMessages;
+			std::vector<ScriptHandlerRegistry> m_layerMessageHandlers;
+			std::vector<std::vector<LayerIndex>> m_adjacentLayers; //< layers players can reach directly from a layer (doors, teleporters), prefetched by their clients
 			std::vector<TerrainLayer> m_layers; //< Shouldn't resize because of raw pointer in Player
+			WorkerPool* m_workerPool;
+			Nz::UInt64 m_nextHibernationCheck;
+			std::size_t m_parallelPhysicsProfilerSection;
 	};
 }
 
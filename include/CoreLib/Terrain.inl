@@ -7,6 +7,12 @@
 
 namespace bw
 {
+	inline const std::vector<LayerIndex>& Terrain::GetAdjacentLayers(LayerIndex layerIndex) const
+	{
+		assert(layerIndex < m_adjacentLayers.size());
+		return m_adjacentLayers[layerIndex];
+	}
+
 	inline TerrainLayer& Terrain::GetLayer(LayerIndex layerIndex)
 	{
 		assert(layerIndex < m_layers.size());
@@ -24,8 +30,31 @@ namespace bw
 		return LayerIndex(m_layers.size());
 	}
 
+	inline ScriptHandlerRegistry& Terrain::GetLayerMessageHandlers(LayerIndex layerIndex)
+	{
+		assert(layerIndex < m_layerMessageHandlers.size());
+		return m_layerMessageHandlers[layerIndex];
+	}
+
 	inline const Map& Terrain::GetMap() const
 	{
 		return m_map;
 	}
+
+	inline bool Terrain::IsLayerActive(LayerIndex layerIndex) const
+	{
+		return GetLayer(layerIndex).IsActive();
+	}
+
+	inline void Terrain::SetAdjacentLayers(LayerIndex layerIndex, std::vector<LayerIndex> adjacentLayers)
+	{
+		assert(layerIndex < m_adjacentLayers.size());
+		m_adjacentLayers[layerIndex] = std::move(adjacentLayers);
+	}
+
+	// When set, layers physics are stepped concurrently; script collision callbacks are serialized and must stay in their own layer
+	inline void Terrain::SetWorkerPool(WorkerPool* workerPool)
+	{
+		m_workerPool = workerPool;
+	}
 }
@@ -7,9 +7,20 @@
 #ifndef BURGWAR_CORELIB_TERRAINLAYER_HPP
 #define BURGWAR_CORELIB_TERRAINLAYER_HPP
 
+#include <CoreLib/EntityId.hpp>
 #include <CoreLib/Export.hpp>
+#include <CoreLib/HitboxHistory.hpp>
 #include <CoreLib/Map.hpp>
+#include <CoreLib/MatchCheckpoint.hpp>
 #include <CoreLib/SharedLayer.hpp>
+#include <CoreLib/Components/ScriptComponent.hpp>
+#include <Nazara/Core/Bitset.hpp>
+#include <Nazara/Math/Quaternion.hpp>
+#include <Nazara/Math/Vector3.hpp>
+#include <tsl/hopscotch_map.h>
+#include <tsl/hopscotch_set.h>
+#include <optional>
+#include <vector>
 
 namespace bw
 {
@@ -26,17 +37,80 @@ namespace bw
 			TerrainLayer(TerrainLayer&&) noexcept = default;
 			~TerrainLayer() = default;
 
+			void CaptureCheckpoint(MatchCheckpoint::Layer& layerCheckpoint);
+
+			inline HitboxHistory& GetHitboxHistory();
+			inline const HitboxHistory& GetHitboxHistory() const;
 			Match& GetMatch();
 
+			inline bool IsActive() const;
+			inline bool IsEntityRecycled(Ndk::EntityId entityId) const;
+
+			bool RecycleEntity(const Ndk::EntityHandle& entity);
 			void ResetEntities();
+			const Ndk::EntityHandle& RespawnEntity(std::size_t elementIndex, EntityId uniqueId, const Nz::Vector2f& position, const Nz::DegreeAnglef& rotation, PropertyValueMap properties);
+			void RestoreCheckpoint(const MatchCheckpoint::Layer& layerCheckpoint);
 
 			TerrainLayer& operator=(const TerrainLayer&) = delete;
 			TerrainLayer& operator=(TerrainLayer&&) = delete;
 
 		private:
+			struct EntitySnapshot;
+
+			void CaptureInitialState();
+			bool CaptureEntity(const Ndk::EntityHandle& entity, EntitySnapshot& snapshot) const;
+			void ClearEntityPools();
+			std::vector<Ndk::EntityHandle> CreateMapEntities();
 			void InitializeEntities();
+			bool RestoreEntity(const Ndk::EntityHandle& entity, const EntitySnapshot& snapshot) const;
+			bool RestoreInitialState();
+
+			struct PhysicsSnapshot
+			{
+				Nz::RadianAnglef angularVelocity;
+				Nz::RadianAnglef rotation;
+				Nz::Vector2f linearVelocity;
+				Nz::Vector2f position;
+				float mass;
+				float momentOfInertia;
+				bool isSleeping;
+			};
+
+			struct EntitySnapshot
+			{
+				std::size_t mapEntityIndex;
+				std::optional<Nz::UInt16> health;
+				std::optional<PhysicsSnapshot> physics;
+				Nz::Bitset<> componentBits;
+				Nz::Quaternionf rotation;
+				Nz::Vector3f position;
+				Nz::Vector3f scale;
+				ScriptComponent::State scriptState;
+			};
+
+			// Map entities state right after their initialization, restored on reset instead of running init scripts again
+			struct InitialState
+			{
+				std::vector<EntitySnapshot> entities;
+				std::vector<std::size_t> recreatedEntities; //< map entities whose state cannot be captured
+			};
+
+			struct PooledEntity
+			{
+				Ndk::EntityHandle entity;
+				Nz::UInt64 recycleTick;
+			};
+
+			// Pooled entities are disabled, wait a few ticks before respawning them so every system sees them leaving
+			static constexpr Nz::UInt64 RespawnTickDelay = 2;
 
+			std::optional<InitialState> m_initialState;
+			tsl::hopscotch_map<std::size_t /*elementIndex*/, std::vector<PooledEntity>> m_entityPools; //< oldest first
+			tsl::hopscotch_set<Ndk::EntityId> m_recycledEntities;
 			const Map::Layer& m_mapLayer;
+			HitboxHistory m_hitboxHistory;
+			Nz::UInt64 m_lastVisibleTick; //< used by Terrain to hibernate layers
+			bool m_isActive; //< inactive layers have no map entities (see MatchSettings::lazyLayerActivation)
 	};
 }
 
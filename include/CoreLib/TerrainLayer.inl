@@ -6,4 +6,23 @@
 
 namespace bw
 {
+	inline HitboxHistory& TerrainLayer::GetHitboxHistory()
+	{
+		return m_hitboxHistory;
+	}
+
+	inline const HitboxHistory& TerrainLayer::GetHitboxHistory() const
+	{
+		return m_hitboxHistory;
+	}
+
+	inline bool TerrainLayer::IsActive() const
+	{
+		return m_isActive;
+	}
+
+	inline bool TerrainLayer::IsEntityRecycled(Ndk::EntityId entityId) const
+	{
+		return m_recycledEntities.find(entityId) != m_recycledEntities.end();
+	}
 }
@@ -0,0 +1,100 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_TICKPROFILER_HPP
+#define BURGWAR_CORELIB_TICKPROFILER_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bw
+{
+	// Accumulates time spent in named sections during a tick, and keeps one sample per section for the last ticks
+	class BURGWAR_CORELIB_API TickProfiler
+	{
+		public:
+			class Scope;
+
+			TickProfiler(std::size_t maxSampleCount = 1024);
+			TickProfiler(const TickProfiler&) = delete;
+			TickProfiler(TickProfiler&&) = delete;
+			~TickProfiler() = default;
+
+			inline void Enable(bool enable = true);
+
+			void EndTick();
+
+			void ExportSamples(std::ostream& stream, std::size_t sampleCount) const;
+
+			std::string Format(std::string_view title = "Tick profile", std::string_view sampleName = "ticks") const;
+			std::string FormatSummary(std::size_t sectionCount) const;
+
+			Nz::UInt64 GetSample(std::size_t sectionIndex, std::size_t sampleIndex) const;
+			inline std::size_t GetSampleCount() const;
+
+			inline bool IsEnabled() const;
+
+			inline Scope Profile(std::size_t sectionIndex);
+
+			inline void Record(std::size_t sectionIndex, Nz::UInt64 duration);
+			std::size_t RegisterSection(std::string name);
+
+			void Reset();
+
+			TickProfiler& operator=(const TickProfiler&) = delete;
+			TickProfiler& operator=(TickProfiler&&) = delete;
+
+			class Scope
+			{
+				public:
+					inline Scope(TickProfiler* profiler, std::size_t sectionIndex);
+					Scope(const Scope&) = delete;
+					Scope(Scope&&) = delete;
+					inline ~Scope();
+
+					Scope& operator=(const Scope&) = delete;
+					Scope& operator=(Scope&&) = delete;
+
+				private:
+					TickProfiler* m_profiler;
+					std::size_t m_sectionIndex;
+					Nz::UInt64 m_startTime;
+			};
+
+		private:
+			struct Percentiles
+			{
+				double average;
+				Nz::UInt64 max;
+				Nz::UInt64 p50;
+				Nz::UInt64 p95;
+				Nz::UInt64 p99;
+			};
+
+			struct Section
+			{
+				std::string name;
+				std::vector<Nz::UInt64> samples;
+				Nz::UInt64 tickDuration = 0;
+			};
+
+			Percentiles ComputePercentiles(const Section& section) const;
+
+			std::size_t m_maxSampleCount;
+			std::size_t m_nextSampleIndex;
+			std::size_t m_sampleCount;
+			std::vector<Section> m_sections;
+			bool m_isEnabled;
+	};
+}
+
+#include <CoreLib/TickProfiler.inl>
+
+#endif
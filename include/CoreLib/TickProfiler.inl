@@ -0,0 +1,49 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/TickProfiler.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <cassert>
+
+namespace bw
+{
+	inline void TickProfiler::Enable(bool enable)
+	{
+		m_isEnabled = enable;
+	}
+
+	inline std::size_t TickProfiler::GetSampleCount() const
+	{
+		return m_sampleCount;
+	}
+
+	inline bool TickProfiler::IsEnabled() const
+	{
+		return m_isEnabled;
+	}
+
+	inline auto TickProfiler::Profile(std::size_t sectionIndex) -> Scope
+	{
+		return Scope((m_isEnabled) ? this : nullptr, sectionIndex);
+	}
+
+	inline void TickProfiler::Record(std::size_t sectionIndex, Nz::UInt64 duration)
+	{
+		assert(sectionIndex < m_sections.size());
+		m_sections[sectionIndex].tickDuration += duration;
+	}
+
+	inline TickProfiler::Scope::Scope(TickProfiler* profiler, std::size_t sectionIndex) :
+	m_profiler(profiler),
+	m_sectionIndex(sectionIndex),
+	m_startTime((profiler) ? Nz::GetElapsedMicroseconds() : 0)
+	{
+	}
+
+	inline TickProfiler::Scope::~Scope()
+	{
+		if (m_profiler)
+			m_profiler->Record(m_sectionIndex, Nz::GetElapsedMicroseconds() - m_startTime);
+	}
+}
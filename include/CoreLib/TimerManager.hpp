@@ -9,35 +9,65 @@
 
 #include <CoreLib/Export.hpp>
 #include <Nazara/Prerequisites.hpp>
+#include <array>
 #include <functional>
+#include <limits>
 #include <vector>
 
 namespace bw
 {
 	class SharedMatch;
 
+	// Hierarchical timing wheel, timers are stored in a pool and linked into per-millisecond buckets
 	class BURGWAR_CORELIB_API TimerManager
 	{
 		public:
 			using Callback = std::function<void()>;
 
-			TimerManager() = default;
+			inline TimerManager();
 			~TimerManager() = default;
 
-			inline void Clear();
+			void Clear();
 
-			inline void PushCallback(Nz::UInt64 expirationTime, Callback finish);
+			inline std::size_t GetPendingTimerCount() const;
 
-			inline void Update(Nz::UInt64 now);
+			void PushCallback(Nz::UInt64 expirationTime, Callback callback);
+
+			void Update(Nz::UInt64 now);
+
+			static constexpr std::size_t LevelBits = 6;
+			static constexpr std::size_t LevelCount = 4;
+			static constexpr std::size_t SlotCount = 1 << LevelBits;
 
 		private:
+			struct Bucket
+			{
+				std::size_t first = InvalidIndex;
+				std::size_t last = InvalidIndex;
+			};
+
 			struct Timer
 			{
 				Callback callback;
 				Nz::UInt64 expirationTime;
+				std::size_t next;
 			};
 
-			std::vector<Timer> m_pendingTimers;
+			std::size_t AllocateTimer();
+			void Cascade(std::size_t level, Nz::UInt64 time);
+			bool FireBucket(Bucket bucket);
+			void LinkTimer(std::size_t timerIndex);
+			inline void PushBack(Bucket& bucket, std::size_t timerIndex);
+
+			static constexpr std::size_t InvalidIndex = std::numeric_limits<std::size_t>::max();
+
+			std::array<std::array<Bucket, SlotCount>, LevelCount> m_wheels;
+			std::size_t m_clearCounter;
+			std::size_t m_freeTimer;
+			std::size_t m_pendingTimerCount;
+			std::vector<Timer> m_timers;
+			Bucket m_expiredTimers; //< Timers pushed with an expiration time which has already been processed
+			Nz::UInt64 m_nextTime; //< Next millisecond to be processed by Update
 	};
 }
 
@@ -6,36 +6,28 @@
 
 namespace bw
 {
-	inline void TimerManager::Clear()
+	inline TimerManager::TimerManager() :
+	m_clearCounter(0),
+	m_freeTimer(InvalidIndex),
+	m_pendingTimerCount(0),
+	m_nextTime(0)
 	{
-		m_pendingTimers.clear();
 	}
 
-	inline void TimerManager::PushCallback(Nz::UInt64 expirationTime, Callback callback)
+	inline std::size_t TimerManager::GetPendingTimerCount() const
 	{
-		Timer& timer = m_pendingTimers.emplace_back();
-		timer.callback = std::move(callback);
-		timer.expirationTime = expirationTime;
-
-		//TODO: Insertion sort
+		return m_pendingTimerCount;
 	}
 
-	inline void TimerManager::Update(Nz::UInt64 now)
+	inline void TimerManager::PushBack(Bucket& bucket, std::size_t timerIndex)
 	{
-		// Use index instead of iterator because callback may push new timers
-		for (std::size_t i = 0; i < m_pendingTimers.size();)
-		{
-			if (now > m_pendingTimers[i].expirationTime)
-			{
-				auto it = m_pendingTimers.begin() + i;
+		m_timers[timerIndex].next = InvalidIndex;
 
-				Timer timer = std::move(*it);
-				m_pendingTimers.erase(it);
+		if (bucket.last != InvalidIndex)
+			m_timers[bucket.last].next = timerIndex;
+		else
+			bucket.first = timerIndex;
 
-				timer.callback();
-			}
-			else
-				++i;
-		}
+		bucket.last = timerIndex;
 	}
 }
@@ -0,0 +1,26 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_TYPEDPACKET_HPP
+#define BURGWAR_CORELIB_TYPEDPACKET_HPP
+
+#include <memory>
+
+namespace bw
+{
+	// Packet structure passed as-is between in-process sessions, skipping serialization
+	struct TypedPacket
+	{
+		std::size_t packetId; //< identifies the packet structure type (Packets::*::Type)
+		std::shared_ptr<void> data;
+	};
+
+	template<typename T> TypedPacket BuildTypedPacket(T&& packet);
+}
+
+#include <CoreLib/TypedPacket.inl>
+
+#endif
@@ -0,0 +1,21 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/TypedPacket.hpp>
+#include <type_traits>
+
+namespace bw
+{
+	template<typename T>
+	TypedPacket BuildTypedPacket(T&& packet)
+	{
+		using Packet = std::decay_t<T>;
+
+		TypedPacket typedPacket;
+		typedPacket.data = std::make_shared<Packet>(std::forward<T>(packet));
+		typedPacket.packetId = static_cast<std::size_t>(Packet::Type);
+
+		return typedPacket;
+	}
+}
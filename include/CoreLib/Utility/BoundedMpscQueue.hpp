@@ -0,0 +1,49 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_BOUNDEDMPSCQUEUE_HPP
+#define BURGWAR_CORELIB_BOUNDEDMPSCQUEUE_HPP
+
+#include <atomic>
+#include <memory>
+
+namespace bw
+{
+	// Lock-free fixed-size queue, any thread may push but only one thread at a time may pop
+	template<typename T>
+	class BoundedMpscQueue
+	{
+		public:
+			BoundedMpscQueue(std::size_t capacity); //< rounded up to a power of two
+			BoundedMpscQueue(const BoundedMpscQueue&) = delete;
+			BoundedMpscQueue(BoundedMpscQueue&&) = delete;
+			~BoundedMpscQueue() = default;
+
+			std::size_t GetCapacity() const;
+
+			bool TryPop(T& value);
+			bool TryPush(T&& value); //< fails if queue is full
+
+			BoundedMpscQueue& operator=(const BoundedMpscQueue&) = delete;
+			BoundedMpscQueue& operator=(BoundedMpscQueue&&) = delete;
+
+		private:
+			struct Cell
+			{
+				std::atomic_size_t sequence;
+				T value;
+			};
+
+			std::unique_ptr<Cell[]> m_cells;
+			std::size_t m_mask;
+			alignas(64) std::atomic_size_t m_enqueuePosition;
+			alignas(64) std::size_t m_dequeuePosition;
+	};
+}
+
+#include <CoreLib/Utility/BoundedMpscQueue.inl>
+
+#endif
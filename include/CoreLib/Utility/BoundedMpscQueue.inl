@@ -0,0 +1,77 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/BoundedMpscQueue.hpp>
+#include <cassert>
+#include <cstdint>
+
+namespace bw
+{
+	template<typename T>
+	BoundedMpscQueue<T>::BoundedMpscQueue(std::size_t capacity) :
+	m_enqueuePosition(0),
+	m_dequeuePosition(0)
+	{
+		std::size_t cellCount = 2;
+		while (cellCount < capacity)
+			cellCount *= 2;
+
+		m_cells = std::make_unique<Cell[]>(cellCount);
+		m_mask = cellCount - 1;
+
+		// Each cell sequence tells which position it's waiting for, a push makes it position + 1 (ready to be popped)
+		for (std::size_t i = 0; i < cellCount; ++i)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	template<typename T>
+	std::size_t BoundedMpscQueue<T>::GetCapacity() const
+	{
+		return m_mask + 1;
+	}
+
+	template<typename T>
+	bool BoundedMpscQueue<T>::TryPop(T& value)
+	{
+		Cell& cell = m_cells[m_dequeuePosition & m_mask];
+		std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+		if (static_cast<std::intptr_t>(sequence - (m_dequeuePosition + 1)) < 0)
+			return false; //< empty (or a producer is still writing it)
+
+		value = std::move(cell.value);
+		cell.sequence.store(m_dequeuePosition + m_mask + 1, std::memory_order_release);
+		m_dequeuePosition++;
+
+		return true;
+	}
+
+	template<typename T>
+	bool BoundedMpscQueue<T>::TryPush(T&& value)
+	{
+		Cell* cell;
+		std::size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &m_cells[position & m_mask];
+			std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+
+			std::intptr_t diff = static_cast<std::intptr_t>(sequence - position);
+			if (diff == 0)
+			{
+				// Cell is free, reserve it
+				if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false; //< full, consumer hasn't popped this cell yet
+			else
+				position = m_enqueuePosition.load(std::memory_order_relaxed);
+		}
+
+		cell->value = std::move(value);
+		cell->sequence.store(position + 1, std::memory_order_release);
+
+		return true;
+	}
+}
@@ -19,6 +19,8 @@ namespace bw
 			CircularBuffer(std::size_t maxValueCount);
 			~CircularBuffer();
 
+			void Clear();
+
 			T Dequeue();
 			template<typename... Args> void Enqueue(Args&&... args);
 
@@ -27,6 +29,9 @@ namespace bw
 			bool IsEmpty() const;
 			bool IsFull() const;
 
+			T& operator[](std::size_t index);
+			const T& operator[](std::size_t index) const;
+
 		private:
 			std::size_t CycleIndex(std::size_t index) const;
 
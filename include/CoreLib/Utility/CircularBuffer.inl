@@ -21,13 +21,22 @@ namespace bw
 	template<typename T>
 	CircularBuffer<T>::~CircularBuffer()
 	{
-		for (std::size_t i = m_head; i < m_tail; i = CycleIndex(i + 1))
+		Clear();
+	}
+
+	template<typename T>
+	void CircularBuffer<T>::Clear()
+	{
+		for (std::size_t i = m_head; i != m_tail; i = CycleIndex(i + 1))
 		{
 			T* object = reinterpret_cast<T*>(&m_values[i]);
 			Nz::PlacementDestroy(object);
 		}
+
+		m_head = 0;
+		m_tail = 0;
 	}
-	
+
 	template<typename T>
 	T CircularBuffer<T>::Dequeue()
 	{
@@ -76,6 +85,20 @@ namespace bw
 		return CycleIndex(m_tail + 1) == m_head;
 	}
 
+	template<typename T>
+	T& CircularBuffer<T>::operator[](std::size_t index)
+	{
+		assert(index < GetSize());
+		return *reinterpret_cast<T*>(&m_values[CycleIndex(m_head + index)]);
+	}
+
+	template<typename T>
+	const T& CircularBuffer<T>::operator[](std::size_t index) const
+	{
+		assert(index < GetSize());
+		return *reinterpret_cast<const T*>(&m_values[CycleIndex(m_head + index)]);
+	}
+
 	template<typename T>
 	std::size_t CircularBuffer<T>::CycleIndex(std::size_t index) const
 	{
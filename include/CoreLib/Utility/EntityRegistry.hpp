@@ -0,0 +1,68 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_ENTITYREGISTRY_HPP
+#define BURGWAR_CORELIB_ENTITYREGISTRY_HPP
+
+#include <CoreLib/EntityId.hpp>
+#include <tsl/hopscotch_map.h>
+#include <array>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace bw
+{
+	// Dense map keyed by entity ids: ids index paged arrays (no hashing) pointing into packed value arrays
+	// Values are kept contiguous (swap-and-pop on erase), any pointer returned by Find may be invalidated by Emplace and Erase
+	template<typename T>
+	class EntityRegistry
+	{
+		public:
+			EntityRegistry() = default;
+			EntityRegistry(const EntityRegistry&) = delete;
+			EntityRegistry(EntityRegistry&&) = default;
+			~EntityRegistry() = default;
+
+			void Clear();
+
+			template<typename... Args> T& Emplace(EntityId id, Args&&... args);
+			bool Erase(EntityId id);
+
+			T* Find(EntityId id);
+			const T* Find(EntityId id) const;
+
+			template<typename F> void ForEach(F&& func);
+			template<typename F> void ForEach(F&& func) const;
+
+			std::size_t GetSize() const;
+
+			bool IsEmpty() const;
+
+			EntityRegistry& operator=(const EntityRegistry&) = delete;
+			EntityRegistry& operator=(EntityRegistry&&) = default;
+
+		private:
+			static constexpr std::size_t PageBits = 8;
+			static constexpr std::size_t PageSize = 1 << PageBits;
+			static constexpr std::size_t MaxPageCount = 1 << 16; //< Ids over 2^24 (in absolute value) go through a hash map
+			static constexpr Nz::UInt32 InvalidSlot = std::numeric_limits<Nz::UInt32>::max();
+
+			using Page = std::array<Nz::UInt32, PageSize>;
+
+			Nz::UInt32 GetSlotIndex(EntityId id) const;
+			void SetSlotIndex(EntityId id, Nz::UInt32 slotIndex);
+
+			std::array<std::vector<std::unique_ptr<Page>>, 2> m_pages; //< positive ids first, then negative ids (clientside entities)
+			std::vector<EntityId> m_ids; //< id of each value, same indices as m_values
+			std::vector<T> m_values;
+			tsl::hopscotch_map<EntityId, Nz::UInt32> m_farSlotIndices;
+	};
+}
+
+#include <CoreLib/Utility/EntityRegistry.inl>
+
+#endif
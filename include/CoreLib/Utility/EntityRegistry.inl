@@ -0,0 +1,185 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/EntityRegistry.hpp>
+#include <cassert>
+#include <new>
+
+namespace bw
+{
+	template<typename T>
+	void EntityRegistry<T>::Clear()
+	{
+		for (auto& pages : m_pages)
+			pages.clear();
+
+		m_farSlotIndices.clear();
+		m_ids.clear();
+		m_values.clear();
+	}
+
+	template<typename T>
+	template<typename... Args>
+	T& EntityRegistry<T>::Emplace(EntityId id, Args&&... args)
+	{
+		assert(GetSlotIndex(id) == InvalidSlot);
+
+		Nz::UInt32 slotIndex = static_cast<Nz::UInt32>(m_values.size());
+		T& value = m_values.emplace_back(std::forward<Args>(args)...);
+		m_ids.push_back(id);
+
+		SetSlotIndex(id, slotIndex);
+
+		return value;
+	}
+
+	template<typename T>
+	bool EntityRegistry<T>::Erase(EntityId id)
+	{
+		Nz::UInt32 slotIndex = GetSlotIndex(id);
+		if (slotIndex == InvalidSlot)
+			return false;
+
+		SetSlotIndex(id, InvalidSlot);
+
+		// Release the slot before destroying the value, as its destructor may use the registry
+		T value = std::move(m_values[slotIndex]);
+
+		// Fill the hole with the last value to keep values packed
+		Nz::UInt32 lastIndex = static_cast<Nz::UInt32>(m_values.size() - 1);
+		if (slotIndex != lastIndex)
+		{
+			// Values may not be move-assignable (entity wrappers), relocate the last one in place
+			T* slot = &m_values[slotIndex];
+			slot->~T();
+			new (slot) T(std::move(m_values[lastIndex]));
+
+			m_ids[slotIndex] = m_ids[lastIndex];
+			SetSlotIndex(m_ids[slotIndex], slotIndex);
+		}
+
+		m_ids.pop_back();
+		m_values.pop_back();
+
+		return true;
+	}
+
+	template<typename T>
+	T* EntityRegistry<T>::Find(EntityId id)
+	{
+		Nz::UInt32 slotIndex = GetSlotIndex(id);
+		if (slotIndex == InvalidSlot)
+			return nullptr;
+
+		return &m_values[slotIndex];
+	}
+
+	template<typename T>
+	const T* EntityRegistry<T>::Find(EntityId id) const
+	{
+		Nz::UInt32 slotIndex = GetSlotIndex(id);
+		if (slotIndex == InvalidSlot)
+			return nullptr;
+
+		return &m_values[slotIndex];
+	}
+
+	template<typename T>
+	template<typename F>
+	void EntityRegistry<T>::ForEach(F&& func)
+	{
+		// Indices are used (instead of iterators) as func may emplace or erase values
+		for (std::size_t i = 0; i < m_values.size();)
+		{
+			EntityId id = m_ids[i];
+			func(id, m_values[i]);
+
+			// If func erased the current value, the last one took its place and has yet to be visited
+			if (i < m_ids.size() && m_ids[i] == id)
+				++i;
+		}
+	}
+
+	template<typename T>
+	template<typename F>
+	void EntityRegistry<T>::ForEach(F&& func) const
+	{
+		for (std::size_t i = 0; i < m_values.size(); ++i)
+			func(m_ids[i], m_values[i]);
+	}
+
+	template<typename T>
+	std::size_t EntityRegistry<T>::GetSize() const
+	{
+		return m_values.size();
+	}
+
+	template<typename T>
+	bool EntityRegistry<T>::IsEmpty() const
+	{
+		return m_values.empty();
+	}
+
+	template<typename T>
+	Nz::UInt32 EntityRegistry<T>::GetSlotIndex(EntityId id) const
+	{
+		bool isNegative = (id < 0);
+		Nz::UInt64 position = (isNegative) ? static_cast<Nz::UInt64>(-(id + 1)) : static_cast<Nz::UInt64>(id);
+		Nz::UInt64 pageIndex = position >> PageBits;
+
+		if (pageIndex >= MaxPageCount)
+		{
+			auto it = m_farSlotIndices.find(id);
+			if (it == m_farSlotIndices.end())
+				return InvalidSlot;
+
+			return it->second;
+		}
+
+		const auto& pages = m_pages[(isNegative) ? 1 : 0];
+		if (pageIndex >= pages.size() || !pages[pageIndex])
+			return InvalidSlot;
+
+		return (*pages[pageIndex])[position & (PageSize - 1)];
+	}
+
+	template<typename T>
+	void EntityRegistry<T>::SetSlotIndex(EntityId id, Nz::UInt32 slotIndex)
+	{
+		bool isNegative = (id < 0);
+		Nz::UInt64 position = (isNegative) ? static_cast<Nz::UInt64>(-(id + 1)) : static_cast<Nz::UInt64>(id);
+		Nz::UInt64 pageIndex = position >> PageBits;
+
+		if (pageIndex >= MaxPageCount)
+		{
+			if (slotIndex != InvalidSlot)
+				m_farSlotIndices[id] = slotIndex;
+			else
+				m_farSlotIndices.erase(id);
+
+			return;
+		}
+
+		auto& pages = m_pages[(isNegative) ? 1 : 0];
+		if (pageIndex >= pages.size())
+		{
+			if (slotIndex == InvalidSlot)
+				return;
+
+			pages.resize(pageIndex + 1);
+		}
+
+		auto& page = pages[pageIndex];
+		if (!page)
+		{
+			if (slotIndex == InvalidSlot)
+				return;
+
+			page = std::make_unique<Page>();
+			page->fill(InvalidSlot);
+		}
+
+		(*page)[position & (PageSize - 1)] = slotIndex;
+	}
+}
@@ -0,0 +1,47 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_FILEWATCHER_HPP
+#define BURGWAR_CORELIB_FILEWATCHER_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace bw
+{
+	// Reports files created, modified or removed under a directory and its subdirectories, using OS notifications (no rescan)
+	class BURGWAR_CORELIB_API FileWatcher
+	{
+		public:
+			FileWatcher(std::filesystem::path directory);
+			FileWatcher(const FileWatcher&) = delete;
+			FileWatcher(FileWatcher&&) = delete;
+			~FileWatcher();
+
+			inline const std::filesystem::path& GetDirectory() const;
+
+			inline bool IsValid() const;
+
+			// Appends paths (relative to the watched directory) changed since last poll, an empty path means notifications were lost and anything may have changed
+			void Poll(std::vector<std::filesystem::path>& changedPaths);
+
+			FileWatcher& operator=(const FileWatcher&) = delete;
+			FileWatcher& operator=(FileWatcher&&) = delete;
+
+		private:
+			struct PlatformData;
+
+			std::filesystem::path m_directory;
+			std::unique_ptr<PlatformData> m_platformData; //< null if the directory can't be watched
+	};
+}
+
+#include <CoreLib/Utility/FileWatcher.inl>
+
+#endif
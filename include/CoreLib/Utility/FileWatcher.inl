@@ -0,0 +1,18 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/FileWatcher.hpp>
+
+namespace bw
+{
+	inline const std::filesystem::path& FileWatcher::GetDirectory() const
+	{
+		return m_directory;
+	}
+
+	inline bool FileWatcher::IsValid() const
+	{
+		return m_platformData != nullptr;
+	}
+}
@@ -0,0 +1,52 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_UTILITY_INPLACEFUNCTION_HPP
+#define BURGWAR_CORELIB_UTILITY_INPLACEFUNCTION_HPP
+
+#include <cstddef>
+#include <type_traits>
+
+namespace bw
+{
+	template<typename Signature, std::size_t Capacity = 64> class InplaceFunction;
+
+	// Move-only std::function alternative storing callables up to Capacity bytes in itself, bigger ones are allocated
+	template<typename R, typename... Args, std::size_t Capacity>
+	class InplaceFunction<R(Args...), Capacity>
+	{
+		public:
+			InplaceFunction();
+			InplaceFunction(std::nullptr_t);
+			template<typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, InplaceFunction> && !std::is_same_v<std::decay_t<F>, std::nullptr_t>>> InplaceFunction(F&& function);
+			InplaceFunction(const InplaceFunction&) = delete;
+			InplaceFunction(InplaceFunction&& function) noexcept;
+			~InplaceFunction();
+
+			void Reset();
+
+			explicit operator bool() const;
+
+			R operator()(Args... args);
+
+			InplaceFunction& operator=(const InplaceFunction&) = delete;
+			InplaceFunction& operator=(InplaceFunction&& function) noexcept;
+
+		private:
+			using InvokeFunction = R(*)(void* storage, Args&&... args);
+			using MoveFunction = void(*)(void* source, void* destination); //< destroys source afterwards, only destroys it if destination is null
+
+			template<typename F> static constexpr bool IsStoredInplace = sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+
+			alignas(std::max_align_t) unsigned char m_storage[Capacity];
+			InvokeFunction m_invoke;
+			MoveFunction m_move;
+	};
+}
+
+#include <CoreLib/Utility/InplaceFunction.inl>
+
+#endif
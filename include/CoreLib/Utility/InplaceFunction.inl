@@ -0,0 +1,128 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/InplaceFunction.hpp>
+#include <cassert>
+#include <new>
+#include <utility>
+
+namespace bw
+{
+	template<typename R, typename... Args, std::size_t Capacity>
+	InplaceFunction<R(Args...), Capacity>::InplaceFunction() :
+	m_invoke(nullptr),
+	m_move(nullptr)
+	{
+	}
+
+	template<typename R, typename... Args, std::size_t Capacity>
+	InplaceFunction<R(Args...), Capacity>::InplaceFunction(std::nullptr_t) :
+	InplaceFunction()
+	{
+	}
+
+	template<typename R, typename... Args, std::size_t Capacity>
+	template<typename F, typename>
+	InplaceFunction<R(Args...), Capacity>::InplaceFunction(F&& function)
+	{
+		using Callable = std::decay_t<F>;
+
+		if constexpr (IsStoredInplace<Callable>)
+		{
+			new (m_storage) Callable(std::forward<F>(function));
+
+			m_invoke = [](void* storage, Args&&... args) -> R
+			{
+				return (*static_cast<Callable*>(storage))(std::forward<Args>(args)...);
+			};
+
+			m_move = [](void* source, void* destination)
+			{
+				Callable& callable = *static_cast<Callable*>(source);
+				if (destination)
+					new (destination) Callable(std::move(callable));
+
+				callable.~Callable();
+			};
+		}
+		else
+		{
+			new (m_storage) Callable*(new Callable(std::forward<F>(function)));
+
+			m_invoke = [](void* storage, Args&&... args) -> R
+			{
+				return (**static_cast<Callable**>(storage))(std::forward<Args>(args)...);
+			};
+
+			m_move = [](void* source, void* destination)
+			{
+				Callable* callable = *static_cast<Callable**>(source);
+				if (destination)
+					new (destination) Callable*(callable);
+				else
+					delete callable;
+			};
+		}
+	}
+
+	template<typename R, typename... Args, std::size_t Capacity>
+	InplaceFunction<R(Args...), Capacity>::InplaceFunction(InplaceFunction&& function) noexcept :
+	m_invoke(function.m_invoke),
+	m_move(function.m_move)
+	{
+		if (m_move)
+			m_move(function.m_storage, m_storage);
+
+		function.m_invoke = nullptr;
+		function.m_move = nullptr;
+	}
+
+	template<typename R, typename... Args, std::size_t Capacity>
+	InplaceFunction<R(Args...), Capacity>::~InplaceFunction()
+	{
+		Reset();
+	}
+
+	template<typename R, typename... Args, std::size_t Capacity>
+	void InplaceFunction<R(Args...), Capacity>::Reset()
+	{
+		if (m_move)
+			m_move(m_storage, nullptr);
+
+		m_invoke = nullptr;
+		m_move = nullptr;
+	}
+
+	template<typename R, typename... Args, std::size_t Capacity>
+	InplaceFunction<R(Args...), Capacity>::operator bool() const
+	{
+		return m_invoke != nullptr;
+	}
+
+	template<typename R, typename... Args, std::size_t Capacity>
+	R InplaceFunction<R(Args...), Capacity>::operator()(Args... args)
+	{
+		assert(m_invoke);
+		return m_invoke(m_storage, std::forward<Args>(args)...);
+	}
+
+	template<typename R, typename... Args, std::size_t Capacity>
+	auto InplaceFunction<R(Args...), Capacity>::operator=(InplaceFunction&& function) noexcept -> InplaceFunction&
+	{
+		if (this == &function)
+			return *this;
+
+		Reset();
+
+		m_invoke = function.m_invoke;
+		m_move = function.m_move;
+		if (m_move)
+			m_move(function.m_storage, m_storage);
+
+		function.m_invoke = nullptr;
+		function.m_move = nullptr;
+
+		return *this;
+	}
+}
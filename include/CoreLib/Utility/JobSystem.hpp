@@ -0,0 +1,81 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_UTILITY_JOBSYSTEM_HPP
+#define BURGWAR_CORELIB_UTILITY_JOBSYSTEM_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <concurrentqueue/concurrentqueue.h>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bw
+{
+	enum class JobPriority
+	{
+		High,
+		Normal,
+		Low,
+
+		Max = Low
+	};
+
+	// Application-wide pool of worker threads running independent jobs, each worker has its own queues and steals from others when it runs out of work
+	class BURGWAR_CORELIB_API JobSystem
+	{
+		public:
+			using Job = std::function<void()>;
+
+			JobSystem(std::size_t workerCount);
+			JobSystem(const JobSystem&) = delete;
+			JobSystem(JobSystem&&) = delete;
+			~JobSystem();
+
+			void Dispatch(Job job, JobPriority priority = JobPriority::Normal);
+			template<typename F, typename C> void Dispatch(F&& job, C&& continuation, JobPriority priority = JobPriority::Normal);
+			void DispatchToMainThread(Job job);
+
+			inline std::size_t GetWorkerCount() const;
+
+			void ProcessMainThreadJobs();
+
+			JobSystem& operator=(const JobSystem&) = delete;
+			JobSystem& operator=(JobSystem&&) = delete;
+
+			static constexpr std::size_t PriorityCount = static_cast<std::size_t>(JobPriority::Max) + 1;
+
+		private:
+			bool TryPopJob(std::size_t workerIndex, Job& job);
+			void WorkerMain(std::size_t workerIndex);
+
+			struct WorkerQueue
+			{
+				std::array<std::deque<Job>, PriorityCount> jobs; //< owner pops from the back, thieves from the front
+				std::mutex mutex;
+			};
+
+			std::atomic_size_t m_nextQueue;
+			std::atomic_size_t m_pendingJobCount;
+			std::condition_variable m_jobCondition;
+			std::mutex m_sleepMutex;
+			std::vector<std::thread> m_workers;
+			std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+			moodycamel::ConcurrentQueue<Job> m_mainThreadJobs;
+			bool m_isStopping;
+	};
+}
+
+#include <CoreLib/Utility/JobSystem.inl>
+
+#endif
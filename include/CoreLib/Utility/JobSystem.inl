@@ -0,0 +1,35 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/JobSystem.hpp>
+#include <type_traits>
+
+namespace bw
+{
+	// Runs job on a worker thread, then continuation with its result (if any) on the main thread
+	template<typename F, typename C>
+	void JobSystem::Dispatch(F&& job, C&& continuation, JobPriority priority)
+	{
+		Dispatch([this, job = std::forward<F>(job), continuation = std::forward<C>(continuation)]() mutable
+		{
+			if constexpr (std::is_void_v<std::invoke_result_t<std::decay_t<F>&>>)
+			{
+				job();
+				DispatchToMainThread(std::move(continuation));
+			}
+			else
+			{
+				DispatchToMainThread([continuation = std::move(continuation), result = job()]() mutable
+				{
+					continuation(std::move(result));
+				});
+			}
+		}, priority);
+	}
+
+	inline std::size_t JobSystem::GetWorkerCount() const
+	{
+		return m_workers.size();
+	}
+}
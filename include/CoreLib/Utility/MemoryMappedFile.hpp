@@ -0,0 +1,47 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_MEMORYMAPPEDFILE_HPP
+#define BURGWAR_CORELIB_MEMORYMAPPEDFILE_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <filesystem>
+
+namespace bw
+{
+	// Read-only view of a whole file, pages are loaded by the OS on access and shared between processes
+	class BURGWAR_CORELIB_API MemoryMappedFile
+	{
+		public:
+			inline MemoryMappedFile();
+			inline MemoryMappedFile(const std::filesystem::path& filePath);
+			MemoryMappedFile(const MemoryMappedFile&) = delete;
+			inline MemoryMappedFile(MemoryMappedFile&& file) noexcept;
+			inline ~MemoryMappedFile();
+
+			void Close();
+
+			inline const Nz::UInt8* GetData() const;
+			inline std::size_t GetSize() const;
+
+			inline bool IsOpen() const;
+
+			bool Open(const std::filesystem::path& filePath);
+
+			MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+			inline MemoryMappedFile& operator=(MemoryMappedFile&& file) noexcept;
+
+		private:
+			const Nz::UInt8* m_data;
+			std::size_t m_size;
+			bool m_isOpen;
+	};
+}
+
+#include <CoreLib/Utility/MemoryMappedFile.inl>
+
+#endif
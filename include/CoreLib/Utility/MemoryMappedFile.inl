@@ -0,0 +1,60 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/MemoryMappedFile.hpp>
+#include <utility>
+
+namespace bw
+{
+	inline MemoryMappedFile::MemoryMappedFile() :
+	m_data(nullptr),
+	m_size(0),
+	m_isOpen(false)
+	{
+	}
+
+	inline MemoryMappedFile::MemoryMappedFile(const std::filesystem::path& filePath) :
+	MemoryMappedFile()
+	{
+		Open(filePath);
+	}
+
+	inline MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& file) noexcept :
+	m_data(std::exchange(file.m_data, nullptr)),
+	m_size(std::exchange(file.m_size, 0)),
+	m_isOpen(std::exchange(file.m_isOpen, false))
+	{
+	}
+
+	inline MemoryMappedFile::~MemoryMappedFile()
+	{
+		Close();
+	}
+
+	inline const Nz::UInt8* MemoryMappedFile::GetData() const
+	{
+		return m_data;
+	}
+
+	inline std::size_t MemoryMappedFile::GetSize() const
+	{
+		return m_size;
+	}
+
+	inline bool MemoryMappedFile::IsOpen() const
+	{
+		return m_isOpen;
+	}
+
+	inline MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& file) noexcept
+	{
+		Close();
+
+		m_data = std::exchange(file.m_data, nullptr);
+		m_size = std::exchange(file.m_size, 0);
+		m_isOpen = std::exchange(file.m_isOpen, false);
+
+		return *this;
+	}
+}
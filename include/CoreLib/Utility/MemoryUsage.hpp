@@ -0,0 +1,24 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_UTILITY_MEMORYUSAGE_HPP
+#define BURGWAR_CORELIB_UTILITY_MEMORYUSAGE_HPP
+
+#include <tsl/hopscotch_map.h>
+#include <tsl/hopscotch_set.h>
+#include <vector>
+
+namespace bw
+{
+	// Estimate heap memory owned by a container itself (allocated storage, not memory owned by its elements)
+	template<typename T> std::size_t EstimateMemoryUsage(const std::vector<T>& container);
+	template<typename K, typename V, typename... Args> std::size_t EstimateMemoryUsage(const tsl::hopscotch_map<K, V, Args...>& container);
+	template<typename K, typename... Args> std::size_t EstimateMemoryUsage(const tsl::hopscotch_set<K, Args...>& container);
+}
+
+#include <CoreLib/Utility/MemoryUsage.inl>
+
+#endif
@@ -0,0 +1,33 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/MemoryUsage.hpp>
+#include <cstdint>
+
+namespace bw
+{
+	namespace Detail
+	{
+		// Hopscotch buckets store their value next to a neighborhood bitmap
+		constexpr std::size_t HopscotchBucketOverhead = sizeof(std::uint64_t);
+	}
+
+	template<typename T>
+	std::size_t EstimateMemoryUsage(const std::vector<T>& container)
+	{
+		return container.capacity() * sizeof(T);
+	}
+
+	template<typename K, typename V, typename... Args>
+	std::size_t EstimateMemoryUsage(const tsl::hopscotch_map<K, V, Args...>& container)
+	{
+		return container.bucket_count() * (sizeof(std::pair<K, V>) + Detail::HopscotchBucketOverhead);
+	}
+
+	template<typename K, typename... Args>
+	std::size_t EstimateMemoryUsage(const tsl::hopscotch_set<K, Args...>& container)
+	{
+		return container.bucket_count() * (sizeof(K) + Detail::HopscotchBucketOverhead);
+	}
+}
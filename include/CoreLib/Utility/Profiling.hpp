@@ -0,0 +1,37 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_UTILITY_PROFILING_HPP
+#define BURGWAR_CORELIB_UTILITY_PROFILING_HPP
+
+// Frame profiler (Tracy) instrumentation, compiled in with xmake f --profile_zones=y and expanding to nothing otherwise
+
+#ifdef BURGWAR_PROFILE_ZONES
+
+#include <tracy/Tracy.hpp>
+#include <string_view>
+
+#define bwProfileZone(Name) ZoneScopedN(Name)
+#define bwProfileZoneText(Text) do { std::string_view bwZoneText_(Text); ZoneText(bwZoneText_.data(), bwZoneText_.size()); } while (false)
+#define bwProfileFrame() FrameMark
+#define bwProfileFrameNamed(Name) FrameMarkNamed(Name)
+#define bwProfileThreadName(Name) tracy::SetThreadName(Name)
+#define bwProfileAlloc(Ptr, Size, PoolName) TracyAllocN(Ptr, Size, PoolName)
+#define bwProfileFree(Ptr, PoolName) TracyFreeN(Ptr, PoolName)
+
+#else
+
+#define bwProfileZone(Name) do {} while (false)
+#define bwProfileZoneText(Text) do {} while (false)
+#define bwProfileFrame() do {} while (false)
+#define bwProfileFrameNamed(Name) do {} while (false)
+#define bwProfileThreadName(Name) do {} while (false)
+#define bwProfileAlloc(Ptr, Size, PoolName) do {} while (false)
+#define bwProfileFree(Ptr, PoolName) do {} while (false)
+
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_UTILITY_TICKRINGBUFFER_HPP
+#define BURGWAR_CORELIB_UTILITY_TICKRINGBUFFER_HPP
+
+#include <Nazara/Prerequisites.hpp>
+#include <vector>
+
+namespace bw
+{
+	// Fixed-size history indexed by network tick, pushing a tick overwrites the entry which is capacity ticks older
+	// Entries storage is reused when overwritten (to keep their allocated memory), callers have to reset what they fill
+	template<typename T>
+	class TickRingBuffer
+	{
+		public:
+			TickRingBuffer(std::size_t minCapacity);
+			~TickRingBuffer() = default;
+
+			void Clear();
+
+			T* Find(Nz::UInt16 tick);
+			const T* Find(Nz::UInt16 tick) const;
+			template<typename F> void ForEach(F&& callback) const; //< from oldest to most recent tick
+
+			std::size_t GetCapacity() const;
+
+			T& Push(Nz::UInt16 tick);
+
+			void Remove(Nz::UInt16 tick);
+			void RemoveUntil(Nz::UInt16 tick); //< removes tick and every older one
+
+		private:
+			bool IsInWindow(Nz::UInt16 tick) const;
+
+			struct Slot
+			{
+				T value;
+				Nz::UInt16 tick = 0;
+				bool isValid = false;
+			};
+
+			std::size_t m_mask;
+			std::vector<Slot> m_slots;
+			Nz::UInt16 m_lastTick;
+			bool m_isEmpty;
+	};
+}
+
+#include <CoreLib/Utility/TickRingBuffer.inl>
+
+#endif
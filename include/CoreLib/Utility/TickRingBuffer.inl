@@ -0,0 +1,128 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/TickRingBuffer.hpp>
+#include <CoreLib/Utils.hpp>
+#include <cassert>
+
+namespace bw
+{
+	template<typename T>
+	TickRingBuffer<T>::TickRingBuffer(std::size_t minCapacity) :
+	m_lastTick(0),
+	m_isEmpty(true)
+	{
+		assert(minCapacity > 0 && minCapacity <= 0x8000);
+
+		// A power of two capacity divides the tick range, so slots stay consistent when ticks wrap around
+		std::size_t capacity = 1;
+		while (capacity < minCapacity)
+			capacity *= 2;
+
+		m_mask = capacity - 1;
+		m_slots.resize(capacity);
+	}
+
+	template<typename T>
+	void TickRingBuffer<T>::Clear()
+	{
+		for (Slot& slot : m_slots)
+			slot.isValid = false;
+
+		m_isEmpty = true;
+	}
+
+	template<typename T>
+	T* TickRingBuffer<T>::Find(Nz::UInt16 tick)
+	{
+		if (!IsInWindow(tick))
+			return nullptr;
+
+		Slot& slot = m_slots[tick & m_mask];
+		if (!slot.isValid || slot.tick != tick)
+			return nullptr;
+
+		return &slot.value;
+	}
+
+	template<typename T>
+	const T* TickRingBuffer<T>::Find(Nz::UInt16 tick) const
+	{
+		if (!IsInWindow(tick))
+			return nullptr;
+
+		const Slot& slot = m_slots[tick & m_mask];
+		if (!slot.isValid || slot.tick != tick)
+			return nullptr;
+
+		return &slot.value;
+	}
+
+	template<typename T>
+	template<typename F>
+	void TickRingBuffer<T>::ForEach(F&& callback) const
+	{
+		if (m_isEmpty)
+			return;
+
+		Nz::UInt16 tick = Nz::UInt16(m_lastTick - m_mask);
+		for (std::size_t i = 0; i < m_slots.size(); ++i, ++tick)
+		{
+			const Slot& slot = m_slots[tick & m_mask];
+			if (slot.isValid && slot.tick == tick)
+				callback(slot.value);
+		}
+	}
+
+	template<typename T>
+	std::size_t TickRingBuffer<T>::GetCapacity() const
+	{
+		return m_slots.size();
+	}
+
+	template<typename T>
+	T& TickRingBuffer<T>::Push(Nz::UInt16 tick)
+	{
+		if (m_isEmpty || IsMoreRecent(tick, m_lastTick))
+			m_lastTick = tick;
+
+		m_isEmpty = false;
+
+		Slot& slot = m_slots[tick & m_mask];
+		slot.isValid = true;
+		slot.tick = tick;
+
+		return slot.value;
+	}
+
+	template<typename T>
+	void TickRingBuffer<T>::Remove(Nz::UInt16 tick)
+	{
+		if (!IsInWindow(tick))
+			return;
+
+		Slot& slot = m_slots[tick & m_mask];
+		if (slot.tick == tick)
+			slot.isValid = false;
+	}
+
+	template<typename T>
+	void TickRingBuffer<T>::RemoveUntil(Nz::UInt16 tick)
+	{
+		if (m_isEmpty)
+			return;
+
+		for (Slot& slot : m_slots)
+		{
+			if (slot.isValid && IsInWindow(slot.tick) && !IsMoreRecent(slot.tick, tick))
+				slot.isValid = false;
+		}
+	}
+
+	template<typename T>
+	bool TickRingBuffer<T>::IsInWindow(Nz::UInt16 tick) const
+	{
+		return !m_isEmpty && Nz::UInt16(m_lastTick - tick) <= m_mask;
+	}
+}
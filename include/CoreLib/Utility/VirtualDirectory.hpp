@@ -7,11 +7,14 @@
 #ifndef BURGWAR_CORELIB_VIRTUALDIRECTORY_HPP
 #define BURGWAR_CORELIB_VIRTUALDIRECTORY_HPP
 
+#include <CoreLib/PackFile.hpp>
 #include <Nazara/Prerequisites.hpp>
+#include <tsl/hopscotch_map.h>
 #include <filesystem>
 #include <map>
 #include <memory>
 #include <optional>
+#include <set>
 #include <string>
 #include <variant>
 #include <vector>
@@ -21,31 +24,86 @@ namespace bw
 	class BURGWAR_CORELIB_API VirtualDirectory : public std::enable_shared_from_this<VirtualDirectory>
 	{
 		public:
+			struct DataPointerEntry;
+
 			using FileContentEntry = std::vector<Nz::UInt8>;
 			using PhysicalFileEntry = std::filesystem::path;
 			using VirtualDirectoryEntry = std::shared_ptr<VirtualDirectory>;
 
-			using Entry = std::variant<FileContentEntry, PhysicalFileEntry, VirtualDirectoryEntry>;
+			using Entry = std::variant<FileContentEntry, PhysicalFileEntry, VirtualDirectoryEntry, DataPointerEntry>;
 
 			inline VirtualDirectory(VirtualDirectoryEntry parentDirectory = nullptr);
 			inline VirtualDirectory(std::filesystem::path physicalPath, VirtualDirectoryEntry parentDirectory = nullptr);
 			~VirtualDirectory() = default;
 
+			// Remembers paths resolved by GetEntry until something is stored in this directory or one of its subdirectories
+			inline void EnablePathIndex(bool enable = true);
+
 			template<typename F> void Foreach(F&& cb, bool includeDots = false);
+			template<typename F> void ForeachFile(F&& cb, const std::string& pathPrefix = {});
 
 			inline bool GetEntry(const std::string_view& path, Entry* entry);
+			inline const std::optional<std::filesystem::path>& GetPhysicalPath() const;
+
+			inline bool IsPathIndexEnabled() const;
+
+			// Packed files are looked up after stored entries and before physical files (last mounted packs first), subdirectories already looked up won't see them
+			inline void MountPackFile(const std::string_view& path, std::shared_ptr<const PackFile> packFile);
 
 			inline VirtualDirectoryEntry& StoreDirectory(const std::string_view& path, VirtualDirectoryEntry directory);
 			inline VirtualDirectoryEntry& StoreDirectory(const std::string_view& path, std::filesystem::path directoryPath);
+			inline DataPointerEntry& StoreFile(const std::string_view& path, DataPointerEntry file);
 			inline FileContentEntry& StoreFile(const std::string_view& path, FileContentEntry file);
 			inline PhysicalFileEntry& StoreFile(const std::string_view& path, std::filesystem::path filePath);
 
+			// File content living in memory owned by another object (such as a memory-mapped file), which the entry keeps alive
+			struct DataPointerEntry
+			{
+				std::shared_ptr<const void> owner;
+				const Nz::UInt8* data;
+				std::size_t size;
+			};
+
 		private:
+			struct PathHash
+			{
+				using is_transparent = void;
+
+				std::size_t operator()(std::string_view path) const { return std::hash<std::string_view>()(path); }
+			};
+
+			struct PathEqual
+			{
+				using is_transparent = void;
+
+				bool operator()(std::string_view lhs, std::string_view rhs) const { return lhs == rhs; }
+			};
+
+			struct PackMount
+			{
+				std::shared_ptr<const PackFile> packFile;
+				std::string prefix; //< empty or ending with a slash
+			};
+
+			struct ResolvedEntry
+			{
+				const Entry* entry = nullptr; //< points inside the owning directory content, nullptr for physical and packed files
+				const PackFile::Entry* packEntry = nullptr;
+				std::shared_ptr<const PackFile> packFile;
+				PhysicalFileEntry physicalPath;
+			};
+
+			inline VirtualDirectoryEntry CreateSubdirectory(const std::string_view& name);
 			inline void EnsureDots();
-			inline bool RetrieveDirectory(const std::string_view& path, bool allowCreation, std::shared_ptr<VirtualDirectory>& directory, std::string_view& entryName);
 			inline bool GetEntryInternal(const std::string_view& name, Entry* entry);
+			inline bool GetIndexedEntry(const std::string_view& path, Entry* entry);
+			inline void InvalidatePathIndex();
+			inline bool ResolveEntryInternal(const std::string_view& name, ResolvedEntry& resolvedEntry);
+			inline bool RetrieveDirectory(const std::string_view& path, bool allowCreation, std::shared_ptr<VirtualDirectory>& directory, std::string_view& entryName);
+			inline void RetrieveEntry(const ResolvedEntry& resolvedEntry, Entry* entry);
 			inline VirtualDirectoryEntry& StoreDirectoryInternal(std::string name, std::filesystem::path directoryPath);
 			inline VirtualDirectoryEntry& StoreDirectoryInternal(std::string name, VirtualDirectoryEntry directory);
+			inline DataPointerEntry& StoreFileInternal(std::string name, DataPointerEntry file);
 			inline FileContentEntry& StoreFileInternal(std::string name, FileContentEntry file);
 			inline PhysicalFileEntry& StoreFileInternal(std::string name, std::filesystem::path file);
 
@@ -53,7 +111,10 @@ namespace bw
 
 			std::map<std::string /*name*/, Entry, std::less<>> m_content;
 			std::optional<std::filesystem::path> m_physicalPath;
+			std::vector<PackMount> m_packMounts;
+			tsl::hopscotch_map<std::string /*path*/, ResolvedEntry, PathHash, PathEqual> m_pathIndex;
 			VirtualDirectoryEntry m_parent;
+			bool m_isPathIndexEnabled;
 			bool m_wereDotRegistered;
 	};
 }
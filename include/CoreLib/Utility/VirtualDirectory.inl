@@ -9,6 +9,7 @@ namespace bw
 {
 	inline VirtualDirectory::VirtualDirectory(VirtualDirectoryEntry parentDirectory) :
 	m_parent(std::move(parentDirectory)),
+	m_isPathIndexEnabled(false),
 	m_wereDotRegistered(false)
 	{
 	}
@@ -16,10 +17,47 @@ namespace bw
 	inline VirtualDirectory::VirtualDirectory(std::filesystem::path physicalPath, VirtualDirectoryEntry parentDirectory) :
 	m_physicalPath(std::move(physicalPath)),
 	m_parent(std::move(parentDirectory)),
+	m_isPathIndexEnabled(false),
 	m_wereDotRegistered(false)
 	{
 	}
 
+	inline auto VirtualDirectory::CreateSubdirectory(const std::string_view& name) -> VirtualDirectoryEntry
+	{
+		VirtualDirectoryEntry directory;
+		if (m_physicalPath)
+		{
+			std::filesystem::path entryPath = *m_physicalPath / name;
+			if (std::filesystem::is_directory(entryPath))
+				directory = std::make_shared<VirtualDirectory>(std::move(entryPath), shared_from_this());
+		}
+
+		// Subdirectories see every pack having files in them, in the same mount order
+		for (const PackMount& packMount : m_packMounts)
+		{
+			std::string directoryPrefix = packMount.prefix;
+			directoryPrefix += name;
+			directoryPrefix += '/';
+
+			if (!packMount.packFile->HasDirectory(directoryPrefix))
+				continue;
+
+			if (!directory)
+				directory = std::make_shared<VirtualDirectory>(shared_from_this());
+
+			directory->m_packMounts.push_back({ packMount.packFile, std::move(directoryPrefix) });
+		}
+
+		return directory;
+	}
+
+	inline void VirtualDirectory::EnablePathIndex(bool enable)
+	{
+		m_isPathIndexEnabled = enable;
+		if (!enable)
+			m_pathIndex.clear();
+	}
+
 	template<typename F>
 	void VirtualDirectory::Foreach(F&& cb, bool includeDots)
 	{
@@ -34,6 +72,34 @@ namespace bw
 			cb(pair.first, pair.second);
 		}
 
+		// Packed entries hide physical ones and those of previously mounted packs
+		std::set<std::string, std::less<>> packedNames;
+		for (auto mountIt = m_packMounts.rbegin(); mountIt != m_packMounts.rend(); ++mountIt)
+		{
+			mountIt->packFile->ForeachChild(mountIt->prefix, [&](const std::string_view& name, const PackFile::Entry* packEntry)
+			{
+				if (m_content.find(name) != m_content.end() || packedNames.find(name) != packedNames.end())
+					return;
+
+				Entry entry;
+				if (packEntry)
+				{
+					ResolvedEntry resolvedEntry;
+					resolvedEntry.packEntry = packEntry;
+					resolvedEntry.packFile = mountIt->packFile;
+
+					RetrieveEntry(resolvedEntry, &entry);
+				}
+				else
+					entry.emplace<VirtualDirectoryEntry>(CreateSubdirectory(name));
+
+				std::string entryName(name);
+				cb(entryName, entry);
+
+				packedNames.insert(std::move(entryName));
+			});
+		}
+
 		if (m_physicalPath)
 		{
 			for (auto&& physicalEntry : std::filesystem::directory_iterator(*m_physicalPath))
@@ -41,8 +107,8 @@ namespace bw
 				Entry entry;
 
 				std::string filename = physicalEntry.path().filename().generic_u8string();
-				if (m_content.find(filename) != m_content.end())
-					continue; //< Physical file/directory has been overriden by a virtual one
+				if (m_content.find(filename) != m_content.end() || packedNames.find(filename) != packedNames.end())
+					continue; //< Physical file/directory has been overriden by a virtual or packed one
 
 				if (physicalEntry.is_regular_file())
 					entry.emplace<PhysicalFileEntry>(physicalEntry.path());
@@ -59,8 +125,25 @@ namespace bw
 		}
 	}
 
+	template<typename F>
+	void VirtualDirectory::ForeachFile(F&& cb, const std::string& pathPrefix)
+	{
+		Foreach([&](const std::string& entryName, const Entry& entry)
+		{
+			std::string entryPath = (pathPrefix.empty()) ? entryName : pathPrefix + '/' + entryName;
+
+			if (std::holds_alternative<VirtualDirectoryEntry>(entry))
+				std::get<VirtualDirectoryEntry>(entry)->ForeachFile(cb, entryPath);
+			else
+				cb(entryPath, entry);
+		});
+	}
+
 	inline bool VirtualDirectory::GetEntry(const std::string_view& path, Entry* entry)
 	{
+		if (m_isPathIndexEnabled)
+			return GetIndexedEntry(path, entry);
+
 		std::shared_ptr<VirtualDirectory> dir;
 		std::string_view entryName;
 		if (!RetrieveDirectory(path, false, dir, entryName))
@@ -72,6 +155,43 @@ namespace bw
 		return true;
 	}
 
+	inline const std::optional<std::filesystem::path>& VirtualDirectory::GetPhysicalPath() const
+	{
+		return m_physicalPath;
+	}
+
+	inline bool VirtualDirectory::IsPathIndexEnabled() const
+	{
+		return m_isPathIndexEnabled;
+	}
+
+	inline void VirtualDirectory::MountPackFile(const std::string_view& path, std::shared_ptr<const PackFile> packFile)
+	{
+		std::shared_ptr<VirtualDirectory> dir = shared_from_this();
+		if (!path.empty())
+		{
+			std::string_view entryName;
+			if (!RetrieveDirectory(path, true, dir, entryName))
+				throw std::runtime_error("invalid path");
+
+			Entry entry;
+			if (dir->GetEntryInternal(entryName, &entry))
+			{
+				if (auto directory = std::get_if<VirtualDirectoryEntry>(&entry))
+					dir = *directory;
+				else
+					throw std::runtime_error("invalid path");
+			}
+			else
+				dir = dir->StoreDirectoryInternal(std::string(entryName), std::make_shared<VirtualDirectory>(dir));
+		}
+
+		InvalidatePathIndex();
+		dir->InvalidatePathIndex();
+
+		dir->m_packMounts.push_back({ std::move(packFile), std::string() });
+	}
+
 	inline auto VirtualDirectory::StoreDirectory(const std::string_view& path, VirtualDirectoryEntry directory) -> VirtualDirectoryEntry&
 	{
 		std::shared_ptr<VirtualDirectory> dir;
@@ -79,6 +199,9 @@ namespace bw
 		if (!RetrieveDirectory(path, true, dir, entryName))
 			throw std::runtime_error("invalid path");
 
+		InvalidatePathIndex();
+		dir->InvalidatePathIndex();
+
 		return dir->StoreDirectoryInternal(std::string(entryName), std::move(directory));
 	}
 
@@ -89,9 +212,25 @@ namespace bw
 		if (!RetrieveDirectory(path, true, dir, entryName))
 			throw std::runtime_error("invalid path");
 
+		InvalidatePathIndex();
+		dir->InvalidatePathIndex();
+
 		return dir->StoreDirectoryInternal(std::string(entryName), std::move(directoryPath));
 	}
 
+	inline auto VirtualDirectory::StoreFile(const std::string_view& path, DataPointerEntry file) -> DataPointerEntry&
+	{
+		std::shared_ptr<VirtualDirectory> dir;
+		std::string_view entryName;
+		if (!RetrieveDirectory(path, true, dir, entryName))
+			throw std::runtime_error("invalid path");
+
+		InvalidatePathIndex();
+		dir->InvalidatePathIndex();
+
+		return dir->StoreFileInternal(std::string(entryName), std::move(file));
+	}
+
 	inline auto VirtualDirectory::StoreFile(const std::string_view& path, FileContentEntry file) -> FileContentEntry&
 	{
 		std::shared_ptr<VirtualDirectory> dir;
@@ -99,6 +238,9 @@ namespace bw
 		if (!RetrieveDirectory(path, true, dir, entryName))
 			throw std::runtime_error("invalid path");
 
+		InvalidatePathIndex();
+		dir->InvalidatePathIndex();
+
 		return dir->StoreFileInternal(std::string(entryName), std::move(file));
 	}
 
@@ -109,6 +251,9 @@ namespace bw
 		if (!RetrieveDirectory(path, true, dir, entryName))
 			throw std::runtime_error("invalid path");
 
+		InvalidatePathIndex();
+		dir->InvalidatePathIndex();
+
 		return dir->StoreFileInternal(std::string(entryName), std::move(filePath));
 	}
 
@@ -160,36 +305,122 @@ namespace bw
 	}
 
 	inline bool VirtualDirectory::GetEntryInternal(const std::string_view& name, Entry* entry)
+	{
+		ResolvedEntry resolvedEntry;
+		if (!ResolveEntryInternal(name, resolvedEntry))
+			return false;
+
+		RetrieveEntry(resolvedEntry, entry);
+		return true;
+	}
+
+	inline bool VirtualDirectory::GetIndexedEntry(const std::string_view& path, Entry* entry)
+	{
+		// Every separator is indexed as a slash
+		std::string normalizedPath;
+		std::string_view key = path;
+		if (path.find_first_of("\\:") != path.npos)
+		{
+			normalizedPath = path;
+			for (char& c : normalizedPath)
+			{
+				if (c == '\\' || c == ':')
+					c = '/';
+			}
+
+			key = normalizedPath;
+		}
+
+		auto it = m_pathIndex.find(key);
+		if (it == m_pathIndex.end())
+		{
+			std::shared_ptr<VirtualDirectory> dir;
+			std::string_view entryName;
+			if (!RetrieveDirectory(path, false, dir, entryName))
+				return false;
+
+			ResolvedEntry resolvedEntry;
+			if (!dir->ResolveEntryInternal(entryName, resolvedEntry))
+				return false;
+
+			it = m_pathIndex.emplace(std::string(key), std::move(resolvedEntry)).first;
+		}
+
+		RetrieveEntry(it->second, entry);
+		return true;
+	}
+
+	inline void VirtualDirectory::InvalidatePathIndex()
+	{
+		// Parents may have indexed entries of this directory
+		for (VirtualDirectory* dir = this; dir; dir = dir->m_parent.get())
+		{
+			if (!dir->m_pathIndex.empty())
+				dir->m_pathIndex.clear();
+		}
+	}
+
+	inline bool VirtualDirectory::ResolveEntryInternal(const std::string_view& name, ResolvedEntry& resolvedEntry)
 	{
 		EnsureDots();
 
 		auto it = m_content.find(name);
 		if (it != m_content.end())
 		{
-			*entry = it->second;
+			resolvedEntry.entry = &it->second;
 			return true;
 		}
-		else
+
+		for (auto mountIt = m_packMounts.rbegin(); mountIt != m_packMounts.rend(); ++mountIt)
 		{
-			if (m_physicalPath)
-			{
-				std::filesystem::path entryPath = *m_physicalPath / name;
+			std::string packPath = mountIt->prefix;
+			packPath += name;
 
-				if (std::filesystem::is_regular_file(entryPath))
-					entry->emplace<PhysicalFileEntry>(entryPath);
-				else if (std::filesystem::is_directory(entryPath))
-				{
-					// FIXME: Allocating a shared_ptr on iteration is bad, not sure about a workaround
-					*entry = StoreDirectoryInternal(std::string(name), entryPath);
-				}
-				else
-					return false;
+			if (const PackFile::Entry* packEntry = mountIt->packFile->FindEntry(packPath))
+			{
+				resolvedEntry.packEntry = packEntry;
+				resolvedEntry.packFile = mountIt->packFile;
+				return true;
+			}
+		}
 
+		if (m_physicalPath)
+		{
+			std::filesystem::path entryPath = *m_physicalPath / name;
+			if (std::filesystem::is_regular_file(entryPath))
+			{
+				resolvedEntry.physicalPath = std::move(entryPath);
 				return true;
 			}
+		}
 
-			return false;
+		// FIXME: Allocating a shared_ptr on iteration is bad, not sure about a workaround
+		if (VirtualDirectoryEntry directory = CreateSubdirectory(name))
+		{
+			StoreDirectoryInternal(std::string(name), std::move(directory));
+			resolvedEntry.entry = &m_content.find(name)->second;
+			return true;
+		}
+
+		return false;
+	}
+
+	inline void VirtualDirectory::RetrieveEntry(const ResolvedEntry& resolvedEntry, Entry* entry)
+	{
+		if (resolvedEntry.entry)
+			*entry = *resolvedEntry.entry;
+		else if (resolvedEntry.packEntry)
+		{
+			// Uncompressed files are referenced in the pack (mapping), compressed ones are decompressed on each retrieval
+			FileContentEntry buffer;
+			const Nz::UInt8* data = resolvedEntry.packFile->ReadEntry(*resolvedEntry.packEntry, buffer);
+			if (resolvedEntry.packEntry->compression != PackFile::Compression::None)
+				*entry = std::move(buffer);
+			else
+				*entry = DataPointerEntry{ resolvedEntry.packFile, data, static_cast<std::size_t>(resolvedEntry.packEntry->size) };
 		}
+		else
+			entry->emplace<PhysicalFileEntry>(resolvedEntry.physicalPath);
 	}
 
 	inline auto VirtualDirectory::StoreDirectoryInternal(std::string name, std::filesystem::path directoryPath) -> VirtualDirectoryEntry&
@@ -208,6 +439,14 @@ namespace bw
 		return std::get<VirtualDirectoryEntry>(it->second);
 	}
 
+	inline auto VirtualDirectory::StoreFileInternal(std::string name, DataPointerEntry file) -> DataPointerEntry&
+	{
+		assert(name.find_first_of("\\/:") == name.npos);
+
+		auto it = m_content.insert_or_assign(std::move(name), std::move(file)).first;
+		return std::get<DataPointerEntry>(it->second);
+	}
+
 	inline auto VirtualDirectory::StoreFileInternal(std::string name, FileContentEntry file) -> FileContentEntry&
 	{
 		assert(name.find_first_of("\\/:") == name.npos);
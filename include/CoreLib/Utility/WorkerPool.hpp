@@ -0,0 +1,59 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_CORELIB_UTILITY_WORKERPOOL_HPP
+#define BURGWAR_CORELIB_UTILITY_WORKERPOOL_HPP
+
+#include <CoreLib/Export.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bw
+{
+	// Fixed set of threads running indexed jobs, the calling thread takes part in every job and returns once all indices have been processed
+	class BURGWAR_CORELIB_API WorkerPool
+	{
+		public:
+			WorkerPool(std::size_t workerCount);
+			WorkerPool(const WorkerPool&) = delete;
+			WorkerPool(WorkerPool&&) = delete;
+			~WorkerPool();
+
+			template<typename F> void ForEach(std::size_t count, F&& func);
+
+			inline std::size_t GetWorkerCount() const;
+
+			WorkerPool& operator=(const WorkerPool&) = delete;
+			WorkerPool& operator=(WorkerPool&&) = delete;
+
+		private:
+			using Job = std::function<void(std::size_t index)>;
+
+			void ProcessJob();
+			void Run(std::size_t count, const Job& job);
+			void WorkerMain();
+
+			std::atomic_size_t m_nextIndex;
+			std::condition_variable m_jobCondition;
+			std::condition_variable m_jobDoneCondition;
+			std::mutex m_mutex;
+			std::size_t m_finishedWorkerCount;
+			std::size_t m_jobSize;
+			std::vector<std::thread> m_workers;
+			const Job* m_job;
+			Nz::UInt64 m_jobGeneration;
+			bool m_isStopping;
+	};
+}
+
+#include <CoreLib/Utility/WorkerPool.inl>
+
+#endif
@@ -0,0 +1,31 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/WorkerPool.hpp>
+
+namespace bw
+{
+	template<typename F>
+	void WorkerPool::ForEach(std::size_t count, F&& func)
+	{
+		if (count == 0)
+			return;
+
+		if (m_workers.empty() || count == 1)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+				func(i);
+
+			return;
+		}
+
+		Job job(std::forward<F>(func));
+		Run(count, job);
+	}
+
+	inline std::size_t WorkerPool::GetWorkerCount() const
+	{
+		return m_workers.size();
+	}
+}
@@ -8,14 +8,18 @@
 #define BURGWAR_CORELIB_UTILS_HPP
 
 #include <CoreLib/Export.hpp>
+#include <Nazara/Core/ByteStream.hpp>
 #include <Nazara/Math/Angle.hpp>
 #include <Nazara/Math/Quaternion.hpp>
+#include <Nazara/Math/Rect.hpp>
 #include <Nazara/Math/Vector2.hpp>
 #include <Nazara/Math/Vector3.hpp>
+#include <Nazara/Math/Vector4.hpp>
 #include <cctype>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <vector>
 
 namespace bw
 {
@@ -66,6 +70,20 @@ namespace bw
 	template<template<typename...> typename T, typename U>
 	inline constexpr bool IsSameTpl_v = IsSameTpl<T, U>::value;
 
+	// Types streamed as their memory (byte-swapped if needed), bools are excluded as packet serializers pack them into bits
+	template<typename T>
+	struct IsRawSerializable : std::bool_constant<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>
+	{
+		using ComponentType = T;
+	};
+
+	template<typename T> struct IsRawSerializable<Nz::Vector2<T>> : IsRawSerializable<T> {};
+	template<typename T> struct IsRawSerializable<Nz::Vector3<T>> : IsRawSerializable<T> {};
+	template<typename T> struct IsRawSerializable<Nz::Vector4<T>> : IsRawSerializable<T> {};
+
+	template<typename T>
+	inline constexpr bool IsRawSerializable_v = IsRawSerializable<T>::value;
+
 	inline Nz::RadianAnglef AngleFromQuaternion(const Nz::Quaternionf& quat);
 	template<typename T> Nz::Vector2<T> AlignPosition(Nz::Vector2<T> position, const Nz::Vector2<T>& alignment);
 	BURGWAR_CORELIB_API std::string ByteToString(Nz::UInt64 bytes, bool speed = false);
@@ -74,11 +92,14 @@ namespace bw
 	BURGWAR_CORELIB_API Nz::Vector3f DampenedString(const Nz::Vector3f& currentPos, const Nz::Vector3f& targetPos, float frametime, float springStrength = 3.f);
 	inline bool EndsWith(const std::string_view& str, const std::string_view& suffix);
 	template<typename T> bool IsMoreRecent(T a, T b);
+	BURGWAR_CORELIB_API std::vector<Nz::Rectui> MergeSolidTiles(const std::vector<Nz::UInt32>& content, const Nz::Vector2ui& mapSize); //< greedy cover of non-zero tiles with as few rectangles (in tiles) as possible
+	template<typename T> void ReadRawArray(Nz::ByteStream& stream, T* data, std::size_t count); //< same as reading elements one by one, in one copy
 	inline std::string ReplaceStr(std::string str, const std::string_view& from, const std::string_view& to);
 	template<typename F> bool SplitString(const std::string_view& str, const std::string_view& token, F&& func);
 	template<typename F> bool SplitStringAny(const std::string_view& str, const std::string_view& token, F&& func);
 	inline bool StringEqual(const std::string_view& lhs, const std::string_view& rhs);
 	template<typename E> auto UnderlyingCast(E value) -> std::underlying_type_t<E>;
+	template<typename T> void WriteRawArray(Nz::ByteStream& stream, const T* data, std::size_t count); //< same as writing elements one by one, in one copy
 }
 
 #include <CoreLib/Utils.inl>
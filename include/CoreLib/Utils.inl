@@ -3,8 +3,12 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/Utils.hpp>
+#include <Nazara/Core/Endianness.hpp>
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <stdexcept>
 
 namespace bw
 {
@@ -65,6 +69,29 @@ namespace bw
 		return false;
 	}
 
+	template<typename T>
+	void ReadRawArray(Nz::ByteStream& stream, T* data, std::size_t count)
+	{
+		using ComponentType = typename IsRawSerializable<T>::ComponentType;
+		static_assert(IsRawSerializable_v<T>);
+		static_assert(sizeof(T) % sizeof(ComponentType) == 0);
+
+		std::size_t byteSize = count * sizeof(T);
+		if (stream.Read(data, byteSize) != byteSize)
+			throw std::runtime_error("failed to read");
+
+		if constexpr (sizeof(ComponentType) > 1)
+		{
+			if (stream.GetDataEndianness() != Nz::GetPlatformEndianness())
+			{
+				ComponentType* components = reinterpret_cast<ComponentType*>(data);
+				std::size_t componentCount = count * (sizeof(T) / sizeof(ComponentType));
+				for (std::size_t i = 0; i < componentCount; ++i)
+					Nz::SwapBytes(&components[i], sizeof(ComponentType));
+			}
+		}
+	}
+
 	std::string ReplaceStr(std::string str, const std::string_view& from, const std::string_view& to)
 	{
 		if (str.empty())
@@ -132,4 +159,44 @@ namespace bw
 	{
 		return static_cast<std::underlying_type_t<E>>(value);
 	}
+
+	template<typename T>
+	void WriteRawArray(Nz::ByteStream& stream, const T* data, std::size_t count)
+	{
+		using ComponentType = typename IsRawSerializable<T>::ComponentType;
+		static_assert(IsRawSerializable_v<T>);
+		static_assert(sizeof(T) % sizeof(ComponentType) == 0);
+
+		if constexpr (sizeof(ComponentType) > 1)
+		{
+			if (stream.GetDataEndianness() != Nz::GetPlatformEndianness())
+			{
+				// Swap a chunk at a time, source data is left untouched
+				std::array<T, 256> chunk;
+				while (count > 0)
+				{
+					std::size_t chunkCount = std::min(count, chunk.size());
+					std::copy(data, data + chunkCount, chunk.begin());
+
+					ComponentType* components = reinterpret_cast<ComponentType*>(chunk.data());
+					std::size_t componentCount = chunkCount * (sizeof(T) / sizeof(ComponentType));
+					for (std::size_t i = 0; i < componentCount; ++i)
+						Nz::SwapBytes(&components[i], sizeof(ComponentType));
+
+					std::size_t byteSize = chunkCount * sizeof(T);
+					if (stream.Write(chunk.data(), byteSize) != byteSize)
+						throw std::runtime_error("failed to write");
+
+					data += chunkCount;
+					count -= chunkCount;
+				}
+
+				return;
+			}
+		}
+
+		std::size_t byteSize = count * sizeof(T);
+		if (stream.Write(data, byteSize) != byteSize)
+			throw std::runtime_error("failed to write");
+	}
 }
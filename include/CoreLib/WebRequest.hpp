@@ -34,12 +34,16 @@ namespace bw
 
 			void ForceProtocol(Nz::NetProtocol protocol);
 
+			long GetResponseCode() const;
+
 			inline void SetDataCallback(DataCallback callback);
 			inline void SetHeader(std::string header, std::string value);
 			void SetJSonContent(const std::string_view& encodedJSon);
 			void SetMaximumFileSize(Nz::UInt64 maxFileSize);
+			void SetRange(Nz::UInt64 firstByte, Nz::UInt64 lastByte);
 			inline void SetResultCallback(ResultCallback callback);
 			void SetServiceName(const std::string_view& serviceName);
+			void SetTimeout(Nz::UInt64 milliseconds);
 			void SetURL(const std::string& url);
 
 			void SetupGet();
@@ -59,6 +63,7 @@ namespace bw
 
 			Nz::MovablePtr<CURL> m_curlHandle;
 			Nz::MovablePtr<curl_slist> m_headerList;
+			std::string m_range;
 			std::string m_responseBody;
 			tsl::hopscotch_map<std::string, std::string> m_headers;
 			DataCallback m_dataCallback;
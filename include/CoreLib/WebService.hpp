@@ -13,6 +13,7 @@
 #include <tsl/hopscotch_map.h>
 
 using CURLM = void;
+using CURLSH = void;
 
 namespace bw
 {
@@ -51,6 +52,7 @@ namespace bw
 			tsl::hopscotch_map<CURL*, std::unique_ptr<WebRequest>> m_activeRequests;
 
 			static std::string s_userAgent;
+			static CURLSH* s_curlShare;
 			static std::unique_ptr<CurlLibrary> s_curlLibrary;
 	};
 }
@@ -0,0 +1,17 @@
+RegisterClientScript()
+
+-- Runs func(...) on a worker thread and returns its results, func cannot use engine functions nor locals from enclosing scopes
+-- and can only exchange plain data (no entities nor functions)
+function jobs.Run(func, ...)
+	local co, main = coroutine.running()
+	assert(not main, "must be called from a coroutine")
+
+	jobs.Start(func, function (...) assert(coroutine.resume(co, ...)) end, ...)
+
+	local results = table.pack(coroutine.yield())
+	if (not results[1]) then
+		error(results[2], 2)
+	end
+
+	return table.unpack(results, 2, results.n)
+end
@@ -31,7 +31,7 @@ entity:On("init", function (self)
 			texturePath = "placeholder/frite_particle.png"
 		})
 
-		self.ParticleGroup:GenerateParticles(100)
+		self.ParticleGroup:GenerateParticles(100, self:GetPosition())
 	end
 end)
 
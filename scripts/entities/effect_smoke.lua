@@ -32,7 +32,7 @@ entity:On("init", function (self)
 			texturePath = "smoke.png"
 		})
 
-		self.ParticleGroup:GenerateParticles(25)
+		self.ParticleGroup:GenerateParticles(25, self:GetPosition())
 	end
 end)
 
@@ -2,7 +2,8 @@ RegisterClientScript()
 RegisterClientAssets("placeholder/potato.png")
 
 local entity = ScriptedEntity({
-	IsNetworked = true
+	IsNetworked = true,
+	PoolSize = 32
 })
 
 entity.ExplosionSounds = {
@@ -13,8 +14,14 @@ entity.ExplosionSounds = {
 }
 RegisterClientAssets(entity.ExplosionSounds)
 
-entity:On("init", function (self)
+local function ResetExplosion(self)
 	self.ExplosionTick = match.GetLocalTick() + 5 / match.GetTickDuration()
+	self.Exploded = false
+end
+
+entity:On("init", function (self)
+	ResetExplosion(self)
+
 	self:SetColliders({ 
 		Collider = Circle(Vec2(0, 0) * 0.2, 128 * 0.2),
 		ColliderType = SERVER and ColliderType.Callback or ColliderType.Default
@@ -31,6 +38,9 @@ entity:On("init", function (self)
 	end
 end)
 
+-- Potatoes are pooled, init only runs once per pooled entity
+entity:On("respawn", ResetExplosion)
+
 entity:On("tick", function (self)
 	local currentTick = match.GetLocalTick()
 	if (currentTick >= self.ExplosionTick) then
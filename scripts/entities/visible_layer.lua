@@ -8,6 +8,7 @@ local entity = ScriptedEntity({
 		{ Name = "recursive", Type = PropertyType.Boolean, Default = false, Shared = true },
 		{ Name = "renderOrder", Type = PropertyType.Integer, Default = 0, Shared = true },
 		{ Name = "scale", Type = PropertyType.FloatSize, Default = Vec2(1, 1), Shared = true },
+		{ Name = "static", Type = PropertyType.Boolean, Default = false, Shared = true },
 	}
 })
 
@@ -38,7 +39,8 @@ if (CLIENT) then
 				LayerIndex = self:GetProperty("layer"),
 				ParallaxFactor = self:GetProperty("parallaxFactor"),
 				RenderOrder = self:GetProperty("renderOrder"),
-				Scale = self:GetProperty("scale")
+				Scale = self:GetProperty("scale"),
+				Static = self:GetProperty("static")
 			})
 		end
 	end
@@ -6,5 +6,9 @@ return {
 	},
 	Properties = {
 		{ Name = "respawntime", Type = PropertyType.Integer, Default = 5, Shared = true },
+		-- Layer physics, negative values let the server pick them from entity density (map layer settings take precedence)
+		{ Name = "physicsiterations", Type = PropertyType.Integer, Default = -1 },
+		{ Name = "physicssleeptime", Type = PropertyType.Float, Default = -1 },
+		{ Name = "physicshashcellsize", Type = PropertyType.Float, Default = -1 },
 	}
 }
@@ -2,6 +2,8 @@ local gamemode = ScriptedGamemode()
 
 gamemode.ShakeData = nil
 
+local cameraRects = {} -- reused by the camera rect query each refresh
+
 function gamemode:ClampCameraPosition(viewportSize, rect, position)
 	local mins = rect:GetCorner(false, false)
 	local maxs = rect:GetCorner(true, true) - viewportSize
@@ -87,7 +89,7 @@ end)
 function gamemode:RefreshCameraRect()
 	local playerPosition = engine_GetPlayerPosition(0)
 	if (playerPosition) then
-		local cameraRects = match.GetEntitiesByClass("entity_camera_rect", engine_GetActiveLayer())
+		match.GetEntitiesByClass("entity_camera_rect", engine_GetActiveLayer(), cameraRects)
 
 		-- Find most suitable camera rect
 		local mostSuitableCameraRect
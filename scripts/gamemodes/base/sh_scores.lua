@@ -59,12 +59,15 @@ if (SERVER) then
 		derivedGamemode.ScoreUpdated = false
 	end
 
-	gamemode:On("PlayerJoined", function (self, player)
+	local function SendScores(self, player)
 		local derivedGamemode = match.GetGamemode()
 		if #derivedGamemode.ScoreTypes > 0 then
 			player:SendPacket(BuildScorePacket())
 		end
-	end)
+	end
+
+	gamemode:On("PlayerJoined", SendScores)
+	gamemode:On("PlayerResumed", SendScores)
 
 	gamemode:On("Tick", function (self)
 		local derivedGamemode = match.GetGamemode()
@@ -114,9 +114,12 @@ if (SERVER) then
 		return packet
 	end
 
-	gamemode:On("PlayerJoined", function (self, player)
+	local function SendTeams(self, player)
 		player:SendPacket(self:BuildTeamPacket())
-	end)
+	end
+
+	gamemode:On("PlayerJoined", SendTeams)
+	gamemode:On("PlayerResumed", SendTeams)
 
 	gamemode:On("PlayerLeave", function (self, player)
 		for _, team in pairs(self:GetTeams()) do
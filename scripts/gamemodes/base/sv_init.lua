@@ -4,7 +4,11 @@ gamemode.PlayerEntity = "entity_burger"
 
 gamemode.PlayerSeeds = {}
 
-math.randomseed(os.time())
+-- Plain fields of the gamemode (such as scores) are saved in match checkpoints, see ServerSettings.CheckpointPath
+gamemode.Checkpoint = true
+
+-- Seeded by the match so recorded matches can be replayed
+math.randomseed(match.GetRandomSeed())
 
 gamemode.BasePlayerDeathSlot = gamemode:OnAsync("PlayerDeath", function (self, player, attacker)
 	print(player:GetName() .. " died")
@@ -27,6 +31,23 @@ gamemode.BasePlayerJoinedSlot = gamemode:On("PlayerJoined", function(self, playe
 	match.GetGamemode():SpawnPlayer(player)
 end)
 
+-- Player reconnected to a match resumed from a checkpoint, its entity (if it still has one) was given back
+gamemode:On("PlayerResumed", function (self, player)
+	local gamemode = match.GetGamemode()
+	local team = gamemode:ChoosePlayerTeam(player)
+	if (team) then
+		team:AddPlayer(player)
+	end
+
+	if (not player:GetControlledEntity()) then
+		if (not self.PlayerSeeds[player:GetPlayerIndex()]) then
+			self.PlayerSeeds[player:GetPlayerIndex()] = math.random(0, math.maxinteger)
+		end
+
+		gamemode:SpawnPlayer(player)
+	end
+end)
+
 gamemode:On("PlayerLeave", function (self, player)
 	self.PlayerSeeds[player:GetPlayerIndex()] = nil
 end)
@@ -8,6 +8,8 @@ gamemode.CameraZoom = nil
 gamemode.TargetCameraPos = nil
 gamemode.TargetCameraZoom = nil
 
+local cameraZones = {} -- reused by the camera zone query each frame
+
 local stuckInputController = CustomInputController.new(function (entity)
 	local inputs = entity:GetOwner():GetInputs()
 
@@ -69,7 +71,7 @@ function gamemode:UpdateCameraPosition()
 		return
 	end
 
-	local cameraZones = match.GetEntitiesByClass("entity_camera_zone", currentLayer)
+	match.GetEntitiesByClass("entity_camera_zone", currentLayer, cameraZones)
 
 	local camZone
 	if (#cameraZones > 0) then
@@ -42,7 +42,8 @@ if (SERVER) then
 		local nearestFraction = math.huge
 		local nearestResult
 
-		physics.TraceMultiple(self:GetLayerIndex(), startPos, endPos, function (result)
+		-- Trace against targets as the shooter saw them
+		physics.TraceMultipleRewind(self:GetLayerIndex(), startPos, endPos, self:GetOwner(), function (result)
 			if (result.fraction < nearestFraction) then
 				if (result.hitEntity) then
 					-- Ignore player
@@ -13,23 +13,34 @@ local weapon = ScriptedWeapon({
 
 RegisterClientAssets(weapon.Sprite)
 
-if (SERVER) then
-	weapon:On("attack", function (self)
-		local scale = self:GetScale()
+-- Runs on the server and, for local players, on the client (the predicted grenade is replaced by the server one when it arrives)
+local function ThrowGrenade(self)
+	local scale = self:GetScale()
 
-		local projectile = match.CreateEntity({
-			Type = "entity_grenade",
-			LayerIndex = self:GetLayerIndex(),
-			Owner = self:GetOwner(),
-			Position = self:GetPosition() + self:GetDirection() * 32 * scale,
-			--Scale = scale, -- TODO: Handle scale when creating entity
-			Properties = {
-				lifetime = math.random(1, 2),
-			}
-		})
-		projectile:SetScale(scale)
+	local projectile = match.CreateEntity({
+		Type = "entity_grenade",
+		LayerIndex = self:GetLayerIndex(),
+		Owner = self:GetOwner(),
+		Position = self:GetPosition() + self:GetDirection() * 32 * scale,
+		--Scale = scale, -- TODO: Handle scale when creating entity
+		Properties = {
+			lifetime = math.random(1, 2),
+		}
+	})
+	projectile:SetScale(scale)
+
+	projectile:SetVelocity(self:GetDirection() * scale * 1000)
+end
 
-		projectile:SetVelocity(self:GetDirection() * scale * 1000)
+if (SERVER) then
+	weapon:On("attack", function (self)
+		ThrowGrenade(self)
 		self:GetOwnerEntity():RemoveWeapon(self.FullName)
 	end)
+else
+	weapon:On("attack", function (self)
+		if (self:IsPredicted()) then
+			ThrowGrenade(self)
+		end
+	end)
 end
@@ -15,34 +15,37 @@ local weapon = ScriptedWeapon({
 RegisterClientAssets(weapon.Sprite)
 RegisterClientAssets(ammoSprite)
 
-if (SERVER) then
-	weapon:On("attack", function (self)
-		self.ChargeStart = match.GetSeconds()
-	end)
+-- Runs on the server and, for local players, on the client (the predicted potato is replaced by the server one when it arrives)
+local function FirePotato(self)
+	local chargeFactor = math.clamp((match.GetSeconds() - self.ChargeStart) ^ 2, 0, 5) / 5
 
-	weapon:On("attackfinish", function (self)
-		local chargeFactor = math.clamp((match.GetSeconds() - self.ChargeStart) ^ 2, 0, 5) / 5
+	local rotation = self:GetRotation() + 90
+	if (not self:IsLookingRight()) then
+		rotation = rotation + 180
+	end
 
-		local rotation = self:GetRotation() + 90
-		if (not self:IsLookingRight()) then
-			rotation = rotation + 180
-		end
+	local scale = self:GetScale()
 
-		local scale = self:GetScale()
+	local projectile = match.CreateEntity({
+		Type = "entity_potato",
+		LayerIndex = self:GetLayerIndex(),
+		Owner = self:GetOwner(),
+		Position = self:GetPosition() + self:GetDirection() * 360 * self.Scale * scale,
+		Rotation = rotation,
+		Properties = {}
+	})
 
-		local projectile = match.CreateEntity({
-			Type = "entity_potato",
-			LayerIndex = self:GetLayerIndex(),
-			Owner = self:GetOwner(),
-			Position = self:GetPosition() + self:GetDirection() * 360 * self.Scale * scale,
-			Rotation = rotation,
-			Properties = {}
-		})
+	projectile:SetScale(scale)
 
-		projectile:SetScale(scale)
+	projectile:SetVelocity(self:GetDirection() * scale * 1500 * chargeFactor)
+end
 
-		projectile:SetVelocity(self:GetDirection() * scale * 1500 * chargeFactor)
+if (SERVER) then
+	weapon:On("attack", function (self)
+		self.ChargeStart = match.GetSeconds()
 	end)
+
+	weapon:On("attackfinish", FirePotato)
 else
 	weapon.ChargeBarFullsize = Vec2(60, 10)
 
@@ -83,6 +86,12 @@ else
 		end
 	end)
 
+	weapon:On("attackfinish", function (self)
+		if (self:IsPredicted()) then
+			FirePotato(self)
+		end
+	end)
+
 	weapon:OnAsync("attackfinish", function (self)
 		self.IsCharging = false
 		self.ChargeBar:Hide()
@@ -29,22 +29,16 @@ function weapon:Launch()
 	local startPos = self:ToGlobalPosition(startOffset)
 	local endPos = startPos + self:GetDirection() * maxDist
 
-	local nearestFraction = math.huge
+	-- Hits are sorted from the nearest to the farthest
+	local ownerEntity = self:GetOwnerEntity()
 	local nearestResult
-
-	local traceResult = physics.TraceMultiple(self:GetLayerIndex(), startPos, endPos, function (result)
-		if (result.fraction < nearestFraction) then
-			if (result.hitEntity) then
-				-- Ignore player
-				if (result.hitEntity == self:GetOwnerEntity()) then
-					return
-				end
-			end
-
+	for _, result in ipairs(physics.TraceAll(self:GetLayerIndex(), startPos, endPos, true)) do
+		-- Ignore player
+		if (not result.hitEntity or result.hitEntity ~= ownerEntity) then
 			nearestResult = result
-			nearestFraction = result.fraction
+			break
 		end
-	end)
+	end
 
 	if (not nearestResult) then
 		return
@@ -33,14 +33,12 @@ if (SERVER) then
 		local rect = Rect(origin + mins * scale, origin + maxs * scale)
 
 		local ownerEntity = self:GetOwnerEntity()
-		physics.RegionQuery(self:GetLayerIndex(), rect, function (entity)
-			if (entity == ownerEntity or entity == self) then
-				return
+		for _, entity in ipairs(physics.RegionQueryAll(self:GetLayerIndex(), rect)) do
+			if (entity ~= ownerEntity and entity ~= self) then
+				entity:ApplyImpulse(dir * 10000)
+				entity:Damage(math.random(15, 35), self)
 			end
-
-			entity:ApplyImpulse(dir * 10000)
-			entity:Damage(math.random(15, 35), self)
-		end)
+		end
 	end)
 end
 
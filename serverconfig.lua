@@ -1,22 +1,80 @@
 Debug = {
-	SendServerState = true
+	SendServerState = true,
+	SimulatedJitter = 0, -- ms
+	SimulatedLatency = 0, -- ms, one way (applied on both directions)
+	SimulatedPacketDuplication = 0.0, -- 0..1
+	SimulatedPacketLoss = 0.0, -- 0..1
+	SimulatedPacketReordering = 0.0, -- 0..1
+	SimulationSeed = 0
+}
+RelaySettings = {
+	Delay = 0, -- seconds spectators lag behind the match when running with "BurgWarServer --relay <host>" (spectators connect on ServerSettings.Port)
+	MaxSpectatorCount = 256,
+	Password = "" -- must match the game server RelayPassword
 }
 Resources = {
 	AssetDirectory = "assets",
+	BytecodeCacheDirectory = ".bytecodeCache", -- compiled scripts kept between runs (empty to keep them in memory only)
+	ChecksumCacheFile = ".checksumCache", -- asset checksums kept between runs (empty to disable)
+	JobThreadCount = 0, -- threads running background jobs such as asset hashing (0 = one per core, minus the main thread)
 	ModDirectory = "mods",
-	ScriptDirectory  = "scripts"
+	ScriptDirectory  = "scripts",
+	ScriptJobInstructionBudget = 100000000 -- Lua instructions a background job may run before being aborted (0 = unlimited)
 }
 ServerSettings = {
+	-- additional match config files, each one is loaded on top of this file and should at least override Port, ex:
+	-- ServerSettings.Port = 14770
+	-- ServerSettings.MapPath = "other_map.bmap"
+	AdditionalMatches = [[
+	]],
 	FastDownloadURLs = [[
 https://burgwar.digitalpulse.software/resources
 	]],
 	MasterServers = [[
 https://bwmasterserver.digitalpulse.software
 	]],
+	AdaptiveSnapshotRate = false, -- send snapshots less often (down to 10/s) to clients with a congested connection
+	BinaryLogFileCount = 5, -- files kept by binary log rotation (log, log.1, ...)
+	BinaryLogMaxFileSize = 64, -- MiB written to a binary log file before rotating it
+	BinaryLogPath = "", -- also write logs with their match/entity context in binary form to this file, decode them with "logtool <file>" (empty = disabled)
+	CheckpointInterval = 30, -- seconds between two match checkpoints, written in the background (0 = only when the server stops)
+	CheckpointPath = "", -- save the match state to this file and resume from it on start, so a server can be restarted or moved without ending the match (delete it to start a new match, empty = disabled)
+	CheckpointReconnectionDelay = 60, -- seconds players of a resumed match have to reconnect before their slot and entity are released
+	DeferPacketSerialization = false, -- serialize MatchState packets on network threads
 	DisableWhenEmpty = true,
+	FastTerrainReset = false, -- restore map entities on round restart instead of recreating them (entities keeping tables in their state are still recreated)
+	FileWatchDelay = 0, -- watch the script and asset directories and reload changed scripts this many seconds after files stopped changing, for development servers (0 = disabled)
 	Gamemode = "deathmatch",
+	HealthQuantizationStep = 1, -- with QuantizeMatchState, health updates are sent as a multiple of this (rounded up)
+	InterestCellSize = 512,
+	InterestRadius = 0, -- only send moving entities within this distance of a player (0 = whole layer)
+	LagCompensationDuration = 1.0, -- seconds of past hitboxes kept so hitscan weapons can trace against what shooters saw (0 = disabled)
+	LayerHibernationDelay = 0, -- with LazyLayerActivation, remove layer entities when nobody saw it for this many seconds, they're recreated from the map when someone comes back (0 = never)
+	LazyLayerActivation = false, -- only instantiate a layer (except the first one) once a player sees it, scripts can't find entities of layers nobody saw yet
+	LoadShedding = true, -- when ticks fall behind, defer non-critical work, halve snapshot rate and slow down interval-based script ticks
 	MapPath = "beta_map.bmap",
+	MatchThreadCount = 0, -- threads used to update matches when hosting more than one (0 = one per core)
+	MaxTickRate = 0, -- with MinTickRate, tick rate of a full match, the rate changes at runtime with player count and is lowered when ticks fall behind (0 = TickRate)
+	MetricsPort = 0, -- serve Prometheus metrics (tick times, sessions, bandwidth, Lua memory, ...) over HTTP on this port at /metrics (0 = disabled)
+	MinTickRate = 0, -- with MaxTickRate, tick rate of a match with at most one player (0 = TickRate, both at 0 = fixed rate)
+	MovementExtrapolationError = 0, -- with MovementSyncEpsilon, don't send bodies (but players) while clients can extrapolate them from their velocity within this distance (0 = disabled)
+	MovementKeyframeInterval = 100, -- ticks between two unconditional updates of each body (0 = never)
+	MovementSyncEpsilon = 0.01, -- only send bodies which moved more than this distance (0 = send every awake body each tick)
 	Name = "no name set",
+	NetworkStatisticsInterval = 0, -- log a network traffic summary every X seconds (0 = disabled)
+	NetworkThreadCount = 1, -- each network thread listens on its own port (Port, Port + 1, ...)
+	ParallelLayerUpdate = false, -- step layers physics on worker threads (requires WorkerThreadCount > 0, collision callbacks must stay in their layer)
+	PeerBandwidth = 0, -- outgoing bytes per second per client (0 = unlimited)
+	QuantizeMatchState = false,
+	RelayPassword = "", -- lets relays ("BurgWarServer --relay <host>") connect as a single session seeing every layer and serve the match to many spectators (empty = disabled)
+	ReplayRecordPath = "", -- record clients traffic to this file, replay it with "BurgWarServer --replay <file>" (empty = disabled)
 	Description = "a description of your server",
+	ScriptCallbackBudget = 0, -- ms an entity event callbacks may take before a warning is logged, runaway tick callbacks get throttled (0 = unlimited)
+	ScriptGarbageCollector = "stepped", -- Lua GC mode: "stepped" (incremental, only run in the tick idle time), "incremental" or "generational" (both triggered by allocations)
+	ScriptGarbageCollectorStepBudget = 1.0, -- ms of Lua garbage collection per tick in stepped mode (at least one step is always taken)
+	SnapshotRate = 0, -- world snapshots sent to each client per second, can be lower than TickRate (0 = every tick)
+	TickProfileInterval = 0, -- log the slowest tick sections every X seconds (0 = disabled)
+	TickProfiling = true, -- time tick phases, systems and script callbacks (with Lua allocations), see the "profile" admin console command
 	TickRate = 33,
+	WorkerThreadCount = 0, -- threads helping each match with parallel tick work, such as building visibility packets for each client (0 = disabled)
 }
@@ -0,0 +1,34 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Benchmark/BenchmarkReport.hpp>
+#include <Nazara/Core/File.hpp>
+#include <fmt/format.h>
+#include <iterator>
+
+namespace bw
+{
+	bool BenchmarkReport::SaveToFile(const std::filesystem::path& filePath) const
+	{
+		std::string report = ToCsv();
+
+		Nz::File reportFile(filePath.generic_u8string(), Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate);
+		if (!reportFile.IsOpen())
+			return false;
+
+		return reportFile.Write(report.data(), report.size()) == report.size();
+	}
+
+	std::string BenchmarkReport::ToCsv() const
+	{
+		std::string report = "benchmark,metric,value,unit\n";
+		for (const Measure& measure : m_measures)
+		{
+			// Benchmark names may contain commas (template arguments)
+			fmt::format_to(std::back_inserter(report), "\"{0}\",{1},{2:.3f},{3}\n", measure.benchmark, measure.metric, measure.value, measure.unit);
+		}
+
+		return report;
+	}
+}
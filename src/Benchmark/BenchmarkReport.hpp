@@ -0,0 +1,44 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_BENCHMARK_BENCHMARKREPORT_HPP
+#define BURGWAR_BENCHMARK_BENCHMARKREPORT_HPP
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	// One row per measure (benchmark,metric,value,unit), so reports of different releases can be diffed or plotted as long as benchmark names don't change
+	class BenchmarkReport
+	{
+		public:
+			BenchmarkReport() = default;
+			~BenchmarkReport() = default;
+
+			inline void AddMeasure(std::string benchmark, std::string metric, double value, std::string unit);
+
+			bool SaveToFile(const std::filesystem::path& filePath) const;
+
+			std::string ToCsv() const;
+
+		private:
+			struct Measure
+			{
+				std::string benchmark;
+				std::string metric;
+				std::string unit;
+				double value;
+			};
+
+			std::vector<Measure> m_measures;
+	};
+}
+
+#include <Benchmark/BenchmarkReport.inl>
+
+#endif
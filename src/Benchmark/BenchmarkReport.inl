@@ -0,0 +1,17 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Benchmark/BenchmarkReport.hpp>
+
+namespace bw
+{
+	inline void BenchmarkReport::AddMeasure(std::string benchmark, std::string metric, double value, std::string unit)
+	{
+		auto& measure = m_measures.emplace_back();
+		measure.benchmark = std::move(benchmark);
+		measure.metric = std::move(metric);
+		measure.unit = std::move(unit);
+		measure.value = value;
+	}
+}
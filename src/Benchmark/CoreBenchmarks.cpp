@@ -0,0 +1,489 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Benchmark/CoreBenchmarks.hpp>
+#include <Benchmark/BenchmarkReport.hpp>
+#include <CoreLib/Map.hpp>
+#include <CoreLib/PropertyValues.hpp>
+#include <CoreLib/Protocol/CompressedInteger.hpp>
+#include <CoreLib/Protocol/NetworkStringStore.hpp>
+#include <CoreLib/Protocol/PacketSerializer.hpp>
+#include <CoreLib/Utility/CircularBuffer.hpp>
+#include <CoreLib/Utility/VirtualDirectory.hpp>
+#include <Nazara/Core/ByteArray.hpp>
+#include <Nazara/Core/ByteStream.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <vector>
+
+namespace bw
+{
+	namespace
+	{
+		// Measured results are accumulated there, so the compiler can't optimize the measured code away
+		volatile std::size_t s_sink = 0;
+
+		constexpr std::size_t MaxMapLoadIterationCount = 50; //< map loading is orders of magnitude slower than other benchmarks
+
+		class CoreBenchmarkRunner
+		{
+			public:
+				CoreBenchmarkRunner(const CoreBenchmarkParams& params, BenchmarkReport& report) :
+				m_params(params),
+				m_report(report),
+				m_randomGenerator(params.seed)
+				{
+				}
+
+				const CoreBenchmarkParams& GetParams() const
+				{
+					return m_params;
+				}
+
+				std::mt19937& GetRandomGenerator()
+				{
+					return m_randomGenerator;
+				}
+
+				bool IsEnabled(std::string_view name) const
+				{
+					return m_params.filter.empty() || name.find(m_params.filter) != std::string_view::npos;
+				}
+
+				// Runs func (which performs opCount operations) as many times as requested and reports the time of a single operation
+				template<typename F>
+				void Run(const std::string& name, std::size_t opCount, F&& func, std::size_t iterationCount = 0)
+				{
+					using Clock = std::chrono::steady_clock;
+
+					if (!IsEnabled(name))
+						return;
+
+					if (iterationCount == 0)
+						iterationCount = m_params.iterationCount;
+
+					Clock::time_point startTime = Clock::now();
+					for (std::size_t i = 0; i < iterationCount; ++i)
+						func();
+
+					double opTime = std::chrono::duration<double, std::nano>(Clock::now() - startTime).count() / (iterationCount * opCount);
+
+					fmt::print("{0:<48} {1:>10} {2:>14.2f}\n", name, opCount, opTime);
+					m_report.AddMeasure("core/" + name, "time", opTime, "ns/op");
+				}
+
+			private:
+				const CoreBenchmarkParams& m_params;
+				BenchmarkReport& m_report;
+				std::mt19937 m_randomGenerator;
+		};
+
+		template<typename T>
+		void BenchmarkCompressedUnsigned(CoreBenchmarkRunner& runner, const std::string& typeName)
+		{
+			constexpr std::size_t ValueCount = 1024;
+
+			// Spread values over every encoded length
+			std::vector<T> values(ValueCount);
+			for (T& value : values)
+			{
+				unsigned int shift = std::uniform_int_distribution<unsigned int>(0, sizeof(T) * 8 - 1)(runner.GetRandomGenerator());
+				value = std::uniform_int_distribution<T>(0, std::numeric_limits<T>::max())(runner.GetRandomGenerator()) >> shift;
+			}
+
+			Nz::ByteArray buffer;
+			Nz::ByteStream stream(&buffer, Nz::OpenMode_ReadWrite);
+			for (T value : values)
+				stream << CompressedUnsigned<T>(value);
+
+			runner.Run("CompressedUnsigned<" + typeName + "> write", ValueCount, [&]
+			{
+				stream.GetStream()->SetCursorPos(0);
+				for (T value : values)
+					stream << CompressedUnsigned<T>(value);
+			});
+
+			runner.Run("CompressedUnsigned<" + typeName + "> read", ValueCount, [&]
+			{
+				stream.GetStream()->SetCursorPos(0);
+
+				std::size_t sum = 0;
+				for (std::size_t i = 0; i < ValueCount; ++i)
+				{
+					CompressedUnsigned<T> value;
+					stream >> value;
+
+					sum += static_cast<std::size_t>(value);
+				}
+
+				s_sink = s_sink + sum;
+			});
+
+			runner.Run("DecodeCompressedUnsigned<" + typeName + ">", ValueCount, [&]
+			{
+				const Nz::UInt8* data = buffer.GetConstBuffer();
+				std::size_t size = buffer.GetSize();
+
+				std::size_t sum = 0;
+				while (size > 0)
+				{
+					T value;
+					std::size_t consumed = DecodeCompressedUnsigned(data, size, value);
+					if (consumed == 0)
+						break;
+
+					data += consumed;
+					size -= consumed;
+					sum += static_cast<std::size_t>(value);
+				}
+
+				s_sink = s_sink + sum;
+			});
+		}
+
+		void BenchmarkPacketSerializer(CoreBenchmarkRunner& runner)
+		{
+			// Mixed fields, looking like what entity packets hold
+			struct Record
+			{
+				CompressedUnsigned<Nz::UInt32> id;
+				Nz::Vector2f position;
+				std::string name;
+				Nz::UInt16 health;
+				float rotation;
+				bool isAsleep;
+				bool isFacingRight;
+				bool hasOwner;
+			};
+
+			constexpr std::size_t RecordCount = 256;
+
+			std::mt19937& randomGenerator = runner.GetRandomGenerator();
+			std::uniform_real_distribution<float> floatDis(-1'000.f, 1'000.f);
+
+			std::vector<Record> records(RecordCount);
+			for (std::size_t i = 0; i < RecordCount; ++i)
+			{
+				Record& record = records[i];
+				record.id = Nz::UInt32(i * 3);
+				record.position = Nz::Vector2f(floatDis(randomGenerator), floatDis(randomGenerator));
+				record.name = "entity_" + std::to_string(randomGenerator() % 1000);
+				record.health = Nz::UInt16(randomGenerator() % 100);
+				record.rotation = floatDis(randomGenerator);
+				record.isAsleep = randomGenerator() % 2;
+				record.isFacingRight = randomGenerator() % 2;
+				record.hasOwner = randomGenerator() % 2;
+			}
+
+			auto SerializeRecord = [](PacketSerializer& serializer, Record& record)
+			{
+				serializer &= record.id;
+				serializer &= record.position;
+				serializer &= record.name;
+				serializer &= record.health;
+				serializer &= record.rotation;
+				serializer &= record.isAsleep;
+				serializer &= record.isFacingRight;
+				serializer &= record.hasOwner;
+			};
+
+			Nz::ByteArray buffer;
+			Nz::ByteStream stream(&buffer, Nz::OpenMode_ReadWrite);
+			{
+				PacketSerializer serializer(stream, true);
+				for (Record& record : records)
+					SerializeRecord(serializer, record);
+			}
+
+			runner.Run("PacketSerializer write (ByteStream)", RecordCount, [&]
+			{
+				stream.GetStream()->SetCursorPos(0);
+
+				PacketSerializer serializer(stream, true);
+				for (Record& record : records)
+					SerializeRecord(serializer, record);
+			});
+
+			runner.Run("PacketSerializer read (ByteStream)", RecordCount, [&]
+			{
+				stream.GetStream()->SetCursorPos(0);
+
+				PacketSerializer serializer(stream, false);
+
+				std::size_t sum = 0;
+				for (std::size_t i = 0; i < RecordCount; ++i)
+				{
+					Record record;
+					SerializeRecord(serializer, record);
+
+					sum += record.name.size();
+				}
+
+				s_sink = s_sink + sum;
+			});
+		}
+
+		void BenchmarkVirtualDirectory(CoreBenchmarkRunner& runner)
+		{
+			// 3^8 files, eight levels deep (as mods mounted over the base scripts and assets can get)
+			constexpr std::size_t Depth = 8;
+			constexpr std::size_t FanOut = 3;
+
+			std::size_t fileCount = 1;
+			for (std::size_t i = 0; i < Depth; ++i)
+				fileCount *= FanOut;
+
+			std::vector<std::string> paths;
+			paths.reserve(fileCount);
+			for (std::size_t fileIndex = 0; fileIndex < fileCount; ++fileIndex)
+			{
+				std::string path;
+				std::size_t remainder = fileIndex;
+				for (std::size_t level = 0; level < Depth - 1; ++level)
+				{
+					path += "directory" + std::to_string(remainder % FanOut) + "/";
+					remainder /= FanOut;
+				}
+				path += "file" + std::to_string(remainder % FanOut) + ".lua";
+
+				paths.push_back(std::move(path));
+			}
+
+			auto BuildDirectory = [&]
+			{
+				auto directory = std::make_shared<VirtualDirectory>();
+				for (const std::string& path : paths)
+					directory->StoreFile(path, VirtualDirectory::FileContentEntry{});
+
+				return directory;
+			};
+
+			std::shuffle(paths.begin(), paths.end(), runner.GetRandomGenerator());
+
+			auto LookupPaths = [&](VirtualDirectory& directory)
+			{
+				std::size_t sum = 0;
+				for (const std::string& path : paths)
+				{
+					VirtualDirectory::Entry entry;
+					if (directory.GetEntry(path, &entry))
+						sum += entry.index();
+				}
+
+				s_sink = s_sink + sum;
+			};
+
+			std::string depthSuffix = " (depth " + std::to_string(Depth) + ")";
+
+			std::shared_ptr<VirtualDirectory> directory = BuildDirectory();
+			runner.Run("VirtualDirectory::GetEntry" + depthSuffix, paths.size(), [&] { LookupPaths(*directory); });
+
+			std::shared_ptr<VirtualDirectory> indexedDirectory = BuildDirectory();
+			indexedDirectory->EnablePathIndex();
+			runner.Run("VirtualDirectory::GetEntry indexed" + depthSuffix, paths.size(), [&] { LookupPaths(*indexedDirectory); });
+		}
+
+		void BenchmarkCircularBuffer(CoreBenchmarkRunner& runner)
+		{
+			constexpr std::size_t Capacity = 64; //< about what inputs and snapshots buffers hold
+			constexpr std::size_t OpCount = 1024;
+
+			CircularBuffer<Nz::UInt64> buffer(Capacity);
+
+			runner.Run("CircularBuffer enqueue/dequeue", OpCount, [&]
+			{
+				std::size_t sum = 0;
+				for (std::size_t i = 0; i < OpCount; ++i)
+				{
+					if (buffer.IsFull())
+						sum += buffer.Dequeue();
+
+					buffer.Enqueue(Nz::UInt64(i));
+				}
+
+				s_sink = s_sink + sum;
+			});
+
+			buffer.Clear();
+			while (!buffer.IsFull())
+				buffer.Enqueue(Nz::UInt64(buffer.GetSize()));
+
+			// Make it wrap around
+			for (std::size_t i = 0; i < Capacity / 2; ++i)
+			{
+				buffer.Dequeue();
+				buffer.Enqueue(Nz::UInt64(i));
+			}
+
+			runner.Run("CircularBuffer indexing", OpCount, [&]
+			{
+				std::size_t bufferSize = buffer.GetSize();
+
+				std::size_t sum = 0;
+				for (std::size_t i = 0; i < OpCount; ++i)
+					sum += buffer[i % bufferSize];
+
+				s_sink = s_sink + sum;
+			});
+		}
+
+		void BenchmarkNetworkStringStore(CoreBenchmarkRunner& runner)
+		{
+			constexpr std::size_t StringCount = 2048;
+
+			std::mt19937& randomGenerator = runner.GetRandomGenerator();
+
+			// Entity classes, property names and such
+			std::vector<std::string> strings;
+			strings.reserve(StringCount);
+			for (std::size_t i = 0; i < StringCount; ++i)
+				strings.push_back(((i % 2 == 0) ? "entity_" : "property_") + std::to_string(randomGenerator()));
+
+			NetworkStringStore store;
+			for (const std::string& str : strings)
+				store.RegisterString(str);
+
+			std::vector<Nz::UInt32> ids(StringCount);
+			for (std::size_t i = 0; i < StringCount; ++i)
+				ids[i] = Nz::UInt32(i);
+
+			std::shuffle(strings.begin(), strings.end(), randomGenerator);
+			std::shuffle(ids.begin(), ids.end(), randomGenerator);
+
+			runner.Run("NetworkStringStore::RegisterString", StringCount, [&]
+			{
+				NetworkStringStore newStore;
+				for (const std::string& str : strings)
+					newStore.RegisterString(str);
+
+				s_sink = s_sink + newStore.GetStringIndex(strings.front());
+			});
+
+			runner.Run("NetworkStringStore::GetStringIndex", StringCount, [&]
+			{
+				std::size_t sum = 0;
+				for (const std::string& str : strings)
+					sum += store.GetStringIndex(str);
+
+				s_sink = s_sink + sum;
+			});
+
+			runner.Run("NetworkStringStore::GetString", StringCount, [&]
+			{
+				std::size_t sum = 0;
+				for (Nz::UInt32 id : ids)
+					sum += store.GetString(id).size();
+
+				s_sink = s_sink + sum;
+			});
+		}
+
+		void BenchmarkPropertyValueMap(CoreBenchmarkRunner& runner)
+		{
+			constexpr std::size_t PropertyCount = 16; //< a well furnished entity
+
+			std::vector<std::string> names;
+			for (std::size_t i = 0; i < PropertyCount; ++i)
+				names.push_back("property_" + std::to_string(runner.GetRandomGenerator()() % 10'000));
+
+			auto FillMap = [&](PropertyValueMap& properties)
+			{
+				for (std::size_t i = 0; i < PropertyCount; ++i)
+				{
+					switch (i % 3)
+					{
+						case 0: properties.emplace(names[i], PropertySingleValue<PropertyType::Float>(float(i))); break;
+						case 1: properties.emplace(names[i], PropertySingleValue<PropertyType::Integer>(Nz::Int64(i))); break;
+						case 2: properties.emplace(names[i], PropertySingleValue<PropertyType::String>(names[i])); break;
+					}
+				}
+			};
+
+			runner.Run("PropertyValueMap insert", PropertyCount, [&]
+			{
+				PropertyValueMap properties;
+				FillMap(properties);
+
+				s_sink = s_sink + properties.size();
+			});
+
+			PropertyValueMap properties;
+			FillMap(properties);
+
+			std::vector<std::string> lookups = names;
+			std::shuffle(lookups.begin(), lookups.end(), runner.GetRandomGenerator());
+
+			runner.Run("PropertyValueMap lookup", PropertyCount, [&]
+			{
+				std::size_t sum = 0;
+				for (const std::string& name : lookups)
+				{
+					auto it = properties.find(name);
+					if (it != properties.end())
+						sum += it->second.index();
+				}
+
+				s_sink = s_sink + sum;
+			});
+		}
+
+		void BenchmarkMapLoading(CoreBenchmarkRunner& runner)
+		{
+			const std::filesystem::path& mapPath = runner.GetParams().mapPath;
+			if (mapPath.empty() || !runner.IsEnabled("Map::LoadFromBinary"))
+				return;
+
+			if (!std::filesystem::exists(mapPath))
+			{
+				fmt::print(stderr, "{0} doesn't exist, skipping map loading benchmark\n", mapPath.generic_u8string());
+				return;
+			}
+
+			// Map directories are compiled first, as servers load binary maps
+			std::filesystem::path binaryMapPath = mapPath;
+			bool isTemporary = false;
+			if (std::filesystem::is_directory(mapPath))
+			{
+				binaryMapPath = std::filesystem::temp_directory_path() / (mapPath.filename().generic_u8string() + ".bench.bmap");
+				isTemporary = true;
+
+				if (!Map::LoadFromDirectory(mapPath).Compile(binaryMapPath))
+				{
+					fmt::print(stderr, "failed to compile {0} to {1}, skipping map loading benchmark\n", mapPath.generic_u8string(), binaryMapPath.generic_u8string());
+					return;
+				}
+			}
+
+			std::size_t iterationCount = std::min(runner.GetParams().iterationCount, MaxMapLoadIterationCount);
+			runner.Run("Map::LoadFromBinary", 1, [&]
+			{
+				Map map = Map::LoadFromBinary(binaryMapPath);
+				s_sink = s_sink + map.GetLayerCount();
+			}, iterationCount);
+
+			if (isTemporary)
+				std::filesystem::remove(binaryMapPath);
+		}
+	}
+
+	void RunCoreBenchmarks(const CoreBenchmarkParams& params, BenchmarkReport& report)
+	{
+		CoreBenchmarkRunner runner(params, report);
+
+		fmt::print("\n{0:<48} {1:>10} {2:>14}\n", "core", "ops", "ns/op");
+
+		BenchmarkCompressedUnsigned<Nz::UInt32>(runner, "UInt32");
+		BenchmarkCompressedUnsigned<Nz::UInt64>(runner, "UInt64");
+		BenchmarkPacketSerializer(runner);
+		BenchmarkVirtualDirectory(runner);
+		BenchmarkCircularBuffer(runner);
+		BenchmarkNetworkStringStore(runner);
+		BenchmarkPropertyValueMap(runner);
+		BenchmarkMapLoading(runner);
+	}
+}
@@ -0,0 +1,29 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_BENCHMARK_COREBENCHMARKS_HPP
+#define BURGWAR_BENCHMARK_COREBENCHMARKS_HPP
+
+#include <filesystem>
+#include <string>
+
+namespace bw
+{
+	class BenchmarkReport;
+
+	struct CoreBenchmarkParams
+	{
+		std::filesystem::path mapPath; //< map directory or binary map loaded by the Map::LoadFromBinary benchmark, skipped if empty
+		std::size_t iterationCount;
+		std::string filter;
+		unsigned int seed;
+	};
+
+	// Low-level building blocks (compressed integers, serializer, virtual filesystem, containers, string store, properties, map loading)
+	void RunCoreBenchmarks(const CoreBenchmarkParams& params, BenchmarkReport& report);
+}
+
+#endif
@@ -0,0 +1,499 @@
+// Copyright(C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Benchmark/BenchmarkReport.hpp>
+#include <Benchmark/CoreBenchmarks.hpp>
+#include <CoreLib/PlayerCommandStore.hpp>
+#include <CoreLib/Protocol/PacketCompression.hpp>
+#include <CoreLib/Protocol/Packets.hpp>
+#include <Main/Main.hpp>
+#include <Nazara/Core/Initializer.hpp>
+#include <Nazara/Network/Network.hpp>
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+	struct BenchmarkParams
+	{
+		bw::BenchmarkReport* report;
+		std::size_t entityCount;
+		std::size_t iterationCount;
+		std::string filter;
+	};
+
+	class PayloadGenerator
+	{
+		public:
+			PayloadGenerator(std::size_t entityCount, unsigned int seed) :
+			m_entityCount(entityCount),
+			m_randomGenerator(seed)
+			{
+			}
+
+			std::size_t GetEntityCount() const
+			{
+				return m_entityCount;
+			}
+
+			bool Chance(float probability)
+			{
+				return std::uniform_real_distribution<float>(0.f, 1.f)(m_randomGenerator) < probability;
+			}
+
+			float Float(float min, float max)
+			{
+				return std::uniform_real_distribution<float>(min, max)(m_randomGenerator);
+			}
+
+			template<typename T>
+			T Integer(T min, T max)
+			{
+				return static_cast<T>(std::uniform_int_distribution<long long>(min, max)(m_randomGenerator));
+			}
+
+			Nz::Vector2f Position()
+			{
+				return Nz::Vector2f(Float(-5'000.f, 5'000.f), Float(-1'000.f, 1'000.f));
+			}
+
+			std::string String(std::size_t minLength, std::size_t maxLength)
+			{
+				std::string str(Integer<std::size_t>(minLength, maxLength), ' ');
+				for (char& c : str)
+					c = Integer<char>('a', 'z');
+
+				return str;
+			}
+
+			// Entities are spread between a few layers, with increasing ids
+			template<typename Entity, typename Layer, typename F>
+			void FillLayers(std::vector<Entity>& entities, std::vector<Layer>& layers, F&& fillEntity)
+			{
+				constexpr std::size_t LayerCount = 3;
+
+				std::size_t remainingEntities = m_entityCount;
+				for (std::size_t layerIndex = 0; layerIndex < LayerCount; ++layerIndex)
+				{
+					std::size_t layerEntityCount = (layerIndex == LayerCount - 1) ? remainingEntities : m_entityCount / LayerCount;
+					remainingEntities -= layerEntityCount;
+
+					auto& layer = layers.emplace_back();
+					layer.layerIndex = bw::LayerIndex(layerIndex);
+					layer.entityCount = Nz::UInt32(layerEntityCount);
+
+					Nz::UInt32 entityId = 0;
+					for (std::size_t i = 0; i < layerEntityCount; ++i)
+					{
+						entityId += Integer<Nz::UInt32>(1, 4);
+
+						auto& entity = entities.emplace_back();
+						fillEntity(entity, entityId);
+					}
+				}
+			}
+
+			bw::Packets::Helper::EntityData EntityData()
+			{
+				bw::Packets::Helper::EntityData entityData;
+				entityData.entityClass = Integer<Nz::UInt32>(0, 150);
+				entityData.uniqueId = Integer<Nz::UInt64>(1, 100'000);
+				entityData.position = Position();
+				entityData.rotation = Nz::RadianAnglef(Float(-3.14f, 3.14f));
+
+				if (Chance(0.1f))
+					entityData.scale = Float(0.5f, 2.f);
+
+				if (Chance(0.3f))
+				{
+					auto& health = entityData.health.emplace();
+					health.maxHealth = 100;
+					health.currentHealth = Integer<Nz::UInt16>(0, 100);
+				}
+
+				if (Chance(0.5f))
+				{
+					auto& physicsProperties = entityData.physicsProperties.emplace();
+					physicsProperties.angularVelocity = Nz::RadianAnglef(Float(-1.f, 1.f));
+					physicsProperties.isAsleep = Chance(0.5f);
+					physicsProperties.linearVelocity = Nz::Vector2f(Float(-500.f, 500.f), Float(-500.f, 500.f));
+					physicsProperties.mass = Float(1.f, 100.f);
+					physicsProperties.momentOfInertia = Float(1.f, 1'000.f);
+				}
+
+				if (Chance(0.05f))
+				{
+					entityData.ownerPlayerIndex = Integer<Nz::UInt16>(0, 16);
+					entityData.inputs.emplace();
+					entityData.playerMovement.emplace().isFacingRight = Chance(0.5f);
+				}
+
+				// Typical property map: a few scalars, a string and a position
+				std::size_t propertyCount = Integer<std::size_t>(0, 6);
+				for (std::size_t i = 0; i < propertyCount; ++i)
+				{
+					auto& property = entityData.properties.emplace_back();
+					property.name = Integer<Nz::UInt32>(0, 200);
+
+					switch (i % 4)
+					{
+						case 0: property.value = bw::PropertySingleValue<bw::PropertyType::Float>(Float(0.f, 100.f)); break;
+						case 1: property.value = bw::PropertySingleValue<bw::PropertyType::Integer>(Integer<Nz::Int64>(-1'000, 1'000)); break;
+						case 2: property.value = bw::PropertySingleValue<bw::PropertyType::String>(String(4, 24)); break;
+						case 3: property.value = bw::PropertySingleValue<bw::PropertyType::FloatPosition>(Position()); break;
+					}
+				}
+
+				return entityData;
+			}
+
+			bw::Packets::CreateEntities CreateEntities()
+			{
+				bw::Packets::CreateEntities packet;
+				packet.stateTick = 42;
+				FillLayers(packet.entities, packet.layers, [&](auto& entity, Nz::UInt32 entityId)
+				{
+					entity.id = entityId;
+					entity.data = EntityData();
+				});
+
+				return packet;
+			}
+
+			bw::Packets::EnableLayer EnableLayer()
+			{
+				bw::Packets::EnableLayer packet;
+				packet.layerIndex = 1;
+				packet.stateTick = 42;
+
+				Nz::UInt32 entityId = 0;
+				for (std::size_t i = 0; i < m_entityCount; ++i)
+				{
+					entityId += Integer<Nz::UInt32>(1, 4);
+
+					auto& entity = packet.layerEntities.emplace_back();
+					entity.id = entityId;
+					entity.data = EntityData();
+				}
+
+				return packet;
+			}
+
+			bw::Packets::EntitiesPhysics EntitiesPhysics()
+			{
+				bw::Packets::EntitiesPhysics packet;
+				packet.stateTick = 42;
+				FillLayers(packet.entities, packet.layers, [&](auto& entity, Nz::UInt32 entityId)
+				{
+					entity.id = entityId;
+					entity.asleep = Chance(0.5f);
+					entity.mass = Float(1.f, 100.f);
+					entity.momentOfInertia = Float(1.f, 1'000.f);
+					if (Chance(0.05f))
+						entity.playerMovement = bw::Packets::EntitiesPhysics::PlayerMovement{ 250.f, 100.f, 50.f };
+				});
+
+				return packet;
+			}
+
+			bw::Packets::MatchState MatchState(bool quantized)
+			{
+				bw::Packets::MatchState packet;
+				packet.isQuantized = quantized;
+				packet.lastInputTick = 41;
+				packet.stateTick = 42;
+				FillLayers(packet.entities, packet.layers, [&](auto& entity, Nz::UInt32 entityId)
+				{
+					entity.id = entityId;
+					entity.position = Position();
+					entity.rotation = Nz::RadianAnglef(Float(-3.14f, 3.14f));
+					entity.quantizedPosition = Nz::Vector2<Nz::UInt16>(Integer<Nz::UInt16>(0, 0xFFFF), Integer<Nz::UInt16>(0, 0xFFFF));
+					entity.quantizedRotation = Integer<Nz::UInt16>(0, 0xFFFF);
+
+					if (Chance(0.5f))
+					{
+						auto& physicsProperties = entity.physicsProperties.emplace();
+						physicsProperties.angularVelocity = Nz::RadianAnglef(Float(-1.f, 1.f));
+						physicsProperties.linearVelocity = Nz::Vector2f(Float(-500.f, 500.f), Float(-500.f, 500.f));
+						physicsProperties.quantizedAngularVelocity = Integer<Nz::Int16>(-0x7FFF, 0x7FFF);
+						physicsProperties.quantizedLinearVelocity = Nz::Vector2<Nz::Int16>(Integer<Nz::Int16>(-0x7FFF, 0x7FFF), Integer<Nz::Int16>(-0x7FFF, 0x7FFF));
+					}
+
+					if (Chance(0.05f))
+						entity.playerMovement.emplace().isFacingRight = Chance(0.5f);
+				});
+
+				return packet;
+			}
+
+			bw::Packets::NetworkStrings NetworkStrings()
+			{
+				bw::Packets::NetworkStrings packet;
+				packet.startId = 0;
+				for (std::size_t i = 0; i < m_entityCount; ++i)
+					packet.strings.push_back("entity_" + String(4, 16));
+
+				return packet;
+			}
+
+		private:
+			std::size_t m_entityCount;
+			std::mt19937 m_randomGenerator;
+	};
+
+	template<typename T>
+	void RunBenchmark(const char* name, T packet, std::size_t entityCount, const BenchmarkParams& params)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		if (!params.filter.empty() && std::string_view(name).find(params.filter) == std::string_view::npos)
+			return;
+
+		Nz::NetPacket data;
+
+		Clock::time_point startTime = Clock::now();
+		for (std::size_t i = 0; i < params.iterationCount; ++i)
+		{
+			data.Reset();
+			bw::PlayerCommandStore::SerializePacket(data, packet);
+		}
+		double serializationTime = std::chrono::duration<double, std::nano>(Clock::now() - startTime).count() / params.iterationCount;
+
+		std::size_t packetSize = data.GetDataSize();
+
+		startTime = Clock::now();
+		for (std::size_t i = 0; i < params.iterationCount; ++i)
+		{
+			data.GetStream()->SetCursorPos(Nz::NetPacket::HeaderSize + 1); //< skip opcode
+
+			T unserializedPacket;
+			bw::PacketSerializer serializer(data, false);
+			bw::Packets::Serialize(serializer, unserializedPacket);
+		}
+		double unserializationTime = std::chrono::duration<double, std::nano>(Clock::now() - startTime).count() / params.iterationCount;
+
+		// Size once compressed (as it would be sent if compression is enabled for this command)
+		std::vector<Nz::UInt8> compressedPayload;
+		const Nz::UInt8* payload = static_cast<const Nz::UInt8*>(data.GetConstData()) + Nz::NetPacket::HeaderSize + 1;
+		bool isCompressible = bw::CompressPacketPayload(payload, packetSize - 1, compressedPayload);
+		std::string compressedSize = (isCompressible) ? std::to_string(compressedPayload.size()) : "-";
+
+		std::string bytesPerEntity = (entityCount > 0) ? fmt::format("{0:.2f}", double(packetSize) / entityCount) : "-";
+
+		fmt::print("{0:<28} {1:>10} {2:>10} {3:>10} {4:>14.0f} {5:>14.0f}\n", name, packetSize, compressedSize, bytesPerEntity, serializationTime, unserializationTime);
+
+		std::string benchmarkName = std::string("packet/") + name;
+		params.report->AddMeasure(benchmarkName, "size", double(packetSize), "bytes");
+		if (isCompressible)
+			params.report->AddMeasure(benchmarkName, "lz4_size", double(compressedPayload.size()), "bytes");
+
+		params.report->AddMeasure(benchmarkName, "serialize", serializationTime, "ns");
+		params.report->AddMeasure(benchmarkName, "unserialize", unserializationTime, "ns");
+	}
+}
+
+int BurgWarBenchmark(int argc, char* argv[])
+{
+	cxxopts::Options options("BurgWarBenchmark", "Packet serialization and core utilities throughput benchmark");
+	options.add_options()
+		("e,entities", "Entity count of generated packets", cxxopts::value<std::size_t>()->default_value("500"), "count")
+		("f,filter", "Only run benchmarks whose name contains this string", cxxopts::value<std::string>()->default_value(""), "name")
+		("i,iterations", "Iteration count of each benchmark", cxxopts::value<std::size_t>()->default_value("1000"), "count")
+		("m,map", "Map (directory or binary) loaded by the Map::LoadFromBinary benchmark, empty to skip it", cxxopts::value<std::string>()->default_value("maps/ssb_island"), "path")
+		("r,report", "Write every measure to a CSV file (benchmark,metric,value,unit)", cxxopts::value<std::string>()->default_value(""), "file")
+		("s,seed", "Random seed used to generate payloads", cxxopts::value<unsigned int>()->default_value("0"), "seed")
+		("h,help", "Print usage")
+	;
+
+	try
+	{
+		auto result = options.parse(argc, argv);
+		if (result.count("help") > 0)
+		{
+			fmt::print("{}\n", options.help());
+			return EXIT_SUCCESS;
+		}
+
+		bw::BenchmarkReport report;
+
+		BenchmarkParams params;
+		params.report = &report;
+		params.entityCount = result["entities"].as<std::size_t>();
+		params.filter = result["filter"].as<std::string>();
+		params.iterationCount = std::max<std::size_t>(result["iterations"].as<std::size_t>(), 1);
+
+		Nz::Initializer<Nz::Network> network;
+
+		PayloadGenerator generator(params.entityCount, result["seed"].as<unsigned int>());
+		std::size_t entityCount = generator.GetEntityCount();
+
+		fmt::print("{0} entities, {1} iterations\n\n", entityCount, params.iterationCount);
+		fmt::print("{0:<28} {1:>10} {2:>10} {3:>10} {4:>14} {5:>14}\n", "packet", "bytes", "lz4 bytes", "B/entity", "serialize ns", "unserialize ns");
+
+		// Entity batches
+		RunBenchmark("CreateEntities", generator.CreateEntities(), entityCount, params);
+		RunBenchmark("EnableLayer", generator.EnableLayer(), entityCount, params);
+		RunBenchmark("EntitiesPhysics", generator.EntitiesPhysics(), entityCount, params);
+		RunBenchmark("MatchState", generator.MatchState(false), entityCount, params);
+		RunBenchmark("MatchState (quantized)", generator.MatchState(true), entityCount, params);
+
+		{
+			bw::Packets::DeleteEntities packet;
+			packet.stateTick = 42;
+			generator.FillLayers(packet.entities, packet.layers, [](auto& entity, Nz::UInt32 entityId) { entity.id = entityId; });
+
+			RunBenchmark("DeleteEntities", std::move(packet), entityCount, params);
+		}
+
+		{
+			bw::Packets::EntitiesAnimation packet;
+			packet.stateTick = 42;
+			generator.FillLayers(packet.entities, packet.layers, [&](auto& entity, Nz::UInt32 entityId)
+			{
+				entity.entityId = entityId;
+				entity.animId = generator.Integer<Nz::UInt8>(0, 8);
+			});
+
+			RunBenchmark("EntitiesAnimation", std::move(packet), entityCount, params);
+		}
+
+		{
+			bw::Packets::EntitiesInputs packet;
+			packet.stateTick = 42;
+			generator.FillLayers(packet.entities, packet.layers, [&](auto& entity, Nz::UInt32 entityId)
+			{
+				entity.id = entityId;
+				entity.inputs.aimDirection = Nz::Vector2f(generator.Float(-1.f, 1.f), generator.Float(-1.f, 1.f));
+				entity.inputs.isAttacking = generator.Chance(0.2f);
+				entity.inputs.isJumping = generator.Chance(0.1f);
+				entity.inputs.isMovingRight = generator.Chance(0.3f);
+			});
+
+			RunBenchmark("EntitiesInputs", std::move(packet), entityCount, params);
+		}
+
+		{
+			bw::Packets::EntitiesScale packet;
+			packet.stateTick = 42;
+			generator.FillLayers(packet.entities, packet.layers, [&](auto& entity, Nz::UInt32 entityId)
+			{
+				entity.id = entityId;
+				entity.newScale = generator.Float(0.5f, 2.f);
+			});
+
+			RunBenchmark("EntitiesScale", std::move(packet), entityCount, params);
+		}
+
+		{
+			bw::Packets::EntitiesWeapon packet;
+			packet.stateTick = 42;
+			generator.FillLayers(packet.entities, packet.layers, [&](auto& entity, Nz::UInt32 entityId)
+			{
+				entity.id = entityId;
+				entity.weaponEntityId = (generator.Chance(0.5f)) ? entityId + 1 : bw::Packets::EntitiesWeapon::NoWeapon;
+			});
+
+			RunBenchmark("EntitiesWeapon", std::move(packet), entityCount, params);
+		}
+
+		{
+			bw::Packets::HealthUpdate packet;
+			packet.stateTick = 42;
+			generator.FillLayers(packet.entities, packet.layers, [&](auto& entity, Nz::UInt32 entityId)
+			{
+				entity.id = entityId;
+				entity.currentHealth = generator.Integer<Nz::UInt16>(0, 100);
+			});
+
+			RunBenchmark("HealthUpdate", std::move(packet), entityCount, params);
+		}
+
+		RunBenchmark("NetworkStrings", generator.NetworkStrings(), entityCount, params);
+
+		// Small and frequent packets
+		{
+			bw::Packets::ChatMessage packet;
+			packet.content = generator.String(10, 80);
+			packet.localIndex = 0;
+			packet.playerIndex = 3;
+
+			RunBenchmark("ChatMessage", std::move(packet), 0, params);
+		}
+
+		{
+			bw::Packets::InputTimingCorrection packet;
+			packet.serverTick = 42;
+			packet.tickError = -3;
+
+			RunBenchmark("InputTimingCorrection", std::move(packet), 0, params);
+		}
+
+		{
+			bw::Packets::PlayerPingUpdate packet;
+			for (Nz::UInt16 i = 0; i < 16; ++i)
+			{
+				auto& player = packet.players.emplace_back();
+				player.ping = generator.Integer<Nz::UInt16>(10, 200);
+				player.playerIndex = i;
+			}
+
+			RunBenchmark("PlayerPingUpdate", std::move(packet), 0, params);
+		}
+
+		{
+			bw::Packets::PlayersInput packet;
+			packet.estimatedServerTick = 42;
+			packet.inputTick = 40;
+			packet.lastReceivedStateTick = 38;
+			packet.inputs.resize(2);
+
+			// Previous inputs, delta-coded: only the first player changed its inputs
+			for (Nz::UInt8 i = 0; i < bw::Packets::PlayersInput::MaxPreviousInputs; ++i)
+			{
+				auto& previousInputs = packet.previousInputs.emplace_back();
+				previousInputs.tickOffset = 1;
+				previousInputs.inputs.resize(2);
+				previousInputs.inputs[0].emplace().isMovingRight = true;
+			}
+
+			RunBenchmark("PlayersInput", std::move(packet), 0, params);
+		}
+
+		bw::CoreBenchmarkParams coreParams;
+		coreParams.filter = params.filter;
+		coreParams.iterationCount = params.iterationCount;
+		coreParams.mapPath = result["map"].as<std::string>();
+		coreParams.seed = result["seed"].as<unsigned int>();
+
+		bw::RunCoreBenchmarks(coreParams, report);
+
+		std::string reportFile = result["report"].as<std::string>();
+		if (!reportFile.empty())
+		{
+			if (!report.SaveToFile(reportFile))
+			{
+				fmt::print(stderr, "failed to write benchmark report to {}\n", reportFile);
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	catch (const cxxopts::OptionException& e)
+	{
+		fmt::print(stderr, "{}\n{}\n", e.what(), options.help());
+	}
+	catch (const std::exception& e)
+	{
+		fmt::print(stderr, "{}\n", e.what());
+	}
+
+	return EXIT_SUCCESS;
+}
+
+BurgWarMain(BurgWarBenchmark)
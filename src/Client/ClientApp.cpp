@@ -7,6 +7,7 @@
 #include <NDK/Systems.hpp>
 #include <CoreLib/Match.hpp>
 #include <CoreLib/Version.hpp>
+#include <CoreLib/Utility/Profiling.hpp>
 #include <ClientLib/ClientSession.hpp>
 #include <ClientLib/KeyboardAndMousePoller.hpp>
 #include <ClientLib/ClientMatch.hpp>
@@ -14,6 +15,9 @@
 #include <ClientLib/LocalSessionManager.hpp>
 #include <Client/States/BackgroundState.hpp>
 #include <Client/States/MainMenuState.hpp>
+#include <Client/States/Game/DemoState.hpp>
+#include <Nazara/Audio/Audio.hpp>
+#include <cstring>
 
 namespace bw
 {
@@ -26,6 +30,18 @@ namespace bw
 		if (!m_configFile.LoadFromFile("clientconfig.lua"))
 			throw std::runtime_error("failed to load config file");
 
+		// --timedemo <file> plays a demo back as fast as possible and reports frame times once it's over
+		for (int i = 1; i < argc; ++i)
+		{
+			if (std::strcmp(argv[i], "--timedemo") == 0 && i + 1 < argc)
+			{
+				m_configFile.SetStringValue("Demo.PlaybackFile", argv[++i]);
+				m_configFile.SetBoolValue("Demo.Timedemo", true);
+			}
+		}
+
+		m_isTimedemo = m_config.GetBoolValue("Demo.Timedemo");
+
 		LoadMods();
 		FillStores();
 
@@ -36,6 +52,15 @@ namespace bw
 		unsigned int height = m_config.GetIntegerValue<unsigned int>("WindowSettings.Height");
 		unsigned int width = m_config.GetIntegerValue<unsigned int>("WindowSettings.Width");
 
+		if (m_isTimedemo)
+		{
+			vsync = false;
+			fpsLimit = 0;
+
+			if (!m_config.GetBoolValue("Demo.TimedemoAudio"))
+				Nz::Audio::SetGlobalVolume(0.f);
+		}
+
 		Nz::VideoMode desktopMode = Nz::VideoMode::GetDesktopMode();
 
 		Nz::VideoMode chosenVideoMode;
@@ -103,7 +128,12 @@ namespace bw
 		});
 
 		m_stateMachine.PushState(std::make_shared<BackgroundState>(m_stateData));
-		m_stateMachine.PushState(std::make_shared<MainMenuState>(m_stateData));
+
+		const std::string& demoPath = m_config.GetStringValue("Demo.PlaybackFile");
+		if (!demoPath.empty())
+			m_stateMachine.PushState(std::make_shared<DemoState>(m_stateData, std::filesystem::u8path(demoPath), std::make_shared<MainMenuState>(m_stateData)));
+		else
+			m_stateMachine.PushState(std::make_shared<MainMenuState>(m_stateData));
 	}
 
 	ClientApp::~ClientApp()
@@ -116,15 +146,28 @@ namespace bw
 
 	int ClientApp::Run()
 	{
+		bool isFirstFrame = true;
 		while (ClientApplication::Run())
 		{
-			m_mainWindow->Display();
+			{
+				bwProfileZone("Display");
+				m_mainWindow->Display();
+			}
+			bwProfileFrame();
+
+			// Warm match resources up while the player looks at the menu
+			if (isFirstFrame)
+			{
+				FillMatchStores();
+				isFirstFrame = false;
+			}
 
 			BurgApp::Update();
 
 			m_networkReactors.Update();
 
-			if (!m_stateMachine.Update(GetUpdateTime()))
+			bwProfileZone("State machine update");
+			if (!m_stateMachine.Update((m_isTimedemo) ? TimedemoFrameTime : GetUpdateTime()))
 				break;
 		}
 
@@ -35,6 +35,9 @@ namespace bw
 			Nz::RenderWindow* m_mainWindow;
 			ClientAppConfig m_configFile;
 			NetworkReactorManager m_networkReactors;
+			bool m_isTimedemo;
+
+			static constexpr float TimedemoFrameTime = 1.f / 60.f; //< timedemos advance by a fixed step per frame, so every run renders the same frames
 	};
 }
 
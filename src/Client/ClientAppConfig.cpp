@@ -13,7 +13,15 @@ namespace bw
 		RegisterStringOption("Debug.ShowConnectionData");
 		RegisterBoolOption("Debug.ShowServerGhosts");
 		RegisterBoolOption("Debug.ShowVersion", true);
+		RegisterFloatOption("Demo.KeyframeInterval", 0.1, 3600.0, 5.0); //< seconds
+		RegisterStringOption("Demo.PlaybackFile", "");
+		RegisterStringOption("Demo.RecordDirectory", "");
+		RegisterBoolOption("Demo.Timedemo"); //< set by --timedemo
+		RegisterBoolOption("Demo.TimedemoAudio");
 		RegisterStringOption("Resources.AssetCacheDirectory", ".assetCache");
+		RegisterStringOption("Resources.ContentStoreDirectory", ".contentStore");
+		RegisterIntegerOption("Resources.ContentStoreMaxSize", 0, 1024 * 1024, 4096); //< MiB
+		RegisterIntegerOption("Resources.MaxConcurrentDownloads", 1, 32, 4);
 		RegisterStringOption("Resources.ScriptCacheDirectory", ".scriptCache");
 		RegisterIntegerOption("WindowSettings.AntialiasingLevel", 0, 16);
 		RegisterBoolOption("WindowSettings.Fullscreen");
@@ -9,9 +9,10 @@
 
 namespace bw
 {
-	AuthenticationState::AuthenticationState(std::shared_ptr<StateData> stateData, std::shared_ptr<ClientSession> clientSession, std::shared_ptr<AbstractState> originalState) :
+	AuthenticationState::AuthenticationState(std::shared_ptr<StateData> stateData, std::shared_ptr<ClientSession> clientSession, std::shared_ptr<AbstractState> originalState, std::vector<std::string> reconnectTokens) :
 	CancelableState(std::move(stateData), std::move(originalState)),
-	m_clientSession(std::move(clientSession))
+	m_clientSession(std::move(clientSession)),
+	m_reconnectTokens(std::move(reconnectTokens))
 	{
 		m_onAuthFailedSlot.Connect(m_clientSession->OnAuthFailure, [this](ClientSession*, const Packets::AuthFailure& /*data*/)
 		{
@@ -47,7 +48,10 @@ namespace bw
 		ConfigFile& playerConfig = GetStateData().app->GetPlayerSettings();
 
 		Packets::Auth authPacket;
-		authPacket.players.emplace_back().nickname = playerConfig.GetStringValue("Player.Name");
+		auto& authPlayer = authPacket.players.emplace_back();
+		authPlayer.nickname = playerConfig.GetStringValue("Player.Name");
+		if (!m_reconnectTokens.empty())
+			authPlayer.reconnectToken = m_reconnectTokens.front(); //< server gives our player back if it resumed the match we were in
 
 		m_clientSession->SendPacket(std::move(authPacket));
 	}
@@ -12,13 +12,15 @@
 #include <Client/States/Game/CancelableState.hpp>
 #include <NDK/Widgets/LabelWidget.hpp>
 #include <optional>
+#include <string>
+#include <vector>
 
 namespace bw
 {
 	class AuthenticationState final : public CancelableState
 	{
 		public:
-			AuthenticationState(std::shared_ptr<StateData> stateData, std::shared_ptr<ClientSession> clientSession, std::shared_ptr<AbstractState> originalState);
+			AuthenticationState(std::shared_ptr<StateData> stateData, std::shared_ptr<ClientSession> clientSession, std::shared_ptr<AbstractState> originalState, std::vector<std::string> reconnectTokens = {});
 			~AuthenticationState() = default;
 
 		private:
@@ -27,6 +29,7 @@ namespace bw
 
 			std::optional<Packets::AuthSuccess> m_authSuccessPacket;
 			std::shared_ptr<ClientSession> m_clientSession;
+			std::vector<std::string> m_reconnectTokens;
 
 			NazaraSlot(ClientSession, OnAuthFailure, m_onAuthFailedSlot);
 			NazaraSlot(ClientSession, OnAuthSuccess, m_onAuthSucceededSlot);
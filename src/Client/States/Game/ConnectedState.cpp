@@ -18,9 +18,11 @@ namespace bw
 	constexpr float UpdateInfoRefreshTime = 1.0f; //< 1s
 	constexpr Nz::UInt32 TimeoutThreshold = 3'000; //< 3s
 
-	ConnectedState::ConnectedState(std::shared_ptr<StateData> stateData, std::shared_ptr<ClientSession> clientSession, std::shared_ptr<AbstractState> firstState) :
+	ConnectedState::ConnectedState(std::shared_ptr<StateData> stateData, std::shared_ptr<ClientSession> clientSession, std::shared_ptr<AbstractState> firstState, std::optional<ConnectionState::Address> reconnectAddress, std::shared_ptr<AbstractState> originalState) :
 	AbstractState(std::move(stateData)),
+	m_reconnectAddress(std::move(reconnectAddress)),
 	m_firstState(std::move(firstState)),
+	m_originalState(std::move(originalState)),
 	m_clientSession(std::move(clientSession)),
 	m_downloadSpeedLabel(nullptr),
 	m_pingLabel(nullptr),
@@ -34,6 +36,16 @@ namespace bw
 	m_queryInfoTimer(0.f)
 	{
 		RefreshFlags();
+
+		m_onAuthSucceededSlot.Connect(m_clientSession->OnAuthSuccess, [this](ClientSession*, const Packets::AuthSuccess& data)
+		{
+			m_reconnectTokens.clear();
+			for (const auto& player : data.players)
+			{
+				if (!player.reconnectToken.empty())
+					m_reconnectTokens.push_back(player.reconnectToken);
+			}
+		});
 	}
 
 	void ConnectedState::Enter(Ndk::StateMachine& fsm)
@@ -253,7 +265,16 @@ namespace bw
 		if (!m_clientSession->IsConnected())
 		{
 			fsm.ResetState(std::make_shared<BackgroundState>(GetStateDataPtr()));
-			fsm.PushState(std::make_shared<ConnectionLostState>(GetStateDataPtr()));
+
+			// Server may have been restarted from a checkpoint of the match, try to get our player back (this falls back to joining as a new player)
+			if (m_reconnectAddress && !m_reconnectTokens.empty() && m_originalState)
+			{
+				bwLog(GetStateData().app->GetLogger(), LogLevel::Info, "connection lost, trying to reconnect...");
+				fsm.PushState(std::make_shared<ConnectionState>(GetStateDataPtr(), std::move(*m_reconnectAddress), std::move(m_originalState), std::move(m_reconnectTokens)));
+			}
+			else
+				fsm.PushState(std::make_shared<ConnectionLostState>(GetStateDataPtr()));
+
 			return true;
 		}
 
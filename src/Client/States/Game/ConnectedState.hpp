@@ -8,22 +8,24 @@
 #define BURGWAR_STATES_GAME_CONNECTEDSTATE_HPP
 
 #include <CoreLib/SessionBridge.hpp>
+#include <ClientLib/ClientSession.hpp>
 #include <CoreLib/Utility/AverageValues.hpp>
 #include <Client/States/AbstractState.hpp>
+#include <Client/States/Game/ConnectionState.hpp>
 #include <Nazara/Core/Clock.hpp>
 #include <Nazara/Graphics/Sprite.hpp>
 #include <NDK/Widgets/LabelWidget.hpp>
 #include <optional>
+#include <string>
 #include <variant>
+#include <vector>
 
 namespace bw
 {
-	class ClientSession;
-
 	class ConnectedState final : public AbstractState
 	{
 		public:
-			ConnectedState(std::shared_ptr<StateData> stateData, std::shared_ptr<ClientSession> clientSession, std::shared_ptr<AbstractState> firstState);
+			ConnectedState(std::shared_ptr<StateData> stateData, std::shared_ptr<ClientSession> clientSession, std::shared_ptr<AbstractState> firstState, std::optional<ConnectionState::Address> reconnectAddress = std::nullopt, std::shared_ptr<AbstractState> originalState = nullptr);
 			~ConnectedState() = default;
 
 		private:
@@ -44,9 +46,12 @@ namespace bw
 			void UpdateSessionInfo();
 			bool Update(Ndk::StateMachine& fsm, float elapsedTime) override;
 
+			std::optional<ConnectionState::Address> m_reconnectAddress;
 			std::optional<SessionBridge::SessionInfo> m_lastSessionInfo;
 			std::shared_ptr<AbstractState> m_firstState;
+			std::shared_ptr<AbstractState> m_originalState;
 			std::shared_ptr<ClientSession> m_clientSession;
+			std::vector<std::string> m_reconnectTokens;
 			Ndk::EntityOwner m_connectionLostEntity;
 			Ndk::LabelWidget* m_downloadSpeedLabel;
 			Ndk::LabelWidget* m_pingLabel;
@@ -61,6 +66,8 @@ namespace bw
 			float m_connectionLostCounter;
 			float m_queryInfoTimer;
 			float m_updateInfoTimer;
+
+			NazaraSlot(ClientSession, OnAuthSuccess, m_onAuthSucceededSlot);
 	};
 }
 
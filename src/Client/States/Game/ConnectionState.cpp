@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <Client/States/Game/ConnectionState.hpp>
+#include <CoreLib/Config.hpp>
 #include <CoreLib/NetworkSessionBridge.hpp>
 #include <ClientLib/LocalSessionBridge.hpp>
 #include <ClientLib/LocalSessionManager.hpp>
@@ -15,14 +16,15 @@
 
 namespace bw
 {
-	ConnectionState::ConnectionState(std::shared_ptr<StateData> stateData, Address remoteAddress, std::shared_ptr<AbstractState> previousState) :
-	ConnectionState(std::move(stateData), AddressList{ std::move(remoteAddress) }, std::move(previousState))
+	ConnectionState::ConnectionState(std::shared_ptr<StateData> stateData, Address remoteAddress, std::shared_ptr<AbstractState> previousState, std::vector<std::string> reconnectTokens) :
+	ConnectionState(std::move(stateData), AddressList{ std::move(remoteAddress) }, std::move(previousState), std::move(reconnectTokens))
 	{
 	}
 
-	ConnectionState::ConnectionState(std::shared_ptr<StateData> stateData, AddressList remoteAddresses, std::shared_ptr<AbstractState> previousState) :
+	ConnectionState::ConnectionState(std::shared_ptr<StateData> stateData, AddressList remoteAddresses, std::shared_ptr<AbstractState> previousState, std::vector<std::string> reconnectTokens) :
 	CancelableState(stateData, std::move(previousState)),
 	m_currentAddressIndex(0),
+	m_reconnectTokens(std::move(reconnectTokens)),
 	m_addresses(std::move(remoteAddresses)),
 	m_timeBeforeGivingUp(0.f)
 	{
@@ -33,12 +35,36 @@ namespace bw
 		{
 			UpdateStatus("Connected, authenticating...", Nz::Color::White);
 
-			auto authState = std::make_shared<AuthenticationState>(GetStateDataPtr(), m_clientSession, GetOriginalState());
-			SwitchToState(std::make_shared<ConnectedState>(GetStateDataPtr(), m_clientSession, std::move(authState)), 0.5f);
+			auto authState = std::make_shared<AuthenticationState>(GetStateDataPtr(), m_clientSession, GetOriginalState(), std::move(m_reconnectTokens));
+
+			// Remember where we are connected, to come back if the connection is lost while the server has a checkpoint of the match
+			std::optional<Address> reconnectAddress;
+			const Address& currentAddress = m_addresses[m_currentAddressIndex];
+			if (std::holds_alternative<Nz::IpAddress>(currentAddress) || std::holds_alternative<ServerName>(currentAddress))
+				reconnectAddress = currentAddress;
+
+			SwitchToState(std::make_shared<ConnectedState>(GetStateDataPtr(), m_clientSession, std::move(authState), std::move(reconnectAddress), GetOriginalState()), 0.5f);
 		});
 
-		m_clientSessionDisconnectedSlot.Connect(m_clientSession->OnDisconnected, [this](ClientSession*)
+		m_clientSessionDisconnectedSlot.Connect(m_clientSession->OnDisconnected, [this](ClientSession* session)
 		{
+			// Server may ask us to connect to another of its network threads
+			Nz::UInt32 disconnectionData = session->GetDisconnectionData();
+			if (disconnectionData & NetworkRedirectFlag)
+			{
+				if (const Nz::IpAddress* address = std::get_if<Nz::IpAddress>(&m_addresses[m_currentAddressIndex]))
+				{
+					Nz::IpAddress redirectAddress = *address;
+					redirectAddress.SetPort(Nz::UInt16(address->GetPort() + (disconnectionData & ~NetworkRedirectFlag)));
+
+					bwLog(GetStateData().app->GetLogger(), LogLevel::Debug, "server redirected us to {0}", redirectAddress.ToString().ToStdString());
+
+					m_addresses[m_currentAddressIndex] = redirectAddress;
+					ProcessNextAddress();
+					return;
+				}
+			}
+
 			HandleConnectionFailure();
 		});
 
@@ -148,6 +174,13 @@ namespace bw
 		m_clientSession->Connect(sessionManager->CreateSession());
 		m_timeBeforeGivingUp = 3.f; //< Should be instant
 	}
+
+	void ConnectionState::ProcessNextAddress(const std::shared_ptr<SessionBridge>& sessionBridge)
+	{
+		bwLog(GetStateData().app->GetLogger(), LogLevel::Debug, "connecting using custom session bridge...");
+		m_clientSession->Connect(sessionBridge);
+		m_timeBeforeGivingUp = 3.f; //< Should be instant
+	}
 	
 	bool ConnectionState::Update(Ndk::StateMachine& fsm, float elapsedTime)
 	{
@@ -30,11 +30,11 @@ namespace bw
 				Nz::UInt16 port;
 			};
 
-			using Address = std::variant<ServerName, Nz::IpAddress, LocalSessionManager*>;
+			using Address = std::variant<ServerName, Nz::IpAddress, LocalSessionManager*, std::shared_ptr<SessionBridge>>;
 			using AddressList = std::vector<Address>;
 
-			ConnectionState(std::shared_ptr<StateData> stateData, Address remoteAddress, std::shared_ptr<AbstractState> previousState);
-			ConnectionState(std::shared_ptr<StateData> stateData, AddressList remoteAddresses, std::shared_ptr<AbstractState> previousState);
+			ConnectionState(std::shared_ptr<StateData> stateData, Address remoteAddress, std::shared_ptr<AbstractState> previousState, std::vector<std::string> reconnectTokens = {});
+			ConnectionState(std::shared_ptr<StateData> stateData, AddressList remoteAddresses, std::shared_ptr<AbstractState> previousState, std::vector<std::string> reconnectTokens = {});
 			~ConnectionState();
 
 		private:
@@ -44,6 +44,7 @@ namespace bw
 			void ProcessNextAddress(const ServerName& name);
 			void ProcessNextAddress(const Nz::IpAddress& address);
 			void ProcessNextAddress(LocalSessionManager* sessionManager);
+			void ProcessNextAddress(const std::shared_ptr<SessionBridge>& sessionBridge);
 			bool Update(Ndk::StateMachine& fsm, float elapsedTime) override;
 
 			struct ResolvingData
@@ -57,6 +58,7 @@ namespace bw
 			std::optional<ResolvingData> m_resolvingData;
 			std::shared_ptr<ClientSession> m_clientSession;
 			std::size_t m_currentAddressIndex;
+			std::vector<std::string> m_reconnectTokens;
 			AddressList m_addresses;
 			float m_timeBeforeGivingUp;
 
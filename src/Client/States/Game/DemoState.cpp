@@ -0,0 +1,95 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Client/States/Game/DemoState.hpp>
+#include <ClientLib/DemoSessionBridge.hpp>
+#include <Client/ClientApp.hpp>
+#include <Client/States/BackgroundState.hpp>
+#include <Client/States/Game/ConnectionState.hpp>
+
+namespace bw
+{
+	DemoState::DemoState(std::shared_ptr<StateData> stateDataPtr, const std::filesystem::path& demoPath, std::shared_ptr<AbstractState> originalState) :
+	AbstractState(std::move(stateDataPtr)),
+	m_originalState(std::move(originalState))
+	{
+		ClientApp& app = *GetStateData().app;
+		m_isTimedemo = app.GetConfig().GetBoolValue("Demo.Timedemo");
+
+		try
+		{
+			m_sessionBridge = std::make_shared<DemoSessionBridge>(demoPath, app.GetLogger());
+		}
+		catch (const std::exception& e)
+		{
+			bwLog(app.GetLogger(), LogLevel::Error, "failed to load demo {0}: {1}", demoPath.generic_u8string(), e.what());
+			return;
+		}
+
+		bwLog(app.GetLogger(), LogLevel::Info, "playing demo {0} ({1} ticks)", demoPath.generic_u8string(), m_sessionBridge->GetLastTick());
+
+		ConnectSignal(GetStateData().window->GetEventHandler().OnKeyPressed, [this](const Nz::EventHandler*, const Nz::WindowEvent::KeyEvent& event)
+		{
+			Nz::UInt64 seekStep = static_cast<Nz::UInt64>(SeekStep / m_sessionBridge->GetTickDuration());
+			Nz::UInt64 currentTick = m_sessionBridge->GetCurrentTick();
+
+			switch (event.virtualKey)
+			{
+				case Nz::Keyboard::VKey::Home:
+					m_sessionBridge->Seek(0);
+					break;
+
+				case Nz::Keyboard::VKey::Left:
+					m_sessionBridge->Seek((currentTick > seekStep) ? currentTick - seekStep : 0);
+					break;
+
+				case Nz::Keyboard::VKey::Right:
+					m_sessionBridge->Seek(currentTick + seekStep);
+					break;
+
+				case Nz::Keyboard::VKey::Space:
+					m_sessionBridge->SetPaused(!m_sessionBridge->IsPaused());
+					break;
+
+				default:
+					break;
+			}
+		});
+	}
+
+	void DemoState::Enter(Ndk::StateMachine& fsm)
+	{
+		if (!m_sessionBridge)
+		{
+			if (m_isTimedemo)
+			{
+				GetStateData().app->Quit();
+				return;
+			}
+
+			fsm.ResetState(std::make_shared<BackgroundState>(GetStateDataPtr()));
+			fsm.PushState(m_originalState);
+			return;
+		}
+
+		fsm.PushState(std::make_shared<ConnectionState>(GetStateDataPtr(), m_sessionBridge, m_originalState));
+	}
+
+	bool DemoState::Update(Ndk::StateMachine& fsm, float elapsedTime)
+	{
+		if (!AbstractState::Update(fsm, elapsedTime))
+			return false;
+
+		m_sessionBridge->Update(elapsedTime);
+
+		// GameState reports frame times when leaving
+		if (m_isTimedemo && m_sessionBridge->GetCurrentTick() >= m_sessionBridge->GetLastTick())
+		{
+			bwLog(GetStateData().app->GetLogger(), LogLevel::Info, "timedemo finished");
+			GetStateData().app->Quit();
+		}
+
+		return true;
+	}
+}
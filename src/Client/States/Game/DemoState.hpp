@@ -0,0 +1,38 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_STATES_GAME_DEMOSTATE_HPP
+#define BURGWAR_STATES_GAME_DEMOSTATE_HPP
+
+#include <Client/States/AbstractState.hpp>
+#include <filesystem>
+#include <memory>
+
+namespace bw
+{
+	class DemoSessionBridge;
+
+	class DemoState final : public AbstractState
+	{
+		public:
+			DemoState(std::shared_ptr<StateData> stateDataPtr, const std::filesystem::path& demoPath, std::shared_ptr<AbstractState> originalState);
+			~DemoState() = default;
+
+		private:
+			void Enter(Ndk::StateMachine& fsm) override;
+			bool Update(Ndk::StateMachine& fsm, float elapsedTime) override;
+
+			static constexpr float SeekStep = 10.f; //< seconds
+
+			std::shared_ptr<AbstractState> m_originalState;
+			std::shared_ptr<DemoSessionBridge> m_sessionBridge;
+			bool m_isTimedemo;
+	};
+}
+
+#include <Client/States/Game/DemoState.inl>
+
+#endif
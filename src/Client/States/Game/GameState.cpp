@@ -3,40 +3,140 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <Client/States/Game/GameState.hpp>
+#include <ClientLib/ClientAssetStore.hpp>
 #include <ClientLib/ClientMatch.hpp>
+#include <ClientLib/DemoRecorder.hpp>
 #include <Client/ClientApp.hpp>
 #include <Client/States/BackgroundState.hpp>
 #include <Client/States/MainMenuState.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <ctime>
+#include <functional>
+#include <numeric>
 
 namespace bw
 {
-	GameState::GameState(std::shared_ptr<StateData> stateDataPtr, std::shared_ptr<ClientSession> clientSession, const Packets::AuthSuccess& authSuccess, const Packets::MatchData& matchData, std::shared_ptr<VirtualDirectory> assetDirectory, std::shared_ptr<VirtualDirectory> scriptDirectory) :
+	GameState::GameState(std::shared_ptr<StateData> stateDataPtr, std::shared_ptr<ClientSession> clientSession, const Packets::AuthSuccess& authSuccess, const Packets::MatchData& matchData, std::shared_ptr<VirtualDirectory> assetDirectory, std::shared_ptr<VirtualDirectory> scriptDirectory, std::shared_ptr<AsyncImageLoader> imageLoader) :
 	AbstractState(std::move(stateDataPtr)),
-	m_clientSession(std::move(clientSession))
+	m_clientSession(std::move(clientSession)),
+	m_lastFrameTime(0)
 	{
 		StateData& stateData = GetStateData();
 
 		m_match = std::make_shared<ClientMatch>(*stateData.app, stateData.window, stateData.window, &stateData.canvas.value(), *m_clientSession, authSuccess, matchData);
 		m_match->LoadAssets(std::move(assetDirectory));
+
+		ClientAssetStore& assetStore = m_match->GetAssetStore();
+		assetStore.AdoptImageLoader(std::move(imageLoader));
+
+		// Decode remaining images in the background while scripts are loaded and the first entities are received (files shipped under several paths only once)
+		std::vector<std::string> assetPaths;
+		assetPaths.reserve(matchData.assets.size());
+		for (const auto& asset : matchData.assets)
+		{
+			assetStore.RegisterAssetChecksum(asset.path, asset.sha1Checksum);
+			assetPaths.push_back(asset.path);
+		}
+
+		assetStore.PreloadAssets(assetPaths);
+
 		m_match->LoadScripts(std::move(scriptDirectory));
 
-		if (stateData.app->GetConfig().GetBoolValue("Debug.ShowServerGhosts"))
+		const ConfigFile& config = stateData.app->GetConfig();
+		if (config.GetBoolValue("Debug.ShowServerGhosts"))
 			m_match->InitDebugGhosts();
 
+		// Demos being played back aren't recorded again
+		const std::string& demoDirectory = config.GetStringValue("Demo.RecordDirectory");
+		if (!demoDirectory.empty() && config.GetStringValue("Demo.PlaybackFile").empty())
+			StartDemoRecording(std::filesystem::u8path(demoDirectory), matchData);
+
+		// Timedemos advance by a fixed step, running late ticks on real time would make the rendered frames depend on the hardware
+		m_isTimedemo = config.GetBoolValue("Demo.Timedemo");
+		if (m_isTimedemo)
+			m_match->EnableLateTicks(false);
+
 		m_clientSession->SendPacket(Packets::Ready{});
 	}
 
+	void GameState::StartDemoRecording(const std::filesystem::path& demoDirectory, const Packets::MatchData& matchData)
+	{
+		ClientApp& app = *GetStateData().app;
+
+		std::error_code error;
+		std::filesystem::create_directories(demoDirectory, error);
+
+		std::time_t currentTime = std::time(nullptr);
+		std::array<char, 32> fileName;
+		std::strftime(fileName.data(), fileName.size(), "%Y%m%d_%H%M%S.bwdemo", std::localtime(&currentTime));
+
+		std::filesystem::path demoPath = demoDirectory / fileName.data();
+
+		float keyframeInterval = app.GetConfig().GetFloatValue<float>("Demo.KeyframeInterval");
+		Nz::UInt64 keyframeTickInterval = static_cast<Nz::UInt64>(std::ceil(keyframeInterval / matchData.tickDuration));
+
+		try
+		{
+			m_match->StartDemoRecording(std::make_unique<DemoRecorder>(demoPath, app.GetLogger(), matchData, m_clientSession->GetNetworkStringStore().BuildPacket(), keyframeTickInterval));
+			bwLog(app.GetLogger(), LogLevel::Info, "recording demo to {0}", demoPath.generic_u8string());
+		}
+		catch (const std::exception& e)
+		{
+			bwLog(app.GetLogger(), LogLevel::Error, "failed to start demo recording: {0}", e.what());
+		}
+	}
+
 	void GameState::Leave(Ndk::StateMachine& /*fsm*/)
 	{
+		if (m_isTimedemo)
+			LogTimedemoReport();
+
 		if (m_clientSession)
 			m_clientSession->Disconnect();
 	}
 
+	void GameState::LogTimedemoReport()
+	{
+		ClientApp& app = *GetStateData().app;
+
+		std::size_t frameCount = m_timedemoFrameTimes.size();
+		if (frameCount == 0)
+			return;
+
+		std::sort(m_timedemoFrameTimes.begin(), m_timedemoFrameTimes.end(), std::greater<>());
+
+		// Lows are the average of the slowest frames rather than a single percentile, so a few hitches weigh in
+		auto AverageFrameTime = [&](std::size_t count)
+		{
+			count = std::clamp<std::size_t>(count, 1, frameCount);
+			return std::accumulate(m_timedemoFrameTimes.begin(), m_timedemoFrameTimes.begin() + count, Nz::UInt64(0)) / 1000.0 / count;
+		};
+
+		double averageTime = AverageFrameTime(frameCount);
+
+		bwLog(app.GetLogger(), LogLevel::Info, "timedemo: {0} frames in {1:.2f}s, average {2:.2f} ms ({3:.1f} FPS), 1% low {4:.2f} ms, 0.1% low {5:.2f} ms", frameCount, averageTime * frameCount / 1000.0, averageTime, 1000.0 / averageTime, AverageFrameTime(frameCount / 100), AverageFrameTime(frameCount / 1000));
+
+		bwLog(app.GetLogger(), LogLevel::Info, "{0}", m_match->GetFrameProfiler().Format("timedemo frame profile", "frames"));
+	}
+
 	bool GameState::Update(Ndk::StateMachine& fsm, float elapsedTime)
 	{
 		if (!AbstractState::Update(fsm, elapsedTime))
 			return false;
 
+		if (m_isTimedemo)
+		{
+			// Measured between two updates to include rendering and buffer swapping
+			Nz::UInt64 now = Nz::GetElapsedMicroseconds();
+			if (m_lastFrameTime != 0)
+				m_timedemoFrameTimes.push_back(now - m_lastFrameTime);
+
+			m_lastFrameTime = now;
+		}
+
 		if (!m_match->Update(elapsedTime))
 		{
 			fsm.ResetState(std::make_shared<BackgroundState>(GetStateDataPtr()));
@@ -10,27 +10,35 @@
 #include <CoreLib/Protocol/Packets.hpp>
 #include <Client/States/AbstractState.hpp>
 #include <ClientLib/ClientSession.hpp>
+#include <filesystem>
+#include <vector>
 
 namespace bw
 {
+	class AsyncImageLoader;
 	class ClientMatch;
 	class VirtualDirectory;
 
 	class GameState final : public AbstractState
 	{
 		public:
-			GameState(std::shared_ptr<StateData> stateDataPtr, std::shared_ptr<ClientSession> clientSession, const Packets::AuthSuccess& authSuccess, const Packets::MatchData& matchData, std::shared_ptr<VirtualDirectory> assetDirectory, std::shared_ptr<VirtualDirectory> scriptDirectory);
+			GameState(std::shared_ptr<StateData> stateDataPtr, std::shared_ptr<ClientSession> clientSession, const Packets::AuthSuccess& authSuccess, const Packets::MatchData& matchData, std::shared_ptr<VirtualDirectory> assetDirectory, std::shared_ptr<VirtualDirectory> scriptDirectory, std::shared_ptr<AsyncImageLoader> imageLoader);
 			~GameState() = default;
 
 			inline const std::shared_ptr<ClientMatch>& GetMatch();
 
 		private:
 			void Leave(Ndk::StateMachine& fsm) override;
+			void LogTimedemoReport();
+			void StartDemoRecording(const std::filesystem::path& demoDirectory, const Packets::MatchData& matchData);
 			bool Update(Ndk::StateMachine& fsm, float elapsedTime) override;
 
 			std::shared_ptr<AbstractState> m_nextState;
 			std::shared_ptr<ClientSession> m_clientSession;
 			std::shared_ptr<ClientMatch> m_match;
+			std::vector<Nz::UInt64> m_timedemoFrameTimes; //< microseconds, wall clock
+			Nz::UInt64 m_lastFrameTime;
+			bool m_isTimedemo;
 	};
 }
 
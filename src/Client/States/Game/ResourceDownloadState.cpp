@@ -3,18 +3,24 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <Client/States/Game/ResourceDownloadState.hpp>
+#include <CoreLib/Scripting/ScriptBytecodeCache.hpp>
+#include <CoreLib/Utility/JobSystem.hpp>
 #include <CoreLib/Utility/VirtualDirectory.hpp>
+#include <ClientLib/AsyncImageLoader.hpp>
 #include <ClientLib/ClientSession.hpp>
+#include <ClientLib/ContentStore.hpp>
 #include <ClientLib/HttpDownloadManager.hpp>
 #include <ClientLib/PacketDownloadManager.hpp>
 #include <Client/ClientApp.hpp>
 #include <Client/States/Game/GameState.hpp>
+#include <algorithm>
 #include <sstream>
 
 namespace bw
 {
 	ResourceDownloadState::ResourceDownloadState(std::shared_ptr<StateData> stateData, std::shared_ptr<ClientSession> clientSession, Packets::AuthSuccess authSuccess, Packets::MatchData matchData, std::shared_ptr<AbstractState> originalState) :
 	CancelableState(std::move(stateData), std::move(originalState)),
+	m_imageLoader(std::make_shared<AsyncImageLoader>()),
 	m_clientSession(std::move(clientSession)),
 	m_authSuccess(std::move(authSuccess)),
 	m_matchData(std::move(matchData))
@@ -26,6 +32,8 @@ namespace bw
 
 		m_targetAssetDirectory = std::make_shared<VirtualDirectory>();
 		m_targetScriptDirectory = std::make_shared<VirtualDirectory>();
+		m_targetAssetDirectory->EnablePathIndex();
+		m_targetScriptDirectory->EnablePathIndex();
 
 		m_downloadManagers.emplace_back(std::make_unique<PacketDownloadManager>(m_clientSession));
 
@@ -33,17 +41,41 @@ namespace bw
 		auto scriptDir = std::make_shared<VirtualDirectory>(config.GetStringValue("Resources.ScriptDirectory"));
 		RegisterFiles(m_matchData.scripts, scriptDir, m_targetScriptDirectory, config.GetStringValue("Resources.ScriptCacheDirectory"), m_scriptData, true);
 
+		// Every stage is pipelined: scripts are compiled and images decoded as soon as they are available, while other files are still downloading
+		for (const auto& script : m_matchData.scripts)
+		{
+			if (m_scriptData.find(script.path) == m_scriptData.end())
+				PreloadScript(script.path);
+		}
+
 		if (!m_matchData.fastDownloadUrls.empty())
 		{
-			if (WebService::IsInitialized())
-				m_downloadManagers.emplace(m_downloadManagers.begin(), std::make_unique<HttpDownloadManager>(app->GetLogger(), std::move(m_matchData.fastDownloadUrls), 2));
+			if (app->LoadWebService())
+				m_downloadManagers.emplace(m_downloadManagers.begin(), std::make_unique<HttpDownloadManager>(app->GetLogger(), std::move(m_matchData.fastDownloadUrls), config.GetIntegerValue<std::size_t>("Resources.MaxConcurrentDownloads")));
 			else
 				bwLog(app->GetLogger(), LogLevel::Warning, "web services are not initialized, fast download will be disabled");
 		}
 
-		// Register assets files
+		// Register assets files, smallest first (mostly sprites) so they can be decoded while bigger ones (sounds, musics) are downloading
+		std::vector<Packets::MatchData::ClientFile> assets = m_matchData.assets;
+		std::stable_sort(assets.begin(), assets.end(), [](const auto& first, const auto& second) { return first.size < second.size; });
+
 		auto assetDir = std::make_shared<VirtualDirectory>(config.GetStringValue("Resources.AssetDirectory"));
-		RegisterFiles(m_matchData.assets, assetDir, m_targetAssetDirectory, config.GetStringValue("Resources.AssetCacheDirectory"), m_assetData, false);
+		RegisterFiles(assets, assetDir, m_targetAssetDirectory, config.GetStringValue("Resources.AssetCacheDirectory"), m_assetData, false);
+
+		for (const auto& asset : assets)
+		{
+			if (m_assetData.find(asset.path) == m_assetData.end())
+				PreloadAsset(asset.path);
+		}
+
+		Nz::UInt64 contentStoreMaxSize = config.GetIntegerValue<Nz::UInt64>("Resources.ContentStoreMaxSize") * 1024 * 1024;
+		if (contentStoreMaxSize > 0)
+		{
+			auto contentStore = std::make_shared<ContentStore>(app->GetLogger(), std::filesystem::u8path(config.GetStringValue("Resources.ContentStoreDirectory")), contentStoreMaxSize);
+			for (auto& downloadManagerPtr : m_downloadManagers)
+				downloadManagerPtr->SetContentStore(contentStore);
+		}
 
 		for (auto& downloadManagerPtr : m_downloadManagers)
 		{
@@ -73,9 +105,15 @@ namespace bw
 
 				bwLog(GetStateData().app->GetLogger(), LogLevel::Info, "Downloaded {} ({})", fileEntry.downloadPath, ByteToString(downloadSpeed, true));
 				if (isAsset)
+				{
 					m_targetAssetDirectory->StoreFile(fileEntry.downloadPath, realPath);
+					PreloadAsset(fileEntry.downloadPath);
+				}
 				else
+				{
 					m_targetScriptDirectory->StoreFile(fileEntry.downloadPath, realPath);
+					PreloadScript(fileEntry.downloadPath);
+				}
 
 				UpdateStatus();
 			});
@@ -91,9 +129,15 @@ namespace bw
 
 				bwLog(GetStateData().app->GetLogger(), LogLevel::Info, "Downloaded {} ({})", fileEntry.downloadPath, ByteToString(downloadSpeed, true));
 				if (isAsset)
+				{
 					m_targetAssetDirectory->StoreFile(fileEntry.downloadPath, content);
+					PreloadAsset(fileEntry.downloadPath);
+				}
 				else
+				{
 					m_targetScriptDirectory->StoreFile(fileEntry.downloadPath, content);
+					PreloadScript(fileEntry.downloadPath);
+				}
 
 				UpdateStatus();
 			});
@@ -158,7 +202,7 @@ namespace bw
 			bwLog(GetStateData().app->GetLogger(), LogLevel::Info, "Creating match...");
 			UpdateStatus("Entering match...", Nz::Color::White);
 
-			SwitchToState(std::make_shared<GameState>(GetStateDataPtr(), m_clientSession, m_authSuccess, m_matchData, std::move(m_targetAssetDirectory), std::move(m_targetScriptDirectory)), 0.5f);
+			SwitchToState(std::make_shared<GameState>(GetStateDataPtr(), m_clientSession, m_authSuccess, m_matchData, std::move(m_targetAssetDirectory), std::move(m_targetScriptDirectory), std::move(m_imageLoader)), 0.5f);
 		}
 
 		return true;
@@ -191,6 +235,54 @@ namespace bw
 		m_clientSession->Disconnect();
 	}
 
+	void ResourceDownloadState::PreloadAsset(const std::string& assetPath)
+	{
+		if (!AsyncImageLoader::IsSupported(assetPath))
+			return;
+
+		VirtualDirectory::Entry entry;
+		if (!m_targetAssetDirectory->GetEntry(assetPath, &entry))
+			return;
+
+		m_imageLoader->Push(assetPath, std::move(entry));
+	}
+
+	void ResourceDownloadState::PreloadScript(const std::string& scriptPath)
+	{
+		VirtualDirectory::Entry entry;
+		if (!m_targetScriptDirectory->GetEntry(scriptPath, &entry))
+			return;
+
+		// Scripts are kept in memory, take a copy as the job may outlive this state
+		std::string content;
+		if (std::holds_alternative<VirtualDirectory::DataPointerEntry>(entry))
+		{
+			const auto& dataPointer = std::get<VirtualDirectory::DataPointerEntry>(entry);
+			content.assign(reinterpret_cast<const char*>(dataPointer.data), dataPointer.size);
+		}
+		else if (std::holds_alternative<VirtualDirectory::FileContentEntry>(entry))
+		{
+			const auto& fileContent = std::get<VirtualDirectory::FileContentEntry>(entry);
+			content.assign(reinterpret_cast<const char*>(fileContent.data()), fileContent.size());
+		}
+		else
+			return;
+
+		// Compiled into the application cache, where the match script preloading will find it
+		ClientApp* app = GetStateData().app;
+		app->GetJobSystem().Dispatch([bytecodeCache = app->GetBytecodeCache(), scriptPath, content = std::move(content)]
+		{
+			std::string cacheKey = ScriptBytecodeCache::ComputeKey(scriptPath, content);
+			if (bytecodeCache->Find(cacheKey))
+				return;
+
+			// Compilation errors are reported when the match loads the script
+			ScriptBytecodeCache::Bytecode bytecode;
+			if (ScriptBytecodeCache::Compile(scriptPath, content, &bytecode))
+				bytecodeCache->Store(cacheKey, std::move(bytecode));
+		}, JobPriority::Low);
+	}
+
 	void ResourceDownloadState::RegisterFiles(const std::vector<Packets::MatchData::ClientFile>& files, const std::shared_ptr<VirtualDirectory>& resourceDir, const std::shared_ptr<VirtualDirectory>& targetDir, const std::string& cacheDir, FileMap& fileMap, bool keepInMemory)
 	{
 		assert(!m_downloadManagers.empty());
@@ -209,7 +301,22 @@ namespace bw
 				bool isFilePresent = std::visit([&](auto&& arg)
 				{
 					using T = std::decay_t<decltype(arg)>;
-					if constexpr (std::is_same_v<T, VirtualDirectory::FileContentEntry>)
+					if constexpr (std::is_same_v<T, VirtualDirectory::DataPointerEntry>)
+					{
+						if (arg.size != resource.size)
+							return false;
+
+						auto hash = Nz::AbstractHash::Get(Nz::HashType_SHA1);
+						hash->Begin();
+						hash->Append(arg.data, arg.size);
+
+						if (expectedChecksum != hash->End())
+							return false;
+
+						targetDir->StoreFile(resource.path, arg);
+						return true;
+					}
+					else if constexpr (std::is_same_v<T, VirtualDirectory::FileContentEntry>)
 					{
 						std::size_t fileSize = arg.size();
 						if (fileSize != resource.size)
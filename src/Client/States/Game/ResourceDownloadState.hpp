@@ -18,6 +18,7 @@
 
 namespace bw
 {
+	class AsyncImageLoader;
 	class ClientSession;
 	class VirtualDirectory;
 
@@ -40,6 +41,9 @@ namespace bw
 
 			void OnCancelled() override;
 
+			void PreloadAsset(const std::string& assetPath);
+			void PreloadScript(const std::string& scriptPath);
+
 			void RegisterFiles(const std::vector<Packets::MatchData::ClientFile>& files, const std::shared_ptr<VirtualDirectory>& resourceDir, const std::shared_ptr<VirtualDirectory>& targetDir, const std::string& cacheDir, FileMap& fileMap, bool keepInMemory);
 			bool Update(Ndk::StateMachine& fsm, float elapsedTime) override;
 
@@ -48,6 +52,7 @@ namespace bw
 
 			FileMap m_assetData;
 			FileMap m_scriptData;
+			std::shared_ptr<AsyncImageLoader> m_imageLoader;
 			std::shared_ptr<ClientSession> m_clientSession;
 			std::shared_ptr<VirtualDirectory> m_targetAssetDirectory;
 			std::shared_ptr<VirtualDirectory> m_targetScriptDirectory;
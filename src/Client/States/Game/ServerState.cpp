@@ -4,16 +4,21 @@
 
 #include <Client/States/Game/ServerState.hpp>
 #include <CoreLib/Utils.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
 #include <ClientLib/LocalSessionManager.hpp>
 #include <Client/ClientApp.hpp>
 #include <Client/States/BackgroundState.hpp>
 #include <Client/States/Game/ConnectionState.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <chrono>
 
 namespace bw
 {
 	ServerState::ServerState(std::shared_ptr<StateData> stateDataPtr, Match::MatchSettings matchSettings, Match::GamemodeSettings gamemodeSettings, Match::ModSettings modSettings, std::shared_ptr<AbstractState> originalState) :
 	AbstractState(std::move(stateDataPtr)),
-	m_originalState(std::move(originalState))
+	m_originalState(std::move(originalState)),
+	m_isMatchRunning(true),
+	m_stopSimulation(false)
 	{
 		ClientApp& app = *GetStateData().app;
 		const ConfigFile& config = app.GetConfig();
@@ -21,10 +26,53 @@ namespace bw
 		m_match.emplace(app, std::move(matchSettings), std::move(gamemodeSettings), std::move(modSettings));
 
 		MatchSessions& sessions = m_match->GetSessions();
-		m_localSessionManager = sessions.CreateSessionManager<LocalSessionManager>();
+		m_localSessionManager = sessions.CreateSessionManager<LocalSessionManager>(true);
 
 		if (config.GetBoolValue("Debug.SendServerState"))
 			m_match->InitDebugGhosts();
+
+		m_simulationThread = std::thread([this]
+		{
+			using Clock = std::chrono::steady_clock;
+
+			Clock::time_point nextUpdate = Clock::now();
+			Nz::UInt64 lastUpdate = Nz::GetElapsedMicroseconds();
+
+			while (!m_stopSimulation)
+			{
+				Nz::UInt64 now = Nz::GetElapsedMicroseconds();
+				float elapsedTime = (now - lastUpdate) / 1'000'000.f;
+				lastUpdate = now;
+
+				try
+				{
+					if (!m_match->Update(elapsedTime))
+						break;
+				}
+				catch (const std::exception& e)
+				{
+					bwLog(m_match->GetLogger(), LogLevel::Error, "match update failed: {0}", e.what());
+					break;
+				}
+
+				nextUpdate += std::chrono::microseconds(static_cast<Nz::UInt64>(m_match->GetTickDuration() * 1'000'000));
+
+				Clock::time_point currentTime = Clock::now();
+				if (nextUpdate > currentTime)
+					std::this_thread::sleep_until(nextUpdate);
+				else
+					nextUpdate = currentTime;
+			}
+
+			m_isMatchRunning = false;
+		});
+	}
+
+	ServerState::~ServerState()
+	{
+		// The match must not be destroyed while its thread is updating it
+		m_stopSimulation = true;
+		m_simulationThread.join();
 	}
 
 	void ServerState::Enter(Ndk::StateMachine& fsm)
@@ -37,7 +85,10 @@ namespace bw
 		if (!AbstractState::Update(fsm, elapsedTime))
 			return false;
 
-		if (!m_match->Update(elapsedTime))
+		// Client side of the local sessions, the match thread handles the server side
+		m_localSessionManager->PollClients();
+
+		if (!m_isMatchRunning)
 		{
 			fsm.ResetState(std::make_shared<BackgroundState>(GetStateDataPtr()));
 			fsm.PushState(m_originalState);
@@ -9,7 +9,9 @@
 
 #include <Client/States/AbstractState.hpp>
 #include <CoreLib/Match.hpp>
+#include <atomic>
 #include <optional>
+#include <thread>
 
 namespace bw
 {
@@ -17,13 +19,14 @@ namespace bw
 	class LocalSessionManager;
 	class NetworkSessionManager;
 
+	// Hosts a match for the local player, the match runs on its own thread so its ticks and the client frames don't delay each other
 	class ServerState final : public AbstractState
 	{
 		public:
 			ServerState(std::shared_ptr<StateData> stateDataPtr, Match::MatchSettings matchSettings, Match::GamemodeSettings gamemodeSettings, Match::ModSettings modSettings, std::shared_ptr<AbstractState> originalState);
-			~ServerState() = default;
+			~ServerState();
 
-			inline Match& GetMatch();
+			inline Match& GetMatch(); //< the match is updated by the simulation thread
 			inline const Match& GetMatch() const;
 
 		private:
@@ -32,6 +35,9 @@ namespace bw
 
 			std::optional<Match> m_match;
 			std::shared_ptr<AbstractState> m_originalState;
+			std::atomic_bool m_isMatchRunning;
+			std::atomic_bool m_stopSimulation;
+			std::thread m_simulationThread;
 			LocalSessionManager* m_localSessionManager;
 	};
 }
@@ -3,29 +3,88 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <Client/States/ServerListState.hpp>
+#include <CoreLib/Config.hpp>
 #include <CoreLib/Version.hpp>
 #include <CoreLib/WebRequest.hpp>
 #include <Client/ClientApp.hpp>
 #include <Client/States/JoinServerState.hpp>
-#include <Client/States/Game/ConnectionState.hpp>
+#include <Nazara/Core/Clock.hpp>
 #include <Nazara/Utility/RichTextDrawer.hpp>
 #include <NDK/StateMachine.hpp>
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cassert>
+#include <fstream>
 
 namespace bw
 {
 	namespace
 	{
 		constexpr Nz::UInt32 MasterServerDataVersion = 1U;
+		constexpr Nz::UInt32 ServerListCacheVersion = 1U;
+
+		constexpr const char* ServerListCacheFile = "serverlist_cache.json";
+
+		constexpr std::size_t MaxConcurrentProbes = 16; //< per reactor (one per protocol)
+		constexpr std::size_t PrefetchServerCount = 8;
+		constexpr Nz::UInt64 ProbeTimeout = 3000; //< ms
+
+		std::optional<ConnectionState::AddressList> ParseConnectionDetails(const Logger& logger, const std::string& body)
+		{
+			nlohmann::json connectionDetails;
+
+			try
+			{
+				connectionDetails = nlohmann::json::parse(body);
+			}
+			catch (const std::exception& e)
+			{
+				bwLog(logger, LogLevel::Error, "failed to parse connection details: {0}", e.what());
+				return std::nullopt;
+			}
+
+			Nz::UInt32 dataVersion = connectionDetails.value("data_version", 0);
+			if (dataVersion != MasterServerDataVersion)
+				bwLog(logger, LogLevel::Warning, "unexpected data version (expected {0}, got {1})", MasterServerDataVersion, dataVersion);
+
+			std::string addresses = connectionDetails.value("ip", "");
+			if (addresses.empty())
+			{
+				bwLog(logger, LogLevel::Error, "missing ip field in connection details");
+				return std::nullopt;
+			}
+
+			Nz::UInt16 serverPort = connectionDetails.value("port", Nz::UInt16(0));
+			if (serverPort == 0)
+			{
+				bwLog(logger, LogLevel::Error, "missing or invalid port field ({0}) in connection details", serverPort);
+				return std::nullopt;
+			}
+
+			ConnectionState::AddressList serverAddresses;
+			SplitString(addresses, ";", [&](const std::string_view& ip)
+			{
+				ConnectionState::ServerName address;
+				address.hostname = ip;
+				address.port = serverPort;
+
+				serverAddresses.emplace_back(std::move(address));
+				return true;
+			});
+
+			return serverAddresses;
+		}
 	}
 
+	constexpr float PingInterval = 10.f;
 	constexpr float RefreshTime = 15.f;
 
 	ServerListState::ServerListState(std::shared_ptr<StateData> stateData, std::shared_ptr<AbstractState> previousState) :
 	AbstractState(std::move(stateData)),
-	m_previousState(std::move(previousState))
+	m_previousState(std::move(previousState)),
+	m_timeBeforePing(PingInterval)
 	{
-		if (WebService::IsInitialized())
+		if (GetStateData().app->LoadWebService())
 			m_webService.emplace(GetStateData().app->GetLogger());
 		else
 			bwLog(GetStateData().app->GetLogger(), LogLevel::Warning, "web services are not initialized, server listing will not work");
@@ -63,10 +122,14 @@ namespace bw
 
 			return true;
 		});
+
+		LoadServerListCache();
 	}
 
 	ServerListState::~ServerListState()
 	{
+		SaveServerListCache();
+
 		//FIXME: ScrollAreaWidget uses SetParent which is broken as it doesn't register children to parent
 		m_serverListWidget->SetParent(&GetStateData().canvas.value());
 		m_serverListWidget->Destroy();
@@ -103,9 +166,59 @@ namespace bw
 			RefreshServers(elapsedTime);
 		}
 
+		PollProbes();
+
+		if ((m_timeBeforePing -= elapsedTime) < 0.f)
+		{
+			PingServers();
+			m_timeBeforePing = PingInterval;
+		}
+
 		return true;
 	}
 
+	auto ServerListState::FindServer(const std::string& masterServer, const std::string& uuid) -> ServerData*
+	{
+		auto masterIt = m_masterServers.find(masterServer);
+		if (masterIt == m_masterServers.end())
+			return nullptr;
+
+		auto serverIt = masterIt.value().serverList.find(uuid);
+		if (serverIt == masterIt.value().serverList.end())
+			return nullptr;
+
+		return &serverIt.value();
+	}
+
+	void ServerListState::LoadServerListCache()
+	{
+		std::ifstream file(ServerListCacheFile);
+		if (!file)
+			return;
+
+		try
+		{
+			nlohmann::json cacheDoc = nlohmann::json::parse(file);
+			if (cacheDoc.value("cache_version", 0U) != ServerListCacheVersion)
+				return;
+
+			// Display the last known servers right away, they will be replaced by the first refresh
+			for (auto&& [url, serverListDoc] : cacheDoc["master_servers"].items())
+			{
+				auto it = m_masterServers.find(url);
+				if (it == m_masterServers.end())
+					continue;
+
+				it.value().lastServerList = serverListDoc.dump();
+				UpdateServerList(url, serverListDoc);
+			}
+		}
+		catch (const std::exception& e)
+		{
+			bwLog(GetStateData().app->GetLogger(), LogLevel::Warning, "failed to load server list cache: {0}", e.what());
+		}
+	}
+
 	void ServerListState::LayoutWidgets()
 	{
 		Nz::Vector2f canvasSize = GetStateData().canvas->GetSize();
@@ -180,71 +293,177 @@ namespace bw
 
 	void ServerListState::OnServerConnectionPressed(const std::string& masterServer, const std::string& uuid)
 	{
-		std::unique_ptr<WebRequest> request = WebRequest::Get(masterServer + "/server/" + uuid + "/connection_details", [this, stateData = GetStateDataPtr(), masterServer, uuid](WebRequestResult&& result)
+		ServerData* serverData = FindServer(masterServer, uuid);
+		if (!serverData)
+			return;
+
+		// Connection details of the most populated servers are usually prefetched
+		if (serverData->connectionDetails)
 		{
-			if (!result)
+			m_nextGameState = std::make_shared<ConnectionState>(GetStateDataPtr(), *serverData->connectionDetails, shared_from_this());
+			return;
+		}
+
+		RequestConnectionDetails(masterServer, uuid, true);
+	}
+
+	void ServerListState::PingServers()
+	{
+		for (auto masterIt = m_masterServers.begin(); masterIt != m_masterServers.end(); ++masterIt)
+		{
+			for (auto serverIt = masterIt.value().serverList.begin(); serverIt != masterIt.value().serverList.end(); ++serverIt)
 			{
-				bwLog(stateData->app->GetLogger(), LogLevel::Error, "failed to connect to server {0} from {1}, connect request failed: {2}", uuid, masterServer, result.GetErrorMessage());
-				return;
+				ServerData& serverData = serverIt.value();
+				if (serverData.connectionDetails && !serverData.isProbing)
+					StartProbe(masterIt->first, serverIt->first, serverData);
 			}
+		}
+	}
+
+	void ServerListState::PollProbes()
+	{
+		bool hasUpdatedPing = false;
+
+		auto HandleProbeResult = [&](std::size_t peerId, Nz::UInt32 ping)
+		{
+			auto it = m_pendingProbes.find(peerId);
+			if (it == m_pendingProbes.end())
+				return false;
 
-			switch (result.GetReponseCode())
+			if (ServerData* serverData = FindServer(it->second.masterServer, it->second.uuid))
 			{
-				case 200:
-				{
-					bwLog(stateData->app->GetLogger(), LogLevel::Debug, "successfully received connection info of {0} from {1}", uuid, masterServer);
-					nlohmann::json connectionDetails;
-					
-					try
-					{
-						connectionDetails = nlohmann::json::parse(result.GetBody());
-					}
-					catch (const std::exception& e)
-					{
-						bwLog(stateData->app->GetLogger(), LogLevel::Error, "failed to parse connection details: {0}", e.what());
-						return;
-					}
+				serverData->isProbing = false;
+				serverData->ping = ping;
+				RefreshServerLabel(*serverData);
 
-					Nz::UInt32 dataVersion = connectionDetails.value("data_version", 0);
-					if (dataVersion != MasterServerDataVersion)
-						bwLog(stateData->app->GetLogger(), LogLevel::Warning, "unexpected data version (expected {0}, got {1})", MasterServerDataVersion, dataVersion);
+				hasUpdatedPing = true;
+			}
 
-					std::string addresses = connectionDetails.value("ip", "");
-					if (addresses.empty())
-					{
-						bwLog(stateData->app->GetLogger(), LogLevel::Error, "missing ip field, aborting connection.");
-						return;
-					}
+			m_pendingProbes.erase(it);
+			return true;
+		};
 
-					Nz::UInt16 serverPort = connectionDetails.value("port", Nz::UInt16(0));
-					if (serverPort == 0)
-					{
-						bwLog(stateData->app->GetLogger(), LogLevel::Error, "missing or invalid port field ({0}), aborting connection.", serverPort);
-						return;
-					}
+		Nz::UInt64 now = Nz::GetElapsedMilliseconds();
+		for (const auto& reactorPtr : m_probeReactors)
+		{
+			reactorPtr->Poll([&](bool /*outgoing*/, std::size_t peerId, Nz::UInt32 /*data*/)
+			{
+				// Connection is established after a single round trip, which is all we wanted
+				auto it = m_pendingProbes.find(peerId);
+				if (it == m_pendingProbes.end())
+					return;
+
+				reactorPtr->DisconnectPeer(peerId, 0, DisconnectionType::Kick);
+				HandleProbeResult(peerId, static_cast<Nz::UInt32>(now - it->second.startTime));
+			},
+			[&](std::size_t peerId, Nz::UInt32 /*data*/)
+			{
+				HandleProbeResult(peerId, UnreachablePing);
+			},
+			[&](std::size_t /*peerId*/, Nz::NetPacket&& /*packet*/)
+			{
+			});
+		}
 
-					ConnectionState::AddressList serverAddresses;
-					SplitString(addresses, ";", [&](const std::string_view& ip)
-					{
-						ConnectionState::ServerName address;
-						address.hostname = ip;
-						address.port = serverPort;
+		std::vector<std::size_t> timedOutProbes;
+		for (auto&& [peerId, probe] : m_pendingProbes)
+		{
+			if (now - probe.startTime >= ProbeTimeout)
+				timedOutProbes.push_back(peerId);
+		}
 
-						serverAddresses.emplace_back(std::move(address));
-						return true;
-					});
+		for (std::size_t peerId : timedOutProbes)
+		{
+			m_pendingProbes[peerId].reactor->DisconnectPeer(peerId, 0, DisconnectionType::Kick);
+			HandleProbeResult(peerId, UnreachablePing);
+		}
 
-					m_nextGameState = std::make_shared<ConnectionState>(GetStateDataPtr(), std::move(serverAddresses), shared_from_this());
-					break;
-				}
+		if (hasUpdatedPing)
+			LayoutWidgets();
+	}
 
-				default:
-					bwLog(stateData->app->GetLogger(), LogLevel::Error, "failed to connect to server {0} from {1}, request failed with code {2}", uuid, masterServer, result.GetReponseCode());
-					break;
-			}
+	void ServerListState::PrefetchConnectionDetails()
+	{
+		if (!m_webService)
+			return;
+
+		struct ServerRef
+		{
+			const std::string* masterServer;
+			const std::string* uuid;
+			Nz::UInt32 playerCount;
+		};
+
+		std::vector<ServerRef> servers;
+		for (auto&& [masterServer, masterServerData] : m_masterServers)
+		{
+			for (auto&& [uuid, serverData] : masterServerData.serverList)
+				servers.push_back({ &masterServer, &uuid, serverData.playerCount });
+		}
+
+		std::size_t prefetchCount = std::min(servers.size(), PrefetchServerCount);
+		std::partial_sort(servers.begin(), servers.begin() + prefetchCount, servers.end(), [](const ServerRef& lhs, const ServerRef& rhs)
+		{
+			return lhs.playerCount > rhs.playerCount;
 		});
 
-		m_webService->AddRequest(std::move(request));
+		for (std::size_t i = 0; i < prefetchCount; ++i)
+		{
+			ServerData* serverData = FindServer(*servers[i].masterServer, *servers[i].uuid);
+			if (!serverData->connectionDetails && !serverData->isRequestingDetails)
+				RequestConnectionDetails(*servers[i].masterServer, *servers[i].uuid, false);
+		}
+	}
+
+	void ServerListState::RefreshServerLabel(ServerData& serverData)
+	{
+		Nz::RichTextDrawer infoDrawer;
+		infoDrawer.SetDefaultCharacterSize(24);
+		infoDrawer.AppendText(serverData.serverName + '\n');
+
+		infoDrawer.SetDefaultCharacterSize(18);
+		infoDrawer.SetDefaultColor(Nz::Color::White);
+		if (!serverData.description.empty())
+			infoDrawer.AppendText(serverData.description + '\n');
+
+		infoDrawer.SetDefaultCharacterSize(18);
+
+		infoDrawer.SetDefaultColor(Nz::Color(220, 220, 220));
+		infoDrawer.AppendText("Gamemode: ");
+
+		infoDrawer.SetDefaultColor(Nz::Color::White);
+		infoDrawer.AppendText(serverData.gamemode);
+
+		infoDrawer.SetDefaultColor(Nz::Color(220, 220, 220));
+		infoDrawer.AppendText(" Map: ");
+
+		infoDrawer.SetDefaultColor(Nz::Color::White);
+		infoDrawer.AppendText(serverData.map);
+
+		infoDrawer.AppendText("\n");
+
+		infoDrawer.SetDefaultCharacterSize(16);
+		infoDrawer.AppendText(std::to_string(serverData.playerCount) + "/" + std::to_string(serverData.maxPlayerCount) + " players");
+
+		if (serverData.ping == UnreachablePing)
+		{
+			infoDrawer.SetDefaultColor(Nz::Color(160, 160, 160));
+			infoDrawer.AppendText(" - unreachable");
+		}
+		else if (serverData.ping != UnknownPing)
+		{
+			if (serverData.ping < 80)
+				infoDrawer.SetDefaultColor(Nz::Color(120, 220, 120));
+			else if (serverData.ping < 150)
+				infoDrawer.SetDefaultColor(Nz::Color(230, 210, 100));
+			else
+				infoDrawer.SetDefaultColor(Nz::Color(230, 110, 100));
+
+			infoDrawer.AppendText(" - " + std::to_string(serverData.ping) + " ms");
+		}
+
+		serverData.infoLabel->UpdateText(infoDrawer);
+		serverData.infoLabel->Resize(serverData.infoLabel->GetPreferredSize());
 	}
 
 	void ServerListState::RefreshServers(float elapsedTime)
@@ -277,7 +496,10 @@ namespace bw
 
 							auto it = m_masterServers.find(url);
 							if (it != m_masterServers.end())
+							{
+								it.value().lastServerList = result.GetBody();
 								it.value().timeBeforeRefresh = RefreshTime;
+							}
 
 							break;
 						}
@@ -293,6 +515,158 @@ namespace bw
 		}
 	}
 
+	void ServerListState::RequestConnectionDetails(const std::string& masterServer, const std::string& uuid, bool connect)
+	{
+		if (!m_webService)
+			return;
+
+		ServerData* serverData = FindServer(masterServer, uuid);
+		assert(serverData);
+
+		if (connect)
+			serverData->connectOnDetails = true;
+
+		if (serverData->isRequestingDetails)
+			return;
+
+		serverData->isRequestingDetails = true;
+
+		std::unique_ptr<WebRequest> request = WebRequest::Get(masterServer + "/server/" + uuid + "/connection_details", [this, stateData = GetStateDataPtr(), masterServer, uuid](WebRequestResult&& result)
+		{
+			ServerData* targetServer = FindServer(masterServer, uuid);
+			if (!targetServer)
+				return; //< server disappeared in the meantime
+
+			targetServer->isRequestingDetails = false;
+
+			bool connect = targetServer->connectOnDetails;
+			targetServer->connectOnDetails = false;
+
+			if (!result)
+			{
+				bwLog(stateData->app->GetLogger(), LogLevel::Error, "failed to retrieve connection details of server {0} from {1}, request failed: {2}", uuid, masterServer, result.GetErrorMessage());
+				return;
+			}
+
+			if (result.GetReponseCode() != 200)
+			{
+				bwLog(stateData->app->GetLogger(), LogLevel::Error, "failed to retrieve connection details of server {0} from {1}, request failed with code {2}", uuid, masterServer, result.GetReponseCode());
+				return;
+			}
+
+			bwLog(stateData->app->GetLogger(), LogLevel::Debug, "successfully received connection info of {0} from {1}", uuid, masterServer);
+
+			targetServer->connectionDetails = ParseConnectionDetails(stateData->app->GetLogger(), result.GetBody());
+			if (!targetServer->connectionDetails)
+			{
+				if (connect)
+					bwLog(stateData->app->GetLogger(), LogLevel::Error, "invalid connection details for server {0}, aborting connection.", uuid);
+
+				return;
+			}
+
+			if (connect)
+				m_nextGameState = std::make_shared<ConnectionState>(GetStateDataPtr(), *targetServer->connectionDetails, shared_from_this());
+			else if (!targetServer->isProbing)
+				StartProbe(masterServer, uuid, *targetServer);
+		});
+
+		m_webService->AddRequest(std::move(request));
+	}
+
+	void ServerListState::SaveServerListCache()
+	{
+		nlohmann::json masterServers = nlohmann::json::object();
+		for (auto&& [url, masterServerData] : m_masterServers)
+		{
+			if (masterServerData.lastServerList.empty())
+				continue;
+
+			try
+			{
+				masterServers[url] = nlohmann::json::parse(masterServerData.lastServerList);
+			}
+			catch (const std::exception&)
+			{
+				continue;
+			}
+		}
+
+		if (masterServers.empty())
+			return;
+
+		nlohmann::json cacheDoc;
+		cacheDoc["cache_version"] = ServerListCacheVersion;
+		cacheDoc["master_servers"] = std::move(masterServers);
+
+		std::ofstream file(ServerListCacheFile, std::ios::out | std::ios::trunc);
+		if (!file)
+		{
+			bwLog(GetStateData().app->GetLogger(), LogLevel::Warning, "failed to open {0} for writing", ServerListCacheFile);
+			return;
+		}
+
+		file << cacheDoc.dump();
+	}
+
+	void ServerListState::StartProbe(const std::string& masterServer, const std::string& uuid, ServerData& serverData)
+	{
+		assert(serverData.connectionDetails);
+
+		// Only probe addresses which don't need to be resolved first
+		Nz::IpAddress address;
+		for (const auto& serverAddress : *serverData.connectionDetails)
+		{
+			if (const auto* serverName = std::get_if<ConnectionState::ServerName>(&serverAddress))
+			{
+				if (address.BuildFromAddress(serverName->hostname.c_str()))
+				{
+					address.SetPort(serverName->port);
+					break;
+				}
+			}
+		}
+
+		if (!address.IsValid())
+			return;
+
+		NetworkReactor* reactor = nullptr;
+		for (const auto& reactorPtr : m_probeReactors)
+		{
+			if (reactorPtr->GetProtocol() == address.GetProtocol())
+			{
+				reactor = reactorPtr.get();
+				break;
+			}
+		}
+
+		if (!reactor)
+		{
+			try
+			{
+				auto& reactorPtr = m_probeReactors.emplace_back(std::make_unique<NetworkReactor>(m_probeReactors.size() * MaxConcurrentProbes, address.GetProtocol(), Nz::UInt16(0), MaxConcurrentProbes));
+				reactor = reactorPtr.get();
+			}
+			catch (const std::exception& e)
+			{
+				bwLog(GetStateData().app->GetLogger(), LogLevel::Error, "failed to create probe reactor: {0}", e.what());
+				return;
+			}
+		}
+
+		std::size_t peerId = reactor->ConnectTo(address, NetworkProbeData);
+		if (peerId == NetworkReactor::InvalidPeerId)
+			return; //< every probe slot is in use, it will be retried on next ping
+
+		PendingProbe& probe = m_pendingProbes[peerId];
+		probe.masterServer = masterServer;
+		probe.reactor = reactor;
+		probe.startTime = Nz::GetElapsedMilliseconds();
+		probe.uuid = uuid;
+
+		serverData.isProbing = true;
+	}
+
 	void ServerListState::UpdateServerList(const std::string& masterServer, const nlohmann::json& serverListDoc)
 	{
 		StateData& stateData = GetStateData();
@@ -358,39 +732,15 @@ namespace bw
 				serverData.infoLabel = m_serverListWidget->Add<Ndk::LabelWidget>();
 			}
 
-			Nz::RichTextDrawer infoDrawer;
-			infoDrawer.SetDefaultCharacterSize(24);
-			infoDrawer.AppendText(name + '\n');
-
-			infoDrawer.SetDefaultCharacterSize(18);
-			infoDrawer.SetDefaultColor(Nz::Color::White);
-			if (!desc.empty())
-				infoDrawer.AppendText(desc + '\n');
-
-			infoDrawer.SetDefaultCharacterSize(18);
-
-			infoDrawer.SetDefaultColor(Nz::Color(220, 220, 220));
-			infoDrawer.AppendText("Gamemode: ");
-
-			infoDrawer.SetDefaultColor(Nz::Color::White);
-			infoDrawer.AppendText(gamemode);
-
-			infoDrawer.SetDefaultColor(Nz::Color(220, 220, 220));
-			infoDrawer.AppendText(" Map: ");
-
-			infoDrawer.SetDefaultColor(Nz::Color::White);
-			infoDrawer.AppendText(map);
-
-			infoDrawer.AppendText("\n");
-
-			infoDrawer.SetDefaultCharacterSize(16);
-			infoDrawer.AppendText(std::to_string(playerCount) + "/" + std::to_string(maxPlayerCount) + " players");
-
-			serverData.infoLabel->UpdateText(infoDrawer);
-			serverData.infoLabel->Resize(serverData.infoLabel->GetPreferredSize());
-
+			serverData.description = std::move(desc);
+			serverData.gamemode = std::move(gamemode);
+			serverData.map = std::move(map);
+			serverData.maxPlayerCount = maxPlayerCount;
+			serverData.playerCount = playerCount;
 			serverData.serverName = std::move(name);
 
+			RefreshServerLabel(serverData);
+
 			newServerList.emplace(std::move(uuid), std::move(serverData));
 		}
 
@@ -412,5 +762,6 @@ namespace bw
 		masterServerData.serverList = std::move(newServerList);
 
 		LayoutWidgets();
+		PrefetchConnectionDetails();
 	}
 }
@@ -7,12 +7,17 @@
 #ifndef BURGWAR_STATES_SERVERLISTSTATE_HPP
 #define BURGWAR_STATES_SERVERLISTSTATE_HPP
 
+#include <CoreLib/NetworkReactor.hpp>
 #include <CoreLib/WebService.hpp>
 #include <Client/States/AbstractState.hpp>
+#include <Client/States/Game/ConnectionState.hpp>
 #include <NDK/State.hpp>
 #include <NDK/Widgets.hpp>
 #include <nlohmann/json_fwd.hpp>
+#include <Nazara/Network/IpAddress.hpp>
 #include <tsl/hopscotch_map.h>
+#include <limits>
+#include <memory>
 #include <optional>
 #include <variant>
 #include <vector>
@@ -32,27 +37,65 @@ namespace bw
 
 			void LayoutWidgets() override;
 
+			struct ServerData;
+
+			ServerData* FindServer(const std::string& masterServer, const std::string& uuid);
+
+			void LoadServerListCache();
+
 			void OnBackPressed();
 			void OnDirectConnectionPressed();
 			void OnServerConnectionPressed(const std::string& masterServer, const std::string& uuid);
 
+			void PingServers();
+			void PollProbes();
+			void PrefetchConnectionDetails();
+
+			void RefreshServerLabel(ServerData& serverData);
 			void RefreshServers(float elapsedTime);
+			void RequestConnectionDetails(const std::string& masterServer, const std::string& uuid, bool connect);
+
+			void SaveServerListCache();
+
+			void StartProbe(const std::string& masterServer, const std::string& uuid, ServerData& serverData);
 			void UpdateServerList(const std::string& masterServer, const nlohmann::json& serverListDoc);
 
+			static constexpr Nz::UInt32 UnknownPing = std::numeric_limits<Nz::UInt32>::max();
+			static constexpr Nz::UInt32 UnreachablePing = UnknownPing - 1;
+
 			struct ServerData
 			{
 				Ndk::ButtonWidget* connectButton;
 				Ndk::LabelWidget* infoLabel;
+				std::optional<ConnectionState::AddressList> connectionDetails;
+				std::string description;
+				std::string gamemode;
+				std::string map;
 				std::string serverName;
+				Nz::UInt32 maxPlayerCount = 0;
+				Nz::UInt32 ping = UnknownPing;
+				Nz::UInt32 playerCount = 0;
+				bool connectOnDetails = false;
+				bool isProbing = false;
+				bool isRequestingDetails = false;
 			};
 
 			struct MasterServerData
 			{
 				tsl::hopscotch_map<std::string, ServerData> serverList;
+				std::string lastServerList; //< last received server list document, saved to the cache
 				float timeBeforeRefresh = 0.f;
 				bool receivedData = false; //< Did we already successfully refresh from this master server?
 			};
 
+			struct PendingProbe
+			{
+				NetworkReactor* reactor;
+				Nz::UInt64 startTime;
+				std::string masterServer;
+				std::string uuid;
+			};
+
 			Ndk::BaseWidget* m_serverListWidget;
 			Ndk::ButtonWidget* m_backButton;
 			Ndk::ButtonWidget* m_directConnectButton;
@@ -61,8 +104,11 @@ namespace bw
 			std::shared_ptr<AbstractState> m_nextGameState;
 			std::shared_ptr<AbstractState> m_nextState;
 			std::vector<std::reference_wrapper<const ServerData>> m_tempOrderedServerList;
+			std::vector<std::unique_ptr<NetworkReactor>> m_probeReactors;
+			tsl::hopscotch_map<std::size_t /*peerId*/, PendingProbe> m_pendingProbes;
 			tsl::hopscotch_map<std::string, MasterServerData> m_masterServers;
 			std::optional<WebService> m_webService;
+			float m_timeBeforePing;
 	};
 }
 
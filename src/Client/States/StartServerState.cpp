@@ -242,6 +242,9 @@ namespace bw
 			matchSettings.port = static_cast<Nz::UInt16>(rawPort);
 			matchSettings.tickDuration = 1.f / config.GetFloatValue<float>("ServerSettings.TickRate");
 
+			if (config.GetBoolValue("ServerSettings.QuantizeMatchState"))
+				matchSettings.stateQuantization.emplace();
+
 			Match::ModSettings modSettings;
 
 			// FIXME: Allow to select enabled mods
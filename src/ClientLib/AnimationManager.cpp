@@ -0,0 +1,203 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/AnimationManager.hpp>
+#include <Nazara/Math/Algorithm.hpp>
+#include <NDK/Components/NodeComponent.hpp>
+#include <iterator>
+
+namespace bw
+{
+	namespace
+	{
+		Nz::Vector4f ToVector(const Nz::Color& color)
+		{
+			return Nz::Vector4f(color.r, color.g, color.b, color.a);
+		}
+
+		Nz::Vector4f ToVector(const Nz::Vector2f& vec)
+		{
+			return Nz::Vector4f(vec.x, vec.y, 0.f, 0.f);
+		}
+
+		template<typename T>
+		void UpdateAnimations(std::vector<T>& animations, std::vector<T>& newAnimations, float elapsedTime, bool(*apply)(T& animation, float ratio))
+		{
+			animations.insert(animations.end(), std::make_move_iterator(newAnimations.begin()), std::make_move_iterator(newAnimations.end()));
+			newAnimations.clear();
+
+			// Finished animations are replaced by the last one, order doesn't matter
+			for (std::size_t i = 0; i < animations.size();)
+			{
+				T& animation = animations[i];
+				animation.elapsedTime += elapsedTime;
+
+				bool isRunning;
+				if (animation.elapsedTime >= animation.duration)
+				{
+					if (apply(animation, 1.f) && animation.finishCallback)
+						animation.finishCallback();
+
+					isRunning = false;
+				}
+				else
+					isRunning = apply(animation, animation.elapsedTime / animation.duration);
+
+				if (isRunning)
+					++i;
+				else
+				{
+					if (i != animations.size() - 1)
+						animation = std::move(animations.back());
+
+					animations.pop_back();
+				}
+			}
+		}
+	}
+
+	void AnimationManager::PushAnimation(float duration, UpdateCallback update, FinishCallback finish)
+	{
+		if (!update(0.f))
+			return;
+
+		Animation& anim = m_newAnimations.emplace_back();
+		anim.duration = duration;
+		anim.elapsedTime = 0.f;
+		anim.finishCallback = std::move(finish);
+		anim.updateCallback = std::move(update);
+	}
+
+	void AnimationManager::PushColorAnimation(Nz::SpriteRef sprite, const Nz::Color& from, const Nz::Color& to, float duration, Easing easing, FinishCallback finish)
+	{
+		Curve curve;
+		curve.duration = duration;
+		curve.easing = easing;
+		curve.finishCallback = std::move(finish);
+		curve.from = ToVector(from);
+		curve.sprite = std::move(sprite);
+		curve.to = ToVector(to);
+		curve.type = CurveType::Color;
+
+		PushCurve(std::move(curve));
+	}
+
+	void AnimationManager::PushOffsetAnimation(Ndk::EntityHandle entity, const Nz::Vector2f& from, const Nz::Vector2f& to, float duration, Easing easing, FinishCallback finish)
+	{
+		Curve curve;
+		curve.duration = duration;
+		curve.easing = easing;
+		curve.entity = std::move(entity);
+		curve.finishCallback = std::move(finish);
+		curve.from = ToVector(from);
+		curve.to = ToVector(to);
+		curve.type = CurveType::Offset;
+
+		PushCurve(std::move(curve));
+	}
+
+	void AnimationManager::PushPositionAnimation(Ndk::EntityHandle entity, const Nz::Vector2f& from, const Nz::Vector2f& to, float duration, Easing easing, FinishCallback finish)
+	{
+		Curve curve;
+		curve.duration = duration;
+		curve.easing = easing;
+		curve.entity = std::move(entity);
+		curve.finishCallback = std::move(finish);
+		curve.from = ToVector(from);
+		curve.to = ToVector(to);
+		curve.type = CurveType::Position;
+
+		PushCurve(std::move(curve));
+	}
+
+	void AnimationManager::PushRotationAnimation(Ndk::EntityHandle entity, const Nz::DegreeAnglef& from, const Nz::DegreeAnglef& to, float duration, Easing easing, FinishCallback finish)
+	{
+		Curve curve;
+		curve.duration = duration;
+		curve.easing = easing;
+		curve.entity = std::move(entity);
+		curve.finishCallback = std::move(finish);
+		curve.from = Nz::Vector4f(from.value, 0.f, 0.f, 0.f);
+		curve.to = Nz::Vector4f(to.value, 0.f, 0.f, 0.f);
+		curve.type = CurveType::Rotation;
+
+		PushCurve(std::move(curve));
+	}
+
+	void AnimationManager::PushScaleAnimation(Ndk::EntityHandle entity, const Nz::Vector2f& from, const Nz::Vector2f& to, float duration, Easing easing, FinishCallback finish)
+	{
+		Curve curve;
+		curve.duration = duration;
+		curve.easing = easing;
+		curve.entity = std::move(entity);
+		curve.finishCallback = std::move(finish);
+		curve.from = ToVector(from);
+		curve.to = ToVector(to);
+		curve.type = CurveType::Scale;
+
+		PushCurve(std::move(curve));
+	}
+
+	void AnimationManager::Update(float elapsedTime)
+	{
+		UpdateAnimations<Animation>(m_animations, m_newAnimations, elapsedTime, [](Animation& animation, float ratio)
+		{
+			return animation.updateCallback(ratio);
+		});
+
+		UpdateAnimations<Curve>(m_curves, m_newCurves, elapsedTime, &AnimationManager::ApplyCurve);
+	}
+
+	void AnimationManager::PushCurve(Curve&& curve)
+	{
+		curve.elapsedTime = 0.f;
+
+		if (!ApplyCurve(curve, 0.f))
+			return;
+
+		m_newCurves.emplace_back(std::move(curve));
+	}
+
+	bool AnimationManager::ApplyCurve(Curve& curve, float ratio)
+	{
+		Nz::Vector4f value = Nz::Lerp(curve.from, curve.to, ApplyEasing(curve.easing, ratio));
+
+		if (curve.type == CurveType::Color)
+		{
+			if (!curve.sprite)
+				return false;
+
+			curve.sprite->SetColor(Nz::Color(static_cast<Nz::UInt8>(value.x), static_cast<Nz::UInt8>(value.y), static_cast<Nz::UInt8>(value.z), static_cast<Nz::UInt8>(value.w)));
+			return true;
+		}
+
+		if (!curve.entity || !curve.entity->HasComponent<Ndk::NodeComponent>())
+			return false;
+
+		auto& nodeComponent = curve.entity->GetComponent<Ndk::NodeComponent>();
+		switch (curve.type)
+		{
+			case CurveType::Offset:
+				nodeComponent.SetInitialPosition(Nz::Vector2f(value.x, value.y));
+				break;
+
+			case CurveType::Position:
+				nodeComponent.SetPosition(Nz::Vector2f(value.x, value.y));
+				break;
+
+			case CurveType::Rotation:
+				nodeComponent.SetRotation(Nz::DegreeAnglef(value.x));
+				break;
+
+			case CurveType::Scale:
+				nodeComponent.SetScale(Nz::Vector2f(value.x, value.y));
+				break;
+
+			case CurveType::Color:
+				break;
+		}
+
+		return true;
+	}
+}
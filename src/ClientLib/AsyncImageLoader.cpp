@@ -0,0 +1,141 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/AsyncImageLoader.hpp>
+#include <CoreLib/Utils.hpp>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <filesystem>
+#include <string_view>
+
+namespace bw
+{
+	AsyncImageLoader::~AsyncImageLoader()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_isStopping = true;
+			m_jobs.clear();
+		}
+		m_jobCondition.notify_all();
+
+		if (m_worker.joinable())
+			m_worker.join();
+	}
+
+	void AsyncImageLoader::Clear()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_jobs.clear();
+
+		// Don't keep the result of the image being decoded
+		m_resultCondition.wait(lock, [&] { return m_currentJob.empty(); });
+		m_results.clear();
+	}
+
+	bool AsyncImageLoader::HasResult(const std::string& imagePath) const
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		return m_results.find(imagePath) != m_results.end();
+	}
+
+	bool AsyncImageLoader::IsPending(const std::string& imagePath) const
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_currentJob == imagePath)
+			return true;
+
+		return std::any_of(m_jobs.begin(), m_jobs.end(), [&](const Job& job) { return job.imagePath == imagePath; });
+	}
+
+	void AsyncImageLoader::Push(std::string imagePath, VirtualDirectory::Entry entry, Nz::ImageParams params)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			auto& job = m_jobs.emplace_back();
+			job.entry = std::move(entry);
+			job.imagePath = std::move(imagePath);
+			job.params = std::move(params);
+		}
+
+		// Started on first use, most stores (editor, server) never load anything asynchronously
+		if (!m_worker.joinable())
+			m_worker = std::thread(&AsyncImageLoader::WorkerMain, this);
+		else
+			m_jobCondition.notify_one();
+	}
+
+	bool AsyncImageLoader::Take(const std::string& imagePath, Nz::ImageRef* image)
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		if (auto jobIt = std::find_if(m_jobs.begin(), m_jobs.end(), [&](const Job& job) { return job.imagePath == imagePath; }); jobIt != m_jobs.end())
+		{
+			// The image is needed right now, move it to the front of the queue
+			Job job = std::move(*jobIt);
+			m_jobs.erase(jobIt);
+			m_jobs.push_front(std::move(job));
+		}
+		else if (m_currentJob != imagePath && m_results.find(imagePath) == m_results.end())
+			return false;
+
+		m_resultCondition.wait(lock, [&] { return m_results.find(imagePath) != m_results.end(); });
+
+		auto it = m_results.find(imagePath);
+		*image = std::move(it.value());
+		m_results.erase(it);
+
+		return true;
+	}
+
+	bool AsyncImageLoader::IsSupported(const std::string& imagePath)
+	{
+		static constexpr std::array<std::string_view, 5> imageExtensions = { ".bmp", ".jpeg", ".jpg", ".png", ".tga" };
+
+		std::string extension = std::filesystem::u8path(imagePath).extension().generic_u8string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+
+		return std::find(imageExtensions.begin(), imageExtensions.end(), extension) != imageExtensions.end();
+	}
+
+	void AsyncImageLoader::WorkerMain()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;)
+		{
+			m_jobCondition.wait(lock, [&] { return m_isStopping || !m_jobs.empty(); });
+			if (m_isStopping)
+				break;
+
+			Job job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+			m_currentJob = job.imagePath;
+
+			lock.unlock();
+
+			Nz::ImageRef image = std::visit([&](auto&& arg) -> Nz::ImageRef
+			{
+				using T = std::decay_t<decltype(arg)>;
+				if constexpr (std::is_same_v<T, VirtualDirectory::DataPointerEntry>)
+					return Nz::Image::LoadFromMemory(arg.data, arg.size, job.params);
+				else if constexpr (std::is_same_v<T, VirtualDirectory::FileContentEntry>)
+					return Nz::Image::LoadFromMemory(arg.data(), arg.size(), job.params);
+				else if constexpr (std::is_same_v<T, VirtualDirectory::PhysicalFileEntry>)
+					return Nz::Image::LoadFromFile(arg.generic_u8string(), job.params);
+				else if constexpr (std::is_same_v<T, VirtualDirectory::VirtualDirectoryEntry>)
+					return nullptr;
+				else
+					static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
+			}, job.entry);
+
+			lock.lock();
+
+			m_currentJob.clear();
+			m_results.insert_or_assign(std::move(job.imagePath), std::move(image));
+			m_resultCondition.notify_all();
+		}
+	}
+}
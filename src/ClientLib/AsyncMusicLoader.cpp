@@ -0,0 +1,131 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/AsyncMusicLoader.hpp>
+#include <CoreLib/Utils.hpp>
+#include <algorithm>
+
+namespace bw
+{
+	AsyncMusicLoader::~AsyncMusicLoader()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_isStopping = true;
+			m_jobs.clear();
+		}
+		m_jobCondition.notify_all();
+
+		if (m_worker.joinable())
+			m_worker.join();
+	}
+
+	void AsyncMusicLoader::Clear()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_jobs.clear();
+
+		// Don't keep the music being opened
+		m_resultCondition.wait(lock, [&] { return m_currentJob.empty(); });
+		m_results.clear();
+	}
+
+	bool AsyncMusicLoader::IsPending(const std::string& musicPath) const
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (m_currentJob == musicPath)
+			return true;
+
+		return std::any_of(m_jobs.begin(), m_jobs.end(), [&](const Job& job) { return job.musicPath == musicPath; });
+	}
+
+	void AsyncMusicLoader::Push(std::string musicPath, VirtualDirectory::Entry entry)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+
+			auto& job = m_jobs.emplace_back();
+			job.entry = std::move(entry);
+			job.musicPath = std::move(musicPath);
+		}
+
+		// Started on first use, most matches never prefetch anything
+		if (!m_worker.joinable())
+			m_worker = std::thread(&AsyncMusicLoader::WorkerMain, this);
+		else
+			m_jobCondition.notify_one();
+	}
+
+	auto AsyncMusicLoader::Take(const std::string& musicPath) -> std::optional<Result>
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+
+		if (auto jobIt = std::find_if(m_jobs.begin(), m_jobs.end(), [&](const Job& job) { return job.musicPath == musicPath; }); jobIt != m_jobs.end())
+		{
+			// The music is needed right now, move it to the front of the queue
+			Job job = std::move(*jobIt);
+			m_jobs.erase(jobIt);
+			m_jobs.push_front(std::move(job));
+		}
+		else if (m_currentJob != musicPath && m_results.find(musicPath) == m_results.end())
+			return std::nullopt;
+
+		m_resultCondition.wait(lock, [&] { return m_results.find(musicPath) != m_results.end(); });
+
+		auto it = m_results.find(musicPath);
+		Result result = std::move(it.value());
+		m_results.erase(it);
+
+		return result;
+	}
+
+	auto AsyncMusicLoader::Open(VirtualDirectory::Entry entry) -> Result
+	{
+		Result result;
+		result.source = std::move(entry);
+
+		// Nz::Music only decodes a few buffers ahead on its own streaming thread once playing, opening it is what we do here
+		result.isOpen = std::visit([&](auto&& arg)
+		{
+			using T = std::decay_t<decltype(arg)>;
+			if constexpr (std::is_same_v<T, VirtualDirectory::DataPointerEntry>)
+				return result.music.OpenFromMemory(arg.data, arg.size);
+			else if constexpr (std::is_same_v<T, VirtualDirectory::FileContentEntry>)
+				return result.music.OpenFromMemory(arg.data(), arg.size());
+			else if constexpr (std::is_same_v<T, VirtualDirectory::PhysicalFileEntry>)
+				return result.music.OpenFromFile(arg.generic_u8string());
+			else if constexpr (std::is_same_v<T, VirtualDirectory::VirtualDirectoryEntry>)
+				return false;
+			else
+				static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
+		}, result.source);
+
+		return result;
+	}
+
+	void AsyncMusicLoader::WorkerMain()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;)
+		{
+			m_jobCondition.wait(lock, [&] { return m_isStopping || !m_jobs.empty(); });
+			if (m_isStopping)
+				break;
+
+			Job job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+			m_currentJob = job.musicPath;
+
+			lock.unlock();
+
+			Result result = Open(std::move(job.entry));
+
+			lock.lock();
+
+			m_currentJob.clear();
+			m_results.insert_or_assign(std::move(job.musicPath), std::move(result));
+			m_resultCondition.notify_all();
+		}
+	}
+}
@@ -11,8 +11,11 @@
 namespace bw
 {
 	static constexpr std::size_t maxChatLines = 100;
+	static constexpr std::size_t chatTrimThreshold = 25; //< extra lines the text area can hold before being rebuilt from history
 
 	Chatbox::Chatbox(const Logger& logger, Nz::RenderTarget* rt, Ndk::Canvas* canvas) :
+	m_displayedLineCount(0),
+	m_chatLines(maxChatLines),
 	m_chatEnteringBox(nullptr),
 	m_logger(logger)
 	{
@@ -57,8 +60,9 @@ namespace bw
 
 	void Chatbox::Clear()
 	{
-		m_chatLines.clear();
+		m_chatLines.Clear();
 		m_chatBox->Clear();
+		m_displayedLineCount = 0;
 	}
 
 	void Chatbox::Open(bool shouldOpen)
@@ -84,9 +88,7 @@ namespace bw
 
 	void Chatbox::PrintMessage(std::vector<Item> message)
 	{
-		auto logContext = m_logger.PushContext();
-		logContext->level = LogLevel::Info;
-		if (m_logger.ShouldLog(*logContext))
+		if (m_logger.ShouldLog(LogLevel::Info))
 		{
 			std::string textMessage;
 
@@ -102,14 +104,29 @@ namespace bw
 				}, messageItem);
 			}
 
+			auto logContext = m_logger.PushContext();
+			logContext->level = LogLevel::Info;
+
 			m_logger.LogFormat(*logContext, "{0}", textMessage);
 		}
 
-		m_chatLines.emplace_back(std::move(message));
-		if (m_chatLines.size() > maxChatLines)
-			m_chatLines.erase(m_chatLines.begin());
+		if (m_chatLines.IsFull())
+			m_chatLines.Dequeue();
 
-		Refresh();
+		// Append the new line to the text area, only rebuilding it (from the bounded history) once in a while to drop old lines
+		if (m_displayedLineCount >= maxChatLines + chatTrimThreshold)
+		{
+			m_chatLines.Enqueue(std::move(message));
+			Refresh();
+		}
+		else
+		{
+			AppendLine(message);
+			m_chatLines.Enqueue(std::move(message));
+			m_displayedLineCount++;
+
+			UpdateLayout();
+		}
 	}
 
 	void Chatbox::SendMessage()
@@ -119,6 +136,33 @@ namespace bw
 			OnChatMessage(text.ToStdString());
 	}
 
+	void Chatbox::AppendLine(const std::vector<Item>& lineItems)
+	{
+		for (const Item& lineItem : lineItems)
+		{
+			std::visit([&](auto&& item)
+			{
+				using T = std::decay_t<decltype(item)>;
+
+				if constexpr (std::is_same_v<T, ColorItem>)
+				{
+					m_chatBox->SetTextColor(item.color);
+				}
+				else if constexpr (std::is_same_v<T, TextItem>)
+				{
+					if (!item.text.empty())
+						m_chatBox->AppendText(item.text);
+				}
+				else
+					static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
+
+			}, lineItem);
+		}
+
+		m_chatBox->SetTextColor(Nz::Color::White);
+		m_chatBox->AppendText("\n");
+	}
+
 	void Chatbox::OnRenderTargetSizeChange(const Nz::RenderTarget* renderTarget)
 	{
 		Nz::Vector2f size = Nz::Vector2f(renderTarget->GetSize());
@@ -132,33 +176,18 @@ namespace bw
 	void Chatbox::Refresh()
 	{
 		m_chatBox->Clear();
-		for (const auto& lineItems : m_chatLines)
-		{
-			for (const Item& lineItem : lineItems)
-			{
-				std::visit([&](auto&& item)
-				{
-					using T = std::decay_t<decltype(item)>;
 
-					if constexpr (std::is_same_v<T, ColorItem>)
-					{
-						m_chatBox->SetTextColor(item.color);
-					}
-					else if constexpr (std::is_same_v<T, TextItem>)
-					{
-						if (!item.text.empty())
-							m_chatBox->AppendText(item.text);
-					}
-					else
-						static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
-
-				}, lineItem);
-			}
+		std::size_t lineCount = m_chatLines.GetSize();
+		for (std::size_t i = 0; i < lineCount; ++i)
+			AppendLine(m_chatLines[i]);
 
-			m_chatBox->SetTextColor(Nz::Color::White);
-			m_chatBox->AppendText("\n");
-		}
+		m_displayedLineCount = lineCount;
 
+		UpdateLayout();
+	}
+
+	void Chatbox::UpdateLayout()
+	{
 		m_chatBox->Resize({ m_chatBox->GetWidth(), m_chatBox->GetPreferredHeight() });
 		m_chatboxScrollArea->Resize(m_chatboxScrollArea->GetSize()); // force layout update
 		m_chatboxScrollArea->SetPosition({ 5.f, m_chatEnteringBox->GetPosition().y - m_chatboxScrollArea->GetHeight() - 5, 0.f });
@@ -3,15 +3,30 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <ClientLib/ClientAssetStore.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <cassert>
 
 namespace bw
 {
+	void ClientAssetStore::AdoptImageLoader(std::shared_ptr<AsyncImageLoader> imageLoader)
+	{
+		// Images already queued or decoded by it (while downloading them) are used as if they were preloaded
+		assert(imageLoader);
+		m_imageLoader = std::move(imageLoader);
+	}
+
 	void ClientAssetStore::Clear()
 	{
 		AssetStore::Clear();
 
+		m_imageLoader->Clear();
 		m_models.clear();
+		m_musicLoader.Clear();
+		m_repeatedSpriteRegions.clear();
 		m_soundBuffers.clear();
+		m_spriteAtlas.Clear();
+		m_spriteRegions.clear();
+		m_textureCallbacks.clear();
 		m_textures.clear();
 	}
 
@@ -34,10 +49,218 @@ namespace bw
 		return GetResource(soundPath, m_soundBuffers, loaderParameters);
 	}
 
+	const TextureAtlas::Region* ClientAssetStore::GetSpriteRegion(const std::string& texturePath, bool repeatTexture) const
+	{
+		auto& regions = (repeatTexture) ? m_repeatedSpriteRegions : m_spriteRegions;
+		if (auto it = regions.find(texturePath); it != regions.end())
+			return &it->second;
+
+		// Identical images share their atlas slot (or texture) and material
+		if (const std::string& sourcePath = GetSourcePath(texturePath); sourcePath != texturePath)
+		{
+			const TextureAtlas::Region* sourceRegion = GetSpriteRegion(sourcePath, repeatTexture);
+			if (!sourceRegion)
+				return nullptr;
+
+			TextureAtlas::Region region = *sourceRegion;
+			return &regions.emplace(texturePath, std::move(region)).first->second;
+		}
+
+		// Small images are packed together (unless already loaded on their own), repeated textures need their own texture to wrap
+		if (!repeatTexture && m_textures.find(texturePath) == m_textures.end())
+		{
+			// Don't keep the image in the cache, it lives in the atlas page once inserted
+			Nz::ImageRef image = LoadImage(texturePath);
+			if (!image)
+				return nullptr;
+
+			if (m_spriteAtlas.CanInsert(*image))
+			{
+				if (std::optional<TextureAtlas::Region> region = m_spriteAtlas.Insert(*image))
+					return &regions.emplace(texturePath, std::move(*region)).first->second;
+
+				bwLog(m_logger, LogLevel::Warning, "failed to insert {} in sprite atlas", texturePath);
+			}
+
+			Nz::TextureRef texture = Nz::Texture::New();
+			if (!texture->LoadFromImage(*image))
+				return nullptr;
+
+			m_textures.emplace(texturePath, std::move(texture));
+		}
+
+		const Nz::TextureRef& texture = GetTexture(texturePath);
+		if (!texture)
+			return nullptr;
+
+		// Still share the material between every sprite using this texture
+		TextureAtlas::Region region;
+		region.material = Nz::Material::New("Translucent2D");
+		region.material->SetDiffuseMap(texture);
+		region.size = Nz::Vector2f(Nz::Vector2ui(texture->GetWidth(), texture->GetHeight()));
+		region.textureCoords = Nz::Rectf(0.f, 0.f, 1.f, 1.f);
+
+		auto& sampler = region.material->GetDiffuseSampler();
+		sampler.SetFilterMode(Nz::SamplerFilter_Bilinear);
+		if (repeatTexture)
+			sampler.SetWrapMode(Nz::SamplerWrap_Repeat);
+
+		return &regions.emplace(texturePath, std::move(region)).first->second;
+	}
+
 	const Nz::TextureRef& ClientAssetStore::GetTexture(const std::string& texturePath) const
 	{
+		if (const std::string& sourcePath = GetSourcePath(texturePath); sourcePath != texturePath && m_textures.find(texturePath) == m_textures.end())
+		{
+			Nz::TextureRef texture = GetTexture(sourcePath);
+			if (texture)
+				return m_textures.emplace(texturePath, std::move(texture)).first->second;
+		}
+
+		// Use the preloaded image if there's one, decoding is the expensive part of loading a texture
+		if (m_textures.find(texturePath) == m_textures.end())
+		{
+			Nz::ImageRef image;
+			if (m_imageLoader->Take(texturePath, &image) && image)
+			{
+				Nz::TextureRef texture = Nz::Texture::New();
+				if (texture->LoadFromImage(*image))
+					return m_textures.emplace(texturePath, std::move(texture)).first->second;
+			}
+		}
+
 		Nz::ImageParams loaderParameters;
 
 		return GetResource(texturePath, m_textures, loaderParameters);
 	}
+
+	void ClientAssetStore::ImportAssets(const ClientAssetStore& assetStore)
+	{
+		AssetStore::ImportAssets(assetStore);
+
+		// Sprite regions are not imported as they live in the other store atlas, such sprites will use their own texture instead
+		std::size_t importedCount = 0;
+		importedCount += ImportResources(assetStore, assetStore.m_models, m_models);
+		importedCount += ImportResources(assetStore, assetStore.m_soundBuffers, m_soundBuffers);
+		importedCount += ImportResources(assetStore, assetStore.m_textures, m_textures);
+
+		bwLog(m_logger, LogLevel::Debug, "imported {0} client asset(s)", importedCount);
+	}
+
+	void ClientAssetStore::LoadTextureAsync(const std::string& texturePath, TextureCallback callback) const
+	{
+		if (const std::string& sourcePath = GetSourcePath(texturePath); sourcePath != texturePath)
+			return LoadTextureAsync(sourcePath, std::move(callback));
+
+		if (auto it = m_textures.find(texturePath); it != m_textures.end())
+		{
+			callback(it->second);
+			return;
+		}
+
+		auto& callbacks = m_textureCallbacks[texturePath];
+		if (callbacks.empty() && !m_imageLoader->IsPending(texturePath))
+			QueueImage(texturePath);
+
+		callbacks.push_back(std::move(callback));
+	}
+
+	std::optional<AsyncMusicLoader::Result> ClientAssetStore::OpenMusic(const std::string& musicPath) const
+	{
+		// Musics are not cached as each one has its own playing state, but a prefetched one can be handed over once
+		if (std::optional<AsyncMusicLoader::Result> result = m_musicLoader.Take(musicPath))
+			return result;
+
+		VirtualDirectory::Entry entry;
+		if (!GetAssetDirectory()->GetEntry(musicPath, &entry))
+			return std::nullopt;
+
+		return AsyncMusicLoader::Open(std::move(entry));
+	}
+
+	void ClientAssetStore::PrefetchMusic(const std::string& musicPath) const
+	{
+		if (m_musicLoader.IsPending(musicPath))
+			return;
+
+		VirtualDirectory::Entry entry;
+		if (!GetAssetDirectory()->GetEntry(musicPath, &entry))
+			return;
+
+		m_musicLoader.Push(musicPath, std::move(entry));
+	}
+
+	void ClientAssetStore::PreloadAssets(const std::vector<std::string>& assetPaths)
+	{
+		std::size_t queuedImageCount = 0;
+		for (const std::string& assetPath : assetPaths)
+		{
+			if (GetSourcePath(assetPath) != assetPath)
+			{
+				// Its content is loaded under another path, drop the copy decoded while downloading (if any)
+				Nz::ImageRef duplicateImage;
+				if (m_imageLoader->HasResult(assetPath))
+					m_imageLoader->Take(assetPath, &duplicateImage);
+
+				continue;
+			}
+
+			if (m_textures.find(assetPath) != m_textures.end() || m_spriteRegions.find(assetPath) != m_spriteRegions.end())
+				continue;
+
+			if (m_imageLoader->IsPending(assetPath) || m_imageLoader->HasResult(assetPath))
+				continue;
+
+			if (QueueImage(assetPath))
+				queuedImageCount++;
+		}
+
+		bwLog(m_logger, LogLevel::Info, "Preloading {} images", queuedImageCount);
+	}
+
+	void ClientAssetStore::Update()
+	{
+		for (auto it = m_textureCallbacks.begin(); it != m_textureCallbacks.end();)
+		{
+			if (m_imageLoader->IsPending(it->first))
+			{
+				++it;
+				continue;
+			}
+
+			std::string texturePath = it->first;
+			std::vector<TextureCallback> callbacks = std::move(it.value());
+			it = m_textureCallbacks.erase(it);
+
+			const Nz::TextureRef& texture = GetTexture(texturePath);
+			for (const TextureCallback& callback : callbacks)
+				callback(texture);
+
+			// Callbacks may have requested other textures, start over
+			it = m_textureCallbacks.begin();
+		}
+	}
+
+	Nz::ImageRef ClientAssetStore::LoadImage(const std::string& imagePath) const
+	{
+		Nz::ImageRef image;
+		if (m_imageLoader->Take(imagePath, &image))
+			return image;
+
+		tsl::hopscotch_map<std::string, Nz::ImageRef> imageCache;
+		return GetResource(imagePath, imageCache, Nz::ImageParams{});
+	}
+
+	bool ClientAssetStore::QueueImage(const std::string& imagePath) const
+	{
+		if (!AsyncImageLoader::IsSupported(imagePath))
+			return false;
+
+		VirtualDirectory::Entry entry;
+		if (!GetAssetDirectory()->GetEntry(imagePath, &entry))
+			return false;
+
+		m_imageLoader->Push(imagePath, std::move(entry));
+		return true;
+	}
 }
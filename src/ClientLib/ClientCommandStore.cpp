@@ -34,9 +34,9 @@ namespace bw
 		IncomingCommand(EntitiesAnimation);
 		IncomingCommand(EntitiesDeath);
 		IncomingCommand(EntitiesInputs);
+		IncomingCommand(EntitiesPhysics);
 		IncomingCommand(EntitiesScale);
-		IncomingCommand(EntityPhysics);
-		IncomingCommand(EntityWeapon);
+		IncomingCommand(EntitiesWeapon);
 		IncomingCommand(HealthUpdate);
 		IncomingCommand(InputTimingCorrection);
 		IncomingCommand(MapReset);
@@ -50,16 +50,20 @@ namespace bw
 		IncomingCommand(PlayerNameUpdate);
 		IncomingCommand(PlayerPingUpdate);
 		IncomingCommand(PlayerWeapons);
+		IncomingCommand(RecycleEntities);
+		IncomingCommand(RespawnEntities);
 		IncomingCommand(ScriptPacket);
+		IncomingCommand(TickRateUpdate);
 
 		// Outgoing commands
 		OutgoingCommand(Auth,                        Nz::ENetPacketFlag_Reliable, 0);
+		OutgoingCommand(DownloadClientFileAck,       Nz::ENetPacketFlag_Reliable, 0);
 		OutgoingCommand(DownloadClientFileRequest,   Nz::ENetPacketFlag_Reliable, 0);
 		OutgoingCommand(NetworkStrings,              Nz::ENetPacketFlag_Reliable, 0);
 		OutgoingCommand(PlayerChat,                  Nz::ENetPacketFlag_Reliable, 1);
 		OutgoingCommand(PlayerConsoleCommand,        Nz::ENetPacketFlag_Reliable, 1);
 		OutgoingCommand(PlayerSelectWeapon,          Nz::ENetPacketFlag_Reliable, 0);
-		OutgoingCommand(PlayersInput,                Nz::ENetPacketFlag_Reliable, 0);
+		OutgoingCommand(PlayersInput,                0,                           2);
 		OutgoingCommand(Ready,                       Nz::ENetPacketFlag_Reliable, 0);
 		OutgoingCommand(ScriptPacket,                Nz::ENetPacketFlag_Reliable, 1);
 		OutgoingCommand(UpdatePlayerName,            Nz::ENetPacketFlag_Reliable, 1);
@@ -7,11 +7,16 @@
 #include <ClientLib/Components/VisualComponent.hpp>
 #include <ClientLib/Components/ClientMatchComponent.hpp>
 #include <ClientLib/Components/ClientOwnerComponent.hpp>
+#include <ClientLib/Components/FrameCallbackRateComponent.hpp>
+#include <ClientLib/Components/LayerCacheComponent.hpp>
 #include <ClientLib/Components/LocalPlayerControlledComponent.hpp>
 #include <ClientLib/Components/SoundEmitterComponent.hpp>
 #include <ClientLib/Components/VisibleLayerComponent.hpp>
 #include <ClientLib/Components/VisualInterpolationComponent.hpp>
+#include <ClientLib/Scripting/Text.hpp>
 #include <ClientLib/Systems/FrameCallbackSystem.hpp>
+#include <ClientLib/Systems/LayerCacheSystem.hpp>
+#include <ClientLib/Systems/ParticleUpdateSystem.hpp>
 #include <ClientLib/Systems/PostFrameCallbackSystem.hpp>
 #include <ClientLib/Systems/SoundSystem.hpp>
 #include <ClientLib/Systems/VisualInterpolationSystem.hpp>
@@ -46,11 +51,15 @@ namespace bw
 		Ndk::InitializeComponent<VisualComponent>("LayrEnt");
 		Ndk::InitializeComponent<ClientMatchComponent>("LclMatch");
 		Ndk::InitializeComponent<ClientOwnerComponent>("LclOwner");
+		Ndk::InitializeComponent<FrameCallbackRateComponent>("FrmRate");
+		Ndk::InitializeComponent<LayerCacheComponent>("LayrCach");
 		Ndk::InitializeComponent<LocalPlayerControlledComponent>("LclPly");
 		Ndk::InitializeComponent<SoundEmitterComponent>("SndEmtr");
 		Ndk::InitializeComponent<VisibleLayerComponent>("VsbLayrs");
 		Ndk::InitializeComponent<VisualInterpolationComponent>("Interp");
 		Ndk::InitializeSystem<FrameCallbackSystem>();
+		Ndk::InitializeSystem<LayerCacheSystem>();
+		Ndk::InitializeSystem<ParticleUpdateSystem>();
 		Ndk::InitializeSystem<PostFrameCallbackSystem>();
 		Ndk::InitializeSystem<SoundSystem>();
 		Ndk::InitializeSystem<VisualInterpolationSystem>();
@@ -58,6 +67,8 @@ namespace bw
 
 	ClientEditorApp::~ClientEditorApp()
 	{
+		Text::ClearLayoutCache();
+
 		Nz::FontLibrary::Clear();
 		Nz::MaterialLibrary::Clear();
 		Nz::SpriteLibrary::Clear();
@@ -75,6 +86,47 @@ namespace bw
 		ClientApplication::Quit();
 	}
 
+	void ClientEditorApp::FillMatchStores()
+	{
+		// Fonts and sprites only used in matches are loaded on first use (or once the first screen is shown) to keep startup short
+		std::call_once(m_matchStoresFlag, [&]
+		{
+			const std::string& gameResourceFolder = m_config.GetStringValue("Resources.AssetDirectory");
+
+			//FIXME: Should be part of ClientLib too
+			Nz::Color trailColor(242, 255, 168);
+
+			Nz::SpriteRef trailSprite = Nz::Sprite::New();
+			trailSprite->SetMaterial(Nz::Material::New("Translucent2D"));
+			trailSprite->SetCornerColor(Nz::RectCorner_LeftBottom, trailColor * Nz::Color(128, 128, 128, 0));
+			trailSprite->SetCornerColor(Nz::RectCorner_LeftTop, trailColor * Nz::Color(128, 128, 128, 0));
+			trailSprite->SetCornerColor(Nz::RectCorner_RightTop, trailColor);
+			trailSprite->SetCornerColor(Nz::RectCorner_RightBottom, trailColor);
+			trailSprite->SetSize(64.f, 2.f);
+
+			Nz::SpriteLibrary::Register("Trail", std::move(trailSprite));
+
+			auto LoadFont = [&](const std::string& filename) -> Nz::FontRef
+			{
+				Nz::FontRef font = Nz::Font::OpenFromFile(gameResourceFolder + filename);
+				if (!font)
+				{
+					bwLog(GetLogger(), LogLevel::Warning, "Failed to open font file {}, reverting to default", filename);
+					return Nz::Font::GetDefault();
+				}
+
+				return font;
+			};
+
+			Nz::FontRef barthowheel = LoadFont("/fonts/Barthowheel Regular.ttf");
+			Nz::FontRef grandstander = LoadFont("/fonts/Grandstander-clean.otf");
+
+			Nz::FontLibrary::Register("BW_Chatbox", barthowheel);
+			Nz::FontLibrary::Register("BW_Names", grandstander);
+			Nz::FontLibrary::Register("BW_ScoreMenu", Nz::Font::GetDefault());
+		});
+	}
+
 	void ClientEditorApp::FillStores()
 	{
 		const std::string& gameResourceFolder = m_config.GetStringValue("Resources.AssetDirectory");
@@ -85,38 +137,16 @@ namespace bw
 
 		Nz::MaterialLibrary::Register("SpriteNoDepth", spriteNoDepthMat);
 
-		Nz::TextureLibrary::Register("MenuBackground", Nz::Texture::LoadFromFile(gameResourceFolder + "/background.png"));
-
-		//FIXME: Should be part of ClientLib too
-		Nz::Color trailColor(242, 255, 168);
-
-		Nz::SpriteRef trailSprite = Nz::Sprite::New();
-		trailSprite->SetMaterial(Nz::Material::New("Translucent2D"));
-		trailSprite->SetCornerColor(Nz::RectCorner_LeftBottom, trailColor * Nz::Color(128, 128, 128, 0));
-		trailSprite->SetCornerColor(Nz::RectCorner_LeftTop, trailColor * Nz::Color(128, 128, 128, 0));
-		trailSprite->SetCornerColor(Nz::RectCorner_RightTop, trailColor);
-		trailSprite->SetCornerColor(Nz::RectCorner_RightBottom, trailColor);
-		trailSprite->SetSize(64.f, 2.f);
-
-		Nz::SpriteLibrary::Register("Trail", std::move(trailSprite));
+		// Same settings as the material TextSprite creates for each instance, but shared so texts can be batched together
+		Nz::MaterialRef textMat = Nz::Material::New();
+		textMat->EnableBlending(true);
+		textMat->EnableDepthWrite(false);
+		textMat->EnableFaceCulling(false);
+		textMat->SetDstBlend(Nz::BlendFunc_InvSrcAlpha);
+		textMat->SetSrcBlend(Nz::BlendFunc_SrcAlpha);
 
-		auto LoadFont = [&](const std::string& filename) -> Nz::FontRef
-		{
-			Nz::FontRef font = Nz::Font::OpenFromFile(gameResourceFolder + filename);
-			if (!font)
-			{
-				bwLog(GetLogger(), LogLevel::Warning, "Failed to open font file {}, reverting to default", filename);
-				return Nz::Font::GetDefault();
-			}
-
-			return font;
-		};
+		Nz::MaterialLibrary::Register("Text", textMat);
 
-		Nz::FontRef barthowheel = LoadFont("/fonts/Barthowheel Regular.ttf");
-		Nz::FontRef grandstander = LoadFont("/fonts/Grandstander-clean.otf");
-
-		Nz::FontLibrary::Register("BW_Chatbox", barthowheel);
-		Nz::FontLibrary::Register("BW_Names", grandstander);
-		Nz::FontLibrary::Register("BW_ScoreMenu", Nz::Font::GetDefault());
+		Nz::TextureLibrary::Register("MenuBackground", Nz::Texture::LoadFromFile(gameResourceFolder + "/background.png"));
 	}
 }
@@ -10,6 +10,7 @@
 #include <CoreLib/BurgApp.hpp>
 #include <ClientLib/PlayerConfig.hpp>
 #include <NDK/ClientApplication.hpp>
+#include <mutex>
 
 namespace bw
 {
@@ -21,6 +22,8 @@ namespace bw
 			ClientEditorApp(int argc, char* argv[], LogSide side, const SharedAppConfig& configFile);
 			~ClientEditorApp();
 
+			void FillMatchStores();
+
 			inline ConfigFile& GetPlayerSettings();
 			inline const ConfigFile& GetPlayerSettings() const;
 
@@ -32,6 +35,7 @@ namespace bw
 			void FillStores();
 
 		private:
+			std::once_flag m_matchStoresFlag;
 			PlayerConfig m_playerSettings;
 	};
 }
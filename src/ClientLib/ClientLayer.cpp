@@ -13,15 +13,18 @@
 #include <ClientLib/Systems/VisualInterpolationSystem.hpp>
 #include <ClientLib/Scripting/ClientEntityStore.hpp>
 #include <ClientLib/Scripting/ClientWeaponStore.hpp>
+#include <Nazara/Core/Clock.hpp>
 #include <NDK/Components/NodeComponent.hpp>
 #include <NDK/Components/PhysicsComponent2D.hpp>
 #include <NDK/Systems/LifetimeSystem.hpp>
+#include <algorithm>
 
 namespace bw
 {
 	ClientLayer::ClientLayer(ClientMatch& match, LayerIndex layerIndex, const Nz::Color& backgroundColor) :
 	ClientEditorLayer(match, layerIndex),
 	m_backgroundColor(backgroundColor),
+	m_remainingEntityCount(0),
 	m_isEnabled(false),
 	m_isPredictionEnabled(false)
 	{
@@ -45,18 +48,20 @@ namespace bw
 	ClientEditorLayer(std::move(layer)),
 	m_entities(std::move(layer.m_entities)),
 	m_serverEntityIds(std::move(layer.m_serverEntityIds)),
+	m_pendingEntities(std::move(layer.m_pendingEntities)),
+	m_recycledEntities(std::move(layer.m_recycledEntities)),
 	m_backgroundColor(layer.m_backgroundColor),
+	m_remainingEntityCount(layer.m_remainingEntityCount),
 	m_isEnabled(layer.m_isEnabled),
 	m_isPredictionEnabled(layer.m_isPredictionEnabled)
 	{
-		for (auto it = m_entities.begin(); it != m_entities.end(); ++it)
+		m_entities.ForEach([&](EntityId uniqueId, EntityData& entity)
 		{
-			EntityData& entity = it.value();
-			entity.onDestruction.Connect(entity.layerEntity.GetEntity()->OnEntityDestruction, [this, uniqueId = entity.layerEntity.GetUniqueId()](Ndk::Entity*)
+			entity.onDestruction.Connect(entity.layerEntity.GetEntity()->OnEntityDestruction, [this, uniqueId](Ndk::Entity*)
 			{
 				HandleEntityDestruction(uniqueId);
 			});
-		}
+		});
 		
 		OnEntityCreated.Connect([this](ClientLayer* layer, ClientLayerEntity& layerEntity)
 		{
@@ -88,12 +93,15 @@ namespace bw
 			OnDisabled(this);
 			m_sounds.clear();
 			m_freeSoundIds.Clear();
+			m_pendingEntities.clear();
+			m_recycledEntities.clear();
+			m_remainingEntityCount = 0;
 
 			// Since we are disabled, refresh won't be called until we are enabled, refresh the world now to kill entities
 			GetWorld().Clear();
 
-			assert(m_entities.empty());
-			assert(m_serverEntityIds.empty());
+			assert(m_entities.IsEmpty());
+			assert(m_serverEntityIds.IsEmpty());
 		}
 	}
 
@@ -110,6 +118,27 @@ namespace bw
 		return static_cast<ClientMatch&>(SharedLayer::GetMatch());
 	}
 
+	void ClientLayer::InstantiatePendingEntities(const Nz::Vector2f& viewPosition, Nz::UInt64 deadline)
+	{
+		assert(m_isEnabled);
+
+		// Nearest entities first, so the loading happens from the camera outwards
+		m_pendingEntityOrder.clear();
+		for (auto it = m_pendingEntities.begin(); it != m_pendingEntities.end(); ++it)
+			m_pendingEntityOrder.emplace_back(viewPosition.SquaredDistance(it->second.position), it->first);
+
+		std::sort(m_pendingEntityOrder.begin(), m_pendingEntityOrder.end());
+
+		// At least one entity is instantiated per call, so loading always progresses
+		for (const auto& [squaredDistance, serverId] : m_pendingEntityOrder)
+		{
+			InstantiatePendingEntity(serverId); //< may already have been instantiated as a parent
+
+			if (Nz::GetElapsedMicroseconds() >= deadline)
+				break;
+		}
+	}
+
 	bool ClientLayer::IsEnabled() const
 	{
 		return m_isEnabled;
@@ -146,14 +175,10 @@ namespace bw
 		if (!layerEntity.IsClientside())
 		{
 			Nz::UInt32 serverId = layerEntity.GetServerId();
-			assert(m_serverEntityIds.find(serverId) == m_serverEntityIds.end());
-			m_serverEntityIds.emplace(serverId, uniqueId);
+			m_serverEntityIds.Emplace(serverId, uniqueId);
 		}
 
-		assert(m_entities.find(uniqueId) == m_entities.end());
-		auto it = m_entities.emplace(uniqueId, std::move(layerEntity)).first;
-
-		EntityData& entity = it.value();
+		EntityData& entity = m_entities.Emplace(uniqueId, std::move(layerEntity));
 		entity.onDestruction.Connect(entity.layerEntity.GetEntity()->OnEntityDestruction, [this, uniqueId](Ndk::Entity*)
 		{
 			HandleEntityDestruction(uniqueId);
@@ -193,6 +218,14 @@ namespace bw
 		});
 	}
 
+	void ClientLayer::SyncVisuals(const Nz::Rectf& viewRect)
+	{
+		ForEachLayerEntity([&](ClientLayerEntity& layerEntity)
+		{
+			layerEntity.SyncVisuals(viewRect);
+		});
+	}
+
 	void ClientLayer::CreateEntity(Nz::UInt32 entityId, const Packets::Helper::EntityData& entityData)
 	{
 		static std::string entityPrefix = "entity_";
@@ -200,6 +233,10 @@ namespace bw
 
 		assert(m_isEnabled);
 
+		// The server won't respawn an entity we kept if it reused its id for a new one
+		m_pendingEntities.erase(entityId);
+		m_recycledEntities.erase(entityId);
+
 		ClientMatch& clientMatch = GetClientMatch();
 		ClientEntityStore& entityStore = clientMatch.GetEntityStore();
 		ClientWeaponStore& weaponStore = clientMatch.GetWeaponStore();
@@ -219,18 +256,20 @@ namespace bw
 		const ClientLayerEntity* parent = nullptr;
 		if (entityData.parentId)
 		{
-			auto idIt = m_serverEntityIds.find(entityData.parentId.value());
-			//assert(idIt != m_serverEntityIds.end());
-			if (idIt == m_serverEntityIds.end())
+			const EntityId* parentUniqueId = m_serverEntityIds.Find(entityData.parentId.value());
+			if (!parentUniqueId && InstantiatePendingEntity(entityData.parentId.value()) != InvalidEntityId)
+				parentUniqueId = m_serverEntityIds.Find(entityData.parentId.value());
+
+			if (!parentUniqueId)
 			{
 				bwLog(GetMatch().GetLogger(), LogLevel::Error, "Entity #{} depends on {} which doesn't exist", uniqueId, entityData.parentId.value());
 				return;
 			}
 
-			auto entityIt = m_entities.find(idIt->second);
-			assert(entityIt != m_entities.end());
+			EntityData* parentEntity = m_entities.Find(*parentUniqueId);
+			assert(parentEntity);
 
-			parent = &entityIt.value().layerEntity;
+			parent = &parentEntity->layerEntity;
 		}
 
 		std::optional<ClientLayerEntity> layerEntity;
@@ -332,19 +371,29 @@ namespace bw
 		RegisterEntity(std::move(layerEntity.value()));
 	}
 
-	void ClientLayer::HandleEntityDestruction(EntityId uniqueId)
+	void ClientLayer::DiscardEntity(EntityId uniqueId)
 	{
-		std::size_t hash = m_entities.hash_function()(uniqueId);
+		EntityData* entityData = m_entities.Find(uniqueId);
+		assert(entityData);
+		assert(entityData->layerEntity.IsClientside());
+
+		OnEntityDelete(this, entityData->layerEntity);
+
+		// Unlike a destruction, don't trigger the Destroyed event (a mispredicted grenade shouldn't explode)
+		m_entities.Erase(uniqueId);
+	}
 
-		auto it = m_entities.find(uniqueId, hash);
-		assert(it != m_entities.end());
+	void ClientLayer::HandleEntityDestruction(EntityId uniqueId)
+	{
+		EntityData* entityData = m_entities.Find(uniqueId);
+		assert(entityData);
 
-		EntityData& entity = it.value();
+		EntityData& entity = *entityData;
 		if (!entity.layerEntity.IsClientside())
 		{
-			std::size_t erasedCount = m_serverEntityIds.erase(entity.layerEntity.GetServerId());
-			NazaraUnused(erasedCount);
-			assert(erasedCount == 1);
+			bool erased = m_serverEntityIds.Erase(entity.layerEntity.GetServerId());
+			NazaraUnused(erased);
+			assert(erased);
 		}
 
 		OnEntityDelete(this, entity.layerEntity);
@@ -355,9 +404,9 @@ namespace bw
 			auto& scriptComponent = entity.layerEntity.GetEntity()->GetComponent<ScriptComponent>();
 			scriptComponent.ExecuteCallback<ElementEvent::Destroyed>();
 		}
-		// `it` and `entity` are no longer valid here (as a new entity could have been created by the destroyed callback)
+		// `entity` is no longer valid here (as a new entity could have been created by the destroyed callback)
 
-		m_entities.erase(uniqueId, hash);
+		m_entities.Erase(uniqueId);
 	}
 
 	void ClientLayer::HandlePacket(const Packets::CreateEntities::Entity* entities, std::size_t entityCount)
@@ -379,6 +428,9 @@ namespace bw
 
 		for (std::size_t i = 0; i < entityCount; ++i)
 		{
+			if (m_pendingEntities.erase(entities[i].id) > 0)
+				continue;
+
 			if (EntityId uniqueId = GetUniqueIdByServerId(entities[i].id); uniqueId != 0)
 				HandleEntityDestruction(uniqueId);
 		}
@@ -388,13 +440,9 @@ namespace bw
 	{
 		assert(m_isEnabled);
 
+		// Layer entities are instantiated over the next frames (see InstantiatePendingEntities)
 		for (std::size_t i = 0; i < entityCount; ++i)
-		{
-			Nz::UInt32 entityId = entities[i].id;
-			auto& entityData = entities[i].data;
-
-			CreateEntity(entityId, entityData);
-		}
+			m_pendingEntities.insert_or_assign(entities[i].id, entities[i].data);
 	}
 
 	void ClientLayer::HandlePacket(const Packets::EntitiesAnimation::Entity* entities, std::size_t entityCount)
@@ -422,6 +470,9 @@ namespace bw
 		for (std::size_t i = 0; i < entityCount; ++i)
 		{
 			Nz::UInt32 entityId = entities[i].id;
+			if (m_pendingEntities.erase(entityId) > 0)
+				continue;
+
 			if (EntityId uniqueId = GetUniqueIdByServerId(entityId); uniqueId != 0)
 			{
 				auto entityOpt = GetEntity(uniqueId);
@@ -456,47 +507,34 @@ namespace bw
 		}
 	}
 
-	void ClientLayer::HandlePacket(const Packets::EntitiesScale::Entity* entities, std::size_t entityCount)
+	void ClientLayer::HandlePacket(const Packets::EntitiesPhysics::Entity* entities, std::size_t entityCount)
 	{
 		assert(m_isEnabled);
 
 		for (std::size_t i = 0; i < entityCount; ++i)
 		{
-			Nz::UInt32 entityId = entities[i].id;
-			float newScale = entities[i].newScale;
+			const auto& entityData = entities[i];
 
-			auto entityOpt = GetEntityByServerId(entityId);
+			auto entityOpt = GetEntityByServerId(entityData.id);
 			if (!entityOpt)
 				continue;
 
-			ClientLayerEntity& localEntity = entityOpt.value();
-			localEntity.UpdateScale(newScale);
-		}
-	}
-
-	void ClientLayer::HandlePacket(const Packets::EntityPhysics& packet)
-	{
-		assert(packet.entityId.layerId == GetLayerIndex());
-
-		auto entityOpt = GetEntityByServerId(packet.entityId.entityId);
-		if (!entityOpt)
-			return;
+			ClientLayerEntity& localEntity = *entityOpt;
+			if (!localEntity.IsPhysical())
+				continue;
 
-		ClientLayerEntity& localEntity = *entityOpt;
-		if (localEntity.IsPhysical())
-		{
 			const Ndk::EntityHandle& entity = localEntity.GetEntity();
 
 			auto& entityPhys = entity->GetComponent<Ndk::PhysicsComponent2D>();
-			entityPhys.SetMass(packet.mass, false);
-			entityPhys.SetMomentOfInertia(packet.momentOfInertia);
+			entityPhys.SetMass(entityData.mass, false);
+			entityPhys.SetMomentOfInertia(entityData.momentOfInertia);
 
-			if (packet.asleep)
+			if (entityData.asleep)
 				entityPhys.ForceSleep();
 
-			if (packet.playerMovement)
+			if (entityData.playerMovement)
 			{
-				auto& packetPlayerMovement = packet.playerMovement.value();
+				auto& packetPlayerMovement = entityData.playerMovement.value();
 
 				if (entity->HasComponent<PlayerMovementComponent>())
 				{
@@ -509,26 +547,49 @@ namespace bw
 		}
 	}
 
-	void ClientLayer::HandlePacket(const Packets::EntityWeapon& packet)
+	void ClientLayer::HandlePacket(const Packets::EntitiesScale::Entity* entities, std::size_t entityCount)
 	{
-		assert(packet.entityId.layerId == GetLayerIndex());
+		assert(m_isEnabled);
 
-		auto entityOpt = GetEntityByServerId(packet.entityId.entityId);
-		if (!entityOpt)
-			return;
+		for (std::size_t i = 0; i < entityCount; ++i)
+		{
+			Nz::UInt32 entityId = entities[i].id;
+			float newScale = entities[i].newScale;
+
+			auto entityOpt = GetEntityByServerId(entityId);
+			if (!entityOpt)
+				continue;
+
+			ClientLayerEntity& localEntity = entityOpt.value();
+			localEntity.UpdateScale(newScale);
+		}
+	}
 
-		ClientLayerEntity& localEntity = *entityOpt;
-		if (packet.weaponEntityId != Packets::EntityWeapon::NoWeapon)
+	void ClientLayer::HandlePacket(const Packets::EntitiesWeapon::Entity* entities, std::size_t entityCount)
+	{
+		assert(m_isEnabled);
+
+		for (std::size_t i = 0; i < entityCount; ++i)
 		{
-			auto newWeaponOpt = GetEntityByServerId(packet.weaponEntityId);
-			if (!newWeaponOpt)
-				return;
+			const auto& entityData = entities[i];
+
+			auto entityOpt = GetEntityByServerId(entityData.id);
+			if (!entityOpt)
+				continue;
 
-			ClientLayerEntity& newWeapon = newWeaponOpt.value();
-			localEntity.UpdateWeaponEntity(newWeapon.CreateHandle<ClientLayerEntity>());
+			ClientLayerEntity& localEntity = *entityOpt;
+			if (entityData.weaponEntityId != Packets::EntitiesWeapon::NoWeapon)
+			{
+				auto newWeaponOpt = GetEntityByServerId(entityData.weaponEntityId);
+				if (!newWeaponOpt)
+					continue;
+
+				ClientLayerEntity& newWeapon = newWeaponOpt.value();
+				localEntity.UpdateWeaponEntity(newWeapon.CreateHandle<ClientLayerEntity>());
+			}
+			else
+				localEntity.UpdateWeaponEntity({});
 		}
-		else
-			localEntity.UpdateWeaponEntity({});
 	}
 
 	void ClientLayer::HandlePacket(const Packets::HealthUpdate::Entity* entities, std::size_t entityCount)
@@ -556,12 +617,141 @@ namespace bw
 	{
 		assert(m_isEnabled);
 
+		for (std::size_t i = 0; i < entityCount; ++i)
+			m_pendingEntities.insert_or_assign(entities[i].id, entities[i].data);
+	}
+
+	void ClientLayer::HandlePacket(const Packets::RecycleEntities::Entity* entities, std::size_t entityCount)
+	{
+		assert(m_isEnabled);
+
 		for (std::size_t i = 0; i < entityCount; ++i)
 		{
-			Nz::UInt32 entityId = entities[i].id;
-			auto& entityData = entities[i].data;
+			// Recycled entities are kept until the server respawns them, even those we didn't instantiate yet
+			InstantiatePendingEntity(entities[i].id);
 
-			CreateEntity(entityId, entityData);
+			if (EntityId uniqueId = GetUniqueIdByServerId(entities[i].id); uniqueId != 0)
+				RecycleEntity(uniqueId);
+		}
+	}
+
+	void ClientLayer::HandlePacket(const Packets::RespawnEntities::Entity* entities, std::size_t entityCount)
+	{
+		assert(m_isEnabled);
+
+		const NetworkStringStore& networkStringStore = GetClientMatch().GetNetworkStringStore();
+
+		for (std::size_t i = 0; i < entityCount; ++i)
+		{
+			const auto& entityData = entities[i];
+
+			auto it = m_recycledEntities.find(entityData.id);
+			if (it == m_recycledEntities.end())
+			{
+				bwLog(GetMatch().GetLogger(), LogLevel::Warning, "Received respawn event for entity {0} which wasn't recycled", entityData.id);
+				continue;
+			}
+
+			std::unique_ptr<ClientLayerEntity> layerEntity = std::move(it.value());
+			m_recycledEntities.erase(it);
+
+			const Ndk::EntityHandle& entity = layerEntity->GetEntity();
+
+			if (entity->HasComponent<ScriptComponent>())
+			{
+				PropertyValueMap properties;
+				for (const auto& property : entityData.properties)
+				{
+					const std::string& propertyName = networkStringStore.GetString(property.name);
+					properties.emplace(propertyName, property.value);
+				}
+
+				entity->GetComponent<ScriptComponent>().UpdateProperties(std::move(properties));
+			}
+
+			if (entity->HasComponent<ClientOwnerComponent>())
+				entity->RemoveComponent<ClientOwnerComponent>();
+
+			if (entityData.ownerPlayerIndex)
+			{
+				if (ClientPlayer* player = GetClientMatch().GetPlayerByIndex(*entityData.ownerPlayerIndex))
+					entity->AddComponent<ClientOwnerComponent>(player->CreateHandle());
+			}
+
+			if (entityData.physicsProperties && layerEntity->IsPhysical())
+			{
+				auto& physProperties = *entityData.physicsProperties;
+
+				auto& entityPhys = entity->GetComponent<Ndk::PhysicsComponent2D>();
+				entityPhys.SetMass(physProperties.mass, false);
+				entityPhys.SetMomentOfInertia(physProperties.momentOfInertia);
+
+				layerEntity->UpdateState(entityData.position, entityData.rotation, physProperties.linearVelocity, physProperties.angularVelocity);
+
+				if (physProperties.isAsleep)
+					entityPhys.ForceSleep();
+			}
+			else
+				layerEntity->UpdateState(entityData.position, entityData.rotation);
+
+			if (entityData.currentHealth && layerEntity->HasHealth())
+				layerEntity->UpdateHealth(*entityData.currentHealth);
+
+			layerEntity->UpdateUniqueId(static_cast<EntityId>(entityData.uniqueId));
+			layerEntity->Enable();
+
+			ClientLayerEntity& respawnedEntity = RegisterEntity(std::move(*layerEntity));
+			if (respawnedEntity.GetEntity()->HasComponent<ScriptComponent>())
+				respawnedEntity.GetEntity()->GetComponent<ScriptComponent>().ExecuteCallback<ElementEvent::Respawn>();
 		}
 	}
+
+	EntityId ClientLayer::InstantiatePendingEntity(Nz::UInt32 serverId)
+	{
+		auto it = m_pendingEntities.find(serverId);
+		if (it == m_pendingEntities.end())
+			return InvalidEntityId;
+
+		// Instantiating a parent first may touch the pending map, don't keep a reference in it
+		Packets::Helper::EntityData entityData = std::move(it.value());
+		m_pendingEntities.erase(it);
+
+		CreateEntity(serverId, entityData);
+
+		const EntityId* uniqueId = m_serverEntityIds.Find(serverId);
+		return (uniqueId) ? *uniqueId : InvalidEntityId;
+	}
+
+	void ClientLayer::RecycleEntity(EntityId uniqueId)
+	{
+		EntityData* entityData = m_entities.Find(uniqueId);
+		assert(entityData);
+
+		Nz::UInt32 serverId = entityData->layerEntity.GetServerId();
+
+		bool erased = m_serverEntityIds.Erase(serverId);
+		NazaraUnused(erased);
+		assert(erased);
+
+		OnEntityDelete(this, entityData->layerEntity);
+
+		if (entityData->layerEntity.GetEntity()->HasComponent<ScriptComponent>())
+		{
+			auto& scriptComponent = entityData->layerEntity.GetEntity()->GetComponent<ScriptComponent>();
+			scriptComponent.ExecuteCallback<ElementEvent::Destroyed>();
+		}
+
+		// The destroyed callback may have created entities, invalidating entityData
+		entityData = m_entities.Find(uniqueId);
+		assert(entityData);
+
+		// Keep the entity (and its visuals, physics and script state) around until the server respawns it
+		auto recycledEntity = std::make_unique<ClientLayerEntity>(std::move(entityData->layerEntity));
+		m_entities.Erase(uniqueId);
+
+		recycledEntity->UpdateUniqueId(InvalidEntityId);
+		recycledEntity->Disable();
+
+		m_recycledEntities.insert_or_assign(serverId, std::move(recycledEntity));
+	}
 }
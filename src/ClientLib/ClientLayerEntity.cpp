@@ -12,9 +12,11 @@
 #include <CoreLib/Utils.hpp>
 #include <ClientLib/ClientLayer.hpp>
 #include <ClientLib/ClientMatch.hpp>
+#include <ClientLib/Components/ClientMatchComponent.hpp>
 #include <ClientLib/VisualEntity.hpp>
 #include <Nazara/Utility/SimpleTextDrawer.hpp>
 #include <NDK/Components.hpp>
+#include <algorithm>
 
 namespace bw
 {
@@ -171,6 +173,9 @@ namespace bw
 	{
 		assert(m_health);
 
+		// Quantized health updates may be rounded above max health
+		newHealth = std::min(newHealth, m_health->maxHealth);
+
 		Nz::UInt16 oldHealth = m_health->currentHealth;
 		if (newHealth == oldHealth)
 			return;
@@ -210,6 +215,24 @@ namespace bw
 			entityNode.SetParent(static_cast<Nz::Node*>(nullptr));
 	}
 
+	void ClientLayerEntity::UpdateUniqueId(EntityId uniqueId)
+	{
+		ClientMatch& clientMatch = m_layer.GetClientMatch();
+		if (EntityId oldUniqueId = GetUniqueId(); oldUniqueId != InvalidEntityId)
+			clientMatch.UnregisterEntity(oldUniqueId);
+
+		LayerVisualEntity::UpdateUniqueId(uniqueId);
+
+		if (uniqueId != InvalidEntityId)
+		{
+			clientMatch.RegisterEntity(uniqueId, CreateHandle<ClientLayerEntity>());
+
+			const Ndk::EntityHandle& entity = GetEntity();
+			if (entity->HasComponent<ClientMatchComponent>())
+				entity->GetComponent<ClientMatchComponent>().UpdateUniqueId(uniqueId);
+		}
+	}
+
 	void ClientLayerEntity::UpdateWeaponEntity(const ClientLayerEntityHandle& entity)
 	{
 		if (m_weaponEntity)
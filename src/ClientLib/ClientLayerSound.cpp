@@ -23,7 +23,7 @@ namespace bw
 		return m_layer.GetLayerIndex();
 	}
 
-	std::size_t ClientLayerSound::PlaySound(const Nz::SoundBufferRef& soundBuffer, bool isLooping, bool isSpatialized)
+	std::size_t ClientLayerSound::PlaySound(const Nz::SoundBufferRef& soundBuffer, bool isLooping, bool isSpatialized, float priority)
 	{
 		// Find first finished sound
 		std::size_t soundIndex = 0;
@@ -40,10 +40,11 @@ namespace bw
 		playingSound.duration = soundBuffer->GetDuration() / 1000.f;
 		playingSound.isLooping = isLooping;
 		playingSound.isSpatialized = isSpatialized;
+		playingSound.priority = priority;
 		playingSound.soundBuffer = soundBuffer;
 
 		for (SoundEntity* soundEntity : m_soundEntities)
-			soundEntity->PlaySound(soundIndex, soundBuffer, isLooping, isSpatialized);
+			soundEntity->PlaySound(soundIndex, soundBuffer, isLooping, isSpatialized, priority);
 
 		return soundIndex;
 	}
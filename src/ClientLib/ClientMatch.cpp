@@ -9,17 +9,19 @@
 #include <CoreLib/Components/PlayerMovementComponent.hpp>
 #include <CoreLib/Components/ScriptComponent.hpp>
 #include <CoreLib/Components/WeaponComponent.hpp>
-#include <CoreLib/Scripting/NetworkPacket.hpp>
+#include <CoreLib/Scripting/ScriptBytecodeCache.hpp>
 #include <CoreLib/Scripting/ScriptingUtils.hpp>
 #include <CoreLib/Systems/AnimationSystem.hpp>
 #include <CoreLib/Systems/PlayerMovementSystem.hpp>
 #include <CoreLib/Systems/TickCallbackSystem.hpp>
 #include <CoreLib/Systems/WeaponSystem.hpp>
+#include <CoreLib/Utility/Profiling.hpp>
 #include <ClientLib/ClientEditorApp.hpp>
 #include <ClientLib/ClientSession.hpp>
 #include <ClientLib/KeyboardAndMousePoller.hpp>
 #include <ClientLib/InputPoller.hpp>
 #include <ClientLib/ClientCommandStore.hpp>
+#include <ClientLib/DemoRecorder.hpp>
 #include <ClientLib/Scoreboard.hpp>
 #include <ClientLib/VisualEntity.hpp>
 #include <ClientLib/Components/LocalPlayerControlledComponent.hpp>
@@ -31,7 +33,10 @@
 #include <ClientLib/Scripting/ClientScriptingLibrary.hpp>
 #include <ClientLib/Scripting/ClientWeaponLibrary.hpp>
 #include <ClientLib/Components/ClientMatchComponent.hpp>
+#include <ClientLib/Systems/LayerCacheSystem.hpp>
+#include <ClientLib/Systems/ParticleUpdateSystem.hpp>
 #include <ClientLib/Systems/SoundSystem.hpp>
+#include <Nazara/Core/Clock.hpp>
 #include <Nazara/Graphics/ColorBackground.hpp>
 #include <Nazara/Graphics/TileMap.hpp>
 #include <Nazara/Graphics/TextSprite.hpp>
@@ -42,8 +47,13 @@
 #include <Nazara/Utility/SimpleTextDrawer.hpp>
 #include <NDK/Components.hpp>
 #include <NDK/Systems.hpp>
+#include <fmt/format.h>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <fstream>
+#include <limits>
+#include <type_traits>
 
 namespace bw
 {
@@ -55,27 +65,56 @@ namespace bw
 	m_renderTarget(renderTarget),
 	m_window(window),
 	m_activeLayerIndex(NoLayer),
-	m_averageTickError(20),
+	m_jitterBufferDepth(3),
+	m_predictedInputs(static_cast<std::size_t>(std::ceil(2.f / matchData.minTickDuration))), //< Remember at most 2s of inputs (at the highest rate the match may switch to)
+	m_tickPredictions(static_cast<std::size_t>(std::ceil(2.f / matchData.minTickDuration))),
+	m_inputLatency(64),
+	m_tickArrivalDelay(64),
+	m_tickArrivalDelaySquared(64),
 	m_chatBox(GetLogger(), renderTarget, canvas),
 	m_application(burgApp),
+	m_clockSync(matchData.tickDuration, -static_cast<float>(matchData.currentTick)),
 	m_session(session),
 	m_escapeMenu(burgApp, canvas),
+	m_performanceOverlay(canvas, session),
 	m_scoreboard(nullptr),
+	m_frameProfiler(FrameCaptureSampleCount),
+	m_areLateTicksEnabled(true),
 	m_hasFocus(window->HasFocus()),
 	m_isLeavingMatch(false),
 	m_errorCorrectionTimer(0.f),
+	m_jitterBufferTimer(0.f),
+	m_lateTickTime(0.f),
 	m_playerEntitiesTimer(0.f),
 	m_playerInputTimer(0.f)
 	{
 		assert(window);
 
+		m_application.FillMatchStores();
+
 		for (const auto& property : matchData.gamemodeProperties)
 		{
 			const std::string& propertyName = m_session.GetNetworkStringStore().GetString(property.name);
 			m_gamemodeProperties.emplace(propertyName, property.value);
 		}
 
-		m_averageTickError.InsertValue(-static_cast<Nz::Int32>(matchData.currentTick));
+		// Frame profiling is cheap enough to be always enabled, which allows to dump the last frames when the player experiences lag
+		m_frameProfiler.Enable();
+		m_frameProfilerSections.frameTime = m_frameProfiler.RegisterSection("frame");
+		m_frameProfilerSections.update = m_frameProfiler.RegisterSection("update");
+		m_frameProfilerSections.tick = m_frameProfiler.RegisterSection("tick");
+		m_frameProfilerSections.frameScripts = m_frameProfiler.RegisterSection("scripts/Frame");
+		m_frameProfilerSections.visualSync = m_frameProfiler.RegisterSection("visuals/sync");
+		m_frameProfilerSections.render = m_frameProfiler.RegisterSection("render");
+		m_frameProfilerSections.audio = m_frameProfiler.RegisterSection("audio");
+		m_frameProfilerSections.postFrameScripts = m_frameProfiler.RegisterSection("scripts/PostFrame");
+
+		m_lastArrivedTick = matchData.currentTick;
+		m_lastHandledTick = AdjustServerTick(matchData.currentTick);
+		m_tickPacketBuckets.resize(JitterBufferSize);
+
+		if (matchData.stateQuantization)
+			m_stateQuantizer.emplace(matchData.stateQuantization.value());
 
 		m_layers.reserve(matchData.layers.size());
 
@@ -83,6 +122,16 @@ namespace bw
 		for (auto&& layerData : matchData.layers)
 		{
 			auto& layer = m_layers.emplace_back(std::make_unique<ClientLayer>(*this, layerIndex++, layerData.backgroundColor));
+
+			// Use the same physics settings as the server for prediction
+			SharedLayer::PhysicsSettings physicsSettings;
+			physicsSettings.iterationCount = layerData.physicsIterationCount;
+			physicsSettings.sleepTime = layerData.physicsSleepTime;
+			physicsSettings.spatialHashCellSize = layerData.physicsSpatialHashCellSize;
+			physicsSettings.spatialHashEntityCount = layerData.physicsSpatialHashEntityCount;
+
+			layer->ConfigurePhysics(physicsSettings);
+
 			layer->OnEntityCreated.Connect([this](ClientLayer* layer, ClientLayerEntity& entity)
 			{
 				HandleEntityCreated(layer, entity);
@@ -97,8 +146,9 @@ namespace bw
 		auto& playerSettings = burgApp.GetPlayerSettings();
 
 		m_renderWorld.AddSystem<Ndk::DebugSystem>();
+		m_renderWorld.AddSystem<LayerCacheSystem>();
 		m_renderWorld.AddSystem<Ndk::ListenerSystem>();
-		m_renderWorld.AddSystem<Ndk::ParticleSystem>();
+		m_renderWorld.AddSystem<ParticleUpdateSystem>(playerSettings);
 		m_renderWorld.AddSystem<Ndk::RenderSystem>();
 		m_renderWorld.AddSystem<AnimationSystem>(*this);
 		m_renderWorld.AddSystem<SoundSystem>(playerSettings);
@@ -121,8 +171,9 @@ namespace bw
 		std::size_t playerCount = authSuccess.players.size();
 
 		m_inputPacket.inputs.resize(playerCount);
-		for (auto& input : m_inputPacket.inputs)
-			input.emplace();
+		m_sentInputs.clear();
+
+		m_receivedMatchStates.resize(Packets::MatchState::MaxBaselineAge + 1);
 
 		m_localPlayers.reserve(playerCount);
 		assert(playerCount != 0xFF);
@@ -198,6 +249,45 @@ namespace bw
 		m_gamemode.reset();
 	}
 
+	std::string ClientMatch::FormatReconciliationStatistics() const
+	{
+		const ReconciliationStatistics& stats = m_reconciliationStats;
+		if (stats.reconciliationCount == 0)
+			return fmt::format("Reconciliations: none over {0} match states", stats.stateCount);
+
+		return fmt::format("Reconciliations: {0} over {1} match states ({2:.1f}%), {3:.2f} ms on average (max {4:.2f} ms), {5:.1f} ticks and {6:.1f} entities replayed on average",
+			stats.reconciliationCount, stats.stateCount, 100.0 * stats.reconciliationCount / stats.stateCount,
+			stats.totalDuration / 1000.0 / stats.reconciliationCount, stats.maxDuration / 1000.0,
+			double(stats.replayedTickCount) / stats.reconciliationCount, double(stats.islandEntityCount) / stats.reconciliationCount);
+	}
+
+	bool ClientMatch::DumpFrameCapture(const std::string& filePath, float duration)
+	{
+		std::size_t sampleCount = m_frameProfiler.GetSampleCount();
+
+		// Walk back the frame times until we cover the requested duration
+		Nz::UInt64 remainingTime = static_cast<Nz::UInt64>(std::max(duration, 0.f) * 1'000'000.f);
+		std::size_t captureSampleCount = 0;
+		while (captureSampleCount < sampleCount && remainingTime > 0)
+		{
+			Nz::UInt64 frameTime = m_frameProfiler.GetSample(m_frameProfilerSections.frameTime, sampleCount - captureSampleCount - 1);
+			remainingTime -= std::min(frameTime, remainingTime);
+			captureSampleCount++;
+		}
+
+		std::ofstream file(filePath, std::ios::out | std::ios::trunc);
+		if (!file)
+		{
+			bwLog(GetLogger(), LogLevel::Error, "failed to open {0} to write frame capture", filePath);
+			return false;
+		}
+
+		m_frameProfiler.ExportSamples(file, captureSampleCount);
+		bwLog(GetLogger(), LogLevel::Info, "dumped {0} frames to {1}", captureSampleCount, filePath);
+
+		return true;
+	}
+
 	void ClientMatch::ForEachEntity(std::function<void(const Ndk::EntityHandle& entity)> func)
 	{
 		for (auto& layer : m_layers)
@@ -289,6 +379,20 @@ namespace bw
 		}
 	}
 
+	bool ClientMatch::IsLocalPlayerWeapon(const Ndk::EntityHandle& weapon) const
+	{
+		for (const LocalPlayerData& localPlayer : m_localPlayers)
+		{
+			for (const auto& weaponData : localPlayer.weapons)
+			{
+				if (weaponData.entity == weapon)
+					return true;
+			}
+		}
+
+		return false;
+	}
+
 	void ClientMatch::LoadAssets(std::shared_ptr<VirtualDirectory> assetDir)
 	{
 		if (!m_assetStore)
@@ -307,20 +411,34 @@ namespace bw
 	{
 		assert(m_assetStore);
 
+		// Reading and compiling scripts doesn't need the Lua state, do it in parallel before running them
+		std::vector<std::string> preloadedFolders = { "autorun", "entities", "gamemodes", "weapons" };
+
 		if (!m_scriptingContext)
 		{
 			std::shared_ptr<ClientScriptingLibrary> scriptingLibrary = std::make_shared<ClientScriptingLibrary>(*this);
 
 			m_scriptingContext = std::make_shared<ScriptingContext>(GetLogger(), scriptDir);
+			m_scriptingContext->SetBytecodeCache(GetApplication().GetBytecodeCache());
+			m_scriptingContext->Preload(GetApplication().GetJobSystem(), preloadedFolders);
 			m_scriptingContext->LoadLibrary(scriptingLibrary);
 			m_scriptingContext->LoadLibrary(std::make_shared<ClientEditorScriptingLibrary>(GetLogger(), *m_assetStore));
 
 			if (!m_localConsole)
+			{
 				m_localConsole.emplace(GetLogger(), m_renderTarget, m_canvas, scriptingLibrary, scriptDir);
+
+				// Only available from the local console, match scripts (sent by the server) shouldn't be able to write files
+				m_localConsole->GetEnvironment().RegisterFunction("DumpFrameCapture", [this](float duration, std::optional<std::string> filePath)
+				{
+					return DumpFrameCapture(filePath.value_or("frame_capture.csv"), duration);
+				});
+			}
 		}
 		else
 		{
 			m_scriptingContext->UpdateScriptDirectory(scriptDir);
+			m_scriptingContext->Preload(GetApplication().GetJobSystem(), preloadedFolders);
 			m_scriptingContext->ReloadLibraries();
 		}
 
@@ -367,17 +485,7 @@ namespace bw
 		{
 			Ndk::EntityHandle entity = AssertScriptEntity(entityTable);
 
-			m_animationManager.PushAnimation(duration, [=](float ratio)
-			{
-				if (!entity)
-					return false;
-
-				float newAngle = Nz::Lerp(fromAngle, toAngle, ratio);
-				auto& nodeComponent = entity->GetComponent<Ndk::NodeComponent>();
-				nodeComponent.SetRotation(Nz::DegreeAnglef(newAngle));
-
-				return true;
-			}, [this, callback]()
+			m_animationManager.PushRotationAnimation(entity, Nz::DegreeAnglef(fromAngle), Nz::DegreeAnglef(toAngle), duration, AnimationManager::Easing::Linear, [this, callback]()
 			{
 				auto result = callback();
 				if (!result.valid())
@@ -393,17 +501,7 @@ namespace bw
 		{
 			Ndk::EntityHandle entity = AssertScriptEntity(entityTable);
 
-			m_animationManager.PushAnimation(duration, [=](float ratio)
-			{
-				if (!entity)
-					return false;
-
-				Nz::Vector2f offset = Nz::Lerp(fromOffset, toOffset, ratio * ratio); //< FIXME
-				auto& nodeComponent = entity->GetComponent<Ndk::NodeComponent>();
-				nodeComponent.SetInitialPosition(offset); //< FIXME
-
-				return true;
-			}, [this, callback]()
+			m_animationManager.PushOffsetAnimation(entity, fromOffset, toOffset, duration, AnimationManager::Easing::QuadraticIn, [this, callback]()
 			{
 				auto result = callback();
 				if (!result.valid())
@@ -471,6 +569,9 @@ namespace bw
 		else
 			m_gamemode->Reload();
 
+		// Scripts of other gamemodes
+		m_scriptingContext->ClearPreloadedScripts();
+
 		m_scriptingContext->LoadDirectoryOpt("map/autorun");
 	}
 
@@ -480,6 +581,35 @@ namespace bw
 		m_entitiesByUniqueId.emplace(uniqueId, std::move(entity));
 	}
 
+	void ClientMatch::RegisterPredictedEntity(const ClientLayerEntity& layerEntity)
+	{
+		const Ndk::EntityHandle& entity = layerEntity.GetEntity();
+		if (!entity->HasComponent<ScriptComponent>())
+			return;
+
+		// Only entities created while a local player weapon attacks are expected from the server (projectiles)
+		const Ndk::EntityHandle& attackingWeapon = entity->GetWorld()->GetSystem<WeaponSystem>().GetAttackingWeapon();
+		if (!attackingWeapon)
+			return;
+
+		for (const LocalPlayerData& localPlayer : m_localPlayers)
+		{
+			for (const auto& weapon : localPlayer.weapons)
+			{
+				if (weapon.entity != attackingWeapon)
+					continue;
+
+				auto& predictedEntity = m_predictedEntities.emplace_back();
+				predictedEntity.entityClass = entity->GetComponent<ScriptComponent>().GetElement()->fullName;
+				predictedEntity.inputTick = GetNetworkTick();
+				predictedEntity.layerIndex = layerEntity.GetLayerIndex();
+				predictedEntity.playerIndex = localPlayer.playerIndex;
+				predictedEntity.uniqueId = layerEntity.GetUniqueId();
+				return;
+			}
+		}
+	}
+
 	const Ndk::EntityHandle& ClientMatch::RetrieveEntityByUniqueId(EntityId uniqueId) const
 	{
 		auto it = m_entitiesByUniqueId.find(uniqueId);
@@ -497,6 +627,11 @@ namespace bw
 		return entity->GetComponent<ClientMatchComponent>().GetUniqueId();
 	}
 
+	void ClientMatch::StartDemoRecording(std::unique_ptr<DemoRecorder> demoRecorder)
+	{
+		m_demoRecorder = std::move(demoRecorder);
+	}
+
 	void ClientMatch::UnregisterEntity(EntityId uniqueId)
 	{
 		auto it = m_entitiesByUniqueId.find(uniqueId);
@@ -509,10 +644,17 @@ namespace bw
 		if (m_isLeavingMatch)
 			return false;
 
+		m_frameProfiler.Record(m_frameProfilerSections.frameTime, static_cast<Nz::UInt64>(elapsedTime * 1'000'000.f));
+		Nz::UInt64 updateStart = Nz::GetElapsedMicroseconds();
+
+		if (m_assetStore)
+			m_assetStore->Update();
+
 		if (m_scriptingContext)
 			m_scriptingContext->Update();
 
-		SharedMatch::Update(elapsedTime);
+		SharedMatch::Update(std::max(elapsedTime - m_lateTickTime, 0.f));
+		m_lateTickTime = 0.f;
 
 		if (m_debug)
 		{
@@ -600,32 +742,108 @@ namespace bw
 				layer->PreFrameUpdate(elapsedTime);
 		}
 
-		if (m_gamemode)
-			m_gamemode->ExecuteCallback<GamemodeEvent::Frame>(elapsedTime);
-
-		for (auto& layer : m_layers)
 		{
-			if (layer->IsEnabled())
-				layer->FrameUpdate(elapsedTime);
+			auto frameScriptsScope = m_frameProfiler.Profile(m_frameProfilerSections.frameScripts);
+			bwProfileZone("Frame scripts");
+
+			if (m_gamemode)
+				m_gamemode->ExecuteCallback<GamemodeEvent::Frame>(elapsedTime);
+
+			for (auto& layer : m_layers)
+			{
+				if (layer->IsEnabled())
+					layer->FrameUpdate(elapsedTime);
+			}
 		}
 
 		m_animationManager.Update(elapsedTime);
 
+		// Entities far from the camera don't need their visuals to follow them (the margin covers renderables larger than their entity)
+		constexpr float VisualCullingMargin = 128.f;
+
+		const Nz::Recti& viewport = m_camera->GetViewport();
+		Nz::Vector2f viewCorner1 = m_camera->Unproject(Nz::Vector2f(float(viewport.x), float(viewport.y)));
+		Nz::Vector2f viewCorner2 = m_camera->Unproject(Nz::Vector2f(float(viewport.x + viewport.width), float(viewport.y + viewport.height)));
+
+		Nz::Rectf viewRect(viewCorner1, viewCorner2); //< handles flipped axes
+		viewRect.x -= VisualCullingMargin;
+		viewRect.y -= VisualCullingMargin;
+		viewRect.width += 2.f * VisualCullingMargin;
+		viewRect.height += 2.f * VisualCullingMargin;
+
+		// Layer entities are instantiated over several frames, nearest to the camera first
+		constexpr Nz::UInt64 EntityInstantiationBudget = 4000; //< microseconds per frame
+
+		Nz::UInt64 instantiationDeadline = Nz::GetElapsedMicroseconds() + EntityInstantiationBudget;
 		for (auto& layerPtr : m_layers)
 		{
-			if (layerPtr->IsEnabled())
-				layerPtr->SyncVisuals();
+			if (!layerPtr->IsEnabled() || !layerPtr->HasPendingEntities())
+				continue;
+
+			layerPtr->InstantiatePendingEntities(viewRect.GetCenter(), instantiationDeadline);
+
+			if (!layerPtr->IsLoading())
+			{
+				bwLog(GetLogger(), LogLevel::Debug, "Layer {} is now fully loaded", layerPtr->GetLayerIndex());
+
+				if (m_gamemode)
+					m_gamemode->ExecuteCallback<GamemodeEvent::LayerEnabled>(layerPtr->GetLayerIndex());
+			}
 		}
 
-		m_renderWorld.Update(elapsedTime);
+		{
+			auto visualSyncScope = m_frameProfiler.Profile(m_frameProfilerSections.visualSync);
+			bwProfileZone("Visual sync");
 
-		if (m_gamemode)
-			m_gamemode->ExecuteCallback<GamemodeEvent::PostFrame>(elapsedTime);
+			for (auto& layerPtr : m_layers)
+			{
+				if (layerPtr->IsEnabled())
+					layerPtr->SyncVisuals(viewRect);
+			}
+		}
 
-		for (auto& layer : m_layers)
+		m_renderWorld.GetSystem<ParticleUpdateSystem>().UpdateViewRect(viewRect);
+
+		// Audio is updated along with rendering by the render world, split it from the render time
+		Nz::UInt64 renderStart = Nz::GetElapsedMicroseconds();
 		{
-			if (layer->IsEnabled())
-				layer->PostFrameUpdate(elapsedTime);
+			bwProfileZone("Render world");
+			m_renderWorld.Update(elapsedTime);
+		}
+		Nz::UInt64 renderDuration = Nz::GetElapsedMicroseconds() - renderStart;
+		Nz::UInt64 audioDuration = std::min(m_renderWorld.GetSystem<SoundSystem>().GetLastUpdateDuration(), renderDuration);
+
+		m_frameProfiler.Record(m_frameProfilerSections.audio, audioDuration);
+		m_frameProfiler.Record(m_frameProfilerSections.render, renderDuration - audioDuration);
+
+		{
+			auto postFrameScriptsScope = m_frameProfiler.Profile(m_frameProfilerSections.postFrameScripts);
+			bwProfileZone("Post-frame scripts");
+
+			if (m_gamemode)
+				m_gamemode->ExecuteCallback<GamemodeEvent::PostFrame>(elapsedTime);
+
+			for (auto& layer : m_layers)
+			{
+				if (layer->IsEnabled())
+					layer->PostFrameUpdate(elapsedTime);
+			}
+		}
+
+		// Ticks which became due while this frame was built run now rather than next frame, their inputs are sampled and sent that much earlier
+		if (m_areLateTicksEnabled)
+		{
+			m_lateTickTime = (Nz::GetElapsedMicroseconds() - updateStart) / 1'000'000.f;
+			SharedMatch::Update(m_lateTickTime);
+		}
+
+		m_frameProfiler.Record(m_frameProfilerSections.update, Nz::GetElapsedMicroseconds() - updateStart);
+		m_frameProfiler.EndTick();
+
+		if (m_performanceOverlay.IsVisible())
+		{
+			std::string matchStatistics = fmt::format("Jitter buffer depth: {0} tick(s), input latency: {1:.1f} ms, reconciliations: {2} over {3} match states", m_jitterBufferDepth, m_inputLatency.GetAverageValue() * 1000.f, m_reconciliationStats.reconciliationCount, m_reconciliationStats.stateCount);
+			m_performanceOverlay.Update(elapsedTime, m_frameProfiler, matchStatistics);
 		}
 
 		/*Ndk::PhysicsSystem2D::DebugDrawOptions options;
@@ -673,6 +891,9 @@ namespace bw
 		//TODO: Use slots
 		m_session.OnChatMessage.Connect([this](ClientSession* /*session*/, const Packets::ChatMessage& message)
 		{
+			if (m_demoRecorder)
+				m_demoRecorder->RecordPacket(message);
+
 			HandleChatMessage(message);
 		});
 
@@ -683,62 +904,62 @@ namespace bw
 
 		m_session.OnControlEntity.Connect([this](ClientSession* /*session*/, const Packets::ControlEntity& controlEntity)
 		{
-			PushTickPacket(controlEntity.stateTick, controlEntity);
+			PushTickPacket(controlEntity.stateTick, AcquireTickPacket(controlEntity));
 		});
 
 		m_session.OnCreateEntities.Connect([this](ClientSession* /*session*/, const Packets::CreateEntities& createEntities)
 		{
-			PushTickPacket(createEntities.stateTick, createEntities);
+			PushTickPacket(createEntities.stateTick, AcquireTickPacket(createEntities));
 		});
 
 		m_session.OnDeleteEntities.Connect([this](ClientSession* /*session*/, const Packets::DeleteEntities& deleteEntities)
 		{
-			PushTickPacket(deleteEntities.stateTick, deleteEntities);
+			PushTickPacket(deleteEntities.stateTick, AcquireTickPacket(deleteEntities));
 		});
 		
 		m_session.OnDisableLayer.Connect([this](ClientSession* /*session*/, const Packets::DisableLayer& disableLayer)
 		{
-			PushTickPacket(disableLayer.stateTick, disableLayer);
+			PushTickPacket(disableLayer.stateTick, AcquireTickPacket(disableLayer));
 		});
 		
 		m_session.OnEnableLayer.Connect([this](ClientSession* /*session*/, const Packets::EnableLayer& enableLayer)
 		{
-			PushTickPacket(enableLayer.stateTick, enableLayer);
+			PushTickPacket(enableLayer.stateTick, AcquireTickPacket(enableLayer));
 		});
 
 		m_session.OnEntitiesAnimation.Connect([this](ClientSession* /*session*/, const Packets::EntitiesAnimation& animations)
 		{
-			PushTickPacket(animations.stateTick, animations);
+			PushTickPacket(animations.stateTick, AcquireTickPacket(animations));
 		});
 
 		m_session.OnEntitiesDeath.Connect([this](ClientSession* /*session*/, const Packets::EntitiesDeath& deaths)
 		{
-			PushTickPacket(deaths.stateTick, deaths);
+			PushTickPacket(deaths.stateTick, AcquireTickPacket(deaths));
 		});
 
 		m_session.OnEntitiesInputs.Connect([this](ClientSession* /*session*/, const Packets::EntitiesInputs& inputs)
 		{
-			PushTickPacket(inputs.stateTick, inputs);
+			PushTickPacket(inputs.stateTick, AcquireTickPacket(inputs));
 		});
 
-		m_session.OnEntitiesScale.Connect([this](ClientSession* /*session*/, const Packets::EntitiesScale& scale)
+		m_session.OnEntitiesPhysics.Connect([this](ClientSession* /*session*/, const Packets::EntitiesPhysics& physics)
 		{
-			PushTickPacket(scale.stateTick, scale);
+			PushTickPacket(physics.stateTick, AcquireTickPacket(physics));
 		});
 
-		m_session.OnEntityPhysics.Connect([this](ClientSession* /*session*/, const Packets::EntityPhysics& physics)
+		m_session.OnEntitiesScale.Connect([this](ClientSession* /*session*/, const Packets::EntitiesScale& scale)
 		{
-			PushTickPacket(physics.stateTick, physics);
+			PushTickPacket(scale.stateTick, AcquireTickPacket(scale));
 		});
-		
-		m_session.OnEntityWeapon.Connect([this](ClientSession* /*session*/, const Packets::EntityWeapon& weapon)
+
+		m_session.OnEntitiesWeapon.Connect([this](ClientSession* /*session*/, const Packets::EntitiesWeapon& weapon)
 		{
-			PushTickPacket(weapon.stateTick, weapon);
+			PushTickPacket(weapon.stateTick, AcquireTickPacket(weapon));
 		});
 
 		m_session.OnHealthUpdate.Connect([this](ClientSession* /*session*/, const Packets::HealthUpdate& healthUpdate)
 		{
-			PushTickPacket(healthUpdate.stateTick, healthUpdate);
+			PushTickPacket(healthUpdate.stateTick, AcquireTickPacket(healthUpdate));
 		});
 
 		m_session.OnInputTimingCorrection.Connect([this](ClientSession* /*session*/, const Packets::InputTimingCorrection& timingCorrection)
@@ -748,53 +969,101 @@ namespace bw
 		
 		m_session.OnMapReset.Connect([this](ClientSession* /*session*/, const Packets::MapReset& mapReset)
 		{
-			PushTickPacket(mapReset.stateTick, mapReset);
+			PushTickPacket(mapReset.stateTick, AcquireTickPacket(mapReset));
 		});
 
 		m_session.OnMatchState.Connect([this](ClientSession* /*session*/, const Packets::MatchState& matchState)
 		{
-			PushTickPacket(matchState.stateTick, matchState);
+			TickPacketContent packet = AcquireTickPacket(matchState);
+
+			Packets::MatchState& decodedState = std::get<Packets::MatchState>(packet);
+			DecodeMatchState(decodedState);
+
+			auto& lastReceivedStateTick = m_inputPacket.lastReceivedStateTick;
+			if (!lastReceivedStateTick || IsMoreRecent(decodedState.stateTick, *lastReceivedStateTick))
+				lastReceivedStateTick = decodedState.stateTick;
+
+			PushTickPacket(decodedState.stateTick, std::move(packet));
+		});
+
+		m_session.OnNetworkStrings.Connect([this](ClientSession* /*session*/, const Packets::NetworkStrings& networkStrings)
+		{
+			if (m_demoRecorder)
+				m_demoRecorder->RecordPacket(networkStrings);
 		});
 
 		m_session.OnPlayerControlEntity.Connect([this](ClientSession* /*session*/, const Packets::PlayerControlEntity& playerControlEntity)
 		{
+			if (m_demoRecorder)
+				m_demoRecorder->RecordPacket(playerControlEntity);
+
 			HandlePlayerControlEntity(playerControlEntity);
 		});
 
 		m_session.OnPlayerLayer.Connect([this](ClientSession* /*session*/, const Packets::PlayerLayer& layerUpdate)
 		{
-			PushTickPacket(layerUpdate.stateTick, layerUpdate);
+			PushTickPacket(layerUpdate.stateTick, AcquireTickPacket(layerUpdate));
 		});
 		
 		m_session.OnPlayerJoined.Connect([this](ClientSession* /*session*/, const Packets::PlayerJoined& playerJoined)
 		{
+			if (m_demoRecorder)
+				m_demoRecorder->RecordPacket(playerJoined);
+
 			HandlePlayerJoined(playerJoined);
 		});
 		
 		m_session.OnPlayerLeaving.Connect([this](ClientSession* /*session*/, const Packets::PlayerLeaving& playerLeaving)
 		{
+			if (m_demoRecorder)
+				m_demoRecorder->RecordPacket(playerLeaving);
+
 			HandlePlayerLeaving(playerLeaving);
 		});
 		
 		m_session.OnPlayerNameUpdate.Connect([this](ClientSession* /*session*/, const Packets::PlayerNameUpdate& playerNameUpdate)
 		{
+			if (m_demoRecorder)
+				m_demoRecorder->RecordPacket(playerNameUpdate);
+
 			HandlePlayerNameUpdate(playerNameUpdate);
 		});
 
 		m_session.OnPlayerPingUpdate.Connect([this](ClientSession* /*session*/, const Packets::PlayerPingUpdate& playerPingUpdate)
 		{
+			if (m_demoRecorder)
+				m_demoRecorder->RecordPacket(playerPingUpdate);
+
 			HandlePlayerPingUpdate(playerPingUpdate);
 		});
 
 		m_session.OnPlayerWeapons.Connect([this](ClientSession* /*session*/, const Packets::PlayerWeapons& weapons)
 		{
-			PushTickPacket(weapons.stateTick, weapons);
+			PushTickPacket(weapons.stateTick, AcquireTickPacket(weapons));
+		});
+
+		m_session.OnRecycleEntities.Connect([this](ClientSession* /*session*/, const Packets::RecycleEntities& recycleEntities)
+		{
+			PushTickPacket(recycleEntities.stateTick, AcquireTickPacket(recycleEntities));
+		});
+
+		m_session.OnRespawnEntities.Connect([this](ClientSession* /*session*/, const Packets::RespawnEntities& respawnEntities)
+		{
+			PushTickPacket(respawnEntities.stateTick, AcquireTickPacket(respawnEntities));
 		});
 
 		m_session.OnScriptPacket.Connect([this](ClientSession* /*session*/, const Packets::ScriptPacket& scriptPacket)
 		{
+			if (m_demoRecorder)
+				m_demoRecorder->RecordPacket(scriptPacket);
+
 			HandleScriptPacket(scriptPacket);
 		});
+
+		m_session.OnTickRateUpdate.Connect([this](ClientSession* /*session*/, const Packets::TickRateUpdate& tickRateUpdate)
+		{
+			m_pendingTickRateUpdate = tickRateUpdate;
+		});
 	}
 
 	void ClientMatch::BindSignals(ClientEditorApp& burgApp, Nz::RenderWindow* window, Ndk::Canvas* canvas)
@@ -834,6 +1103,10 @@ namespace bw
 					break;
 				}
 
+				case Nz::Keyboard::VKey::F3:
+					m_performanceOverlay.Show(!m_performanceOverlay.IsVisible());
+					break;
+
 				case Nz::Keyboard::VKey::F9:
 					if (m_remoteConsole)
 						m_remoteConsole->Hide();
@@ -918,7 +1191,120 @@ namespace bw
 
 	Nz::UInt64 ClientMatch::EstimateServerTick() const
 	{
-		return GetCurrentTick() - m_averageTickError.GetAverageValue();
+		return GetCurrentTick() - m_clockSync.GetRoundedOffset();
+	}
+
+	void ClientMatch::DecodeMatchState(Packets::MatchState& packet)
+	{
+		if (packet.isQuantized && !m_stateQuantizer)
+		{
+			bwLog(GetLogger(), LogLevel::Error, "received quantized MatchState #{0} without quantization settings, ignoring", packet.stateTick);
+			packet.entities.clear();
+			packet.layers.clear();
+			return;
+		}
+
+		tsl::hopscotch_map<Nz::UInt64, ReceivedMatchState::EntityState> entityStates;
+		entityStates.reserve(packet.entities.size());
+
+		// Restore delta-encoded fields from their baselines, dropping entities we cannot decode
+		std::size_t entityIndex = 0;
+		std::size_t decodedEntityCount = 0;
+		for (auto& layer : packet.layers)
+		{
+			Nz::UInt32 layerEntityCount = 0;
+			for (std::size_t i = 0; i < layer.entityCount; ++i)
+			{
+				auto& entityData = packet.entities[entityIndex++];
+				Nz::UInt64 entityKey = Nz::UInt64(layer.layerIndex) << 32 | Nz::UInt32(entityData.id);
+
+				if (packet.isQuantized)
+				{
+					bool hasPosition = !entityData.delta || entityData.delta->positionChanged;
+					bool hasRotation = !entityData.delta || entityData.delta->rotationChanged;
+					bool hasVelocity = !entityData.delta || entityData.delta->velocityChanged;
+
+					if (hasPosition)
+						entityData.position = m_stateQuantizer->DequantizePosition(entityData.quantizedPosition);
+
+					if (hasRotation)
+						entityData.rotation = m_stateQuantizer->DequantizeAngle(entityData.quantizedRotation);
+
+					if (entityData.physicsProperties && hasVelocity)
+					{
+						auto& physicsProperties = entityData.physicsProperties.value();
+						physicsProperties.angularVelocity = m_stateQuantizer->DequantizeAngularVelocity(physicsProperties.quantizedAngularVelocity);
+						physicsProperties.linearVelocity = m_stateQuantizer->DequantizeLinearVelocity(physicsProperties.quantizedLinearVelocity);
+					}
+				}
+
+				if (entityData.delta)
+				{
+					const auto& deltaData = entityData.delta.value();
+
+					Nz::UInt16 baselineTick = packet.stateTick - deltaData.baselineAge;
+					const ReceivedMatchState& baselineState = m_receivedMatchStates[baselineTick % m_receivedMatchStates.size()];
+
+					const ReceivedMatchState::EntityState* baseline = nullptr;
+					if (deltaData.baselineAge != 0 && baselineState.isValid && baselineState.stateTick == baselineTick)
+					{
+						auto it = baselineState.entities.find(entityKey);
+						if (it != baselineState.entities.end())
+							baseline = &it->second;
+					}
+
+					if (!baseline)
+					{
+						bwLog(GetLogger(), LogLevel::Warning, "MatchState #{0}: missing baseline #{1} for entity {2}, ignoring", packet.stateTick, baselineTick, Nz::UInt32(entityData.id));
+						continue;
+					}
+
+					if (!deltaData.positionChanged)
+						entityData.position = baseline->position;
+
+					if (!deltaData.rotationChanged)
+						entityData.rotation = baseline->rotation;
+
+					if (entityData.physicsProperties && !deltaData.velocityChanged)
+					{
+						entityData.physicsProperties->angularVelocity = baseline->angularVelocity;
+						entityData.physicsProperties->linearVelocity = baseline->linearVelocity;
+					}
+
+					entityData.delta.reset();
+				}
+
+				auto& entityState = entityStates[entityKey];
+				entityState.position = entityData.position;
+				entityState.rotation = entityData.rotation;
+
+				if (entityData.physicsProperties)
+				{
+					entityState.angularVelocity = entityData.physicsProperties->angularVelocity;
+					entityState.linearVelocity = entityData.physicsProperties->linearVelocity;
+				}
+				else
+				{
+					entityState.angularVelocity = Nz::RadianAnglef::Zero();
+					entityState.linearVelocity = Nz::Vector2f::Zero();
+				}
+
+				if (decodedEntityCount != entityIndex - 1)
+					packet.entities[decodedEntityCount] = std::move(entityData);
+
+				decodedEntityCount++;
+				layerEntityCount++;
+			}
+
+			layer.entityCount = layerEntityCount;
+		}
+
+		packet.entities.resize(decodedEntityCount);
+
+		ReceivedMatchState& receivedState = m_receivedMatchStates[packet.stateTick % m_receivedMatchStates.size()];
+		receivedState.isValid = true;
+		receivedState.stateTick = packet.stateTick;
+		receivedState.entities = std::move(entityStates);
 	}
 
 	void ClientMatch::HandleChatMessage(const Packets::ChatMessage& packet)
@@ -1101,12 +1487,7 @@ namespace bw
 
 	void ClientMatch::HandleScriptPacket(const Packets::ScriptPacket& packet)
 	{
-		const ScriptHandlerRegistry& registry = GetScriptPacketHandlerRegistry();
-		const NetworkStringStore& stringStore = GetNetworkStringStore();
-
-		const std::string& packetName = stringStore.GetString(packet.nameIndex);
-
-		registry.Call(packetName, IncomingNetworkPacket(stringStore, packet));
+		DispatchScriptPacket(packet);
 	}
 
 	void ClientMatch::HandleTickPacket(TickPacketContent&& packet)
@@ -1170,6 +1551,17 @@ namespace bw
 			assert(layerData.layerIndex < m_layers.size());
 			auto& layer = m_layers[layerData.layerIndex];
 			layer->HandlePacket(&packet.entities[offset], layerData.entityCount);
+
+			if (!m_predictedEntities.empty())
+			{
+				for (std::size_t i = 0; i < layerData.entityCount; ++i)
+				{
+					const auto& entity = packet.entities[offset + i];
+					if (entity.data.ownerPlayerIndex)
+						ReconcilePredictedEntity(*layer, entity.id, *entity.data.ownerPlayerIndex);
+				}
+			}
+
 			offset += layerData.entityCount;
 		}
 	}
@@ -1203,15 +1595,26 @@ namespace bw
 	{
 		std::size_t layerIndex = packet.layerIndex;
 
-		assert(!m_layers[layerIndex]->IsEnabled());
-		bwLog(GetLogger(), LogLevel::Debug, "Layer {} is now enabled", layerIndex);
-
-		//TODO
+		// Layers are streamed in chunks, only the first one enables the layer
 		auto& layer = m_layers[layerIndex];
-		layer->Enable();
+		if (!layer->IsEnabled())
+		{
+			bwLog(GetLogger(), LogLevel::Debug, "Layer {} is now enabled", layerIndex);
+
+			//TODO
+			layer->Enable();
+		}
+		else
+			assert(layer->IsLoading());
+
 		layer->HandlePacket(packet.layerEntities.data(), packet.layerEntities.size());
+		layer->SetRemainingEntityCount(packet.remainingEntityCount);
 
-		m_gamemode->ExecuteCallback<GamemodeEvent::LayerEnabled>(layerIndex);
+		if (!layer->IsLoading())
+		{
+			bwLog(GetLogger(), LogLevel::Debug, "Layer {} is now fully loaded", layerIndex);
+			m_gamemode->ExecuteCallback<GamemodeEvent::LayerEnabled>(layerIndex);
+		}
 	}
 
 	void ClientMatch::HandleTickPacket(Packets::EntitiesAnimation&& packet)
@@ -1250,7 +1653,7 @@ namespace bw
 		}
 	}
 
-	void ClientMatch::HandleTickPacket(Packets::EntitiesScale&& packet)
+	void ClientMatch::HandleTickPacket(Packets::EntitiesPhysics&& packet)
 	{
 		std::size_t offset = 0;
 		for (auto&& layerData : packet.layers)
@@ -1262,18 +1665,28 @@ namespace bw
 		}
 	}
 
-	void ClientMatch::HandleTickPacket(Packets::EntityPhysics&& packet)
+	void ClientMatch::HandleTickPacket(Packets::EntitiesScale&& packet)
 	{
-		assert(packet.entityId.layerId < m_layers.size());
-		auto& layer = m_layers[packet.entityId.layerId];
-		layer->HandlePacket(packet);
+		std::size_t offset = 0;
+		for (auto&& layerData : packet.layers)
+		{
+			assert(layerData.layerIndex < m_layers.size());
+			auto& layer = m_layers[layerData.layerIndex];
+			layer->HandlePacket(&packet.entities[offset], layerData.entityCount);
+			offset += layerData.entityCount;
+		}
 	}
 
-	void ClientMatch::HandleTickPacket(Packets::EntityWeapon&& packet)
+	void ClientMatch::HandleTickPacket(Packets::EntitiesWeapon&& packet)
 	{
-		assert(packet.entityId.layerId < m_layers.size());
-		auto& layer = m_layers[packet.entityId.layerId];
-		layer->HandlePacket(packet);
+		std::size_t offset = 0;
+		for (auto&& layerData : packet.layers)
+		{
+			assert(layerData.layerIndex < m_layers.size());
+			auto& layer = m_layers[layerData.layerIndex];
+			layer->HandlePacket(&packet.entities[offset], layerData.entityCount);
+			offset += layerData.entityCount;
+		}
 	}
 
 	void ClientMatch::HandleTickPacket(Packets::HealthUpdate&& packet)
@@ -1320,8 +1733,12 @@ namespace bw
 			offset += layerData.entityCount;
 		}
 
+		// Layers still instantiating their entities are reported once they're done
 		for (std::size_t i = enabledLayers.FindFirst(); i != enabledLayers.npos; i = enabledLayers.FindNext(i))
-			m_gamemode->ExecuteCallback<GamemodeEvent::LayerEnabled>(i);
+		{
+			if (!m_layers[i]->IsLoading())
+				m_gamemode->ExecuteCallback<GamemodeEvent::LayerEnabled>(i);
+		}
 
 		m_gamemode->ExecuteCallback<GamemodeEvent::MapInit>();
 	}
@@ -1329,17 +1746,21 @@ namespace bw
 	void ClientMatch::HandleTickPacket(Packets::MatchState&& packet)
 	{
 		m_inactiveEntities.clear();
+		m_reconciliationIsland.clear();
+
+		m_reconciliationStats.stateCount++;
 
 		bool performReconciliation = !Nz::Keyboard::IsKeyPressed(Nz::Keyboard::VKey::A);
+		bool replayIsland = false; //< when false (no prediction for that tick), every predicted entity is replayed
 
-		auto inputIt = std::find_if(m_predictedInputs.begin(), m_predictedInputs.end(), [lastInputTick = packet.lastInputTick](const PredictedInput& input)
-		{
-			return input.inputTick == lastInputTick;
-		});
-		if (inputIt != m_predictedInputs.end())
+		if (const PredictedInput* inputIt = m_predictedInputs.Find(packet.lastInputTick))
 		{
+			replayIsland = true;
+
 			performReconciliation = performReconciliation && [&]
 			{
+				bool hasError = false;
+
 				// Check if reconciliation is required (were all packets entities at the same position back then?)
 				std::size_t offset = 0;
 				for (auto&& packetLayer : packet.layers)
@@ -1370,28 +1791,49 @@ namespace bw
 						constexpr float MaxRotationError = Nz::DegreeToRadian(5.f);
 
 						auto& entityData = it.value();
+
+						// Server rotation may be wrapped (quantized states), compare the shortest angle difference
+						float rotationError = std::remainder(entityData.rotation.value - packetEntity.rotation.value, 2.f * float(M_PI));
+
 						if (entityData.isPhysical &&
 						    (!CompareWithEpsilon(entityData.position, packetEntity.position, MaxPositionError) ||
-						     !CompareWithEpsilon(entityData.rotation, packetEntity.rotation, MaxRotationError)))
+						     std::abs(rotationError) > MaxRotationError))
 						{
 							/*Nz::Vector2f posDiff = entityData.position - packetEntity.position;
 							Nz::RadianAnglef rotDiff = entityData.rotation - packetEntity.rotation;
 
 							bwLog(GetLogger(), LogLevel::Debug, "Prediction error for entity #{} (position diff: {}, rotation diff: {})", uniqueId, posDiff.ToString().ToStdString(), rotDiff.ToString().ToStdString());*/
-							return true;
+							m_reconciliationIsland.insert(uniqueId);
+							hasError = true;
 						}
 					}
 
 					offset += packetLayer.entityCount;
 				}
 
-				return false;
+				return hasError;
 			}();
 
 			if (performReconciliation)
 			{
 				//bwLog(GetLogger(), LogLevel::Debug, "Too much error detected, performing reconciliation...");
 
+				// Only replay mispredicted entities, the ones we control and the ones they touched since that tick
+				for (const LocalPlayerData& localPlayer : m_localPlayers)
+				{
+					if (localPlayer.controlledEntity)
+						m_reconciliationIsland.insert(localPlayer.controlledEntity->GetUniqueId());
+				}
+
+				m_predictedInputs.ForEach([&](const PredictedInput& input)
+				{
+					if (IsMoreRecent(packet.lastInputTick, input.inputTick))
+						return;
+
+					for (const auto& playerData : input.inputs)
+						m_reconciliationIsland.insert(playerData.touchedEntities.begin(), playerData.touchedEntities.end());
+				});
+
 				// Reset entities to their previous position
 				for (const auto& layerData : inputIt->layers)
 				{
@@ -1400,9 +1842,32 @@ namespace bw
 					if (!layer->IsEnabled() || !layer->IsPredictionEnabled())
 						continue;
 
+					// Entities out of the island keep their current prediction, they're put back in place after the replay
+					bool canSleep = layer->GetPhysicsSettings().sleepTime > 0.f;
+
 					layer->ForEachLayerEntity([&](ClientLayerEntity& layerEntity)
 					{
 						EntityId uniqueId = layerEntity.GetUniqueId();
+						if (m_reconciliationIsland.find(uniqueId) == m_reconciliationIsland.end())
+						{
+							if (layerEntity.IsPhysical())
+							{
+								auto& frozenEntity = m_frozenEntities.emplace_back();
+								frozenEntity.angularVelocity = layerEntity.GetAngularVelocity();
+								frozenEntity.linearVelocity = layerEntity.GetLinearVelocity();
+								frozenEntity.position = layerEntity.GetPhysicalPosition();
+								frozenEntity.rotation = layerEntity.GetPhysicalRotation();
+								frozenEntity.uniqueId = uniqueId;
+								frozenEntity.layerIndex = layerData.layerIndex;
+
+								// Sleeping bodies are skipped by the physics step until something of the island touches them
+								if (canSleep)
+									layerEntity.GetEntity()->GetComponent<Ndk::PhysicsComponent2D>().ForceSleep();
+							}
+
+							return;
+						}
+
 						auto it = layerData.entities.find(uniqueId);
 						if (it != layerData.entities.end())
 						{
@@ -1433,6 +1898,21 @@ namespace bw
 			{
 				auto& packetEntity = packet.entities[offset + i];
 
+				// Entities waiting for their instantiation will start from the latest state
+				if (Packets::Helper::EntityData* pendingEntity = layer->FindPendingEntity(packetEntity.id))
+				{
+					pendingEntity->position = packetEntity.position;
+					pendingEntity->rotation = packetEntity.rotation;
+
+					if (pendingEntity->physicsProperties && packetEntity.physicsProperties)
+					{
+						pendingEntity->physicsProperties->angularVelocity = packetEntity.physicsProperties->angularVelocity;
+						pendingEntity->physicsProperties->linearVelocity = packetEntity.physicsProperties->linearVelocity;
+					}
+
+					continue;
+				}
+
 				auto entityOpt = layer->GetEntityByServerId(packetEntity.id);
 				if (!entityOpt)
 					continue;
@@ -1443,6 +1923,9 @@ namespace bw
 					if (!performReconciliation)
 						continue; //< No reconciliation is required, ignore physical entities
 
+					if (replayIsland && m_reconciliationIsland.find(localEntity.GetUniqueId()) == m_reconciliationIsland.end())
+						continue;
+
 					if (packetEntity.physicsProperties.has_value())
 					{
 						auto& physData = packetEntity.physicsProperties.value();
@@ -1469,18 +1952,37 @@ namespace bw
 			offset += packetLayer.entityCount;
 		}
 
-		// Remove treated inputs
-		auto firstClientInput = std::find_if(m_predictedInputs.begin(), m_predictedInputs.end(), [lastInputTick = packet.lastInputTick](const PredictedInput& input)
+		// Provisional entities the server didn't create after handling their input were mispredicted (weapon on cooldown, player dead, ...)
+		for (auto it = m_predictedEntities.begin(); it != m_predictedEntities.end();)
 		{
-			return IsMoreRecent(input.inputTick, lastInputTick);
-		});
-		m_predictedInputs.erase(m_predictedInputs.begin(), firstClientInput);
+			if (static_cast<Nz::Int16>(Nz::UInt16(packet.lastInputTick - it->inputTick)) <= Nz::Int16(PredictedEntityGraceTicks))
+			{
+				++it;
+				continue;
+			}
+
+			ClientLayer& layer = *m_layers[it->layerIndex];
+			if (layer.GetEntity(it->uniqueId))
+				layer.DiscardEntity(it->uniqueId);
+
+			it = m_predictedEntities.erase(it);
+		}
+
+		// Remove treated inputs
+		m_predictedInputs.RemoveUntil(packet.lastInputTick);
 
 		if (!performReconciliation)
 			return;
 
-		for (const PredictedInput& input : m_predictedInputs)
+		Nz::UInt64 reconciliationStart = Nz::GetElapsedMicroseconds();
+
+		m_reconciliationStats.islandEntityCount += (replayIsland) ? m_reconciliationIsland.size() : m_entitiesByUniqueId.size();
+		m_reconciliationStats.reconciliationCount++;
+
+		m_predictedInputs.ForEach([&](const PredictedInput& input)
 		{
+			m_reconciliationStats.replayedTickCount++;
+
 			for (std::size_t i = 0; i < m_localPlayers.size(); ++i)
 			{
 				auto& controllerData = m_localPlayers[i];
@@ -1563,7 +2065,7 @@ namespace bw
 				else
 					++it;
 			}
-		}
+		});
 
 		// Prevent locking entities forever
 		for (EntityId uniqueId : m_inactiveEntities)
@@ -1582,6 +2084,29 @@ namespace bw
 				break;
 			}
 		}
+
+		for (const FrozenEntity& frozenEntity : m_frozenEntities)
+		{
+			auto& layer = m_layers[frozenEntity.layerIndex];
+			if (auto entityOpt = layer->GetEntity(frozenEntity.uniqueId))
+				entityOpt->get().UpdateState(frozenEntity.position, frozenEntity.rotation, frozenEntity.linearVelocity, frozenEntity.angularVelocity);
+		}
+		m_frozenEntities.clear();
+
+		// Contacts made while replaying are not part of the next prediction
+		for (const LocalPlayerData& localPlayer : m_localPlayers)
+		{
+			if (localPlayer.controlledEntity)
+			{
+				auto& entity = localPlayer.controlledEntity->GetEntity();
+				if (entity->HasComponent<PlayerMovementComponent>())
+					entity->GetComponent<PlayerMovementComponent>().ClearTouchedEntities();
+			}
+		}
+
+		Nz::UInt64 reconciliationDuration = Nz::GetElapsedMicroseconds() - reconciliationStart;
+		m_reconciliationStats.maxDuration = std::max(m_reconciliationStats.maxDuration, reconciliationDuration);
+		m_reconciliationStats.totalDuration += reconciliationDuration;
 	}
 
 	void ClientMatch::HandleTickPacket(Packets::PlayerLayer&& packet)
@@ -1634,29 +2159,55 @@ namespace bw
 		playerData.selectedWeapon = playerData.weapons.size();
 	}
 
-	void ClientMatch::HandleTickError(Nz::UInt16 stateTick, Nz::Int32 tickError)
+	void ClientMatch::HandleTickPacket(Packets::RecycleEntities&& packet)
 	{
-		for (auto it = m_tickPredictions.begin(); it != m_tickPredictions.end(); ++it)
+		std::size_t offset = 0;
+		for (auto&& layerData : packet.layers)
 		{
-			if (it->serverTick == stateTick)
-			{
-				m_averageTickError.InsertValue(it->tickError + tickError);
-				m_tickPredictions.erase(it);
+			assert(layerData.layerIndex < m_layers.size());
+			auto& layer = m_layers[layerData.layerIndex];
+			layer->HandlePacket(&packet.entities[offset], layerData.entityCount);
+			offset += layerData.entityCount;
+		}
+	}
 
-				//bwLog(GetLogger(), LogLevel::Debug, "Error: {}", tickError);
-				return;
+	void ClientMatch::HandleTickPacket(Packets::RespawnEntities&& packet)
+	{
+		std::size_t offset = 0;
+		for (auto&& layerData : packet.layers)
+		{
+			assert(layerData.layerIndex < m_layers.size());
+			auto& layer = m_layers[layerData.layerIndex];
+			layer->HandlePacket(&packet.entities[offset], layerData.entityCount);
+
+			// Pooled projectiles are respawned rather than created
+			if (!m_predictedEntities.empty())
+			{
+				for (std::size_t i = 0; i < layerData.entityCount; ++i)
+				{
+					const auto& entity = packet.entities[offset + i];
+					if (entity.ownerPlayerIndex)
+						ReconcilePredictedEntity(*layer, entity.id, *entity.ownerPlayerIndex);
+				}
 			}
+
+			offset += layerData.entityCount;
 		}
+	}
 
-		bwLog(GetLogger(), LogLevel::Warning, "Input not found for state tick {0}", stateTick);
+	void ClientMatch::HandleTickError(Nz::UInt16 stateTick, Nz::Int32 tickError)
+	{
+		if (const TickPrediction* prediction = m_tickPredictions.Find(stateTick))
+		{
+			Nz::UInt64 now = Nz::GetElapsedMicroseconds();
+			m_clockSync.InsertSample(static_cast<float>(prediction->tickError + tickError), now - prediction->sendTime, now);
+			m_tickPredictions.Remove(stateTick);
 
-		//m_averageTickError.InsertValue(m_averageTickError.GetAverageValue() + tickError);
+			//bwLog(GetLogger(), LogLevel::Debug, "Error: {}", tickError);
+			return;
+		}
 
-		/*std::cout << "----" << std::endl;
-		std::cout << "Current tick error: " << m_tickError << std::endl;
-		std::cout << "Target tick error: " << tickError << std::endl;
-		m_tickError = Nz::Approach(m_tickError, m_tickError + tickError, std::abs(std::max(10, 1)));
-		std::cout << "New tick error: " << m_tickError << std::endl;*/
+		bwLog(GetLogger(), LogLevel::Warning, "Input not found for state tick {0}", stateTick);
 	}
 
 	void ClientMatch::InitializeRemoteConsole()
@@ -1687,22 +2238,79 @@ namespace bw
 
 	void ClientMatch::OnTick(bool lastTick)
 	{
+		auto tickScope = m_frameProfiler.Profile(m_frameProfilerSections.tick);
+		bwProfileZone("ClientMatch::OnTick");
+
+		m_clockSync.Update(GetTickDuration());
+
 		Nz::UInt16 estimatedServerTick = GetNetworkTick(EstimateServerTick());
 
+		// Switch rate at the same tick as the server, so inputs and predictions keep matching its ticks
+		if (m_pendingTickRateUpdate && !IsMoreRecent(m_pendingTickRateUpdate->applyTick, estimatedServerTick))
+		{
+			float tickDuration = m_pendingTickRateUpdate->tickDuration;
+			m_pendingTickRateUpdate.reset();
+
+			if (tickDuration != GetTickDuration())
+			{
+				bwLog(GetLogger(), LogLevel::Info, "server tick rate changed to {0:.0f}", 1.f / tickDuration);
+
+				SetTickDuration(tickDuration);
+				m_clockSync.SetTickDuration(tickDuration);
+			}
+		}
+
 		Nz::UInt16 handledTick = AdjustServerTick(estimatedServerTick); //< To handle network jitter
 
 		//bwLog(GetLogger(), LogLevel::Debug, "Executing packets for tick {}", handledTick);
 
-		auto it = m_tickedPackets.begin();
-		while (it != m_tickedPackets.end() && (it->serverTick == handledTick || IsMoreRecent(handledTick, it->serverTick)))
+		// Late packets (whose tick was already handled) are executed as soon as possible
+		for (TickPacket& tickPacket : m_lateTickPackets)
+		{
+			HandleTickPacket(std::move(tickPacket.content));
+			ReleaseTickPacket(std::move(tickPacket.content));
+		}
+
+		m_lateTickPackets.clear();
+
+		if (IsMoreRecent(handledTick, m_lastHandledTick))
+		{
+			// Handle every tick since the last one, this happens when the buffer depth shrinks or the server tick estimation jumps forward
+			std::size_t tickCount = std::min<std::size_t>(static_cast<Nz::UInt16>(handledTick - m_lastHandledTick), JitterBufferSize);
+			Nz::UInt16 firstTick = static_cast<Nz::UInt16>(handledTick - tickCount + 1);
+
+			for (std::size_t i = 0; i < tickCount; ++i)
+			{
+				Nz::UInt16 tick = static_cast<Nz::UInt16>(firstTick + i);
+
+				TickPacketBucket& bucket = m_tickPacketBuckets[tick % JitterBufferSize];
+				if (bucket.serverTick != tick)
+					continue;
+
+				for (TickPacketContent& packet : bucket.packets)
+				{
+					HandleTickPacket(std::move(packet));
+					ReleaseTickPacket(std::move(packet));
+				}
+
+				bucket.packets.clear();
+			}
+
+			m_lastHandledTick = handledTick;
+		}
+
+		m_jitterBufferTimer += GetTickDuration();
+		if (m_jitterBufferTimer >= 1.f)
 		{
-			HandleTickPacket(std::move(it->content));
-			++it;
+			m_jitterBufferTimer = 0.f;
+			UpdateJitterBufferDepth();
 		}
-		m_tickedPackets.erase(m_tickedPackets.begin(), it);
 
 		if (lastTick)
+		{
+			m_inputLatency.InsertValue(GetTickTimer());
 			SendInputs(estimatedServerTick, true);
+		}
 
 		if (m_gamemode)
 			m_gamemode->ExecuteCallback<GamemodeEvent::Tick>();
@@ -1716,15 +2324,13 @@ namespace bw
 		if (lastTick)
 		{
 			// Remember predicted ticks for improving over time
-			if (m_tickPredictions.size() >= static_cast<std::size_t>(std::ceil(2 / GetTickDuration()))) //< Remember at most 2s of inputs
-				m_tickPredictions.erase(m_tickPredictions.begin());
-
-			auto& prediction = m_tickPredictions.emplace_back();
+			auto& prediction = m_tickPredictions.Push(estimatedServerTick);
+			prediction.sendTime = Nz::GetElapsedMicroseconds();
 			prediction.serverTick = estimatedServerTick;
-			prediction.tickError = m_averageTickError.GetAverageValue();
+			prediction.tickError = m_clockSync.GetRoundedOffset();
 
-			// Remember inputs for reconciliation
-			PredictedInput& predictedInputs = m_predictedInputs.emplace_back();
+			// Remember inputs for reconciliation, the overwritten entry is reused
+			PredictedInput& predictedInputs = m_predictedInputs.Push(GetNetworkTick());
 			predictedInputs.inputTick = GetNetworkTick();
 
 			predictedInputs.inputs.resize(m_localPlayers.size());
@@ -1735,6 +2341,9 @@ namespace bw
 				auto& playerData = predictedInputs.inputs[i];
 				playerData.input = PlayerInputData{};
 				playerData.previousInput = PlayerInputData{};
+				playerData.movement.reset();
+				playerData.touchedEntities.clear();
+				playerData.weapons.clear();
 
 				if (controllerData.controlledEntity)
 				{
@@ -1751,6 +2360,15 @@ namespace bw
 
 						movementData.friction = playerPhysics.GetFriction(0);
 						movementData.surfaceVelocity = playerPhysics.GetSurfaceVelocity(0);
+
+						// Bodies touched by our entity have to be replayed along with it if a correction happens
+						playerMovement.EnableContactTracking(true);
+						for (const Ndk::EntityHandle& touchedEntity : playerMovement.GetTouchedEntities())
+						{
+							if (touchedEntity && touchedEntity->HasComponent<ClientMatchComponent>())
+								playerData.touchedEntities.push_back(touchedEntity->GetComponent<ClientMatchComponent>().GetUniqueId());
+						}
+						playerMovement.ClearTouchedEntities();
 					}
 
 					if (entity->HasComponent<InputComponent>())
@@ -1772,12 +2390,17 @@ namespace bw
 				}
 			}
 
+			std::size_t layerCount = 0;
 			for (auto& layer : m_layers)
 			{
 				if (layer->IsEnabled())
 				{
-					auto& layerData = predictedInputs.layers.emplace_back();
+					if (layerCount >= predictedInputs.layers.size())
+						predictedInputs.layers.emplace_back();
+
+					auto& layerData = predictedInputs.layers[layerCount++];
 					layerData.layerIndex = layer->GetLayerIndex();
+					layerData.entities.clear();
 
 					layer->ForEachLayerEntity([&](ClientLayerEntity& layerEntity)
 					{
@@ -1801,25 +2424,144 @@ namespace bw
 					});
 				}
 			}
+			predictedInputs.layers.resize(layerCount);
 		}
 	}
 
-	void ClientMatch::PushTickPacket(Nz::UInt16 tick, const TickPacketContent& packet)
+	void ClientMatch::PushTickPacket(Nz::UInt16 tick, TickPacketContent&& packet)
 	{
-		//bwLog(GetLogger(), LogLevel::Debug, "Execute server tick in {}", tick - m_expectedServerTick.value());
+		//bwLog(GetLogger(), LogLevel::Debug, "Received packet of tick #{}", tick);
 
-		TickPacket newPacket;
-		newPacket.serverTick = tick;
-		newPacket.content = packet;
+		if (m_demoRecorder)
+		{
+			std::visit([&](const auto& content)
+			{
+				m_demoRecorder->RecordTickPacket(tick, content);
+			}, packet);
+		}
 
-		//bwLog(GetLogger(), LogLevel::Debug, "Received packet of tick #{}", tick);
+		// Measure arrival delay only once per tick, as packets of the same tick are usually received together
+		if (IsMoreRecent(tick, m_lastArrivedTick))
+		{
+			Nz::UInt16 estimatedServerTick = GetNetworkTick(EstimateServerTick());
+			float arrivalDelay = static_cast<Nz::Int16>(estimatedServerTick - tick);
+
+			m_tickArrivalDelay.InsertValue(arrivalDelay);
+			m_tickArrivalDelaySquared.InsertValue(arrivalDelay * arrivalDelay);
+
+			m_lastArrivedTick = tick;
+		}
+
+		if (!IsMoreRecent(tick, m_lastHandledTick))
+		{
+			TickPacket newPacket;
+			newPacket.serverTick = tick;
+			newPacket.content = std::move(packet);
+
+			auto it = std::upper_bound(m_lateTickPackets.begin(), m_lateTickPackets.end(), newPacket, [](const TickPacket& a, const TickPacket& b)
+			{
+				return IsMoreRecent(b.serverTick, a.serverTick);
+			});
+
+			m_lateTickPackets.emplace(it, std::move(newPacket));
+			return;
+		}
+
+		if (static_cast<Nz::UInt16>(tick - m_lastHandledTick) > JitterBufferSize)
+		{
+			bwLog(GetLogger(), LogLevel::Warning, "received packet for tick #{0} which is too far in the future (last handled tick: #{1}), handling it now", tick, m_lastHandledTick);
+
+			TickPacket& newPacket = m_lateTickPackets.emplace_back();
+			newPacket.serverTick = tick;
+			newPacket.content = std::move(packet);
+			return;
+		}
+
+		TickPacketBucket& bucket = m_tickPacketBuckets[tick % JitterBufferSize];
+		if (bucket.serverTick != tick)
+		{
+			if (!bucket.packets.empty())
+			{
+				bwLog(GetLogger(), LogLevel::Warning, "dropping {0} unhandled packet(s) of tick #{1}", bucket.packets.size(), bucket.serverTick);
+
+				for (TickPacketContent& droppedPacket : bucket.packets)
+					ReleaseTickPacket(std::move(droppedPacket));
+
+				bucket.packets.clear();
+			}
+
+			bucket.serverTick = tick;
+		}
+
+		bucket.packets.push_back(std::move(packet));
+	}
+
+	void ClientMatch::ReconcilePredictedEntity(ClientLayer& layer, Nz::UInt32 serverId, Nz::UInt16 ownerPlayerIndex)
+	{
+		auto serverEntityOpt = layer.GetEntityByServerId(serverId);
+		if (!serverEntityOpt)
+			return;
+
+		ClientLayerEntity& serverEntity = serverEntityOpt->get();
+		if (!serverEntity.GetEntity()->HasComponent<ScriptComponent>())
+			return;
+
+		const std::string& entityClass = serverEntity.GetEntity()->GetComponent<ScriptComponent>().GetElement()->fullName;
 
-		auto it = std::upper_bound(m_tickedPackets.begin(), m_tickedPackets.end(), newPacket, [](const TickPacket& a, const TickPacket& b)
+		// Weapons create their projectiles in the same order on both sides, the oldest matching prediction is the one confirmed by the server
+		auto it = std::find_if(m_predictedEntities.begin(), m_predictedEntities.end(), [&](const PredictedEntity& predictedEntity)
 		{
-			return IsMoreRecent(b.serverTick, a.serverTick);
+			return predictedEntity.playerIndex == ownerPlayerIndex && predictedEntity.layerIndex == layer.GetLayerIndex() && predictedEntity.entityClass == entityClass;
 		});
 
-		m_tickedPackets.emplace(it, std::move(newPacket));
+		if (it == m_predictedEntities.end())
+			return;
+
+		EntityId predictedId = it->uniqueId;
+		m_predictedEntities.erase(it);
+
+		auto predictedEntityOpt = layer.GetEntity(predictedId);
+		if (!predictedEntityOpt)
+			return; //< already gone client-side
+
+		ClientLayerEntity& predictedEntity = predictedEntityOpt->get();
+
+		// Continue from the provisional state to prevent the projectile from jumping back by the round-trip, physics updates will correct it
+		if (predictedEntity.IsPhysical() && serverEntity.IsPhysical())
+			serverEntity.UpdateState(predictedEntity.GetPhysicalPosition(), predictedEntity.GetPhysicalRotation(), predictedEntity.GetLinearVelocity(), predictedEntity.GetAngularVelocity());
+		else
+			serverEntity.UpdateState(predictedEntity.GetPosition(), predictedEntity.GetRotation());
+
+		layer.DiscardEntity(predictedId);
+	}
+
+	void ClientMatch::ReleaseTickPacket(TickPacketContent&& packet)
+	{
+		std::visit([this](auto&& content)
+		{
+			using T = std::decay_t<decltype(content)>;
+			std::get<std::vector<T>>(m_tickPacketPool).push_back(std::move(content));
+		}, std::move(packet));
+	}
+
+	void ClientMatch::UpdateJitterBufferDepth()
+	{
+		// Size the buffer so that most packets (mean + two standard deviations) arrive before their tick gets handled
+		float meanDelay = m_tickArrivalDelay.GetAverageValue();
+		float variance = std::max(m_tickArrivalDelaySquared.GetAverageValue() - meanDelay * meanDelay, 0.f);
+
+		float targetDepth = std::ceil(meanDelay + 2.f * std::sqrt(variance));
+		Nz::UInt16 clampedDepth = static_cast<Nz::UInt16>(Nz::Clamp(targetDepth, float(MinJitterBufferDepth), float(MaxJitterBufferDepth)));
+
+		// Move one tick at a time to avoid visible jumps
+		Nz::UInt16 previousDepth = m_jitterBufferDepth;
+		if (clampedDepth > m_jitterBufferDepth)
+			m_jitterBufferDepth++;
+		else if (clampedDepth < m_jitterBufferDepth)
+			m_jitterBufferDepth--;
+
+		if (m_jitterBufferDepth != previousDepth)
+			bwLog(GetLogger(), LogLevel::Debug, "jitter buffer depth changed from {0} to {1} tick(s) (mean delay: {2}, deviation: {3})", previousDepth, m_jitterBufferDepth, meanDelay, std::sqrt(variance));
 	}
 
 	bool ClientMatch::SendInputs(Nz::UInt16 serverTick, bool force)
@@ -1843,22 +2585,55 @@ namespace bw
 			PlayerInputData input;
 
 			if (checkInputs)
+			{
 				input = controllerData.inputPoller->Poll(*this, controllerData.controlledEntity);
 
+				// Predict with the aim direction the server will receive
+				input.QuantizeAimDirection();
+			}
+
 			if (controllerData.lastInputData != input)
 			{
 				hasInputData = true;
 				controllerData.lastInputData = input;
-				m_inputPacket.inputs[i] = input;
 			}
-			else
-				m_inputPacket.inputs[i].reset();
+
+			m_inputPacket.inputs[i] = input;
 		}
 
 		if (hasInputData || force)
 		{
+			// Input packets are unreliable, send previous inputs again (only what changed from the more recent inputs) so the server can recover lost ones
+			m_inputPacket.previousInputs.clear();
+
+			const SentInputs* moreRecentInputs = nullptr;
+			for (const SentInputs& sentInputs : m_sentInputs)
+			{
+				const std::vector<PlayerInputData>& recentInputs = (moreRecentInputs) ? moreRecentInputs->inputs : m_inputPacket.inputs;
+				Nz::UInt16 recentInputTick = (moreRecentInputs) ? moreRecentInputs->inputTick : m_inputPacket.inputTick;
+
+				if (!IsMoreRecent(recentInputTick, sentInputs.inputTick) || Nz::UInt16(recentInputTick - sentInputs.inputTick) > std::numeric_limits<Nz::UInt8>::max())
+					break;
+
+				auto& previousInputs = m_inputPacket.previousInputs.emplace_back();
+				previousInputs.tickOffset = Nz::UInt8(recentInputTick - sentInputs.inputTick);
+				previousInputs.inputs.resize(recentInputs.size());
+				for (std::size_t i = 0; i < recentInputs.size(); ++i)
+				{
+					if (sentInputs.inputs[i] != recentInputs[i])
+						previousInputs.inputs[i] = sentInputs.inputs[i];
+				}
+
+				moreRecentInputs = &sentInputs;
+			}
+
 			m_session.SendPacket(m_inputPacket);
 
+			if (m_sentInputs.size() >= Packets::PlayersInput::MaxPreviousInputs)
+				m_sentInputs.pop_back();
+
+			m_sentInputs.push_front(SentInputs{ m_inputPacket.inputs, m_inputPacket.inputTick });
+
 			return true;
 		}
 		else
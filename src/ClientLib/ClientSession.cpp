@@ -23,8 +23,11 @@ namespace bw
 
 		m_bridge = std::move(sessionBridge);
 
-		m_onDisconnectedSlot.Connect(m_bridge->OnDisconnected, [this](Nz::UInt32 /*data*/)
+		m_disconnectionData = 0;
+		m_protocolFeatures = LegacyProtocolFeatures & SupportedProtocolFeatures; //< until the server tells us what it will use
+		m_onDisconnectedSlot.Connect(m_bridge->OnDisconnected, [this](Nz::UInt32 data)
 		{
+			m_disconnectionData = data;
 			OnSessionDisconnected();
 		});
 
@@ -33,6 +36,16 @@ namespace bw
 			HandleIncomingPacket(packet);
 		});
 
+		m_onIncomingTypedPacketSlot.Connect(m_bridge->OnIncomingTypedPacket, [this](TypedPacket& packet)
+		{
+			m_commandStore.HandleTypedPacket(this, packet);
+		});
+
+		OnAuthSuccess.Connect([this](ClientSession*, const Packets::AuthSuccess& packet)
+		{
+			m_protocolFeatures = packet.protocolFeatures;
+		});
+
 		OnNetworkStrings.Connect([this](ClientSession*, const Packets::NetworkStrings& packet)
 		{
 			if (packet.startId == 0)
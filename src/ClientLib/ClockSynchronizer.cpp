@@ -0,0 +1,133 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/ClockSynchronizer.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace bw
+{
+	ClockSynchronizer::ClockSynchronizer(float tickDuration, float initialOffset) :
+	m_nextSample(0),
+	m_drift(0.f),
+	m_offset(initialOffset),
+	m_targetOffset(initialOffset),
+	m_tickDuration(tickDuration)
+	{
+		m_samples.reserve(MaxSampleCount);
+		m_sortBuffer.reserve(MaxSampleCount);
+		m_validSamples.reserve(MaxSampleCount);
+	}
+
+	void ClockSynchronizer::InsertSample(float offset, Nz::UInt64 roundTripTime, Nz::UInt64 now)
+	{
+		Sample sample{ roundTripTime, now, offset };
+		if (m_samples.size() < MaxSampleCount)
+			m_samples.push_back(sample);
+		else
+			m_samples[m_nextSample] = sample;
+
+		m_nextSample = (m_nextSample + 1) % MaxSampleCount;
+
+		auto Median = [&]
+		{
+			assert(!m_sortBuffer.empty());
+
+			auto middle = m_sortBuffer.begin() + m_sortBuffer.size() / 2;
+			std::nth_element(m_sortBuffer.begin(), middle, m_sortBuffer.end());
+			return *middle;
+		};
+
+		// Samples which took much longer than usual to come back went through a congested path, their offset is unreliable
+		m_sortBuffer.clear();
+		for (const Sample& storedSample : m_samples)
+			m_sortBuffer.push_back(static_cast<float>(storedSample.roundTripTime));
+
+		float maxRoundTripTime = 2.f * Median() + m_tickDuration * 1'000'000.f;
+
+		m_validSamples.clear();
+		m_sortBuffer.clear();
+		for (const Sample& storedSample : m_samples)
+		{
+			if (storedSample.roundTripTime > maxRoundTripTime)
+				continue;
+
+			m_validSamples.push_back(&storedSample);
+			m_sortBuffer.push_back(storedSample.offset);
+		}
+
+		// Most recent sample is used if its round-trip time made every sample an outlier
+		if (m_validSamples.empty())
+		{
+			m_targetOffset = offset;
+			return;
+		}
+
+		float medianOffset = Median();
+
+		// Drift (offset change over time, such as from a slightly different tick rate) is the least-squares slope of offset over time
+		Nz::UInt64 firstTime = m_validSamples.front()->time;
+		double meanTime = 0.0;
+		double meanOffset = 0.0;
+		for (const Sample* validSample : m_validSamples)
+		{
+			firstTime = std::min(firstTime, validSample->time);
+			meanOffset += validSample->offset;
+		}
+
+		for (const Sample* validSample : m_validSamples)
+			meanTime += (validSample->time - firstTime) / 1'000'000.0;
+
+		meanTime /= m_validSamples.size();
+		meanOffset /= m_validSamples.size();
+
+		double covariance = 0.0;
+		double variance = 0.0;
+		for (const Sample* validSample : m_validSamples)
+		{
+			double time = (validSample->time - firstTime) / 1'000'000.0 - meanTime;
+			covariance += time * (validSample->offset - meanOffset);
+			variance += time * time;
+		}
+
+		// Only trust drift measured over a few seconds
+		constexpr std::size_t MinDriftSampleCount = 8;
+		constexpr double MinDriftVariance = 1.0;
+
+		if (m_validSamples.size() >= MinDriftSampleCount && variance / m_validSamples.size() >= MinDriftVariance)
+			m_drift = std::clamp(static_cast<float>(covariance / variance), -MaxDrift, MaxDrift);
+		else
+			m_drift = 0.f;
+
+		// Median offset is roughly the offset at the mean sample time, bring it to now
+		float elapsedSinceMean = static_cast<float>((now - firstTime) / 1'000'000.0 - meanTime);
+		m_targetOffset = medianOffset + m_drift * elapsedSinceMean;
+	}
+
+	void ClockSynchronizer::SetTickDuration(float tickDuration)
+	{
+		// The offset stays valid as both sides switch at the same tick, but drift was measured at the previous rate
+		m_samples.clear();
+		m_nextSample = 0;
+		m_drift = 0.f;
+		m_targetOffset = m_offset;
+		m_tickDuration = tickDuration;
+	}
+
+	void ClockSynchronizer::Update(float elapsedTime)
+	{
+		m_targetOffset += m_drift * elapsedTime;
+
+		// Large errors (first samples, lag spikes) are corrected at once, small ones progressively so the estimated server tick never jumps
+		float error = m_targetOffset - m_offset;
+		if (std::abs(error) > StepThreshold)
+			m_offset = m_targetOffset;
+		else
+		{
+			float maxSlew = MaxSlewPerTick * elapsedTime / m_tickDuration;
+			m_offset += std::clamp(error, -maxSlew, maxSlew);
+		}
+	}
+}
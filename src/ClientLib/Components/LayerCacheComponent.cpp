@@ -0,0 +1,121 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/Components/LayerCacheComponent.hpp>
+#include <Nazara/Graphics/ColorBackground.hpp>
+#include <Nazara/Graphics/Material.hpp>
+#include <NDK/Components/CameraComponent.hpp>
+#include <NDK/Components/GraphicsComponent.hpp>
+#include <NDK/Components/NodeComponent.hpp>
+#include <NDK/Systems/RenderSystem.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace bw
+{
+	LayerCacheComponent::LayerCacheComponent(int renderOrder) :
+	m_cacheWorld(std::make_unique<Ndk::World>(false)),
+	m_renderOrder(renderOrder),
+	m_isInvalidated(true)
+	{
+		Ndk::RenderSystem& renderSystem = m_cacheWorld->AddSystem<Ndk::RenderSystem>();
+		renderSystem.SetGlobalUp(Nz::Vector3f::Down());
+		renderSystem.SetDefaultBackground(Nz::ColorBackground::New(Nz::Color(0, 0, 0, 0)));
+
+		m_cameraEntity = m_cacheWorld->CreateEntity();
+		m_cameraEntity->AddComponent<Ndk::NodeComponent>();
+
+		auto& camera = m_cameraEntity->AddComponent<Ndk::CameraComponent>();
+		camera.SetProjectionType(Nz::ProjectionType_Orthogonal);
+		camera.SetZFar(20000.f);
+
+		m_sprite = Nz::Sprite::New();
+		m_sprite->SetMaterial(Nz::Material::New("Translucent2D"));
+		m_sprite->GetMaterial()->GetDiffuseSampler().SetFilterMode(Nz::SamplerFilter_Bilinear);
+		m_sprite->SetTextureCoords(Nz::Rectf(0.f, 1.f, 1.f, -1.f)); //< render textures are upside down
+	}
+
+	void LayerCacheComponent::OnAttached()
+	{
+		if (!m_entity->HasComponent<Ndk::GraphicsComponent>())
+			m_entity->AddComponent<Ndk::GraphicsComponent>();
+	}
+
+	void LayerCacheComponent::Refresh()
+	{
+		m_isInvalidated = false;
+
+		auto& gfxComponent = m_entity->GetComponent<Ndk::GraphicsComponent>();
+		gfxComponent.Clear();
+
+		// Compute layer bounds at full scale
+		m_rootNode.SetPosition(Nz::Vector2f::Zero());
+		m_rootNode.SetScale(Nz::Vector2f::Unit());
+
+		bool hasBounds = false;
+		Nz::Rectf bounds;
+		for (const Ndk::EntityHandle& entity : m_cacheWorld->GetEntities())
+		{
+			if (!entity->HasComponent<Ndk::GraphicsComponent>())
+				continue;
+
+			const Nz::Boxf& aabb = entity->GetComponent<Ndk::GraphicsComponent>().GetAABB();
+			if (!aabb.IsValid() || (aabb.width <= 0.f && aabb.height <= 0.f))
+				continue;
+
+			Nz::Rectf entityBounds(aabb.x, aabb.y, aabb.width, aabb.height);
+			if (hasBounds)
+				bounds.ExtendTo(entityBounds);
+			else
+			{
+				bounds = entityBounds;
+				hasBounds = true;
+			}
+		}
+
+		if (!hasBounds)
+			return;
+
+		bounds.x = std::floor(bounds.x);
+		bounds.y = std::floor(bounds.y);
+		bounds.width = std::ceil(bounds.width);
+		bounds.height = std::ceil(bounds.height);
+
+		float scaleFactor = std::min(1.f, float(MaxCacheSize) / std::max(bounds.width, bounds.height));
+		unsigned int width = std::max(static_cast<unsigned int>(std::ceil(bounds.width * scaleFactor)), 1U);
+		unsigned int height = std::max(static_cast<unsigned int>(std::ceil(bounds.height * scaleFactor)), 1U);
+
+		if (!m_texture || m_texture->GetWidth() != width || m_texture->GetHeight() != height)
+		{
+			m_texture = Nz::Texture::New();
+			m_texture->Create(Nz::ImageType_2D, Nz::PixelFormatType_RGBA8, width, height);
+
+			m_renderTexture.Destroy();
+			m_renderTexture.Create();
+			m_renderTexture.AttachTexture(Nz::AttachmentPoint_Color, 0, m_texture);
+			m_renderTexture.AttachBuffer(Nz::AttachmentPoint_DepthStencil, 0, Nz::PixelFormatType_Depth24Stencil8, width, height);
+
+			auto& camera = m_cameraEntity->GetComponent<Ndk::CameraComponent>();
+			camera.SetTarget(&m_renderTexture);
+			camera.SetSize(Nz::Vector2f(float(width), float(height)));
+
+			m_sprite->GetMaterial()->SetDiffuseMap(m_texture);
+		}
+
+		// Move layer content to the texture origin and render it once
+		m_rootNode.SetPosition(-bounds.GetPosition() * scaleFactor);
+		m_rootNode.SetScale(scaleFactor, scaleFactor);
+
+		m_cacheWorld->Update(0.f);
+
+		m_sprite->SetSize(bounds.width, bounds.height);
+
+		auto& nodeComponent = m_entity->GetComponent<Ndk::NodeComponent>();
+		nodeComponent.SetPosition(bounds.GetPosition());
+
+		gfxComponent.Attach(m_sprite, m_renderOrder);
+	}
+
+	Ndk::ComponentIndex LayerCacheComponent::componentIndex;
+}
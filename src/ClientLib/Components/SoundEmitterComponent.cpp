@@ -8,14 +8,14 @@
 
 namespace bw
 {
-	Nz::UInt32 SoundEmitterComponent::PlaySound(const Nz::SoundBufferRef& soundBuffer, const Nz::Vector3f& soundPosition, bool attachedToEntity, bool isLooping, bool isSpatialized)
+	Nz::UInt32 SoundEmitterComponent::PlaySound(const Nz::SoundBufferRef& soundBuffer, const Nz::Vector3f& soundPosition, bool attachedToEntity, bool isLooping, bool isSpatialized, float priority)
 	{
 		const Ndk::EntityHandle& entity = GetEntity();
 		if (!entity)
 			return SoundSystem::InvalidSoundId;
 
 		auto& soundSystem = entity->GetWorld()->GetSystem<SoundSystem>();
-		if (Nz::UInt32 soundId = soundSystem.PlaySound(soundBuffer, soundPosition, attachedToEntity, isLooping, isSpatialized); soundId != SoundSystem::InvalidSoundId)
+		if (Nz::UInt32 soundId = soundSystem.PlaySound(soundBuffer, soundPosition, attachedToEntity, isLooping, isSpatialized, priority); soundId != SoundSystem::InvalidSoundId)
 		{
 			m_sounds.insert(soundId);
 			return soundId;
@@ -4,6 +4,7 @@
 
 #include <ClientLib/Components/VisibleLayerComponent.hpp>
 #include <ClientLib/ClientMatch.hpp>
+#include <ClientLib/Components/LayerCacheComponent.hpp>
 #include <NDK/Components/NodeComponent.hpp>
 
 namespace bw
@@ -13,7 +14,7 @@ namespace bw
 		m_visibleLayers.clear();
 	}
 
-	void VisibleLayerComponent::RegisterLocalLayer(ClientLayer& localLayer, int renderOrder, const Nz::Vector2f& scale, const Nz::Vector2f& parallaxFactor)
+	void VisibleLayerComponent::RegisterLocalLayer(ClientLayer& localLayer, int renderOrder, const Nz::Vector2f& scale, const Nz::Vector2f& parallaxFactor, bool isStatic)
 	{
 		std::shared_ptr<VisibleLocalLayer> visibleLayer = std::make_shared<VisibleLocalLayer>();
 
@@ -37,12 +38,12 @@ namespace bw
 			});
 		}
 
-		RegisterLayer(std::move(visibleLayer), localLayer.GetClientMatch().GetCamera(), localLayer, renderOrder, scale, parallaxFactor);
+		RegisterLayer(std::move(visibleLayer), localLayer.GetClientMatch().GetCamera(), localLayer, renderOrder, scale, parallaxFactor, isStatic);
 	}
 
 	void VisibleLayerComponent::RegisterVisibleLayer(Camera& camera, VisualLayer& visualLayer, int renderOrder, const Nz::Vector2f& scale, const Nz::Vector2f& parallaxFactor)
 	{
-		RegisterLayer(std::make_shared<VisibleLayer>(), camera, visualLayer, renderOrder, scale, parallaxFactor);
+		RegisterLayer(std::make_shared<VisibleLayer>(), camera, visualLayer, renderOrder, scale, parallaxFactor, false);
 	}
 
 	void VisibleLayerComponent::CreateSound(VisibleLayer* layer, std::size_t soundIndex, ClientLayerSound& layerSound)
@@ -52,7 +53,15 @@ namespace bw
 
 	void VisibleLayerComponent::CreateVisual(VisibleLayer* layer, Nz::Int64 uniqueId, LayerVisualEntity& layerEntity)
 	{
-		layer->visualEntities.emplace(uniqueId, VisualEntity(m_renderWorld, layerEntity.CreateHandle(), layer->baseNode, layer->baseRenderOrder));
+		if (layer->cacheEntity)
+		{
+			auto& layerCache = layer->cacheEntity->GetComponent<LayerCacheComponent>();
+			layerCache.Invalidate();
+
+			layer->visualEntities.emplace(uniqueId, VisualEntity(layerCache.GetCacheWorld(), layerEntity.CreateHandle(), layerCache.GetRootNode(), layer->baseRenderOrder));
+		}
+		else
+			layer->visualEntities.emplace(uniqueId, VisualEntity(m_renderWorld, layerEntity.CreateHandle(), layer->baseNode, layer->baseRenderOrder));
 	}
 
 	void VisibleLayerComponent::DeleteSound(VisibleLayer* layer, std::size_t soundIndex, ClientLayerSound& /*layerSound*/)
@@ -63,9 +72,12 @@ namespace bw
 	void VisibleLayerComponent::DeleteVisual(VisibleLayer* layer, Nz::Int64 uniqueId)
 	{
 		layer->visualEntities.erase(uniqueId);
+
+		if (layer->cacheEntity)
+			layer->cacheEntity->GetComponent<LayerCacheComponent>().Invalidate();
 	}
 
-	void VisibleLayerComponent::RegisterLayer(std::shared_ptr<VisibleLayer> visibleLayer, Camera& camera, VisualLayer& visualLayer, int renderOrder, const Nz::Vector2f& scale, const Nz::Vector2f& parallaxFactor)
+	void VisibleLayerComponent::RegisterLayer(std::shared_ptr<VisibleLayer> visibleLayer, Camera& camera, VisualLayer& visualLayer, int renderOrder, const Nz::Vector2f& scale, const Nz::Vector2f& parallaxFactor, bool isStatic)
 	{
 		assert(visibleLayer);
 
@@ -75,12 +87,23 @@ namespace bw
 		visibleLayer->baseNode.SetScale(scale);
 		visibleLayer->baseRenderOrder = renderOrder;
 
+		// Static layers are rendered into a texture once (and again when their entities change), which is displayed as a single quad
+		if (isStatic)
+		{
+			visibleLayer->cacheEntity = m_renderWorld.CreateEntity();
+			visibleLayer->cacheEntity->AddComponent<Ndk::NodeComponent>().SetParent(visibleLayer->baseNode);
+			visibleLayer->cacheEntity->AddComponent<LayerCacheComponent>(renderOrder);
+		}
+
 		VisibleLayer* visibleLayerPtr = visibleLayer.get();
 		
 		visibleLayerPtr->onDisabled.Connect(visualLayer.OnDisabled, [=](VisualLayer*)
 		{
 			visibleLayerPtr->soundEntities.clear();
 			visibleLayerPtr->visualEntities.clear();
+
+			if (visibleLayerPtr->cacheEntity)
+				visibleLayerPtr->cacheEntity->GetComponent<LayerCacheComponent>().Invalidate();
 		});
 
 		visibleLayerPtr->onEnabled.Connect(visualLayer.OnEnabled, [=](VisualLayer* layer)
@@ -4,10 +4,13 @@
 
 #include <ClientLib/Console.hpp>
 #include <NDK/Console.hpp>
+#include <NDK/Widgets/TextAreaWidget.hpp>
 
 namespace bw
 {
-	Console::Console(Nz::RenderTarget* window, Ndk::Canvas* canvas)
+	Console::Console(Nz::RenderTarget* window, Ndk::Canvas* canvas) :
+	m_displayedLineCount(0),
+	m_historyLines(MaxHistoryLines)
 	{
 		m_widget = canvas->Add<Ndk::Console>();
 		m_widget->Hide();
@@ -31,12 +34,42 @@ namespace bw
 
 	void Console::Clear()
 	{
+		m_displayedLineCount = 0;
+		m_historyLines.Clear();
 		m_widget->Clear();
 	}
 
 	void Console::Print(const std::string& str, Nz::Color color)
 	{
-		m_widget->AddLine(str, color);
+		if (m_historyLines.IsFull())
+			m_historyLines.Dequeue();
+
+		m_historyLines.Enqueue(Line{ str, color });
+
+		// The widget appends lines but never forgets them, rebuild it from our bounded history once in a while
+		if (m_displayedLineCount >= MaxHistoryLines + TrimThreshold)
+		{
+			// Clearing the widget also resets its input, don't lose what the player is typing
+			Ndk::TextAreaWidget* input = m_widget->GetInput();
+			Nz::String inputText = input->GetText();
+
+			m_widget->Clear();
+			input->SetText(inputText);
+
+			std::size_t lineCount = m_historyLines.GetSize();
+			for (std::size_t i = 0; i < lineCount; ++i)
+			{
+				const Line& line = m_historyLines[i];
+				m_widget->AddLine(line.text, line.color);
+			}
+
+			m_displayedLineCount = lineCount;
+		}
+		else
+		{
+			m_widget->AddLine(str, color);
+			m_displayedLineCount++;
+		}
 	}
 
 	void Console::SetExecuteCallback(ExecuteCallback callback)
@@ -0,0 +1,214 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/ContentStore.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <CoreLib/Utils.hpp>
+#include <Nazara/Core/ByteArray.hpp>
+#include <Nazara/Core/File.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace bw
+{
+	ContentStore::ContentStore(const Logger& logger, std::filesystem::path storeDirectory, Nz::UInt64 maxSize) :
+	m_storeDirectory(std::move(storeDirectory)),
+	m_logger(logger),
+	m_maxSize(maxSize),
+	m_totalSize(0)
+	{
+		std::error_code ec;
+		if (!std::filesystem::is_directory(m_storeDirectory, ec))
+		{
+			if (!std::filesystem::create_directories(m_storeDirectory, ec))
+				bwLog(m_logger, LogLevel::Error, "failed to create content store directory {0}: {1}", m_storeDirectory.generic_u8string(), ec.message());
+
+			return;
+		}
+
+		// Objects are stored as <first two hex digits>/<hex checksum>, last write time is used as last use time
+		for (auto it = std::filesystem::recursive_directory_iterator(m_storeDirectory, ec); it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+		{
+			if (ec)
+				break;
+
+			if (!it->is_regular_file(ec))
+				continue;
+
+			std::string hexChecksum = it->path().filename().generic_u8string();
+			if (hexChecksum.size() != 40)
+				continue;
+
+			Entry& entry = m_entries[std::move(hexChecksum)];
+			entry.lastUse = it->last_write_time(ec);
+			entry.size = it->file_size(ec);
+
+			m_totalSize += entry.size;
+		}
+
+		bwLog(m_logger, LogLevel::Info, "content store contains {0} files ({1})", m_entries.size(), ByteToString(m_totalSize));
+
+		Evict();
+	}
+
+	bool ContentStore::Fetch(const Checksum& checksum, Nz::UInt64 expectedSize, const std::filesystem::path& outputPath)
+	{
+		std::string hexChecksum;
+		Entry* entry = FindEntry(checksum, expectedSize, &hexChecksum);
+		if (!entry)
+			return false;
+
+		std::filesystem::path directory = outputPath.parent_path();
+
+		std::error_code ec;
+		if (!directory.empty() && !std::filesystem::is_directory(directory, ec))
+			std::filesystem::create_directories(directory, ec);
+
+		if (!LinkOrCopy(GetObjectPath(hexChecksum), outputPath))
+			return false;
+
+		Touch(hexChecksum, *entry);
+		return true;
+	}
+
+	bool ContentStore::Fetch(const Checksum& checksum, Nz::UInt64 expectedSize, std::vector<Nz::UInt8>& content)
+	{
+		std::string hexChecksum;
+		Entry* entry = FindEntry(checksum, expectedSize, &hexChecksum);
+		if (!entry)
+			return false;
+
+		Nz::File file(GetObjectPath(hexChecksum).generic_u8string());
+		if (!file.Open(Nz::OpenMode_ReadOnly))
+			return false;
+
+		content.resize(entry->size);
+		if (file.Read(content.data(), content.size()) != content.size())
+			return false;
+
+		Touch(hexChecksum, *entry);
+		return true;
+	}
+
+	void ContentStore::Store(const Checksum& checksum, const std::filesystem::path& filePath)
+	{
+		if (m_maxSize == 0)
+			return;
+
+		std::string hexChecksum = Nz::ByteArray(checksum.data(), checksum.size()).ToHex().ToStdString();
+		if (m_entries.find(hexChecksum) != m_entries.end())
+			return;
+
+		std::error_code ec;
+		Nz::UInt64 fileSize = std::filesystem::file_size(filePath, ec);
+		if (ec || fileSize > m_maxSize)
+			return;
+
+		std::filesystem::path objectPath = GetObjectPath(hexChecksum);
+		std::filesystem::create_directories(objectPath.parent_path(), ec);
+
+		if (!LinkOrCopy(filePath, objectPath))
+		{
+			bwLog(m_logger, LogLevel::Warning, "failed to add {0} to content store", filePath.generic_u8string());
+			return;
+		}
+
+		auto it = m_entries.emplace(hexChecksum, Entry{}).first;
+		it.value().size = fileSize;
+		Touch(hexChecksum, it.value());
+
+		m_totalSize += fileSize;
+
+		Evict();
+	}
+
+	void ContentStore::Evict()
+	{
+		if (m_totalSize <= m_maxSize)
+			return;
+
+		std::vector<std::pair<std::string, std::filesystem::file_time_type>> entries;
+		entries.reserve(m_entries.size());
+		for (auto&& [hexChecksum, entry] : m_entries)
+			entries.emplace_back(hexChecksum, entry.lastUse);
+
+		std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+
+		for (const auto& [hexChecksum, lastUse] : entries)
+		{
+			if (m_totalSize <= m_maxSize)
+				break;
+
+			auto it = m_entries.find(hexChecksum);
+			assert(it != m_entries.end());
+
+			std::error_code ec;
+			std::filesystem::remove(GetObjectPath(hexChecksum), ec);
+			if (ec)
+			{
+				bwLog(m_logger, LogLevel::Warning, "failed to evict {0} from content store: {1}", hexChecksum, ec.message());
+				continue;
+			}
+
+			m_totalSize -= it->second.size;
+			m_entries.erase(it);
+		}
+	}
+
+	auto ContentStore::FindEntry(const Checksum& checksum, Nz::UInt64 expectedSize, std::string* hexChecksum) -> Entry*
+	{
+		std::string hex = Nz::ByteArray(checksum.data(), checksum.size()).ToHex().ToStdString();
+
+		auto it = m_entries.find(hex);
+		if (it == m_entries.end() || it->second.size != expectedSize)
+			return nullptr;
+
+		// Files may have been altered outside of the game, don't trust them blindly
+		std::filesystem::path objectPath = GetObjectPath(hex);
+		Nz::ByteArray fileChecksum = Nz::File::ComputeHash(Nz::HashType_SHA1, objectPath.generic_u8string());
+		if (fileChecksum.GetSize() != checksum.size() || std::memcmp(fileChecksum.GetConstBuffer(), checksum.data(), checksum.size()) != 0)
+		{
+			bwLog(m_logger, LogLevel::Warning, "content store file {0} is corrupted, removing it", hex);
+
+			std::error_code ec;
+			std::filesystem::remove(objectPath, ec);
+
+			m_totalSize -= it->second.size;
+			m_entries.erase(it);
+			return nullptr;
+		}
+
+		if (hexChecksum)
+			*hexChecksum = std::move(hex);
+
+		return &it.value();
+	}
+
+	std::filesystem::path ContentStore::GetObjectPath(const std::string& hexChecksum) const
+	{
+		return m_storeDirectory / hexChecksum.substr(0, 2) / hexChecksum;
+	}
+
+	void ContentStore::Touch(const std::string& hexChecksum, Entry& entry)
+	{
+		entry.lastUse = std::filesystem::file_time_type::clock::now();
+
+		std::error_code ec;
+		std::filesystem::last_write_time(GetObjectPath(hexChecksum), entry.lastUse, ec);
+	}
+
+	bool ContentStore::LinkOrCopy(const std::filesystem::path& from, const std::filesystem::path& to)
+	{
+		std::error_code ec;
+		std::filesystem::remove(to, ec);
+
+		// Hard links share storage between the store and server caches, fallback on a copy when unsupported (FAT, different volumes)
+		std::filesystem::create_hard_link(from, to, ec);
+		if (!ec)
+			return true;
+
+		return std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, ec) && !ec;
+	}
+}
@@ -0,0 +1,45 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/DemoCommandStore.hpp>
+
+namespace bw
+{
+	DemoCommandStore::DemoCommandStore(const Logger& logger) :
+	CommandStore(logger)
+	{
+#define IncomingCommand(Type) RegisterIncomingCommand<Packets::Type>(#Type, [](DemoPacket& target, Packets::Type&& packet) \
+{ \
+	target = std::move(packet); \
+})
+
+		// Incoming commands
+		IncomingCommand(ChatMessage);
+		IncomingCommand(CreateEntities);
+		IncomingCommand(DeleteEntities);
+		IncomingCommand(DisableLayer);
+		IncomingCommand(EnableLayer);
+		IncomingCommand(EntitiesAnimation);
+		IncomingCommand(EntitiesDeath);
+		IncomingCommand(EntitiesInputs);
+		IncomingCommand(EntitiesPhysics);
+		IncomingCommand(EntitiesScale);
+		IncomingCommand(EntitiesWeapon);
+		IncomingCommand(HealthUpdate);
+		IncomingCommand(MapReset);
+		IncomingCommand(MatchData);
+		IncomingCommand(MatchState);
+		IncomingCommand(NetworkStrings);
+		IncomingCommand(PlayerControlEntity);
+		IncomingCommand(PlayerJoined);
+		IncomingCommand(PlayerLeaving);
+		IncomingCommand(PlayerNameUpdate);
+		IncomingCommand(PlayerPingUpdate);
+		IncomingCommand(RecycleEntities);
+		IncomingCommand(RespawnEntities);
+		IncomingCommand(ScriptPacket);
+
+#undef IncomingCommand
+	}
+}
@@ -0,0 +1,231 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/DemoReader.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <CoreLib/Protocol/CompressedInteger.hpp>
+#include <Nazara/Core/ErrorFlags.hpp>
+#include <Nazara/Core/File.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace bw
+{
+	DemoReader::DemoReader(const std::filesystem::path& filePath, const Logger& logger) :
+	m_commandStore(logger),
+	m_lastTick(0)
+	{
+		Nz::File demoFile(filePath.generic_u8string(), Nz::OpenMode_ReadOnly);
+		if (!demoFile.IsOpen())
+			throw std::runtime_error("failed to open demo file " + filePath.generic_u8string());
+
+		// Load the whole file at once, seeking back and forth is cheap this way
+		m_content.resize(demoFile.GetSize());
+		if (demoFile.Read(m_content.data(), m_content.size()) != m_content.size())
+			throw std::runtime_error("failed to read demo file");
+
+		m_contentView.emplace(m_content.data(), m_content.size());
+
+		m_stream.SetStream(&m_contentView.value());
+		m_stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		std::array<char, 8> signature;
+		if (m_stream.Read(signature.data(), signature.size()) != signature.size() || std::memcmp(signature.data(), "Burgdemo", signature.size()) != 0)
+			throw std::runtime_error("not a valid demo file");
+
+		Nz::UInt16 fileVersion;
+		m_stream >> fileVersion;
+
+		if (fileVersion != DemoRecorder::FileVersion)
+			throw std::runtime_error("unsupported demo file version " + std::to_string(fileVersion));
+
+		Nz::UInt64 indexOffset;
+		m_stream >> m_tickDuration;
+		m_stream >> indexOffset;
+
+		DemoPacket matchData = ReadPacketData();
+		if (!std::holds_alternative<Packets::MatchData>(matchData))
+			throw std::runtime_error("demo file doesn't start with match data");
+
+		m_matchData = std::move(std::get<Packets::MatchData>(matchData));
+		m_eventBegin = m_contentView->GetCursorPos();
+
+		if (indexOffset >= m_eventBegin && indexOffset < m_content.size())
+		{
+			m_contentView->SetCursorPos(indexOffset);
+
+			CompressedUnsigned<Nz::UInt64> lastTick;
+			CompressedUnsigned<Nz::UInt32> keyframeCount;
+			m_stream >> lastTick >> keyframeCount;
+
+			m_lastTick = lastTick;
+
+			m_index.resize(keyframeCount);
+			for (IndexEntry& entry : m_index)
+			{
+				CompressedUnsigned<Nz::UInt64> demoTick;
+				CompressedUnsigned<Nz::UInt64> fileOffset;
+				m_stream >> demoTick >> fileOffset;
+
+				entry.demoTick = demoTick;
+				entry.fileOffset = fileOffset;
+			}
+
+			m_eventEnd = indexOffset;
+		}
+		else
+		{
+			bwLog(logger, LogLevel::Warning, "demo {0} has no index (recording was interrupted), rebuilding it", filePath.generic_u8string());
+			BuildIndex();
+		}
+
+		Rewind();
+	}
+
+	auto DemoReader::FindKeyframe(Nz::UInt64 demoTick) const -> const IndexEntry*
+	{
+		auto it = std::upper_bound(m_index.begin(), m_index.end(), demoTick, [](Nz::UInt64 tick, const IndexEntry& entry)
+		{
+			return tick < entry.demoTick;
+		});
+
+		if (it == m_index.begin())
+			return nullptr;
+
+		return &*std::prev(it);
+	}
+
+	auto DemoReader::PeekEvent() -> std::optional<Event>
+	{
+		Nz::UInt64 cursorPos = m_contentView->GetCursorPos();
+		if (cursorPos >= m_eventEnd)
+			return std::nullopt;
+
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		Event event = ReadEventHeader();
+		m_contentView->SetCursorPos(cursorPos);
+
+		return event;
+	}
+
+	void DemoReader::ReadKeyframe(std::vector<DemoPacket>& packets)
+	{
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		Event event = ReadEventHeader();
+		if (event.type != EventType::Keyframe)
+			throw std::runtime_error("unexpected demo event (file is corrupted)");
+
+		Nz::UInt64 keyframeEnd = m_contentView->GetCursorPos() + ReadSize();
+		while (m_contentView->GetCursorPos() < keyframeEnd)
+			packets.push_back(ReadPacketData());
+	}
+
+	DemoPacket DemoReader::ReadPacket()
+	{
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		Event event = ReadEventHeader();
+		if (event.type != EventType::Packet)
+			throw std::runtime_error("unexpected demo event (file is corrupted)");
+
+		return ReadPacketData();
+	}
+
+	void DemoReader::Rewind()
+	{
+		m_contentView->SetCursorPos(m_eventBegin);
+	}
+
+	void DemoReader::SeekToKeyframe(const IndexEntry& keyframe)
+	{
+		if (keyframe.fileOffset < m_eventBegin || keyframe.fileOffset >= m_eventEnd)
+			throw std::runtime_error("invalid keyframe offset (file is corrupted)");
+
+		m_contentView->SetCursorPos(keyframe.fileOffset);
+	}
+
+	void DemoReader::SkipEvent()
+	{
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		ReadEventHeader();
+
+		// Both packets and keyframes are prefixed by their size
+		Nz::UInt32 size = ReadSize();
+		m_contentView->SetCursorPos(m_contentView->GetCursorPos() + size);
+	}
+
+	void DemoReader::BuildIndex()
+	{
+		m_eventEnd = m_content.size();
+
+		Nz::UInt64 eventOffset = m_eventBegin;
+		m_contentView->SetCursorPos(eventOffset);
+
+		try
+		{
+			std::optional<Event> event;
+			while ((event = PeekEvent()))
+			{
+				SkipEvent();
+
+				if (event->type == EventType::Keyframe)
+					m_index.push_back({ event->demoTick, eventOffset });
+
+				m_lastTick = std::max(m_lastTick, event->demoTick);
+				eventOffset = m_contentView->GetCursorPos();
+			}
+		}
+		catch (const std::exception&)
+		{
+			// Last event was partially written
+			m_eventEnd = eventOffset;
+		}
+	}
+
+	auto DemoReader::ReadEventHeader() -> Event
+	{
+		Nz::UInt8 eventType;
+		CompressedUnsigned<Nz::UInt64> demoTick;
+		m_stream >> eventType >> demoTick;
+
+		if (eventType > static_cast<Nz::UInt8>(EventType::Packet))
+			throw std::runtime_error("unknown demo event (file is corrupted)");
+
+		return Event{ demoTick, static_cast<EventType>(eventType) };
+	}
+
+	DemoPacket DemoReader::ReadPacketData()
+	{
+		Nz::UInt32 dataSize = ReadSize();
+
+		Nz::UInt64 cursorPos = m_contentView->GetCursorPos();
+		m_contentView->SetCursorPos(cursorPos + dataSize);
+
+		Nz::NetPacket packet(0, &m_content[cursorPos], dataSize);
+
+		DemoPacket demoPacket;
+		if (!m_commandStore.UnserializePacket(demoPacket, packet))
+			throw std::runtime_error("failed to unserialize demo packet (file is corrupted)");
+
+		return demoPacket;
+	}
+
+	Nz::UInt32 DemoReader::ReadSize()
+	{
+		CompressedUnsigned<Nz::UInt32> size;
+		m_stream >> size;
+
+		if (m_contentView->GetCursorPos() + size > m_content.size())
+			throw std::runtime_error("truncated demo file");
+
+		return size;
+	}
+}
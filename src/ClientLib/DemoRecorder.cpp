@@ -0,0 +1,150 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/DemoRecorder.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace bw
+{
+	DemoRecorder::DemoRecorder(const std::filesystem::path& filePath, const Logger& logger, const Packets::MatchData& matchData, const Packets::NetworkStrings& networkStrings, Nz::UInt64 keyframeInterval) :
+	m_mirror(logger),
+	m_stream(&m_buffer, Nz::OpenMode_WriteOnly),
+	m_file(filePath.generic_u8string(), Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate),
+	m_referenceTick(matchData.currentTick),
+	m_flushedSize(0),
+	m_keyframeInterval(std::max<Nz::UInt64>(keyframeInterval, 1)),
+	m_lastDemoTick(0),
+	m_nextKeyframeTick(m_keyframeInterval)
+	{
+		if (!m_file.IsOpen())
+			throw std::runtime_error("failed to open demo file " + filePath.generic_u8string());
+
+		m_stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		m_stream.Write("Burgdemo", 8);
+		m_stream << FileVersion;
+		m_stream << matchData.tickDuration;
+		m_stream << Nz::UInt64(0); //< index offset, written when the recording ends
+
+		Nz::NetPacket matchDataPacket;
+		PlayerCommandStore::SerializePacket(matchDataPacket, matchData);
+		WritePacketData(m_stream, matchDataPacket);
+
+		m_mirror.HandlePacket(matchData, 0);
+
+		// Strings received before the match started
+		WritePacket(0, networkStrings);
+	}
+
+	DemoRecorder::~DemoRecorder()
+	{
+		// The index allows seeking without reading the whole demo first, readers rebuild it if the client didn't get there (crash)
+		Nz::UInt64 indexOffset = GetFileOffset();
+
+		m_stream << CompressedUnsigned<Nz::UInt64>(m_lastDemoTick);
+		m_stream << CompressedUnsigned<Nz::UInt32>(Nz::UInt32(m_index.size()));
+		for (const IndexEntry& entry : m_index)
+		{
+			m_stream << CompressedUnsigned<Nz::UInt64>(entry.demoTick);
+			m_stream << CompressedUnsigned<Nz::UInt64>(entry.fileOffset);
+		}
+
+		Flush();
+
+		Nz::ByteArray indexOffsetData;
+		Nz::ByteStream indexOffsetStream(&indexOffsetData, Nz::OpenMode_WriteOnly);
+		indexOffsetStream.SetDataEndianness(Nz::Endianness_LittleEndian);
+		indexOffsetStream << indexOffset;
+
+		m_file.SetCursorPos(IndexOffsetPosition);
+		m_file.Write(indexOffsetData.GetConstBuffer(), indexOffsetData.GetSize());
+	}
+
+	void DemoRecorder::Flush()
+	{
+		if (m_buffer.IsEmpty())
+			return;
+
+		m_file.Write(m_buffer.GetConstBuffer(), m_buffer.GetSize());
+		m_flushedSize += m_buffer.GetSize();
+
+		m_buffer.Clear();
+		m_stream.GetStream()->SetCursorPos(0);
+	}
+
+	Nz::UInt64 DemoRecorder::ToDemoTick(Nz::UInt16 tick)
+	{
+		// Network ticks wrap around, demo ticks count from the beginning of the recording
+		Nz::Int16 tickDelta = static_cast<Nz::Int16>(Nz::UInt16(tick - m_referenceTick));
+		if (tickDelta <= 0)
+		{
+			Nz::UInt64 tickAge = static_cast<Nz::UInt64>(-tickDelta);
+			return (tickAge < m_lastDemoTick) ? m_lastDemoTick - tickAge : 0;
+		}
+
+		m_referenceTick = tick;
+		m_lastDemoTick += tickDelta;
+
+		return m_lastDemoTick;
+	}
+
+	void DemoRecorder::WriteKeyframe(Nz::UInt64 demoTick)
+	{
+		m_index.push_back({ demoTick, GetFileOffset() });
+		m_nextKeyframeTick = demoTick + m_keyframeInterval;
+
+		MatchStateMirror::CatchUpPackets catchUpPackets;
+		m_mirror.BuildCatchUpPackets(catchUpPackets);
+
+		// Keyframe packets are serialized first so their size can precede them, allowing readers to skip keyframes
+		Nz::ByteArray keyframeData;
+		Nz::ByteStream keyframeStream(&keyframeData, Nz::OpenMode_WriteOnly);
+		keyframeStream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		auto WriteKeyframePacket = [&](const auto& packet)
+		{
+			Nz::NetPacket data;
+			PlayerCommandStore::SerializePacket(data, packet);
+
+			WritePacketData(keyframeStream, data);
+		};
+
+		Packets::NetworkStrings networkStrings;
+		networkStrings.startId = 0;
+		networkStrings.strings = m_mirror.GetNetworkStrings();
+		WriteKeyframePacket(networkStrings);
+
+		for (const auto& playerJoined : catchUpPackets.players)
+			WriteKeyframePacket(playerJoined);
+
+		for (const auto& enableLayer : catchUpPackets.enabledLayers)
+			WriteKeyframePacket(enableLayer);
+
+		if (!catchUpPackets.recycledEntities.entities.empty())
+			WriteKeyframePacket(catchUpPackets.recycledEntities);
+
+		if (!catchUpPackets.entitiesPhysics.entities.empty())
+			WriteKeyframePacket(catchUpPackets.entitiesPhysics);
+
+		if (!catchUpPackets.entitiesWeapon.entities.empty())
+			WriteKeyframePacket(catchUpPackets.entitiesWeapon);
+
+		for (const auto& playerControlEntity : catchUpPackets.playerControlledEntities)
+			WriteKeyframePacket(playerControlEntity);
+
+		m_stream << static_cast<Nz::UInt8>(EventType::Keyframe);
+		m_stream << CompressedUnsigned<Nz::UInt64>(demoTick);
+		m_stream << CompressedUnsigned<Nz::UInt32>(Nz::UInt32(keyframeData.GetSize()));
+		m_stream.Write(keyframeData.GetConstBuffer(), keyframeData.GetSize());
+	}
+
+	void DemoRecorder::WritePacketData(Nz::ByteStream& stream, const Nz::NetPacket& packet)
+	{
+		std::size_t dataSize = packet.GetDataSize();
+
+		stream << CompressedUnsigned<Nz::UInt32>(static_cast<Nz::UInt32>(dataSize));
+		stream.Write(static_cast<const Nz::UInt8*>(packet.GetConstData()) + Nz::NetPacket::HeaderSize, dataSize);
+	}
+}
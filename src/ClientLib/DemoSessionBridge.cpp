@@ -0,0 +1,335 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/DemoSessionBridge.hpp>
+#include <CoreLib/EntityId.hpp>
+#include <CoreLib/MatchClientSession.hpp>
+#include <CoreLib/MatchClientVisibility.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <tsl/hopscotch_map.h>
+#include <algorithm>
+#include <type_traits>
+
+namespace bw
+{
+	DemoSessionBridge::DemoSessionBridge(const std::filesystem::path& filePath, const Logger& logger) :
+	SessionBridge(nullptr),
+	m_reader(filePath, logger),
+	m_logger(logger),
+	m_wireTick(m_reader.GetMatchData().currentTick),
+	m_sentStringCount(0),
+	m_demoTick(0),
+	m_tickAccumulator(0.f),
+	m_isAuthenticated(false),
+	m_isPaused(false),
+	m_isStreaming(false)
+	{
+		m_mirror.emplace(logger);
+		m_mirror->HandlePacket(m_reader.GetMatchData(), 0);
+
+		HandleConnection(0);
+	}
+
+	void DemoSessionBridge::Disconnect()
+	{
+		// Nothing to notify, the session drops its bridge
+		m_isStreaming = false;
+	}
+
+	bool DemoSessionBridge::IsLocal() const
+	{
+		return true;
+	}
+
+	void DemoSessionBridge::QueryInfo(std::function<void(const SessionInfo& info)> callback) const
+	{
+		SessionInfo info;
+		info.ping = 0;
+		info.timeSinceLastReceive = 0;
+		info.totalByteReceived = 0;
+		info.totalByteSent = 0;
+		info.totalPacketLost = 0;
+		info.totalPacketReceived = 0;
+		info.totalPacketSent = 0;
+
+		callback(info);
+	}
+
+	void DemoSessionBridge::Seek(Nz::UInt64 demoTick)
+	{
+		if (!m_isStreaming)
+			return;
+
+		demoTick = std::min(demoTick, GetLastTick());
+
+		try
+		{
+			const DemoReader::IndexEntry* keyframe = m_reader.FindKeyframe(demoTick);
+
+			// Every packet sent while seeking is stamped with the current tick, so the client handles them in order after the ones it already got
+			if (demoTick >= m_demoTick && (!keyframe || keyframe->demoTick <= m_demoTick))
+			{
+				// No keyframe in between, sending the packets up to the target is enough
+				m_demoTick = demoTick;
+				ReleaseEvents(demoTick, demoTick);
+				return;
+			}
+
+			std::vector<DemoPacket> keyframePackets;
+			if (keyframe)
+			{
+				m_reader.SeekToKeyframe(*keyframe);
+				m_reader.ReadKeyframe(keyframePackets);
+			}
+			else
+				m_reader.Rewind();
+
+			m_demoTick = demoTick;
+
+			SendKeyframe(std::move(keyframePackets));
+			ReleaseEvents(demoTick, demoTick);
+		}
+		catch (const std::exception& e)
+		{
+			bwLog(m_logger, LogLevel::Error, "demo seek failed: {0}", e.what());
+
+			m_isStreaming = false;
+			HandleDisconnection(0);
+		}
+	}
+
+	void DemoSessionBridge::SendPacket(Nz::UInt8 /*channelId*/, Nz::ENetPacketFlags /*flags*/, Nz::NetPacket&& /*packet*/)
+	{
+		// Client sessions always send typed packets to this bridge (see SupportsTypedPackets)
+	}
+
+	void DemoSessionBridge::SendTypedPacket(TypedPacket&& packet)
+	{
+		// Other client packets (chat, console commands, ...) have no meaning during playback
+		if (packet.packetId == static_cast<std::size_t>(Packets::Auth::Type))
+			HandleClientPacket(*static_cast<const Packets::Auth*>(packet.data.get()));
+		else if (packet.packetId == static_cast<std::size_t>(Packets::DownloadClientFileRequest::Type))
+			HandleClientPacket(*static_cast<const Packets::DownloadClientFileRequest*>(packet.data.get()));
+		else if (packet.packetId == static_cast<std::size_t>(Packets::PlayersInput::Type))
+			HandleClientPacket(*static_cast<const Packets::PlayersInput*>(packet.data.get()));
+		else if (packet.packetId == static_cast<std::size_t>(Packets::Ready::Type))
+			HandleClientPacket(*static_cast<const Packets::Ready*>(packet.data.get()));
+	}
+
+	bool DemoSessionBridge::SupportsTypedPackets() const
+	{
+		return true;
+	}
+
+	void DemoSessionBridge::Update(float elapsedTime)
+	{
+		float tickDuration = m_reader.GetTickDuration();
+
+		// Time keeps flowing while paused, the demo tick stops
+		m_tickAccumulator += elapsedTime;
+		while (m_tickAccumulator >= tickDuration)
+		{
+			m_tickAccumulator -= tickDuration;
+			m_wireTick++;
+
+			if (m_isStreaming && !m_isPaused && m_demoTick < GetLastTick())
+				m_demoTick++;
+		}
+
+		if (!m_isStreaming)
+			return;
+
+		try
+		{
+			ReleaseEvents(m_demoTick);
+		}
+		catch (const std::exception& e)
+		{
+			bwLog(m_logger, LogLevel::Error, "demo playback failed: {0}", e.what());
+
+			m_isStreaming = false;
+			HandleDisconnection(0);
+		}
+	}
+
+	void DemoSessionBridge::HandleClientPacket(const Packets::Auth& /*packet*/)
+	{
+		if (m_isAuthenticated)
+			return;
+
+		m_isAuthenticated = true;
+
+		// Demos are watched as a spectator, whatever players the client asked for
+		SendToClient(Packets::AuthSuccess{});
+
+		Packets::MatchData matchData = m_reader.GetMatchData();
+		matchData.currentTick = m_wireTick;
+		SendToClient(std::move(matchData));
+	}
+
+	void DemoSessionBridge::HandleClientPacket(const Packets::DownloadClientFileRequest& packet)
+	{
+		// Demos don't embed the match files, clients should already have them (from the recording) or get them from FastDownloadURLs
+		bwLog(m_logger, LogLevel::Warning, "{0} is not available from the demo", packet.path);
+
+		Packets::DownloadClientFileResponse response;
+		response.content = Packets::DownloadClientFileResponse::Failure{ Packets::DownloadClientFileResponse::Error::FileNotFound };
+		SendToClient(std::move(response));
+	}
+
+	void DemoSessionBridge::HandleClientPacket(const Packets::PlayersInput& packet)
+	{
+		if (!m_isStreaming)
+			return;
+
+		// There are no inputs to apply, but the client still synchronizes its clock with this
+		Nz::UInt16 adjustedTick = m_wireTick + MatchClientSession::InputTimingTolerance;
+
+		Packets::InputTimingCorrection correctionPacket;
+		correctionPacket.serverTick = packet.estimatedServerTick;
+		correctionPacket.tickError = static_cast<Nz::Int16>(Nz::UInt16(packet.estimatedServerTick - adjustedTick));
+
+		SendToClient(std::move(correctionPacket));
+	}
+
+	void DemoSessionBridge::HandleClientPacket(const Packets::Ready& /*packet*/)
+	{
+		if (!m_isAuthenticated || m_isStreaming)
+			return;
+
+		m_isStreaming = true;
+	}
+
+	void DemoSessionBridge::ReleaseEvents(Nz::UInt64 lastTick, Nz::UInt64 firstTick)
+	{
+		std::optional<DemoReader::Event> event;
+		while ((event = m_reader.PeekEvent()) && event->demoTick <= lastTick)
+		{
+			if (event->type == DemoReader::EventType::Packet)
+				SendToClient(m_reader.ReadPacket(), ToWireTick(std::max(event->demoTick, firstTick)));
+			else
+				m_reader.SkipEvent(); //< keyframes are only used when seeking
+		}
+	}
+
+	void DemoSessionBridge::SendKeyframe(std::vector<DemoPacket>&& keyframePackets)
+	{
+		// Bring the client back to an empty match (as when it joined), players still there in the keyframe are kept rather than leaving and joining again
+		MatchStateMirror::CatchUpPackets currentState;
+		m_mirror->BuildCatchUpPackets(currentState);
+
+		for (const auto& enableLayer : currentState.enabledLayers)
+		{
+			Packets::DisableLayer disableLayer;
+			disableLayer.stateTick = m_wireTick;
+			disableLayer.layerIndex = enableLayer.layerIndex;
+
+			SendToClient(std::move(disableLayer));
+		}
+
+		tsl::hopscotch_map<Nz::UInt16, const Packets::PlayerJoined*> keyframePlayers;
+		for (const DemoPacket& packet : keyframePackets)
+		{
+			if (const Packets::PlayerJoined* playerJoined = std::get_if<Packets::PlayerJoined>(&packet))
+				keyframePlayers.emplace(playerJoined->playerIndex, playerJoined);
+		}
+
+		tsl::hopscotch_map<Nz::UInt16, std::string> keptPlayers;
+		for (const auto& player : currentState.players)
+		{
+			auto it = keyframePlayers.find(player.playerIndex);
+			if (it == keyframePlayers.end())
+			{
+				Packets::PlayerLeaving playerLeaving;
+				playerLeaving.playerIndex = player.playerIndex;
+
+				SendToClient(std::move(playerLeaving));
+				continue;
+			}
+
+			keptPlayers.emplace(player.playerIndex, player.playerName);
+		}
+
+		for (const auto& playerControlEntity : currentState.playerControlledEntities)
+		{
+			if (keptPlayers.find(playerControlEntity.playerIndex) == keptPlayers.end())
+				continue;
+
+			Packets::PlayerControlEntity releaseEntity;
+			releaseEntity.playerIndex = playerControlEntity.playerIndex;
+			releaseEntity.controlledEntityId = static_cast<Nz::UInt64>(InvalidEntityId);
+
+			SendToClient(std::move(releaseEntity));
+		}
+
+		m_mirror.emplace(m_logger);
+		m_mirror->HandlePacket(m_reader.GetMatchData(), 0);
+
+		for (DemoPacket& packet : keyframePackets)
+		{
+			if (Packets::PlayerJoined* playerJoined = std::get_if<Packets::PlayerJoined>(&packet))
+			{
+				auto it = keptPlayers.find(playerJoined->playerIndex);
+				if (it != keptPlayers.end())
+				{
+					m_mirror->HandlePacket(*playerJoined, 0);
+
+					if (it->second != playerJoined->playerName)
+					{
+						Packets::PlayerNameUpdate nameUpdate;
+						nameUpdate.playerIndex = playerJoined->playerIndex;
+						nameUpdate.newName = playerJoined->playerName;
+
+						SendToClient(std::move(nameUpdate));
+					}
+
+					continue;
+				}
+			}
+			else if (Packets::NetworkStrings* networkStrings = std::get_if<Packets::NetworkStrings>(&packet))
+			{
+				// Keyframes hold every string, network strings are never removed so the client only needs the ones it doesn't know yet
+				m_mirror->HandlePacket(*networkStrings, 0);
+
+				if (networkStrings->strings.size() <= m_sentStringCount)
+					continue;
+
+				networkStrings->strings.erase(networkStrings->strings.begin(), networkStrings->strings.begin() + m_sentStringCount);
+				networkStrings->startId = m_sentStringCount;
+
+				m_sentStringCount += Nz::UInt32(networkStrings->strings.size());
+				SendToClient(std::move(*networkStrings));
+				continue;
+			}
+
+			SendToClient(std::move(packet), m_wireTick);
+		}
+	}
+
+	void DemoSessionBridge::SendToClient(DemoPacket&& packet, Nz::UInt16 wireTick)
+	{
+		std::visit([&](auto&& arg)
+		{
+			using T = std::decay_t<decltype(arg)>;
+
+			if constexpr (!std::is_same_v<T, std::monostate> && !std::is_same_v<T, Packets::MatchData>)
+			{
+				if constexpr (Detail::HasStateTick<T>::value)
+					arg.stateTick = wireTick;
+
+				if constexpr (std::is_same_v<T, Packets::NetworkStrings>)
+				{
+					// Strings starting from zero reset the client string store
+					Nz::UInt32 stringCount = Nz::UInt32(arg.startId + arg.strings.size());
+					m_sentStringCount = (arg.startId == 0) ? stringCount : std::max(m_sentStringCount, stringCount);
+				}
+
+				if constexpr (std::is_constructible_v<MatchStateMirror::Packet, const T&>)
+					m_mirror->HandlePacket(arg, 0);
+
+				SendToClient(std::move(arg));
+			}
+		}, std::move(packet));
+	}
+}
@@ -3,8 +3,45 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <ClientLib/DownloadManager.hpp>
+#include <ClientLib/ContentStore.hpp>
 
 namespace bw
 {
 	DownloadManager::~DownloadManager() = default;
+
+	void DownloadManager::AddToContentStore(std::size_t fileIndex)
+	{
+		if (!m_contentStore)
+			return;
+
+		const FileEntry& entry = GetEntry(fileIndex);
+		m_contentStore->Store(entry.expectedChecksum, entry.outputPath);
+	}
+
+	bool DownloadManager::FetchFromContentStore(std::size_t fileIndex)
+	{
+		if (!m_contentStore)
+			return false;
+
+		const FileEntry& entry = GetEntry(fileIndex);
+		if (entry.keepInMemory)
+		{
+			std::vector<Nz::UInt8> content;
+			if (!m_contentStore->Fetch(entry.expectedChecksum, entry.expectedSize, content))
+				return false;
+
+			OnDownloadStarted(this, fileIndex, entry.downloadPath);
+			OnDownloadFinishedMemory(this, fileIndex, content, 0);
+		}
+		else
+		{
+			if (!m_contentStore->Fetch(entry.expectedChecksum, entry.expectedSize, entry.outputPath))
+				return false;
+
+			OnDownloadStarted(this, fileIndex, entry.downloadPath);
+			OnDownloadFinished(this, fileIndex, entry.outputPath, 0);
+		}
+
+		return true;
+	}
 }
@@ -7,10 +7,18 @@
 #include <CoreLib/Utils.hpp>
 #include <Nazara/Core/File.hpp>
 #include <algorithm>
+#include <array>
+#include <cstring>
 #include <stdexcept>
 
 namespace bw
 {
+	namespace
+	{
+		constexpr Nz::UInt64 MinChunkSize = 4 * 1024 * 1024; //< files bigger than twice this size are split across mirrors
+		constexpr std::size_t HashBlockSize = 64 * 1024;
+	}
+
 	HttpDownloadManager::HttpDownloadManager(const Logger& logger, std::vector<std::string> baseDownloadUrls, std::size_t maxSimultaneousDownload) :
 	m_nextFileIndex(0),
 	m_baseDownloadUrls(std::move(baseDownloadUrls)),
@@ -26,12 +34,8 @@ namespace bw
 
 		assert(maxSimultaneousDownload > 0);
 
-		m_requests.reserve(maxSimultaneousDownload);
-		for (std::size_t i = 0; i < maxSimultaneousDownload; ++i)
-		{
-			auto& request = m_requests.emplace_back();
-			request.hash = Nz::AbstractHash::Get(Nz::HashType_SHA1);
-		}
+		// Requests are referenced by their callbacks, don't move them
+		m_requests.resize(maxSimultaneousDownload);
 	}
 
 	auto HttpDownloadManager::GetEntry(std::size_t fileIndex) const -> const FileEntry&
@@ -42,7 +46,7 @@ namespace bw
 
 	bool HttpDownloadManager::IsFinished() const
 	{
-		if (m_nextFileIndex < m_downloadList.size())
+		if (m_nextFileIndex < m_downloadList.size() || !m_pendingChunks.empty())
 			return false;
 
 		for (const Request& request : m_requests)
@@ -64,157 +68,368 @@ namespace bw
 		newFile.outputPath = std::move(outputPath);
 	}
 
-	void HttpDownloadManager::RequestNextFiles()
+	void HttpDownloadManager::FinishFile(std::size_t fileIndex, Nz::UInt64 downloadSpeed)
 	{
-		if (IsFinished())
-		{
-			OnFinished(this);
-			return;
-		}
-
-		if (m_nextFileIndex >= m_downloadList.size())
-			return; //< All remaining files are being processed
+		PendingFile& pendingFile = m_downloadList[fileIndex];
+		assert(pendingFile.remainingChunkCount == 0);
 
-		for (Request& request : m_requests)
+		if (!pendingFile.hasFailed)
 		{
-			if (!request.isActive)
+			if (pendingFile.downloadedSize == pendingFile.expectedSize)
 			{
-				PendingFile& pendingDownload = m_downloadList[m_nextFileIndex];
+				// Hash data which was received out of order (split files)
+				if (pendingFile.hashedSize < pendingFile.expectedSize)
+				{
+					if (pendingFile.keepInMemory)
+						pendingFile.hash->Append(&pendingFile.fileContent[pendingFile.hashedSize], pendingFile.expectedSize - pendingFile.hashedSize);
+					else
+					{
+						std::array<Nz::UInt8, HashBlockSize> buffer;
 
-				std::string downloadUrl = m_baseDownloadUrls[pendingDownload.downloadUrlIndex] + "/" + pendingDownload.downloadPath;
+						pendingFile.file->SetCursorPos(pendingFile.hashedSize);
+						while (pendingFile.hashedSize < pendingFile.expectedSize)
+						{
+							std::size_t readSize = pendingFile.file->Read(buffer.data(), std::min<Nz::UInt64>(buffer.size(), pendingFile.expectedSize - pendingFile.hashedSize));
+							if (readSize == 0)
+								break;
 
-				std::unique_ptr<WebRequest> webRequest = WebRequest::Get(downloadUrl);
-				webRequest->SetMaximumFileSize(pendingDownload.expectedSize);
+							pendingFile.hash->Append(buffer.data(), readSize);
+							pendingFile.hashedSize += readSize;
+						}
+					}
+				}
 
-				webRequest->SetDataCallback([this, &request](const void* data, std::size_t size)
+				m_byteArray.Assign(pendingFile.expectedChecksum.begin(), pendingFile.expectedChecksum.end());
+				if (m_byteArray != pendingFile.hash->End())
 				{
-					auto& fileData = m_downloadList[request.fileIndex];
-					fileData.downloadedSize += size;
+					bwLog(m_logger, LogLevel::Error, "[HTTP] Failed to download {0}: checksums don't match", pendingFile.downloadPath);
+					pendingFile.error = Error::ChecksumMismatch;
+					pendingFile.hasFailed = true;
+				}
+			}
+			else
+			{
+				bwLog(m_logger, LogLevel::Error, "[HTTP] Failed to download {0}: sizes don't match (received {1}, expected {2})", pendingFile.downloadPath, pendingFile.downloadedSize, pendingFile.expectedSize);
+				pendingFile.error = Error::SizeMismatch;
+				pendingFile.hasFailed = true;
+			}
+		}
 
-					// Prevent tricky HTTP servers sending more data than expected
-					if (fileData.downloadedSize > fileData.expectedSize)
-					{
-						bwLog(m_logger, LogLevel::Error, "[HTTP] {0}: receiving more bytes than expected ({1} > {2}), aborting...", GetEntry(request.fileIndex).downloadPath, fileData.downloadedSize, fileData.expectedSize);
-						return false;
-					}
+		std::vector<Nz::UInt8> fileContent = std::move(pendingFile.fileContent);
+		std::unique_ptr<Nz::File> file = std::move(pendingFile.file);
+		pendingFile.hash.reset();
 
-					request.hash->Append(reinterpret_cast<const Nz::UInt8*>(data), size);
-					request.file.Write(data, size);
+		if (!pendingFile.hasFailed)
+		{
+			file->Close();
 
-					if (request.keepInMemory)
-					{
-						std::size_t offset = request.fileContent.size();
-						request.fileContent.resize(offset + size);
-						std::memcpy(&request.fileContent[offset], data, size);
-					}
+			AddToContentStore(fileIndex);
 
-					OnDownloadProgress(this, request.fileIndex, fileData.downloadedSize);
-					return true;
-				});
-				
-				webRequest->SetResultCallback([this, &request](WebRequestResult&& result)
-				{
-					// Handle download end
-					PendingFile& pendingDownload = m_downloadList[request.fileIndex];
+			if (pendingFile.keepInMemory)
+				OnDownloadFinishedMemory(this, fileIndex, fileContent, downloadSpeed);
+			else
+				OnDownloadFinished(this, fileIndex, pendingFile.outputPath, downloadSpeed);
+		}
+		else
+		{
+			// Keep the valid beginning of the file after network errors so it can be resumed
+			if (pendingFile.error == Error::FileNotFound)
+				file->SetSize(pendingFile.hashedSize);
 
-					request.file.Close();
+			file->Close();
 
-					bool downloadError = true;
+			if (pendingFile.error != Error::FileNotFound && !file->Delete())
+				bwLog(m_logger, LogLevel::Warning, "Failed to delete {0} after a download error", pendingFile.outputPath.generic_u8string());
 
-					Error errorCode = DownloadManager::Error::FileNotFound;
+			OnDownloadError(this, fileIndex, pendingFile.error);
+		}
+	}
 
-					std::string downloadPath = m_baseDownloadUrls[pendingDownload.downloadUrlIndex] + "/" + pendingDownload.downloadPath;
+	void HttpDownloadManager::HandleChunkData(Request& request, const void* data, std::size_t size)
+	{
+		Chunk& chunk = request.chunk;
+		PendingFile& pendingFile = m_downloadList[chunk.fileIndex];
 
-					if (result)
-					{
-						if (long responseCode = result.GetReponseCode(); responseCode == 200)
-						{
-							if (pendingDownload.downloadedSize == pendingDownload.expectedSize)
-							{
-								Nz::ByteArray byteArray = request.hash->End();
-								m_byteArray.Assign(pendingDownload.expectedChecksum.begin(), pendingDownload.expectedChecksum.end());
-
-								if (m_byteArray == byteArray)
-								{
-									Nz::UInt64 downloadSpeed = result.GetDownloadSpeed();
-
-									if (pendingDownload.keepInMemory)
-										OnDownloadFinishedMemory(this, request.fileIndex, request.fileContent, downloadSpeed);
-									else
-										OnDownloadFinished(this, request.fileIndex, pendingDownload.outputPath, downloadSpeed);
-
-									downloadError = false;
-								}
-								else
-								{
-									bwLog(m_logger, LogLevel::Error, "[HTTP] Failed to download {0}: checksums don't match", downloadPath);
-									errorCode = DownloadManager::Error::ChecksumMismatch;
-								}
-							}
-							else
-							{
-								bwLog(m_logger, LogLevel::Error, "[HTTP] Failed to download {0}: sizes don't match (received {1}, expected {2})", downloadPath, pendingDownload.downloadedSize, pendingDownload.expectedSize);
-								errorCode = DownloadManager::Error::SizeMismatch;
-							}
-						}
-						else
-							bwLog(m_logger, LogLevel::Error, "[HTTP] Failed to download {0}: expected code 200, got {1}", downloadPath, responseCode);
-					}
-					else
-						bwLog(m_logger, LogLevel::Error, "[HTTP] Failed to download {0}: ", downloadPath, result.GetErrorMessage());
+		const Nz::UInt8* ptr = static_cast<const Nz::UInt8*>(data);
 
-					if (downloadError)
-					{
-						// Can we try another URL to download this file?
-						if (pendingDownload.downloadUrlIndex + 1 < m_baseDownloadUrls.size())
-						{
-							bwLog(m_logger, LogLevel::Info, "[HTTP] {0} download will be retried from {1}", pendingDownload.downloadPath, m_baseDownloadUrls[pendingDownload.downloadUrlIndex + 1]);
+		// Skip data before the chunk (when a server doesn't answer the range request with a partial response)
+		if (request.bodyOffset < chunk.offset)
+		{
+			std::size_t skippedSize = static_cast<std::size_t>(std::min<Nz::UInt64>(chunk.offset - request.bodyOffset, size));
+			ptr += skippedSize;
+			size -= skippedSize;
+			request.bodyOffset += skippedSize;
+		}
+
+		std::size_t writeSize = static_cast<std::size_t>(std::min<Nz::UInt64>(chunk.endOffset - chunk.offset, size));
+		if (writeSize == 0)
+			return;
 
-							PendingFile& newFile = m_downloadList.emplace_back(pendingDownload);
-							newFile.downloadedSize = 0;
-							newFile.downloadUrlIndex++;
+		pendingFile.file->SetCursorPos(chunk.offset);
+		pendingFile.file->Write(ptr, writeSize);
 
-							// pendingDownload is no longer valid from here
-						}
-						else
-						{
-							OnDownloadError(this, request.fileIndex, errorCode);
+		if (pendingFile.keepInMemory)
+			std::memcpy(&pendingFile.fileContent[chunk.offset], ptr, writeSize);
 
-							if (!request.file.Delete())
-								bwLog(m_logger, LogLevel::Warning, "Failed to delete {0} after a download error", pendingDownload.outputPath.generic_u8string());
-						}
-					}
+		if (pendingFile.hashedSize == chunk.offset)
+		{
+			pendingFile.hash->Append(ptr, writeSize);
+			pendingFile.hashedSize += writeSize;
+		}
+
+		chunk.offset += writeSize;
+		request.bodyOffset += writeSize;
+		pendingFile.downloadedSize += writeSize;
+
+		OnDownloadProgress(this, chunk.fileIndex, pendingFile.downloadedSize);
+	}
 
-					// Cleanup
-					request.isActive = false;
-				});
+	void HttpDownloadManager::HandleChunkResult(Request& request, WebRequestResult&& result)
+	{
+		Chunk& chunk = request.chunk;
+		PendingFile& pendingFile = m_downloadList[chunk.fileIndex];
 
-				std::filesystem::path directory = pendingDownload.outputPath.parent_path();
-				std::string filePath = pendingDownload.outputPath.generic_u8string();
+		std::string downloadUrl = m_baseDownloadUrls[chunk.mirrorIndex] + "/" + pendingFile.downloadPath;
 
-				if (!directory.empty() && !std::filesystem::is_directory(directory))
+		Nz::UInt64 downloadSpeed = 0;
+		bool succeeded = false;
+		if (result)
+		{
+			long responseCode = result.GetReponseCode();
+			if (responseCode == 200 || responseCode == 206)
+			{
+				if (chunk.offset == chunk.endOffset)
 				{
-					if (!std::filesystem::create_directories(directory))
-						throw std::runtime_error("failed to create client script asset directory: " + directory.generic_u8string());
+					downloadSpeed = result.GetDownloadSpeed();
+					succeeded = true;
 				}
+				else
+					bwLog(m_logger, LogLevel::Error, "[HTTP] Failed to download {0}: transfer ended {1} bytes early", downloadUrl, chunk.endOffset - chunk.offset);
+			}
+			else
+				bwLog(m_logger, LogLevel::Error, "[HTTP] Failed to download {0}: expected code 200 or 206, got {1}", downloadUrl, responseCode);
+		}
+		else if (request.isChunkComplete)
+			succeeded = true; //< we aborted the transfer ourselves after receiving the whole chunk
+		else
+			bwLog(m_logger, LogLevel::Error, "[HTTP] Failed to download {0}: {1}", downloadUrl, result.GetErrorMessage());
+
+		request.isActive = false;
+		request.webRequest = nullptr;
+
+		if (!succeeded)
+		{
+			// Can we try another mirror to download what's left of this chunk?
+			if (++chunk.failedAttemptCount < m_baseDownloadUrls.size() && !pendingFile.hasFailed)
+			{
+				chunk.mirrorIndex = (chunk.mirrorIndex + 1) % m_baseDownloadUrls.size();
 
-				request.fileIndex = m_nextFileIndex;
-				request.hash->Begin();
-				request.file.Open(filePath, Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate);
-				request.keepInMemory = pendingDownload.keepInMemory;
+				bwLog(m_logger, LogLevel::Info, "[HTTP] {0} download will be resumed from {1}", pendingFile.downloadPath, m_baseDownloadUrls[chunk.mirrorIndex]);
 
-				m_webService.AddRequest(std::move(webRequest));
+				m_pendingChunks.push_front(chunk);
+				return;
+			}
 
-				OnDownloadStarted(this, m_nextFileIndex, downloadUrl);
+			pendingFile.hasFailed = true;
+		}
 
-				request.isActive = true;
+		assert(pendingFile.remainingChunkCount > 0);
+		if (--pendingFile.remainingChunkCount == 0)
+			FinishFile(chunk.fileIndex, downloadSpeed);
+	}
 
-				if (++m_nextFileIndex >= m_downloadList.size())
+	void HttpDownloadManager::PrepareFile(std::size_t fileIndex)
+	{
+		PendingFile& pendingFile = m_downloadList[fileIndex];
+
+		std::filesystem::path directory = pendingFile.outputPath.parent_path();
+		std::string filePath = pendingFile.outputPath.generic_u8string();
+
+		if (!directory.empty() && !std::filesystem::is_directory(directory))
+		{
+			if (!std::filesystem::create_directories(directory))
+				throw std::runtime_error("failed to create client script asset directory: " + directory.generic_u8string());
+		}
+
+		pendingFile.hash = Nz::AbstractHash::Get(Nz::HashType_SHA1);
+		pendingFile.hash->Begin();
+
+		if (pendingFile.keepInMemory)
+			pendingFile.fileContent.resize(pendingFile.expectedSize);
+
+		// Resume a previous partial download if there's one
+		Nz::UInt64 existingSize = 0;
+		if (std::error_code ec; std::filesystem::is_regular_file(pendingFile.outputPath, ec))
+		{
+			existingSize = std::filesystem::file_size(pendingFile.outputPath, ec);
+			if (ec || existingSize >= pendingFile.expectedSize)
+				existingSize = 0; //< a complete file would have been found by the resource check, it's invalid
+		}
+
+		pendingFile.file = std::make_unique<Nz::File>(filePath);
+		if (existingSize > 0 && pendingFile.file->Open(Nz::OpenMode_ReadWrite))
+		{
+			std::array<Nz::UInt8, HashBlockSize> buffer;
+			while (pendingFile.hashedSize < existingSize)
+			{
+				std::size_t readSize = pendingFile.file->Read(buffer.data(), std::min<Nz::UInt64>(buffer.size(), existingSize - pendingFile.hashedSize));
+				if (readSize == 0)
 					break;
+
+				pendingFile.hash->Append(buffer.data(), readSize);
+				if (pendingFile.keepInMemory)
+					std::memcpy(&pendingFile.fileContent[pendingFile.hashedSize], buffer.data(), readSize);
+
+				pendingFile.hashedSize += readSize;
+			}
+
+			if (pendingFile.hashedSize == existingSize)
+				bwLog(m_logger, LogLevel::Info, "[HTTP] Resuming {0} download from {1}", pendingFile.downloadPath, ByteToString(existingSize));
+			else
+			{
+				// Failed to read the partial file, start over
+				pendingFile.file->Close();
+				pendingFile.hash->End();
+				pendingFile.hash->Begin();
+				pendingFile.hashedSize = 0;
+				existingSize = 0;
+			}
+		}
+		else
+			existingSize = 0;
+
+		if (existingSize == 0)
+		{
+			if (!pendingFile.file->Open(Nz::OpenMode_ReadWrite | Nz::OpenMode_Truncate))
+				throw std::runtime_error("failed to open " + filePath);
+		}
+
+		pendingFile.downloadedSize = existingSize;
+
+		// Split big files across mirrors
+		Nz::UInt64 remainingSize = pendingFile.expectedSize - existingSize;
+
+		std::size_t chunkCount = 1;
+		if (m_baseDownloadUrls.size() > 1 && remainingSize >= 2 * MinChunkSize)
+			chunkCount = static_cast<std::size_t>(std::min<Nz::UInt64>(m_baseDownloadUrls.size(), remainingSize / MinChunkSize));
+
+		Nz::UInt64 chunkSize = remainingSize / chunkCount + ((remainingSize % chunkCount != 0) ? 1 : 0);
+
+		// Spread files over mirrors
+		std::size_t firstMirrorIndex = fileIndex % m_baseDownloadUrls.size();
+
+		pendingFile.remainingChunkCount = chunkCount;
+		for (std::size_t i = 0; i < chunkCount; ++i)
+		{
+			Chunk& chunk = m_pendingChunks.emplace_back();
+			chunk.fileIndex = fileIndex;
+			chunk.mirrorIndex = (firstMirrorIndex + i) % m_baseDownloadUrls.size();
+			chunk.offset = existingSize + i * chunkSize;
+			chunk.endOffset = std::min(chunk.offset + chunkSize, pendingFile.expectedSize);
+		}
+
+		OnDownloadStarted(this, fileIndex, m_baseDownloadUrls[firstMirrorIndex] + "/" + pendingFile.downloadPath);
+	}
+
+	void HttpDownloadManager::RequestNextFiles()
+	{
+		if (IsFinished())
+		{
+			OnFinished(this);
+			return;
+		}
+
+		for (Request& request : m_requests)
+		{
+			if (request.isActive)
+				continue;
+
+			while (m_pendingChunks.empty() && m_nextFileIndex < m_downloadList.size())
+			{
+				std::size_t fileIndex = m_nextFileIndex++;
+				if (!FetchFromContentStore(fileIndex))
+					PrepareFile(fileIndex);
+			}
+
+			if (m_pendingChunks.empty())
+				break; //< All remaining files are being processed
+
+			request.chunk = m_pendingChunks.front();
+			m_pendingChunks.pop_front();
+
+			PendingFile& pendingFile = m_downloadList[request.chunk.fileIndex];
+			if (pendingFile.hasFailed)
+			{
+				// Another chunk of this file failed, don't bother downloading this one
+				if (--pendingFile.remainingChunkCount == 0)
+					FinishFile(request.chunk.fileIndex, 0);
+
+				continue;
 			}
+
+			StartChunk(request);
 		}
 	}
 
+	void HttpDownloadManager::StartChunk(Request& request)
+	{
+		const Chunk& chunk = request.chunk;
+		const PendingFile& pendingFile = m_downloadList[chunk.fileIndex];
+
+		std::string downloadUrl = m_baseDownloadUrls[chunk.mirrorIndex] + "/" + pendingFile.downloadPath;
+
+		std::unique_ptr<WebRequest> webRequest = WebRequest::Get(downloadUrl);
+		webRequest->SetMaximumFileSize(pendingFile.expectedSize);
+
+		bool isPartial = (chunk.offset > 0 || chunk.endOffset < pendingFile.expectedSize);
+		if (isPartial)
+			webRequest->SetRange(chunk.offset, chunk.endOffset - 1);
+
+		webRequest->SetDataCallback([this, &request, isPartial](const void* data, std::size_t size)
+		{
+			if (!request.hasCheckedResponse)
+			{
+				long responseCode = request.webRequest->GetResponseCode();
+				if (responseCode != 200 && responseCode != 206)
+					return false;
+
+				// A server ignoring the range request sends the whole file
+				if (responseCode == 200)
+				{
+					request.bodyOffset = 0;
+					request.ignoresRange = isPartial;
+				}
+
+				request.hasCheckedResponse = true;
+			}
+
+			HandleChunkData(request, data, size);
+
+			// Don't download the rest of the file when the server ignored our range
+			if (request.ignoresRange && request.chunk.offset == request.chunk.endOffset)
+			{
+				request.isChunkComplete = true;
+				return false;
+			}
+
+			return true;
+		});
+
+		webRequest->SetResultCallback([this, &request](WebRequestResult&& result)
+		{
+			HandleChunkResult(request, std::move(result));
+		});
+
+		request.bodyOffset = chunk.offset;
+		request.hasCheckedResponse = false;
+		request.ignoresRange = false;
+		request.isActive = true;
+		request.isChunkComplete = false;
+		request.webRequest = webRequest.get();
+
+		m_webService.AddRequest(std::move(webRequest));
+	}
+
 	void HttpDownloadManager::Update()
 	{
 		RequestNextFiles();
@@ -170,6 +170,18 @@ namespace bw
 			visualEntity->Update(position, rotation, scale);
 	}
 
+	void LayerVisualEntity::SyncVisuals(const Nz::Rectf& viewRect)
+	{
+		auto& entityNode = m_entity->GetComponent<Ndk::NodeComponent>();
+
+		Nz::Vector2f position = Nz::Vector2f(entityNode.GetPosition(Nz::CoordSys_Global));
+		Nz::Vector2f scale = Nz::Vector2f(entityNode.GetScale(Nz::CoordSys_Global));
+		Nz::Quaternionf rotation = entityNode.GetRotation(Nz::CoordSys_Global);
+
+		for (VisualEntity* visualEntity : m_visualEntities)
+			visualEntity->Update(position, rotation, scale, viewRect);
+	}
+
 	void LayerVisualEntity::UpdateHoveringRenderableHoveringHeight(const Nz::InstancedRenderableRef& renderable, float newHoveringHeight)
 	{
 		for (auto& hoveringRenderable : m_attachedHoveringRenderables)
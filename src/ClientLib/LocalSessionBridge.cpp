@@ -13,7 +13,8 @@ namespace bw
 	SessionBridge(nullptr),
 	m_peerId(peerId),
 	m_sessionManager(sessionManager),
-	m_isServer(isServer)
+	m_isServer(isServer),
+	m_typedPackets(false)
 	{
 		BurgApp& app = m_sessionManager.GetOwner()->GetMatch().GetApp();
 		m_lastReceiveTime = app.GetAppTime();
@@ -51,6 +52,16 @@ namespace bw
 		SessionBridge::HandleIncomingPacket(packet);
 	}
 
+	void LocalSessionBridge::HandleIncomingTypedPacket(TypedPacket& packet)
+	{
+		BurgApp& app = m_sessionManager.GetOwner()->GetMatch().GetApp();
+		m_lastReceiveTime = app.GetAppTime();
+
+		m_sessionInfo.totalPacketReceived++;
+
+		SessionBridge::HandleIncomingTypedPacket(packet);
+	}
+
 	void LocalSessionBridge::QueryInfo(std::function<void(const SessionInfo& info)> callback) const
 	{
 		BurgApp& app = m_sessionManager.GetOwner()->GetMatch().GetApp();
@@ -69,4 +80,19 @@ namespace bw
 
 		m_sessionManager.SendPacket(m_peerId, std::move(packet), m_isServer);
 	}
+
+	void LocalSessionBridge::SendTypedPacket(TypedPacket&& packet)
+	{
+		assert(IsConnected());
+		assert(m_typedPackets);
+
+		m_sessionInfo.totalPacketSent++;
+
+		m_sessionManager.SendPacket(m_peerId, std::move(packet), m_isServer);
+	}
+
+	bool LocalSessionBridge::SupportsTypedPackets() const
+	{
+		return m_typedPackets;
+	}
 }
@@ -5,15 +5,47 @@
 #include <ClientLib/LocalSessionManager.hpp>
 #include <ClientLib/LocalSessionBridge.hpp>
 #include <CoreLib/Match.hpp>
+#include <CoreLib/MatchClientSession.hpp>
 #include <CoreLib/MatchSessions.hpp>
+#include <CoreLib/Utils.hpp>
 #include <CoreLib/LogSystem/Logger.hpp>
 
 namespace bw
 {
+	namespace
+	{
+		template<typename T>
+		void DeliverPackets(LocalSessionBridge& bridge, std::vector<T>& packets)
+		{
+			for (auto&& packet : packets)
+			{
+				std::visit([&](auto&& packetData)
+				{
+					using P = std::decay_t<decltype(packetData)>;
+
+					if constexpr (std::is_same_v<P, Nz::NetPacket>)
+						bridge.HandleIncomingPacket(packetData);
+					else if constexpr (std::is_same_v<P, TypedPacket>)
+						bridge.HandleIncomingTypedPacket(packetData);
+					else
+						static_assert(AlwaysFalse<P>::value, "non-exhaustive visitor");
+				}, packet);
+			}
+		}
+	}
+
+	LocalSessionManager::LocalSessionManager(MatchSessions* owner, bool separateClientThread) :
+	SessionManager(owner),
+	m_separateClientThread(separateClientThread)
+	{
+	}
+
 	LocalSessionManager::~LocalSessionManager() = default;
 
 	std::shared_ptr<LocalSessionBridge> LocalSessionManager::CreateSession()
 	{
+		std::lock_guard<std::mutex> lock(m_peerMutex);
+
 		// Find first free peerId
 		std::size_t peerId = 0;
 		for (; peerId < m_peers.size(); ++peerId)
@@ -25,48 +57,110 @@ namespace bw
 		if (peerId == m_peers.size())
 			m_peers.emplace_back();
 
-		bwLog(GetOwner()->GetMatch().GetLogger(), LogLevel::Info, "Local session #{0} created", peerId);
+		// The match session is created by the next Poll, as it may run on another thread
 		auto& peer = m_peers[peerId];
 		peer.emplace();
 		peer->clientBridge = std::make_shared<LocalSessionBridge>(*this, peerId, false);
 		peer->serverBridge = std::make_shared<LocalSessionBridge>(*this, peerId, true);
-		peer->session = GetOwner()->CreateSession(peer->serverBridge);
 
 		return peer->clientBridge;
 	}
 
 	void LocalSessionManager::Poll()
 	{
-		for (auto& peerOpt : m_peers)
+		// Packets handlers may send packets or create sessions, the lock is released while they run (and m_peers may be resized)
+		std::unique_lock<std::mutex> lock(m_peerMutex);
+		for (std::size_t peerId = 0; peerId < m_peers.size(); ++peerId)
 		{
-			if (peerOpt)
+			if (!m_peers[peerId] || m_peers[peerId]->isServerDisconnected)
+				continue;
+
+			std::shared_ptr<LocalSessionBridge> serverBridge = m_peers[peerId]->serverBridge;
+
+			if (!m_peers[peerId]->session && !m_peers[peerId]->disconnectionRequested)
 			{
-				Peer& peer = peerOpt.value();
-				for (auto&& packet : peer.clientPackets)
-					peer.clientBridge->HandleIncomingPacket(packet);
+				lock.unlock();
 
-				peer.clientPackets.clear();
+				bwLog(GetOwner()->GetMatch().GetLogger(), LogLevel::Info, "Local session #{0} created", peerId);
+				MatchClientSession* session = GetOwner()->CreateSession(serverBridge);
 
-				for (auto&& packet : peer.serverPackets)
-					peer.serverBridge->HandleIncomingPacket(packet);
+				// Packets structures can be passed as-is unless something stands between the session and its bridge (such as a network simulator)
+				bool typedPackets = (&session->GetSessionBridge() == serverBridge.get());
 
-				peer.serverPackets.clear();
+				lock.lock();
 
-				if (peer.disconnectionRequested)
-				{
-					peer.clientBridge->HandleDisconnection(0);
-					peer.serverBridge->HandleDisconnection(0);
+				Peer& peer = m_peers[peerId].value();
+				peer.session = session;
+				peer.clientBridge->EnableTypedPackets(typedPackets);
+				peer.serverBridge->EnableTypedPackets(typedPackets);
+			}
+
+			Peer& peer = m_peers[peerId].value();
+			std::vector<PendingPacket> packets = std::move(peer.serverPackets);
+			peer.serverPackets.clear();
+
+			MatchClientSession* session = peer.session;
+			bool disconnectionRequested = peer.disconnectionRequested;
 
-					GetOwner()->DeleteSession(peer.session);
+			lock.unlock();
+
+			if (session)
+				DeliverPackets(*serverBridge, packets);
+
+			if (disconnectionRequested)
+			{
+				serverBridge->HandleDisconnection(0);
 
-					peerOpt.reset();
-				}
+				if (session)
+					GetOwner()->DeleteSession(session);
 			}
+
+			lock.lock();
+
+			// The client side handles the disconnection and frees the peer
+			if (disconnectionRequested)
+				m_peers[peerId]->isServerDisconnected = true;
+		}
+
+		lock.unlock();
+
+		if (!m_separateClientThread)
+			PollClients();
+	}
+
+	void LocalSessionManager::PollClients()
+	{
+		std::unique_lock<std::mutex> lock(m_peerMutex);
+		for (std::size_t peerId = 0; peerId < m_peers.size(); ++peerId)
+		{
+			if (!m_peers[peerId])
+				continue;
+
+			Peer& peer = m_peers[peerId].value();
+			std::shared_ptr<LocalSessionBridge> clientBridge = peer.clientBridge;
+			std::vector<PendingPacket> packets = std::move(peer.clientPackets);
+			peer.clientPackets.clear();
+
+			bool isServerDisconnected = peer.isServerDisconnected;
+
+			lock.unlock();
+
+			DeliverPackets(*clientBridge, packets);
+
+			if (isServerDisconnected)
+				clientBridge->HandleDisconnection(0);
+
+			lock.lock();
+
+			if (isServerDisconnected)
+				m_peers[peerId].reset();
 		}
 	}
 
 	void LocalSessionManager::DisconnectPeer(std::size_t peerId)
 	{
+		std::lock_guard<std::mutex> lock(m_peerMutex);
+
 		assert(peerId < m_peers.size() && m_peers[peerId]);
 		Peer& peer = m_peers[peerId].value();
 		peer.disconnectionRequested = true;
@@ -74,11 +168,26 @@ namespace bw
 
 	void LocalSessionManager::SendPacket(std::size_t peerId, Nz::NetPacket&& packet, bool isServer)
 	{
+		// Reset cursor position
+		packet.GetStream()->SetCursorPos(Nz::NetPacket::HeaderSize);
+
+		std::lock_guard<std::mutex> lock(m_peerMutex);
+
 		assert(peerId < m_peers.size() && m_peers[peerId]);
 		Peer& peer = m_peers[peerId].value();
 
-		// Reset cursor position
-		packet.GetStream()->SetCursorPos(Nz::NetPacket::HeaderSize);
+		if (isServer)
+			peer.clientPackets.emplace_back(std::move(packet));
+		else
+			peer.serverPackets.emplace_back(std::move(packet));
+	}
+
+	void LocalSessionManager::SendPacket(std::size_t peerId, TypedPacket&& packet, bool isServer)
+	{
+		std::lock_guard<std::mutex> lock(m_peerMutex);
+
+		assert(peerId < m_peers.size() && m_peers[peerId]);
+		Peer& peer = m_peers[peerId].value();
 
 		if (isServer)
 			peer.clientPackets.emplace_back(std::move(packet));
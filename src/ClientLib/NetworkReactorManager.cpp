@@ -42,17 +42,26 @@ namespace bw
 		}
 
 		// We don't have any reactor compatible with the server's protocol, allocate a new one
-		std::size_t reactorId = AddReactor(std::make_unique<NetworkReactor>(reactorCount * MaxPeerCount, serverAddress.GetProtocol(), Nz::UInt16(0), MaxPeerCount));
+		std::size_t reactorId = AddReactor(std::make_unique<NetworkReactor>(reactorCount * MaxPeerCount, serverAddress.GetProtocol(), Nz::UInt16(0), MaxPeerCount, GetPacketDecoder()));
 		return ConnectWithReactor(GetReactor(reactorId).get());
 	}
 
+	NetworkReactor::PacketDecoder NetworkReactorManager::GetPacketDecoder() const
+	{
+		return [decoderStore = m_packetDecoderStore](Nz::NetPacket& packet, TypedPacket& typedPacket)
+		{
+			return decoderStore->DecodePacket(packet, typedPacket);
+		};
+	}
+
 	void NetworkReactorManager::Update()
 	{
 		for (const auto& reactorPtr : m_reactors)
 		{
 			reactorPtr->Poll([&](bool outgoing, std::size_t clientId, Nz::UInt32 data) { HandlePeerConnection(outgoing, clientId, data); },
 			                 [&](std::size_t clientId, Nz::UInt32 data) { HandlePeerDisconnection(clientId, data); },
-			                 [&](std::size_t clientId, Nz::NetPacket&& packet) { HandlePeerPacket(clientId, packet); });
+			                 [&](std::size_t clientId, Nz::NetPacket&& packet) { HandlePeerPacket(clientId, packet); },
+			                 [&](std::size_t clientId, TypedPacket&& packet) { HandlePeerTypedPacket(clientId, packet); });
 		}
 	}
 
@@ -71,4 +80,9 @@ namespace bw
 	{
 		m_connections[peerId]->HandleIncomingPacket(packet);
 	}
+
+	void NetworkReactorManager::HandlePeerTypedPacket(std::size_t peerId, TypedPacket& packet)
+	{
+		m_connections[peerId]->HandleIncomingTypedPacket(packet);
+	}
 }
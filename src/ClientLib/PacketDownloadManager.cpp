@@ -65,22 +65,31 @@ namespace bw
 		if (packet.fragmentIndex >= pendingFileData.receivedFragment.GetSize())
 			throw std::runtime_error("unexpected fragment " + std::to_string(packet.fragmentIndex) + " from server");
 
-		std::size_t offset = packet.fragmentIndex * pendingFileData.fragmentSize;
-		m_outputFile.SetCursorPos(offset);
-		m_outputFile.Write(packet.fragmentContent.data(), packet.fragmentContent.size());
+		// Fragments are sent reliably and in order, which allows to write and hash them as they come
+		if (packet.fragmentIndex != pendingFileData.receivedFragmentCount)
+			throw std::runtime_error("out of order fragment " + std::to_string(packet.fragmentIndex) + " from server (expected " + std::to_string(pendingFileData.receivedFragmentCount) + ")");
+
+		if (packet.fragmentContent.size() > pendingFileData.fragmentSize)
+			throw std::runtime_error("fragment " + std::to_string(packet.fragmentIndex) + " from server is too big");
+
+		if (m_outputFile.Write(packet.fragmentContent.data(), packet.fragmentContent.size()) != packet.fragmentContent.size())
+			throw std::runtime_error("failed to write to " + pendingFileData.outputPath.generic_u8string());
 
 		m_hash->Append(packet.fragmentContent.data(), packet.fragmentContent.size());
 
-		std::size_t downloadedSize = (packet.fragmentIndex + 1) * pendingFileData.fragmentSize;
 		if (pendingFileData.keepInMemory)
-		{
-			if (m_fileContent.size() < downloadedSize)
-				m_fileContent.resize(downloadedSize);
+			m_fileContent.insert(m_fileContent.end(), packet.fragmentContent.begin(), packet.fragmentContent.end());
 
-			std::memcpy(&m_fileContent[offset], packet.fragmentContent.data(), packet.fragmentContent.size());
-		}
+		pendingFileData.downloadedSize += packet.fragmentContent.size();
+		pendingFileData.receivedFragmentCount++;
+
+		// Acknowledge the fragment so the server can move its sending window
+		Packets::DownloadClientFileAck ackPacket;
+		ackPacket.receivedFragmentCount = pendingFileData.receivedFragmentCount;
 
-		OnDownloadProgress(this, currentFileIndex, downloadedSize);
+		m_clientSession->SendPacket(ackPacket);
+
+		OnDownloadProgress(this, currentFileIndex, pendingFileData.downloadedSize);
 
 		pendingFileData.receivedFragment.Set(packet.fragmentIndex, true);
 		if (pendingFileData.receivedFragment.TestAll())
@@ -91,6 +100,8 @@ namespace bw
 
 			if (m_byteArray == m_hash->End())
 			{
+				AddToContentStore(currentFileIndex);
+
 				if (pendingFileData.keepInMemory)
 					OnDownloadFinishedMemory(this, currentFileIndex, m_fileContent, 0);
 				else
@@ -113,7 +124,12 @@ namespace bw
 			if constexpr (std::is_same_v<T, Packets::DownloadClientFileResponse::Success>)
 			{
 				pendingFileData.receivedFragment.Resize(arg.fragmentCount);
+				pendingFileData.downloadedSize = 0;
 				pendingFileData.fragmentSize = arg.fragmentSize;
+				pendingFileData.receivedFragmentCount = 0;
+
+				if (pendingFileData.keepInMemory)
+					m_fileContent.reserve(pendingFileData.expectedSize);
 
 				std::filesystem::path clientFolderPath = pendingFileData.outputPath.parent_path();
 				std::string filePath = pendingFileData.outputPath.generic_u8string();
@@ -168,6 +184,10 @@ namespace bw
 				return;
 		}
 
+		// Skip files already known by the content store
+		while (m_nextFileIndex < m_downloadList.size() && FetchFromContentStore(m_nextFileIndex))
+			m_downloadList[m_nextFileIndex++].receivedFragment.Resize(1, true);
+
 		if (m_nextFileIndex >= m_downloadList.size())
 			return; //< All remaining files are being processed
 
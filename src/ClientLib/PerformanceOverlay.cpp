@@ -0,0 +1,101 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/PerformanceOverlay.hpp>
+#include <CoreLib/TickProfiler.hpp>
+#include <ClientLib/ClientSession.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <Nazara/Utility/SimpleTextDrawer.hpp>
+#include <fmt/format.h>
+
+namespace bw
+{
+	PerformanceOverlay::PerformanceOverlay(Ndk::Canvas* canvas, ClientSession& session) :
+	m_networkStatistics(std::make_shared<NetworkStatistics>()),
+	m_session(session),
+	m_refreshTimer(0.f)
+	{
+		m_label = canvas->Add<Ndk::LabelWidget>();
+		m_label->EnableBackground(true);
+		m_label->SetBackgroundColor(Nz::Color(0, 0, 0, 160));
+		m_label->SetPosition(5.f, 5.f);
+		m_label->Hide();
+	}
+
+	PerformanceOverlay::~PerformanceOverlay()
+	{
+		m_label->Destroy();
+	}
+
+	void PerformanceOverlay::Show(bool shouldShow)
+	{
+		if (IsVisible() == shouldShow)
+			return;
+
+		if (shouldShow)
+		{
+			m_label->Show(true);
+			m_refreshTimer = 0.f; //< refresh right away
+		}
+		else
+			m_label->Hide();
+	}
+
+	void PerformanceOverlay::Update(float elapsedTime, const TickProfiler& frameProfiler, const std::string& matchStatistics)
+	{
+		if (!IsVisible())
+			return;
+
+		m_refreshTimer -= elapsedTime;
+		if (m_refreshTimer > 0.f)
+			return;
+
+		m_refreshTimer += RefreshInterval;
+		if (m_refreshTimer < 0.f)
+			m_refreshTimer = RefreshInterval;
+
+		QueryNetworkStatistics();
+
+		std::string text = frameProfiler.Format("Frame profile", "frames");
+
+		const NetworkStatistics& networkStats = *m_networkStatistics;
+		if (networkStats.lastSessionInfo)
+		{
+			const SessionBridge::SessionInfo& sessionInfo = *networkStats.lastSessionInfo;
+			text += fmt::format("RTT: {0} ms, download: {1:.1f} KiB/s, upload: {2:.1f} KiB/s, packets lost: {3}/{4}\n", sessionInfo.ping, networkStats.downloadSpeed / 1024.0, networkStats.uploadSpeed / 1024.0, sessionInfo.totalPacketLost, sessionInfo.totalPacketSent);
+		}
+
+		text += matchStatistics;
+
+		m_label->UpdateText(Nz::SimpleTextDrawer::Draw(text, 14, 0, Nz::Color::White));
+		m_label->Resize(m_label->GetPreferredSize());
+	}
+
+	void PerformanceOverlay::QueryNetworkStatistics()
+	{
+		// The overlay may be destroyed before the session answers
+		m_session.QuerySessionInfo([networkStatsPtr = std::weak_ptr<NetworkStatistics>(m_networkStatistics)](const SessionBridge::SessionInfo& sessionInfo)
+		{
+			std::shared_ptr<NetworkStatistics> networkStats = networkStatsPtr.lock();
+			if (!networkStats)
+				return;
+
+			Nz::UInt64 now = Nz::GetElapsedMicroseconds();
+			if (networkStats->lastSessionInfo)
+			{
+				const SessionBridge::SessionInfo& lastSessionInfo = *networkStats->lastSessionInfo;
+
+				double elapsedTime = double(now - networkStats->lastQueryTime) / 1'000'000.0;
+				if (elapsedTime > 0.0)
+				{
+					networkStats->downloadSpeed = (sessionInfo.totalByteReceived - lastSessionInfo.totalByteReceived) / elapsedTime;
+					networkStats->uploadSpeed = (sessionInfo.totalByteSent - lastSessionInfo.totalByteSent) / elapsedTime;
+				}
+			}
+
+			networkStats->lastQueryTime = now;
+			networkStats->lastSessionInfo = sessionInfo;
+		});
+	}
+}
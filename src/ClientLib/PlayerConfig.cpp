@@ -15,6 +15,7 @@ namespace bw
 		RegisterStringOption("StartServer.Gamemode", "deathmatch");
 		RegisterStringOption("StartServer.Map", "beta_map");
 		RegisterStringOption("StartServer.Name", "A server has no name");
+		RegisterIntegerOption("Graphics.ParticleBudget", 0, 1'000'000, 20'000); //< particles generated per frame
 		RegisterIntegerOption("JoinServer.Port", 0, 0xFFFF, 14768);
 		RegisterIntegerOption("StartServer.Port", 0, 0xFFFF, 14768);
 		RegisterIntegerOption("Sound.GlobalVolume", 0, 100, 80);
@@ -170,6 +170,10 @@ namespace bw
 		if (valueIndex >= playerData.values.size())
 			return;
 
+		auto& columnData = playerData.values[valueIndex];
+		if (columnData.value == value)
+			return;
+
 		Nz::Color playerColor = Nz::Color::White;
 		if (playerData.color)
 			playerColor = *playerData.color;
@@ -179,12 +183,15 @@ namespace bw
 		Nz::FontRef scoreMenuFont = Nz::FontLibrary::Get("BW_ScoreMenu");
 		assert(scoreMenuFont);
 
-		auto& columnData = playerData.values[valueIndex];
+		float previousHeight = columnData.label->GetHeight();
+
 		columnData.value = std::move(value);
 		columnData.label->UpdateText(Nz::SimpleTextDrawer::Draw(scoreMenuFont, columnData.value, 18, 0, playerColor));
 		columnData.label->Resize(columnData.label->GetPreferredSize());
 
-		Layout();
+		// Labels keep their position when their text changes, rows only have to be moved if the row height changed
+		if (columnData.label->GetHeight() != previousHeight)
+			Layout();
 	}
 
 	void Scoreboard::Layout()
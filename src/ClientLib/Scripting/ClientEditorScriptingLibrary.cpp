@@ -20,12 +20,9 @@ namespace bw
 
 	void ClientEditorScriptingLibrary::RegisterLibrary(ScriptingContext& context)
 	{
-		sol::state& luaState = context.GetLuaState();
-		sol::table assetTable = luaState.create_named_table("assets");
-		sol::table renderTable = luaState.create_named_table("render");
+		context.RegisterLazyTable("assets", [this, &context](sol::table& library) { RegisterAssetLibrary(context, library); });
+		context.RegisterLazyTable("render", [this, &context](sol::table& library) { RegisterRenderLibrary(context, library); });
 
-		RegisterAssetLibrary(context, assetTable);
-		RegisterRenderLibrary(context, renderTable);
 		RegisterSpriteClass(context);
 		RegisterTilemapClass(context);
 		RegisterTextClass(context);
@@ -10,6 +10,7 @@
 #include <ClientLib/ClientMatch.hpp>
 #include <ClientLib/Components/ClientMatchComponent.hpp>
 #include <ClientLib/Components/ClientOwnerComponent.hpp>
+#include <ClientLib/Components/FrameCallbackRateComponent.hpp>
 #include <ClientLib/Components/VisualComponent.hpp>
 #include <ClientLib/Scripting/Sound.hpp>
 #include <ClientLib/Scripting/Sprite.hpp>
@@ -100,20 +101,26 @@ namespace bw
 			else
 				color = Nz::Color::White;
 
-			//TODO: Don't create a material everytime
-			Nz::MaterialRef mat = Nz::Material::New("Translucent2D");
-			if (!texturePath.empty())
-				mat->SetDiffuseMap(m_assetStore.GetTexture(texturePath));
-
-			auto& sampler = mat->GetDiffuseSampler();
-			sampler.SetFilterMode(Nz::SamplerFilter_Bilinear);
-			if (repeatTexture)
-				sampler.SetWrapMode(Nz::SamplerWrap_Repeat);
-
 			Nz::SpriteRef sprite = Nz::Sprite::New();
 			sprite->SetColor(color);
-			sprite->SetMaterial(mat);
-			sprite->SetTextureCoords(textureCoords);
+
+			// Sprites share their material (and small textures are packed in atlas pages) so they can be batched
+			if (const TextureAtlas::Region* region = (!texturePath.empty()) ? m_assetStore.GetSpriteRegion(texturePath, repeatTexture) : nullptr)
+			{
+				const Nz::Rectf& regionCoords = region->textureCoords;
+
+				sprite->SetMaterial(region->material, false);
+				sprite->SetSize(region->size);
+				sprite->SetTextureCoords(Nz::Rectf(regionCoords.x + textureCoords.x * regionCoords.width, regionCoords.y + textureCoords.y * regionCoords.height, textureCoords.width * regionCoords.width, textureCoords.height * regionCoords.height));
+			}
+			else
+			{
+				Nz::MaterialRef mat = Nz::Material::New("Translucent2D");
+				mat->GetDiffuseSampler().SetFilterMode(Nz::SamplerFilter_Bilinear);
+
+				sprite->SetMaterial(mat);
+				sprite->SetTextureCoords(textureCoords);
+			}
 
 			if (std::optional<sol::table> cornerColorTable = parameters.get_or<std::optional<sol::table>>("CornerColor", std::nullopt); cornerColorTable)
 			{
@@ -208,8 +215,7 @@ namespace bw
 			if (font)
 				drawer.SetFont(font);
 
-			Nz::TextSpriteRef textSprite = Nz::TextSprite::New();
-			textSprite->Update(drawer);
+			Nz::TextSpriteRef textSprite = Text::BuildTextSprite(drawer);
 
 			auto& visualComponent = entity->GetComponent<VisualComponent>();
 
@@ -296,7 +302,7 @@ namespace bw
 				return sol::nil;
 		});
 
-		elementTable["PlaySound"] = LuaFunction([this](sol::this_state L, const sol::table& entityTable, const std::string& soundPath, bool isAttachedToEntity, bool isLooping, bool isSpatialized)
+		elementTable["PlaySound"] = LuaFunction([this](sol::this_state L, const sol::table& entityTable, const std::string& soundPath, bool isAttachedToEntity, bool isLooping, bool isSpatialized, std::optional<float> priority)
 		{
 			Ndk::EntityHandle entity = AssertScriptEntity(entityTable);
 			auto& entityMatch = entity->GetComponent<ClientMatchComponent>();
@@ -317,9 +323,36 @@ namespace bw
 
 			auto& layerSound = layer.RegisterSound(std::move(localLayerSound.value()));
 
-			std::size_t soundIndex = layerSound.PlaySound(soundBuffer, isLooping, isSpatialized);
+			std::size_t soundIndex = layerSound.PlaySound(soundBuffer, isLooping, isSpatialized, priority.value_or(1.f));
 			return Sound(layerSound.CreateHandle(), soundIndex);
 		});
+
+		// Rate is either a frequency (in Hz), 0 to run every frame or "idle" to only run when the frame budget allows it
+		elementTable["SetCallbackRate"] = LuaFunction([](sol::this_state L, const sol::table& entityTable, const std::string_view& event, const sol::object& rateObject)
+		{
+			Ndk::EntityHandle entity = AssertScriptEntity(entityTable);
+
+			ElementEvent elementEvent;
+			if (event == "Frame")
+				elementEvent = ElementEvent::Frame;
+			else if (event == "PostFrame")
+				elementEvent = ElementEvent::PostFrame;
+			else
+				TriggerLuaArgError(L, 2, "only Frame and PostFrame callbacks can be rate-limited");
+
+			float rate;
+			if (rateObject.is<std::string>() && rateObject.as<std::string>() == "idle")
+				rate = FrameCallbackRateComponent::IdleOnly;
+			else if (rateObject.is<float>() && rateObject.as<float>() >= 0.f)
+				rate = rateObject.as<float>();
+			else
+				TriggerLuaArgError(L, 3, "rate must be a positive frequency, 0 (every frame) or \"idle\"");
+
+			if (!entity->HasComponent<FrameCallbackRateComponent>())
+				entity->AddComponent<FrameCallbackRateComponent>();
+
+			entity->GetComponent<FrameCallbackRateComponent>().UpdateRate(elementEvent, rate);
+		});
 	}
 
 	void ClientElementLibrary::SetScale(const Ndk::EntityHandle& entity, float newScale)
@@ -56,12 +56,13 @@ namespace bw
 			int renderOrder = parameters.get_or("RenderOrder", 0);
 			Nz::Vector2f parallaxFactor = parameters.get_or("ParallaxFactor", Nz::Vector2f::Unit());
 			Nz::Vector2f scale = parameters.get_or("Scale", Nz::Vector2f::Unit());
+			bool isStatic = parameters.get_or("Static", false);
 
 			if (!entity->HasComponent<VisibleLayerComponent>())
 				entity->AddComponent<VisibleLayerComponent>(clientMatch.GetRenderWorld());
 
 			auto& visibleLayer = entity->GetComponent<VisibleLayerComponent>();
-			visibleLayer.RegisterLocalLayer(clientMatch.GetLayer(layerIndex), renderOrder, scale, parallaxFactor);
+			visibleLayer.RegisterLocalLayer(clientMatch.GetLayer(layerIndex), renderOrder, scale, parallaxFactor, isStatic);
 		});
 
 		elementMetatable["AddTilemap"] = LuaFunction([this](const sol::table& entityTable, const Nz::Vector2ui& mapSize, const Nz::Vector2f& cellSize, const sol::table& content, const std::vector<TileData>& tiles, int renderOrder = 0) -> sol::optional<Tilemap>
@@ -80,7 +81,7 @@ namespace bw
 			if (materials.empty())
 				return {};
 
-			Nz::TileMapRef tileMap = Nz::TileMap::New(mapSize, cellSize, materials.size());
+			std::vector<Nz::MaterialRef> materialRefs(materials.size());
 			for (auto&& [materialPath, matIndex] : materials)
 			{
 				Nz::MaterialRef material = Nz::Material::New(); //< FIXME
@@ -95,9 +96,36 @@ namespace bw
 				else
 					material = Nz::Material::GetDefault();
 
-				tileMap->SetMaterial(matIndex, material);
+				materialRefs[matIndex] = std::move(material);
 			}
 
+			// Split the map in chunks so only the visible ones get rendered (and a tile change only rebuilds its chunk)
+			Nz::Vector2ui chunkSize(std::min(mapSize.x, Tilemap::DefaultChunkSize), std::min(mapSize.y, Tilemap::DefaultChunkSize));
+			if (chunkSize.x == 0 || chunkSize.y == 0)
+				return {};
+
+			Nz::Vector2ui chunkCount((mapSize.x + chunkSize.x - 1) / chunkSize.x, (mapSize.y + chunkSize.y - 1) / chunkSize.y);
+
+			std::vector<Nz::TileMapRef> chunks(std::size_t(chunkCount.x) * chunkCount.y);
+			auto GetChunk = [&](const Nz::Vector2ui& tilePos) -> Nz::TileMap&
+			{
+				Nz::Vector2ui chunkPos(tilePos.x / chunkSize.x, tilePos.y / chunkSize.y);
+
+				Nz::TileMapRef& chunk = chunks[chunkPos.y * chunkCount.x + chunkPos.x];
+				if (!chunk)
+				{
+					// Border chunks are smaller
+					Nz::Vector2ui firstTile = chunkPos * chunkSize;
+					Nz::Vector2ui size(std::min(chunkSize.x, mapSize.x - firstTile.x), std::min(chunkSize.y, mapSize.y - firstTile.y));
+
+					chunk = Nz::TileMap::New(size, cellSize, materialRefs.size());
+					for (std::size_t matIndex = 0; matIndex < materialRefs.size(); ++matIndex)
+						chunk->SetMaterial(matIndex, materialRefs[matIndex]);
+				}
+
+				return *chunk;
+			};
+
 			std::size_t cellCount = content.size();
 			std::size_t expectedCellCount = mapSize.x * mapSize.y;
 			if (cellCount != expectedCellCount)
@@ -120,7 +148,7 @@ namespace bw
 						auto matIt = materials.find(tileData.materialPath);
 						assert(matIt != materials.end());
 
-						tileMap->EnableTile(tilePos, tileData.texCoords, Nz::Color::White, matIt->second);
+						GetChunk(tilePos).EnableTile(Nz::Vector2ui(tilePos.x % chunkSize.x, tilePos.y % chunkSize.y), tileData.texCoords, Nz::Color::White, matIt->second);
 					}
 				}
 			}
@@ -129,7 +157,7 @@ namespace bw
 
 			auto& visualComponent = entity->GetComponent<VisualComponent>();
 
-			Tilemap scriptTilemap(visualComponent.GetLayerVisual(), std::move(tileMap), transformMatrix, renderOrder);
+			Tilemap scriptTilemap(visualComponent.GetLayerVisual(), mapSize, cellSize, chunkSize, std::move(chunks), transformMatrix, renderOrder);
 			scriptTilemap.Show();
 
 			return scriptTilemap;
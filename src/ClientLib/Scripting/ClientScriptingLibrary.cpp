@@ -29,8 +29,6 @@ namespace bw
 	{
 		SharedScriptingLibrary::RegisterLibrary(context);
 
-		sol::state& luaState = context.GetLuaState();
-
 		RegisterCameraClass(context);
 		RegisterDummyInputPollerClass(context);
 		RegisterGlobalLibrary(context);
@@ -40,11 +38,8 @@ namespace bw
 		RegisterScoreboardClass(context);
 		RegisterSoundClass(context);
 
-		sol::table particleTable = luaState.create_named_table("particle");
-		sol::table soundTable = luaState.create_named_table("sound");
-
-		RegisterParticleLibrary(context, particleTable);
-		RegisterSoundLibrary(context, soundTable);
+		context.RegisterLazyTable("particle", [this, &context](sol::table& library) { RegisterParticleLibrary(context, library); });
+		context.RegisterLazyTable("sound", [this, &context](sol::table& library) { RegisterSoundLibrary(context, library); });
 
 		context.LoadDirectory("autorun");
 	}
@@ -133,7 +128,11 @@ namespace bw
 			if (!entityOpt)
 				TriggerLuaError(L, "failed to create \"" + entityType + "\"");
 
-			const Ndk::EntityHandle& entity = layer.RegisterEntity(std::move(entityOpt.value())).GetEntity();
+			ClientLayerEntity& layerEntity = layer.RegisterEntity(std::move(entityOpt.value()));
+			if (entityPtr->isNetworked)
+				match.RegisterPredictedEntity(layerEntity); //< entities the server will create too are replaced when they arrive
+
+			const Ndk::EntityHandle& entity = layerEntity.GetEntity();
 
 			if (lifeOwner)
 			{
@@ -198,6 +197,11 @@ namespace bw
 			return GetMatch().GetCurrentTick();
 		});
 
+		library["GetReconciliationStatistics"] = LuaFunction([&]()
+		{
+			return GetMatch().FormatReconciliationStatistics();
+		});
+
 		library["GetTick"] = LuaFunction([&]()
 		{
 			return GetMatch().AdjustServerTick(GetMatch().EstimateServerTick());
@@ -230,10 +234,11 @@ namespace bw
 			Nz::Vector2f position = parameters.get_or("Position", Nz::Vector2f::Zero());
 			bool isLooping = parameters.get_or("Loop", false);
 			bool isSpatialized = parameters.get_or("Spatialized", true);
+			float priority = parameters.get_or("Priority", 1.f);
 
 			auto& layerSound = layer.RegisterSound(ClientLayerSound(layer, position));
 
-			std::size_t soundIndex = layerSound.PlaySound(soundBuffer, isLooping, isSpatialized);
+			std::size_t soundIndex = layerSound.PlaySound(soundBuffer, isLooping, isSpatialized, priority);
 			return Sound(layerSound.CreateHandle(), soundIndex);
 		});
 	}
@@ -277,39 +282,22 @@ namespace bw
 		library["CreateMusicFromFile"] = LuaFunction([this](sol::this_state L, const std::string& musicPath) -> sol::object
 		{
 			ClientMatch& match = GetMatch();
-			const auto& assetDirectory = match.GetAssetStore().GetAssetDirectory();
 
-			VirtualDirectory::Entry entry;
-			if (!assetDirectory->GetEntry(musicPath, &entry))
+			// Takes the music opened by PrefetchMusicFromFile if any, decoding then happens on the music streaming thread
+			std::optional<AsyncMusicLoader::Result> result = match.GetAssetStore().OpenMusic(musicPath);
+			if (!result)
 				return sol::make_object(L, std::make_pair(sol::nil, "file not found"));
 
-			Nz::Music music;
-
-			bool loaded = std::visit([&](auto&& arg)
-			{
-				using T = std::decay_t<decltype(arg)>;
-				if constexpr (std::is_same_v<T, VirtualDirectory::FileContentEntry>)
-				{
-					bwLog(m_logger, LogLevel::Info, "Loading asset from memory");
-					return music.OpenFromMemory(arg.data(), arg.size());
-				}
-				else if constexpr (std::is_same_v<T, VirtualDirectory::PhysicalFileEntry>)
-				{
-					bwLog(m_logger, LogLevel::Info, "Loading asset from {}", arg.generic_u8string());
-					return music.OpenFromFile(arg.generic_u8string());
-				}
-				else if constexpr (std::is_same_v<T, VirtualDirectory::VirtualDirectoryEntry>)
-				{
-					return false;
-				}
-				else
-					static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
-			}, entry);
-
-			if (!loaded)
+			if (!result->isOpen)
 				return sol::make_object(L, std::make_pair(sol::nil, "failed to open music"));
 
-			return sol::make_object(L, Music(match.GetApplication(), std::move(music)));
+			return sol::make_object(L, Music(match.GetApplication(), std::move(result->music), std::move(result->source)));
+		});
+
+		library["PrefetchMusicFromFile"] = LuaFunction([this](const std::string& musicPath)
+		{
+			bwLog(m_logger, LogLevel::Debug, "Prefetching music {}", musicPath);
+			GetMatch().GetAssetStore().PrefetchMusic(musicPath);
 		});
 	}
 	
@@ -458,7 +446,9 @@ namespace bw
 				LuaFunction([=](ParticleGroup& group, const std::string& name) { group.AddGenerator(name, emptyTable); }),
 				LuaFunction(&ParticleGroup::AddGenerator)),
 
-			"GenerateParticles", LuaFunction(&ParticleGroup::GenerateParticles),
+			"GenerateParticles", sol::overload(
+				LuaFunction(sol::resolve<void(unsigned int)>(&ParticleGroup::GenerateParticles)),
+				LuaFunction(sol::resolve<void(unsigned int, const Nz::Vector2f&)>(&ParticleGroup::GenerateParticles))),
 
 			"GetParticleCount", LuaFunction(&ParticleGroup::GetParticleCount),
 
@@ -82,6 +82,15 @@ namespace bw
 			entityClientMatch.GetLayer().RegisterEntity(std::move(layerEntity));
 		};
 
+		elementMetatable["IsPredicted"] = LuaFunction([](const sol::table& weaponTable)
+		{
+			Ndk::EntityHandle entity = AssertScriptEntity(weaponTable);
+
+			// Attacks of local players weapons are run client-side before the server confirms them
+			auto& entityClientMatch = entity->GetComponent<ClientMatchComponent>();
+			return entityClientMatch.GetClientMatch().IsLocalPlayerWeapon(entity);
+		});
+
 		elementMetatable["Shoot"] = sol::overload(
 			LuaFunction(shootFunc),
 			LuaFunction([=](const sol::table& weaponTable, Nz::Vector2f startPos, Nz::Vector2f direction, Nz::UInt16 damage) { shootFunc(weaponTable, startPos, direction, damage); }));
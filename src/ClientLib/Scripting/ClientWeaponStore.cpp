@@ -22,13 +22,21 @@ namespace bw
 	{
 		const auto& weaponClass = GetElement(entityIndex);
 
-		Nz::MaterialRef mat = Nz::Material::New("Translucent2D");
-		mat->SetDiffuseMap(m_assetStore.GetTexture(weaponClass->spriteName));
-		auto& sampler = mat->GetDiffuseSampler();
-		sampler.SetFilterMode(Nz::SamplerFilter_Bilinear);
-
 		Nz::SpriteRef sprite = Nz::Sprite::New();
-		sprite->SetMaterial(mat);
+		if (const TextureAtlas::Region* region = m_assetStore.GetSpriteRegion(weaponClass->spriteName))
+		{
+			sprite->SetMaterial(region->material, false);
+			sprite->SetSize(region->size);
+			sprite->SetTextureCoords(region->textureCoords);
+		}
+		else
+		{
+			Nz::MaterialRef mat = Nz::Material::New("Translucent2D");
+			mat->GetDiffuseSampler().SetFilterMode(Nz::SamplerFilter_Bilinear);
+
+			sprite->SetMaterial(mat);
+		}
+
 		sprite->SetSize(sprite->GetSize() * weaponClass->scale);
 		Nz::Vector2f burgerSize = sprite->GetSize();
 		sprite->SetOrigin(weaponClass->spriteOrigin);
@@ -9,7 +9,8 @@
 
 namespace bw
 {
-	Music::Music(ClientEditorApp& app, Nz::Music music) :
+	Music::Music(ClientEditorApp& app, Nz::Music music, VirtualDirectory::Entry source) :
+	m_source(std::move(source)),
 	m_music(std::move(music))
 	{
 		auto& playerSettings = app.GetPlayerSettings();
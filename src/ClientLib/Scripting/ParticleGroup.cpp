@@ -4,6 +4,8 @@
 
 #include <ClientLib/Scripting/ParticleGroup.hpp>
 #include <ClientLib/Scripting/ParticleRegistry.hpp>
+#include <ClientLib/Systems/ParticleUpdateSystem.hpp>
+#include <NDK/World.hpp>
 #include <NDK/Components/ParticleGroupComponent.hpp>
 #include <cassert>
 #include <stdexcept>
@@ -46,6 +48,28 @@ namespace bw
 		if (!m_entity)
 			throw std::runtime_error("Particle group has been killed");
 
+		if (Ndk::World* world = m_entity->GetWorld(); world->HasSystem<ParticleUpdateSystem>())
+			count = world->GetSystem<ParticleUpdateSystem>().AcquireParticles(count);
+
+		if (count == 0)
+			return;
+
+		auto& particleGroup = m_entity->GetComponent<Ndk::ParticleGroupComponent>();
+		particleGroup.GenerateParticles(count);
+	}
+
+	void ParticleGroup::GenerateParticles(unsigned int count, const Nz::Vector2f& position)
+	{
+		if (!m_entity)
+			throw std::runtime_error("Particle group has been killed");
+
+		// Knowing where particles are emitted allows to reduce them when far from the camera
+		if (Ndk::World* world = m_entity->GetWorld(); world->HasSystem<ParticleUpdateSystem>())
+			count = world->GetSystem<ParticleUpdateSystem>().AcquireParticles(count, position);
+
+		if (count == 0)
+			return;
+
 		auto& particleGroup = m_entity->GetComponent<Ndk::ParticleGroupComponent>();
 		particleGroup.GenerateParticles(count);
 	}
@@ -4,12 +4,57 @@
 
 #include <ClientLib/Scripting/Text.hpp>
 #include <Nazara/Core/Color.hpp>
+#include <Nazara/Graphics/Material.hpp>
 #include <sol/sol.hpp>
+#include <tsl/hopscotch_map.h>
+#include <functional>
 #include <optional>
 #include <stdexcept>
 
 namespace bw
 {
+	namespace
+	{
+		struct LayoutKey
+		{
+			std::string text;
+			const Nz::Font* font;
+			Nz::Color color;
+			Nz::Color outlineColor;
+			Nz::TextStyleFlags style;
+			float outlineThickness;
+			unsigned int characterSize;
+
+			bool operator==(const LayoutKey& other) const
+			{
+				return text == other.text && font == other.font && color == other.color && outlineColor == other.outlineColor &&
+				       style == other.style && outlineThickness == other.outlineThickness && characterSize == other.characterSize;
+			}
+		};
+
+		struct LayoutKeyHasher
+		{
+			std::size_t operator()(const LayoutKey& key) const
+			{
+				// Texts sharing the same string are rarely displayed with different settings, hashing the string is enough
+				return std::hash<std::string>()(key.text) ^ std::hash<const Nz::Font*>()(key.font);
+			}
+		};
+
+		// Glyphs of every font already live in Nazara's shared atlas, this keeps the geometry of recently used strings (damage numbers, names, ...)
+		tsl::hopscotch_map<LayoutKey, Nz::TextSpriteRef, LayoutKeyHasher> s_layoutCache;
+	}
+
+	Nz::TextSpriteRef Text::BuildTextSprite(const Nz::SimpleTextDrawer& drawer)
+	{
+		return Nz::TextSprite::New(GetCachedLayout(drawer));
+	}
+
+	void Text::ClearLayoutCache()
+	{
+		s_layoutCache.clear();
+	}
+
 	void Text::SetColor(Nz::Color color)
 	{
 		if (!m_visualEntity)
@@ -57,9 +102,38 @@ namespace bw
 		m_isVisible = show;
 	}
 	
+	const Nz::TextSprite& Text::GetCachedLayout(const Nz::SimpleTextDrawer& drawer)
+	{
+		LayoutKey key;
+		key.text = drawer.GetText().ToStdString();
+		key.font = drawer.GetFont();
+		key.color = drawer.GetColor();
+		key.outlineColor = drawer.GetOutlineColor();
+		key.style = drawer.GetStyle();
+		key.outlineThickness = drawer.GetOutlineThickness();
+		key.characterSize = drawer.GetCharacterSize();
+
+		auto it = s_layoutCache.find(key);
+		if (it != s_layoutCache.end())
+			return *it->second;
+
+		if (s_layoutCache.size() >= MaxCachedLayouts)
+			s_layoutCache.clear();
+
+		// Every text shares the same material, allowing the renderer to draw them in a single batch (per atlas texture)
+		Nz::TextSpriteRef textSprite = Nz::TextSprite::New();
+		textSprite->SetMaterial(Nz::MaterialLibrary::Get("Text"));
+		textSprite->Update(drawer);
+
+		return *s_layoutCache.emplace(std::move(key), std::move(textSprite)).first->second;
+	}
+
 	void Text::UpdateTextSprite()
 	{
-		m_textSprite->Update(m_drawer);
+		// Copying the cached sprite keeps the instance attached to the entity, only its color has to be restored
+		Nz::Color color = m_textSprite->GetColor();
+		*m_textSprite = GetCachedLayout(m_drawer);
+		m_textSprite->SetColor(color);
 	}
 
 	void Text::UpdateTransformMatrix()
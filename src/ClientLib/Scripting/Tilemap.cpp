@@ -18,31 +18,57 @@ namespace bw
 		if (show == m_isVisible)
 			return;
 
-		if (show)
-			m_visualEntity->AttachRenderable(m_tilemap, m_transformMatrix, m_renderOrder);
-		else
-			m_visualEntity->DetachRenderable(m_tilemap);
+		for (std::size_t i = 0; i < m_chunks.size(); ++i)
+		{
+			const Nz::TileMapRef& chunk = m_chunks[i];
+			if (!chunk)
+				continue;
+
+			if (show)
+				m_visualEntity->AttachRenderable(chunk, GetChunkMatrix(i), m_renderOrder);
+			else
+				m_visualEntity->DetachRenderable(chunk);
+		}
 
 		m_isVisible = show;
 	}
 
 	void Tilemap::SetTileColor(unsigned int x, unsigned int y, const Nz::Color& color)
 	{
-		const Nz::Vector2ui& mapSize = m_tilemap->GetMapSize();
-		if (x >= mapSize.x || y >= mapSize.y)
+		if (x >= m_mapSize.x || y >= m_mapSize.y)
 			throw std::runtime_error("tile position out of range");
 
-		Nz::Vector2ui tilePos(x, y);
+		// Only the chunk owning the tile gets rebuilt
+		const Nz::TileMapRef& chunk = m_chunks[(y / m_chunkSize.y) * m_chunkCount.x + x / m_chunkSize.x];
+		if (!chunk)
+			return;
+
+		Nz::Vector2ui tilePos(x % m_chunkSize.x, y % m_chunkSize.y);
 
-		const auto& tileData = m_tilemap->GetTile(tilePos);
+		const auto& tileData = chunk->GetTile(tilePos);
 		if (!tileData.enabled)
 			return;
 
-		m_tilemap->EnableTile(tilePos, tileData.textureCoords, color, tileData.layerIndex);
+		chunk->EnableTile(tilePos, tileData.textureCoords, color, tileData.layerIndex);
+	}
+
+	Nz::Matrix4f Tilemap::GetChunkMatrix(std::size_t chunkIndex) const
+	{
+		Nz::Vector2ui chunkPos(static_cast<unsigned int>(chunkIndex % m_chunkCount.x), static_cast<unsigned int>(chunkIndex / m_chunkCount.x));
+		Nz::Vector2f chunkOffset = Nz::Vector2f(chunkPos * m_chunkSize) * m_tileSize;
+
+		return Nz::Matrix4f::ConcatenateAffine(Nz::Matrix4f::Translate(chunkOffset), m_transformMatrix);
 	}
 
 	void Tilemap::UpdateTransformMatrix()
 	{
-		m_visualEntity->UpdateRenderableMatrix(m_tilemap, m_transformMatrix);
+		if (!m_isVisible)
+			return;
+
+		for (std::size_t i = 0; i < m_chunks.size(); ++i)
+		{
+			if (const Nz::TileMapRef& chunk = m_chunks[i])
+				m_visualEntity->UpdateRenderableMatrix(chunk, GetChunkMatrix(i));
+		}
 	}
 }
@@ -42,14 +42,14 @@ namespace bw
 			m_layerSound->UnregisterAudibleSound(this);
 	}
 
-	void SoundEntity::PlaySound(std::size_t soundIndex, const Nz::SoundBufferRef& soundBuffer, bool isLooping, bool isSpatialized)
+	void SoundEntity::PlaySound(std::size_t soundIndex, const Nz::SoundBufferRef& soundBuffer, bool isLooping, bool isSpatialized, float priority)
 	{
 		if (soundIndex >= m_soundIds.size())
 			m_soundIds.resize(soundIndex + 1);
 
 		auto& nodeComponent = m_entity->GetComponent<Ndk::NodeComponent>();
 		auto& soundEmitterComponent = m_entity->GetComponent<SoundEmitterComponent>();
-		m_soundIds[soundIndex] = soundEmitterComponent.PlaySound(soundBuffer, nodeComponent.GetPosition(), true, isLooping, isSpatialized);
+		m_soundIds[soundIndex] = soundEmitterComponent.PlaySound(soundBuffer, nodeComponent.GetPosition(), true, isLooping, isSpatialized, priority);
 	}
 
 	void SoundEntity::StopSound(std::size_t soundIndex)
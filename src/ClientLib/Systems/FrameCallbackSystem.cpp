@@ -18,7 +18,7 @@ namespace bw
 
 	void FrameCallbackSystem::OnEntityRemoved(Ndk::Entity* entity)
 	{
-		m_frameUpdateEntities.Remove(entity);
+		m_scheduler.Remove(entity);
 	}
 
 	void FrameCallbackSystem::OnEntityValidation(Ndk::Entity* entity, bool /*justAdded*/)
@@ -26,19 +26,14 @@ namespace bw
 		auto& scriptComponent = entity->GetComponent<ScriptComponent>();
 
 		if (scriptComponent.HasCallbacks(ElementEvent::Frame))
-			m_frameUpdateEntities.Insert(entity);
+			m_scheduler.Insert(entity);
 		else
-			m_frameUpdateEntities.Remove(entity);
+			m_scheduler.Remove(entity);
 	}
 
-	void FrameCallbackSystem::OnUpdate(float /*elapsedTime*/)
+	void FrameCallbackSystem::OnUpdate(float elapsedTime)
 	{
-		for (const Ndk::EntityHandle& entity : m_frameUpdateEntities)
-		{
-			auto& scriptComponent = entity->GetComponent<ScriptComponent>();
-
-			scriptComponent.ExecuteCallback<ElementEvent::Frame>();
-		}
+		m_scheduler.Update(elapsedTime);
 	}
 
 	Ndk::SystemIndex FrameCallbackSystem::systemIndex;
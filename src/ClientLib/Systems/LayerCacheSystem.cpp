@@ -0,0 +1,28 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/Systems/LayerCacheSystem.hpp>
+#include <ClientLib/Components/LayerCacheComponent.hpp>
+#include <NDK/Components/NodeComponent.hpp>
+
+namespace bw
+{
+	LayerCacheSystem::LayerCacheSystem()
+	{
+		Requires<LayerCacheComponent, Ndk::NodeComponent>();
+		SetMaximumUpdateRate(0);
+	}
+
+	void LayerCacheSystem::OnUpdate(float /*elapsedTime*/)
+	{
+		for (const Ndk::EntityHandle& entity : GetEntities())
+		{
+			auto& layerCache = entity->GetComponent<LayerCacheComponent>();
+			if (layerCache.IsInvalidated())
+				layerCache.Refresh();
+		}
+	}
+
+	Ndk::SystemIndex LayerCacheSystem::systemIndex;
+}
@@ -0,0 +1,85 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/Systems/ParticleUpdateSystem.hpp>
+#include <CoreLib/ConfigFile.hpp>
+#include <NDK/Components/ParticleGroupComponent.hpp>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace bw
+{
+	ParticleUpdateSystem::ParticleUpdateSystem(ConfigFile& playerSettings) :
+	m_hasViewRect(false)
+	{
+		Requires<Ndk::ParticleGroupComponent>();
+
+		// Keep a core for the main thread (which takes part in the update) and the rest of the process (network, audio)
+		unsigned int hardwareThreadCount = std::thread::hardware_concurrency();
+		std::size_t workerCount = (hardwareThreadCount > 2) ? std::min<std::size_t>(hardwareThreadCount - 2, 3) : 0;
+		if (workerCount > 0)
+			m_workerPool = std::make_unique<WorkerPool>(workerCount);
+
+		m_particleBudget = playerSettings.GetIntegerValue<unsigned int>("Graphics.ParticleBudget");
+		m_remainingBudget = m_particleBudget;
+		m_particleBudgetUpdateSlot.Connect(playerSettings.GetIntegerUpdateSignal("Graphics.ParticleBudget"), [this](long long newValue)
+		{
+			m_particleBudget = static_cast<unsigned int>(newValue);
+		});
+	}
+
+	unsigned int ParticleUpdateSystem::AcquireParticles(unsigned int particleCount)
+	{
+		particleCount = std::min(particleCount, m_remainingBudget);
+		m_remainingBudget -= particleCount;
+
+		return particleCount;
+	}
+
+	unsigned int ParticleUpdateSystem::AcquireParticles(unsigned int particleCount, const Nz::Vector2f& position)
+	{
+		// Level of detail: particles emitted out of view are reduced with the distance to the view
+		if (m_hasViewRect && !m_viewRect.Contains(position))
+		{
+			float distX = std::max({ m_viewRect.x - position.x, 0.f, position.x - (m_viewRect.x + m_viewRect.width) });
+			float distY = std::max({ m_viewRect.y - position.y, 0.f, position.y - (m_viewRect.y + m_viewRect.height) });
+			float distance = std::sqrt(distX * distX + distY * distY);
+
+			float factor = std::max(1.f - distance / LodFadeDistance, 0.f);
+			particleCount = static_cast<unsigned int>(std::ceil(particleCount * factor));
+		}
+
+		return AcquireParticles(particleCount);
+	}
+
+	void ParticleUpdateSystem::OnUpdate(float elapsedTime)
+	{
+		m_remainingBudget = m_particleBudget;
+
+		const auto& entities = GetEntities();
+
+		std::vector<Ndk::ParticleGroupComponent*> groups;
+		groups.reserve(entities.size());
+		for (const Ndk::EntityHandle& entity : entities)
+			groups.push_back(&entity->GetComponent<Ndk::ParticleGroupComponent>());
+
+		// Groups only touch their own particles (controllers are stateless functions), they can be updated concurrently
+		if (m_workerPool)
+		{
+			m_workerPool->ForEach(groups.size(), [&](std::size_t groupIndex)
+			{
+				groups[groupIndex]->Update(elapsedTime);
+			});
+		}
+		else
+		{
+			for (Ndk::ParticleGroupComponent* group : groups)
+				group->Update(elapsedTime);
+		}
+	}
+
+	Ndk::SystemIndex ParticleUpdateSystem::systemIndex;
+}
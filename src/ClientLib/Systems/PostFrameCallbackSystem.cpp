@@ -18,7 +18,7 @@ namespace bw
 
 	void PostFrameCallbackSystem::OnEntityRemoved(Ndk::Entity* entity)
 	{
-		m_frameUpdateEntities.Remove(entity);
+		m_scheduler.Remove(entity);
 	}
 
 	void PostFrameCallbackSystem::OnEntityValidation(Ndk::Entity* entity, bool /*justAdded*/)
@@ -26,19 +26,14 @@ namespace bw
 		auto& scriptComponent = entity->GetComponent<ScriptComponent>();
 
 		if (scriptComponent.HasCallbacks(ElementEvent::PostFrame))
-			m_frameUpdateEntities.Insert(entity);
+			m_scheduler.Insert(entity);
 		else
-			m_frameUpdateEntities.Remove(entity);
+			m_scheduler.Remove(entity);
 	}
 
-	void PostFrameCallbackSystem::OnUpdate(float /*elapsedTime*/)
+	void PostFrameCallbackSystem::OnUpdate(float elapsedTime)
 	{
-		for (const Ndk::EntityHandle& entity : m_frameUpdateEntities)
-		{
-			auto& scriptComponent = entity->GetComponent<ScriptComponent>();
-
-			scriptComponent.ExecuteCallback<ElementEvent::PostFrame>();
-		}
+		m_scheduler.Update(elapsedTime);
 	}
 
 	Ndk::SystemIndex PostFrameCallbackSystem::systemIndex;
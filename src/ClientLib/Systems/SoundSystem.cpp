@@ -6,16 +6,20 @@
 #include <CoreLib/ConfigFile.hpp>
 #include <Nazara/Audio/Audio.hpp>
 #include <Nazara/Audio/SoundBuffer.hpp>
+#include <Nazara/Core/Clock.hpp>
 #include <NDK/Components/NodeComponent.hpp>
 #include <ClientLib/Components/SoundEmitterComponent.hpp>
-#include <array>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 namespace bw
 {
 	SoundSystem::SoundSystem(ConfigFile& playerSettings) :
-	m_maxSoundInPool(32),
+	m_maxVoiceCount(32),
 	m_soundOffset(0.f, 0.f, 50.f),
-	m_nextSoundId(1)
+	m_nextSoundId(1),
+	m_lastUpdateDuration(0)
 	{
 		Requires<SoundEmitterComponent>();
 
@@ -26,80 +30,154 @@ namespace bw
 		});
 	}
 
-	Nz::UInt32 SoundSystem::PlaySound(const Nz::SoundBufferRef& soundBuffer, const Nz::Vector3f& soundPosition, bool attachedToEntity, bool isLooping, bool isSpatialized)
+	Nz::UInt32 SoundSystem::PlaySound(const Nz::SoundBufferRef& soundBuffer, const Nz::Vector3f& soundPosition, bool attachedToEntity, bool isLooping, bool isSpatialized, float priority)
 	{
+		// A burst of the same sound (mass gunfire, explosions chain) isn't louder past a few instances, drop the extra ones
+		std::size_t& startedCount = m_frameStartedSounds[soundBuffer.Get()];
+		if (startedCount >= MaxIdenticalSoundsPerFrame)
+			return InvalidSoundId;
+
+		startedCount++;
+
 		Nz::UInt32 soundId = m_nextSoundId++;
 		// Prevent sound id to be invalid sound id
 		if (soundId == InvalidSoundId)
 			soundId = m_nextSoundId++;
 
-		std::size_t entryIndex = std::numeric_limits<std::size_t>::max();
-		if (m_soundPool.size() >= m_maxSoundInPool)
+		SoundData& soundData = m_sounds[soundId];
+		soundData.attachedToEntity = attachedToEntity;
+		soundData.buffer = soundBuffer;
+		soundData.duration = soundBuffer->GetDuration();
+		soundData.isLooping = isLooping;
+		soundData.isSpatialized = isSpatialized;
+		soundData.justStarted = true;
+		soundData.playingOffset = 0.f;
+		soundData.position = soundPosition + m_soundOffset;
+		soundData.priority = std::max(priority, 0.f);
+		soundData.velocity = Nz::Vector3f::Zero();
+		soundData.voiceIndex = NoVoice;
+
+		return soundId;
+	}
+
+	void SoundSystem::StopSound(Nz::UInt32 soundId)
+	{
+		auto it = m_sounds.find(soundId);
+		if (it == m_sounds.end())
+			return;
+
+		if (std::size_t voiceIndex = it->second.voiceIndex; voiceIndex != NoVoice)
 		{
-			// Find oldest entry
-			float bestScore = -std::numeric_limits<float>::infinity();
+			Voice& voice = m_voices[voiceIndex];
+			voice.sound.Stop();
+			voice.soundId = InvalidSoundId;
+		}
+
+		m_sounds.erase(it);
+	}
+
+	void SoundSystem::UpdateVoices()
+	{
+		Nz::Vector3f listenerPosition = Nz::Audio::GetListenerPosition();
 
-			for (auto it = m_soundPool.begin(); it != m_soundPool.end(); ++it)
+		// Score every logical sound by how loud it would be heard, inaudible ones are culled before reaching spatialization
+		m_voiceCandidates.clear();
+		for (auto&& [soundId, soundData] : m_sounds)
+		{
+			float gain = 1.f;
+			if (soundData.isSpatialized)
 			{
-				auto& soundEntry = *it;
-				if (!soundEntry.sound.IsPlaying())
-				{
-					entryIndex = std::distance(m_soundPool.begin(), it);
-					break;
-				}
+				float distance = listenerPosition.Distance(soundData.position);
+				if (distance > MaxAudibleDistance)
+					continue;
 
-				float score = 1.f - float(soundEntry.sound.GetPlayingOffset()) / soundEntry.sound.GetDuration();
-				if (score > bestScore)
-				{
-					bestScore = score;
-					entryIndex = std::distance(m_soundPool.begin(), it);
-				}
+				// Same inverse distance attenuation OpenAL applies to our voices
+				gain = SoundMinDistance / (SoundMinDistance + std::max(distance - SoundMinDistance, 0.f));
 			}
 
-			assert(entryIndex < m_soundPool.size());
-			auto& entry = m_soundPool[entryIndex];
-			entry.sound.Stop();
-			m_playingSounds.erase(entry.playingSoundId);
+			float score = soundData.priority * gain;
+			if (score <= 0.f)
+				continue;
+
+			// Favor sounds already holding a voice, so two sounds of similar score don't keep stealing each other voice
+			if (soundData.voiceIndex != NoVoice)
+				score *= 1.1f;
+
+			m_voiceCandidates.emplace_back(score, soundId);
 		}
-		else
+
+		if (m_voiceCandidates.size() > m_maxVoiceCount)
 		{
-			entryIndex = m_soundPool.size();
-			auto& newSound = m_soundPool.emplace_back();
-			newSound.sound.SetMinDistance(200);
-			newSound.sound.SetVolume(m_volume);
+			std::nth_element(m_voiceCandidates.begin(), m_voiceCandidates.begin() + m_maxVoiceCount, m_voiceCandidates.end(), [](const auto& lhs, const auto& rhs)
+			{
+				return lhs.first > rhs.first;
+			});
+
+			m_voiceCandidates.resize(m_maxVoiceCount);
 		}
 
-		auto& entry = m_soundPool[entryIndex];
-		entry.attachedToEntity = attachedToEntity;
-		entry.playingSoundId = soundId;
-		entry.sound.SetBuffer(soundBuffer);
-		entry.sound.EnableLooping(isLooping);
-		entry.sound.EnableSpatialization(isSpatialized);
-		entry.sound.SetPosition(soundPosition + m_soundOffset);
-		entry.sound.Play();
+		// Virtualize culled sounds and those outside of the top ones, they keep advancing their playing offset without being mixed
+		for (Voice& voice : m_voices)
+		{
+			if (voice.soundId == InvalidSoundId)
+				continue;
 
-		m_playingSounds.emplace(soundId, entryIndex);
+			bool isCandidate = std::any_of(m_voiceCandidates.begin(), m_voiceCandidates.end(), [&](const auto& candidate) { return candidate.second == voice.soundId; });
+			if (!isCandidate)
+			{
+				auto it = m_sounds.find(voice.soundId);
+				assert(it != m_sounds.end());
+				it.value().voiceIndex = NoVoice;
 
-		return soundId;
-	}
+				voice.sound.Stop();
+				voice.soundId = InvalidSoundId;
+			}
+		}
 
-	void SoundSystem::StopSound(Nz::UInt32 soundId)
-	{
-		auto it = m_playingSounds.find(soundId);
-		if (it == m_playingSounds.end())
-			return;
+		std::size_t freeVoiceIndex = 0;
+		for (auto&& [score, soundId] : m_voiceCandidates)
+		{
+			SoundData& soundData = m_sounds.find(soundId).value();
+			if (soundData.voiceIndex != NoVoice)
+			{
+				Voice& voice = m_voices[soundData.voiceIndex];
+				voice.sound.SetPosition(soundData.position);
+				voice.sound.SetVelocity(soundData.velocity);
+				continue;
+			}
+
+			while (freeVoiceIndex < m_voices.size() && m_voices[freeVoiceIndex].soundId != InvalidSoundId)
+				freeVoiceIndex++;
 
-		auto& soundEntry = m_soundPool[it->second];
-		soundEntry.sound.Stop();
+			if (freeVoiceIndex == m_voices.size())
+			{
+				auto& newVoice = m_voices.emplace_back();
+				newVoice.sound.SetMinDistance(SoundMinDistance);
+				newVoice.sound.SetVolume(m_volume);
+			}
 
-		m_playingSounds.erase(it);
+			Voice& voice = m_voices[freeVoiceIndex];
+			voice.soundId = soundId;
+			voice.sound.SetBuffer(soundData.buffer);
+			voice.sound.EnableLooping(soundData.isLooping);
+			voice.sound.EnableSpatialization(soundData.isSpatialized);
+			voice.sound.SetPosition(soundData.position);
+			voice.sound.SetVelocity(soundData.velocity);
+			voice.sound.Play();
+
+			// Resume a virtualized sound where it would have been
+			if (soundData.playingOffset > 0.f)
+				voice.sound.SetPlayingOffset(static_cast<Nz::UInt32>(soundData.playingOffset));
+
+			soundData.voiceIndex = freeVoiceIndex;
+		}
 	}
 
 	void SoundSystem::UpdateVolume(float newVolume)
 	{
 		m_volume = newVolume;
-		for (SoundData& soundData : m_soundPool)
-			soundData.sound.SetVolume(newVolume);
+		for (Voice& voice : m_voices)
+			voice.sound.SetVolume(newVolume);
 	}
 
 	void SoundSystem::OnEntityRemoved(Ndk::Entity* entity)
@@ -124,12 +202,45 @@ namespace bw
 
 	void SoundSystem::OnUpdate(float elapsedTime)
 	{
+		Nz::UInt64 updateStart = Nz::GetElapsedMicroseconds();
+
 		float invElapsedTime = 1.f / elapsedTime;
+		float elapsedMs = elapsedTime * 1000.f;
+
+		m_frameStartedSounds.clear();
 
-		for (auto& soundEntry : m_soundPool)
+		for (auto it = m_sounds.begin(); it != m_sounds.end();)
 		{
-			if (!soundEntry.sound.IsPlaying())
-				m_playingSounds.erase(soundEntry.playingSoundId);
+			SoundData& soundData = it.value();
+
+			// Sounds started since last update begin at offset zero
+			if (soundData.justStarted)
+			{
+				soundData.justStarted = false;
+				++it;
+				continue;
+			}
+
+			soundData.playingOffset += elapsedMs;
+			if (soundData.playingOffset >= soundData.duration)
+			{
+				if (soundData.isLooping && soundData.duration > 0)
+					soundData.playingOffset = std::fmod(soundData.playingOffset, float(soundData.duration));
+				else
+				{
+					if (soundData.voiceIndex != NoVoice)
+					{
+						Voice& voice = m_voices[soundData.voiceIndex];
+						voice.sound.Stop();
+						voice.soundId = InvalidSoundId;
+					}
+
+					it = m_sounds.erase(it);
+					continue;
+				}
+			}
+
+			++it;
 		}
 
 		for (const Ndk::EntityHandle& movableEntity : m_movableEntities)
@@ -148,23 +259,27 @@ namespace bw
 			{
 				Nz::UInt32 soundId = *ownedSoundIt;
 
-				auto it = m_playingSounds.find(soundId);
-				if (it == m_playingSounds.end())
+				auto it = m_sounds.find(soundId);
+				if (it == m_sounds.end())
 				{
 					ownedSoundIt = ownedSound.erase(ownedSoundIt);
 					continue;
 				}
 
-				auto& soundEntry = m_soundPool[it->second];
-				if (soundEntry.attachedToEntity)
+				SoundData& soundData = it.value();
+				if (soundData.attachedToEntity)
 				{
-					soundEntry.sound.SetPosition(entityPos + m_soundOffset);
-					soundEntry.sound.SetVelocity(velocity);
+					soundData.position = entityPos + m_soundOffset;
+					soundData.velocity = velocity;
 				}
 
 				++ownedSoundIt;
 			}
 		}
+
+		UpdateVoices();
+
+		m_lastUpdateDuration = Nz::GetElapsedMicroseconds() - updateStart;
 	}
 
 	Ndk::SystemIndex SoundSystem::systemIndex;
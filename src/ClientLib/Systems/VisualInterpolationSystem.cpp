@@ -27,24 +27,81 @@ namespace bw
 
 	void VisualInterpolationSystem::OnUpdate(float elapsedTime)
 	{
+		constexpr float MaxSmoothedDistance = 128.f;
+		constexpr float PositionEpsilon = 0.01f;
+		constexpr float RotationEpsilon = 0.0001f;
+
 		float C = 10.f;
 		float factor = 1.f - std::exp(-elapsedTime * C);
 
-		for (const Ndk::EntityHandle& entity : GetEntities())
+		const auto& entities = GetEntities();
+		std::size_t entityCount = entities.size();
+
+		m_positionsX.resize(entityCount);
+		m_positionsY.resize(entityCount);
+		m_rotations.resize(entityCount);
+		m_targetPositionsX.resize(entityCount);
+		m_targetPositionsY.resize(entityCount);
+		m_targetRotations.resize(entityCount);
+
+		std::size_t entityIndex = 0;
+		for (const Ndk::EntityHandle& entity : entities)
 		{
 			auto& entityLerp = entity->GetComponent<VisualInterpolationComponent>();
-			auto& entityNode = entity->GetComponent<Ndk::NodeComponent>();
 			auto& entityPhysics = entity->GetComponent<Ndk::PhysicsComponent2D>();
 
-			// x = x + (target-x) * (1-Exp(-deltaTime*C))
-			Nz::RadianAnglef sourceRot = entityLerp.GetLastRotation();
-			Nz::RadianAnglef targetRot = entityPhysics.GetRotation();
 			Nz::Vector2f sourcePos = entityLerp.GetLastPosition();
 			Nz::Vector2f targetPos = entityPhysics.GetPosition();
+			float sourceRotation = entityLerp.GetLastRotation().value;
+			float targetRotation = entityPhysics.GetRotation().value;
+
+			// Bodies are extrapolated between server updates, small corrections are smoothed but big ones (teleports, respawns) would slide across the map
+			if (sourcePos.SquaredDistance(targetPos) > MaxSmoothedDistance * MaxSmoothedDistance)
+			{
+				sourcePos = targetPos;
+				sourceRotation = targetRotation;
+			}
+
+			m_positionsX[entityIndex] = sourcePos.x;
+			m_positionsY[entityIndex] = sourcePos.y;
+			m_rotations[entityIndex] = sourceRotation;
+			m_targetPositionsX[entityIndex] = targetPos.x;
+			m_targetPositionsY[entityIndex] = targetPos.y;
+			m_targetRotations[entityIndex] = targetRotation;
+
+			entityIndex++;
+		}
 
-			Nz::RadianAnglef rotation = sourceRot + (targetRot - sourceRot) * factor;
-			Nz::Vector2f position = sourcePos + (targetPos - sourcePos) * factor;
+		// x = x + (target-x) * (1-Exp(-deltaTime*C)), snapping to the target once close enough so resting entities stop changing
+		auto Interpolate = [&](std::vector<float>& values, const std::vector<float>& targets, float epsilon)
+		{
+			float* valuePtr = values.data();
+			const float* targetPtr = targets.data();
+			for (std::size_t i = 0; i < entityCount; ++i)
+			{
+				float delta = targetPtr[i] - valuePtr[i];
+				valuePtr[i] = (std::abs(delta) <= epsilon) ? targetPtr[i] : valuePtr[i] + delta * factor;
+			}
+		};
+
+		Interpolate(m_positionsX, m_targetPositionsX, PositionEpsilon);
+		Interpolate(m_positionsY, m_targetPositionsY, PositionEpsilon);
+		Interpolate(m_rotations, m_targetRotations, RotationEpsilon);
+
+		entityIndex = 0;
+		for (const Ndk::EntityHandle& entity : entities)
+		{
+			auto& entityLerp = entity->GetComponent<VisualInterpolationComponent>();
+
+			Nz::Vector2f position(m_positionsX[entityIndex], m_positionsY[entityIndex]);
+			Nz::RadianAnglef rotation(m_rotations[entityIndex]);
+			entityIndex++;
 
+			// Don't invalidate the node (and everything attached to it) of entities which didn't move
+			if (position == entityLerp.GetLastPosition() && rotation == entityLerp.GetLastRotation())
+				continue;
+
+			auto& entityNode = entity->GetComponent<Ndk::NodeComponent>();
 			entityNode.SetPosition(position);
 			entityNode.SetRotation(rotation);
 
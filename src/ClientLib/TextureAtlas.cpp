@@ -0,0 +1,127 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <ClientLib/TextureAtlas.hpp>
+#include <cassert>
+
+namespace bw
+{
+	namespace
+	{
+		constexpr unsigned int RegionPadding = 1; //< transparent border between images, prevents bilinear filtering from bleeding neighbors
+	}
+
+	void TextureAtlas::Clear()
+	{
+		m_pages.clear();
+	}
+
+	auto TextureAtlas::Insert(const Nz::Image& image) -> std::optional<Region>
+	{
+		if (!CanInsert(image))
+			return std::nullopt;
+
+		unsigned int width = image.GetWidth();
+		unsigned int height = image.GetHeight();
+
+		Nz::Vector2ui position;
+		Page* targetPage = nullptr;
+		for (Page& page : m_pages)
+		{
+			if (AllocateRect(page, width, height, &position))
+			{
+				targetPage = &page;
+				break;
+			}
+		}
+
+		if (!targetPage)
+		{
+			targetPage = &CreatePage();
+
+			bool allocated = AllocateRect(*targetPage, width, height, &position);
+			NazaraUnused(allocated);
+			assert(allocated);
+		}
+
+		const Nz::UInt8* pixels;
+		Nz::Image convertedImage;
+		if (image.GetFormat() != Nz::PixelFormatType_RGBA8)
+		{
+			convertedImage = image;
+			if (!convertedImage.Convert(Nz::PixelFormatType_RGBA8))
+				return std::nullopt;
+
+			pixels = convertedImage.GetConstPixels();
+		}
+		else
+			pixels = image.GetConstPixels();
+
+		if (!targetPage->texture->Update(pixels, Nz::Rectui(position.x, position.y, width, height)))
+			return std::nullopt;
+
+		float invPageSize = 1.f / m_pageSize;
+
+		Region region;
+		region.material = targetPage->material;
+		region.size = Nz::Vector2f(float(width), float(height));
+		region.textureCoords = Nz::Rectf(position.x * invPageSize, position.y * invPageSize, width * invPageSize, height * invPageSize);
+
+		return region;
+	}
+
+	bool TextureAtlas::AllocateRect(Page& page, unsigned int width, unsigned int height, Nz::Vector2ui* position) const
+	{
+		unsigned int paddedWidth = width + RegionPadding;
+		unsigned int paddedHeight = height + RegionPadding;
+
+		// Shelf packing: pick the lowest shelf the image fits in, sprites of a mod tend to have similar heights
+		Shelf* bestShelf = nullptr;
+		for (Shelf& shelf : page.shelves)
+		{
+			if (shelf.height < paddedHeight || shelf.nextX + paddedWidth > m_pageSize)
+				continue;
+
+			if (!bestShelf || shelf.height < bestShelf->height)
+				bestShelf = &shelf;
+		}
+
+		if (!bestShelf)
+		{
+			if (page.nextShelfY + paddedHeight > m_pageSize)
+				return false;
+
+			bestShelf = &page.shelves.emplace_back();
+			bestShelf->height = paddedHeight;
+			bestShelf->nextX = 0;
+			bestShelf->y = page.nextShelfY;
+
+			page.nextShelfY += paddedHeight;
+		}
+
+		position->x = bestShelf->nextX;
+		position->y = bestShelf->y;
+
+		bestShelf->nextX += paddedWidth;
+
+		return true;
+	}
+
+	auto TextureAtlas::CreatePage() -> Page&
+	{
+		Page& page = m_pages.emplace_back();
+		page.texture = Nz::Texture::New();
+		page.texture->Create(Nz::ImageType_2D, Nz::PixelFormatType_RGBA8, m_pageSize, m_pageSize);
+
+		// Padding has to be transparent
+		std::vector<Nz::UInt8> emptyPixels(std::size_t(m_pageSize) * m_pageSize * 4, 0);
+		page.texture->Update(emptyPixels.data());
+
+		page.material = Nz::Material::New("Translucent2D");
+		page.material->SetDiffuseMap(page.texture);
+		page.material->GetDiffuseSampler().SetFilterMode(Nz::SamplerFilter_Bilinear);
+
+		return page;
+	}
+}
@@ -75,6 +75,31 @@ namespace bw
 		}
 	}
 
+	void VisualEntity::Update(const Nz::Vector2f& position, const Nz::Quaternionf& rotation, const Nz::Vector2f& scale, const Nz::Rectf& viewRect)
+	{
+		auto& visualNode = m_entity->GetComponent<Ndk::NodeComponent>();
+
+		// Renderables are still where they were last synchronized, only skip entities which were and stay out of view
+		const Nz::Boxf& aabb = m_entity->GetComponent<Ndk::GraphicsComponent>().GetAABB();
+		Nz::Rectf currentBounds(aabb.x, aabb.y, aabb.width, aabb.height);
+		Nz::Vector2f currentPosition = Nz::Vector2f(visualNode.GetPosition(Nz::CoordSys_Global));
+
+		if (!viewRect.Intersect(currentBounds) && !viewRect.Contains(currentPosition))
+		{
+			const Nz::Node* parentNode = visualNode.GetParent();
+			Nz::Vector2f newPosition = (parentNode) ? Nz::Vector2f(parentNode->ToGlobalPosition(Nz::Vector3f(position.x, position.y, 0.f))) : position;
+
+			Nz::Rectf newBounds = currentBounds;
+			newBounds.x += newPosition.x - currentPosition.x;
+			newBounds.y += newPosition.y - currentPosition.y;
+
+			if (!viewRect.Intersect(newBounds) && !viewRect.Contains(newPosition))
+				return;
+		}
+
+		Update(position, rotation, scale);
+	}
+
 	void VisualEntity::AttachHoveringRenderable(Nz::InstancedRenderableRef renderable, const Nz::Matrix4f& offsetMatrix, int renderOrder, float hoverOffset)
 	{
 		auto& hoveringRenderable = m_hoveringRenderables.emplace_back();
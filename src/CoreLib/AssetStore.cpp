@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/AssetStore.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
 
 namespace bw
 {
@@ -10,7 +11,9 @@ namespace bw
 
 	void AssetStore::Clear()
 	{
+		m_checksumPaths.clear();
 		m_images.clear();
+		m_sourcePaths.clear();
 	}
 
 	const Nz::ImageRef& AssetStore::GetImage(const std::string& imagePath) const
@@ -19,4 +22,39 @@ namespace bw
 
 		return GetResource(imagePath, m_images, loaderParameters);
 	}
+
+	void AssetStore::ImportAssets(const AssetStore& assetStore)
+	{
+		std::size_t importedCount = ImportResources(assetStore, assetStore.m_images, m_images);
+		bwLog(m_logger, LogLevel::Debug, "imported {0} image(s)", importedCount);
+	}
+
+	void AssetStore::RegisterAssetChecksum(const std::string& assetPath, const std::array<Nz::UInt8, 20>& sha1Checksum)
+	{
+		std::string checksum(sha1Checksum.begin(), sha1Checksum.end());
+
+		auto it = m_checksumPaths.find(checksum);
+		if (it == m_checksumPaths.end())
+		{
+			m_checksumPaths.emplace(std::move(checksum), assetPath);
+			return;
+		}
+
+		if (it->second != assetPath)
+			m_sourcePaths.insert_or_assign(assetPath, it->second);
+	}
+
+	bool AssetStore::IsSameAsset(const AssetStore& assetStore, const std::string& assetPath) const
+	{
+		// Only physical files can be told apart cheaply, in-memory and packed entries are loaded again
+		VirtualDirectory::Entry entry;
+		if (!m_assetDirectory->GetEntry(assetPath, &entry) || !std::holds_alternative<VirtualDirectory::PhysicalFileEntry>(entry))
+			return false;
+
+		VirtualDirectory::Entry sourceEntry;
+		if (!assetStore.m_assetDirectory->GetEntry(assetPath, &sourceEntry) || !std::holds_alternative<VirtualDirectory::PhysicalFileEntry>(sourceEntry))
+			return false;
+
+		return std::get<VirtualDirectory::PhysicalFileEntry>(entry) == std::get<VirtualDirectory::PhysicalFileEntry>(sourceEntry);
+	}
 }
@@ -0,0 +1,282 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/BinaryMapReader.hpp>
+#include <CoreLib/Protocol/CompressedInteger.hpp>
+#include <CoreLib/Utility/MemoryMappedFile.hpp>
+#include <Nazara/Core/AbstractHash.hpp>
+#include <Nazara/Core/ByteArray.hpp>
+#include <Nazara/Core/ByteStream.hpp>
+#include <Nazara/Core/ErrorFlags.hpp>
+#include <Nazara/Core/File.hpp>
+#include <Nazara/Core/MemoryView.hpp>
+#include <lz4.h>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace bw
+{
+	BinaryMapReader::BinaryMapReader(const std::filesystem::path& mapFile) :
+	m_gameVersion(0)
+	{
+		// Map the whole file, sections are then read (or referenced) straight from the mapping
+		std::shared_ptr<MemoryMappedFile> mapping = std::make_shared<MemoryMappedFile>();
+		if (mapping->Open(mapFile))
+		{
+			m_data = mapping->GetData();
+			m_size = mapping->GetSize();
+			m_mapping = std::move(mapping);
+		}
+		else
+		{
+			Nz::File infoFile(mapFile.generic_u8string(), Nz::OpenMode_ReadOnly);
+			if (!infoFile.IsOpen())
+				throw std::runtime_error("failed to open map file");
+
+			// Load the whole file at once, reading it in small chunks (as compressed integers do) from the disk is slow
+			m_content.resize(infoFile.GetSize());
+			if (infoFile.Read(m_content.data(), m_content.size()) != m_content.size())
+				throw std::runtime_error("failed to read map file");
+
+			m_data = m_content.data();
+			m_size = m_content.size();
+		}
+
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		Nz::MemoryView fileView(m_data, m_size);
+
+		Nz::ByteStream stream(&fileView);
+		stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		std::array<char, 8> signature;
+		if (stream.Read(signature.data(), signature.size()) != signature.size())
+			throw std::runtime_error("corrupted map file (or not a burger map file)");
+
+		if (std::memcmp(signature.data(), "Burgrmap", signature.size()) != 0)
+			throw std::runtime_error("not a valid burger map file");
+
+		stream >> m_fileVersion;
+
+		if (m_fileVersion > Map::BinaryFileVersion)
+			throw std::runtime_error("unhandled file version (more recent than game)");
+
+		// Map header
+		stream >> m_mapInfo.name >> m_mapInfo.author >> m_mapInfo.description;
+
+		// For debugging purpose
+		if (m_fileVersion >= 1)
+			stream >> m_gameVersion;
+
+		if (HasSectionTable())
+		{
+			auto ReadSection = [&](Section& section)
+			{
+				stream >> section.offset >> section.size;
+				section.uncompressedSize = section.size;
+
+				if (m_fileVersion >= Map::CompressedSectionFileVersion)
+				{
+					Nz::UInt8 compression;
+					stream >> compression;
+
+					section.compression = static_cast<Compression>(compression);
+					switch (section.compression)
+					{
+						case Compression::None:
+							break;
+
+						case Compression::LZ4:
+							stream >> section.uncompressedSize;
+							break;
+
+						default:
+							throw std::runtime_error("unhandled section compression " + std::to_string(compression));
+					}
+
+					auto& checksum = section.checksum.emplace();
+					if (stream.Read(checksum.data(), checksum.size()) != checksum.size())
+						throw std::runtime_error("corrupted map file (truncated section table)");
+				}
+			};
+
+			CompressedUnsigned<Nz::UInt16> layerCount;
+			stream >> layerCount;
+
+			m_layers.resize(layerCount);
+			for (LayerSection& layer : m_layers)
+			{
+				stream >> layer.name;
+
+				CompressedUnsigned<Nz::UInt16> entityCount;
+				stream >> entityCount;
+				layer.entityCount = entityCount;
+
+				ReadSection(layer.data);
+			}
+
+			CompressedUnsigned<Nz::UInt32> scriptCount;
+			stream >> scriptCount;
+
+			m_scripts.resize(scriptCount);
+			for (ScriptSection& script : m_scripts)
+			{
+				stream >> script.filepath;
+				ReadSection(script.content);
+				ReadSection(script.bytecode);
+			}
+
+			ReadSection(m_assets);
+		}
+
+		m_contentOffset = static_cast<std::size_t>(fileView.GetCursorPos());
+
+		// Check every section once, so loading them later can't read out of the file
+		auto CheckSection = [&](const Section& section, const std::string& sectionName)
+		{
+			std::size_t contentSize = m_size - m_contentOffset;
+			if (section.offset > contentSize || section.size > contentSize - section.offset)
+				throw std::runtime_error("corrupted map file (" + sectionName + " section is out of bounds)");
+		};
+
+		for (const LayerSection& layer : m_layers)
+			CheckSection(layer.data, "layer " + layer.name);
+
+		for (const ScriptSection& script : m_scripts)
+		{
+			CheckSection(script.content, "script " + script.filepath);
+			CheckSection(script.bytecode, "script " + script.filepath + " bytecode");
+		}
+
+		CheckSection(m_assets, "assets");
+	}
+
+	std::vector<Map::Asset> BinaryMapReader::LoadAssets() const
+	{
+		assert(HasSectionTable());
+
+		std::vector<Nz::UInt8> buffer;
+		const Nz::UInt8* sectionData = ReadSection(m_assets, buffer, "assets");
+
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		Nz::MemoryView sectionView(sectionData, m_assets.uncompressedSize);
+
+		Nz::ByteStream stream(&sectionView);
+		stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		CompressedUnsigned<Nz::UInt32> assetCount;
+		stream >> assetCount;
+
+		std::vector<Map::Asset> assets(assetCount);
+		for (Map::Asset& asset : assets)
+		{
+			stream >> asset.filepath;
+			stream >> asset.size;
+			if (stream.Read(asset.sha1Checksum.data(), asset.sha1Checksum.size()) != asset.sha1Checksum.size())
+				throw std::runtime_error("corrupted map file (truncated asset section)");
+		}
+
+		return assets;
+	}
+
+	Map::Layer BinaryMapReader::LoadLayer(LayerIndex layerIndex) const
+	{
+		const LayerSection& layerSection = GetLayerSection(layerIndex);
+
+		std::vector<Nz::UInt8> buffer;
+		const Nz::UInt8* sectionData = ReadSection(layerSection.data, buffer, "layer " + layerSection.name);
+
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		Nz::MemoryView sectionView(sectionData, layerSection.data.uncompressedSize);
+
+		Nz::ByteStream stream(&sectionView);
+		stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		Map::Layer layer;
+		Map::ReadBinaryLayer(stream, layer, m_fileVersion);
+
+		return layer;
+	}
+
+	Map::Script BinaryMapReader::LoadScript(std::size_t scriptIndex) const
+	{
+		const ScriptSection& scriptSection = GetScriptSection(scriptIndex);
+
+		Map::Script script;
+		script.filepath = scriptSection.filepath;
+
+		std::vector<Nz::UInt8> contentBuffer;
+		const Nz::UInt8* contentData = ReadSection(scriptSection.content, contentBuffer, "script " + script.filepath);
+		std::size_t contentSize = static_cast<std::size_t>(scriptSection.content.uncompressedSize);
+
+		// Uncompressed mapped scripts are referenced in place (see Map::GetMapping), others are copied as the file content dies with us
+		if (!contentBuffer.empty())
+			script.content = std::move(contentBuffer);
+		else if (m_mapping)
+			script.mappedContent = std::string_view(reinterpret_cast<const char*>(contentData), contentSize);
+		else
+			script.content.assign(contentData, contentData + contentSize);
+
+		std::vector<Nz::UInt8> bytecodeBuffer;
+		const Nz::UInt8* bytecodeData = ReadSection(scriptSection.bytecode, bytecodeBuffer, "script " + script.filepath + " bytecode");
+		if (!bytecodeBuffer.empty())
+			script.bytecode = std::move(bytecodeBuffer);
+		else
+			script.bytecode.assign(bytecodeData, bytecodeData + scriptSection.bytecode.uncompressedSize);
+
+		return script;
+	}
+
+	auto BinaryMapReader::ComputeChecksum(const Nz::UInt8* data, std::size_t size) -> std::array<Nz::UInt8, Section::ChecksumSize>
+	{
+		auto hash = Nz::AbstractHash::Get(Nz::HashType_CRC32);
+		hash->Begin();
+		hash->Append(data, size);
+
+		Nz::ByteArray digest = hash->End();
+		assert(digest.GetSize() == Section::ChecksumSize);
+
+		std::array<Nz::UInt8, Section::ChecksumSize> checksum;
+		std::memcpy(checksum.data(), digest.GetConstBuffer(), checksum.size());
+
+		return checksum;
+	}
+
+	const Nz::UInt8* BinaryMapReader::ReadSection(const Section& section, std::vector<Nz::UInt8>& buffer, const std::string& sectionName) const
+	{
+		// Bounds were checked when parsing section table
+		const Nz::UInt8* sectionData = m_data + m_contentOffset + section.offset;
+		std::size_t sectionSize = static_cast<std::size_t>(section.size);
+
+		if (section.checksum && ComputeChecksum(sectionData, sectionSize) != *section.checksum)
+			throw std::runtime_error("corrupted map file (" + sectionName + " section checksum mismatch)");
+
+		switch (section.compression)
+		{
+			case Compression::None:
+				return sectionData;
+
+			case Compression::LZ4:
+			{
+				if (section.size > std::size_t(std::numeric_limits<int>::max()) || section.uncompressedSize > MaxUncompressedSectionSize)
+					throw std::runtime_error("corrupted map file (" + sectionName + " section is too large)");
+
+				buffer.resize(static_cast<std::size_t>(section.uncompressedSize));
+
+				int decompressedSize = LZ4_decompress_safe(reinterpret_cast<const char*>(sectionData), reinterpret_cast<char*>(buffer.data()), int(sectionSize), int(buffer.size()));
+				if (decompressedSize < 0 || std::size_t(decompressedSize) != buffer.size())
+					throw std::runtime_error("corrupted map file (failed to decompress " + sectionName + " section)");
+
+				return buffer.data();
+			}
+		}
+
+		throw std::runtime_error("unhandled section compression");
+	}
+}
@@ -16,18 +16,24 @@
 #include <CoreLib/Components/OwnerComponent.hpp>
 #include <CoreLib/Components/PlayerControlledComponent.hpp>
 #include <CoreLib/Components/PlayerMovementComponent.hpp>
+#include <CoreLib/Components/PoolableComponent.hpp>
 #include <CoreLib/Components/ScriptComponent.hpp>
 #include <CoreLib/Components/WeaponComponent.hpp>
 #include <CoreLib/Components/WeaponWielderComponent.hpp>
+#include <CoreLib/LogSystem/AsyncSink.hpp>
 #include <CoreLib/LogSystem/StdSink.hpp>
+#include <CoreLib/Scripting/ScriptBytecodeCache.hpp>
 #include <CoreLib/Systems/AnimationSystem.hpp>
+#include <CoreLib/Systems/ElementIndexSystem.hpp>
 #include <CoreLib/Systems/InputSystem.hpp>
 #include <CoreLib/Systems/NetworkSyncSystem.hpp>
 #include <CoreLib/Systems/PlayerMovementSystem.hpp>
 #include <CoreLib/Systems/TickCallbackSystem.hpp>
 #include <CoreLib/Systems/WeaponSystem.hpp>
+#include <CoreLib/Utility/JobSystem.hpp>
 #include <Nazara/Core/Clock.hpp>
 #include <Nazara/Core/Thread.hpp>
+#include <algorithm>
 #include <cassert>
 #include <thread>
 
@@ -61,7 +67,8 @@ namespace bw
 
 		InstallInterruptHandlers();
 
-		m_logger.RegisterSink(std::make_shared<StdSink>());
+		// Console output can be slow, don't make the logging thread (such as a match tick) wait for it
+		m_logger.RegisterSink(std::make_shared<AsyncSink>(std::make_shared<StdSink>()));
 		m_logger.SetMinimumLogLevel(LogLevel::Debug);
 
 		Ndk::InitializeComponent<AnimationComponent>("Anim");
@@ -75,28 +82,24 @@ namespace bw
 		Ndk::InitializeComponent<OwnerComponent>("Owner");
 		Ndk::InitializeComponent<PlayerControlledComponent>("PlyCtrl");
 		Ndk::InitializeComponent<PlayerMovementComponent>("PlyMvt");
+		Ndk::InitializeComponent<PoolableComponent>("Poolable");
 		Ndk::InitializeComponent<ScriptComponent>("Script");
 		Ndk::InitializeComponent<WeaponComponent>("Weapon");
 		Ndk::InitializeComponent<WeaponWielderComponent>("WepnWiel");
 		Ndk::InitializeSystem<AnimationSystem>();
+		Ndk::InitializeSystem<ElementIndexSystem>();
 		Ndk::InitializeSystem<InputSystem>();
 		Ndk::InitializeSystem<NetworkSyncSystem>();
 		Ndk::InitializeSystem<PlayerMovementSystem>();
 		Ndk::InitializeSystem<TickCallbackSystem>();
 		Ndk::InitializeSystem<WeaponSystem>();
-
-		std::string error;
-		if (WebService::Initialize(&error))
-		{
-			bwLog(GetLogger(), LogLevel::Debug, "libcurl has been loaded");
-			m_webService.emplace(m_logger);
-		}
-		else
-			bwLog(GetLogger(), LogLevel::Error, "failed to initialize web services ({0}), some functionalities will not work", error);
 	}
 
 	BurgApp::~BurgApp()
 	{
+		// Jobs may still use other services
+		m_jobSystem.reset();
+
 		m_webService.reset();
 		WebService::Uninitialize();
 
@@ -104,6 +107,51 @@ namespace bw
 		s_application = nullptr;
 	}
 
+	const std::shared_ptr<ScriptBytecodeCache>& BurgApp::GetBytecodeCache()
+	{
+		// Created on first use as config is not loaded yet when BurgApp is constructed, matches may ask for it from their own thread
+		std::call_once(m_bytecodeCacheFlag, [&]
+		{
+			m_bytecodeCache = std::make_shared<ScriptBytecodeCache>(m_logger, m_config.GetStringValue("Resources.BytecodeCacheDirectory"));
+		});
+
+		return m_bytecodeCache;
+	}
+
+	JobSystem& BurgApp::GetJobSystem()
+	{
+		// Created on first use for the same reason as the bytecode cache
+		std::call_once(m_jobSystemFlag, [&]
+		{
+			std::size_t workerCount = m_config.GetIntegerValue<std::size_t>("Resources.JobThreadCount");
+			if (workerCount == 0)
+				workerCount = std::max(std::thread::hardware_concurrency(), 2U) - 1; //< keep a core for the main thread
+
+			m_jobSystem = std::make_unique<JobSystem>(workerCount);
+			bwLog(GetLogger(), LogLevel::Debug, "job system started with {0} worker(s)", workerCount);
+		});
+
+		return *m_jobSystem;
+	}
+
+	bool BurgApp::LoadWebService()
+	{
+		// Loading libcurl is slow and many sessions never do a web request, so this is done on first use
+		std::call_once(m_webServiceFlag, [&]
+		{
+			std::string error;
+			if (WebService::Initialize(&error))
+			{
+				bwLog(GetLogger(), LogLevel::Debug, "libcurl has been loaded");
+				m_webService.emplace(m_logger);
+			}
+			else
+				bwLog(GetLogger(), LogLevel::Error, "failed to initialize web services ({0}), some functionalities will not work", error);
+		});
+
+		return m_webService.has_value();
+	}
+
 	void BurgApp::Update()
 	{
 		Nz::UInt64 now = Nz::GetElapsedMicroseconds();
@@ -113,6 +161,8 @@ namespace bw
 
 		if (m_webService)
 			m_webService->Poll();
+
+		GetJobSystem().ProcessMainThreadJobs();
 	}
 
 	void BurgApp::HandleInterruptSignal(const char* signalName)
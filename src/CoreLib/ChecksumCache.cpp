@@ -0,0 +1,188 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/ChecksumCache.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <Nazara/Core/File.hpp>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace bw
+{
+	ChecksumCache::ChecksumCache(const Logger& logger, std::filesystem::path cacheFile) :
+	m_cacheFile(std::move(cacheFile)),
+	m_logger(logger),
+	m_isDirty(false)
+	{
+		if (!m_cacheFile.empty() && std::filesystem::is_regular_file(m_cacheFile))
+		{
+			if (!Load())
+				bwLog(m_logger, LogLevel::Warning, "failed to load checksum cache {0}, it will be rebuilt", m_cacheFile.generic_u8string());
+		}
+	}
+
+	Nz::ByteArray ChecksumCache::ComputeChecksum(const std::filesystem::path& filePath)
+	{
+		FileInfo fileInfo;
+		if (!RetrieveFileInfo(filePath, &fileInfo))
+			return Nz::File::ComputeHash(Nz::HashType_SHA1, filePath.generic_u8string());
+
+		std::string path = filePath.generic_u8string();
+
+		Nz::ByteArray checksum;
+		if (FindChecksum(path, fileInfo, &checksum))
+			return checksum;
+
+		checksum = Nz::File::ComputeHash(Nz::HashType_SHA1, path);
+		if (!checksum.IsEmpty())
+			UpdateChecksum(std::move(path), fileInfo, checksum);
+
+		return checksum;
+	}
+
+	std::vector<Nz::ByteArray> ChecksumCache::ComputeChecksums(const std::vector<std::filesystem::path>& filePaths)
+	{
+		std::vector<Nz::ByteArray> checksums(filePaths.size());
+		std::vector<FileInfo> fileInfos(filePaths.size());
+		std::vector<std::size_t> missingChecksums;
+
+		for (std::size_t i = 0; i < filePaths.size(); ++i)
+		{
+			if (!RetrieveFileInfo(filePaths[i], &fileInfos[i]) || !FindChecksum(filePaths[i].generic_u8string(), fileInfos[i], &checksums[i]))
+				missingChecksums.push_back(i);
+		}
+
+		if (missingChecksums.empty())
+			return checksums;
+
+		bwLog(m_logger, LogLevel::Info, "computing checksums of {0} file(s) ({1} cached)", missingChecksums.size(), filePaths.size() - missingChecksums.size());
+
+		// Hash missing files on every core, each thread only writes to its own checksum slots
+		std::atomic_size_t nextIndex = 0;
+		auto HashFiles = [&]
+		{
+			std::size_t index;
+			while ((index = nextIndex++) < missingChecksums.size())
+			{
+				std::size_t fileIndex = missingChecksums[index];
+				checksums[fileIndex] = Nz::File::ComputeHash(Nz::HashType_SHA1, filePaths[fileIndex].generic_u8string());
+			}
+		};
+
+		std::size_t threadCount = std::min<std::size_t>(std::max(std::thread::hardware_concurrency(), 1U), missingChecksums.size());
+
+		std::vector<std::thread> threads;
+		threads.reserve(threadCount - 1);
+		for (std::size_t i = 1; i < threadCount; ++i)
+			threads.emplace_back(HashFiles);
+
+		HashFiles();
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		for (std::size_t fileIndex : missingChecksums)
+		{
+			if (!checksums[fileIndex].IsEmpty())
+				UpdateChecksum(filePaths[fileIndex].generic_u8string(), fileInfos[fileIndex], checksums[fileIndex]);
+		}
+
+		return checksums;
+	}
+
+	bool ChecksumCache::Save()
+	{
+		if (!m_isDirty || m_cacheFile.empty())
+			return true;
+
+		// One file per line: <size> <last write time> <hex checksum> <path>
+		std::ofstream file(m_cacheFile, std::ios::trunc);
+		if (!file)
+		{
+			bwLog(m_logger, LogLevel::Warning, "failed to save checksum cache {0}", m_cacheFile.generic_u8string());
+			return false;
+		}
+
+		for (auto&& [path, entry] : m_entries)
+			file << entry.fileInfo.size << ' ' << entry.fileInfo.lastWriteTime << ' ' << entry.checksum.ToHex().ToStdString() << ' ' << path << '\n';
+
+		m_isDirty = false;
+		return true;
+	}
+
+	bool ChecksumCache::FindChecksum(const std::string& filePath, const FileInfo& fileInfo, Nz::ByteArray* checksum) const
+	{
+		auto it = m_entries.find(filePath);
+		if (it == m_entries.end())
+			return false;
+
+		const Entry& entry = it->second;
+		if (entry.fileInfo.size != fileInfo.size || entry.fileInfo.lastWriteTime != fileInfo.lastWriteTime)
+			return false;
+
+		*checksum = entry.checksum;
+		return true;
+	}
+
+	bool ChecksumCache::Load()
+	{
+		std::ifstream file(m_cacheFile);
+		if (!file)
+			return false;
+
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::istringstream lineStream(line);
+
+			Entry entry;
+			std::string hexChecksum;
+			if (!(lineStream >> entry.fileInfo.size >> entry.fileInfo.lastWriteTime >> hexChecksum))
+				return false;
+
+			if (hexChecksum.size() != 40)
+				return false;
+
+			entry.checksum.Resize(hexChecksum.size() / 2);
+			for (std::size_t i = 0; i < entry.checksum.GetSize(); ++i)
+				entry.checksum[i] = static_cast<Nz::UInt8>(std::stoul(hexChecksum.substr(i * 2, 2), nullptr, 16));
+
+			lineStream.ignore(1); //< skip separator
+			std::string path;
+			if (!std::getline(lineStream, path) || path.empty())
+				return false;
+
+			m_entries.insert_or_assign(std::move(path), std::move(entry));
+		}
+
+		return true;
+	}
+
+	void ChecksumCache::UpdateChecksum(std::string filePath, const FileInfo& fileInfo, const Nz::ByteArray& checksum)
+	{
+		Entry& entry = m_entries[std::move(filePath)];
+		entry.checksum = checksum;
+		entry.fileInfo = fileInfo;
+
+		m_isDirty = true;
+	}
+
+	bool ChecksumCache::RetrieveFileInfo(const std::filesystem::path& filePath, FileInfo* fileInfo)
+	{
+		std::error_code ec;
+		fileInfo->size = std::filesystem::file_size(filePath, ec);
+		if (ec)
+			return false;
+
+		auto lastWriteTime = std::filesystem::last_write_time(filePath, ec);
+		if (ec)
+			return false;
+
+		fileInfo->lastWriteTime = static_cast<Nz::Int64>(lastWriteTime.time_since_epoch().count());
+		return true;
+	}
+}
@@ -0,0 +1,120 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/ColliderCache.hpp>
+#include <CoreLib/Utils.hpp>
+#include <algorithm>
+
+namespace bw
+{
+	ColliderGeometry::ColliderGeometry(std::vector<Collider> colliders) :
+	m_colliders(std::move(colliders))
+	{
+	}
+
+	Nz::Collider2DRef ColliderGeometry::BuildCollider(float scale) const
+	{
+		if (m_colliders.empty())
+		{
+			// No collider
+			return nullptr;
+		}
+
+		// Colliders are only descriptions, bodies create their own shapes from them so they can be shared
+		auto it = std::find_if(m_builtColliders.begin(), m_builtColliders.end(), [&](const auto& pair) { return pair.first == scale; });
+		if (it != m_builtColliders.end())
+		{
+			Nz::Collider2DRef collider = it->second;
+			if (it != m_builtColliders.end() - 1)
+			{
+				m_builtColliders.erase(it);
+				m_builtColliders.emplace_back(scale, collider);
+			}
+
+			return collider;
+		}
+
+		Nz::Collider2DRef collider;
+		if (m_colliders.size() == 1)
+		{
+			// Single collider
+			collider = ToCollider(m_colliders.front(), scale);
+		}
+		else
+		{
+			// Multiple colliders
+
+			std::vector<Nz::Collider2DRef> simpleColliders;
+			simpleColliders.reserve(m_colliders.size());
+
+			for (const auto& simpleCollider : m_colliders)
+				simpleColliders.emplace_back(ToCollider(simpleCollider, scale));
+
+			Nz::CompoundCollider2DRef compound = Nz::CompoundCollider2D::New(std::move(simpleColliders));
+			compound->OverridesCollisionProperties(false);
+
+			collider = compound;
+		}
+
+		if (m_builtColliders.size() >= MaxBuiltScaleCount)
+			m_builtColliders.erase(m_builtColliders.begin());
+
+		m_builtColliders.emplace_back(scale, collider);
+
+		return collider;
+	}
+
+	Nz::Collider2DRef ColliderGeometry::ToCollider(const Collider& collider, float scale)
+	{
+		return std::visit([&](auto&& arg) -> Nz::Collider2DRef
+		{
+			using T = std::decay_t<decltype(arg)>;
+
+			Nz::Collider2DRef collider;
+
+			if constexpr (std::is_same_v<T, CircleCollider>)
+				collider = Nz::CircleCollider2D::New(arg.radius * scale, arg.offset * scale);
+			else if constexpr (std::is_same_v<T, RectangleCollider>)
+			{
+				Nz::Rectf scaledRect = arg.data;
+				scaledRect.x *= scale;
+				scaledRect.y *= scale;
+				scaledRect.width *= scale;
+				scaledRect.height *= scale;
+
+				collider = Nz::BoxCollider2D::New(scaledRect);
+			}
+			else if constexpr (std::is_same_v<T, SegmentCollider>)
+				collider = Nz::SegmentCollider2D::New(arg.from * scale, arg.fromNeighbor * scale, arg.to * scale, arg.toNeighbor * scale);
+			else
+				static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
+
+			collider->SetCollisionId(arg.physics.colliderId);
+			collider->SetElasticity(arg.physics.elasticity);
+			collider->SetFriction(arg.physics.friction);
+			collider->SetSurfaceVelocity(arg.physics.surfaceVelocity);
+			collider->SetTrigger(arg.physics.isTrigger);
+
+			return collider;
+
+		}, collider);
+	}
+
+	std::shared_ptr<const ColliderGeometry> ColliderCache::GetGeometry(std::vector<Collider> colliders)
+	{
+		for (const auto& geometry : m_geometries)
+		{
+			if (geometry->GetColliders() == colliders)
+				return geometry;
+		}
+
+		auto geometry = std::make_shared<const ColliderGeometry>(std::move(colliders));
+
+		// Some elements (like tilemaps) have unique colliders per instance, don't let them grow the cache forever
+		if (m_geometries.size() < MaxGeometryCount)
+			m_geometries.push_back(geometry);
+
+		return geometry;
+	}
+}
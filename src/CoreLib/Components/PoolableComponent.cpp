@@ -0,0 +1,23 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Components/PoolableComponent.hpp>
+#include <CoreLib/TerrainLayer.hpp>
+
+namespace bw
+{
+	void PoolableComponent::KillEntity(const Ndk::EntityHandle& entity)
+	{
+		if (entity->HasComponent<PoolableComponent>())
+		{
+			auto& poolable = entity->GetComponent<PoolableComponent>();
+			if (poolable.GetLayer().RecycleEntity(entity))
+				return;
+		}
+
+		entity->Kill();
+	}
+
+	Ndk::ComponentIndex PoolableComponent::componentIndex;
+}
@@ -3,35 +3,153 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/Components/ScriptComponent.hpp>
+#include <CoreLib/Systems/TickCallbackSystem.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <NDK/World.hpp>
+#include <algorithm>
 
 namespace bw
 {
-	ScriptComponent::ScriptComponent(const Logger& logger, std::shared_ptr<const ScriptedElement> element, std::shared_ptr<ScriptingContext> context, sol::table entityTable, PropertyValueMap properties) :
-	m_eventCallbacks(element->eventCallbacks),
-	m_customEventCallbacks(element->customEventCallbacks),
+	ScriptComponent::ScriptComponent(const Logger& logger, std::shared_ptr<const ScriptedElement> element, std::shared_ptr<ScriptingContext> context, sol::table entityTable, ScriptedPropertyValues properties) :
 	m_element(std::move(element)),
 	m_context(std::move(context)),
 	m_nextCallbackId(m_element->nextCallbackId),
 	m_entityTable(std::move(entityTable)),
 	m_logger(Ndk::EntityHandle::InvalidHandle, logger),
+	m_nextBudgetWarning(0),
 	m_properties(std::move(properties)),
 	m_timeBeforeTick(0.f)
 	{
+		// Callbacks are only copied once per element, instances share them until they register their own
+		if (!m_element->sharedCallbacks)
+		{
+			m_element->sharedCallbacks = std::make_shared<ScriptedElement::CallbackSet>();
+			m_element->sharedCallbacks->eventCallbacks = m_element->eventCallbacks;
+			m_element->sharedCallbacks->customEventCallbacks = m_element->customEventCallbacks;
+		}
+
+		m_callbacks = m_element->sharedCallbacks;
 	}
 
 	ScriptComponent::~ScriptComponent() = default;
 
+	auto ScriptComponent::CaptureState() const -> std::optional<State>
+	{
+		State state;
+		state.callbacks = m_callbacks;
+		state.nextCallbackId = m_nextCallbackId;
+		state.timeBeforeTick = m_timeBeforeTick;
+
+		for (auto&& [key, value] : m_entityTable)
+		{
+			switch (value.get_type())
+			{
+				case sol::type::table:
+				case sol::type::thread:
+					return std::nullopt;
+
+				default:
+					break;
+			}
+
+			state.tableFields.emplace_back(key, value);
+		}
+
+		return state;
+	}
+
+	void ScriptComponent::RestoreState(const State& state)
+	{
+		m_callbacks = state.callbacks;
+		m_nextCallbackId = state.nextCallbackId;
+		m_timeBeforeTick = state.timeBeforeTick;
+
+		std::vector<sol::object> keys;
+		for (auto&& [key, value] : m_entityTable)
+			keys.push_back(key);
+
+		for (const sol::object& key : keys)
+			m_entityTable.raw_set(key, sol::lua_nil);
+
+		for (auto&& [key, value] : state.tableFields)
+			m_entityTable.raw_set(key, value);
+
+		RescheduleTick();
+	}
+
+	void ScriptComponent::SetNextTick(float seconds)
+	{
+		m_timeBeforeTick = seconds;
+		RescheduleTick();
+	}
+
+	void ScriptComponent::UpdateElement(std::shared_ptr<const ScriptedElement> element)
+	{
+		// Property indices may have changed with the element, remap values by name
+		ScriptedPropertyValues properties(element->properties.size());
+		for (auto&& [propertyName, property] : m_element->properties)
+		{
+			if (property.index >= m_properties.size() || !m_properties[property.index])
+				continue;
+
+			if (auto it = element->properties.find(propertyName); it != element->properties.end())
+				properties[it->second.index] = std::move(m_properties[property.index]);
+		}
+
+		m_element = std::move(element);
+		m_properties = std::move(properties);
+	}
+
 	void ScriptComponent::UpdateEntity(const Ndk::EntityHandle& entity)
 	{
 		m_entityTable["_Entity"] = entity;
 		m_logger.UpdateEntity(entity);
 	}
 
+	void ScriptComponent::UpdateProperties(PropertyValueMap properties)
+	{
+		m_properties.clear();
+		m_properties.resize(m_element->properties.size());
+		for (auto it = properties.begin(); it != properties.end(); ++it)
+		{
+			if (auto propertyIt = m_element->properties.find(it->first); propertyIt != m_element->properties.end())
+				m_properties[propertyIt->second.index] = std::move(it.value());
+		}
+	}
+
+	void ScriptComponent::CheckCallbackBudget(std::string_view eventName, Nz::UInt64 duration, bool throttleTick)
+	{
+		Nz::UInt64 budget = m_context->GetProfiler().GetCallbackBudget();
+		if (budget == 0 || duration <= budget)
+			return;
+
+		Nz::UInt64 now = Nz::GetElapsedMicroseconds();
+		if (now >= m_nextBudgetWarning)
+		{
+			bwLog(m_logger, LogLevel::Warning, "{0} callbacks took {1:.2f} ms, over the {2:.2f} ms script budget{3}", eventName, duration / 1000.0, budget / 1000.0, (throttleTick) ? ", throttling its ticks" : "");
+			m_nextBudgetWarning = now + 5'000'000; //< don't flood the log with a script overrunning every tick
+		}
+
+		// Postpone the next tick by the overrun, so a runaway tick callback can't hold the match more than half of the time
+		if (throttleTick)
+			m_timeBeforeTick = std::max(m_timeBeforeTick, 0.f) + (duration - budget) / 1'000'000.f;
+	}
+
 	void ScriptComponent::OnAttached()
 	{
 		UpdateEntity(m_entity);
 	}
 
+	void ScriptComponent::RescheduleTick()
+	{
+		if (!m_entity)
+			return;
+
+		Ndk::World* world = m_entity->GetWorld();
+		if (world->HasSystem<TickCallbackSystem>())
+			world->GetSystem<TickCallbackSystem>().Reschedule(m_entity);
+	}
+
 	Ndk::ComponentIndex ScriptComponent::componentIndex;
 }
 
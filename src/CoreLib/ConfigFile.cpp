@@ -6,6 +6,7 @@
 #include <CoreLib/BurgApp.hpp>
 #include <CoreLib/Utils.hpp>
 #include <sol/sol.hpp>
+#include <cassert>
 #include <fstream>
 
 namespace bw
@@ -37,20 +38,33 @@ namespace bw
 
 	bool ConfigFile::LoadFromFile(const std::filesystem::path& filePath)
 	{
+		return LoadFromFiles({ filePath });
+	}
+
+	bool ConfigFile::LoadFromFiles(const std::vector<std::filesystem::path>& filePaths)
+	{
+		assert(!filePaths.empty());
+
 		sol::state lua;
 		lua.open_libraries();
 
-		std::string path = filePath.generic_u8string();
+		std::string path = filePaths.back().generic_u8string();
 
 		try
 		{
 			sol::environment configEnv(lua, sol::create, lua.globals());
 
-			if (auto result = lua.safe_script_file(path, configEnv, sol::load_mode::text); !result.valid())
+			// Every file runs in the same environment, allowing later files to override values set by previous ones
+			for (const std::filesystem::path& filePath : filePaths)
 			{
-				sol::error err = result;
-				bwLog(m_app.GetLogger(), LogLevel::Error, "failed to load config {0}: {1}", path, err.what());
-				return false;
+				path = filePath.generic_u8string();
+
+				if (auto result = lua.safe_script_file(path, configEnv, sol::load_mode::text); !result.valid())
+				{
+					sol::error err = result;
+					bwLog(m_app.GetLogger(), LogLevel::Error, "failed to load config {0}: {1}", path, err.what());
+					return false;
+				}
 			}
 
 			bool hasError = false;
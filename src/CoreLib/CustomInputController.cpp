@@ -37,4 +37,9 @@ namespace bw
 
 		return *inputsOpt;
 	}
+
+	bool CustomInputController::IsScripted() const
+	{
+		return true;
+	}
 }
@@ -0,0 +1,194 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/HitboxHistory.hpp>
+#include <CoreLib/SharedMatch.hpp>
+#include <CoreLib/Components/MatchComponent.hpp>
+#include <NDK/Components/PhysicsComponent2D.hpp>
+#include <NDK/Systems/PhysicsSystem2D.hpp>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace bw
+{
+	HitboxHistory::HitboxHistory(std::size_t capacity) :
+	m_frameCount(0),
+	m_nextFrameIndex(0)
+	{
+		SetCapacity(capacity);
+	}
+
+	void HitboxHistory::RaycastQuery(const SharedMatch& match, Ndk::World& world, Nz::UInt16 tick, const Nz::Vector2f& startPos, const Nz::Vector2f& endPos, const Ndk::EntityHandle& ignoredEntity, const std::function<void(const RaycastHit& hitInfo)>& callback) const
+	{
+		// Entities whose past hitbox is traced instead of their current body (sorted, as frame hitboxes are)
+		std::vector<EntityId> rewoundEntities;
+
+		if (const Frame* frame = FindFrame(tick))
+		{
+			constexpr float SquaredRewindThreshold = RewindThreshold * RewindThreshold;
+
+			for (const Hitbox& hitbox : frame->hitboxes)
+			{
+				const Ndk::EntityHandle& entity = match.RetrieveEntityByUniqueId(hitbox.uniqueId);
+				if (!entity || entity->GetWorld() != &world || !entity->HasComponent<Ndk::PhysicsComponent2D>())
+					continue; //< entity has been destroyed or moved to another layer since
+
+				Nz::Rectf currentAABB = entity->GetComponent<Ndk::PhysicsComponent2D>().GetAABB();
+				if ((currentAABB.GetCenter() - hitbox.aabb.GetCenter()).GetSquaredLength() < SquaredRewindThreshold)
+					continue; //< didn't move, the physics world gives a more precise result
+
+				rewoundEntities.push_back(hitbox.uniqueId);
+
+				if (entity == ignoredEntity)
+					continue;
+
+				RaycastHit hitInfo;
+				if (!IntersectRay(hitbox.aabb, startPos, endPos, &hitInfo.fraction, &hitInfo.hitNormal))
+					continue;
+
+				hitInfo.entity = entity;
+				hitInfo.hitPos = startPos + (endPos - startPos) * hitInfo.fraction;
+				hitInfo.isRewound = true;
+
+				callback(hitInfo);
+			}
+		}
+
+		auto& physSystem = world.GetSystem<Ndk::PhysicsSystem2D>();
+		physSystem.RaycastQuery(startPos, endPos, 1.f, 0, 0xFFFFFFFF, 0xFFFFFFFF, [&](const Ndk::PhysicsSystem2D::RaycastHit& physHit)
+		{
+			const Ndk::EntityHandle& hitEntity = physHit.body;
+			if (hitEntity == ignoredEntity)
+				return;
+
+			if (!rewoundEntities.empty() && hitEntity->HasComponent<MatchComponent>())
+			{
+				if (std::binary_search(rewoundEntities.begin(), rewoundEntities.end(), hitEntity->GetComponent<MatchComponent>().GetUniqueId()))
+					return;
+			}
+
+			RaycastHit hitInfo;
+			hitInfo.entity = hitEntity;
+			hitInfo.fraction = physHit.fraction;
+			hitInfo.hitNormal = physHit.hitNormal;
+			hitInfo.hitPos = physHit.hitPos;
+			hitInfo.isRewound = false;
+
+			callback(hitInfo);
+		});
+	}
+
+	bool HitboxHistory::RaycastQueryFirst(const SharedMatch& match, Ndk::World& world, Nz::UInt16 tick, const Nz::Vector2f& startPos, const Nz::Vector2f& endPos, const Ndk::EntityHandle& ignoredEntity, RaycastHit* hitInfo) const
+	{
+		bool hasHit = false;
+		RaycastQuery(match, world, tick, startPos, endPos, ignoredEntity, [&](const RaycastHit& hit)
+		{
+			if (!hasHit || hit.fraction < hitInfo->fraction)
+			{
+				*hitInfo = hit;
+				hasHit = true;
+			}
+		});
+
+		return hasHit;
+	}
+
+	void HitboxHistory::Record(Nz::UInt16 tick, Ndk::World& world)
+	{
+		if (m_frames.empty())
+			return;
+
+		Frame& frame = m_frames[m_nextFrameIndex];
+		frame.hitboxes.clear();
+		frame.tick = tick;
+
+		// Only bodies can move, static colliders are always traced in the physics world
+		for (const Ndk::EntityHandle& entity : world.GetSystem<Ndk::PhysicsSystem2D>().GetEntities())
+		{
+			if (!entity->HasComponent<Ndk::PhysicsComponent2D>() || !entity->HasComponent<MatchComponent>())
+				continue;
+
+			Hitbox& hitbox = frame.hitboxes.emplace_back();
+			hitbox.aabb = entity->GetComponent<Ndk::PhysicsComponent2D>().GetAABB();
+			hitbox.uniqueId = entity->GetComponent<MatchComponent>().GetUniqueId();
+		}
+
+		std::sort(frame.hitboxes.begin(), frame.hitboxes.end(), [](const Hitbox& lhs, const Hitbox& rhs) { return lhs.uniqueId < rhs.uniqueId; });
+
+		m_nextFrameIndex = (m_nextFrameIndex + 1) % m_frames.size();
+		m_frameCount = std::min(m_frameCount + 1, m_frames.size());
+	}
+
+	void HitboxHistory::SetCapacity(std::size_t capacity)
+	{
+		m_frames.clear();
+		m_frames.resize(capacity);
+
+		Clear();
+	}
+
+	auto HitboxHistory::FindFrame(Nz::UInt16 tick) const -> const Frame*
+	{
+		if (m_frameCount == 0)
+			return nullptr;
+
+		std::size_t frameCapacity = m_frames.size();
+		std::size_t newestFrameIndex = (m_nextFrameIndex + frameCapacity - 1) % frameCapacity;
+
+		// Ticks more recent than the last recorded one are traced against the last frame, older ticks than the history are clamped to the oldest frame
+		Nz::Int16 tickAge = static_cast<Nz::Int16>(m_frames[newestFrameIndex].tick - tick);
+		if (tickAge <= 0)
+			return &m_frames[newestFrameIndex];
+
+		std::size_t frameAge = std::min<std::size_t>(tickAge, m_frameCount - 1);
+		return &m_frames[(newestFrameIndex + frameCapacity - frameAge) % frameCapacity];
+	}
+
+	bool HitboxHistory::IntersectRay(const Nz::Rectf& aabb, const Nz::Vector2f& startPos, const Nz::Vector2f& endPos, float* fraction, Nz::Vector2f* hitNormal)
+	{
+		constexpr float Epsilon = 0.0001f;
+
+		Nz::Vector2f direction = endPos - startPos;
+
+		float minFraction = 0.f;
+		float maxFraction = 1.f;
+		Nz::Vector2f normal = (direction.GetSquaredLength() > Epsilon) ? -Nz::Vector2f::Normalize(direction) : Nz::Vector2f::Zero(); //< when starting inside the box
+
+		// Slab test, one axis at a time
+		auto TestAxis = [&](float origin, float delta, float boxMin, float boxMax, const Nz::Vector2f& minNormal)
+		{
+			if (std::abs(delta) < Epsilon)
+				return origin >= boxMin && origin <= boxMax;
+
+			float entryFraction = (boxMin - origin) / delta;
+			float exitFraction = (boxMax - origin) / delta;
+			Nz::Vector2f entryNormal = minNormal;
+			if (entryFraction > exitFraction)
+			{
+				std::swap(entryFraction, exitFraction);
+				entryNormal = -entryNormal;
+			}
+
+			if (entryFraction > minFraction)
+			{
+				minFraction = entryFraction;
+				normal = entryNormal;
+			}
+
+			maxFraction = std::min(maxFraction, exitFraction);
+			return minFraction <= maxFraction;
+		};
+
+		if (!TestAxis(startPos.x, direction.x, aabb.x, aabb.x + aabb.width, Nz::Vector2f(-1.f, 0.f)))
+			return false;
+
+		if (!TestAxis(startPos.y, direction.y, aabb.y, aabb.y + aabb.height, Nz::Vector2f(0.f, -1.f)))
+			return false;
+
+		*fraction = minFraction;
+		*hitNormal = normal;
+		return true;
+	}
+}
@@ -7,5 +7,10 @@
 namespace bw
 {
 	InputController::~InputController() = default;
+
+	bool InputController::IsScripted() const
+	{
+		return false;
+	}
 }
 
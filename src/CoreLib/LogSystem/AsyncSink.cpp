@@ -0,0 +1,135 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/LogSystem/AsyncSink.hpp>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	namespace
+	{
+		constexpr std::chrono::milliseconds WakeUpInterval(50); //< upper bound on latency, as a producer may notify right before the worker waits
+		constexpr std::size_t MaxFlushAttempts = 1000;
+
+		std::mutex s_sinkListMutex;
+		std::vector<AsyncSink*> s_sinkList;
+	}
+
+	AsyncSink::AsyncSink(std::shared_ptr<LogSink> sink, std::size_t queueSize) :
+	m_isStopping(false),
+	m_droppedCount(0),
+	m_sink(std::move(sink)),
+	m_queue(queueSize),
+	m_reportedDropCount(0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_sinkListMutex);
+			s_sinkList.push_back(this);
+		}
+
+		m_worker = std::thread(&AsyncSink::WorkerMain, this);
+	}
+
+	AsyncSink::~AsyncSink()
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_sinkListMutex);
+			s_sinkList.erase(std::find(s_sinkList.begin(), s_sinkList.end(), this));
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_wakeUpMutex);
+			m_isStopping = true;
+		}
+		m_wakeUpCondition.notify_one();
+
+		m_worker.join();
+	}
+
+	void AsyncSink::Flush()
+	{
+		// Worker may be writing records itself, wait for it to be done (but don't wait forever, it may be the one which crashed)
+		for (std::size_t i = 0; i < MaxFlushAttempts; ++i)
+		{
+			if (Drain())
+				return;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	void AsyncSink::Write(const LogContext& context, std::string_view content)
+	{
+		Record record;
+		record.context.level = context.level;
+		record.context.side = context.side;
+		record.context.elapsedTime = context.elapsedTime;
+		record.content = content;
+
+		if (!m_queue.TryPush(std::move(record)))
+		{
+			m_droppedCount.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		m_wakeUpCondition.notify_one();
+	}
+
+	void AsyncSink::FlushAll()
+	{
+		// Don't risk a deadlock if a sink was being created or destroyed when crashing
+		std::unique_lock<std::mutex> lock(s_sinkListMutex, std::try_to_lock);
+		if (!lock.owns_lock())
+			return;
+
+		for (AsyncSink* sink : s_sinkList)
+			sink->Flush();
+	}
+
+	bool AsyncSink::Drain()
+	{
+		if (m_isDraining.test_and_set(std::memory_order_acquire))
+			return false;
+
+		Record record;
+		while (m_queue.TryPop(record))
+			m_sink->Write(record.context, record.content);
+
+		Nz::UInt64 droppedCount = m_droppedCount.load(std::memory_order_relaxed);
+		if (droppedCount != m_reportedDropCount)
+		{
+			LogContext dropContext;
+			dropContext.level = LogLevel::Warning;
+			dropContext.side = LogSide::Irrelevant;
+			dropContext.elapsedTime = 0.f;
+
+			m_sink->Write(dropContext, "log queue was full, " + std::to_string(droppedCount - m_reportedDropCount) + " message(s) dropped");
+
+			m_reportedDropCount = droppedCount;
+		}
+
+		m_isDraining.clear(std::memory_order_release);
+		return true;
+	}
+
+	void AsyncSink::WorkerMain()
+	{
+		std::unique_lock<std::mutex> lock(m_wakeUpMutex);
+		while (!m_isStopping)
+		{
+			lock.unlock();
+			Drain();
+			lock.lock();
+
+			m_wakeUpCondition.wait_for(lock, WakeUpInterval);
+		}
+		lock.unlock();
+
+		// Write everything left before exiting
+		Flush();
+	}
+}
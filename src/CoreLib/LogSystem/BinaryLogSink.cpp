@@ -0,0 +1,246 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/LogSystem/BinaryLogSink.hpp>
+#include <CoreLib/SharedMatch.hpp>
+#include <CoreLib/LogSystem/EntityLogContext.hpp>
+#include <CoreLib/LogSystem/MatchLogContext.hpp>
+#include <CoreLib/Protocol/CompressedInteger.hpp>
+#include <Nazara/Core/ErrorFlags.hpp>
+#include <Nazara/Core/MemoryView.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+namespace bw
+{
+	namespace
+	{
+		constexpr std::size_t FlushThreshold = 64 * 1024; //< records are buffered until they reach this size
+		constexpr std::array<char, 8> FileSignature = { 'B', 'u', 'r', 'g', 'L', 'o', 'g', 's' };
+
+		std::filesystem::path GetRotatedPath(const std::filesystem::path& filePath, std::size_t index)
+		{
+			std::filesystem::path rotatedPath = filePath;
+			rotatedPath += "." + std::to_string(index);
+
+			return rotatedPath;
+		}
+
+		void WriteString(Nz::ByteStream& stream, std::string_view str)
+		{
+			CompressedUnsigned<Nz::UInt32> length(Nz::UInt32(str.size()));
+			stream << length;
+			stream.Write(str.data(), str.size());
+		}
+
+		std::string ReadString(Nz::ByteStream& stream)
+		{
+			CompressedUnsigned<Nz::UInt32> length;
+			stream >> length;
+
+			std::string str(length, '\0');
+			if (stream.Read(str.data(), str.size()) != str.size())
+				throw std::runtime_error("truncated string");
+
+			return str;
+		}
+	}
+
+	BinaryLogSink::BinaryLogSink(std::filesystem::path filePath, Nz::UInt64 maxFileSize, std::size_t maxFileCount) :
+	m_filePath(std::move(filePath)),
+	m_maxFileCount(std::max<std::size_t>(maxFileCount, 1)),
+	m_stream(&m_buffer, Nz::OpenMode_WriteOnly),
+	m_fileSize(0),
+	m_maxFileSize(maxFileSize)
+	{
+		m_stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		// Never append to a previous run file, its records could be cut
+		RotateFiles();
+	}
+
+	BinaryLogSink::~BinaryLogSink()
+	{
+		Flush();
+	}
+
+	void BinaryLogSink::Flush()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		FlushBuffer();
+	}
+
+	void BinaryLogSink::Write(const LogContext& context, std::string_view content)
+	{
+		Nz::UInt64 timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+		const MatchLogContext* matchContext = dynamic_cast<const MatchLogContext*>(&context);
+		const EntityLogContext* entityContext = dynamic_cast<const EntityLogContext*>(&context);
+
+		Nz::UInt8 flags = 0;
+		if (matchContext && matchContext->match)
+			flags |= RecordFlag_Match;
+
+		if (entityContext && entityContext->entity)
+			flags |= RecordFlag_Entity;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_stream << timestamp << context.elapsedTime;
+		m_stream << static_cast<Nz::UInt8>(context.level) << static_cast<Nz::UInt8>(context.side) << flags;
+
+		if (flags & RecordFlag_Match)
+		{
+			WriteString(m_stream, matchContext->match->GetName());
+			m_stream << matchContext->tick;
+		}
+
+		if (flags & RecordFlag_Entity)
+			m_stream << static_cast<Nz::UInt32>(entityContext->entity->GetId());
+
+		WriteString(m_stream, content);
+
+		// Errors are flushed right away, as they often precede a crash
+		if (m_buffer.GetSize() >= FlushThreshold || context.level >= LogLevel::Error)
+			FlushBuffer();
+	}
+
+	bool BinaryLogSink::ReadFile(const std::filesystem::path& filePath, const std::function<void(const Record& record)>& callback)
+	{
+		Nz::File file(filePath.generic_u8string(), Nz::OpenMode_ReadOnly);
+		if (!file.IsOpen())
+			return false;
+
+		std::vector<Nz::UInt8> content(file.GetSize());
+		if (file.Read(content.data(), content.size()) != content.size())
+			return false;
+
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		Nz::MemoryView contentView(content.data(), content.size());
+
+		Nz::ByteStream stream(&contentView);
+		stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		std::array<char, FileSignature.size()> signature;
+		if (stream.Read(signature.data(), signature.size()) != signature.size() || signature != FileSignature)
+			return false;
+
+		Nz::UInt16 fileVersion;
+		try
+		{
+			stream >> fileVersion;
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+
+		if (fileVersion > FileVersion)
+			return false;
+
+		Record record;
+		while (contentView.GetCursorPos() < content.size())
+		{
+			try
+			{
+				Nz::UInt8 level;
+				Nz::UInt8 side;
+				Nz::UInt8 flags;
+				stream >> record.timestamp >> record.elapsedTime >> level >> side >> flags;
+
+				record.level = static_cast<LogLevel>(level);
+				record.side = static_cast<LogSide>(side);
+
+				record.matchName.reset();
+				record.tick = 0;
+				if (flags & RecordFlag_Match)
+				{
+					record.matchName = ReadString(stream);
+					stream >> record.tick;
+				}
+
+				record.entityId.reset();
+				if (flags & RecordFlag_Entity)
+				{
+					Nz::UInt32 entityId;
+					stream >> entityId;
+
+					record.entityId = entityId;
+				}
+
+				record.content = ReadString(stream);
+			}
+			catch (const std::exception&)
+			{
+				// Last record may have been cut by a crash, keep everything before it
+				break;
+			}
+
+			callback(record);
+		}
+
+		return true;
+	}
+
+	void BinaryLogSink::FlushBuffer()
+	{
+		if (m_buffer.IsEmpty())
+			return;
+
+		if (m_fileSize + m_buffer.GetSize() > m_maxFileSize)
+			RotateFiles();
+
+		if (m_file.IsOpen())
+		{
+			m_file.Write(m_buffer.GetConstBuffer(), m_buffer.GetSize());
+			m_file.Flush();
+
+			m_fileSize += m_buffer.GetSize();
+		}
+
+		m_buffer.Clear();
+		m_stream.SetStream(&m_buffer, Nz::OpenMode_WriteOnly);
+		m_stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+	}
+
+	bool BinaryLogSink::OpenFile()
+	{
+		if (!m_file.Open(m_filePath.generic_u8string(), Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate))
+			return false;
+
+		m_file.Write(FileSignature.data(), FileSignature.size());
+
+		Nz::ByteStream headerStream(&m_file);
+		headerStream.SetDataEndianness(Nz::Endianness_LittleEndian);
+		headerStream << FileVersion;
+
+		m_fileSize = FileSignature.size() + sizeof(FileVersion);
+		return true;
+	}
+
+	void BinaryLogSink::RotateFiles()
+	{
+		m_file.Close();
+
+		// log => log.1 => log.2 ... the oldest one is removed
+		std::error_code err;
+		if (m_maxFileCount > 1)
+		{
+			std::filesystem::remove(GetRotatedPath(m_filePath, m_maxFileCount - 1), err);
+			for (std::size_t i = m_maxFileCount - 1; i > 1; --i)
+				std::filesystem::rename(GetRotatedPath(m_filePath, i - 1), GetRotatedPath(m_filePath, i), err);
+
+			std::filesystem::rename(m_filePath, GetRotatedPath(m_filePath, 1), err);
+		}
+
+		// Sink can't log its own failures, records are dropped until next rotation if the file can't be opened
+		if (!OpenFile())
+			std::fprintf(stderr, "failed to open binary log file %s\n", m_filePath.generic_u8string().c_str());
+	}
+}
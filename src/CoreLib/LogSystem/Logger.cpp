@@ -7,10 +7,42 @@
 #include <CoreLib/LogSystem/LogSink.hpp>
 #include <array>
 #include <charconv>
+#include <new>
 #include <sstream>
 
 namespace bw
 {
+	namespace
+	{
+		constexpr std::size_t MaxFreeContextBlocks = 16; //< per thread, log calls only keep a few contexts alive at once
+
+		struct ContextBlock
+		{
+			ContextBlock* next;
+		};
+
+		// Contexts are allocated and freed by the logging thread, a thread-local free list means no lock nor heap allocation once warm
+		struct ContextFreeList
+		{
+			~ContextFreeList()
+			{
+				while (head)
+				{
+					ContextBlock* next = head->next;
+					::operator delete(head);
+					head = next;
+				}
+
+				count = 0;
+			}
+
+			ContextBlock* head = nullptr;
+			std::size_t count = 0;
+		};
+
+		thread_local ContextFreeList s_freeContextBlocks;
+	}
+
 	void Logger::Log(const LogContext& context, std::string content) const
 	{
 		OverrideContent(context, content);
@@ -26,20 +58,20 @@ namespace bw
 			sinkPtr->Write(context, content);
 	}
 
-	bool Logger::ShouldLog(const LogContext& context) const
+	bool Logger::ShouldLog(LogLevel level) const
 	{
-		if (context.level < m_minimumLogLevel)
+		if (level < m_minimumLogLevel)
 			return false;
 
-		if (m_logParent && !m_logParent->ShouldLog(context))
+		if (m_logParent && !m_logParent->ShouldLog(level))
 			return false;
 
 		return true;
 	}
 
-	LogContext* Logger::NewContext(Nz::MemoryPool& pool) const
+	LogContext* Logger::NewContext() const
 	{
-		return AllocateContext<LogContext>(pool);
+		return AllocateContext<LogContext>();
 	}
 
 	void Logger::InitializeContext(LogContext& context) const
@@ -104,6 +136,35 @@ namespace bw
 
 	void Logger::FreeContext(LogContext* context) const
 	{
-		m_contextPool.Delete(context);
+		context->~LogContext();
+		FreeContextMemory(context);
+	}
+
+	void* Logger::AllocateContextMemory()
+	{
+		if (ContextBlock* block = s_freeContextBlocks.head)
+		{
+			s_freeContextBlocks.head = block->next;
+			s_freeContextBlocks.count--;
+
+			return block;
+		}
+
+		return ::operator new(MaxContextSize);
+	}
+
+	void Logger::FreeContextMemory(void* memory)
+	{
+		if (s_freeContextBlocks.count >= MaxFreeContextBlocks)
+		{
+			::operator delete(memory);
+			return;
+		}
+
+		ContextBlock* block = static_cast<ContextBlock*>(memory);
+		block->next = s_freeContextBlocks.head;
+
+		s_freeContextBlocks.head = block;
+		s_freeContextBlocks.count++;
 	}
 }
@@ -23,9 +23,9 @@ namespace bw
 		m_logParent.LogRaw(context, content);
 	}
 
-	bool LoggerProxy::ShouldLog(const LogContext& context) const
+	bool LoggerProxy::ShouldLog(LogLevel level) const
 	{
-		return m_logParent.ShouldLog(context);
+		return m_logParent.ShouldLog(level);
 	}
 
 	void LoggerProxy::OverrideContent(const LogContext& /*context*/, std::string& /*content*/) const
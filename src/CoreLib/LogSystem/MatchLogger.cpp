@@ -7,9 +7,9 @@
 
 namespace bw
 {
-	bool MatchLogger::ShouldLog(const LogContext& context) const
+	bool MatchLogger::ShouldLog(LogLevel level) const
 	{
-		if (!Logger::ShouldLog(context))
+		if (!Logger::ShouldLog(level))
 			return false;
 
 		return true;
@@ -24,9 +24,9 @@ namespace bw
 		Logger::OverrideContent(context, content);
 	}
 
-	LogContext* MatchLogger::NewContext(Nz::MemoryPool& pool) const
+	LogContext* MatchLogger::NewContext() const
 	{
-		return AllocateContext<MatchLogContext>(pool);
+		return AllocateContext<MatchLogContext>();
 	}
 
 	void MatchLogger::InitializeContext(LogContext& context) const
@@ -3,15 +3,21 @@
 // For conditions of distribution and use, see copyright notice in Prerequisites.hpp
 
 #include <CoreLib/Map.hpp>
+#include <CoreLib/BinaryMapReader.hpp>
 #include <CoreLib/Protocol/CompressedInteger.hpp>
+#include <CoreLib/Scripting/ScriptBytecodeCache.hpp>
+#include <CoreLib/Utility/MemoryMappedFile.hpp>
 #include <CoreLib/Version.hpp>
 #include <CoreLib/Utils.hpp>
 #include <Nazara/Core/Bitset.hpp>
+#include <Nazara/Core/ByteArray.hpp>
 #include <Nazara/Core/ByteStream.hpp>
 #include <Nazara/Core/ErrorFlags.hpp>
 #include <Nazara/Core/File.hpp>
+#include <Nazara/Core/MemoryView.hpp>
 #include <Nazara/Math/Rect.hpp>
 #include <fmt/format.h>
+#include <lz4hc.h>
 #include <nlohmann/json.hpp>
 #include <stdexcept>
 
@@ -101,107 +107,482 @@ namespace Nz
 
 namespace bw
 {
-	constexpr Nz::UInt16 MapFileVersion = 1;
-
-	bool Map::Compile(const std::filesystem::path& outputPath)
+	namespace
 	{
-		Nz::File infoFile(outputPath.generic_u8string(), Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate);
-		if (!infoFile.IsOpen())
-			return false;
-
-		Nz::ByteStream stream(&infoFile);
-		stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+		constexpr std::size_t SectionCompressionThreshold = 128; //< smaller sections are never compressed
+		constexpr std::size_t JsonWriteBufferSize = 64 * 1024;
 
-		stream.Write("Burgrmap", 8);
-		stream << MapFileVersion;
+		std::string GetGameVersionString()
+		{
+			return fmt::format("{}.{}.{}", GameMajorVersion, GameMinorVersion, GamePatchVersion);
+		}
 
-		// Map header
-		stream << m_mapInfo.name << m_mapInfo.author << m_mapInfo.description;
+		MapInfo ParseMapInfo(const nlohmann::json& mapJson)
+		{
+			MapInfo mapInfo;
+			mapInfo.author = mapJson.value("author", "unknown");
+			mapInfo.description = mapJson.value("description", "");
+			mapInfo.name = mapJson.at("name");
 
-		// Game version
-		stream << GameVersion;
+			return mapInfo;
+		}
 
-		// Map layers
-		CompressedUnsigned<Nz::UInt16> layerCount(Nz::UInt16(m_layers.size()));
-		stream << layerCount;
+		void ParseAssets(const nlohmann::json& assetArray, std::vector<Map::Asset>& assets)
+		{
+			for (auto&& entry : assetArray)
+			{
+				Map::Asset& asset = assets.emplace_back();
+				asset.filepath = entry.at("filePath");
+				asset.sha1Checksum = entry.at("checksum");
+				asset.size = entry.value("size", Nz::UInt64(0));
+			}
+		}
 
-		for (const Layer& layer : m_layers)
+		void ParseLayerInfo(const nlohmann::json& layerInfo, Map::Layer& layer)
 		{
-			stream << layer.name;
-			stream << layer.backgroundColor;
+			layer.backgroundColor = layerInfo.value("backgroundColor", Nz::Color::Black);
+			layer.name = layerInfo.value("name", "");
 
-			CompressedUnsigned<Nz::UInt16> entityCount(Nz::UInt16(layer.entities.size()));
-			stream << entityCount;
+			if (auto physicsIt = layerInfo.find("physics"); physicsIt != layerInfo.end())
+			{
+				const nlohmann::json& physicsInfo = *physicsIt;
+				if (auto it = physicsInfo.find("iterationCount"); it != physicsInfo.end())
+					layer.physics.iterationCount = it->get<Nz::UInt32>();
+
+				if (auto it = physicsInfo.find("sleepTime"); it != physicsInfo.end())
+					layer.physics.sleepTime = it->get<float>();
 
-			for (const Entity& entity : layer.entities)
+				if (auto it = physicsInfo.find("spatialHashCellSize"); it != physicsInfo.end())
+					layer.physics.spatialHashCellSize = it->get<float>();
+			}
+		}
+
+		nlohmann::json SerializeAssets(const std::vector<Map::Asset>& assets)
+		{
+			auto assetArray = nlohmann::json::array();
+			for (const auto& mapAsset : assets)
 			{
-				stream << entity.entityType;
-				stream << entity.name;
-				stream << entity.position.x << entity.position.y;
-				stream << entity.rotation.ToDegrees();
+				nlohmann::json assetInfo;
+				assetInfo["filePath"] = mapAsset.filepath;
+				assetInfo["checksum"] = mapAsset.sha1Checksum;
+				assetInfo["size"] = mapAsset.size;
 
-				CompressedSigned<EntityId> compressedUniqueId(entity.uniqueId);
-				stream << compressedUniqueId;
+				assetArray.emplace_back(std::move(assetInfo));
+			}
 
-				CompressedUnsigned<Nz::UInt16> propertyCount(Nz::UInt16(entity.properties.size()));
-				stream << propertyCount;
+			return assetArray;
+		}
 
-				for (const auto& [key, value] : entity.properties)
-				{
-					stream << key;
+		// Returns null when the layer uses default physics settings
+		nlohmann::json SerializeLayerPhysics(const Map::LayerPhysics& physics)
+		{
+			nlohmann::json physicsInfo;
+			if (physics.iterationCount)
+				physicsInfo["iterationCount"] = *physics.iterationCount;
 
-					auto [P, isArray] = ExtractPropertyType(value);
+			if (physics.sleepTime)
+				physicsInfo["sleepTime"] = *physics.sleepTime;
 
-					Nz::UInt8 propertyType = Nz::UInt8(P);
-					stream << propertyType;
+			if (physics.spatialHashCellSize)
+				physicsInfo["spatialHashCellSize"] = *physics.spatialHashCellSize;
 
-					stream << isArray;
+			return physicsInfo;
+		}
 
-					std::visit([&](auto&& propertyValue)
+		// SAX handler building layers and entities as they are parsed, only one entity is held as a json value at once
+		class MapJsonReader final : public nlohmann::json_sax<nlohmann::json>
+		{
+			public:
+				MapJsonReader() = default;
+
+				bool null() override { return AddValue(nullptr); }
+				bool boolean(bool val) override { return AddValue(val); }
+				bool number_integer(number_integer_t val) override { return AddValue(val); }
+				bool number_unsigned(number_unsigned_t val) override { return AddValue(val); }
+				bool number_float(number_float_t val, const string_t& /*s*/) override { return AddValue(val); }
+				bool string(string_t& val) override { return AddValue(std::move(val)); }
+				bool binary(binary_t& val) override { return AddValue(nlohmann::json::binary(std::move(val))); }
+
+				bool start_object(std::size_t /*elements*/) override
+				{
+					if (m_valueStack.empty())
 					{
-						using T = std::decay_t<decltype(propertyValue)>;
-						using TypeExtractor = PropertyTypeExtractor<T>;
-						constexpr bool IsArray = TypeExtractor::IsArray;
+						if (m_contexts.empty())
+						{
+							m_contexts.push_back(Context::Root);
+							return true;
+						}
 
-						if constexpr (IsArray)
+						if (m_contexts.back() == Context::Layers)
 						{
-							CompressedUnsigned<Nz::UInt32> arraySize(Nz::UInt32(propertyValue.size()));
+							m_layers.emplace_back();
+							m_layerInfo = nlohmann::json::object();
+							m_contexts.push_back(Context::Layer);
+							return true;
+						}
+					}
 
-							stream << arraySize;
-							for (const auto& element : propertyValue)
-								stream << element;
+					return BeginValue(nlohmann::json::object());
+				}
+
+				bool key(string_t& val) override
+				{
+					if (m_valueStack.empty())
+						m_key = std::move(val);
+					else
+						m_valueKey = std::move(val);
+
+					return true;
+				}
+
+				bool end_object() override
+				{
+					if (!m_valueStack.empty())
+						return EndValue();
+
+					if (m_contexts.back() == Context::Layer)
+						ParseLayerInfo(m_layerInfo, m_layers.back());
+
+					m_contexts.pop_back();
+					return true;
+				}
+
+				bool start_array(std::size_t /*elements*/) override
+				{
+					if (m_valueStack.empty() && !m_contexts.empty())
+					{
+						if (m_contexts.back() == Context::Root && m_key == "layers")
+						{
+							m_contexts.push_back(Context::Layers);
+							return true;
+						}
+
+						if (m_contexts.back() == Context::Layer && m_key == "entities")
+						{
+							m_contexts.push_back(Context::Entities);
+							return true;
 						}
-						else
-							stream << propertyValue.value;
+					}
+
+					return BeginValue(nlohmann::json::array());
+				}
+
+				bool end_array() override
+				{
+					if (!m_valueStack.empty())
+						return EndValue();
+
+					m_contexts.pop_back();
+					return true;
+				}
+
+				bool parse_error(std::size_t /*position*/, const std::string& /*lastToken*/, const nlohmann::detail::exception& ex) override
+				{
+					throw std::runtime_error(std::string("failed to parse info.json: ") + ex.what());
+				}
+
+				std::vector<Map::Asset>& GetAssets() { return m_assets; }
+				std::vector<Map::Layer>& GetLayers() { return m_layers; }
+				const nlohmann::json& GetRootInfo() const { return m_rootInfo; }
+
+			private:
+				enum class Context
+				{
+					Root,
+					Layers,
+					Layer,
+					Entities
+				};
+
+				bool AddValue(nlohmann::json value)
+				{
+					if (m_valueStack.empty())
+						return DeliverValue(std::move(value));
+
+					nlohmann::json& container = *m_valueStack.back();
+					if (container.is_object())
+						container[m_valueKey] = std::move(value);
+					else
+						container.push_back(std::move(value));
+
+					return true;
+				}
+
+				bool BeginValue(nlohmann::json container)
+				{
+					if (m_valueStack.empty())
+					{
+						m_value = std::move(container);
+						m_valueStack.push_back(&m_value);
+						return true;
+					}
+
+					// Only the innermost container grows, pointers to its parents stay valid
+					nlohmann::json& parent = *m_valueStack.back();
+					if (parent.is_object())
+						m_valueStack.push_back(&(parent[m_valueKey] = std::move(container)));
+					else
+					{
+						parent.push_back(std::move(container));
+						m_valueStack.push_back(&parent.back());
+					}
+
+					return true;
+				}
+
+				bool DeliverValue(nlohmann::json value)
+				{
+					if (m_contexts.empty())
+						throw std::runtime_error("info.json root is not an object");
+
+					switch (m_contexts.back())
+					{
+						case Context::Root:
+							if (m_key == "assets")
+								ParseAssets(value, m_assets);
+							else
+								m_rootInfo[m_key] = std::move(value);
+							break;
+
+						case Context::Layers:
+							throw std::runtime_error("layers must be objects");
+
+						case Context::Layer:
+							m_layerInfo[m_key] = std::move(value);
+							break;
+
+						case Context::Entities:
+							m_layers.back().entities.emplace_back(Map::UnserializeEntity(value));
+							break;
+					}
+
+					return true;
+				}
 
-					}, value);
+				bool EndValue()
+				{
+					m_valueStack.pop_back();
+					if (m_valueStack.empty())
+						return DeliverValue(std::move(m_value));
+
+					return true;
+				}
+
+				std::string m_key;
+				std::string m_valueKey;
+				std::vector<Context> m_contexts;
+				std::vector<nlohmann::json*> m_valueStack;
+				std::vector<Map::Asset> m_assets;
+				std::vector<Map::Layer> m_layers;
+				nlohmann::json m_layerInfo;
+				nlohmann::json m_rootInfo = nlohmann::json::object();
+				nlohmann::json m_value;
+		};
+
+		// Writes json values through a buffer, indenting them as if they were dumped as part of a bigger document
+		class MapJsonWriter
+		{
+			public:
+				MapJsonWriter(Nz::File& file) :
+				m_file(file),
+				m_hasFailed(false)
+				{
+					m_buffer.reserve(JsonWriteBufferSize);
+				}
+
+				bool Flush()
+				{
+					if (!m_buffer.empty())
+					{
+						if (m_file.Write(m_buffer.data(), m_buffer.size()) != m_buffer.size())
+							m_hasFailed = true;
+
+						m_buffer.clear();
+					}
+
+					return !m_hasFailed;
+				}
+
+				void Write(std::string_view str)
+				{
+					m_buffer.append(str);
+					if (m_buffer.size() >= JsonWriteBufferSize)
+						Flush();
+				}
+
+				void WriteValue(const nlohmann::json& value, std::size_t depth)
+				{
+					std::string content = value.dump(1, '\t');
+
+					std::size_t startPos = 0;
+					std::size_t lineEnd;
+					while ((lineEnd = content.find('\n', startPos)) != content.npos)
+					{
+						m_buffer.append(content, startPos, lineEnd - startPos + 1);
+						m_buffer.append(depth, '\t');
+						startPos = lineEnd + 1;
+					}
+					m_buffer.append(content, startPos);
+
+					if (m_buffer.size() >= JsonWriteBufferSize)
+						Flush();
+				}
+
+			private:
+				std::string m_buffer;
+				Nz::File& m_file;
+				bool m_hasFailed;
+		};
+	}
+
+	bool Map::Compile(const std::filesystem::path& outputPath, bool compressSections)
+	{
+		Nz::File infoFile(outputPath.generic_u8string(), Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate);
+		if (!infoFile.IsOpen())
+			return false;
+
+		using Compression = BinaryMapReader::Compression;
+		using Section = BinaryMapReader::Section;
+
+		// Serialize every section first, as the section table (written before them) holds their offsets and sizes
+		std::vector<Nz::UInt8> sectionData;
+		std::vector<Nz::UInt8> compressedData;
+
+		auto AppendSection = [&](const Nz::UInt8* data, std::size_t size)
+		{
+			Section section;
+			section.offset = sectionData.size();
+			section.uncompressedSize = size;
+
+			// Scripts and entity properties are mostly text which compresses well, sections are kept raw when it doesn't help
+			if (compressSections && size >= SectionCompressionThreshold && size <= BinaryMapReader::MaxUncompressedSectionSize)
+			{
+				int maxCompressedSize = LZ4_compressBound(int(size));
+				compressedData.resize(maxCompressedSize);
+
+				int compressedSize = LZ4_compress_HC(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(compressedData.data()), int(size), maxCompressedSize, LZ4HC_CLEVEL_MAX);
+				if (compressedSize > 0 && std::size_t(compressedSize) < size)
+				{
+					section.compression = Compression::LZ4;
+					data = compressedData.data();
+					size = std::size_t(compressedSize);
 				}
 			}
-		}
+
+			section.size = size;
+			section.checksum = BinaryMapReader::ComputeChecksum(data, size);
+			sectionData.insert(sectionData.end(), data, data + size);
+
+			return section;
+		};
+
+		auto SerializeSection = [&](auto&& writer)
+		{
+			Nz::ByteArray content;
+			{
+				Nz::ByteStream contentStream(&content, Nz::OpenMode_WriteOnly);
+				contentStream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+				writer(contentStream);
+			}
+
+			return AppendSection(content.GetConstBuffer(), content.GetSize());
+		};
+
+		// Map layers
+		std::vector<Section> layerSections;
+		layerSections.reserve(m_layers.size());
+
+		for (const Layer& layer : m_layers)
+			layerSections.push_back(SerializeSection([&](Nz::ByteStream& contentStream) { WriteBinaryLayer(contentStream, layer); }));
 
 		// Scripts
-		CompressedUnsigned<Nz::UInt32> scriptCount(Nz::UInt32(m_scripts.size()));
-		stream << scriptCount;
+		std::vector<std::pair<Section, Section>> scriptSections; //< content, bytecode
+		scriptSections.reserve(m_scripts.size());
 
 		for (const auto& script : m_scripts)
 		{
-			stream << script.filepath;
-			CompressedUnsigned<Nz::UInt64> scriptSize(Nz::UInt64(script.content.size()));
-			stream << scriptSize;
-			stream.Write(script.content.data(), script.content.size());
+			std::string_view source = script.GetContent();
+
+			Section contentSection = AppendSection(reinterpret_cast<const Nz::UInt8*>(source.data()), source.size());
+
+			// Precompile scripts so servers don't have to, leave bytecode empty if the script doesn't compile (error will be reported at load time)
+			ScriptBytecodeCache::Bytecode bytecode;
+			if (!ScriptBytecodeCache::Compile(script.filepath, source, &bytecode))
+				bytecode.clear();
+
+			Section bytecodeSection = AppendSection(reinterpret_cast<const Nz::UInt8*>(bytecode.data()), bytecode.size());
+
+			scriptSections.emplace_back(contentSection, bytecodeSection);
 		}
 
 		// Assets
-		CompressedUnsigned<Nz::UInt32> assetCount(Nz::UInt32(m_assets.size()));
-		stream << assetCount;
+		Section assetSection = SerializeSection([&](Nz::ByteStream& contentStream)
+		{
+			CompressedUnsigned<Nz::UInt32> assetCount(Nz::UInt32(m_assets.size()));
+			contentStream << assetCount;
+
+			for (const Asset& asset : m_assets)
+			{
+				contentStream << asset.filepath;
+				contentStream << asset.size;
+				contentStream.Write(asset.sha1Checksum.data(), asset.sha1Checksum.size());
+			}
+		});
+
+		Nz::ByteStream stream(&infoFile);
+		stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		stream.Write("Burgrmap", 8);
+		stream << BinaryFileVersion;
+
+		// Map header
+		stream << m_mapInfo.name << m_mapInfo.author << m_mapInfo.description;
+
+		// Game version
+		stream << GameVersion;
+
+		// Section table
+		auto WriteSectionEntry = [&](const Section& section)
+		{
+			stream << section.offset << section.size;
+			stream << static_cast<Nz::UInt8>(section.compression);
+			if (section.compression != Compression::None)
+				stream << section.uncompressedSize;
+
+			stream.Write(section.checksum->data(), section.checksum->size());
+		};
+
+		CompressedUnsigned<Nz::UInt16> layerCount(Nz::UInt16(m_layers.size()));
+		stream << layerCount;
 
-		for (const Asset& asset : m_assets)
+		for (std::size_t i = 0; i < m_layers.size(); ++i)
 		{
-			stream << asset.filepath;
-			stream << asset.size;
-			stream.Write(asset.sha1Checksum.data(), asset.sha1Checksum.size());
+			const Layer& layer = m_layers[i];
+
+			stream << layer.name;
+
+			CompressedUnsigned<Nz::UInt16> entityCount(Nz::UInt16(layer.entities.size()));
+			stream << entityCount;
+
+			WriteSectionEntry(layerSections[i]);
 		}
 
+		CompressedUnsigned<Nz::UInt32> scriptCount(Nz::UInt32(m_scripts.size()));
+		stream << scriptCount;
+
+		for (std::size_t i = 0; i < m_scripts.size(); ++i)
+		{
+			stream << m_scripts[i].filepath;
+			WriteSectionEntry(scriptSections[i].first);
+			WriteSectionEntry(scriptSections[i].second);
+		}
+
+		WriteSectionEntry(assetSection);
+
+		// Sections
+		stream.Write(sectionData.data(), sectionData.size());
+
 		return true;
 	}
 
@@ -231,16 +612,161 @@ namespace bw
 	{
 		assert(IsValid());
 
-		std::string content = Serialize(*this).dump(1, '\t');
-
 		Nz::File infoFile((mapFolderPath / "info.json").generic_u8string(), Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate);
 		if (!infoFile.IsOpen())
 			return false;
 
-		if (infoFile.Write(content.data(), content.size()) != content.size())
-			return false;
+		// Produces the same output as Serialize(*this).dump(1, '\t') (whose keys are sorted) without holding the whole document
+		MapJsonWriter writer(infoFile);
+		writer.Write("{\n\t\"assets\": ");
+		writer.WriteValue(SerializeAssets(m_assets), 1);
+		writer.Write(",\n\t\"author\": ");
+		writer.WriteValue(m_mapInfo.author, 1);
+		writer.Write(",\n\t\"description\": ");
+		writer.WriteValue(m_mapInfo.description, 1);
+		writer.Write(",\n\t\"gameVersion\": ");
+		writer.WriteValue(GetGameVersionString(), 1);
+		writer.Write(",\n\t\"layers\": ");
+		if (!m_layers.empty())
+		{
+			writer.Write("[\n");
+			for (std::size_t layerIndex = 0; layerIndex < m_layers.size(); ++layerIndex)
+			{
+				const Layer& layer = m_layers[layerIndex];
 
-		return true;
+				writer.Write("\t\t{\n\t\t\t\"backgroundColor\": ");
+				writer.WriteValue(layer.backgroundColor, 3);
+				writer.Write(",\n\t\t\t\"entities\": ");
+				if (!layer.entities.empty())
+				{
+					writer.Write("[\n");
+					for (std::size_t entityIndex = 0; entityIndex < layer.entities.size(); ++entityIndex)
+					{
+						writer.Write("\t\t\t\t");
+						writer.WriteValue(SerializeEntity(layer.entities[entityIndex]), 4);
+						writer.Write((entityIndex + 1 < layer.entities.size()) ? ",\n" : "\n");
+					}
+					writer.Write("\t\t\t]");
+				}
+				else
+					writer.Write("[]");
+
+				writer.Write(",\n\t\t\t\"name\": ");
+				writer.WriteValue(layer.name, 3);
+
+				if (nlohmann::json physicsInfo = SerializeLayerPhysics(layer.physics); !physicsInfo.is_null())
+				{
+					writer.Write(",\n\t\t\t\"physics\": ");
+					writer.WriteValue(physicsInfo, 3);
+				}
+
+				writer.Write((layerIndex + 1 < m_layers.size()) ? "\n\t\t},\n" : "\n\t\t}\n");
+			}
+			writer.Write("\t]");
+		}
+		else
+			writer.Write("[]");
+
+		writer.Write(",\n\t\"name\": ");
+		writer.WriteValue(m_mapInfo.name, 1);
+		writer.Write("\n}");
+
+		return writer.Flush();
+	}
+
+	void Map::ReadBinaryLayer(Nz::ByteStream& stream, Layer& layer, Nz::UInt16 fileVersion)
+	{
+		stream >> layer.name;
+		stream >> layer.backgroundColor;
+
+		if (fileVersion >= 2)
+		{
+			Nz::UInt8 physicsFlags;
+			stream >> physicsFlags;
+
+			if (physicsFlags & (1 << 0))
+			{
+				CompressedUnsigned<Nz::UInt32> iterationCount;
+				stream >> iterationCount;
+				layer.physics.iterationCount = static_cast<Nz::UInt32>(iterationCount);
+			}
+
+			if (physicsFlags & (1 << 1))
+				stream >> layer.physics.sleepTime.emplace();
+
+			if (physicsFlags & (1 << 2))
+				stream >> layer.physics.spatialHashCellSize.emplace();
+		}
+
+		CompressedUnsigned<Nz::UInt16> entityCount;
+		stream >> entityCount;
+
+		layer.entities.resize(entityCount);
+		for (Entity& entity : layer.entities)
+		{
+			stream >> entity.entityType;
+			stream >> entity.name;
+			stream >> entity.position.x >> entity.position.y;
+
+			float degRot;
+			stream >> degRot;
+			entity.rotation = Nz::DegreeAnglef::FromDegrees(degRot);
+
+			CompressedSigned<EntityId> compressedUniqueId;
+			stream >> compressedUniqueId;
+			entity.uniqueId = compressedUniqueId;
+
+			CompressedUnsigned<Nz::UInt16> propertyCount;
+			stream >> propertyCount;
+
+			std::size_t loopCount = propertyCount;
+			for (std::size_t i = 0; i < loopCount; ++i)
+			{
+				std::string propertyName;
+				stream >> propertyName;
+
+				Nz::UInt8 propertyTypeInt;
+				stream >> propertyTypeInt;
+
+				PropertyType propertyType = static_cast<PropertyType>(propertyTypeInt);
+
+				bool isArray;
+				stream >> isArray;
+
+				// Waiting for template lambda in C++20
+				auto Unserialize = [&](auto dummyType)
+				{
+					using T = std::decay_t<decltype(dummyType)>;
+
+					static constexpr PropertyType Property = T::Property;
+
+					if (isArray)
+					{
+						CompressedUnsigned<Nz::UInt32> size;
+						stream >> size;
+
+						PropertyArrayValue<Property> elements(size);
+						ReadPropertyArray(stream, elements);
+
+						entity.properties.emplace(std::move(propertyName), std::move(elements));
+					}
+					else
+					{
+						PropertySingleValue<Property> value;
+						stream >> value.value;
+
+						entity.properties.emplace(std::move(propertyName), std::move(value));
+					}
+				};
+
+				switch (propertyType)
+				{
+#define BURGWAR_PROPERTYTYPE(V, T, IT) case PropertyType:: T: Unserialize(PropertyTag<PropertyType:: T>{}); break;
+
+#include <CoreLib/PropertyTypeList.hpp>
+				}
+			}
+		}
 	}
 
 	nlohmann::json Map::Serialize(const Map& map)
@@ -253,19 +779,8 @@ namespace bw
 		mapJson["name"] = mapInfo.name;
 		mapJson["author"] = mapInfo.author;
 		mapJson["description"] = mapInfo.description;
-		mapJson["gameVersion"] = fmt::format("{}.{}.{}", GameMajorVersion, GameMinorVersion, GamePatchVersion);
-
-		auto assetArray = nlohmann::json::array();
-		for (const auto& mapAsset : map.GetAssets())
-		{
-			nlohmann::json assetInfo;
-			assetInfo["filePath"] = mapAsset.filepath;
-			assetInfo["checksum"] = mapAsset.sha1Checksum;
-			assetInfo["size"] = mapAsset.size;
-
-			assetArray.emplace_back(std::move(assetInfo));
-		}
-		mapJson["assets"] = std::move(assetArray);
+		mapJson["gameVersion"] = GetGameVersionString();
+		mapJson["assets"] = SerializeAssets(map.GetAssets());
 
 		auto layerArray = nlohmann::json::array();
 		for (const auto& mapLayer : map.GetLayers())
@@ -274,6 +789,9 @@ namespace bw
 			layerInfo["backgroundColor"] = mapLayer.backgroundColor;
 			layerInfo["name"] = mapLayer.name;
 
+			if (nlohmann::json physicsInfo = SerializeLayerPhysics(mapLayer.physics); !physicsInfo.is_null())
+				layerInfo["physics"] = std::move(physicsInfo);
+
 			auto entityArray = nlohmann::json::array();
 			for (auto&& entityEntry : mapLayer.entities)
 				entityArray.emplace_back(SerializeEntity(entityEntry));
@@ -335,32 +853,25 @@ namespace bw
 
 	Map Map::Unserialize(const nlohmann::json& mapJson)
 	{
-		MapInfo mapInfo;
+		Map map(ParseMapInfo(mapJson));
 
-		mapInfo.author = mapJson.value("author", "unknown");
-		mapInfo.description = mapJson.value("description", "");
-		mapInfo.name = mapJson.at("name");
-
-		Map map(std::move(mapInfo));
-
-		auto& assets = map.GetAssets();
-		for (auto&& entry : mapJson["assets"])
-		{
-			Asset& asset = assets.emplace_back();
-			asset.filepath = entry.at("filePath");
-			asset.sha1Checksum = entry.at("checksum");
-			asset.size = entry.value("size", Nz::UInt64(0));
-		}
+		if (auto it = mapJson.find("assets"); it != mapJson.end())
+			ParseAssets(*it, map.GetAssets());
 
 		auto& layers = map.GetLayers();
-		for (auto&& entry : mapJson["layers"])
+		if (auto it = mapJson.find("layers"); it != mapJson.end())
 		{
-			Layer& layer = layers.emplace_back();
-			layer.backgroundColor = entry.value("backgroundColor", Nz::Color::Black);
-			layer.name = entry.value("name", "");
+			for (auto&& entry : *it)
+			{
+				Layer& layer = layers.emplace_back();
+				ParseLayerInfo(entry, layer);
 
-			for (auto&& entityInfo : entry["entities"])
-				layer.entities.emplace_back(UnserializeEntity(entityInfo));
+				if (auto entitiesIt = entry.find("entities"); entitiesIt != entry.end())
+				{
+					for (auto&& entityInfo : *entitiesIt)
+						layer.entities.emplace_back(UnserializeEntity(entityInfo));
+				}
+			}
 		}
 
 		map.RebuildEntityIndices();
@@ -427,6 +938,85 @@ namespace bw
 		return entity;
 	}
 
+	void Map::WriteBinaryLayer(Nz::ByteStream& stream, const Layer& layer)
+	{
+		stream << layer.name;
+		stream << layer.backgroundColor;
+
+		const LayerPhysics& physics = layer.physics;
+
+		Nz::UInt8 physicsFlags = 0;
+		if (physics.iterationCount)
+			physicsFlags |= 1 << 0;
+
+		if (physics.sleepTime)
+			physicsFlags |= 1 << 1;
+
+		if (physics.spatialHashCellSize)
+			physicsFlags |= 1 << 2;
+
+		stream << physicsFlags;
+
+		if (physics.iterationCount)
+		{
+			CompressedUnsigned<Nz::UInt32> iterationCount(*physics.iterationCount);
+			stream << iterationCount;
+		}
+
+		if (physics.sleepTime)
+			stream << *physics.sleepTime;
+
+		if (physics.spatialHashCellSize)
+			stream << *physics.spatialHashCellSize;
+
+		CompressedUnsigned<Nz::UInt16> entityCount(Nz::UInt16(layer.entities.size()));
+		stream << entityCount;
+
+		for (const Entity& entity : layer.entities)
+		{
+			stream << entity.entityType;
+			stream << entity.name;
+			stream << entity.position.x << entity.position.y;
+			stream << entity.rotation.ToDegrees();
+
+			CompressedSigned<EntityId> compressedUniqueId(entity.uniqueId);
+			stream << compressedUniqueId;
+
+			CompressedUnsigned<Nz::UInt16> propertyCount(Nz::UInt16(entity.properties.size()));
+			stream << propertyCount;
+
+			for (const auto& [key, value] : entity.properties)
+			{
+				stream << key;
+
+				auto [P, isArray] = ExtractPropertyType(value);
+
+				Nz::UInt8 propertyType = Nz::UInt8(P);
+				stream << propertyType;
+
+				stream << isArray;
+
+				std::visit([&](auto&& propertyValue)
+				{
+					using T = std::decay_t<decltype(propertyValue)>;
+					using TypeExtractor = PropertyTypeExtractor<T>;
+					constexpr bool IsArray = TypeExtractor::IsArray;
+
+					if constexpr (IsArray)
+					{
+						CompressedUnsigned<Nz::UInt32> arraySize(Nz::UInt32(propertyValue.size()));
+
+						stream << arraySize;
+						WritePropertyArray(stream, propertyValue);
+					}
+					else
+						stream << propertyValue.value;
+
+				}, value);
+			}
+		}
+	}
+
 	bool Map::CheckEntityIndices() const
 	{
 		for (auto&& [uniqueId, indices] : m_entitiesByUniqueId)
@@ -445,155 +1035,114 @@ namespace bw
 		return true;
 	}
 
-	void Map::LoadFromBinaryInternal(const std::filesystem::path& mapFile)
+	bool Map::CheckEntityIndices(LayerIndex layerIndex) const
 	{
-		Nz::File infoFile(mapFile.generic_u8string(), Nz::OpenMode_ReadOnly);
-		if (!infoFile.IsOpen())
-			throw std::runtime_error("failed to open map file");
-
-		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
-
-		Nz::ByteStream stream(&infoFile);
-		stream.SetDataEndianness(Nz::Endianness_LittleEndian);
-
-		std::array<char, 8> signature;
-		if (stream.Read(signature.data(), signature.size()) != signature.size())
-			throw std::runtime_error("corrupted map file (or not a burger map file)");
-
-		if (std::memcmp(signature.data(), "Burgrmap", signature.size()) != 0)
-			throw std::runtime_error("not a valid burger map file");
-
-		Nz::UInt16 fileVersion;
-		stream >> fileVersion;
+		// Checks a single layer, for mutations which can't have touched the others
+		const auto& layer = m_layers[layerIndex];
+		for (std::size_t entityIndex = 0; entityIndex < layer.entities.size(); ++entityIndex)
+		{
+			auto it = m_entitiesByUniqueId.find(layer.entities[entityIndex].uniqueId);
+			if (it == m_entitiesByUniqueId.end())
+				return false;
 
-		if (fileVersion > MapFileVersion)
-			throw std::runtime_error("unhandled file version (more recent than game)");
+			if (it->second.layerIndex != layerIndex || it->second.entityIndex != entityIndex)
+				return false;
+		}
 
-		// Map header
-		stream >> m_mapInfo.name >> m_mapInfo.author >> m_mapInfo.description;
+		return true;
+	}
 
-		// For debugging purpose
-		if (fileVersion >= 1)
-		{
-			Nz::UInt32 gameVersion;
-			stream >> gameVersion;
-			NazaraUnused(gameVersion);
-		}
+	void Map::LoadFromBinaryInternal(const std::filesystem::path& mapFile)
+	{
+		BinaryMapReader reader(mapFile);
 
-		CompressedUnsigned<Nz::UInt16> layerCount;
-		stream >> layerCount;
+		m_mapInfo = reader.GetMapInfo();
 
 		m_layers.clear();
-		m_layers.resize(layerCount);
+		m_scripts.clear();
+		m_assets.clear();
 
-		for (Layer& layer : m_layers)
+		if (reader.HasSectionTable())
 		{
-			stream >> layer.name;
-			stream >> layer.backgroundColor;
-
-			CompressedUnsigned<Nz::UInt16> entityCount;
-			stream >> entityCount;
-
-			layer.entities.resize(entityCount);
-			for (Entity& entity : layer.entities)
-			{
-				stream >> entity.entityType;
-				stream >> entity.name;
-				stream >> entity.position.x >> entity.position.y;
+			m_layers.reserve(reader.GetLayerCount());
+			for (std::size_t i = 0; i < reader.GetLayerCount(); ++i)
+				m_layers.push_back(reader.LoadLayer(static_cast<LayerIndex>(i)));
 
-				float degRot;
-				stream >> degRot;
-				entity.rotation = Nz::DegreeAnglef::FromDegrees(degRot);
+			m_scripts.reserve(reader.GetScriptCount());
+			for (std::size_t i = 0; i < reader.GetScriptCount(); ++i)
+				m_scripts.push_back(reader.LoadScript(i));
 
-				CompressedSigned<EntityId> compressedUniqueId;
-				stream >> compressedUniqueId;
-				entity.uniqueId = compressedUniqueId;
+			m_assets = reader.LoadAssets();
+		}
+		else
+		{
+			// Older maps are a single stream following the header
+			Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
 
-				CompressedUnsigned<Nz::UInt16> propertyCount;
-				stream >> propertyCount;
+			const Nz::UInt8* fileData = reader.GetData();
+			std::size_t fileSize = reader.GetSize();
+			Nz::UInt16 fileVersion = reader.GetFileVersion();
 
-				std::size_t loopCount = propertyCount;
-				for (std::size_t i = 0; i < loopCount; ++i)
-				{
-					std::string propertyName;
-					stream >> propertyName;
+			Nz::MemoryView fileView(fileData, fileSize);
+			fileView.SetCursorPos(reader.GetContentOffset());
 
-					Nz::UInt8 propertyTypeInt;
-					stream >> propertyTypeInt;
+			Nz::ByteStream stream(&fileView);
+			stream.SetDataEndianness(Nz::Endianness_LittleEndian);
 
-					PropertyType propertyType = static_cast<PropertyType>(propertyTypeInt);
+			CompressedUnsigned<Nz::UInt16> layerCount;
+			stream >> layerCount;
 
-					bool isArray;
-					stream >> isArray;
+			m_layers.resize(layerCount);
+			for (Layer& layer : m_layers)
+				ReadBinaryLayer(stream, layer, fileVersion);
 
-					// Waiting for template lambda in C++20
-					auto Unserialize = [&](auto dummyType)
-					{
-						using T = std::decay_t<decltype(dummyType)>;
+			// Scripts
+			CompressedUnsigned<Nz::UInt32> scriptCount;
+			stream >> scriptCount;
 
-						static constexpr PropertyType Property = T::Property;
+			m_scripts.resize(scriptCount);
+			for (Script& script : m_scripts)
+			{
+				stream >> script.filepath;
 
-						if (isArray)
-						{
-							CompressedUnsigned<Nz::UInt32> size;
-							stream >> size;
+				CompressedUnsigned<Nz::UInt64> scriptSize;
+				stream >> scriptSize;
 
-							PropertyArrayValue<Property> elements(size);
-							for (auto& element : elements)
-								stream >> element;
+				Nz::UInt64 scriptOffset = fileView.GetCursorPos();
+				if (scriptSize > fileSize - scriptOffset)
+					throw std::runtime_error("corrupted map file (script " + script.filepath + " is out of bounds)");
 
-							entity.properties.emplace(std::move(propertyName), std::move(elements));
-						}
-						else
-						{
-							PropertySingleValue<Property> value;
-							stream >> value.value;
+				if (reader.GetMapping())
+					script.mappedContent = std::string_view(reinterpret_cast<const char*>(fileData + scriptOffset), static_cast<std::size_t>(scriptSize));
+				else
+					script.content.assign(fileData + scriptOffset, fileData + scriptOffset + scriptSize);
 
-							entity.properties.emplace(std::move(propertyName), std::move(value));
-						}
-					};
+				fileView.SetCursorPos(scriptOffset + scriptSize);
 
-					switch (propertyType)
-					{
-#define BURGWAR_PROPERTYTYPE(V, T, IT) case PropertyType:: T: Unserialize(PropertyTag<PropertyType:: T>{}); break;
+				if (fileVersion >= 3)
+				{
+					CompressedUnsigned<Nz::UInt64> bytecodeSize;
+					stream >> bytecodeSize;
 
-#include <CoreLib/PropertyTypeList.hpp>
-					}
+					script.bytecode.resize(bytecodeSize);
+					stream.Read(script.bytecode.data(), script.bytecode.size());
 				}
 			}
-		}
-
-		// Scripts
-		CompressedUnsigned<Nz::UInt32> scriptCount;
-		stream >> scriptCount;
-
-		m_scripts.clear();
-		m_scripts.resize(scriptCount);
-
-		for (Script& script : m_scripts)
-		{
-			stream >> script.filepath;
 
-			CompressedUnsigned<Nz::UInt64> scriptSize;
-			stream >> scriptSize;
+			// Assets
+			CompressedUnsigned<Nz::UInt32> assetCount;
+			stream >> assetCount;
 
-			script.content.resize(scriptSize);
-			stream.Read(script.content.data(), script.content.size());
+			m_assets.resize(assetCount);
+			for (Asset& asset : m_assets)
+			{
+				stream >> asset.filepath;
+				stream >> asset.size;
+				stream.Read(asset.sha1Checksum.data(), asset.sha1Checksum.size());
+			}
 		}
 
-		// Assets
-		CompressedUnsigned<Nz::UInt32> assetCount;
-		stream >> assetCount;
-
-		m_assets.clear();
-		m_assets.resize(assetCount);
-
-		for (Asset& asset : m_assets)
-		{
-			stream >> asset.filepath;
-			stream >> asset.size;
-			stream.Read(asset.sha1Checksum.data(), asset.sha1Checksum.size());
-		}
+		m_mapping = reader.GetMapping(); //< keeps script views valid
 
 		RebuildEntityIndices();
 		Sanitize();
@@ -613,9 +1162,15 @@ namespace bw
 		if (infoFile.Read(content.data(), content.size()) != content.size())
 			throw std::runtime_error("failed to read info.json file");
 
-		nlohmann::json json = nlohmann::json::parse(content.begin(), content.end());
+		// Layers and entities are built while parsing instead of going through a whole document
+		MapJsonReader reader;
+		nlohmann::json::sax_parse(content.begin(), content.end(), &reader);
 
-		Map map = Unserialize(json);
+		Map map(ParseMapInfo(reader.GetRootInfo()));
+		map.m_assets = std::move(reader.GetAssets());
+		map.m_layers = std::move(reader.GetLayers());
+		map.RebuildEntityIndices();
+		map.Sanitize();
 
 		// Load map scripts
 		std::filesystem::path mapScriptDir = mapFolder / "scripts";
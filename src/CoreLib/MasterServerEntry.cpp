@@ -3,10 +3,13 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/MasterServerEntry.hpp>
+#include <CoreLib/BurgApp.hpp>
 #include <CoreLib/Match.hpp>
 #include <CoreLib/Version.hpp>
+#include <CoreLib/WebService.hpp>
 #include <CoreLib/LogSystem/Logger.hpp>
 #include <CoreLib/Scripting/ServerGamemode.hpp>
+#include <CoreLib/Utility/JobSystem.hpp>
 #include <nlohmann/json.hpp>
 #include <functional>
 
@@ -15,27 +18,53 @@ namespace bw
 	namespace
 	{
 		constexpr Nz::UInt32 MasterServerDataVersion = 1U;
+
+		constexpr float ChangeCheckInterval = 5.f; //< minimum delay between two refreshes triggered by a change
+		constexpr float HeartbeatInterval = 30.f; //< refresh delay when nothing changed, keeps the server listed
+		constexpr float RetryInterval = 15.f;
+		constexpr Nz::UInt64 RequestTimeout = 10'000; //< milliseconds
 	}
 
 	MasterServerEntry::MasterServerEntry(Match& match, std::string masterServerURL) :
+	m_responses(std::make_shared<ResponseQueue>()),
 	m_masterServerURL(std::move(masterServerURL)),
 	m_match(match),
-	m_webService(m_match.GetLogger())
+	m_isDeltaRefreshSupported(true),
+	m_isRequestPending(false),
+	m_timeBeforeChangeCheck(0.f),
+	m_timeBeforeRefresh(0.f)
 	{
 	}
 
 	void MasterServerEntry::Update(float elapsedTime)
 	{
-		m_webService.Poll();
+		Response response;
+		while (m_responses->try_dequeue(response))
+			HandleResponse(std::move(response));
+
+		// Never stack requests, the next one will hold every change anyway
+		if (m_isRequestPending)
+			return;
 
 		m_timeBeforeRefresh -= elapsedTime;
-		if (m_timeBeforeRefresh >= 0.f)
+		if (m_updateToken.empty())
+		{
+			if (m_timeBeforeRefresh < 0.f)
+				Register();
+
 			return;
+		}
 
-		if (!m_updateToken.empty())
-			Refresh();
-		else
-			Register();
+		m_timeBeforeChangeCheck -= elapsedTime;
+		if (m_timeBeforeRefresh >= 0.f && m_timeBeforeChangeCheck >= 0.f)
+			return;
+
+		m_timeBeforeChangeCheck = ChangeCheckInterval;
+
+		// Refresh early when something changed (players joining/leaving), otherwise only send a heartbeat from time to time
+		nlohmann::json serverInfo = BuildServerInfo();
+		if (m_timeBeforeRefresh < 0.f || HasServerInfoChanged(serverInfo))
+			Refresh(serverInfo);
 	}
 
 	nlohmann::json MasterServerEntry::BuildServerInfo() const
@@ -73,15 +102,41 @@ namespace bw
 		return serverData;
 	}
 
-	void MasterServerEntry::HandleResponse(WebRequestResult&& result, bool refresh)
+	void MasterServerEntry::HandleResponse(Response&& response)
 	{
-		if (!result)
+		if (response.requestType == RequestType::RegisterIPv4)
+		{
+			if (!response.hasSucceeded)
+				bwLog(m_match.GetLogger(), LogLevel::Error, "failed to register ipv4 to master server {0}: {1}", m_masterServerURL, response.errorMessage);
+			else if (response.responseCode != 200)
+				bwLog(m_match.GetLogger(), LogLevel::Error, "failed to register ipv4 to master server {0}, unexpected response {1}: {2}", m_masterServerURL, response.responseCode, response.body);
+			else
+				bwLog(m_match.GetLogger(), LogLevel::Debug, "successfully registered ipv4 to master server {0}", m_masterServerURL);
+
+			return;
+		}
+
+		bool refresh = (response.requestType == RequestType::Refresh);
+
+		// Older master servers reject partial refreshes, fall back to full refreshes for them
+		if (response.isDelta && response.hasSucceeded && response.responseCode == 400)
+		{
+			bwLog(m_match.GetLogger(), LogLevel::Warning, "master server {0} rejected partial refresh, falling back to full refreshes", m_masterServerURL);
+			m_isDeltaRefreshSupported = false;
+			m_isRequestPending = false;
+			m_timeBeforeRefresh = 0.f;
+			return;
+		}
+
+		m_isRequestPending = false;
+
+		if (!response.hasSucceeded)
 		{
-			bwLog(m_match.GetLogger(), LogLevel::Error, (refresh) ? "failed to refresh to {0}, register request failed: {1}" : "failed to register to {0}, register request failed: {1}", m_masterServerURL, result.GetErrorMessage());
+			bwLog(m_match.GetLogger(), LogLevel::Error, (refresh) ? "failed to refresh to {0}, register request failed: {1}" : "failed to register to {0}, register request failed: {1}", m_masterServerURL, response.errorMessage);
 			return;
 		}
 
-		switch (result.GetReponseCode())
+		switch (response.responseCode)
 		{
 			case 200:
 			{
@@ -89,40 +144,23 @@ namespace bw
 
 				try
 				{
-					nlohmann::json response = nlohmann::json::parse(result.GetBody());
-					Nz::UInt32 dataVersion = response["data_version"];
+					nlohmann::json responseData = nlohmann::json::parse(response.body);
+					Nz::UInt32 dataVersion = responseData["data_version"];
 					if (dataVersion != MasterServerDataVersion)
 						bwLog(m_match.GetLogger(), LogLevel::Warning, "unexpected data version (expected {0}, got {1})", MasterServerDataVersion, dataVersion);
 
-					nlohmann::json ipv4UrlValue = response["register_ipv4_url"];
-					updateToken = response["token"];
+					nlohmann::json ipv4UrlValue = responseData["register_ipv4_url"];
+					updateToken = responseData["token"];
 
 					if (!refresh && ipv4UrlValue.is_string())
 					{
 						std::string ipv4Url = ipv4UrlValue;
 						if (!ipv4Url.empty())
 						{
-							std::unique_ptr<WebRequest> request = WebRequest::Post(ipv4Url, [&](WebRequestResult&& result)
-							{
-								if (result.HasSucceeded())
-								{
-									if (result.GetReponseCode() == 200)
-										bwLog(m_match.GetLogger(), LogLevel::Debug, "successfully registered ipv4 to master server {0}", m_masterServerURL);
-									else
-										bwLog(m_match.GetLogger(), LogLevel::Error, "failed to register ipv4 to master server {0}, unexpected response {1}: {2}", m_masterServerURL, result.GetReponseCode(), result.GetBody());
-								}
-								else
-									bwLog(m_match.GetLogger(), LogLevel::Error, "failed to register ipv4 to master server {0}: {1}", m_masterServerURL, result.GetErrorMessage());
-							});
-
-							request->ForceProtocol(Nz::NetProtocol_IPv4); //< Just in case
-
 							nlohmann::json requestData;
 							requestData["update_token"] = updateToken;
 
-							request->SetJSonContent(requestData.dump());
-
-							m_webService.AddRequest(std::move(request));
+							SendRequest(std::move(ipv4Url), requestData, RequestType::RegisterIPv4);
 						}
 					}
 				}
@@ -133,8 +171,9 @@ namespace bw
 				}
 
 				bwLog(m_match.GetLogger(), LogLevel::Info, (refresh) ? "successfully refreshed server to {0}" : "successfully registered server to {0}", m_masterServerURL);
+				m_sentFields = std::move(m_pendingFields);
 				m_updateToken = std::move(updateToken);
-				m_timeBeforeRefresh = 30.f;
+				m_timeBeforeRefresh = HeartbeatInterval;
 				break;
 			}
 
@@ -143,6 +182,7 @@ namespace bw
 				if (refresh)
 				{
 					bwLog(m_match.GetLogger(), LogLevel::Warning, "master server {0} rejected token, retrying to register server...", m_masterServerURL);
+					m_sentFields.clear();
 					m_updateToken.clear();
 					m_timeBeforeRefresh = 1.f;
 					break;
@@ -152,41 +192,111 @@ namespace bw
 			}
 
 			default:
-				bwLog(m_match.GetLogger(), LogLevel::Info, (refresh) ? "failed to refresh to {0}: refresh request failed with code {1}" : "failed to register to {0}: register request failed with code {1}", m_masterServerURL, result.GetReponseCode());
+				bwLog(m_match.GetLogger(), LogLevel::Info, (refresh) ? "failed to refresh to {0}: refresh request failed with code {1}" : "failed to register to {0}: register request failed with code {1}", m_masterServerURL, response.responseCode);
 				break;
 		}
 	}
 
-	void MasterServerEntry::Refresh()
+	bool MasterServerEntry::HasServerInfoChanged(const nlohmann::json& serverInfo) const
 	{
-		std::unique_ptr<WebRequest> request = WebRequest::Post(m_masterServerURL + "/servers", [&](WebRequestResult&& result)
+		if (serverInfo.size() != m_sentFields.size())
+			return true;
+
+		for (auto it = serverInfo.begin(); it != serverInfo.end(); ++it)
 		{
-			HandleResponse(std::move(result), true);
-		});
+			auto fieldIt = m_sentFields.find(it.key());
+			if (fieldIt == m_sentFields.end() || fieldIt->second != it.value().dump())
+				return true;
+		}
+
+		return false;
+	}
 
-		request->SetServiceName("MasterServer");
+	void MasterServerEntry::Refresh(const nlohmann::json& serverInfo)
+	{
+		tsl::hopscotch_map<std::string, std::string> fields = SerializeFields(serverInfo);
+
+		// Only send fields the master server doesn't know yet, an unchanged server only sends its token (and data version)
+		nlohmann::json requestData;
+		if (m_isDeltaRefreshSupported)
+		{
+			for (auto it = serverInfo.begin(); it != serverInfo.end(); ++it)
+			{
+				auto sentIt = m_sentFields.find(it.key());
+				if (sentIt == m_sentFields.end() || sentIt->second != fields[it.key()])
+					requestData[it.key()] = it.value();
+			}
+
+			requestData["data_version"] = MasterServerDataVersion;
+		}
+		else
+			requestData = serverInfo;
 
-		nlohmann::json serverData = BuildServerInfo();
-		serverData["update_token"] = m_updateToken;
+		requestData["update_token"] = m_updateToken;
 
-		request->SetJSonContent(serverData.dump());
+		m_pendingFields = std::move(fields);
+		SendRequest(m_masterServerURL + "/servers", requestData, RequestType::Refresh, m_isDeltaRefreshSupported);
 
-		m_webService.AddRequest(std::move(request));
-		m_timeBeforeRefresh = 15.f;
+		m_isRequestPending = true;
+		m_timeBeforeRefresh = RetryInterval;
 	}
 
 	void MasterServerEntry::Register()
 	{
-		std::unique_ptr<WebRequest> request = WebRequest::Post(m_masterServerURL + "/servers", [&](WebRequestResult&& result)
+		nlohmann::json serverInfo = BuildServerInfo();
+		m_pendingFields = SerializeFields(serverInfo);
+
+		SendRequest(m_masterServerURL + "/servers", serverInfo, RequestType::Register);
+
+		m_isRequestPending = true;
+		m_timeBeforeRefresh = RetryInterval;
+	}
+
+	void MasterServerEntry::SendRequest(std::string url, const nlohmann::json& requestData, RequestType requestType, bool isDelta)
+	{
+		BurgApp& app = m_match.GetApp();
+
+		// Only plain data crosses threads: the request is built and polled by the main thread, its result comes back through the response queue
+		app.GetJobSystem().DispatchToMainThread([&app, url = std::move(url), content = requestData.dump(), responses = m_responses, requestType, isDelta]
 		{
-			HandleResponse(std::move(result), false);
-		});
+			std::unique_ptr<WebRequest> request = WebRequest::Post(url, [responses, requestType, isDelta](WebRequestResult&& result)
+			{
+				Response response;
+				response.isDelta = isDelta;
+				response.requestType = requestType;
+
+				response.hasSucceeded = result.HasSucceeded();
+				if (response.hasSucceeded)
+				{
+					response.body = std::move(result.GetBody());
+					response.responseCode = result.GetReponseCode();
+				}
+				else
+					response.errorMessage = result.GetErrorMessage();
+
+				responses->enqueue(std::move(response));
+			});
 
-		request->SetServiceName("MasterServer");
+			if (requestType == RequestType::RegisterIPv4)
+				request->ForceProtocol(Nz::NetProtocol_IPv4); //< Just in case
+			else
+			{
+				request->SetServiceName("MasterServer");
+				request->SetTimeout(RequestTimeout);
+			}
 
-		request->SetJSonContent(BuildServerInfo().dump());
+			request->SetJSonContent(content);
+
+			app.GetWebService().AddRequest(std::move(request));
+		});
+	}
+
+	tsl::hopscotch_map<std::string, std::string> MasterServerEntry::SerializeFields(const nlohmann::json& serverInfo)
+	{
+		tsl::hopscotch_map<std::string, std::string> fields;
+		for (auto it = serverInfo.begin(); it != serverInfo.end(); ++it)
+			fields.emplace(it.key(), it.value().dump());
 
-		m_webService.AddRequest(std::move(request));
-		m_timeBeforeRefresh = 15.f;
+		return fields;
 	}
 }
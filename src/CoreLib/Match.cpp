@@ -8,12 +8,16 @@
 #include <CoreLib/ConfigFile.hpp>
 #include <CoreLib/MatchClientSession.hpp>
 #include <CoreLib/MatchClientVisibility.hpp>
+#include <CoreLib/MatchRecorder.hpp>
 #include <CoreLib/Mod.hpp>
 #include <CoreLib/NetworkSessionManager.hpp>
 #include <CoreLib/Terrain.hpp>
 #include <CoreLib/Components/MatchComponent.hpp>
+#include <CoreLib/Components/OwnerComponent.hpp>
+#include <CoreLib/Components/WeaponWielderComponent.hpp>
 #include <CoreLib/Protocol/CompressedInteger.hpp>
 #include <CoreLib/Protocol/Packets.hpp>
+#include <CoreLib/Scripting/ScriptBytecodeCache.hpp>
 #include <CoreLib/Scripting/ServerElementLibrary.hpp>
 #include <CoreLib/Scripting/ServerEntityLibrary.hpp>
 #include <CoreLib/Scripting/ServerWeaponLibrary.hpp>
@@ -21,28 +25,103 @@
 #include <CoreLib/Scripting/ServerScriptingLibrary.hpp>
 #include <CoreLib/Systems/NetworkSyncSystem.hpp>
 #include <CoreLib/Utils.hpp>
+#include <CoreLib/Utility/JobSystem.hpp>
+#include <CoreLib/Utility/MemoryUsage.hpp>
+#include <CoreLib/Utility/Profiling.hpp>
+#include <Nazara/Core/ByteArray.hpp>
+#include <Nazara/Core/Clock.hpp>
 #include <Nazara/Core/File.hpp>
 #include <NDK/Components/PhysicsComponent2D.hpp>
+#include <fmt/format.h>
 #include <tsl/hopscotch_set.h>
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <filesystem>
 #include <fstream>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string_view>
+#include <thread>
 
 namespace bw
 {
+	namespace
+	{
+		constexpr std::size_t PingFullUpdateInterval = 10; //< every X ping updates, send every ping (updates are unreliable)
+		constexpr Nz::UInt16 PingUpdateThreshold = 5; //< milliseconds a ping has to change by to be sent again
+		constexpr Nz::UInt16 UnsentPing = std::numeric_limits<Nz::UInt16>::max();
+		constexpr float TickRateUpdateDelay = 0.5f; //< seconds between a tick rate change announcement and the tick it applies to
+	}
+
 	Match::Match(BurgApp& app, MatchSettings matchSettings, GamemodeSettings gamemodeSettings, ModSettings modSettings) :
 	SharedMatch(app, LogSide::Server, matchSettings.name, matchSettings.tickDuration),
 	m_maxPlayerCount(matchSettings.maxPlayerCount),
 	m_nextUniqueId(matchSettings.map.GetFreeUniqueId()),
+	m_lastCheckpointTime(0),
+	m_lastMetricsUpdate(0),
+	m_lastNetworkStatisticsLog(0),
 	m_lastPingUpdate(0),
-	m_app(app),
+	m_pingUpdateCounter(0),
+	m_lastTickProfileLog(0),
+	m_lastTickRateEvaluation(0),
+	m_pendingTickRateTick(0),
+	m_tickRateEvaluationTick(0),
+	m_tickRateEvaluationTickDuration(0),
+	m_randomSeed(matchSettings.randomSeed.value_or(std::random_device{}())),
+	m_sentNetworkStringCount(0),
+	m_checksumCache(GetLogger(), app.GetConfig().GetStringValue("Resources.ChecksumCacheFile")),
 	m_gamemodeSettings(std::move(gamemodeSettings)),
 	m_map(std::move(matchSettings.map)),
 	m_sessions(*this),
 	m_settings(std::move(matchSettings)),
 	m_modSettings(std::move(modSettings)),
+	m_deferredMasterServerTime(0.f),
 	m_isResetting(false),
 	m_isMatchRunning(true)
 	{
+		TickProfiler& tickProfiler = GetTickProfiler();
+		tickProfiler.Enable(m_settings.tickProfiling);
+
+		EnableLoadShedding(m_settings.loadShedding);
+
+		// Replays are played back at a single tick rate
+		if (m_settings.adaptiveTickRate && !m_settings.replayRecordPath.empty())
+		{
+			bwLog(GetLogger(), LogLevel::Warning, "adaptive tick rate is disabled while recording the match");
+			m_settings.adaptiveTickRate.reset();
+		}
+
+		m_tickProfilerSections.sessionTick = tickProfiler.RegisterSection("sessions/OnTick");
+		m_tickProfilerSections.playerTick = tickProfiler.RegisterSection("players/OnTick");
+		m_tickProfilerSections.gamemodeTick = tickProfiler.RegisterSection("gamemode/Tick");
+		m_tickProfilerSections.scriptGarbageCollection = tickProfiler.RegisterSection("scripts/GC");
+		m_tickProfilerSections.sessionUpdate = tickProfiler.RegisterSection("sessions/Update");
+
+		// Resumed matches keep their random seed, so scripts seeded with it keep the same sequences
+		std::optional<MatchCheckpoint> checkpoint;
+		if (!m_settings.checkpointPath.empty() && std::filesystem::exists(m_settings.checkpointPath))
+		{
+			try
+			{
+				checkpoint = MatchCheckpoint::LoadFromFile(m_settings.checkpointPath);
+				if (checkpoint->gamemodeName != m_gamemodeSettings.name || checkpoint->layers.size() != m_map.GetLayerCount())
+				{
+					bwLog(GetLogger(), LogLevel::Error, "checkpoint {0} was saved from another gamemode or map, starting a new match", m_settings.checkpointPath);
+					checkpoint.reset();
+				}
+				else
+					m_randomSeed = checkpoint->randomSeed;
+			}
+			catch (const std::exception& e)
+			{
+				bwLog(GetLogger(), LogLevel::Error, "failed to load checkpoint {0}: {1}, starting a new match", m_settings.checkpointPath, e.what());
+				checkpoint.reset();
+			}
+		}
+
 		ReloadMods();
 		ReloadAssets();
 		ReloadScripts();
@@ -50,15 +129,44 @@ namespace bw
 		m_terrain = std::make_unique<Terrain>(*this, m_map);
 		m_terrain->Initialize();
 
+		if (m_settings.workerThreadCount > 0)
+		{
+			m_workerPool = std::make_unique<WorkerPool>(m_settings.workerThreadCount);
+
+			if (m_settings.parallelLayerUpdate)
+				m_terrain->SetWorkerPool(m_workerPool.get());
+		}
+
 		m_scriptingContext->LoadDirectoryOpt("map/autorun");
 
+		if (m_settings.fileWatchDelay > 0.f)
+		{
+			// Only physical roots are watched, files of mods are listed when they are loaded
+			auto WatchDirectory = [&](std::optional<FileWatch>& fileWatch, const VirtualDirectory& directory)
+			{
+				const auto& physicalPath = directory.GetPhysicalPath();
+				if (!physicalPath)
+					return;
+
+				fileWatch.emplace(*physicalPath);
+				if (!fileWatch->watcher.IsValid())
+				{
+					bwLog(GetLogger(), LogLevel::Warning, "failed to watch {0}, changes won't be reloaded automatically", physicalPath->generic_u8string());
+					fileWatch.reset();
+				}
+			};
+
+			WatchDirectory(m_assetWatch, *m_assetDirectory);
+			WatchDirectory(m_scriptWatch, *m_scriptDirectory);
+		}
+
 		BuildMatchData();
 
-		if (WebService::IsInitialized())
+		if (GetApp().LoadWebService())
 		{
 			if (m_settings.registerToMasterServer && m_settings.port != 0)
 			{
-				const std::string& masterServerList = m_app.GetConfig().GetStringValue("ServerSettings.MasterServers");
+				const std::string& masterServerList = GetApp().GetConfig().GetStringValue("ServerSettings.MasterServers");
 				SplitStringAny(masterServerList, "\f\n\r\t\v ", [&](const std::string_view& masterServerURI)
 				{
 					if (!masterServerURI.empty())
@@ -74,19 +182,48 @@ namespace bw
 		m_gamemode->ExecuteCallback<GamemodeEvent::Init>();
 		m_gamemode->ExecuteCallback<GamemodeEvent::MapInit>();
 
+		if (checkpoint)
+			RestoreCheckpoint(checkpoint.value());
+
+		if (!m_settings.checkpointPath.empty())
+		{
+			m_checkpointWriter = std::make_shared<CheckpointWriter>();
+			m_lastCheckpointTime = GetApp().GetAppTime();
+		}
+
 		bwLog(GetLogger(), LogLevel::Info, "match initialized");
 
+		if (!m_settings.replayRecordPath.empty())
+		{
+			m_recorder = std::make_unique<MatchRecorder>(m_settings.replayRecordPath, GetTickDuration(), m_randomSeed);
+			bwLog(GetLogger(), LogLevel::Info, "recording match to {0} (random seed: {1})", m_settings.replayRecordPath, m_randomSeed);
+		}
+
+		// Sessions get the whole store when they authenticate
+		m_sentNetworkStringCount = m_networkStringStore.GetStringCount();
+
 		if (m_settings.port != 0)
-			m_sessions.CreateSessionManager<NetworkSessionManager>(m_settings.port, m_settings.maxPlayerCount);
+			m_sessions.CreateSessionManager<NetworkSessionManager>(m_settings.port, m_settings.maxPlayerCount, m_settings.networkThreadCount);
 	}
 
 	Match::~Match()
 	{
+		// Last checkpoint, taken before sessions are cleared as players leaving would remove their entity
+		if (m_checkpointWriter)
+		{
+			while (m_checkpointWriter->isWriting)
+				std::this_thread::yield();
+
+			WriteCheckpoint(false);
+		}
+
 		// Clear timer manager before scripting context gets deleted
 		GetScriptPacketHandlerRegistry().Clear();
 		GetTimerManager().Clear();
 
 		m_sessions.Clear();
+
+		m_checksumCache.Save();
 	}
 
 	void Match::BroadcastChatMessage(Player* player, std::string message)
@@ -107,7 +244,7 @@ namespace bw
 
 	void Match::BuildClientAssetListPacket(Packets::MatchData& clientAsset) const
 	{
-		const std::string& fastDownloadUrls = m_app.GetConfig().GetStringValue("ServerSettings.FastDownloadURLs");
+		const std::string& fastDownloadUrls = GetApp().GetConfig().GetStringValue("ServerSettings.FastDownloadURLs");
 
 		// Make sure url are only present once
 		tsl::hopscotch_set<std::string> urls;
@@ -142,7 +279,7 @@ namespace bw
 		{
 			auto& scriptData = clientScript.scripts.emplace_back();
 			scriptData.path = pair.first;
-			scriptData.size = pair.second.content.size();
+			scriptData.size = pair.second.content->size();
 
 			const Nz::ByteArray& checksum = pair.second.checksum;
 			assert(scriptData.sha1Checksum.size() == checksum.size());
@@ -152,6 +289,18 @@ namespace bw
 		std::sort(clientScript.scripts.begin(), clientScript.scripts.end(), [](const auto& first, const auto& second) { return first.path < second.path; });
 	}
 
+	Packets::TickRateUpdate Match::BuildTickRateUpdate() const
+	{
+		if (m_pendingTickRateUpdate)
+			return m_pendingTickRateUpdate.value();
+
+		Packets::TickRateUpdate tickRateUpdate;
+		tickRateUpdate.applyTick = GetNetworkTick();
+		tickRateUpdate.tickDuration = GetTickDuration();
+
+		return tickRateUpdate;
+	}
+
 	Player* Match::CreatePlayer(MatchClientSession& session, Nz::UInt8 localIndex, std::string name)
 	{
 		if (m_players.size() >= m_maxPlayerCount)
@@ -167,7 +316,19 @@ namespace bw
 		else
 			m_freePlayerId.Set(playerIndex, false);
 
-		auto playerPtr = std::make_unique<Player>(*this, session, playerIndex, localIndex, std::move(name));
+		// Reconnect tokens only have to be hard to guess, they don't protect anything but the player slot (clients only try to reconnect when they got one)
+		std::string reconnectToken;
+		if (!m_settings.checkpointPath.empty())
+		{
+			std::random_device randomDevice;
+			std::array<Nz::UInt32, 4> tokenData;
+			for (Nz::UInt32& value : tokenData)
+				value = randomDevice();
+
+			reconnectToken = Nz::ByteArray(tokenData.data(), sizeof(tokenData)).ToHex().ToStdString();
+		}
+
+		auto playerPtr = std::make_unique<Player>(*this, session, playerIndex, localIndex, std::move(name), std::move(reconnectToken));
 		Player* player = playerPtr.get();
 
 		m_players[playerIndex] = std::move(playerPtr);
@@ -177,6 +338,53 @@ namespace bw
 		return player;
 	}
 
+	auto Match::EstimateMemoryUsage() -> MemoryUsage
+	{
+		MemoryUsage memoryUsage;
+		memoryUsage.scripts = GetScriptProfiler().GetMemoryUsage();
+
+		memoryUsage.clientAssets = bw::EstimateMemoryUsage(m_clientAssets) + bw::EstimateMemoryUsage(m_clientScripts);
+		for (auto&& [assetPath, asset] : m_clientAssets)
+		{
+			if (asset.mappedFile)
+				memoryUsage.clientAssets += static_cast<std::size_t>(asset.size);
+		}
+
+		for (auto&& [scriptPath, script] : m_clientScripts)
+		{
+			if (script.content)
+				memoryUsage.clientAssets += script.content->size();
+		}
+
+		LayerIndex layerCount = GetLayerCount();
+		for (LayerIndex i = 0; i < layerCount; ++i)
+		{
+			for (const Ndk::EntityHandle& entity : GetLayer(i).GetWorld().GetEntities())
+			{
+				memoryUsage.entities++;
+				memoryUsage.entityComponents += entity->GetComponentBits().Count();
+			}
+		}
+
+		m_sessions.ForEachSession([&](MatchClientSession* session)
+		{
+			memoryUsage.sessions += session->EstimateMemoryUsage();
+			memoryUsage.visibility += session->GetVisibility().EstimateMemoryUsage();
+		});
+
+		return memoryUsage;
+	}
+
+	void Match::FlushNetworkStrings()
+	{
+		if (m_networkStringStore.GetStringCount() <= m_sentNetworkStringCount)
+			return;
+
+		// Strings registered since last flush (by scripts or element reloads) are sent at once instead of one reliable packet each
+		BroadcastPacket(m_networkStringStore.BuildPacket(m_sentNetworkStringCount), false);
+		m_sentNetworkStringCount = m_networkStringStore.GetStringCount();
+	}
+
 	void Match::ForEachEntity(std::function<void(const Ndk::EntityHandle& entity)> func)
 	{
 		for (LayerIndex i = 0; i < m_terrain->GetLayerCount(); ++i)
@@ -187,6 +395,20 @@ namespace bw
 		}
 	}
 
+	std::string Match::FormatMemoryUsage()
+	{
+		MemoryUsage memoryUsage = EstimateMemoryUsage();
+
+		std::string output = "Memory usage (estimated):\n";
+		output += fmt::format("  scripts (Lua heap): {0:.1f} KiB\n", memoryUsage.scripts / 1024.0);
+		output += fmt::format("  visibility: {0:.1f} KiB\n", memoryUsage.visibility / 1024.0);
+		output += fmt::format("  session buffers: {0:.1f} KiB\n", memoryUsage.sessions / 1024.0);
+		output += fmt::format("  client assets and scripts: {0:.1f} KiB\n", memoryUsage.clientAssets / 1024.0);
+		output += fmt::format("  worlds: {0} entities, {1} components", memoryUsage.entities, memoryUsage.entityComponents);
+
+		return output;
+	}
+
 	bool Match::GetClientAsset(const std::string& filePath, const ClientAsset** clientAssetData)
 	{
 		auto it = m_clientAssets.find(filePath);
@@ -234,6 +456,12 @@ namespace bw
 		return m_terrain->GetLayerCount();
 	}
 
+	auto Match::GetMetrics() const -> Metrics
+	{
+		std::lock_guard<std::mutex> lock(m_metricsMutex);
+		return m_metrics;
+	}
+
 	const NetworkStringStore& Match::GetNetworkStringStore() const
 	{
 		return m_networkStringStore;
@@ -282,7 +510,7 @@ namespace bw
 		std::filesystem::path filepath = std::get<VirtualDirectory::PhysicalFileEntry>(entry);
 
 		Nz::UInt64 assetSize = std::filesystem::file_size(filepath);
-		Nz::ByteArray assetHash = Nz::File::ComputeHash(Nz::HashType_SHA1, filepath.generic_u8string());
+		Nz::ByteArray assetHash = m_checksumCache.ComputeChecksum(filepath);
 
 		RegisterClientAssetInternal(std::move(assetPath), assetSize, std::move(assetHash), std::move(filepath));
 	}
@@ -297,7 +525,12 @@ namespace bw
 			throw std::runtime_error(scriptPath + " is not a file");
 
 		std::vector<Nz::UInt8> content;
-		if (std::holds_alternative<VirtualDirectory::FileContentEntry>(entry))
+		if (std::holds_alternative<VirtualDirectory::DataPointerEntry>(entry))
+		{
+			const auto& dataPointer = std::get<VirtualDirectory::DataPointerEntry>(entry);
+			content.assign(dataPointer.data, dataPointer.data + dataPointer.size);
+		}
+		else if (std::holds_alternative<VirtualDirectory::FileContentEntry>(entry))
 			content = std::get<VirtualDirectory::FileContentEntry>(entry);
 		else if (std::holds_alternative<VirtualDirectory::PhysicalFileEntry>(entry))
 		{
@@ -320,16 +553,14 @@ namespace bw
 
 		ClientScript clientScriptData;
 		clientScriptData.checksum = hash->End();
-		clientScriptData.content = std::move(content);
+		clientScriptData.content = std::make_shared<const std::vector<Nz::UInt8>>(std::move(content));
 
 		m_clientScripts.emplace(std::move(scriptPath), std::move(clientScriptData));
 	}
 
 	void Match::RegisterEntity(EntityId uniqueId, Ndk::EntityHandle entity)
 	{
-		assert(m_entitiesByUniqueId.find(uniqueId) == m_entitiesByUniqueId.end());
-
-		Entity& entityData = m_entitiesByUniqueId.emplace(uniqueId, Entity{}).first.value();
+		Entity& entityData = m_entitiesByUniqueId.Emplace(uniqueId);
 		entityData.entity = std::move(entity);
 		entityData.onDestruction.Connect(entityData.entity->OnEntityDestruction, [this, uniqueId](Ndk::Entity* entity)
 		{
@@ -340,26 +571,29 @@ namespace bw
 				entityScript.ExecuteCallback<ElementEvent::Destroyed>();
 			}
 
-			m_entitiesByUniqueId.erase(uniqueId);
+			m_entitiesByUniqueId.Erase(uniqueId);
 		});
 	}
 
 	void Match::RegisterNetworkString(std::string string)
 	{
+		// Sent to players with other new strings by FlushNetworkStrings
 		if (m_networkStringStore.GetStringIndex(string) == m_networkStringStore.InvalidIndex)
-		{
-			Nz::UInt32 newStringId = m_networkStringStore.RegisterString(std::move(string));
+			m_networkStringStore.RegisterString(std::move(string));
+	}
 
-			// Send the new string to all players, if any
-			BroadcastPacket(m_networkStringStore.BuildPacket(newStringId), false);
-		}
+	void Match::RegisterRelaySession(MatchClientSession* session)
+	{
+		assert(std::find(m_relaySessions.begin(), m_relaySessions.end(), session) == m_relaySessions.end());
+		m_relaySessions.push_back(session);
 	}
 
 	void Match::ReloadAssets()
 	{
-		const std::string& assetDirectory = m_app.GetConfig().GetStringValue("Resources.AssetDirectory");
+		const std::string& assetDirectory = GetApp().GetConfig().GetStringValue("Resources.AssetDirectory");
 
 		m_assetDirectory = std::make_shared<VirtualDirectory>(assetDirectory);
+		m_assetDirectory->EnablePathIndex();
 		for (const auto& modPtr : m_enabledMods)
 		{
 			for (const auto& [assetPath, physicalPath] : modPtr->GetAssets())
@@ -375,8 +609,14 @@ namespace bw
 		}
 
 		assert(m_map.IsValid());
-		for (const auto& asset : m_map.GetAssets())
+		const auto& mapAssets = m_map.GetAssets();
+
+		std::vector<std::size_t> assetIndices;
+		std::vector<std::filesystem::path> assetPaths;
+		for (std::size_t i = 0; i < mapAssets.size(); ++i)
 		{
+			const auto& asset = mapAssets[i];
+
 			std::filesystem::path assetPath = assetDirectory;
 			assetPath /= asset.filepath;
 
@@ -393,23 +633,34 @@ namespace bw
 				continue;
 			}
 
+			assetIndices.push_back(i);
+			assetPaths.push_back(std::move(assetPath));
+		}
+
+		// Checksums are cached on disk and missing ones are computed in parallel
+		std::vector<Nz::ByteArray> fileChecksums = m_checksumCache.ComputeChecksums(assetPaths);
+		for (std::size_t i = 0; i < assetIndices.size(); ++i)
+		{
+			const auto& asset = mapAssets[assetIndices[i]];
+
 			Nz::ByteArray expectedChecksum(asset.sha1Checksum.size(), 0);
 			std::memcpy(expectedChecksum.GetBuffer(), asset.sha1Checksum.data(), asset.sha1Checksum.size());
 
-			Nz::ByteArray fileChecksum = Nz::File::ComputeHash(Nz::HashType_SHA1, assetPath.generic_u8string());
-			if (fileChecksum != expectedChecksum)
+			if (fileChecksums[i] != expectedChecksum)
 			{
-				bwLog(GetLogger(), LogLevel::Error, "Map asset doesn't match file ({0}): checksum doesn't match", asset.filepath, asset.size, fileSize);
+				bwLog(GetLogger(), LogLevel::Error, "Map asset doesn't match file ({0}): checksum doesn't match", asset.filepath);
 				continue;
 			}
 
-			RegisterClientAssetInternal(asset.filepath, fileSize, fileChecksum, std::move(assetPath));
+			RegisterClientAssetInternal(asset.filepath, asset.size, std::move(fileChecksums[i]), std::move(assetPaths[i]));
 		}
+
+		m_checksumCache.Save();
 	}
 
 	void Match::ReloadMods()
 	{
-		const auto& loadedMods = m_app.GetMods();
+		const auto& loadedMods = GetApp().GetMods();
 		for (auto&& [modId, modSettings] : m_modSettings.enabledMods)
 		{
 			auto it = loadedMods.find(modId);
@@ -423,23 +674,109 @@ namespace bw
 		}
 	}
 
-	void Match::ReloadScripts()
+	void Match::ReloadChangedScripts()
 	{
-		assert(m_assetStore);
+		assert(m_scriptingContext);
 
-		m_clientScripts.clear();
+		tsl::hopscotch_map<std::string, Nz::ByteArray> previousChecksums = std::move(m_scriptChecksums);
+		BuildScriptDirectory();
 
-		const std::string& scriptFolder = m_app.GetConfig().GetStringValue("Resources.ScriptDirectory");
+		std::vector<std::string> changedFiles;
+		for (auto&& [filePath, checksum] : m_scriptChecksums)
+		{
+			if (auto it = previousChecksums.find(filePath); it == previousChecksums.end() || it->second != checksum)
+				changedFiles.push_back(filePath);
+		}
 
-		m_scriptDirectory = std::make_shared<VirtualDirectory>(scriptFolder);
-		for (const auto& modPtr : m_enabledMods)
+		for (auto&& [filePath, checksum] : previousChecksums)
 		{
-			for (const auto& [scriptPath, physicalPath] : modPtr->GetScripts())
-				m_scriptDirectory->StoreFile(scriptPath, physicalPath);
+			if (m_scriptChecksums.find(filePath) == m_scriptChecksums.end())
+				changedFiles.push_back(filePath);
 		}
 
-		for (const auto& mapScript : m_map.GetScripts())
-			m_scriptDirectory->StoreFile(mapScript.filepath, mapScript.content);
+		if (changedFiles.empty())
+		{
+			bwLog(GetLogger(), LogLevel::Info, "no script changed");
+			return;
+		}
+
+		// Only entities and weapons can be reloaded on their own, anything else (gamemode, autorun, shared files) may touch every script
+		auto GetElementEntry = [](const std::string& filePath, std::string_view directory) -> std::optional<std::string>
+		{
+			if (filePath.size() <= directory.size() || filePath.compare(0, directory.size(), directory) != 0 || filePath[directory.size()] != '/')
+				return std::nullopt;
+
+			std::string entryName = filePath.substr(directory.size() + 1);
+			if (std::size_t separatorPos = entryName.find('/'); separatorPos != std::string::npos)
+				entryName.resize(separatorPos);
+
+			return entryName;
+		};
+
+		std::vector<std::string> changedEntities;
+		std::vector<std::string> changedWeapons;
+		for (const std::string& filePath : changedFiles)
+		{
+			if (auto entryName = GetElementEntry(filePath, "entities"))
+			{
+				if (std::find(changedEntities.begin(), changedEntities.end(), *entryName) == changedEntities.end())
+					changedEntities.push_back(std::move(*entryName));
+			}
+			else if (auto entryName = GetElementEntry(filePath, "weapons"))
+			{
+				if (std::find(changedWeapons.begin(), changedWeapons.end(), *entryName) == changedWeapons.end())
+					changedWeapons.push_back(std::move(*entryName));
+			}
+			else
+			{
+				bwLog(GetLogger(), LogLevel::Info, "{0} changed, reloading all scripts", filePath);
+				ReloadScripts();
+				return;
+			}
+		}
+
+		bwLog(GetLogger(), LogLevel::Info, "reloading {0} changed file(s) ({1} entities, {2} weapons)", changedFiles.size(), changedEntities.size(), changedWeapons.size());
+
+		// Changed client scripts are registered again by their element (or below if they aren't anymore), with their new content
+		std::vector<std::string> changedClientScripts;
+		for (const std::string& filePath : changedFiles)
+		{
+			if (auto it = m_clientScripts.find(filePath); it != m_clientScripts.end())
+			{
+				m_clientScripts.erase(it);
+				changedClientScripts.push_back(filePath);
+			}
+		}
+
+		m_scriptingContext->UpdateScriptDirectory(m_scriptDirectory);
+
+		m_entityStore->ReloadElements("entities", changedEntities);
+		m_weaponStore->ReloadElements("weapons", changedWeapons);
+
+		for (std::string& filePath : changedClientScripts)
+		{
+			if (m_clientScripts.find(filePath) != m_clientScripts.end() || m_scriptChecksums.find(filePath) == m_scriptChecksums.end())
+				continue;
+
+			RegisterClientScript(std::move(filePath));
+		}
+
+		if (m_terrain)
+			UpdateEntityElements();
+
+		RegisterElementNetworkStrings();
+	}
+
+	void Match::ReloadScripts()
+	{
+		assert(m_assetStore);
+
+		m_clientScripts.clear();
+
+		BuildScriptDirectory();
+
+		// Reading and compiling scripts doesn't need the Lua state, do it in parallel before running them
+		std::vector<std::string> preloadedFolders = { "autorun", "entities", "gamemodes", "weapons" };
 
 		if (!m_scriptingContext)
 		{
@@ -447,11 +784,20 @@ namespace bw
 				m_scriptingLibrary = std::make_shared<ServerScriptingLibrary>(*this, *m_assetStore);
 
 			m_scriptingContext = std::make_shared<ScriptingContext>(GetLogger(), m_scriptDirectory);
+			m_scriptingContext->SetBytecodeCache(m_bytecodeCache);
+			m_scriptingContext->Preload(GetApp().GetJobSystem(), preloadedFolders);
 			m_scriptingContext->LoadLibrary(m_scriptingLibrary);
+
+			ScriptProfiler& scriptProfiler = m_scriptingContext->GetProfiler();
+			scriptProfiler.Enable(m_settings.tickProfiling);
+			scriptProfiler.SetCallbackBudget(static_cast<Nz::UInt64>(m_settings.scriptCallbackBudget * 1000.f));
+
+			m_scriptingContext->SetGarbageCollectorMode(m_settings.scriptGarbageCollectorMode);
 		}
 		else
 		{
 			m_scriptingContext->UpdateScriptDirectory(m_scriptDirectory);
+			m_scriptingContext->Preload(GetApp().GetJobSystem(), preloadedFolders);
 			m_scriptingContext->ReloadLibraries();
 		}
 
@@ -498,6 +844,9 @@ namespace bw
 		else
 			m_gamemode->Reload();
 
+		// Scripts of other gamemodes
+		m_scriptingContext->ClearPreloadedScripts();
+
 		for (auto&& [propertyName, propertyData] : m_gamemode->GetProperties())
 		{
 			if (propertyData.shared)
@@ -505,42 +854,9 @@ namespace bw
 		}
 
 		if (m_terrain)
-		{
-			ForEachEntity([this](const Ndk::EntityHandle& entity)
-			{
-				if (entity->HasComponent<ScriptComponent>())
-				{
-					// Warning: ugly (FIXME)
-					m_entityStore->UpdateEntityElement(entity);
-					m_weaponStore->UpdateEntityElement(entity);
-				}
-			});
-		}
-
-		m_entityStore->ForEachElement([&](const ScriptedEntity& entity)
-		{
-			if (entity.isNetworked)
-			{
-				m_networkStringStore.RegisterString(entity.fullName);
-
-				for (auto&& [propertyName, propertyData] : entity.properties)
-				{
-					if (propertyData.shared)
-						m_networkStringStore.RegisterString(propertyName);
-				}
-			}
-		});
-
-		m_weaponStore->ForEachElement([&](const ScriptedWeapon& weapon)
-		{
-			m_networkStringStore.RegisterString(weapon.fullName);
+			UpdateEntityElements();
 
-			for (auto&& [propertyName, propertyData] : weapon.properties)
-			{
-				if (propertyData.shared)
-					m_networkStringStore.RegisterString(propertyName);
-			}
-		});
+		RegisterElementNetworkStrings();
 	}
 
 	void Match::RemovePlayer(Player* player, DisconnectionReason disconnectionReason)
@@ -582,8 +898,18 @@ namespace bw
 			BroadcastPacket(leavingPacket);
 		}
 
+		// A player leaving before being ready again never took back their entity
+		std::size_t playerIndex = std::distance(m_players.begin(), it);
+		if (auto resumedIt = m_resumedPlayers.find(playerIndex); resumedIt != m_resumedPlayers.end())
+		{
+			if (const Ndk::EntityHandle& entity = RetrieveEntityByUniqueId(resumedIt->second.controlledEntityId))
+				entity->Kill();
+
+			m_resumedPlayers.erase(resumedIt);
+		}
+
 		it->reset();
-		m_freePlayerId.Set(std::distance(m_players.begin(), it), true);
+		m_freePlayerId.Set(playerIndex, true);
 
 		ForEachPlayer([&](Player* player)
 		{
@@ -623,13 +949,42 @@ namespace bw
 		m_gamemode->ExecuteCallback<GamemodeEvent::MapInit>();
 	}
 
+	Player* Match::ResumePlayer(MatchClientSession& session, Nz::UInt8 localIndex, const std::string& reconnectToken)
+	{
+		auto it = m_resumablePlayers.find(reconnectToken);
+		if (it == m_resumablePlayers.end())
+			return nullptr;
+
+		MatchCheckpoint::Player playerData = std::move(it.value().playerData);
+		m_resumablePlayers.erase(it);
+
+		// Slot was reserved when restoring the checkpoint
+		std::size_t playerIndex = playerData.playerIndex;
+		assert(playerIndex < m_players.size() && !m_players[playerIndex]);
+
+		auto playerPtr = std::make_unique<Player>(*this, session, playerIndex, localIndex, playerData.name, playerData.reconnectToken);
+		Player* player = playerPtr.get();
+		player->SetAdmin(playerData.isAdmin);
+
+		m_players[playerIndex] = std::move(playerPtr);
+
+		bwLog(GetLogger(), LogLevel::Info, "{0} reconnected as player #{1}", player->GetName(), playerIndex);
+
+		// Controlled entity is given back once the session is ready (see OnPlayerReady)
+		m_resumedPlayers.emplace(playerIndex, std::move(playerData));
+
+		m_gamemode->ExecuteCallback<GamemodeEvent::PlayerConnected>(player->CreateHandle());
+
+		return player;
+	}
+
 	const Ndk::EntityHandle& Match::RetrieveEntityByUniqueId(EntityId uniqueId) const
 	{
-		auto it = m_entitiesByUniqueId.find(uniqueId);
-		if (it == m_entitiesByUniqueId.end())
+		const Entity* entityData = m_entitiesByUniqueId.Find(uniqueId);
+		if (!entityData)
 			return Ndk::EntityHandle::InvalidHandle;
 
-		return it.value().entity;
+		return entityData->entity;
 	}
 
 	EntityId Match::RetrieveUniqueIdByEntity(const Ndk::EntityHandle& entity) const
@@ -640,12 +995,55 @@ namespace bw
 		return entity->GetComponent<MatchComponent>().GetUniqueId();
 	}
 
+	void Match::UnregisterEntity(EntityId uniqueId)
+	{
+		// Entity stays alive (pooled entities), its destruction will no longer be reported
+		bool erased = m_entitiesByUniqueId.Erase(uniqueId);
+		NazaraUnused(erased);
+		assert(erased);
+	}
+
+	void Match::UnregisterRelaySession(MatchClientSession* session)
+	{
+		auto it = std::find(m_relaySessions.begin(), m_relaySessions.end(), session);
+		assert(it != m_relaySessions.end());
+		m_relaySessions.erase(it);
+	}
+
 	bool Match::Update(float elapsedTime)
 	{
+		// Recorded before polling sessions, so their events are replayed in the same update
+		if (m_recorder)
+			m_recorder->RecordUpdate(elapsedTime);
+
 		m_sessions.Poll();
 
-		for (const auto& masterServerEntryPtr : m_masterServerEntries)
-			masterServerEntryPtr->Update(elapsedTime);
+		// Master server refreshes are not critical, postpone them while the server is catching up
+		m_deferredMasterServerTime += elapsedTime;
+		if (GetLoadLevel() < LoadLevel::DeferNonCritical)
+		{
+			for (const auto& masterServerEntryPtr : m_masterServerEntries)
+				masterServerEntryPtr->Update(m_deferredMasterServerTime);
+
+			m_deferredMasterServerTime = 0.f;
+		}
+
+		// Metrics are read from other threads (see ServerApp metrics endpoint), snapshot them instead of locking the whole match
+		if (m_settings.metricsInterval > 0 && GetApp().GetAppTime() - m_lastMetricsUpdate >= m_settings.metricsInterval)
+		{
+			Metrics metrics = CollectMetrics();
+
+			std::lock_guard<std::mutex> lock(m_metricsMutex);
+			m_metrics = std::move(metrics);
+			m_lastMetricsUpdate = GetApp().GetAppTime();
+		}
+
+		// Slots of players who didn't reconnect yet keep the match awake
+		if (!m_resumablePlayers.empty())
+			ExpireResumablePlayers();
+
+		if (m_assetWatch || m_scriptWatch)
+			UpdateFileWatches();
 
 		if (m_settings.sleepWhenEmpty && m_freePlayerId.TestAll())
 			return m_isMatchRunning;
@@ -654,17 +1052,70 @@ namespace bw
 
 		SharedMatch::Update(elapsedTime);
 
-		Nz::UInt64 appTime = m_app.GetAppTime();
-		if (appTime - m_lastPingUpdate > 1000)
+		Nz::UInt64 appTime = GetApp().GetAppTime();
+
+		if (m_checkpointWriter)
+		{
+			if (m_settings.checkpointInterval > 0.f && appTime - m_lastCheckpointTime >= static_cast<Nz::UInt64>(m_settings.checkpointInterval * 1000.f))
+			{
+				WriteCheckpoint(true);
+				m_lastCheckpointTime = appTime;
+			}
+
+			std::string checkpointError;
+			{
+				std::lock_guard<std::mutex> lock(m_checkpointWriter->errorMutex);
+				checkpointError = std::move(m_checkpointWriter->lastError);
+				m_checkpointWriter->lastError.clear();
+			}
+
+			if (!checkpointError.empty())
+				bwLog(GetLogger(), LogLevel::Error, "failed to write checkpoint: {0}", checkpointError);
+		}
+
+		if (m_settings.adaptiveTickRate && appTime - m_lastTickRateEvaluation >= static_cast<Nz::UInt64>(m_settings.adaptiveTickRate->evaluationInterval * 1000.f))
+		{
+			UpdateTickRate();
+			m_lastTickRateEvaluation = appTime;
+		}
+
+		Nz::UInt64 pingUpdateInterval = (GetLoadLevel() >= LoadLevel::DeferNonCritical) ? 5000 : 1000;
+		if (appTime - m_lastPingUpdate > pingUpdateInterval)
 		{
 			SendPingUpdate();
 			m_lastPingUpdate = appTime;
 		}
 
+		if (m_settings.networkStatisticsInterval > 0 && appTime - m_lastNetworkStatisticsLog > m_settings.networkStatisticsInterval * 1000)
+		{
+			m_sessions.LogNetworkStatistics();
+			m_lastNetworkStatisticsLog = appTime;
+		}
+
+		if (m_settings.tickProfileInterval > 0 && appTime - m_lastTickProfileLog > m_settings.tickProfileInterval * 1000)
+		{
+			const TickProfiler& tickProfiler = GetTickProfiler();
+			if (tickProfiler.IsEnabled())
+				bwLog(GetLogger(), LogLevel::Info, "Tick profile: slowest sections: {0}", tickProfiler.FormatSummary(4));
+
+			const ScriptProfiler& scriptProfiler = GetScriptProfiler();
+			if (scriptProfiler.IsEnabled())
+				bwLog(GetLogger(), LogLevel::Info, "Script profile: heaviest callbacks: {0}", scriptProfiler.FormatSummary(4));
+
+			const ScriptingContext::GarbageCollectorStats& gcStats = m_scriptingContext->GetGarbageCollectorStats();
+			if (gcStats.stepCount > 0)
+				bwLog(GetLogger(), LogLevel::Info, "Script GC: {0} cycle(s) completed, {1:.3f} ms average step, {2:.3f} ms longest step, Lua memory: {3:.1f} KiB", gcStats.cycleCount, gcStats.totalStepDuration / 1000.0 / gcStats.stepCount, gcStats.maxStepDuration / 1000.0, scriptProfiler.GetMemoryUsage() / 1024.0);
+
+			if (IsLoadSheddingEnabled())
+				bwLog(GetLogger(), LogLevel::Info, "{0}", FormatLoadStatistics());
+
+			m_lastTickProfileLog = appTime;
+		}
+
 
 		if (m_debug && appTime - m_debug->lastBroadcastTime > 1000 / 60)
 		{
-			m_debug->lastBroadcastTime = m_app.GetAppTime();
+			m_debug->lastBroadcastTime = GetApp().GetAppTime();
 
 			// Send all entities state
 			Nz::NetPacket debugPacket(1);
@@ -733,22 +1184,128 @@ namespace bw
 		return m_isMatchRunning;
 	}
 
-	void Match::BuildMatchData()
+	void Match::BuildScriptDirectory()
 	{
-		// Send match data
-		const Map& mapData = m_terrain->GetMap();
-
-		m_matchData.gamemode = m_gamemodeSettings.name;
-		m_matchData.tickDuration = GetTickDuration();
+		const std::string& scriptFolder = GetApp().GetConfig().GetStringValue("Resources.ScriptDirectory");
 
-		m_matchData.layers.clear();
-		m_matchData.layers.reserve(mapData.GetLayerCount());
-		for (std::size_t i = 0; i < mapData.GetLayerCount(); ++i)
+		m_scriptDirectory = std::make_shared<VirtualDirectory>(scriptFolder);
+		m_scriptDirectory->EnablePathIndex();
+		for (const auto& modPtr : m_enabledMods)
 		{
-			const auto& mapLayer = mapData.GetLayer(LayerIndex(i));
+			if (const auto& scriptPack = modPtr->GetScriptPack())
+				m_scriptDirectory->MountPackFile({}, scriptPack);
 
-			auto& packetLayer = m_matchData.layers.emplace_back();
-			packetLayer.backgroundColor = mapLayer.backgroundColor;
+			for (const auto& [scriptPath, physicalPath] : modPtr->GetScripts())
+				m_scriptDirectory->StoreFile(scriptPath, physicalPath);
+		}
+
+		if (!m_bytecodeCache)
+			m_bytecodeCache = GetApp().GetBytecodeCache();
+
+		for (const auto& mapScript : m_map.GetScripts())
+		{
+			std::string_view source = mapScript.GetContent();
+
+			// Scripts of memory-mapped maps are served straight from the mapping
+			if (mapScript.mappedContent.data())
+				m_scriptDirectory->StoreFile(mapScript.filepath, VirtualDirectory::DataPointerEntry{ m_map.GetMapping(), reinterpret_cast<const Nz::UInt8*>(source.data()), source.size() });
+			else
+				m_scriptDirectory->StoreFile(mapScript.filepath, mapScript.content);
+
+			// Maps may ship precompiled scripts
+			if (!mapScript.bytecode.empty())
+				m_bytecodeCache->Register(ScriptBytecodeCache::ComputeKey(mapScript.filepath, source), mapScript.bytecode);
+		}
+
+		// Remember every script checksum, for ReloadChangedScripts to know what to reload (physical files go through the checksum cache)
+		m_scriptChecksums.clear();
+		m_scriptDirectory->ForeachFile([&](const std::string& filePath, const VirtualDirectory::Entry& entry)
+		{
+			if (std::holds_alternative<VirtualDirectory::PhysicalFileEntry>(entry))
+				m_scriptChecksums.emplace(filePath, m_checksumCache.ComputeChecksum(std::get<VirtualDirectory::PhysicalFileEntry>(entry)));
+			else if (std::holds_alternative<VirtualDirectory::DataPointerEntry>(entry))
+			{
+				const auto& dataPointer = std::get<VirtualDirectory::DataPointerEntry>(entry);
+
+				auto hash = Nz::AbstractHash::Get(Nz::HashType_SHA1);
+				hash->Begin();
+				hash->Append(dataPointer.data, dataPointer.size);
+
+				m_scriptChecksums.emplace(filePath, hash->End());
+			}
+			else if (std::holds_alternative<VirtualDirectory::FileContentEntry>(entry))
+			{
+				const auto& content = std::get<VirtualDirectory::FileContentEntry>(entry);
+
+				auto hash = Nz::AbstractHash::Get(Nz::HashType_SHA1);
+				hash->Begin();
+				hash->Append(content.data(), content.size());
+
+				m_scriptChecksums.emplace(filePath, hash->End());
+			}
+		});
+
+		m_checksumCache.Save();
+	}
+
+	void Match::BuildMatchData()
+	{
+		// Send match data
+		const Map& mapData = m_terrain->GetMap();
+
+		m_matchData.gamemode = m_gamemodeSettings.name;
+		m_matchData.minTickDuration = GetMinTickDuration();
+		m_matchData.tickDuration = GetTickDuration();
+
+		if (m_settings.stateQuantization)
+		{
+			const auto& quantizationSettings = m_settings.stateQuantization.value();
+
+			Nz::Vector2f positionMin(std::numeric_limits<float>::infinity());
+			Nz::Vector2f positionMax(-std::numeric_limits<float>::infinity());
+			for (std::size_t i = 0; i < mapData.GetLayerCount(); ++i)
+			{
+				for (const auto& mapEntity : mapData.GetLayer(LayerIndex(i)).entities)
+				{
+					positionMin.Minimize(mapEntity.position);
+					positionMax.Maximize(mapEntity.position);
+				}
+			}
+
+			if (positionMin.x > positionMax.x)
+			{
+				// Empty map
+				positionMin = Nz::Vector2f::Zero();
+				positionMax = Nz::Vector2f::Zero();
+			}
+
+			Packets::Helper::StateQuantization& stateQuantization = m_matchData.stateQuantization.emplace();
+			stateQuantization.positionMin = positionMin - Nz::Vector2f(quantizationSettings.mapMargin);
+			stateQuantization.positionMax = positionMax + Nz::Vector2f(quantizationSettings.mapMargin);
+			stateQuantization.maxAngularVelocity = quantizationSettings.maxAngularVelocity;
+			stateQuantization.maxLinearVelocity = quantizationSettings.maxLinearVelocity;
+
+			m_stateQuantizer.emplace(stateQuantization);
+		}
+		else
+		{
+			m_matchData.stateQuantization.reset();
+			m_stateQuantizer.reset();
+		}
+
+		m_matchData.layers.clear();
+		m_matchData.layers.reserve(mapData.GetLayerCount());
+		for (std::size_t i = 0; i < mapData.GetLayerCount(); ++i)
+		{
+			const auto& mapLayer = mapData.GetLayer(LayerIndex(i));
+			const auto& physicsSettings = m_terrain->GetLayer(LayerIndex(i)).GetPhysicsSettings();
+
+			auto& packetLayer = m_matchData.layers.emplace_back();
+			packetLayer.backgroundColor = mapLayer.backgroundColor;
+			packetLayer.physicsIterationCount = physicsSettings.iterationCount;
+			packetLayer.physicsSleepTime = physicsSettings.sleepTime;
+			packetLayer.physicsSpatialHashCellSize = physicsSettings.spatialHashCellSize;
+			packetLayer.physicsSpatialHashEntityCount = physicsSettings.spatialHashEntityCount;
 		}
 
 		m_matchData.assets.clear();
@@ -775,6 +1332,138 @@ namespace bw
 		}
 	}
 
+	void Match::CaptureCheckpoint(MatchCheckpoint& checkpoint)
+	{
+		checkpoint.currentTick = GetCurrentTick();
+		checkpoint.gamemodeName = m_gamemodeSettings.name;
+		checkpoint.nextUniqueId = m_nextUniqueId;
+		checkpoint.randomSeed = m_randomSeed;
+
+		// Gamemode state is spread over its table and the ones of its bases
+		checkpoint.gamemodeState.clear();
+		sol::table gamemodeTable = m_gamemode->GetTable();
+		if (gamemodeTable.get_or("Checkpoint", false))
+		{
+			for (;;)
+			{
+				checkpoint.gamemodeState.push_back(ScriptMessageValue::FromLuaFields(*this, gamemodeTable));
+
+				sol::object baseGamemode = gamemodeTable.raw_get<sol::object>("Base");
+				if (baseGamemode.get_type() != sol::type::table)
+					break;
+
+				gamemodeTable = baseGamemode.as<sol::table>();
+			}
+		}
+
+		LayerIndex layerCount = GetLayerCount();
+		checkpoint.layers.resize(layerCount);
+		for (LayerIndex i = 0; i < layerCount; ++i)
+			m_terrain->GetLayer(i).CaptureCheckpoint(checkpoint.layers[i]);
+
+		checkpoint.players.clear();
+		ForEachPlayer([&](Player* player)
+		{
+			MatchCheckpoint::Player& playerData = checkpoint.players.emplace_back();
+			playerData.isAdmin = player->IsAdmin();
+			playerData.layerIndex = player->GetLayerIndex();
+			playerData.name = player->GetName();
+			playerData.playerIndex = static_cast<Nz::UInt16>(player->GetPlayerIndex());
+			playerData.reconnectToken = player->GetReconnectToken();
+
+			if (const Ndk::EntityHandle& controlledEntity = player->GetControlledEntity())
+				playerData.controlledEntityId = controlledEntity->GetComponent<MatchComponent>().GetUniqueId();
+			else if (auto it = m_resumedPlayers.find(player->GetPlayerIndex()); it != m_resumedPlayers.end())
+				playerData.controlledEntityId = it->second.controlledEntityId;
+			else
+				playerData.controlledEntityId = InvalidEntityId;
+		}, false);
+
+		// Players who didn't reconnect yet can still do it after the next resume
+		for (auto&& [reconnectToken, resumablePlayer] : m_resumablePlayers)
+			checkpoint.players.push_back(resumablePlayer.playerData);
+	}
+
+	auto Match::CollectMetrics() -> Metrics
+	{
+		Metrics metrics;
+		metrics.discardedTickCount = GetDiscardedTickCount();
+		metrics.memoryUsage = EstimateMemoryUsage();
+		metrics.name = m_settings.name;
+		metrics.scriptGarbageCollector = m_scriptingContext->GetGarbageCollectorStats();
+		metrics.scriptMemoryUsage = GetScriptProfiler().GetMemoryUsage();
+		metrics.tickCount = GetCurrentTick();
+		metrics.tickDurations = GetTickDurationHistogram();
+
+		LayerIndex layerCount = GetLayerCount();
+		metrics.layerEntityCounts.reserve(layerCount);
+		for (LayerIndex i = 0; i < layerCount; ++i)
+			metrics.layerEntityCounts.push_back(GetLayer(i).GetWorld().GetEntities().size());
+
+		ForEachPlayer([&](Player*) { metrics.playerCount++; }, false);
+
+		const PlayerCommandStore& commandStore = m_sessions.GetCommandStore();
+		auto AddPacketMetrics = [&](const CommandStatisticsList& statistics, bool outgoing)
+		{
+			for (std::size_t packetId = 0; packetId < statistics.size(); ++packetId)
+			{
+				const CommandStatistics& packetStatistics = statistics[packetId];
+				if (packetStatistics.packetCount == 0)
+					continue;
+
+				const char* packetName = (outgoing) ? commandStore.GetOutgoingCommandName(packetId) : commandStore.GetIncomingCommandName(packetId);
+
+				auto& packetMetrics = metrics.packets.emplace_back();
+				packetMetrics.byteCount = packetStatistics.byteCount;
+				packetMetrics.name = (packetName) ? packetName : "<unknown>";
+				packetMetrics.outgoing = outgoing;
+				packetMetrics.packetCount = packetStatistics.packetCount;
+			}
+		};
+
+		AddPacketMetrics(commandStore.GetIncomingStatistics(), false);
+		AddPacketMetrics(commandStore.GetOutgoingStatistics(), true);
+
+		m_sessions.ForEachSession([&](MatchClientSession* session)
+		{
+			metrics.pendingDownloadCount += session->GetPendingDownloadCount();
+
+			if (const auto& sessionInfo = session->GetSessionInfo())
+			{
+				auto& sessionMetrics = metrics.sessions.emplace_back();
+				sessionMetrics.inputTiming = session->GetInputTimingStatistics();
+				sessionMetrics.info = *sessionInfo;
+				sessionMetrics.sessionId = session->GetSessionId();
+			}
+		});
+
+		return metrics;
+	}
+
+	void Match::ExpireResumablePlayers()
+	{
+		Nz::UInt64 appTime = GetApp().GetAppTime();
+		for (auto it = m_resumablePlayers.begin(); it != m_resumablePlayers.end();)
+		{
+			const ResumablePlayer& resumablePlayer = it->second;
+			if (appTime < resumablePlayer.expirationTime)
+			{
+				++it;
+				continue;
+			}
+
+			const MatchCheckpoint::Player& playerData = resumablePlayer.playerData;
+			bwLog(GetLogger(), LogLevel::Info, "{0} didn't reconnect in time, releasing player #{1}", playerData.name, playerData.playerIndex);
+
+			if (const Ndk::EntityHandle& controlledEntity = RetrieveEntityByUniqueId(playerData.controlledEntityId))
+				controlledEntity->Kill();
+
+			m_freePlayerId.Set(playerData.playerIndex, true);
+
+			it = m_resumablePlayers.erase(it);
+		}
+	}
+
 	void Match::OnPlayerReady(Player* newPlayer)
 	{
 		if (newPlayer->IsReady())
@@ -788,8 +1477,14 @@ namespace bw
 
 		newPlayer->SetReady();
 
+		auto resumedIt = m_resumedPlayers.find(newPlayer->GetPlayerIndex());
+		bool isResumed = (resumedIt != m_resumedPlayers.end());
+
 		Packets::ChatMessage chatPacket;
-		chatPacket.content = newPlayer->GetName() + " has joined.";
+		chatPacket.content = newPlayer->GetName() + ((isResumed) ? " is back." : " has joined.");
+
+		// New player needs everyone's ping
+		m_pingUpdateCounter = 0;
 
 		ForEachPlayer([&](Player* player)
 		{
@@ -809,7 +1504,32 @@ namespace bw
 			player->SendPacket(chatPacket);
 		});
 
-		m_gamemode->ExecuteCallback<GamemodeEvent::PlayerJoined>(newPlayer->CreateHandle());
+		if (isResumed)
+		{
+			MatchCheckpoint::Player playerData = std::move(resumedIt->second);
+			m_resumedPlayers.erase(resumedIt);
+
+			if (const Ndk::EntityHandle& controlledEntity = RetrieveEntityByUniqueId(playerData.controlledEntityId))
+			{
+				newPlayer->UpdateControlledEntity(controlledEntity);
+
+				// Weapons were given back while the entity had no owner
+				if (controlledEntity->HasComponent<WeaponWielderComponent>())
+				{
+					for (const Ndk::EntityOwner& weapon : controlledEntity->GetComponent<WeaponWielderComponent>().GetWeapons())
+					{
+						if (!weapon->HasComponent<OwnerComponent>())
+							weapon->AddComponent<OwnerComponent>(newPlayer->CreateHandle());
+					}
+				}
+			}
+			else if (playerData.layerIndex < GetLayerCount())
+				newPlayer->MoveToLayer(playerData.layerIndex);
+
+			m_gamemode->ExecuteCallback<GamemodeEvent::PlayerResumed>(newPlayer->CreateHandle());
+		}
+		else
+			m_gamemode->ExecuteCallback<GamemodeEvent::PlayerJoined>(newPlayer->CreateHandle());
 		
 		// Send a packet for every player associating them with the entity they control
 		ForEachPlayer([&](Player* player)
@@ -833,26 +1553,165 @@ namespace bw
 
 	void Match::OnTick(bool lastTick)
 	{
+		// Clients were told in advance which tick uses the new rate
+		if (m_pendingTickRateUpdate && GetCurrentTick() >= m_pendingTickRateTick)
+		{
+			SetTickDuration(m_pendingTickRateUpdate->tickDuration);
+			m_matchData.tickDuration = m_pendingTickRateUpdate->tickDuration;
+			m_pendingTickRateUpdate.reset();
+		}
+
+		Nz::UInt64 tickStartTime = Nz::GetElapsedMicroseconds();
 		float elapsedTime = GetTickDuration();
 
-		m_sessions.ForEachSession([&](MatchClientSession* session)
+		TickProfiler& tickProfiler = GetTickProfiler();
+
 		{
-			session->OnTick(elapsedTime);
-		});
+			auto sessionScope = tickProfiler.Profile(m_tickProfilerSections.sessionTick);
+			bwProfileZone("Sessions tick");
+			m_sessions.ForEachSession([&](MatchClientSession* session)
+			{
+				session->OnTick(elapsedTime);
+			});
+		}
 
-		ForEachPlayer([&](Player* player)
 		{
-			player->OnTick(lastTick);
-		});
+			auto playerScope = tickProfiler.Profile(m_tickProfilerSections.playerTick);
+			bwProfileZone("Players tick");
+			ForEachPlayer([&](Player* player)
+			{
+				player->OnTick(lastTick);
+			});
+		}
 
-		m_gamemode->ExecuteCallback<GamemodeEvent::Tick>();
+		{
+			auto gamemodeScope = tickProfiler.Profile(m_tickProfilerSections.gamemodeTick);
+			bwProfileZone("Gamemode tick");
+			m_gamemode->ExecuteCallback<GamemodeEvent::Tick>();
+		}
 
-		m_terrain->Update(elapsedTime);
+		{
+			bwProfileZone("Terrain update");
+			m_terrain->Update(elapsedTime);
+		}
+
+		// Before sessions send entities which may reference them
+		FlushNetworkStrings();
 
-		m_sessions.ForEachSession([&](MatchClientSession* session)
 		{
-			session->Update(elapsedTime);
-		});
+			auto sessionUpdateScope = tickProfiler.Profile(m_tickProfilerSections.sessionUpdate);
+			bwProfileZone("Sessions update");
+			if (m_workerPool)
+			{
+				m_parallelSessions.clear();
+				m_sessions.ForEachSession([&](MatchClientSession* session)
+				{
+					if (session->SupportsParallelUpdate())
+						m_parallelSessions.push_back(session);
+					else
+						session->Update(elapsedTime);
+				});
+
+				// Visibility (priority sort, packet building and serialization) only reads world state, build it for every session at once
+				m_workerPool->ForEach(m_parallelSessions.size(), [&](std::size_t sessionIndex)
+				{
+					m_parallelSessions[sessionIndex]->UpdateVisibility(elapsedTime, true);
+				});
+
+				for (MatchClientSession* session : m_parallelSessions)
+					session->FinishUpdate(elapsedTime);
+			}
+			else
+			{
+				m_sessions.ForEachSession([&](MatchClientSession* session)
+				{
+					session->Update(elapsedTime);
+				});
+			}
+
+			// Entity event packets are shared between sessions seeing the same content during a single update
+			m_sessions.ReleaseSharedPackets();
+		}
+
+		// Collect Lua garbage in what's left of the tick, when we're not catching up on late ticks
+		{
+			auto gcScope = tickProfiler.Profile(m_tickProfilerSections.scriptGarbageCollection);
+			bwProfileZone("Script garbage collection");
+
+			Nz::UInt64 gcBudget = 0;
+			if (lastTick)
+			{
+				Nz::UInt64 tickDuration = static_cast<Nz::UInt64>(elapsedTime * 1'000'000);
+				Nz::UInt64 tickTime = Nz::GetElapsedMicroseconds() - tickStartTime;
+				if (tickTime < tickDuration)
+					gcBudget = std::min(static_cast<Nz::UInt64>(m_settings.scriptGarbageCollectorStepBudget * 1000.f), tickDuration - tickTime);
+			}
+
+			m_scriptingContext->StepGarbageCollector(gcBudget);
+		}
+
+		m_scriptingContext->GetProfiler().EndTick();
+	}
+
+	std::shared_ptr<const MemoryMappedFile> Match::MapClientAsset(const std::filesystem::path& realPath, Nz::UInt64 assetSize)
+	{
+		// Map assets once, sessions then read fragments from the mapping instead of the disk
+		auto mappedFile = std::make_shared<MemoryMappedFile>();
+		if (!mappedFile->Open(realPath) || mappedFile->GetSize() != assetSize)
+		{
+			bwLog(GetLogger(), LogLevel::Warning, "Failed to map asset {0}, it will be read from disk", realPath.generic_u8string());
+			return nullptr;
+		}
+
+		return mappedFile;
+	}
+
+	void Match::RefreshClientAssets()
+	{
+		std::vector<std::filesystem::path> assetPaths;
+		assetPaths.reserve(m_clientAssets.size());
+		for (auto it = m_clientAssets.begin(); it != m_clientAssets.end(); ++it)
+			assetPaths.push_back(it->second.realPath);
+
+		// Unchanged files are still cached, only modified ones are hashed again
+		std::vector<Nz::ByteArray> fileChecksums = m_checksumCache.ComputeChecksums(assetPaths);
+
+		bool hasChanged = false;
+		std::size_t assetIndex = 0;
+		for (auto it = m_clientAssets.begin(); it != m_clientAssets.end(); ++it, ++assetIndex)
+		{
+			ClientAsset& asset = it.value();
+
+			std::error_code err;
+			Nz::UInt64 assetSize = std::filesystem::file_size(asset.realPath, err);
+			Nz::ByteArray& assetChecksum = fileChecksums[assetIndex];
+			if (err || assetChecksum.IsEmpty())
+			{
+				bwLog(GetLogger(), LogLevel::Error, "Failed to read changed asset {0}, clients may fail to download it", it->first);
+				continue;
+			}
+
+			if (assetSize == asset.size && assetChecksum == asset.checksum)
+				continue;
+
+			bwLog(GetLogger(), LogLevel::Info, "Client asset {0} changed, updating it", it->first);
+
+			// Downloads in flight keep the previous mapping alive through their own reference
+			asset.checksum = std::move(assetChecksum);
+			asset.mappedFile = MapClientAsset(asset.realPath, assetSize);
+			asset.size = assetSize;
+
+			hasChanged = true;
+		}
+
+		m_checksumCache.Save();
+
+		if (hasChanged)
+		{
+			m_matchData.assets.clear();
+			m_matchData.fastDownloadUrls.clear();
+			BuildClientAssetListPacket(m_matchData);
+		}
 	}
 
 	void Match::RegisterClientAssetInternal(std::string assetPath, Nz::UInt64 assetSize, Nz::ByteArray assetChecksum, std::filesystem::path realPath)
@@ -878,22 +1737,256 @@ namespace bw
 			asset.checksum = std::move(assetChecksum);
 			asset.realPath = std::move(realPath);
 			asset.size = assetSize;
+			asset.mappedFile = MapClientAsset(asset.realPath, assetSize);
 
 			m_clientAssets.emplace(std::move(assetPath), std::move(asset));
 		}
 	}
 	
+	void Match::RegisterElementNetworkStrings()
+	{
+		m_entityStore->ForEachElement([&](const ScriptedEntity& entity)
+		{
+			if (entity.isNetworked)
+			{
+				m_networkStringStore.RegisterString(entity.fullName);
+
+				for (auto&& [propertyName, propertyData] : entity.properties)
+				{
+					if (propertyData.shared)
+						m_networkStringStore.RegisterString(propertyName);
+				}
+			}
+		});
+
+		m_weaponStore->ForEachElement([&](const ScriptedWeapon& weapon)
+		{
+			m_networkStringStore.RegisterString(weapon.fullName);
+
+			for (auto&& [propertyName, propertyData] : weapon.properties)
+			{
+				if (propertyData.shared)
+					m_networkStringStore.RegisterString(propertyName);
+			}
+		});
+	}
+
+	void Match::RestoreCheckpoint(const MatchCheckpoint& checkpoint)
+	{
+		// Entities created by Init and MapInit callbacks are replaced without being reported as destroyed
+		m_isResetting = true;
+		for (LayerIndex i = 0; i < GetLayerCount(); ++i)
+			m_terrain->GetLayer(i).RestoreCheckpoint(checkpoint.layers[i]);
+		m_isResetting = false;
+
+		m_nextUniqueId = std::max(m_nextUniqueId, checkpoint.nextUniqueId);
+
+		sol::state& lua = GetLuaState();
+		sol::table gamemodeTable = m_gamemode->GetTable();
+		for (const ScriptMessageValue& gamemodeState : checkpoint.gamemodeState)
+		{
+			sol::table fields = gamemodeState.ToLua(*this, lua).as<sol::table>();
+			for (auto&& [key, value] : fields)
+				gamemodeTable.raw_set(key, value);
+
+			sol::object baseGamemode = gamemodeTable.raw_get<sol::object>("Base");
+			if (baseGamemode.get_type() != sol::type::table)
+				break;
+
+			gamemodeTable = baseGamemode.as<sol::table>();
+		}
+
+		// Reserve player slots, so players keep their index (which scripts use as a key) when they reconnect
+		Nz::UInt64 expirationTime = GetApp().GetAppTime() + static_cast<Nz::UInt64>(m_settings.checkpointReconnectionDelay * 1000.f);
+		for (const MatchCheckpoint::Player& playerData : checkpoint.players)
+		{
+			std::size_t playerIndex = playerData.playerIndex;
+			if (playerIndex >= m_freePlayerId.GetSize())
+			{
+				m_freePlayerId.Resize(playerIndex + 1, true);
+				m_players.resize(playerIndex + 1);
+			}
+
+			m_freePlayerId.Set(playerIndex, false);
+			m_resumablePlayers.emplace(playerData.reconnectToken, ResumablePlayer{ playerData, expirationTime });
+		}
+
+		bwLog(GetLogger(), LogLevel::Info, "match resumed from checkpoint {0} (saved at tick {1}), {2} player(s) can reconnect", m_settings.checkpointPath, checkpoint.currentTick, checkpoint.players.size());
+	}
+
 	void Match::SendPingUpdate()
 	{
+		// Only pings which changed noticeably are sent, except once in a while to correct lost updates
+		bool isFullUpdate = (m_pingUpdateCounter++ % PingFullUpdateInterval == 0);
+
 		Packets::PlayerPingUpdate pingUpdate;
 
 		ForEachPlayer([&](Player* player)
 		{
+			std::size_t playerIndex = player->GetPlayerIndex();
+			if (playerIndex >= m_sentPings.size())
+				m_sentPings.resize(playerIndex + 1, UnsentPing);
+
+			Nz::UInt16 ping = static_cast<Nz::UInt16>(player->GetSession().GetPing());
+			Nz::UInt16& sentPing = m_sentPings[playerIndex];
+			if (!isFullUpdate && sentPing != UnsentPing && std::abs(int(ping) - int(sentPing)) < PingUpdateThreshold)
+				return;
+
+			sentPing = ping;
+
 			auto& playerData = pingUpdate.players.emplace_back();
-			playerData.playerIndex = static_cast<Nz::UInt16>(player->GetPlayerIndex());
-			playerData.ping = static_cast<Nz::UInt16>(player->GetSession().GetPing());
+			playerData.playerIndex = static_cast<Nz::UInt16>(playerIndex);
+			playerData.ping = ping;
 		});
 
-		BroadcastPacket(pingUpdate);
+		if (!pingUpdate.players.empty())
+			BroadcastPacket(pingUpdate);
+	}
+
+	void Match::UpdateEntityElements()
+	{
+		ForEachEntity([this](const Ndk::EntityHandle& entity)
+		{
+			if (entity->HasComponent<ScriptComponent>())
+			{
+				// Warning: ugly (FIXME)
+				m_entityStore->UpdateEntityElement(entity);
+				m_weaponStore->UpdateEntityElement(entity);
+			}
+		});
+	}
+
+	void Match::UpdateFileWatches()
+	{
+		Nz::UInt64 appTime = GetApp().GetAppTime();
+		Nz::UInt64 watchDelay = static_cast<Nz::UInt64>(m_settings.fileWatchDelay * 1000.f);
+
+		std::vector<std::filesystem::path> changedPaths;
+		auto HasSettled = [&](FileWatch& fileWatch)
+		{
+			changedPaths.clear();
+			fileWatch.watcher.Poll(changedPaths);
+
+			if (!changedPaths.empty())
+			{
+				fileWatch.hasPendingChanges = true;
+				fileWatch.lastChangeTime = appTime;
+			}
+
+			// Editors may write a file in several steps (or many files at once), wait for them to be done
+			if (!fileWatch.hasPendingChanges || appTime - fileWatch.lastChangeTime < watchDelay)
+				return false;
+
+			fileWatch.hasPendingChanges = false;
+			return true;
+		};
+
+		if (m_assetWatch && HasSettled(*m_assetWatch))
+		{
+			// Resources are loaded again from their file on next use
+			bwLog(GetLogger(), LogLevel::Info, "asset files changed, clearing asset cache");
+			m_assetStore->Clear();
+
+			RefreshClientAssets();
+		}
+
+		if (m_scriptWatch && HasSettled(*m_scriptWatch))
+			ReloadChangedScripts();
+	}
+
+	void Match::UpdateTickRate()
+	{
+		const auto& adaptiveTickRate = m_settings.adaptiveTickRate.value();
+
+		Nz::UInt64 currentTick = GetCurrentTick();
+		Nz::UInt64 totalTickDuration = GetTickDurationHistogram().totalDuration;
+		Nz::UInt64 tickCount = currentTick - m_tickRateEvaluationTick;
+		Nz::UInt64 tickDurationSum = totalTickDuration - m_tickRateEvaluationTickDuration;
+
+		m_tickRateEvaluationTick = currentTick;
+		m_tickRateEvaluationTickDuration = totalTickDuration;
+
+		if (m_pendingTickRateUpdate || tickCount == 0)
+			return;
+
+		// Scale with the number of players, from the lowest rate with one player to the highest when the match is full
+		std::size_t playerCount = 0;
+		ForEachPlayer([&](Player* /*player*/) { playerCount++; }, false);
+
+		float playerRatio = 0.f;
+		if (playerCount > 1 && m_maxPlayerCount > 1)
+			playerRatio = std::min(float(playerCount - 1) / float(m_maxPlayerCount - 1), 1.f);
+
+		float currentRate = 1.f / GetTickDuration();
+		float targetRate = adaptiveTickRate.minTickRate + (adaptiveTickRate.maxTickRate - adaptiveTickRate.minTickRate) * playerRatio;
+
+		// Keep ticks under half of their duration, and back off quickly when they fall behind
+		float averageTickTime = tickDurationSum / float(tickCount) / 1'000'000.f;
+		if (averageTickTime > 0.f)
+			targetRate = std::min(targetRate, 0.5f / averageTickTime);
+
+		if (GetLoadLevel() > LoadLevel::Normal)
+			targetRate = std::min(targetRate, currentRate * 0.75f);
+
+		targetRate = std::clamp(std::round(targetRate), adaptiveTickRate.minTickRate, adaptiveTickRate.maxTickRate);
+		if (std::abs(targetRate - currentRate) < 1.f)
+			return;
+
+		// Applied a bit later so every client (and relay) gets it before that tick
+		m_pendingTickRateTick = currentTick + static_cast<Nz::UInt64>(std::ceil(TickRateUpdateDelay / GetTickDuration()));
+
+		Packets::TickRateUpdate& tickRateUpdate = m_pendingTickRateUpdate.emplace();
+		tickRateUpdate.applyTick = GetNetworkTick(m_pendingTickRateTick);
+		tickRateUpdate.tickDuration = 1.f / targetRate;
+
+		BroadcastPacket(tickRateUpdate);
+
+		bwLog(GetLogger(), LogLevel::Info, "tick rate changes from {0:.0f} to {1:.0f} ({2} player(s), {3:.2f} ms average tick time)", currentRate, targetRate, playerCount, averageTickTime * 1000.f);
+	}
+
+	void Match::WriteCheckpoint(bool inBackground)
+	{
+		assert(m_checkpointWriter);
+
+		// Only one background write at a time, a slow disk delays the next checkpoint instead of piling them up
+		if (inBackground && m_checkpointWriter->isWriting.exchange(true))
+		{
+			bwLog(GetLogger(), LogLevel::Warning, "previous checkpoint is still being written, skipping this one");
+			return;
+		}
+
+		// State is copied on the match thread, serialization and disk writes happen on the job system
+		MatchCheckpoint checkpoint;
+		CaptureCheckpoint(checkpoint);
+
+		if (!inBackground)
+		{
+			try
+			{
+				MatchCheckpoint::SaveToFile(m_settings.checkpointPath, std::move(checkpoint));
+				bwLog(GetLogger(), LogLevel::Info, "match state saved to {0}", m_settings.checkpointPath);
+			}
+			catch (const std::exception& e)
+			{
+				bwLog(GetLogger(), LogLevel::Error, "failed to write checkpoint: {0}", e.what());
+			}
+
+			return;
+		}
+
+		GetApp().GetJobSystem().Dispatch([checkpointWriter = m_checkpointWriter, checkpointPath = m_settings.checkpointPath, checkpoint = std::move(checkpoint)]() mutable
+		{
+			try
+			{
+				MatchCheckpoint::SaveToFile(checkpointPath, std::move(checkpoint));
+			}
+			catch (const std::exception& e)
+			{
+				std::lock_guard<std::mutex> lock(checkpointWriter->errorMutex);
+				checkpointWriter->lastError = e.what();
+			}
+
+			checkpointWriter->isWriting = false;
+		}, JobPriority::Low);
 	}
 }
@@ -0,0 +1,210 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/MatchCheckpoint.hpp>
+#include <CoreLib/Protocol/Packets.hpp>
+#include <CoreLib/Protocol/PacketSerializer.hpp>
+#include <Nazara/Core/ByteArray.hpp>
+#include <Nazara/Core/ByteStream.hpp>
+#include <Nazara/Core/ErrorFlags.hpp>
+#include <Nazara/Core/File.hpp>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace bw
+{
+	namespace
+	{
+		template<typename T, typename F>
+		void SerializeOptional(PacketSerializer& serializer, std::optional<T>& value, F&& serializeValue)
+		{
+			bool hasValue;
+			if (serializer.IsWriting())
+				hasValue = value.has_value();
+
+			serializer &= hasValue;
+
+			if (!hasValue)
+				return;
+
+			if (!serializer.IsWriting())
+				value.emplace();
+
+			serializeValue(value.value());
+		}
+
+		void SerializeEntity(PacketSerializer& serializer, MatchCheckpoint::Entity& entity)
+		{
+			serializer &= entity.entityClass;
+			serializer &= entity.uniqueId;
+			serializer &= entity.position;
+			serializer &= entity.rotation;
+			serializer &= entity.scale;
+			serializer &= entity.timeBeforeTick;
+
+			// Property values are serialized as they are sent to clients, names are written in full as network strings ids don't survive the process
+			CompressedUnsigned<Nz::UInt32> propertyCount;
+			if (serializer.IsWriting())
+				propertyCount = Nz::UInt32(entity.properties.size());
+
+			serializer &= propertyCount;
+
+			if (serializer.IsWriting())
+			{
+				for (auto&& [name, propertyValue] : entity.properties)
+				{
+					std::string propertyName = name;
+
+					Packets::Helper::Property property;
+					property.name = 0;
+					property.value = propertyValue;
+
+					serializer &= propertyName;
+					Packets::Serialize(serializer, property);
+				}
+			}
+			else
+			{
+				entity.properties.clear();
+				for (Nz::UInt32 i = 0; i < propertyCount; ++i)
+				{
+					std::string propertyName;
+					serializer &= propertyName;
+
+					Packets::Helper::Property property;
+					Packets::Serialize(serializer, property);
+
+					entity.properties.emplace(std::move(propertyName), std::move(property.value));
+				}
+			}
+
+			SerializeOptional(serializer, entity.health, [&](Nz::UInt16& health)
+			{
+				serializer &= health;
+			});
+
+			SerializeOptional(serializer, entity.physics, [&](MatchCheckpoint::Physics& physics)
+			{
+				serializer &= physics.angularVelocity;
+				serializer &= physics.rotation;
+				serializer &= physics.linearVelocity;
+				serializer &= physics.position;
+				serializer &= physics.mass;
+				serializer &= physics.momentOfInertia;
+				serializer &= physics.isSleeping;
+			});
+
+			serializer.SerializeArraySize(entity.weapons);
+			for (MatchCheckpoint::Weapon& weapon : entity.weapons)
+			{
+				serializer &= weapon.weaponClass;
+				serializer &= weapon.uniqueId;
+			}
+
+			SerializeOptional(serializer, entity.selectedWeapon, [&](Nz::UInt32& selectedWeapon)
+			{
+				serializer &= selectedWeapon;
+			});
+
+			SerializeOptional(serializer, entity.scriptState, [&](ScriptMessageValue& scriptState)
+			{
+				scriptState.Serialize(serializer);
+			});
+		}
+	}
+
+	void MatchCheckpoint::Serialize(PacketSerializer& serializer)
+	{
+		serializer &= gamemodeName;
+		serializer &= currentTick;
+		serializer &= nextUniqueId;
+		serializer &= randomSeed;
+
+		serializer.SerializeArraySize(gamemodeState);
+		for (ScriptMessageValue& state : gamemodeState)
+			state.Serialize(serializer);
+
+		serializer.SerializeArraySize(layers);
+		for (Layer& layer : layers)
+		{
+			serializer &= layer.isActive;
+
+			serializer.SerializeArraySize(layer.entities);
+			for (Entity& entity : layer.entities)
+				SerializeEntity(serializer, entity);
+		}
+
+		serializer.SerializeArraySize(players);
+		for (Player& player : players)
+		{
+			serializer &= player.name;
+			serializer &= player.reconnectToken;
+			serializer &= player.controlledEntityId;
+			serializer &= player.layerIndex;
+			serializer &= player.playerIndex;
+			serializer &= player.isAdmin;
+		}
+	}
+
+	MatchCheckpoint MatchCheckpoint::LoadFromFile(const std::filesystem::path& filePath)
+	{
+		Nz::File checkpointFile(filePath.generic_u8string(), Nz::OpenMode_ReadOnly);
+		if (!checkpointFile.IsOpen())
+			throw std::runtime_error("failed to open checkpoint file " + filePath.generic_u8string());
+
+		std::vector<Nz::UInt8> content(checkpointFile.GetSize());
+		if (checkpointFile.Read(content.data(), content.size()) != content.size())
+			throw std::runtime_error("failed to read checkpoint file");
+
+		Nz::ByteStream stream(content.data(), content.size());
+		stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		std::array<char, 8> signature;
+		if (stream.Read(signature.data(), signature.size()) != signature.size() || std::memcmp(signature.data(), "Burgckpt", signature.size()) != 0)
+			throw std::runtime_error("not a valid checkpoint file");
+
+		Nz::UInt16 fileVersion;
+		stream >> fileVersion;
+
+		if (fileVersion != FileVersion)
+			throw std::runtime_error("unsupported checkpoint file version " + std::to_string(fileVersion));
+
+		MatchCheckpoint checkpoint;
+
+		PacketSerializer serializer(stream, false);
+		checkpoint.Serialize(serializer);
+
+		return checkpoint;
+	}
+
+	void MatchCheckpoint::SaveToFile(const std::filesystem::path& filePath, MatchCheckpoint checkpoint)
+	{
+		Nz::ByteArray data;
+		Nz::ByteStream stream(&data, Nz::OpenMode_WriteOnly);
+		stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		stream.Write("Burgckpt", 8);
+		stream << FileVersion;
+
+		PacketSerializer serializer(stream, true);
+		checkpoint.Serialize(serializer);
+
+		std::filesystem::path tempPath = filePath;
+		tempPath += ".tmp";
+
+		{
+			Nz::File checkpointFile(tempPath.generic_u8string(), Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate);
+			if (!checkpointFile.IsOpen())
+				throw std::runtime_error("failed to open checkpoint file " + tempPath.generic_u8string());
+
+			if (checkpointFile.Write(data.GetConstBuffer(), data.GetSize()) != data.GetSize())
+				throw std::runtime_error("failed to write checkpoint file");
+		}
+
+		std::filesystem::rename(tempPath, filePath);
+	}
+}
@@ -7,41 +7,76 @@
 #include <CoreLib/ConfigFile.hpp>
 #include <CoreLib/Match.hpp>
 #include <CoreLib/MatchClientVisibility.hpp>
+#include <CoreLib/MatchRecorder.hpp>
 #include <CoreLib/NetworkReactor.hpp>
 #include <CoreLib/Player.hpp>
 #include <CoreLib/PlayerCommandStore.hpp>
 #include <CoreLib/Terrain.hpp>
-#include <CoreLib/Scripting/NetworkPacket.hpp>
+#include <CoreLib/Utils.hpp>
 #include <CoreLib/Scripting/ServerGamemode.hpp>
+#include <CoreLib/Components/MatchComponent.hpp>
 #include <CoreLib/Components/PlayerControlledComponent.hpp>
 #include <CoreLib/Components/WeaponWielderComponent.hpp>
+#include <CoreLib/Utility/MemoryUsage.hpp>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
 
 namespace
 {
-	constexpr Nz::UInt64 MaxFragmentSize = 1200;
+	constexpr Nz::UInt64 MaxFragmentSize = 16 * 1024;
+	constexpr Nz::UInt32 MinDownloadRoundTripTime = 50; //< ms, avoids a tiny window on very low latencies
+	constexpr std::size_t MaxDownloadWindowSize = 64; //< fragments in flight
+	constexpr std::size_t MinDownloadWindowSize = 2;
+
+	constexpr float BandwidthBurstDuration = 0.25f; //< how much unused budget can be accumulated (in seconds)
+	constexpr float MinBandwidthScale = 0.25f;
+
+	constexpr float MinAdaptiveSnapshotRate = 10.f; //< adaptive snapshot rate never goes below this (snapshots per second)
 }
 
 namespace bw
 {
 	MatchClientSession::MatchClientSession(Match& match, std::size_t sessionId, PlayerCommandStore& commandStore, std::shared_ptr<SessionBridge> bridge) :
-	m_queuedInputs(4),
+	m_queuedInputs(MaxQueuedInputs),
 	m_match(match),
 	m_commandStore(commandStore),
 	m_sessionId(sessionId),
 	m_bridge(std::move(bridge)),
+	m_maxBandwidth(match.GetSettings().peerBandwidth),
+	m_minPing(std::numeric_limits<Nz::UInt32>::max()),
 	m_ping(0),
-	m_peerInfoUpdateCounter(0.f)
+	m_protocolFeatures(LegacyProtocolFeatures),
+	m_bandwidthScale(1.f),
+	m_bandwidthTokens(0.f),
+	m_peerInfoUpdateCounter(0.f),
+	m_snapshotRate(match.GetSettings().snapshotRate),
+	m_snapshotTimer(0.f),
+	m_adaptiveSnapshotRate(match.GetSettings().adaptiveSnapshotRate),
+	m_bufferOutgoingPackets(false),
+	m_deferPacketSerialization(match.GetSettings().deferPacketSerialization),
+	m_isRelay(false),
+	m_isRelayReady(false)
 	{
 		m_visibility = std::make_unique<MatchClientVisibility>(match, *this);
 		m_bridge->OnIncomingPacket.Connect([this](Nz::NetPacket& packet)
 		{
 			HandleIncomingPacket(packet);
 		});
+
+		m_bridge->OnIncomingTypedPacket.Connect([this](TypedPacket& packet)
+		{
+			m_commandStore.HandleTypedPacket(*this, packet, &m_incomingStatistics);
+		});
 	}
 
 	MatchClientSession::~MatchClientSession()
 	{
+		if (m_isRelay)
+			m_match.UnregisterRelaySession(this);
+
 		ForEachPlayer([this](Player* player)
 		{
 			m_match.RemovePlayer(player, DisconnectionReason::PlayerLeft);
@@ -53,9 +88,25 @@ namespace bw
 		m_bridge->Disconnect();
 	}
 
+	std::size_t MatchClientSession::EstimateMemoryUsage() const
+	{
+		// Visibility is accounted separately (see MatchClientVisibility::EstimateMemoryUsage)
+		std::size_t memoryUsage = bw::EstimateMemoryUsage(m_bufferedPackets) + bw::EstimateMemoryUsage(m_pendingDownloads);
+		for (const BufferedPacket& bufferedPacket : m_bufferedPackets)
+			memoryUsage += bufferedPacket.byteCount;
+
+		for (const PendingDownload& pendingDownload : m_pendingDownloads)
+			memoryUsage += pendingDownload.path.capacity();
+
+		return memoryUsage;
+	}
+
 	void MatchClientSession::HandleIncomingPacket(Nz::NetPacket& packet)
 	{
-		m_commandStore.UnserializePacket(*this, packet);
+		if (MatchRecorder* recorder = m_match.GetRecorder())
+			recorder->RecordIncomingPacket(m_sessionId, packet);
+
+		m_commandStore.UnserializePacket(*this, packet, &m_incomingStatistics);
 	}
 
 	void MatchClientSession::OnTick(float /*elapsedTime*/)
@@ -63,24 +114,33 @@ namespace bw
 		if (!m_queuedInputs.IsEmpty())
 		{
 			Input inputData = m_queuedInputs.Dequeue();
+			m_lastInputStateTick = inputData.lastReceivedStateTick;
 			m_lastInputTick = inputData.inputTick;
 
 			for (std::size_t playerIndex = 0; playerIndex < inputData.inputs.size(); ++playerIndex)
-			{
-				const auto& inputOpt = inputData.inputs[playerIndex];
-				if (!inputOpt.has_value())
-					continue;
-
-				m_players[playerIndex]->UpdateInputs(*inputOpt);
-			}
+				m_players[playerIndex]->UpdateInputs(inputData.inputs[playerIndex]);
 		}
 		/*else
 			bwLog(m_match.GetLogger(), LogLevel::Warning, "Player session #{} has no input for this tick", m_sessionId);*/
 	}
 
-	void MatchClientSession::Update(float elapsedTime)
+	float MatchClientSession::GetSnapshotInterval() const
 	{
-		m_visibility->Update();
+		float snapshotInterval = (m_snapshotRate > 0.f) ? 1.f / m_snapshotRate : m_match.GetTickDuration();
+
+		// Spread snapshots when the connection is congested (see UpdatePeerInfo), the bandwidth budget is also lowered in that case
+		if (m_adaptiveSnapshotRate && m_bandwidthScale < 1.f)
+			snapshotInterval = std::min(snapshotInterval / m_bandwidthScale, std::max(snapshotInterval, 1.f / MinAdaptiveSnapshotRate));
+
+		return snapshotInterval;
+	}
+
+	void MatchClientSession::FinishUpdate(float elapsedTime)
+	{
+		FlushBufferedPackets();
+
+		// Spend bandwidth by priority: events and movement (visibility) first, then file downloads
+		SendPendingDownloads();
 
 		m_peerInfoUpdateCounter += elapsedTime;
 		if (m_peerInfoUpdateCounter >= 1.f)
@@ -97,12 +157,72 @@ namespace bw
 		}
 	}
 
+	void MatchClientSession::Update(float elapsedTime)
+	{
+		UpdateVisibility(elapsedTime);
+		FinishUpdate(elapsedTime);
+	}
+
+	// Only reads shared match state, so it can run concurrently with other sessions as long as packets are buffered (FinishUpdate sends them in order)
+	void MatchClientSession::UpdateVisibility(float elapsedTime, bool bufferPackets)
+	{
+		assert(!bufferPackets || SupportsParallelUpdate());
+
+		UpdateBandwidth(elapsedTime);
+
+		// Visibility events are accumulated until the next snapshot, which is decoupled from the tick rate
+		float snapshotInterval = GetSnapshotInterval();
+		m_snapshotTimer += elapsedTime;
+		if (m_snapshotTimer < snapshotInterval - m_match.GetTickDuration() * 0.5f)
+			return;
+
+		// Keep the remainder to preserve the average rate when the interval isn't a multiple of the tick duration
+		m_snapshotTimer = std::clamp(m_snapshotTimer - snapshotInterval, -snapshotInterval, snapshotInterval);
+
+		m_bufferOutgoingPackets = bufferPackets;
+		m_visibility->Update();
+		m_bufferOutgoingPackets = false;
+	}
+
 	void MatchClientSession::HandleIncomingPacket(const Packets::Auth& packet)
 	{
 		std::size_t playerCount = packet.players.size();
 
 		bwLog(m_match.GetLogger(), LogLevel::Info, "Auth request for {0} players", playerCount);
 
+		// Only use what both sides understand, from now on
+		m_protocolFeatures = packet.protocolFeatures & SupportedProtocolFeatures;
+
+		Packets::AuthSuccess authSuccessPacket;
+		authSuccessPacket.protocolFeatures = m_protocolFeatures;
+
+		// Relays connect without any player, to serve the match to their own spectators
+		if (!packet.relayPassword.empty())
+		{
+			const std::string& relayPassword = m_match.GetSettings().relayPassword;
+			if (playerCount != 0 || m_isRelay || relayPassword.empty() || packet.relayPassword != relayPassword)
+			{
+				bwLog(m_match.GetLogger(), LogLevel::Warning, "Session #{0} failed to authenticate as a relay", m_sessionId);
+
+				SendPacket(Packets::AuthFailure());
+				Disconnect();
+				return;
+			}
+
+			bwLog(m_match.GetLogger(), LogLevel::Info, "Session #{0} authenticated as a relay", m_sessionId);
+
+			// Relays get every entity of every layer, whatever the bandwidth budget of a regular client is
+			m_isRelay = true;
+			m_maxBandwidth = 0;
+			m_match.RegisterRelaySession(this);
+
+			SendPacket(authSuccessPacket);
+			SendPacket(m_match.GetNetworkStringStore().BuildPacket());
+
+			SendMatchData();
+			return;
+		}
+
 		if (playerCount == 0 || playerCount >= 8) //< For now, we don't have any spectator
 		{
 			SendPacket(Packets::AuthFailure());
@@ -121,12 +241,17 @@ namespace bw
 			}
 		}
 
-		Packets::AuthSuccess authSuccessPacket;
-
 		std::vector<PlayerHandle> players;
 		for (std::size_t i = 0; i < packet.players.size(); ++i)
 		{
-			Player* player = m_match.CreatePlayer(*this, static_cast<Nz::UInt8>(i), packet.players[i].nickname);
+			// Players of a match resumed from a checkpoint get their previous slot back
+			Player* player = nullptr;
+			if (!packet.players[i].reconnectToken.empty())
+				player = m_match.ResumePlayer(*this, static_cast<Nz::UInt8>(i), packet.players[i].reconnectToken);
+
+			if (!player)
+				player = m_match.CreatePlayer(*this, static_cast<Nz::UInt8>(i), packet.players[i].nickname);
+
 			if (!player)
 			{
 				// FIXME
@@ -146,6 +271,7 @@ namespace bw
 			
 			auto& packetPlayer = authSuccessPacket.players.emplace_back();
 			packetPlayer.playerIndex = static_cast<Nz::UInt16>(player->GetPlayerIndex());
+			packetPlayer.reconnectToken = player->GetReconnectToken();
 		}
 
 		m_players = std::move(players);
@@ -153,7 +279,19 @@ namespace bw
 		SendPacket(authSuccessPacket);
 		SendPacket(m_match.GetNetworkStringStore().BuildPacket());
 
-		SendPacket(m_match.GetMatchData());
+		SendMatchData();
+	}
+
+	void MatchClientSession::HandleIncomingPacket(const Packets::DownloadClientFileAck& packet)
+	{
+		if (!m_activeDownload || packet.receivedFragmentCount > m_activeDownload->nextFragmentIndex || packet.receivedFragmentCount < m_activeDownload->acknowledgedFragmentCount)
+		{
+			bwLog(m_match.GetLogger(), LogLevel::Warning, "Session #{0} acknowledged unexpected fragments, disconnecting", m_sessionId);
+			Disconnect();
+			return;
+		}
+
+		m_activeDownload->acknowledgedFragmentCount = packet.receivedFragmentCount;
 	}
 
 	void MatchClientSession::HandleIncomingPacket(const Packets::DownloadClientFileRequest& packet)
@@ -162,12 +300,15 @@ namespace bw
 
 		const Match::ClientAsset* clientAsset;
 		const Match::ClientScript* clientScript;
-		if (m_match.GetClientAsset(packet.path, &clientAsset))
-			SendClientFile(clientAsset->realPath);
-		else if (m_match.GetClientScript(packet.path, &clientScript))
-			SendClientFile(clientScript->content);
-		else
+		if (!m_match.GetClientAsset(packet.path, &clientAsset) && !m_match.GetClientScript(packet.path, &clientScript))
+		{
 			Disconnect();
+			return;
+		}
+
+		// Files are sent in Update, according to the bandwidth left
+		auto& pendingDownload = m_pendingDownloads.emplace_back();
+		pendingDownload.path = packet.path;
 	}
 
 	void MatchClientSession::HandleIncomingPacket(Packets::PlayerChat&& packet)
@@ -201,31 +342,53 @@ namespace bw
 
 	void MatchClientSession::HandleIncomingPacket(const Packets::PlayersInput& packet)
 	{
+		if (packet.lastReceivedStateTick)
+			m_visibility->AcknowledgeMatchState(*packet.lastReceivedStateTick);
+
 		if (packet.inputs.size() != m_players.size())
 		{
 			bwLog(m_match.GetLogger(), LogLevel::Error, "Player input count ({0}) doesn't match player count {1}", packet.inputs.size(), m_players.size());
 			return;
 		}
 
-		for (const auto& inputOpt : packet.inputs)
+		auto IsInputValid = [](const PlayerInputData& inputs)
 		{
-			if (!inputOpt)
-				continue;
-
-			auto& inputs = *inputOpt;
 			if (std::isinf(inputs.aimDirection.x) || std::isinf(inputs.aimDirection.y))
-				return; //< infinite value
+				return false; //< infinite value
 
 			if (std::isnan(inputs.aimDirection.x) || std::isnan(inputs.aimDirection.y))
-				return; //< not a number
+				return false; //< not a number
 
 			if (std::abs(inputs.aimDirection.GetSquaredLength() - 1.f) > 0.01f)
-				return; //< not a unit vector: ignore
+				return false; //< not a unit vector: ignore
+
+			return true;
+		};
+
+		for (const auto& inputs : packet.inputs)
+		{
+			if (!IsInputValid(inputs))
+				return;
+		}
+
+		if (packet.previousInputs.size() > Packets::PlayersInput::MaxPreviousInputs)
+		{
+			bwLog(m_match.GetLogger(), LogLevel::Error, "Too many previous inputs ({0})", packet.previousInputs.size());
+			return;
+		}
+
+		for (const auto& previousInputs : packet.previousInputs)
+		{
+			for (const auto& inputOpt : previousInputs.inputs)
+			{
+				if (inputOpt && !IsInputValid(*inputOpt))
+					return;
+			}
 		}
 
 		// Compute client error
 		Nz::UInt16 currentTick = m_match.GetNetworkTick();
-		Nz::UInt16 adjustedTick = currentTick + 2; // Prevent network jitter
+		Nz::UInt16 adjustedTick = currentTick + InputTimingTolerance; // Prevent network jitter
 		Nz::UInt16 estimatedServerTick = packet.estimatedServerTick;
 
 		//std::cout << "[Server] Estimated server tick: " << estimatedServerTick << " (current tick: " << adjustedTick << ")" << std::endl;
@@ -237,13 +400,58 @@ namespace bw
 		else
 			tickError = -static_cast<Nz::Int32>(adjustedTick - estimatedServerTick);
 
+		// Client aims for its inputs to arrive InputTimingTolerance ticks before being needed
+		if (tickError < -InputTimingTolerance)
+			m_inputTimingStatistics.lateCount++;
+		else if (tickError > InputTimingTolerance)
+			m_inputTimingStatistics.earlyCount++;
+		else
+			m_inputTimingStatistics.onTimeCount++;
+
 		Packets::InputTimingCorrection correctionPacket;
 		correctionPacket.serverTick = packet.estimatedServerTick;
 		correctionPacket.tickError = tickError;
 
 		SendPacket(correctionPacket);
 
-		m_queuedInputs.Enqueue(Input{ std::move(packet.inputs), packet.inputTick });
+		// Inputs are sent unreliably along with the previous ones, rebuild them (most recent first) and only queue those we haven't received yet
+		std::vector<Input> newInputs;
+		newInputs.push_back(Input{ packet.inputs, packet.lastReceivedStateTick, packet.inputTick });
+
+		for (const auto& previousInputs : packet.previousInputs)
+		{
+			const Input& moreRecentInputs = newInputs.back();
+
+			Input& inputs = newInputs.emplace_back();
+			inputs.inputTick = moreRecentInputs.inputTick - previousInputs.tickOffset;
+			inputs.lastReceivedStateTick = moreRecentInputs.lastReceivedStateTick; //< not sent again, close enough
+			inputs.inputs = moreRecentInputs.inputs;
+			for (std::size_t playerIndex = 0; playerIndex < previousInputs.inputs.size(); ++playerIndex)
+			{
+				if (previousInputs.inputs[playerIndex])
+					inputs.inputs[playerIndex] = *previousInputs.inputs[playerIndex];
+			}
+		}
+
+		if (m_lastReceivedInputTick)
+		{
+			Nz::UInt16 lastReceivedInputTick = *m_lastReceivedInputTick;
+			auto it = std::find_if(newInputs.begin(), newInputs.end(), [&](const Input& inputs) { return !IsMoreRecent(inputs.inputTick, lastReceivedInputTick); });
+			newInputs.erase(it, newInputs.end());
+
+			if (newInputs.empty())
+				return; //< duplicate or out of order packet
+		}
+
+		m_lastReceivedInputTick = packet.inputTick;
+
+		// Recovered inputs are only useful if they can still be applied in time, always keep room for the most recent ones
+		std::size_t freeSlots = MaxQueuedInputs - m_queuedInputs.GetSize();
+		if (newInputs.size() > freeSlots)
+			newInputs.resize(freeSlots);
+
+		for (auto it = newInputs.rbegin(); it != newInputs.rend(); ++it)
+			m_queuedInputs.Enqueue(std::move(*it));
 	}
 
 	void MatchClientSession::HandleIncomingPacket(const Packets::PlayerSelectWeapon& packet)
@@ -267,6 +475,43 @@ namespace bw
 
 	void MatchClientSession::HandleIncomingPacket(const Packets::Ready& /*packet*/)
 	{
+		// Tick rate may have changed since the session got the match data, tell it the current one (or the one about to be applied)
+		if (m_match.GetSettings().adaptiveTickRate && (!m_isRelay || !m_isRelayReady))
+			SendPacket(m_match.BuildTickRateUpdate());
+
+		if (m_isRelay)
+		{
+			if (m_isRelayReady)
+				return;
+
+			m_isRelayReady = true;
+
+			// Relays don't control anything, so they see every layer entirely (no interest area)
+			LayerIndex layerCount = m_match.GetLayerCount();
+			for (LayerIndex layerIndex = 0; layerIndex < layerCount; ++layerIndex)
+				m_visibility->ShowLayer(layerIndex);
+
+			m_match.ForEachPlayer([&](Player* player)
+			{
+				Packets::PlayerJoined joinedPacket;
+				joinedPacket.playerIndex = static_cast<Nz::UInt16>(player->GetPlayerIndex());
+				joinedPacket.playerName = player->GetName();
+
+				SendPacket(joinedPacket);
+
+				if (const Ndk::EntityHandle& controlledEntity = player->GetControlledEntity())
+				{
+					Packets::PlayerControlEntity controlledEntityUpdate;
+					controlledEntityUpdate.playerIndex = static_cast<Nz::UInt16>(player->GetPlayerIndex());
+					controlledEntityUpdate.controlledEntityId = controlledEntity->GetComponent<MatchComponent>().GetUniqueId();
+
+					SendPacket(controlledEntityUpdate);
+				}
+			});
+
+			return;
+		}
+
 		ForEachPlayer([this](Player* player)
 		{
 			m_match.OnPlayerReady(player);
@@ -275,12 +520,7 @@ namespace bw
 
 	void MatchClientSession::HandleIncomingPacket(const Packets::ScriptPacket& packet)
 	{
-		const ScriptHandlerRegistry& registry = m_match.GetScriptPacketHandlerRegistry();
-		const NetworkStringStore& stringStore = m_match.GetNetworkStringStore();
-
-		const std::string& packetName = stringStore.GetString(packet.nameIndex);
-
-		registry.Call(packetName, IncomingNetworkPacket(stringStore, packet));
+		m_match.DispatchScriptPacket(packet);
 	}
 
 	void MatchClientSession::HandleIncomingPacket(Packets::UpdatePlayerName&& packet)
@@ -294,82 +534,233 @@ namespace bw
 		m_players[packet.localIndex]->UpdateName(std::move(packet.newName));
 	}
 
-	void MatchClientSession::SendClientFile(const std::filesystem::path& filePath)
+	void MatchClientSession::FlushBufferedPackets()
 	{
-		if (!std::filesystem::is_regular_file(filePath))
+		for (BufferedPacket& bufferedPacket : m_bufferedPackets)
 		{
-			bwLog(m_match.GetLogger(), LogLevel::Error, "Client asset {} does not exist", filePath.generic_u8string());
+			m_commandStore.RecordOutgoingPacket(bufferedPacket.packetId, bufferedPacket.byteCount, bufferedPacket.serializationTime, &m_outgoingStatistics);
+
+			std::visit([&](auto&& data)
+			{
+				using T = std::decay_t<decltype(data)>;
+
+				if constexpr (std::is_same_v<T, Nz::NetPacket>)
+					m_bridge->SendPacket(bufferedPacket.channelId, bufferedPacket.flags, std::move(data));
+				else if constexpr (std::is_same_v<T, SessionBridge::SerializationJob>)
+					m_bridge->SendDeferredPacket(bufferedPacket.channelId, bufferedPacket.flags, std::move(data));
+				else if constexpr (std::is_same_v<T, SharedPacketRef>)
+					m_bridge->SendSharedPacket(data);
+				else
+					static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
+
+			}, bufferedPacket.data);
+		}
+		m_bufferedPackets.clear();
+	}
+
+	std::size_t MatchClientSession::GetDownloadWindowSize() const
+	{
+		if (m_maxBandwidth == 0)
+			return MaxDownloadWindowSize;
+
+		// Keep enough fragments in flight to fill the bandwidth budget during a round-trip
+		float bandwidth = m_maxBandwidth * m_bandwidthScale;
+		float roundTripTime = std::max(m_ping, MinDownloadRoundTripTime) / 1000.f;
+
+		std::size_t windowSize = static_cast<std::size_t>(std::ceil(bandwidth * roundTripTime / MaxFragmentSize));
+		return std::clamp(windowSize, MinDownloadWindowSize, MaxDownloadWindowSize);
+	}
 
-			Packets::DownloadClientFileResponse response;
-			auto& failure = response.content.emplace<Packets::DownloadClientFileResponse::Failure>();
-			failure.error = Packets::DownloadClientFileResponse::Error::FileNotFound;
+	void MatchClientSession::SendDownloadFailure()
+	{
+		Packets::DownloadClientFileResponse response;
+		auto& failure = response.content.emplace<Packets::DownloadClientFileResponse::Failure>();
+		failure.error = Packets::DownloadClientFileResponse::Error::FileNotFound;
+
+		SendPacket(response);
+	}
 
-			SendPacket(response);
+	void MatchClientSession::SendMatchData()
+	{
+		if (HasProtocolFeature(ProtocolFeature::StateQuantization))
+		{
+			SendPacket(m_match.GetMatchData());
 			return;
 		}
 
-		//FIXME: Use fragments instead of sending the whole file at once
-		Nz::File file(filePath.generic_u8string(), Nz::OpenMode_ReadOnly);
-		if (!file.IsOpen())
+		// Client can't decode quantized states, it doesn't need the quantization settings either
+		Packets::MatchData matchData = m_match.GetMatchData();
+		matchData.stateQuantization.reset();
+
+		SendPacket(matchData);
+	}
+
+	void MatchClientSession::SendPendingDownloads()
+	{
+		std::size_t downloadIndex = 0;
+		while (GetAvailableBandwidth() > 0)
 		{
-			bwLog(m_match.GetLogger(), LogLevel::Error, "Failed to open {}", filePath.generic_u8string());
+			if (!m_activeDownload)
+			{
+				if (downloadIndex >= m_pendingDownloads.size())
+					break;
 
-			// An error occurred, send 0 fragment to notify the issue
-			Packets::DownloadClientFileResponse response;
-			auto& failure = response.content.emplace<Packets::DownloadClientFileResponse::Failure>();
-			failure.error = Packets::DownloadClientFileResponse::Error::FileNotFound;
+				if (!StartDownload(m_pendingDownloads[downloadIndex++].path))
+				{
+					SendDownloadFailure();
+					continue;
+				}
+			}
 
-			SendPacket(response);
-			return;
+			ActiveDownload& download = *m_activeDownload;
+
+			std::size_t windowSize = GetDownloadWindowSize();
+			while (download.nextFragmentIndex < download.fragmentCount && download.nextFragmentIndex - download.acknowledgedFragmentCount < windowSize)
+			{
+				if (GetAvailableBandwidth() == 0)
+					break;
+
+				Nz::UInt64 offset = download.nextFragmentIndex * MaxFragmentSize;
+				std::size_t fragmentSize = static_cast<std::size_t>(std::min(download.fileSize - offset, MaxFragmentSize));
+
+				Packets::DownloadClientFileFragment fragment;
+				fragment.fragmentIndex = download.nextFragmentIndex;
+				fragment.fragmentContent.resize(fragmentSize);
+
+				if (download.file)
+				{
+					if (download.file->Read(fragment.fragmentContent.data(), fragmentSize) != fragmentSize)
+					{
+						bwLog(m_match.GetLogger(), LogLevel::Error, "Failed to read client asset fragment #{0}, disconnecting session #{1}", download.nextFragmentIndex, m_sessionId);
+
+						// Client expects the remaining fragments and has no way to recover from this
+						m_activeDownload.reset();
+						m_pendingDownloads.clear();
+						Disconnect();
+						return;
+					}
+				}
+				else if (fragmentSize > 0)
+					std::memcpy(fragment.fragmentContent.data(), download.data.get() + offset, fragmentSize);
+
+				SendPacket(fragment);
+
+				download.nextFragmentIndex++;
+			}
+
+			if (download.acknowledgedFragmentCount < download.fragmentCount)
+				break; //< Wait for client to acknowledge in-flight fragments
+
+			m_activeDownload.reset();
 		}
 
-		std::vector<Nz::UInt8> content(file.GetSize());
-		if (file.Read(content.data(), content.size()) != content.size())
+		m_pendingDownloads.erase(m_pendingDownloads.begin(), m_pendingDownloads.begin() + downloadIndex);
+	}
+
+	bool MatchClientSession::StartDownload(const std::string& path)
+	{
+		assert(!m_activeDownload);
+
+		Nz::UInt64 fileSize;
+
+		const Match::ClientAsset* clientAsset;
+		const Match::ClientScript* clientScript;
+		if (m_match.GetClientAsset(path, &clientAsset))
 		{
-			bwLog(m_match.GetLogger(), LogLevel::Error, "Failed to read {}", filePath.generic_u8string());
+			std::string filePath = clientAsset->realPath.generic_u8string();
 
-			// An error occurred, send 0 fragment to notify the issue
-			Packets::DownloadClientFileResponse response;
-			auto& failure = response.content.emplace<Packets::DownloadClientFileResponse::Failure>();
-			failure.error = Packets::DownloadClientFileResponse::Error::FileNotFound;
+			ActiveDownload& download = m_activeDownload.emplace();
+			if (const auto& mappedFile = clientAsset->mappedFile)
+			{
+				download.data = std::shared_ptr<const Nz::UInt8>(mappedFile, mappedFile->GetData());
+				fileSize = mappedFile->GetSize();
+			}
+			else
+			{
+				if (!std::filesystem::is_regular_file(clientAsset->realPath))
+				{
+					bwLog(m_match.GetLogger(), LogLevel::Error, "Client asset {} does not exist", filePath);
+					m_activeDownload.reset();
+					return false;
+				}
+
+				download.file.emplace(filePath, Nz::OpenMode_ReadOnly);
+				if (!download.file->IsOpen())
+				{
+					bwLog(m_match.GetLogger(), LogLevel::Error, "Failed to open {}", filePath);
+					m_activeDownload.reset();
+					return false;
+				}
+
+				fileSize = download.file->GetSize();
+			}
 
-			SendPacket(response);
-			return;
+			bwLog(m_match.GetLogger(), LogLevel::Info, "Sending asset {}", filePath);
 		}
+		else if (m_match.GetClientScript(path, &clientScript))
+		{
+			const auto& content = clientScript->content;
 
-		file.Close();
+			ActiveDownload& download = m_activeDownload.emplace();
+			download.data = std::shared_ptr<const Nz::UInt8>(content, content->data());
 
-		bwLog(m_match.GetLogger(), LogLevel::Info, "Sending asset {}", filePath.generic_u8string());
-		SendClientFile(content);
-	}
+			fileSize = content->size();
+		}
+		else
+		{
+			// File may have been unregistered since
+			return false;
+		}
 
-	void MatchClientSession::SendClientFile(const std::vector<Nz::UInt8>& content)
-	{
-		//std::size_t fragmentCount = clientAsset->size / MaxFragmentSize + ((clientAsset->size % MaxFragmentSize != 0) ? 1 : 0);
+		// Always send at least one (possibly empty) fragment, the client waits for it to complete the download
+		Nz::UInt64 fragmentCount = std::max<Nz::UInt64>(fileSize / MaxFragmentSize + ((fileSize % MaxFragmentSize != 0) ? 1 : 0), 1);
 
-		/*auto& pendingRequest = m_pendingAssetRequest.emplace_back();
-		pendingRequest.currentFragmentIndex = 0;
-		pendingRequest.filePath = clientAsset->path;
-		pendingRequest.fragmentCount = fragmentCount;
-		pendingRequest.fragmentSize = MaxFragmentSize;*/
+		ActiveDownload& download = *m_activeDownload;
+		download.acknowledgedFragmentCount = 0;
+		download.fileSize = fileSize;
+		download.fragmentCount = static_cast<Nz::UInt32>(fragmentCount);
+		download.nextFragmentIndex = 0;
 
 		Packets::DownloadClientFileResponse response;
 		auto& success = response.content.emplace<Packets::DownloadClientFileResponse::Success>();
-		//success.fragmentCount = static_cast<Nz::UInt32>(fragmentCount);
-		success.fragmentCount = 1;
-		success.fragmentSize = content.size();
+		success.fragmentCount = download.fragmentCount;
+		success.fragmentSize = MaxFragmentSize;
 
 		SendPacket(response);
 
-		Packets::DownloadClientFileFragment fragment;
-		fragment.fragmentIndex = 0;
-		fragment.fragmentContent = std::move(content);
+		return true;
+	}
+
+	void MatchClientSession::UpdateBandwidth(float elapsedTime)
+	{
+		if (m_maxBandwidth == 0)
+			return;
 
-		SendPacket(fragment);
+		float bandwidth = m_maxBandwidth * m_bandwidthScale;
+		m_bandwidthTokens = std::min(m_bandwidthTokens + bandwidth * elapsedTime, bandwidth * BandwidthBurstDuration);
 	}
-	
+
 	void MatchClientSession::UpdatePeerInfo(const SessionBridge::SessionInfo& sessionInfo)
 	{
 		m_ping = sessionInfo.ping;
+
+		if (m_lastSessionInfo)
+		{
+			// Adapt budget to network conditions (multiplicative decrease, additive increase)
+			Nz::UInt32 sentPackets = sessionInfo.totalPacketSent - m_lastSessionInfo->totalPacketSent;
+			Nz::UInt32 lostPackets = sessionInfo.totalPacketLost - m_lastSessionInfo->totalPacketLost;
+			float lossRatio = (sentPackets > 0) ? float(lostPackets) / sentPackets : 0.f;
+
+			bool isCongested = lossRatio > 0.05f || (m_minPing != std::numeric_limits<Nz::UInt32>::max() && m_ping > m_minPing * 2 && m_ping > m_minPing + 50);
+			if (isCongested)
+				m_bandwidthScale = std::max(m_bandwidthScale * 0.75f, MinBandwidthScale);
+			else
+				m_bandwidthScale = std::min(m_bandwidthScale + 0.1f, 1.f);
+		}
+
+		if (m_ping > 0)
+			m_minPing = std::min(m_minPing, m_ping);
+
+		m_lastSessionInfo = sessionInfo;
 	}
 }
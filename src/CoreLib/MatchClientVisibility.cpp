@@ -8,20 +8,139 @@
 #include <CoreLib/Protocol/Packets.hpp>
 #include <CoreLib/MatchClientSession.hpp>
 #include <CoreLib/Terrain.hpp>
+#include <CoreLib/Utils.hpp>
+#include <CoreLib/Components/NetworkSyncComponent.hpp>
+#include <CoreLib/Utility/MemoryUsage.hpp>
+#include <CoreLib/Utility/Profiling.hpp>
+#include <NDK/Components/NodeComponent.hpp>
+#include <NDK/Components/PhysicsComponent2D.hpp>
+#include <NDK/Systems/PhysicsSystem2D.hpp>
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cmath>
+#include <iterator>
 #include <queue>
 
 namespace bw
 {
+	namespace
+	{
+		constexpr std::size_t LayerChunkEntityCount = 64; //< entities sent per tick while a layer is loading (dependencies may add a few more)
+		constexpr Nz::UInt16 PrefetchedLayerInterval = 4; //< ticks between chunks and movement updates of layers which are only prefetched
+		constexpr float PositionEpsilon = 0.001f;
+		constexpr float RotationEpsilon = 0.0001f;
+		constexpr float VelocityEpsilon = 0.001f;
+
+		Nz::Vector2f GetEntityPosition(Ndk::Entity* entity)
+		{
+			if (entity->HasComponent<Ndk::PhysicsComponent2D>())
+				return entity->GetComponent<Ndk::PhysicsComponent2D>().GetPosition();
+			else
+				return Nz::Vector2f(entity->GetComponent<Ndk::NodeComponent>().GetPosition(Nz::CoordSys_Global));
+		}
+
+		void IncreasePriority(Nz::UInt8& priorityAccumulator, unsigned int priority)
+		{
+			priorityAccumulator = static_cast<Nz::UInt8>(std::min(priorityAccumulator + priority, 0xFFu));
+		}
+	}
+
+	void MatchClientVisibility::AcknowledgeMatchState(Nz::UInt16 stateTick)
+	{
+		SentMatchState& sentState = m_sentMatchStates[stateTick % m_sentMatchStates.size()];
+		if (!sentState.isValid || sentState.stateTick != stateTick)
+			return; //< unknown, too old or already acknowledged
+
+		// Client acknowledges the last state it received, every older state still pending is considered lost
+		for (SentMatchState& pendingState : m_sentMatchStates)
+		{
+			if (pendingState.isValid && IsMoreRecent(stateTick, pendingState.stateTick))
+				HandleLostMatchState(pendingState);
+		}
+
+		for (const SentMatchState::Entity& entityState : sentState.entities)
+		{
+			auto layerIt = m_layers.find(entityState.layerIndex);
+			if (layerIt == m_layers.end())
+				continue;
+
+			Layer& layer = *layerIt.value();
+			if (!layer.visibleEntityIds.UnboundedTest(entityState.entityId))
+				continue;
+
+			auto& visibleData = layer.visibleEntities[entityState.entityId];
+
+			// Entity may have been recreated with the same id since
+			if (visibleData.generation != entityState.generation)
+				continue;
+
+			if (visibleData.baseline && !IsMoreRecent(stateTick, visibleData.baselineTick))
+				continue;
+
+			visibleData.baseline = entityState.state;
+			visibleData.baselineTick = stateTick;
+		}
+
+		sentState.isValid = false;
+		sentState.entities.clear();
+	}
+
+	std::size_t MatchClientVisibility::EstimateMemoryUsage() const
+	{
+		std::size_t memoryUsage = bw::EstimateMemoryUsage(m_layers) + bw::EstimateMemoryUsage(m_controlledEntities);
+		memoryUsage += bw::EstimateMemoryUsage(m_pendingLayerUpdates) + bw::EstimateMemoryUsage(m_matchStateLayers);
+		memoryUsage += bw::EstimateMemoryUsage(m_priorityMovementData) + bw::EstimateMemoryUsage(m_sortedMovementData) + bw::EstimateMemoryUsage(m_staticMovementData) + bw::EstimateMemoryUsage(m_sentMatchStates);
+		memoryUsage += bw::EstimateMemoryUsage(m_interestCells) + bw::EstimateMemoryUsage(m_sharedPacketKey);
+
+		for (const SentMatchState& sentState : m_sentMatchStates)
+			memoryUsage += bw::EstimateMemoryUsage(sentState.entities);
+
+		memoryUsage += bw::EstimateMemoryUsage(m_layerPool);
+
+		auto AccountPendingPackets = [&](const auto&... pendingPackets)
+		{
+			((memoryUsage += bw::EstimateMemoryUsage(pendingPackets)), ...);
+		};
+		std::apply(AccountPendingPackets, m_pendingEntityPackets);
+		std::apply(AccountPendingPackets, m_pendingEntitiesPackets);
+
+		auto AccountLayer = [&](const Layer* layer)
+		{
+			memoryUsage += sizeof(Layer);
+			memoryUsage += bw::EstimateMemoryUsage(layer->creationEvents) + bw::EstimateMemoryUsage(layer->inputUpdateEvents) + bw::EstimateMemoryUsage(layer->healthUpdateEvents);
+			memoryUsage += bw::EstimateMemoryUsage(layer->staticMovementUpdateEvents) + bw::EstimateMemoryUsage(layer->playAnimationEvents) + bw::EstimateMemoryUsage(layer->physicsEvents);
+			memoryUsage += bw::EstimateMemoryUsage(layer->respawnEvents) + bw::EstimateMemoryUsage(layer->scaleEvents) + bw::EstimateMemoryUsage(layer->weaponEvents);
+			memoryUsage += bw::EstimateMemoryUsage(layer->visibleEntities) + bw::EstimateMemoryUsage(layer->deathEvents) + bw::EstimateMemoryUsage(layer->destructionEvents);
+			memoryUsage += bw::EstimateMemoryUsage(layer->recycleEvents) + bw::EstimateMemoryUsage(layer->recycledEntities) + bw::EstimateMemoryUsage(layer->matchStateEntities);
+			memoryUsage += bw::EstimateMemoryUsage(layer->priorityAccumulators);
+		};
+
+		// Event maps grow with the number of entities a session sees, and are (unlike their content) never shrunk
+		for (auto&& [layerIndex, layer] : m_layers)
+			AccountLayer(layer.get());
+
+		for (const auto& layer : m_layerPool)
+			AccountLayer(layer.get());
+
+		return memoryUsage;
+	}
+
 	void MatchClientVisibility::ResetVisibleEntities()
 	{
 		Nz::UInt16 networkTick = m_match.GetNetworkTick();
 
+		for (SentMatchState& sentState : m_sentMatchStates)
+		{
+			sentState.isValid = false;
+			sentState.entities.clear();
+		}
+
 		m_pendingEvents.Clear();
-		m_pendingEntitiesEvent.clear();
 		m_controlledEntities.clear();
 		m_pendingLayerUpdates.clear();
-		m_multiplePendingEntitiesEvent.clear();
+		std::apply([](auto&... pendingPackets) { (pendingPackets.clear(), ...); }, m_pendingEntityPackets);
+		std::apply([](auto&... pendingPackets) { (pendingPackets.clear(), ...); }, m_pendingEntitiesPackets);
 		m_priorityMovementData.clear();
 
 		for (auto&& [layerIndex, layer] : m_layers)
@@ -34,9 +153,15 @@ namespace bw
 			layer->physicsEvents.clear();
 			layer->scaleEvents.clear();
 			layer->weaponEvents.clear();
+			layer->priorityAccumulators.clear();
 			layer->visibleEntities.clear();
+			layer->visibleEntityIds.Clear();
 			layer->deathEvents.clear();
 			layer->destructionEvents.clear();
+			layer->recycleEvents.clear();
+			layer->recycledEntities.clear();
+			layer->respawnEvents.clear();
+			layer->loadingEntities.clear();
 		}
 
 		Packets::MapReset mapReset;
@@ -60,7 +185,7 @@ namespace bw
 		m_session.SendPacket(mapReset);
 	}
 
-	void MatchClientVisibility::ShowLayer(LayerIndex layerIndex)
+	void MatchClientVisibility::ShowLayer(LayerIndex layerIndex, bool prefetch)
 	{
 		m_newlyHiddenLayers.UnboundedReset(layerIndex);
 
@@ -68,10 +193,22 @@ namespace bw
 		{
 			Layer& layer = *(it.value());
 			layer.visibilityCounter++;
+			if (prefetch)
+				layer.prefetchCounter++;
 		}
 		else
 		{
-			auto& layer = *m_layers.emplace(layerIndex, std::make_unique<Layer>()).first.value();
+			std::unique_ptr<Layer> layerPtr;
+			if (!m_layerPool.empty())
+			{
+				layerPtr = std::move(m_layerPool.back());
+				m_layerPool.pop_back();
+			}
+			else
+				layerPtr = std::make_unique<Layer>();
+
+			auto& layer = *m_layers.emplace(layerIndex, std::move(layerPtr)).first.value();
+			layer.prefetchCounter = (prefetch) ? 1 : 0;
 
 			Terrain& terrain = m_match.GetTerrain();
 			assert(layerIndex < terrain.GetLayerCount());
@@ -90,7 +227,7 @@ namespace bw
 
 			layer.onEntityDeletedSlot.Connect(syncSystem.OnEntityDeleted, [this](NetworkSyncSystem* syncSystem, const NetworkSyncSystem::EntityDestruction& entityDestruction)
 			{
-				HandleEntityRemove(syncSystem->GetLayer().GetLayerIndex(), entityDestruction.entityId, false);
+				HandleEntityRemove(syncSystem->GetLayer().GetLayerIndex(), entityDestruction.entityId, false, entityDestruction.recycled);
 			});
 
 			layer.onEntityInvalidated.Connect(syncSystem.OnEntityInvalidated, [this, layerIndex](NetworkSyncSystem*, const NetworkSyncSystem::EntityMovement& entityMovement)
@@ -101,13 +238,13 @@ namespace bw
 				assert(m_layers.find(layerIndex) != m_layers.end());
 				Layer& layer = *m_layers[layerIndex];
 
-				if (layer.visibleEntities.find(entityMovement.entityId) == layer.visibleEntities.end())
+				if (!layer.visibleEntityIds.UnboundedTest(entityMovement.entityId))
 					return;
 
 				layer.staticMovementUpdateEvents[entityMovement.entityId] = entityMovement;
 			});
 
-			layer.onEntityPlayAnimation.Connect(syncSystem.OnEntityPlayAnimation, [this, layerIndex](NetworkSyncSystem*, const NetworkSyncSystem::EntityPlayAnimation& entityPlayAnimation)
+			layer.onEntitiesPlayAnimation.Connect(syncSystem.OnEntitiesPlayAnimation, [this, layerIndex](NetworkSyncSystem* syncSystem, const NetworkSyncSystem::EntityPlayAnimation* events, std::size_t entityCount)
 			{
 				if (m_ignoreEvents)
 					return;
@@ -115,29 +252,39 @@ namespace bw
 				assert(m_layers.find(layerIndex) != m_layers.end());
 				Layer& layer = *m_layers[layerIndex];
 
-				if (layer.visibleEntities.find(entityPlayAnimation.entityId) == layer.visibleEntities.end())
+				// Most updates concern entities this client doesn't see, check them all at once before looking at each of them
+				if (!layer.visibleEntityIds.Intersects(syncSystem->GetUpdatedEntities(NetworkDirtyFlag::Animation)))
 					return;
 
-				layer.playAnimationEvents[entityPlayAnimation.entityId] = entityPlayAnimation;
-				m_pendingEvents.Set(VisibilityEventType::PlayAnimation);
+				for (std::size_t i = 0; i < entityCount; ++i)
+				{
+					if (!layer.visibleEntityIds.UnboundedTest(events[i].entityId))
+						continue;
+
+					layer.playAnimationEvents[events[i].entityId] = events[i];
+					m_pendingEvents.Set(VisibilityEventType::PlayAnimation);
+				}
 			});
 
 			layer.onEntityDeath.Connect(syncSystem.OnEntityDeath, [this](NetworkSyncSystem* syncSystem, const NetworkSyncSystem::EntityDeath& entityDeath)
 			{
-				HandleEntityRemove(syncSystem->GetLayer().GetLayerIndex(), entityDeath.entityId, true);
+				HandleEntityRemove(syncSystem->GetLayer().GetLayerIndex(), entityDeath.entityId, true, false);
 			});
 
-			layer.onEntitiesHealthUpdate.Connect(syncSystem.OnEntitiesHealthUpdate, [this, layerIndex](NetworkSyncSystem*, const NetworkSyncSystem::EntityHealth* events, std::size_t entityCount)
+			layer.onEntitiesHealthUpdate.Connect(syncSystem.OnEntitiesHealthUpdate, [this, layerIndex](NetworkSyncSystem* syncSystem, const NetworkSyncSystem::EntityHealth* events, std::size_t entityCount)
 			{
 				if (m_ignoreEvents)
 					return;
 
 				assert(m_layers.find(layerIndex) != m_layers.end());
 				Layer& layer = *m_layers[layerIndex];
+
+				if (!layer.visibleEntityIds.Intersects(syncSystem->GetUpdatedEntities(NetworkDirtyFlag::Health)))
+					return;
 				
 				for (std::size_t i = 0; i < entityCount; ++i)
 				{
-					if (layer.visibleEntities.find(events[i].entityId) == layer.visibleEntities.end())
+					if (!layer.visibleEntityIds.UnboundedTest(events[i].entityId))
 						continue;
 
 					layer.healthUpdateEvents[events[i].entityId] = events[i];
@@ -145,7 +292,7 @@ namespace bw
 				}
 			});
 
-			layer.onEntitiesInputUpdate.Connect(syncSystem.OnEntitiesInputUpdate, [this, layerIndex](NetworkSyncSystem*, const NetworkSyncSystem::EntityInputs* events, std::size_t entityCount)
+			layer.onEntitiesInputUpdate.Connect(syncSystem.OnEntitiesInputUpdate, [this, layerIndex](NetworkSyncSystem* syncSystem, const NetworkSyncSystem::EntityInputs* events, std::size_t entityCount)
 			{
 				if (m_ignoreEvents)
 					return;
@@ -153,13 +300,15 @@ namespace bw
 				assert(m_layers.find(layerIndex) != m_layers.end());
 				Layer& layer = *m_layers[layerIndex];
 
+				if (!layer.visibleEntityIds.Intersects(syncSystem->GetUpdatedEntities(NetworkDirtyFlag::Inputs)))
+					return;
+
 				for (std::size_t i = 0; i < entityCount; ++i)
 				{
-					Nz::UInt64 entityKey = Nz::UInt64(layerIndex) << 32 | events[i].entityId;
-					if (m_controlledEntities.find(entityKey) != m_controlledEntities.end())
+					if (IsEntityControlled(layerIndex, events[i].entityId))
 						continue;
 
-					if (layer.visibleEntities.find(events[i].entityId) == layer.visibleEntities.end())
+					if (!layer.visibleEntityIds.UnboundedTest(events[i].entityId))
 						continue;
 
 					layer.inputUpdateEvents[events[i].entityId] = events[i];
@@ -167,7 +316,7 @@ namespace bw
 				}
 			});
 
-			layer.onEntitiesPhysicsUpdate.Connect(syncSystem.OnEntitiesPhysicsUpdate, [this, layerIndex](NetworkSyncSystem*, const NetworkSyncSystem::EntityPhysics* events, std::size_t entityCount)
+			layer.onEntitiesPhysicsUpdate.Connect(syncSystem.OnEntitiesPhysicsUpdate, [this, layerIndex](NetworkSyncSystem* syncSystem, const NetworkSyncSystem::EntityPhysics* events, std::size_t entityCount)
 			{
 				if (m_ignoreEvents)
 					return;
@@ -175,9 +324,12 @@ namespace bw
 				assert(m_layers.find(layerIndex) != m_layers.end());
 				Layer& layer = *m_layers[layerIndex];
 
+				if (!layer.visibleEntityIds.Intersects(syncSystem->GetUpdatedEntities(NetworkDirtyFlag::Physics)))
+					return;
+
 				for (std::size_t i = 0; i < entityCount; ++i)
 				{
-					if (layer.visibleEntities.find(events[i].entityId) == layer.visibleEntities.end())
+					if (!layer.visibleEntityIds.UnboundedTest(events[i].entityId))
 						continue;
 
 					layer.physicsEvents[events[i].entityId] = events[i];
@@ -185,7 +337,7 @@ namespace bw
 				}
 			});
 			
-			layer.onEntitiesScaleUpdate.Connect(syncSystem.OnEntitiesScaleUpdate, [this, layerIndex](NetworkSyncSystem*, const NetworkSyncSystem::EntityScale* events, std::size_t entityCount)
+			layer.onEntitiesScaleUpdate.Connect(syncSystem.OnEntitiesScaleUpdate, [this, layerIndex](NetworkSyncSystem* syncSystem, const NetworkSyncSystem::EntityScale* events, std::size_t entityCount)
 			{
 				if (m_ignoreEvents)
 					return;
@@ -193,9 +345,12 @@ namespace bw
 				assert(m_layers.find(layerIndex) != m_layers.end());
 				Layer& layer = *m_layers[layerIndex];
 
+				if (!layer.visibleEntityIds.Intersects(syncSystem->GetUpdatedEntities(NetworkDirtyFlag::Scale)))
+					return;
+
 				for (std::size_t i = 0; i < entityCount; ++i)
 				{
-					if (layer.visibleEntities.find(events[i].entityId) == layer.visibleEntities.end())
+					if (!layer.visibleEntityIds.UnboundedTest(events[i].entityId))
 						continue;
 
 					layer.scaleEvents[events[i].entityId] = events[i];
@@ -203,7 +358,7 @@ namespace bw
 				}
 			});
 
-			layer.onEntitiesWeaponUpdate.Connect(syncSystem.OnEntitiesWeaponUpdate, [this, layerIndex](NetworkSyncSystem*, const NetworkSyncSystem::EntityWeapon* events, std::size_t entityCount)
+			layer.onEntitiesWeaponUpdate.Connect(syncSystem.OnEntitiesWeaponUpdate, [this, layerIndex](NetworkSyncSystem* syncSystem, const NetworkSyncSystem::EntityWeapon* events, std::size_t entityCount)
 			{
 				if (m_ignoreEvents)
 					return;
@@ -211,9 +366,12 @@ namespace bw
 				assert(m_layers.find(layerIndex) != m_layers.end());
 				Layer& layer = *m_layers[layerIndex];
 
+				if (!layer.visibleEntityIds.Intersects(syncSystem->GetUpdatedEntities(NetworkDirtyFlag::Weapon)))
+					return;
+
 				for (std::size_t i = 0; i < entityCount; ++i)
 				{
-					if (layer.visibleEntities.find(events[i].entityId) == layer.visibleEntities.end())
+					if (!layer.visibleEntityIds.UnboundedTest(events[i].entityId))
 						continue;
 
 					layer.weaponEvents[events[i].entityId] = events[i];
@@ -227,6 +385,8 @@ namespace bw
 
 	void MatchClientVisibility::Update()
 	{
+		bwProfileZone("MatchClientVisibility::Update");
+
 		Nz::UInt16 networkTick = m_match.GetNetworkTick();
 
 		// Handle hidden and shown layers
@@ -266,10 +426,34 @@ namespace bw
 			m_pendingLayerUpdates.clear();
 		}
 
-		if (m_newlyVisibleLayers.GetSize() != 0)
+		// Layers are streamed over several ticks, as sending them at once would stall the reliable channel
+		bool isLoadingLayer = false;
+		for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
+		{
+			Layer& layer = *it.value();
+			if (!layer.loadingEntities.empty() && layer.prefetchCounter < layer.visibilityCounter)
+			{
+				SendLayerChunk(it.key(), layer, networkTick);
+				isLoadingLayer = true;
+			}
+		}
+
+		// Prefetched layers only use the bandwidth left, one of them at a time
+		if (!isLoadingLayer && networkTick % PrefetchedLayerInterval == 0)
 		{
-			PendingCreationEventMap pendingCreationMap; //< Used to resolve parenting
+			for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
+			{
+				Layer& layer = *it.value();
+				if (!layer.loadingEntities.empty())
+				{
+					SendLayerChunk(it.key(), layer, networkTick);
+					break;
+				}
+			}
+		}
 
+		if (m_newlyVisibleLayers.GetSize() != 0)
+		{
 			for (std::size_t i = m_newlyVisibleLayers.FindFirst(); i != m_newlyVisibleLayers.npos; i = m_newlyVisibleLayers.FindNext(i))
 			{
 				LayerIndex layerIndex = LayerIndex(i);
@@ -288,26 +472,22 @@ namespace bw
 				if (m_clientVisibleLayers.UnboundedTest(i))
 				{
 					for (const Ndk::EntityHandle& entity : syncSystem.GetEntities())
-						layer.visibleEntities.emplace(entity->GetId(), Layer::VisibleEntityData{});
+						MarkEntityVisible(layer, entity->GetId());
 
 					continue;
 				}
 
-				Packets::EnableLayer enableLayerPacket;
-				enableLayerPacket.layerIndex = layerIndex;
-				enableLayerPacket.stateTick = networkTick;
-
-				PushLayerEntities(enableLayerPacket.layerEntities, layerIndex, pendingCreationMap);
-
-				m_session.SendPacket(enableLayerPacket);
+				// First chunk enables the layer client-side
+				PrepareLayerLoading(layerIndex, layer);
+				SendLayerChunk(layerIndex, layer, networkTick);
 
 				m_clientVisibleLayers.UnboundedSet(layerIndex);
-
-				pendingCreationMap.clear();
 			}
 			m_newlyVisibleLayers.Clear();
 		}
 
+		UpdateInterestArea();
+
 		// Send packet in fixed order
 		if (m_pendingEvents.Test(VisibilityEventType::Death))
 		{
@@ -345,6 +525,7 @@ namespace bw
 
 			m_deleteEntitiesPacket.entities.clear();
 			m_deleteEntitiesPacket.layers.clear();
+			m_sharedPacketKey.clear();
 
 			for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
 			{
@@ -358,25 +539,115 @@ namespace bw
 				layerData.layerIndex = layerIndex;
 				layerData.entityCount = static_cast<Nz::UInt32>(layer.destructionEvents.size());
 
+				m_sharedPacketKey.push_back((Nz::UInt64(layerIndex) << 32) | layerData.entityCount);
 				for (Nz::UInt32 entityId : layer.destructionEvents)
 				{
 					auto& entityData = m_deleteEntitiesPacket.entities.emplace_back();
 					entityData.id = entityId;
+
+					m_sharedPacketKey.push_back(entityId);
 				}
 				layer.destructionEvents.clear();
 			}
 
-			m_session.SendPacket(m_deleteEntitiesPacket);
+			SendSharedEventPacket(m_deleteEntitiesPacket);
 
 			m_pendingEvents.Clear(VisibilityEventType::Destruction);
 		}
 
+		if (m_pendingEvents.Test(VisibilityEventType::Recycle))
+		{
+			m_recycleEntitiesPacket.stateTick = networkTick;
+
+			m_recycleEntitiesPacket.entities.clear();
+			m_recycleEntitiesPacket.layers.clear();
+
+			for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
+			{
+				auto& layer = *it.value();
+				if (layer.recycleEvents.empty())
+					continue;
+
+				auto& layerData = m_recycleEntitiesPacket.layers.emplace_back();
+				layerData.layerIndex = it.key();
+				layerData.entityCount = static_cast<Nz::UInt32>(layer.recycleEvents.size());
+
+				for (Nz::UInt32 entityId : layer.recycleEvents)
+				{
+					auto& entityData = m_recycleEntitiesPacket.entities.emplace_back();
+					entityData.id = entityId;
+				}
+				layer.recycleEvents.clear();
+			}
+
+			m_session.SendPacket(m_recycleEntitiesPacket);
+
+			m_pendingEvents.Clear(VisibilityEventType::Recycle);
+		}
+
+		if (m_pendingEvents.Test(VisibilityEventType::Respawn))
+		{
+			m_respawnEntitiesPacket.stateTick = networkTick;
+
+			m_respawnEntitiesPacket.entities.clear();
+			m_respawnEntitiesPacket.layers.clear();
+
+			for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
+			{
+				auto& layer = *it.value();
+				if (layer.respawnEvents.empty())
+					continue;
+
+				auto& layerData = m_respawnEntitiesPacket.layers.emplace_back();
+				layerData.layerIndex = it.key();
+				layerData.entityCount = static_cast<Nz::UInt32>(layer.respawnEvents.size());
+
+				for (auto&& [entityId, eventData] : layer.respawnEvents)
+				{
+					auto& entityData = m_respawnEntitiesPacket.entities.emplace_back();
+					entityData.id = entityId;
+					entityData.uniqueId = static_cast<Nz::UInt64>(eventData.uniqueId);
+					entityData.position = eventData.position;
+					entityData.rotation = eventData.rotation;
+
+					if (eventData.healthProperties.has_value())
+						entityData.currentHealth = eventData.healthProperties->currentHealth;
+
+					if (eventData.playerOwner)
+						entityData.ownerPlayerIndex = static_cast<Nz::UInt16>(eventData.playerOwner->GetPlayerIndex());
+
+					if (eventData.physicsProperties.has_value())
+					{
+						const auto& physicsProperties = *eventData.physicsProperties;
+
+						entityData.physicsProperties.emplace();
+						entityData.physicsProperties->angularVelocity = physicsProperties.angularVelocity;
+						entityData.physicsProperties->linearVelocity = physicsProperties.linearVelocity;
+						entityData.physicsProperties->isAsleep = physicsProperties.isSleeping;
+						entityData.physicsProperties->mass = physicsProperties.mass;
+						entityData.physicsProperties->momentOfInertia = physicsProperties.momentOfInertia;
+					}
+
+					entityData.properties = eventData.payload->properties;
+				}
+				layer.respawnEvents.clear();
+			}
+
+			m_session.SendPacket(m_respawnEntitiesPacket);
+
+			m_pendingEvents.Clear(VisibilityEventType::Respawn);
+		}
+
 		if (m_pendingEvents.Test(VisibilityEventType::Creation))
 		{
 			m_createEntitiesPacket.stateTick = networkTick;
 
 			m_createEntitiesPacket.entities.clear();
 			m_createEntitiesPacket.layers.clear();
+			m_sharedPacketKey.clear();
+
+			// Creation events built for this session only (interest area, layer loading) may hold data other sessions don't have
+			bool shareable = true;
 
 			for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
 			{
@@ -386,53 +657,40 @@ namespace bw
 
 				LayerIndex layerIndex = it.key();
 
-				std::function<void(PendingCreationEventMap::iterator it)> PushEntity;
-				PushEntity = [&](PendingCreationEventMap::iterator it)
-				{
-					auto& eventData = it.value();
-					if (!eventData.has_value())
-						return;
+				auto& layerData = m_createEntitiesPacket.layers.emplace_back();
+				layerData.layerIndex = layerIndex;
+				layerData.entityCount = static_cast<Nz::UInt32>(layer.creationEvents.size());
 
-					auto HandleDependentEntity = [&](Nz::UInt32 entityId)
-					{
-						auto dependentIt = layer.creationEvents.find(entityId);
-						if (dependentIt != layer.creationEvents.end() && dependentIt != it)
-							PushEntity(dependentIt);
-					};
+				m_sharedPacketKey.push_back((Nz::UInt64(layerIndex) << 32) | layerData.entityCount);
+				ForEachCreationEventOrdered(layer.creationEvents, [&](const NetworkSyncSystem::EntityCreation& eventData)
+				{
+					if (eventData.eventId == 0)
+						shareable = false;
 
-					if (eventData->parent)
-						HandleDependentEntity(static_cast<Nz::UInt32>(eventData->parent.value()));
+					m_sharedPacketKey.push_back(eventData.entityId);
+					m_sharedPacketKey.push_back(eventData.eventId);
 
-					if (eventData->weapon)
+					if (eventData.weapon)
 					{
 						NetworkSyncSystem::EntityWeapon weaponEvent;
-						weaponEvent.entityId = eventData->entityId;
-						weaponEvent.weaponId = eventData->weapon.value();
+						weaponEvent.entityId = eventData.entityId;
+						weaponEvent.weaponId = eventData.weapon.value();
 
 						layer.weaponEvents[weaponEvent.entityId] = weaponEvent;
 						m_pendingEvents.Set(VisibilityEventType::WeaponUpdate);
 					}
 
-					for (auto&& [layerIndex, entityIndex] : eventData->dependentIds)
-						HandleDependentEntity(static_cast<Nz::UInt32>(entityIndex));
-
 					auto& entityData = m_createEntitiesPacket.entities.emplace_back();
-					entityData.id = eventData->entityId;
-					FillEntityData(eventData.value(), entityData.data);
-
-					eventData.reset();
-				};
-
-				auto& layerData = m_createEntitiesPacket.layers.emplace_back();
-				layerData.layerIndex = layerIndex;
-				layerData.entityCount = static_cast<Nz::UInt32>(layer.creationEvents.size());
-
-				for (auto eventIt = layer.creationEvents.begin(); eventIt != layer.creationEvents.end(); ++eventIt)
-					PushEntity(eventIt);
+					entityData.id = eventData.entityId;
+					FillEntityData(eventData, entityData.data);
+				});
 				layer.creationEvents.clear();
 			}
 
-			m_session.SendPacket(m_createEntitiesPacket);
+			if (shareable)
+				SendSharedEventPacket(m_createEntitiesPacket);
+			else
+				m_session.SendPacket(m_createEntitiesPacket);
 
 			m_pendingEvents.Clear(VisibilityEventType::Creation);
 		}
@@ -441,8 +699,12 @@ namespace bw
 		{
 			m_healthUpdatePacket.stateTick = networkTick;
 
+			if (const auto& stateQuantization = m_match.GetSettings().stateQuantization)
+				m_healthUpdatePacket.healthStep = stateQuantization->healthStep;
+
 			m_healthUpdatePacket.entities.clear();
 			m_healthUpdatePacket.layers.clear();
+			m_sharedPacketKey.clear();
 
 			for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
 			{
@@ -456,6 +718,7 @@ namespace bw
 				layerData.layerIndex = layerIndex;
 				layerData.entityCount = static_cast<Nz::UInt32>(layer.healthUpdateEvents.size());
 
+				m_sharedPacketKey.push_back((Nz::UInt64(layerIndex) << 32) | layerData.entityCount);
 				for (auto&& pair : layer.healthUpdateEvents)
 				{
 					auto& eventData = pair.second;
@@ -463,11 +726,13 @@ namespace bw
 					auto& entityData = m_healthUpdatePacket.entities.emplace_back();
 					entityData.id = pair.first;
 					entityData.currentHealth = eventData.currentHealth;
+
+					m_sharedPacketKey.push_back((Nz::UInt64(pair.first) << 32) | eventData.currentHealth);
 				}
 				layer.healthUpdateEvents.clear();
 			}
 
-			m_session.SendPacket(m_healthUpdatePacket);
+			SendSharedEventPacket(m_healthUpdatePacket);
 
 			m_pendingEvents.Clear(VisibilityEventType::HealthUpdate);
 		}
@@ -513,6 +778,7 @@ namespace bw
 
 			m_entitiesAnimationPacket.entities.clear();
 			m_entitiesAnimationPacket.layers.clear();
+			m_sharedPacketKey.clear();
 
 			for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
 			{
@@ -526,6 +792,7 @@ namespace bw
 				layerData.layerIndex = layerIndex;
 				layerData.entityCount = static_cast<Nz::UInt32>(layer.playAnimationEvents.size());
 
+				m_sharedPacketKey.push_back((Nz::UInt64(layerIndex) << 32) | layerData.entityCount);
 				for (auto&& pair : layer.playAnimationEvents)
 				{
 					auto& eventData = pair.second;
@@ -533,17 +800,24 @@ namespace bw
 					auto& entityData = m_entitiesAnimationPacket.entities.emplace_back();
 					entityData.entityId = pair.first;
 					entityData.animId = static_cast<Nz::UInt8>(eventData.animId);
+
+					m_sharedPacketKey.push_back((Nz::UInt64(pair.first) << 32) | entityData.animId);
 				}
 				layer.playAnimationEvents.clear();
 			}
 
-			m_session.SendPacket(m_entitiesAnimationPacket);
+			SendSharedEventPacket(m_entitiesAnimationPacket);
 
 			m_pendingEvents.Clear(VisibilityEventType::PlayAnimation);
 		}
 
 		if (m_pendingEvents.Test(VisibilityEventType::PhysicsUpdate))
 		{
+			m_physicsUpdatePacket.stateTick = networkTick;
+
+			m_physicsUpdatePacket.entities.clear();
+			m_physicsUpdatePacket.layers.clear();
+
 			for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
 			{
 				auto& layer = *it.value();
@@ -552,34 +826,36 @@ namespace bw
 
 				LayerIndex layerIndex = it.key();
 
+				auto& layerData = m_physicsUpdatePacket.layers.emplace_back();
+				layerData.layerIndex = layerIndex;
+				layerData.entityCount = static_cast<Nz::UInt32>(layer.physicsEvents.size());
+
 				for (auto&& pair : layer.physicsEvents)
 				{
-					Packets::EntityPhysics physicsPacket;
-					physicsPacket.entityId.layerId = layerIndex;
-					physicsPacket.entityId.entityId = pair.first;
-					physicsPacket.stateTick = networkTick;
-
 					auto& physicsData = pair.second;
-					physicsPacket.asleep = physicsData.isAsleep;
-					physicsPacket.mass = physicsData.mass;
-					physicsPacket.momentOfInertia = physicsData.momentOfInertia;
-					
+
+					auto& entityData = m_physicsUpdatePacket.entities.emplace_back();
+					entityData.id = pair.first;
+					entityData.asleep = physicsData.isAsleep;
+					entityData.mass = physicsData.mass;
+					entityData.momentOfInertia = physicsData.momentOfInertia;
+
 					if (physicsData.playerMovement)
 					{
 						const auto& playerMovementData = physicsData.playerMovement.value();
 
-						auto& packetMovement = physicsPacket.playerMovement.emplace();
+						auto& packetMovement = entityData.playerMovement.emplace();
 						packetMovement.jumpHeight = playerMovementData.jumpHeight;
 						packetMovement.jumpHeightBoost = playerMovementData.jumpHeightBoost;
 						packetMovement.movementSpeed = playerMovementData.movementSpeed;
 					}
-
-					m_session.SendPacket(physicsPacket);
 				}
 
 				layer.physicsEvents.clear();
 			}
 
+			m_session.SendPacket(m_physicsUpdatePacket);
+
 			m_pendingEvents.Clear(VisibilityEventType::PhysicsUpdate);
 		}
 
@@ -619,6 +895,11 @@ namespace bw
 
 		if (m_pendingEvents.Test(VisibilityEventType::WeaponUpdate))
 		{
+			m_weaponUpdatePacket.stateTick = networkTick;
+
+			m_weaponUpdatePacket.entities.clear();
+			m_weaponUpdatePacket.layers.clear();
+
 			for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
 			{
 				auto& layer = *it.value();
@@ -627,83 +908,34 @@ namespace bw
 
 				LayerIndex layerIndex = it.key();
 
+				auto& layerData = m_weaponUpdatePacket.layers.emplace_back();
+				layerData.layerIndex = layerIndex;
+				layerData.entityCount = static_cast<Nz::UInt32>(layer.weaponEvents.size());
+
 				for (auto&& pair : layer.weaponEvents)
 				{
-					Packets::EntityWeapon weaponPacket;
-					weaponPacket.entityId.layerId = layerIndex;
-					weaponPacket.entityId.entityId = pair.first;
-					weaponPacket.stateTick = networkTick;
-
 					auto& weaponData = pair.second;
-					weaponPacket.weaponEntityId = (weaponData.weaponId.has_value()) ? weaponData.weaponId.value() : Packets::EntityWeapon::NoWeapon;
 
-					m_session.SendPacket(weaponPacket);
+					auto& entityData = m_weaponUpdatePacket.entities.emplace_back();
+					entityData.id = pair.first;
+					entityData.weaponEntityId = (weaponData.weaponId.has_value()) ? weaponData.weaponId.value() : Packets::EntitiesWeapon::NoWeapon;
 				}
 
 				layer.weaponEvents.clear();
 			}
 
+			m_session.SendPacket(m_weaponUpdatePacket);
+
 			m_pendingEvents.Clear(VisibilityEventType::WeaponUpdate);
 		}
 
-		if (!m_layers.empty())
+		// Under heavy load, only send snapshots every other tick (entities events are still sent every tick)
+		bool reduceNetworkRate = (m_match.GetLoadLevel() >= SharedMatch::LoadLevel::ReduceNetworkRate && (m_match.GetCurrentTick() % 2) != 0);
+		if (!m_layers.empty() && !reduceNetworkRate)
 			SendMatchState();
 
-		for (auto it = m_pendingEntitiesEvent.begin(); it != m_pendingEntitiesEvent.end();)
-		{
-			LayerIndex layerId = LayerIndex(it.key() >> 32);
-			Nz::UInt32 entityId = Nz::UInt32(it.key() & 0xFFFFFFFF);
-
-			if (m_layers.find(layerId) == m_layers.end())
-			{
-				// If a pending event is related to a layer which is no longer visible, drop it
-				it = m_pendingEntitiesEvent.erase(it);
-				continue;
-			}
-			Layer& layer = *m_layers[layerId];
-
-			if (layer.visibleEntities.find(entityId) != layer.visibleEntities.end())
-			{
-				auto& callbackVec = it.value();
-				for (auto&& func : callbackVec)
-					func();
-
-				it = m_pendingEntitiesEvent.erase(it);
-			}
-			else
-				++it;
-		}
-
-		for (auto it = m_multiplePendingEntitiesEvent.begin(); it != m_multiplePendingEntitiesEvent.end();)
-		{
-			if (m_layers.find(it->layerIndex) == m_layers.end())
-			{
-				// If a pending event is related to a layer which is no longer visible, drop it
-				it = m_multiplePendingEntitiesEvent.erase(it);
-				continue;
-			}
-
-			Layer& layer = *m_layers[it->layerIndex];
-
-			bool allEntitiesVisible = true;
-			for (std::size_t i = it->entitiesId.FindFirst(); i != it->entitiesId.npos; i = it->entitiesId.FindNext(i))
-			{
-				if (layer.visibleEntities.find(Nz::UInt32(i)) == layer.visibleEntities.end())
-				{
-					allEntitiesVisible = false;
-					break;
-				}
-			}
-
-			if (allEntitiesVisible)
-			{
-				it->sendFunction();
-
-				it = m_multiplePendingEntitiesEvent.erase(it);
-			}
-			else
-				++it;
-		}
+		std::apply([&](auto&... pendingPackets) { (FlushPendingPackets(pendingPackets), ...); }, m_pendingEntityPackets);
+		std::apply([&](auto&... pendingPackets) { (FlushPendingPackets(pendingPackets), ...); }, m_pendingEntitiesPackets);
 	}
 
 	void MatchClientVisibility::HandleEntityCreation(LayerIndex layerIndex, const NetworkSyncSystem::EntityCreation& eventData)
@@ -714,13 +946,31 @@ namespace bw
 
 		assert(m_layers.find(layerIndex) != m_layers.end());
 		Layer& layer = *m_layers[layerIndex];
-		layer.creationEvents[eventData.entityId] = eventData;
-		layer.visibleEntities.emplace(eventData.entityId, Layer::VisibleEntityData{});
 
-		m_pendingEvents.Set(VisibilityEventType::Creation);
+		// Entities created while their layer is loading are sent with the next chunk (which also sends their dependencies)
+		if (!layer.loadingEntities.empty())
+		{
+			layer.loadingEntities.push_back(eventData.entityId);
+			return;
+		}
+
+		// Respawned entities the client still has in store only need to be moved and re-enabled
+		bool wasRecycled = layer.recycledEntities.erase(eventData.entityId) > 0;
+		if (wasRecycled && eventData.respawned)
+		{
+			layer.respawnEvents.insert_or_assign(eventData.entityId, eventData);
+			m_pendingEvents.Set(VisibilityEventType::Respawn);
+		}
+		else
+		{
+			layer.creationEvents[eventData.entityId] = eventData;
+			m_pendingEvents.Set(VisibilityEventType::Creation);
+		}
+
+		MarkEntityVisible(layer, eventData.entityId);
 	}
 
-	void MatchClientVisibility::HandleEntityRemove(LayerIndex layerIndex, Ndk::EntityId entityId, bool deathEvent)
+	void MatchClientVisibility::HandleEntityRemove(LayerIndex layerIndex, Ndk::EntityId entityId, bool deathEvent, bool recycled)
 	{
 		assert(m_layers.find(layerIndex) != m_layers.end());
 		Layer& layer = *m_layers[layerIndex];
@@ -729,6 +979,14 @@ namespace bw
 		auto it = layer.creationEvents.find(entityId);
 		if (it != layer.creationEvents.end())
 			layer.creationEvents.erase(it);
+		else if (layer.respawnEvents.erase(entityId) > 0)
+		{
+			// Respawn wasn't sent yet so the client still holds the entity in store, it will be dropped when its id gets reused
+			if (recycled)
+				layer.recycledEntities.insert(entityId);
+		}
+		else if (!layer.visibleEntityIds.UnboundedTest(entityId))
+			return; //< Entity is outside of the interest area (or its layer is about to be sent)
 		else
 		{
 			if (m_ignoreEvents)
@@ -739,6 +997,12 @@ namespace bw
 				layer.deathEvents.insert(entityId);
 				m_pendingEvents.Set(VisibilityEventType::Death);
 			}
+			else if (recycled)
+			{
+				layer.recycleEvents.insert(entityId);
+				layer.recycledEntities.insert(entityId);
+				m_pendingEvents.Set(VisibilityEventType::Recycle);
+			}
 			else
 			{
 				layer.destructionEvents.insert(entityId);
@@ -746,18 +1010,112 @@ namespace bw
 			}
 		}
 
-		Nz::UInt64 entityKey = Nz::UInt64(layerIndex) << 32 | entityId;
-		m_controlledEntities.erase(entityKey);
+		SetEntityControlledStatus(layerIndex, entityId, false);
 
 		layer.inputUpdateEvents.erase(entityId);
 		layer.healthUpdateEvents.erase(entityId);
 		layer.physicsEvents.erase(entityId);
 		layer.playAnimationEvents.erase(entityId);
+		layer.scaleEvents.erase(entityId);
 		layer.staticMovementUpdateEvents.erase(entityId);
-		layer.visibleEntities.erase(entityId);
+		layer.visibleEntityIds.UnboundedReset(entityId);
 		layer.weaponEvents.erase(entityId);
 	}
 
+	void MatchClientVisibility::HandleLostMatchState(SentMatchState& sentState)
+	{
+		for (const SentMatchState::Entity& entityState : sentState.entities)
+		{
+			auto layerIt = m_layers.find(entityState.layerIndex);
+			if (layerIt == m_layers.end())
+				continue;
+
+			Layer& layer = *layerIt.value();
+			if (!layer.visibleEntityIds.UnboundedTest(entityState.entityId))
+				continue;
+
+			const auto& visibleData = layer.visibleEntities[entityState.entityId];
+
+			// Nothing to reinstate if the entity was recreated or sent again since
+			if (visibleData.generation != entityState.generation || visibleData.lastSentTick != sentState.stateTick)
+				continue;
+
+			Nz::UInt8& priorityAccumulator = layer.priorityAccumulators[entityState.entityId];
+			priorityAccumulator = static_cast<Nz::UInt8>(std::min(priorityAccumulator + entityState.priorityAccumulator, 0xFF));
+
+			// A newer static update may have been registered in the meantime
+			if (entityState.staticMovement)
+				layer.staticMovementUpdateEvents.emplace(entityState.entityId, *entityState.staticMovement);
+		}
+
+		sentState.isValid = false;
+		sentState.entities.clear();
+	}
+
+	void MatchClientVisibility::PrepareLayerLoading(LayerIndex layerIndex, Layer& layer)
+	{
+		Ndk::World& world = m_match.GetTerrain().GetLayer(layerIndex).GetWorld();
+		NetworkSyncSystem& syncSystem = world.GetSystem<NetworkSyncSystem>();
+
+		// Entities nearest to the ones controlled by the client are sent first
+		std::vector<Nz::Vector2f> focusPositions;
+		if (layerIndex < m_controlledEntities.size())
+		{
+			const Nz::Bitset<Nz::UInt64>& controlledEntities = m_controlledEntities[layerIndex];
+			for (std::size_t entityId = controlledEntities.FindFirst(); entityId != controlledEntities.npos; entityId = controlledEntities.FindNext(entityId))
+			{
+				if (world.IsEntityIdValid(static_cast<Ndk::EntityId>(entityId)))
+					focusPositions.push_back(GetEntityPosition(world.GetEntity(static_cast<Ndk::EntityId>(entityId))));
+			}
+		}
+
+		std::vector<std::pair<float /*squaredDistance*/, Nz::UInt32 /*entityId*/>> entities;
+		for (const Ndk::EntityHandle& entity : syncSystem.GetEntities())
+		{
+			float squaredDistance = 0.f;
+			if (!focusPositions.empty())
+			{
+				Nz::Vector2f position = GetEntityPosition(entity);
+
+				squaredDistance = std::numeric_limits<float>::infinity();
+				for (const Nz::Vector2f& focusPosition : focusPositions)
+					squaredDistance = std::min(squaredDistance, position.SquaredDistance(focusPosition));
+			}
+
+			entities.emplace_back(squaredDistance, static_cast<Nz::UInt32>(entity->GetId()));
+		}
+
+		// Chunks are taken from the back
+		std::sort(entities.begin(), entities.end(), [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+		layer.loadingEntities.clear();
+		for (auto&& [squaredDistance, entityId] : entities)
+			layer.loadingEntities.push_back(entityId);
+	}
+
+	template<typename E>
+	void MatchClientVisibility::PushCreationEvents(std::vector<E>& packetEntities, Layer& layer, PendingCreationEventMap& pendingCreationMap)
+	{
+		ForEachCreationEventOrdered(pendingCreationMap, [&](const NetworkSyncSystem::EntityCreation& eventData)
+		{
+			if (eventData.weapon)
+			{
+				NetworkSyncSystem::EntityWeapon weaponEvent;
+				weaponEvent.entityId = eventData.entityId;
+				weaponEvent.weaponId = eventData.weapon.value();
+
+				layer.weaponEvents[weaponEvent.entityId] = weaponEvent;
+				m_pendingEvents.Set(VisibilityEventType::WeaponUpdate);
+			}
+
+			auto& entityData = packetEntities.emplace_back();
+			entityData.id = eventData.entityId;
+			FillEntityData(eventData, entityData.data);
+
+			MarkEntityVisible(layer, eventData.entityId);
+		});
+	}
+
 	template<typename E>
 	void MatchClientVisibility::PushLayerEntities(std::vector<E>& packetEntities, LayerIndex layerIndex, PendingCreationEventMap& pendingCreationMap)
 	{
@@ -775,204 +1133,364 @@ namespace bw
 		{
 			for (std::size_t i = 0; i < entityCount; ++i)
 			{
-				if (layer.visibleEntities.find(entitiesCreation[i].entityId) == layer.visibleEntities.end())
+				if (!layer.visibleEntityIds.UnboundedTest(entitiesCreation[i].entityId))
 					pendingCreationMap[entitiesCreation[i].entityId] = entitiesCreation[i];
 			}
 		});
 
-		std::function<void(PendingCreationEventMap::iterator it)> PushEntity;
-		PushEntity = [&](PendingCreationEventMap::iterator it)
+		PushCreationEvents(packetEntities, layer, pendingCreationMap);
+	}
+
+	void MatchClientVisibility::ReleaseLayer(std::unique_ptr<Layer> layer)
+	{
+		layer->onEntityCreatedSlot.Disconnect();
+		layer->onEntityDeath.Disconnect();
+		layer->onEntityDeletedSlot.Disconnect();
+		layer->onEntityInvalidated.Disconnect();
+		layer->onEntitiesHealthUpdate.Disconnect();
+		layer->onEntitiesInputUpdate.Disconnect();
+		layer->onEntitiesPhysicsUpdate.Disconnect();
+		layer->onEntitiesPlayAnimation.Disconnect();
+		layer->onEntitiesScaleUpdate.Disconnect();
+		layer->onEntitiesWeaponUpdate.Disconnect();
+
+		// Containers are cleared but keep their buckets, so showing a layer again doesn't have to grow them back
+		layer->prefetchCounter = 0;
+		layer->visibilityCounter = 1;
+		layer->creationEvents.clear();
+		layer->inputUpdateEvents.clear();
+		layer->healthUpdateEvents.clear();
+		layer->staticMovementUpdateEvents.clear();
+		layer->playAnimationEvents.clear();
+		layer->physicsEvents.clear();
+		layer->respawnEvents.clear();
+		layer->scaleEvents.clear();
+		layer->weaponEvents.clear();
+		layer->priorityAccumulators.clear();
+		layer->visibleEntities.clear();
+		layer->visibleEntityIds.Clear();
+		layer->deathEvents.clear();
+		layer->destructionEvents.clear();
+		layer->recycleEvents.clear();
+		layer->recycledEntities.clear();
+		layer->matchStateEntities.clear();
+		layer->loadingEntities.clear();
+
+		m_layerPool.push_back(std::move(layer));
+	}
+
+	void MatchClientVisibility::SendLayerChunk(LayerIndex layerIndex, Layer& layer, Nz::UInt16 networkTick)
+	{
+		Ndk::World& world = m_match.GetTerrain().GetLayer(layerIndex).GetWorld();
+		NetworkSyncSystem& syncSystem = world.GetSystem<NetworkSyncSystem>();
+
+		PendingCreationEventMap pendingCreationMap;
+
+		// Entities may have been destroyed, or sent by another event, since the layer started loading
+		auto QueueEntity = [&](Nz::UInt32 entityId)
 		{
-			auto& entityId = it.key();
-			auto& eventData = it.value();
-			if (!eventData.has_value())
-				return;
+			if (!world.IsEntityIdValid(entityId))
+				return false;
 
-			auto HandleDependentEntity = [&](Nz::UInt32 entityId)
-			{
-				auto dependentIt = pendingCreationMap.find(entityId);
-				if (dependentIt != pendingCreationMap.end() && dependentIt != it)
-					PushEntity(dependentIt);
-			};
+			if (layer.visibleEntityIds.UnboundedTest(entityId) || layer.creationEvents.find(entityId) != layer.creationEvents.end())
+				return false;
 
-			if (eventData->parent)
-				HandleDependentEntity(static_cast<Nz::UInt32>(eventData->parent.value()));
+			if (pendingCreationMap.find(entityId) != pendingCreationMap.end())
+				return false;
 
-			if (eventData->weapon)
+			const Ndk::EntityHandle& entity = world.GetEntity(entityId);
+			if (!syncSystem.GetEntities().Has(entity))
+				return false;
+
+			syncSystem.BuildCreationEvent(pendingCreationMap[entityId].emplace(), entity);
+			return true;
+		};
+
+		// Entities a chunk entity depends on (parent, referenced entities) are sent with it
+		std::vector<Nz::UInt32> entityIds;
+		std::size_t entityCount = 0;
+		while (entityCount < LayerChunkEntityCount && !layer.loadingEntities.empty())
+		{
+			entityIds.push_back(layer.loadingEntities.back());
+			layer.loadingEntities.pop_back();
+
+			while (!entityIds.empty())
 			{
-				NetworkSyncSystem::EntityWeapon weaponEvent;
-				weaponEvent.entityId = eventData->entityId;
-				weaponEvent.weaponId = eventData->weapon.value();
+				Nz::UInt32 entityId = entityIds.back();
+				entityIds.pop_back();
 
-				layer.weaponEvents[weaponEvent.entityId] = weaponEvent;
-				m_pendingEvents.Set(VisibilityEventType::WeaponUpdate);
-			}
+				if (!QueueEntity(entityId))
+					continue;
 
-			for (auto&& [layerIndex, entityIndex] : eventData->dependentIds)
-				HandleDependentEntity(static_cast<Nz::UInt32>(entityIndex));
+				entityCount++;
 
-			auto& entityData = packetEntities.emplace_back();
-			entityData.id = eventData->entityId;
-			FillEntityData(eventData.value(), entityData.data);
+				const NetworkSyncSystem::EntityCreation& creationEvent = *pendingCreationMap[entityId];
+				if (creationEvent.parent)
+					entityIds.push_back(static_cast<Nz::UInt32>(creationEvent.parent.value()));
 
-			layer.visibleEntities.emplace(entityId, Layer::VisibleEntityData{});
+				for (auto&& [dependentLayerIndex, dependentId] : creationEvent.dependentIds)
+				{
+					if (dependentLayerIndex == layerIndex)
+						entityIds.push_back(static_cast<Nz::UInt32>(dependentId));
+				}
+			}
+		}
 
-			eventData.reset();
-		};
+		Packets::EnableLayer enableLayerPacket;
+		enableLayerPacket.layerIndex = layerIndex;
+		enableLayerPacket.remainingEntityCount = static_cast<Nz::UInt32>(layer.loadingEntities.size());
+		enableLayerPacket.stateTick = networkTick;
 
-		for (auto it = pendingCreationMap.begin(); it != pendingCreationMap.end(); ++it)
-			PushEntity(it);
+		PushCreationEvents(enableLayerPacket.layerEntities, layer, pendingCreationMap);
+
+		m_session.SendPacket(enableLayerPacket);
 	}
 
 	void MatchClientVisibility::SendMatchState()
 	{
 		constexpr std::size_t MaxPacketSize = Nz::ENetConstants::ENetHost_DefaultMTU - sizeof(Nz::ENetProtocolHeader) - sizeof(Nz::ENetProtocolSendFragment);
 
-		auto HasExceededPacketSize = [&]() -> bool
-		{
-			std::size_t size = Packets::EstimateSize(m_matchStatePacket);
-			return size > MaxPacketSize;
-		};
-
 		Terrain& terrain = m_match.GetTerrain();
 
 		m_priorityMovementData.clear();
-		auto PushMovementData = [this](LayerIndex layerIndex, Nz::UInt8 priorityAccumulator, const NetworkSyncSystem::EntityMovement& movementData, bool isStatic)
-		{
-			m_priorityMovementData.push_back(PriorityMovementData{
-				priorityAccumulator,
-				layerIndex,
-				movementData,
-				isStatic
-			});
-		};
+		m_staticMovementData.clear();
+
+		Nz::UInt16 networkTick = m_match.GetNetworkTick();
+		float tickDuration = m_match.GetTickDuration();
+
+		const auto& movementSync = m_match.GetSettings().movementSync;
+		float maxExtrapolationError = (movementSync) ? movementSync->extrapolationPositionError : 0.f;
 
 		for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
 		{
 			LayerIndex layerIndex = it.key();
 			auto& layer = *it.value();
 
+			TerrainLayer& terrainLayer = terrain.GetLayer(layerIndex);
+			Ndk::World& world = terrainLayer.GetWorld();
+
 			for (auto&& pair : layer.staticMovementUpdateEvents)
 			{
-				auto visibleIt = layer.visibleEntities.find(pair.first);
-				assert(visibleIt != layer.visibleEntities.end());
+				assert(layer.visibleEntityIds.UnboundedTest(pair.first));
+
+				// Static entities rarely move, each of their updates is worth more than a regular movement update
+				const Ndk::EntityHandle& entity = world.GetEntity(pair.first);
+				Nz::UInt8 priority = (entity) ? entity->GetComponent<NetworkSyncComponent>().GetSettings().priority : 1;
+
+				Nz::UInt8& priorityAccumulator = layer.priorityAccumulators[pair.first];
+				IncreasePriority(priorityAccumulator, priority * 3U);
+
+				m_priorityMovementData.push_back(PriorityMovementData{
+					priorityAccumulator,
+					layerIndex,
+					&layer,
+					nullptr,
+					m_staticMovementData.size(),
+					pair.first,
+					true
+				});
+
+				m_staticMovementData.push_back(pair.second);
+			}
 
-				auto& visibleData = visibleIt.value();
-				visibleData.priorityAccumulator += 3; //< TODO use NetworkSyncComponent value
+			// Static updates are only removed once sent, so the ones which didn't fit this packet are kept for the next one
 
-				PushMovementData(layerIndex, visibleData.priorityAccumulator, pair.second, true);
-			}
+			// Prefetched layers aren't displayed, their entities only have to be roughly in place when the player gets there
+			if (layer.prefetchCounter == layer.visibilityCounter && networkTick % PrefetchedLayerInterval != 0)
+				continue;
 
-			layer.staticMovementUpdateEvents.clear();
+			const NetworkSyncSystem& syncSystem = world.GetSystem<NetworkSyncSystem>();
 
-			TerrainLayer& terrainLayer = terrain.GetLayer(layerIndex);
-			const NetworkSyncSystem& syncSystem = terrainLayer.GetWorld().GetSystem<NetworkSyncSystem>();
+			const Nz::Bitset<Nz::UInt64>* controlledEntities = (layerIndex < m_controlledEntities.size()) ? &m_controlledEntities[layerIndex] : nullptr;
+			Nz::Vector2f gravity = world.GetSystem<Ndk::PhysicsSystem2D>().GetGravity();
 
-			syncSystem.MoveEntities([&](const NetworkSyncSystem::EntityMovement* entitiesMovement, std::size_t entityCount)
+			// Shared by all sessions, only the entity ids are read until the entity is picked for the packet
+			const NetworkSyncSystem::MovementSnapshot& movementSnapshot = syncSystem.GetMovementSnapshot();
+			for (std::size_t i = 0; i < movementSnapshot.GetEntityCount(); ++i)
 			{
-				for (std::size_t i = 0; i < entityCount; ++i)
-				{
-					auto& movementData = entitiesMovement[i];
+				Ndk::EntityId entityId = movementSnapshot.entityIds[i];
+				if (!layer.visibleEntityIds.UnboundedTest(entityId))
+					continue;
 
-					auto visibleIt = layer.visibleEntities.find(movementData.entityId);
-					if (visibleIt == layer.visibleEntities.end())
+				Nz::UInt8& priorityAccumulator = layer.priorityAccumulators[entityId];
+				if (controlledEntities && controlledEntities->UnboundedTest(entityId))
+				{
+					//FIXME
+					priorityAccumulator = 0xFF;
+				}
+				else
+				{
+					// Entities with a maximum update rate don't compete until enough time went by since the last one this client got
+					Nz::UInt16 updateInterval = movementSnapshot.updateIntervals[i];
+					if (updateInterval > 1 && Nz::UInt16(networkTick - layer.visibleEntities[entityId].lastSentTick) < updateInterval)
 						continue;
 
-					auto& visibleData = visibleIt.value();
-					Nz::UInt64 entityKey = Nz::UInt64(layerIndex) << 32 | movementData.entityId;
-					if (m_controlledEntities.find(entityKey) != m_controlledEntities.end())
+					// Clients keep simulating bodies from the last state they got, ballistic ones don't need to be sent as long as this stays accurate
+					const auto& visibleData = layer.visibleEntities[entityId];
+					if (maxExtrapolationError > 0.f && visibleData.baseline && (movementSnapshot.flags[i] & NetworkSyncSystem::MovementSnapshot::HasPlayerMovement) == 0)
 					{
-						//FIXME
-						visibleData.priorityAccumulator = 0xFF;
+						Nz::UInt16 baselineAge = networkTick - visibleData.baselineTick;
+						if (baselineAge <= Packets::MatchState::MaxBaselineAge)
+						{
+							const EntityState& baseline = visibleData.baseline.value();
+							float elapsedTime = baselineAge * tickDuration;
+
+							Nz::Vector2f extrapolatedPosition = baseline.position + baseline.linearVelocity * elapsedTime + gravity * (0.5f * elapsedTime * elapsedTime);
+							float extrapolatedRotation = baseline.rotation.value + baseline.angularVelocity.value * elapsedTime;
+							float rotationError = std::remainder(extrapolatedRotation - movementSnapshot.rotations[i].value, 2.f * float(M_PI));
+
+							if (extrapolatedPosition.SquaredDistance(movementSnapshot.positions[i]) <= maxExtrapolationError * maxExtrapolationError &&
+							    std::abs(rotationError) <= movementSync->extrapolationRotationError)
+								continue;
+						}
 					}
-					else
-						visibleData.priorityAccumulator += 1; //< TODO use NetworkSyncComponent value
 
-					PushMovementData(layerIndex, visibleData.priorityAccumulator, movementData, false);
+					IncreasePriority(priorityAccumulator, movementSnapshot.priorities[i]);
 				}
-			});
+
+				m_priorityMovementData.push_back(PriorityMovementData{
+					priorityAccumulator,
+					layerIndex,
+					&layer,
+					&movementSnapshot,
+					i,
+					entityId,
+					false
+				});
+			}
 		}
 
-		std::sort(m_priorityMovementData.begin(), m_priorityMovementData.end(), [](const PriorityMovementData& lhs, const PriorityMovementData& rhs)
+		// Priorities are bytes, a counting sort (highest first) is linear and doesn't compare anything
+		std::array<std::size_t, 256> priorityOffsets = {};
+		for (const PriorityMovementData& movementData : m_priorityMovementData)
+			priorityOffsets[movementData.priorityAccumulator]++;
+
+		std::size_t offset = 0;
+		for (std::size_t i = priorityOffsets.size(); i-- > 0;)
 		{
-			return lhs.priorityAccumulator > rhs.priorityAccumulator;
-		});
+			std::size_t count = priorityOffsets[i];
+			priorityOffsets[i] = offset;
+			offset += count;
+		}
+
+		m_sortedMovementData.resize(m_priorityMovementData.size());
+		for (const PriorityMovementData& movementData : m_priorityMovementData)
+			m_sortedMovementData[priorityOffsets[movementData.priorityAccumulator]++] = movementData;
+
+		std::swap(m_priorityMovementData, m_sortedMovementData);
 
 		m_matchStatePacket.entities.clear();
 		m_matchStatePacket.layers.clear();
 		m_matchStatePacket.stateTick = m_match.GetNetworkTick();
 		m_matchStatePacket.lastInputTick = m_session.GetLastInputTick();
+		m_matchStatePacket.isQuantized = m_match.GetStateQuantizer().has_value() && m_session.HasProtocolFeature(ProtocolFeature::StateQuantization);
+
+		Nz::UInt16 stateTick = m_matchStatePacket.stateTick;
+
+		// Pick entities by priority while keeping track of the packet size, entities are grouped by layer in the packet
+		std::size_t packetSize = Packets::EstimateHeaderSize(m_matchStatePacket);
+		std::size_t propertyBitCount = 1; //< quantization bit
+		std::size_t layerHeaderSize = Packets::EstimateSize(Packets::MatchState::Layer{});
+
+		// Limit packet size to what's left of the session bandwidth budget for this tick
+		std::size_t availableBandwidth = m_session.GetAvailableBandwidth();
+		bool isBudgetLimited = availableBandwidth < MaxPacketSize;
+		std::size_t maxPacketSize = std::min(MaxPacketSize, availableBandwidth);
+		if (packetSize + (propertyBitCount + 7) / 8 > maxPacketSize)
+			return; //< Entities priority will keep growing until next tick
+
+		// Remember what the client will know once it has received this packet, to be used as a baseline when acknowledged (or reinstated when lost)
+		SentMatchState& sentState = m_sentMatchStates[stateTick % m_sentMatchStates.size()];
+		if (sentState.isValid)
+			HandleLostMatchState(sentState); //< Never acknowledged
+
+		sentState.isValid = true;
+		sentState.stateTick = stateTick;
+
+		m_matchStateLayers.clear();
 
 		std::size_t handledEntities = 0;
 		for (PriorityMovementData& movementData : m_priorityMovementData)
 		{
-			std::size_t entityIndex = 0;
+			Layer& layer = *movementData.layer;
 
-			LayerIndex layerIndex = 0;
-			std::size_t layerCount = m_matchStatePacket.layers.size();
-			for (; layerIndex < layerCount; ++layerIndex)
-			{
-				auto& layer = m_matchStatePacket.layers[layerIndex];
-				entityIndex += layer.entityCount;
+			Packets::MatchState::Entity entityData;
+			if (movementData.staticEntity)
+				BuildMovementPacket(entityData, m_staticMovementData[movementData.movementIndex], layer, stateTick);
+			else
+				BuildMovementPacket(entityData, *movementData.snapshot, movementData.movementIndex, layer, stateTick);
 
-				if (layer.layerIndex == movementData.layerIndex)
-				{
-					layer.entityCount++;
-					break;
-				}
-			}
+			std::size_t entityBitCount = 0;
+			std::size_t entitySize = Packets::EstimateSize(entityData, m_matchStatePacket.isQuantized, entityBitCount);
 
-			// Has layer been found?
-			if (layerIndex == layerCount)
-			{
-				// No, insert it as a new one
-				auto& layer = m_matchStatePacket.layers.emplace_back();
-				layer.entityCount = 1;
-				layer.layerIndex = movementData.layerIndex;
-			}
+			bool isNewLayer = layer.matchStateEntities.empty();
+			if (isNewLayer)
+				entitySize += layerHeaderSize;
 
-			assert(entityIndex <= m_matchStatePacket.entities.size());
-			auto entityIt = m_matchStatePacket.entities.emplace(m_matchStatePacket.entities.begin() + entityIndex);
-			BuildMovementPacket(*entityIt, movementData.movementData);
+			std::size_t newPacketSize = packetSize + entitySize + (propertyBitCount + entityBitCount + 7) / 8;
+			if ((handledEntities != 0 || isBudgetLimited) && newPacketSize > maxPacketSize) //< Allow at least one entity in the packet (unless bandwidth is limited)
+				break;
 
-			if (handledEntities != 0 && HasExceededPacketSize()) //< Allow at least one entity in the packet
-			{
-				// Remove last inserted entity
-				m_matchStatePacket.entities.erase(entityIt);
+			if (isNewLayer)
+				m_matchStateLayers.push_back({ movementData.layerIndex, &layer });
 
-				auto& layer = m_matchStatePacket.layers[layerIndex];
-				if (--layer.entityCount == 0)
-				{
-					assert(layerIndex == layerCount);
-					m_matchStatePacket.layers.pop_back();
-				}
+			assert(layer.visibleEntityIds.UnboundedTest(entityData.id));
 
-				handledEntities--;
+			auto& entityState = sentState.entities.emplace_back();
+			entityState.layerIndex = movementData.layerIndex;
+			entityState.entityId = entityData.id;
+			entityState.generation = layer.visibleEntities[entityData.id].generation;
+			entityState.priorityAccumulator = movementData.priorityAccumulator;
+			entityState.state.position = entityData.position;
+			entityState.state.rotation = entityData.rotation;
 
-				break;
+			if (entityData.physicsProperties)
+			{
+				entityState.state.angularVelocity = entityData.physicsProperties->angularVelocity;
+				entityState.state.linearVelocity = entityData.physicsProperties->linearVelocity;
 			}
+			else
+			{
+				entityState.state.angularVelocity = Nz::RadianAnglef::Zero();
+				entityState.state.linearVelocity = Nz::Vector2f::Zero();
+			}
+
+			if (movementData.staticEntity)
+				entityState.staticMovement = m_staticMovementData[movementData.movementIndex];
+
+			layer.matchStateEntities.push_back(std::move(entityData));
 
+			packetSize += entitySize;
+			propertyBitCount += entityBitCount;
 			handledEntities++;
 		}
 
-		// Reset priority only once we're sure entities are being sent
-		// TODO: Reset priority accumulator only once a client acknowledge the packet? (Or maybe reset priority / events if the packet is lost)
+		m_matchStatePacket.entities.reserve(handledEntities);
+		for (auto&& [layerIndex, layer] : m_matchStateLayers)
+		{
+			auto& packetLayer = m_matchStatePacket.layers.emplace_back();
+			packetLayer.layerIndex = layerIndex;
+			packetLayer.entityCount = static_cast<Nz::UInt32>(layer->matchStateEntities.size());
+
+			std::move(layer->matchStateEntities.begin(), layer->matchStateEntities.end(), std::back_inserter(m_matchStatePacket.entities));
+			layer->matchStateEntities.clear();
+		}
+
+		assert(Packets::EstimateSize(m_matchStatePacket) == packetSize + (propertyBitCount + 7) / 8);
+
+		// Reset priority once entities are being sent, they will be reinstated if the client doesn't acknowledge this state (see HandleLostMatchState)
 		for (std::size_t i = 0; i < handledEntities; ++i)
 		{
 			const PriorityMovementData& movementData = m_priorityMovementData[i];
 
-			auto layerIt = m_layers.find(movementData.layerIndex);
-			assert(layerIt != m_layers.end());
-
-			auto& layerData = *layerIt.value();
+			auto& layerData = *movementData.layer;
 
-			Nz::UInt32 entityId = Nz::UInt32(movementData.movementData.entityId);
+			Nz::UInt32 entityId = Nz::UInt32(movementData.entityId);
 
-			auto visibleIt = layerData.visibleEntities.find(entityId);
-			assert(visibleIt != layerData.visibleEntities.end());
+			assert(layerData.visibleEntityIds.UnboundedTest(entityId));
 
-			auto& visibleData = visibleIt.value();
-			visibleData.priorityAccumulator = 0;
+			layerData.visibleEntities[entityId].lastSentTick = stateTick;
+			layerData.priorityAccumulators[entityId] = 0;
 
 			if (movementData.staticEntity)
 				layerData.staticMovementUpdateEvents.erase(entityId);
@@ -980,10 +1498,115 @@ namespace bw
 
 		//bwLog(m_match.GetLogger(), LogLevel::Debug, "Entity count: {0} (packet size: {1})", m_matchStatePacket.entities.size(), Packets::EstimateSize(m_matchStatePacket));
 
-		m_session.SendPacket(m_matchStatePacket);
+		m_session.SendDeferredPacket(std::move(m_matchStatePacket), packetSize + (propertyBitCount + 7) / 8);
 	}
 
-	void MatchClientVisibility::BuildMovementPacket(Packets::MatchState::Entity& packetData, const NetworkSyncSystem::EntityMovement& eventData)
+	void MatchClientVisibility::UpdateInterestArea()
+	{
+		const auto& interestSettings = m_match.GetSettings().interestArea;
+		if (!interestSettings || m_ignoreEvents)
+			return;
+
+		float cellSize = interestSettings->cellSize;
+		int cellRadius = static_cast<int>(std::ceil(interestSettings->radius / cellSize));
+
+		auto GetCell = [&](Ndk::Entity* entity)
+		{
+			Nz::Vector2f position = GetEntityPosition(entity);
+			return Nz::Vector2i(static_cast<int>(std::floor(position.x / cellSize)), static_cast<int>(std::floor(position.y / cellSize)));
+		};
+
+		Terrain& terrain = m_match.GetTerrain();
+
+		for (auto it = m_layers.begin(); it != m_layers.end(); ++it)
+		{
+			LayerIndex layerIndex = it.key();
+			Layer& layer = *it.value();
+
+			// Loading layers are culled once all their entities have been sent
+			if (!layer.loadingEntities.empty())
+				continue;
+
+			Ndk::World& world = terrain.GetLayer(layerIndex).GetWorld();
+
+			m_interestCells.clear();
+			if (layerIndex < m_controlledEntities.size())
+			{
+				const Nz::Bitset<Nz::UInt64>& controlledEntities = m_controlledEntities[layerIndex];
+				for (std::size_t entityId = controlledEntities.FindFirst(); entityId != controlledEntities.npos; entityId = controlledEntities.FindNext(entityId))
+				{
+					if (world.IsEntityIdValid(static_cast<Ndk::EntityId>(entityId)))
+						m_interestCells.push_back(GetCell(world.GetEntity(static_cast<Ndk::EntityId>(entityId))));
+				}
+			}
+
+			// Without any controlled entity on this layer (spectators), everything stays visible
+			if (m_interestCells.empty())
+				continue;
+
+			// Entities leave the area one cell further than they enter it, to prevent them from flickering on the border
+			auto IsInArea = [&](Ndk::Entity* entity, bool isVisible)
+			{
+				Nz::Vector2i cell = GetCell(entity);
+
+				int radius = cellRadius;
+				if (float relevanceDistance = entity->GetComponent<NetworkSyncComponent>().GetSettings().relevanceDistance; relevanceDistance > 0.f)
+					radius = static_cast<int>(std::ceil(relevanceDistance / cellSize));
+
+				int maxDistance = (isVisible) ? radius + 1 : radius;
+
+				for (const Nz::Vector2i& interestCell : m_interestCells)
+				{
+					if (std::abs(cell.x - interestCell.x) <= maxDistance && std::abs(cell.y - interestCell.y) <= maxDistance)
+						return true;
+				}
+
+				return false;
+			};
+
+			// Only dynamic entities are culled, child entities (such as weapons) follow their parents
+			std::function<bool(Ndk::Entity* entity, bool isVisible)> ShouldBeVisible;
+			ShouldBeVisible = [&](Ndk::Entity* entity, bool isVisible)
+			{
+				if (const Ndk::EntityHandle& parent = entity->GetComponent<NetworkSyncComponent>().GetParent())
+				{
+					bool isParentVisible = layer.visibleEntityIds.UnboundedTest(parent->GetId());
+					return ShouldBeVisible(parent, isParentVisible);
+				}
+
+				if (!entity->HasComponent<Ndk::PhysicsComponent2D>())
+					return true;
+
+				if (IsEntityControlled(layerIndex, entity->GetId()))
+					return true;
+
+				return IsInArea(entity, isVisible);
+			};
+
+			NetworkSyncSystem& syncSystem = world.GetSystem<NetworkSyncSystem>();
+			for (const Ndk::EntityHandle& entity : syncSystem.GetEntities())
+			{
+				Nz::UInt32 entityId = static_cast<Nz::UInt32>(entity->GetId());
+
+				bool isVisible = layer.visibleEntityIds.UnboundedTest(entityId);
+				bool shouldBeVisible = ShouldBeVisible(entity, isVisible);
+				if (isVisible == shouldBeVisible)
+					continue;
+
+				if (shouldBeVisible)
+				{
+					NetworkSyncSystem::EntityCreation creationEvent;
+					syncSystem.BuildCreationEvent(creationEvent, entity);
+
+					HandleEntityCreation(layerIndex, creationEvent);
+				}
+				else
+					HandleEntityRemove(layerIndex, entity->GetId(), false, false);
+			}
+		}
+	}
+
+	void MatchClientVisibility::BuildMovementPacket(Packets::MatchState::Entity& packetData, const NetworkSyncSystem::EntityMovement& eventData, const Layer& layer, Nz::UInt16 stateTick)
 	{
 		packetData.id = eventData.entityId;
 		packetData.position = eventData.position;
@@ -1001,15 +1624,99 @@ namespace bw
 			packetData.physicsProperties->angularVelocity = eventData.physicsProperties->angularVelocity;
 			packetData.physicsProperties->linearVelocity = eventData.physicsProperties->linearVelocity;
 		}
+
+		EncodeMovementPacket(packetData, layer, stateTick);
 	}
 
-	void MatchClientVisibility::FillEntityData(const NetworkSyncSystem::EntityCreation& creationEvent, Packets::Helper::EntityData& entityData)
+	void MatchClientVisibility::BuildMovementPacket(Packets::MatchState::Entity& packetData, const NetworkSyncSystem::MovementSnapshot& snapshot, std::size_t movementIndex, const Layer& layer, Nz::UInt16 stateTick)
 	{
-		const NetworkStringStore& networkStringStore = m_match.GetNetworkStringStore();
+		assert(movementIndex < snapshot.GetEntityCount());
+
+		packetData.id = snapshot.entityIds[movementIndex];
+		packetData.position = snapshot.positions[movementIndex];
+		packetData.rotation = snapshot.rotations[movementIndex];
+
+		Nz::UInt8 flags = snapshot.flags[movementIndex];
+		if (flags & NetworkSyncSystem::MovementSnapshot::HasPlayerMovement)
+		{
+			packetData.playerMovement.emplace();
+			packetData.playerMovement->isFacingRight = (flags & NetworkSyncSystem::MovementSnapshot::IsFacingRight) != 0;
+		}
+
+		// Snapshot only contains physical entities
+		packetData.physicsProperties.emplace();
+		packetData.physicsProperties->angularVelocity = snapshot.angularVelocities[movementIndex];
+		packetData.physicsProperties->linearVelocity = snapshot.linearVelocities[movementIndex];
 
+		EncodeMovementPacket(packetData, layer, stateTick);
+	}
+
+	void MatchClientVisibility::EncodeMovementPacket(Packets::MatchState::Entity& packetData, const Layer& layer, Nz::UInt16 stateTick)
+	{
+		if (const auto& quantizer = m_match.GetStateQuantizer(); quantizer && m_session.HasProtocolFeature(ProtocolFeature::StateQuantization))
+		{
+			// Keep dequantized values so baselines match what the client decodes
+			packetData.quantizedPosition = quantizer->QuantizePosition(packetData.position);
+			packetData.quantizedRotation = quantizer->QuantizeAngle(packetData.rotation);
+			packetData.position = quantizer->DequantizePosition(packetData.quantizedPosition);
+			packetData.rotation = quantizer->DequantizeAngle(packetData.quantizedRotation);
+
+			if (packetData.physicsProperties)
+			{
+				auto& physicsProperties = packetData.physicsProperties.value();
+				physicsProperties.quantizedAngularVelocity = quantizer->QuantizeAngularVelocity(physicsProperties.angularVelocity);
+				physicsProperties.quantizedLinearVelocity = quantizer->QuantizeLinearVelocity(physicsProperties.linearVelocity);
+				physicsProperties.angularVelocity = quantizer->DequantizeAngularVelocity(physicsProperties.quantizedAngularVelocity);
+				physicsProperties.linearVelocity = quantizer->DequantizeLinearVelocity(physicsProperties.quantizedLinearVelocity);
+			}
+		}
+
+		assert(layer.visibleEntityIds.UnboundedTest(packetData.id));
+
+		const auto& visibleData = layer.visibleEntities[packetData.id];
+		if (!visibleData.baseline || !m_session.HasProtocolFeature(ProtocolFeature::DeltaSnapshots))
+			return;
+
+		Nz::UInt16 baselineAge = stateTick - visibleData.baselineTick;
+		if (baselineAge == 0 || baselineAge > Packets::MatchState::MaxBaselineAge)
+			return;
+
+		// Encode against the acknowledged baseline, unchanged fields take the baseline value (as the client will)
+		const EntityState& baseline = visibleData.baseline.value();
+
+		auto& deltaData = packetData.delta.emplace();
+		deltaData.baselineAge = static_cast<Nz::UInt8>(baselineAge);
+
+		deltaData.positionChanged = !CompareWithEpsilon(packetData.position, baseline.position, PositionEpsilon);
+		if (!deltaData.positionChanged)
+			packetData.position = baseline.position;
+
+		deltaData.rotationChanged = !CompareWithEpsilon(packetData.rotation, baseline.rotation, RotationEpsilon);
+		if (!deltaData.rotationChanged)
+			packetData.rotation = baseline.rotation;
+
+		if (packetData.physicsProperties)
+		{
+			auto& physicsProperties = packetData.physicsProperties.value();
+
+			deltaData.velocityChanged = !CompareWithEpsilon(physicsProperties.angularVelocity, baseline.angularVelocity, VelocityEpsilon) ||
+			                            !CompareWithEpsilon(physicsProperties.linearVelocity, baseline.linearVelocity, VelocityEpsilon);
+
+			if (!deltaData.velocityChanged)
+			{
+				physicsProperties.angularVelocity = baseline.angularVelocity;
+				physicsProperties.linearVelocity = baseline.linearVelocity;
+			}
+		}
+		else
+			deltaData.velocityChanged = false;
+	}
+
+	void MatchClientVisibility::FillEntityData(const NetworkSyncSystem::EntityCreation& creationEvent, Packets::Helper::EntityData& entityData)
+	{
 		assert(creationEvent.uniqueId > 0);
 
-		entityData.entityClass = networkStringStore.CheckStringIndex(creationEvent.entityClass);
+		entityData.entityClass = creationEvent.payload->entityClass;
 		entityData.uniqueId = static_cast<Nz::UInt64>(creationEvent.uniqueId);
 		entityData.position = creationEvent.position;
 		entityData.rotation = creationEvent.rotation;
@@ -1051,11 +1758,152 @@ namespace bw
 			entityData.physicsProperties->momentOfInertia = physicsProperties.momentOfInertia;
 		}
 
-		for (auto&& [propertyName, propertyValue] : creationEvent.properties)
+		// Property names were resolved once when the entity was created
+		entityData.properties = creationEvent.payload->properties;
+	}
+
+	template<typename T>
+	void MatchClientVisibility::FlushPendingPackets(std::vector<PendingEntityPacket<T>>& pendingPackets)
+	{
+		// Packets are compacted in place (keeping their order) instead of being erased one by one
+		std::size_t pendingPacketCount = 0;
+		for (std::size_t i = 0; i < pendingPackets.size(); ++i)
+		{
+			PendingEntityPacket<T>& pendingPacket = pendingPackets[i];
+
+			LayerIndex layerId = LayerIndex(pendingPacket.entityKey >> 32);
+			Nz::UInt32 entityId = Nz::UInt32(pendingPacket.entityKey & 0xFFFFFFFF);
+
+			// If a pending packet is related to a layer which is no longer visible, drop it
+			auto layerIt = m_layers.find(layerId);
+			if (layerIt == m_layers.end())
+				continue;
+
+			Layer& layer = *layerIt.value();
+			if (layer.visibleEntityIds.UnboundedTest(entityId))
+			{
+				SendPendingPacket(pendingPacket.packet);
+				continue;
+			}
+
+			if (pendingPacketCount != i)
+				pendingPackets[pendingPacketCount] = std::move(pendingPacket);
+
+			pendingPacketCount++;
+		}
+		pendingPackets.erase(pendingPackets.begin() + pendingPacketCount, pendingPackets.end());
+	}
+
+	template<typename T>
+	void MatchClientVisibility::FlushPendingPackets(std::vector<PendingEntitiesPacket<T>>& pendingPackets)
+	{
+		std::size_t pendingPacketCount = 0;
+		for (std::size_t i = 0; i < pendingPackets.size(); ++i)
 		{
-			auto& propertyData = entityData.properties.emplace_back();
-			propertyData.name = networkStringStore.CheckStringIndex(propertyName);
-			propertyData.value = propertyValue;
+			PendingEntitiesPacket<T>& pendingPacket = pendingPackets[i];
+
+			// If a pending packet is related to a layer which is no longer visible, drop it
+			auto layerIt = m_layers.find(pendingPacket.layerIndex);
+			if (layerIt == m_layers.end())
+				continue;
+
+			Layer& layer = *layerIt.value();
+
+			bool allEntitiesVisible = true;
+			for (std::size_t entityId = pendingPacket.entitiesId.FindFirst(); entityId != pendingPacket.entitiesId.npos; entityId = pendingPacket.entitiesId.FindNext(entityId))
+			{
+				if (!layer.visibleEntityIds.UnboundedTest(Nz::UInt32(entityId)))
+				{
+					allEntitiesVisible = false;
+					break;
+				}
+			}
+
+			if (allEntitiesVisible)
+			{
+				SendPendingPacket(pendingPacket.packet);
+				continue;
+			}
+
+			if (pendingPacketCount != i)
+				pendingPackets[pendingPacketCount] = std::move(pendingPacket);
+
+			pendingPacketCount++;
 		}
+		pendingPackets.erase(pendingPackets.begin() + pendingPacketCount, pendingPackets.end());
+	}
+
+	template<typename F>
+	void MatchClientVisibility::ForEachCreationEventOrdered(PendingCreationEventMap& creationEvents, F&& func)
+	{
+		// Entities have to be created after the ones they depend on (parent, weapons, ...), dependencies are walked depth-first
+		// using an explicit stack, events are reset once handled
+		auto& stack = m_creationOrderStack;
+		assert(stack.empty());
+
+		for (auto it = creationEvents.begin(); it != creationEvents.end(); ++it)
+		{
+			if (!it.value().has_value())
+				continue;
+
+			stack.push_back(CreationOrderNode{ it, 0 });
+			while (!stack.empty())
+			{
+				CreationOrderNode& node = stack.back();
+				auto& eventData = node.it.value();
+
+				std::size_t parentCount = (eventData->parent) ? 1 : 0;
+				if (node.dependencyIndex < parentCount + eventData->dependentIds.size())
+				{
+					std::size_t dependencyIndex = node.dependencyIndex++;
+
+					Nz::UInt32 dependencyId;
+					if (dependencyIndex < parentCount)
+						dependencyId = static_cast<Nz::UInt32>(eventData->parent.value());
+					else
+						dependencyId = static_cast<Nz::UInt32>(eventData->dependentIds[dependencyIndex - parentCount].second);
+
+					auto dependencyIt = creationEvents.find(dependencyId);
+					if (dependencyIt == creationEvents.end() || !dependencyIt.value().has_value())
+						continue;
+
+					// Entities already on the stack are part of a dependency cycle, which can't be honored
+					if (std::any_of(stack.begin(), stack.end(), [&](const CreationOrderNode& stackNode) { return stackNode.it == dependencyIt; }))
+						continue;
+
+					stack.push_back(CreationOrderNode{ dependencyIt, 0 });
+					continue;
+				}
+
+				func(eventData.value());
+				eventData.reset();
+
+				stack.pop_back();
+			}
+		}
+	}
+
+	template<typename T>
+	void MatchClientVisibility::SendSharedEventPacket(const T& packet)
+	{
+		// Local sessions don't need serialization at all
+		if (m_session.GetSessionBridge().SupportsTypedPackets())
+		{
+			m_session.SendPacket(packet);
+			return;
+		}
+
+		// Sessions seeing the same events this update (same key) get the same serialized packet
+		MatchSessions& sessions = m_match.GetSessions();
+		m_session.SendSharedPacket(sessions.AcquireSharedPacket(packet, m_sharedPacketKey, m_session.HasProtocolFeature(ProtocolFeature::Compression)));
+	}
+
+	template<typename T>
+	void MatchClientVisibility::SendPendingPacket(T& packet)
+	{
+		if constexpr (Detail::HasStateTick<T>::value)
+			packet.stateTick = m_match.GetNetworkTick();
+
+		m_session.SendPacket(packet);
 	}
 }
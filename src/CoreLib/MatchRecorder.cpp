@@ -0,0 +1,76 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/MatchRecorder.hpp>
+#include <CoreLib/Protocol/CompressedInteger.hpp>
+#include <stdexcept>
+
+namespace bw
+{
+	MatchRecorder::MatchRecorder(const std::filesystem::path& filePath, float tickDuration, Nz::UInt32 randomSeed) :
+	m_stream(&m_buffer, Nz::OpenMode_WriteOnly),
+	m_file(filePath.generic_u8string(), Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate)
+	{
+		if (!m_file.IsOpen())
+			throw std::runtime_error("failed to open replay file " + filePath.generic_u8string());
+
+		m_stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		m_stream.Write("Burgrepl", 8);
+		m_stream << FileVersion;
+		m_stream << tickDuration;
+		m_stream << randomSeed;
+
+		Flush();
+	}
+
+	MatchRecorder::~MatchRecorder()
+	{
+		Flush();
+	}
+
+	void MatchRecorder::Flush()
+	{
+		if (m_buffer.IsEmpty())
+			return;
+
+		m_file.Write(m_buffer.GetConstBuffer(), m_buffer.GetSize());
+
+		m_buffer.Clear();
+		m_stream.GetStream()->SetCursorPos(0);
+	}
+
+	void MatchRecorder::RecordConnection(std::size_t sessionId)
+	{
+		m_stream << static_cast<Nz::UInt8>(EventType::Connection);
+		m_stream << CompressedUnsigned<Nz::UInt32>(static_cast<Nz::UInt32>(sessionId));
+	}
+
+	void MatchRecorder::RecordDisconnection(std::size_t sessionId)
+	{
+		m_stream << static_cast<Nz::UInt8>(EventType::Disconnection);
+		m_stream << CompressedUnsigned<Nz::UInt32>(static_cast<Nz::UInt32>(sessionId));
+	}
+
+	void MatchRecorder::RecordIncomingPacket(std::size_t sessionId, const Nz::NetPacket& packet)
+	{
+		// Packets are stored as received (compressed ones included), and unserialized again when replayed
+		std::size_t dataSize = packet.GetDataSize();
+
+		m_stream << static_cast<Nz::UInt8>(EventType::IncomingPacket);
+		m_stream << CompressedUnsigned<Nz::UInt32>(static_cast<Nz::UInt32>(sessionId));
+		m_stream << packet.GetNetCode();
+		m_stream << CompressedUnsigned<Nz::UInt32>(static_cast<Nz::UInt32>(dataSize));
+		m_stream.Write(static_cast<const Nz::UInt8*>(packet.GetConstData()) + Nz::NetPacket::HeaderSize, dataSize);
+	}
+
+	void MatchRecorder::RecordUpdate(float elapsedTime)
+	{
+		m_stream << static_cast<Nz::UInt8>(EventType::Update);
+		m_stream << elapsedTime;
+
+		if (m_buffer.GetSize() >= FlushThreshold)
+			Flush();
+	}
+}
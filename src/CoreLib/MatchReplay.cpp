@@ -0,0 +1,121 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/MatchReplay.hpp>
+#include <CoreLib/Protocol/CompressedInteger.hpp>
+#include <Nazara/Core/ErrorFlags.hpp>
+#include <Nazara/Core/File.hpp>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace bw
+{
+	MatchReplay::MatchReplay(const std::filesystem::path& filePath)
+	{
+		Nz::File replayFile(filePath.generic_u8string(), Nz::OpenMode_ReadOnly);
+		if (!replayFile.IsOpen())
+			throw std::runtime_error("failed to open replay file " + filePath.generic_u8string());
+
+		// Load the whole file at once, events are small and read one after another
+		m_content.resize(replayFile.GetSize());
+		if (replayFile.Read(m_content.data(), m_content.size()) != m_content.size())
+			throw std::runtime_error("failed to read replay file");
+
+		m_contentView.emplace(m_content.data(), m_content.size());
+
+		m_stream.SetStream(&m_contentView.value());
+		m_stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		std::array<char, 8> signature;
+		if (m_stream.Read(signature.data(), signature.size()) != signature.size() || std::memcmp(signature.data(), "Burgrepl", signature.size()) != 0)
+			throw std::runtime_error("not a valid replay file");
+
+		Nz::UInt16 fileVersion;
+		m_stream >> fileVersion;
+
+		if (fileVersion != MatchRecorder::FileVersion)
+			throw std::runtime_error("unsupported replay file version " + std::to_string(fileVersion));
+
+		m_stream >> m_tickDuration;
+		m_stream >> m_randomSeed;
+	}
+
+	auto MatchReplay::PeekEvent() -> std::optional<EventType>
+	{
+		Nz::UInt64 cursorPos = m_contentView->GetCursorPos();
+		if (cursorPos >= m_content.size())
+			return std::nullopt;
+
+		return static_cast<EventType>(m_content[cursorPos]);
+	}
+
+	std::size_t MatchReplay::ReadConnection()
+	{
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException); //< truncated files (server crash) throw instead of returning garbage
+
+		ReadEventType(EventType::Connection);
+
+		CompressedUnsigned<Nz::UInt32> sessionId;
+		m_stream >> sessionId;
+
+		return sessionId;
+	}
+
+	std::size_t MatchReplay::ReadDisconnection()
+	{
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		ReadEventType(EventType::Disconnection);
+
+		CompressedUnsigned<Nz::UInt32> sessionId;
+		m_stream >> sessionId;
+
+		return sessionId;
+	}
+
+	Nz::NetPacket MatchReplay::ReadIncomingPacket(std::size_t* sessionId)
+	{
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		ReadEventType(EventType::IncomingPacket);
+
+		CompressedUnsigned<Nz::UInt32> packetSessionId;
+		Nz::UInt16 netCode;
+		CompressedUnsigned<Nz::UInt32> dataSize;
+		m_stream >> packetSessionId >> netCode >> dataSize;
+
+		Nz::UInt64 cursorPos = m_contentView->GetCursorPos();
+		if (cursorPos + dataSize > m_content.size())
+			throw std::runtime_error("truncated replay file");
+
+		m_contentView->SetCursorPos(cursorPos + dataSize);
+
+		*sessionId = packetSessionId;
+		return Nz::NetPacket(netCode, &m_content[cursorPos], dataSize);
+	}
+
+	float MatchReplay::ReadUpdate()
+	{
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		ReadEventType(EventType::Update);
+
+		float elapsedTime;
+		m_stream >> elapsedTime;
+
+		return elapsedTime;
+	}
+
+	void MatchReplay::ReadEventType(EventType expectedType)
+	{
+		Nz::UInt8 eventType;
+		m_stream >> eventType;
+
+		if (eventType != static_cast<Nz::UInt8>(expectedType))
+			throw std::runtime_error("unexpected replay event (file is corrupted)");
+	}
+}
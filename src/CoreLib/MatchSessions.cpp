@@ -3,18 +3,76 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/MatchSessions.hpp>
+#include <CoreLib/BurgApp.hpp>
+#include <CoreLib/ConfigFile.hpp>
 #include <CoreLib/LogSystem/Logger.hpp>
 #include <CoreLib/Match.hpp>
 #include <CoreLib/MatchClientSession.hpp>
+#include <CoreLib/MatchRecorder.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <functional>
 
 namespace bw
 {
+	namespace
+	{
+		template<typename F>
+		void FormatCommandStatistics(std::string& output, const CommandStatisticsList& statistics, F&& getCommandName)
+		{
+			for (std::size_t packetId = 0; packetId < statistics.size(); ++packetId)
+			{
+				const CommandStatistics& commandStatistics = statistics[packetId];
+				if (commandStatistics.packetCount == 0)
+					continue;
+
+				const char* commandName = getCommandName(packetId);
+				output += fmt::format("  {0}: {1} packets, {2:.1f} kB, {3:.2f} ms\n", (commandName) ? commandName : "<unknown>", commandStatistics.packetCount, commandStatistics.byteCount / 1000.0, commandStatistics.processingTime / 1000.0);
+			}
+		}
+
+		CommandStatistics SumStatistics(const CommandStatisticsList& statistics, const CommandStatisticsList& previousStatistics)
+		{
+			CommandStatistics total;
+			for (std::size_t packetId = 0; packetId < statistics.size(); ++packetId)
+			{
+				total.byteCount += statistics[packetId].byteCount;
+				total.packetCount += statistics[packetId].packetCount;
+				total.processingTime += statistics[packetId].processingTime;
+
+				if (packetId < previousStatistics.size())
+				{
+					total.byteCount -= previousStatistics[packetId].byteCount;
+					total.packetCount -= previousStatistics[packetId].packetCount;
+					total.processingTime -= previousStatistics[packetId].processingTime;
+				}
+			}
+
+			return total;
+		}
+	}
+
 	MatchSessions::MatchSessions(Match& match) :
 	m_nextSessionId(0),
 	m_match(match),
 	m_commandStore(m_match.GetLogger()),
 	m_sessionPool(sizeof(MatchClientSession))
 	{
+		const ConfigFile& config = m_match.GetApp().GetConfig();
+
+		SimulatedSessionBridge::Conditions conditions;
+		conditions.duplicationRate = config.GetFloatValue<float>("Debug.SimulatedPacketDuplication");
+		conditions.jitter = config.GetIntegerValue<Nz::UInt32>("Debug.SimulatedJitter");
+		conditions.latency = config.GetIntegerValue<Nz::UInt32>("Debug.SimulatedLatency");
+		conditions.lossRate = config.GetFloatValue<float>("Debug.SimulatedPacketLoss");
+		conditions.reorderRate = config.GetFloatValue<float>("Debug.SimulatedPacketReordering");
+		conditions.seed = config.GetIntegerValue<Nz::UInt32>("Debug.SimulationSeed");
+
+		if (conditions.duplicationRate > 0.f || conditions.jitter > 0 || conditions.latency > 0 || conditions.lossRate > 0.f || conditions.reorderRate > 0.f)
+		{
+			bwLog(m_match.GetLogger(), LogLevel::Warning, "Network conditions simulation enabled (latency: {0}ms, jitter: {1}ms, loss: {2}, duplication: {3}, reordering: {4})", conditions.latency, conditions.jitter, conditions.lossRate, conditions.duplicationRate, conditions.reorderRate);
+			m_simulatedConditions = conditions;
+		}
 	}
 
 	MatchSessions::~MatchSessions()
@@ -28,21 +86,117 @@ namespace bw
 			m_sessionPool.Delete(pair.second);
 
 		m_sessionIdToSession.clear();
+		m_simulatedBridges.clear();
+	}
+
+	std::string MatchSessions::FormatNetworkStatistics() const
+	{
+		std::string output = fmt::format("Network statistics ({0} session(s))\n", m_sessionIdToSession.size());
+
+		output += "Outgoing:\n";
+		FormatCommandStatistics(output, m_commandStore.GetOutgoingStatistics(), [&](std::size_t packetId) { return m_commandStore.GetOutgoingCommandName(packetId); });
+
+		output += "Incoming:\n";
+		FormatCommandStatistics(output, m_commandStore.GetIncomingStatistics(), [&](std::size_t packetId) { return m_commandStore.GetIncomingCommandName(packetId); });
+
+		output += "Sessions:\n";
+		for (const auto& pair : m_sessionIdToSession)
+		{
+			const MatchClientSession* session = pair.second;
+
+			CommandStatistics outgoing = SumStatistics(session->GetOutgoingStatistics(), {});
+			CommandStatistics incoming = SumStatistics(session->GetIncomingStatistics(), {});
+
+			output += fmt::format("  #{0}: sent {1} packets ({2:.1f} kB), received {3} packets ({4:.1f} kB)", pair.first, outgoing.packetCount, outgoing.byteCount / 1000.0, incoming.packetCount, incoming.byteCount / 1000.0);
+
+			// Peer totals as seen by the network reactor (includes protocol overhead and resends)
+			if (const auto& sessionInfo = session->GetSessionInfo())
+			{
+				float packetLoss = (sessionInfo->totalPacketSent > 0) ? 100.f * sessionInfo->totalPacketLost / sessionInfo->totalPacketSent : 0.f;
+				output += fmt::format(" - peer: ping {0} ms, {1:.1f}% loss, sent {2:.1f} kB, received {3:.1f} kB", sessionInfo->ping, packetLoss, sessionInfo->totalByteSent / 1000.0, sessionInfo->totalByteReceived / 1000.0);
+			}
+
+			const auto& inputTiming = session->GetInputTimingStatistics();
+			output += fmt::format(" - inputs: {0} on time, {1} late, {2} early", inputTiming.onTimeCount, inputTiming.lateCount, inputTiming.earlyCount);
+
+			output += "\n";
+		}
+
+		return output;
+	}
+
+	void MatchSessions::LogNetworkStatistics()
+	{
+		const CommandStatisticsList& incomingStatistics = m_commandStore.GetIncomingStatistics();
+		const CommandStatisticsList& outgoingStatistics = m_commandStore.GetOutgoingStatistics();
+
+		CommandStatistics incoming = SumStatistics(incomingStatistics, m_lastLoggedIncomingStatistics);
+		CommandStatistics outgoing = SumStatistics(outgoingStatistics, m_lastLoggedOutgoingStatistics);
+
+		// Find out which commands used the most bandwidth since last time
+		constexpr std::size_t TopCommandCount = 3;
+
+		std::vector<std::pair<Nz::UInt64, std::size_t>> outgoingBytes;
+		for (std::size_t packetId = 0; packetId < outgoingStatistics.size(); ++packetId)
+		{
+			Nz::UInt64 byteCount = outgoingStatistics[packetId].byteCount;
+			if (packetId < m_lastLoggedOutgoingStatistics.size())
+				byteCount -= m_lastLoggedOutgoingStatistics[packetId].byteCount;
+
+			if (byteCount > 0)
+				outgoingBytes.emplace_back(byteCount, packetId);
+		}
+
+		std::size_t topCount = std::min(outgoingBytes.size(), TopCommandCount);
+		std::partial_sort(outgoingBytes.begin(), outgoingBytes.begin() + topCount, outgoingBytes.end(), std::greater<>());
+
+		std::string topCommands;
+		for (std::size_t i = 0; i < topCount; ++i)
+		{
+			const char* commandName = m_commandStore.GetOutgoingCommandName(outgoingBytes[i].second);
+			topCommands += fmt::format("{0}{1} ({2:.1f} kB)", (i > 0) ? ", " : "", (commandName) ? commandName : "<unknown>", outgoingBytes[i].first / 1000.0);
+		}
+
+		bwLog(m_match.GetLogger(), LogLevel::Info, "Network: {0} session(s), sent {1} packets ({2:.1f} kB), received {3} packets ({4:.1f} kB); top sent: {5}", m_sessionIdToSession.size(), outgoing.packetCount, outgoing.byteCount / 1000.0, incoming.packetCount, incoming.byteCount / 1000.0, (!topCommands.empty()) ? topCommands : "none");
+
+		m_lastLoggedIncomingStatistics = incomingStatistics;
+		m_lastLoggedOutgoingStatistics = outgoingStatistics;
 	}
 
 	void MatchSessions::Poll()
 	{
 		for (auto& sessionManager : m_managers)
 			sessionManager->Poll();
+
+		for (auto it = m_simulatedBridges.begin(); it != m_simulatedBridges.end(); ++it)
+			it.value()->Poll();
+	}
+
+	void MatchSessions::ReleaseSharedPackets()
+	{
+		// Packets still queued by sessions or bridges are kept alive by their references
+		m_sharedPackets.clear();
 	}
 
 	MatchClientSession* MatchSessions::CreateSession(std::shared_ptr<SessionBridge> bridge)
 	{
 		std::size_t sessionId = m_nextSessionId++;
+
+		if (m_simulatedConditions)
+		{
+			auto simulatedBridge = std::make_shared<SimulatedSessionBridge>(std::move(bridge), *m_simulatedConditions);
+			m_simulatedBridges.emplace(sessionId, simulatedBridge);
+
+			bridge = std::move(simulatedBridge);
+		}
+
 		MatchClientSession* session = m_sessionPool.New<MatchClientSession>(m_match, sessionId, m_commandStore, std::move(bridge));
 
 		m_sessionIdToSession.insert_or_assign(sessionId, session);
 
+		if (MatchRecorder* recorder = m_match.GetRecorder())
+			recorder->RecordConnection(sessionId);
+
 		bwLog(m_match.GetLogger(), LogLevel::Info, "Created session #{0}", sessionId);
 
 		return session;
@@ -51,10 +205,29 @@ namespace bw
 	void MatchSessions::DeleteSession(MatchClientSession* session)
 	{
 		std::size_t sessionId = session->GetSessionId();
+		if (MatchRecorder* recorder = m_match.GetRecorder())
+			recorder->RecordDisconnection(sessionId);
+
 		m_sessionIdToSession.erase(sessionId);
+		m_simulatedBridges.erase(sessionId);
 
 		m_sessionPool.Delete(session);
 
 		bwLog(m_match.GetLogger(), LogLevel::Info, "Deleted session #{0}", sessionId);
 	}
+
+	std::size_t MatchSessions::SharedPacketKeyHasher::operator()(const SharedPacketKey& key) const
+	{
+		auto Combine = [](std::size_t& seed, std::size_t value)
+		{
+			seed ^= value + 0x9E3779B9 + (seed << 6) + (seed >> 2);
+		};
+
+		std::size_t seed = key.packetId;
+		Combine(seed, key.compressed);
+		for (Nz::UInt64 value : key.content)
+			Combine(seed, std::hash<Nz::UInt64>()(value));
+
+		return seed;
+	}
 }
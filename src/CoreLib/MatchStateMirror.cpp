@@ -0,0 +1,455 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/MatchStateMirror.hpp>
+#include <CoreLib/Utils.hpp>
+#include <tsl/hopscotch_set.h>
+#include <algorithm>
+#include <type_traits>
+
+namespace bw
+{
+	MatchStateMirror::MatchStateMirror(const Logger& logger) :
+	m_logger(logger),
+	m_lastStateTick(0),
+	m_lastStateTime(0)
+	{
+	}
+
+	void MatchStateMirror::BuildCatchUpPackets(CatchUpPackets& packets) const
+	{
+		for (auto&& [playerIndex, player] : m_players)
+		{
+			auto& playerJoined = packets.players.emplace_back();
+			playerJoined.playerIndex = playerIndex;
+			playerJoined.playerName = player.name;
+
+			if (player.controlledEntityId)
+			{
+				auto& controlEntity = packets.playerControlledEntities.emplace_back();
+				controlEntity.playerIndex = playerIndex;
+				controlEntity.controlledEntityId = *player.controlledEntityId;
+			}
+		}
+
+		packets.entitiesPhysics.stateTick = m_lastStateTick;
+		packets.entitiesWeapon.stateTick = m_lastStateTick;
+		packets.recycledEntities.stateTick = m_lastStateTick;
+
+		// Entities are grouped by layer in those packets
+		auto AppendLayer = [](auto& packet, LayerIndex layerIndex, std::size_t firstEntity)
+		{
+			std::size_t entityCount = packet.entities.size() - firstEntity;
+			if (entityCount == 0)
+				return;
+
+			auto& layerData = packet.layers.emplace_back();
+			layerData.layerIndex = layerIndex;
+			layerData.entityCount = Nz::UInt32(entityCount);
+		};
+
+		tsl::hopscotch_set<Nz::UInt32> addedEntities;
+		std::vector<Nz::UInt32> parentChain;
+		for (std::size_t i = 0; i < m_layers.size(); ++i)
+		{
+			const Layer& layer = m_layers[i];
+			if (!layer.isEnabled)
+				continue;
+
+			LayerIndex layerIndex = LayerIndex(i);
+
+			auto& enableLayer = packets.enabledLayers.emplace_back();
+			enableLayer.layerIndex = layerIndex;
+			enableLayer.remainingEntityCount = layer.remainingEntityCount;
+			enableLayer.stateTick = m_lastStateTick;
+			enableLayer.layerEntities.reserve(layer.entities.size());
+
+			std::size_t firstPhysicsEntity = packets.entitiesPhysics.entities.size();
+			std::size_t firstRecycledEntity = packets.recycledEntities.entities.size();
+			std::size_t firstWeaponEntity = packets.entitiesWeapon.entities.size();
+
+			// Clients need parents to be created before their children
+			addedEntities.clear();
+			for (auto it = layer.entities.begin(); it != layer.entities.end(); ++it)
+			{
+				parentChain.clear();
+
+				Nz::UInt32 entityId = it->first;
+				while (addedEntities.find(entityId) == addedEntities.end())
+				{
+					auto entityIt = layer.entities.find(entityId);
+					if (entityIt == layer.entities.end())
+						break;
+
+					parentChain.push_back(entityId);
+					addedEntities.insert(entityId);
+
+					const auto& parentId = entityIt->second.data.parentId;
+					if (!parentId)
+						break;
+
+					entityId = *parentId;
+				}
+
+				for (auto chainIt = parentChain.rbegin(); chainIt != parentChain.rend(); ++chainIt)
+				{
+					const Entity& entity = layer.entities.at(*chainIt);
+
+					auto& entityData = enableLayer.layerEntities.emplace_back();
+					entityData.id = *chainIt;
+					entityData.data = entity.data;
+
+					if (entity.isRecycled)
+					{
+						auto& recycledEntity = packets.recycledEntities.entities.emplace_back();
+						recycledEntity.id = *chainIt;
+					}
+
+					if (entity.physics)
+						packets.entitiesPhysics.entities.push_back(*entity.physics);
+
+					if (entity.weaponEntityId)
+					{
+						auto& weaponEntity = packets.entitiesWeapon.entities.emplace_back();
+						weaponEntity.id = *chainIt;
+						weaponEntity.weaponEntityId = *entity.weaponEntityId;
+					}
+				}
+			}
+
+			AppendLayer(packets.entitiesPhysics, layerIndex, firstPhysicsEntity);
+			AppendLayer(packets.entitiesWeapon, layerIndex, firstWeaponEntity);
+			AppendLayer(packets.recycledEntities, layerIndex, firstRecycledEntity);
+		}
+	}
+
+	Nz::UInt16 MatchStateMirror::EstimateCurrentTick(Nz::UInt64 now) const
+	{
+		if (!m_matchData)
+			return 0;
+
+		// Upstream sends a state every few ticks at most, extrapolate from the last one
+		Nz::UInt64 elapsedTicks = static_cast<Nz::UInt64>((now - m_lastStateTime) / (m_matchData->tickDuration * 1'000'000.f));
+		return static_cast<Nz::UInt16>(m_lastStateTick + elapsedTicks);
+	}
+
+	void MatchStateMirror::HandlePacket(Packet&& packet, Nz::UInt64 now)
+	{
+		std::visit([&](const auto& arg)
+		{
+			using T = std::decay_t<decltype(arg)>;
+
+			Apply(arg);
+
+			if constexpr (std::is_same_v<T, Packets::MatchData>)
+			{
+				m_lastStateTick = arg.currentTick;
+				m_lastStateTime = now;
+			}
+			else if constexpr (std::is_same_v<T, Packets::MatchState>)
+			{
+				if (!IsMoreRecent(m_lastStateTick, arg.stateTick))
+				{
+					m_lastStateTick = arg.stateTick;
+					m_lastStateTime = now;
+				}
+			}
+		}, packet);
+	}
+
+	void MatchStateMirror::Apply(std::monostate)
+	{
+	}
+
+	void MatchStateMirror::Apply(const Packets::CreateEntities& packet)
+	{
+		ForEachLayerEntity(packet, [](Layer& layer, const Packets::CreateEntities::Entity& entityData)
+		{
+			Entity& entity = layer.entities[entityData.id];
+			entity = Entity{};
+			entity.data = entityData.data;
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::DeleteEntities& packet)
+	{
+		ForEachLayerEntity(packet, [](Layer& layer, const Packets::DeleteEntities::Entity& entityData)
+		{
+			layer.entities.erase(entityData.id);
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::DisableLayer& packet)
+	{
+		if (Layer* layer = GetLayer(packet.layerIndex))
+		{
+			layer->entities.clear();
+			layer->isEnabled = false;
+			layer->remainingEntityCount = 0;
+		}
+	}
+
+	void MatchStateMirror::Apply(const Packets::EnableLayer& packet)
+	{
+		Layer* layer = GetLayer(packet.layerIndex);
+		if (!layer)
+			return;
+
+		// Layers are streamed in chunks, only the first one enables it
+		if (!layer->isEnabled || layer->remainingEntityCount == 0)
+		{
+			layer->entities.clear();
+			layer->isEnabled = true;
+		}
+
+		for (const auto& entityData : packet.layerEntities)
+		{
+			Entity& entity = layer->entities[entityData.id];
+			entity = Entity{};
+			entity.data = entityData.data;
+		}
+
+		layer->remainingEntityCount = packet.remainingEntityCount;
+	}
+
+	void MatchStateMirror::Apply(const Packets::EntitiesDeath& packet)
+	{
+		ForEachLayerEntity(packet, [](Layer& layer, const Packets::EntitiesDeath::Entity& entityData)
+		{
+			layer.entities.erase(entityData.id);
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::EntitiesInputs& packet)
+	{
+		ForEachLayerEntity(packet, [](Layer& layer, const Packets::EntitiesInputs::Entity& entityData)
+		{
+			if (auto it = layer.entities.find(entityData.id); it != layer.entities.end())
+				it.value().data.inputs = entityData.inputs;
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::EntitiesPhysics& packet)
+	{
+		ForEachLayerEntity(packet, [](Layer& layer, const Packets::EntitiesPhysics::Entity& entityData)
+		{
+			if (auto it = layer.entities.find(entityData.id); it != layer.entities.end())
+				it.value().physics = entityData;
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::EntitiesScale& packet)
+	{
+		ForEachLayerEntity(packet, [](Layer& layer, const Packets::EntitiesScale::Entity& entityData)
+		{
+			if (auto it = layer.entities.find(entityData.id); it != layer.entities.end())
+				it.value().data.scale = entityData.newScale;
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::EntitiesWeapon& packet)
+	{
+		ForEachLayerEntity(packet, [](Layer& layer, const Packets::EntitiesWeapon::Entity& entityData)
+		{
+			auto it = layer.entities.find(entityData.id);
+			if (it == layer.entities.end())
+				return;
+
+			if (entityData.weaponEntityId != Packets::EntitiesWeapon::NoWeapon)
+				it.value().weaponEntityId = entityData.weaponEntityId;
+			else
+				it.value().weaponEntityId.reset();
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::HealthUpdate& packet)
+	{
+		ForEachLayerEntity(packet, [](Layer& layer, const Packets::HealthUpdate::Entity& entityData)
+		{
+			auto it = layer.entities.find(entityData.id);
+			if (it != layer.entities.end() && it->second.data.health)
+				it.value().data.health->currentHealth = entityData.currentHealth;
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::MapReset& packet)
+	{
+		for (Layer& layer : m_layers)
+		{
+			if (layer.isEnabled)
+			{
+				layer.entities.clear();
+				layer.remainingEntityCount = 0;
+			}
+		}
+
+		ForEachLayerEntity(packet, [](Layer& layer, const Packets::MapReset::Entity& entityData)
+		{
+			Entity& entity = layer.entities[entityData.id];
+			entity = Entity{};
+			entity.data = entityData.data;
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::MatchData& packet)
+	{
+		m_matchData = packet;
+		m_layers.clear();
+		m_layers.resize(packet.layers.size());
+
+		if (packet.stateQuantization)
+			m_stateQuantizer.emplace(*packet.stateQuantization);
+		else
+			m_stateQuantizer.reset();
+	}
+
+	void MatchStateMirror::Apply(const Packets::MatchState& packet)
+	{
+		// States are unreliable and may arrive out of order
+		if (IsMoreRecent(m_lastStateTick, packet.stateTick))
+			return;
+
+		if (packet.isQuantized && !m_stateQuantizer)
+		{
+			bwLog(m_logger, LogLevel::Error, "received a quantized state without quantization settings");
+			return;
+		}
+
+		ForEachLayerEntity(packet, [&](Layer& layer, const Packets::MatchState::Entity& entityData)
+		{
+			auto it = layer.entities.find(entityData.id);
+			if (it == layer.entities.end())
+				return;
+
+			// Relays never acknowledge states, so they should never receive delta-encoded entities
+			if (entityData.delta)
+				return;
+
+			Packets::Helper::EntityData& data = it.value().data;
+			if (packet.isQuantized)
+			{
+				data.position = m_stateQuantizer->DequantizePosition(entityData.quantizedPosition);
+				data.rotation = m_stateQuantizer->DequantizeAngle(entityData.quantizedRotation);
+			}
+			else
+			{
+				data.position = entityData.position;
+				data.rotation = entityData.rotation;
+			}
+
+			if (entityData.playerMovement)
+			{
+				auto& playerMovement = data.playerMovement.emplace();
+				playerMovement.isFacingRight = entityData.playerMovement->isFacingRight;
+			}
+
+			if (entityData.physicsProperties && data.physicsProperties)
+			{
+				if (packet.isQuantized)
+				{
+					data.physicsProperties->angularVelocity = m_stateQuantizer->DequantizeAngularVelocity(entityData.physicsProperties->quantizedAngularVelocity);
+					data.physicsProperties->linearVelocity = m_stateQuantizer->DequantizeLinearVelocity(entityData.physicsProperties->quantizedLinearVelocity);
+				}
+				else
+				{
+					data.physicsProperties->angularVelocity = entityData.physicsProperties->angularVelocity;
+					data.physicsProperties->linearVelocity = entityData.physicsProperties->linearVelocity;
+				}
+			}
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::NetworkStrings& packet)
+	{
+		std::size_t startId = packet.startId;
+		if (m_networkStrings.size() < startId + packet.strings.size())
+			m_networkStrings.resize(startId + packet.strings.size());
+
+		std::copy(packet.strings.begin(), packet.strings.end(), m_networkStrings.begin() + startId);
+	}
+
+	void MatchStateMirror::Apply(const Packets::PlayerControlEntity& packet)
+	{
+		if (auto it = m_players.find(packet.playerIndex); it != m_players.end())
+			it.value().controlledEntityId = packet.controlledEntityId;
+	}
+
+	void MatchStateMirror::Apply(const Packets::PlayerJoined& packet)
+	{
+		Player& player = m_players[packet.playerIndex];
+		player = Player{};
+		player.name = packet.playerName;
+	}
+
+	void MatchStateMirror::Apply(const Packets::PlayerLeaving& packet)
+	{
+		m_players.erase(packet.playerIndex);
+	}
+
+	void MatchStateMirror::Apply(const Packets::PlayerNameUpdate& packet)
+	{
+		if (auto it = m_players.find(packet.playerIndex); it != m_players.end())
+			it.value().name = packet.newName;
+	}
+
+	void MatchStateMirror::Apply(const Packets::RecycleEntities& packet)
+	{
+		ForEachLayerEntity(packet, [](Layer& layer, const Packets::RecycleEntities::Entity& entityData)
+		{
+			if (auto it = layer.entities.find(entityData.id); it != layer.entities.end())
+				it.value().isRecycled = true;
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::RespawnEntities& packet)
+	{
+		ForEachLayerEntity(packet, [](Layer& layer, const Packets::RespawnEntities::Entity& entityData)
+		{
+			auto it = layer.entities.find(entityData.id);
+			if (it == layer.entities.end())
+				return;
+
+			Entity& entity = it.value();
+			entity.isRecycled = false;
+
+			Packets::Helper::EntityData& data = entity.data;
+			data.ownerPlayerIndex = entityData.ownerPlayerIndex;
+			data.physicsProperties = entityData.physicsProperties;
+			data.position = entityData.position;
+			data.rotation = entityData.rotation;
+			data.uniqueId = entityData.uniqueId;
+
+			if (entityData.currentHealth && data.health)
+				data.health->currentHealth = *entityData.currentHealth;
+
+			// Respawned properties override the recycled entity ones
+			for (const auto& property : entityData.properties)
+			{
+				auto propertyIt = std::find_if(data.properties.begin(), data.properties.end(), [&](const auto& entityProperty) { return entityProperty.name == property.name; });
+				if (propertyIt != data.properties.end())
+					propertyIt->value = property.value;
+				else
+					data.properties.push_back(property);
+			}
+		});
+	}
+
+	void MatchStateMirror::Apply(const Packets::TickRateUpdate& packet)
+	{
+		// Spectators catching up get the new rate right away, those already there switch with upstream
+		if (m_matchData)
+			m_matchData->tickDuration = packet.tickDuration;
+	}
+
+	auto MatchStateMirror::GetLayer(Nz::UInt16 layerIndex) -> Layer*
+	{
+		if (layerIndex >= m_layers.size())
+		{
+			bwLog(m_logger, LogLevel::Error, "received packet for unknown layer #{0}", layerIndex);
+			return nullptr;
+		}
+
+		return &m_layers[layerIndex];
+	}
+}
@@ -4,6 +4,7 @@
 
 #include <CoreLib/Mod.hpp>
 #include <CoreLib/LogSystem/Logger.hpp>
+#include <CoreLib/PackFile.hpp>
 #include <Nazara/Core/File.hpp>
 #include <nlohmann/json.hpp>
 
@@ -43,6 +44,10 @@ namespace bw
 				}
 			}
 		}
+
+		// Scripts may also be shipped as a single pack file (see BurgWarMapTool --pack), loose script files override packed ones
+		if (std::filesystem::path scriptPack = m_modDirectory / "scripts.bwpack"; std::filesystem::is_regular_file(scriptPack))
+			m_scriptPack = std::make_shared<const PackFile>(scriptPack);
 	}
 
 	Mod Mod::LoadFromDirectory(const std::filesystem::path& modDirectory)
@@ -5,6 +5,7 @@
 #include <CoreLib/NetworkReactor.hpp>
 #include <CoreLib/Config.hpp>
 #include <CoreLib/Utils.hpp>
+#include <CoreLib/Utility/Profiling.hpp>
 #include <cassert>
 #include <condition_variable>
 #include <mutex>
@@ -12,8 +13,9 @@
 
 namespace bw
 {
-	NetworkReactor::NetworkReactor(std::size_t firstId, Nz::NetProtocol protocol, Nz::UInt16 port, std::size_t maxClient) :
+	NetworkReactor::NetworkReactor(std::size_t firstId, Nz::NetProtocol protocol, Nz::UInt16 port, std::size_t maxClient, PacketDecoder packetDecoder) :
 	m_firstId(firstId),
+	m_packetDecoder(std::move(packetDecoder)),
 	m_protocol(protocol)
 	{
 		if (port > 0)
@@ -25,6 +27,9 @@ namespace bw
 			throw std::runtime_error("failed to start reactor");
 
 		m_clients.resize(maxClient, nullptr);
+		m_probePeers.resize(maxClient, false);
+		m_incomingEvents.resize(EventBulkSize);
+		m_outgoingEvents.resize(EventBulkSize);
 
 		m_running.store(true, std::memory_order_release);
 		m_thread = Nz::Thread(&NetworkReactor::WorkerThread, this);
@@ -113,19 +118,61 @@ namespace bw
 		m_outgoingQueue.enqueue(std::move(outgoingData));
 	}
 
+	void NetworkReactor::SendDeferredData(std::size_t peerId, Nz::UInt8 channelId, Nz::ENetPacketFlags flags, SerializationJob serializationJob)
+	{
+		assert(peerId >= m_firstId);
+
+		OutgoingEvent::DeferredPacketEvent packetEvent;
+		packetEvent.channelId = channelId;
+		packetEvent.flags = flags;
+		packetEvent.serializationJob = std::move(serializationJob);
+
+		OutgoingEvent outgoingData;
+		outgoingData.peerId = peerId - m_firstId;
+		outgoingData.data = std::move(packetEvent);
+
+		m_outgoingQueue.enqueue(std::move(outgoingData));
+	}
+
+	void NetworkReactor::SendSharedData(std::size_t peerId, SharedPacketRef packet)
+	{
+		assert(peerId >= m_firstId);
+
+		OutgoingEvent::SharedPacketEvent packetEvent;
+		packetEvent.packet = std::move(packet);
+
+		OutgoingEvent outgoingData;
+		outgoingData.peerId = peerId - m_firstId;
+		outgoingData.data = std::move(packetEvent);
+
+		m_outgoingQueue.enqueue(std::move(outgoingData));
+	}
+
 	void NetworkReactor::WorkerThread()
 	{
 		moodycamel::ConsumerToken connectionToken(m_connectionRequests);
 		moodycamel::ConsumerToken outgoingToken(m_outgoingQueue);
 		moodycamel::ProducerToken incomingToken(m_incomingQueue);
 
+		bwProfileThreadName("Network reactor");
+
 		while (m_running.load(std::memory_order_acquire))
 		{
-			ReceivePackets(incomingToken);
-			SendPackets(incomingToken, outgoingToken);
+			{
+				bwProfileZone("Receive packets");
+				ReceivePackets(incomingToken);
+			}
+
+			{
+				bwProfileZone("Send packets");
+				SendPackets(incomingToken, outgoingToken);
+			}
 
 			// Handle connection requests last to treat disconnection request before connection requests
-			HandleConnectionRequests(connectionToken);
+			{
+				bwProfileZone("Connection requests");
+				HandleConnectionRequests(connectionToken);
+			}
 		}
 
 		EnsureProperDisconnection(incomingToken, outgoingToken);
@@ -218,6 +265,7 @@ namespace bw
 					{
 						Nz::UInt16 peerId = event.peer->GetPeerId();
 						m_clients[peerId] = nullptr;
+						m_probePeers[peerId] = false;
 
 						IncomingEvent::DisconnectEvent disconnectEvent;
 						disconnectEvent.data = event.data;
@@ -235,6 +283,7 @@ namespace bw
 					{
 						Nz::UInt16 peerId = event.peer->GetPeerId();
 						m_clients[peerId] = event.peer;
+						m_probePeers[peerId] = (event.type == Nz::ENetEventType::IncomingConnect && event.data == NetworkProbeData);
 
 						IncomingEvent::ConnectEvent connectEvent;
 						connectEvent.data = event.data;
@@ -252,12 +301,29 @@ namespace bw
 					{
 						Nz::UInt16 peerId = event.peer->GetPeerId();
 
-						IncomingEvent::PacketEvent packetEvent;
-						packetEvent.packet = std::move(event.packet->data);
+						// Probes get no session, whatever they send is dropped before being decoded
+						if (m_probePeers[peerId])
+							break;
 
 						IncomingEvent newEvent;
 						newEvent.peerId = m_firstId + peerId;
-						newEvent.data.emplace<IncomingEvent::PacketEvent>(std::move(packetEvent));
+
+						if (m_packetDecoder)
+						{
+							// Big packets (entity creations, layers) would otherwise be decoded between two frames of the polling thread
+							IncomingEvent::TypedPacketEvent typedPacketEvent;
+							if (!m_packetDecoder(event.packet->data, typedPacketEvent.packet))
+								break; //< already logged by the decoder, the polling thread wouldn't do better
+
+							newEvent.data.emplace<IncomingEvent::TypedPacketEvent>(std::move(typedPacketEvent));
+						}
+						else
+						{
+							IncomingEvent::PacketEvent packetEvent;
+							packetEvent.packet = std::move(event.packet->data);
+
+							newEvent.data.emplace<IncomingEvent::PacketEvent>(std::move(packetEvent));
+						}
 
 						m_incomingQueue.enqueue(producterToken, std::move(newEvent));
 						break;
@@ -273,77 +339,120 @@ namespace bw
 
 	void NetworkReactor::SendPackets(const moodycamel::ProducerToken& producterToken, moodycamel::ConsumerToken& token)
 	{
-		OutgoingEvent outEvent;
-		while (m_outgoingQueue.try_dequeue(token, outEvent))
+		std::size_t eventCount;
+		while ((eventCount = m_outgoingQueue.try_dequeue_bulk(token, m_outgoingEvents.begin(), m_outgoingEvents.size())) > 0)
 		{
-			std::visit([&](auto&& arg) {
-				using T = std::decay_t<decltype(arg)>;
-				if constexpr (std::is_same_v<T, OutgoingEvent::DisconnectEvent>)
-				{
-					if (Nz::ENetPeer* peer = m_clients[outEvent.peerId])
+			for (std::size_t i = 0; i < eventCount; ++i)
+			{
+				OutgoingEvent& outEvent = m_outgoingEvents[i];
+				std::visit([&](auto&& arg) {
+					using T = std::decay_t<decltype(arg)>;
+					if constexpr (std::is_same_v<T, OutgoingEvent::DisconnectEvent>)
 					{
-						switch (arg.type)
+						if (Nz::ENetPeer* peer = m_clients[outEvent.peerId])
 						{
-							case DisconnectionType::Kick:
+							switch (arg.type)
 							{
-								peer->DisconnectNow(arg.data);
+								case DisconnectionType::Kick:
+								{
+									peer->DisconnectNow(arg.data);
 
-								// DisconnectNow does not generate Disconnect event
-								m_clients[outEvent.peerId] = nullptr;
+									// DisconnectNow does not generate Disconnect event
+									m_clients[outEvent.peerId] = nullptr;
 
-								IncomingEvent newEvent;
-								newEvent.peerId = m_firstId + outEvent.peerId;
+									IncomingEvent newEvent;
+									newEvent.peerId = m_firstId + outEvent.peerId;
 
-								auto& disconnectEvent = newEvent.data.emplace<IncomingEvent::DisconnectEvent>();
-								disconnectEvent.data = 0;
+									auto& disconnectEvent = newEvent.data.emplace<IncomingEvent::DisconnectEvent>();
+									disconnectEvent.data = 0;
 
-								m_incomingQueue.enqueue(producterToken, std::move(newEvent));
-								break;
-							}
+									m_incomingQueue.enqueue(producterToken, std::move(newEvent));
+									break;
+								}
 
-							case DisconnectionType::Later:
-								peer->DisconnectLater(arg.data);
-								break;
+								case DisconnectionType::Later:
+									peer->DisconnectLater(arg.data);
+									break;
 
-							case DisconnectionType::Normal:
-								peer->Disconnect(arg.data);
-								break;
+								case DisconnectionType::Normal:
+									peer->Disconnect(arg.data);
+									break;
 
-							default:
-								assert(!"Unknown disconnection type");
-								break;
+								default:
+									assert(!"Unknown disconnection type");
+									break;
+							}
 						}
 					}
-				}
-				else if constexpr (std::is_same_v<T, OutgoingEvent::PacketEvent>)
-				{
-					if (Nz::ENetPeer* peer = m_clients[outEvent.peerId])
-						peer->Send(arg.channelId, arg.flags, std::move(arg.packet));
-				}
-				else if constexpr (std::is_same_v<T, OutgoingEvent::QueryPeerInfo>)
-				{
-					if (Nz::ENetPeer* peer = m_clients[outEvent.peerId])
+					else if constexpr (std::is_same_v<T, OutgoingEvent::DeferredPacketEvent>)
 					{
-						IncomingEvent newEvent;
-						newEvent.peerId = m_firstId + outEvent.peerId;
-
-						auto& peerInfo = newEvent.data.emplace<IncomingEvent::PeerInfoResponse>();
-						peerInfo.callback = std::move(arg.callback);
-						peerInfo.peerInfo.timeSinceLastReceive = m_host.GetServiceTime() - peer->GetLastReceiveTime();
-						peerInfo.peerInfo.ping = peer->GetRoundTripTime();
-						peerInfo.peerInfo.totalByteReceived = peer->GetTotalByteReceived();
-						peerInfo.peerInfo.totalByteSent = peer->GetTotalByteSent();
-						peerInfo.peerInfo.totalPacketLost = peer->GetTotalPacketLost();
-						peerInfo.peerInfo.totalPacketReceived = peer->GetTotalPacketReceived();
-						peerInfo.peerInfo.totalPacketSent = peer->GetTotalPacketSent();
+						if (Nz::ENetPeer* peer = m_clients[outEvent.peerId])
+						{
+							// Packet serialization happens here, off the simulation thread
+							Nz::NetPacket packet;
+							arg.serializationJob(packet);
+							packet.FlushBits();
 
-						m_incomingQueue.enqueue(producterToken, std::move(newEvent));
+							peer->Send(arg.channelId, arg.flags, std::move(packet));
+						}
 					}
-				}
-				else
-					static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
+					else if constexpr (std::is_same_v<T, OutgoingEvent::PacketEvent>)
+					{
+						if (Nz::ENetPeer* peer = m_clients[outEvent.peerId])
+							peer->Send(arg.channelId, arg.flags, std::move(arg.packet));
+					}
+					else if constexpr (std::is_same_v<T, OutgoingEvent::SharedPacketEvent>)
+					{
+						if (Nz::ENetPeer* peer = m_clients[outEvent.peerId])
+						{
+							// Allocate a single ENet packet for every peer it is sent to
+							auto it = m_sharedPackets.find(arg.packet.get());
+							if (it == m_sharedPackets.end())
+							{
+								const Nz::NetPacket& sharedData = arg.packet->data;
+								const Nz::UInt8* data = static_cast<const Nz::UInt8*>(sharedData.GetConstData()) + Nz::NetPacket::HeaderSize;
+
+								Nz::ENetPacketRef enetPacket = m_host.AllocatePacket(arg.packet->flags, Nz::NetPacket(sharedData.GetNetCode(), data, sharedData.GetDataSize()));
+								// Keep a reference on the shared packet so its address cannot be reused while it's in the map
+								it = m_sharedPackets.emplace(arg.packet.get(), std::make_pair(arg.packet, std::move(enetPacket))).first;
+							}
+
+							peer->Send(arg.packet->channelId, it->second.second);
+						}
+					}
+					else if constexpr (std::is_same_v<T, OutgoingEvent::QueryPeerInfo>)
+					{
+						if (Nz::ENetPeer* peer = m_clients[outEvent.peerId])
+						{
+							IncomingEvent newEvent;
+							newEvent.peerId = m_firstId + outEvent.peerId;
+
+							auto& peerInfo = newEvent.data.emplace<IncomingEvent::PeerInfoResponse>();
+							peerInfo.callback = std::move(arg.callback);
+							peerInfo.peerInfo.timeSinceLastReceive = m_host.GetServiceTime() - peer->GetLastReceiveTime();
+							peerInfo.peerInfo.ping = peer->GetRoundTripTime();
+							peerInfo.peerInfo.totalByteReceived = peer->GetTotalByteReceived();
+							peerInfo.peerInfo.totalByteSent = peer->GetTotalByteSent();
+							peerInfo.peerInfo.totalPacketLost = peer->GetTotalPacketLost();
+							peerInfo.peerInfo.totalPacketReceived = peer->GetTotalPacketReceived();
+							peerInfo.peerInfo.totalPacketSent = peer->GetTotalPacketSent();
+
+							m_incomingQueue.enqueue(producterToken, std::move(newEvent));
+						}
+					}
+					else
+						static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
+
+				}, outEvent.data);
 
-			}, outEvent.data);
+				outEvent.data = OutgoingEvent::DisconnectEvent{};
+			}
+
+			if (eventCount < m_outgoingEvents.size())
+				break;
 		}
+
+		// ENet keeps its own references on queued packets
+		m_sharedPackets.clear();
 	}
 }
@@ -36,9 +36,19 @@ namespace bw
 		});
 	}
 
+	void NetworkSessionBridge::SendDeferredPacket(Nz::UInt8 channelId, Nz::ENetPacketFlags flags, SerializationJob serializationJob)
+	{
+		m_reactor.SendDeferredData(m_peerId, channelId, flags, std::move(serializationJob));
+	}
+
 	void NetworkSessionBridge::SendPacket(Nz::UInt8 channelId, Nz::ENetPacketFlags flags, Nz::NetPacket && packet)
 	{
 		packet.FlushBits();
 		m_reactor.SendData(m_peerId, channelId, flags, std::move(packet));
 	}
+
+	void NetworkSessionBridge::SendSharedPacket(const SharedPacketRef& packet)
+	{
+		m_reactor.SendSharedData(m_peerId, packet);
+	}
 }
@@ -3,60 +3,107 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/NetworkSessionManager.hpp>
+#include <CoreLib/Config.hpp>
 #include <CoreLib/MatchClientSession.hpp>
 #include <CoreLib/NetworkSessionBridge.hpp>
 #include <CoreLib/Match.hpp>
 #include <CoreLib/MatchSessions.hpp>
 #include <CoreLib/LogSystem/Logger.hpp>
+#include <algorithm>
+#include <cassert>
+#include <iterator>
 
 namespace bw
 {
-	NetworkSessionManager::NetworkSessionManager(MatchSessions* owner, Nz::UInt16 port, std::size_t maxClient) :
+	NetworkSessionManager::NetworkSessionManager(MatchSessions* owner, Nz::UInt16 port, std::size_t maxClient, std::size_t reactorCount) :
 	SessionManager(owner),
-	m_reactor(0, Nz::NetProtocol_Any, port, maxClient)
+	m_maxClientPerReactor(maxClient)
 	{
+		assert(reactorCount > 0);
+
+		// Each reactor runs its own network thread and listens on its own port, clients first connect to the first one and are redirected to the least busy one
+		m_reactorSessionCount.resize(reactorCount, 0);
+		m_reactors.reserve(reactorCount);
+		for (std::size_t i = 0; i < reactorCount; ++i)
+			m_reactors.emplace_back(std::make_unique<NetworkReactor>(i * maxClient, Nz::NetProtocol_Any, Nz::UInt16(port + i), maxClient));
 	}
 
 	NetworkSessionManager::~NetworkSessionManager() = default;
 
 	void NetworkSessionManager::Poll()
 	{
-		m_reactor.Poll([&](bool outgoing, std::size_t peerId, Nz::UInt32 data) { HandlePeerConnection(outgoing, peerId, data); },
-		               [&](std::size_t peerId, Nz::UInt32 data) { HandlePeerDisconnection(peerId, data); },
-		               [&](std::size_t peerId, Nz::NetPacket&& packet) { HandlePeerPacket(peerId, std::move(packet)); });
+		for (const auto& reactorPtr : m_reactors)
+		{
+			reactorPtr->Poll([&](bool outgoing, std::size_t peerId, Nz::UInt32 data) { HandlePeerConnection(outgoing, peerId, data); },
+			                 [&](std::size_t peerId, Nz::UInt32 data) { HandlePeerDisconnection(peerId, data); },
+			                 [&](std::size_t peerId, Nz::NetPacket&& packet) { HandlePeerPacket(peerId, std::move(packet)); });
+		}
 	}
 
-	void NetworkSessionManager::HandlePeerConnection(bool /*outgoing*/, std::size_t peerId, Nz::UInt32 /*data*/)
+	void NetworkSessionManager::HandlePeerConnection(bool /*outgoing*/, std::size_t peerId, Nz::UInt32 data)
 	{
+		std::size_t reactorIndex = GetReactorIndex(peerId);
+		NetworkReactor& reactor = *m_reactors[reactorIndex];
+
+		if (data == NetworkProbeData)
+		{
+			// Server list only measures its round trip time to us, no session is created for this peer either
+			reactor.DisconnectPeer(peerId, 0, DisconnectionType::Later);
+			return;
+		}
+
+		if (reactorIndex == 0 && m_reactors.size() > 1)
+		{
+			auto it = std::min_element(m_reactorSessionCount.begin(), m_reactorSessionCount.end());
+			std::size_t bestReactorIndex = std::distance(m_reactorSessionCount.begin(), it);
+			if (bestReactorIndex != reactorIndex && *it < m_reactorSessionCount[reactorIndex])
+			{
+				bwLog(GetOwner()->GetMatch().GetLogger(), LogLevel::Info, "Peer #{0} connected, redirecting it to network thread #{1}", peerId, bestReactorIndex);
+
+				// No session is created for this peer, its disconnection will be ignored
+				reactor.DisconnectPeer(peerId, NetworkRedirectFlag | Nz::UInt32(bestReactorIndex), DisconnectionType::Later);
+				return;
+			}
+		}
+
 		bwLog(GetOwner()->GetMatch().GetLogger(), LogLevel::Info, "Peer #{0} connected", peerId);
 
-		std::shared_ptr<NetworkSessionBridge> clientBridge = std::make_shared<NetworkSessionBridge>(m_reactor, peerId);
+		if (peerId >= m_peers.size())
+			m_peers.resize(peerId + 1);
 
-		MatchClientSession* session = GetOwner()->CreateSession(std::move(clientBridge));
+		Peer& peer = m_peers[peerId];
+		peer.bridge = std::make_shared<NetworkSessionBridge>(reactor, peerId);
+		peer.bridge->HandleConnection(data);
 
-		if (peerId >= m_peerIdToSession.size())
-			m_peerIdToSession.resize(peerId + 1);
+		peer.session = GetOwner()->CreateSession(peer.bridge);
 
-		m_peerIdToSession[peerId] = session;
+		m_reactorSessionCount[reactorIndex]++;
 	}
 
-	void NetworkSessionManager::HandlePeerDisconnection(std::size_t peerId, Nz::UInt32 /*data*/)
+	void NetworkSessionManager::HandlePeerDisconnection(std::size_t peerId, Nz::UInt32 data)
 	{
+		if (peerId >= m_peers.size() || !m_peers[peerId].session)
+			return; //< Redirected peer
+
 		bwLog(GetOwner()->GetMatch().GetLogger(), LogLevel::Info, "Peer #{0} disconnected", peerId);
 
-		MatchClientSession*& session = m_peerIdToSession[peerId];
-		assert(session);
+		Peer& peer = m_peers[peerId];
+		peer.bridge->HandleDisconnection(data);
+
+		GetOwner()->DeleteSession(peer.session);
+		peer.bridge.reset();
+		peer.session = nullptr;
 
-		GetOwner()->DeleteSession(session);
-		session = nullptr;
+		m_reactorSessionCount[GetReactorIndex(peerId)]--;
 	}
 
 	void NetworkSessionManager::HandlePeerPacket(std::size_t peerId, Nz::NetPacket&& packet)
 	{
-		MatchClientSession* session = m_peerIdToSession[peerId];
-		assert(session);
+		// Redirected and probe peers have no bridge but may still send packets until their disconnection goes through
+		if (peerId >= m_peers.size() || !m_peers[peerId].bridge)
+			return;
 
 		//bwLog(m_logger, LogLevel::Info, "Peer #{0} sent packet", peerId);
-		session->HandleIncomingPacket(packet);
+		m_peers[peerId].bridge->HandleIncomingPacket(packet);
 	}
 }
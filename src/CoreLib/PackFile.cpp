@@ -0,0 +1,253 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/PackFile.hpp>
+#include <CoreLib/BinaryMapReader.hpp>
+#include <CoreLib/Protocol/CompressedInteger.hpp>
+#include <CoreLib/Utility/MemoryMappedFile.hpp>
+#include <Nazara/Core/ByteStream.hpp>
+#include <Nazara/Core/ErrorFlags.hpp>
+#include <Nazara/Core/File.hpp>
+#include <Nazara/Core/MemoryView.hpp>
+#include <lz4.h>
+#include <lz4hc.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace bw
+{
+	namespace
+	{
+		constexpr std::size_t CompressionThreshold = 128; //< smaller files are never compressed
+
+		constexpr std::size_t AlignOffset(std::size_t offset)
+		{
+			return (offset + PackFile::BlobAlignment - 1) / PackFile::BlobAlignment * PackFile::BlobAlignment;
+		}
+	}
+
+	PackFile::PackFile(const std::filesystem::path& packFile)
+	{
+		std::shared_ptr<MemoryMappedFile> mapping = std::make_shared<MemoryMappedFile>();
+		if (mapping->Open(packFile))
+		{
+			m_data = mapping->GetData();
+			m_size = mapping->GetSize();
+			m_mapping = std::move(mapping);
+		}
+		else
+		{
+			Nz::File file(packFile.generic_u8string(), Nz::OpenMode_ReadOnly);
+			if (!file.IsOpen())
+				throw std::runtime_error("failed to open pack file");
+
+			m_content.resize(file.GetSize());
+			if (file.Read(m_content.data(), m_content.size()) != m_content.size())
+				throw std::runtime_error("failed to read pack file");
+
+			m_data = m_content.data();
+			m_size = m_content.size();
+		}
+
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		Nz::MemoryView fileView(m_data, m_size);
+
+		Nz::ByteStream stream(&fileView);
+		stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		std::array<char, 8> signature;
+		if (stream.Read(signature.data(), signature.size()) != signature.size())
+			throw std::runtime_error("corrupted pack file (or not a burger pack file)");
+
+		if (std::memcmp(signature.data(), "Burgpack", signature.size()) != 0)
+			throw std::runtime_error("not a valid burger pack file");
+
+		Nz::UInt16 fileVersion;
+		stream >> fileVersion;
+
+		if (fileVersion > FileVersion)
+			throw std::runtime_error("unhandled pack file version (more recent than game)");
+
+		CompressedUnsigned<Nz::UInt32> entryCount;
+		stream >> entryCount;
+
+		m_entries.resize(entryCount);
+		for (Entry& entry : m_entries)
+		{
+			stream >> entry.path >> entry.offset >> entry.size;
+			entry.uncompressedSize = entry.size;
+
+			Nz::UInt8 compression;
+			stream >> compression;
+
+			entry.compression = static_cast<Compression>(compression);
+			switch (entry.compression)
+			{
+				case Compression::None:
+					break;
+
+				case Compression::LZ4:
+					stream >> entry.uncompressedSize;
+					break;
+
+				default:
+					throw std::runtime_error("unhandled pack entry compression " + std::to_string(compression));
+			}
+
+			if (stream.Read(entry.checksum.data(), entry.checksum.size()) != entry.checksum.size())
+				throw std::runtime_error("corrupted pack file (truncated index)");
+		}
+
+		m_contentOffset = AlignOffset(static_cast<std::size_t>(fileView.GetCursorPos()));
+
+		// Check the index once, lookups rely on it being sorted and reads on entries being in bounds
+		for (std::size_t i = 0; i < m_entries.size(); ++i)
+		{
+			const Entry& entry = m_entries[i];
+			if (i > 0 && m_entries[i - 1].path >= entry.path)
+				throw std::runtime_error("corrupted pack file (index is not sorted)");
+
+			if (m_contentOffset > m_size || entry.offset > m_size - m_contentOffset || entry.size > m_size - m_contentOffset - entry.offset)
+				throw std::runtime_error("corrupted pack file (" + entry.path + " is out of bounds)");
+		}
+	}
+
+	bool PackFile::HasDirectory(const std::string_view& directoryPrefix) const
+	{
+		auto it = LowerBound(directoryPrefix);
+		return it != m_entries.end() && it->path.compare(0, directoryPrefix.size(), directoryPrefix) == 0;
+	}
+
+	const Nz::UInt8* PackFile::ReadEntry(const Entry& entry, std::vector<Nz::UInt8>& buffer) const
+	{
+		// Bounds were checked when parsing index
+		const Nz::UInt8* entryData = m_data + m_contentOffset + entry.offset;
+		std::size_t entrySize = static_cast<std::size_t>(entry.size);
+
+		if (BinaryMapReader::ComputeChecksum(entryData, entrySize) != entry.checksum)
+			throw std::runtime_error("corrupted pack file (" + entry.path + " checksum mismatch)");
+
+		switch (entry.compression)
+		{
+			case Compression::None:
+				return entryData;
+
+			case Compression::LZ4:
+			{
+				if (entry.size > std::size_t(std::numeric_limits<int>::max()) || entry.uncompressedSize > MaxUncompressedSize)
+					throw std::runtime_error("corrupted pack file (" + entry.path + " is too large)");
+
+				buffer.resize(static_cast<std::size_t>(entry.uncompressedSize));
+
+				int decompressedSize = LZ4_decompress_safe(reinterpret_cast<const char*>(entryData), reinterpret_cast<char*>(buffer.data()), int(entrySize), int(buffer.size()));
+				if (decompressedSize < 0 || std::size_t(decompressedSize) != buffer.size())
+					throw std::runtime_error("corrupted pack file (failed to decompress " + entry.path + ")");
+
+				return buffer.data();
+			}
+		}
+
+		throw std::runtime_error("unhandled pack entry compression");
+	}
+
+	bool PackFile::Build(const std::filesystem::path& outputPath, std::vector<SourceFile> files, bool compressFiles)
+	{
+		for (SourceFile& file : files)
+			std::replace(file.path.begin(), file.path.end(), '\\', '/');
+
+		std::sort(files.begin(), files.end(), [](const SourceFile& lhs, const SourceFile& rhs) { return lhs.path < rhs.path; });
+
+		auto duplicateIt = std::adjacent_find(files.begin(), files.end(), [](const SourceFile& lhs, const SourceFile& rhs) { return lhs.path == rhs.path; });
+		if (duplicateIt != files.end())
+			return false;
+
+		// Every file is stored first as the index (written before them) holds their offsets and sizes
+		std::vector<Entry> entries;
+		entries.reserve(files.size());
+
+		std::vector<Nz::UInt8> blobData;
+		std::vector<Nz::UInt8> compressedData;
+		std::vector<Nz::UInt8> fileContent;
+		for (const SourceFile& file : files)
+		{
+			Nz::File sourceFile(file.physicalPath.generic_u8string(), Nz::OpenMode_ReadOnly);
+			if (!sourceFile.IsOpen())
+				return false;
+
+			fileContent.resize(sourceFile.GetSize());
+			if (sourceFile.Read(fileContent.data(), fileContent.size()) != fileContent.size())
+				return false;
+
+			const Nz::UInt8* data = fileContent.data();
+			std::size_t size = fileContent.size();
+
+			Entry& entry = entries.emplace_back();
+			entry.path = file.path;
+			entry.offset = blobData.size();
+			entry.uncompressedSize = size;
+
+			// Already compressed assets (such as images) are kept raw as compressing them doesn't help
+			if (compressFiles && size >= CompressionThreshold && size <= MaxUncompressedSize)
+			{
+				int maxCompressedSize = LZ4_compressBound(int(size));
+				compressedData.resize(maxCompressedSize);
+
+				int compressedSize = LZ4_compress_HC(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(compressedData.data()), int(size), maxCompressedSize, LZ4HC_CLEVEL_MAX);
+				if (compressedSize > 0 && std::size_t(compressedSize) < size)
+				{
+					entry.compression = Compression::LZ4;
+					data = compressedData.data();
+					size = std::size_t(compressedSize);
+				}
+			}
+
+			entry.size = size;
+			entry.checksum = BinaryMapReader::ComputeChecksum(data, size);
+
+			blobData.insert(blobData.end(), data, data + size);
+			blobData.resize(AlignOffset(blobData.size()));
+		}
+
+		Nz::File packFile(outputPath.generic_u8string(), Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate);
+		if (!packFile.IsOpen())
+			return false;
+
+		Nz::ByteStream stream(&packFile);
+		stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+		stream.Write("Burgpack", 8);
+		stream << FileVersion;
+
+		CompressedUnsigned<Nz::UInt32> entryCount(Nz::UInt32(entries.size()));
+		stream << entryCount;
+
+		for (const Entry& entry : entries)
+		{
+			stream << entry.path << entry.offset << entry.size;
+			stream << static_cast<Nz::UInt8>(entry.compression);
+			if (entry.compression != Compression::None)
+				stream << entry.uncompressedSize;
+
+			stream.Write(entry.checksum.data(), entry.checksum.size());
+		}
+
+		// Pad index so blobs are aligned in the file
+		std::size_t indexSize = static_cast<std::size_t>(packFile.GetCursorPos());
+		std::array<Nz::UInt8, BlobAlignment> padding = {};
+		stream.Write(padding.data(), AlignOffset(indexSize) - indexSize);
+
+		if (stream.Write(blobData.data(), blobData.size()) != blobData.size())
+			return false;
+
+		return true;
+	}
+
+	auto PackFile::LowerBound(const std::string_view& path) const -> std::vector<Entry>::const_iterator
+	{
+		return std::lower_bound(m_entries.begin(), m_entries.end(), path, [](const Entry& entry, const std::string_view& searchedPath) { return entry.path < searchedPath; });
+	}
+}
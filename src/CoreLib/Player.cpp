@@ -31,10 +31,11 @@
 
 namespace bw
 {
-	Player::Player(Match& match, MatchClientSession& session, std::size_t playerIndex, Nz::UInt8 localIndex, std::string playerName) :
+	Player::Player(Match& match, MatchClientSession& session, std::size_t playerIndex, Nz::UInt8 localIndex, std::string playerName, std::string reconnectToken) :
 	m_layerIndex(NoLayer),
 	m_playerIndex(playerIndex),
 	m_name(std::move(playerName)),
+	m_reconnectToken(std::move(reconnectToken)),
 	m_localIndex(localIndex),
 	m_match(match),
 	m_session(session),
@@ -49,6 +50,9 @@ namespace bw
 		MatchClientVisibility& visibility = GetSession().GetVisibility();
 		for (std::size_t layerIndex = m_visibleLayers.FindFirst(); layerIndex != m_visibleLayers.npos; layerIndex = m_visibleLayers.FindNext(layerIndex))
 			visibility.HideLayer(static_cast<LayerIndex>(layerIndex));
+
+		for (std::size_t layerIndex = m_prefetchedLayers.FindFirst(); layerIndex != m_prefetchedLayers.npos; layerIndex = m_prefetchedLayers.FindNext(layerIndex))
+			visibility.HideLayer(static_cast<LayerIndex>(layerIndex), true);
 	}
 
 	void Player::HandleConsoleCommand(const std::string& str)
@@ -75,7 +79,13 @@ namespace bw
 			});
 		}
 
-		m_scriptingEnvironment->Execute(str);
+		// Built-in shortcuts
+		if (str == "memory")
+			m_scriptingEnvironment->Execute("print(match.GetMemoryReport())");
+		else if (str == "profile")
+			m_scriptingEnvironment->Execute("print(match.GetTickProfile())");
+		else
+			m_scriptingEnvironment->Execute(str);
 	}
 
 	void Player::MoveToLayer(LayerIndex layerIndex)
@@ -84,8 +94,7 @@ namespace bw
 		{
 			m_match.GetGamemode()->ExecuteCallback<GamemodeEvent::PlayerLayerUpdate>(CreateHandle(), m_layerIndex, layerIndex);
 
-			if (m_layerIndex != NoLayer)
-				UpdateLayerVisibility(m_layerIndex, false);
+			LayerIndex previousLayerIndex = m_layerIndex;
 
 			if (m_layerIndex != NoLayer && layerIndex != NoLayer)
 			{
@@ -144,6 +153,12 @@ namespace bw
 
 			if (m_layerIndex != NoLayer)
 				UpdateLayerVisibility(m_layerIndex, true);
+
+			UpdatePrefetchedLayers();
+
+			// Hidden last so a layer staying visible (as the new layer or a prefetched one) isn't sent again
+			if (previousLayerIndex != NoLayer)
+				UpdateLayerVisibility(previousLayerIndex, false);
 		}
 	}
 
@@ -296,7 +311,10 @@ namespace bw
 			throw std::runtime_error("Layer index out of bounds");
 
 		if (isVisible)
+		{
+			m_match.GetTerrain().ActivateLayer(layerIndex);
 			visibility.ShowLayer(layerIndex);
+		}
 		else
 			visibility.HideLayer(layerIndex);
 
@@ -353,4 +371,36 @@ namespace bw
 		assert(!m_isReady);
 		m_isReady = true;
 	}
+
+	void Player::UpdatePrefetchedLayers()
+	{
+		Terrain& terrain = m_match.GetTerrain();
+
+		Nz::Bitset<Nz::UInt64> prefetchedLayers;
+		if (m_layerIndex != NoLayer)
+		{
+			for (LayerIndex adjacentLayer : terrain.GetAdjacentLayers(m_layerIndex))
+				prefetchedLayers.UnboundedSet(adjacentLayer);
+		}
+
+		// New layers are shown before old ones are hidden, so a layer adjacent to both isn't released in between
+		MatchClientVisibility& visibility = GetSession().GetVisibility();
+		for (std::size_t i = prefetchedLayers.FindFirst(); i != prefetchedLayers.npos; i = prefetchedLayers.FindNext(i))
+		{
+			if (m_prefetchedLayers.UnboundedTest(i))
+				continue;
+
+			LayerIndex layerIndex = static_cast<LayerIndex>(i);
+			terrain.ActivateLayer(layerIndex);
+			visibility.ShowLayer(layerIndex, true);
+		}
+
+		for (std::size_t i = m_prefetchedLayers.FindFirst(); i != m_prefetchedLayers.npos; i = m_prefetchedLayers.FindNext(i))
+		{
+			if (!prefetchedLayers.UnboundedTest(i))
+				visibility.HideLayer(static_cast<LayerIndex>(i), true);
+		}
+
+		m_prefetchedLayers = std::move(prefetchedLayers);
+	}
 }
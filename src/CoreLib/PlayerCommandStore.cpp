@@ -4,6 +4,7 @@
 
 #include <CoreLib/PlayerCommandStore.hpp>
 #include <CoreLib/MatchClientSession.hpp>
+#include <CoreLib/Protocol/PacketCompression.hpp>
 #include <CoreLib/Protocol/Packets.hpp>
 
 namespace bw
@@ -11,14 +12,18 @@ namespace bw
 	PlayerCommandStore::PlayerCommandStore(const Logger& logger) :
 	CommandStore(logger)
 	{
+		// Peers are untrusted clients, don't let them claim multi-megabyte payloads
+		SetMaxUncompressedSize(PacketMaxServerBoundUncompressedSize);
+
 #define IncomingCommand(Type) RegisterIncomingCommand<Packets::Type>(#Type, [](MatchClientSession& session, Packets::Type&& packet) \
 { \
 	session.HandleIncomingPacket(std::move(packet)); \
 })
-#define OutgoingCommand(Type, Flags, Channel) RegisterOutgoingCommand<Packets::Type>(#Type, Flags, Channel)
+#define OutgoingCommand(Type, ...) RegisterOutgoingCommand<Packets::Type>(#Type, __VA_ARGS__)
 
 		// Incoming commands
 		IncomingCommand(Auth);
+		IncomingCommand(DownloadClientFileAck);
 		IncomingCommand(DownloadClientFileRequest);
 		IncomingCommand(PlayerChat);
 		IncomingCommand(PlayerConsoleCommand);
@@ -28,7 +33,7 @@ namespace bw
 		IncomingCommand(ScriptPacket);
 		IncomingCommand(UpdatePlayerName);
 
-		// Outgoing commands
+		// Outgoing commands (last parameter enables payload compression, for large and redundant packets)
 		OutgoingCommand(AuthFailure,                  Nz::ENetPacketFlag_Reliable,    0);
 		OutgoingCommand(AuthSuccess,                  Nz::ENetPacketFlag_Reliable,    0);
 		OutgoingCommand(ChatMessage,                  Nz::ENetPacketFlag_Reliable,    0);
@@ -36,32 +41,35 @@ namespace bw
 		OutgoingCommand(ClientScriptList,             Nz::ENetPacketFlag_Reliable,    0);
 		OutgoingCommand(ConsoleAnswer,                Nz::ENetPacketFlag_Reliable,    0);
 		OutgoingCommand(ControlEntity,                Nz::ENetPacketFlag_Reliable,    1);
-		OutgoingCommand(CreateEntities,               Nz::ENetPacketFlag_Reliable,    1);
+		OutgoingCommand(CreateEntities,               Nz::ENetPacketFlag_Reliable,    1, true);
 		OutgoingCommand(DeleteEntities,               Nz::ENetPacketFlag_Reliable,    1);
 		OutgoingCommand(DisableLayer,                 Nz::ENetPacketFlag_Reliable,    1);
-		OutgoingCommand(DownloadClientFileFragment,   Nz::ENetPacketFlag_Reliable,    0);
+		OutgoingCommand(DownloadClientFileFragment,   Nz::ENetPacketFlag_Reliable,    0, true);
 		OutgoingCommand(DownloadClientFileResponse,   Nz::ENetPacketFlag_Reliable,    0);
-		OutgoingCommand(EnableLayer,                  Nz::ENetPacketFlag_Reliable,    1);
+		OutgoingCommand(EnableLayer,                  Nz::ENetPacketFlag_Reliable,    1, true);
 		OutgoingCommand(EntitiesAnimation,            Nz::ENetPacketFlag_Reliable,    1);
 		OutgoingCommand(EntitiesDeath,                Nz::ENetPacketFlag_Reliable,    1);
 		OutgoingCommand(EntitiesInputs,               Nz::ENetPacketFlag_Reliable,    1);
+		OutgoingCommand(EntitiesPhysics,              Nz::ENetPacketFlag_Reliable,    1);
 		OutgoingCommand(EntitiesScale,                Nz::ENetPacketFlag_Reliable,    1);
-		OutgoingCommand(EntityPhysics,                Nz::ENetPacketFlag_Reliable,    1);
-		OutgoingCommand(EntityWeapon,                 Nz::ENetPacketFlag_Reliable,    1);
+		OutgoingCommand(EntitiesWeapon,               Nz::ENetPacketFlag_Reliable,    1);
 		OutgoingCommand(HealthUpdate,                 Nz::ENetPacketFlag_Reliable,    1);
 		OutgoingCommand(InputTimingCorrection,        Nz::ENetPacketFlag_Unsequenced, 0);
 		OutgoingCommand(MapReset,                     Nz::ENetPacketFlag_Reliable,    1);
-		OutgoingCommand(MatchData,                    Nz::ENetPacketFlag_Reliable,    0);
+		OutgoingCommand(MatchData,                    Nz::ENetPacketFlag_Reliable,    0, true);
 		OutgoingCommand(MatchState,                   0,                              1);
-		OutgoingCommand(NetworkStrings,               Nz::ENetPacketFlag_Reliable,    0);
+		OutgoingCommand(NetworkStrings,               Nz::ENetPacketFlag_Reliable,    0, true);
 		OutgoingCommand(PlayerControlEntity,          Nz::ENetPacketFlag_Reliable,    1);
 		OutgoingCommand(PlayerJoined,                 Nz::ENetPacketFlag_Reliable,    1);
 		OutgoingCommand(PlayerLayer,                  Nz::ENetPacketFlag_Reliable,    1);
 		OutgoingCommand(PlayerLeaving,                Nz::ENetPacketFlag_Reliable,    1);
 		OutgoingCommand(PlayerNameUpdate,             Nz::ENetPacketFlag_Reliable,    1);
-		OutgoingCommand(PlayerPingUpdate,             Nz::ENetPacketFlag_Reliable,    1);
+		OutgoingCommand(PlayerPingUpdate,             0,                              1);
 		OutgoingCommand(PlayerWeapons,                Nz::ENetPacketFlag_Reliable,    1);
+		OutgoingCommand(RecycleEntities,              Nz::ENetPacketFlag_Reliable,    1);
+		OutgoingCommand(RespawnEntities,              Nz::ENetPacketFlag_Reliable,    1);
 		OutgoingCommand(ScriptPacket,                 Nz::ENetPacketFlag_Reliable,    1);
+		OutgoingCommand(TickRateUpdate,               Nz::ENetPacketFlag_Reliable,    0);
 
 #undef IncomingCommand
 #undef OutgoingCommand
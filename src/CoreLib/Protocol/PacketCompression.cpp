@@ -0,0 +1,45 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Protocol/PacketCompression.hpp>
+#include <lz4.h>
+#include <limits>
+
+namespace bw
+{
+	bool CompressPacketPayload(const Nz::UInt8* data, std::size_t size, std::vector<Nz::UInt8>& compressedData)
+	{
+		if (size < PacketCompressionThreshold || size > PacketMaxUncompressedSize)
+			return false;
+
+		int maxCompressedSize = LZ4_compressBound(int(size));
+		compressedData.resize(maxCompressedSize);
+
+		int compressedSize = LZ4_compress_default(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(compressedData.data()), int(size), maxCompressedSize);
+		if (compressedSize <= 0)
+			return false;
+
+		// Account for the uncompressed size we have to send along
+		if (std::size_t(compressedSize) + sizeof(Nz::UInt32) >= size)
+			return false;
+
+		compressedData.resize(compressedSize);
+		return true;
+	}
+
+	bool DecompressPacketPayload(const Nz::UInt8* data, std::size_t size, std::size_t uncompressedSize, std::vector<Nz::UInt8>& uncompressedData)
+	{
+		if (uncompressedSize > PacketMaxUncompressedSize || size > std::size_t(std::numeric_limits<int>::max()))
+			return false;
+
+		// Reject impossible sizes before allocating them
+		if (Nz::UInt64(uncompressedSize) > Nz::UInt64(size) * PacketMaxCompressionRatio + 16)
+			return false;
+
+		uncompressedData.resize(uncompressedSize);
+
+		int decompressedSize = LZ4_decompress_safe(reinterpret_cast<const char*>(data), reinterpret_cast<char*>(uncompressedData.data()), int(size), int(uncompressedSize));
+		return decompressedSize >= 0 && std::size_t(decompressedSize) == uncompressedSize;
+	}
+}
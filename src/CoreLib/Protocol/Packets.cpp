@@ -8,51 +8,140 @@
 #include <Nazara/Math/Vector3.hpp>
 #include <Nazara/Math/Vector4.hpp>
 #include <CoreLib/Utils.hpp>
+#include <algorithm>
 #include <cassert>
 
 namespace bw
 {
+	namespace
+	{
+#define BURGWAR_PROPERTYTYPE(V, T, UT)
+#define BURGWAR_PROPERTYTYPE_LAST(V, T, UT) constexpr PropertyType PropertyTypeMax = PropertyType:: T;
+
+#include <CoreLib/PropertyTypeList.hpp>
+
+		// Appended to the authentication packets, peers which predate negotiation don't send it
+		void SerializeProtocolFeatures(PacketSerializer& serializer, ProtocolFeatureFlags& features)
+		{
+			if (!serializer.IsWriting() && serializer.IsAtEnd())
+			{
+				features = LegacyProtocolFeatures;
+				return;
+			}
+
+			CompressedUnsigned<Nz::UInt32> featureBits;
+			if (serializer.IsWriting())
+				featureBits = Nz::UInt32(static_cast<ProtocolFeatureFlags::BitField>(features));
+
+			serializer &= featureBits;
+
+			if (!serializer.IsWriting())
+			{
+				// Ignore features from newer versions
+				features = ProtocolFeatureFlags(static_cast<ProtocolFeatureFlags::BitField>(Nz::UInt32(featureBits))) & SupportedProtocolFeatures;
+			}
+		}
+	}
+
 	namespace Packets
 	{
-		std::size_t EstimateSize(const MatchState& matchState)
+		std::size_t EstimateHeaderSize(const MatchState& /*matchState*/)
 		{
 			std::size_t size = 0;
-			
+
 			size += sizeof(MatchState::lastInputTick);
 			size += sizeof(MatchState::stateTick);
-
 			size += sizeof(Nz::UInt8); // layer count
-			size += (sizeof(MatchState::Layer::layerIndex) + sizeof(MatchState::Layer::entityCount)) * matchState.layers.size();
 
-			// entity property bit size (2 bits per entity), rounded up
-			size += (matchState.entities.size() * 2 + 7) / 8;
+			return size;
+		}
 
-			size += (sizeof(MatchState::Entity::id) + sizeof(MatchState::Entity::position) + sizeof(MatchState::Entity::rotation)) * matchState.entities.size();
+		std::size_t EstimateSize(const MatchState& matchState)
+		{
+			std::size_t size = EstimateHeaderSize(matchState);
 
-			std::size_t playerEntity = 0;
-			std::size_t physicalEntity = 0;
+			for (auto& layer : matchState.layers)
+				size += EstimateSize(layer);
 
+			std::size_t propertyBitCount = 1; // quantization bit
 			for (auto& entity : matchState.entities)
+				size += EstimateSize(entity, matchState.isQuantized, propertyBitCount);
+
+			size += (propertyBitCount + 7) / 8; // rounded up
+
+			return size;
+		}
+
+		std::size_t EstimateSize(const MatchState::Entity& entity, bool isQuantized, std::size_t& propertyBitCount)
+		{
+			std::size_t positionSize;
+			std::size_t rotationSize;
+			std::size_t velocitySize;
+			if (isQuantized)
 			{
-				if (entity.playerMovement)
-					playerEntity++;
+				positionSize = sizeof(MatchState::Entity::quantizedPosition);
+				rotationSize = sizeof(MatchState::Entity::quantizedRotation);
+				velocitySize = sizeof(MatchState::PhysicsProperties::quantizedAngularVelocity) + sizeof(MatchState::PhysicsProperties::quantizedLinearVelocity);
+			}
+			else
+			{
+				positionSize = sizeof(MatchState::Entity::position);
+				rotationSize = sizeof(MatchState::Entity::rotation);
+				velocitySize = sizeof(MatchState::PhysicsProperties::angularVelocity) + sizeof(MatchState::PhysicsProperties::linearVelocity);
+			}
 
-				if (entity.physicsProperties)
-					physicalEntity++;
+			std::size_t size = sizeof(MatchState::Entity::id);
+			propertyBitCount += 3; // movement, physics and delta bits
+
+			if (entity.playerMovement)
+				propertyBitCount++; // isFacingRight
+
+			if (entity.delta)
+			{
+				const auto& delta = entity.delta.value();
+
+				propertyBitCount += 2; // position and rotation changed bits
+				size += sizeof(MatchState::DeltaData::baselineAge);
+
+				if (delta.positionChanged)
+					size += positionSize;
+
+				if (delta.rotationChanged)
+					size += rotationSize;
 			}
+			else
+				size += positionSize + rotationSize;
+
+			if (entity.physicsProperties)
+			{
+				if (entity.delta)
+					propertyBitCount++; // velocity changed bit
 
-			size += (playerEntity + 7) / 8; // one bit per player entity, rounded up
-			size += (sizeof(MatchState::PhysicsProperties::angularVelocity) + sizeof(MatchState::PhysicsProperties::linearVelocity)) * physicalEntity;
+				if (!entity.delta || entity.delta->velocityChanged)
+					size += velocitySize;
+			}
 
 			return size;
 		}
 
+		std::size_t EstimateSize(const MatchState::Layer& /*layer*/)
+		{
+			return sizeof(MatchState::Layer::layerIndex) + sizeof(MatchState::Layer::entityCount);
+		}
+
 		void Serialize(PacketSerializer& serializer, Auth& data)
 		{
 			serializer.SerializeArraySize(data.players);
 
 			for (auto& player : data.players)
+			{
 				serializer &= player.nickname;
+				serializer &= player.reconnectToken;
+			}
+
+			serializer &= data.relayPassword;
+
+			SerializeProtocolFeatures(serializer, data.protocolFeatures);
 		}
 
 		void Serialize(PacketSerializer& /*serializer*/, AuthFailure& /*data*/)
@@ -64,7 +153,12 @@ namespace bw
 			serializer.SerializeArraySize(data.players);
 
 			for (auto& player : data.players)
+			{
 				serializer &= player.playerIndex;
+				serializer &= player.reconnectToken;
+			}
+
+			SerializeProtocolFeatures(serializer, data.protocolFeatures);
 		}
 
 		void Serialize(PacketSerializer& serializer, ChatMessage& data)
@@ -183,6 +277,11 @@ namespace bw
 			serializer &= data.layerIndex;
 		}
 
+		void Serialize(PacketSerializer& serializer, DownloadClientFileAck& data)
+		{
+			serializer &= data.receivedFragmentCount;
+		}
+
 		void Serialize(PacketSerializer& serializer, DownloadClientFileFragment& data)
 		{
 			serializer &= data.fragmentIndex;
@@ -249,6 +348,7 @@ namespace bw
 		{
 			serializer &= data.stateTick;
 			serializer &= data.layerIndex;
+			serializer &= data.remainingEntityCount;
 
 			serializer.SerializeArraySize(data.layerEntities);
 			for (auto& entity : data.layerEntities)
@@ -338,8 +438,10 @@ namespace bw
 			}
 		}
 
-		void Serialize(PacketSerializer& serializer, EntitiesScale& data)
+		void Serialize(PacketSerializer& serializer, EntitiesPhysics& data)
 		{
+			serializer &= data.stateTick;
+
 			Nz::UInt32 entityCount = 0;
 
 			serializer.SerializeArraySize(data.layers);
@@ -359,48 +461,87 @@ namespace bw
 			for (auto& entity : data.entities)
 			{
 				serializer &= entity.id;
-				serializer &= entity.newScale;
+				serializer &= entity.asleep;
+				serializer &= entity.mass;
+				serializer &= entity.momentOfInertia;
+
+				bool hasPlayerMovement;
+				if (serializer.IsWriting())
+					hasPlayerMovement = entity.playerMovement.has_value();
+
+				serializer &= hasPlayerMovement;
+				if (!serializer.IsWriting())
+				{
+					if (hasPlayerMovement)
+						entity.playerMovement.emplace();
+				}
+
+				if (entity.playerMovement.has_value())
+				{
+					auto& playerMovement = entity.playerMovement.value();
+					serializer &= playerMovement.jumpHeight;
+					serializer &= playerMovement.jumpHeightBoost;
+					serializer &= playerMovement.movementSpeed;
+				}
 			}
 		}
 
-		void Serialize(PacketSerializer& serializer, EntityPhysics& data)
+		void Serialize(PacketSerializer& serializer, EntitiesScale& data)
 		{
-			Serialize(serializer, data.entityId);
-			serializer &= data.stateTick;
-			serializer &= data.asleep;
-			serializer &= data.mass;
-			serializer &= data.momentOfInertia;
-
-			bool hasPlayerMovement;
-			if (serializer.IsWriting())
-				hasPlayerMovement = data.playerMovement.has_value();
+			Nz::UInt32 entityCount = 0;
 
-			serializer &= hasPlayerMovement;
-			if (!serializer.IsWriting())
+			serializer.SerializeArraySize(data.layers);
+			for (auto& layer : data.layers)
 			{
-				if (hasPlayerMovement)
-					data.playerMovement.emplace();
+				serializer &= layer.layerIndex;
+				serializer &= layer.entityCount;
+
+				entityCount += layer.entityCount;
 			}
 
-			if (data.playerMovement.has_value())
+			if (serializer.IsWriting())
+				assert(data.entities.size() == entityCount);
+			else
+				data.entities.resize(entityCount);
+
+			for (auto& entity : data.entities)
 			{
-				auto& playerMovement = data.playerMovement.value();
-				serializer &= playerMovement.jumpHeight;
-				serializer &= playerMovement.jumpHeightBoost;
-				serializer &= playerMovement.movementSpeed;
+				serializer &= entity.id;
+				serializer &= entity.newScale;
 			}
 		}
 
-		void Serialize(PacketSerializer& serializer, EntityWeapon& data)
+		void Serialize(PacketSerializer& serializer, EntitiesWeapon& data)
 		{
-			Serialize(serializer, data.entityId);
 			serializer &= data.stateTick;
-			serializer &= data.weaponEntityId;
+
+			Nz::UInt32 entityCount = 0;
+
+			serializer.SerializeArraySize(data.layers);
+			for (auto& layer : data.layers)
+			{
+				serializer &= layer.layerIndex;
+				serializer &= layer.entityCount;
+
+				entityCount += layer.entityCount;
+			}
+
+			if (serializer.IsWriting())
+				assert(data.entities.size() == entityCount);
+			else
+				data.entities.resize(entityCount);
+
+			for (auto& entity : data.entities)
+			{
+				serializer &= entity.id;
+				serializer &= entity.weaponEntityId;
+			}
 		}
 
 		void Serialize(PacketSerializer& serializer, HealthUpdate& data)
 		{
 			serializer &= data.stateTick;
+			serializer &= data.healthStep;
 
 			Nz::UInt32 entityCount = 0;
 
@@ -418,10 +559,19 @@ namespace bw
 			else
 				data.entities.resize(entityCount);
 
+			Nz::UInt32 healthStep = std::max<Nz::UInt16>(data.healthStep, 1);
 			for (auto& entity : data.entities)
 			{
 				serializer &= entity.id;
-				serializer &= entity.currentHealth;
+
+				CompressedUnsigned<Nz::UInt16> quantizedHealth;
+				if (serializer.IsWriting())
+					quantizedHealth = static_cast<Nz::UInt16>((entity.currentHealth + healthStep - 1) / healthStep);
+
+				serializer &= quantizedHealth;
+
+				if (!serializer.IsWriting())
+					entity.currentHealth = static_cast<Nz::UInt16>(std::min<Nz::UInt32>(quantizedHealth * healthStep, 0xFFFF));
 			}
 		}
 
@@ -434,6 +584,7 @@ namespace bw
 		void Serialize(PacketSerializer& serializer, MatchData& data)
 		{
 			serializer &= data.currentTick;
+			serializer &= data.minTickDuration;
 			serializer &= data.tickDuration;
 			serializer &= data.gamemode;
 
@@ -444,7 +595,13 @@ namespace bw
 
 			serializer.SerializeArraySize(data.layers);
 			for (auto& layer : data.layers)
+			{
 				serializer &= layer.backgroundColor;
+				serializer &= layer.physicsIterationCount;
+				serializer &= layer.physicsSleepTime;
+				serializer &= layer.physicsSpatialHashCellSize;
+				serializer &= layer.physicsSpatialHashEntityCount;
+			}
 
 			serializer.SerializeArraySize(data.gamemodeProperties);
 			for (auto& property : data.gamemodeProperties)
@@ -475,6 +632,24 @@ namespace bw
 				else
 					serializer.Read(script.sha1Checksum.data(), script.sha1Checksum.size());
 			}
+
+			bool hasStateQuantization;
+			if (serializer.IsWriting())
+				hasStateQuantization = data.stateQuantization.has_value();
+
+			serializer &= hasStateQuantization;
+
+			if (hasStateQuantization)
+			{
+				if (!serializer.IsWriting())
+					data.stateQuantization.emplace();
+
+				auto& stateQuantization = data.stateQuantization.value();
+				serializer &= stateQuantization.positionMin;
+				serializer &= stateQuantization.positionMax;
+				serializer &= stateQuantization.maxAngularVelocity;
+				serializer &= stateQuantization.maxLinearVelocity;
+			}
 		}
 
 		void Serialize(PacketSerializer& serializer, MapReset& data)
@@ -527,18 +702,23 @@ namespace bw
 			else
 				data.entities.resize(entityCount);
 
+			serializer &= data.isQuantized;
+
 			for (auto& entity : data.entities)
 			{
 				bool hasMovementData;
 				bool hasPhysicsProps;
+				bool hasDelta;
 				if (serializer.IsWriting())
 				{
 					hasMovementData = entity.playerMovement.has_value();
 					hasPhysicsProps = entity.physicsProperties.has_value();
+					hasDelta = entity.delta.has_value();
 				}
 
 				serializer &= hasMovementData;
 				serializer &= hasPhysicsProps;
+				serializer &= hasDelta;
 
 				if (!serializer.IsWriting())
 				{
@@ -547,6 +727,9 @@ namespace bw
 
 					if (hasPhysicsProps)
 						entity.physicsProperties.emplace();
+
+					if (hasDelta)
+						entity.delta.emplace();
 				}
 
 				if (entity.playerMovement)
@@ -554,19 +737,66 @@ namespace bw
 					auto& playerMovementData = entity.playerMovement.value();
 					serializer &= playerMovementData.isFacingRight;
 				}
+
+				if (entity.delta)
+				{
+					auto& deltaData = entity.delta.value();
+					serializer &= deltaData.positionChanged;
+					serializer &= deltaData.rotationChanged;
+
+					if (entity.physicsProperties)
+						serializer &= deltaData.velocityChanged;
+					else if (!serializer.IsWriting())
+						deltaData.velocityChanged = false;
+				}
 			}
 
 			for (auto& entity : data.entities)
 			{
 				serializer &= entity.id;
-				serializer &= entity.position;
-				serializer &= entity.rotation;
 
-				if (entity.physicsProperties)
+				bool hasPosition = true;
+				bool hasRotation = true;
+				bool hasVelocity = true;
+				if (entity.delta)
 				{
-					auto& physicsProperties = entity.physicsProperties.value();
-					serializer &= physicsProperties.angularVelocity;
-					serializer &= physicsProperties.linearVelocity;
+					auto& deltaData = entity.delta.value();
+					serializer &= deltaData.baselineAge;
+
+					hasPosition = deltaData.positionChanged;
+					hasRotation = deltaData.rotationChanged;
+					hasVelocity = deltaData.velocityChanged;
+				}
+
+				if (data.isQuantized)
+				{
+					if (hasPosition)
+						serializer &= entity.quantizedPosition;
+
+					if (hasRotation)
+						serializer &= entity.quantizedRotation;
+
+					if (entity.physicsProperties && hasVelocity)
+					{
+						auto& physicsProperties = entity.physicsProperties.value();
+						serializer &= physicsProperties.quantizedAngularVelocity;
+						serializer &= physicsProperties.quantizedLinearVelocity;
+					}
+				}
+				else
+				{
+					if (hasPosition)
+						serializer &= entity.position;
+
+					if (hasRotation)
+						serializer &= entity.rotation;
+
+					if (entity.physicsProperties && hasVelocity)
+					{
+						auto& physicsProperties = entity.physicsProperties.value();
+						serializer &= physicsProperties.angularVelocity;
+						serializer &= physicsProperties.linearVelocity;
+					}
 				}
 			}
 		}
@@ -653,26 +883,81 @@ namespace bw
 			serializer &= data.estimatedServerTick;
 			serializer &= data.inputTick;
 
-			serializer.SerializeArraySize(data.inputs);
+			bool hasLastReceivedStateTick;
+			if (serializer.IsWriting())
+				hasLastReceivedStateTick = data.lastReceivedStateTick.has_value();
 
-			for (auto& input : data.inputs)
-			{
-				bool hasInput;
-				if (serializer.IsWriting())
-					hasInput = input.has_value();
+			serializer &= hasLastReceivedStateTick;
 
-				serializer &= hasInput;
+			if (hasLastReceivedStateTick)
+			{
+				if (!serializer.IsWriting())
+					data.lastReceivedStateTick.emplace();
 
-				if (!serializer.IsWriting() && hasInput)
-					input.emplace();
+				serializer &= data.lastReceivedStateTick.value();
 			}
 
+			serializer.SerializeArraySize(data.inputs);
 			for (auto& input : data.inputs)
+				Serialize(serializer, input);
+
+			// Previous inputs are delta-coded against the more recent ones, only changes are sent (flags are always sent, aim direction only if it changed)
+			std::vector<PlayerInputData> moreRecentInputs = data.inputs;
+
+			serializer.SerializeArraySize(data.previousInputs);
+			for (auto& previousInputs : data.previousInputs)
 			{
-				if (!input.has_value())
-					continue;
+				serializer &= previousInputs.tickOffset;
+
+				// Player count is the same for every inputs
+				if (!serializer.IsWriting())
+					previousInputs.inputs.resize(data.inputs.size());
 
-				Serialize(serializer, *input);
+				assert(previousInputs.inputs.size() == data.inputs.size());
+
+				for (auto& input : previousInputs.inputs)
+				{
+					bool hasInput;
+					if (serializer.IsWriting())
+						hasInput = input.has_value();
+
+					serializer &= hasInput;
+
+					if (!serializer.IsWriting() && hasInput)
+						input.emplace();
+				}
+
+				for (std::size_t i = 0; i < previousInputs.inputs.size(); ++i)
+				{
+					auto& input = previousInputs.inputs[i];
+					if (!input.has_value())
+						continue;
+
+					serializer &= input->isAttacking;
+					serializer &= input->isCrouching;
+					serializer &= input->isLookingRight;
+					serializer &= input->isJumping;
+					serializer &= input->isMovingLeft;
+					serializer &= input->isMovingRight;
+
+					bool aimChanged;
+					if (serializer.IsWriting())
+						aimChanged = input->EncodeAimDirection() != moreRecentInputs[i].EncodeAimDirection();
+
+					serializer &= aimChanged;
+
+					if (aimChanged)
+					{
+						if (serializer.IsWriting())
+							serializer.WriteBits(input->EncodeAimDirection(), PlayerInputData::AimAngleBits);
+						else
+							input->DecodeAimDirection(static_cast<Nz::UInt16>(serializer.ReadBits(PlayerInputData::AimAngleBits)));
+					}
+					else if (!serializer.IsWriting())
+						input->aimDirection = moreRecentInputs[i].aimDirection;
+
+					moreRecentInputs[i] = *input;
+				}
 			}
 		}
 
@@ -694,6 +979,106 @@ namespace bw
 		{
 		}
 
+		void Serialize(PacketSerializer& serializer, RecycleEntities& data)
+		{
+			serializer &= data.stateTick;
+
+			Nz::UInt32 entityCount = 0;
+
+			serializer.SerializeArraySize(data.layers);
+			for (auto& layer : data.layers)
+			{
+				serializer &= layer.layerIndex;
+				serializer &= layer.entityCount;
+
+				entityCount += layer.entityCount;
+			}
+
+			if (serializer.IsWriting())
+				assert(data.entities.size() == entityCount);
+			else
+				data.entities.resize(entityCount);
+
+			for (auto& entity : data.entities)
+				serializer &= entity.id;
+		}
+
+		void Serialize(PacketSerializer& serializer, RespawnEntities& data)
+		{
+			serializer &= data.stateTick;
+
+			Nz::UInt32 entityCount = 0;
+
+			serializer.SerializeArraySize(data.layers);
+			for (auto& layer : data.layers)
+			{
+				serializer &= layer.layerIndex;
+				serializer &= layer.entityCount;
+
+				entityCount += layer.entityCount;
+			}
+
+			if (serializer.IsWriting())
+				assert(data.entities.size() == entityCount);
+			else
+				data.entities.resize(entityCount);
+
+			for (auto& entity : data.entities)
+			{
+				bool hasHealth;
+				bool hasOwner;
+				bool hasPhysicsProps;
+
+				if (serializer.IsWriting())
+				{
+					hasHealth = entity.currentHealth.has_value();
+					hasOwner = entity.ownerPlayerIndex.has_value();
+					hasPhysicsProps = entity.physicsProperties.has_value();
+				}
+
+				serializer &= hasHealth;
+				serializer &= hasOwner;
+				serializer &= hasPhysicsProps;
+
+				if (!serializer.IsWriting())
+				{
+					if (hasHealth)
+						entity.currentHealth.emplace();
+
+					if (hasOwner)
+						entity.ownerPlayerIndex.emplace();
+
+					if (hasPhysicsProps)
+						entity.physicsProperties.emplace();
+				}
+
+				serializer &= entity.id;
+				serializer &= entity.uniqueId;
+				serializer &= entity.position;
+				serializer &= entity.rotation;
+
+				if (entity.currentHealth)
+					serializer &= entity.currentHealth.value();
+
+				if (entity.ownerPlayerIndex)
+					serializer &= entity.ownerPlayerIndex.value();
+
+				if (entity.physicsProperties)
+				{
+					auto& physicsProperties = entity.physicsProperties.value();
+					serializer &= physicsProperties.angularVelocity;
+					serializer &= physicsProperties.linearVelocity;
+					serializer &= physicsProperties.isAsleep;
+					serializer &= physicsProperties.mass;
+					serializer &= physicsProperties.momentOfInertia;
+				}
+
+				serializer.SerializeArraySize(entity.properties);
+				for (auto& property : entity.properties)
+					Serialize(serializer, property);
+			}
+		}
+
 		void Serialize(PacketSerializer& serializer, ScriptPacket& data)
 		{
 			serializer &= data.nameIndex;
@@ -705,6 +1090,12 @@ namespace bw
 				serializer.Read(data.content.data(), data.content.size());
 		}
 
+		void Serialize(PacketSerializer& serializer, TickRateUpdate& data)
+		{
+			serializer &= data.applyTick;
+			serializer &= data.tickDuration;
+		}
+
 		void Serialize(PacketSerializer& serializer, UpdatePlayerName& data)
 		{
 			serializer &= data.localIndex;
@@ -720,7 +1111,11 @@ namespace bw
 			serializer &= input.isMovingLeft;
 			serializer &= input.isMovingRight;
 
-			serializer &= input.aimDirection;
+			// Aim direction is sent as an angle, packed along with flags
+			if (serializer.IsWriting())
+				serializer.WriteBits(input.EncodeAimDirection(), PlayerInputData::AimAngleBits);
+			else
+				input.DecodeAimDirection(static_cast<Nz::UInt16>(serializer.ReadBits(PlayerInputData::AimAngleBits)));
 		}
 
 		void Serialize(PacketSerializer& serializer, Helper::EntityData& data)
@@ -833,12 +1228,10 @@ namespace bw
 
 			if (serializer.IsWriting())
 			{
-				auto [internalType, isArray] = ExtractPropertyType(data.value);
-
-				Nz::UInt8 propertyType = Nz::UInt8(internalType);
-				serializer &= propertyType;
+				auto [propertyType, isArray] = ExtractPropertyType(data.value);
 
-				serializer &= Nz::UInt8((isArray) ? 1 : 0);
+				serializer.SerializeEnum(propertyType, PropertyTypeMax);
+				serializer &= isArray;
 
 				std::visit([&](auto&& propertyValue)
 				{
@@ -851,8 +1244,15 @@ namespace bw
 						CompressedUnsigned<Nz::UInt32> arraySize(Nz::UInt32(propertyValue.size()));
 						serializer.Serialize(arraySize);
 
-						for (auto& element : propertyValue)
-							serializer &= element;
+						// Don't unshare elements of the sent value
+						const auto& elements = propertyValue;
+						if constexpr (T::IsRawSerializable)
+							serializer.WriteArray(elements.GetData(), elements.GetSize());
+						else
+						{
+							for (const auto& element : elements)
+								serializer &= element;
+						}
 					}
 					else
 						serializer &= propertyValue.value;
@@ -861,15 +1261,11 @@ namespace bw
 			}
 			else
 			{
-				Nz::UInt8 propertyTypeInt;
-				serializer &= propertyTypeInt;
-
-				PropertyType propertyType = static_cast<PropertyType>(propertyTypeInt);
-
-				Nz::UInt8 isArrayInt;
-				serializer &= isArrayInt;
+				PropertyType propertyType;
+				serializer.SerializeEnum(propertyType, PropertyTypeMax);
 
-				bool isArray = (isArrayInt != 0);
+				bool isArray;
+				serializer &= isArray;
 
 				// Waiting for template lambda in C++20
 				auto Unserialize = [&](auto dummyType)
@@ -884,8 +1280,13 @@ namespace bw
 						serializer &= size;
 
 						auto& elements = data.value.emplace<PropertyArrayValue<Property>>(size);
-						for (auto& element : elements)
-							serializer &= element;
+						if constexpr (PropertyArrayValue<Property>::IsRawSerializable)
+							serializer.ReadArray(elements.GetData(), elements.GetSize());
+						else
+						{
+							for (auto& element : elements)
+								serializer &= element;
+						}
 					}
 					else
 					{
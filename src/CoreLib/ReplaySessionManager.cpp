@@ -0,0 +1,129 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/ReplaySessionManager.hpp>
+#include <CoreLib/Match.hpp>
+#include <CoreLib/MatchReplay.hpp>
+#include <CoreLib/MatchSessions.hpp>
+#include <CoreLib/SessionBridge.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <optional>
+#include <stdexcept>
+
+namespace bw
+{
+	namespace
+	{
+		// Outgoing packets are still serialized (as they would be for a remote client) but dropped
+		class ReplaySessionBridge : public SessionBridge
+		{
+			public:
+				using SessionBridge::SessionBridge;
+
+				void Disconnect() override
+				{
+					// The recorded disconnection will delete the session
+				}
+
+				bool IsLocal() const override
+				{
+					return false;
+				}
+
+				void QueryInfo(std::function<void(const SessionInfo& info)> callback) const override
+				{
+					SessionInfo info;
+					info.ping = 0;
+					info.timeSinceLastReceive = 0;
+					info.totalByteReceived = 0;
+					info.totalByteSent = m_totalByteSent;
+					info.totalPacketLost = 0;
+					info.totalPacketReceived = 0;
+					info.totalPacketSent = m_totalPacketSent;
+
+					callback(info);
+				}
+
+				void SendPacket(Nz::UInt8 /*channelId*/, Nz::ENetPacketFlags /*flags*/, Nz::NetPacket&& packet) override
+				{
+					m_totalByteSent += packet.GetDataSize();
+					m_totalPacketSent++;
+				}
+
+			private:
+				Nz::UInt64 m_totalByteSent = 0;
+				Nz::UInt32 m_totalPacketSent = 0;
+		};
+	}
+
+	ReplaySessionManager::ReplaySessionManager(MatchSessions* owner, MatchReplay& replay) :
+	SessionManager(owner),
+	m_replay(replay)
+	{
+	}
+
+	ReplaySessionManager::~ReplaySessionManager() = default;
+
+	void ReplaySessionManager::Poll()
+	{
+		MatchSessions* owner = GetOwner();
+
+		std::optional<MatchReplay::EventType> eventType;
+		while ((eventType = m_replay.PeekEvent()) && *eventType != MatchReplay::EventType::Update)
+		{
+			switch (*eventType)
+			{
+				case MatchReplay::EventType::Connection:
+				{
+					std::size_t sessionId = m_replay.ReadConnection();
+
+					Peer& peer = m_peers[sessionId];
+					peer.bridge = std::make_shared<ReplaySessionBridge>(nullptr);
+					peer.bridge->HandleConnection(0);
+
+					peer.session = owner->CreateSession(peer.bridge);
+					break;
+				}
+
+				case MatchReplay::EventType::Disconnection:
+				{
+					std::size_t sessionId = m_replay.ReadDisconnection();
+
+					auto it = m_peers.find(sessionId);
+					if (it == m_peers.end())
+						break;
+
+					Peer& peer = it.value();
+					peer.bridge->HandleDisconnection(0);
+
+					owner->DeleteSession(peer.session);
+					m_peers.erase(it);
+					break;
+				}
+
+				case MatchReplay::EventType::IncomingPacket:
+				{
+					std::size_t sessionId;
+					Nz::NetPacket packet = m_replay.ReadIncomingPacket(&sessionId);
+
+					auto it = m_peers.find(sessionId);
+					if (it == m_peers.end())
+					{
+						bwLog(owner->GetMatch().GetLogger(), LogLevel::Warning, "replay: packet received from unknown session #{0}", sessionId);
+						break;
+					}
+
+					it.value().bridge->HandleIncomingPacket(packet);
+					break;
+				}
+
+				case MatchReplay::EventType::Update:
+					break;
+
+				default:
+					throw std::runtime_error("unknown replay event (file is corrupted)");
+			}
+		}
+	}
+}
@@ -0,0 +1,10 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Scripting/NativeElement.hpp>
+
+namespace bw
+{
+	NativeElement::~NativeElement() = default;
+}
@@ -0,0 +1,147 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Scripting/NetworkPacket.hpp>
+#include <CoreLib/SharedMatch.hpp>
+#include <CoreLib/Protocol/PacketSerializer.hpp>
+#include <fmt/format.h>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace bw
+{
+	namespace
+	{
+		template<typename T>
+		void SerializeField(PacketSerializer& serializer, T& value)
+		{
+			// Integers are mostly small values (counters, entity ids), variable length encoding saves most of their bytes
+			if constexpr (std::is_same_v<T, Nz::Int64>)
+			{
+				CompressedSigned<Nz::Int64> compressedValue(value);
+				serializer &= compressedValue;
+				value = compressedValue;
+			}
+			else if constexpr (std::is_same_v<T, LayerIndex>)
+			{
+				CompressedUnsigned<LayerIndex> compressedValue(value);
+				serializer &= compressedValue;
+				value = compressedValue;
+			}
+			else
+				serializer &= value;
+		}
+	}
+
+	NetworkPacketSchema NetworkPacketSchema::FromLua(const sol::table& fields)
+	{
+		NetworkPacketSchema schema;
+		for (std::size_t i = 1; i <= fields.size(); ++i)
+		{
+			sol::table fieldTable = fields[i];
+
+			auto& field = schema.fields.emplace_back();
+			field.name = fieldTable.get_or("Name", std::string{});
+			if (field.name.empty())
+				throw std::runtime_error("field #" + std::to_string(i) + " has no name");
+
+			sol::optional<PropertyType> fieldType = fieldTable["Type"];
+			if (!fieldType)
+				throw std::runtime_error("field " + field.name + " has no type");
+
+			field.type = *fieldType;
+			field.isArray = fieldTable.get_or("Array", false);
+			field.maxArraySize = fieldTable.get_or("MaxSize", DefaultMaxArraySize);
+		}
+
+		return schema;
+	}
+
+	sol::table IncomingNetworkPacket::ReadFields(SharedMatch& match, sol::state_view& lua, const NetworkPacketSchema& schema)
+	{
+		PacketSerializer serializer(m_stream, false);
+
+		sol::table fields = lua.create_table(0, int(schema.fields.size()));
+		for (const auto& field : schema.fields)
+		{
+			PropertyValue value;
+
+			// Waiting for template lambda in C++20
+			auto Unserialize = [&](auto dummyType)
+			{
+				using T = std::decay_t<decltype(dummyType)>;
+
+				static constexpr PropertyType Property = T::Property;
+
+				if (field.isArray)
+				{
+					CompressedUnsigned<Nz::UInt32> size;
+					serializer &= size;
+
+					// Booleans are packed as bits and every other element takes at least one byte, check the size before allocating anything
+					Nz::UInt64 minimumSize = (Property == PropertyType::Bool) ? (Nz::UInt64(size) + 7) / 8 : Nz::UInt64(size);
+					Nz::UInt64 remainingBytes = m_content->GetSize() - m_stream.GetStream()->GetCursorPos();
+					if (size > field.maxArraySize || minimumSize > remainingBytes)
+						throw std::runtime_error(fmt::format("field {0} has an invalid array size ({1})", field.name, Nz::UInt32(size)));
+
+					auto& elements = value.emplace<PropertyArrayValue<Property>>(size);
+					for (auto& element : elements)
+						SerializeField(serializer, element);
+				}
+				else
+				{
+					auto& singleValue = value.emplace<PropertySingleValue<Property>>();
+					SerializeField(serializer, singleValue.value);
+				}
+			};
+
+			switch (field.type)
+			{
+#define BURGWAR_PROPERTYTYPE(V, T, UT) case PropertyType:: T: Unserialize(PropertyTag<PropertyType:: T>{}); break;
+
+#include <CoreLib/PropertyTypeList.hpp>
+			}
+
+			fields[field.name] = TranslatePropertyToLua(&match, lua, value);
+		}
+
+		return fields;
+	}
+
+	void OutgoingNetworkPacket::WriteFields(SharedMatch& match, const NetworkPacketSchema& schema, const sol::table& values)
+	{
+		PacketSerializer serializer(m_stream, true);
+
+		for (const auto& field : schema.fields)
+		{
+			sol::object fieldValue = values[field.name];
+			if (!fieldValue)
+				throw std::runtime_error(fmt::format("missing field {0} for packet {1}", field.name, m_packetName));
+
+			PropertyValue value = TranslatePropertyFromLua(&match, fieldValue, field.type, field.isArray);
+			std::visit([&](auto&& propertyValue)
+			{
+				using T = std::decay_t<decltype(propertyValue)>;
+				using TypeExtractor = PropertyTypeExtractor<T>;
+				constexpr bool IsArray = TypeExtractor::IsArray;
+
+				if constexpr (IsArray)
+				{
+					if (propertyValue.size() > field.maxArraySize)
+						throw std::runtime_error(fmt::format("field {0} of packet {1} has too many elements ({2} > {3})", field.name, m_packetName, propertyValue.size(), field.maxArraySize));
+
+					CompressedUnsigned<Nz::UInt32> arraySize(Nz::UInt32(propertyValue.size()));
+					serializer &= arraySize;
+
+					for (auto& element : propertyValue)
+						SerializeField(serializer, element);
+				}
+				else
+					SerializeField(serializer, propertyValue.value);
+
+			}, value);
+		}
+	}
+}
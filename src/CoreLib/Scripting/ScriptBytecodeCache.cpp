@@ -0,0 +1,155 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Scripting/ScriptBytecodeCache.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <Nazara/Core/AbstractHash.hpp>
+#include <Nazara/Core/ByteArray.hpp>
+#include <Nazara/Core/File.hpp>
+#include <cassert>
+
+namespace bw
+{
+	ScriptBytecodeCache::ScriptBytecodeCache(const Logger& logger, std::filesystem::path cacheFolder) :
+	m_cacheFolder(std::move(cacheFolder)),
+	m_logger(logger)
+	{
+	}
+
+	auto ScriptBytecodeCache::Find(const std::string& key) -> std::shared_ptr<const Bytecode>
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (auto it = m_entries.find(key); it != m_entries.end())
+			return it->second;
+
+		if (m_cacheFolder.empty())
+			return nullptr;
+
+		std::filesystem::path cachePath = GetCachePath(key);
+		if (!std::filesystem::is_regular_file(cachePath))
+			return nullptr;
+
+		Nz::File file(cachePath.generic_u8string());
+		if (!file.Open(Nz::OpenMode_ReadOnly))
+			return nullptr;
+
+		Bytecode bytecode(file.GetSize());
+		if (file.Read(bytecode.data(), bytecode.size()) != bytecode.size())
+		{
+			bwLog(m_logger, LogLevel::Warning, "failed to read cached bytecode {0}", cachePath.generic_u8string());
+			return nullptr;
+		}
+
+		auto entry = std::make_shared<const Bytecode>(std::move(bytecode));
+		m_entries.emplace(key, entry);
+
+		return entry;
+	}
+
+	void ScriptBytecodeCache::Register(const std::string& key, Bytecode bytecode)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_entries.insert_or_assign(key, std::make_shared<const Bytecode>(std::move(bytecode)));
+	}
+
+	void ScriptBytecodeCache::Store(const std::string& key, Bytecode bytecode)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto entry = std::make_shared<const Bytecode>(std::move(bytecode));
+		m_entries.insert_or_assign(key, entry);
+
+		if (m_cacheFolder.empty())
+			return;
+
+		std::error_code ec;
+		std::filesystem::create_directories(m_cacheFolder, ec);
+
+		// Write to a temporary file first so another process never reads a partial chunk
+		std::filesystem::path cachePath = GetCachePath(key);
+		std::filesystem::path tempPath = cachePath;
+		tempPath += ".tmp";
+
+		{
+			Nz::File file(tempPath.generic_u8string(), Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate);
+			if (!file.IsOpen() || file.Write(entry->data(), entry->size()) != entry->size())
+			{
+				bwLog(m_logger, LogLevel::Warning, "failed to save bytecode to {0}", tempPath.generic_u8string());
+				return;
+			}
+		}
+
+		std::filesystem::rename(tempPath, cachePath, ec);
+		if (ec)
+		{
+			bwLog(m_logger, LogLevel::Warning, "failed to save bytecode to {0}: {1}", cachePath.generic_u8string(), ec.message());
+			std::filesystem::remove(tempPath, ec);
+		}
+	}
+
+	bool ScriptBytecodeCache::Compile(const std::string& chunkName, const std::string_view& content, Bytecode* bytecode, std::string* error)
+	{
+		assert(bytecode);
+
+		sol::state state;
+		sol::load_result result = state.load(content, chunkName, sol::load_mode::text);
+		if (!result.valid())
+		{
+			if (error)
+			{
+				sol::error err = result;
+				*error = err.what();
+			}
+
+			return false;
+		}
+
+		sol::protected_function chunk = result;
+		*bytecode = Dump(chunk);
+
+		return true;
+	}
+
+	std::string ScriptBytecodeCache::ComputeKey(const std::string& chunkName, const std::string_view& content)
+	{
+		// Chunk name is part of the bytecode (for error messages), Lua version is checked when loading it but a new version shouldn't hit old entries
+		static constexpr std::string_view luaVersion = LUA_RELEASE;
+
+		auto hash = Nz::AbstractHash::Get(Nz::HashType_SHA1);
+		hash->Begin();
+		hash->Append(reinterpret_cast<const Nz::UInt8*>(luaVersion.data()), luaVersion.size());
+		hash->Append(reinterpret_cast<const Nz::UInt8*>(chunkName.data()), chunkName.size() + 1); //< include null terminator as a separator
+		hash->Append(reinterpret_cast<const Nz::UInt8*>(content.data()), content.size());
+
+		return hash->End().ToHex().ToStdString();
+	}
+
+	auto ScriptBytecodeCache::Dump(const sol::protected_function& function) -> Bytecode
+	{
+		lua_State* L = function.lua_state();
+
+		Bytecode bytecode;
+
+		function.push(L);
+		lua_dump(L, [](lua_State* /*L*/, const void* data, std::size_t size, void* userdata) -> int
+		{
+			Bytecode& output = *static_cast<Bytecode*>(userdata);
+
+			const Nz::UInt8* bytes = static_cast<const Nz::UInt8*>(data);
+			output.insert(output.end(), bytes, bytes + size);
+
+			return 0;
+		}, &bytecode, 0);
+		lua_pop(L, 1);
+
+		return bytecode;
+	}
+
+	std::filesystem::path ScriptBytecodeCache::GetCachePath(const std::string& key) const
+	{
+		return m_cacheFolder / (key + ".luac");
+	}
+}
@@ -0,0 +1,221 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Scripting/ScriptMessageValue.hpp>
+#include <CoreLib/PropertyValues.hpp>
+#include <CoreLib/SharedMatch.hpp>
+#include <CoreLib/Protocol/PacketSerializer.hpp>
+#include <CoreLib/Scripting/ScriptingUtils.hpp>
+#include <cassert>
+#include <stdexcept>
+#include <type_traits>
+
+namespace bw
+{
+	void ScriptMessageValue::Serialize(PacketSerializer& serializer)
+	{
+		Serialize(serializer, 0);
+	}
+
+	sol::object ScriptMessageValue::ToLua(sol::state_view& lua) const
+	{
+		return ToLua(nullptr, lua);
+	}
+
+	sol::object ScriptMessageValue::ToLua(SharedMatch& match, sol::state_view& lua) const
+	{
+		return ToLua(&match, lua);
+	}
+
+	ScriptMessageValue ScriptMessageValue::FromLua(const sol::object& value)
+	{
+		return FromLua(nullptr, value, 0);
+	}
+
+	ScriptMessageValue ScriptMessageValue::FromLua(SharedMatch& match, const sol::object& value)
+	{
+		return FromLua(&match, value, 0);
+	}
+
+	ScriptMessageValue ScriptMessageValue::FromLuaFields(SharedMatch& match, const sol::table& table)
+	{
+		ScriptMessageValue messageValue;
+
+		Table& fields = messageValue.m_value.emplace<Table>();
+		for (auto&& [key, fieldValue] : table)
+		{
+			switch (fieldValue.get_type())
+			{
+				case sol::type::function:
+				case sol::type::lightuserdata:
+				case sol::type::thread:
+				case sol::type::userdata:
+					continue;
+
+				case sol::type::table:
+				{
+					sol::table fieldTable = fieldValue.as<sol::table>();
+					if (fieldTable[sol::metatable_key].valid() && !RetrieveScriptEntity(fieldTable))
+						continue;
+
+					break;
+				}
+
+				default:
+					break;
+			}
+
+			// Nested tables may still hold values which cannot be copied
+			try
+			{
+				ScriptMessageValue keyValue = FromLua(&match, key, 1);
+				fields.emplace_back(std::move(keyValue), FromLua(&match, fieldValue, 1));
+			}
+			catch (const std::exception&)
+			{
+			}
+		}
+
+		return messageValue;
+	}
+
+	ScriptMessageValue ScriptMessageValue::FromLua(SharedMatch* match, const sol::object& value, std::size_t depth)
+	{
+		ScriptMessageValue messageValue;
+
+		switch (value.get_type())
+		{
+			case sol::type::lua_nil:
+			case sol::type::none:
+				break;
+
+			case sol::type::boolean:
+				messageValue.m_value = value.as<bool>();
+				break;
+
+			case sol::type::number:
+			{
+				lua_State* L = value.lua_state();
+				value.push(L);
+				bool isInteger = lua_isinteger(L, -1);
+				lua_pop(L, 1);
+
+				if (isInteger)
+					messageValue.m_value = value.as<Nz::Int64>();
+				else
+					messageValue.m_value = value.as<double>();
+
+				break;
+			}
+
+			case sol::type::string:
+				messageValue.m_value = value.as<std::string>();
+				break;
+
+			case sol::type::table:
+			{
+				sol::table table = value.as<sol::table>();
+
+				// Entities are passed by unique id, as their table belongs to the sender scripting context
+				if (Ndk::EntityHandle entity = RetrieveScriptEntity(table))
+				{
+					if (!match)
+						throw std::runtime_error("entities cannot be copied out of their match");
+
+					messageValue.m_value = EntityReference{ match->RetrieveUniqueIdByEntity(entity) };
+					break;
+				}
+
+				if (depth >= MaxDepth)
+					throw std::runtime_error("message has too many nested tables");
+
+				Table& fields = messageValue.m_value.emplace<Table>();
+				for (auto&& [key, fieldValue] : table)
+					fields.emplace_back(FromLua(match, key, depth + 1), FromLua(match, fieldValue, depth + 1));
+
+				break;
+			}
+
+			default:
+				throw std::runtime_error(std::string("unsupported message value type ") + sol::type_name(value.lua_state(), value.get_type()));
+		}
+
+		return messageValue;
+	}
+
+	void ScriptMessageValue::Serialize(PacketSerializer& serializer, std::size_t depth)
+	{
+		if (depth > MaxDepth)
+			throw std::runtime_error("message has too many nested tables");
+
+		Nz::UInt8 valueType = static_cast<Nz::UInt8>(m_value.index());
+		serializer &= valueType;
+
+		if (!serializer.IsWriting())
+		{
+			switch (valueType)
+			{
+				case 0: m_value.emplace<std::monostate>(); break;
+				case 1: m_value.emplace<bool>(); break;
+				case 2: m_value.emplace<Nz::Int64>(); break;
+				case 3: m_value.emplace<double>(); break;
+				case 4: m_value.emplace<std::string>(); break;
+				case 5: m_value.emplace<EntityReference>(); break;
+				case 6: m_value.emplace<Table>(); break;
+
+				default:
+					throw std::runtime_error("unknown message value type " + std::to_string(valueType));
+			}
+		}
+
+		std::visit([&](auto&& value)
+		{
+			using T = std::decay_t<decltype(value)>;
+
+			if constexpr (std::is_same_v<T, std::monostate>)
+				return;
+			else if constexpr (std::is_same_v<T, EntityReference>)
+				serializer &= value.uniqueId;
+			else if constexpr (std::is_same_v<T, Table>)
+			{
+				serializer.SerializeArraySize(value);
+				for (auto&& [key, fieldValue] : value)
+				{
+					key.Serialize(serializer, depth + 1);
+					fieldValue.Serialize(serializer, depth + 1);
+				}
+			}
+			else
+				serializer &= value;
+
+		}, m_value);
+	}
+
+	sol::object ScriptMessageValue::ToLua(SharedMatch* match, sol::state_view& lua) const
+	{
+		return std::visit([&](auto&& value) -> sol::object
+		{
+			using T = std::decay_t<decltype(value)>;
+
+			if constexpr (std::is_same_v<T, std::monostate>)
+				return sol::make_object(lua, sol::lua_nil);
+			else if constexpr (std::is_same_v<T, EntityReference>)
+			{
+				assert(match); //< only built from a match
+				return TranslatePropertyToLua(match, lua, PropertySingleValue<PropertyType::Entity>(value.uniqueId));
+			}
+			else if constexpr (std::is_same_v<T, Table>)
+			{
+				sol::table table = lua.create_table();
+				for (auto&& [key, fieldValue] : value)
+					table[key.ToLua(match, lua)] = fieldValue.ToLua(match, lua);
+
+				return table;
+			}
+			else
+				return sol::make_object(lua, value);
+
+		}, m_value);
+	}
+}
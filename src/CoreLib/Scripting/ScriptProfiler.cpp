@@ -0,0 +1,158 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Scripting/ScriptProfiler.hpp>
+#include <CoreLib/Utility/Profiling.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <vector>
+
+namespace bw
+{
+	ScriptProfiler::ScriptProfiler() :
+	m_allocator(nullptr),
+	m_memoryUsage(0),
+	m_allocatorUserdata(nullptr),
+	m_allocatedBytes(0),
+	m_callbackBudget(0),
+	m_tickCount(0),
+	m_isEnabled(false)
+	{
+	}
+
+	void ScriptProfiler::EndTick()
+	{
+		if (!m_isEnabled)
+			return;
+
+		for (auto it = m_callbacks.begin(); it != m_callbacks.end(); ++it)
+		{
+			CallbackStats& stats = it.value();
+			stats.maxTickAllocatedBytes = std::max(stats.maxTickAllocatedBytes, stats.tickAllocatedBytes);
+			stats.maxTickDuration = std::max(stats.maxTickDuration, stats.tickDuration);
+			stats.tickAllocatedBytes = 0;
+			stats.tickDuration = 0;
+		}
+
+		m_tickCount++;
+	}
+
+	std::string ScriptProfiler::Format() const
+	{
+		std::string output = fmt::format("Script profile (last {0} ticks, Lua memory: {1:.1f} KiB)\n", m_tickCount, m_memoryUsage / 1024.0);
+		if (m_tickCount == 0)
+			return output;
+
+		std::vector<const CallbackStats*> callbacks;
+		callbacks.reserve(m_callbacks.size());
+
+		std::size_t nameWidth = 0;
+		for (const auto& [key, stats] : m_callbacks)
+		{
+			callbacks.push_back(&stats);
+			nameWidth = std::max(nameWidth, stats.name.size());
+		}
+
+		std::sort(callbacks.begin(), callbacks.end(), [](const CallbackStats* lhs, const CallbackStats* rhs)
+		{
+			return lhs->totalDuration > rhs->totalDuration;
+		});
+
+		// Durations are in ms and allocations in KiB, both per tick
+		double tickCount = double(m_tickCount);
+		for (const CallbackStats* stats : callbacks)
+			output += fmt::format("  {0:<{1}}  calls {2:8.2f}  avg {3:7.3f}  max {4:7.3f}  alloc {5:8.2f}  max alloc {6:8.2f}\n", stats->name, nameWidth, stats->callCount / tickCount, stats->totalDuration / tickCount / 1000.0, stats->maxTickDuration / 1000.0, stats->totalAllocatedBytes / tickCount / 1024.0, stats->maxTickAllocatedBytes / 1024.0);
+
+		return output;
+	}
+
+	std::string ScriptProfiler::FormatSummary(std::size_t callbackCount) const
+	{
+		if (m_tickCount == 0)
+			return "no sample";
+
+		std::vector<const CallbackStats*> callbacks;
+		callbacks.reserve(m_callbacks.size());
+		for (const auto& [key, stats] : m_callbacks)
+			callbacks.push_back(&stats);
+
+		callbackCount = std::min(callbackCount, callbacks.size());
+		std::partial_sort(callbacks.begin(), callbacks.begin() + callbackCount, callbacks.end(), [](const CallbackStats* lhs, const CallbackStats* rhs)
+		{
+			return lhs->totalDuration > rhs->totalDuration;
+		});
+
+		std::string output;
+		for (std::size_t i = 0; i < callbackCount; ++i)
+		{
+			const CallbackStats* stats = callbacks[i];
+			output += fmt::format("{0}{1} ({2:.2f} ms/tick, {3:.1f} KiB/tick)", (i > 0) ? ", " : "", stats->name, stats->totalDuration / double(m_tickCount) / 1000.0, stats->totalAllocatedBytes / double(m_tickCount) / 1024.0);
+		}
+
+		output += fmt::format(", Lua memory: {0:.1f} KiB", m_memoryUsage / 1024.0);
+
+		return output;
+	}
+
+	void ScriptProfiler::InstallAllocator(lua_State* L)
+	{
+		// Wrap the state allocator instead of replacing it, memory already allocated by it may still be freed through us
+		m_allocator = lua_getallocf(L, &m_allocatorUserdata);
+		m_memoryUsage = static_cast<std::size_t>(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 + static_cast<std::size_t>(lua_gc(L, LUA_GCCOUNTB, 0));
+
+		lua_setallocf(L, &ScriptProfiler::Allocate, this);
+	}
+
+	void ScriptProfiler::Reset()
+	{
+		m_callbacks.clear();
+		m_tickCount = 0;
+	}
+
+	void ScriptProfiler::Record(std::string_view elementName, std::string_view eventName, Nz::UInt64 duration, Nz::UInt64 allocatedBytes)
+	{
+		// Reuse the same buffer to build the key, so looking up an already known callback doesn't allocate
+		m_keyBuffer.assign(elementName);
+		m_keyBuffer += '/';
+		m_keyBuffer += eventName;
+
+		auto it = m_callbacks.find(m_keyBuffer);
+		if (it == m_callbacks.end())
+		{
+			it = m_callbacks.emplace(m_keyBuffer, CallbackStats{}).first;
+			it.value().name = m_keyBuffer;
+		}
+
+		CallbackStats& stats = it.value();
+		stats.callCount++;
+		stats.tickAllocatedBytes += allocatedBytes;
+		stats.tickDuration += duration;
+		stats.totalAllocatedBytes += allocatedBytes;
+		stats.totalDuration += duration;
+	}
+
+	void* ScriptProfiler::Allocate(void* userdata, void* ptr, std::size_t oldSize, std::size_t newSize)
+	{
+		ScriptProfiler* profiler = static_cast<ScriptProfiler*>(userdata);
+
+		void* newPtr = profiler->m_allocator(profiler->m_allocatorUserdata, ptr, oldSize, newSize);
+		if (!newPtr && newSize > 0)
+			return nullptr; //< allocation failed, nothing changed
+
+		// When ptr is null, oldSize holds the type of the object being allocated
+		std::size_t previousSize = (ptr) ? oldSize : 0;
+
+		if (ptr)
+			bwProfileFree(ptr, "Lua");
+
+		if (newPtr)
+			bwProfileAlloc(newPtr, newSize, "Lua");
+
+		profiler->m_memoryUsage = profiler->m_memoryUsage - previousSize + newSize;
+		if (newSize > previousSize)
+			profiler->m_allocatedBytes += newSize - previousSize;
+
+		return newPtr;
+	}
+}
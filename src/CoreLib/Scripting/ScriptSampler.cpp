@@ -0,0 +1,172 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Scripting/ScriptSampler.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace bw
+{
+	namespace
+	{
+		char s_samplerRegistryKey; //< address used as the registry key of the running sampler
+
+		void AppendFrameName(std::string& output, const char* str, std::size_t maxLength = std::string::npos)
+		{
+			// Semicolons separate frames and a line holds a whole stack, don't let chunk names break the format
+			for (std::size_t i = 0; str[i] != '\0' && i < maxLength; ++i)
+			{
+				switch (str[i])
+				{
+					case ';':
+						output.push_back(':');
+						break;
+
+					case '\n':
+					case '\r':
+					case '\t':
+						output.push_back(' ');
+						break;
+
+					default:
+						output.push_back(str[i]);
+						break;
+				}
+			}
+		}
+	}
+
+	ScriptSampler::ScriptSampler() :
+	m_sampleCount(0),
+	m_sampleInterval(0),
+	m_isRunning(false)
+	{
+	}
+
+	void ScriptSampler::Attach(lua_State* L)
+	{
+		if (m_isRunning)
+			lua_sethook(L, &ScriptSampler::Hook, LUA_MASKCOUNT, static_cast<int>(m_sampleInterval));
+	}
+
+	void ScriptSampler::Detach(lua_State* L)
+	{
+		lua_sethook(L, nullptr, 0, 0);
+	}
+
+	std::string ScriptSampler::FormatCollapsedStacks() const
+	{
+		std::vector<std::pair<const std::string*, Nz::UInt64>> stacks;
+		stacks.reserve(m_stacks.size());
+		for (auto&& [stack, count] : m_stacks)
+			stacks.emplace_back(&stack, count);
+
+		std::sort(stacks.begin(), stacks.end(), [](const auto& lhs, const auto& rhs) { return *lhs.first < *rhs.first; });
+
+		std::string output;
+		for (auto&& [stack, count] : stacks)
+			output += fmt::format("{0} {1}\n", *stack, count);
+
+		return output;
+	}
+
+	void ScriptSampler::Reset()
+	{
+		m_stacks.clear();
+		m_sampleCount = 0;
+	}
+
+	void ScriptSampler::Start(lua_State* L, unsigned int instructionInterval)
+	{
+		m_sampleInterval = std::max(instructionInterval, 1U);
+		m_isRunning = true;
+
+		lua_pushlightuserdata(L, this);
+		lua_rawsetp(L, LUA_REGISTRYINDEX, &s_samplerRegistryKey);
+
+		// Threads created from now on inherit the hook of the main thread
+		Attach(L);
+	}
+
+	void ScriptSampler::Stop(lua_State* L)
+	{
+		m_isRunning = false;
+
+		lua_pushnil(L);
+		lua_rawsetp(L, LUA_REGISTRYINDEX, &s_samplerRegistryKey);
+
+		Detach(L);
+	}
+
+	void ScriptSampler::Sample(lua_State* L)
+	{
+		std::size_t depth = 0;
+
+		lua_Debug ar;
+		for (int level = 0; depth < MaxStackDepth && lua_getstack(L, level, &ar) != 0; ++level)
+		{
+			if (lua_getinfo(L, "Sn", &ar) == 0)
+				continue;
+
+			if (depth >= m_frames.size())
+				m_frames.emplace_back();
+
+			std::string& frame = m_frames[depth++];
+			frame.clear();
+
+			if (std::strcmp(ar.what, "main") == 0)
+				frame += "(main chunk)";
+			else
+				AppendFrameName(frame, (ar.name) ? ar.name : "(anonymous)");
+
+			if (std::strcmp(ar.what, "C") == 0)
+				frame += " [C]";
+			else
+			{
+				// Script chunks are named after their path in the script directory
+				const char* source = ar.source;
+				if (*source == '@' || *source == '=')
+					source++;
+
+				frame += " (";
+				AppendFrameName(frame, source, 128);
+				fmt::format_to(std::back_inserter(frame), ":{0})", ar.linedefined);
+			}
+		}
+
+		if (depth == 0)
+			return;
+
+		// Collapsed stacks go from the outermost frame to the innermost one
+		m_stackBuffer.clear();
+		for (std::size_t i = depth; i > 0; --i)
+		{
+			if (i != depth)
+				m_stackBuffer.push_back(';');
+
+			m_stackBuffer += m_frames[i - 1];
+		}
+
+		m_stacks[m_stackBuffer]++;
+		m_sampleCount++;
+	}
+
+	void ScriptSampler::Hook(lua_State* L, lua_Debug* /*ar*/)
+	{
+		lua_rawgetp(L, LUA_REGISTRYINDEX, &s_samplerRegistryKey);
+		ScriptSampler* sampler = static_cast<ScriptSampler*>(lua_touserdata(L, -1));
+		lua_pop(L, 1);
+
+		// Threads still hooked once sampling is over (coroutines created while sampling) unhook themselves
+		if (!sampler)
+		{
+			lua_sethook(L, nullptr, 0, 0);
+			return;
+		}
+
+		sampler->Sample(L);
+	}
+}
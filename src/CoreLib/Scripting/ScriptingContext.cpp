@@ -3,24 +3,41 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/Scripting/ScriptingContext.hpp>
+#include <CoreLib/Scripting/ScriptBytecodeCache.hpp>
 #include <CoreLib/Scripting/SharedScriptingLibrary.hpp>
 #include <CoreLib/SharedMatch.hpp>
 #include <CoreLib/Utils.hpp>
+#include <CoreLib/Utility/JobSystem.hpp>
 #include <Nazara/Core/CallOnExit.hpp>
+#include <Nazara/Core/Clock.hpp>
 #include <Nazara/Core/File.hpp>
+#include <algorithm>
+#include <condition_variable>
 #include <filesystem>
 
 namespace bw
 {
 	namespace
 	{
-		std::size_t MaxInactiveCoroutines = 20;
+		constexpr std::size_t CoroutinePoolCapacity = 64;
 	}
 	
 	ScriptingContext::ScriptingContext(const Logger& logger, std::shared_ptr<VirtualDirectory> scriptDir) :
+	m_garbageCollectorMode(GarbageCollectorMode::Incremental),
+	m_continuationQueue(std::make_shared<ContinuationQueue>()),
 	m_scriptDirectory(std::move(scriptDir)),
 	m_logger(logger)
 	{
+		m_profiler.InstallAllocator(m_luaState);
+
+		// Pre-warm the coroutine pool so bursts of async callbacks don't allocate threads
+		m_availableThreads.reserve(CoroutinePoolCapacity);
+		for (std::size_t i = 0; i < CoroutinePoolCapacity; ++i)
+			m_availableThreads.emplace_back(sol::thread::create(m_luaState));
+
+		m_startedThreads.reserve(CoroutinePoolCapacity);
+		m_suspendedThreads.reserve(CoroutinePoolCapacity);
+
 		m_printFunction = [this](const std::string& str, const Nz::Color& /*color*/)
 		{
 			bwLog(m_logger, LogLevel::Info, "{}", str.data());
@@ -30,7 +47,8 @@ namespace bw
 	ScriptingContext::~ScriptingContext()
 	{
 		m_availableThreads.clear();
-		m_runningThreads.clear();
+		m_startedThreads.clear();
+		m_suspendedThreads.clear();
 	}
 
 	tl::expected<sol::object, std::string> ScriptingContext::Load(const std::filesystem::path& file, bool logError)
@@ -49,7 +67,7 @@ namespace bw
 		{
 			using T = std::decay_t<decltype(arg)>;
 
-			if constexpr (std::is_same_v<T, VirtualDirectory::FileContentEntry> || std::is_same_v<T, VirtualDirectory::PhysicalFileEntry>)
+			if constexpr (std::is_same_v<T, VirtualDirectory::DataPointerEntry> || std::is_same_v<T, VirtualDirectory::FileContentEntry> || std::is_same_v<T, VirtualDirectory::PhysicalFileEntry>)
 				return LoadFile(file, arg);
 			else if constexpr (std::is_same_v<T, VirtualDirectory::VirtualDirectoryEntry>)
 				return tl::unexpected(file.generic_u8string() + " is a directory, expected a file");
@@ -77,7 +95,7 @@ namespace bw
 		{
 			using T = std::decay_t<decltype(arg)>;
 
-			if constexpr (std::is_same_v<T, VirtualDirectory::FileContentEntry> || std::is_same_v<T, VirtualDirectory::PhysicalFileEntry>)
+			if constexpr (std::is_same_v<T, VirtualDirectory::DataPointerEntry> || std::is_same_v<T, VirtualDirectory::FileContentEntry> || std::is_same_v<T, VirtualDirectory::PhysicalFileEntry>)
 				return LoadFile(file, arg, Async{});
 			else if constexpr (std::is_same_v<T, VirtualDirectory::VirtualDirectoryEntry>)
 			{
@@ -132,65 +150,387 @@ namespace bw
 			m_libraries.emplace_back(std::move(library)); //< Store library to ensure it won't be deleted
 	}
 
+	void ScriptingContext::Preload(JobSystem& jobSystem, const std::vector<std::string>& folders)
+	{
+		std::condition_variable jobCondition;
+		std::mutex mutex;
+		std::size_t pendingJobCount = 0;
+		tsl::hopscotch_map<std::string, PreloadedScript> preloadedScripts;
+
+		auto DispatchJob = [&](std::function<void()> job)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				pendingJobCount++;
+			}
+
+			jobSystem.Dispatch([&, job = std::move(job)]
+			{
+				try
+				{
+					job();
+				}
+				catch (const std::exception&)
+				{
+					// Scripts which couldn't be preloaded are loaded as usual, which reports the error
+				}
+
+				// Notified under the lock, as this function returns (destroying the condition) as soon as the count drops to zero
+				std::unique_lock<std::mutex> lock(mutex);
+				if (--pendingJobCount == 0)
+					jobCondition.notify_all();
+			});
+		};
+
+		auto PreloadFile = [&, bytecodeCache = m_bytecodeCache](std::string filePath, VirtualDirectory::Entry entry)
+		{
+			DispatchJob([&, filePath = std::move(filePath), entry = std::move(entry)]
+			{
+				PreloadedScript script;
+				std::string_view content;
+
+				std::visit([&](auto&& arg)
+				{
+					using T = std::decay_t<decltype(arg)>;
+
+					if constexpr (std::is_same_v<T, VirtualDirectory::DataPointerEntry>)
+						content = std::string_view(reinterpret_cast<const char*>(arg.data), arg.size);
+					else if constexpr (std::is_same_v<T, VirtualDirectory::FileContentEntry>)
+						content = std::string_view(reinterpret_cast<const char*>(arg.data()), arg.size());
+					else if constexpr (std::is_same_v<T, VirtualDirectory::PhysicalFileEntry>)
+					{
+						Nz::File file(arg.generic_u8string());
+						if (!file.Open(Nz::OpenMode_ReadOnly))
+							return;
+
+						script.content.resize(file.GetSize());
+						if (file.Read(script.content.data(), script.content.size()) != script.content.size())
+						{
+							script.content.clear();
+							return;
+						}
+
+						content = script.content;
+					}
+					else if constexpr (!std::is_same_v<T, VirtualDirectory::VirtualDirectoryEntry>)
+						static_assert(AlwaysFalse<T>::value, "non-exhaustive visitor");
+				}, entry);
+
+				if (content.empty())
+					return;
+
+				std::string cacheKey = ScriptBytecodeCache::ComputeKey(filePath, content);
+				if (bytecodeCache)
+					script.bytecode = bytecodeCache->Find(cacheKey);
+
+				if (!script.bytecode)
+				{
+					ScriptBytecodeCache::Bytecode bytecode;
+					if (ScriptBytecodeCache::Compile(filePath, content, &bytecode))
+					{
+						if (bytecodeCache)
+							bytecodeCache->Store(cacheKey, bytecode);
+
+						script.bytecode = std::make_shared<const ScriptBytecodeCache::Bytecode>(std::move(bytecode));
+					}
+				}
+
+				std::unique_lock<std::mutex> lock(mutex);
+				preloadedScripts.insert_or_assign(std::move(filePath), std::move(script));
+			});
+		};
+
+		// Subdirectories are enumerated by their own job, this only reads their parent directory
+		std::function<void(std::string directoryPath, VirtualDirectory::VirtualDirectoryEntry directory)> PreloadDirectory;
+		PreloadDirectory = [&](std::string directoryPath, VirtualDirectory::VirtualDirectoryEntry directory)
+		{
+			DispatchJob([&, directoryPath = std::move(directoryPath), directory = std::move(directory)]
+			{
+				directory->Foreach([&](const std::string& entryName, const VirtualDirectory::Entry& entry)
+				{
+					std::string entryPath = directoryPath + "/" + entryName;
+
+					if (std::holds_alternative<VirtualDirectory::VirtualDirectoryEntry>(entry))
+						PreloadDirectory(std::move(entryPath), std::get<VirtualDirectory::VirtualDirectoryEntry>(entry));
+					else if (EndsWith(entryName, ".lua"))
+						PreloadFile(std::move(entryPath), entry);
+				});
+			});
+		};
+
+		for (const std::string& folder : folders)
+		{
+			VirtualDirectory::Entry entry;
+			if (!m_scriptDirectory->GetEntry(folder, &entry))
+				continue;
+
+			if (std::holds_alternative<VirtualDirectory::VirtualDirectoryEntry>(entry))
+				PreloadDirectory(folder, std::get<VirtualDirectory::VirtualDirectoryEntry>(entry));
+			else
+				PreloadFile(folder, std::move(entry));
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		jobCondition.wait(lock, [&] { return pendingJobCount == 0; });
+
+		bwLog(m_logger, LogLevel::Debug, "{0} script(s) preloaded", preloadedScripts.size());
+
+		for (auto it = preloadedScripts.begin(); it != preloadedScripts.end(); ++it)
+			m_preloadedScripts.insert_or_assign(it->first, std::move(it.value()));
+	}
+
+	void ScriptingContext::RegisterLazyTable(std::string name, std::function<void(sol::table& table)> initializer)
+	{
+		sol::table globals = m_luaState.globals();
+
+		if (m_lazyTables.empty())
+		{
+			// Only reached for globals which aren't set
+			sol::table globalsMetatable = m_luaState.create_table();
+			globalsMetatable["__index"] = [this](sol::this_state L, const sol::table& globalTable, const sol::stack_object& key) -> sol::object
+			{
+				if (key.get_type() != sol::type::string)
+					return sol::lua_nil;
+
+				auto it = m_lazyTables.find(key.as<std::string>());
+				if (it == m_lazyTables.end())
+					return sol::lua_nil;
+
+				// Initializers may register other lazy tables (invalidating the iterator), and may access the table they're filling
+				std::string tableName = it->first;
+				auto tableInitializer = it->second;
+
+				sol::table table = sol::state_view(L).create_table();
+				globalTable.raw_set(tableName, table);
+
+				tableInitializer(table);
+
+				return table;
+			};
+
+			globals[sol::metatable_key] = globalsMetatable;
+		}
+
+		// Reloading libraries drops the previous table, it will be filled again on next access
+		globals.raw_set(name, sol::lua_nil);
+		m_lazyTables.insert_or_assign(std::move(name), std::move(initializer));
+	}
+
 	void ScriptingContext::ReloadLibraries()
 	{
 		for (const auto& library : m_libraries)
 			library->RegisterLibrary(*this);
 	}
 
+	void ScriptingContext::SetGarbageCollectorMode(GarbageCollectorMode mode)
+	{
+		lua_State* L = m_luaState.lua_state();
+
+		switch (mode)
+		{
+			case GarbageCollectorMode::Generational:
+				lua_gc(L, LUA_GCGEN, 0, 0);
+				lua_gc(L, LUA_GCRESTART);
+				break;
+
+			case GarbageCollectorMode::Incremental:
+				lua_gc(L, LUA_GCINC, 0, 0, 0);
+				lua_gc(L, LUA_GCRESTART);
+				break;
+
+			case GarbageCollectorMode::IncrementalStepped:
+				lua_gc(L, LUA_GCINC, 0, 0, 0);
+				lua_gc(L, LUA_GCSTOP);
+				break;
+		}
+
+		m_garbageCollectorMode = mode;
+	}
+
+	void ScriptingContext::StartSampling(unsigned int instructionInterval)
+	{
+		m_sampler.Reset();
+		m_sampler.Start(m_luaState, instructionInterval);
+
+		// Pooled threads were created before the main thread was hooked
+		for (auto* threads : { &m_availableThreads, &m_startedThreads, &m_suspendedThreads })
+		{
+			for (sol::thread& thread : *threads)
+				m_sampler.Attach(thread.thread_state());
+		}
+	}
+
+	Nz::UInt64 ScriptingContext::StepGarbageCollector(Nz::UInt64 budget)
+	{
+		if (m_garbageCollectorMode != GarbageCollectorMode::IncrementalStepped)
+			return 0;
+
+		lua_State* L = m_luaState.lua_state();
+
+		Nz::UInt64 startTime = Nz::GetElapsedMicroseconds();
+		Nz::UInt64 duration;
+
+		// Always take at least one step, so memory keeps being reclaimed even when no time is left in ticks
+		do
+		{
+			bool cycleEnded = (lua_gc(L, LUA_GCSTEP, 0) != 0);
+			duration = Nz::GetElapsedMicroseconds() - startTime;
+
+			if (cycleEnded)
+			{
+				m_garbageCollectorStats.cycleCount++;
+				break; //< don't start a new cycle right away, there's nothing left to collect
+			}
+		}
+		while (duration < budget);
+
+		m_garbageCollectorStats.maxStepDuration = std::max(m_garbageCollectorStats.maxStepDuration, duration);
+		m_garbageCollectorStats.stepCount++;
+		m_garbageCollectorStats.totalStepDuration += duration;
+
+		return duration;
+	}
+
+	void ScriptingContext::StopSampling()
+	{
+		m_sampler.Stop(m_luaState);
+
+		for (auto* threads : { &m_availableThreads, &m_startedThreads, &m_suspendedThreads })
+		{
+			for (sol::thread& thread : *threads)
+				m_sampler.Detach(thread.thread_state());
+		}
+	}
+
 	void ScriptingContext::Update()
 	{
-		for (auto it = m_runningThreads.begin(); it != m_runningThreads.end();)
+		// Continuations may resume coroutines, run them before collecting those which are over
 		{
-			sol::thread& runningThread = *it;
-			lua_State* lthread = runningThread.thread_state();
+			std::unique_lock<std::mutex> lock(m_continuationQueue->mutex);
+			std::swap(m_runningContinuations, m_continuationQueue->continuations);
+		}
+
+		for (auto& continuation : m_runningContinuations)
+			continuation();
 
-			bool removeThread = true;
-			switch (static_cast<sol::thread_status>(lua_status(lthread)))
+		m_runningContinuations.clear();
+
+		// Coroutines are resumed by Lua itself, we only have to give back the threads of those which are over
+		for (std::size_t i = 0; i < m_suspendedThreads.size();)
+		{
+			if (lua_status(m_suspendedThreads[i].thread_state()) == LUA_YIELD)
 			{
-				case sol::thread_status::ok:
-					// Coroutine has finished without error, we can recycle its thread
-					if (m_availableThreads.size() < MaxInactiveCoroutines)
-						m_availableThreads.emplace_back(std::move(runningThread));
-					break;
-
-				case sol::thread_status::yielded:
-					removeThread = false;
-					break;
-
-				// Errors
-				case sol::thread_status::dead:
-				case sol::thread_status::handler:
-				case sol::thread_status::gc:
-				case sol::thread_status::memory:
-				case sol::thread_status::runtime:
-					break;
+				++i;
+				continue;
 			}
 
-			if (removeThread)
-				it = m_runningThreads.erase(it);
+			RecycleThread(std::move(m_suspendedThreads[i]));
+
+			m_suspendedThreads[i] = std::move(m_suspendedThreads.back());
+			m_suspendedThreads.pop_back();
+		}
+
+		for (sol::thread& startedThread : m_startedThreads)
+		{
+			if (lua_status(startedThread.thread_state()) == LUA_YIELD)
+				m_suspendedThreads.emplace_back(std::move(startedThread));
 			else
-				++it;
+				RecycleThread(std::move(startedThread));
 		}
+		m_startedThreads.clear();
 	}
 
 	sol::thread& ScriptingContext::CreateThread()
 	{
-		auto AllocateThread = [&]() -> sol::thread&
+		if (m_availableThreads.empty())
 		{
-			bwLog(m_logger, LogLevel::Debug, "Allocating new coroutine ({} total)", m_availableThreads.size() + m_runningThreads.size() + 1);
-			return m_runningThreads.emplace_back(sol::thread::create(m_luaState));
-		};
+			bwLog(m_logger, LogLevel::Debug, "Allocating new coroutine ({} total)", m_startedThreads.size() + m_suspendedThreads.size() + 1);
+			return m_startedThreads.emplace_back(sol::thread::create(m_luaState));
+		}
+
+		sol::thread& thread = m_startedThreads.emplace_back(std::move(m_availableThreads.back()));
+		m_availableThreads.pop_back();
+
+		return thread;
+	}
+
+	void ScriptingContext::RecycleThread(sol::thread&& thread)
+	{
+		// Keep the pool at its capacity, threads allocated during a burst are released to the garbage collector
+		if (m_availableThreads.size() >= CoroutinePoolCapacity)
+			return;
+
+		// A coroutine which died from an error has to be reset before being reused (this leaves the error object on its stack)
+		lua_State* lthread = thread.thread_state();
+		if (lua_status(lthread) != LUA_OK)
+			lua_resetthread(lthread);
 
-		auto PopThread = [&]() -> sol::thread&
+		lua_settop(lthread, 0);
+
+		m_availableThreads.emplace_back(std::move(thread));
+	}
+
+	tl::expected<sol::protected_function, std::string> ScriptingContext::LoadChunk(const std::filesystem::path& path, const std::string_view& content)
+	{
+		sol::state& state = GetLuaState();
+		std::string chunkName = path.generic_string();
+
+		auto Load = [&](const std::string_view& code, sol::load_mode mode) -> tl::expected<sol::protected_function, std::string>
 		{
-			sol::thread& thread = m_runningThreads.emplace_back(std::move(m_availableThreads.back()));
-			m_availableThreads.pop_back();
+			sol::load_result result = state.load(code, chunkName, mode);
+			if (!result.valid())
+			{
+				sol::error err = result;
+				return tl::unexpected(std::string(err.what()));
+			}
 
-			return thread;
+			return sol::protected_function(result);
 		};
 
-		return (!m_availableThreads.empty()) ? PopThread() : AllocateThread();
+		if (auto it = m_preloadedScripts.find(chunkName); it != m_preloadedScripts.end())
+		{
+			std::shared_ptr<const ScriptBytecodeCache::Bytecode> bytecode = std::move(it.value().bytecode);
+			m_preloadedScripts.erase(it);
+
+			// Compilation errors are reported by loading the source
+			if (bytecode)
+			{
+				auto chunk = Load(std::string_view(reinterpret_cast<const char*>(bytecode->data()), bytecode->size()), sol::load_mode::binary);
+				if (chunk)
+					return chunk;
+
+				bwLog(m_logger, LogLevel::Warning, "failed to load preloaded bytecode of {0} ({1}), recompiling it", chunkName, chunk.error());
+			}
+		}
+
+		if (!m_bytecodeCache)
+			return Load(content, sol::load_mode::text);
+
+		std::string cacheKey = ScriptBytecodeCache::ComputeKey(chunkName, content);
+		if (std::shared_ptr<const ScriptBytecodeCache::Bytecode> bytecode = m_bytecodeCache->Find(cacheKey))
+		{
+			auto chunk = Load(std::string_view(reinterpret_cast<const char*>(bytecode->data()), bytecode->size()), sol::load_mode::binary);
+			if (chunk)
+				return chunk;
+
+			bwLog(m_logger, LogLevel::Warning, "failed to load cached bytecode of {0} ({1}), recompiling it", chunkName, chunk.error());
+		}
+
+		auto chunk = Load(content, sol::load_mode::text);
+		if (chunk)
+			m_bytecodeCache->Store(cacheKey, ScriptBytecodeCache::Dump(chunk.value()));
+
+		return chunk;
+	}
+
+	tl::expected<sol::object, std::string> ScriptingContext::LoadFile(std::filesystem::path path, const VirtualDirectory::DataPointerEntry& entry)
+	{
+		return LoadFile(std::move(path), std::string_view(reinterpret_cast<const char*>(entry.data), entry.size));
+	}
+
+	auto ScriptingContext::LoadFile(std::filesystem::path path, const VirtualDirectory::DataPointerEntry& entry, Async) -> std::optional<FileLoadCoroutine>
+	{
+		return LoadFile(std::move(path), std::string_view(reinterpret_cast<const char*>(entry.data), entry.size), Async{});
 	}
 
 	tl::expected<sol::object, std::string> ScriptingContext::LoadFile(std::filesystem::path path, const VirtualDirectory::FileContentEntry& entry)
@@ -232,8 +572,11 @@ namespace bw
 		m_currentFile = std::move(path);
 		m_currentFolder = m_currentFile.parent_path();
 
-		sol::state& state = GetLuaState();
-		sol::protected_function_result result = state.do_string(content, m_currentFile.generic_string());
+		auto chunk = LoadChunk(m_currentFile, content);
+		if (!chunk)
+			return tl::unexpected("failed to load " + m_currentFile.generic_u8string() + ": " + chunk.error());
+
+		sol::protected_function_result result = chunk.value()();
 		if (!result.valid())
 		{
 			sol::error err = result;
@@ -245,21 +588,20 @@ namespace bw
 
 	auto ScriptingContext::LoadFile(std::filesystem::path path, const std::string_view& content, Async) -> std::optional<FileLoadCoroutine>
 	{
-		sol::state& state = GetLuaState();
-		sol::load_result result = state.load(content, path.generic_string());
-		if (!result.valid())
+		auto chunk = LoadChunk(path, content);
+		if (!chunk)
 		{
-			sol::error err = result;
-			bwLog(m_logger, LogLevel::Error, "failed to load {0}: {1}", path.generic_u8string(), err.what());
+			bwLog(m_logger, LogLevel::Error, "failed to load {0}: {1}", path.generic_u8string(), chunk.error());
 			return {};
 		}
 
+		sol::state& state = GetLuaState();
 		sol::thread thread = sol::thread::create(state.lua_state());
 		sol::state_view threadState = thread.state();
 
 		return FileLoadCoroutine{
 			std::move(thread),
-			sol::coroutine(threadState, sol::protected_function(result)),
+			sol::coroutine(threadState, std::move(chunk.value())),
 			std::move(path)
 		};
 	}
@@ -273,7 +615,7 @@ namespace bw
 			{
 				using T = std::decay_t<decltype(arg)>;
 
-				if constexpr (std::is_same_v<T, VirtualDirectory::FileContentEntry> || std::is_same_v<T, VirtualDirectory::PhysicalFileEntry>)
+				if constexpr (std::is_same_v<T, VirtualDirectory::DataPointerEntry> || std::is_same_v<T, VirtualDirectory::FileContentEntry> || std::is_same_v<T, VirtualDirectory::PhysicalFileEntry>)
 					return LoadFile(entryPath, arg);
 				else if constexpr (std::is_same_v<T, VirtualDirectory::VirtualDirectoryEntry>)
 				{
@@ -292,6 +634,10 @@ namespace bw
 
 	std::string ScriptingContext::ReadFile(const std::filesystem::path& path, const VirtualDirectory::PhysicalFileEntry& entry)
 	{
+		// Its bytecode is left to LoadChunk
+		if (auto it = m_preloadedScripts.find(path.generic_string()); it != m_preloadedScripts.end() && !it->second.content.empty())
+			return std::move(it.value().content);
+
 		Nz::File file(entry.generic_u8string());
 		if (!file.Open(Nz::OpenMode_ReadOnly))
 		{
@@ -19,6 +19,7 @@
 #include <NDK/Components/PhysicsComponent2D.hpp>
 #include <NDK/Systems/PhysicsSystem2D.hpp>
 #include <sol/sol.hpp>
+#include <algorithm>
 
 namespace bw
 {
@@ -88,12 +89,16 @@ namespace bw
 			}
 
 			const auto& entityProperties = entityScript.GetProperties();
-			if (!entityProperties.empty())
+			std::size_t propertyCount = std::count_if(entityProperties.begin(), entityProperties.end(), [](const auto& value) { return value.has_value(); });
+			if (propertyCount > 0)
 			{
-				sol::table propertyTable = state.create_table(int(entityProperties.size()), 0);
+				sol::table propertyTable = state.create_table(int(propertyCount), 0);
 
-				for (const auto& [name, value] : entityProperties)
-					propertyTable[name] = TranslatePropertyToLua(&match, state, value);
+				for (const auto& [name, property] : element->properties)
+				{
+					if (property.index < entityProperties.size() && entityProperties[property.index])
+						propertyTable[name] = TranslatePropertyToLua(&match, state, *entityProperties[property.index]);
+				}
 
 				resultTable["Properties"] = propertyTable;
 			}
@@ -12,6 +12,7 @@
 #include <CoreLib/Components/NetworkSyncComponent.hpp>
 #include <CoreLib/Components/PlayerControlledComponent.hpp>
 #include <CoreLib/Components/PlayerMovementComponent.hpp>
+#include <CoreLib/Components/PoolableComponent.hpp>
 #include <CoreLib/Components/ScriptComponent.hpp>
 #include <CoreLib/Scripting/ScriptingUtils.hpp>
 #include <CoreLib/Systems/NetworkSyncSystem.hpp>
@@ -74,10 +75,18 @@ namespace bw
 		if (entityClass->isNetworked)
 		{
 			// Not quite sure about this, maybe parent handling should be automatic?
+			NetworkSyncComponent* syncComponent;
 			if (parent && parent->HasComponent<NetworkSyncComponent>())
-				entity->AddComponent<NetworkSyncComponent>(entityClass->fullName, parent);
+				syncComponent = &entity->AddComponent<NetworkSyncComponent>(entityClass->fullName, parent);
 			else
-				entity->AddComponent<NetworkSyncComponent>(entityClass->fullName);
+				syncComponent = &entity->AddComponent<NetworkSyncComponent>(entityClass->fullName);
+
+			NetworkSyncComponent::Settings syncSettings;
+			syncSettings.maxUpdateRate = entityClass->networkMaxUpdateRate;
+			syncSettings.priority = entityClass->networkPriority;
+			syncSettings.relevanceDistance = entityClass->networkRelevanceDistance;
+
+			syncComponent->UpdateSettings(syncSettings);
 		}
 
 		if (playerControlled)
@@ -99,6 +108,20 @@ namespace bw
 
 	const Ndk::EntityHandle& ServerEntityStore::InstantiateEntity(TerrainLayer& layer, std::size_t entityIndex, EntityId uniqueId, const Nz::Vector2f& position, const Nz::DegreeAnglef& rotation, const PropertyValueMap& properties, const Ndk::EntityHandle& parent) const
 	{
+		// Child entities follow their parent lifecycle and are never pooled
+		bool isPoolable = (GetElement(entityIndex)->poolSize > 0 && !parent);
+		if (isPoolable)
+		{
+			if (const Ndk::EntityHandle& entity = layer.RespawnEntity(entityIndex, uniqueId, position, rotation, properties))
+			{
+				// Init already ran when the entity was first created, scripts reset their state on respawn
+				entity->GetComponent<ScriptComponent>().ExecuteCallback<ElementEvent::Respawn>();
+
+				bwLog(GetLogger(), LogLevel::Debug, "Respawned entity {} on layer {} of type {}", uniqueId, layer.GetLayerIndex(), GetElement(entityIndex)->fullName);
+				return entity;
+			}
+		}
+
 		const Ndk::EntityHandle& entity = CreateEntity(layer, entityIndex, uniqueId, position, rotation, properties, parent);
 		if (!entity)
 			return Ndk::EntityHandle::InvalidHandle;
@@ -109,6 +132,9 @@ namespace bw
 			return Ndk::EntityHandle::InvalidHandle;
 		}
 
+		if (isPoolable)
+			entity->AddComponent<PoolableComponent>(layer, entityIndex);
+
 		return entity;
 	}
 
@@ -121,7 +147,12 @@ namespace bw
 	{
 		SharedEntityStore::InitializeElement(elementTable, element);
 
+		element.checkpoint = elementTable.get_or("Checkpoint", false);
 		element.isNetworked = elementTable.get_or("IsNetworked", false);
 		element.maxHealth = elementTable.get_or("MaxHealth", Nz::UInt16(0));
+		element.networkMaxUpdateRate = elementTable.get_or("NetworkMaxUpdateRate", 0.f);
+		element.networkPriority = elementTable.get_or("NetworkPriority", Nz::UInt8(1));
+		element.networkRelevanceDistance = elementTable.get_or("NetworkRelevanceDistance", 0.f);
+		element.poolSize = elementTable.get_or("PoolSize", std::size_t(0));
 	}
 }
@@ -4,6 +4,8 @@
 
 #include <CoreLib/Scripting/ServerScriptingLibrary.hpp>
 #include <CoreLib/Match.hpp>
+#include <CoreLib/HitboxHistory.hpp>
+#include <CoreLib/MatchClientSession.hpp>
 #include <CoreLib/MatchClientVisibility.hpp>
 #include <CoreLib/Player.hpp>
 #include <CoreLib/PlayerInputController.hpp>
@@ -11,7 +13,9 @@
 #include <CoreLib/Components/EntityOwnerComponent.hpp>
 #include <CoreLib/Components/MatchComponent.hpp>
 #include <CoreLib/Components/OwnerComponent.hpp>
+#include <CoreLib/Components/PoolableComponent.hpp>
 #include <CoreLib/Scripting/NetworkPacket.hpp>
+#include <CoreLib/Scripting/ScriptMessageValue.hpp>
 #include <CoreLib/Scripting/ServerTexture.hpp>
 #include <CoreLib/Scripting/ScriptingUtils.hpp>
 #include <CoreLib/Scripting/SharedElementLibrary.hpp>
@@ -36,10 +40,8 @@ namespace bw
 	{
 		SharedScriptingLibrary::RegisterLibrary(context);
 
-		sol::state& luaState = context.GetLuaState();
-		sol::table assetTable = luaState.create_named_table("assets");
+		context.RegisterLazyTable("assets", [this, &context](sol::table& library) { RegisterAssetLibrary(context, library); });
 
-		RegisterAssetLibrary(context, assetTable);
 		RegisterPlayerClass(context);
 		RegisterServerTextureClass(context);
 
@@ -154,6 +156,7 @@ namespace bw
 		library["BroadcastPacket"] = LuaFunction([&](const OutgoingNetworkPacket& outgoingPacket, std::optional<bool> onlyReady)
 		{
 			Match& match = GetMatch();
+			match.FlushNetworkStrings(); //< packet name may have been registered this tick
 
 			const NetworkStringStore& networkStringStore = match.GetNetworkStringStore();
 			match.BroadcastPacket(outgoingPacket.ToPacket(networkStringStore), onlyReady.value_or(true));
@@ -222,6 +225,10 @@ namespace bw
 
 			if (lifeOwner)
 			{
+				// Owner would kill the entity on its death, even after it went back to its pool
+				if (entity->HasComponent<PoolableComponent>())
+					entity->RemoveComponent<PoolableComponent>();
+
 				if (!lifeOwner->HasComponent<EntityOwnerComponent>())
 					lifeOwner->AddComponent<EntityOwnerComponent>();
 
@@ -293,6 +300,11 @@ namespace bw
 			return GetMatch().GetCurrentTick();
 		});
 		
+		library["GetNetworkStatistics"] = LuaFunction([&]()
+		{
+			return GetMatch().GetSessions().FormatNetworkStatistics();
+		});
+
 		library["GetPlayerByIndex"] = LuaFunction([&](sol::this_state L, Nz::UInt16 playerIndex) -> sol::object
 		{
 			if (Player* player = GetMatch().GetPlayerByIndex(playerIndex))
@@ -318,11 +330,63 @@ namespace bw
 			return playerTable;
 		});
 
+		library["GetMemoryReport"] = LuaFunction([&]
+		{
+			return GetMatch().FormatMemoryUsage();
+		});
+
+		library["GetRandomSeed"] = LuaFunction([&]
+		{
+			return GetMatch().GetRandomSeed();
+		});
+
 		library["GetTick"] = LuaFunction([&]
 		{
 			return GetMatch().GetCurrentTick();
 		});
 
+		library["GetTickProfile"] = LuaFunction([&]()
+		{
+			Match& match = GetMatch();
+
+			std::string profile = match.GetTickProfiler().Format();
+
+			const ScriptProfiler& scriptProfiler = match.GetScriptProfiler();
+			if (scriptProfiler.IsEnabled())
+			{
+				profile += '\n';
+				profile += scriptProfiler.Format();
+			}
+
+			if (match.IsLoadSheddingEnabled())
+			{
+				profile += '\n';
+				profile += match.FormatLoadStatistics();
+			}
+
+			return profile;
+		});
+
+		// Layers only talk to each other through messages, which are copied and received at the beginning of the next tick
+		library["PostLayerMessage"] = LuaFunction([&](sol::this_state L, LayerIndex layerIndex, std::string name, const sol::object& value)
+		{
+			Match& match = GetMatch();
+			if (layerIndex >= match.GetLayerCount())
+				TriggerLuaArgError(L, 1, "layer out of range (" + std::to_string(layerIndex) + " > " + std::to_string(match.GetLayerCount()) + ")");
+
+			ScriptMessageValue messageValue;
+			try
+			{
+				messageValue = ScriptMessageValue::FromLua(match, value);
+			}
+			catch (const std::exception& e)
+			{
+				TriggerLuaArgError(L, 3, e.what());
+			}
+
+			match.GetTerrain().PostLayerMessage(layerIndex, std::move(name), std::move(messageValue));
+		});
+
 		library["ResetTerrain"] = LuaFunction([&]
 		{
 			return GetMatch().ResetTerrain();
@@ -332,18 +396,147 @@ namespace bw
 		{
 			return GetMatch().Quit();
 		});
+
+		library["SetAdjacentLayers"] = LuaFunction([&](sol::this_state L, LayerIndex layerIndex, const sol::table& adjacentLayers)
+		{
+			Match& match = GetMatch();
+			if (layerIndex >= match.GetLayerCount())
+				TriggerLuaArgError(L, 1, "layer out of range (" + std::to_string(layerIndex) + " > " + std::to_string(match.GetLayerCount()) + ")");
+
+			std::vector<LayerIndex> layers;
+			layers.reserve(adjacentLayers.size());
+			for (std::size_t i = 1; i <= adjacentLayers.size(); ++i)
+			{
+				LayerIndex adjacentLayer = adjacentLayers[i];
+				if (adjacentLayer >= match.GetLayerCount())
+					TriggerLuaArgError(L, 2, "layer out of range (" + std::to_string(adjacentLayer) + " > " + std::to_string(match.GetLayerCount()) + ")");
+
+				if (adjacentLayer != layerIndex)
+					layers.push_back(adjacentLayer);
+			}
+
+			match.GetTerrain().SetAdjacentLayers(layerIndex, std::move(layers));
+		});
+
+		library["SetLayerMessageHandler"] = LuaFunction([&](sol::this_state L, LayerIndex layerIndex, std::string name, sol::main_protected_function handler)
+		{
+			Match& match = GetMatch();
+			if (layerIndex >= match.GetLayerCount())
+				TriggerLuaArgError(L, 1, "layer out of range (" + std::to_string(layerIndex) + " > " + std::to_string(match.GetLayerCount()) + ")");
+
+			ScriptHandlerRegistry& messageHandlers = match.GetTerrain().GetLayerMessageHandlers(layerIndex);
+			if (handler)
+				messageHandlers.Register(std::move(name), std::move(handler));
+			else
+				messageHandlers.Unregister(name);
+		});
 	}
 
 	void ServerScriptingLibrary::RegisterNetworkLibrary(ScriptingContext& context, sol::table& library)
 	{
 		SharedScriptingLibrary::RegisterNetworkLibrary(context, library);
 
+		// Declaring a packet also registers its name, so scripts don't have to do both
+		library["DeclarePacket"] = LuaFunction([&](sol::this_state L, std::string packetName, const sol::table& fields)
+		{
+			Match& match = GetMatch();
+
+			try
+			{
+				match.RegisterScriptPacketSchema(packetName, NetworkPacketSchema::FromLua(fields));
+			}
+			catch (const std::exception& e)
+			{
+				TriggerLuaError(L, "Packet \"" + packetName + "\": " + e.what());
+			}
+
+			match.RegisterNetworkString(std::move(packetName));
+		});
+
 		library["RegisterPacket"] = LuaFunction([&](std::string packetName)
 		{
 			GetMatch().RegisterNetworkString(std::move(packetName));
 		});
 	}
 
+	void ServerScriptingLibrary::RegisterPhysicsLibrary(ScriptingContext& context, sol::table& library)
+	{
+		SharedScriptingLibrary::RegisterPhysicsLibrary(context, library);
+
+		// Lag compensation: trace against entities as the shooter saw them when using their weapon (the MatchState their last inputs acknowledged)
+		auto GetRewindParameters = [this](const std::optional<PlayerHandle>& shooter) -> std::pair<Nz::UInt16, Ndk::EntityHandle>
+		{
+			Match& match = GetMatch();
+			if (!shooter || !shooter.value())
+				return { match.GetNetworkTick(), Ndk::EntityHandle::InvalidHandle };
+
+			Player* player = shooter.value().GetObject();
+			const std::optional<Nz::UInt16>& viewTick = player->GetSession().GetLastInputStateTick();
+
+			return { (viewTick) ? *viewTick : match.GetNetworkTick(), player->GetControlledEntity() };
+		};
+
+		auto BuildResult = [](sol::state_view& state, const HitboxHistory::RaycastHit& hitInfo)
+		{
+			sol::table result = state.create_table();
+			result["fraction"] = hitInfo.fraction;
+			result["hitPos"] = hitInfo.hitPos;
+			result["hitNormal"] = hitInfo.hitNormal;
+
+			if (hitInfo.entity->HasComponent<ScriptComponent>())
+				result["hitEntity"] = hitInfo.entity->GetComponent<ScriptComponent>().GetTable();
+
+			return result;
+		};
+
+		library["TraceRewind"] = LuaFunction([=](sol::this_state L, LayerIndex layer, Nz::Vector2f startPos, Nz::Vector2f endPos, std::optional<PlayerHandle> shooter) -> sol::object
+		{
+			Match& match = GetMatch();
+			if (layer >= match.GetLayerCount())
+				TriggerLuaArgError(L, 1, "invalid layer index");
+
+			TerrainLayer& terrainLayer = match.GetLayer(layer);
+			auto [tick, shooterEntity] = GetRewindParameters(shooter);
+
+			HitboxHistory::RaycastHit hitInfo;
+			if (terrainLayer.GetHitboxHistory().RaycastQueryFirst(match, terrainLayer.GetWorld(), tick, startPos, endPos, shooterEntity, &hitInfo))
+			{
+				sol::state_view state(L);
+				return BuildResult(state, hitInfo);
+			}
+			else
+				return sol::nil;
+		});
+
+		library["TraceMultipleRewind"] = LuaFunction([=](sol::this_state L, LayerIndex layer, Nz::Vector2f startPos, Nz::Vector2f endPos, std::optional<PlayerHandle> shooter, const sol::protected_function& callback)
+		{
+			Match& match = GetMatch();
+			if (layer >= match.GetLayerCount())
+				TriggerLuaArgError(L, 1, "invalid layer index");
+
+			TerrainLayer& terrainLayer = match.GetLayer(layer);
+			auto [tick, shooterEntity] = GetRewindParameters(shooter);
+
+			Ndk::EntityList hitEntities;
+
+			sol::state_view state(L);
+			terrainLayer.GetHitboxHistory().RaycastQuery(match, terrainLayer.GetWorld(), tick, startPos, endPos, shooterEntity, [&](const HitboxHistory::RaycastHit& hitInfo)
+			{
+				if (hitEntities.Has(hitInfo.entity))
+					return;
+
+				hitEntities.Insert(hitInfo.entity);
+
+				auto callbackResult = callback(BuildResult(state, hitInfo));
+				if (!callbackResult.valid())
+				{
+					sol::error err = callbackResult;
+					bwLogRateLimited(match.GetLogger(), LogLevel::Error, "physics.TraceMultipleRewind callback failed: {}", err.what());
+				}
+			});
+		});
+	}
+
 	void ServerScriptingLibrary::RegisterPlayerClass(ScriptingContext& context)
 	{
 		sol::state& state = context.GetLuaState();
@@ -373,7 +566,10 @@ namespace bw
 			"PrintChatMessage", LuaFunction(&Player::PrintChatMessage),
 			"SendPacket", LuaFunction([this](Player& player, const OutgoingNetworkPacket& outgoingPacket)
 			{
-				const NetworkStringStore& networkStringStore = GetSharedMatch().GetNetworkStringStore();
+				Match& match = GetMatch();
+				match.FlushNetworkStrings(); //< packet name may have been registered this tick
+
+				const NetworkStringStore& networkStringStore = match.GetNetworkStringStore();
 				player.SendPacket(outgoingPacket.ToPacket(networkStringStore));
 			}),
 			"SetAdmin", LuaFunction(&Player::SetAdmin),
@@ -401,6 +597,12 @@ namespace bw
 			Match& match = GetMatch();
 			match.ReloadScripts();
 		});
+
+		library["ReloadChanged"] = LuaFunction([this]()
+		{
+			Match& match = GetMatch();
+			match.ReloadChangedScripts();
+		});
 	}
 
 	void ServerScriptingLibrary::RegisterServerTextureClass(ScriptingContext& context)
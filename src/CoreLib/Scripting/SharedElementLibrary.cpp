@@ -5,6 +5,7 @@
 #include <CoreLib/Scripting/SharedElementLibrary.hpp>
 #include <CoreLib/Components/EntityOwnerComponent.hpp>
 #include <CoreLib/Components/HealthComponent.hpp>
+#include <CoreLib/Components/PoolableComponent.hpp>
 #include <CoreLib/Components/ScriptComponent.hpp>
 #include <CoreLib/Scripting/ElementEventConnection.hpp>
 #include <CoreLib/Scripting/ScriptingUtils.hpp>
@@ -15,6 +16,29 @@
 
 namespace bw
 {
+	namespace
+	{
+		const ScriptedEvent& RetrieveCustomEvent(const ScriptedElement& element, const sol::stack_object& event)
+		{
+			// Event handles (see EventHandles) skip the name lookup
+			if (event.get_type() == sol::type::number)
+			{
+				std::size_t eventIndex = event.as<std::size_t>();
+				if (eventIndex >= element.customEvents.size())
+					throw std::runtime_error("invalid event handle " + std::to_string(eventIndex));
+
+				return element.customEvents[eventIndex];
+			}
+
+			std::string eventName = event.as<std::string>();
+			auto it = element.customEventByName.find(eventName);
+			if (it == element.customEventByName.end())
+				throw std::runtime_error("unknown event " + eventName);
+
+			return element.customEvents[it->second];
+		}
+	}
+
 	SharedElementLibrary::~SharedElementLibrary() = default;
 
 	void SharedElementLibrary::RegisterLibrary(sol::table& elementMetatable)
@@ -133,7 +157,7 @@ namespace bw
 				entityHealth.Damage(entityHealth.GetHealth(), entity);
 			}
 			else
-				entity->Kill();
+				PoolableComponent::KillEntity(entity);
 		});
 
 		elementMetatable["On"] = LuaFunction([&](sol::this_state L, const sol::table& entityTable, const std::string_view& event, sol::main_protected_function callback)
@@ -152,6 +176,12 @@ namespace bw
 			entity->AddComponent<Ndk::LifetimeComponent>(lifetime);
 		});
 
+		elementMetatable["SetNextTick"] = LuaFunction([](const sol::table& entityTable, float seconds)
+		{
+			Ndk::EntityHandle entity = AssertScriptEntity(entityTable);
+			entity->GetComponent<ScriptComponent>().SetNextTick(seconds);
+		});
+
 		elementMetatable["SetScale"] = LuaFunction([&](const sol::table& entityTable, float scale)
 		{
 			Ndk::EntityHandle entity = AssertScriptEntity(entityTable);
@@ -174,19 +204,12 @@ namespace bw
 			return Nz::Vector2f(nodeComponent.ToGlobalPosition(localPosition));
 		});
 
-		elementMetatable["Trigger"] = LuaFunction([](const sol::table& entityTable, const std::string_view& event, sol::variadic_args parameters)
+		elementMetatable["Trigger"] = LuaFunction([](const sol::table& entityTable, const sol::stack_object& event, sol::variadic_args parameters)
 		{
 			Ndk::EntityHandle entity = AssertScriptEntity(entityTable);
 
 			auto& entityScript = entity->GetComponent<ScriptComponent>();
-			const auto& element = entityScript.GetElement();
-
-			std::string eventName = std::string(event);
-			auto it = element->customEventByName.find(eventName);
-			if (it == element->customEventByName.end())
-				throw std::runtime_error("unknown event " + eventName);
-
-			const auto& eventData = element->customEvents[it->second];
+			const auto& eventData = RetrieveCustomEvent(*entityScript.GetElement(), event);
 
 			return entityScript.ExecuteCustomCallback(eventData.index, parameters);
 		});
@@ -232,6 +255,8 @@ namespace bw
 			callbackData.callback = std::move(callback);
 			callbackData.callbackId = element->nextCallbackId++;
 
+			element->sharedCallbacks.reset();
+
 			return ElementEventConnection{ eventIndex, callbackData.callbackId };
 		}
 	}
@@ -266,6 +291,8 @@ namespace bw
 			callbackData.callback = std::move(callback);
 			callbackData.callbackId = element->nextCallbackId++;
 
+			element->sharedCallbacks.reset();
+
 			return ElementEventConnection{ scriptingEvent, callbackData.callbackId };
 		}
 	}
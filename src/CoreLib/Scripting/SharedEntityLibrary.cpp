@@ -11,6 +11,7 @@
 #include <CoreLib/Components/HealthComponent.hpp>
 #include <CoreLib/Components/InputComponent.hpp>
 #include <CoreLib/Components/PlayerMovementComponent.hpp>
+#include <CoreLib/Components/PoolableComponent.hpp>
 #include <CoreLib/Components/ScriptComponent.hpp>
 #include <CoreLib/Components/WeaponWielderComponent.hpp>
 #include <CoreLib/Scripting/ScriptingUtils.hpp> 
@@ -473,7 +474,7 @@ namespace bw
 						else
 						{
 							sol::error err = result;
-							bwLog(entityScript.GetLogger(), LogLevel::Error, "Movement controller callback failed: {0}", err.what());
+							bwLogRateLimited(entityScript.GetLogger(), LogLevel::Error, "Movement controller callback failed: {0}", err.what());
 						}
 
 						body2D.UpdateVelocity(overridedGravity, overridedDamping, deltaTime);
@@ -487,7 +488,7 @@ namespace bw
 		elementMetatable["Remove"] = LuaFunction([](const sol::table& entityTable)
 		{
 			Ndk::EntityHandle entity = AssertScriptEntity(entityTable);
-			entity->Kill();
+			PoolableComponent::KillEntity(entity);
 		});
 
 		elementMetatable["SetAngularVelocity"] = LuaFunction([](const sol::table& entityTable, const Nz::DegreeAnglef& velocity)
@@ -506,9 +507,7 @@ namespace bw
 
 			std::size_t colliderCount = colliderTable.size();
 
-			auto& entityNode = entity->GetComponent<Ndk::NodeComponent>();
-			auto& entityCollData = entity->AddComponent<CollisionDataComponent>();
-
+			std::vector<Collider> colliders;
 			if (colliderCount <= 1)
 			{
 				// Only one collider passed in a table or directly
@@ -516,9 +515,9 @@ namespace bw
 				try
 				{
 					if (colliderCount == 0)
-						entityCollData.AddCollider(ParseCollider(colliderTable));
+						colliders.emplace_back(ParseCollider(colliderTable));
 					else
-						entityCollData.AddCollider(ParseCollider(colliderTable[1]));
+						colliders.emplace_back(ParseCollider(colliderTable[1]));
 				}
 				catch (const std::exception& e)
 				{
@@ -528,11 +527,12 @@ namespace bw
 			else
 			{
 				// Multiple colliders passed in a table
+				colliders.reserve(colliderCount);
 				for (std::size_t i = 0; i < colliderCount; ++i)
 				{
 					try
 					{
-						entityCollData.AddCollider(ParseCollider(colliderTable[i + 1]));
+						colliders.emplace_back(ParseCollider(colliderTable[i + 1]));
 					}
 					catch (const std::exception& e)
 					{
@@ -541,6 +541,16 @@ namespace bw
 				}
 			}
 
+			// Instances of the same element usually have the same colliders, share them (and the built physics colliders)
+			std::shared_ptr<const ColliderGeometry> geometry;
+			if (entity->HasComponent<ScriptComponent>())
+				geometry = entity->GetComponent<ScriptComponent>().GetElement()->colliderCache.GetGeometry(std::move(colliders));
+			else
+				geometry = std::make_shared<const ColliderGeometry>(std::move(colliders));
+
+			auto& entityNode = entity->GetComponent<Ndk::NodeComponent>();
+			auto& entityCollData = entity->AddComponent<CollisionDataComponent>(std::move(geometry));
+
 			entity->AddComponent<Ndk::CollisionComponent2D>(entityCollData.BuildCollider(entityNode.GetScale().y));
 		});
 
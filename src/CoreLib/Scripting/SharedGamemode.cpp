@@ -81,6 +81,13 @@ namespace bw
 			}
 		}
 
+		// Base gamemodes events are loaded first, this holds every event the gamemode knows of
+		sol::table eventHandles = sol::state_view(gamemodeTable.lua_state()).create_table(0, int(m_customEvents.size()));
+		for (const ScriptedEvent& event : m_customEvents)
+			eventHandles[event.name] = event.index;
+
+		gamemodeTable["EventHandles"] = eventHandles;
+
 		sol::object properties = gamemodeTable.raw_get<sol::object>("Properties");
 		if (properties)
 		{
@@ -155,16 +162,27 @@ namespace bw
 			return RegisterEvent(gamemodeTable, event, std::move(callback), true);
 		};
 
-		m_gamemodeMetatable["Trigger"] = [&](const sol::table& /*gamemodeTable*/, const std::string_view& event, sol::variadic_args parameters)
+		m_gamemodeMetatable["Trigger"] = [&](const sol::table& /*gamemodeTable*/, const sol::stack_object& event, sol::variadic_args parameters)
 		{
-			std::string eventName = std::string(event);
-			auto it = m_customEventByName.find(eventName);
-			if (it == m_customEventByName.end())
-				throw std::runtime_error("unknown event " + eventName);
+			// Event handles (see EventHandles) skip the name lookup
+			std::size_t eventIndex;
+			if (event.get_type() == sol::type::number)
+			{
+				eventIndex = event.as<std::size_t>();
+				if (eventIndex >= m_customEvents.size())
+					throw std::runtime_error("invalid event handle " + std::to_string(eventIndex));
+			}
+			else
+			{
+				std::string eventName = event.as<std::string>();
+				auto it = m_customEventByName.find(eventName);
+				if (it == m_customEventByName.end())
+					throw std::runtime_error("unknown event " + eventName);
 
-			const auto& eventData = m_customEvents[it->second];
+				eventIndex = it->second;
+			}
 
-			return ExecuteCustomCallback(eventData.index, parameters);
+			return ExecuteCustomCallback(m_customEvents[eventIndex].index, parameters);
 		};
 
 		m_gamemodeMetatable["GetProperty"] = [&](sol::this_state s, const sol::table& /*table*/, const std::string& propertyName) -> sol::object
@@ -13,20 +13,120 @@
 #include <CoreLib/Scripting/ElementEventConnection.hpp>
 #include <CoreLib/Scripting/GamemodeEventConnection.hpp>
 #include <CoreLib/Scripting/NetworkPacket.hpp>
+#include <CoreLib/Scripting/ScriptBytecodeCache.hpp>
 #include <CoreLib/Scripting/SharedElementLibrary.hpp>
+#include <CoreLib/Scripting/SharedEntityStore.hpp>
 #include <CoreLib/Scripting/SharedGamemode.hpp>
 #include <CoreLib/Scripting/ScriptingContext.hpp>
 #include <CoreLib/Scripting/ScriptingUtils.hpp>
+#include <CoreLib/Systems/ElementIndexSystem.hpp>
+#include <CoreLib/Utility/JobSystem.hpp>
+#include <Nazara/Core/File.hpp>
 #include <Nazara/Physics2D/Constraint2D.hpp>
 #include <NDK/Components/ConstraintComponent2D.hpp>
 #include <NDK/Systems/PhysicsSystem2D.hpp>
+#include <CoreLib/BurgApp.hpp>
 #include <CoreLib/SharedMatch.hpp>
+#include <CoreLib/Utils.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <vector>
 
 namespace bw
 {
+	namespace
+	{
+		constexpr int JobBudgetCheckInterval = 10'000; //< instructions between two budget checks
+
+		char s_jobBudgetRegistryKey; //< address used as the registry key of the job remaining instruction count
+
+		void JobBudgetHook(lua_State* L, lua_Debug* /*ar*/)
+		{
+			lua_rawgetp(L, LUA_REGISTRYINDEX, &s_jobBudgetRegistryKey);
+			Nz::UInt64* remainingInstructions = static_cast<Nz::UInt64*>(lua_touserdata(L, -1));
+			lua_pop(L, 1);
+
+			if (*remainingInstructions > JobBudgetCheckInterval)
+			{
+				*remainingInstructions -= JobBudgetCheckInterval;
+				return;
+			}
+
+			// Check every instruction from now on so a pcall loop can't swallow the error and keep running
+			lua_sethook(L, &JobBudgetHook, LUA_MASKCOUNT, 1);
+			luaL_error(L, "job exceeded its instruction budget");
+		}
+
+		sol::table BuildHitTable(sol::state_view& state, const Ndk::PhysicsSystem2D::RaycastHit& hitInfo)
+		{
+			sol::table result = state.create_table(0, 4);
+			result["fraction"] = hitInfo.fraction;
+			result["hitPos"] = hitInfo.hitPos;
+			result["hitNormal"] = hitInfo.hitNormal;
+
+			const Ndk::EntityHandle& hitEntity = hitInfo.body;
+			if (hitEntity->HasComponent<ScriptComponent>())
+				result["hitEntity"] = hitEntity->GetComponent<ScriptComponent>().GetTable();
+
+			return result;
+		}
+
+		std::vector<ScriptMessageValue> RunScriptJob(const ScriptBytecodeCache::Bytecode& bytecode, const std::vector<ScriptMessageValue>& arguments, Nz::UInt64 instructionBudget)
+		{
+			// Each job gets its own state, only able to compute: no engine, file or script access
+			sol::state state;
+			state.open_libraries(sol::lib::base, sol::lib::math, sol::lib::string, sol::lib::table, sol::lib::utf8);
+			for (const char* name : { "collectgarbage", "dofile", "load", "loadfile", "print", "require" })
+				state[name] = sol::lua_nil;
+
+			// A looping job would otherwise hold its worker forever
+			Nz::UInt64 remainingInstructions = instructionBudget;
+			if (instructionBudget > 0)
+			{
+				lua_State* L = state.lua_state();
+				lua_pushlightuserdata(L, &remainingInstructions);
+				lua_rawsetp(L, LUA_REGISTRYINDEX, &s_jobBudgetRegistryKey);
+				lua_sethook(L, &JobBudgetHook, LUA_MASKCOUNT, JobBudgetCheckInterval);
+			}
+
+			sol::load_result loadResult = state.load(std::string_view(reinterpret_cast<const char*>(bytecode.data()), bytecode.size()), "job", sol::load_mode::binary);
+			if (!loadResult.valid())
+			{
+				sol::error err = loadResult;
+				throw std::runtime_error(err.what());
+			}
+
+			sol::state_view stateView(state);
+
+			std::vector<sol::object> luaArguments;
+			luaArguments.reserve(arguments.size());
+			for (const ScriptMessageValue& argument : arguments)
+				luaArguments.push_back(argument.ToLua(stateView));
+
+			sol::protected_function function = loadResult;
+			sol::protected_function_result result = function(sol::as_args(luaArguments));
+			if (!result.valid())
+			{
+				sol::error err = result;
+				throw std::runtime_error(err.what());
+			}
+
+			std::vector<ScriptMessageValue> values;
+			values.reserve(result.return_count());
+			for (const sol::object& value : result)
+				values.push_back(ScriptMessageValue::FromLua(value));
+
+			return values;
+		}
+	}
+
 	SharedScriptingLibrary::SharedScriptingLibrary(SharedMatch& sharedMatch) :
 	AbstractScriptingLibrary(sharedMatch.GetLogger()),
-	m_match(sharedMatch)
+	m_match(sharedMatch),
+	m_nextJobId(0)
 	{
 	}
 
@@ -37,27 +137,23 @@ namespace bw
 		sol::state& luaState = context.GetLuaState();
 		luaState.open_libraries();
 
-		sol::table gameTable = luaState.create_named_table("game");
-		sol::table matchTable = luaState.create_named_table("match");
-		sol::table networkTable = luaState.create_named_table("network");
-		sol::table physicsTable = luaState.create_named_table("physics");
-		sol::table scriptsTable = luaState.create_named_table("scripts");
-		sol::table timerTable = luaState.create_named_table("timer");
-
+		// Usertypes are registered right away as C++ may push their objects before any script uses their global
 		RegisterConstraintClass(context);
 		RegisterEventConnectionClass(context);
-		RegisterGameLibrary(context, gameTable);
 		RegisterGlobalLibrary(context);
 		RegisterInputControllerClass(context);
-		RegisterMatchLibrary(context, matchTable);
 		RegisterMetatableLibrary(context);
-		RegisterNetworkLibrary(context, networkTable);
 		RegisterNetworkPacketClasses(context);
 		RegisterRandomEngineClass(context);
-		RegisterPhysicsLibrary(context, physicsTable);
 		RegisterPlayerMovementControllerClass(context);
-		RegisterScriptLibrary(context, scriptsTable);
-		RegisterTimerLibrary(context, timerTable);
+
+		context.RegisterLazyTable("game", [this, &context](sol::table& library) { RegisterGameLibrary(context, library); });
+		context.RegisterLazyTable("jobs", [this, &context](sol::table& library) { RegisterJobLibrary(context, library); });
+		context.RegisterLazyTable("match", [this, &context](sol::table& library) { RegisterMatchLibrary(context, library); });
+		context.RegisterLazyTable("network", [this, &context](sol::table& library) { RegisterNetworkLibrary(context, library); });
+		context.RegisterLazyTable("physics", [this, &context](sol::table& library) { RegisterPhysicsLibrary(context, library); });
+		context.RegisterLazyTable("scripts", [this, &context](sol::table& library) { RegisterScriptLibrary(context, library); });
+		context.RegisterLazyTable("timer", [this, &context](sol::table& library) { RegisterTimerLibrary(context, library); });
 	}
 
 	void SharedScriptingLibrary::RegisterConstraintClass(ScriptingContext& context)
@@ -226,70 +322,135 @@ namespace bw
 		});
 	}
 
-	void SharedScriptingLibrary::RegisterMatchLibrary(ScriptingContext& /*context*/, sol::table& library)
+	void SharedScriptingLibrary::RegisterJobLibrary(ScriptingContext& context, sol::table& library)
 	{
-		library["GetEntityByUniqueId"] = LuaFunction([&](EntityId uniqueId)
+		// Runs a pure function on the job system, in a separate Lua state, and calls back with (true, results...) or (false, error) on a later tick
+		library["Start"] = LuaFunction([&](sol::this_state L, const sol::protected_function& function, sol::main_protected_function callback, sol::variadic_args args)
 		{
-			return TranslateEntityToLua(m_match.RetrieveEntityByUniqueId(uniqueId));
-		});
+			// Only the function code is sent, it cannot capture any local
+			function.push(L);
+			bool isCFunction = lua_iscfunction(L, -1);
+			const char* upvalueName = nullptr;
+			for (int i = 1; !isCFunction && (upvalueName = lua_getupvalue(L, -1, i)) != nullptr; ++i)
+			{
+				lua_pop(L, 1);
+				if (std::strcmp(upvalueName, "_ENV") != 0)
+					break;
+			}
+			lua_pop(L, 1);
 
-		library["GetEntities"] = LuaFunction([&](sol::this_state L, std::optional<LayerIndex> layerIndexOpt)
-		{
-			sol::state_view state(L);
-			sol::table result = state.create_table();
+			if (isCFunction)
+				TriggerLuaArgError(L, 1, "job function must be a Lua function");
 
-			std::size_t index = 1;
-			auto entityFunc = [&](const Ndk::EntityHandle& entity)
+			if (upvalueName)
+				TriggerLuaArgError(L, 1, fmt::format("job function cannot use local variable {} from an enclosing scope", upvalueName));
+
+			std::vector<ScriptMessageValue> arguments;
+			arguments.reserve(args.size());
+			for (std::size_t i = 0; i < args.size(); ++i)
 			{
-				if (!entity->HasComponent<ScriptComponent>())
-					return;
+				try
+				{
+					arguments.push_back(ScriptMessageValue::FromLua(sol::object(args[i])));
+				}
+				catch (const std::exception& e)
+				{
+					TriggerLuaArgError(L, int(3 + i), e.what());
+				}
+			}
 
-				auto& entityScript = entity->GetComponent<ScriptComponent>();
-				result[index++] = entityScript.GetTable();
-			};
+			Nz::UInt64 jobId = m_nextJobId++;
+			m_pendingJobs.emplace(jobId, std::move(callback));
 
-			if (layerIndexOpt)
+			Nz::UInt64 instructionBudget = m_match.GetApp().GetConfig().GetIntegerValue<Nz::UInt64>("Resources.ScriptJobInstructionBudget");
+
+			m_match.GetApp().GetJobSystem().Dispatch([this, jobId, bytecode = ScriptBytecodeCache::Dump(function), arguments = std::move(arguments), instructionBudget, continuationQueue = context.GetContinuationQueue()]()
 			{
-				LayerIndex layerIndex = layerIndexOpt.value();
-				if (layerIndex >= m_match.GetLayerCount())
-					TriggerLuaArgError(L, 2, "invalid layer index");
+				// Don't bother running jobs of a scripting context which is gone
+				if (continuationQueue.expired())
+					return;
 
-				m_match.GetLayer(layerIndex).ForEachEntity(entityFunc);
-			}
-			else
-				m_match.ForEachEntity(entityFunc);
+				JobResult result;
+				try
+				{
+					result.values = RunScriptJob(bytecode, arguments, instructionBudget);
+					result.success = true;
+				}
+				catch (const std::exception& e)
+				{
+					result.error = e.what();
+					result.success = false;
+				}
 
-			return result;
+				if (auto queue = continuationQueue.lock())
+				{
+					queue->Push([this, jobId, result = std::move(result)]() mutable
+					{
+						HandleJobResult(jobId, result);
+					});
+				}
+			});
+		});
+	}
+
+	void SharedScriptingLibrary::RegisterMatchLibrary(ScriptingContext& /*context*/, sol::table& library)
+	{
+		library["GetEntityByUniqueId"] = LuaFunction([&](EntityId uniqueId)
+		{
+			return TranslateEntityToLua(m_match.RetrieveEntityByUniqueId(uniqueId));
 		});
 
-		library["GetEntitiesByClass"] = LuaFunction([&](sol::this_state L, const std::string& entityClass, std::optional<LayerIndex> layerIndexOpt)
+		// Scripts querying entities every tick can pass the table returned by a previous call, it will be refilled instead of creating garbage
+		auto QueryEntities = [this](sol::this_state L, std::optional<LayerIndex> layerIndexOpt, std::optional<sol::table> resultOpt, int layerArgIndex, auto&& getEntityList)
 		{
-			sol::state_view state(L);
-			sol::table result = state.create_table();
+			sol::table result = (resultOpt) ? std::move(resultOpt).value() : sol::state_view(L).create_table();
+			std::size_t previousSize = (resultOpt) ? result.size() : 0;
 
 			std::size_t index = 1;
-			auto entityFunc = [&](const Ndk::EntityHandle& entity)
+			auto AddEntities = [&](SharedLayer& layer)
 			{
-				if (!entity->HasComponent<ScriptComponent>())
+				const Ndk::EntityList* entities = getEntityList(layer.GetWorld().GetSystem<ElementIndexSystem>());
+				if (!entities)
 					return;
 
-				auto& entityScript = entity->GetComponent<ScriptComponent>();
-				if (entityScript.GetElement()->fullName == entityClass)
-					result[index++] = entityScript.GetTable();
+				for (const Ndk::EntityHandle& entity : *entities)
+					result.raw_set(index++, entity->GetComponent<ScriptComponent>().GetTable());
 			};
 
 			if (layerIndexOpt)
 			{
 				LayerIndex layerIndex = layerIndexOpt.value();
 				if (layerIndex >= m_match.GetLayerCount())
-					TriggerLuaArgError(L, 2, "invalid layer index");
+					TriggerLuaArgError(L, layerArgIndex, "invalid layer index");
 
-				m_match.GetLayer(layerIndex).ForEachEntity(entityFunc);
+				AddEntities(m_match.GetLayer(layerIndex));
 			}
 			else
-				m_match.ForEachEntity(entityFunc);
+			{
+				for (LayerIndex layerIndex = 0; layerIndex < m_match.GetLayerCount(); ++layerIndex)
+					AddEntities(m_match.GetLayer(layerIndex));
+			}
+
+			for (std::size_t i = index; i <= previousSize; ++i)
+				result.raw_set(i, sol::lua_nil);
 
 			return result;
+		};
+
+		library["GetEntities"] = LuaFunction([QueryEntities](sol::this_state L, std::optional<LayerIndex> layerIndexOpt, std::optional<sol::table> resultOpt)
+		{
+			return QueryEntities(L, layerIndexOpt, std::move(resultOpt), 1, [](const ElementIndexSystem& indexSystem)
+			{
+				return &indexSystem.GetEntities();
+			});
+		});
+
+		library["GetEntitiesByClass"] = LuaFunction([QueryEntities](sol::this_state L, const std::string& entityClass, std::optional<LayerIndex> layerIndexOpt, std::optional<sol::table> resultOpt)
+		{
+			return QueryEntities(L, layerIndexOpt, std::move(resultOpt), 2, [&](const ElementIndexSystem& indexSystem)
+			{
+				return indexSystem.FindEntitiesByClass(entityClass);
+			});
 		});
 
 		library["GetGamemode"] = LuaFunction([this]()
@@ -316,17 +477,75 @@ namespace bw
 		{
 			return m_match.GetTickDuration();
 		});
+
+		library["StartScriptSampling"] = LuaFunction([this](std::optional<unsigned int> instructionInterval)
+		{
+			ScriptingContext& scriptingContext = *m_match.GetEntityStore().GetScriptingContext();
+			scriptingContext.StartSampling(instructionInterval.value_or(1000));
+		});
+
+		library["StopScriptSampling"] = LuaFunction([this](sol::this_state L) -> std::string
+		{
+			ScriptingContext& scriptingContext = *m_match.GetEntityStore().GetScriptingContext();
+
+			const ScriptSampler& sampler = scriptingContext.GetSampler();
+			if (!sampler.IsRunning())
+				TriggerLuaError(L, "script sampling is not running");
+
+			scriptingContext.StopSampling();
+
+			// Fixed output path, as scripts downloaded from a server can call this too
+			std::string filePath = (m_match.GetLogger().GetSide() == LogSide::Server) ? "scriptsamples_server.folded" : "scriptsamples_client.folded";
+			std::string collapsedStacks = sampler.FormatCollapsedStacks();
+
+			Nz::File outputFile(filePath, Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate);
+			if (!outputFile.IsOpen() || outputFile.Write(collapsedStacks.data(), collapsedStacks.size()) != collapsedStacks.size())
+				TriggerLuaError(L, "failed to write " + filePath);
+
+			return fmt::format("{0} sample(s) every {1} instructions written to {2}", sampler.GetSampleCount(), sampler.GetSampleInterval(), filePath);
+		});
 	}
 
 	void SharedScriptingLibrary::RegisterNetworkLibrary(ScriptingContext& /*context*/, sol::table& library)
 	{
-		library["NewPacket"] = LuaFunction([this](sol::this_state L, std::string name) -> OutgoingNetworkPacket
+		library["DeclarePacket"] = LuaFunction([this](sol::this_state L, std::string name, const sol::table& fields)
+		{
+			try
+			{
+				// Build the schema first, name is still needed if it fails
+				NetworkPacketSchema schema = NetworkPacketSchema::FromLua(fields);
+				m_match.RegisterScriptPacketSchema(std::move(name), std::move(schema));
+			}
+			catch (const std::exception& e)
+			{
+				TriggerLuaError(L, "Packet \"" + name + "\": " + e.what());
+			}
+		});
+
+		library["NewPacket"] = LuaFunction([this](sol::this_state L, std::string name, const std::optional<sol::table>& values) -> OutgoingNetworkPacket
 		{
 			const NetworkStringStore& networkStringStore = m_match.GetNetworkStringStore();
 			if (networkStringStore.GetStringIndex(name) == networkStringStore.InvalidIndex)
 				TriggerLuaError(L, "Packet name \"" + name + "\" has not been registered");
 
-			return OutgoingNetworkPacket(std::move(name));
+			OutgoingNetworkPacket packet(name);
+			if (values)
+			{
+				const NetworkPacketSchema* schema = m_match.GetScriptPacketSchema(name);
+				if (!schema)
+					TriggerLuaError(L, "Packet \"" + name + "\" has no declared fields");
+
+				try
+				{
+					packet.WriteFields(m_match, *schema, *values);
+				}
+				catch (const std::exception& e)
+				{
+					TriggerLuaError(L, e.what());
+				}
+			}
+
+			return packet;
 		});
 
 		library["SetHandler"] = LuaFunction([this](std::string name, sol::main_protected_function handler)
@@ -342,6 +561,28 @@ namespace bw
 
 	void SharedScriptingLibrary::RegisterPhysicsLibrary(ScriptingContext& /*context*/, sol::table& library)
 	{
+		library["BuildTileColliders"] = LuaFunction([](sol::this_state L, const Nz::Vector2ui& mapSize, const Nz::Vector2f& cellSize, const sol::table& contentTable) -> sol::table
+		{
+			std::size_t tileCount = contentTable.size();
+
+			std::vector<Nz::UInt32> content(tileCount);
+			for (std::size_t i = 0; i < tileCount; ++i)
+				content[i] = static_cast<Nz::UInt32>(contentTable.get_or<Nz::Int64>(i + 1, 0));
+
+			// Adjacent solid tiles are merged beforehand, as each collider is a shape for the broadphase to handle
+			std::vector<Nz::Rectui> tileRects = MergeSolidTiles(content, mapSize);
+
+			sol::state_view state(L);
+			sol::table result = state.create_table(int(tileRects.size()), 0);
+			for (std::size_t i = 0; i < tileRects.size(); ++i)
+			{
+				const Nz::Rectui& tileRect = tileRects[i];
+				result[i + 1] = Nz::Rectf(tileRect.x * cellSize.x, tileRect.y * cellSize.y, tileRect.width * cellSize.x, tileRect.height * cellSize.y);
+			}
+
+			return result;
+		});
+
 		library["CreateDampenedSpringConstraint"] = LuaFunction([](sol::this_state L, const sol::table& firstEntityTable, const sol::table& secondEntityTable, const Nz::Vector2f& firstAnchor, const Nz::Vector2f& secondAnchor, float restLength, float stiffness, float damping)
 		{
 			const Ndk::EntityHandle& firstEntity = AssertScriptEntity(firstEntityTable);
@@ -422,7 +663,7 @@ namespace bw
 					if (!callbackResult.valid())
 					{
 						sol::error err = callbackResult;
-						bwLog(m_match.GetLogger(), LogLevel::Error, "physics.RegionQuery callback failed: {}", err.what());
+						bwLogRateLimited(m_match.GetLogger(), LogLevel::Error, "physics.RegionQuery callback failed: {}", err.what());
 					}
 				}
 			};
@@ -442,16 +683,7 @@ namespace bw
 			if (physSystem.RaycastQueryFirst(startPos, endPos, 1.f, 0, 0xFFFFFFFF, 0xFFFFFFFF, &hitInfo))
 			{
 				sol::state_view state(L);
-				sol::table result = state.create_table();
-				result["fraction"] = hitInfo.fraction;
-				result["hitPos"] = hitInfo.hitPos;
-				result["hitNormal"] = hitInfo.hitNormal;
-
-				const Ndk::EntityHandle& hitEntity = hitInfo.body;
-				if (hitEntity->HasComponent<ScriptComponent>())
-					result["hitEntity"] = hitEntity->GetComponent<ScriptComponent>().GetTable();
-
-				return result;
+				return BuildHitTable(state, hitInfo);
 			}
 			else
 				return sol::nil;
@@ -476,24 +708,126 @@ namespace bw
 
 				hitEntities.Insert(hitEntity);
 
-				sol::table result = state.create_table();
-				result["fraction"] = hitInfo.fraction;
-				result["hitPos"] = hitInfo.hitPos;
-				result["hitNormal"] = hitInfo.hitNormal;
-
-				if (hitEntity->HasComponent<ScriptComponent>())
-					result["hitEntity"] = hitEntity->GetComponent<ScriptComponent>().GetTable();
-
-				auto callbackResult = callback(result);
+				auto callbackResult = callback(BuildHitTable(state, hitInfo));
 				if (!callbackResult.valid())
 				{
 					sol::error err = callbackResult;
-					bwLog(m_match.GetLogger(), LogLevel::Error, "physics.RegionQuery callback failed: {}", err.what());
+					bwLogRateLimited(m_match.GetLogger(), LogLevel::Error, "physics.RegionQuery callback failed: {}", err.what());
 				}
 			};
 
 			physSystem.RaycastQuery(startPos, endPos, 1.f, 0, 0xFFFFFFFF, 0xFFFFFFFF, resultCallback);
 		});
+
+		// Array-returning variants, avoiding a Lua call per hit
+		library["RegionQueryAll"] = LuaFunction([this](sol::this_state L, LayerIndex layer, const Nz::Rectf& rect) -> sol::table
+		{
+			if (layer >= m_match.GetLayerCount())
+				TriggerLuaArgError(L, 1, "invalid layer index");
+
+			Ndk::World& world = m_match.GetLayer(layer).GetWorld();
+			auto& physSystem = world.GetSystem<Ndk::PhysicsSystem2D>();
+
+			Ndk::EntityList hitEntities;
+			std::vector<Ndk::Entity*> scriptEntities;
+
+			physSystem.RegionQuery(rect, 0, 0xFFFFFFFF, 0xFFFFFFFF, [&](const Ndk::EntityHandle& hitEntity)
+			{
+				if (hitEntities.Has(hitEntity))
+					return;
+
+				hitEntities.Insert(hitEntity);
+
+				if (hitEntity->HasComponent<ScriptComponent>())
+					scriptEntities.push_back(hitEntity);
+			});
+
+			sol::state_view state(L);
+			sol::table result = state.create_table(int(scriptEntities.size()), 0);
+			for (std::size_t i = 0; i < scriptEntities.size(); ++i)
+				result[i + 1] = scriptEntities[i]->GetComponent<ScriptComponent>().GetTable();
+
+			return result;
+		});
+
+		library["TraceAll"] = LuaFunction([this](sol::this_state L, LayerIndex layer, Nz::Vector2f startPos, Nz::Vector2f endPos, std::optional<bool> withHitData) -> sol::table
+		{
+			if (layer >= m_match.GetLayerCount())
+				TriggerLuaArgError(L, 1, "invalid layer index");
+
+			Ndk::World& world = m_match.GetLayer(layer).GetWorld();
+			auto& physSystem = world.GetSystem<Ndk::PhysicsSystem2D>();
+
+			Ndk::EntityList hitEntities;
+			std::vector<Ndk::PhysicsSystem2D::RaycastHit> hits;
+
+			physSystem.RaycastQuery(startPos, endPos, 1.f, 0, 0xFFFFFFFF, 0xFFFFFFFF, [&](const Ndk::PhysicsSystem2D::RaycastHit& hitInfo)
+			{
+				if (hitEntities.Has(hitInfo.body))
+					return;
+
+				hitEntities.Insert(hitInfo.body);
+				hits.push_back(hitInfo);
+			});
+
+			// Closest hit first
+			std::sort(hits.begin(), hits.end(), [](const Ndk::PhysicsSystem2D::RaycastHit& lhs, const Ndk::PhysicsSystem2D::RaycastHit& rhs) { return lhs.fraction < rhs.fraction; });
+
+			sol::state_view state(L);
+			if (withHitData.value_or(false))
+			{
+				sol::table result = state.create_table(int(hits.size()), 0);
+				for (std::size_t i = 0; i < hits.size(); ++i)
+					result[i + 1] = BuildHitTable(state, hits[i]);
+
+				return result;
+			}
+			else
+			{
+				auto it = std::remove_if(hits.begin(), hits.end(), [](const Ndk::PhysicsSystem2D::RaycastHit& hitInfo) { return !hitInfo.body->HasComponent<ScriptComponent>(); });
+				hits.erase(it, hits.end());
+
+				sol::table result = state.create_table(int(hits.size()), 0);
+				for (std::size_t i = 0; i < hits.size(); ++i)
+					result[i + 1] = hits[i].body->GetComponent<ScriptComponent>().GetTable();
+
+				return result;
+			}
+		});
+
+		library["TraceBatch"] = LuaFunction([this](sol::this_state L, LayerIndex layer, const sol::table& rays) -> sol::table
+		{
+			if (layer >= m_match.GetLayerCount())
+				TriggerLuaArgError(L, 1, "invalid layer index");
+
+			Ndk::World& world = m_match.GetLayer(layer).GetWorld();
+			auto& physSystem = world.GetSystem<Ndk::PhysicsSystem2D>();
+
+			sol::state_view state(L);
+
+			std::size_t rayCount = rays.size();
+			sol::table result = state.create_table(int(rayCount), 0);
+			for (std::size_t i = 1; i <= rayCount; ++i)
+			{
+				std::optional<sol::table> ray = rays.get<std::optional<sol::table>>(i);
+				if (!ray)
+					TriggerLuaArgError(L, 2, "rays must be tables of {startPos, endPos}");
+
+				std::optional<Nz::Vector2f> startPos = ray->get<std::optional<Nz::Vector2f>>(1);
+				std::optional<Nz::Vector2f> endPos = ray->get<std::optional<Nz::Vector2f>>(2);
+				if (!startPos || !endPos)
+					TriggerLuaArgError(L, 2, "rays must be tables of {startPos, endPos}");
+
+				// Misses are stored as false to keep the result a proper sequence
+				Ndk::PhysicsSystem2D::RaycastHit hitInfo;
+				if (physSystem.RaycastQueryFirst(*startPos, *endPos, 1.f, 0, 0xFFFFFFFF, 0xFFFFFFFF, &hitInfo))
+					result[i] = BuildHitTable(state, hitInfo);
+				else
+					result[i] = false;
+			}
+
+			return result;
+		});
 	}
 
 	void SharedScriptingLibrary::RegisterScriptLibrary(ScriptingContext& /*context*/, sol::table& /*library*/)
@@ -511,9 +845,40 @@ namespace bw
 				if (!result.valid())
 				{
 					sol::error err = result;
-					bwLog(GetLogger(), LogLevel::Error, "timer.Create callback failed: {0}", err.what());
+					bwLogRateLimited(GetLogger(), LogLevel::Error, "timer.Create callback failed: {0}", err.what());
 				}
 			});
 		});
 	}
+
+	void SharedScriptingLibrary::HandleJobResult(Nz::UInt64 jobId, JobResult& result)
+	{
+		auto it = m_pendingJobs.find(jobId);
+		if (it == m_pendingJobs.end())
+			return;
+
+		sol::main_protected_function callback = std::move(it.value());
+		m_pendingJobs.erase(it);
+
+		sol::protected_function_result callbackResult;
+		if (result.success)
+		{
+			sol::state_view lua(callback.lua_state());
+
+			std::vector<sol::object> values;
+			values.reserve(result.values.size());
+			for (const ScriptMessageValue& value : result.values)
+				values.push_back(value.ToLua(lua));
+
+			callbackResult = callback(true, sol::as_args(values));
+		}
+		else
+			callbackResult = callback(false, result.error);
+
+		if (!callbackResult.valid())
+		{
+			sol::error err = callbackResult;
+			bwLogRateLimited(GetLogger(), LogLevel::Error, "jobs.Start callback failed: {0}", err.what());
+		}
+	}
 }
@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/SessionBridge.hpp>
+#include <cassert>
 
 namespace bw
 {
@@ -28,4 +29,40 @@ namespace bw
 
 		OnIncomingPacket(packet);
 	}
+
+	void SessionBridge::HandleIncomingTypedPacket(TypedPacket& packet)
+	{
+		assert(m_isConnected);
+
+		OnIncomingTypedPacket(packet);
+	}
+
+	void SessionBridge::SendDeferredPacket(Nz::UInt8 channelId, Nz::ENetPacketFlags flags, SerializationJob serializationJob)
+	{
+		// Default implementation: serialize right away
+		Nz::NetPacket packet;
+		serializationJob(packet);
+
+		SendPacket(channelId, flags, std::move(packet));
+	}
+
+	void SessionBridge::SendSharedPacket(const SharedPacketRef& packet)
+	{
+		// Default implementation: send our own copy
+		const Nz::NetPacket& sharedData = packet->data;
+		const Nz::UInt8* data = static_cast<const Nz::UInt8*>(sharedData.GetConstData()) + Nz::NetPacket::HeaderSize;
+
+		SendPacket(packet->channelId, packet->flags, Nz::NetPacket(sharedData.GetNetCode(), data, sharedData.GetDataSize()));
+	}
+
+	void SessionBridge::SendTypedPacket(TypedPacket&& /*packet*/)
+	{
+		assert(!"Typed packets are not supported by this bridge");
+	}
+
+	bool SessionBridge::SupportsTypedPackets() const
+	{
+		// Packets have to be serialized by default
+		return false;
+	}
 }
@@ -10,11 +10,22 @@ namespace bw
 	ConfigFile(app)
 	{
 		RegisterStringOption("Resources.AssetDirectory");
+		RegisterStringOption("Resources.BytecodeCacheDirectory", ".bytecodeCache");
+		RegisterStringOption("Resources.ChecksumCacheFile", ".checksumCache");
+		RegisterIntegerOption("Resources.JobThreadCount", 0, 256, 0);
 		RegisterStringOption("Resources.ModDirectory");
 		RegisterStringOption("Resources.ScriptDirectory");
+		RegisterIntegerOption("Resources.ScriptJobInstructionBudget", 0, 1'000'000'000'000, 100'000'000);
 		RegisterBoolOption("Debug.SendServerState");
+		RegisterIntegerOption("Debug.SimulatedJitter", 0, 10'000, 0);
+		RegisterIntegerOption("Debug.SimulatedLatency", 0, 10'000, 0);
+		RegisterFloatOption("Debug.SimulatedPacketDuplication", 0.0, 1.0, 0.0);
+		RegisterFloatOption("Debug.SimulatedPacketLoss", 0.0, 1.0, 0.0);
+		RegisterFloatOption("Debug.SimulatedPacketReordering", 0.0, 1.0, 0.0);
+		RegisterIntegerOption("Debug.SimulationSeed", 0, 0xFFFFFFFF, 0);
 		RegisterStringOption("ServerSettings.FastDownloadURLs", "");
 		RegisterStringOption("ServerSettings.MasterServers", "");
+		RegisterBoolOption("ServerSettings.QuantizeMatchState", false);
 		RegisterFloatOption("ServerSettings.TickRate");
 	}
 }
@@ -8,17 +8,52 @@
 #include <CoreLib/Components/PlayerMovementComponent.hpp>
 #include <CoreLib/Components/ScriptComponent.hpp>
 #include <CoreLib/Systems/AnimationSystem.hpp>
+#include <CoreLib/Systems/ElementIndexSystem.hpp>
 #include <CoreLib/Systems/InputSystem.hpp>
+#include <CoreLib/Systems/NetworkSyncSystem.hpp>
 #include <CoreLib/Systems/PlayerMovementSystem.hpp>
 #include <CoreLib/Systems/TickCallbackSystem.hpp>
 #include <CoreLib/Systems/WeaponSystem.hpp>
 #include <NDK/Systems/LifetimeSystem.hpp>
 #include <NDK/Systems/PhysicsSystem2D.hpp>
 #include <NDK/Systems/VelocitySystem.hpp>
+#include <algorithm>
 #include <cassert>
+#include <mutex>
 
 namespace bw
 {
+	namespace
+	{
+		std::string GetSystemName(const Ndk::BaseSystem& system)
+		{
+			Ndk::SystemIndex systemIndex = system.GetIndex();
+
+			if (systemIndex == AnimationSystem::systemIndex)
+				return "AnimationSystem";
+			else if (systemIndex == ElementIndexSystem::systemIndex)
+				return "ElementIndexSystem";
+			else if (systemIndex == InputSystem::systemIndex)
+				return "InputSystem";
+			else if (systemIndex == Ndk::LifetimeSystem::systemIndex)
+				return "LifetimeSystem";
+			else if (systemIndex == NetworkSyncSystem::systemIndex)
+				return "NetworkSyncSystem";
+			else if (systemIndex == Ndk::PhysicsSystem2D::systemIndex)
+				return "PhysicsSystem2D";
+			else if (systemIndex == PlayerMovementSystem::systemIndex)
+				return "PlayerMovementSystem";
+			else if (systemIndex == TickCallbackSystem::systemIndex)
+				return "TickCallbackSystem";
+			else if (systemIndex == Ndk::VelocitySystem::systemIndex)
+				return "VelocitySystem";
+			else if (systemIndex == WeaponSystem::systemIndex)
+				return "WeaponSystem";
+			else
+				return "System #" + std::to_string(systemIndex);
+		}
+	}
+
 	SharedLayer::SharedLayer(SharedMatch& match, LayerIndex layerIndex) :
 	m_match(match),
 	m_layerIndex(layerIndex)
@@ -28,6 +63,7 @@ namespace bw
 		m_world.AddSystem<Ndk::VelocitySystem>();
 
 		m_world.AddSystem<AnimationSystem>(match);
+		m_world.AddSystem<ElementIndexSystem>();
 		m_world.AddSystem<InputSystem>();
 		m_world.AddSystem<PlayerMovementSystem>();
 		m_world.AddSystem<TickCallbackSystem>(match);
@@ -36,11 +72,12 @@ namespace bw
 		Ndk::PhysicsSystem2D& physics = m_world.GetSystem<Ndk::PhysicsSystem2D>();
 		physics.SetGravity(Nz::Vector2f(0.f, 9.81f * 192.f));
 		physics.SetMaxStepCount(1);
-		physics.SetSleepTime(0.f);
 		physics.SetStepSize(match.GetTickDuration());
 
+		std::recursive_mutex& scriptMutex = match.GetScriptMutex();
+
 		Ndk::PhysicsSystem2D::Callback triggerCallbacks;
-		triggerCallbacks.startCallback = [](Ndk::PhysicsSystem2D& /*world*/, Nz::Arbiter2D& /*arbiter*/, const Ndk::EntityHandle& bodyA, const Ndk::EntityHandle& bodyB, void* /*userdata*/)
+		triggerCallbacks.startCallback = [&scriptMutex](Ndk::PhysicsSystem2D& /*world*/, Nz::Arbiter2D& /*arbiter*/, const Ndk::EntityHandle& bodyA, const Ndk::EntityHandle& bodyB, void* /*userdata*/)
 		{
 			bool shouldCollide = true;
 
@@ -51,6 +88,7 @@ namespace bw
 					auto& firstScript = first->GetComponent<ScriptComponent>();
 					auto& secondScript = second->GetComponent<ScriptComponent>();
 
+					std::lock_guard<std::recursive_mutex> lock(scriptMutex);
 					if (auto ret = firstScript.ExecuteCallback<ElementEvent::CollisionStart>(secondScript.GetTable()); ret.has_value())
 						shouldCollide = *ret;
 				}
@@ -62,7 +100,7 @@ namespace bw
 			return shouldCollide;
 		};
 
-		triggerCallbacks.endCallback = [](Ndk::PhysicsSystem2D& /*world*/, Nz::Arbiter2D& /*arbiter*/, const Ndk::EntityHandle& bodyA, const Ndk::EntityHandle& bodyB, void* /*userdata*/)
+		triggerCallbacks.endCallback = [&scriptMutex](Ndk::PhysicsSystem2D& /*world*/, Nz::Arbiter2D& /*arbiter*/, const Ndk::EntityHandle& bodyA, const Ndk::EntityHandle& bodyB, void* /*userdata*/)
 		{
 			auto HandleCollision = [&](const Ndk::EntityHandle& first, const Ndk::EntityHandle& second)
 			{
@@ -71,6 +109,7 @@ namespace bw
 					auto& firstScript = first->GetComponent<ScriptComponent>();
 					auto& secondScript = second->GetComponent<ScriptComponent>();
 
+					std::lock_guard<std::recursive_mutex> lock(scriptMutex);
 					firstScript.ExecuteCallback<ElementEvent::CollisionStop>(secondScript.GetTable());
 				}
 			};
@@ -90,6 +129,8 @@ namespace bw
 				if (first->HasComponent<PlayerMovementComponent>())
 				{
 					PlayerMovementComponent& playerMovement = first->GetComponent<PlayerMovementComponent>();
+					playerMovement.RecordContact(second);
+
 					if (const auto& controller = playerMovement.GetController())
 						shouldCollide = shouldCollide && controller->PreSolveCollision(playerMovement, second, arbiter);
 				}
@@ -103,6 +144,8 @@ namespace bw
 
 		physics.RegisterCallbacks(2, triggerCallbacks);
 
+		ConfigurePhysics(m_physicsSettings);
+
 		m_world.ForEachSystem([](Ndk::BaseSystem& system)
 		{
 			system.SetFixedUpdateRate(0.f);
@@ -112,8 +155,73 @@ namespace bw
 
 	SharedLayer::~SharedLayer() = default;
 
+	void SharedLayer::ConfigurePhysics(const PhysicsSettings& settings)
+	{
+		Ndk::PhysicsSystem2D& physics = m_world.GetSystem<Ndk::PhysicsSystem2D>();
+		physics.SetIterationCount(settings.iterationCount);
+		physics.SetSleepTime(settings.sleepTime);
+
+		// Chipmunk can't go back to its bounding box tree once the spatial hash is enabled
+		if (settings.spatialHashCellSize > 0.f)
+			physics.UseSpatialHash(settings.spatialHashCellSize, settings.spatialHashEntityCount);
+
+		m_physicsSettings = settings;
+	}
+
+	void SharedLayer::EnablePhysicsUpdate(bool enable)
+	{
+		m_world.GetSystem<Ndk::PhysicsSystem2D>().Enable(enable);
+	}
+
+	void SharedLayer::StepPhysics(float elapsedTime)
+	{
+		Ndk::PhysicsSystem2D& physics = m_world.GetSystem<Ndk::PhysicsSystem2D>();
+
+		bool wasEnabled = physics.IsEnabled();
+		physics.Enable(true);
+		physics.Update(elapsedTime);
+		physics.Enable(wasEnabled);
+	}
+
 	void SharedLayer::TickUpdate(float elapsedTime)
 	{
-		m_world.Update(elapsedTime);
+		TickProfiler& tickProfiler = m_match.GetTickProfiler();
+		if (!tickProfiler.IsEnabled())
+		{
+			m_world.Update(elapsedTime);
+			return;
+		}
+
+		if (m_profiledSystems.empty())
+			RegisterProfiledSystems();
+
+		// Same as Ndk::World::Update, with every system timed separately
+		m_world.Refresh();
+
+		for (const ProfiledSystem& profiledSystem : m_profiledSystems)
+		{
+			if (!profiledSystem.system->IsEnabled())
+				continue;
+
+			auto systemScope = tickProfiler.Profile(profiledSystem.sectionIndex);
+			profiledSystem.system->Update(elapsedTime);
+		}
+	}
+
+	void SharedLayer::RegisterProfiledSystems()
+	{
+		TickProfiler& tickProfiler = m_match.GetTickProfiler();
+
+		m_world.ForEachSystem([&](Ndk::BaseSystem& system)
+		{
+			auto& profiledSystem = m_profiledSystems.emplace_back();
+			profiledSystem.system = &system;
+			profiledSystem.sectionIndex = tickProfiler.RegisterSection("layers/" + GetSystemName(system));
+		});
+
+		std::stable_sort(m_profiledSystems.begin(), m_profiledSystems.end(), [](const ProfiledSystem& lhs, const ProfiledSystem& rhs)
+		{
+			return lhs.system->GetUpdateOrder() < rhs.system->GetUpdateOrder();
+		});
 	}
 }
@@ -4,10 +4,18 @@
 
 #include <CoreLib/SharedMatch.hpp>
 #include <CoreLib/BurgApp.hpp>
+#include <CoreLib/Utils.hpp>
 #include <CoreLib/Components/InputComponent.hpp>
 #include <CoreLib/LogSystem/EntityLogContext.hpp>
 #include <CoreLib/LogSystem/Logger.hpp>
+#include <CoreLib/Scripting/ScriptingContext.hpp>
+#include <CoreLib/Scripting/SharedEntityStore.hpp>
+#include <CoreLib/Utility/Profiling.hpp>
 #include <NDK/Components/PhysicsComponent2D.hpp>
+#include <NDK/Systems/PhysicsSystem2D.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <fmt/format.h>
+#include <algorithm>
 #include <cassert>
 
 namespace bw
@@ -15,31 +23,107 @@ namespace bw
 	namespace
 	{
 		unsigned int MaxDelayedTick = 10;
+
+		// Backlog (in ticks) from which each load level kicks in, must stay below MaxDelayedTick
+		constexpr std::array<float, static_cast<std::size_t>(SharedMatch::LoadLevel::Max) + 1> LoadLevelThresholds = { 0.f, 2.f, 4.f, 6.f };
+
+		// How long the backlog has to stay low before lowering the load level by one step
+		constexpr float LoadLevelCooldown = 2.f;
+
+		const char* ToString(SharedMatch::LoadLevel loadLevel)
+		{
+			switch (loadLevel)
+			{
+				case SharedMatch::LoadLevel::Normal:            return "normal";
+				case SharedMatch::LoadLevel::DeferNonCritical:  return "defer non-critical";
+				case SharedMatch::LoadLevel::ReduceNetworkRate: return "reduce network rate";
+				case SharedMatch::LoadLevel::StretchScripts:    return "stretch scripts";
+			}
+
+			return "<unknown>";
+		}
 	}
 
 	SharedMatch::SharedMatch(BurgApp& app, LogSide side, std::string matchName, float tickDuration) :
+	m_app(app),
 	m_name(std::move(matchName)),
-	m_logger(app, *this, side, app.GetLogger(), sizeof(EntityLogContext)),
+	m_logger(app, *this, side, app.GetLogger()),
 	m_scriptPacketHandler(m_logger),
 	m_currentTick(0),
 	m_currentTime(0),
+	m_discardedTickCount(0),
+	m_loadLevel(LoadLevel::Normal),
+	m_tickProfilerSection(m_tickProfiler.RegisterSection("tick")),
 	m_floatingTime(0.f),
+	m_loadLevelCooldown(0.f),
 	m_maxTickTimer(MaxDelayedTick * tickDuration),
 	m_tickDuration(tickDuration),
-	m_tickTimer(0.f)
+	m_tickTimer(0.f),
+	m_isLoadSheddingEnabled(false)
 	{
+		m_loadLevelTickCounts.fill(0);
+
 		m_logger.SetMinimumLogLevel(LogLevel::Debug);
 	}
 
 	SharedMatch::~SharedMatch() = default;
 
+	void SharedMatch::DispatchScriptPacket(const Packets::ScriptPacket& packet)
+	{
+		const NetworkStringStore& stringStore = GetNetworkStringStore();
+		const std::string& packetName = stringStore.GetString(packet.nameIndex);
+
+		IncomingNetworkPacket incomingPacket(stringStore, packet);
+
+		// Declared packets are decoded here, handlers receive their fields as a table (and the packet for any extra data)
+		if (const NetworkPacketSchema* schema = GetScriptPacketSchema(packetName))
+		{
+			sol::state& state = GetEntityStore().GetScriptingContext()->GetLuaState();
+
+			sol::table fields;
+			try
+			{
+				fields = incomingPacket.ReadFields(*this, state, *schema);
+			}
+			catch (const std::exception& e)
+			{
+				bwLog(m_logger, LogLevel::Warning, "failed to decode \"{0}\" packet: {1}", packetName, e.what());
+				return;
+			}
+
+			m_scriptPacketHandler.Call(packetName, std::move(fields), std::move(incomingPacket));
+		}
+		else
+			m_scriptPacketHandler.Call(packetName, std::move(incomingPacket));
+	}
+
+	std::string SharedMatch::FormatLoadStatistics() const
+	{
+		std::string statistics = fmt::format("Load level: {0}, ticks per level: ", ToString(m_loadLevel));
+		for (std::size_t i = 0; i < m_loadLevelTickCounts.size(); ++i)
+		{
+			if (i > 0)
+				statistics += ", ";
+
+			statistics += fmt::format("{0} {1}", ToString(static_cast<LoadLevel>(i)), m_loadLevelTickCounts[i]);
+		}
+		statistics += fmt::format(" ({0} ticks discarded)", m_discardedTickCount);
+
+		return statistics;
+	}
+
 	void SharedMatch::Update(float elapsedTime)
 	{
 		m_tickTimer += elapsedTime;
+		if (m_isLoadSheddingEnabled)
+			UpdateLoadLevel(elapsedTime);
+
 		if (m_tickTimer > m_maxTickTimer)
 		{
 			float lostTicks = (m_tickTimer - m_maxTickTimer) / m_tickDuration;
-			bwLog(m_logger, LogLevel::Warning, "Update is too slow, {} ticks have been discarded to preserve realtime", lostTicks);
+			bwLogRateLimited(m_logger, LogLevel::Warning, "Update is too slow, {} ticks have been discarded to preserve realtime", lostTicks);
+
+			m_discardedTickCount += static_cast<Nz::UInt64>(lostTicks);
 
 			m_tickTimer = m_maxTickTimer;
 		}
@@ -50,7 +134,22 @@ namespace bw
 
 			m_timerManager.Update(m_currentTime);
 
-			OnTick(m_tickTimer < m_tickDuration);
+			Nz::UInt64 tickStartTime = Nz::GetElapsedMicroseconds();
+			{
+				auto tickScope = m_tickProfiler.Profile(m_tickProfilerSection);
+				bwProfileZone("Match tick");
+				OnTick(m_tickTimer < m_tickDuration);
+			}
+			m_tickProfiler.EndTick();
+			bwProfileFrameNamed("Tick");
+
+			Nz::UInt64 tickDuration = Nz::GetElapsedMicroseconds() - tickStartTime;
+			const auto& bucketBounds = TickDurationHistogram::BucketBounds;
+			std::size_t bucketIndex = std::lower_bound(bucketBounds.begin(), bucketBounds.end(), tickDuration) - bucketBounds.begin();
+			m_tickDurations.tickCounts[bucketIndex]++;
+			m_tickDurations.totalDuration += tickDuration;
+
+			m_loadLevelTickCounts[UnderlyingCast(m_loadLevel)]++;
 
 			m_currentTick++;
 			m_floatingTime += m_tickDuration * 1000.f;
@@ -59,4 +158,54 @@ namespace bw
 			m_floatingTime -= elapsedTimeMs;
 		}
 	}
+
+	void SharedMatch::SetTickDuration(float tickDuration)
+	{
+		m_maxTickTimer = MaxDelayedTick * tickDuration;
+		m_tickDuration = tickDuration;
+
+		// Physics steps once per tick
+		LayerIndex layerCount = GetLayerCount();
+		for (LayerIndex i = 0; i < layerCount; ++i)
+			GetLayer(i).GetWorld().GetSystem<Ndk::PhysicsSystem2D>().SetStepSize(tickDuration);
+	}
+
+	void SharedMatch::UpdateLoadLevel(float elapsedTime)
+	{
+		float backlog = m_tickTimer / m_tickDuration;
+
+		LoadLevel targetLevel = LoadLevel::Normal;
+		for (std::size_t i = LoadLevelThresholds.size(); i > 0; --i)
+		{
+			if (backlog >= LoadLevelThresholds[i - 1])
+			{
+				targetLevel = static_cast<LoadLevel>(i - 1);
+				break;
+			}
+		}
+
+		if (targetLevel > m_loadLevel)
+		{
+			// Raise immediately to catch up as fast as possible
+			bwLog(m_logger, LogLevel::Warning, "Server is {0:.1f} ticks behind, raising load level from {1} to {2}", backlog, ToString(m_loadLevel), ToString(targetLevel));
+
+			m_loadLevel = targetLevel;
+			m_loadLevelCooldown = LoadLevelCooldown;
+		}
+		else if (targetLevel < m_loadLevel)
+		{
+			// Lower one step at a time, and only once the backlog stayed low for a while, to prevent oscillations
+			m_loadLevelCooldown -= elapsedTime;
+			if (m_loadLevelCooldown <= 0.f)
+			{
+				LoadLevel newLevel = static_cast<LoadLevel>(UnderlyingCast(m_loadLevel) - 1);
+				bwLog(m_logger, LogLevel::Info, "Server caught up, lowering load level from {0} to {1}", ToString(m_loadLevel), ToString(newLevel));
+
+				m_loadLevel = newLevel;
+				m_loadLevelCooldown = LoadLevelCooldown;
+			}
+		}
+		else
+			m_loadLevelCooldown = LoadLevelCooldown;
+	}
 }
@@ -0,0 +1,210 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/SimulatedSessionBridge.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <algorithm>
+#include <cassert>
+
+namespace bw
+{
+	namespace
+	{
+		constexpr std::size_t MaxResendCount = 5;
+		constexpr Nz::UInt64 ResendMargin = 20; //< added to round trip time when resending a lost reliable packet (in milliseconds)
+	}
+
+	SimulatedSessionBridge::SimulatedSessionBridge(std::shared_ptr<SessionBridge> bridge, const Conditions& conditions) :
+	SessionBridge(nullptr),
+	m_randomGenerator(conditions.seed),
+	m_bridge(std::move(bridge)),
+	m_conditions(conditions),
+	m_lostPacketCount(0),
+	m_lastIncomingDeliveryTime(0),
+	m_lastReliableDeliveryTime(0),
+	m_nextSequence(0)
+	{
+		assert(m_bridge);
+
+		m_onConnectedSlot.Connect(m_bridge->OnConnected, [this](Nz::UInt32 data)
+		{
+			HandleConnection(data);
+		});
+
+		m_onDisconnectedSlot.Connect(m_bridge->OnDisconnected, [this](Nz::UInt32 data)
+		{
+			m_pendingPackets.clear();
+
+			HandleDisconnection(data);
+		});
+
+		m_onIncomingPacketSlot.Connect(m_bridge->OnIncomingPacket, [this](Nz::NetPacket& packet)
+		{
+			// Packet memory belongs to the wrapped bridge, copy it
+			const Nz::UInt8* data = static_cast<const Nz::UInt8*>(packet.GetConstData()) + Nz::NetPacket::HeaderSize;
+			SchedulePacket(false, 0, Nz::ENetPacketFlag_Reliable, Nz::NetPacket(packet.GetNetCode(), data, packet.GetDataSize()));
+		});
+
+		if (m_bridge->IsConnected())
+			HandleConnection(0);
+	}
+
+	void SimulatedSessionBridge::Disconnect()
+	{
+		m_bridge->Disconnect();
+	}
+
+	bool SimulatedSessionBridge::IsLocal() const
+	{
+		return m_bridge->IsLocal();
+	}
+
+	void SimulatedSessionBridge::Poll()
+	{
+		if (m_pendingPackets.empty())
+			return;
+
+		Nz::UInt64 now = Nz::GetElapsedMilliseconds();
+
+		auto it = std::partition(m_pendingPackets.begin(), m_pendingPackets.end(), [&](const PendingPacket& pendingPacket) { return pendingPacket.deliveryTime > now; });
+		if (it == m_pendingPackets.end())
+			return;
+
+		m_duePackets.clear();
+		std::move(it, m_pendingPackets.end(), std::back_inserter(m_duePackets));
+		m_pendingPackets.erase(it, m_pendingPackets.end());
+
+		std::sort(m_duePackets.begin(), m_duePackets.end(), [](const PendingPacket& lhs, const PendingPacket& rhs)
+		{
+			if (lhs.deliveryTime != rhs.deliveryTime)
+				return lhs.deliveryTime < rhs.deliveryTime;
+
+			return lhs.sequence < rhs.sequence;
+		});
+
+		for (PendingPacket& pendingPacket : m_duePackets)
+		{
+			// Incoming packet handling may disconnect us
+			if (!IsConnected())
+				break;
+
+			if (pendingPacket.outgoing)
+			{
+				bool isSequenced = (pendingPacket.flags & (Nz::ENetPacketFlag_Reliable | Nz::ENetPacketFlag_Unsequenced)) == 0;
+				if (isSequenced)
+				{
+					// Like ENet, drop unreliable sequenced packets arriving after a more recent one
+					if (m_lastSequencedDelivery.size() <= pendingPacket.channelId)
+						m_lastSequencedDelivery.resize(pendingPacket.channelId + 1, 0);
+
+					Nz::UInt64& lastSequence = m_lastSequencedDelivery[pendingPacket.channelId];
+					if (pendingPacket.sequence < lastSequence)
+						continue;
+
+					lastSequence = pendingPacket.sequence;
+				}
+
+				m_bridge->SendPacket(pendingPacket.channelId, pendingPacket.flags, std::move(pendingPacket.packet));
+			}
+			else
+				SessionBridge::HandleIncomingPacket(pendingPacket.packet);
+		}
+		m_duePackets.clear();
+	}
+
+	void SimulatedSessionBridge::QueryInfo(std::function<void(const SessionInfo& info)> callback) const
+	{
+		m_bridge->QueryInfo([callback = std::move(callback), latency = m_conditions.latency, jitter = m_conditions.jitter, lostPacketCount = m_lostPacketCount](const SessionInfo& info)
+		{
+			SessionInfo simulatedInfo = info;
+			simulatedInfo.ping += 2 * latency + jitter; //< ping is measured by the server only, average jitter in both directions
+			simulatedInfo.totalPacketLost += lostPacketCount;
+
+			callback(simulatedInfo);
+		});
+	}
+
+	void SimulatedSessionBridge::SendPacket(Nz::UInt8 channelId, Nz::ENetPacketFlags flags, Nz::NetPacket&& packet)
+	{
+		assert(IsConnected());
+
+		SchedulePacket(true, channelId, flags, std::move(packet));
+	}
+
+	Nz::UInt64 SimulatedSessionBridge::ComputeDeliveryTime(Nz::UInt64 now)
+	{
+		Nz::UInt64 deliveryTime = now + m_conditions.latency;
+		if (m_conditions.jitter > 0)
+			deliveryTime += std::uniform_int_distribution<Nz::UInt32>(0, m_conditions.jitter)(m_randomGenerator);
+
+		return deliveryTime;
+	}
+
+	void SimulatedSessionBridge::SchedulePacket(bool outgoing, Nz::UInt8 channelId, Nz::ENetPacketFlags flags, Nz::NetPacket&& packet)
+	{
+		Nz::UInt64 now = Nz::GetElapsedMilliseconds();
+		Nz::UInt64 deliveryTime = ComputeDeliveryTime(now);
+		Nz::UInt64 sequence = m_nextSequence++;
+
+		if (!outgoing)
+		{
+			// We don't know how the packet was sent, keep incoming order
+			deliveryTime = std::max(deliveryTime, m_lastIncomingDeliveryTime);
+			m_lastIncomingDeliveryTime = deliveryTime;
+		}
+		else if (flags & Nz::ENetPacketFlag_Reliable)
+		{
+			// Reliable packets are never lost, but each loss costs a round trip before the packet is resent
+			for (std::size_t i = 0; i < MaxResendCount && TestProbability(m_conditions.lossRate); ++i)
+			{
+				deliveryTime += 2 * (m_conditions.latency + m_conditions.jitter) + ResendMargin;
+				m_lostPacketCount++;
+			}
+
+			// ... and are delivered in order
+			deliveryTime = std::max(deliveryTime, m_lastReliableDeliveryTime);
+			m_lastReliableDeliveryTime = deliveryTime;
+		}
+		else
+		{
+			if (TestProbability(m_conditions.lossRate))
+			{
+				m_lostPacketCount++;
+				return;
+			}
+
+			if (TestProbability(m_conditions.reorderRate))
+				deliveryTime += m_conditions.latency + m_conditions.jitter + ResendMargin;
+
+			if (TestProbability(m_conditions.duplicationRate))
+			{
+				const Nz::UInt8* data = static_cast<const Nz::UInt8*>(packet.GetConstData()) + Nz::NetPacket::HeaderSize;
+
+				auto& duplicatedPacket = m_pendingPackets.emplace_back();
+				duplicatedPacket.channelId = channelId;
+				duplicatedPacket.deliveryTime = ComputeDeliveryTime(now);
+				duplicatedPacket.flags = flags;
+				duplicatedPacket.outgoing = outgoing;
+				duplicatedPacket.packet = Nz::NetPacket(packet.GetNetCode(), data, packet.GetDataSize());
+				duplicatedPacket.sequence = sequence;
+			}
+		}
+
+		auto& pendingPacket = m_pendingPackets.emplace_back();
+		pendingPacket.channelId = channelId;
+		pendingPacket.deliveryTime = deliveryTime;
+		pendingPacket.flags = flags;
+		pendingPacket.outgoing = outgoing;
+		pendingPacket.packet = std::move(packet);
+		pendingPacket.sequence = sequence;
+	}
+
+	bool SimulatedSessionBridge::TestProbability(float probability)
+	{
+		if (probability <= 0.f)
+			return false;
+
+		return std::uniform_real_distribution<float>(0.f, 1.f)(m_randomGenerator) < probability;
+	}
+}
@@ -4,7 +4,7 @@
 
 #include <CoreLib/Systems/AnimationSystem.hpp>
 #include <CoreLib/SharedMatch.hpp>
-#include <CoreLib/Components/AnimationComponent.hpp>
+#include <cassert>
 
 namespace bw
 {
@@ -15,14 +15,80 @@ namespace bw
 		SetMaximumUpdateRate(100.f);
 	}
 
+	void AnimationSystem::AddPlayingAnimation(AnimationComponent& animation)
+	{
+		auto it = m_entityData.find(animation.GetEntity()->GetId());
+		assert(it != m_entityData.end());
+
+		// Playing another animation only moves its end time
+		EntityData& entityData = it.value();
+		if (entityData.playingIndex == InvalidIndex)
+		{
+			entityData.playingIndex = m_playingAnimations.size();
+			m_playingAnimations.push_back({ animation.GetEndTime(), &animation });
+		}
+		else
+			m_playingAnimations[entityData.playingIndex].endTime = animation.GetEndTime();
+	}
+
+	void AnimationSystem::RemovePlayingAnimation(std::size_t playingIndex)
+	{
+		assert(playingIndex < m_playingAnimations.size());
+
+		m_entityData[m_playingAnimations[playingIndex].animation->GetEntity()->GetId()].playingIndex = InvalidIndex;
+
+		if (playingIndex != m_playingAnimations.size() - 1)
+		{
+			m_playingAnimations[playingIndex] = m_playingAnimations.back();
+			m_entityData[m_playingAnimations[playingIndex].animation->GetEntity()->GetId()].playingIndex = playingIndex;
+		}
+
+		m_playingAnimations.pop_back();
+	}
+
+	void AnimationSystem::OnEntityAdded(Ndk::Entity* entity)
+	{
+		auto& animComponent = entity->GetComponent<AnimationComponent>();
+
+		EntityData& entityData = m_entityData.emplace(entity->GetId(), EntityData{}).first.value();
+		entityData.onAnimationStart.Connect(animComponent.OnAnimationStart, [this](AnimationComponent* animation)
+		{
+			AddPlayingAnimation(*animation);
+		});
+
+		// Animation may have been started before the entity got to this system
+		if (animComponent.IsPlaying())
+			AddPlayingAnimation(animComponent);
+	}
+
+	void AnimationSystem::OnEntityRemoved(Ndk::Entity* entity)
+	{
+		auto it = m_entityData.find(entity->GetId());
+		assert(it != m_entityData.end());
+
+		if (std::size_t playingIndex = it->second.playingIndex; playingIndex != InvalidIndex)
+			RemovePlayingAnimation(playingIndex);
+
+		m_entityData.erase(entity->GetId());
+	}
+
 	void AnimationSystem::OnUpdate(float /*elapsedTime*/)
 	{
 		Nz::UInt64 now = m_match.GetCurrentTime();
 
-		for (const Ndk::EntityHandle& entity : GetEntities())
+		for (std::size_t i = 0; i < m_playingAnimations.size();)
 		{
-			auto& animComponent = entity->GetComponent<AnimationComponent>();
-			animComponent.Update(now);
+			if (now < m_playingAnimations[i].endTime)
+			{
+				++i;
+				continue;
+			}
+
+			// End callbacks may start another animation, which is added back to the list
+			AnimationComponent* animation = m_playingAnimations[i].animation;
+			RemovePlayingAnimation(i);
+
+			animation->Update(now);
 		}
 	}
 
@@ -0,0 +1,61 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Systems/ElementIndexSystem.hpp>
+#include <CoreLib/Components/ScriptComponent.hpp>
+
+namespace bw
+{
+	ElementIndexSystem::ElementIndexSystem()
+	{
+		Requires<ScriptComponent>();
+		SetMaximumUpdateRate(0);
+	}
+
+	void ElementIndexSystem::OnEntityRemoved(Ndk::Entity* entity)
+	{
+		// Script component may already be gone at this point, use the class which was indexed
+		auto it = m_entityClasses.find(entity->GetId());
+		if (it == m_entityClasses.end())
+			return;
+
+		m_classEntities[it->second].Remove(entity);
+		m_entityClasses.erase(it);
+	}
+
+	void ElementIndexSystem::OnEntityValidation(Ndk::Entity* entity, bool /*justAdded*/)
+	{
+		auto& scriptComponent = entity->GetComponent<ScriptComponent>();
+		const std::string& elementClass = scriptComponent.GetElement()->fullName;
+
+		auto classIt = m_classIndices.find(elementClass);
+		if (classIt == m_classIndices.end())
+		{
+			classIt = m_classIndices.emplace(elementClass, m_classEntities.size()).first;
+			m_classEntities.emplace_back();
+		}
+
+		std::size_t classIndex = classIt->second;
+
+		auto entityIt = m_entityClasses.find(entity->GetId());
+		if (entityIt != m_entityClasses.end())
+		{
+			if (entityIt->second == classIndex)
+				return;
+
+			m_classEntities[entityIt->second].Remove(entity);
+			entityIt.value() = classIndex;
+		}
+		else
+			m_entityClasses.emplace(entity->GetId(), classIndex);
+
+		m_classEntities[classIndex].Insert(entity);
+	}
+
+	void ElementIndexSystem::OnUpdate(float /*elapsedTime*/)
+	{
+	}
+
+	Ndk::SystemIndex ElementIndexSystem::systemIndex;
+}
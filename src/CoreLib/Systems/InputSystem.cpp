@@ -3,7 +3,7 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/Systems/InputSystem.hpp>
-#include <CoreLib/Components/InputComponent.hpp>
+#include <CoreLib/InputController.hpp>
 
 namespace bw
 {
@@ -14,16 +14,55 @@ namespace bw
 		SetUpdateOrder(-100);
 	}
 
+	void InputSystem::OnEntityAdded(Ndk::Entity* entity)
+	{
+		auto& inputComponent = entity->GetComponent<InputComponent>();
+
+		EntityData& entityData = m_entityData.emplace(entity->GetId(), EntityData{}).first.value();
+		entityData.onControllerUpdate.Connect(inputComponent.OnControllerUpdate, [this, entity](InputComponent* input)
+		{
+			RefreshControllerKind(entity, *input);
+		});
+
+		RefreshControllerKind(entity, inputComponent);
+	}
+
+	void InputSystem::OnEntityRemoved(Ndk::Entity* entity)
+	{
+		m_entityData.erase(entity->GetId());
+		m_nativeControlledEntities.Remove(entity);
+		m_scriptControlledEntities.Remove(entity);
+	}
+
 	void InputSystem::OnUpdate(float /*elapsedTime*/)
 	{
-		for (const Ndk::EntityHandle& entity : GetEntities())
+		UpdateInputs(m_nativeControlledEntities);
+		UpdateInputs(m_scriptControlledEntities);
+	}
+
+	void InputSystem::RefreshControllerKind(Ndk::Entity* entity, const InputComponent& inputComponent)
+	{
+		m_nativeControlledEntities.Remove(entity);
+		m_scriptControlledEntities.Remove(entity);
+
+		// Entities without controller get their inputs from elsewhere (network, scripts calling UpdateInputs)
+		const auto& controller = inputComponent.GetController();
+		if (!controller)
+			return;
+
+		if (controller->IsScripted())
+			m_scriptControlledEntities.Insert(entity);
+		else
+			m_nativeControlledEntities.Insert(entity);
+	}
+
+	void InputSystem::UpdateInputs(const Ndk::EntityList& entities)
+	{
+		for (const Ndk::EntityHandle& entity : entities)
 		{
 			auto& inputComponent = entity->GetComponent<InputComponent>();
-			if (const auto& controller = inputComponent.GetController())
-			{
-				if (auto inputOpt = controller->GenerateInputs(entity))
-					inputComponent.UpdateInputs(*inputOpt);
-			}
+			if (auto inputOpt = inputComponent.GetController()->GenerateInputs(entity))
+				inputComponent.UpdateInputs(*inputOpt);
 		}
 	}
 
@@ -12,11 +12,15 @@
 #include <CoreLib/Components/NetworkSyncComponent.hpp>
 #include <CoreLib/Components/OwnerComponent.hpp>
 #include <CoreLib/Components/PlayerMovementComponent.hpp>
+#include <CoreLib/Components/PoolableComponent.hpp>
 #include <CoreLib/Components/ScriptComponent.hpp>
+#include <algorithm>
+#include <cmath>
 
 namespace bw
 {
 	NetworkSyncSystem::NetworkSyncSystem(TerrainLayer& layer) :
+	m_lastCreationEventId(0),
 	m_layer(layer)
 	{
 		Requires<NetworkSyncComponent, Ndk::NodeComponent>();
@@ -26,44 +30,86 @@ namespace bw
 
 	void NetworkSyncSystem::CreateEntities(const std::function<void(const EntityCreation* entityCreation, std::size_t entityCount)>& callback) const
 	{
-		m_creationEvents.clear();
+		// Sessions can query this from multiple threads at once
+		thread_local std::vector<EntityCreation> creationEvents;
+		creationEvents.clear();
 
 		for (const Ndk::EntityHandle& entity : GetEntities())
 		{
-			EntityCreation& creationEvent = m_creationEvents.emplace_back();
+			EntityCreation& creationEvent = creationEvents.emplace_back();
 			BuildEvent(creationEvent, entity);
 		}
 
-		callback(m_creationEvents.data(), m_creationEvents.size());
+		callback(creationEvents.data(), creationEvents.size());
 	}
 
 	void NetworkSyncSystem::DeleteEntities(const std::function<void(const EntityDestruction* entityDestruction, std::size_t entityCount)>& callback) const
 	{
-		m_destructionEvents.clear();
+		thread_local std::vector<EntityDestruction> destructionEvents;
+		destructionEvents.clear();
 
 		for (const Ndk::EntityHandle& entity : GetEntities())
 		{
-			EntityDestruction& destructionEvent = m_destructionEvents.emplace_back();
+			EntityDestruction& destructionEvent = destructionEvents.emplace_back();
 			BuildEvent(destructionEvent, entity);
 		}
 
-		callback(m_destructionEvents.data(), m_destructionEvents.size());
+		callback(destructionEvents.data(), destructionEvents.size());
 	}
 
-	void NetworkSyncSystem::MoveEntities(const std::function<void(const EntityMovement* entityMovement, std::size_t entityCount)>& callback) const
+	std::shared_ptr<const NetworkSyncSystem::EntityCreationPayload> NetworkSyncSystem::BuildCreationPayload(Ndk::Entity* entity) const
 	{
-		m_movementEvents.clear();
+		const NetworkStringStore& networkStringStore = m_layer.GetMatch().GetNetworkStringStore();
+		const NetworkSyncComponent& syncComponent = entity->GetComponent<NetworkSyncComponent>();
 
-		for (const Ndk::EntityHandle& entity : m_physicsEntities)
+		auto payload = std::make_shared<EntityCreationPayload>();
+		payload->entityClass = networkStringStore.CheckStringIndex(syncComponent.GetEntityClass());
+
+		if (entity->HasComponent<ScriptComponent>())
 		{
-			auto& entityPhys = entity->GetComponent<Ndk::PhysicsComponent2D>();
-			if (entityPhys.IsSleeping())
-				continue;
+			auto& scriptComponent = entity->GetComponent<ScriptComponent>();
+
+			const auto& element = scriptComponent.GetElement();
+			const auto& properties = scriptComponent.GetProperties();
 
-			BuildEvent(m_movementEvents.emplace_back(), entity);
+			for (const auto& [key, property] : element->properties)
+			{
+				if (!property.shared || property.index >= properties.size() || !properties[property.index])
+					continue;
+
+				const PropertyValue& value = *properties[property.index];
+
+				auto& propertyData = payload->properties.emplace_back();
+				propertyData.name = networkStringStore.CheckStringIndex(key);
+				propertyData.value = value;
+
+				auto RegisterDependentId = [&](EntityId entityId)
+				{
+					payload->dependentUniqueIds.push_back(entityId);
+				};
+
+				std::visit([&](auto&& propertyValue)
+				{
+					using T = std::decay_t<decltype(propertyValue)>;
+					using TypeExtractor = PropertyTypeExtractor<T>;
+					constexpr bool IsArray = TypeExtractor::IsArray;
+
+					if constexpr (TypeExtractor::Property == PropertyType::Entity)
+					{
+						if constexpr (IsArray)
+						{
+							for (auto& id : propertyValue)
+								RegisterDependentId(id);
+						}
+						else
+							RegisterDependentId(propertyValue.value);
+
+					}
+				}, value);
+			}
 		}
 
-		callback(m_movementEvents.data(), m_movementEvents.size());
+		return payload;
 	}
 
 	void NetworkSyncSystem::BuildEvent(EntityCreation& creationEvent, Ndk::Entity* entity) const
@@ -71,11 +117,17 @@ namespace bw
 		const NetworkSyncComponent& syncComponent = entity->GetComponent<NetworkSyncComponent>();
 
 		creationEvent.entityId = entity->GetId();
-		creationEvent.entityClass = syncComponent.GetEntityClass();
+		creationEvent.eventId = 0; //< built for a single session
+
+		auto payloadIt = m_creationPayloads.find(entity->GetId());
+		assert(payloadIt != m_creationPayloads.end());
+		creationEvent.payload = payloadIt->second;
 
 		auto& entityMatch = entity->GetComponent<MatchComponent>();
 		creationEvent.uniqueId = entityMatch.GetUniqueId();
 
+		creationEvent.respawned = entity->HasComponent<PoolableComponent>() && entity->GetComponent<PoolableComponent>().IsRespawned();
+
 		if (const Ndk::EntityHandle& parent = syncComponent.GetParent())
 		{
 			assert(parent->GetWorld() == entity->GetWorld());
@@ -134,50 +186,14 @@ namespace bw
 			creationEvent.playerMovement->isFacingRight = entityPlayerMovement.IsFacingRight();
 		}
 
-		if (entity->HasComponent<ScriptComponent>())
+		// Resolved on each event as the property entities may have been created in the meantime
+		for (EntityId dependentUniqueId : creationEvent.payload->dependentUniqueIds)
 		{
-			auto& scriptComponent = entity->GetComponent<ScriptComponent>();
-
-			const auto& element = scriptComponent.GetElement();
-
-			for (const auto& [key, value] : scriptComponent.GetProperties())
+			const Ndk::EntityHandle& propertyEntity = m_layer.GetMatch().RetrieveEntityByUniqueId(dependentUniqueId);
+			if (propertyEntity)
 			{
-				auto it = element->properties.find(key);
-				assert(it != element->properties.end());
-
-				if (!it->second.shared)
-					continue;
-
-				creationEvent.properties.emplace(key, value);
-
-				auto RegisterDependentId = [&](EntityId entityId)
-				{
-					const Ndk::EntityHandle& propertyEntity = m_layer.GetMatch().RetrieveEntityByUniqueId(entityId);
-					if (propertyEntity)
-					{
-						auto& propertyEntityMatch = propertyEntity->GetComponent<MatchComponent>();
-						creationEvent.dependentIds.emplace_back(propertyEntityMatch.GetLayerIndex(), propertyEntity->GetId());
-					}
-				};
-
-				std::visit([&](auto&& propertyValue)
-				{
-					using T = std::decay_t<decltype(propertyValue)>;
-					using TypeExtractor = PropertyTypeExtractor<T>;
-					constexpr bool IsArray = TypeExtractor::IsArray;
-
-					if constexpr (TypeExtractor::Property == PropertyType::Entity)
-					{
-						if constexpr (IsArray)
-						{
-							for (auto& id : propertyValue)
-								RegisterDependentId(id);
-						}
-						else
-							RegisterDependentId(propertyValue.value);
-
-					}
-				}, value);
+				auto& propertyEntityMatch = propertyEntity->GetComponent<MatchComponent>();
+				creationEvent.dependentIds.emplace_back(propertyEntityMatch.GetLayerIndex(), propertyEntity->GetId());
 			}
 		}
 
@@ -198,6 +214,7 @@ namespace bw
 	void NetworkSyncSystem::BuildEvent(EntityDestruction& deleteEvent, Ndk::Entity* entity) const
 	{
 		deleteEvent.entityId = entity->GetId();
+		deleteEvent.recycled = m_layer.IsEntityRecycled(entity->GetId());
 	}
 
 	void NetworkSyncSystem::BuildEvent(EntityMovement& movementEvent, Ndk::Entity* entity) const
@@ -235,8 +252,13 @@ namespace bw
 
 	void NetworkSyncSystem::OnEntityAdded(Ndk::Entity* entity)
 	{
+		// Built once as properties don't change during the entity lifetime (scale, weapon and such are read on each event)
+		assert(m_creationPayloads.find(entity->GetId()) == m_creationPayloads.end());
+		m_creationPayloads.emplace(entity->GetId(), BuildCreationPayload(entity));
+
 		EntityCreation creationEvent;
 		BuildEvent(creationEvent, entity);
+		creationEvent.eventId = ++m_lastCreationEventId;
 
 		OnEntityCreated(this, creationEvent);
 
@@ -252,12 +274,7 @@ namespace bw
 		{
 			slots.onAnimationStart.Connect(entity->GetComponent<AnimationComponent>().OnAnimationStart, [&](AnimationComponent* anim)
 			{
-				EntityPlayAnimation event;
-				event.animId = anim->GetAnimId();
-				event.entityId = anim->GetEntity()->GetId();
-				event.startTime = anim->GetStartTime();
-
-				OnEntityPlayAnimation(this, event);
+				MarkDirty(anim->GetEntity(), NetworkDirtyFlag::Animation);
 			});
 		}
 
@@ -275,7 +292,7 @@ namespace bw
 
 			slots.onHealthChange.Connect(entityHealth.OnHealthChange, [&](HealthComponent* health, Nz::UInt16 /*newHealth*/, const Ndk::EntityHandle& /*dealer*/)
 			{
-				m_healthUpdateEntities.Insert(health->GetEntity());
+				MarkDirty(health->GetEntity(), NetworkDirtyFlag::Health);
 			});
 		}
 
@@ -283,7 +300,7 @@ namespace bw
 		{
 			slots.onInputUpdate.Connect(entity->GetComponent<InputComponent>().OnInputUpdate, [&](InputComponent* input)
 			{
-				m_inputUpdateEntities.Insert(input->GetEntity());
+				MarkDirty(input->GetEntity(), NetworkDirtyFlag::Inputs);
 			});
 		}
 
@@ -293,7 +310,7 @@ namespace bw
 
 			slots.onNewWeaponSelection.Connect(entityWeaponWielder.OnNewWeaponSelection, [&](WeaponWielderComponent* wielder, std::size_t /*newWeaponIndex*/)
 			{
-				m_weaponUpdateEntities.Insert(wielder->GetEntity());
+				MarkDirty(wielder->GetEntity(), NetworkDirtyFlag::Weapon);
 			});
 		}
 	}
@@ -305,12 +322,17 @@ namespace bw
 
 		OnEntityDeleted(this, destructionEvent);
 
-		m_healthUpdateEntities.Remove(entity);
-		m_inputUpdateEntities.Remove(entity);
+		m_creationPayloads.erase(entity->GetId());
+		m_movementStates.erase(entity->GetId());
 		m_physicsEntities.Remove(entity);
-		m_physicsUpdateEntities.Remove(entity);
 		m_staticEntities.Remove(entity);
-		m_weaponUpdateEntities.Remove(entity);
+
+		// Pending updates of an entity leaving the system are dropped (its id may be reused before the next update)
+		if (m_dirtyEntities.UnboundedTest(entity->GetId()))
+		{
+			m_entityDirtyFlags[entity->GetId()] = NetworkDirtyFlags{};
+			m_dirtyEntities.Reset(entity->GetId());
+		}
 
 		auto it = m_entitySlots.find(entity->GetId());
 		assert(it != m_entitySlots.end());
@@ -319,55 +341,70 @@ namespace bw
 
 	void NetworkSyncSystem::OnUpdate(float /*elapsedTime*/)
 	{
-		if (!m_healthUpdateEntities.empty())
+		if (m_dirtyEntities.TestNone())
+			return;
+
+		m_healthEvents.clear();
+		m_inputEvents.clear();
+		m_movementEvents.clear();
+		m_physicsEvent.clear();
+		m_playAnimationEvents.clear();
+		m_scaleEvent.clear();
+		m_weaponEvents.clear();
+
+		// Every kind of update is gathered in one pass over the touched entities (in id order, as the event lists)
+		Ndk::World& world = GetWorld();
+		for (std::size_t entityId = m_dirtyEntities.FindFirst(); entityId != m_dirtyEntities.npos; entityId = m_dirtyEntities.FindNext(entityId))
 		{
-			m_healthEvents.clear();
+			assert(entityId < m_entityDirtyFlags.size());
+			NetworkDirtyFlags dirtyFlags = m_entityDirtyFlags[entityId];
+			m_entityDirtyFlags[entityId] = NetworkDirtyFlags{};
 
-			for (const auto& entity : m_healthUpdateEntities)
+			const Ndk::EntityHandle& entity = world.GetEntity(static_cast<Ndk::EntityId>(entityId));
+			assert(entity);
+
+			if (dirtyFlags & NetworkDirtyFlag::Health)
 			{
 				EntityHealth& healthEvent = m_healthEvents.emplace_back();
 				healthEvent.entityId = entity->GetId();
 				healthEvent.currentHealth = entity->GetComponent<HealthComponent>().GetHealth();
-			}
-			m_healthUpdateEntities.Clear();
 
-			OnEntitiesHealthUpdate(this, m_healthEvents.data(), m_healthEvents.size());
-		}
-
-		if (!m_inputUpdateEntities.empty())
-		{
-			m_inputEvents.clear();
+				m_updatedEntities[static_cast<std::size_t>(NetworkDirtyFlag::Health)].UnboundedSet(entityId);
+			}
 
-			for (const auto& entity : m_inputUpdateEntities)
+			if (dirtyFlags & NetworkDirtyFlag::Inputs)
 			{
 				EntityInputs& inputEvent = m_inputEvents.emplace_back();
 				inputEvent.entityId = entity->GetId();
 				inputEvent.inputs = entity->GetComponent<InputComponent>().GetInputs();
+
+				m_updatedEntities[static_cast<std::size_t>(NetworkDirtyFlag::Inputs)].UnboundedSet(entityId);
 			}
 
-			m_inputUpdateEntities.Clear();
+			if (dirtyFlags & NetworkDirtyFlag::Animation)
+			{
+				// Animations started during the tick are sent as one batch, only the last one of each entity matters
+				auto& entityAnimation = entity->GetComponent<AnimationComponent>();
+				if (entityAnimation.IsPlaying())
+				{
+					EntityPlayAnimation& playAnimationEvent = m_playAnimationEvents.emplace_back();
+					playAnimationEvent.animId = entityAnimation.GetAnimId();
+					playAnimationEvent.entityId = entity->GetId();
+					playAnimationEvent.startTime = entityAnimation.GetStartTime();
 
-			OnEntitiesInputUpdate(this, m_inputEvents.data(), m_inputEvents.size());
-		}
+					m_updatedEntities[static_cast<std::size_t>(NetworkDirtyFlag::Animation)].UnboundedSet(entityId);
+				}
+			}
 
-		if (!m_movedStaticEntities.empty())
-		{
-			for (const auto& entity : m_movedStaticEntities)
+			if (dirtyFlags & NetworkDirtyFlag::Movement)
 			{
-				EntityMovement movementEvent;
+				EntityMovement& movementEvent = m_movementEvents.emplace_back();
 				BuildEvent(movementEvent, entity);
 
-				OnEntityInvalidated(this, movementEvent);
+				m_updatedEntities[static_cast<std::size_t>(NetworkDirtyFlag::Movement)].UnboundedSet(entityId);
 			}
 
-			m_movedStaticEntities.Clear();
-		}
-
-		if (!m_physicsUpdateEntities.empty())
-		{
-			m_physicsEvent.clear();
-
-			for (const auto& entity : m_physicsUpdateEntities)
+			if (dirtyFlags & NetworkDirtyFlag::Physics)
 			{
 				EntityPhysics& physicsEvent = m_physicsEvent.emplace_back();
 				physicsEvent.entityId = entity->GetId();
@@ -386,36 +423,22 @@ namespace bw
 					playerMovementData.jumpHeightBoost = entityPlayerMovement.GetJumpBoostHeight();
 					playerMovementData.movementSpeed = entityPlayerMovement.GetMovementSpeed();
 				}
-			}
-
-			m_physicsUpdateEntities.Clear();
 
-			OnEntitiesPhysicsUpdate(this, m_physicsEvent.data(), m_physicsEvent.size());
-		}
-
-		if (!m_scaleUpdateEntities.empty())
-		{
-			m_scaleEvent.clear();
+				m_updatedEntities[static_cast<std::size_t>(NetworkDirtyFlag::Physics)].UnboundedSet(entityId);
+			}
 
-			for (const auto& entity : m_scaleUpdateEntities)
+			if (dirtyFlags & NetworkDirtyFlag::Scale)
 			{
 				auto& entityNode = entity->GetComponent<Ndk::NodeComponent>();
 
 				EntityScale& scaleEvent = m_scaleEvent.emplace_back();
 				scaleEvent.entityId = entity->GetId();
 				scaleEvent.newScale = entityNode.GetScale().y;
-			}
-
-			m_scaleUpdateEntities.Clear();
-
-			OnEntitiesScaleUpdate(this, m_scaleEvent.data(), m_scaleEvent.size());
-		}
 
-		if (!m_weaponUpdateEntities.empty())
-		{
-			m_weaponEvents.clear();
+				m_updatedEntities[static_cast<std::size_t>(NetworkDirtyFlag::Scale)].UnboundedSet(entityId);
+			}
 
-			for (const auto& entity : m_weaponUpdateEntities)
+			if (dirtyFlags & NetworkDirtyFlag::Weapon)
 			{
 				auto& weaponWielder = entity->GetComponent<WeaponWielderComponent>();
 
@@ -426,11 +449,121 @@ namespace bw
 
 				if (selectedWeapon != WeaponWielderComponent::NoWeapon)
 					weaponEvent.weaponId = weaponWielder.GetWeapon(selectedWeapon)->GetId();
+
+				m_updatedEntities[static_cast<std::size_t>(NetworkDirtyFlag::Weapon)].UnboundedSet(entityId);
 			}
+		}
 
-			m_weaponUpdateEntities.Clear();
+		m_dirtyEntities.Reset();
 
+		if (!m_healthEvents.empty())
+			OnEntitiesHealthUpdate(this, m_healthEvents.data(), m_healthEvents.size());
+
+		if (!m_inputEvents.empty())
+			OnEntitiesInputUpdate(this, m_inputEvents.data(), m_inputEvents.size());
+
+		if (!m_playAnimationEvents.empty())
+			OnEntitiesPlayAnimation(this, m_playAnimationEvents.data(), m_playAnimationEvents.size());
+
+		for (const EntityMovement& movementEvent : m_movementEvents)
+			OnEntityInvalidated(this, movementEvent);
+
+		if (!m_physicsEvent.empty())
+			OnEntitiesPhysicsUpdate(this, m_physicsEvent.data(), m_physicsEvent.size());
+
+		if (!m_scaleEvent.empty())
+			OnEntitiesScaleUpdate(this, m_scaleEvent.data(), m_scaleEvent.size());
+
+		if (!m_weaponEvents.empty())
 			OnEntitiesWeaponUpdate(this, m_weaponEvents.data(), m_weaponEvents.size());
+
+		for (auto& updatedEntities : m_updatedEntities)
+			updatedEntities.Reset();
+	}
+
+	void NetworkSyncSystem::UpdateMovementSnapshot()
+	{
+		m_movementSnapshot.entityIds.clear();
+		m_movementSnapshot.positions.clear();
+		m_movementSnapshot.rotations.clear();
+		m_movementSnapshot.linearVelocities.clear();
+		m_movementSnapshot.angularVelocities.clear();
+		m_movementSnapshot.flags.clear();
+		m_movementSnapshot.priorities.clear();
+		m_movementSnapshot.updateIntervals.clear();
+
+		Match& match = m_layer.GetMatch();
+		const auto& movementSync = match.GetSettings().movementSync;
+
+		Nz::UInt64 currentTick = match.GetCurrentTick();
+		Nz::UInt64 settleTickCount = 0;
+		if (movementSync)
+			settleTickCount = static_cast<Nz::UInt64>(std::ceil(movementSync->settleDuration / match.GetTickDuration()));
+
+		for (const Ndk::EntityHandle& entity : m_physicsEntities)
+		{
+			auto& entityPhys = entity->GetComponent<Ndk::PhysicsComponent2D>();
+			bool isSleeping = entityPhys.IsSleeping();
+			if (isSleeping && !movementSync)
+				continue;
+
+			Nz::UInt8 flags = 0;
+			if (entity->HasComponent<PlayerMovementComponent>())
+			{
+				flags |= MovementSnapshot::HasPlayerMovement;
+				if (entity->GetComponent<PlayerMovementComponent>().IsFacingRight())
+					flags |= MovementSnapshot::IsFacingRight;
+			}
+
+			Nz::Vector2f position = entityPhys.GetPosition();
+			Nz::RadianAnglef rotation = entityPhys.GetRotation();
+
+			if (movementSync)
+			{
+				// Compare with the last significant state (not the previous tick) so slow drifts are eventually sent
+				auto [it, inserted] = m_movementStates.try_emplace(entity->GetId());
+				MovementState& movementState = it.value();
+
+				bool justFellAsleep = !inserted && isSleeping && !movementState.isSleeping;
+				if (inserted || justFellAsleep || flags != movementState.flags ||
+				    !CompareWithEpsilon(position, movementState.position, movementSync->positionEpsilon) ||
+				    !CompareWithEpsilon(rotation, movementState.rotation, movementSync->rotationEpsilon))
+				{
+					movementState.flags = flags;
+					movementState.lastChangeTick = currentTick;
+					movementState.position = position;
+					movementState.rotation = rotation;
+				}
+				movementState.isSleeping = isSleeping;
+
+				bool hasChanged = (currentTick - movementState.lastChangeTick <= settleTickCount);
+
+				// Controlled entities are always sent as clients reconcile their predictions with them
+				bool isControlled = !isSleeping && entity->HasComponent<InputComponent>();
+
+				// Keyframes are spread over ticks to prevent bursts
+				bool isKeyframe = (movementSync->keyframeInterval > 0 && (currentTick + entity->GetId()) % movementSync->keyframeInterval == 0);
+
+				if (!hasChanged && !isControlled && !isKeyframe)
+					continue;
+			}
+
+			//TODO: Handle parents?
+			m_movementSnapshot.entityIds.push_back(entity->GetId());
+			m_movementSnapshot.positions.push_back(position);
+			m_movementSnapshot.rotations.push_back(rotation);
+			m_movementSnapshot.linearVelocities.push_back(entityPhys.GetVelocity());
+			m_movementSnapshot.angularVelocities.push_back(entityPhys.GetAngularVelocity());
+			m_movementSnapshot.flags.push_back(flags);
+
+			const NetworkSyncComponent::Settings& syncSettings = entity->GetComponent<NetworkSyncComponent>().GetSettings();
+
+			Nz::UInt16 updateInterval = 1;
+			if (syncSettings.maxUpdateRate > 0.f)
+				updateInterval = static_cast<Nz::UInt16>(std::clamp(std::lround(1.f / (syncSettings.maxUpdateRate * match.GetTickDuration())), 1L, 0xFFL));
+
+			m_movementSnapshot.priorities.push_back(syncSettings.priority);
+			m_movementSnapshot.updateIntervals.push_back(updateInterval);
 		}
 	}
 
@@ -8,6 +8,7 @@
 #include <CoreLib/PlayerMovementController.hpp>
 #include <CoreLib/Components/InputComponent.hpp>
 #include <CoreLib/Components/PlayerMovementComponent.hpp>
+#include <cassert>
 
 namespace bw
 {
@@ -19,19 +20,20 @@ namespace bw
 	
 	void PlayerMovementSystem::OnEntityAdded(Ndk::Entity* entity)
 	{
-		Ndk::PhysicsComponent2D& entityPhys = entity->GetComponent<Ndk::PhysicsComponent2D>();
-		entityPhys.SetVelocityFunction([entity = entity->CreateHandle()](Nz::RigidBody2D& rigidBody, const Nz::Vector2f& gravity, float damping, float dt)
-		{
-			auto& movementComponent = entity->GetComponent<PlayerMovementComponent>();
+		MovementData& movementData = m_movementData.emplace_back();
+		movementData.entityId = entity->GetId();
+		movementData.input = &entity->GetComponent<InputComponent>();
+		movementData.movement = &entity->GetComponent<PlayerMovementComponent>();
+		movementData.node = &entity->GetComponent<Ndk::NodeComponent>();
+		movementData.physics = &entity->GetComponent<Ndk::PhysicsComponent2D>();
 
-			const auto& controller = movementComponent.GetController();
-			if (controller)
-			{
-				auto& inputComponent = entity->GetComponent<InputComponent>();
-				const auto& inputs = inputComponent.GetInputs();
+		m_movementIndices[entity->GetId()] = m_movementData.size() - 1;
 
-				controller->UpdateVelocity(inputs, movementComponent, rigidBody, gravity, damping, dt);
-			}
+		// Components outlive the velocity function, which is reset when the entity leaves this system
+		movementData.physics->SetVelocityFunction([input = movementData.input, movement = movementData.movement](Nz::RigidBody2D& rigidBody, const Nz::Vector2f& gravity, float damping, float dt)
+		{
+			if (const auto& controller = movement->GetController())
+				controller->UpdateVelocity(input->GetInputs(), *movement, rigidBody, gravity, damping, dt);
 			else
 				rigidBody.UpdateVelocity(gravity, damping, dt);
 		});
@@ -39,6 +41,20 @@ namespace bw
 
 	void PlayerMovementSystem::OnEntityRemoved(Ndk::Entity* entity)
 	{
+		auto it = m_movementIndices.find(entity->GetId());
+		assert(it != m_movementIndices.end());
+
+		std::size_t movementIndex = it->second;
+		m_movementIndices.erase(it);
+
+		if (movementIndex != m_movementData.size() - 1)
+		{
+			m_movementData[movementIndex] = m_movementData.back();
+			m_movementIndices[m_movementData[movementIndex].entityId] = movementIndex;
+		}
+
+		m_movementData.pop_back();
+
 		if (!entity->HasComponent<Ndk::PhysicsComponent2D>())
 			return;
 
@@ -51,19 +67,15 @@ namespace bw
 
 	void PlayerMovementSystem::OnUpdate(float /*elapsedTime*/)
 	{
-		for (const Ndk::EntityHandle& entity : GetEntities())
-		{
-			auto& inputComponent = entity->GetComponent<InputComponent>();
-			auto& playerMovement = entity->GetComponent<PlayerMovementComponent>();
-			auto& nodeComponent = entity->GetComponent<Ndk::NodeComponent>();
-			auto& entityPhys = entity->GetComponent<Ndk::PhysicsComponent2D>();
+		Nz::Vector2f up = Nz::Vector2f::UnitY();
 
-			const auto& inputs = inputComponent.GetInputs();
-			
-			Nz::Vector2f up = Nz::Vector2f::UnitY();
+		for (const MovementData& movementData : m_movementData)
+		{
+			const auto& inputs = movementData.input->GetInputs();
+			PlayerMovementComponent& playerMovement = *movementData.movement;
 
 			bool isOnGround = false;
-			entityPhys.ForEachArbiter([&](Nz::Arbiter2D& arbiter)
+			movementData.physics->ForEachArbiter([&](Nz::Arbiter2D& arbiter)
 			{
 				if (up.DotProduct(arbiter.GetNormal()) > 0.75f)
 					isOnGround = true;
@@ -74,7 +86,7 @@ namespace bw
 			playerMovement.UpdateWasJumpingState(inputs.isJumping);
 
 			if (playerMovement.UpdateFacingRightState(inputs.isLookingRight))
-				nodeComponent.Scale(-1.f, 1.f);
+				movementData.node->Scale(-1.f, 1.f);
 		}
 	}
 
@@ -6,18 +6,32 @@
 #include <CoreLib/SharedMatch.hpp>
 #include <CoreLib/LogSystem/Logger.hpp>
 #include <CoreLib/Components/ScriptComponent.hpp>
+#include <algorithm>
 
 namespace bw
 {
 	TickCallbackSystem::TickCallbackSystem(SharedMatch& match) :
-	m_match(match)
+	m_match(match),
+	m_currentFrame(0),
+	m_scriptTime(0.0)
 	{
 		Requires<ScriptComponent>();
 		SetMaximumUpdateRate(0);
 	}
 
+	void TickCallbackSystem::Reschedule(Ndk::Entity* entity)
+	{
+		auto it = m_entityTicks.find(entity->GetId());
+		if (it == m_entityTicks.end())
+			return;
+
+		it.value().lastUpdateTime = m_scriptTime;
+		Schedule(entity->GetId(), entity->GetComponent<ScriptComponent>().m_timeBeforeTick);
+	}
+
 	void TickCallbackSystem::OnEntityRemoved(Ndk::Entity* entity)
 	{
+		m_entityTicks.erase(entity->GetId()); //< its wheel entries are ignored from now on
 		m_tickableEntities.Remove(entity);
 	}
 
@@ -26,35 +40,95 @@ namespace bw
 		auto& scriptComponent = entity->GetComponent<ScriptComponent>();
 
 		if (scriptComponent.HasCallbacks(ElementEvent::Tick))
+		{
+			if (m_tickableEntities.Has(entity))
+				return;
+
 			m_tickableEntities.Insert(entity);
+
+			auto& entityTick = m_entityTicks[entity->GetId()];
+			entityTick.lastUpdateTime = m_scriptTime;
+
+			Schedule(entity->GetId(), scriptComponent.m_timeBeforeTick);
+		}
 		else
-			m_tickableEntities.Remove(entity);
+			OnEntityRemoved(entity);
 	}
 
 	void TickCallbackSystem::OnUpdate(float elapsedTime)
 	{
-		for (const Ndk::EntityHandle& entity : m_tickableEntities)
+		// Scripts ticking every frame keep running at full rate, only interval-based ticks (SetNextTick) get stretched
+		float scriptElapsedTime = elapsedTime;
+		if (m_match.GetLoadLevel() >= SharedMatch::LoadLevel::StretchScripts)
+			scriptElapsedTime *= 0.5f;
+
+		m_scriptTime += scriptElapsedTime;
+
+		Nz::UInt64 frame = m_currentFrame++;
+
+		// Callbacks schedule ticks in the next frames, swap the bucket out so they can't touch what we're iterating
+		std::vector<ScheduledTick>& bucket = m_tickWheel[frame % WheelSize];
+		std::swap(m_dueTicks, bucket);
+
+		for (const ScheduledTick& scheduledTick : m_dueTicks)
 		{
-			auto& scriptComponent = entity->GetComponent<ScriptComponent>();
-			if (!scriptComponent.CanTriggerTick(elapsedTime)) //<FIXME: Due to reconciliation, this is not right
+			auto it = m_entityTicks.find(scheduledTick.entityId);
+			if (it == m_entityTicks.end() || it->second.serial != scheduledTick.serial)
+				continue; //< entity was removed or rescheduled since
+
+			if (scheduledTick.dueFrame > frame)
+			{
+				// Due in a later lap of the wheel
+				bucket.push_back(scheduledTick);
 				continue;
+			}
+
+			const Ndk::EntityHandle& entity = GetWorld().GetEntity(scheduledTick.entityId);
+			auto& scriptComponent = entity->GetComponent<ScriptComponent>();
+
+			// Entities are scheduled with the unstretched tick duration, they may be visited early (never late) under load
+			float elapsedSinceUpdate = static_cast<float>(m_scriptTime - it->second.lastUpdateTime);
+			it.value().lastUpdateTime = m_scriptTime;
+
+			if (scriptComponent.CanTriggerTick(elapsedSinceUpdate)) //<FIXME: Due to reconciliation, this is not right
+				scriptComponent.ExecuteCallback<ElementEvent::Tick>();
+
+			// Script may have removed the entity or its tick callbacks
+			if (m_entityTicks.find(scheduledTick.entityId) != m_entityTicks.end() && entity)
+				Schedule(scheduledTick.entityId, scriptComponent.m_timeBeforeTick);
+		}
+
+		m_dueTicks.clear();
+	}
+
+	void TickCallbackSystem::Schedule(Ndk::EntityId entityId, float timeBeforeTick)
+	{
+		EntityTick& entityTick = m_entityTicks[entityId];
+		entityTick.serial++;
+
+		// Number of frames before the countdown goes below zero (ticking every frame while it stays negative)
+		Nz::UInt64 frameCount = 1;
+		float tickDuration = m_match.GetTickDuration();
+		if (timeBeforeTick >= 0.f && tickDuration > 0.f)
+			frameCount = static_cast<Nz::UInt64>(timeBeforeTick / tickDuration) + 1;
 
-			//FIXME
-			scriptComponent.ExecuteCallback<ElementEvent::Tick>();
+		// Entities spawned together with the same interval would tick on the same frames, spread them over the least busy of the next few buckets
+		Nz::UInt64 dueFrame = m_currentFrame + frameCount - 1;
+		if (frameCount >= PhaseSpreadMinInterval)
+		{
+			Nz::UInt64 spread = std::min(frameCount / PhaseSpreadMinInterval, MaxPhaseSpread);
 
-			/*auto result = element->tickFunction(scriptComponent.GetTable());
-			if (result.valid())
+			Nz::UInt64 bestFrame = dueFrame;
+			for (Nz::UInt64 candidate = dueFrame + 1; candidate <= dueFrame + spread; ++candidate)
 			{
-				sol::object retObj = result;
-				if (retObj.is<float>())
-					scriptComponent.SetNextTick(retObj.as<float>());
+				if (m_tickWheel[candidate % WheelSize].size() < m_tickWheel[bestFrame % WheelSize].size())
+					bestFrame = candidate;
 			}
-			else
-			{
-				sol::error err = result;
-				bwLog(m_match.GetLogger(), LogLevel::Error, "OnTick failed: {0}", err.what());
-			}*/
+
+			dueFrame = bestFrame;
 		}
+
+		m_tickWheel[dueFrame % WheelSize].push_back({ entityId, entityTick.serial, dueFrame });
 	}
 
 	Ndk::SystemIndex TickCallbackSystem::systemIndex;
@@ -19,14 +19,34 @@ namespace bw
 		SetMaximumUpdateRate(0);
 	}
 
+	void WeaponSystem::OnEntityAdded(Ndk::Entity* entity)
+	{
+		auto& weaponComponent = entity->GetComponent<WeaponComponent>();
+
+		EntityData& entityData = m_entityData.emplace(entity->GetId(), EntityData{}).first.value();
+		entityData.onActiveUpdate.Connect(weaponComponent.OnActiveUpdate, [this, entity](WeaponComponent* weapon)
+		{
+			if (weapon->IsActive())
+				m_activeWeapons.Insert(entity);
+			else
+				m_activeWeapons.Remove(entity);
+		});
+
+		if (weaponComponent.IsActive())
+			m_activeWeapons.Insert(entity);
+	}
+
+	void WeaponSystem::OnEntityRemoved(Ndk::Entity* entity)
+	{
+		m_activeWeapons.Remove(entity);
+		m_entityData.erase(entity->GetId());
+	}
+
 	void WeaponSystem::OnUpdate(float /*elapsedTime*/)
 	{
-		for (const Ndk::EntityHandle& weapon : GetEntities())
+		for (const Ndk::EntityHandle& weapon : m_activeWeapons)
 		{
 			auto& weaponComponent = weapon->GetComponent<WeaponComponent>();
-			if (!weaponComponent.IsActive())
-				continue;
-
 			if (const Ndk::EntityHandle& owner = weaponComponent.GetOwner())
 			{
 				InputComponent& ownerInputs = owner->GetComponent<InputComponent>();
@@ -63,7 +83,10 @@ namespace bw
 					if (weaponCooldown.Trigger(m_match.GetCurrentTime()))
 					{
 						auto& weaponScript = weapon->GetComponent<ScriptComponent>();
+
+						m_attackingWeapon = weapon;
 						weaponScript.ExecuteCallback<ElementEvent::Attack>(weaponScript.GetTable());
+						m_attackingWeapon.Reset();
 
 						weaponComponent.SetAttacking(true);
 					}
@@ -71,7 +94,10 @@ namespace bw
 				else if (!inputs.isAttacking && weaponComponent.IsAttacking())
 				{
 					auto& weaponScript = weapon->GetComponent<ScriptComponent>();
+
+					m_attackingWeapon = weapon;
 					weaponScript.ExecuteCallback<ElementEvent::AttackFinish>(weaponScript.GetTable());
+					m_attackingWeapon.Reset();
 
 					weaponComponent.SetAttacking(false);
 				}
@@ -4,34 +4,261 @@
 
 #include <CoreLib/Terrain.hpp>
 #include <CoreLib/LayerIndex.hpp>
+#include <CoreLib/Match.hpp>
+#include <CoreLib/MatchClientSession.hpp>
+#include <CoreLib/MatchClientVisibility.hpp>
+#include <CoreLib/Player.hpp>
+#include <CoreLib/Systems/NetworkSyncSystem.hpp>
+#include <CoreLib/Utility/WorkerPool.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <algorithm>
 
 namespace bw
 {
 	Terrain::Terrain(Match& match, Map& map) :
-	m_map(map)
+	m_match(match),
+	m_map(map),
+	m_workerPool(nullptr),
+	m_nextHibernationCheck(0),
+	m_parallelPhysicsProfilerSection(match.GetTickProfiler().RegisterSection("layers/PhysicsSystem2D (parallel)"))
 	{
+		m_adjacentLayers.resize(m_map.GetLayerCount());
+		m_layerMessageHandlers.reserve(m_map.GetLayerCount());
 		m_layers.reserve(m_map.GetLayerCount());
 		for (LayerIndex layerIndex = 0; layerIndex < m_map.GetLayerCount(); ++layerIndex)
+		{
+			m_layerMessageHandlers.emplace_back(match.GetLogger());
 			m_layers.emplace_back(match, LayerIndex(layerIndex), m_map.GetLayer(layerIndex));
+		}
+	}
+
+	void Terrain::ActivateLayer(LayerIndex layerIndex)
+	{
+		TerrainLayer& layer = GetLayer(layerIndex);
+		layer.m_lastVisibleTick = m_match.GetCurrentTick();
+
+		if (layer.IsActive())
+			return;
+
+		Nz::UInt64 startTime = Nz::GetElapsedMicroseconds();
+
+		// Scripts may already have spawned entities in this layer, only create (and initialize) map ones
+		std::vector<Ndk::EntityHandle> mapEntities = layer.CreateMapEntities();
+
+		auto& entityStore = m_match.GetEntityStore();
+		for (const Ndk::EntityHandle& entity : mapEntities)
+		{
+			if (entity && !entityStore.InitializeEntity(entity))
+				entity->Kill();
+		}
+
+		layer.GetWorld().Refresh();
+		layer.CaptureInitialState();
+		layer.m_isActive = true;
+
+		bwLog(m_match.GetLogger(), LogLevel::Info, "layer #{0} activated ({1} entities) in {2:.2f} ms", layerIndex, mapEntities.size(), (Nz::GetElapsedMicroseconds() - startTime) / 1000.0);
 	}
 
 	void Terrain::Initialize()
 	{
+		// With lazy activation, only the first layer (where gamemodes usually look for spawnpoints) is instantiated right away
+		bool lazyActivation = m_match.GetSettings().lazyLayerActivation;
+
+		std::vector<TerrainLayer*> activeLayers;
 		for (TerrainLayer& layer : m_layers)
-			layer.InitializeEntities();
+		{
+			if (lazyActivation && layer.GetLayerIndex() != 0)
+				continue;
+
+			layer.ResetEntities();
+			layer.m_isActive = true;
+			activeLayers.push_back(&layer);
+		}
+
+		// Every entity has to exist before initializing them (as they may reference each other)
+		for (TerrainLayer* layer : activeLayers)
+			layer->InitializeEntities();
+
+		for (TerrainLayer* layer : activeLayers)
+			layer->CaptureInitialState();
+	}
+
+	void Terrain::PostLayerMessage(LayerIndex layerIndex, std::string name, ScriptMessageValue value)
+	{
+		assert(layerIndex < m_layers.size());
+
+		std::lock_guard<std::mutex> lock(m_layerMessageMutex);
+
+		auto& message = m_pendingLayerMessages.emplace_back();
+		message.layerIndex = layerIndex;
+		message.name = std::move(name);
+		message.value = std::move(value);
 	}
 
 	void Terrain::Reset()
 	{
+		// Layers whose initial state was captured are restored without running init scripts again
+		std::vector<TerrainLayer*> resetLayers;
 		for (TerrainLayer& layer : m_layers)
-			layer.ResetEntities();
+		{
+			// Inactive layers only hold entities spawned by scripts, their map entities wait for a player to see them
+			if (!layer.IsActive())
+			{
+				layer.ClearEntityPools();
+				layer.GetWorld().Clear();
+				continue;
+			}
+
+			if (!layer.RestoreInitialState())
+			{
+				layer.ResetEntities();
+				resetLayers.push_back(&layer);
+			}
+		}
+
+		// Every entity has to exist before initializing them (as they may reference each other)
+		for (TerrainLayer* layer : resetLayers)
+			layer->InitializeEntities();
+
+		for (TerrainLayer* layer : resetLayers)
+			layer->CaptureInitialState();
+
+		// Entities may have been moved back to their initial position, past hitboxes are irrelevant
+		for (TerrainLayer& layer : m_layers)
+			layer.GetHitboxHistory().Clear();
 
-		Initialize();
+		UpdateMovementSnapshots();
 	}
 
 	void Terrain::Update(float elapsedTime)
 	{
+		DispatchLayerMessages();
+		HibernateUnvisitedLayers();
+
+		if (!m_workerPool || m_layers.size() < 2)
+		{
+			for (TerrainLayer& layer : m_layers)
+				layer.TickUpdate(elapsedTime);
+
+			RecordHitboxes();
+			UpdateMovementSnapshots();
+			return;
+		}
+
+		// Entities changes are applied serially as they trigger match-wide signals (network, unique ids)
 		for (TerrainLayer& layer : m_layers)
+			layer.GetWorld().Refresh();
+
+		// Layers have their own physics world, step them concurrently
+		{
+			auto physicsScope = m_layers.front().GetMatch().GetTickProfiler().Profile(m_parallelPhysicsProfilerSection);
+			m_workerPool->ForEach(m_layers.size(), [&](std::size_t layerIndex)
+			{
+				m_layers[layerIndex].StepPhysics(elapsedTime);
+			});
+		}
+
+		// Sync point: remaining systems (scripts, movement, network) run one layer after another
+		for (TerrainLayer& layer : m_layers)
+		{
+			layer.EnablePhysicsUpdate(false);
 			layer.TickUpdate(elapsedTime);
+			layer.EnablePhysicsUpdate(true);
+		}
+
+		RecordHitboxes();
+		UpdateMovementSnapshots();
+	}
+
+	void Terrain::DispatchLayerMessages()
+	{
+		// Messages posted during a tick are received at the beginning of the next one, whatever order layers were updated in
+		{
+			std::lock_guard<std::mutex> lock(m_layerMessageMutex);
+			std::swap(m_dispatchedLayerMessages, m_pendingLayerMessages);
+		}
+
+		if (m_dispatchedLayerMessages.empty())
+			return;
+
+		Match& match = m_layers.front().GetMatch();
+		sol::state& state = match.GetEntityStore().GetScriptingContext()->GetLuaState();
+
+		std::lock_guard<std::recursive_mutex> scriptLock(match.GetScriptMutex());
+		for (const LayerMessage& message : m_dispatchedLayerMessages)
+			m_layerMessageHandlers[message.layerIndex].Call(message.name, message.value.ToLua(match, state));
+
+		m_dispatchedLayerMessages.clear();
+	}
+
+	void Terrain::HibernateLayer(TerrainLayer& layer)
+	{
+		Ndk::World& world = layer.GetWorld();
+		std::size_t entityCount = world.GetEntities().size();
+
+		// Like a terrain reset, entities leaving this way don't trigger their Destroyed event
+		m_match.m_isResetting = true;
+		layer.ClearEntityPools();
+		world.Clear();
+		m_match.m_isResetting = false;
+
+		layer.GetHitboxHistory().Clear();
+		layer.m_initialState.reset();
+		layer.m_isActive = false;
+
+		bwLog(m_match.GetLogger(), LogLevel::Info, "layer #{0} hibernated ({1} entities), nobody saw it for {2} s", layer.GetLayerIndex(), entityCount, m_match.GetSettings().layerHibernationDelay);
+	}
+
+	void Terrain::HibernateUnvisitedLayers()
+	{
+		const auto& settings = m_match.GetSettings();
+		if (!settings.lazyLayerActivation || settings.layerHibernationDelay <= 0.f)
+			return;
+
+		// No need to go through every player visibility each tick
+		Nz::UInt64 currentTick = m_match.GetCurrentTick();
+		if (currentTick < m_nextHibernationCheck)
+			return;
+
+		m_nextHibernationCheck = currentTick + std::max<Nz::UInt64>(static_cast<Nz::UInt64>(1.f / m_match.GetTickDuration()), 1);
+
+		m_match.ForEachPlayer([&](Player* player)
+		{
+			MatchClientVisibility& visibility = player->GetSession().GetVisibility();
+			for (TerrainLayer& layer : m_layers)
+			{
+				LayerIndex layerIndex = layer.GetLayerIndex();
+				if (layer.IsActive() && (visibility.IsLayerVisible(layerIndex) || player->GetLayerIndex() == layerIndex))
+					layer.m_lastVisibleTick = currentTick;
+			}
+		}, false);
+
+		Nz::UInt64 hibernationTickCount = static_cast<Nz::UInt64>(settings.layerHibernationDelay / m_match.GetTickDuration());
+		for (TerrainLayer& layer : m_layers)
+		{
+			// First layer is never hibernated, as it was not lazily activated
+			if (!layer.IsActive() || layer.GetLayerIndex() == 0)
+				continue;
+
+			if (currentTick - layer.m_lastVisibleTick >= hibernationTickCount)
+				HibernateLayer(layer);
+		}
+	}
+
+	void Terrain::RecordHitboxes()
+	{
+		if (m_layers.empty())
+			return;
+
+		Nz::UInt16 networkTick = m_layers.front().GetMatch().GetNetworkTick();
+		for (TerrainLayer& layer : m_layers)
+			layer.GetHitboxHistory().Record(networkTick, layer.GetWorld());
+	}
+
+	void Terrain::UpdateMovementSnapshots()
+	{
+		// Built once per tick and read by every session visibility
+		for (TerrainLayer& layer : m_layers)
+			layer.GetWorld().GetSystem<NetworkSyncSystem>().UpdateMovementSnapshot();
 	}
 }
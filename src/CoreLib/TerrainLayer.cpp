@@ -4,26 +4,194 @@
 
 #include <CoreLib/TerrainLayer.hpp>
 #include <CoreLib/Match.hpp>
+#include <CoreLib/Components/EntityOwnerComponent.hpp>
+#include <CoreLib/Components/HealthComponent.hpp>
+#include <CoreLib/Components/MatchComponent.hpp>
 #include <CoreLib/Components/NetworkSyncComponent.hpp>
+#include <CoreLib/Components/OwnerComponent.hpp>
 #include <CoreLib/Components/PlayerControlledComponent.hpp>
 #include <CoreLib/Components/PlayerMovementComponent.hpp>
+#include <CoreLib/Components/PoolableComponent.hpp>
+#include <CoreLib/Components/WeaponComponent.hpp>
+#include <CoreLib/Components/WeaponWielderComponent.hpp>
+#include <CoreLib/Utils.hpp>
+#include <CoreLib/Scripting/ServerGamemode.hpp>
 #include <CoreLib/Systems/AnimationSystem.hpp>
 #include <CoreLib/Systems/NetworkSyncSystem.hpp>
 #include <CoreLib/Systems/PlayerMovementSystem.hpp>
 #include <Nazara/Physics2D/Arbiter2D.hpp>
 #include <NDK/Components.hpp>
 #include <NDK/Systems.hpp>
+#include <algorithm>
+#include <cmath>
 
 namespace bw
 {
+	namespace
+	{
+		// Layers with at least that many entities and less than that area (in pixels) per entity are considered dense
+		constexpr std::size_t DenseLayerMinEntityCount = 128;
+		constexpr float DenseLayerMaxAreaPerEntity = 256.f * 256.f;
+
+		template<PropertyType P>
+		std::optional<PropertyUnderlyingType_t<P>> GetGamemodeProperty(Match& match, const std::string& propertyName)
+		{
+			const auto& gamemode = match.GetGamemode();
+			if (!gamemode)
+				return std::nullopt;
+
+			auto propertyOpt = gamemode->GetProperty(propertyName);
+			if (!propertyOpt)
+				return std::nullopt;
+
+			const auto* propertyValue = std::get_if<PropertySingleValue<P>>(&propertyOpt->get());
+			if (!propertyValue)
+			{
+				bwLog(match.GetLogger(), LogLevel::Warning, "gamemode property {0} is not a {1}, ignoring it", propertyName, ToString(P));
+				return std::nullopt;
+			}
+
+			return **propertyValue;
+		}
+
+		SharedLayer::PhysicsSettings BuildPhysicsSettings(Match& match, LayerIndex layerIndex, const Map::Layer& layerData)
+		{
+			SharedLayer::PhysicsSettings settings;
+
+			// Automatic settings: a spatial hash and aggressive sleeping pay off when lots of bodies are packed together
+			std::size_t entityCount = layerData.entities.size();
+			if (entityCount >= DenseLayerMinEntityCount)
+			{
+				Nz::Vector2f minPos = layerData.entities.front().position;
+				Nz::Vector2f maxPos = minPos;
+				for (const Map::Entity& entity : layerData.entities)
+				{
+					minPos.Minimize(entity.position);
+					maxPos.Maximize(entity.position);
+				}
+
+				Nz::Vector2f size = maxPos - minPos;
+				float area = std::max(size.x, 1.f) * std::max(size.y, 1.f);
+				if (area / entityCount <= DenseLayerMaxAreaPerEntity)
+				{
+					settings.sleepTime = 0.5f;
+					settings.spatialHashCellSize = 128.f;
+				}
+			}
+
+			// Gamemode properties (negative values mean automatic)
+			if (auto iterationCount = GetGamemodeProperty<PropertyType::Integer>(match, "physicsiterations"); iterationCount && *iterationCount >= 0)
+				settings.iterationCount = static_cast<Nz::UInt32>(*iterationCount);
+
+			if (auto sleepTime = GetGamemodeProperty<PropertyType::Float>(match, "physicssleeptime"); sleepTime && *sleepTime >= 0.f)
+				settings.sleepTime = *sleepTime;
+
+			if (auto cellSize = GetGamemodeProperty<PropertyType::Float>(match, "physicshashcellsize"); cellSize && *cellSize >= 0.f)
+				settings.spatialHashCellSize = *cellSize;
+
+			// Map settings
+			const Map::LayerPhysics& layerPhysics = layerData.physics;
+			if (layerPhysics.iterationCount)
+				settings.iterationCount = *layerPhysics.iterationCount;
+
+			if (layerPhysics.sleepTime)
+				settings.sleepTime = *layerPhysics.sleepTime;
+
+			if (layerPhysics.spatialHashCellSize)
+				settings.spatialHashCellSize = *layerPhysics.spatialHashCellSize;
+
+			// Chipmunk advises a hash table about ten times bigger than the object count
+			if (settings.spatialHashCellSize > 0.f)
+				settings.spatialHashEntityCount = static_cast<Nz::UInt32>(std::max<std::size_t>(entityCount * 10, 1000));
+
+			bwLog(match.GetLogger(), LogLevel::Debug, "layer #{0} physics: {1} iteration(s), sleep time: {2}s, spatial hash cell size: {3}", layerIndex, settings.iterationCount, settings.sleepTime, settings.spatialHashCellSize);
+
+			return settings;
+		}
+	}
+
 	TerrainLayer::TerrainLayer(Match& match, LayerIndex layerIndex, const Map::Layer& layerData) :
 	SharedLayer(match, layerIndex),
-	m_mapLayer(layerData)
+	m_mapLayer(layerData),
+	m_hitboxHistory(static_cast<std::size_t>(std::ceil(match.GetSettings().lagCompensationDuration / match.GetMinTickDuration()))),
+	m_lastVisibleTick(0),
+	m_isActive(false)
 	{
+		ConfigurePhysics(BuildPhysicsSettings(match, layerIndex, layerData));
+
 		Ndk::World& world = GetWorld();
 		world.AddSystem<NetworkSyncSystem>(*this);
+	}
 
-		ResetEntities();
+	void TerrainLayer::CaptureCheckpoint(MatchCheckpoint::Layer& layerCheckpoint)
+	{
+		Match& match = GetMatch();
+
+		layerCheckpoint.isActive = m_isActive;
+		layerCheckpoint.entities.clear();
+
+		for (const Ndk::EntityHandle& entity : GetWorld().GetEntities())
+		{
+			if (!entity->HasComponent<MatchComponent>() || !entity->HasComponent<ScriptComponent>() || IsEntityRecycled(entity->GetId()))
+				continue;
+
+			// Weapons are given back to their wielder, other children are expected to be created again by their parent
+			auto& entityNode = entity->GetComponent<Ndk::NodeComponent>();
+			if (entityNode.GetParent() || entity->HasComponent<WeaponComponent>())
+				continue;
+
+			auto& entityScript = entity->GetComponent<ScriptComponent>();
+			std::shared_ptr<const ScriptedEntity> element = std::static_pointer_cast<const ScriptedEntity>(entityScript.GetElement());
+
+			MatchCheckpoint::Entity& entityData = layerCheckpoint.entities.emplace_back();
+			entityData.entityClass = element->fullName;
+			entityData.uniqueId = entity->GetComponent<MatchComponent>().GetUniqueId();
+			entityData.position = Nz::Vector2f(entityNode.GetPosition(Nz::CoordSys_Local));
+			entityData.rotation = AngleFromQuaternion(entityNode.GetRotation(Nz::CoordSys_Local));
+			entityData.scale = entityNode.GetScale(Nz::CoordSys_Local);
+			entityData.timeBeforeTick = entityScript.GetTimeBeforeTick();
+
+			const ScriptedPropertyValues& propertyValues = entityScript.GetProperties();
+			for (auto&& [propertyName, property] : element->properties)
+			{
+				if (property.index < propertyValues.size() && propertyValues[property.index])
+					entityData.properties.emplace(propertyName, propertyValues[property.index].value());
+			}
+
+			if (element->checkpoint)
+				entityData.scriptState = ScriptMessageValue::FromLuaFields(match, entityScript.GetTable());
+
+			if (entity->HasComponent<HealthComponent>())
+				entityData.health = entity->GetComponent<HealthComponent>().GetHealth();
+
+			if (entity->HasComponent<Ndk::PhysicsComponent2D>())
+			{
+				auto& entityPhys = entity->GetComponent<Ndk::PhysicsComponent2D>();
+
+				auto& physics = entityData.physics.emplace();
+				physics.angularVelocity = entityPhys.GetAngularVelocity();
+				physics.isSleeping = entityPhys.IsSleeping();
+				physics.linearVelocity = entityPhys.GetVelocity();
+				physics.mass = entityPhys.GetMass();
+				physics.momentOfInertia = entityPhys.GetMomentOfInertia();
+				physics.position = entityPhys.GetPosition();
+				physics.rotation = entityPhys.GetRotation();
+			}
+
+			if (entity->HasComponent<WeaponWielderComponent>())
+			{
+				auto& weaponWielder = entity->GetComponent<WeaponWielderComponent>();
+				for (const Ndk::EntityOwner& weapon : weaponWielder.GetWeapons())
+				{
+					auto& weaponData = entityData.weapons.emplace_back();
+					weaponData.weaponClass = weapon->GetComponent<ScriptComponent>().GetElement()->fullName;
+					weaponData.uniqueId = weapon->GetComponent<MatchComponent>().GetUniqueId();
+				}
+
+				if (std::size_t selectedWeapon = weaponWielder.GetSelectedWeapon(); selectedWeapon != WeaponWielderComponent::NoWeapon)
+					entityData.selectedWeapon = static_cast<Nz::UInt32>(selectedWeapon);
+			}
+		}
 	}
 
 	Match& TerrainLayer::GetMatch()
@@ -31,13 +199,313 @@ namespace bw
 		return static_cast<Match&>(SharedLayer::GetMatch());
 	}
 
+	bool TerrainLayer::RecycleEntity(const Ndk::EntityHandle& entity)
+	{
+		if (m_recycledEntities.find(entity->GetId()) != m_recycledEntities.end())
+			return true; //< Already recycled this tick
+
+		// Entities owning others would not kill them, keep their regular lifecycle
+		if (entity->HasComponent<EntityOwnerComponent>())
+			return false;
+
+		Match& match = GetMatch();
+
+		std::size_t elementIndex = entity->GetComponent<PoolableComponent>().GetElementIndex();
+		const auto& element = match.GetEntityStore().GetElement(elementIndex);
+
+		auto poolIt = m_entityPools.find(elementIndex);
+		if (poolIt != m_entityPools.end() && poolIt->second.size() >= element->poolSize)
+			return false;
+
+		m_recycledEntities.insert(entity->GetId());
+
+		// From the scripts point of view, the entity is destroyed
+		auto& entityScript = entity->GetComponent<ScriptComponent>();
+		entityScript.ExecuteCallback<ElementEvent::Destroyed>();
+
+		match.UnregisterEntity(entity->GetComponent<MatchComponent>().GetUniqueId());
+
+		if (entity->HasComponent<OwnerComponent>())
+			entity->RemoveComponent<OwnerComponent>();
+
+		entity->Disable();
+
+		// Callback may have recycled other entities
+		m_entityPools[elementIndex].push_back({ entity, match.GetCurrentTick() });
+
+		return true;
+	}
+
 	void TerrainLayer::ResetEntities()
+	{
+		ClearEntityPools();
+
+		Ndk::World& world = GetWorld();
+		world.Clear();
+
+		CreateMapEntities();
+	}
+
+	const Ndk::EntityHandle& TerrainLayer::RespawnEntity(std::size_t elementIndex, EntityId uniqueId, const Nz::Vector2f& position, const Nz::DegreeAnglef& rotation, PropertyValueMap properties)
+	{
+		auto poolIt = m_entityPools.find(elementIndex);
+		if (poolIt == m_entityPools.end())
+			return Ndk::EntityHandle::InvalidHandle;
+
+		std::vector<PooledEntity>& pool = poolIt.value();
+
+		// Pooled entities may have been killed by something else in the meantime
+		pool.erase(std::remove_if(pool.begin(), pool.end(), [](const PooledEntity& pooledEntity) { return !pooledEntity.entity; }), pool.end());
+
+		if (pool.empty() || GetMatch().GetCurrentTick() < pool.front().recycleTick + RespawnTickDelay)
+			return Ndk::EntityHandle::InvalidHandle;
+
+		Ndk::EntityId entityId = pool.front().entity->GetId();
+		pool.erase(pool.begin());
+
+		m_recycledEntities.erase(entityId);
+
+		const Ndk::EntityHandle& entity = GetWorld().GetEntity(entityId);
+		entity->GetComponent<MatchComponent>().UpdateUniqueId(uniqueId);
+		entity->GetComponent<PoolableComponent>().MarkAsRespawned();
+		entity->GetComponent<ScriptComponent>().UpdateProperties(std::move(properties));
+
+		auto& entityNode = entity->GetComponent<Ndk::NodeComponent>();
+		entityNode.SetPosition(position);
+		entityNode.SetRotation(rotation);
+
+		if (entity->HasComponent<Ndk::PhysicsComponent2D>())
+		{
+			auto& entityPhys = entity->GetComponent<Ndk::PhysicsComponent2D>();
+			entityPhys.SetPosition(position);
+			entityPhys.SetRotation(rotation);
+			entityPhys.SetAngularVelocity(Nz::RadianAnglef::Zero());
+			entityPhys.SetVelocity(Nz::Vector2f::Zero());
+		}
+
+		if (entity->HasComponent<HealthComponent>())
+		{
+			auto& entityHealth = entity->GetComponent<HealthComponent>();
+			entityHealth.RestoreHealth(entityHealth.GetMaxHealth());
+		}
+
+		entity->Enable();
+
+		return entity;
+	}
+
+	void TerrainLayer::RestoreCheckpoint(const MatchCheckpoint::Layer& layerCheckpoint)
 	{
 		Match& match = GetMatch();
-		
 		Ndk::World& world = GetWorld();
+
+		// The initial state is kept, map entities are still matched by their unique id on reset
+		ClearEntityPools();
 		world.Clear();
 
+		m_isActive = layerCheckpoint.isActive;
+
+		auto& entityStore = match.GetEntityStore();
+
+		std::vector<std::pair<Ndk::EntityHandle, const MatchCheckpoint::Entity*>> restoredEntities;
+		for (const MatchCheckpoint::Entity& entityData : layerCheckpoint.entities)
+		{
+			std::size_t entityTypeIndex = entityStore.GetElementIndex(entityData.entityClass);
+			if (entityTypeIndex == entityStore.InvalidIndex)
+			{
+				bwLog(match.GetLogger(), LogLevel::Error, "Unknown entity type {0}", entityData.entityClass);
+				continue;
+			}
+
+			try
+			{
+				const Ndk::EntityHandle& entity = entityStore.CreateEntity(*this, entityTypeIndex, entityData.uniqueId, entityData.position, Nz::DegreeAnglef(entityData.rotation), entityData.properties);
+				if (entity)
+				{
+					match.RegisterEntity(entityData.uniqueId, entity);
+					restoredEntities.emplace_back(entity, &entityData);
+				}
+			}
+			catch (const std::exception& e)
+			{
+				bwLog(match.GetLogger(), LogLevel::Error, "Failed to instantiate entity {0}: {1}", entityData.entityClass, e.what());
+			}
+		}
+
+		for (const auto& restoredEntity : restoredEntities)
+		{
+			if (!entityStore.InitializeEntity(restoredEntity.first))
+				restoredEntity.first->Kill();
+		}
+
+		world.Refresh();
+
+		// Every entity exists at this point, so script state can reference any of them
+		auto& weaponStore = match.GetWeaponStore();
+		for (const auto& restoredEntity : restoredEntities)
+		{
+			const Ndk::EntityHandle& entity = restoredEntity.first;
+			if (!entity)
+				continue;
+
+			const MatchCheckpoint::Entity* entityData = restoredEntity.second;
+
+			auto& entityNode = entity->GetComponent<Ndk::NodeComponent>();
+			entityNode.SetScale(entityData->scale, Nz::CoordSys_Local);
+
+			if (entityData->health && entity->HasComponent<HealthComponent>())
+				entity->GetComponent<HealthComponent>().RestoreHealth(entityData->health.value());
+
+			if (entityData->physics && entity->HasComponent<Ndk::PhysicsComponent2D>())
+			{
+				const MatchCheckpoint::Physics& physics = entityData->physics.value();
+
+				auto& entityPhys = entity->GetComponent<Ndk::PhysicsComponent2D>();
+				entityPhys.SetMass(physics.mass, false);
+				entityPhys.SetMomentOfInertia(physics.momentOfInertia);
+				entityPhys.SetPosition(physics.position);
+				entityPhys.SetRotation(physics.rotation);
+				entityPhys.SetAngularVelocity(physics.angularVelocity);
+				entityPhys.SetVelocity(physics.linearVelocity);
+
+				if (physics.isSleeping)
+					entityPhys.ForceSleep();
+			}
+
+			auto& entityScript = entity->GetComponent<ScriptComponent>();
+			if (entityData->scriptState)
+			{
+				sol::state_view lua(entityScript.GetTable().lua_state());
+
+				sol::table fields = entityData->scriptState->ToLua(match, lua).as<sol::table>();
+				for (auto&& [key, value] : fields)
+					entityScript.GetTable().raw_set(key, value);
+			}
+
+			if (entityData->timeBeforeTick > 0.f)
+				entityScript.SetNextTick(entityData->timeBeforeTick);
+
+			if (!entityData->weapons.empty() && entity->HasComponent<WeaponWielderComponent>())
+			{
+				auto& weaponWielder = entity->GetComponent<WeaponWielderComponent>();
+				for (const MatchCheckpoint::Weapon& weaponData : entityData->weapons)
+				{
+					weaponWielder.GiveWeapon(weaponData.weaponClass, [&](const std::string& weaponClass) -> Ndk::EntityHandle
+					{
+						std::size_t weaponIndex = weaponStore.GetElementIndex(weaponClass);
+						if (weaponIndex == ServerWeaponStore::InvalidIndex)
+							return Ndk::EntityHandle::InvalidHandle;
+
+						const Ndk::EntityHandle& weapon = weaponStore.InstantiateWeapon(*this, weaponIndex, weaponData.uniqueId, {}, entity);
+						if (!weapon)
+							return Ndk::EntityHandle::InvalidHandle;
+
+						match.RegisterEntity(weaponData.uniqueId, weapon);
+						return weapon;
+					});
+				}
+
+				if (entityData->selectedWeapon && *entityData->selectedWeapon < weaponWielder.GetWeaponCount())
+					weaponWielder.SelectWeapon(*entityData->selectedWeapon);
+			}
+		}
+
+		bwLog(match.GetLogger(), LogLevel::Debug, "layer #{0}: restored {1} entities from checkpoint", GetLayerIndex(), restoredEntities.size());
+	}
+
+	void TerrainLayer::CaptureInitialState()
+	{
+		m_initialState.reset();
+
+		Match& match = GetMatch();
+		if (!match.GetSettings().fastTerrainReset)
+			return;
+
+		Ndk::World& world = GetWorld();
+		world.Refresh();
+
+		InitialState initialState;
+		std::size_t mapEntityCount = 0;
+		for (std::size_t i = 0; i < m_mapLayer.entities.size(); ++i)
+		{
+			const Ndk::EntityHandle& entity = match.RetrieveEntityByUniqueId(m_mapLayer.entities[i].uniqueId);
+			if (!entity || entity->GetWorld() != &world)
+				continue; //< Failed to instantiate, a full reset would fail as well
+
+			mapEntityCount++;
+
+			EntitySnapshot& snapshot = initialState.entities.emplace_back();
+			snapshot.mapEntityIndex = i;
+			if (!CaptureEntity(entity, snapshot))
+			{
+				initialState.entities.pop_back();
+				initialState.recreatedEntities.push_back(i);
+			}
+		}
+
+		// Entities spawned by init scripts cannot be matched again on reset
+		if (world.GetEntities().size() != mapEntityCount)
+		{
+			bwLog(match.GetLogger(), LogLevel::Info, "layer #{0}: {1} entities were spawned during initialization, fast reset is disabled for this layer", GetLayerIndex(), world.GetEntities().size() - mapEntityCount);
+			return;
+		}
+
+		bwLog(match.GetLogger(), LogLevel::Debug, "layer #{0}: captured initial state of {1} entities ({2} will be recreated on reset)", GetLayerIndex(), initialState.entities.size(), initialState.recreatedEntities.size());
+
+		m_initialState = std::move(initialState);
+	}
+
+	bool TerrainLayer::CaptureEntity(const Ndk::EntityHandle& entity, EntitySnapshot& snapshot) const
+	{
+		if (!entity->HasComponent<ScriptComponent>())
+			return false;
+
+		std::optional<ScriptComponent::State> scriptState = entity->GetComponent<ScriptComponent>().CaptureState();
+		if (!scriptState)
+			return false;
+
+		snapshot.scriptState = std::move(scriptState.value());
+		snapshot.componentBits = entity->GetComponentBits();
+
+		auto& entityNode = entity->GetComponent<Ndk::NodeComponent>();
+		snapshot.position = entityNode.GetPosition(Nz::CoordSys_Local);
+		snapshot.rotation = entityNode.GetRotation(Nz::CoordSys_Local);
+		snapshot.scale = entityNode.GetScale(Nz::CoordSys_Local);
+
+		if (entity->HasComponent<HealthComponent>())
+			snapshot.health = entity->GetComponent<HealthComponent>().GetHealth();
+
+		if (entity->HasComponent<Ndk::PhysicsComponent2D>())
+		{
+			auto& entityPhys = entity->GetComponent<Ndk::PhysicsComponent2D>();
+
+			auto& physics = snapshot.physics.emplace();
+			physics.angularVelocity = entityPhys.GetAngularVelocity();
+			physics.isSleeping = entityPhys.IsSleeping();
+			physics.linearVelocity = entityPhys.GetVelocity();
+			physics.mass = entityPhys.GetMass();
+			physics.momentOfInertia = entityPhys.GetMomentOfInertia();
+			physics.position = entityPhys.GetPosition();
+			physics.rotation = entityPhys.GetRotation();
+		}
+
+		return true;
+	}
+
+	void TerrainLayer::ClearEntityPools()
+	{
+		// Pooled entities are killed along the other ones
+		m_entityPools.clear();
+		m_recycledEntities.clear();
+	}
+
+	std::vector<Ndk::EntityHandle> TerrainLayer::CreateMapEntities()
+	{
+		Match& match = GetMatch();
+
+		std::vector<Ndk::EntityHandle> entities;
+		entities.reserve(m_mapLayer.entities.size());
+
 		auto& entityStore = match.GetEntityStore();
 		for (const Map::Entity& entityData : m_mapLayer.entities)
 		{
@@ -52,13 +520,18 @@ namespace bw
 			{
 				const Ndk::EntityHandle& entity = entityStore.CreateEntity(*this, entityTypeIndex, entityData.uniqueId, entityData.position, entityData.rotation, entityData.properties);
 				if (entity)
+				{
 					match.RegisterEntity(entityData.uniqueId, entity);
+					entities.push_back(entity);
+				}
 			}
 			catch (const std::exception& e)
 			{
 				bwLog(match.GetLogger(), LogLevel::Error, "Failed to instantiate entity {0}: {1}", entityData.entityType, e.what());
 			}
 		}
+
+		return entities;
 	}
 
 	void TerrainLayer::InitializeEntities()
@@ -73,4 +546,113 @@ namespace bw
 		Ndk::World& world = GetWorld();
 		world.Refresh();
 	}
+
+	bool TerrainLayer::RestoreEntity(const Ndk::EntityHandle& entity, const EntitySnapshot& snapshot) const
+	{
+		// Components added or removed by scripts cannot be restored
+		if (entity->GetComponentBits() != snapshot.componentBits)
+			return false;
+
+		entity->GetComponent<ScriptComponent>().RestoreState(snapshot.scriptState);
+
+		auto& entityNode = entity->GetComponent<Ndk::NodeComponent>();
+		entityNode.SetPosition(snapshot.position, Nz::CoordSys_Local);
+		entityNode.SetRotation(snapshot.rotation, Nz::CoordSys_Local);
+		entityNode.SetScale(snapshot.scale, Nz::CoordSys_Local);
+
+		if (snapshot.health)
+			entity->GetComponent<HealthComponent>().RestoreHealth(snapshot.health.value());
+
+		if (snapshot.physics)
+		{
+			const PhysicsSnapshot& physics = snapshot.physics.value();
+
+			auto& entityPhys = entity->GetComponent<Ndk::PhysicsComponent2D>();
+			entityPhys.SetMass(physics.mass, false);
+			entityPhys.SetMomentOfInertia(physics.momentOfInertia);
+			entityPhys.SetPosition(physics.position);
+			entityPhys.SetRotation(physics.rotation);
+			entityPhys.SetAngularVelocity(physics.angularVelocity);
+			entityPhys.SetVelocity(physics.linearVelocity);
+
+			if (physics.isSleeping)
+				entityPhys.ForceSleep();
+		}
+
+		return true;
+	}
+
+	bool TerrainLayer::RestoreInitialState()
+	{
+		if (!m_initialState)
+			return false;
+
+		Match& match = GetMatch();
+		Ndk::World& world = GetWorld();
+
+		ClearEntityPools();
+
+		// Process pending kills, so we don't try to restore dying entities
+		world.Refresh();
+
+		tsl::hopscotch_set<Ndk::EntityId> restoredEntities;
+		std::vector<std::size_t> missingEntities = m_initialState->recreatedEntities;
+
+		for (const EntitySnapshot& snapshot : m_initialState->entities)
+		{
+			const Ndk::EntityHandle& entity = match.RetrieveEntityByUniqueId(m_mapLayer.entities[snapshot.mapEntityIndex].uniqueId);
+			if (entity && entity->GetWorld() == &world && RestoreEntity(entity, snapshot))
+				restoredEntities.insert(entity->GetId());
+			else
+				missingEntities.push_back(snapshot.mapEntityIndex);
+		}
+
+		// Remove everything else (entities spawned during the round and map entities which couldn't be restored)
+		for (const Ndk::EntityHandle& entity : world.GetEntities())
+		{
+			if (restoredEntities.find(entity->GetId()) == restoredEntities.end())
+				entity->Kill();
+		}
+
+		world.Refresh();
+
+		// Recreate missing map entities through the regular path
+		auto& entityStore = match.GetEntityStore();
+
+		std::vector<Ndk::EntityHandle> recreatedEntities;
+		for (std::size_t mapEntityIndex : missingEntities)
+		{
+			const Map::Entity& entityData = m_mapLayer.entities[mapEntityIndex];
+
+			std::size_t entityTypeIndex = entityStore.GetElementIndex(entityData.entityType);
+			if (entityTypeIndex == entityStore.InvalidIndex)
+				continue;
+
+			try
+			{
+				const Ndk::EntityHandle& entity = entityStore.CreateEntity(*this, entityTypeIndex, entityData.uniqueId, entityData.position, entityData.rotation, entityData.properties);
+				if (entity)
+				{
+					match.RegisterEntity(entityData.uniqueId, entity);
+					recreatedEntities.push_back(entity);
+				}
+			}
+			catch (const std::exception& e)
+			{
+				bwLog(match.GetLogger(), LogLevel::Error, "Failed to instantiate entity {0}: {1}", entityData.entityType, e.what());
+			}
+		}
+
+		for (const Ndk::EntityHandle& entity : recreatedEntities)
+		{
+			if (!entityStore.InitializeEntity(entity))
+				entity->Kill();
+		}
+
+		world.Refresh();
+
+		bwLog(match.GetLogger(), LogLevel::Debug, "layer #{0}: restored {1} entities, recreated {2}", GetLayerIndex(), restoredEntities.size(), recreatedEntities.size());
+
+		return true;
+	}
 }
@@ -0,0 +1,164 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/TickProfiler.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <cassert>
+
+namespace bw
+{
+	TickProfiler::TickProfiler(std::size_t maxSampleCount) :
+	m_maxSampleCount(maxSampleCount),
+	m_nextSampleIndex(0),
+	m_sampleCount(0),
+	m_isEnabled(false)
+	{
+		assert(m_maxSampleCount > 0);
+	}
+
+	void TickProfiler::EndTick()
+	{
+		if (!m_isEnabled)
+			return;
+
+		for (Section& section : m_sections)
+		{
+			section.samples[m_nextSampleIndex] = section.tickDuration;
+			section.tickDuration = 0;
+		}
+
+		m_nextSampleIndex = (m_nextSampleIndex + 1) % m_maxSampleCount;
+		m_sampleCount = std::min(m_sampleCount + 1, m_maxSampleCount);
+	}
+
+	void TickProfiler::ExportSamples(std::ostream& stream, std::size_t sampleCount) const
+	{
+		sampleCount = std::min(sampleCount, m_sampleCount);
+
+		// One line per sample (from the oldest to the most recent), one column per section, in microseconds
+		stream << "sample";
+		for (const Section& section : m_sections)
+			stream << ',' << section.name;
+
+		stream << '\n';
+
+		for (std::size_t i = m_sampleCount - sampleCount; i < m_sampleCount; ++i)
+		{
+			stream << i;
+			for (std::size_t sectionIndex = 0; sectionIndex < m_sections.size(); ++sectionIndex)
+				stream << ',' << GetSample(sectionIndex, i);
+
+			stream << '\n';
+		}
+	}
+
+	std::string TickProfiler::Format(std::string_view title, std::string_view sampleName) const
+	{
+		if (m_sampleCount == 0)
+			return fmt::format("{0}: no sample", title);
+
+		std::string output = fmt::format("{0} (last {1} {2}, in ms)\n", title, m_sampleCount, sampleName);
+
+		std::size_t nameWidth = 0;
+		for (const Section& section : m_sections)
+			nameWidth = std::max(nameWidth, section.name.size());
+
+		for (const Section& section : m_sections)
+		{
+			Percentiles percentiles = ComputePercentiles(section);
+			output += fmt::format("  {0:<{1}}  avg {2:7.3f}  p50 {3:7.3f}  p95 {4:7.3f}  p99 {5:7.3f}  max {6:7.3f}\n", section.name, nameWidth, percentiles.average / 1000.0, percentiles.p50 / 1000.0, percentiles.p95 / 1000.0, percentiles.p99 / 1000.0, percentiles.max / 1000.0);
+		}
+
+		return output;
+	}
+
+	std::string TickProfiler::FormatSummary(std::size_t sectionCount) const
+	{
+		if (m_sampleCount == 0)
+			return "no sample";
+
+		std::vector<std::pair<Percentiles, const Section*>> sections;
+		sections.reserve(m_sections.size());
+		for (const Section& section : m_sections)
+			sections.emplace_back(ComputePercentiles(section), &section);
+
+		sectionCount = std::min(sectionCount, sections.size());
+		std::partial_sort(sections.begin(), sections.begin() + sectionCount, sections.end(), [](const auto& lhs, const auto& rhs)
+		{
+			return lhs.first.p99 > rhs.first.p99;
+		});
+
+		std::string output;
+		for (std::size_t i = 0; i < sectionCount; ++i)
+		{
+			const auto& [percentiles, section] = sections[i];
+			output += fmt::format("{0}{1} (p50 {2:.2f} ms, p99 {3:.2f} ms)", (i > 0) ? ", " : "", section->name, percentiles.p50 / 1000.0, percentiles.p99 / 1000.0);
+		}
+
+		return output;
+	}
+
+	Nz::UInt64 TickProfiler::GetSample(std::size_t sectionIndex, std::size_t sampleIndex) const
+	{
+		assert(sectionIndex < m_sections.size());
+		assert(sampleIndex < m_sampleCount);
+
+		// Sample index is relative to the oldest sample still stored
+		std::size_t firstIndex = (m_sampleCount == m_maxSampleCount) ? m_nextSampleIndex : 0;
+		return m_sections[sectionIndex].samples[(firstIndex + sampleIndex) % m_maxSampleCount];
+	}
+
+	std::size_t TickProfiler::RegisterSection(std::string name)
+	{
+		// Sections with the same name (same system in several layers) are merged
+		auto it = std::find_if(m_sections.begin(), m_sections.end(), [&](const Section& section) { return section.name == name; });
+		if (it != m_sections.end())
+			return std::distance(m_sections.begin(), it);
+
+		Section& section = m_sections.emplace_back();
+		section.name = std::move(name);
+		section.samples.resize(m_maxSampleCount, 0);
+
+		return m_sections.size() - 1;
+	}
+
+	void TickProfiler::Reset()
+	{
+		for (Section& section : m_sections)
+		{
+			std::fill(section.samples.begin(), section.samples.end(), 0);
+			section.tickDuration = 0;
+		}
+
+		m_nextSampleIndex = 0;
+		m_sampleCount = 0;
+	}
+
+	auto TickProfiler::ComputePercentiles(const Section& section) const -> Percentiles
+	{
+		// Samples are stored in a ring, only the first m_sampleCount are valid until it is full
+		std::vector<Nz::UInt64> samples(section.samples.begin(), section.samples.begin() + m_sampleCount);
+		std::sort(samples.begin(), samples.end());
+
+		auto Percentile = [&](double percentile)
+		{
+			std::size_t index = static_cast<std::size_t>(percentile * (samples.size() - 1) + 0.5);
+			return samples[index];
+		};
+
+		Nz::UInt64 sum = 0;
+		for (Nz::UInt64 sample : samples)
+			sum += sample;
+
+		Percentiles percentiles;
+		percentiles.average = double(sum) / samples.size();
+		percentiles.max = samples.back();
+		percentiles.p50 = Percentile(0.50);
+		percentiles.p95 = Percentile(0.95);
+		percentiles.p99 = Percentile(0.99);
+
+		return percentiles;
+	}
+}
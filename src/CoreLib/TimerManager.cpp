@@ -0,0 +1,167 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/TimerManager.hpp>
+#include <algorithm>
+#include <cassert>
+
+namespace bw
+{
+	void TimerManager::Clear()
+	{
+		for (auto& wheel : m_wheels)
+			wheel.fill(Bucket{});
+
+		m_expiredTimers = Bucket{};
+		m_freeTimer = InvalidIndex;
+		m_pendingTimerCount = 0;
+		m_timers.clear();
+
+		m_clearCounter++; //< Lets Update know it must stop iterating if a callback cleared us
+	}
+
+	void TimerManager::PushCallback(Nz::UInt64 expirationTime, Callback callback)
+	{
+		std::size_t timerIndex = AllocateTimer();
+
+		Timer& timer = m_timers[timerIndex];
+		timer.callback = std::move(callback);
+		timer.expirationTime = expirationTime;
+
+		m_pendingTimerCount++;
+
+		LinkTimer(timerIndex);
+	}
+
+	void TimerManager::Update(Nz::UInt64 now)
+	{
+		constexpr Nz::UInt64 SlotMask = SlotCount - 1;
+
+		// Timers expire once now is strictly greater than their expiration time, process every millisecond up to now - 1
+		while (m_nextTime < now)
+		{
+			if (m_pendingTimerCount == 0)
+			{
+				m_nextTime = now;
+				break;
+			}
+
+			Nz::UInt64 time = m_nextTime;
+			std::size_t slot = static_cast<std::size_t>(time & SlotMask);
+
+			// Entering a new lap of the first wheel, bring down timers from upper wheels (upper first so they can fall through)
+			if (slot == 0)
+			{
+				std::size_t maxLevel = 1;
+				while (maxLevel + 1 < LevelCount && ((time >> (maxLevel * LevelBits)) & SlotMask) == 0)
+					maxLevel++;
+
+				for (std::size_t level = maxLevel; level > 0; --level)
+					Cascade(level, time);
+			}
+
+			Bucket dueBucket = m_wheels[0][slot];
+			m_wheels[0][slot] = Bucket{};
+
+			m_nextTime = time + 1;
+
+			if (!FireBucket(dueBucket))
+				return;
+		}
+
+		// Timers pushed with an already processed expiration time (including from callbacks) expire right away
+		while (m_expiredTimers.first != InvalidIndex)
+		{
+			Bucket expiredBucket = m_expiredTimers;
+			m_expiredTimers = Bucket{};
+
+			if (!FireBucket(expiredBucket))
+				return;
+		}
+	}
+
+	std::size_t TimerManager::AllocateTimer()
+	{
+		if (m_freeTimer != InvalidIndex)
+		{
+			std::size_t timerIndex = m_freeTimer;
+			m_freeTimer = m_timers[timerIndex].next;
+
+			return timerIndex;
+		}
+
+		m_timers.emplace_back();
+		return m_timers.size() - 1;
+	}
+
+	void TimerManager::Cascade(std::size_t level, Nz::UInt64 time)
+	{
+		assert(level > 0 && level < LevelCount);
+
+		Bucket& bucket = m_wheels[level][static_cast<std::size_t>((time >> (level * LevelBits)) & (SlotCount - 1))];
+		std::size_t timerIndex = bucket.first;
+		bucket = Bucket{};
+
+		while (timerIndex != InvalidIndex)
+		{
+			std::size_t nextIndex = m_timers[timerIndex].next;
+			LinkTimer(timerIndex);
+
+			timerIndex = nextIndex;
+		}
+	}
+
+	bool TimerManager::FireBucket(Bucket bucket)
+	{
+		std::size_t clearCounter = m_clearCounter;
+
+		std::size_t timerIndex = bucket.first;
+		while (timerIndex != InvalidIndex)
+		{
+			Timer& timer = m_timers[timerIndex];
+			std::size_t nextIndex = timer.next;
+
+			// Release the timer before calling it, as the callback may push new timers (and reallocate the pool)
+			Callback callback = std::move(timer.callback);
+			timer.callback = nullptr;
+			timer.next = m_freeTimer;
+			m_freeTimer = timerIndex;
+			m_pendingTimerCount--;
+
+			callback();
+
+			if (m_clearCounter != clearCounter)
+				return false;
+
+			timerIndex = nextIndex;
+		}
+
+		return true;
+	}
+
+	void TimerManager::LinkTimer(std::size_t timerIndex)
+	{
+		Nz::UInt64 expirationTime = m_timers[timerIndex].expirationTime;
+		if (expirationTime < m_nextTime)
+		{
+			PushBack(m_expiredTimers, timerIndex);
+			return;
+		}
+
+		Nz::UInt64 delta = expirationTime - m_nextTime;
+		for (std::size_t level = 0; level < LevelCount; ++level)
+		{
+			if (delta < (Nz::UInt64(1) << ((level + 1) * LevelBits)))
+			{
+				PushBack(m_wheels[level][static_cast<std::size_t>((expirationTime >> (level * LevelBits)) & (SlotCount - 1))], timerIndex);
+				return;
+			}
+		}
+
+		// Further than the wheels range (~4.6 hours), park it as far as possible, it will be linked again when cascaded
+		constexpr std::size_t TopLevel = LevelCount - 1;
+		Nz::UInt64 parkingTime = m_nextTime + ((Nz::UInt64(1) << (LevelCount * LevelBits)) - 1);
+		PushBack(m_wheels[TopLevel][static_cast<std::size_t>((parkingTime >> (TopLevel * LevelBits)) & (SlotCount - 1))], timerIndex);
+	}
+}
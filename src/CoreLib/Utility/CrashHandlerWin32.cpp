@@ -7,6 +7,7 @@
 #ifdef NAZARA_PLATFORM_WINDOWS
 
 #include <CoreLib/Utility/CrashHandlerWin32.hpp>
+#include <CoreLib/LogSystem/AsyncSink.hpp>
 #include <CoreLib/Version.hpp>
 #include <Nazara/Core/HardwareInfo.hpp>
 #include <array>
@@ -263,6 +264,9 @@ namespace bw
 			if (IsDebuggerPresent())
 				return EXCEPTION_CONTINUE_SEARCH;
 
+			// Last log lines are usually the most useful ones to understand a crash
+			AsyncSink::FlushAll();
+
 			const wchar_t* executableFilename;
 			std::array<wchar_t, MAX_PATH> executablePath;
 			auto FallbackToDefaultFilename = [&]()
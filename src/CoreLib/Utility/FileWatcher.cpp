@@ -0,0 +1,203 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/FileWatcher.hpp>
+
+#if defined(NAZARA_PLATFORM_WINDOWS)
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <Windows.h>
+#include <array>
+#elif defined(NAZARA_PLATFORM_LINUX)
+#include <tsl/hopscotch_map.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <array>
+#endif
+
+namespace bw
+{
+#if defined(NAZARA_PLATFORM_WINDOWS)
+	struct FileWatcher::PlatformData
+	{
+		bool ReadChanges()
+		{
+			constexpr DWORD notifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+
+			return ReadDirectoryChangesW(directoryHandle, buffer.data(), DWORD(buffer.size() * sizeof(DWORD)), TRUE, notifyFilter, nullptr, &overlapped, nullptr) != FALSE;
+		}
+
+		std::array<DWORD, 16 * 1024> buffer; //< FILE_NOTIFY_INFORMATION entries are DWORD-aligned
+		HANDLE directoryHandle = INVALID_HANDLE_VALUE;
+		OVERLAPPED overlapped = {};
+	};
+#elif defined(NAZARA_PLATFORM_LINUX)
+	struct FileWatcher::PlatformData
+	{
+		void WatchDirectory(const std::filesystem::path& rootDirectory, const std::filesystem::path& relativePath)
+		{
+			constexpr Nz::UInt32 watchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+			// inotify isn't recursive, every subdirectory needs its own watch (including those created later)
+			std::filesystem::path directoryPath = rootDirectory / relativePath;
+			int watchDescriptor = inotify_add_watch(fileDescriptor, directoryPath.c_str(), watchMask);
+			if (watchDescriptor == -1)
+				return;
+
+			watchedDirectories[watchDescriptor] = relativePath;
+
+			std::error_code ec;
+			for (const auto& entry : std::filesystem::directory_iterator(directoryPath, ec))
+			{
+				if (entry.is_directory(ec))
+					WatchDirectory(rootDirectory, relativePath / entry.path().filename());
+			}
+		}
+
+		tsl::hopscotch_map<int /*watchDescriptor*/, std::filesystem::path> watchedDirectories;
+		int fileDescriptor = -1;
+	};
+#else
+	struct FileWatcher::PlatformData
+	{
+	};
+#endif
+
+	FileWatcher::FileWatcher(std::filesystem::path directory) :
+	m_directory(std::move(directory))
+	{
+#if defined(NAZARA_PLATFORM_WINDOWS)
+		auto platformData = std::make_unique<PlatformData>();
+		platformData->directoryHandle = CreateFileW(m_directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (platformData->directoryHandle == INVALID_HANDLE_VALUE)
+			return;
+
+		if (!platformData->ReadChanges())
+		{
+			CloseHandle(platformData->directoryHandle);
+			return;
+		}
+
+		m_platformData = std::move(platformData);
+#elif defined(NAZARA_PLATFORM_LINUX)
+		auto platformData = std::make_unique<PlatformData>();
+		platformData->fileDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (platformData->fileDescriptor == -1)
+			return;
+
+		platformData->WatchDirectory(m_directory, {});
+		if (platformData->watchedDirectories.empty())
+		{
+			close(platformData->fileDescriptor);
+			return;
+		}
+
+		m_platformData = std::move(platformData);
+#endif
+	}
+
+	FileWatcher::~FileWatcher()
+	{
+		if (!m_platformData)
+			return;
+
+#if defined(NAZARA_PLATFORM_WINDOWS)
+		// The pending read writes into our buffer, wait for its cancellation before freeing it
+		DWORD byteCount;
+		CancelIoEx(m_platformData->directoryHandle, &m_platformData->overlapped);
+		GetOverlappedResult(m_platformData->directoryHandle, &m_platformData->overlapped, &byteCount, TRUE);
+
+		CloseHandle(m_platformData->directoryHandle);
+#elif defined(NAZARA_PLATFORM_LINUX)
+		close(m_platformData->fileDescriptor);
+#endif
+	}
+
+	void FileWatcher::Poll(std::vector<std::filesystem::path>& changedPaths)
+	{
+		if (!m_platformData)
+			return;
+
+#if defined(NAZARA_PLATFORM_WINDOWS)
+		DWORD byteCount;
+		if (!GetOverlappedResult(m_platformData->directoryHandle, &m_platformData->overlapped, &byteCount, FALSE))
+		{
+			if (GetLastError() == ERROR_IO_INCOMPLETE)
+				return;
+
+			// Read failed, report everything as changed and try again
+			changedPaths.emplace_back();
+		}
+		else if (byteCount == 0)
+			changedPaths.emplace_back(); //< buffer overflow, notifications were lost
+		else
+		{
+			const Nz::UInt8* notificationPtr = reinterpret_cast<const Nz::UInt8*>(m_platformData->buffer.data());
+			for (;;)
+			{
+				const FILE_NOTIFY_INFORMATION* notification = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(notificationPtr);
+				changedPaths.emplace_back(std::wstring(notification->FileName, notification->FileNameLength / sizeof(WCHAR)));
+
+				if (notification->NextEntryOffset == 0)
+					break;
+
+				notificationPtr += notification->NextEntryOffset;
+			}
+		}
+
+		if (!m_platformData->ReadChanges())
+		{
+			CloseHandle(m_platformData->directoryHandle);
+			m_platformData.reset();
+		}
+#elif defined(NAZARA_PLATFORM_LINUX)
+		alignas(inotify_event) std::array<char, 16 * 1024> buffer;
+
+		for (;;)
+		{
+			ssize_t readSize = read(m_platformData->fileDescriptor, buffer.data(), buffer.size());
+			if (readSize <= 0)
+				break; //< EAGAIN, no more events
+
+			for (ssize_t offset = 0; offset < readSize;)
+			{
+				const inotify_event* event = reinterpret_cast<const inotify_event*>(&buffer[offset]);
+				offset += sizeof(inotify_event) + event->len;
+
+				if (event->mask & IN_Q_OVERFLOW)
+				{
+					changedPaths.emplace_back();
+					continue;
+				}
+
+				auto it = m_platformData->watchedDirectories.find(event->wd);
+				if (it == m_platformData->watchedDirectories.end())
+					continue;
+
+				if (event->mask & IN_IGNORED)
+				{
+					m_platformData->watchedDirectories.erase(it);
+					continue;
+				}
+
+				if (event->len == 0)
+					continue;
+
+				std::filesystem::path relativePath = it->second / event->name;
+				if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+					m_platformData->WatchDirectory(m_directory, relativePath);
+
+				changedPaths.push_back(std::move(relativePath));
+			}
+		}
+#endif
+	}
+}
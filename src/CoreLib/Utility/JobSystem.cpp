@@ -0,0 +1,144 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/JobSystem.hpp>
+#include <cassert>
+
+namespace bw
+{
+	namespace
+	{
+		// Lets jobs dispatched from a worker go to its own queue
+		thread_local const JobSystem* s_currentJobSystem = nullptr;
+		thread_local std::size_t s_currentWorkerIndex = 0;
+	}
+
+	JobSystem::JobSystem(std::size_t workerCount) :
+	m_nextQueue(0),
+	m_pendingJobCount(0),
+	m_isStopping(false)
+	{
+		m_queues.reserve(workerCount);
+		for (std::size_t i = 0; i < workerCount; ++i)
+			m_queues.emplace_back(std::make_unique<WorkerQueue>());
+
+		m_workers.reserve(workerCount);
+		for (std::size_t i = 0; i < workerCount; ++i)
+			m_workers.emplace_back(&JobSystem::WorkerMain, this, i);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		// Jobs still queued are dropped, running ones are waited for
+		{
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_isStopping = true;
+		}
+		m_jobCondition.notify_all();
+
+		for (std::thread& worker : m_workers)
+			worker.join();
+	}
+
+	void JobSystem::Dispatch(Job job, JobPriority priority)
+	{
+		// Without workers, jobs run right away on the calling thread
+		if (m_workers.empty())
+		{
+			job();
+			return;
+		}
+
+		std::size_t queueIndex;
+		if (s_currentJobSystem == this)
+			queueIndex = s_currentWorkerIndex;
+		else
+			queueIndex = m_nextQueue++ % m_queues.size();
+
+		WorkerQueue& queue = *m_queues[queueIndex];
+		{
+			std::unique_lock<std::mutex> lock(queue.mutex);
+			queue.jobs[static_cast<std::size_t>(priority)].push_back(std::move(job));
+		}
+
+		{
+			// Incremented under the sleep mutex so a worker can't miss it between checking and waiting
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_pendingJobCount++;
+		}
+		m_jobCondition.notify_one();
+	}
+
+	void JobSystem::DispatchToMainThread(Job job)
+	{
+		m_mainThreadJobs.enqueue(std::move(job));
+	}
+
+	void JobSystem::ProcessMainThreadJobs()
+	{
+		// Only process jobs queued before this call, as they may queue other ones
+		std::size_t jobCount = m_mainThreadJobs.size_approx();
+
+		Job job;
+		while (jobCount-- > 0 && m_mainThreadJobs.try_dequeue(job))
+			job();
+	}
+
+	bool JobSystem::TryPopJob(std::size_t workerIndex, Job& job)
+	{
+		// Higher priorities first, from the worker own queue (most recent job, likely to be hot in cache) then stolen from others (oldest job)
+		for (std::size_t priority = 0; priority < PriorityCount; ++priority)
+		{
+			for (std::size_t i = 0; i < m_queues.size(); ++i)
+			{
+				std::size_t queueIndex = (workerIndex + i) % m_queues.size();
+
+				WorkerQueue& queue = *m_queues[queueIndex];
+				std::unique_lock<std::mutex> lock(queue.mutex);
+
+				auto& jobs = queue.jobs[priority];
+				if (jobs.empty())
+					continue;
+
+				if (queueIndex == workerIndex)
+				{
+					job = std::move(jobs.back());
+					jobs.pop_back();
+				}
+				else
+				{
+					job = std::move(jobs.front());
+					jobs.pop_front();
+				}
+
+				m_pendingJobCount--;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void JobSystem::WorkerMain(std::size_t workerIndex)
+	{
+		s_currentJobSystem = this;
+		s_currentWorkerIndex = workerIndex;
+
+		Job job;
+		for (;;)
+		{
+			if (TryPopJob(workerIndex, job))
+			{
+				job();
+				job = nullptr;
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_jobCondition.wait(lock, [&] { return m_isStopping || m_pendingJobCount > 0; });
+			if (m_isStopping)
+				break;
+		}
+	}
+}
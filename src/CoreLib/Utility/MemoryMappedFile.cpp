@@ -0,0 +1,120 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/MemoryMappedFile.hpp>
+
+#if defined(NAZARA_PLATFORM_WINDOWS)
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <Windows.h>
+#elif defined(NAZARA_PLATFORM_POSIX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#error Missing implementation: MemoryMappedFile
+#endif
+
+namespace bw
+{
+	void MemoryMappedFile::Close()
+	{
+		if (!m_isOpen)
+			return;
+
+		if (m_data)
+		{
+#if defined(NAZARA_PLATFORM_WINDOWS)
+			UnmapViewOfFile(m_data);
+#elif defined(NAZARA_PLATFORM_POSIX)
+			munmap(const_cast<Nz::UInt8*>(m_data), m_size);
+#endif
+		}
+
+		m_data = nullptr;
+		m_size = 0;
+		m_isOpen = false;
+	}
+
+	bool MemoryMappedFile::Open(const std::filesystem::path& filePath)
+	{
+		Close();
+
+		// The mapping stays valid after closing the file handles, which allows to map many files without exhausting descriptors
+#if defined(NAZARA_PLATFORM_WINDOWS)
+		HANDLE fileHandle = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(fileHandle, &fileSize))
+		{
+			CloseHandle(fileHandle);
+			return false;
+		}
+
+		if (fileSize.QuadPart > 0)
+		{
+			HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mappingHandle)
+			{
+				CloseHandle(fileHandle);
+				return false;
+			}
+
+			void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+
+			CloseHandle(mappingHandle);
+			CloseHandle(fileHandle);
+
+			if (!data)
+				return false;
+
+			m_data = static_cast<const Nz::UInt8*>(data);
+		}
+		else
+			CloseHandle(fileHandle);
+
+		m_size = static_cast<std::size_t>(fileSize.QuadPart);
+#elif defined(NAZARA_PLATFORM_POSIX)
+		int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+		if (fileDescriptor == -1)
+			return false;
+
+		struct stat fileStats;
+		if (fstat(fileDescriptor, &fileStats) == -1)
+		{
+			close(fileDescriptor);
+			return false;
+		}
+
+		// mmap doesn't support empty mappings
+		if (fileStats.st_size > 0)
+		{
+			void* data = mmap(nullptr, static_cast<std::size_t>(fileStats.st_size), PROT_READ, MAP_SHARED, fileDescriptor, 0);
+			close(fileDescriptor);
+
+			if (data == MAP_FAILED)
+				return false;
+
+			m_data = static_cast<const Nz::UInt8*>(data);
+		}
+		else
+			close(fileDescriptor);
+
+		m_size = static_cast<std::size_t>(fileStats.st_size);
+#endif
+
+		m_isOpen = true;
+		return true;
+	}
+}
@@ -0,0 +1,83 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/Utility/WorkerPool.hpp>
+
+namespace bw
+{
+	WorkerPool::WorkerPool(std::size_t workerCount) :
+	m_nextIndex(0),
+	m_finishedWorkerCount(0),
+	m_jobSize(0),
+	m_job(nullptr),
+	m_jobGeneration(0),
+	m_isStopping(false)
+	{
+		m_workers.reserve(workerCount);
+		for (std::size_t i = 0; i < workerCount; ++i)
+			m_workers.emplace_back(&WorkerPool::WorkerMain, this);
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_isStopping = true;
+		}
+		m_jobCondition.notify_all();
+
+		for (std::thread& worker : m_workers)
+			worker.join();
+	}
+
+	void WorkerPool::ProcessJob()
+	{
+		std::size_t index;
+		while ((index = m_nextIndex++) < m_jobSize)
+			(*m_job)(index);
+	}
+
+	void WorkerPool::Run(std::size_t count, const Job& job)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_finishedWorkerCount = 0;
+			m_job = &job;
+			m_jobSize = count;
+			m_nextIndex = 0;
+			m_jobGeneration++;
+		}
+		m_jobCondition.notify_all();
+
+		ProcessJob();
+
+		// Wait for every worker (even those which got no index) so none of them can still reference this job afterwards
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_jobDoneCondition.wait(lock, [&] { return m_finishedWorkerCount == m_workers.size(); });
+
+		m_job = nullptr;
+	}
+
+	void WorkerPool::WorkerMain()
+	{
+		Nz::UInt64 lastGeneration = 0;
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;)
+		{
+			m_jobCondition.wait(lock, [&] { return m_isStopping || m_jobGeneration != lastGeneration; });
+			if (m_isStopping)
+				break;
+
+			lastGeneration = m_jobGeneration;
+
+			lock.unlock();
+			ProcessJob();
+			lock.lock();
+
+			if (++m_finishedWorkerCount == m_workers.size())
+				m_jobDoneCondition.notify_one();
+		}
+	}
+}
@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/Utils.hpp>
+#include <algorithm>
 #include <array>
 #include <cassert>
 
@@ -72,4 +73,59 @@ namespace bw
 		// move the camera a bit towards the target
 		return currentPos + displacement;
 	}
+
+	std::vector<Nz::Rectui> MergeSolidTiles(const std::vector<Nz::UInt32>& content, const Nz::Vector2ui& mapSize)
+	{
+		std::size_t tileCount = std::min(content.size(), std::size_t(mapSize.x) * mapSize.y);
+		std::vector<bool> covered(tileCount, false);
+
+		auto IsFree = [&](unsigned int x, unsigned int y)
+		{
+			std::size_t tileIndex = std::size_t(y) * mapSize.x + x;
+			return tileIndex < tileCount && content[tileIndex] != 0 && !covered[tileIndex];
+		};
+
+		std::vector<Nz::Rectui> rects;
+		for (unsigned int y = 0; y < mapSize.y; ++y)
+		{
+			for (unsigned int x = 0; x < mapSize.x; ++x)
+			{
+				if (!IsFree(x, y))
+					continue;
+
+				// Grow the run as far as possible on this row, then extend it downwards while the whole run below is solid
+				unsigned int width = 1;
+				while (x + width < mapSize.x && IsFree(x + width, y))
+					width++;
+
+				unsigned int height = 1;
+				for (; y + height < mapSize.y; ++height)
+				{
+					bool isRowSolid = true;
+					for (unsigned int i = 0; i < width; ++i)
+					{
+						if (!IsFree(x + i, y + height))
+						{
+							isRowSolid = false;
+							break;
+						}
+					}
+
+					if (!isRowSolid)
+						break;
+				}
+
+				for (unsigned int j = 0; j < height; ++j)
+				{
+					for (unsigned int i = 0; i < width; ++i)
+						covered[std::size_t(y + j) * mapSize.x + x + i] = true;
+				}
+
+				rects.emplace_back(x, y, width, height);
+				x += width - 1;
+			}
+		}
+
+		return rects;
+	}
 }
@@ -50,6 +50,16 @@ namespace bw
 		}
 	}
 
+	long WebRequest::GetResponseCode() const
+	{
+		auto& libcurl = WebService::GetLibcurl();
+
+		long responseCode = 0;
+		libcurl.easy_getinfo(m_curlHandle.Get(), CURLINFO_RESPONSE_CODE, &responseCode);
+
+		return responseCode;
+	}
+
 	void WebRequest::SetJSonContent(const std::string_view& encodedJSon)
 	{
 		auto& libcurl = WebService::GetLibcurl();
@@ -67,6 +77,17 @@ namespace bw
 		libcurl.easy_setopt(m_curlHandle, CURLOPT_MAXFILESIZE_LARGE, maxSize);
 	}
 
+	void WebRequest::SetRange(Nz::UInt64 firstByte, Nz::UInt64 lastByte)
+	{
+		assert(firstByte <= lastByte);
+
+		auto& libcurl = WebService::GetLibcurl();
+
+		// CURLOPT_RANGE doesn't copy the string
+		m_range = std::to_string(firstByte) + "-" + std::to_string(lastByte);
+		libcurl.easy_setopt(m_curlHandle, CURLOPT_RANGE, m_range.data());
+	}
+
 	void WebRequest::SetServiceName(const std::string_view& serviceName)
 	{
 		auto& libcurl = WebService::GetLibcurl();
@@ -87,6 +108,13 @@ namespace bw
 		m_isUserAgentSet = true;
 	}
 
+	void WebRequest::SetTimeout(Nz::UInt64 milliseconds)
+	{
+		auto& libcurl = WebService::GetLibcurl();
+
+		libcurl.easy_setopt(m_curlHandle, CURLOPT_TIMEOUT_MS, long(milliseconds));
+	}
+
 	void WebRequest::SetURL(const std::string& url)
 	{
 		auto& libcurl = WebService::GetLibcurl();
@@ -7,15 +7,28 @@
 #include <CoreLib/LogSystem/Logger.hpp>
 #include <Nazara/Core/ErrorFlags.hpp>
 #include <CoreLib/CurlLibrary.hpp> //< include last because of curl/curl.h
+#include <array>
+#include <mutex>
 #include <type_traits>
 
 namespace bw
 {
+	namespace
+	{
+		constexpr long DnsCacheTimeout = 10 * 60; //< seconds, master servers rarely move
+		constexpr long KeepAliveDelay = 30; //< seconds, must stay below the refresh interval for connections to survive it
+
+		std::array<std::mutex, CURL_LOCK_DATA_LAST> s_shareMutexes; //< web services may be polled from different threads
+	}
+
 	WebService::WebService(const Logger& logger) :
 	m_logger(logger)
 	{
 		assert(IsInitialized());
 		m_curlMulti = s_curlLibrary->multi_init();
+
+		// Let transfers to the same host share connections (HTTP/2 multiplexing, keep-alive otherwise)
+		s_curlLibrary->multi_setopt(m_curlMulti, CURLMOPT_PIPELINING, long(CURLPIPE_MULTIPLEX));
 	}
 
 	WebService::~WebService()
@@ -49,6 +62,15 @@ namespace bw
 			return totalSize;
 		};
 
+		s_curlLibrary->easy_setopt(handle, CURLOPT_HTTP_VERSION, long(CURL_HTTP_VERSION_2TLS));
+		s_curlLibrary->easy_setopt(handle, CURLOPT_PIPEWAIT, long(1)); //< prefer waiting for a multiplexed connection over opening a new one
+		s_curlLibrary->easy_setopt(handle, CURLOPT_DNS_CACHE_TIMEOUT, DnsCacheTimeout);
+		s_curlLibrary->easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, long(1));
+		s_curlLibrary->easy_setopt(handle, CURLOPT_TCP_KEEPIDLE, KeepAliveDelay);
+		s_curlLibrary->easy_setopt(handle, CURLOPT_TCP_KEEPINTVL, KeepAliveDelay);
+		if (s_curlShare)
+			s_curlLibrary->easy_setopt(handle, CURLOPT_SHARE, s_curlShare);
+
 		s_curlLibrary->easy_setopt(handle, CURLOPT_WRITEFUNCTION, writeCallback);
 		s_curlLibrary->easy_setopt(handle, CURLOPT_WRITEDATA, request.get());
 
@@ -140,6 +162,28 @@ namespace bw
 		if (libcurl->global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK)
 			return false;
 
+		// Every web service has its own multi handle (and thus connection cache), share DNS cache and TLS sessions between them so
+		// a new connection to an already known host skips the lookup and does an abbreviated handshake
+		if (CURLSH* share = libcurl->share_init())
+		{
+			curl_lock_function lockCallback = [](CURL* /*handle*/, curl_lock_data data, curl_lock_access /*access*/, void* /*userptr*/)
+			{
+				s_shareMutexes[data].lock();
+			};
+
+			curl_unlock_function unlockCallback = [](CURL* /*handle*/, curl_lock_data data, void* /*userptr*/)
+			{
+				s_shareMutexes[data].unlock();
+			};
+
+			libcurl->share_setopt(share, CURLSHOPT_LOCKFUNC, lockCallback);
+			libcurl->share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockCallback);
+			libcurl->share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+			libcurl->share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+			s_curlShare = share;
+		}
+
 		curl_version_info_data* curlVersionData = libcurl->version_info(CURLVERSION_NOW);
 
 		s_userAgent = "Burg'War/" +
@@ -154,6 +198,12 @@ namespace bw
 	{
 		if (IsInitialized())
 		{
+			if (s_curlShare)
+			{
+				s_curlLibrary->share_cleanup(s_curlShare);
+				s_curlShare = nullptr;
+			}
+
 			s_curlLibrary->global_cleanup();
 			s_curlLibrary.reset();
 
@@ -162,5 +212,6 @@ namespace bw
 	}
 
 	std::string WebService::s_userAgent;
+	CURLSH* WebService::s_curlShare = nullptr;
 	std::unique_ptr<CurlLibrary> WebService::s_curlLibrary;
 }
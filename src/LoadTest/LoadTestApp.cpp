@@ -0,0 +1,174 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <LoadTest/LoadTestApp.hpp>
+#include <CoreLib/NetworkReactor.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <Nazara/Core/File.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <numeric>
+#include <thread>
+
+namespace bw
+{
+	LoadTestApp::LoadTestApp(Settings settings) :
+	BurgApp(LogSide::Client, m_configFile),
+	m_configFile(*this),
+	m_reactorManager(GetLogger()),
+	m_settings(std::move(settings)),
+	m_isRunning(true)
+	{
+		GetLogger().SetMinimumLogLevel(LogLevel::Info);
+
+		// A single reactor for every bot, NetworkReactorManager would otherwise allocate one network thread every 5 peers
+		m_reactorManager.AddReactor(std::make_unique<NetworkReactor>(0, m_settings.serverAddress.GetProtocol(), Nz::UInt16(0), std::max<std::size_t>(m_settings.botCount, 1), m_reactorManager.GetPacketDecoder()));
+	}
+
+	int LoadTestApp::Run()
+	{
+		bwLog(GetLogger(), LogLevel::Info, "connecting {0} bot(s) to {1} over {2:.1f}s", m_settings.botCount, m_settings.serverAddress.ToString().ToStdString(), m_settings.spawnInterval * m_settings.botCount);
+
+		m_bots.reserve(m_settings.botCount);
+
+		Nz::UInt64 startTime = Nz::GetElapsedMicroseconds();
+		Nz::UInt64 endTime = startTime + static_cast<Nz::UInt64>(m_settings.duration * 1'000'000);
+		Nz::UInt64 spawnInterval = static_cast<Nz::UInt64>(m_settings.spawnInterval * 1'000'000);
+
+		while (m_isRunning)
+		{
+			BurgApp::Update();
+			m_reactorManager.Update();
+
+			Nz::UInt64 now = Nz::GetElapsedMicroseconds();
+			if (now >= endTime)
+				break;
+
+			while (m_bots.size() < m_settings.botCount && now - startTime >= m_bots.size() * spawnInterval)
+			{
+				auto& bot = m_bots.emplace_back(std::make_unique<LoadTestBot>(*this, m_reactorManager, m_bots.size(), m_settings.inputMode, m_settings.seed));
+				bot->Connect(m_settings.serverAddress);
+			}
+
+			for (auto& bot : m_bots)
+				bot->Update(now);
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		// Fetch final byte counters before disconnecting, session infos are answered by the network thread
+		for (auto& bot : m_bots)
+			bot->RefreshSessionInfo();
+
+		PumpNetwork(100'000);
+
+		for (auto& bot : m_bots)
+			bot->Disconnect();
+
+		// Give the network thread some time to notify the server
+		PumpNetwork(500'000);
+
+		return PrintReport();
+	}
+
+	void LoadTestApp::Quit()
+	{
+		m_isRunning = false;
+	}
+
+	void LoadTestApp::PumpNetwork(Nz::UInt64 duration)
+	{
+		Nz::UInt64 endTime = Nz::GetElapsedMicroseconds() + duration;
+		while (Nz::GetElapsedMicroseconds() < endTime)
+		{
+			m_reactorManager.Update();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	int LoadTestApp::PrintReport()
+	{
+		std::vector<Nz::UInt64> joinTimes;
+		std::vector<Nz::Int32> tickDeltas;
+		double totalDownloadRate = 0.0;
+		double totalUploadRate = 0.0;
+		std::size_t failedCount = 0;
+		std::size_t matchStateCount = 0;
+		std::size_t predictionCorrectionCount = 0;
+		std::size_t timingCorrectionCount = 0;
+		Nz::UInt64 totalPlayingTime = 0;
+
+		std::string report = "bot,join_time_ms,playing_time_s,download_bytes_per_s,upload_bytes_per_s,match_states,average_tick_delta,max_tick_delta,timing_corrections,prediction_corrections,failure\n";
+
+		for (std::size_t i = 0; i < m_bots.size(); ++i)
+		{
+			const LoadTestBot::Statistics& stats = m_bots[i]->GetStatistics();
+
+			if (m_bots[i]->HasFailed())
+				failedCount++;
+
+			float playingTime = stats.playingTime / 1'000'000.f;
+			double downloadRate = (playingTime > 0.f) ? stats.totalByteReceived / playingTime : 0.0;
+			double uploadRate = (playingTime > 0.f) ? stats.totalByteSent / playingTime : 0.0;
+
+			if (stats.joinTime)
+			{
+				joinTimes.push_back(*stats.joinTime);
+				totalDownloadRate += downloadRate;
+				totalUploadRate += uploadRate;
+			}
+
+			tickDeltas.insert(tickDeltas.end(), stats.tickDeltas.begin(), stats.tickDeltas.end());
+			matchStateCount += stats.matchStateCount;
+			predictionCorrectionCount += stats.predictionCorrectionCount;
+			timingCorrectionCount += stats.timingCorrectionCount;
+			totalPlayingTime += stats.playingTime;
+
+			double averageTickDelta = (!stats.tickDeltas.empty()) ? double(std::accumulate(stats.tickDeltas.begin(), stats.tickDeltas.end(), Nz::Int64(0))) / stats.tickDeltas.size() : 0.0;
+			Nz::Int32 maxTickDelta = (!stats.tickDeltas.empty()) ? *std::max_element(stats.tickDeltas.begin(), stats.tickDeltas.end()) : 0;
+
+			report += fmt::format("{0},{1},{2:.2f},{3:.0f},{4:.0f},{5},{6:.2f},{7},{8},{9},\"{10}\"\n", i + 1, (stats.joinTime) ? std::to_string(*stats.joinTime / 1000) : std::string(), playingTime, downloadRate, uploadRate, stats.matchStateCount, averageTickDelta, maxTickDelta, stats.timingCorrectionCount, stats.predictionCorrectionCount, stats.failureReason);
+		}
+
+		if (!m_settings.reportFile.empty())
+		{
+			Nz::File reportStream(m_settings.reportFile, Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate);
+			if (!reportStream.IsOpen() || reportStream.Write(report.data(), report.size()) != report.size())
+				bwLog(GetLogger(), LogLevel::Error, "failed to write load test report to {0}", m_settings.reportFile);
+		}
+
+		bwLog(GetLogger(), LogLevel::Info, "{0}/{1} bot(s) joined, {2} failed", joinTimes.size(), m_bots.size(), failedCount);
+		if (joinTimes.empty())
+			return EXIT_FAILURE;
+
+		std::sort(joinTimes.begin(), joinTimes.end());
+
+		auto Percentile = [](const auto& sortedValues, double percentile)
+		{
+			return sortedValues[std::min(static_cast<std::size_t>(percentile * sortedValues.size()), sortedValues.size() - 1)];
+		};
+
+		Nz::UInt64 averageJoinTime = std::accumulate(joinTimes.begin(), joinTimes.end(), Nz::UInt64(0)) / joinTimes.size();
+		bwLog(GetLogger(), LogLevel::Info, "join time: average {0} ms, median {1} ms, 95th {2} ms, max {3} ms", averageJoinTime / 1000, Percentile(joinTimes, 0.5) / 1000, Percentile(joinTimes, 0.95) / 1000, joinTimes.back() / 1000);
+
+		bwLog(GetLogger(), LogLevel::Info, "bandwidth: {0:.0f} B/s down and {1:.0f} B/s up per bot ({2:.1f} KiB/s down and {3:.1f} KiB/s up in total)", totalDownloadRate / joinTimes.size(), totalUploadRate / joinTimes.size(), totalDownloadRate / 1024.0, totalUploadRate / 1024.0);
+
+		if (!tickDeltas.empty())
+		{
+			std::sort(tickDeltas.begin(), tickDeltas.end());
+
+			double averageTickDelta = double(std::accumulate(tickDeltas.begin(), tickDeltas.end(), Nz::Int64(0))) / tickDeltas.size();
+			std::size_t outOfOrderCount = std::count_if(tickDeltas.begin(), tickDeltas.end(), [](Nz::Int32 delta) { return delta <= 0; });
+
+			bwLog(GetLogger(), LogLevel::Info, "match state tick delta: average {0:.2f}, median {1}, 99th {2}, max {3}, {4} out of order ({5} states received)", averageTickDelta, Percentile(tickDeltas, 0.5), Percentile(tickDeltas, 0.99), tickDeltas.back(), outOfOrderCount, matchStateCount);
+		}
+
+		float totalPlayingMinutes = totalPlayingTime / 60'000'000.f;
+		bwLog(GetLogger(), LogLevel::Info, "corrections: {0} timing correction(s), {1} prediction correction(s) ({2:.2f} per bot per minute)", timingCorrectionCount, predictionCorrectionCount, (totalPlayingMinutes > 0.f) ? predictionCorrectionCount / totalPlayingMinutes : 0.f);
+
+		return EXIT_SUCCESS;
+	}
+}
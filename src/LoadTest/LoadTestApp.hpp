@@ -0,0 +1,58 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_LOADTEST_LOADTESTAPP_HPP
+#define BURGWAR_LOADTEST_LOADTESTAPP_HPP
+
+#include <CoreLib/BurgApp.hpp>
+#include <CoreLib/SharedAppConfig.hpp>
+#include <ClientLib/NetworkReactorManager.hpp>
+#include <LoadTest/LoadTestBot.hpp>
+#include <Nazara/Network/IpAddress.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	class LoadTestApp : public BurgApp
+	{
+		public:
+			struct Settings;
+
+			LoadTestApp(Settings settings);
+			~LoadTestApp() = default;
+
+			int Run();
+			void Quit() override;
+
+			struct Settings
+			{
+				LoadTestBot::InputMode inputMode;
+				Nz::IpAddress serverAddress;
+				std::size_t botCount;
+				std::string reportFile;
+				float duration; //< Seconds between the first connection and the end of the test
+				float spawnInterval; //< Seconds between two bot connections
+				unsigned int seed;
+			};
+
+		private:
+			void PumpNetwork(Nz::UInt64 duration);
+			int PrintReport();
+
+			SharedAppConfig m_configFile;
+			NetworkReactorManager m_reactorManager;
+			Settings m_settings;
+			std::atomic_bool m_isRunning;
+			std::vector<std::unique_ptr<LoadTestBot>> m_bots;
+	};
+}
+
+#include <LoadTest/LoadTestApp.inl>
+
+#endif
@@ -0,0 +1,308 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <LoadTest/LoadTestBot.hpp>
+#include <CoreLib/BurgApp.hpp>
+#include <CoreLib/Config.hpp>
+#include <CoreLib/NetworkSessionBridge.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <CoreLib/Protocol/Packets.hpp>
+#include <ClientLib/NetworkReactorManager.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace bw
+{
+	LoadTestBot::LoadTestBot(BurgApp& app, NetworkReactorManager& reactorManager, std::size_t botIndex, InputMode inputMode, unsigned int seed) :
+	m_session(app),
+	m_reactorManager(reactorManager),
+	m_state(State::Disconnected),
+	m_inputMode(inputMode),
+	m_averageTickError(20),
+	m_connectionTime(0),
+	m_lastTickTime(0),
+	m_lastUpdateTime(0),
+	m_localTick(0),
+	m_nextSessionInfoTime(0),
+	m_tickDuration(0),
+	m_randomGenerator(seed + static_cast<unsigned int>(botIndex)),
+	m_nickname(fmt::format("Bot{0}", botIndex + 1)),
+	m_inputTimer(0.f),
+	m_patrolTimer(botIndex * 0.37f) //< Don't have every bot walk in sync
+	{
+		m_onConnectedSlot.Connect(m_session.OnConnected, [this](ClientSession*)
+		{
+			m_state = State::Authenticating;
+
+			Packets::Auth authPacket;
+			auto& playerData = authPacket.players.emplace_back();
+			playerData.nickname = m_nickname;
+
+			m_session.SendPacket(authPacket);
+		});
+
+		m_onDisconnectedSlot.Connect(m_session.OnDisconnected, [this](ClientSession* session)
+		{
+			if (m_state == State::Disconnected || m_state == State::Failed)
+				return;
+
+			// Server may ask us to connect to another of its network threads, this can't be done from the disconnection callback
+			Nz::UInt32 disconnectionData = session->GetDisconnectionData();
+			if (disconnectionData & NetworkRedirectFlag)
+			{
+				m_pendingRedirectPort = Nz::UInt16(m_serverAddress.GetPort() + (disconnectionData & ~NetworkRedirectFlag));
+				return;
+			}
+
+			Fail(fmt::format("disconnected by server (data: {0})", disconnectionData));
+		});
+
+		m_onAuthFailureSlot.Connect(m_session.OnAuthFailure, [this](ClientSession*, const Packets::AuthFailure&)
+		{
+			Fail("authentication failed");
+		});
+
+		m_onAuthSuccessSlot.Connect(m_session.OnAuthSuccess, [this](ClientSession*, const Packets::AuthSuccess&)
+		{
+			m_state = State::Joining;
+		});
+
+		m_onMatchDataSlot.Connect(m_session.OnMatchData, [this](ClientSession*, const Packets::MatchData& matchData)
+		{
+			m_tickDuration = std::max<Nz::UInt64>(static_cast<Nz::UInt64>(matchData.tickDuration * 1'000'000), 1);
+
+			// Same initial estimation as ClientMatch, we start at tick 0 while the server is at matchData.currentTick
+			m_averageTickError.InsertValue(-static_cast<Nz::Int32>(matchData.currentTick));
+
+			m_session.SendPacket(Packets::Ready{});
+
+			m_lastTickTime = Nz::GetElapsedMicroseconds();
+			m_state = State::Playing;
+		});
+
+		m_onMatchStateSlot.Connect(m_session.OnMatchState, [this](ClientSession*, const Packets::MatchState& matchState)
+		{
+			if (!m_statistics.joinTime)
+			{
+				m_statistics.joinTime = Nz::GetElapsedMicroseconds() - m_connectionTime;
+				bwLog(m_session.GetApp().GetLogger(), LogLevel::Debug, "{0} joined in {1}ms", m_nickname, *m_statistics.joinTime / 1000);
+			}
+
+			m_statistics.matchStateCount++;
+
+			if (m_lastReceivedStateTick)
+			{
+				Nz::Int32 tickDelta = static_cast<Nz::Int16>(matchState.stateTick - *m_lastReceivedStateTick);
+				m_statistics.tickDeltas.push_back(tickDelta);
+
+				// MatchStates are unreliable, don't acknowledge an older state
+				if (tickDelta > 0)
+					m_lastReceivedStateTick = matchState.stateTick;
+			}
+			else
+				m_lastReceivedStateTick = matchState.stateTick;
+		});
+
+		m_onInputTimingCorrectionSlot.Connect(m_session.OnInputTimingCorrection, [this](ClientSession*, const Packets::InputTimingCorrection& timingCorrection)
+		{
+			m_statistics.timingCorrectionCount++;
+
+			Nz::Int32 tickError = timingCorrection.tickError;
+			if (std::abs(tickError) >= PredictionCorrectionThreshold)
+				m_statistics.predictionCorrectionCount++;
+
+			auto it = std::find_if(m_tickPredictions.begin(), m_tickPredictions.end(), [&](const TickPrediction& prediction) { return prediction.serverTick == timingCorrection.serverTick; });
+			if (it != m_tickPredictions.end())
+			{
+				m_averageTickError.InsertValue(it->tickError + tickError);
+				m_tickPredictions.erase(it);
+			}
+		});
+	}
+
+	bool LoadTestBot::Connect(const Nz::IpAddress& serverAddress)
+	{
+		m_serverAddress = serverAddress;
+		if (m_state == State::Disconnected)
+		{
+			m_connectionTime = Nz::GetElapsedMicroseconds();
+			m_lastUpdateTime = m_connectionTime;
+		}
+
+		std::shared_ptr<NetworkSessionBridge> sessionBridge = m_reactorManager.ConnectToServer(serverAddress, 0);
+		if (!sessionBridge)
+		{
+			Fail("failed to allocate peer");
+			return false;
+		}
+
+		m_state = State::Connecting;
+		m_session.Connect(std::move(sessionBridge));
+
+		return true;
+	}
+
+	void LoadTestBot::Disconnect()
+	{
+		if (m_state == State::Failed)
+			return;
+
+		m_state = State::Disconnected;
+		m_session.Disconnect();
+	}
+
+	void LoadTestBot::RefreshSessionInfo()
+	{
+		m_session.QuerySessionInfo([this](const SessionBridge::SessionInfo& info)
+		{
+			m_statistics.totalByteReceived = info.totalByteReceived;
+			m_statistics.totalByteSent = info.totalByteSent;
+		});
+	}
+
+	void LoadTestBot::Update(Nz::UInt64 now)
+	{
+		if (m_pendingRedirectPort)
+		{
+			Nz::IpAddress redirectAddress = m_serverAddress;
+			redirectAddress.SetPort(*m_pendingRedirectPort);
+			m_pendingRedirectPort.reset();
+
+			bwLog(m_session.GetApp().GetLogger(), LogLevel::Debug, "{0} redirected to {1}", m_nickname, redirectAddress.ToString().ToStdString());
+
+			if (!Connect(redirectAddress))
+				return;
+		}
+
+		if (m_state == State::Playing)
+		{
+			while (now - m_lastTickTime >= m_tickDuration)
+			{
+				m_lastTickTime += m_tickDuration;
+				HandleTick();
+			}
+
+			m_statistics.playingTime += now - m_lastUpdateTime;
+		}
+
+		if (m_state != State::Failed && now >= m_nextSessionInfoTime)
+		{
+			RefreshSessionInfo();
+			m_nextSessionInfoTime = now + 1'000'000;
+		}
+
+		m_lastUpdateTime = now;
+	}
+
+	void LoadTestBot::Fail(std::string reason)
+	{
+		bwLog(m_session.GetApp().GetLogger(), LogLevel::Warning, "{0} failed: {1}", m_nickname, reason);
+
+		m_statistics.failureReason = std::move(reason);
+		m_state = State::Failed;
+		m_session.Disconnect();
+	}
+
+	void LoadTestBot::HandleTick()
+	{
+		m_localTick++;
+
+		UpdateInputs(m_tickDuration / 1'000'000.f);
+		SendInputs();
+	}
+
+	void LoadTestBot::SendInputs()
+	{
+		Nz::Int32 averageTickError = m_averageTickError.GetAverageValue();
+		Nz::UInt16 estimatedServerTick = static_cast<Nz::UInt16>(static_cast<Nz::Int64>(m_localTick) - averageTickError);
+
+		Packets::PlayersInput inputPacket;
+		inputPacket.estimatedServerTick = estimatedServerTick;
+		inputPacket.inputTick = static_cast<Nz::UInt16>(m_localTick);
+		inputPacket.lastReceivedStateTick = m_lastReceivedStateTick;
+		inputPacket.inputs.push_back(m_inputs);
+
+		// Resend previous inputs like the real client does, as PlayersInput is unreliable
+		for (std::size_t i = 0; i < m_sentInputs.size(); ++i)
+		{
+			const PlayerInputData& moreRecentInputs = (i == 0) ? m_inputs : m_sentInputs[i - 1];
+
+			auto& previousInputs = inputPacket.previousInputs.emplace_back();
+			previousInputs.tickOffset = static_cast<Nz::UInt8>(i + 1);
+			if (m_sentInputs[i] != moreRecentInputs)
+				previousInputs.inputs.emplace_back(m_sentInputs[i]);
+			else
+				previousInputs.inputs.emplace_back();
+		}
+
+		m_session.SendPacket(inputPacket);
+
+		m_sentInputs.insert(m_sentInputs.begin(), m_inputs);
+		if (m_sentInputs.size() > Packets::PlayersInput::MaxPreviousInputs)
+			m_sentInputs.pop_back();
+
+		// Remember at most 2s of predictions
+		if (m_tickPredictions.size() >= 2'000'000 / m_tickDuration)
+			m_tickPredictions.erase(m_tickPredictions.begin());
+
+		auto& prediction = m_tickPredictions.emplace_back();
+		prediction.serverTick = estimatedServerTick;
+		prediction.tickError = averageTickError;
+	}
+
+	void LoadTestBot::UpdateInputs(float elapsedTime)
+	{
+		switch (m_inputMode)
+		{
+			case InputMode::Idle:
+				break;
+
+			case InputMode::Patrol:
+			{
+				// Walk right for two seconds, then left for two seconds, jumping and shooting along the way
+				m_patrolTimer += elapsedTime;
+
+				float phase = std::fmod(m_patrolTimer, 4.f);
+				bool movingRight = (phase < 2.f);
+
+				m_inputs.aimDirection = (movingRight) ? Nz::Vector2f::UnitX() : -Nz::Vector2f::UnitX();
+				m_inputs.isAttacking = (std::fmod(phase, 2.f) >= 1.f && std::fmod(phase, 2.f) < 1.5f);
+				m_inputs.isJumping = (std::fmod(m_patrolTimer, 3.f) < 0.1f);
+				m_inputs.isLookingRight = movingRight;
+				m_inputs.isMovingLeft = !movingRight;
+				m_inputs.isMovingRight = movingRight;
+				break;
+			}
+
+			case InputMode::Random:
+			{
+				m_inputTimer -= elapsedTime;
+				if (m_inputTimer > 0.f)
+					break;
+
+				m_inputTimer = std::uniform_real_distribution<float>(0.25f, 1.5f)(m_randomGenerator);
+
+				auto Chance = [&](float probability)
+				{
+					return std::uniform_real_distribution<float>(0.f, 1.f)(m_randomGenerator) < probability;
+				};
+
+				float aimAngle = std::uniform_real_distribution<float>(-float(M_PI), float(M_PI))(m_randomGenerator);
+				int movement = std::uniform_int_distribution<int>(0, 2)(m_randomGenerator);
+
+				m_inputs.aimDirection = Nz::Vector2f(std::cos(aimAngle), std::sin(aimAngle));
+				m_inputs.isAttacking = Chance(0.4f);
+				m_inputs.isCrouching = Chance(0.1f);
+				m_inputs.isJumping = Chance(0.2f);
+				m_inputs.isLookingRight = (m_inputs.aimDirection.x >= 0.f);
+				m_inputs.isMovingLeft = (movement == 1);
+				m_inputs.isMovingRight = (movement == 2);
+				break;
+			}
+		}
+	}
+}
@@ -0,0 +1,126 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_LOADTEST_LOADTESTBOT_HPP
+#define BURGWAR_LOADTEST_LOADTESTBOT_HPP
+
+#include <CoreLib/PlayerInputData.hpp>
+#include <CoreLib/Utility/AverageValues.hpp>
+#include <ClientLib/ClientSession.hpp>
+#include <Nazara/Network/IpAddress.hpp>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	class BurgApp;
+	class NetworkReactorManager;
+
+	class LoadTestBot
+	{
+		public:
+			enum class InputMode
+			{
+				Idle,
+				Patrol,
+				Random
+			};
+
+			struct Statistics
+			{
+				std::optional<Nz::UInt64> joinTime; //< Microseconds between connection and the first received MatchState
+				std::string failureReason;
+				std::vector<Nz::Int32> tickDeltas; //< Tick difference between two consecutive MatchStates
+				Nz::UInt64 playingTime = 0; //< Microseconds spent in match
+				Nz::UInt64 totalByteReceived = 0;
+				Nz::UInt64 totalByteSent = 0;
+				std::size_t matchStateCount = 0;
+				std::size_t predictionCorrectionCount = 0; //< Timing corrections whose error was big enough for the client to resync
+				std::size_t timingCorrectionCount = 0;
+			};
+
+			LoadTestBot(BurgApp& app, NetworkReactorManager& reactorManager, std::size_t botIndex, InputMode inputMode, unsigned int seed);
+			LoadTestBot(const LoadTestBot&) = delete;
+			LoadTestBot(LoadTestBot&&) = delete;
+			~LoadTestBot() = default;
+
+			bool Connect(const Nz::IpAddress& serverAddress);
+			void Disconnect();
+
+			inline const Statistics& GetStatistics() const;
+
+			inline bool HasFailed() const;
+			inline bool IsPlaying() const;
+
+			void RefreshSessionInfo();
+
+			void Update(Nz::UInt64 now);
+
+			LoadTestBot& operator=(const LoadTestBot&) = delete;
+			LoadTestBot& operator=(LoadTestBot&&) = delete;
+
+			static constexpr Nz::Int32 PredictionCorrectionThreshold = 2;
+
+		private:
+			enum class State
+			{
+				Disconnected,
+				Connecting,
+				Authenticating,
+				Joining,
+				Playing,
+				Failed
+			};
+
+			struct TickPrediction
+			{
+				Nz::UInt16 serverTick;
+				Nz::Int32 tickError;
+			};
+
+			void Fail(std::string reason);
+			void HandleTick();
+			void SendInputs();
+			void UpdateInputs(float elapsedTime);
+
+			ClientSession m_session;
+			NetworkReactorManager& m_reactorManager;
+			State m_state;
+			InputMode m_inputMode;
+			AverageValues<Nz::Int32> m_averageTickError;
+			Nz::IpAddress m_serverAddress;
+			Nz::UInt64 m_connectionTime;
+			Nz::UInt64 m_lastTickTime;
+			Nz::UInt64 m_lastUpdateTime;
+			Nz::UInt64 m_localTick;
+			Nz::UInt64 m_nextSessionInfoTime;
+			Nz::UInt64 m_tickDuration;
+			PlayerInputData m_inputs;
+			Statistics m_statistics;
+			std::mt19937 m_randomGenerator;
+			std::optional<Nz::UInt16> m_lastReceivedStateTick;
+			std::optional<Nz::UInt16> m_pendingRedirectPort;
+			std::string m_nickname;
+			std::vector<PlayerInputData> m_sentInputs; //< Most recent first
+			std::vector<TickPrediction> m_tickPredictions;
+			float m_inputTimer;
+			float m_patrolTimer;
+
+			NazaraSlot(ClientSession, OnAuthFailure, m_onAuthFailureSlot);
+			NazaraSlot(ClientSession, OnAuthSuccess, m_onAuthSuccessSlot);
+			NazaraSlot(ClientSession, OnConnected, m_onConnectedSlot);
+			NazaraSlot(ClientSession, OnDisconnected, m_onDisconnectedSlot);
+			NazaraSlot(ClientSession, OnInputTimingCorrection, m_onInputTimingCorrectionSlot);
+			NazaraSlot(ClientSession, OnMatchData, m_onMatchDataSlot);
+			NazaraSlot(ClientSession, OnMatchState, m_onMatchStateSlot);
+	};
+}
+
+#include <LoadTest/LoadTestBot.inl>
+
+#endif
@@ -0,0 +1,23 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <LoadTest/LoadTestBot.hpp>
+
+namespace bw
+{
+	inline auto LoadTestBot::GetStatistics() const -> const Statistics&
+	{
+		return m_statistics;
+	}
+
+	inline bool LoadTestBot::HasFailed() const
+	{
+		return m_state == State::Failed;
+	}
+
+	inline bool LoadTestBot::IsPlaying() const
+	{
+		return m_state == State::Playing;
+	}
+}
@@ -0,0 +1,87 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <LoadTest/LoadTestApp.hpp>
+#include <Main/Main.hpp>
+#include <Nazara/Core/Initializer.hpp>
+#include <Nazara/Network/Algorithm.hpp>
+#include <Nazara/Network/Network.hpp>
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int BurgWarLoadTest(int argc, char* argv[])
+{
+	cxxopts::Options options("BurgWarLoadTest", "Connects headless bots to a BurgWar server and reports how it holds up");
+	options.add_options()
+		("a,address", "Server hostname or address", cxxopts::value<std::string>()->default_value("localhost"), "host")
+		("p,port", "Server port", cxxopts::value<Nz::UInt16>()->default_value("14768"), "port")
+		("b,bots", "Number of bots to connect", cxxopts::value<std::size_t>()->default_value("100"), "count")
+		("d,duration", "Test duration in seconds, counting from the first connection", cxxopts::value<float>()->default_value("60"), "seconds")
+		("spawn-interval", "Delay between two bot connections in seconds", cxxopts::value<float>()->default_value("0.05"), "seconds")
+		("inputs", "Bot inputs: idle, patrol (scripted back and forth) or random", cxxopts::value<std::string>()->default_value("random"), "mode")
+		("seed", "Random seed used by the random input mode", cxxopts::value<unsigned int>()->default_value("0"), "seed")
+		("report", "Write per-bot statistics to a CSV file", cxxopts::value<std::string>()->default_value(""), "file")
+		("h,help", "Print usage")
+	;
+
+	bw::LoadTestApp::Settings settings;
+	std::string hostname;
+	Nz::UInt16 port;
+
+	try
+	{
+		auto result = options.parse(argc, argv);
+		if (result.count("help") > 0)
+		{
+			fmt::print("{}\n", options.help());
+			return EXIT_SUCCESS;
+		}
+
+		hostname = result["address"].as<std::string>();
+		port = result["port"].as<Nz::UInt16>();
+		settings.botCount = result["bots"].as<std::size_t>();
+		settings.duration = result["duration"].as<float>();
+		settings.reportFile = result["report"].as<std::string>();
+		settings.seed = result["seed"].as<unsigned int>();
+		settings.spawnInterval = result["spawn-interval"].as<float>();
+
+		const std::string& inputMode = result["inputs"].as<std::string>();
+		if (inputMode == "idle")
+			settings.inputMode = bw::LoadTestBot::InputMode::Idle;
+		else if (inputMode == "patrol")
+			settings.inputMode = bw::LoadTestBot::InputMode::Patrol;
+		else if (inputMode == "random")
+			settings.inputMode = bw::LoadTestBot::InputMode::Random;
+		else
+		{
+			fmt::print(stderr, "unknown input mode \"{}\"\n{}\n", inputMode, options.help());
+			return EXIT_FAILURE;
+		}
+	}
+	catch (const cxxopts::OptionException& e)
+	{
+		fmt::print(stderr, "{}\n{}\n", e.what(), options.help());
+		return EXIT_FAILURE;
+	}
+
+	Nz::Initializer<Nz::Network> network;
+
+	Nz::ResolveError resolveError;
+	std::vector<Nz::HostnameInfo> serverAddresses = Nz::IpAddress::ResolveHostname(Nz::NetProtocol_Any, hostname, Nz::String::Number(port), &resolveError);
+	if (serverAddresses.empty())
+	{
+		fmt::print(stderr, "failed to resolve {}: {}\n", hostname, Nz::ErrorToString(resolveError));
+		return EXIT_FAILURE;
+	}
+
+	settings.serverAddress = serverAddresses.front().address;
+
+	bw::LoadTestApp app(std::move(settings));
+	return app.Run();
+}
+
+BurgWarMain(BurgWarLoadTest)
@@ -0,0 +1,143 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <CoreLib/LogSystem/BinaryLogSink.hpp>
+#include <Main/Main.hpp>
+#include <cxxopts.hpp>
+#include <fmt/chrono.h>
+#include <fmt/format.h>
+#include <ctime>
+#include <filesystem>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const char* ToString(bw::LogLevel level)
+	{
+		switch (level)
+		{
+			case bw::LogLevel::Debug:   return "DEBG";
+			case bw::LogLevel::Info:    return "INFO";
+			case bw::LogLevel::Warning: return "WARN";
+			case bw::LogLevel::Error:   return "ERR.";
+		}
+
+		return "????";
+	}
+
+	const char* ToString(bw::LogSide side)
+	{
+		switch (side)
+		{
+			case bw::LogSide::Irrelevant: return "-";
+			case bw::LogSide::Client:     return "C";
+			case bw::LogSide::Editor:     return "E";
+			case bw::LogSide::Server:     return "S";
+		}
+
+		return "?";
+	}
+
+	bw::LogLevel ParseLevel(const std::string& level)
+	{
+		if (level == "debug")
+			return bw::LogLevel::Debug;
+		else if (level == "info")
+			return bw::LogLevel::Info;
+		else if (level == "warning")
+			return bw::LogLevel::Warning;
+		else if (level == "error")
+			return bw::LogLevel::Error;
+
+		throw std::runtime_error("unknown log level " + level + " (expected debug, info, warning or error)");
+	}
+}
+
+int BurgWarLogTool(int argc, char* argv[])
+{
+	cxxopts::Options options("BurgWarLogTool", "Tool for decoding BurgWar binary logs");
+	options.add_options()
+		("i,input", "Input file(s)", cxxopts::value<std::vector<std::string>>())
+		("l,level", "Minimum level of shown records (debug, info, warning, error)", cxxopts::value<std::string>()->default_value("debug"), "level")
+		("m,match", "Only show records of this match", cxxopts::value<std::string>(), "name")
+		("t,tsv", "Output tab-separated fields (timestamp, level, side, match, tick, entity, message) for analysis tools")
+		("h,help", "Print usage")
+	;
+
+	options.parse_positional("input");
+	options.positional_help("LOGS");
+
+	try
+	{
+		auto result = options.parse(argc, argv);
+		if (result.count("help") > 0)
+		{
+			fmt::print("{}\n", options.help());
+			return EXIT_SUCCESS;
+		}
+
+		if (result.count("input") == 0)
+		{
+			fmt::print("no input files\n{}\n", options.help());
+			return EXIT_SUCCESS;
+		}
+
+		bw::LogLevel minimumLevel = ParseLevel(result["level"].as<std::string>());
+		bool tabSeparated = result.count("tsv") > 0;
+
+		std::optional<std::string> matchFilter;
+		if (result.count("match") > 0)
+			matchFilter = result["match"].as<std::string>();
+
+		std::size_t failedCount = 0;
+		for (const std::string& inputFile : result["input"].as<std::vector<std::string>>())
+		{
+			bool succeeded = bw::BinaryLogSink::ReadFile(std::filesystem::u8path(inputFile), [&](const bw::BinaryLogSink::Record& record)
+			{
+				if (record.level < minimumLevel)
+					return;
+
+				if (matchFilter && record.matchName != matchFilter)
+					return;
+
+				std::time_t seconds = static_cast<std::time_t>(record.timestamp / 1'000'000);
+				unsigned int microseconds = static_cast<unsigned int>(record.timestamp % 1'000'000);
+				std::tm time = fmt::gmtime(seconds);
+
+				if (tabSeparated)
+				{
+					fmt::print("{:%Y-%m-%dT%H:%M:%S}.{:06}Z\t{}\t{}\t{}\t{}\t{}\t{}\n", time, microseconds, ToString(record.level), ToString(record.side), record.matchName.value_or(""), record.tick, (record.entityId) ? std::to_string(*record.entityId) : std::string(), record.content);
+					return;
+				}
+
+				// Content already holds the match/entity prefixes added by their loggers
+				fmt::print("{:%Y-%m-%d %H:%M:%S}.{:06} [{}] {}\n", time, microseconds, ToString(record.level), record.content);
+			});
+
+			if (!succeeded)
+			{
+				fmt::print(stderr, "failed to read {0} (missing file or not a binary log)\n", inputFile);
+				failedCount++;
+			}
+		}
+
+		if (failedCount > 0)
+			return EXIT_FAILURE;
+	}
+	catch (const cxxopts::OptionException& e)
+	{
+		fmt::print(stderr, "{}\n{}\n", e.what(), options.help());
+	}
+	catch (const std::exception& e)
+	{
+		fmt::print(stderr, "{}\n", e.what());
+	}
+
+	return EXIT_SUCCESS;
+}
+
+BurgWarMain(BurgWarLogTool)
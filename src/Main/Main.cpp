@@ -4,6 +4,7 @@
 
 #include <Main/Main.hpp>
 #include <CoreLib/Version.hpp>
+#include <CoreLib/LogSystem/AsyncSink.hpp>
 #include <CoreLib/Utility/CrashHandler.hpp>
 #include <fmt/format.h>
 #include <exception>
@@ -21,11 +22,13 @@ int BurgMain(int argc, char* argv[], int(*mainFunc)(int argc, char* argv[]))
 	}
 	catch (const std::exception& e)
 	{
+		bw::AsyncSink::FlushAll();
 		fmt::print(stderr, "unhandled exception: {0}\n", e.what());
 		throw;
 	}
 	catch (...)
 	{
+		bw::AsyncSink::FlushAll();
 		fmt::print(stderr, "unhandled non-standard exception\n");
 		throw;
 	}
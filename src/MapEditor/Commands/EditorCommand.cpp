@@ -0,0 +1,67 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <MapEditor/Commands/EditorCommand.hpp>
+#include <type_traits>
+
+namespace bw::Commands
+{
+	EditorCommand::EditorCommand(EditorWindow& editor, const QString& label) :
+	m_editor(editor)
+	{
+		setText(label);
+	}
+
+	std::size_t EditorCommand::GetMemoryUsage() const
+	{
+		return sizeof(*this);
+	}
+
+	std::size_t EditorCommand::EstimateMemoryUsage(const Map::Entity& entity)
+	{
+		std::size_t memoryUsage = sizeof(entity) + entity.entityType.capacity() + entity.name.capacity();
+		for (auto&& [propertyName, value] : entity.properties)
+			memoryUsage += propertyName.capacity() + EstimateMemoryUsage(value);
+
+		return memoryUsage;
+	}
+
+	std::size_t EditorCommand::EstimateMemoryUsage(const Map::Layer& layer)
+	{
+		std::size_t memoryUsage = sizeof(layer) + layer.name.capacity();
+		for (const Map::Entity& entity : layer.entities)
+			memoryUsage += EstimateMemoryUsage(entity);
+
+		return memoryUsage;
+	}
+
+	std::size_t EditorCommand::EstimateMemoryUsage(const PropertyValue& value)
+	{
+		return std::visit([](auto&& propertyValue) -> std::size_t
+		{
+			using T = std::decay_t<decltype(propertyValue)>;
+			using PropertyTypeExtractor = PropertyTypeExtractor<T>;
+			using UnderlyingType = typename PropertyTypeExtractor::UnderlyingType;
+
+			std::size_t memoryUsage = sizeof(PropertyValue);
+
+			auto AddElement = [&](const UnderlyingType& element)
+			{
+				if constexpr (std::is_same_v<UnderlyingType, std::string>)
+					memoryUsage += element.capacity();
+			};
+
+			if constexpr (PropertyTypeExtractor::IsArray)
+			{
+				memoryUsage += propertyValue.size() * sizeof(UnderlyingType);
+				for (const UnderlyingType& element : propertyValue)
+					AddElement(element);
+			}
+			else
+				AddElement(propertyValue.value);
+
+			return memoryUsage;
+		}, value);
+	}
+}
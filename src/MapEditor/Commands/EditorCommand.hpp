@@ -0,0 +1,43 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_MAPEDITOR_COMMANDS_EDITORCOMMAND_HPP
+#define BURGWAR_MAPEDITOR_COMMANDS_EDITORCOMMAND_HPP
+
+#include <CoreLib/Map.hpp>
+#include <QtWidgets/QUndoCommand>
+
+namespace bw
+{
+	class EditorWindow;
+
+	namespace Commands
+	{
+		enum class CommandId
+		{
+			PositionUpdate = 1
+		};
+
+		// Base of every editor undo command, reports an estimation of the memory it holds for the undo budget
+		class EditorCommand : public QUndoCommand
+		{
+			public:
+				EditorCommand(EditorWindow& editor, const QString& label);
+				~EditorCommand() = default;
+
+				virtual std::size_t GetMemoryUsage() const;
+
+				static std::size_t EstimateMemoryUsage(const Map::Entity& entity);
+				static std::size_t EstimateMemoryUsage(const Map::Layer& layer);
+				static std::size_t EstimateMemoryUsage(const PropertyValue& value);
+
+			protected:
+				EditorWindow& m_editor;
+		};
+	}
+}
+
+#endif
@@ -5,15 +5,20 @@
 #include <MapEditor/Commands/EntityCommands.hpp>
 #include <CoreLib/Map.hpp>
 #include <MapEditor/Widgets/EditorWindow.hpp>
+#include <type_traits>
 
 namespace bw::Commands
 {
 	EntitiesCommand::EntitiesCommand(EditorWindow& editor, std::vector<EntityId> entityUniqueIds, const QString& label) :
-	m_editor(editor),
+	EditorCommand(editor, label),
 	m_entitiesUniqueId(std::move(entityUniqueIds))
 	{
 		assert(!m_entitiesUniqueId.empty());
-		setText(label);
+	}
+
+	std::size_t EntitiesCommand::GetMemoryUsage() const
+	{
+		return sizeof(*this) + m_entitiesUniqueId.capacity() * sizeof(EntityId);
 	}
 
 	EntityCreationDelete::EntityCreationDelete(EditorWindow& editor, std::vector<EntityId> entityUniqueIds, const QString& label) :
@@ -40,6 +45,15 @@ namespace bw::Commands
 	{
 	}
 
+	std::size_t EntityCreationDelete::GetMemoryUsage() const
+	{
+		std::size_t memoryUsage = EntitiesCommand::GetMemoryUsage() + m_entitiesData.capacity() * sizeof(EntityData);
+		for (const EntityData& entityData : m_entitiesData)
+			memoryUsage += EstimateMemoryUsage(entityData.entity);
+
+		return memoryUsage;
+	}
+
 	void EntityCreationDelete::Create()
 	{
 		assert(!m_entitiesData.empty());
@@ -100,6 +114,52 @@ namespace bw::Commands
 	}
 
 
+	EntityAlign::EntityAlign(EditorWindow& editor, std::vector<EntityId> entityUniqueIds, std::vector<Nz::Vector2f> alignedPositions) :
+	EntitiesCommand(editor, std::move(entityUniqueIds), "align entities"),
+	m_alignedPositions(std::move(alignedPositions))
+	{
+		assert(m_alignedPositions.size() == m_entitiesUniqueId.size());
+
+		const Map& map = m_editor.GetWorkingMap();
+
+		m_previousPositions.reserve(m_entitiesUniqueId.size());
+		for (EntityId entityId : m_entitiesUniqueId)
+			m_previousPositions.push_back(map.GetEntity(entityId).position);
+	}
+
+	std::size_t EntityAlign::GetMemoryUsage() const
+	{
+		return EntitiesCommand::GetMemoryUsage() + (m_alignedPositions.capacity() + m_previousPositions.capacity()) * sizeof(Nz::Vector2f);
+	}
+
+	void EntityAlign::redo()
+	{
+		Apply(m_alignedPositions);
+	}
+
+	void EntityAlign::undo()
+	{
+		Apply(m_previousPositions);
+	}
+
+	void EntityAlign::Apply(const std::vector<Nz::Vector2f>& positions)
+	{
+		Map& map = m_editor.GetWorkingMapMut();
+
+		m_editor.BeginBatchEdit();
+		for (std::size_t i = 0; i < m_entitiesUniqueId.size(); ++i)
+		{
+			const auto& indices = map.GetEntityIndices(m_entitiesUniqueId[i]);
+
+			auto& entity = map.GetEntity(indices.layerIndex, indices.entityIndex);
+			entity.position = positions[i];
+
+			m_editor.RefreshEntityPositionAndRotation(indices.layerIndex, indices.entityIndex);
+		}
+		m_editor.EndBatchEdit();
+	}
+
+
 	EntityClone::EntityClone(EditorWindow& editor, const Map::EntityIndices& sourceEntityIndices, const Map::EntityIndices& targetEntityIndices) :
 	EntityCreationDelete(editor, "clone entity", { BuildClone(editor, sourceEntityIndices, targetEntityIndices) })
 	{
@@ -183,44 +243,190 @@ namespace bw::Commands
 
 	EntityUpdate::EntityUpdate(EditorWindow& editor, EntityId entityUniqueId, Map::Entity update, EntityInfoUpdateFlags updateFlags) :
 	EntitiesCommand(editor, { entityUniqueId }, "update entity"),
-	m_updateFlags(updateFlags),
-	m_newState(std::move(update))
+	m_updateFlags(0)
 	{
-		assert(m_newState.uniqueId == entityUniqueId);
+		assert(update.uniqueId == entityUniqueId);
+
+		const Map::Entity& currentEntity = m_editor.GetWorkingMap().GetEntity(entityUniqueId);
+
+		// Only keep what really changed, unchanged fields don't need to be stored nor reapplied
+		if ((updateFlags & EntityInfoUpdate::EntityClass) && currentEntity.entityType != update.entityType)
+		{
+			m_updateFlags |= EntityInfoUpdate::EntityClass;
+			m_previousState.entityType = currentEntity.entityType;
+			m_newState.entityType = std::move(update.entityType);
+		}
+
+		if ((updateFlags & EntityInfoUpdate::EntityName) && currentEntity.name != update.name)
+		{
+			m_updateFlags |= EntityInfoUpdate::EntityName;
+			m_previousState.name = currentEntity.name;
+			m_newState.name = std::move(update.name);
+		}
+
+		if ((updateFlags & EntityInfoUpdate::PositionRotation) && (currentEntity.position != update.position || currentEntity.rotation != update.rotation))
+		{
+			m_updateFlags |= EntityInfoUpdate::PositionRotation;
+			m_previousState.position = currentEntity.position;
+			m_previousState.rotation = currentEntity.rotation;
+			m_newState.position = update.position;
+			m_newState.rotation = update.rotation;
+		}
 
-		m_previousState = m_editor.GetWorkingMap().GetEntity(entityUniqueId);
+		if (updateFlags & EntityInfoUpdate::Properties)
+		{
+			for (auto it = update.properties.begin(); it != update.properties.end(); ++it)
+			{
+				auto currentIt = currentEntity.properties.find(it->first);
+				if (currentIt != currentEntity.properties.end())
+				{
+					if (ArePropertiesEqual(currentIt->second, it->second))
+						continue;
+
+					m_propertyChanges.push_back({ it->first, currentIt->second, std::move(it.value()) });
+				}
+				else
+					m_propertyChanges.push_back({ it->first, std::nullopt, std::move(it.value()) });
+			}
+
+			for (auto&& [propertyName, value] : currentEntity.properties)
+			{
+				if (update.properties.find(propertyName) == update.properties.end())
+					m_propertyChanges.push_back({ propertyName, value, std::nullopt });
+			}
+
+			if (!m_propertyChanges.empty())
+				m_updateFlags |= EntityInfoUpdate::Properties;
+		}
 	}
 
-	void EntityUpdate::redo()
+	std::size_t EntityUpdate::GetMemoryUsage() const
 	{
-		assert(m_entitiesUniqueId.size() == 1);
-		const Map& map = m_editor.GetWorkingMap();
-		const auto& indices = map.GetEntityIndices(m_entitiesUniqueId[0]);
+		std::size_t memoryUsage = EntitiesCommand::GetMemoryUsage();
+		memoryUsage += m_previousState.entityType.capacity() + m_previousState.name.capacity();
+		memoryUsage += m_newState.entityType.capacity() + m_newState.name.capacity();
+
+		memoryUsage += m_propertyChanges.capacity() * sizeof(PropertyChange);
+		for (const PropertyChange& change : m_propertyChanges)
+		{
+			memoryUsage += change.name.capacity();
+			if (change.previousValue)
+				memoryUsage += EstimateMemoryUsage(*change.previousValue);
+
+			if (change.newValue)
+				memoryUsage += EstimateMemoryUsage(*change.newValue);
+		}
 
-		m_editor.UpdateEntity(indices.layerIndex, indices.entityIndex, m_newState, m_updateFlags);
+		return memoryUsage;
+	}
+
+	void EntityUpdate::redo()
+	{
+		Apply(m_newState, false);
 	}
 
 	void EntityUpdate::undo()
+	{
+		Apply(m_previousState, true);
+	}
+
+	void EntityUpdate::Apply(const EntityState& state, bool undo)
 	{
 		assert(m_entitiesUniqueId.size() == 1);
+		if (!m_updateFlags)
+			return;
+
 		const Map& map = m_editor.GetWorkingMap();
 		const auto& indices = map.GetEntityIndices(m_entitiesUniqueId[0]);
+		const Map::Entity& currentEntity = map.GetEntity(indices.layerIndex, indices.entityIndex);
+
+		Map::Entity entity;
+		entity.uniqueId = currentEntity.uniqueId;
+		entity.entityType = state.entityType;
+		entity.name = state.name;
+		entity.position = state.position;
+		entity.rotation = state.rotation;
+
+		if (m_updateFlags & EntityInfoUpdate::Properties)
+		{
+			entity.properties = currentEntity.properties;
+			for (const PropertyChange& change : m_propertyChanges)
+			{
+				const std::optional<PropertyValue>& value = (undo) ? change.previousValue : change.newValue;
+				if (value)
+					entity.properties.insert_or_assign(change.name, *value);
+				else
+					entity.properties.erase(change.name);
+			}
+		}
 
-		m_editor.UpdateEntity(indices.layerIndex, indices.entityIndex, m_previousState, m_updateFlags);
+		m_editor.UpdateEntity(indices.layerIndex, indices.entityIndex, std::move(entity), m_updateFlags);
+	}
+
+	bool EntityUpdate::ArePropertiesEqual(const PropertyValue& lhs, const PropertyValue& rhs)
+	{
+		if (lhs.index() != rhs.index())
+			return false;
+
+		return std::visit([&](auto&& lhsValue) -> bool
+		{
+			using T = std::decay_t<decltype(lhsValue)>;
+			using PropertyTypeExtractor = PropertyTypeExtractor<T>;
+
+			const T& rhsValue = std::get<T>(rhs);
+			if constexpr (PropertyTypeExtractor::IsArray)
+			{
+				if (lhsValue.size() != rhsValue.size())
+					return false;
+
+				for (std::size_t i = 0; i < lhsValue.size(); ++i)
+				{
+					if (lhsValue[i] != rhsValue[i])
+						return false;
+				}
+
+				return true;
+			}
+			else
+				return lhsValue.value == rhsValue.value;
+		}, lhs);
 	}
 
 
 	PositionUpdate::PositionUpdate(EditorWindow& editor, std::vector<EntityId> entityUniqueIds, const Nz::Vector2f& offset) :
 	EntitiesCommand(editor, std::move(entityUniqueIds), "move entity"),
+	m_lastUpdate(std::chrono::steady_clock::now()),
 	m_offset(offset)
 	{
 	}
 
+	int PositionUpdate::id() const
+	{
+		return static_cast<int>(CommandId::PositionUpdate);
+	}
+
+	bool PositionUpdate::mergeWith(const QUndoCommand* command)
+	{
+		// Consecutive drags of the same selection are coalesced into a single undo step
+		const PositionUpdate* positionUpdate = static_cast<const PositionUpdate*>(command);
+		if (positionUpdate->m_entitiesUniqueId != m_entitiesUniqueId)
+			return false;
+
+		if (positionUpdate->m_lastUpdate - m_lastUpdate > MergeDelay)
+			return false;
+
+		m_lastUpdate = positionUpdate->m_lastUpdate;
+		m_offset += positionUpdate->m_offset;
+		return true;
+	}
+
 	void PositionUpdate::redo()
 	{
+		Map& map = m_editor.GetWorkingMapMut();
+
+		m_editor.BeginBatchEdit();
 		for (EntityId entityId : m_entitiesUniqueId)
 		{
-			Map& map = m_editor.GetWorkingMapMut();
 			const auto& indices = map.GetEntityIndices(entityId);
 
 			auto& entity = map.GetEntity(indices.layerIndex, indices.entityIndex);
@@ -228,13 +434,16 @@ namespace bw::Commands
 
 			m_editor.RefreshEntityPositionAndRotation(indices.layerIndex, indices.entityIndex);
 		}
+		m_editor.EndBatchEdit();
 	}
 
 	void PositionUpdate::undo()
 	{
+		Map& map = m_editor.GetWorkingMapMut();
+
+		m_editor.BeginBatchEdit();
 		for (EntityId entityId : m_entitiesUniqueId)
 		{
-			Map& map = m_editor.GetWorkingMapMut();
 			const auto& indices = map.GetEntityIndices(entityId);
 
 			auto& entity = map.GetEntity(indices.layerIndex, indices.entityIndex);
@@ -242,43 +451,48 @@ namespace bw::Commands
 
 			m_editor.RefreshEntityPositionAndRotation(indices.layerIndex, indices.entityIndex);
 		}
+		m_editor.EndBatchEdit();
 	}
 	
 	PrefabInstantiate::PrefabInstantiate(EditorWindow& editor, Map::EntityIndices entityIndices, std::vector<Map::Entity> entities) :
+	EditorCommand(editor, "instantiate prefab"),
 	m_entityData(std::move(entities)),
-	m_entityIndices(std::move(entityIndices)),
-	m_editor(editor)
+	m_entityIndices(std::move(entityIndices))
 	{
 		m_entityUniqueIds.reserve(m_entityData.size());
 		for (const auto& entity : m_entityData)
 			m_entityUniqueIds.push_back(entity.uniqueId);
+	}
+
+	std::size_t PrefabInstantiate::GetMemoryUsage() const
+	{
+		std::size_t memoryUsage = sizeof(*this) + m_entityUniqueIds.capacity() * sizeof(EntityId) + m_entityData.capacity() * sizeof(Map::Entity);
+		for (const Map::Entity& entity : m_entityData)
+			memoryUsage += EstimateMemoryUsage(entity);
 
-		setText("instantiate prefab");
+		return memoryUsage;
 	}
 	
 	void PrefabInstantiate::redo()
 	{
-		LayerIndex layerIndex = m_entityIndices.layerIndex;
-		std::size_t entityIndex = m_entityIndices.entityIndex;
-
 		assert(m_entityUniqueIds.size() == m_entityData.size());
-		for (std::size_t i = 0; i < m_entityData.size(); ++i)
-		{
-			auto& createdEntity = m_editor.CreateEntity(layerIndex, entityIndex++, std::move(m_entityData[i]));
-
-			NazaraUnused(createdEntity); //< Silent warnings in release
-			assert(createdEntity.uniqueId == m_entityUniqueIds[i]); //< Ensure entity wasn't given a new unique id
-		}
+		m_editor.CreateEntities(m_entityIndices.layerIndex, m_entityIndices.entityIndex, std::move(m_entityData));
 		m_entityData.clear();
+
+		// Ensure entities weren't given a new unique id
+		const Map& map = m_editor.GetWorkingMap();
+		NazaraUnused(map); //< Silent warnings in release
+
+		for (std::size_t i = 0; i < m_entityUniqueIds.size(); ++i)
+			assert(map.GetEntity(m_entityIndices.layerIndex, m_entityIndices.entityIndex + i).uniqueId == m_entityUniqueIds[i]);
 	}
 	
 	void PrefabInstantiate::undo()
 	{
 		assert(m_entityData.empty());
-		for (EntityId uniqueId : m_entityUniqueIds)
-		{
-			Map::Entity& entityData = m_entityData.emplace_back(m_editor.DeleteEntity(uniqueId));
-			assert(entityData.uniqueId == uniqueId);
-		}
+
+		// Prefab entities are contiguous, and still where they were created as every later command has been undone
+		m_entityData = m_editor.DeleteEntities(m_entityIndices.layerIndex, m_entityIndices.entityIndex, m_entityUniqueIds.size());
+		assert(m_entityData.size() == m_entityUniqueIds.size());
 	}
 }
@@ -8,9 +8,11 @@
 #define BURGWAR_MAPEDITOR_COMMANDS_ENTITY_HPP
 
 #include <CoreLib/Map.hpp>
+#include <MapEditor/Commands/EditorCommand.hpp>
 #include <MapEditor/Enums.hpp>
 #include <Nazara/Math/Vector2.hpp>
-#include <QtWidgets/QUndoCommand>
+#include <chrono>
+#include <optional>
 
 namespace bw
 {
@@ -18,14 +20,15 @@ namespace bw
 
 	namespace Commands
 	{
-		class EntitiesCommand : public QUndoCommand
+		class EntitiesCommand : public EditorCommand
 		{
 			public:
 				EntitiesCommand(EditorWindow& editor, std::vector<EntityId> entityUniqueIds, const QString& label);
 				~EntitiesCommand() = default;
 
+				std::size_t GetMemoryUsage() const override;
+
 			protected:
-				EditorWindow& m_editor;
 				std::vector<EntityId> m_entitiesUniqueId;
 		};
 
@@ -38,6 +41,8 @@ namespace bw
 				EntityCreationDelete(EditorWindow& editor, const QString& label, std::vector<EntityData> entitiesData);
 				~EntityCreationDelete() = default;
 
+				std::size_t GetMemoryUsage() const override;
+
 				struct EntityData
 				{
 					Map::Entity entity;
@@ -55,6 +60,24 @@ namespace bw
 
 				std::vector<EntityData> m_entitiesData;
 		};
+
+		class EntityAlign final : public EntitiesCommand
+		{
+			public:
+				EntityAlign(EditorWindow& editor, std::vector<EntityId> entityUniqueIds, std::vector<Nz::Vector2f> alignedPositions);
+				~EntityAlign() = default;
+
+				std::size_t GetMemoryUsage() const override;
+
+				void redo() override;
+				void undo() override;
+
+			private:
+				void Apply(const std::vector<Nz::Vector2f>& positions);
+
+				std::vector<Nz::Vector2f> m_alignedPositions;
+				std::vector<Nz::Vector2f> m_previousPositions;
+		};
 		
 		class EntityClone final : public EntityCreationDelete
 		{
@@ -109,13 +132,36 @@ namespace bw
 				EntityUpdate(EditorWindow& editor, EntityId entityUniqueId, Map::Entity update, EntityInfoUpdateFlags updateFlags);
 				~EntityUpdate() = default;
 
+				std::size_t GetMemoryUsage() const override;
+
 				void redo() override;
 				void undo() override;
 
 			private:
+				struct EntityState
+				{
+					std::string entityType;
+					std::string name;
+					Nz::DegreeAnglef rotation;
+					Nz::Vector2f position;
+				};
+
+				struct PropertyChange
+				{
+					std::string name;
+					std::optional<PropertyValue> previousValue; //< unset if the property was added
+					std::optional<PropertyValue> newValue; //< unset if the property was removed
+				};
+
+				void Apply(const EntityState& state, bool undo);
+
+				static bool ArePropertiesEqual(const PropertyValue& lhs, const PropertyValue& rhs);
+
+				// Only the fields selected by m_updateFlags are stored, along with changed properties
 				EntityInfoUpdateFlags m_updateFlags;
-				Map::Entity m_previousState;
-				Map::Entity m_newState;
+				EntityState m_previousState;
+				EntityState m_newState;
+				std::vector<PropertyChange> m_propertyChanges;
 		};
 
 		class PositionUpdate final : public EntitiesCommand
@@ -124,19 +170,27 @@ namespace bw
 				PositionUpdate(EditorWindow& editor, std::vector<EntityId> entityUniqueIds, const Nz::Vector2f& offset);
 				~PositionUpdate() = default;
 
+				int id() const override;
+				bool mergeWith(const QUndoCommand* command) override;
+
 				void redo() override;
 				void undo() override;
 
+				static constexpr std::chrono::milliseconds MergeDelay = std::chrono::milliseconds(1000);
+
 			private:
+				std::chrono::steady_clock::time_point m_lastUpdate;
 				Nz::Vector2f m_offset;
 		};
 
-		class PrefabInstantiate final : public QUndoCommand
+		class PrefabInstantiate final : public EditorCommand
 		{
 			public:
 				PrefabInstantiate(EditorWindow& editor, Map::EntityIndices entityIndices, std::vector<Map::Entity> entities);
 				~PrefabInstantiate() = default;
 
+				std::size_t GetMemoryUsage() const override;
+
 				void redo() override;
 				void undo() override;
 
@@ -144,7 +198,6 @@ namespace bw
 				std::vector<Map::Entity> m_entityData;
 				std::vector<EntityId> m_entityUniqueIds;
 				Map::EntityIndices m_entityIndices;
-				EditorWindow& m_editor;
 		};
 	}
 }
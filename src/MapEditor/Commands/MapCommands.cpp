@@ -8,13 +8,6 @@
 
 namespace bw::Commands
 {
-	MapCommand::MapCommand(EditorWindow& editor, const QString& label) :
-	m_editor(editor)
-	{
-		setText(label);
-	}
-
-	
 	EntitySwap::EntitySwap(EditorWindow& editor, LayerIndex layerIndex, std::size_t firstEntityIndex, std::size_t secondEntityIndex) :
 	MapCommand(editor, "entity reorder"),
 	m_firstEntityIndex(firstEntityIndex),
@@ -50,15 +43,26 @@ namespace bw::Commands
 		m_layerData = std::move(layer);
 	}
 
+	std::size_t LayerCreationDelete::GetMemoryUsage() const
+	{
+		std::size_t memoryUsage = sizeof(*this);
+		if (m_layerData)
+			memoryUsage += EstimateMemoryUsage(*m_layerData);
+
+		return memoryUsage;
+	}
+
 	void LayerCreationDelete::Create()
 	{
 		assert(m_layerData.has_value());
 		m_editor.CreateLayer(m_layerIndex, std::move(m_layerData.value()));
+		m_layerData.reset();
 	}
 
 	void LayerCreationDelete::Delete()
 	{
-		m_editor.DeleteLayer(m_layerIndex);
+		assert(!m_layerData.has_value());
+		m_layerData = m_editor.DeleteLayer(m_layerIndex);
 	}
 
 	
@@ -104,7 +108,7 @@ namespace bw::Commands
 	
 
 	LayerDelete::LayerDelete(EditorWindow& editor, LayerIndex layerIndex) :
-	LayerCreationDelete(editor, "delete entity", layerIndex, editor.GetWorkingMap().GetLayer(layerIndex))
+	LayerCreationDelete(editor, "delete layer", layerIndex)
 	{
 	}
 
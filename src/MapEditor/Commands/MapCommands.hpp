@@ -8,9 +8,9 @@
 #define BURGWAR_MAPEDITOR_COMMANDS_MAP_HPP
 
 #include <CoreLib/Map.hpp>
+#include <MapEditor/Commands/EditorCommand.hpp>
 #include <MapEditor/Enums.hpp>
 #include <Nazara/Math/Vector2.hpp>
-#include <QtWidgets/QUndoCommand>
 
 namespace bw
 {
@@ -18,14 +18,11 @@ namespace bw
 
 	namespace Commands
 	{
-		class MapCommand : public QUndoCommand
+		class MapCommand : public EditorCommand
 		{
 			public:
-				MapCommand(EditorWindow& editor, const QString& label);
+				using EditorCommand::EditorCommand;
 				~MapCommand() = default;
-
-			protected:
-				EditorWindow& m_editor;
 		};
 		
 		class EntitySwap final : public MapCommand
@@ -52,12 +49,14 @@ namespace bw
 				LayerCreationDelete(EditorWindow& editor, const QString& label, LayerIndex layerIndex, Map::Layer layer);
 				~LayerCreationDelete() = default;
 
+				std::size_t GetMemoryUsage() const override;
+
 			protected:
 				void Create();
 				void Delete();
 
 			private:
-				std::optional<Map::Layer> m_layerData;
+				std::optional<Map::Layer> m_layerData; //< only held while the layer doesn't exist in the map
 				LayerIndex m_layerIndex;
 		};
 		
@@ -0,0 +1,43 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <MapEditor/Commands/TileMapCommands.hpp>
+#include <MapEditor/Logic/TileMapEditorMode.hpp>
+
+namespace bw::Commands
+{
+	TileMapUpdate::TileMapUpdate(EditorWindow& editor, std::weak_ptr<TileMapEditorMode> editorMode, std::vector<TileRange> ranges) :
+	EditorCommand(editor, "paint tiles"),
+	m_ranges(std::move(ranges)),
+	m_editorMode(std::move(editorMode))
+	{
+	}
+
+	std::size_t TileMapUpdate::GetMemoryUsage() const
+	{
+		std::size_t memoryUsage = sizeof(*this) + m_ranges.capacity() * sizeof(TileRange);
+		for (const TileRange& range : m_ranges)
+			memoryUsage += (range.previousContent.capacity() + range.newContent.capacity()) * sizeof(Nz::UInt32);
+
+		return memoryUsage;
+	}
+
+	void TileMapUpdate::redo()
+	{
+		if (std::shared_ptr<TileMapEditorMode> editorMode = m_editorMode.lock())
+		{
+			for (const TileRange& range : m_ranges)
+				editorMode->UpdateTiles(range.firstTile, range.newContent);
+		}
+	}
+
+	void TileMapUpdate::undo()
+	{
+		if (std::shared_ptr<TileMapEditorMode> editorMode = m_editorMode.lock())
+		{
+			for (const TileRange& range : m_ranges)
+				editorMode->UpdateTiles(range.firstTile, range.previousContent);
+		}
+	}
+}
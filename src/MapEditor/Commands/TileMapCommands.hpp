@@ -0,0 +1,49 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_MAPEDITOR_COMMANDS_TILEMAP_HPP
+#define BURGWAR_MAPEDITOR_COMMANDS_TILEMAP_HPP
+
+#include <MapEditor/Commands/EditorCommand.hpp>
+#include <Nazara/Prerequisites.hpp>
+#include <memory>
+#include <vector>
+
+namespace bw
+{
+	class TileMapEditorMode;
+
+	namespace Commands
+	{
+		// A paint stroke in the tilemap editor, only changed tiles are stored (as contiguous ranges of tile indices)
+		class TileMapUpdate final : public EditorCommand
+		{
+			public:
+				struct TileRange;
+
+				TileMapUpdate(EditorWindow& editor, std::weak_ptr<TileMapEditorMode> editorMode, std::vector<TileRange> ranges);
+				~TileMapUpdate() = default;
+
+				std::size_t GetMemoryUsage() const override;
+
+				void redo() override;
+				void undo() override;
+
+				struct TileRange
+				{
+					std::size_t firstTile;
+					std::vector<Nz::UInt32> previousContent;
+					std::vector<Nz::UInt32> newContent;
+				};
+
+			private:
+				std::vector<TileRange> m_ranges;
+				std::weak_ptr<TileMapEditorMode> m_editorMode; //< commands outliving the edition session do nothing
+		};
+	}
+}
+
+#endif
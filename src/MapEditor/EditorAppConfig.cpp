@@ -10,6 +10,9 @@ namespace bw
 	EditorAppConfig::EditorAppConfig(EditorWindow& app) :
 	SharedAppConfig(app)
 	{
+		RegisterIntegerOption("Editor.AutosaveInterval", 0, 24 * 60 * 60, 300); //< in seconds, 0 disables autosave
+		RegisterIntegerOption("Editor.UndoLimit", 0, 100'000, 500);
+		RegisterIntegerOption("Editor.UndoMemoryBudget", 1, 16'384, 256); //< in MiB
 		RegisterStringOption("Resources.EditorDirectory");
 	}
 }
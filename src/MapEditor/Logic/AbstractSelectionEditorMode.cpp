@@ -34,10 +34,13 @@ namespace bw
 
 				Nz::Rayf ray(start, end - start);
 
+				// Only entities around the ray (a point with an orthographic camera) need to be tested
+				Nz::Rectf rayRect(Nz::Vector2f(start.x, start.y), Nz::Vector2f(end.x, end.y));
+
 				LayerVisualEntity* bestEntity = nullptr;
 				float bestEntityArea = std::numeric_limits<float>::infinity();
 
-				layer->ForEachVisualEntity([&](LayerVisualEntity& entity)
+				layer->ForEachVisualEntityInRect(rayRect, [&](LayerVisualEntity& entity)
 				{
 					const Nz::Boxf& box = entity.GetGlobalBounds();
 
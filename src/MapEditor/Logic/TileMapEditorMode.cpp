@@ -3,6 +3,7 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <MapEditor/Logic/TileMapEditorMode.hpp>
+#include <MapEditor/Commands/TileMapCommands.hpp>
 #include <MapEditor/Logic/BasicEditorMode.hpp>
 #include <MapEditor/Widgets/EditorWindow.hpp>
 #include <MapEditor/Widgets/MapCanvas.hpp>
@@ -13,6 +14,7 @@
 #include <NDK/Components/NodeComponent.hpp>
 #include <QtWidgets/QDockWidget>
 #include <QtWidgets/QMessageBox>
+#include <algorithm>
 
 namespace bw
 {
@@ -166,37 +168,51 @@ namespace bw
 		for (const auto& tilesetGroup : m_tilesetGroups)
 			materialCount += tilesetGroup.materials.size();
 
-		m_tileMap = Nz::TileMap::New(m_tilemapData.mapSize, m_tilemapData.tileSize, materialCount);
+		auto& tileMapNode = m_tilemapEntity->AddComponent<Ndk::NodeComponent>();
+		tileMapNode.SetPosition(m_tilemapData.origin);
+		tileMapNode.SetRotation(m_tilemapData.rotation);
 
-		std::size_t materialIndex = 0;
-		for (const auto& tilesetGroup : m_tilesetGroups)
+		auto& tileMapGraphics = m_tilemapEntity->AddComponent<Ndk::GraphicsComponent>();
+
+		// Split tilemap in chunks so painting a tile only rebuilds the chunk owning it
+		m_chunkCount.x = (m_tilemapData.mapSize.x + ChunkSize - 1) / ChunkSize;
+		m_chunkCount.y = (m_tilemapData.mapSize.y + ChunkSize - 1) / ChunkSize;
+
+		m_chunks.reserve(m_chunkCount.x * m_chunkCount.y);
+		for (unsigned int chunkY = 0; chunkY < m_chunkCount.y; ++chunkY)
 		{
-			for (const auto& mat : tilesetGroup.materials)
-				m_tileMap->SetMaterial(materialIndex++, mat.material);
+			for (unsigned int chunkX = 0; chunkX < m_chunkCount.x; ++chunkX)
+			{
+				Nz::Vector2ui chunkSize(std::min(ChunkSize, m_tilemapData.mapSize.x - chunkX * ChunkSize), std::min(ChunkSize, m_tilemapData.mapSize.y - chunkY * ChunkSize));
+
+				Nz::TileMapRef& chunk = m_chunks.emplace_back(Nz::TileMap::New(chunkSize, m_tilemapData.tileSize, materialCount));
+
+				std::size_t materialIndex = 0;
+				for (const auto& tilesetGroup : m_tilesetGroups)
+				{
+					for (const auto& mat : tilesetGroup.materials)
+						chunk->SetMaterial(materialIndex++, mat.material);
+				}
+
+				Nz::Vector2f chunkOffset = Nz::Vector2f(Nz::Vector2ui(chunkX, chunkY) * ChunkSize) * m_tilemapData.tileSize;
+				tileMapGraphics.Attach(chunk, Nz::Matrix4f::Translate(chunkOffset), 1);
+			}
 		}
 
 		m_tilemapData.content.resize(m_tilemapData.mapSize.x * m_tilemapData.mapSize.y);
 		for (std::size_t i = 0; i < m_tilemapData.content.size(); ++i)
 		{
 			Nz::UInt32 value = m_tilemapData.content[i];
-			
-			Nz::Vector2ui tilePos = { static_cast<unsigned int>(i % m_tilemapData.mapSize.x), static_cast<unsigned int>(i / m_tilemapData.mapSize.x) };
 			if (value > 0)
 			{
 				assert(value - 1 < m_tiles.size());
+				Nz::Vector2ui tilePos = { static_cast<unsigned int>(i % m_tilemapData.mapSize.x), static_cast<unsigned int>(i / m_tilemapData.mapSize.x) };
 
 				const auto& tileData = m_tiles[value - 1];
-				m_tileMap->EnableTile(tilePos, tileData.texCoords, Nz::Color::White, tileData.materialIndex);
+				m_chunks[(tilePos.y / ChunkSize) * m_chunkCount.x + tilePos.x / ChunkSize]->EnableTile({ tilePos.x % ChunkSize, tilePos.y % ChunkSize }, tileData.texCoords, Nz::Color::White, tileData.materialIndex);
 			}
 		}
 
-		auto& tileMapNode = m_tilemapEntity->AddComponent<Ndk::NodeComponent>();
-		tileMapNode.SetPosition(m_tilemapData.origin);
-		tileMapNode.SetRotation(m_tilemapData.rotation);
-
-		auto& tileMapGraphics = m_tilemapEntity->AddComponent<Ndk::GraphicsComponent>();
-		tileMapGraphics.Attach(m_tileMap, 1);
-
 		m_tileSelectionEntity = mapCanvas->GetWorld().CreateEntity();
 
 		m_tileSelectionEntity->AddComponent<Ndk::NodeComponent>();
@@ -211,7 +227,11 @@ namespace bw
 
 		m_tileEditorWidget->deleteLater();
 
-		m_tileMap.Reset();
+		m_editionMode = EditionMode::None;
+		m_lastAppliedTile.reset();
+		m_strokePreviousContent.clear();
+
+		m_chunks.clear();
 		m_tileSelectionEntity.Reset();
 		m_tilemapEntity.Reset();
 	}
@@ -222,6 +242,7 @@ namespace bw
 			return;
 
 		m_editionMode = (m_clearMode) ? EditionMode::DisableTile : EditionMode::EnableTile;
+		m_lastAppliedTile.reset();
 
 		if (std::optional<Nz::Vector2ui> tilePosition = GetTilePositionFromMouse(mouseButton.x, mouseButton.y))
 			ApplyTile(tilePosition);
@@ -233,6 +254,9 @@ namespace bw
 			return;
 
 		m_editionMode = EditionMode::None;
+		m_lastAppliedTile.reset();
+
+		CommitStroke();
 	}
 
 	void TileMapEditorMode::OnMouseEntered()
@@ -269,19 +293,36 @@ namespace bw
 			m_tileSelectionEntity->Disable();
 	}
 	
+	void TileMapEditorMode::UpdateTiles(std::size_t firstTile, const std::vector<Nz::UInt32>& content)
+	{
+		// Edition session may be over
+		if (m_chunks.empty())
+			return;
+
+		assert(firstTile + content.size() <= m_tilemapData.content.size());
+		for (std::size_t i = 0; i < content.size(); ++i)
+		{
+			std::size_t tileIndex = firstTile + i;
+			Nz::Vector2ui tilePos = { static_cast<unsigned int>(tileIndex % m_tilemapData.mapSize.x), static_cast<unsigned int>(tileIndex / m_tilemapData.mapSize.x) };
+
+			SetTile(tilePos, content[i]);
+		}
+	}
+
 	void TileMapEditorMode::ApplyTile(std::optional<Nz::Vector2ui> tilePosition)
 	{
+		// Mouse moves inside the same tile don't change anything
+		if (m_editionMode == EditionMode::None || tilePosition == m_lastAppliedTile)
+			return;
+
+		m_lastAppliedTile = tilePosition;
+
 		switch (m_editionMode)
 		{
 			case EditionMode::DisableTile:
 			{
 				assert(tilePosition);
-				m_tileMap->DisableTile(*tilePosition);
-
-				std::size_t tileIndex = tilePosition->y * m_tilemapData.mapSize.x + tilePosition->x;
-
-				assert(tileIndex < m_tilemapData.content.size());
-				m_tilemapData.content[tileIndex] = 0;
+				SetTile(*tilePosition, 0);
 				break;
 			}
 
@@ -299,16 +340,9 @@ namespace bw
 						std::size_t tileDataIndex = m_selection.tiles[y * m_selection.width + x];
 
 						assert(tileDataIndex < m_tiles.size());
-						const auto& tileData = m_tiles[tileDataIndex];
-
 						Nz::Vector2ui position(tilePosition->x + static_cast<unsigned int>(x), tilePosition->y + static_cast<unsigned int>(y));
 
-						m_tileMap->EnableTile(position, tileData.texCoords, Nz::Color::White, tileData.materialIndex);
-
-						std::size_t tileIndex = position.y * m_tilemapData.mapSize.x + position.x;
-
-						assert(tileIndex < m_tilemapData.content.size());
-						m_tilemapData.content[tileIndex] = static_cast<Nz::UInt32>(tileDataIndex + 1);
+						SetTile(position, static_cast<Nz::UInt32>(tileDataIndex + 1));
 					}
 				}
 
@@ -321,6 +355,41 @@ namespace bw
 		}
 	}
 
+	void TileMapEditorMode::CommitStroke()
+	{
+		if (m_strokePreviousContent.empty())
+			return;
+
+		std::vector<std::size_t> tileIndices;
+		tileIndices.reserve(m_strokePreviousContent.size());
+		for (auto&& [tileIndex, previousValue] : m_strokePreviousContent)
+			tileIndices.push_back(tileIndex);
+
+		std::sort(tileIndices.begin(), tileIndices.end());
+
+		// Group changed tiles in contiguous ranges, tiles painted back to their previous value are skipped
+		std::vector<Commands::TileMapUpdate::TileRange> ranges;
+		for (std::size_t tileIndex : tileIndices)
+		{
+			Nz::UInt32 previousValue = m_strokePreviousContent[tileIndex];
+			Nz::UInt32 newValue = m_tilemapData.content[tileIndex];
+			if (previousValue == newValue)
+				continue;
+
+			if (ranges.empty() || ranges.back().firstTile + ranges.back().newContent.size() != tileIndex)
+				ranges.emplace_back().firstTile = tileIndex;
+
+			auto& range = ranges.back();
+			range.previousContent.push_back(previousValue);
+			range.newContent.push_back(newValue);
+		}
+
+		m_strokePreviousContent.clear();
+
+		if (!ranges.empty())
+			GetEditorWindow().PushCommand<Commands::TileMapUpdate>(std::static_pointer_cast<TileMapEditorMode>(shared_from_this()), std::move(ranges));
+	}
+
 	std::optional<Nz::Vector2ui> TileMapEditorMode::GetTilePositionFromMouse(int mouseX, int mouseY) const
 	{
 		const MapCanvas* canvas = GetEditorWindow().GetMapCanvas();
@@ -340,6 +409,35 @@ namespace bw
 			return std::nullopt;
 	}
 
+	void TileMapEditorMode::SetTile(const Nz::Vector2ui& tilePosition, Nz::UInt32 value)
+	{
+		std::size_t tileIndex = tilePosition.y * m_tilemapData.mapSize.x + tilePosition.x;
+		assert(tileIndex < m_tilemapData.content.size());
+
+		Nz::UInt32& currentValue = m_tilemapData.content[tileIndex];
+		if (currentValue == value)
+			return;
+
+		// Remember the value the tile had when the stroke began, for the undo command
+		if (m_editionMode != EditionMode::None)
+			m_strokePreviousContent.emplace(tileIndex, currentValue);
+
+		currentValue = value;
+
+		Nz::TileMap& chunk = *m_chunks[(tilePosition.y / ChunkSize) * m_chunkCount.x + tilePosition.x / ChunkSize];
+		Nz::Vector2ui chunkTilePos(tilePosition.x % ChunkSize, tilePosition.y % ChunkSize);
+
+		if (value > 0)
+		{
+			assert(value - 1 < m_tiles.size());
+
+			const auto& tileData = m_tiles[value - 1];
+			chunk.EnableTile(chunkTilePos, tileData.texCoords, Nz::Color::White, tileData.materialIndex);
+		}
+		else
+			chunk.DisableTile(chunkTilePos);
+	}
+
 	void TileMapEditorMode::UpdateSelection(std::size_t width, std::size_t height, const std::vector<TileSelectionWidget::TileSelection>& selectedTiles)
 	{
 		m_tileSelectionEntity->Disable();
@@ -16,7 +16,9 @@
 #include <Nazara/Graphics/TileMap.hpp>
 #include <Nazara/Platform/Cursor.hpp>
 #include <NDK/EntityOwner.hpp>
+#include <tsl/hopscotch_map.h>
 #include <optional>
+#include <vector>
 
 class QDockWidget;
 
@@ -40,6 +42,10 @@ namespace bw
 			void OnMouseEntered() override;
 			void OnMouseMoved(const Nz::WindowEvent::MouseMoveEvent& mouseMoved) override;
 
+			void UpdateTiles(std::size_t firstTile, const std::vector<Nz::UInt32>& content);
+
+			static constexpr unsigned int ChunkSize = 32;
+
 			NazaraSignal(OnEditionCancelled, TileMapEditorMode* /*editorMode*/);
 			NazaraSignal(OnEditionFinished, TileMapEditorMode* /*editorMode*/, const TileMapData& /*tileMapData*/);
 
@@ -47,7 +53,9 @@ namespace bw
 			struct SelectedTiles;
 
 			void ApplyTile(std::optional<Nz::Vector2ui> tilePosition);
+			void CommitStroke();
 			std::optional<Nz::Vector2ui> GetTilePositionFromMouse(int mouseX, int mouseY) const;
+			void SetTile(const Nz::Vector2ui& tilePosition, Nz::UInt32 value);
 			void UpdateSelection(std::size_t width, std::size_t height, const std::vector<TileSelectionWidget::TileSelection>& selectedTiles);
 
 			enum class EditionMode
@@ -72,12 +80,15 @@ namespace bw
 
 			SelectedTiles m_selection;
 			std::vector<TileSelectionWidget::TilesetGroup> m_tilesetGroups;
+			std::optional<Nz::Vector2ui> m_lastAppliedTile;
 			std::vector<Tiles> m_tiles;
+			std::vector<Nz::TileMapRef> m_chunks; //< row-major, each chunk is rebuilt separately
+			tsl::hopscotch_map<std::size_t /*tileIndex*/, Nz::UInt32 /*previousValue*/> m_strokePreviousContent;
 			Ndk::EntityOwner m_tileSelectionEntity;
 			Ndk::EntityOwner m_tilemapEntity;
 			Nz::CursorRef m_eraserCursor;
 			Nz::SpriteRef m_hoveringTileSprite;
-			Nz::TileMapRef m_tileMap;
+			Nz::Vector2ui m_chunkCount;
 			EditionMode m_editionMode;
 			TileMapData m_tilemapData;
 			QDockWidget* m_tileEditorWidget;
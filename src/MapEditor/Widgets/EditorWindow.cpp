@@ -10,6 +10,7 @@
 #include <ClientLib/Components/VisualComponent.hpp>
 #include <ClientLib/Components/ClientMatchComponent.hpp>
 #include <ClientLib/Components/SoundEmitterComponent.hpp>
+#include <MapEditor/Commands/EditorCommand.hpp>
 #include <MapEditor/Commands/EntityCommands.hpp>
 #include <MapEditor/Commands/MapCommands.hpp>
 #include <MapEditor/Components/CanvasComponent.hpp>
@@ -24,6 +25,7 @@
 #include <NDK/Components/NodeComponent.hpp>
 #include <QtCore/QSettings>
 #include <QtCore/QStringBuilder>
+#include <QtCore/QTimer>
 #include <QtGui/QKeyEvent>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QCommonStyle>
@@ -59,15 +61,24 @@ namespace bw
 	m_playWindow(nullptr),
 	m_configFile(*this),
 	m_prefabs(this),
+	m_batchEditCounter(0),
+	m_autosavedRevision(0),
+	m_mapRevision(0),
+	m_isEntityListRefreshPending(false),
+	m_isMapTaskRunning(false),
 	m_mapDirtyFlag(false)
 	{
 		if (!m_configFile.LoadFromFile("editorconfig.lua"))
 			throw std::runtime_error("failed to load config file");
 
+		m_undoMemoryBudget = m_config.GetIntegerValue<std::size_t>("Editor.UndoMemoryBudget") * 1024 * 1024;
+		m_undoStack.setUndoLimit(m_config.GetIntegerValue<int>("Editor.UndoLimit"));
+
 		Ndk::InitializeComponent<CanvasComponent>("CanvsCmp");
 
 		LoadMods();
 		FillStores();
+		FillMatchStores();
 
 		const std::string& editorAssetsFolder = m_config.GetStringValue("Resources.EditorDirectory");
 
@@ -188,11 +199,19 @@ namespace bw
 		m_showColliders->setChecked(settings.value(settings_showColliders, false).toBool());
 		m_showGrid->setChecked(settings.value(settings_showGrid, true).toBool());
 
+		m_autosaveTimer = new QTimer(this);
+		connect(m_autosaveTimer, &QTimer::timeout, this, &EditorWindow::OnAutosave);
+
+		if (int autosaveInterval = m_config.GetIntegerValue<int>("Editor.AutosaveInterval"); autosaveInterval > 0)
+			m_autosaveTimer->start(autosaveInterval * 1000);
+
 		statusBar()->showMessage(tr("Ready"), 0);
 	}
 
 	EditorWindow::~EditorWindow()
 	{
+		WaitForMapTask();
+
 		m_currentMode->OnLeave();
 		m_currentMode.reset();
 
@@ -200,6 +219,12 @@ namespace bw
 		delete m_canvas;
 	}
 
+	void EditorWindow::BeginBatchEdit()
+	{
+		m_batchEditCounter++;
+		m_canvas->BeginBatchEdit();
+	}
+
 	void EditorWindow::ClearSelectedEntity()
 	{
 		m_entityList.listWidget->clearSelection();
@@ -210,6 +235,50 @@ namespace bw
 		UpdateWorkingMap(Map());
 	}
 
+	void EditorWindow::CreateEntities(LayerIndex layerIndex, std::size_t firstEntityIndex, std::vector<Map::Entity> entities)
+	{
+		std::size_t entityCount = entities.size();
+
+		Map& map = GetWorkingMapMut();
+		map.EmplaceEntities(layerIndex, firstEntityIndex, std::move(entities));
+
+		const auto& layer = map.GetLayer(layerIndex);
+
+		BeginBatchEdit();
+		for (std::size_t i = 0; i < entityCount; ++i)
+		{
+			const Map::Entity& newEntity = layer.entities[firstEntityIndex + i];
+			m_canvas->CreateEntity(layerIndex, newEntity.uniqueId, newEntity.entityType, newEntity.position, newEntity.rotation, newEntity.properties);
+		}
+		EndBatchEdit();
+
+		if (m_currentLayer == layerIndex)
+		{
+			// Same as RegisterEntity, but following entries are only shifted once
+			for (auto it = m_entityIndices.begin(); it != m_entityIndices.end(); ++it)
+			{
+				if (it->second >= firstEntityIndex)
+					it.value() += entityCount;
+			}
+
+			for (std::size_t i = 0; i < entityCount; ++i)
+			{
+				std::size_t entityIndex = firstEntityIndex + i;
+				const Map::Entity& entity = layer.entities[entityIndex];
+
+				QString entryName = QString::fromStdString(entity.entityType);
+				if (!entity.name.empty())
+					entryName = entryName % " (" % QString::fromStdString(entity.name) % ")";
+
+				m_entityList.listWidget->insertItem(int(entityIndex), entryName);
+				m_entityIndices.emplace(entity.uniqueId, entityIndex);
+			}
+
+			for (int i = int(firstEntityIndex); i < m_entityList.listWidget->count(); ++i)
+				m_entityList.listWidget->item(i)->setData(Qt::UserRole, qulonglong(i));
+		}
+	}
+
 	Map::Entity& EditorWindow::CreateEntity(LayerIndex layerIndex, std::size_t entityIndex, Map::Entity entityData)
 	{
 		auto& newEntity = GetWorkingMapMut().EmplaceEntity(layerIndex, entityIndex, std::move(entityData));
@@ -230,6 +299,41 @@ namespace bw
 		return layer;
 	}
 
+	std::vector<Map::Entity> EditorWindow::DeleteEntities(LayerIndex layerIndex, std::size_t firstEntityIndex, std::size_t entityCount)
+	{
+		const Map& map = GetWorkingMap();
+		const auto& layer = map.GetLayer(layerIndex);
+		assert(firstEntityIndex + entityCount <= layer.entities.size());
+
+		if (m_currentLayer == layerIndex)
+		{
+			// Same as DeleteEntity, but following entries are only shifted once
+			for (std::size_t i = entityCount; i-- > 0;)
+			{
+				std::size_t entityIndex = firstEntityIndex + i;
+
+				delete m_entityList.listWidget->takeItem(int(entityIndex));
+				m_entityIndices.erase(layer.entities[entityIndex].uniqueId);
+			}
+
+			for (auto it = m_entityIndices.begin(); it != m_entityIndices.end(); ++it)
+			{
+				if (it->second >= firstEntityIndex)
+					it.value() -= entityCount;
+			}
+
+			for (int i = int(firstEntityIndex); i < m_entityList.listWidget->count(); ++i)
+				m_entityList.listWidget->item(i)->setData(Qt::UserRole, qulonglong(i));
+		}
+
+		BeginBatchEdit();
+		for (std::size_t i = 0; i < entityCount; ++i)
+			m_canvas->DeleteEntity(layer.entities[firstEntityIndex + i].uniqueId);
+		EndBatchEdit();
+
+		return GetWorkingMapMut().DropEntities(layerIndex, firstEntityIndex, entityCount);
+	}
+
 	Map::Entity EditorWindow::DeleteEntity(EntityId entityId)
 	{
 		const auto& layerEntity = m_canvas->RetrieveLayerEntityByUniqueId(entityId);
@@ -279,6 +383,25 @@ namespace bw
 		return layer;
 	}
 
+	void EditorWindow::EndBatchEdit()
+	{
+		assert(m_batchEditCounter > 0);
+		m_canvas->EndBatchEdit();
+
+		if (--m_batchEditCounter > 0)
+			return;
+
+		if (m_isEntityListRefreshPending)
+		{
+			// Trigger selection signal once for every updated entity
+			int currentRow = m_entityList.listWidget->currentRow();
+			m_entityList.listWidget->setCurrentRow(-1);
+			m_entityList.listWidget->setCurrentRow(currentRow);
+
+			m_isEntityListRefreshPending = false;
+		}
+	}
+
 	Nz::Vector2f EditorWindow::GetCameraCenter() const
 	{
 		const Camera& camera = m_canvas->GetCamera();
@@ -396,9 +519,20 @@ namespace bw
 		contextMenu.exec(pos);
 	}
 
-	void EditorWindow::PushCommand(QUndoCommand* command)
+	void EditorWindow::PushCommand(Commands::EditorCommand* command)
 	{
-		m_undoStack.push(command);
+		m_undoStack.push(command); //< command may be merged (and deleted) here
+
+		// QUndoStack can only drop its oldest commands through its undo limit, clear the whole history instead of letting it grow past the budget
+		std::size_t memoryUsage = 0;
+		for (int i = 0; i < m_undoStack.count(); ++i)
+			memoryUsage += static_cast<const Commands::EditorCommand*>(m_undoStack.command(i))->GetMemoryUsage();
+
+		if (memoryUsage > m_undoMemoryBudget)
+		{
+			bwLog(GetLogger(), LogLevel::Warning, "undo history is using {0} MiB which is over the budget, clearing it", memoryUsage / (1024 * 1024));
+			m_undoStack.clear();
+		}
 	}
 
 	void EditorWindow::RefreshEntityPositionAndRotation(LayerIndex layerIndex, std::size_t entityIndex)
@@ -496,6 +630,8 @@ namespace bw
 		m_currentMode->OnLeave();
 		m_currentMode = std::move(editorMode);
 		m_currentMode->OnEnter();
+
+		m_canvas->RequestRedraw(); //< modes may add or remove their own entities
 	}
 
 	void EditorWindow::ToggleEntitySelection(std::size_t entityIndex)
@@ -556,8 +692,13 @@ namespace bw
 			// Trigger selection signal
 			if (item->isSelected())
 			{
-				m_entityList.listWidget->setCurrentRow(-1);
-				m_entityList.listWidget->setCurrentRow(int(entityIndex));
+				if (m_batchEditCounter > 0)
+					m_isEntityListRefreshPending = true;
+				else
+				{
+					m_entityList.listWidget->setCurrentRow(-1);
+					m_entityList.listWidget->setCurrentRow(int(entityIndex));
+				}
 			}
 		}
 	}
@@ -568,6 +709,8 @@ namespace bw
 		m_workingMap = std::move(map);
 		m_workingMapPath = std::move(mapPath);
 		m_mapDirtyFlag = false;
+		m_mapRevision++;
+		m_autosavedRevision = m_mapRevision;
 
 		// Reset entity info dialog (as it depends on the map)
 		if (m_entityInfoDialog)
@@ -686,15 +829,24 @@ namespace bw
 
 	void EditorWindow::AlignLayerEntities(LayerIndex layerIndex)
 	{
-		auto& layer = GetWorkingMapMut().GetLayer(layerIndex);
-		for (auto& layerEntity : layer.entities)
-			layerEntity.position = AlignPosition(layerEntity.position, layer.positionAlignment);
+		const auto& layer = GetWorkingMap().GetLayer(layerIndex);
 
-		for (std::size_t i = 0; i < layer.entities.size(); ++i)
+		std::vector<EntityId> entityUniqueIds;
+		std::vector<Nz::Vector2f> alignedPositions;
+		for (const auto& layerEntity : layer.entities)
 		{
-			const auto& layerEntity = layer.entities[i];
-			m_canvas->UpdateEntityPositionAndRotation(layerEntity.uniqueId, layerEntity.position, layerEntity.rotation);
+			Nz::Vector2f alignedPosition = AlignPosition(layerEntity.position, layer.positionAlignment);
+			if (alignedPosition == layerEntity.position)
+				continue;
+
+			entityUniqueIds.push_back(layerEntity.uniqueId);
+			alignedPositions.push_back(alignedPosition);
 		}
+
+		if (entityUniqueIds.empty())
+			return;
+
+		PushCommand<Commands::EntityAlign>(std::move(entityUniqueIds), std::move(alignedPositions));
 	}
 
 	void EditorWindow::BuildAssetList()
@@ -1046,7 +1198,7 @@ namespace bw
 		if (response == QMessageBox::Yes)
 		{
 			// Save before exit
-			if (!SaveMap())
+			if (!SaveMap(true))
 				return false; //< Save failed, do not close
 		}
 
@@ -1064,6 +1216,7 @@ namespace bw
 	void EditorWindow::InvalidateMap()
 	{
 		m_mapDirtyFlag = true;
+		m_mapRevision++;
 		m_saveMapToolbar->setEnabled(true);
 	}
 
@@ -1107,6 +1260,41 @@ namespace bw
 			AlignLayerEntities(currentLayerIndex);
 	}
 
+	void EditorWindow::OnAutosave()
+	{
+		// Autosave goes to its own subfolder and doesn't count as a save, it's only there to recover from a crash
+		if (!m_mapDirtyFlag || m_workingMapPath.empty() || m_autosavedRevision == m_mapRevision)
+			return;
+
+		// Don't block the UI waiting for a compilation or a save to finish, try again on next tick
+		if (m_isMapTaskRunning)
+			return;
+
+		std::filesystem::path autosavePath = m_workingMapPath / "autosave";
+		Nz::UInt64 revision = m_mapRevision;
+
+		RunMapTask(std::make_shared<Map>(m_workingMap), [autosavePath](Map& map)
+		{
+			std::error_code err;
+			std::filesystem::create_directories(autosavePath, err);
+
+			return map.Save(autosavePath);
+		},
+		[this, autosavePath, revision](bool succeeded)
+		{
+			if (succeeded)
+			{
+				m_autosavedRevision = revision;
+				statusBar()->showMessage(tr("Map autosaved"), 3000);
+			}
+			else
+			{
+				bwLog(GetLogger(), LogLevel::Warning, "failed to autosave map to {0}", autosavePath.generic_u8string());
+				statusBar()->showMessage(tr("Failed to autosave map"), 5000);
+			}
+		});
+	}
+
 	void EditorWindow::OnCloneEntity(std::size_t entityIndex)
 	{
 		assert(m_currentLayer);
@@ -1148,13 +1336,29 @@ namespace bw
 		if (QMessageBox::question(this, tr("Build asset list?"), tr("Do you want to rebuild asset list before compiling map?"), QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes)
 			BuildAssetList();
 
-		Map scriptedMap = GetWorkingMap();
-		AddScriptsToMap(scriptedMap);
+		std::shared_ptr<Map> scriptedMap = std::make_shared<Map>(GetWorkingMap());
+		if (!m_workingMapPath.empty())
+			AddScriptsToMap(*scriptedMap);
 
-		if (scriptedMap.Compile(fileName.toStdString()))
-			QMessageBox::information(this, tr("Compilation succeeded"), tr("Map has been successfully compiled"), QMessageBox::Ok);
-		else
-			QMessageBox::critical(this, tr("Failed to compile map"), tr("Map failed to compile"), QMessageBox::Ok);
+		m_compileMap->setEnabled(false);
+		statusBar()->showMessage(tr("Compiling map..."), 0);
+
+		// Serializing and compressing sections is the expensive part, run it out of the UI thread
+		std::filesystem::path outputPath = fileName.toStdString();
+		RunMapTask(std::move(scriptedMap), [outputPath](Map& map)
+		{
+			return map.Compile(outputPath);
+		},
+		[this](bool succeeded)
+		{
+			m_compileMap->setEnabled(m_workingMap.IsValid());
+			statusBar()->clearMessage();
+
+			if (succeeded)
+				QMessageBox::information(this, tr("Compilation succeeded"), tr("Map has been successfully compiled"), QMessageBox::Ok);
+			else
+				QMessageBox::critical(this, tr("Failed to compile map"), tr("Map failed to compile"), QMessageBox::Ok);
+		});
 	}
 
 	void EditorWindow::OnCreateEntity()
@@ -1509,6 +1713,7 @@ namespace bw
 	void EditorWindow::OnPerspectiveSwitch(bool enable)
 	{
 		m_canvas->GetCamera().EnablePerspective(enable);
+		m_canvas->RequestRedraw();
 	}
 
 	void EditorWindow::OnPlayMap()
@@ -1525,7 +1730,7 @@ namespace bw
 		if (!m_workingMapPath.empty())
 			AddScriptsToMap(scriptedMap);
 
-		m_playWindow = new PlayWindow(*this, scriptedMap, tickRate);
+		m_playWindow = new PlayWindow(*this, scriptedMap, tickRate, &m_canvas->GetAssetStore());
 		m_playWindow->resize(1280, 720);
 		m_playWindow->show();
 
@@ -1634,7 +1839,27 @@ namespace bw
 		m_entityIndices.emplace(entity.uniqueId, entityIndex);
 	}
 
-	bool EditorWindow::SaveMap()
+	void EditorWindow::RunMapTask(std::shared_ptr<Map> map, std::function<bool(Map& map)> task, std::function<void(bool succeeded)> onCompletion)
+	{
+		// Only one task at a time, so two of them never write the same files
+		WaitForMapTask();
+
+		m_isMapTaskRunning = true;
+
+		// The task works on its own copy of the map, leaving the working map free to be edited in the meantime
+		m_mapTaskThread = std::thread([this, map = std::move(map), task = std::move(task), onCompletion = std::move(onCompletion)]()
+		{
+			bool succeeded = task(*map);
+
+			QMetaObject::invokeMethod(this, [this, onCompletion, succeeded]()
+			{
+				m_isMapTaskRunning = false;
+				onCompletion(succeeded);
+			}, Qt::QueuedConnection);
+		});
+	}
+
+	bool EditorWindow::SaveMap(bool waitForCompletion)
 	{
 		if (m_workingMapPath.empty())
 		{
@@ -1669,22 +1894,46 @@ namespace bw
 			AddToRecentFileList(workingPath);
 		}
 
-		if (m_workingMap.Save(m_workingMapPath))
+		// The map may be edited while it's being saved, only clear the dirty flag if the saved state is still the current one
+		Nz::UInt64 revision = m_mapRevision;
+		auto OnSaveFinished = [this, revision](bool succeeded)
 		{
-			m_mapDirtyFlag = false;
-			m_saveMapToolbar->setEnabled(false);
+			if (succeeded)
+			{
+				if (m_mapRevision == revision)
+				{
+					m_mapDirtyFlag = false;
+					m_saveMapToolbar->setEnabled(false);
+				}
 
-			statusBar()->showMessage(tr("Map saved"), 3000);
+				statusBar()->showMessage(tr("Map saved"), 3000);
+			}
+			else
+			{
+				QMessageBox::warning(this, tr("Failed to save map"), tr("Failed to save map (is map folder read-only?)"), QMessageBox::Ok);
+				statusBar()->showMessage(tr("Failed to save map"), 5000);
+			}
+		};
 
-			return true;
-		}
-		else
+		if (waitForCompletion)
 		{
-			QMessageBox::warning(this, tr("Failed to save map"), tr("Failed to save map (is map folder read-only?)"), QMessageBox::Ok);
-			statusBar()->showMessage(tr("Failed to save map"), 5000);
+			WaitForMapTask();
 
-			return false;
+			bool succeeded = m_workingMap.Save(m_workingMapPath);
+			OnSaveFinished(succeeded);
+
+			return succeeded;
 		}
+
+		statusBar()->showMessage(tr("Saving map..."), 0);
+
+		std::filesystem::path mapPath = m_workingMapPath;
+		RunMapTask(std::make_shared<Map>(m_workingMap), [mapPath](Map& map)
+		{
+			return map.Save(mapPath);
+		}, std::move(OnSaveFinished));
+
+		return true;
 	}
 
 	void EditorWindow::RebuildCanvas()
@@ -1703,6 +1952,12 @@ namespace bw
 		m_canvas->UpdateActiveLayer(m_currentLayer);
 	}
 
+	void EditorWindow::WaitForMapTask()
+	{
+		if (m_mapTaskThread.joinable())
+			m_mapTaskThread.join();
+	}
+
 	void EditorWindow::UpdateEntityListButtons()
 	{
 		if (m_selectedEntities.size() == 1)
@@ -18,8 +18,10 @@
 #include <QtWidgets/QUndoStack>
 #include <tsl/hopscotch_map.h>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <thread>
 #include <vector>
 
 class QAction;
@@ -27,12 +29,18 @@ class QListWidget;
 class QListWidgetItem;
 class QPushButton;
 class QTabWidget;
+class QTimer;
 
 namespace bw
 {
 	class EntityInfoDialog;
 	class EditorMode;
 	class MapCanvas;
+
+	namespace Commands
+	{
+		class EditorCommand;
+	}
 	class PlayWindow;
 	class ScriptingContext;
 	class VirtualDirectory;
@@ -43,14 +51,21 @@ namespace bw
 			EditorWindow(int argc, char* argv[]);
 			~EditorWindow();
 
+			// Editing many entities between these calls refreshes the canvas gizmo and the entity list only once, at the end
+			void BeginBatchEdit();
+
 			void ClearSelectedEntity();
 			void ClearWorkingMap();
 
+			void CreateEntities(LayerIndex layerIndex, std::size_t firstEntityIndex, std::vector<Map::Entity> entities);
 			Map::Entity& CreateEntity(LayerIndex layerIndex, std::size_t entityIndex, Map::Entity entityData);
 			Map::Layer& CreateLayer(LayerIndex layerIndex, Map::Layer layerData);
+			std::vector<Map::Entity> DeleteEntities(LayerIndex layerIndex, std::size_t firstEntityIndex, std::size_t entityCount);
 			Map::Entity DeleteEntity(EntityId entityId);
 			Map::Layer DeleteLayer(LayerIndex layerIndex);
 
+			void EndBatchEdit();
+
 			Nz::Vector2f GetCameraCenter() const;
 			inline const std::optional<LayerIndex>& GetCurrentLayer() const;
 
@@ -68,7 +83,7 @@ namespace bw
 
 			void OpenEntityContextMenu(std::optional<std::size_t> entityIndexOpt, const QPoint& pos, QWidget* parent = nullptr);
 
-			void PushCommand(QUndoCommand* command);
+			void PushCommand(Commands::EditorCommand* command);
 			template<typename T, typename... Args> void PushCommand(Args&&... args);
 			void RefreshEntityPositionAndRotation(LayerIndex layerIndex, std::size_t entityIndex);
 
@@ -107,6 +122,7 @@ namespace bw
 			void InvalidateMap();
 
 			void OnAlignEntities();
+			void OnAutosave();
 			void OnCloneEntity(std::size_t entityIndex);
 			void OnCloneEntity(std::size_t entityIndex, LayerIndex layerIndex);
 			void OnCloneLayer(LayerIndex layerIndex);
@@ -148,7 +164,11 @@ namespace bw
 
 			void RegisterEntity(std::size_t entityIndex);
 
-			bool SaveMap();
+			void RunMapTask(std::shared_ptr<Map> map, std::function<bool(Map& map)> task, std::function<void(bool succeeded)> onCompletion);
+
+			bool SaveMap(bool waitForCompletion = false);
+
+			void WaitForMapTask();
 
 			struct List
 			{
@@ -162,6 +182,7 @@ namespace bw
 			std::shared_ptr<EditorMode> m_currentMode;
 			std::vector<QAction*> m_recentMapActions;
 			std::vector<std::size_t> m_selectedEntities;
+			std::thread m_mapTaskThread;
 			tsl::hopscotch_map<EntityId /*uniqueId*/, std::size_t /*entityIndex*/> m_entityIndices;
 			List m_entityList;
 			List m_layerList;
@@ -179,6 +200,7 @@ namespace bw
 			QMenu* m_layerMenu;
 			QMenu* m_mapMenu;
 			QTabWidget* m_centralTab;
+			QTimer* m_autosaveTimer;
 			QUndoStack m_undoStack;
 			EntityInfoDialog* m_entityInfoDialog;
 			MapCanvas* m_canvas;
@@ -186,6 +208,12 @@ namespace bw
 			EditorAppConfig m_configFile;
 			EditorWindowPrefabs m_prefabs;
 			Map m_workingMap;
+			std::size_t m_batchEditCounter;
+			std::size_t m_undoMemoryBudget;
+			Nz::UInt64 m_autosavedRevision;
+			Nz::UInt64 m_mapRevision; //< incremented on every change, so a task knows whether its snapshot is still current
+			bool m_isEntityListRefreshPending;
+			bool m_isMapTaskRunning;
 			bool m_mapDirtyFlag;
 	};
 }
@@ -199,14 +199,14 @@ namespace bw
 
 		tsl::hopscotch_map<EntityId /*prefabId*/, EntityId /*uniqueId*/> prefabIdToEntitiesUniqueId;
 
+		EntityId newUniqueId = map.GenerateUniqueIds(prefabLayer.entities.size());
 		for (auto& entityData : prefabLayer.entities)
 		{
-			EntityId newUniqueId = map.GenerateUniqueId();
 			assert(prefabIdToEntitiesUniqueId.find(entityData.uniqueId) == prefabIdToEntitiesUniqueId.end());
 			prefabIdToEntitiesUniqueId[entityData.uniqueId] = newUniqueId;
 
 			entityData.position += positionOffset;
-			entityData.uniqueId = newUniqueId;
+			entityData.uniqueId = newUniqueId++;
 		}
 
 		prefab.ForeachEntityPropertyValue<PropertyType::Entity>([&](Map::Entity& /*entity*/, const std::string& /*name*/, EntityId& uniqueId)
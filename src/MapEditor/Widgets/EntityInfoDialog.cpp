@@ -13,7 +13,7 @@
 #include <MapEditor/Widgets/Integer3SpinBox.hpp>
 #include <MapEditor/Widgets/Integer4SpinBox.hpp>
 #include <Nazara/Core/TypeTag.hpp>
-#include <QtGui/QStandardItemModel>
+#include <QtCore/QAbstractItemModel>
 #include <QtWidgets/QCheckBox>
 #include <QtWidgets/QComboBox>
 #include <QtWidgets/QDialogButtonBox>
@@ -31,6 +31,7 @@
 #include <QtWidgets/QTableWidget>
 #include <QtWidgets/QVBoxLayout>
 #include <bitset>
+#include <functional>
 #include <limits>
 
 static_assert(sizeof(bw::EntityId) == sizeof(qlonglong));
@@ -516,8 +517,8 @@ namespace bw
 	template<>
 	struct PropertyOverrider<true>
 	{
-		template<PropertyType P, typename V, typename CB>
-		static void OverrideProperty(EntityInfoDialog* /*owner*/, int arraySize, int rowIndex, PropertyValueMap& properties, const std::string& keyName, V&& newValue, CB&& callback)
+		template<PropertyType P, typename CB>
+		static void OverrideProperty(EntityInfoDialog* /*owner*/, PropertyValueMap& properties, const std::string& keyName, const PropertyArrayValue<P>& values, int rowIndex, CB&& callback)
 		{
 			bool first = false;
 
@@ -526,12 +527,12 @@ namespace bw
 			auto it = properties.find(keyName);
 			if (it == properties.end())
 			{
-				it = properties.emplace(keyName, T(arraySize)).first;
+				// Start from the displayed values (which may be the default ones) instead of an empty array
+				it = properties.emplace(keyName, values).first;
 				first = true;
 			}
-
-			T& propertyArray = std::get<T>(it.value());
-			propertyArray[rowIndex] = std::forward<V>(newValue);
+			else
+				std::get<T>(it.value())[rowIndex] = values[rowIndex];
 
 			callback(first, QString{});
 		}
@@ -561,45 +562,146 @@ namespace bw
 	};
 
 
-	template<PropertyType P, typename D, typename SpinBox, typename SpinBox::LabelMode L>
-	struct MultiSpinboxPropertyWidget
+	// Exposes a property array to a view without creating an item per element, rows are only converted when displayed
+	template<PropertyType P>
+	class PropertyArrayModel final : public QAbstractTableModel
 	{
-		virtual D* GetDelegate(EntityInfoDialog* owner) = 0;
-		virtual PropertyValueMap& GetProperties(EntityInfoDialog* owner) = 0;
+		public:
+			using T = PropertyArrayValue<P>;
+			using UT = PropertyUnderlyingType_t<P>;
+			using ChangeCallback = std::function<void(const T& values, int rowIndex)>;
+			using FromVariant = std::function<UT(const QVariant& value)>;
+			using ToVariant = std::function<QVariant(const UT& value)>;
 
-		using UT = PropertyUnderlyingType_t<P>;
+			PropertyArrayModel(T values, QString header, ToVariant toVariant, FromVariant fromVariant, ChangeCallback callback, QObject* parent) :
+			QAbstractTableModel(parent),
+			m_values(std::move(values)),
+			m_header(std::move(header)),
+			m_callback(std::move(callback)),
+			m_fromVariant(std::move(fromVariant)),
+			m_toVariant(std::move(toVariant))
+			{
+			}
 
-		template<typename V, typename CB>
-		QTableView* SetupArray(EntityInfoDialog* owner, int arraySize, const V& propertyValue, std::string keyName, CB&& callback)
-		{
-			using T = PropertyArrayValue<P>;
+			int columnCount(const QModelIndex& parent = QModelIndex()) const override
+			{
+				return (parent.isValid()) ? 0 : 1;
+			}
 
-			D* delegate = GetDelegate(owner);
-			PropertyValueMap& properties = GetProperties(owner);
+			QVariant data(const QModelIndex& index, int role) const override
+			{
+				if (!index.isValid() || index.row() >= rowCount())
+					return QVariant();
 
-			QTableView* tableView = new QTableView;
-			QStandardItemModel* model = new QStandardItemModel(arraySize, 1, tableView);
-			tableView->setItemDelegate(delegate);
-			tableView->setModel(model);
+				const UT& value = m_values[index.row()];
+				if constexpr (P == PropertyType::Bool)
+				{
+					if (role == Qt::CheckStateRole)
+						return int((value) ? Qt::Checked : Qt::Unchecked);
+				}
+				else
+				{
+					if (role == Qt::DisplayRole || role == Qt::EditRole)
+						return m_toVariant(value);
+				}
 
-			model->setHorizontalHeaderLabels({ owner->tr("Value") });
+				return QVariant();
+			}
 
-			if (propertyValue)
+			Qt::ItemFlags flags(const QModelIndex& index) const override
 			{
-				auto& propertyArray = std::get<T>(propertyValue->get());
-				for (int i = 0; i < arraySize; ++i)
-					delegate->ApplyModelData(model, model->index(i, 0), propertyArray[i]);
+				Qt::ItemFlags itemFlags = QAbstractTableModel::flags(index);
+				if constexpr (P == PropertyType::Bool)
+					itemFlags |= Qt::ItemIsUserCheckable;
+				else
+					itemFlags |= Qt::ItemIsEditable;
+
+				return itemFlags;
 			}
 
+			QVariant headerData(int section, Qt::Orientation orientation, int role) const override
+			{
+				if (orientation == Qt::Horizontal && role == Qt::DisplayRole)
+					return m_header;
 
-			owner->connect(model, &QStandardItemModel::itemChanged, [=, &properties, keyName = std::move(keyName), callback = std::forward<CB>(callback)](QStandardItem* item)
+				return QAbstractTableModel::headerData(section, orientation, role);
+			}
+
+			int rowCount(const QModelIndex& parent = QModelIndex()) const override
 			{
-				UT value = delegate->RetrieveModelData(item->index());
+				return (parent.isValid()) ? 0 : int(m_values.size());
+			}
 
-				PropertyOverrider<true>::template OverrideProperty<P>(owner, arraySize, item->index().row(), properties, keyName, value, callback);
-			});
+			bool setData(const QModelIndex& index, const QVariant& value, int role) override
+			{
+				if (!index.isValid() || index.row() >= rowCount())
+					return false;
+
+				if constexpr (P == PropertyType::Bool)
+				{
+					if (role != Qt::CheckStateRole)
+						return false;
+
+					m_values[index.row()] = (value.toInt() == Qt::Checked);
+				}
+				else
+				{
+					if (role != Qt::EditRole)
+						return false;
+
+					m_values[index.row()] = m_fromVariant(value);
+				}
+
+				emit dataChanged(index, index, { role });
+				m_callback(m_values, index.row());
+
+				return true;
+			}
+
+		private:
+			T m_values;
+			QString m_header;
+			ChangeCallback m_callback;
+			FromVariant m_fromVariant;
+			ToVariant m_toVariant;
+	};
 
-			return tableView;
+	template<PropertyType P, typename V, typename CB>
+	QTableView* SetupPropertyArrayView(EntityInfoDialog* owner, PropertyValueMap& properties, int arraySize, const V& propertyValue, std::string keyName, CB&& callback, QAbstractItemDelegate* delegate, typename PropertyArrayModel<P>::ToVariant toVariant, typename PropertyArrayModel<P>::FromVariant fromVariant, const QString& header = QString())
+	{
+		using T = PropertyArrayValue<P>;
+
+		T values = (propertyValue) ? std::get<T>(propertyValue->get()) : T(arraySize);
+
+		QTableView* tableView = new QTableView;
+		if (delegate)
+			tableView->setItemDelegate(delegate);
+
+		PropertyArrayModel<P>* model = new PropertyArrayModel<P>(std::move(values), (header.isEmpty()) ? owner->tr("Value") : header, std::move(toVariant), std::move(fromVariant), [=, &properties, keyName = std::move(keyName), callback = std::forward<CB>(callback)](const T& values, int rowIndex)
+		{
+			PropertyOverrider<true>::template OverrideProperty<P>(owner, properties, keyName, values, rowIndex, callback);
+		}, tableView);
+
+		tableView->setModel(model);
+
+		return tableView;
+	}
+
+	template<PropertyType P, typename D, typename SpinBox, typename SpinBox::LabelMode L>
+	struct MultiSpinboxPropertyWidget
+	{
+		virtual D* GetDelegate(EntityInfoDialog* owner) = 0;
+		virtual PropertyValueMap& GetProperties(EntityInfoDialog* owner) = 0;
+
+		using UT = PropertyUnderlyingType_t<P>;
+
+		template<typename V, typename CB>
+		QTableView* SetupArray(EntityInfoDialog* owner, int arraySize, const V& propertyValue, std::string keyName, CB&& callback)
+		{
+			auto ToVariant = [](const UT& value) { return QVariant::fromValue(value); };
+			auto FromVariant = [](const QVariant& value) { return value.value<UT>(); };
+
+			return SetupPropertyArrayView<P>(owner, GetProperties(owner), arraySize, propertyValue, std::move(keyName), std::forward<CB>(callback), GetDelegate(owner), ToVariant, FromVariant);
 		}
 
 		template<typename V, typename CB>
@@ -630,34 +732,12 @@ namespace bw
 		virtual PropertyValueMap& GetProperties(EntityInfoDialog* owner) = 0;
 
 		template<typename V, typename CB>
-		QTableWidget* SetupArray(EntityInfoDialog* owner, int arraySize, const V& propertyValue, std::string keyName, CB&& callback)
+		QTableView* SetupArray(EntityInfoDialog* owner, int arraySize, const V& propertyValue, std::string keyName, CB&& callback)
 		{
-			using T = PropertyArrayValue<P>;
+			auto ToVariant = [](const std::string& value) { return QVariant(QString::fromStdString(value)); };
+			auto FromVariant = [](const QVariant& value) { return value.toString().toStdString(); };
 
-			PropertyValueMap& properties = GetProperties(owner);
-
-			QTableWidget* table = new QTableWidget(arraySize, 1);
-			table->setHorizontalHeaderLabels({ owner->tr("Value") });
-			table->setSelectionMode(QAbstractItemView::NoSelection);
-			table->setEditTriggers(QAbstractItemView::DoubleClicked | QAbstractItemView::EditKeyPressed | QAbstractItemView::SelectedClicked);
-
-			if (propertyValue)
-			{
-				auto& propertyArray = std::get<T>(propertyValue->get());
-
-				QAbstractItemModel* model = table->model();
-				for (int i = 0; i < arraySize; ++i)
-					model->setData(model->index(i, 0), QString::fromStdString(propertyArray[i]));
-			}
-
-			owner->connect(table, &QTableWidget::cellChanged, [=, &properties, keyName = std::move(keyName), callback = std::forward<CB>(callback)](int row, int column)
-			{
-				std::string value = table->item(row, column)->text().toStdString();
-
-				PropertyOverrider<true>::template OverrideProperty<P>(owner, arraySize, row, properties, keyName, std::move(value), callback);
-			});
-
-			return table;
+			return SetupPropertyArrayView<P>(owner, GetProperties(owner), arraySize, propertyValue, std::move(keyName), std::forward<CB>(callback), nullptr, ToVariant, FromVariant);
 		}
 
 		template<typename V, typename CB>
@@ -694,37 +774,7 @@ namespace bw
 		template<typename V, typename CB>
 		QTableView* SetupArray(EntityInfoDialog* owner, int arraySize, const V& propertyValue, std::string keyName, CB&& callback)
 		{
-			using T = PropertyArrayValue<P>;
-
-			QTableView* tableView = new QTableView;
-			QStandardItemModel* model = new QStandardItemModel(arraySize, 1, tableView);
-			tableView->setModel(model);
-
-			model->setHorizontalHeaderLabels({ owner->tr("Enabled") });
-
-			for (int i = 0; i < arraySize; ++i)
-			{
-				QStandardItem* item = new QStandardItem(1);
-				item->setCheckable(true);
-
-				model->setItem(i, 0, item);
-			}
-
-			if (propertyValue)
-			{
-				auto& propertyArray = std::get<T>(propertyValue->get());
-				for (int i = 0; i < arraySize; ++i)
-					model->item(i)->setCheckState((propertyArray[i]) ? Qt::Checked : Qt::Unchecked);
-			}
-
-			owner->connect(model, &QStandardItemModel::itemChanged, [=, keyName = std::move(keyName), callback = std::forward<CB>(callback)](QStandardItem* item) mutable
-			{
-				bool value = item->checkState() == Qt::Checked;
-
-				PropertyOverrider<true>::template OverrideProperty<P>(owner, arraySize, item->index().row(), owner->m_entityInfo.properties, keyName, value, callback);
-			});
-
-			return tableView;
+			return SetupPropertyArrayView<P>(owner, owner->m_entityInfo.properties, arraySize, propertyValue, std::move(keyName), std::forward<CB>(callback), nullptr, nullptr, nullptr, owner->tr("Enabled"));
 		}
 
 		template<typename V, typename CB>
@@ -753,35 +803,16 @@ namespace bw
 		template<typename V, typename CB>
 		QTableView* SetupArray(EntityInfoDialog* owner, int arraySize, const V& propertyValue, std::string keyName, CB&& callback)
 		{
-			using T = PropertyArrayValue<P>;
-
 			owner->m_delegates->comboBoxDelegate.emplace(owner->BuildEntityComboBoxOptions());
 
-			QTableView* tableView = new QTableView;
-			QStandardItemModel* model = new QStandardItemModel(arraySize, 1, tableView);
-			tableView->setItemDelegate(&owner->m_delegates->comboBoxDelegate.value());
-			tableView->setModel(model);
-
-			model->setHorizontalHeaderLabels({ owner->tr("Value") });
-
-			if (propertyValue)
+			auto ToVariant = [](EntityId value) { return QVariant(static_cast<qlonglong>(value)); };
+			auto FromVariant = [](const QVariant& value)
 			{
-				auto& propertyArray = std::get<T>(propertyValue->get());
-
-				for (int i = 0; i < arraySize; ++i)
-					owner->m_delegates->comboBoxDelegate->ApplyModelData(model, model->index(i, 0), static_cast<qlonglong>(propertyArray[i]));
-			}
-
-			owner->connect(model, &QStandardItemModel::itemChanged, [=, keyName = std::move(keyName), callback = std::forward<CB>(callback)](QStandardItem* item) mutable
-			{
-				EntityId value = static_cast<EntityId>(owner->m_delegates->comboBoxDelegate->RetrieveModelData(item->index()).toLongLong());
-				if (value <= 0)
-					value = InvalidEntityId;
-
-				PropertyOverrider<true>::template OverrideProperty<P>(owner, arraySize, item->index().row(), owner->m_entityInfo.properties, keyName, value, callback);
-			});
+				EntityId uniqueId = static_cast<EntityId>(value.toLongLong());
+				return (uniqueId > 0) ? uniqueId : InvalidEntityId;
+			};
 
-			return tableView;
+			return SetupPropertyArrayView<P>(owner, owner->m_entityInfo.properties, arraySize, propertyValue, std::move(keyName), std::forward<CB>(callback), &owner->m_delegates->comboBoxDelegate.value(), ToVariant, FromVariant);
 		}
 
 		template<typename V, typename CB>
@@ -833,30 +864,10 @@ namespace bw
 		template<typename V, typename CB>
 		QTableView* SetupArray(EntityInfoDialog* owner, int arraySize, const V& propertyValue, std::string keyName, CB&& callback)
 		{
-			using T = PropertyArrayValue<P>;
-
-			QTableView* tableView = new QTableView;
-			QStandardItemModel* model = new QStandardItemModel(arraySize, 1, tableView);
-			tableView->setItemDelegate(&owner->m_delegates->floatDelegate);
-			tableView->setModel(model);
-
-			model->setHorizontalHeaderLabels({ owner->tr("Value") });
-
-			if (propertyValue)
-			{
-				auto& propertyArray = std::get<T>(propertyValue->get());
-				for (int i = 0; i < arraySize; ++i)
-					owner->m_delegates->floatDelegate.ApplyModelData(model, model->index(i, 0), propertyArray[i]);
-			}
+			auto ToVariant = [](float value) { return QVariant(value); };
+			auto FromVariant = [](const QVariant& value) { return value.toFloat(); };
 
-			owner->connect(model, &QStandardItemModel::itemChanged, [=, keyName = std::move(keyName), callback = std::forward<CB>(callback)](QStandardItem* item)
-			{
-				float value = owner->m_delegates->floatDelegate.RetrieveModelData(item->index());
-
-				PropertyOverrider<true>::template OverrideProperty<P>(owner, arraySize, item->index().row(), owner->m_entityInfo.properties, keyName, value, callback);
-			});
-
-			return tableView;
+			return SetupPropertyArrayView<P>(owner, owner->m_entityInfo.properties, arraySize, propertyValue, std::move(keyName), std::forward<CB>(callback), &owner->m_delegates->floatDelegate, ToVariant, FromVariant);
 		}
 
 		template<typename V, typename CB>
@@ -924,30 +935,10 @@ namespace bw
 		template<typename V, typename CB>
 		QTableView* SetupArray(EntityInfoDialog* owner, int arraySize, const V& propertyValue, std::string keyName, CB&& callback)
 		{
-			using T = PropertyArrayValue<P>;
-
-			QTableView* tableView = new QTableView;
-			QStandardItemModel* model = new QStandardItemModel(arraySize, 1, tableView);
-			tableView->setItemDelegate(&owner->m_delegates->intDelegate);
-			tableView->setModel(model);
+			auto ToVariant = [](Nz::Int64 value) { return QVariant(int(value)); };
+			auto FromVariant = [](const QVariant& value) { return Nz::Int64(value.toInt()); };
 
-			model->setHorizontalHeaderLabels({ owner->tr("Value") });
-
-			if (propertyValue)
-			{
-				auto& propertyArray = std::get<T>(propertyValue->get());
-				for (int i = 0; i < arraySize; ++i)
-					owner->m_delegates->intDelegate.ApplyModelData(model, model->index(i, 0), propertyArray[i]);
-			}
-
-			owner->connect(model, &QStandardItemModel::itemChanged, [=, keyName = std::move(keyName), callback = std::forward<CB>(callback)](QStandardItem* item)
-			{
-				Nz::Int64 value = owner->m_delegates->intDelegate.RetrieveModelData(item->index());
-
-				PropertyOverrider<true>::template OverrideProperty<P>(owner, arraySize, item->index().row(), owner->m_entityInfo.properties, keyName, value, callback);
-			});
-
-			return tableView;
+			return SetupPropertyArrayView<P>(owner, owner->m_entityInfo.properties, arraySize, propertyValue, std::move(keyName), std::forward<CB>(callback), &owner->m_delegates->intDelegate, ToVariant, FromVariant);
 		}
 
 		template<typename V, typename CB>
@@ -1016,33 +1007,12 @@ namespace bw
 		template<typename V, typename CB>
 		QTableView* SetupArray(EntityInfoDialog* owner, int arraySize, const V& propertyValue, std::string keyName, CB&& callback)
 		{
-			using T = PropertyArrayValue<P>;
-
 			owner->m_delegates->comboBoxDelegate.emplace(owner->BuildLayerComboBoxOptions());
 
-			QTableView* tableView = new QTableView;
-			QStandardItemModel* model = new QStandardItemModel(arraySize, 1, tableView);
-			tableView->setItemDelegate(&owner->m_delegates->comboBoxDelegate.value());
-			tableView->setModel(model);
-
-			model->setHorizontalHeaderLabels({ owner->tr("Value") });
-
-			if (propertyValue)
-			{
-				auto& propertyArray = std::get<T>(propertyValue->get());
-
-				for (int i = 0; i < arraySize; ++i)
-					owner->m_delegates->comboBoxDelegate->ApplyModelData(model, model->index(i, 0), static_cast<qlonglong>(propertyArray[i]));
-			}
-
-			owner->connect(model, &QStandardItemModel::itemChanged, [=, keyName = std::move(keyName), callback = std::forward<CB>(callback)](QStandardItem* item)
-			{
-				LayerIndex value = static_cast<LayerIndex>(owner->m_delegates->comboBoxDelegate->RetrieveModelData(item->index()).toLongLong());
-
-				PropertyOverrider<true>::template OverrideProperty<P>(owner, arraySize, item->index().row(), owner->m_entityInfo.properties, keyName, value, callback);
-			});
+			auto ToVariant = [](LayerIndex value) { return QVariant(static_cast<qlonglong>(value)); };
+			auto FromVariant = [](const QVariant& value) { return static_cast<LayerIndex>(value.toLongLong()); };
 
-			return tableView;
+			return SetupPropertyArrayView<P>(owner, owner->m_entityInfo.properties, arraySize, propertyValue, std::move(keyName), std::forward<CB>(callback), &owner->m_delegates->comboBoxDelegate.value(), ToVariant, FromVariant);
 		}
 
 		template<typename V, typename CB>
@@ -1092,6 +1062,7 @@ namespace bw
 	EntityInfoDialog::EntityInfoDialog(const Logger& logger, const Map& map, EditorEntityStore& clientEntityStore, ScriptingContext& scriptingContext, QWidget* parent) :
 	QDialog(parent),
 	m_entityTypeIndex(0),
+	m_propertyListTypeIndex(InvalidIndex),
 	m_propertyTypeIndex(InvalidIndex),
 	m_entityStore(clientEntityStore),
 	m_logger(logger),
@@ -1343,7 +1314,14 @@ namespace bw
 		{
 			auto propertyIt = m_propertyByName.find(propertyName);
 			if (propertyIt != m_propertyByName.end())
-				m_propertiesList->selectRow(int(propertyIt->second));
+			{
+				// Selecting the current row again doesn't trigger a refresh
+				int rowIndex = int(propertyIt->second);
+				if (m_propertiesList->currentRow() == rowIndex)
+					RefreshPropertyEditor(propertyIt->second);
+				else
+					m_propertiesList->selectRow(rowIndex);
+			}
 			else
 				RefreshPropertyEditor(InvalidIndex);
 		}
@@ -1373,40 +1351,40 @@ namespace bw
 
 	void EntityInfoDialog::RefreshEntityType()
 	{
-		m_editorActionByName.clear();
-		m_properties.clear();
-		m_propertyByName.clear();
-		m_propertiesList->clearContents();
-
 		if (m_entityTypeIndex == m_entityStore.InvalidIndex)
 		{
-			m_entityInfo.properties.clear();
+			m_editorActionByName.clear();
+			m_properties.clear();
+			m_propertyByName.clear();
+			m_propertiesList->clearContents();
 			m_propertiesList->setRowCount(0);
+			m_propertyListTypeIndex = InvalidIndex;
+
+			m_entityInfo.properties.clear();
 			return;
 		}
 
 		auto entityTypeInfo = std::static_pointer_cast<EditorScriptedEntity, ScriptedEntity>(m_entityStore.GetElement(m_entityTypeIndex));
 
-		// Build property list and ensure relevant properties are stored
+		// Property list and editor actions only depend on the entity type, keep them when editing another entity of the same type
+		if (m_propertyListTypeIndex != m_entityTypeIndex)
+		{
+			BuildPropertyList(*entityTypeInfo);
+			m_propertyListTypeIndex = m_entityTypeIndex;
+		}
+
+		// Ensure relevant properties are stored
 		PropertyValueMap oldProperties = std::move(m_entityInfo.properties);
 		m_entityInfo.properties.clear(); // Put back in a valid state
 
 		std::bitset<MaxPropertyCount> modifiedProperties;
 
-		for (const auto& [propertyName, propertyInfo] : entityTypeInfo->properties)
+		for (const auto& propertyData : m_properties)
 		{
-			auto& propertyData = m_properties.emplace_back();
-			propertyData.defaultValue = propertyInfo.defaultValue;
-			propertyData.index = propertyInfo.index;
-			propertyData.isArray = propertyInfo.isArray;
-			propertyData.keyName = propertyName;
-			propertyData.visualName = propertyData.keyName; //< FIXME
-			propertyData.type = propertyInfo.type;
-
 			if (auto it = oldProperties.find(propertyData.keyName); it != oldProperties.end())
 			{
 				// Only keep old property value if types are compatibles
-				if (!propertyInfo.defaultValue || it->second.index() == propertyInfo.defaultValue->index())
+				if (!propertyData.defaultValue || it->second.index() == propertyData.defaultValue->index())
 				{
 					assert(propertyData.index < modifiedProperties.size());
 					modifiedProperties[propertyData.index] = true;
@@ -1417,6 +1395,38 @@ namespace bw
 			}
 		}
 
+		QFont boldFont;
+		boldFont.setWeight(QFont::Medium);
+
+		int rowIndex = 0;
+		for (const auto& propertyInfo : m_properties)
+		{
+			QTableWidgetItem* valueItem = m_propertiesList->item(rowIndex, 1);
+			valueItem->setText(ToString(GetProperty(propertyInfo), propertyInfo.type));
+			valueItem->setFont((modifiedProperties.test(propertyInfo.index)) ? boldFont : QFont());
+
+			++rowIndex;
+		}
+	}
+
+	void EntityInfoDialog::BuildPropertyList(const EditorScriptedEntity& entityTypeInfo)
+	{
+		m_editorActionByName.clear();
+		m_properties.clear();
+		m_propertyByName.clear();
+		m_propertiesList->clearContents();
+
+		for (const auto& [propertyName, propertyInfo] : entityTypeInfo.properties)
+		{
+			auto& propertyData = m_properties.emplace_back();
+			propertyData.defaultValue = propertyInfo.defaultValue;
+			propertyData.index = propertyInfo.index;
+			propertyData.isArray = propertyInfo.isArray;
+			propertyData.keyName = propertyName;
+			propertyData.visualName = propertyData.keyName; //< FIXME
+			propertyData.type = propertyInfo.type;
+		}
+
 		std::sort(m_properties.begin(), m_properties.end(), [](auto&& first, auto&& second) { return first.index < second.index; });
 
 		for (std::size_t i = 0; i < m_properties.size(); ++i)
@@ -1424,19 +1434,11 @@ namespace bw
 
 		m_propertiesList->setRowCount(int(m_properties.size()));
 
-		QFont boldFont;
-		boldFont.setWeight(QFont::Medium);
-
 		int rowIndex = 0;
 		for (const auto& propertyInfo : m_properties)
 		{
 			m_propertiesList->setItem(rowIndex, 0, new QTableWidgetItem(QString::fromStdString(propertyInfo.visualName)));
-
-			QTableWidgetItem* valueItem = new QTableWidgetItem(ToString(GetProperty(propertyInfo), propertyInfo.type));
-			if (modifiedProperties.test(propertyInfo.index))
-				valueItem->setFont(boldFont);
-			
-			m_propertiesList->setItem(rowIndex, 1, valueItem);
+			m_propertiesList->setItem(rowIndex, 1, new QTableWidgetItem);
 			m_propertiesList->setItem(rowIndex, 2, new QTableWidgetItem( propertyInfo.defaultValue.has_value() ? "" : "*" ));
 
 			++rowIndex;
@@ -1447,7 +1449,7 @@ namespace bw
 			delete w;
 
 		std::size_t actionIndex = 0;
-		for (auto&& editorAction : entityTypeInfo->editorActions)
+		for (auto&& editorAction : entityTypeInfo.editorActions)
 		{
 			m_editorActionByName.emplace(editorAction.name, actionIndex++);
 
@@ -32,6 +32,7 @@ class QWidget;
 namespace bw
 {
 	class EditorEntityStore;
+	struct EditorScriptedEntity;
 	class ScriptingContext;
 	class Float2SpinBox;
 	class Logger;
@@ -78,6 +79,7 @@ namespace bw
 
 			std::vector<std::pair<QString, QVariant>> BuildEntityComboBoxOptions();
 			std::vector<std::pair<QString, QVariant>> BuildLayerComboBoxOptions();
+			void BuildPropertyList(const EditorScriptedEntity& entityTypeInfo);
 
 			EntityPropertyConstRefOpt GetProperty(const PropertyData& property) const;
 
@@ -117,6 +119,7 @@ namespace bw
 			EntityId m_entityUniqueId;
 			LayerIndex m_entityLayer;
 			std::size_t m_entityTypeIndex;
+			std::size_t m_propertyListTypeIndex; //< entity type m_properties and the property list were built for
 			std::size_t m_propertyTypeIndex;
 			std::vector<PropertyData> m_properties;
 			std::vector<std::string> m_entityTypes;
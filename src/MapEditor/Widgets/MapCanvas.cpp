@@ -4,10 +4,14 @@
 
 #include <MapEditor/Widgets/MapCanvas.hpp>
 #include <CoreLib/LogSystem/Logger.hpp>
+#include <CoreLib/Systems/AnimationSystem.hpp>
+#include <CoreLib/Systems/TickCallbackSystem.hpp>
 #include <ClientLib/Components/VisibleLayerComponent.hpp>
 #include <ClientLib/Scripting/ClientEditorScriptingLibrary.hpp>
 #include <ClientLib/Scripting/ClientElementLibrary.hpp>
 #include <ClientLib/Scripting/ClientWeaponLibrary.hpp>
+#include <ClientLib/Systems/FrameCallbackSystem.hpp>
+#include <ClientLib/Systems/PostFrameCallbackSystem.hpp>
 #include <MapEditor/Gizmos/PositionGizmo.hpp>
 #include <MapEditor/Components/CanvasComponent.hpp>
 #include <MapEditor/Scripting/EditorElementLibrary.hpp>
@@ -32,7 +36,9 @@ namespace bw
 	MapCanvas::MapCanvas(EditorWindow& editor, QWidget* parent) :
 	SharedMatch(editor, LogSide::Editor, "editor", 1.f / 60.f),
 	WorldCanvas(parent),
+	m_batchEditCounter(0),
 	m_editor(editor),
+	m_isGizmoRefreshPending(false),
 	m_isPhysicsDebugDrawEnabled(false)
 	{
 		Ndk::World& world = GetWorld();
@@ -82,14 +88,20 @@ namespace bw
 		m_gamemode.reset();
 	}
 
+	void MapCanvas::BeginBatchEdit()
+	{
+		m_batchEditCounter++;
+	}
+
 	void MapCanvas::Clear()
 	{
 		UpdateActiveLayer({});
 
-		m_entitiesByUniqueId.clear();
+		m_entitiesByUniqueId.Clear();
 		m_layers.clear();
 
 		ClearEntitySelection(); //< Force disconnection because entity destruction does not occur until the world next update
+		RequestRedraw();
 	}
 
 	void MapCanvas::ClearEntitySelection()
@@ -97,12 +109,17 @@ namespace bw
 		m_onGizmoEntityDestroyed.Disconnect();
 		m_onLayerAlignmentUpdate.Disconnect(); //< Used by position gizmo
 		m_entityGizmo.reset();
+
+		RequestRedraw();
 	}
 
 	const Ndk::EntityHandle& MapCanvas::CreateEntity(LayerIndex layerIndex, EntityId uniqueId, const std::string& entityClass, const Nz::Vector2f& position, const Nz::DegreeAnglef& rotation, PropertyValueMap properties)
 	{
 		assert(layerIndex < m_layers.size());
 		auto& layer = m_layers[layerIndex];
+
+		RequestRedraw();
+
 		return layer.CreateEntity(uniqueId, entityClass, position, rotation, properties).GetEntity();
 	}
 
@@ -115,6 +132,8 @@ namespace bw
 			assert(layerIndex < m_layers.size());
 			auto& layer = m_layers[layerIndex];
 			layer.DeleteEntity(entityId);
+
+			RequestRedraw();
 		}
 	}
 
@@ -129,11 +148,11 @@ namespace bw
 		std::vector<LayerVisualEntityHandle> entities;
 		for (EntityId uniqueId : entityIds)
 		{
-			auto it = m_entitiesByUniqueId.find(uniqueId);
-			if (it == m_entitiesByUniqueId.end())
+			const LayerVisualEntityHandle* visualEntityHandle = m_entitiesByUniqueId.Find(uniqueId);
+			if (!visualEntityHandle)
 				continue;
 
-			entities.emplace_back(it->second);
+			entities.emplace_back(*visualEntityHandle);
 		}
 
 		if (entities.empty())
@@ -156,6 +175,8 @@ namespace bw
 		});
 
 		m_entityGizmo = std::move(positionGizmo);
+		RequestRedraw();
+
 		/*m_onGizmoEntityDestroyed.Connect(entity->OnEntityDestruction, [this](Ndk::Entity* entity)
 		{
 			assert(m_entityGizmo->GetTargetEntity() == entity);
@@ -168,18 +189,34 @@ namespace bw
 	void MapCanvas::EnablePhysicsDebugDraw(bool enable)
 	{
 		m_isPhysicsDebugDrawEnabled = enable;
+		RequestRedraw();
+	}
+
+	void MapCanvas::EndBatchEdit()
+	{
+		assert(m_batchEditCounter > 0);
+		if (--m_batchEditCounter > 0)
+			return;
+
+		if (m_isGizmoRefreshPending)
+		{
+			if (m_entityGizmo)
+				m_entityGizmo->Refresh();
+
+			m_isGizmoRefreshPending = false;
+		}
 	}
 
 	void MapCanvas::ForEachEntity(std::function<void(const Ndk::EntityHandle& entity)> func)
 	{
-		for (auto&& [uniqueId, visualEntityHandle] : m_entitiesByUniqueId)
+		m_entitiesByUniqueId.ForEach([&](EntityId /*uniqueId*/, const LayerVisualEntityHandle& visualEntityHandle)
 		{
 			const Ndk::EntityHandle& entity = visualEntityHandle->GetEntity();
 			if (!entity)
-				continue;
+				return;
 
 			func(entity);
-		}
+		});
 	}
 
 	EditorEntityStore& MapCanvas::GetEntityStore()
@@ -234,6 +271,7 @@ namespace bw
 		if (!m_scriptingContext)
 		{
 			m_scriptingContext = std::make_shared<ScriptingContext>(GetLogger(), m_scriptDirectory);
+			m_scriptingContext->SetBytecodeCache(m_editor.GetBytecodeCache()); //< shared with play sessions, which then don't have to compile scripts again
 			m_scriptingContext->LoadLibrary(std::make_shared<EditorScriptingLibrary>(*this));
 			m_scriptingContext->LoadLibrary(std::make_shared<ClientEditorScriptingLibrary>(GetLogger(), *m_assetStore));
 		}
@@ -290,6 +328,10 @@ namespace bw
 				m_entityStore->UpdateEntityElement(entity);
 		});
 
+		// Entity visuals may have changed along with their scripts
+		for (MapCanvasLayer& layer : m_layers)
+			layer.RebuildSpatialIndex();
+
 		if (!m_gamemode)
 		{
 			m_gamemode = std::make_shared<EditorGamemode>(*this, m_scriptingContext, PropertyValueMap{});
@@ -297,6 +339,8 @@ namespace bw
 		}
 		else
 			m_gamemode->Reload();
+
+		RequestRedraw();
 	}
 
 	void MapCanvas::ResetLayers(std::size_t layerCount)
@@ -305,24 +349,26 @@ namespace bw
 		m_layers.reserve(layerCount);
 		for (std::size_t i = 0; i < layerCount; ++i)
 			m_layers.emplace_back(*this, LayerIndex(i));
+
+		RequestRedraw();
 	}
 
 	const Ndk::EntityHandle& MapCanvas::RetrieveEntityByUniqueId(EntityId uniqueId) const
 	{
-		auto it = m_entitiesByUniqueId.find(uniqueId);
-		if (it == m_entitiesByUniqueId.end())
+		const LayerVisualEntityHandle* visualEntityHandle = m_entitiesByUniqueId.Find(uniqueId);
+		if (!visualEntityHandle)
 			return Ndk::EntityHandle::InvalidHandle;
 
-		return it.value()->GetEntity();
+		return (*visualEntityHandle)->GetEntity();
 	}
 
 	const LayerVisualEntityHandle& MapCanvas::RetrieveLayerEntityByUniqueId(EntityId uniqueId) const
 	{
-		auto it = m_entitiesByUniqueId.find(uniqueId);
-		if (it == m_entitiesByUniqueId.end())
+		const LayerVisualEntityHandle* visualEntityHandle = m_entitiesByUniqueId.Find(uniqueId);
+		if (!visualEntityHandle)
 			return LayerVisualEntityHandle::InvalidHandle;
 
-		return it->second;
+		return *visualEntityHandle;
 	}
 
 	EntityId MapCanvas::RetrieveUniqueIdByEntity(const Ndk::EntityHandle& entity) const
@@ -348,6 +394,8 @@ namespace bw
 		}
 		else
 			m_gridEntity.Reset();
+
+		RequestRedraw();
 	}
 
 	void MapCanvas::UpdateActiveLayer(std::optional<LayerIndex> layerIndex)
@@ -365,15 +413,17 @@ namespace bw
 
 			m_gamemode->ExecuteCallback<GamemodeEvent::ChangeLayer>(m_currentLayer, layerIndex);
 			m_currentLayer = layerIndex;
+
+			RequestRedraw();
 		}
 	}
 
 	void MapCanvas::UpdateEntityPositionAndRotation(EntityId entityId, const Nz::Vector2f& position, const Nz::DegreeAnglef& rotation)
 	{
-		auto it = m_entitiesByUniqueId.find(entityId);
-		assert(it != m_entitiesByUniqueId.end());
+		LayerVisualEntityHandle* visualEntityHandle = m_entitiesByUniqueId.Find(entityId);
+		assert(visualEntityHandle);
 
-		LayerVisualEntity& layerVisual = *it->second;
+		LayerVisualEntity& layerVisual = **visualEntityHandle;
 
 		auto& nodeComponent = layerVisual.GetEntity()->GetComponent<Ndk::NodeComponent>();
 		nodeComponent.SetPosition(position);
@@ -381,8 +431,12 @@ namespace bw
 
 		layerVisual.SyncVisuals();
 
+		LayerIndex layerIndex = layerVisual.GetLayerIndex();
+		assert(layerIndex < m_layers.size());
+		m_layers[layerIndex].UpdateEntityBounds(entityId);
+
 		// Refresh gizmo if an entity it uses has been updated
-		if (m_entityGizmo)
+		if (m_entityGizmo && !m_isGizmoRefreshPending)
 		{
 			const auto& targetEntities = m_entityGizmo->GetTargetEntities();
 
@@ -392,8 +446,40 @@ namespace bw
 			});
 
 			if (targetIt != targetEntities.end())
-				m_entityGizmo->Refresh();
+			{
+				// Refreshing goes through every target entity, do it only once for a batch
+				if (m_batchEditCounter > 0)
+					m_isGizmoRefreshPending = true;
+				else
+					m_entityGizmo->Refresh();
+			}
 		}
+
+		RequestRedraw();
+	}
+
+	bool MapCanvas::HasRunningAnimations()
+	{
+		if (m_gamemode && (m_gamemode->HasCallbacks(GamemodeEvent::Frame) || m_gamemode->HasCallbacks(GamemodeEvent::PostFrame) || m_gamemode->HasCallbacks(GamemodeEvent::Tick)))
+			return true;
+
+		if (GetTimerManager().GetPendingTimerCount() > 0)
+			return true;
+
+		for (MapCanvasLayer& layer : m_layers)
+		{
+			if (!layer.IsEnabled())
+				continue;
+
+			Ndk::World& world = layer.GetWorld();
+			if (world.GetSystem<AnimationSystem>().GetEntities().size() != 0 ||
+			    world.GetSystem<FrameCallbackSystem>().GetEntities().size() != 0 ||
+			    world.GetSystem<PostFrameCallbackSystem>().GetEntities().size() != 0 ||
+			    world.GetSystem<TickCallbackSystem>().GetEntities().size() != 0)
+				return true;
+		}
+
+		return false;
 	}
 
 	void MapCanvas::OnKeyPressed(const Nz::WindowEvent::KeyEvent& key)
@@ -552,6 +638,10 @@ namespace bw
 
 		NazaraCanvas::OnUpdate(elapsedTime);
 		SetActive(false);
+
+		// Keep rendering as long as scripts may move things on their own
+		if (HasRunningAnimations())
+			RequestRedraw();
 	}
 
 	void MapCanvas::UpdateGrid()
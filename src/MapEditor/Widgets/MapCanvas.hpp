@@ -9,6 +9,7 @@
 
 #include <CoreLib/PropertyValues.hpp>
 #include <CoreLib/SharedMatch.hpp>
+#include <CoreLib/Utility/EntityRegistry.hpp>
 #include <ClientLib/ClientAssetStore.hpp>
 #include <ClientLib/ClientSession.hpp>
 #include <ClientLib/VisualEntity.hpp>
@@ -35,6 +36,9 @@ namespace bw
 			MapCanvas(EditorWindow& editor, QWidget* parent = nullptr);
 			~MapCanvas();
 
+			// Defers work done once per edit (gizmo refresh) until the last EndBatchEdit, when editing many entities at once
+			void BeginBatchEdit();
+
 			void Clear();
 			void ClearEntitySelection();
 
@@ -43,6 +47,7 @@ namespace bw
 
 			void EditEntitiesPosition(const std::vector<EntityId>& entityIds);
 			void EnablePhysicsDebugDraw(bool enable);
+			void EndBatchEdit();
 
 			void ForEachEntity(std::function<void(const Ndk::EntityHandle& entity)> func) override;
 			template<typename F> void ForEachEntity(F&& func);
@@ -51,6 +56,7 @@ namespace bw
 			MapCanvasLayer* GetActiveLayer();
 			const MapCanvasLayer* GetActiveLayer() const;
 			inline const std::shared_ptr<VirtualDirectory>& GetAssetDirectory();
+			inline const ClientAssetStore& GetAssetStore() const;
 			EditorEntityStore& GetEntityStore() override;
 			const EditorEntityStore& GetEntityStore() const override;
 			MapCanvasLayer& GetLayer(LayerIndex layerIndex) override;
@@ -87,6 +93,7 @@ namespace bw
 			NazaraSignal(OnMultiSelectionStateUpdated, MapCanvas* /*emitter*/, bool /*newState*/);
 
 		private:
+			bool HasRunningAnimations();
 			inline void RegisterEntity(EntityId uniqueId, LayerVisualEntityHandle handle);
 			void OnKeyPressed(const Nz::WindowEvent::KeyEvent& key) override;
 			void OnKeyReleased(const Nz::WindowEvent::KeyEvent& key) override;
@@ -115,12 +122,14 @@ namespace bw
 			std::shared_ptr<ScriptingContext> m_scriptingContext;
 			std::shared_ptr<VirtualDirectory> m_assetDirectory;
 			std::shared_ptr<VirtualDirectory> m_scriptDirectory;
-			tsl::hopscotch_map<EntityId, LayerVisualEntityHandle> m_entitiesByUniqueId;
+			EntityRegistry<LayerVisualEntityHandle> m_entitiesByUniqueId;
 			std::vector<MapCanvasLayer> m_layers;
 			std::unique_ptr<EditorGizmo> m_entityGizmo;
+			std::size_t m_batchEditCounter;
 			EditorWindow& m_editor;
 			Ndk::EntityOwner m_currentLayerEntity;
 			Ndk::EntityOwner m_gridEntity;
+			bool m_isGizmoRefreshPending;
 			bool m_isPhysicsDebugDrawEnabled;
 	};
 }
@@ -16,8 +16,10 @@ namespace bw
 	template<typename F>
 	void MapCanvas::ForEachMapEntity(F&& func)
 	{
-		for (auto&& [uniqueId, visualEntityHandle] : m_entitiesByUniqueId)
+		m_entitiesByUniqueId.ForEach([&](EntityId /*uniqueId*/, const LayerVisualEntityHandle& visualEntityHandle)
+		{
 			func(*visualEntityHandle);
+		});
 	}
 
 	inline MapCanvasLayer* MapCanvas::GetActiveLayer()
@@ -45,6 +47,12 @@ namespace bw
 		return m_assetDirectory;
 	}
 
+	inline const ClientAssetStore& MapCanvas::GetAssetStore() const
+	{
+		assert(m_assetStore);
+		return *m_assetStore;
+	}
+
 	inline ScriptingContext& MapCanvas::GetScriptingContext()
 	{
 		return *m_scriptingContext;
@@ -62,13 +70,13 @@ namespace bw
 
 	inline void MapCanvas::RegisterEntity(EntityId uniqueId, LayerVisualEntityHandle handle)
 	{
-		assert(m_entitiesByUniqueId.find(uniqueId) == m_entitiesByUniqueId.end());
-		m_entitiesByUniqueId.emplace(uniqueId, std::move(handle));
+		m_entitiesByUniqueId.Emplace(uniqueId, std::move(handle));
 	}
 
 	inline void MapCanvas::UnregisterEntity(EntityId uniqueId)
 	{
-		assert(m_entitiesByUniqueId.find(uniqueId) != m_entitiesByUniqueId.end());
-		m_entitiesByUniqueId.erase(uniqueId);
+		bool erased = m_entitiesByUniqueId.Erase(uniqueId);
+		NazaraUnused(erased);
+		assert(erased);
 	}
 }
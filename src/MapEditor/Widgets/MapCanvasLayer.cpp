@@ -56,6 +56,8 @@ namespace bw
 
 		OnEntityVisualCreated(this, visualEntity);
 
+		IndexEntity(uniqueId, visualEntity);
+
 		return visualEntity;
 	}
 
@@ -67,6 +69,7 @@ namespace bw
 
 		OnEntityVisualDelete(this, it.value());
 
+		UnindexEntity(uniqueId);
 		m_layerEntities.erase(it);
 		m_mapCanvas.UnregisterEntity(uniqueId);
 	}
@@ -81,4 +84,86 @@ namespace bw
 	{
 		return true;
 	}
+
+	void MapCanvasLayer::RebuildSpatialIndex()
+	{
+		m_indexedEntities.clear();
+		m_oversizedEntities.clear();
+		m_spatialCells.clear();
+
+		for (auto it = m_layerEntities.begin(); it != m_layerEntities.end(); ++it)
+			IndexEntity(it->first, it->second);
+	}
+
+	void MapCanvasLayer::UpdateEntityBounds(EntityId uniqueId)
+	{
+		auto it = m_layerEntities.find(uniqueId);
+		if (it == m_layerEntities.end())
+			return;
+
+		IndexEntity(uniqueId, it->second);
+	}
+
+	void MapCanvasLayer::IndexEntity(EntityId uniqueId, const LayerVisualEntity& visualEntity)
+	{
+		UnindexEntity(uniqueId);
+
+		Nz::Boxf globalBounds = visualEntity.GetGlobalBounds();
+
+		IndexedEntity& indexedEntity = m_indexedEntities[uniqueId];
+		indexedEntity.bounds = Nz::Rectf(globalBounds.x, globalBounds.y, globalBounds.width, globalBounds.height);
+		indexedEntity.cells = ComputeCellRect(indexedEntity.bounds);
+		indexedEntity.isOversized = (Nz::UInt64(indexedEntity.cells.width) * Nz::UInt64(indexedEntity.cells.height) > MaxEntityCellCount);
+
+		if (indexedEntity.isOversized)
+		{
+			m_oversizedEntities.push_back(uniqueId);
+			return;
+		}
+
+		const Nz::Recti& cells = indexedEntity.cells;
+		for (int y = cells.y; y < cells.y + cells.height; ++y)
+		{
+			for (int x = cells.x; x < cells.x + cells.width; ++x)
+				m_spatialCells[BuildCellKey(x, y)].push_back(uniqueId);
+		}
+	}
+
+	void MapCanvasLayer::UnindexEntity(EntityId uniqueId)
+	{
+		auto it = m_indexedEntities.find(uniqueId);
+		if (it == m_indexedEntities.end())
+			return;
+
+		auto RemoveId = [&](std::vector<EntityId>& entityIds)
+		{
+			auto idIt = std::find(entityIds.begin(), entityIds.end(), uniqueId);
+			assert(idIt != entityIds.end());
+
+			std::swap(*idIt, entityIds.back());
+			entityIds.pop_back();
+		};
+
+		const IndexedEntity& indexedEntity = it->second;
+		if (indexedEntity.isOversized)
+			RemoveId(m_oversizedEntities);
+		else
+		{
+			const Nz::Recti& cells = indexedEntity.cells;
+			for (int y = cells.y; y < cells.y + cells.height; ++y)
+			{
+				for (int x = cells.x; x < cells.x + cells.width; ++x)
+				{
+					auto cellIt = m_spatialCells.find(BuildCellKey(x, y));
+					assert(cellIt != m_spatialCells.end());
+
+					RemoveId(cellIt.value());
+					if (cellIt->second.empty())
+						m_spatialCells.erase(cellIt);
+				}
+			}
+		}
+
+		m_indexedEntities.erase(it);
+	}
 }
@@ -12,7 +12,9 @@
 #include <ClientLib/ClientEditorLayer.hpp>
 #include <ClientLib/LayerVisualEntity.hpp>
 #include <Nazara/Math/Angle.hpp>
+#include <Nazara/Math/Rect.hpp>
 #include <NDK/World.hpp>
+#include <tsl/hopscotch_map.h>
 #include <memory>
 #include <vector>
 
@@ -32,15 +34,40 @@ namespace bw
 			void DeleteEntity(EntityId uniqueId);
 
 			void ForEachVisualEntity(const std::function<void(LayerVisualEntity& visualEntity)>& func) override;
+			template<typename F> void ForEachVisualEntityInRect(const Nz::Rectf& rect, F&& func);
 
 			bool IsEnabled() const override;
 
+			void RebuildSpatialIndex();
+
+			void UpdateEntityBounds(EntityId uniqueId);
+
 			MapCanvasLayer& operator=(const MapCanvasLayer&) = default;
 			MapCanvasLayer& operator=(MapCanvasLayer&&) = delete;
 
+			static constexpr float CellSize = 256.f;
+			static constexpr std::size_t MaxEntityCellCount = 64; //< bigger entities are always tested instead of filling cells
+
 		private:
+			struct IndexedEntity
+			{
+				Nz::Rectf bounds;
+				Nz::Recti cells; //< unused for oversized entities
+				bool isOversized;
+			};
+
+			void IndexEntity(EntityId uniqueId, const LayerVisualEntity& visualEntity);
+			void UnindexEntity(EntityId uniqueId);
+
+			static inline Nz::UInt64 BuildCellKey(int x, int y);
+			static inline Nz::Recti ComputeCellRect(const Nz::Rectf& rect);
+			static inline bool Overlaps(const Nz::Rectf& lhs, const Nz::Rectf& rhs);
+
 			MapCanvas& m_mapCanvas;
+			std::vector<EntityId> m_oversizedEntities;
+			tsl::hopscotch_map<EntityId, IndexedEntity> m_indexedEntities;
 			tsl::hopscotch_map<EntityId, LayerVisualEntity> m_layerEntities;
+			tsl::hopscotch_map<Nz::UInt64 /*cell*/, std::vector<EntityId>> m_spatialCells;
 	};
 }
 
@@ -3,7 +3,105 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <MapEditor/Widgets/MapCanvasLayer.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 namespace bw
 {
+	// Calls func for every entity whose bounds (as of their last update) overlap rect, callers are expected to do their own precise test
+	template<typename F>
+	void MapCanvasLayer::ForEachVisualEntityInRect(const Nz::Rectf& rect, F&& func)
+	{
+		auto ReportEntity = [&](EntityId uniqueId, const IndexedEntity& indexedEntity)
+		{
+			if (!Overlaps(indexedEntity.bounds, rect))
+				return;
+
+			auto it = m_layerEntities.find(uniqueId);
+			assert(it != m_layerEntities.end());
+
+			func(it.value());
+		};
+
+		for (EntityId uniqueId : m_oversizedEntities)
+		{
+			auto it = m_indexedEntities.find(uniqueId);
+			assert(it != m_indexedEntities.end());
+
+			ReportEntity(uniqueId, it->second);
+		}
+
+		Nz::Recti queryCells = ComputeCellRect(rect);
+
+		auto VisitCell = [&](int x, int y, const std::vector<EntityId>& cellEntities)
+		{
+			for (EntityId uniqueId : cellEntities)
+			{
+				auto it = m_indexedEntities.find(uniqueId);
+				assert(it != m_indexedEntities.end());
+
+				const IndexedEntity& indexedEntity = it->second;
+
+				// Entities spanning multiple cells are only reported from the first queried cell they're in
+				if (x != std::max(indexedEntity.cells.x, queryCells.x) || y != std::max(indexedEntity.cells.y, queryCells.y))
+					continue;
+
+				ReportEntity(uniqueId, indexedEntity);
+			}
+		};
+
+		// Big queries (such as perspective picking rays) are cheaper going through occupied cells only
+		if (Nz::UInt64(queryCells.width) * Nz::UInt64(queryCells.height) > m_spatialCells.size())
+		{
+			for (auto it = m_spatialCells.begin(); it != m_spatialCells.end(); ++it)
+			{
+				int x = static_cast<int>(static_cast<Nz::UInt32>(it->first >> 32));
+				int y = static_cast<int>(static_cast<Nz::UInt32>(it->first & 0xFFFFFFFF));
+				if (x >= queryCells.x && x < queryCells.x + queryCells.width && y >= queryCells.y && y < queryCells.y + queryCells.height)
+					VisitCell(x, y, it->second);
+			}
+		}
+		else
+		{
+			for (int y = queryCells.y; y < queryCells.y + queryCells.height; ++y)
+			{
+				for (int x = queryCells.x; x < queryCells.x + queryCells.width; ++x)
+				{
+					auto it = m_spatialCells.find(BuildCellKey(x, y));
+					if (it != m_spatialCells.end())
+						VisitCell(x, y, it->second);
+				}
+			}
+		}
+	}
+
+	inline Nz::UInt64 MapCanvasLayer::BuildCellKey(int x, int y)
+	{
+		return (Nz::UInt64(static_cast<Nz::UInt32>(x)) << 32) | static_cast<Nz::UInt32>(y);
+	}
+
+	inline Nz::Recti MapCanvasLayer::ComputeCellRect(const Nz::Rectf& rect)
+	{
+		// Clamp coordinates so unbounded rects don't overflow cell indices
+		constexpr float MaxCellIndex = 1 << 24;
+
+		auto ToCell = [&](float coord)
+		{
+			return static_cast<int>(std::clamp(std::floor(coord / CellSize), -MaxCellIndex, MaxCellIndex));
+		};
+
+		int firstX = ToCell(rect.x);
+		int firstY = ToCell(rect.y);
+		int lastX = ToCell(rect.x + rect.width);
+		int lastY = ToCell(rect.y + rect.height);
+
+		return Nz::Recti(firstX, firstY, lastX - firstX + 1, lastY - firstY + 1);
+	}
+
+	inline bool MapCanvasLayer::Overlaps(const Nz::Rectf& lhs, const Nz::Rectf& rhs)
+	{
+		// Unlike Nz::Rect::Intersect, touching (and empty) rects overlap, as entities without visuals have an empty bounding box
+		return lhs.x <= rhs.x + rhs.width && rhs.x <= lhs.x + lhs.width && lhs.y <= rhs.y + rhs.height && rhs.y <= lhs.y + lhs.height;
+	}
 }
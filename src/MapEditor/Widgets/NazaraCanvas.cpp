@@ -9,7 +9,10 @@
 namespace bw
 {
 	NazaraCanvas::NazaraCanvas(QWidget* parent) :
-	QWidget(parent)
+	QWidget(parent),
+	m_isRedrawRequested(false),
+	m_isRenderOnDemandEnabled(false),
+	m_isShown(false)
 	{
 		// Setup some states to allow direct rendering into the widget
 		setAttribute(Qt::WA_PaintOnScreen);
@@ -27,7 +30,13 @@ namespace bw
 		m_updateTimer.setInterval(1000 / 60);
 		m_updateTimer.connect(&m_updateTimer, &QTimer::timeout, [this]()
 		{
+			m_isRedrawRequested = false;
+
 			OnUpdate(m_updateTimer.intervalAsDuration().count() / 1000.f);
+
+			// Updating may request another frame (animations running, ...)
+			if (m_isRenderOnDemandEnabled && !m_isRedrawRequested)
+				m_updateTimer.stop();
 		});
 	}
 
@@ -36,6 +45,12 @@ namespace bw
 		m_updateTimer.stop();
 	}
 
+	void NazaraCanvas::EnableRenderOnDemand(bool enable)
+	{
+		m_isRenderOnDemandEnabled = enable;
+		RequestRedraw();
+	}
+
 	Nz::Vector2ui NazaraCanvas::GetSize() const
 	{
 		return Nz::Vector2ui(Nz::Vector2i(width(), height()));
@@ -46,6 +61,14 @@ namespace bw
 		return QSize(640, 480);
 	}
 
+	void NazaraCanvas::RequestRedraw()
+	{
+		m_isRedrawRequested = true;
+
+		if (m_isShown && !m_updateTimer.isActive())
+			m_updateTimer.start();
+	}
+
 	QSize NazaraCanvas::sizeHint() const
 	{
 		return QSize();
@@ -54,6 +77,7 @@ namespace bw
 	void NazaraCanvas::resizeEvent(QResizeEvent*)
 	{
 		OnWindowResized();
+		RequestRedraw();
 	}
 
 	void NazaraCanvas::showEvent(QShowEvent*)
@@ -77,6 +101,7 @@ namespace bw
 
 	void NazaraCanvas::OnHide()
 	{
+		m_isShown = false;
 		m_updateTimer.stop();
 
 		Nz::WindowEvent event;
@@ -87,6 +112,7 @@ namespace bw
 
 	void NazaraCanvas::OnShow()
 	{
+		m_isShown = true;
 		m_updateTimer.start();
 
 		Nz::WindowEvent event;
@@ -113,6 +139,8 @@ namespace bw
 
 	void NazaraCanvas::paintEvent(QPaintEvent*)
 	{
+		// Widget was exposed or resized
+		RequestRedraw();
 	}
 
 	bool NazaraCanvas::event(QEvent* e)
@@ -169,7 +197,7 @@ namespace bw
 					event.key.virtualKey = key.value();
 					event.key.scancode = Nz::Keyboard::ToScanCode(event.key.virtualKey);
 
-					PushEvent(event);
+					PushInputEvent(event);
 					ignoreEvent = true;
 				}
 
@@ -182,7 +210,7 @@ namespace bw
 					event.text.character = u32str[0];
 					event.text.repeated = keyEvent->isAutoRepeat();
 
-					PushEvent(event);
+					PushInputEvent(event);
 				}
 
 				if (ignoreEvent)
@@ -210,7 +238,7 @@ namespace bw
 					event.key.virtualKey = key.value();
 					event.key.scancode = Nz::Keyboard::ToScanCode(event.key.virtualKey);
 
-					PushEvent(event);
+					PushInputEvent(event);
 					return true;
 				}
 
@@ -232,7 +260,7 @@ namespace bw
 					event.mouseButton.y = pos.y();
 					event.mouseButton.button = button.value();
 
-					PushEvent(event);
+					PushInputEvent(event);
 					return true;
 				}
 
@@ -254,7 +282,7 @@ namespace bw
 					event.mouseButton.y = pos.y();
 					event.mouseButton.button = button.value();
 
-					PushEvent(event);
+					PushInputEvent(event);
 					return true;
 				}
 
@@ -266,7 +294,7 @@ namespace bw
 				Nz::WindowEvent event;
 				event.type = Nz::WindowEventType_MouseEntered;
 
-				PushEvent(event);
+				PushInputEvent(event);
 				return true;
 			}
 
@@ -275,7 +303,7 @@ namespace bw
 				Nz::WindowEvent event;
 				event.type = Nz::WindowEventType_MouseLeft;
 
-				PushEvent(event);
+				PushInputEvent(event);
 				return true;
 			}
 
@@ -292,7 +320,7 @@ namespace bw
 				event.mouseMove.deltaX = newPos.x() - oldPos.x();
 				event.mouseMove.deltaY = newPos.y() - oldPos.y();
 
-				PushEvent(event);
+				PushInputEvent(event);
 				return true;
 			}
 
@@ -304,7 +332,7 @@ namespace bw
 				event.type = Nz::WindowEventType_MouseWheelMoved;
 				event.mouseWheel.delta = wheelEvent->angleDelta().ry() / 120.f;
 
-				PushEvent(event);
+				PushInputEvent(event);
 				return true;
 			}
 
@@ -313,4 +341,11 @@ namespace bw
 		}
 		return QWidget::event(e);
 	}
+
+	void NazaraCanvas::PushInputEvent(const Nz::WindowEvent& event)
+	{
+		// Input may change what's displayed (camera, gizmos, hovered entities, ...)
+		PushEvent(event);
+		RequestRedraw();
+	}
 }
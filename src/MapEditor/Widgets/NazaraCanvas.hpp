@@ -19,9 +19,17 @@ namespace bw
 			NazaraCanvas(QWidget* parent = nullptr);
 			virtual ~NazaraCanvas();
 
+			// Only update and render when something requested it (input, RequestRedraw), instead of continuously
+			void EnableRenderOnDemand(bool enable = true);
+
 			Nz::Vector2ui GetSize() const override;
 
+			inline bool IsRenderOnDemandEnabled() const;
+
 			QSize minimumSizeHint() const override;
+
+			void RequestRedraw();
+
 			QSize sizeHint() const override;
 
 		protected:
@@ -39,7 +47,12 @@ namespace bw
 			bool event(QEvent* e) override;
 
 		private:
+			void PushInputEvent(const Nz::WindowEvent& event);
+
 			QTimer m_updateTimer;
+			bool m_isRedrawRequested;
+			bool m_isRenderOnDemandEnabled;
+			bool m_isShown;
 	};
 }
 
@@ -2,6 +2,12 @@
 // This file is part of the "Nazara Development Kit Qt Layer"
 // For conditions of distribution and use, see copyright notice in Prerequisites.hpp
 
+#include <MapEditor/Widgets/NazaraCanvas.hpp>
+
 namespace bw
 {
+	inline bool NazaraCanvas::IsRenderOnDemandEnabled() const
+	{
+		return m_isRenderOnDemandEnabled;
+	}
 }
@@ -15,7 +15,7 @@
 
 namespace bw
 {
-	PlayWindow::PlayWindow(ClientEditorApp& app, Map map, float tickRate, QWidget* parent) :
+	PlayWindow::PlayWindow(ClientEditorApp& app, Map map, float tickRate, const ClientAssetStore* editorAssetStore, QWidget* parent) :
 	NazaraCanvas(parent),
 	m_canvas(m_world.CreateHandle(), GetEventHandler(), GetCursorController().CreateHandle())
 	{
@@ -74,6 +74,10 @@ namespace bw
 
 			// TODO: Filter out server files
 			m_clientMatch->LoadAssets(m_match->GetAssetDirectory());
+
+			// Textures, models and sounds the editor already loaded don't have to be loaded again
+			if (editorAssetStore)
+				m_clientMatch->GetAssetStore().ImportAssets(*editorAssetStore);
 			m_clientMatch->LoadScripts(m_match->GetScriptDirectory());
 
 			session->SendPacket(Packets::Ready{});
@@ -15,6 +15,7 @@
 
 namespace bw
 {
+	class ClientAssetStore;
 	class ClientEditorApp;
 	class Map;
 	class VirtualDirectory;
@@ -22,7 +23,7 @@ namespace bw
 	class PlayWindow : public NazaraCanvas
 	{
 		public:
-			PlayWindow(ClientEditorApp& app, Map map, float tickRate, QWidget* parent = nullptr);
+			PlayWindow(ClientEditorApp& app, Map map, float tickRate, const ClientAssetStore* editorAssetStore = nullptr, QWidget* parent = nullptr);
 			~PlayWindow() = default;
 
 		private:
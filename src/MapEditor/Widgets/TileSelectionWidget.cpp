@@ -26,6 +26,7 @@ namespace bw
 	m_activeGroup(InvalidGroup),
 	m_firstSelectedTile(0),
 	m_lastSelectedTile(0),
+	m_tilesetGroups(tilesetGroups),
 	m_tileSize(64.f, 64.f)
 	{
 		setWindowTitle(tr("Tile selector"));
@@ -51,7 +52,8 @@ namespace bw
 
 		QTabBar* groupBar = new QTabBar;
 
-		for (const TilesetGroup& tilesetGroup : tilesetGroups)
+		// Only compute the layout of every group, their tilemaps are built when displayed
+		for (const TilesetGroup& tilesetGroup : m_tilesetGroups)
 		{
 			groupBar->addTab(QString::fromStdString(tilesetGroup.groupName));
 
@@ -61,44 +63,12 @@ namespace bw
 				mapSize.x = std::max(mapSize.x, material.tileCount.x);
 				mapSize.y += material.tileCount.y;
 			}
-			//unsigned int tileMapSide = static_cast<unsigned int>(std::ceil(std::sqrt(tileData.size() + 1)));
 
-			Nz::TileMapRef tileMap = Nz::TileMap::New(mapSize, m_tileSize, tilesetGroup.materials.size());
-
-			Nz::Vector2ui tileCursor = Nz::Vector2ui::Zero();
-
-			std::size_t matIndex = 0;
-			for (const MaterialData& materialData : tilesetGroup.materials)
-			{
-				tileMap->SetMaterial(matIndex, materialData.material);
-
-				Nz::Vector2f invTileCount = 1.f / Nz::Vector2f(materialData.tileCount);
-
-				for (std::size_t y = 0; y < materialData.tileCount.y; ++y)
-				{
-					for (std::size_t x = 0; x < materialData.tileCount.x; ++x)
-					{
-						Nz::Rectf texCoords = Nz::Rectf(invTileCount * Nz::Vector2f(x, y), invTileCount * Nz::Vector2f(x + 1, y + 1));
-						tileMap->EnableTile(Nz::Vector2ui(tileCursor.x + static_cast<unsigned int>(x), tileCursor.y + static_cast<unsigned int>(y)), texCoords, Nz::Color::White, matIndex);
-					}
-				}
-				
-				tileCursor.y += materialData.tileCount.y;
-
-				matIndex++;
-			}
-
-			const Ndk::EntityHandle& tilemapEntity = m_tileSelectionCanvas->GetWorld().CreateEntity();
-			tilemapEntity->AddComponent<Ndk::NodeComponent>();
-			tilemapEntity->AddComponent<Ndk::GraphicsComponent>().Attach(tileMap);
-			tilemapEntity->Disable();
-
-			Nz::Vector2f tileMapSize = Nz::Vector2f(tileMap->GetMapSize()) * tileMap->GetTileSize();
+			Nz::Vector2f tileMapSize = Nz::Vector2f(mapSize) * m_tileSize;
 
 			GroupData& group = m_groups.emplace_back();
 			group.contentSize = Nz::Vector2i(std::ceil(tileMapSize.x), std::ceil(tileMapSize.y));
 			group.mapSize = mapSize;
-			group.tilemap = tilemapEntity;
 
 			std::size_t rectIndex = 0;
 			for (const MaterialData& materialData : tilesetGroup.materials)
@@ -161,8 +131,61 @@ namespace bw
 
 		m_activeGroup = groupIndex;
 
+		if (!m_groups[m_activeGroup].tilemap)
+			BuildGroupTilemap(m_activeGroup);
+
 		m_groups[m_activeGroup].tilemap->Enable();
 		m_tileSelectionCanvas->SetContentSize(m_groups[m_activeGroup].contentSize);
+		m_tileSelectionCanvas->GetWorldCanvas()->RequestRedraw();
+	}
+
+	void TileSelectionWidget::BuildGroupTilemap(std::size_t groupIndex)
+	{
+		const TilesetGroup& tilesetGroup = m_tilesetGroups[groupIndex];
+		GroupData& group = m_groups[groupIndex];
+
+		const Ndk::EntityHandle& tilemapEntity = m_tileSelectionCanvas->GetWorld().CreateEntity();
+		tilemapEntity->AddComponent<Ndk::NodeComponent>();
+		auto& tilemapGraphics = tilemapEntity->AddComponent<Ndk::GraphicsComponent>();
+
+		// Split the palette in chunks of rows, each one being culled separately when scrolling through big tilesets
+		std::vector<Nz::TileMapRef> chunks;
+		for (unsigned int firstRow = 0; firstRow < group.mapSize.y; firstRow += ChunkRowCount)
+		{
+			Nz::Vector2ui chunkSize(group.mapSize.x, std::min(ChunkRowCount, group.mapSize.y - firstRow));
+
+			Nz::TileMapRef& chunk = chunks.emplace_back(Nz::TileMap::New(chunkSize, m_tileSize, tilesetGroup.materials.size()));
+			for (std::size_t matIndex = 0; matIndex < tilesetGroup.materials.size(); ++matIndex)
+				chunk->SetMaterial(matIndex, tilesetGroup.materials[matIndex].material);
+
+			tilemapGraphics.Attach(chunk, Nz::Matrix4f::Translate(Nz::Vector2f(0.f, firstRow * m_tileSize.y)));
+		}
+
+		unsigned int tileCursorY = 0;
+
+		std::size_t matIndex = 0;
+		for (const MaterialData& materialData : tilesetGroup.materials)
+		{
+			Nz::Vector2f invTileCount = 1.f / Nz::Vector2f(materialData.tileCount);
+
+			for (unsigned int y = 0; y < materialData.tileCount.y; ++y)
+			{
+				unsigned int row = tileCursorY + y;
+				Nz::TileMap& chunk = *chunks[row / ChunkRowCount];
+
+				for (unsigned int x = 0; x < materialData.tileCount.x; ++x)
+				{
+					Nz::Rectf texCoords = Nz::Rectf(invTileCount * Nz::Vector2f(x, y), invTileCount * Nz::Vector2f(x + 1, y + 1));
+					chunk.EnableTile(Nz::Vector2ui(x, row % ChunkRowCount), texCoords, Nz::Color::White, matIndex);
+				}
+			}
+
+			tileCursorY += materialData.tileCount.y;
+
+			matIndex++;
+		}
+
+		group.tilemap = tilemapEntity;
 	}
 
 	void TileSelectionWidget::SelectRect(std::size_t firstRect, std::size_t lastRect)
@@ -203,6 +226,8 @@ namespace bw
 	void TileSelectionWidget::EnableClearMode()
 	{
 		m_selectedEntity->Disable();
+		m_tileSelectionCanvas->GetWorldCanvas()->RequestRedraw();
+
 		OnClearMode(this);
 	}
 
@@ -212,6 +237,7 @@ namespace bw
 		auto& currentGroup = m_groups[m_activeGroup];
 
 		m_selectedEntity->Enable();
+		m_tileSelectionCanvas->GetWorldCanvas()->RequestRedraw();
 
 		auto BuildTileSelection = [&](std::size_t tileIndex)
 		{
@@ -56,7 +56,10 @@ namespace bw
 				std::size_t tileIndex;
 			};
 
+			static constexpr unsigned int ChunkRowCount = 16;
+
 		private:
+			void BuildGroupTilemap(std::size_t groupIndex);
 			void EnableClearMode();
 			void EnableTileMode();
 			std::size_t GetHoveredTile(int x, int y);
@@ -67,7 +70,7 @@ namespace bw
 
 			struct GroupData
 			{
-				Ndk::EntityOwner tilemap;
+				Ndk::EntityOwner tilemap; //< built when the group is first displayed
 				Nz::Vector2i contentSize;
 				Nz::Vector2ui mapSize;
 				std::vector<std::size_t> materialFirstRectIndices;
@@ -81,6 +84,7 @@ namespace bw
 			std::size_t m_lastSelectedTile;
 			std::optional<std::size_t> m_currentSelectionFirstRect;
 			std::vector<GroupData> m_groups;
+			std::vector<TilesetGroup> m_tilesetGroups;
 			Ndk::EntityOwner m_selectedEntity;
 			Ndk::EntityOwner m_selectionEntity;
 			Nz::Bitset<Nz::UInt64> m_activeTiles;
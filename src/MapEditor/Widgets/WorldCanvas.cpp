@@ -19,6 +19,19 @@ namespace bw
 		Ndk::RenderSystem& renderSystem = m_world.AddSystem<Ndk::RenderSystem>();
 		renderSystem.SetGlobalUp(Nz::Vector3f::Down());
 
+		// Editor worlds are mostly static, only render them when something changes
+		EnableRenderOnDemand();
+
+		m_onCameraMove.Connect(m_camera.OnCameraMove, [this](Camera*, const Nz::Vector2f&)
+		{
+			RequestRedraw();
+		});
+
+		m_onCameraZoomFactorUpdate.Connect(m_camera.OnCameraZoomFactorUpdate, [this](Camera*, float)
+		{
+			RequestRedraw();
+		});
+
 		Nz::EventHandler& eventHandler = GetEventHandler();
 
 		eventHandler.OnKeyPressed.Connect([this](const Nz::EventHandler*, const Nz::WindowEvent::KeyEvent& keyEvent)
@@ -84,6 +97,8 @@ namespace bw
 		OnBackgroundColorUpdate(this, color);
 		m_backgroundColor = color;
 		m_world.GetSystem<Ndk::RenderSystem>().SetDefaultBackground(Nz::ColorBackground::New(color));
+
+		RequestRedraw();
 	}
 
 	void WorldCanvas::OnUpdate(float elapsedTime)
@@ -49,6 +49,9 @@ namespace bw
 			void OnUpdate(float elapsedTime) override;
 
 		private:
+			NazaraSlot(Camera, OnCameraMove, m_onCameraMove);
+			NazaraSlot(Camera, OnCameraZoomFactorUpdate, m_onCameraZoomFactorUpdate);
+
 			std::optional<CameraMovement> m_cameraMovement;
 			Nz::Color m_backgroundColor;
 			Ndk::World m_world;
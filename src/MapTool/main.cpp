@@ -3,20 +3,332 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <CoreLib/Map.hpp>
+#include <CoreLib/PackFile.hpp>
+#include <CoreLib/Protocol/PacketSerializer.hpp>
+#include <CoreLib/Protocol/Packets.hpp>
 #include <Main/Main.hpp>
+#include <Nazara/Core/ByteArray.hpp>
+#include <Nazara/Core/ByteStream.hpp>
+#include <Nazara/Core/ErrorFlags.hpp>
 #include <cxxopts.hpp>
 #include <fmt/format.h>
+#include <tsl/hopscotch_map.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <filesystem>
+#include <iterator>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+
+namespace
+{
+	struct ToolOptions
+	{
+		std::filesystem::path outputPath;
+		std::size_t benchIterationCount;
+		bool bench;
+		bool compile;
+		bool compress;
+		bool pack;
+		bool stats;
+	};
+
+	bw::Map LoadMap(const std::filesystem::path& inputPath, std::filesystem::path& mapName)
+	{
+		if (std::filesystem::is_directory(inputPath))
+		{
+			if (inputPath.has_filename())
+				mapName = inputPath.filename(); //< foo/bar => bar
+			else
+				mapName = inputPath.parent_path().filename(); //< foo/bar/ => bar
+
+			return bw::Map::LoadFromDirectory(inputPath);
+		}
+		else if (std::filesystem::is_regular_file(inputPath))
+		{
+			mapName = inputPath.stem(); //< foo/bar.bmap => bar
+			return bw::Map::LoadFromBinary(inputPath);
+		}
+		else if (std::filesystem::exists(inputPath))
+			throw std::runtime_error(inputPath.generic_u8string() + " is neither a directory nor a binary");
+		else
+			throw std::runtime_error(inputPath.generic_u8string() + " doesn't exist");
+	}
+
+	template<typename F>
+	std::size_t ComputeSerializedSize(F&& serialize)
+	{
+		Nz::ByteArray data;
+		{
+			Nz::ByteStream stream(&data, Nz::OpenMode_WriteOnly);
+			stream.SetDataEndianness(Nz::Endianness_LittleEndian);
+
+			serialize(stream);
+		}
+
+		return data.GetSize();
+	}
+
+	void PrintBenchmark(std::string& output, const std::filesystem::path& inputPath, const std::filesystem::path& mapName, const ToolOptions& options)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		auto Measure = [&](auto&& func)
+		{
+			Clock::time_point startTime = Clock::now();
+			for (std::size_t i = 0; i < options.benchIterationCount; ++i)
+				func();
+
+			return std::chrono::duration<double, std::milli>(Clock::now() - startTime).count() / options.benchIterationCount;
+		};
+
+		std::filesystem::path benchMapPath = std::filesystem::temp_directory_path() / (mapName.generic_u8string() + ".bench.bmap");
+
+		fmt::format_to(std::back_inserter(output), "\nBenchmark ({} iteration(s)):\n", options.benchIterationCount);
+
+		bw::Map map;
+		if (std::filesystem::is_directory(inputPath))
+			fmt::format_to(std::back_inserter(output), "- directory load: {:.2f} ms\n", Measure([&] { map = bw::Map::LoadFromDirectory(inputPath); }));
+		else
+			map = bw::Map::LoadFromBinary(inputPath);
+
+		double compileTime = Measure([&]
+		{
+			if (!map.Compile(benchMapPath, options.compress))
+				throw std::runtime_error("failed to compile map: failed to open " + benchMapPath.generic_u8string());
+		});
+
+		fmt::format_to(std::back_inserter(output), "- compile: {:.2f} ms ({} bytes)\n", compileTime, std::filesystem::file_size(benchMapPath));
+		fmt::format_to(std::back_inserter(output), "- binary load: {:.2f} ms\n", Measure([&] { bw::Map::LoadFromBinary(benchMapPath); }));
+
+		std::filesystem::remove(benchMapPath);
+	}
+
+	void PrintStatistics(std::string& output, const bw::Map& map)
+	{
+		// Entity types and property names are sent as network string indices, number them as the server would
+		tsl::hopscotch_map<std::string, Nz::UInt32> networkStrings;
+		auto GetStringIndex = [&](const std::string& str)
+		{
+			return networkStrings.emplace(str, Nz::UInt32(networkStrings.size())).first->second;
+		};
+
+		fmt::format_to(std::back_inserter(output), "\n{:<24} {:>10} {:>14} {:>14} {:>18}\n", "layer", "entities", "binary bytes", "property bytes", "EnableLayer bytes");
+
+		std::size_t totalEntityCount = 0;
+		std::size_t totalPropertySize = 0;
+		for (std::size_t i = 0; i < map.GetLayerCount(); ++i)
+		{
+			const auto& layer = map.GetLayer(static_cast<bw::LayerIndex>(i));
+
+			std::size_t binarySize = ComputeSerializedSize([&](Nz::ByteStream& stream) { bw::Map::WriteBinaryLayer(stream, layer); });
+
+			// Estimate initial layer payload from map data (entities may add health, physics and more properties once instantiated)
+			bw::Packets::EnableLayer enableLayer;
+			enableLayer.stateTick = 0;
+			enableLayer.layerIndex = static_cast<bw::LayerIndex>(i);
+
+			std::size_t propertySize = 0;
+			for (std::size_t entityIndex = 0; entityIndex < layer.entities.size(); ++entityIndex)
+			{
+				const auto& entity = layer.entities[entityIndex];
+
+				auto& packetEntity = enableLayer.layerEntities.emplace_back();
+				packetEntity.id = Nz::UInt32(entityIndex);
+				packetEntity.data.entityClass = GetStringIndex(entity.entityType);
+				packetEntity.data.uniqueId = Nz::UInt64(entity.uniqueId);
+				packetEntity.data.position = entity.position;
+				packetEntity.data.rotation = entity.rotation;
+
+				for (const auto& [name, value] : entity.properties)
+				{
+					auto& property = packetEntity.data.properties.emplace_back();
+					property.name = GetStringIndex(name);
+					property.value = value;
+
+					propertySize += ComputeSerializedSize([&](Nz::ByteStream& stream)
+					{
+						bw::PacketSerializer serializer(stream, true);
+						bw::Packets::Serialize(serializer, property);
+					});
+				}
+			}
+
+			std::size_t enableLayerSize = ComputeSerializedSize([&](Nz::ByteStream& stream)
+			{
+				bw::PacketSerializer serializer(stream, true);
+				bw::Packets::Serialize(serializer, enableLayer);
+			});
+
+			std::string layerName = fmt::format("#{} {}", i, layer.name);
+			fmt::format_to(std::back_inserter(output), "{:<24} {:>10} {:>14} {:>14} {:>18}\n", layerName, layer.entities.size(), binarySize, propertySize, enableLayerSize);
+
+			totalEntityCount += layer.entities.size();
+			totalPropertySize += propertySize;
+		}
+
+		fmt::format_to(std::back_inserter(output), "{:<24} {:>10} {:>14} {:>14}\n", "total", totalEntityCount, "", totalPropertySize);
+
+		std::size_t scriptSize = 0;
+		const bw::Map::Script* largestScript = nullptr;
+		for (const auto& script : map.GetScripts())
+		{
+			std::size_t contentSize = script.GetContent().size();
+			scriptSize += contentSize;
+
+			if (!largestScript || contentSize > largestScript->GetContent().size())
+				largestScript = &script;
+		}
+
+		fmt::format_to(std::back_inserter(output), "\n{} script(s), {} bytes", map.GetScripts().size(), scriptSize);
+		if (largestScript)
+			fmt::format_to(std::back_inserter(output), " (largest: {}, {} bytes)", largestScript->filepath, largestScript->GetContent().size());
+
+		std::size_t assetSize = 0;
+		const bw::Map::Asset* largestAsset = nullptr;
+		for (const auto& asset : map.GetAssets())
+		{
+			assetSize += asset.size;
+
+			if (!largestAsset || asset.size > largestAsset->size)
+				largestAsset = &asset;
+		}
+
+		fmt::format_to(std::back_inserter(output), "\n{} asset(s), {} bytes", map.GetAssets().size(), assetSize);
+		if (largestAsset)
+			fmt::format_to(std::back_inserter(output), " (largest: {}, {} bytes)", largestAsset->filepath, largestAsset->size);
+
+		output += '\n';
+	}
+
+	bool ProcessMap(const std::string& inputMap, const ToolOptions& options, std::string& output)
+	{
+		std::filesystem::path inputPath = inputMap;
+		std::filesystem::path mapName;
+
+		bw::Map map;
+
+		try
+		{
+			map = LoadMap(inputPath, mapName);
+		}
+		catch (const std::exception& e)
+		{
+			fmt::format_to(std::back_inserter(output), "{0}: {1}\n", inputMap, e.what());
+			return false;
+		}
+
+		try
+		{
+			if (options.compile)
+			{
+				std::filesystem::path outputPath = options.outputPath / mapName;
+				if (outputPath.extension() != "bmap")
+					outputPath += ".bmap";
+
+				if (!map.Compile(outputPath, options.compress))
+					throw std::runtime_error("failed to compile map: failed to open " + outputPath.generic_u8string());
+
+				fmt::format_to(std::back_inserter(output), "successfully compiled map {0} to {1}\n", inputMap, outputPath.generic_u8string());
+			}
+			else
+			{
+				// Show info about the map
+				const auto& mapInfo = map.GetMapInfo();
+
+				fmt::format_to(std::back_inserter(output), "{input_map} info:\n- Name: {name}\n- Description: {desc}\n- Author: {author}\n",
+					fmt::arg("input_map", inputMap),
+					fmt::arg("name", mapInfo.name),
+					fmt::arg("desc", mapInfo.description),
+					fmt::arg("author", mapInfo.author));
+
+				if (!options.stats)
+				{
+					std::size_t layerCount = map.GetLayerCount();
+					fmt::format_to(std::back_inserter(output), "\nThis map has {} layer(s):\n", layerCount);
+					for (std::size_t i = 0; i < layerCount; ++i)
+					{
+						const auto& layer = map.GetLayer(static_cast<bw::LayerIndex>(i));
+						fmt::format_to(std::back_inserter(output), "- layer #{} ({}) has {} entities\n", i, layer.name, layer.entities.size());
+					}
+				}
+			}
+
+			if (options.stats)
+				PrintStatistics(output, map);
+
+			if (options.bench)
+				PrintBenchmark(output, inputPath, mapName, options);
+		}
+		catch (const std::exception& e)
+		{
+			fmt::format_to(std::back_inserter(output), "{0}: {1}\n", inputMap, e.what());
+			return false;
+		}
+
+		return true;
+	}
+
+	bool ProcessPack(const std::string& inputDirectory, const ToolOptions& options, std::string& output)
+	{
+		std::filesystem::path inputPath = inputDirectory;
+		if (!std::filesystem::is_directory(inputPath))
+		{
+			fmt::format_to(std::back_inserter(output), "{0}: not a directory\n", inputDirectory);
+			return false;
+		}
+
+		std::filesystem::path packName = (inputPath.has_filename()) ? inputPath.filename() : inputPath.parent_path().filename();
+
+		try
+		{
+			std::vector<bw::PackFile::SourceFile> files;
+			for (const std::filesystem::path& path : std::filesystem::recursive_directory_iterator(inputPath))
+			{
+				if (!std::filesystem::is_regular_file(path))
+					continue;
+
+				auto& sourceFile = files.emplace_back();
+				sourceFile.path = std::filesystem::relative(path, inputPath).generic_u8string();
+				sourceFile.physicalPath = path;
+			}
+
+			std::size_t fileCount = files.size();
+
+			std::filesystem::path outputPath = options.outputPath / packName;
+			outputPath += ".bwpack";
+
+			if (!bw::PackFile::Build(outputPath, std::move(files), options.compress))
+				throw std::runtime_error("failed to build pack " + outputPath.generic_u8string());
+
+			fmt::format_to(std::back_inserter(output), "successfully packed {0} file(s) from {1} to {2}\n", fileCount, inputDirectory, outputPath.generic_u8string());
+		}
+		catch (const std::exception& e)
+		{
+			fmt::format_to(std::back_inserter(output), "{0}: {1}\n", inputDirectory, e.what());
+			return false;
+		}
+
+		return true;
+	}
+}
 
 int BurgWarMapTool(int argc, char* argv[])
 {
 	cxxopts::Options options("BurgWarMapTool", "Tool for compiling BurgWar maps in CLI");
 	options.add_options()
+		("b,bench", "Time directory load, compilation and binary load of the maps")
+		("bench-iterations", "Iteration count of each benchmarked operation", cxxopts::value<std::size_t>()->default_value("5"), "count")
 		("c,compile", "Compile input maps to binary map format")
 		("i,input", "Input file(s)", cxxopts::value<std::vector<std::string>>())
+		("j,jobs", "Maps processed in parallel (0 = one per core)", cxxopts::value<std::size_t>()->default_value("0"), "count")
 		("o,output", "Output folder", cxxopts::value<std::string>()->default_value("."), "path")
+		("p,pack", "Pack input directories (such as mod scripts) into .bwpack files")
 		("s,show", "Show informations about the map (default)")
+		("stats", "Show per-layer entity counts, property and network payload sizes along with script and asset sizes")
+		("u,uncompressed", "Don't compress sections of compiled maps (or files of packs)")
 		("h,help", "Print usage")
 	;
 
@@ -38,77 +350,71 @@ int BurgWarMapTool(int argc, char* argv[])
 			return EXIT_SUCCESS;
 		}
 
+		ToolOptions toolOptions;
+		toolOptions.bench = result.count("bench") > 0;
+		toolOptions.benchIterationCount = std::max<std::size_t>(result["bench-iterations"].as<std::size_t>(), 1);
+		toolOptions.compile = result.count("compile") > 0;
+		toolOptions.compress = result.count("uncompressed") == 0;
+		toolOptions.outputPath = result["output"].as<std::string>();
+		toolOptions.pack = result.count("pack") > 0;
+		toolOptions.stats = result.count("stats") > 0;
+
+		if ((toolOptions.compile || toolOptions.pack) && !std::filesystem::is_directory(toolOptions.outputPath))
+			std::filesystem::create_directories(toolOptions.outputPath);
+
 		std::vector<std::string> inputMaps = result["input"].as<std::vector<std::string>>();
-		for (const std::string& inputMap : inputMaps)
-		{
-			std::filesystem::path inputPath = inputMap;
-			std::filesystem::path mapName;
 
-			if (inputMaps.size() > 1)
-				fmt::print("--- {0} ---\n", inputPath.generic_u8string());
+		// Concurrent loads would skew timings
+		std::size_t jobCount = result["jobs"].as<std::size_t>();
+		if (toolOptions.bench)
+			jobCount = 1;
+		else if (jobCount == 0)
+			jobCount = std::max(std::thread::hardware_concurrency(), 1U);
 
-			bw::Map map;
+		jobCount = std::min(jobCount, inputMaps.size());
 
-			try
-			{
-				if (std::filesystem::is_directory(inputPath))
-				{
-					map = bw::Map::LoadFromDirectory(inputPath);
-					if (inputPath.has_filename())
-						mapName = inputPath.filename(); //< foo/bar => bar
-					else
-						mapName = inputPath.parent_path().filename(); //< foo/bar/ => bar
-				}
-				else if (std::filesystem::is_regular_file(inputPath))
-				{
-					map = bw::Map::LoadFromBinary(inputPath);
-					mapName = inputPath.stem(); //< foo/bar.bmap => bar
-				}
-				else if (std::filesystem::exists(inputPath))
-					throw std::runtime_error(inputMap + " is neither a directory nor a binary");
-				else
-					throw std::runtime_error(inputMap + " doesn't exist");
-			}
-			catch (const std::exception& e)
-			{
-				fmt::print(stderr, "{0}: {1}\n", inputMap, e.what());
-				continue;
-			}
+		// Error flags are global, set them once for all threads instead of having them toggled concurrently by map loaders
+		Nz::ErrorFlags errFlags(Nz::ErrorFlag_ThrowException);
+
+		std::mutex outputMutex;
+		std::atomic_size_t nextIndex = 0;
+		std::atomic_size_t failedCount = 0;
 
-			if (result.count("compile") > 0)
+		auto ProcessMaps = [&]
+		{
+			std::size_t index;
+			while ((index = nextIndex++) < inputMaps.size())
 			{
-				std::filesystem::path outputPath = result["output"].as<std::string>();
-				if (!std::filesystem::is_directory(outputPath))
-					std::filesystem::create_directories(outputPath);
+				const std::string& inputMap = inputMaps[index];
 
-				outputPath /= mapName;
-				if (outputPath.extension() != "bmap")
-					outputPath += ".bmap";
+				std::string output;
+				if (inputMaps.size() > 1)
+					output = fmt::format("--- {0} ---\n", inputMap);
 
-				if (!map.Compile(outputPath))
-					throw std::runtime_error("failed to compile map: failed to open " + outputPath.generic_u8string());
+				bool success = (toolOptions.pack) ? ProcessPack(inputMap, toolOptions, output) : ProcessMap(inputMap, toolOptions, output);
+				if (!success)
+					failedCount++;
 
-				fmt::print("successfully compiled map {0} to {1}\n", inputMap, outputPath.generic_u8string());
+				// Print each map output at once, so parallel jobs don't interleave their lines
+				std::lock_guard<std::mutex> lock(outputMutex);
+				fmt::print((success) ? stdout : stderr, "{}", output);
 			}
-			else
-			{
-				// Show info about the map
-				const auto& mapInfo = map.GetMapInfo();
+		};
 
-				fmt::print("{input_map} info:\n- Name: {name}\n- Description: {desc}\n- Author: {author}\n", 
-					fmt::arg("input_map", inputMap), 
-					fmt::arg("name", mapInfo.name), 
-					fmt::arg("desc", mapInfo.description), 
-					fmt::arg("author", mapInfo.author));
+		std::vector<std::thread> threads;
+		threads.reserve(jobCount - 1);
+		for (std::size_t i = 1; i < jobCount; ++i)
+			threads.emplace_back(ProcessMaps);
 
-				std::size_t layerCount = map.GetLayerCount();
-				fmt::print("\nThis map has {} layer(s):\n", layerCount);
-				for (std::size_t i = 0; i < layerCount; ++i)
-				{
-					const auto& layer = map.GetLayer(static_cast<bw::LayerIndex>(i));
-					fmt::print("- layer #{} ({}) has {} entities\n", i, layer.name, layer.entities.size());
-				}
-			}
+		ProcessMaps();
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		if (failedCount > 0)
+		{
+			fmt::print(stderr, "{0} map(s) out of {1} failed\n", failedCount.load(), inputMaps.size());
+			return EXIT_FAILURE;
 		}
 	}
 	catch (const cxxopts::OptionException& e)
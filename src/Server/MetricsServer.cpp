@@ -0,0 +1,285 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Server/MetricsServer.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <Nazara/Network/Algorithm.hpp>
+#include <fmt/format.h>
+#include <array>
+#include <stdexcept>
+
+namespace bw
+{
+	namespace
+	{
+		std::string EscapeLabel(std::string_view value)
+		{
+			std::string escaped;
+			escaped.reserve(value.size());
+			for (char c : value)
+			{
+				switch (c)
+				{
+					case '\\': escaped += "\\\\"; break;
+					case '"':  escaped += "\\\""; break;
+					case '\n': escaped += "\\n"; break;
+					default:   escaped += c; break;
+				}
+			}
+
+			return escaped;
+		}
+
+		std::string BuildResponse(std::string_view status, std::string_view contentType, std::string_view body)
+		{
+			return fmt::format("HTTP/1.1 {0}\r\nContent-Type: {1}\r\nContent-Length: {2}\r\nConnection: close\r\n\r\n{3}", status, contentType, body.size(), body);
+		}
+	}
+
+	MetricsServer::MetricsServer(const Logger& logger, Nz::UInt16 port, MetricsCallback callback) :
+	m_logger(logger),
+	m_callback(std::move(callback))
+	{
+		if (m_server.Listen(Nz::NetProtocol_Any, port) != Nz::SocketState_Bound)
+			throw std::runtime_error("failed to listen on metrics port " + std::to_string(port) + ": " + Nz::ErrorToString(m_server.GetLastError()));
+
+		m_server.EnableBlocking(false);
+
+		bwLog(m_logger, LogLevel::Info, "serving metrics on port {0} (/metrics)", port);
+	}
+
+	void MetricsServer::Poll()
+	{
+		Nz::UInt64 now = Nz::GetElapsedMilliseconds();
+
+		for (;;)
+		{
+			auto socket = std::make_unique<Nz::TcpClient>();
+			if (!m_server.AcceptClient(socket.get()))
+				break;
+
+			// Scrapers only need one connection each, don't let anyone pile connections up
+			if (m_clients.size() >= MaxClientCount)
+				continue;
+
+			socket->EnableBlocking(false);
+
+			Client& client = m_clients.emplace_back();
+			client.acceptTime = now;
+			client.socket = std::move(socket);
+		}
+
+		for (auto it = m_clients.begin(); it != m_clients.end();)
+		{
+			bool isDone;
+			if (now - it->acceptTime > RequestTimeout)
+				isDone = true;
+			else
+				isDone = HandleRequest(*it);
+
+			if (isDone)
+				it = m_clients.erase(it);
+			else
+				++it;
+		}
+	}
+
+	std::string MetricsServer::FormatMatchMetrics(const std::vector<Match::Metrics>& matchMetrics)
+	{
+		std::string output;
+
+		auto AppendMetric = [&](std::string_view name, std::string_view type, std::string_view help, auto&& appendSamples)
+		{
+			output += fmt::format("# HELP {0} {1}\n# TYPE {0} {2}\n", name, help, type);
+			for (const Match::Metrics& metrics : matchMetrics)
+			{
+				std::string matchLabel = "match=\"" + EscapeLabel(metrics.name) + "\"";
+				appendSamples(metrics, matchLabel);
+			}
+		};
+
+		auto AppendSample = [&](std::string_view name, std::string_view labels, auto value)
+		{
+			output += fmt::format("{0}{{{1}}} {2}\n", name, labels, value);
+		};
+
+		AppendMetric("burgwar_tick_duration_seconds", "histogram", "Time spent running ticks", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			const auto& bucketBounds = SharedMatch::TickDurationHistogram::BucketBounds;
+			const auto& tickCounts = metrics.tickDurations.tickCounts;
+
+			Nz::UInt64 tickCount = 0;
+			for (std::size_t i = 0; i < bucketBounds.size(); ++i)
+			{
+				tickCount += tickCounts[i];
+				AppendSample("burgwar_tick_duration_seconds_bucket", fmt::format("{0},le=\"{1}\"", matchLabel, bucketBounds[i] / 1'000'000.0), tickCount);
+			}
+
+			tickCount += tickCounts.back();
+			AppendSample("burgwar_tick_duration_seconds_bucket", matchLabel + ",le=\"+Inf\"", tickCount);
+			AppendSample("burgwar_tick_duration_seconds_sum", matchLabel, metrics.tickDurations.totalDuration / 1'000'000.0);
+			AppendSample("burgwar_tick_duration_seconds_count", matchLabel, tickCount);
+		});
+
+		AppendMetric("burgwar_ticks_total", "counter", "Ticks run since match start", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			AppendSample("burgwar_ticks_total", matchLabel, metrics.tickCount);
+		});
+
+		AppendMetric("burgwar_ticks_discarded_total", "counter", "Ticks skipped because updates were too slow to keep up", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			AppendSample("burgwar_ticks_discarded_total", matchLabel, metrics.discardedTickCount);
+		});
+
+		AppendMetric("burgwar_players", "gauge", "Connected players", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			AppendSample("burgwar_players", matchLabel, metrics.playerCount);
+		});
+
+		AppendMetric("burgwar_layer_entities", "gauge", "Entities alive in each layer", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			for (std::size_t i = 0; i < metrics.layerEntityCounts.size(); ++i)
+				AppendSample("burgwar_layer_entities", fmt::format("{0},layer=\"{1}\"", matchLabel, i), metrics.layerEntityCounts[i]);
+		});
+
+		AppendMetric("burgwar_download_queue_length", "gauge", "Client files queued or being sent to sessions", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			AppendSample("burgwar_download_queue_length", matchLabel, metrics.pendingDownloadCount);
+		});
+
+		AppendMetric("burgwar_packets_total", "counter", "Packets sent or received by packet type", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			for (const auto& packet : metrics.packets)
+				AppendSample("burgwar_packets_total", fmt::format("{0},direction=\"{1}\",type=\"{2}\"", matchLabel, (packet.outgoing) ? "out" : "in", EscapeLabel(packet.name)), packet.packetCount);
+		});
+
+		AppendMetric("burgwar_packet_bytes_total", "counter", "Bytes sent or received by packet type (without protocol overhead)", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			for (const auto& packet : metrics.packets)
+				AppendSample("burgwar_packet_bytes_total", fmt::format("{0},direction=\"{1}\",type=\"{2}\"", matchLabel, (packet.outgoing) ? "out" : "in", EscapeLabel(packet.name)), packet.byteCount);
+		});
+
+		AppendMetric("burgwar_session_rtt_seconds", "gauge", "Round-trip time of each session", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			for (const auto& session : metrics.sessions)
+				AppendSample("burgwar_session_rtt_seconds", fmt::format("{0},session=\"{1}\"", matchLabel, session.sessionId), session.info.ping / 1000.0);
+		});
+
+		AppendMetric("burgwar_session_inputs_total", "counter", "Input packets received from each session, by arrival time compared to the tick they were meant for", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			for (const auto& session : metrics.sessions)
+			{
+				AppendSample("burgwar_session_inputs_total", fmt::format("{0},session=\"{1}\",timing=\"early\"", matchLabel, session.sessionId), session.inputTiming.earlyCount);
+				AppendSample("burgwar_session_inputs_total", fmt::format("{0},session=\"{1}\",timing=\"late\"", matchLabel, session.sessionId), session.inputTiming.lateCount);
+				AppendSample("burgwar_session_inputs_total", fmt::format("{0},session=\"{1}\",timing=\"on_time\"", matchLabel, session.sessionId), session.inputTiming.onTimeCount);
+			}
+		});
+
+		AppendMetric("burgwar_session_packets_lost_total", "counter", "Packets lost by each session", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			for (const auto& session : metrics.sessions)
+				AppendSample("burgwar_session_packets_lost_total", fmt::format("{0},session=\"{1}\"", matchLabel, session.sessionId), session.info.totalPacketLost);
+		});
+
+		AppendMetric("burgwar_session_packets_sent_total", "counter", "Packets sent to each session (including resends)", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			for (const auto& session : metrics.sessions)
+				AppendSample("burgwar_session_packets_sent_total", fmt::format("{0},session=\"{1}\"", matchLabel, session.sessionId), session.info.totalPacketSent);
+		});
+
+		AppendMetric("burgwar_session_bytes_total", "counter", "Bytes exchanged with each session (including protocol overhead)", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			for (const auto& session : metrics.sessions)
+			{
+				AppendSample("burgwar_session_bytes_total", fmt::format("{0},session=\"{1}\",direction=\"in\"", matchLabel, session.sessionId), session.info.totalByteReceived);
+				AppendSample("burgwar_session_bytes_total", fmt::format("{0},session=\"{1}\",direction=\"out\"", matchLabel, session.sessionId), session.info.totalByteSent);
+			}
+		});
+
+		AppendMetric("burgwar_memory_bytes", "gauge", "Estimated memory used by each match subsystem", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			const Match::MemoryUsage& memoryUsage = metrics.memoryUsage;
+			AppendSample("burgwar_memory_bytes", matchLabel + ",subsystem=\"client_assets\"", memoryUsage.clientAssets);
+			AppendSample("burgwar_memory_bytes", matchLabel + ",subsystem=\"scripts\"", memoryUsage.scripts);
+			AppendSample("burgwar_memory_bytes", matchLabel + ",subsystem=\"sessions\"", memoryUsage.sessions);
+			AppendSample("burgwar_memory_bytes", matchLabel + ",subsystem=\"visibility\"", memoryUsage.visibility);
+		});
+
+		AppendMetric("burgwar_entity_components", "gauge", "Components attached to entities over all layers", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			AppendSample("burgwar_entity_components", matchLabel, metrics.memoryUsage.entityComponents);
+		});
+
+		AppendMetric("burgwar_script_memory_bytes", "gauge", "Memory allocated by Lua", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			AppendSample("burgwar_script_memory_bytes", matchLabel, metrics.scriptMemoryUsage);
+		});
+
+		AppendMetric("burgwar_script_gc_cycles_total", "counter", "Lua garbage collection cycles completed (stepped mode only)", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			AppendSample("burgwar_script_gc_cycles_total", matchLabel, metrics.scriptGarbageCollector.cycleCount);
+		});
+
+		AppendMetric("burgwar_script_gc_steps_total", "counter", "Lua garbage collection steps", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			AppendSample("burgwar_script_gc_steps_total", matchLabel, metrics.scriptGarbageCollector.stepCount);
+		});
+
+		AppendMetric("burgwar_script_gc_step_seconds_total", "counter", "Time spent in Lua garbage collection steps", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			AppendSample("burgwar_script_gc_step_seconds_total", matchLabel, metrics.scriptGarbageCollector.totalStepDuration / 1'000'000.0);
+		});
+
+		AppendMetric("burgwar_script_gc_step_max_seconds", "gauge", "Longest Lua garbage collection step", [&](const Match::Metrics& metrics, const std::string& matchLabel)
+		{
+			AppendSample("burgwar_script_gc_step_max_seconds", matchLabel, metrics.scriptGarbageCollector.maxStepDuration / 1'000'000.0);
+		});
+
+		return output;
+	}
+
+	bool MetricsServer::HandleRequest(Client& client)
+	{
+		std::array<char, 1024> buffer;
+		for (;;)
+		{
+			std::size_t received;
+			if (!client.socket->Receive(buffer.data(), buffer.size(), &received))
+			{
+				// Receive also fails when there's nothing to read on a non-blocking socket
+				if (client.socket->GetState() != Nz::SocketState_Connected)
+					return true;
+
+				break;
+			}
+
+			if (received == 0)
+				break;
+
+			client.request.append(buffer.data(), received);
+			if (client.request.size() > MaxRequestSize)
+				return true;
+		}
+
+		// Only the request line matters, wait for the whole header anyway so the client is ready to read the answer
+		if (client.request.find("\r\n\r\n") == std::string::npos)
+			return false;
+
+		std::string response;
+		if (client.request.compare(0, 13, "GET /metrics ") == 0 || client.request.compare(0, 13, "GET /metrics?") == 0)
+			response = BuildResponse("200 OK", "text/plain; version=0.0.4", m_callback());
+		else
+			response = BuildResponse("404 Not Found", "text/plain", "not found\n");
+
+		// Responses are small enough to be sent at once
+		client.socket->EnableBlocking(true);
+
+		std::size_t sent;
+		if (!client.socket->Send(response.data(), response.size(), &sent))
+			bwLog(m_logger, LogLevel::Warning, "failed to send metrics: {0}", Nz::ErrorToString(client.socket->GetLastError()));
+
+		return true;
+	}
+}
@@ -0,0 +1,63 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_SERVER_METRICSSERVER_HPP
+#define BURGWAR_SERVER_METRICSSERVER_HPP
+
+#include <CoreLib/Match.hpp>
+#include <Nazara/Network/TcpClient.hpp>
+#include <Nazara/Network/TcpServer.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	class Logger;
+
+	// Minimal HTTP server answering GET /metrics with metrics in Prometheus text format, polled from the application loop
+	class MetricsServer
+	{
+		public:
+			using MetricsCallback = std::function<std::string()>;
+
+			MetricsServer(const Logger& logger, Nz::UInt16 port, MetricsCallback callback);
+			MetricsServer(const MetricsServer&) = delete;
+			MetricsServer(MetricsServer&&) = delete;
+			~MetricsServer() = default;
+
+			void Poll();
+
+			MetricsServer& operator=(const MetricsServer&) = delete;
+			MetricsServer& operator=(MetricsServer&&) = delete;
+
+			static std::string FormatMatchMetrics(const std::vector<Match::Metrics>& matchMetrics);
+
+			static constexpr std::size_t MaxClientCount = 16;
+			static constexpr std::size_t MaxRequestSize = 8 * 1024;
+			static constexpr Nz::UInt64 RequestTimeout = 5'000; //< milliseconds
+
+		private:
+			struct Client
+			{
+				std::string request;
+				std::unique_ptr<Nz::TcpClient> socket;
+				Nz::UInt64 acceptTime;
+			};
+
+			bool HandleRequest(Client& client);
+
+			const Logger& m_logger;
+			std::vector<Client> m_clients;
+			MetricsCallback m_callback;
+			Nz::TcpServer m_server;
+	};
+}
+
+#include <Server/MetricsServer.inl>
+
+#endif
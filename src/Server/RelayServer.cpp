@@ -0,0 +1,189 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Server/RelayServer.hpp>
+#include <CoreLib/Config.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <Server/RelaySpectator.hpp>
+#include <stdexcept>
+
+namespace bw
+{
+	RelayServer::RelayServer(Logger& logger, Settings settings) :
+	m_logger(logger),
+	m_spectatorOutgoingCommandStore(logger),
+	m_matchState(logger),
+	m_spectatorCommandStore(logger),
+	m_upstreamCommandStore(logger),
+	m_spectatorReactor(0, Nz::NetProtocol_Any, settings.port, settings.maxSpectatorCount),
+	m_upstreamReactor(0, settings.upstreamAddress.GetProtocol(), 0, 1),
+	m_settings(std::move(settings)),
+	m_currentUpstreamPacket(nullptr),
+	m_upstreamPeerId(NetworkReactor::InvalidPeerId),
+	m_upstreamProtocolFeatures(LegacyProtocolFeatures & SupportedProtocolFeatures),
+	m_isRunning(true)
+	{
+		if (!ConnectUpstream(m_settings.upstreamAddress))
+			throw std::runtime_error("failed to connect to " + m_settings.upstreamAddress.ToString().ToStdString());
+
+		bwLog(m_logger, LogLevel::Info, "relaying to up to {0} spectator(s) on port {1} with a {2:.1f}s delay", m_settings.maxSpectatorCount, m_settings.port, m_settings.delay);
+	}
+
+	RelayServer::~RelayServer() = default;
+
+	Nz::UInt16 RelayServer::GetCurrentTick() const
+	{
+		return m_matchState.EstimateCurrentTick(Nz::GetElapsedMicroseconds());
+	}
+
+	void RelayServer::HandleUpstreamPacket(Packets::AuthFailure&& /*packet*/)
+	{
+		bwLog(m_logger, LogLevel::Error, "game server refused the relay (relays disabled or wrong password)");
+		m_isRunning = false;
+	}
+
+	void RelayServer::HandleUpstreamPacket(Packets::AuthSuccess&& packet)
+	{
+		bwLog(m_logger, LogLevel::Info, "authenticated as a relay");
+
+		m_upstreamProtocolFeatures = packet.protocolFeatures;
+	}
+
+	void RelayServer::HandleUpstreamPacket(Packets::MatchData&& packet)
+	{
+		if (packet.fastDownloadUrls.empty() && (!packet.assets.empty() || !packet.scripts.empty()))
+			bwLog(m_logger, LogLevel::Warning, "game server has no FastDownloadURLs, spectators missing match files won't be able to join");
+
+		// Start receiving the match right away, spectators will only see it once it has been delayed
+		SendUpstreamPacket(Packets::Ready{});
+
+		DelayPacket(std::move(packet), SpectatorTarget::None);
+	}
+
+	void RelayServer::HandleUpstreamPacket(Packets::NetworkStrings&& packet)
+	{
+		DelayPacket(std::move(packet), SpectatorTarget::Authenticated);
+	}
+
+	bool RelayServer::Update()
+	{
+		m_upstreamReactor.Poll([&](bool /*outgoing*/, std::size_t /*peerId*/, Nz::UInt32 /*data*/) { HandleUpstreamConnection(); },
+		                       [&](std::size_t /*peerId*/, Nz::UInt32 data) { HandleUpstreamDisconnection(data); },
+		                       [&](std::size_t /*peerId*/, Nz::NetPacket&& packet) { HandleUpstreamData(std::move(packet)); });
+
+		if (m_pendingRedirectPort)
+		{
+			Nz::IpAddress redirectAddress = m_settings.upstreamAddress;
+			redirectAddress.SetPort(*m_pendingRedirectPort);
+			m_pendingRedirectPort.reset();
+
+			if (!ConnectUpstream(redirectAddress))
+				m_isRunning = false;
+		}
+
+		m_spectatorReactor.Poll([&](bool /*outgoing*/, std::size_t peerId, Nz::UInt32 /*data*/) { HandleSpectatorConnection(peerId); },
+		                        [&](std::size_t peerId, Nz::UInt32 /*data*/) { HandleSpectatorDisconnection(peerId); },
+		                        [&](std::size_t peerId, Nz::NetPacket&& packet) { HandleSpectatorData(peerId, std::move(packet)); });
+
+		ReleasePackets(Nz::GetElapsedMicroseconds());
+
+		return m_isRunning;
+	}
+
+	bool RelayServer::ConnectUpstream(const Nz::IpAddress& address)
+	{
+		bwLog(m_logger, LogLevel::Info, "connecting to {0}...", address.ToString().ToStdString());
+
+		m_upstreamPeerId = m_upstreamReactor.ConnectTo(address);
+		if (m_upstreamPeerId == NetworkReactor::InvalidPeerId)
+		{
+			bwLog(m_logger, LogLevel::Error, "failed to connect to {0}", address.ToString().ToStdString());
+			return false;
+		}
+
+		return true;
+	}
+
+	void RelayServer::HandleSpectatorConnection(std::size_t peerId)
+	{
+		bwLog(m_logger, LogLevel::Info, "spectator #{0} connected", peerId);
+
+		if (peerId >= m_spectators.size())
+			m_spectators.resize(peerId + 1);
+
+		m_spectators[peerId] = std::make_unique<RelaySpectator>(*this, peerId);
+	}
+
+	void RelayServer::HandleSpectatorData(std::size_t peerId, Nz::NetPacket&& packet)
+	{
+		assert(peerId < m_spectators.size() && m_spectators[peerId]);
+		m_spectatorCommandStore.UnserializePacket(*m_spectators[peerId], packet);
+	}
+
+	void RelayServer::HandleSpectatorDisconnection(std::size_t peerId)
+	{
+		bwLog(m_logger, LogLevel::Info, "spectator #{0} disconnected", peerId);
+
+		assert(peerId < m_spectators.size());
+		m_spectators[peerId].reset();
+	}
+
+	void RelayServer::HandleUpstreamConnection()
+	{
+		bwLog(m_logger, LogLevel::Info, "connected to game server, authenticating...");
+
+		Packets::Auth authPacket;
+		authPacket.relayPassword = m_settings.password;
+
+		SendUpstreamPacket(authPacket);
+	}
+
+	void RelayServer::HandleUpstreamData(Nz::NetPacket&& packet)
+	{
+		m_currentUpstreamPacket = &packet;
+		if (!m_upstreamCommandStore.UnserializePacket(*this, packet))
+			bwLog(m_logger, LogLevel::Error, "failed to handle game server packet");
+
+		m_currentUpstreamPacket = nullptr;
+	}
+
+	void RelayServer::HandleUpstreamDisconnection(Nz::UInt32 data)
+	{
+		m_upstreamPeerId = NetworkReactor::InvalidPeerId;
+
+		// Game server may ask us to connect to another of its network threads
+		if (data & NetworkRedirectFlag)
+		{
+			m_pendingRedirectPort = Nz::UInt16(m_settings.upstreamAddress.GetPort() + (data & ~NetworkRedirectFlag));
+			return;
+		}
+
+		bwLog(m_logger, LogLevel::Error, "disconnected from game server (data: {0})", data);
+		m_isRunning = false;
+	}
+
+	void RelayServer::ReleasePackets(Nz::UInt64 now)
+	{
+		while (!m_delayedPackets.empty() && m_delayedPackets.front().releaseTime <= now)
+		{
+			DelayedPacket delayedPacket = std::move(m_delayedPackets.front());
+			m_delayedPackets.pop_front();
+
+			m_matchState.HandlePacket(std::move(delayedPacket.packet), now);
+
+			if (!delayedPacket.sharedPacket)
+				continue;
+
+			for (const auto& spectatorPtr : m_spectators)
+			{
+				if (!spectatorPtr)
+					continue;
+
+				bool isTarget = (delayedPacket.target == SpectatorTarget::Streaming) ? spectatorPtr->IsStreaming() : spectatorPtr->IsAuthenticated();
+				if (isTarget)
+					spectatorPtr->SendSharedPacket(delayedPacket.sharedPacket);
+			}
+		}
+	}
+}
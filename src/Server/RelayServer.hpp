@@ -0,0 +1,115 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_RELAYSERVER_HPP
+#define BURGWAR_RELAYSERVER_HPP
+
+#include <CoreLib/NetworkReactor.hpp>
+#include <CoreLib/PlayerCommandStore.hpp>
+#include <CoreLib/SharedPacket.hpp>
+#include <CoreLib/MatchStateMirror.hpp>
+#include <Server/RelaySpectatorCommandStore.hpp>
+#include <Server/RelayUpstreamCommandStore.hpp>
+#include <Nazara/Network/IpAddress.hpp>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace bw
+{
+	class Logger;
+	class RelaySpectator;
+
+	// Connects to a game server as a single session seeing every layer and serves what it receives to many spectators, optionally delayed
+	class RelayServer
+	{
+		public:
+			struct Settings;
+
+			RelayServer(Logger& logger, Settings settings);
+			RelayServer(const RelayServer&) = delete;
+			RelayServer(RelayServer&&) = delete;
+			~RelayServer();
+
+			Nz::UInt16 GetCurrentTick() const;
+			inline Logger& GetLogger();
+			inline const MatchStateMirror& GetMatchState() const;
+			inline const PlayerCommandStore& GetSpectatorOutgoingCommandStore() const;
+			inline NetworkReactor& GetSpectatorReactor();
+			inline ProtocolFeatureFlags GetUpstreamProtocolFeatures() const;
+
+			void HandleUpstreamPacket(Packets::AuthFailure&& packet);
+			void HandleUpstreamPacket(Packets::AuthSuccess&& packet);
+			void HandleUpstreamPacket(Packets::MatchData&& packet);
+			void HandleUpstreamPacket(Packets::NetworkStrings&& packet);
+			template<typename T> void HandleUpstreamPacket(T&& packet);
+
+			inline bool IsReady() const;
+
+			bool Update();
+
+			RelayServer& operator=(const RelayServer&) = delete;
+			RelayServer& operator=(RelayServer&&) = delete;
+
+			struct Settings
+			{
+				Nz::IpAddress upstreamAddress;
+				std::size_t maxSpectatorCount;
+				std::string password; //< has to match the game server ServerSettings.RelayPassword
+				float delay; //< seconds
+				Nz::UInt16 port;
+			};
+
+		private:
+			enum class SpectatorTarget
+			{
+				None,          //< handshake packets, only used by the relay
+				Authenticated, //< also sent to spectators still downloading the match files
+				Streaming
+			};
+
+			struct DelayedPacket
+			{
+				MatchStateMirror::Packet packet;
+				SharedPacketRef sharedPacket;
+				Nz::UInt64 releaseTime;
+				SpectatorTarget target;
+			};
+
+			template<typename T> void DelayPacket(T&& packet, SpectatorTarget target);
+			bool ConnectUpstream(const Nz::IpAddress& address);
+			void HandleSpectatorConnection(std::size_t peerId);
+			void HandleSpectatorData(std::size_t peerId, Nz::NetPacket&& packet);
+			void HandleSpectatorDisconnection(std::size_t peerId);
+			void HandleUpstreamConnection();
+			void HandleUpstreamData(Nz::NetPacket&& packet);
+			void HandleUpstreamDisconnection(Nz::UInt32 data);
+			void ReleasePackets(Nz::UInt64 now);
+			template<typename T> void SendUpstreamPacket(const T& packet);
+
+			std::deque<DelayedPacket> m_delayedPackets;
+			std::vector<std::unique_ptr<RelaySpectator>> m_spectators; //< indexed by peer id
+			Logger& m_logger;
+			PlayerCommandStore m_spectatorOutgoingCommandStore;
+			MatchStateMirror m_matchState;
+			RelaySpectatorCommandStore m_spectatorCommandStore;
+			RelayUpstreamCommandStore m_upstreamCommandStore;
+			NetworkReactor m_spectatorReactor;
+			NetworkReactor m_upstreamReactor;
+			Settings m_settings;
+			std::optional<Nz::UInt16> m_pendingRedirectPort;
+			const Nz::NetPacket* m_currentUpstreamPacket; //< packet being unserialized, forwarded as is to spectators
+			std::size_t m_upstreamPeerId;
+			ProtocolFeatureFlags m_upstreamProtocolFeatures;
+			bool m_isRunning;
+	};
+}
+
+#include <Server/RelayServer.inl>
+
+#endif
@@ -0,0 +1,90 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Server/RelayServer.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <cassert>
+#include <type_traits>
+
+namespace bw
+{
+	inline Logger& RelayServer::GetLogger()
+	{
+		return m_logger;
+	}
+
+	inline const MatchStateMirror& RelayServer::GetMatchState() const
+	{
+		return m_matchState;
+	}
+
+	inline const PlayerCommandStore& RelayServer::GetSpectatorOutgoingCommandStore() const
+	{
+		return m_spectatorOutgoingCommandStore;
+	}
+
+	inline NetworkReactor& RelayServer::GetSpectatorReactor()
+	{
+		return m_spectatorReactor;
+	}
+
+	inline ProtocolFeatureFlags RelayServer::GetUpstreamProtocolFeatures() const
+	{
+		return m_upstreamProtocolFeatures;
+	}
+
+	template<typename T>
+	void RelayServer::HandleUpstreamPacket(T&& packet)
+	{
+		// Every other packet is part of the match stream
+		DelayPacket(std::forward<T>(packet), SpectatorTarget::Streaming);
+	}
+
+	inline bool RelayServer::IsReady() const
+	{
+		return m_matchState.HasMatchData();
+	}
+
+	template<typename T>
+	void RelayServer::DelayPacket(T&& packet, SpectatorTarget target)
+	{
+		using Packet = std::decay_t<T>;
+
+		DelayedPacket& delayedPacket = m_delayedPackets.emplace_back();
+		delayedPacket.releaseTime = Nz::GetElapsedMicroseconds() + static_cast<Nz::UInt64>(m_settings.delay * 1'000'000.f);
+		delayedPacket.target = target;
+
+		if constexpr (std::is_constructible_v<MatchStateMirror::Packet, Packet>)
+			delayedPacket.packet = std::forward<T>(packet);
+
+		if (target != SpectatorTarget::None)
+		{
+			// Spectators get the exact bytes the game server sent, serialized and compressed only once
+			assert(m_currentUpstreamPacket);
+			const Nz::NetPacket& upstreamPacket = *m_currentUpstreamPacket;
+			const Nz::UInt8* data = static_cast<const Nz::UInt8*>(upstreamPacket.GetConstData()) + Nz::NetPacket::HeaderSize;
+
+			const auto& command = m_spectatorOutgoingCommandStore.GetOutgoingCommand<Packet>();
+
+			auto sharedPacket = std::make_shared<SharedPacket>();
+			sharedPacket->channelId = command.channelId;
+			sharedPacket->data = Nz::NetPacket(upstreamPacket.GetNetCode(), data, upstreamPacket.GetDataSize());
+			sharedPacket->flags = command.flags;
+			sharedPacket->packetId = static_cast<std::size_t>(Packet::Type);
+
+			delayedPacket.sharedPacket = std::move(sharedPacket);
+		}
+	}
+
+	template<typename T>
+	void RelayServer::SendUpstreamPacket(const T& packet)
+	{
+		const auto& command = m_upstreamCommandStore.GetOutgoingCommand<T>();
+
+		Nz::NetPacket data;
+		m_upstreamCommandStore.SerializePacket(data, packet, command.compress && m_upstreamProtocolFeatures.Test(ProtocolFeature::Compression));
+
+		m_upstreamReactor.SendData(m_upstreamPeerId, command.channelId, command.flags, std::move(data));
+	}
+}
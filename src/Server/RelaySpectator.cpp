@@ -0,0 +1,147 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Server/RelaySpectator.hpp>
+#include <CoreLib/MatchClientSession.hpp>
+#include <CoreLib/LogSystem/Logger.hpp>
+#include <CoreLib/MatchStateMirror.hpp>
+#include <Server/RelayServer.hpp>
+
+namespace bw
+{
+	RelaySpectator::RelaySpectator(RelayServer& relay, std::size_t peerId) :
+	m_relay(relay),
+	m_peerId(peerId),
+	m_isAuthenticated(false),
+	m_isStreaming(false)
+	{
+	}
+
+	void RelaySpectator::SendSharedPacket(SharedPacketRef packet)
+	{
+		m_relay.GetSpectatorReactor().SendSharedData(m_peerId, std::move(packet));
+	}
+
+	void RelaySpectator::HandleIncomingPacket(const Packets::Auth& packet)
+	{
+		if (m_isAuthenticated)
+			return;
+
+		// Spectators can't join before the relay itself got the match data (or while it's still delaying it)
+		if (!m_relay.IsReady())
+		{
+			SendPacket(Packets::AuthFailure{});
+			m_relay.GetSpectatorReactor().DisconnectPeer(m_peerId, 0, DisconnectionType::Later);
+			return;
+		}
+
+		// Match packets are forwarded as the game server encoded them, spectators have to understand everything the relay negotiated
+		ProtocolFeatureFlags upstreamFeatures = m_relay.GetUpstreamProtocolFeatures();
+		if ((packet.protocolFeatures & upstreamFeatures) != upstreamFeatures)
+		{
+			bwLog(m_relay.GetLogger(), LogLevel::Warning, "spectator #{0} doesn't support the protocol features of the game server", m_peerId);
+
+			SendPacket(Packets::AuthFailure{});
+			m_relay.GetSpectatorReactor().DisconnectPeer(m_peerId, 0, DisconnectionType::Later);
+			return;
+		}
+
+		m_isAuthenticated = true;
+
+		const MatchStateMirror& matchState = m_relay.GetMatchState();
+
+		// Spectators don't get any player, whatever they asked for
+		Packets::AuthSuccess authSuccess;
+		authSuccess.protocolFeatures = upstreamFeatures;
+
+		SendPacket(authSuccess);
+
+		Packets::NetworkStrings networkStrings;
+		networkStrings.startId = 0;
+		networkStrings.strings = matchState.GetNetworkStrings();
+		SendPacket(networkStrings);
+
+		Packets::MatchData matchData = matchState.GetMatchData();
+		matchData.currentTick = m_relay.GetCurrentTick();
+		SendPacket(matchData);
+	}
+
+	void RelaySpectator::HandleIncomingPacket(const Packets::DownloadClientFileAck& /*packet*/)
+	{
+	}
+
+	void RelaySpectator::HandleIncomingPacket(const Packets::DownloadClientFileRequest& packet)
+	{
+		// Relays don't have the match files, clients should get them from FastDownloadURLs
+		bwLog(m_relay.GetLogger(), LogLevel::Warning, "spectator #{0} requested {1}, relays can't serve files", m_peerId, packet.path);
+
+		Packets::DownloadClientFileResponse response;
+		response.content = Packets::DownloadClientFileResponse::Failure{ Packets::DownloadClientFileResponse::Error::FileNotFound };
+		SendPacket(response);
+	}
+
+	void RelaySpectator::HandleIncomingPacket(const Packets::PlayerChat& /*packet*/)
+	{
+	}
+
+	void RelaySpectator::HandleIncomingPacket(const Packets::PlayerConsoleCommand& /*packet*/)
+	{
+	}
+
+	void RelaySpectator::HandleIncomingPacket(const Packets::PlayersInput& packet)
+	{
+		if (!m_isStreaming)
+			return;
+
+		// Spectators have no input to send, but they still synchronize their clock with this
+		Nz::UInt16 adjustedTick = m_relay.GetCurrentTick() + MatchClientSession::InputTimingTolerance;
+
+		Packets::InputTimingCorrection correctionPacket;
+		correctionPacket.serverTick = packet.estimatedServerTick;
+		correctionPacket.tickError = static_cast<Nz::Int16>(Nz::UInt16(packet.estimatedServerTick - adjustedTick));
+
+		SendPacket(correctionPacket);
+	}
+
+	void RelaySpectator::HandleIncomingPacket(const Packets::PlayerSelectWeapon& /*packet*/)
+	{
+	}
+
+	void RelaySpectator::HandleIncomingPacket(const Packets::Ready& /*packet*/)
+	{
+		if (!m_isAuthenticated || m_isStreaming)
+			return;
+
+		MatchStateMirror::CatchUpPackets catchUpPackets;
+		m_relay.GetMatchState().BuildCatchUpPackets(catchUpPackets);
+
+		for (const auto& playerJoined : catchUpPackets.players)
+			SendPacket(playerJoined);
+
+		for (const auto& enableLayer : catchUpPackets.enabledLayers)
+			SendPacket(enableLayer);
+
+		if (!catchUpPackets.recycledEntities.entities.empty())
+			SendPacket(catchUpPackets.recycledEntities);
+
+		if (!catchUpPackets.entitiesPhysics.entities.empty())
+			SendPacket(catchUpPackets.entitiesPhysics);
+
+		if (!catchUpPackets.entitiesWeapon.entities.empty())
+			SendPacket(catchUpPackets.entitiesWeapon);
+
+		for (const auto& playerControlEntity : catchUpPackets.playerControlledEntities)
+			SendPacket(playerControlEntity);
+
+		m_isStreaming = true;
+	}
+
+	void RelaySpectator::HandleIncomingPacket(const Packets::ScriptPacket& /*packet*/)
+	{
+	}
+
+	void RelaySpectator::HandleIncomingPacket(const Packets::UpdatePlayerName& /*packet*/)
+	{
+	}
+}
@@ -0,0 +1,61 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_RELAYSPECTATOR_HPP
+#define BURGWAR_RELAYSPECTATOR_HPP
+
+#include <CoreLib/SharedPacket.hpp>
+#include <CoreLib/Protocol/Packets.hpp>
+#include <Server/RelaySpectatorCommandStore.hpp>
+
+namespace bw
+{
+	class RelayServer;
+
+	// Client connected to a relay, it sees every layer and controls nothing
+	class RelaySpectator
+	{
+		friend RelaySpectatorCommandStore;
+
+		public:
+			RelaySpectator(RelayServer& relay, std::size_t peerId);
+			RelaySpectator(const RelaySpectator&) = delete;
+			RelaySpectator(RelaySpectator&&) = delete;
+			~RelaySpectator() = default;
+
+			inline std::size_t GetPeerId() const;
+
+			inline bool IsAuthenticated() const;
+			inline bool IsStreaming() const;
+
+			template<typename T> void SendPacket(const T& packet);
+			void SendSharedPacket(SharedPacketRef packet);
+
+			RelaySpectator& operator=(const RelaySpectator&) = delete;
+			RelaySpectator& operator=(RelaySpectator&&) = delete;
+
+		private:
+			void HandleIncomingPacket(const Packets::Auth& packet);
+			void HandleIncomingPacket(const Packets::DownloadClientFileAck& packet);
+			void HandleIncomingPacket(const Packets::DownloadClientFileRequest& packet);
+			void HandleIncomingPacket(const Packets::PlayerChat& packet);
+			void HandleIncomingPacket(const Packets::PlayerConsoleCommand& packet);
+			void HandleIncomingPacket(const Packets::PlayersInput& packet);
+			void HandleIncomingPacket(const Packets::PlayerSelectWeapon& packet);
+			void HandleIncomingPacket(const Packets::Ready& packet);
+			void HandleIncomingPacket(const Packets::ScriptPacket& packet);
+			void HandleIncomingPacket(const Packets::UpdatePlayerName& packet);
+
+			RelayServer& m_relay;
+			std::size_t m_peerId;
+			bool m_isAuthenticated; //< received MatchData, receives network strings
+			bool m_isStreaming; //< received the current match state, receives every packet
+	};
+}
+
+#include <Server/RelaySpectator.inl>
+
+#endif
@@ -0,0 +1,36 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Server/RelaySpectator.hpp>
+#include <Server/RelayServer.hpp>
+
+namespace bw
+{
+	inline std::size_t RelaySpectator::GetPeerId() const
+	{
+		return m_peerId;
+	}
+
+	inline bool RelaySpectator::IsAuthenticated() const
+	{
+		return m_isAuthenticated;
+	}
+
+	inline bool RelaySpectator::IsStreaming() const
+	{
+		return m_isStreaming;
+	}
+
+	template<typename T>
+	void RelaySpectator::SendPacket(const T& packet)
+	{
+		const PlayerCommandStore& commandStore = m_relay.GetSpectatorOutgoingCommandStore();
+		const auto& command = commandStore.GetOutgoingCommand<T>();
+
+		Nz::NetPacket data;
+		commandStore.SerializePacket(data, packet, command.compress);
+
+		m_relay.GetSpectatorReactor().SendData(m_peerId, command.channelId, command.flags, std::move(data));
+	}
+}
@@ -0,0 +1,37 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Server/RelaySpectatorCommandStore.hpp>
+#include <CoreLib/Protocol/PacketCompression.hpp>
+#include <CoreLib/Protocol/Packets.hpp>
+#include <Server/RelaySpectator.hpp>
+
+namespace bw
+{
+	RelaySpectatorCommandStore::RelaySpectatorCommandStore(const Logger& logger) :
+	CommandStore(logger)
+	{
+		// Peers are untrusted clients, don't let them claim multi-megabyte payloads
+		SetMaxUncompressedSize(PacketMaxServerBoundUncompressedSize);
+
+#define IncomingCommand(Type) RegisterIncomingCommand<Packets::Type>(#Type, [](RelaySpectator& spectator, Packets::Type&& packet) \
+{ \
+	spectator.HandleIncomingPacket(std::move(packet)); \
+})
+
+		// Incoming commands
+		IncomingCommand(Auth);
+		IncomingCommand(DownloadClientFileAck);
+		IncomingCommand(DownloadClientFileRequest);
+		IncomingCommand(PlayerChat);
+		IncomingCommand(PlayerConsoleCommand);
+		IncomingCommand(PlayersInput);
+		IncomingCommand(PlayerSelectWeapon);
+		IncomingCommand(Ready);
+		IncomingCommand(ScriptPacket);
+		IncomingCommand(UpdatePlayerName);
+
+#undef IncomingCommand
+	}
+}
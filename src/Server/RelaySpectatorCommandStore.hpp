@@ -0,0 +1,27 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_RELAYSPECTATORCOMMANDSTORE_HPP
+#define BURGWAR_RELAYSPECTATORCOMMANDSTORE_HPP
+
+#include <CoreLib/CommandStore.hpp>
+
+namespace bw
+{
+	class RelaySpectator;
+
+	// Packets sent by spectators to a relay, packets sent to them are described by PlayerCommandStore
+	class RelaySpectatorCommandStore : public CommandStore<RelaySpectator>
+	{
+		public:
+			RelaySpectatorCommandStore(const Logger& logger);
+			~RelaySpectatorCommandStore() = default;
+	};
+}
+
+#include <Server/RelaySpectatorCommandStore.inl>
+
+#endif
@@ -0,0 +1,56 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#include <Server/RelayUpstreamCommandStore.hpp>
+#include <CoreLib/Protocol/Packets.hpp>
+#include <Server/RelayServer.hpp>
+
+namespace bw
+{
+	RelayUpstreamCommandStore::RelayUpstreamCommandStore(const Logger& logger) :
+	CommandStore(logger)
+	{
+#define IncomingCommand(Type) RegisterIncomingCommand<Packets::Type>(#Type, [](RelayServer& relay, Packets::Type&& packet) \
+{ \
+	relay.HandleUpstreamPacket(std::move(packet)); \
+})
+#define OutgoingCommand(Type, Flags, Channel) RegisterOutgoingCommand<Packets::Type>(#Type, Flags, Channel)
+
+		// Incoming commands
+		IncomingCommand(AuthFailure);
+		IncomingCommand(AuthSuccess);
+		IncomingCommand(ChatMessage);
+		IncomingCommand(CreateEntities);
+		IncomingCommand(DeleteEntities);
+		IncomingCommand(DisableLayer);
+		IncomingCommand(EnableLayer);
+		IncomingCommand(EntitiesAnimation);
+		IncomingCommand(EntitiesDeath);
+		IncomingCommand(EntitiesInputs);
+		IncomingCommand(EntitiesPhysics);
+		IncomingCommand(EntitiesScale);
+		IncomingCommand(EntitiesWeapon);
+		IncomingCommand(HealthUpdate);
+		IncomingCommand(MapReset);
+		IncomingCommand(MatchData);
+		IncomingCommand(MatchState);
+		IncomingCommand(NetworkStrings);
+		IncomingCommand(PlayerControlEntity);
+		IncomingCommand(PlayerJoined);
+		IncomingCommand(PlayerLeaving);
+		IncomingCommand(PlayerNameUpdate);
+		IncomingCommand(PlayerPingUpdate);
+		IncomingCommand(RecycleEntities);
+		IncomingCommand(RespawnEntities);
+		IncomingCommand(ScriptPacket);
+		IncomingCommand(TickRateUpdate);
+
+		// Outgoing commands
+		OutgoingCommand(Auth,  Nz::ENetPacketFlag_Reliable, 0);
+		OutgoingCommand(Ready, Nz::ENetPacketFlag_Reliable, 0);
+
+#undef IncomingCommand
+#undef OutgoingCommand
+	}
+}
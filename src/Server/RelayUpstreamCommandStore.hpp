@@ -0,0 +1,27 @@
+// Copyright (C) 2020 Jérôme Leclercq
+// This file is part of the "Burgwar" project
+// For conditions of distribution and use, see copyright notice in LICENSE
+
+#pragma once
+
+#ifndef BURGWAR_RELAYUPSTREAMCOMMANDSTORE_HPP
+#define BURGWAR_RELAYUPSTREAMCOMMANDSTORE_HPP
+
+#include <CoreLib/CommandStore.hpp>
+
+namespace bw
+{
+	class RelayServer;
+
+	// Packets exchanged between a relay and the game server it relays
+	class RelayUpstreamCommandStore : public CommandStore<RelayServer>
+	{
+		public:
+			RelayUpstreamCommandStore(const Logger& logger);
+			~RelayUpstreamCommandStore() = default;
+	};
+}
+
+#include <Server/RelayUpstreamCommandStore.inl>
+
+#endif
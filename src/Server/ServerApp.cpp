@@ -3,39 +3,188 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <Server/ServerApp.hpp>
+#include <CoreLib/MatchReplay.hpp>
+#include <CoreLib/ReplaySessionManager.hpp>
+#include <CoreLib/Utils.hpp>
+#include <CoreLib/LogSystem/BinaryLogSink.hpp>
+#include <Server/RelayServer.hpp>
+#include <Nazara/Core/Clock.hpp>
+#include <Nazara/Core/File.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <iterator>
+#include <mutex>
+#include <numeric>
 #include <thread>
 
 namespace bw
 {
+	namespace
+	{
+		// Since OS sleep is not that precise, let some time between the wakeup time and the tick
+		constexpr Nz::UInt64 wakeUpTime = 3'000;
+
+		constexpr Nz::UInt64 serviceInterval = 5'000; //< microseconds between two main thread updates (web requests, metrics, main thread jobs) when matches run on their own threads
+
+		constexpr std::size_t metricsInterval = 1'000; //< milliseconds between two match metrics snapshots (when the endpoint is enabled)
+
+		constexpr const char* configFile = "serverconfig.lua";
+	}
+
 	ServerApp::ServerApp(int argc, char* argv[]) :
 	Application(argc, argv),
 	BurgApp(LogSide::Server, m_configFile),
 	m_configFile(*this)
 	{
-		if (!m_configFile.LoadFromFile("serverconfig.lua"))
+		if (!m_configFile.LoadFromFile(configFile))
 			throw std::runtime_error("failed to load config file");
 
+		if (const std::string& binaryLogPath = m_configFile.GetStringValue("ServerSettings.BinaryLogPath"); !binaryLogPath.empty())
+		{
+			Nz::UInt64 maxFileSize = m_configFile.GetIntegerValue<Nz::UInt64>("ServerSettings.BinaryLogMaxFileSize") * 1024 * 1024;
+			std::size_t maxFileCount = m_configFile.GetIntegerValue<std::size_t>("ServerSettings.BinaryLogFileCount");
+
+			GetLogger().RegisterSink(std::make_shared<BinaryLogSink>(std::filesystem::u8path(binaryLogPath), maxFileSize, maxFileCount));
+		}
+
 		LoadMods();
+	}
 
-		Nz::UInt16 maxPlayerCount = m_configFile.GetIntegerValue<Nz::UInt16>("ServerSettings.MaxPlayerCount");
-		Nz::UInt16 serverPort = m_configFile.GetIntegerValue<Nz::UInt16>("ServerSettings.Port");
-		const std::string& gamemode = m_configFile.GetStringValue("ServerSettings.Gamemode");
-		const std::string& mapPath = m_configFile.GetStringValue("ServerSettings.MapPath");
-		const std::string& serverDesc = m_configFile.GetStringValue("ServerSettings.Description");
-		const std::string& serverName = m_configFile.GetStringValue("ServerSettings.Name");
-		float tickRate = m_configFile.GetFloatValue<float>("ServerSettings.TickRate");
-		bool sleepWhenEmpty = m_configFile.GetBoolValue("ServerSettings.SleepWhenEmpty");
+	std::unique_ptr<Match> ServerApp::CreateMatch(const ServerAppConfig& config, const MatchReplay* replay)
+	{
+		Nz::UInt16 interestCellSize = config.GetIntegerValue<Nz::UInt16>("ServerSettings.InterestCellSize");
+		Nz::UInt16 healthQuantizationStep = config.GetIntegerValue<Nz::UInt16>("ServerSettings.HealthQuantizationStep");
+		Nz::UInt32 interestRadius = config.GetIntegerValue<Nz::UInt32>("ServerSettings.InterestRadius");
+		Nz::UInt16 maxPlayerCount = config.GetIntegerValue<Nz::UInt16>("ServerSettings.MaxPlayerCount");
+		Nz::UInt32 networkStatisticsInterval = config.GetIntegerValue<Nz::UInt32>("ServerSettings.NetworkStatisticsInterval");
+		std::size_t networkThreadCount = config.GetIntegerValue<std::size_t>("ServerSettings.NetworkThreadCount");
+		std::size_t peerBandwidth = config.GetIntegerValue<std::size_t>("ServerSettings.PeerBandwidth");
+		std::size_t workerThreadCount = config.GetIntegerValue<std::size_t>("ServerSettings.WorkerThreadCount");
+		std::size_t movementKeyframeInterval = config.GetIntegerValue<std::size_t>("ServerSettings.MovementKeyframeInterval");
+		Nz::UInt16 serverPort = config.GetIntegerValue<Nz::UInt16>("ServerSettings.Port");
+		const std::string& checkpointPath = config.GetStringValue("ServerSettings.CheckpointPath");
+		const std::string& gamemode = config.GetStringValue("ServerSettings.Gamemode");
+		const std::string& mapPath = config.GetStringValue("ServerSettings.MapPath");
+		const std::string& relayPassword = config.GetStringValue("ServerSettings.RelayPassword");
+		const std::string& replayRecordPath = config.GetStringValue("ServerSettings.ReplayRecordPath");
+		const std::string& scriptGarbageCollector = config.GetStringValue("ServerSettings.ScriptGarbageCollector");
+		const std::string& serverDesc = config.GetStringValue("ServerSettings.Description");
+		const std::string& serverName = config.GetStringValue("ServerSettings.Name");
+		float checkpointInterval = config.GetFloatValue<float>("ServerSettings.CheckpointInterval");
+		float checkpointReconnectionDelay = config.GetFloatValue<float>("ServerSettings.CheckpointReconnectionDelay");
+		float fileWatchDelay = config.GetFloatValue<float>("ServerSettings.FileWatchDelay");
+		float lagCompensationDuration = config.GetFloatValue<float>("ServerSettings.LagCompensationDuration");
+		float layerHibernationDelay = config.GetFloatValue<float>("ServerSettings.LayerHibernationDelay");
+		float maxTickRate = config.GetFloatValue<float>("ServerSettings.MaxTickRate");
+		float minTickRate = config.GetFloatValue<float>("ServerSettings.MinTickRate");
+		float movementExtrapolationError = config.GetFloatValue<float>("ServerSettings.MovementExtrapolationError");
+		float movementSyncEpsilon = config.GetFloatValue<float>("ServerSettings.MovementSyncEpsilon");
+		float scriptCallbackBudget = config.GetFloatValue<float>("ServerSettings.ScriptCallbackBudget");
+		float scriptGarbageCollectorStepBudget = config.GetFloatValue<float>("ServerSettings.ScriptGarbageCollectorStepBudget");
+		float snapshotRate = config.GetFloatValue<float>("ServerSettings.SnapshotRate");
+		float tickRate = config.GetFloatValue<float>("ServerSettings.TickRate");
+		Nz::UInt16 metricsPort = m_configFile.GetIntegerValue<Nz::UInt16>("ServerSettings.MetricsPort");
+		bool adaptiveSnapshotRate = config.GetBoolValue("ServerSettings.AdaptiveSnapshotRate");
+		bool deferPacketSerialization = config.GetBoolValue("ServerSettings.DeferPacketSerialization");
+		bool fastTerrainReset = config.GetBoolValue("ServerSettings.FastTerrainReset");
+		bool lazyLayerActivation = config.GetBoolValue("ServerSettings.LazyLayerActivation");
+		bool loadShedding = config.GetBoolValue("ServerSettings.LoadShedding");
+		bool parallelLayerUpdate = config.GetBoolValue("ServerSettings.ParallelLayerUpdate");
+		bool sleepWhenEmpty = config.GetBoolValue("ServerSettings.SleepWhenEmpty");
+		bool quantizeMatchState = config.GetBoolValue("ServerSettings.QuantizeMatchState");
+		bool tickProfiling = config.GetBoolValue("ServerSettings.TickProfiling");
+		std::size_t tickProfileInterval = config.GetIntegerValue<std::size_t>("ServerSettings.TickProfileInterval");
 
 		Match::GamemodeSettings gamemodeSettings;
 		gamemodeSettings.name = gamemode;
 
 		Match::MatchSettings matchSettings;
+		matchSettings.adaptiveSnapshotRate = adaptiveSnapshotRate;
+		matchSettings.checkpointInterval = checkpointInterval;
+		matchSettings.checkpointPath = checkpointPath;
+		matchSettings.checkpointReconnectionDelay = checkpointReconnectionDelay;
+		matchSettings.deferPacketSerialization = deferPacketSerialization;
+		matchSettings.fastTerrainReset = fastTerrainReset;
+		matchSettings.fileWatchDelay = fileWatchDelay;
+		matchSettings.lagCompensationDuration = lagCompensationDuration;
+		matchSettings.layerHibernationDelay = layerHibernationDelay;
+		matchSettings.lazyLayerActivation = lazyLayerActivation;
+		matchSettings.loadShedding = loadShedding;
+		matchSettings.parallelLayerUpdate = parallelLayerUpdate;
 		matchSettings.sleepWhenEmpty = sleepWhenEmpty;
 		matchSettings.description = serverDesc;
 		matchSettings.maxPlayerCount = maxPlayerCount;
+		matchSettings.metricsInterval = (metricsPort > 0) ? metricsInterval : 0;
 		matchSettings.name = serverName;
+		matchSettings.networkStatisticsInterval = networkStatisticsInterval;
+		matchSettings.networkThreadCount = networkThreadCount;
+		matchSettings.peerBandwidth = peerBandwidth;
 		matchSettings.port = serverPort;
+		matchSettings.relayPassword = relayPassword;
+		matchSettings.replayRecordPath = replayRecordPath;
+		matchSettings.scriptCallbackBudget = scriptCallbackBudget;
+		matchSettings.scriptGarbageCollectorStepBudget = scriptGarbageCollectorStepBudget;
+		matchSettings.snapshotRate = snapshotRate;
 		matchSettings.tickDuration = 1.f / tickRate;
+		matchSettings.tickProfileInterval = tickProfileInterval;
+		matchSettings.tickProfiling = tickProfiling;
+		matchSettings.workerThreadCount = workerThreadCount;
+
+		if (interestRadius > 0)
+		{
+			auto& interestArea = matchSettings.interestArea.emplace();
+			interestArea.cellSize = interestCellSize;
+			interestArea.radius = float(interestRadius);
+		}
+
+		if (movementSyncEpsilon > 0.f)
+		{
+			auto& movementSync = matchSettings.movementSync.emplace();
+			movementSync.extrapolationPositionError = movementExtrapolationError;
+			movementSync.keyframeInterval = movementKeyframeInterval;
+			movementSync.positionEpsilon = movementSyncEpsilon;
+		}
+
+		if (maxTickRate > 0.f || minTickRate > 0.f)
+		{
+			auto& adaptiveTickRate = matchSettings.adaptiveTickRate.emplace();
+			adaptiveTickRate.maxTickRate = (maxTickRate > 0.f) ? maxTickRate : tickRate;
+			adaptiveTickRate.minTickRate = (minTickRate > 0.f) ? minTickRate : tickRate;
+
+			if (adaptiveTickRate.minTickRate > adaptiveTickRate.maxTickRate)
+				throw std::runtime_error("match " + serverName + " MinTickRate is greater than its MaxTickRate");
+		}
+
+		if (quantizeMatchState)
+		{
+			auto& stateQuantization = matchSettings.stateQuantization.emplace();
+			stateQuantization.healthStep = healthQuantizationStep;
+		}
+
+		if (scriptGarbageCollector == "generational")
+			matchSettings.scriptGarbageCollectorMode = ScriptingContext::GarbageCollectorMode::Generational;
+		else if (scriptGarbageCollector == "incremental")
+			matchSettings.scriptGarbageCollectorMode = ScriptingContext::GarbageCollectorMode::Incremental;
+		else
+			matchSettings.scriptGarbageCollectorMode = ScriptingContext::GarbageCollectorMode::IncrementalStepped;
+
+		// Replayed matches run offline, with the recorded timings
+		if (replay)
+		{
+			matchSettings.adaptiveTickRate.reset();
+			matchSettings.checkpointPath.clear();
+			matchSettings.fileWatchDelay = 0.f;
+			matchSettings.metricsInterval = 0;
+			matchSettings.port = 0;
+			matchSettings.randomSeed = replay->GetRandomSeed();
+			matchSettings.registerToMasterServer = false;
+			matchSettings.replayRecordPath.clear();
+			matchSettings.tickDuration = replay->GetTickDuration();
+		}
 
 		// Load map
 		if (!EndsWith(mapPath, ".bmap"))
@@ -54,41 +203,359 @@ namespace bw
 		for (auto&& [modId, mod] : GetMods())
 			modSettings.enabledMods[modId] = Match::ModSettings::ModEntry{};
 
-		m_match = std::make_unique<Match>(*this, std::move(matchSettings), std::move(gamemodeSettings), std::move(modSettings));
+		for (const MatchEntry& matchEntry : m_matches)
+		{
+			const Match::MatchSettings& otherSettings = matchEntry.match->GetSettings();
+			if (serverPort < otherSettings.port + otherSettings.networkThreadCount && otherSettings.port < serverPort + networkThreadCount)
+				throw std::runtime_error("match " + serverName + " ports overlap with match " + otherSettings.name + " ports");
+
+			if (!checkpointPath.empty() && checkpointPath == otherSettings.checkpointPath)
+				throw std::runtime_error("match " + serverName + " uses the same checkpoint file as match " + otherSettings.name);
+		}
+
+		return std::make_unique<Match>(*this, std::move(matchSettings), std::move(gamemodeSettings), std::move(modSettings));
 	}
 
 	int ServerApp::Run()
 	{
-		Nz::Clock updateClock;
-		Nz::UInt64 tickDuration = static_cast<Nz::UInt64>(m_match->GetTickDuration() * 1'000'000);
+		LoadMatches();
+		StartMetricsServer();
+
+		if (m_matches.size() == 1)
+			return RunSingleMatch();
+
+		std::size_t workerCount = m_configFile.GetIntegerValue<std::size_t>("ServerSettings.MatchThreadCount");
+		if (workerCount == 0)
+			workerCount = std::max(std::thread::hardware_concurrency(), 1U);
+
+		return RunMatches(std::min(workerCount, m_matches.size()));
+	}
+	
+	void ServerApp::Quit()
+	{
+		Application::Quit();
+	}
+
+	void ServerApp::LoadMatches()
+	{
+		auto AddMatch = [&](const ServerAppConfig& config)
+		{
+			std::unique_ptr<Match> match = CreateMatch(config);
+
+			MatchEntry& matchEntry = m_matches.emplace_back();
+			matchEntry.match = std::move(match);
+			matchEntry.lastUpdate = Nz::GetElapsedMicroseconds();
+			matchEntry.nextUpdate = matchEntry.lastUpdate;
+			matchEntry.tickDuration = static_cast<Nz::UInt64>(matchEntry.match->GetTickDuration() * 1'000'000);
+		};
+
+		AddMatch(m_configFile);
+
+		// Each additional match config is loaded on top of the main config file, and only has to override what differs (port, map, ...)
+		const std::string& additionalMatches = m_configFile.GetStringValue("ServerSettings.AdditionalMatches");
+		SplitStringAny(additionalMatches, "\f\n\r\t\v ", [&](const std::string_view& matchConfigFile)
+		{
+			if (matchConfigFile.empty())
+				return true;
+
+			ServerAppConfig matchConfig(*this);
+			if (!matchConfig.LoadFromFiles({ configFile, std::filesystem::u8path(matchConfigFile) }))
+				throw std::runtime_error("failed to load match config file " + std::string(matchConfigFile));
+
+			AddMatch(matchConfig);
+			return true;
+		});
+	}
+
+	int ServerApp::RunMatches(std::size_t workerCount)
+	{
+		std::condition_variable matchCondition;
+		std::mutex matchMutex;
+		bool stopWorkers = false;
+
+		// Workers always pick the idle match with the earliest tick deadline, so a slow match only delays itself
+		auto MatchWorker = [&]
+		{
+			std::unique_lock<std::mutex> lock(matchMutex);
+			while (!stopWorkers)
+			{
+				MatchEntry* nextMatch = nullptr;
+				for (MatchEntry& matchEntry : m_matches)
+				{
+					if (!matchEntry.isRunning || matchEntry.isUpdating)
+						continue;
+
+					if (!nextMatch || matchEntry.nextUpdate < nextMatch->nextUpdate)
+						nextMatch = &matchEntry;
+				}
+
+				if (!nextMatch)
+				{
+					matchCondition.wait(lock);
+					continue;
+				}
+
+				Nz::UInt64 now = Nz::GetElapsedMicroseconds();
+				if (nextMatch->nextUpdate > now + wakeUpTime)
+				{
+					matchCondition.wait_for(lock, std::chrono::microseconds(nextMatch->nextUpdate - now - wakeUpTime));
+					continue;
+				}
+
+				nextMatch->isUpdating = true;
+				lock.unlock();
+
+				float elapsedTime = (now - nextMatch->lastUpdate) / 1'000'000.f;
+				nextMatch->lastUpdate = now;
+
+				bool isRunning;
+				try
+				{
+					isRunning = nextMatch->match->Update(elapsedTime);
+				}
+				catch (const std::exception& e)
+				{
+					bwLog(nextMatch->match->GetLogger(), LogLevel::Error, "match update failed: {0}", e.what());
+					isRunning = false;
+				}
+
+				lock.lock();
+				nextMatch->isUpdating = false;
+				nextMatch->isRunning = isRunning;
+				nextMatch->tickDuration = static_cast<Nz::UInt64>(nextMatch->match->GetTickDuration() * 1'000'000); //< may change with adaptive tick rate
+				nextMatch->nextUpdate = now + nextMatch->tickDuration;
+
+				matchCondition.notify_one();
+			}
+		};
+
+		bwLog(GetLogger(), LogLevel::Info, "running {0} matches on {1} thread(s)", m_matches.size(), workerCount);
+
+		std::vector<std::thread> workers;
+		workers.reserve(workerCount);
+		for (std::size_t i = 0; i < workerCount; ++i)
+			workers.emplace_back(MatchWorker);
 
 		while (Application::Run())
 		{
 			BurgApp::Update();
 
-			if (!m_match->Update(GetUpdateTime()))
-				break;
+			if (m_metricsServer)
+				m_metricsServer->Poll();
 
-			Nz::UInt64 elapsedTime = updateClock.Restart();
-			if (tickDuration > elapsedTime)
 			{
-				// Since OS sleep is not that precise, let some time between the wakeup time and the tick
-				constexpr Nz::UInt64 wakeUpTime = 3'000;
+				std::unique_lock<std::mutex> lock(matchMutex);
+				if (std::none_of(m_matches.begin(), m_matches.end(), [](const MatchEntry& matchEntry) { return matchEntry.isRunning; }))
+					break;
+			}
+
+			std::this_thread::sleep_for(std::chrono::microseconds(serviceInterval));
+		}
 
-				Nz::UInt64 remainingTime = tickDuration - elapsedTime;
-				if (remainingTime > wakeUpTime)
+		{
+			std::unique_lock<std::mutex> lock(matchMutex);
+			stopWorkers = true;
+		}
+		matchCondition.notify_all();
+
+		for (std::thread& worker : workers)
+			worker.join();
+
+		return 0;
+	}
+
+	int ServerApp::RunRelay(const Nz::IpAddress& serverAddress)
+	{
+		RelayServer::Settings relaySettings;
+		relaySettings.delay = m_configFile.GetFloatValue<float>("RelaySettings.Delay");
+		relaySettings.maxSpectatorCount = m_configFile.GetIntegerValue<std::size_t>("RelaySettings.MaxSpectatorCount");
+		relaySettings.password = m_configFile.GetStringValue("RelaySettings.Password");
+		relaySettings.port = m_configFile.GetIntegerValue<Nz::UInt16>("ServerSettings.Port");
+		relaySettings.upstreamAddress = serverAddress;
+
+		RelayServer relay(GetLogger(), std::move(relaySettings));
+
+		// Relay has no tick of its own, it only moves packets around (and has to release delayed ones on time)
+		while (Application::Run())
+		{
+			BurgApp::Update();
+
+			if (!relay.Update())
+				return EXIT_FAILURE;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	int ServerApp::RunReplay(const std::string& replayFile, const std::string& reportFile)
+	{
+		MatchReplay replay(replayFile);
+
+		std::unique_ptr<Match> match = CreateMatch(m_configFile, &replay);
+		match->GetSessions().CreateSessionManager<ReplaySessionManager>(replay);
+
+		bwLog(GetLogger(), LogLevel::Info, "replaying {0} (tick duration: {1:.2f} ms, random seed: {2})", replayFile, replay.GetTickDuration() * 1000.f, replay.GetRandomSeed());
+
+		// Updates are run back to back with their recorded elapsed time, ticks run by the same update share its duration
+		std::vector<Nz::UInt64> tickDurations;
+		std::size_t updateCount = 0;
+		Nz::UInt64 totalTime = 0;
+
+		try
+		{
+			while (replay.PeekEvent())
+			{
+				float elapsedTime = replay.ReadUpdate();
+
+				Nz::UInt64 firstTick = match->GetCurrentTick();
+				Nz::UInt64 startTime = Nz::GetElapsedMicroseconds();
+
+				bool isRunning = match->Update(elapsedTime);
+
+				Nz::UInt64 updateTime = Nz::GetElapsedMicroseconds() - startTime;
+				totalTime += updateTime;
+				updateCount++;
+
+				Nz::UInt64 tickCount = match->GetCurrentTick() - firstTick;
+				for (Nz::UInt64 i = 0; i < tickCount; ++i)
+					tickDurations.push_back(updateTime / tickCount);
+
+				if (!isRunning)
+					break;
+			}
+		}
+		catch (const std::exception& e)
+		{
+			// Recording of a crashed server usually ends with a partial event
+			bwLog(GetLogger(), LogLevel::Warning, "replay stopped after {0} updates: {1}", updateCount, e.what());
+		}
+
+		if (tickDurations.empty())
+		{
+			bwLog(GetLogger(), LogLevel::Info, "replay didn't run any tick");
+			return 0;
+		}
+
+		if (!reportFile.empty())
+		{
+			std::string report = "tick,duration_us\n";
+			for (std::size_t i = 0; i < tickDurations.size(); ++i)
+				report += fmt::format("{0},{1}\n", i, tickDurations[i]);
+
+			Nz::File reportStream(reportFile, Nz::OpenMode_WriteOnly | Nz::OpenMode_Truncate);
+			if (!reportStream.IsOpen() || reportStream.Write(report.data(), report.size()) != report.size())
+				bwLog(GetLogger(), LogLevel::Error, "failed to write replay report to {0}", reportFile);
+		}
+
+		auto maxIt = std::max_element(tickDurations.begin(), tickDurations.end());
+		std::size_t slowestTick = std::distance(tickDurations.begin(), maxIt);
+		Nz::UInt64 maxDuration = *maxIt;
+
+		Nz::UInt64 tickBudget = static_cast<Nz::UInt64>(replay.GetTickDuration() * 1'000'000);
+		std::size_t overBudgetCount = std::count_if(tickDurations.begin(), tickDurations.end(), [&](Nz::UInt64 duration) { return duration > tickBudget; });
+
+		Nz::UInt64 averageDuration = std::accumulate(tickDurations.begin(), tickDurations.end(), Nz::UInt64(0)) / tickDurations.size();
+
+		std::vector<Nz::UInt64> sortedDurations = tickDurations;
+		std::sort(sortedDurations.begin(), sortedDurations.end());
+
+		auto Percentile = [&](double percentile)
+		{
+			return sortedDurations[std::min(static_cast<std::size_t>(percentile * sortedDurations.size()), sortedDurations.size() - 1)];
+		};
+
+		bwLog(GetLogger(), LogLevel::Info, "replayed {0} ticks ({1} updates) in {2:.1f} ms", tickDurations.size(), updateCount, totalTime / 1000.0);
+		bwLog(GetLogger(), LogLevel::Info, "tick duration: average {0} us, median {1} us, 95th {2} us, 99th {3} us, max {4} us (tick #{5}), {6} tick(s) over budget ({7} us)", averageDuration, Percentile(0.5), Percentile(0.95), Percentile(0.99), maxDuration, slowestTick, overBudgetCount, tickBudget);
+
+		const TickProfiler& tickProfiler = match->GetTickProfiler();
+		if (tickProfiler.IsEnabled())
+			bwLog(GetLogger(), LogLevel::Info, "slowest sections: {0}", tickProfiler.FormatSummary(8));
+
+		const ScriptProfiler& scriptProfiler = match->GetScriptProfiler();
+		if (scriptProfiler.IsEnabled())
+			bwLog(GetLogger(), LogLevel::Info, "heaviest script callbacks: {0}", scriptProfiler.FormatSummary(8));
+
+		return 0;
+	}
+
+	int ServerApp::RunSingleMatch()
+	{
+		Match& match = *m_matches.front().match;
+
+		std::atomic_bool isRunning(true);
+		std::atomic_bool stopSimulation(false);
+
+		// The match ticks on its own thread, the main thread only serves web requests, metrics and main thread jobs so they never delay a tick
+		std::thread simulationThread([&]
+		{
+			using Clock = std::chrono::steady_clock;
+
+			Clock::time_point nextUpdate = Clock::now();
+			Nz::UInt64 lastUpdate = Nz::GetElapsedMicroseconds();
+
+			while (!stopSimulation)
+			{
+				Nz::UInt64 now = Nz::GetElapsedMicroseconds();
+				float elapsedTime = (now - lastUpdate) / 1'000'000.f;
+				lastUpdate = now;
+
+				try
 				{
-					Nz::UInt64 sleepTime = remainingTime - wakeUpTime;
-					std::this_thread::sleep_for(std::chrono::milliseconds(sleepTime / 1'000));
+					if (!match.Update(elapsedTime))
+						break;
 				}
+				catch (const std::exception& e)
+				{
+					bwLog(match.GetLogger(), LogLevel::Error, "match update failed: {0}", e.what());
+					break;
+				}
+
+				// Deadlines are absolute so sleep imprecision doesn't accumulate, a late update runs the next one right away (the match catches up by itself)
+				nextUpdate += std::chrono::microseconds(static_cast<Nz::UInt64>(match.GetTickDuration() * 1'000'000));
+
+				Clock::time_point currentTime = Clock::now();
+				if (nextUpdate > currentTime)
+					std::this_thread::sleep_until(nextUpdate);
+				else
+					nextUpdate = currentTime;
 			}
+
+			isRunning = false;
+		});
+
+		while (Application::Run() && isRunning)
+		{
+			BurgApp::Update();
+
+			if (m_metricsServer)
+				m_metricsServer->Poll();
+
+			std::this_thread::sleep_for(std::chrono::microseconds(serviceInterval));
 		}
 
+		stopSimulation = true;
+		simulationThread.join();
+
 		return 0;
 	}
-	
-	void ServerApp::Quit()
+
+	void ServerApp::StartMetricsServer()
 	{
-		Application::Quit();
+		Nz::UInt16 metricsPort = m_configFile.GetIntegerValue<Nz::UInt16>("ServerSettings.MetricsPort");
+		if (metricsPort == 0)
+			return;
+
+		// Matches snapshot their metrics on their own thread, this only gathers the last snapshots
+		m_metricsServer.emplace(GetLogger(), metricsPort, [this]
+		{
+			std::vector<Match::Metrics> matchMetrics;
+			matchMetrics.reserve(m_matches.size());
+			for (const MatchEntry& matchEntry : m_matches)
+				matchMetrics.push_back(matchEntry.match->GetMetrics());
+
+			return MetricsServer::FormatMatchMetrics(matchMetrics);
+		});
 	}
 }
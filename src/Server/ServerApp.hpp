@@ -9,12 +9,19 @@
 
 #include <CoreLib/BurgApp.hpp>
 #include <CoreLib/Match.hpp>
+#include <Server/MetricsServer.hpp>
 #include <Server/ServerAppConfig.hpp>
 #include <NDK/Application.hpp>
+#include <Nazara/Network/IpAddress.hpp>
 #include <memory>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace bw
 {
+	class MatchReplay;
+
 	class ServerApp : public Ndk::Application, public BurgApp
 	{
 		public:
@@ -22,11 +29,30 @@ namespace bw
 			~ServerApp() = default;
 
 			int Run();
+			int RunRelay(const Nz::IpAddress& serverAddress);
+			int RunReplay(const std::string& replayFile, const std::string& reportFile);
 			void Quit() override;
 
 		private:
+			struct MatchEntry
+			{
+				std::unique_ptr<Match> match;
+				Nz::UInt64 lastUpdate;
+				Nz::UInt64 nextUpdate;
+				Nz::UInt64 tickDuration;
+				bool isRunning = true;
+				bool isUpdating = false;
+			};
+
+			std::unique_ptr<Match> CreateMatch(const ServerAppConfig& config, const MatchReplay* replay = nullptr);
+			void LoadMatches();
+			int RunMatches(std::size_t workerCount);
+			int RunSingleMatch();
+			void StartMetricsServer();
+
+			std::optional<MetricsServer> m_metricsServer;
 			ServerAppConfig m_configFile;
-			std::unique_ptr<Match> m_match;
+			std::vector<MatchEntry> m_matches;
 	};
 }
 
@@ -10,11 +10,52 @@ namespace bw
 	ServerAppConfig::ServerAppConfig(ServerApp& app) :
 	SharedAppConfig(app)
 	{
+		RegisterStringOption("ServerSettings.AdditionalMatches", "");
+		RegisterBoolOption("ServerSettings.AdaptiveSnapshotRate", false);
+		RegisterIntegerOption("ServerSettings.BinaryLogFileCount", 1, 1000, 5);
+		RegisterIntegerOption("ServerSettings.BinaryLogMaxFileSize", 1, 1024 * 1024, 64); //< in MiB
+		RegisterStringOption("ServerSettings.BinaryLogPath", "");
+		RegisterFloatOption("ServerSettings.CheckpointInterval", 0.0, 86400.0, 30.0);
+		RegisterStringOption("ServerSettings.CheckpointPath", "");
+		RegisterFloatOption("ServerSettings.CheckpointReconnectionDelay", 0.0, 86400.0, 60.0);
+		RegisterBoolOption("ServerSettings.DeferPacketSerialization", false);
+		RegisterBoolOption("ServerSettings.FastTerrainReset", false);
+		RegisterFloatOption("ServerSettings.FileWatchDelay", 0.0, 60.0, 0.0);
 		RegisterStringOption("ServerSettings.Gamemode");
+		RegisterIntegerOption("ServerSettings.HealthQuantizationStep", 1, 1000, 1);
+		RegisterIntegerOption("ServerSettings.InterestCellSize", 16, 0xFFFF, 512);
+		RegisterIntegerOption("ServerSettings.InterestRadius", 0, 1'000'000, 0);
+		RegisterFloatOption("ServerSettings.LagCompensationDuration", 0.0, 10.0, 1.0);
+		RegisterFloatOption("ServerSettings.LayerHibernationDelay", 0.0, 86400.0, 0.0);
+		RegisterBoolOption("ServerSettings.LazyLayerActivation", false);
+		RegisterBoolOption("ServerSettings.LoadShedding", true);
 		RegisterStringOption("ServerSettings.MapPath");
+		RegisterIntegerOption("ServerSettings.MatchThreadCount", 0, 256, 0);
 		RegisterIntegerOption("ServerSettings.MaxPlayerCount", 1, 0xFFFF, 16);
+		RegisterFloatOption("ServerSettings.MaxTickRate", 0.0, 1000.0, 0.0);
+		RegisterIntegerOption("ServerSettings.MetricsPort", 0, 0xFFFF, 0);
+		RegisterFloatOption("ServerSettings.MinTickRate", 0.0, 1000.0, 0.0);
+		RegisterFloatOption("ServerSettings.MovementExtrapolationError", 0.0, 1000.0, 0.0);
+		RegisterIntegerOption("ServerSettings.MovementKeyframeInterval", 0, 100'000, 100);
+		RegisterFloatOption("ServerSettings.MovementSyncEpsilon", 0.0, 100.0, 0.01);
+		RegisterIntegerOption("ServerSettings.NetworkStatisticsInterval", 0, 86'400, 0);
+		RegisterIntegerOption("ServerSettings.NetworkThreadCount", 1, 16, 1);
+		RegisterBoolOption("ServerSettings.ParallelLayerUpdate", false);
+		RegisterIntegerOption("ServerSettings.PeerBandwidth", 0, 100'000'000, 0);
 		RegisterIntegerOption("ServerSettings.Port", 1, 0xFFFF, 14768);
+		RegisterStringOption("ServerSettings.RelayPassword", "");
+		RegisterStringOption("ServerSettings.ReplayRecordPath", "");
+		RegisterFloatOption("ServerSettings.ScriptCallbackBudget", 0.0, 1000.0, 0.0);
+		RegisterFloatOption("ServerSettings.ScriptGarbageCollectorStepBudget", 0.0, 1000.0, 1.0);
 		RegisterBoolOption("ServerSettings.SleepWhenEmpty", true);
+		RegisterFloatOption("ServerSettings.SnapshotRate", 0.0, 1000.0, 0.0);
+		RegisterIntegerOption("ServerSettings.TickProfileInterval", 0, 86'400, 0);
+		RegisterBoolOption("ServerSettings.TickProfiling", true);
+		RegisterIntegerOption("ServerSettings.WorkerThreadCount", 0, 64, 0);
+
+		RegisterFloatOption("RelaySettings.Delay", 0.0, 3600.0, 0.0);
+		RegisterIntegerOption("RelaySettings.MaxSpectatorCount", 1, 4095, 256);
+		RegisterStringOption("RelaySettings.Password", "");
 
 		RegisterStringOption("ServerSettings.Description", "", [](std::string value) -> tl::expected<std::string, std::string>
 		{
@@ -24,6 +65,14 @@ namespace bw
 			return value;
 		});
 
+		RegisterStringOption("ServerSettings.ScriptGarbageCollector", "stepped", [](std::string value) -> tl::expected<std::string, std::string>
+		{
+			if (value != "generational" && value != "incremental" && value != "stepped")
+				return tl::make_unexpected("unknown garbage collector mode (expected generational, incremental or stepped)");
+
+			return value;
+		});
+
 		RegisterStringOption("ServerSettings.Name", "a server has no name", [](std::string value) -> tl::expected<std::string, std::string>
 		{
 			if (value.empty())
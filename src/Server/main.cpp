@@ -3,15 +3,77 @@
 // For conditions of distribution and use, see copyright notice in LICENSE
 
 #include <Nazara/Core/Initializer.hpp>
+#include <Nazara/Network/Algorithm.hpp>
+#include <Nazara/Network/IpAddress.hpp>
 #include <Nazara/Network/Network.hpp>
 #include <Server/ServerApp.hpp>
 #include <Main/Main.hpp>
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+#include <cstdlib>
+#include <string>
+#include <vector>
 
 int BurgWarServer(int argc, char* argv[])
 {
+	cxxopts::Options options("BurgWarServer", "BurgWar dedicated server");
+	options.add_options()
+		("relay", "Serve the match of a game server (with ServerSettings.RelayPassword set) to spectators, on ServerSettings.Port", cxxopts::value<std::string>(), "host")
+		("relay-port", "Game server port to relay", cxxopts::value<Nz::UInt16>()->default_value("14768"), "port")
+		("replay", "Replay a match recorded with ServerSettings.ReplayRecordPath as fast as possible and report tick timings", cxxopts::value<std::string>(), "file")
+		("replay-report", "Write replayed tick durations to a CSV file", cxxopts::value<std::string>()->default_value(""), "file")
+		("h,help", "Print usage")
+	;
+
+	std::string relayHostname;
+	std::string replayFile;
+	std::string replayReportFile;
+	Nz::UInt16 relayPort;
+
+	try
+	{
+		auto result = options.parse(argc, argv);
+		if (result.count("help") > 0)
+		{
+			fmt::print("{}\n", options.help());
+			return EXIT_SUCCESS;
+		}
+
+		if (result.count("relay") > 0)
+			relayHostname = result["relay"].as<std::string>();
+
+		relayPort = result["relay-port"].as<Nz::UInt16>();
+
+		if (result.count("replay") > 0)
+			replayFile = result["replay"].as<std::string>();
+
+		replayReportFile = result["replay-report"].as<std::string>();
+	}
+	catch (const cxxopts::OptionException& e)
+	{
+		fmt::print(stderr, "{}\n{}\n", e.what(), options.help());
+		return EXIT_FAILURE;
+	}
+
 	Nz::Initializer<Nz::Network> network;
 	bw::ServerApp app(argc, argv);
 
+	if (!relayHostname.empty())
+	{
+		Nz::ResolveError resolveError;
+		std::vector<Nz::HostnameInfo> serverAddresses = Nz::IpAddress::ResolveHostname(Nz::NetProtocol_Any, relayHostname, Nz::String::Number(relayPort), &resolveError);
+		if (serverAddresses.empty())
+		{
+			fmt::print(stderr, "failed to resolve {}: {}\n", relayHostname, Nz::ErrorToString(resolveError));
+			return EXIT_FAILURE;
+		}
+
+		return app.RunRelay(serverAddresses.front().address);
+	}
+
+	if (!replayFile.empty())
+		return app.RunReplay(replayFile, replayReportFile);
+
 	return app.Run();
 }
 
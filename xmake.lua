@@ -2,6 +2,7 @@
 set_xmakever("2.5.6")
 
 option("build_mapeditor", { default = true, showmenu = true, description = "Should the map editor be compiled as part of the project? (requires Qt)" })
+option("profile_zones", { default = false, showmenu = true, description = "Compile Tracy profiler zones in hot paths (ticks, network, scripts, rendering) and Lua allocations tracking" })
 
 set_policy("package.requires_lock", true)
 add_repositories("burgwar-repo xmake-repo")
@@ -9,7 +10,7 @@ add_repositories("burgwar-repo xmake-repo")
 set_project("BurgWar")
 set_version("0.2.0")
 
-add_requires("cxxopts", "concurrentqueue", "hopscotch-map", "nlohmann_json", "openal-soft", "tl_expected", "tl_function_ref")
+add_requires("cxxopts", "concurrentqueue", "hopscotch-map", "lz4", "nlohmann_json", "openal-soft", "tl_expected", "tl_function_ref")
 add_requires("fmt", { configs = { header_only = false, pic = true } })
 add_requires("libcurl", { optional = true })
 add_requires("nazaraengine 2022.11.23", { alias = "nazara" })
@@ -20,6 +21,10 @@ if is_plat("windows") then
 	add_requires("stackwalker master")
 end
 
+if has_config("profile_zones") then
+	add_requires("tracy")
+end
+
 add_requireconfs("fmt", "stackwalker", { debug = is_mode("debug", "asan") })
 add_requireconfs("libcurl", "nazaraengine", "nazaraengine~server", { configs = { debug = is_mode("debug", "asan"), shared = true } })
 
@@ -45,6 +50,7 @@ set_warnings("allextra")
 if is_mode("releasedbg") then
 	set_fpmodels("fast")
 	add_vectorexts("sse", "sse2", "sse3", "ssse3")
+	add_defines("BURGWAR_LOG_MINIMUM_LEVEL=1") -- Debug logs are compiled out
 elseif is_mode("asan") then
 	set_optimize("none")
 end
@@ -106,8 +112,14 @@ target("CoreLib")
 	add_files("src/CoreLib/**.cpp")
 	add_packages("concurrentqueue", "fmt", "hopscotch-map", "nlohmann_json", "sol2", "tl_expected", { public = true })
 	add_packages("nazaraserver")
+	add_packages("lz4")
 	add_packages("libcurl", { public = true, links = {} })
 
+	if has_config("profile_zones") then
+		add_defines("BURGWAR_PROFILE_ZONES", { public = true })
+		add_packages("tracy", { public = true })
+	end
+
 if is_plat("windows") then
 	add_packages("stackwalker")
 end
@@ -228,12 +240,37 @@ target("BurgWarServer")
 	add_deps("Main", "CoreLib")
 	add_headerfiles("src/Server/**.hpp", "src/Server/**.inl")
 	add_files("src/Server/**.cpp")
-	add_packages("nazaraserver")
+	add_packages("cxxopts", "nazaraserver")
 
 	after_install(function (target)
 		os.vcp("serverconfig.lua", path.join(target:installdir(), "bin"))
 	end)
 
+target("BurgWarLoadTest")
+	set_group("Executable")
+	set_basename("loadtest")
+
+	set_kind("binary")
+	set_default(false)
+	add_rules("install_symbolfile")
+
+	add_deps("Main", "ClientLib", "CoreLib")
+	add_headerfiles("src/LoadTest/**.hpp", "src/LoadTest/**.inl")
+	add_files("src/LoadTest/**.cpp")
+	add_packages("cxxopts", "nazara")
+
+target("BurgWarLogTool")
+	set_group("Executable")
+	set_basename("logtool")
+
+	set_kind("binary")
+	add_rules("install_symbolfile")
+
+	add_deps("Main", "CoreLib")
+	add_headerfiles("src/LogTool/**.hpp", "src/LogTool/**.inl")
+	add_files("src/LogTool/**.cpp")
+	add_packages("cxxopts", "nazaraserver")
+
 target("BurgWarMapTool")
 	set_group("Executable")
 	set_basename("maptool")
@@ -246,6 +283,18 @@ target("BurgWarMapTool")
 	add_files("src/MapTool/**.cpp")
 	add_packages("cxxopts", "nazaraserver")
 
+target("BurgWarBenchmark")
+	set_group("Executable")
+	set_basename("benchmark")
+
+	set_kind("binary")
+	set_default(false)
+
+	add_deps("Main", "CoreLib")
+	add_headerfiles("src/Benchmark/**.hpp", "src/Benchmark/**.inl")
+	add_files("src/Benchmark/**.cpp")
+	add_packages("cxxopts", "nazaraserver")
+
 if has_config("build_mapeditor") then
 	target("BurgWarMapEditor")
 		set_group("Executable")